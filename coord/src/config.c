@@ -11,6 +11,8 @@
 #include "rmutil/util.h"
 #include "rmutil/strings.h"
 #include "hiredis/hiredis.h"
+#include "util/cpu_affinity.h"
+#include "rmalloc.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -116,6 +118,259 @@ CONFIG_GETTER(getConnPerShard) {
   return sdscatprintf(ss, "%zu", realConfig->connPerShard);
 }
 
+// IO_THREAD_CPU_LIST
+CONFIG_SETTER(setIOThreadCpuList) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  const char *list;
+  int acrc = AC_GetString(ac, &list, NULL, 0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  if (!CPUList_IsValidSetting(list)) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, "Invalid CPU list");
+    return REDISMODULE_ERR;
+  }
+  rm_free(realConfig->ioThreadCpuList);
+  realConfig->ioThreadCpuList = *list ? rm_strdup(list) : NULL;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getIOThreadCpuList) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  return sdsnew(realConfig->ioThreadCpuList ? realConfig->ioThreadCpuList : "");
+}
+
+// IO_THREADS
+CONFIG_SETTER(setNumIOThreads) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  size_t num;
+  int acrc = AC_GetSize(ac, &num, AC_F_GE1);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  realConfig->numIOThreads = num;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getNumIOThreads) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->numIOThreads);
+}
+
+// SEARCH_SHARD_LIMIT_FACTOR
+CONFIG_SETTER(setSearchShardLimitFactor) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetDouble(ac, &realConfig->searchShardLimitFactor, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getSearchShardLimitFactor) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%g", realConfig->searchShardLimitFactor);
+}
+
+// KNN_SHARD_LIMIT_FACTOR
+CONFIG_SETTER(setKnnShardLimitFactor) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetDouble(ac, &realConfig->knnShardLimitFactor, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getKnnShardLimitFactor) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%g", realConfig->knnShardLimitFactor);
+}
+
+// KNN_SHARD_LIMIT_APPROXIMATE
+CONFIG_SETTER(setKnnShardLimitApproximate) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  const char *tf;
+  int acrc = AC_GetString(ac, &tf, NULL, 0);
+  if (acrc == AC_OK) {
+    if (!strcasecmp(tf, "true")) {
+      realConfig->knnShardLimitApproximate = 1;
+    } else if (!strcasecmp(tf, "false")) {
+      realConfig->knnShardLimitApproximate = 0;
+    } else {
+      acrc = AC_ERR_PARSE;
+    }
+  }
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getKnnShardLimitApproximate) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  return sdsnew(realConfig->knnShardLimitApproximate ? "true" : "false");
+}
+
+// HEDGE_BUDGET
+CONFIG_SETTER(setHedgeBudget) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  double budget;
+  int acrc = AC_GetDouble(ac, &budget, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  if (budget > 100) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, "Hedging budget must be a percentage");
+    return REDISMODULE_ERR;
+  }
+  realConfig->hedgeBudget = budget;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getHedgeBudget) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%g", realConfig->hedgeBudget);
+}
+
+// CONN_MAX_INFLIGHT
+CONFIG_SETTER(setConnMaxInflight) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->connMaxInflight, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getConnMaxInflight) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->connMaxInflight);
+}
+
+// MAX_PENDING_REQUESTS
+CONFIG_SETTER(setMaxPendingRequests) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->maxPendingRequests, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getMaxPendingRequests) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->maxPendingRequests);
+}
+
+// TERM_STATS_INTERVAL
+CONFIG_SETTER(setTermStatsInterval) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->termStatsInterval, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTermStatsInterval) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->termStatsInterval);
+}
+
+// TRACE_SAMPLE
+CONFIG_SETTER(setTraceSample) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->traceSample, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTraceSample) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->traceSample);
+}
+
+// LOCAL_SHARD_IN_PROCESS
+CONFIG_SETTER(setLocalShardInProcess) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  const char *tf;
+  int acrc = AC_GetString(ac, &tf, NULL, 0);
+  if (acrc == AC_OK) {
+    if (!strcasecmp(tf, "true")) {
+      realConfig->localShardInProcess = 1;
+    } else if (!strcasecmp(tf, "false")) {
+      realConfig->localShardInProcess = 0;
+    } else {
+      acrc = AC_ERR_PARSE;
+    }
+  }
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getLocalShardInProcess) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  return sdsnew(realConfig->localShardInProcess ? "true" : "false");
+}
+
+// CURSOR_READ_AHEAD
+CONFIG_SETTER(setCursorReadAhead) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->cursorReadAhead, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getCursorReadAhead) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->cursorReadAhead);
+}
+
+// INFO_CACHE_TTL
+CONFIG_SETTER(setInfoCacheTTL) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  int acrc = AC_GetSize(ac, &realConfig->infoCacheTTL, AC_F_GE0);
+  if (acrc != AC_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, AC_Strerror(acrc));
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getInfoCacheTTL) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", realConfig->infoCacheTTL);
+}
+
 static RSConfigOptions clusterOptions_g = {
     .vars =
         {
@@ -137,13 +392,92 @@ static RSConfigOptions clusterOptions_g = {
              .setValue = setConnPerShard,
              .getValue = getConnPerShard,
              .flags = RSCONFIGVAR_F_IMMUTABLE},
+            {.name = "IO_THREAD_CPU_LIST",
+             .helpText = "The CPUs the thread sending the requests to the shards runs on, as a list"
+                         " of CPUs and ranges (e.g. 0-3,8), or NUMA_LOCAL for the CPUs of the NUMA"
+                         " node the module is loaded on",
+             .setValue = setIOThreadCpuList,
+             .getValue = getIOThreadCpuList,
+             .flags = RSCONFIGVAR_F_IMMUTABLE},
+            {.name = "IO_THREADS",
+             .helpText = "The number of threads sending the requests to the shards, each with its"
+                         " own event loop and share of the connections to every shard",
+             .setValue = setNumIOThreads,
+             .getValue = getNumIOThreads,
+             .flags = RSCONFIGVAR_F_IMMUTABLE},
+            {.name = "SEARCH_SHARD_LIMIT_FACTOR",
+             .helpText = "FT.SEARCH asks each shard for its share of the requested results times"
+                         " this factor first, and for the rest of them from the shards which may"
+                         " hold more. 0 asks every shard for all the requested results",
+             .setValue = setSearchShardLimitFactor,
+             .getValue = getSearchShardLimitFactor},
+            {.name = "KNN_SHARD_LIMIT_FACTOR",
+             .helpText = "FT.SEARCH asks each shard for its share of the top K results of a KNN"
+                         " query, by their distance, times this factor first, and for the rest of"
+                         " them from the shards whose last result may make the cut. 0 asks every"
+                         " shard for all K results",
+             .setValue = setKnnShardLimitFactor,
+             .getValue = getKnnShardLimitFactor},
+            {.name = "KNN_SHARD_LIMIT_APPROXIMATE",
+             .helpText = "With KNN_SHARD_LIMIT_FACTOR, merge the top K results of a KNN query from"
+                         " the first replies of the shards only, which may miss some of them",
+             .setValue = setKnnShardLimitApproximate,
+             .getValue = getKnnShardLimitApproximate},
+            {.name = "HEDGE_BUDGET",
+             .helpText = "The percentage of the FT.SEARCH requests to the shards which may be sent"
+                         " to a replica as well, when the node they were sent to is late to reply",
+             .setValue = setHedgeBudget,
+             .getValue = getHedgeBudget},
+            {.name = "CONN_MAX_INFLIGHT",
+             .helpText = "The number of commands sent on a connection to a shard before their"
+                         " replies, from which the next commands wait for a reply. 0 is unbounded",
+             .setValue = setConnMaxInflight,
+             .getValue = getConnMaxInflight},
+            {.name = "MAX_PENDING_REQUESTS",
+             .helpText = "The number of requests waiting to be sent to the shards, from which the"
+                         " distributed commands are rejected. 0 is unbounded",
+             .setValue = setMaxPendingRequests,
+             .getValue = getMaxPendingRequests},
+            {.name = "TERM_STATS_INTERVAL",
+             .helpText = "The interval in milliseconds at which the number of documents, their"
+                         " length and the number of documents of the most looked up terms are"
+                         " gathered from the shards, for them to score with the statistics of the"
+                         " whole cluster. 0 disables it",
+             .setValue = setTermStatsInterval,
+             .getValue = getTermStatsInterval},
+            {.name = "TRACE_SAMPLE",
+             .helpText = "One of every this many distributed searches is traced: the shards reply"
+                         " with their times, which are logged to the slow log of the coordinator"
+                         " with its own if the search is slow. 0 disables it",
+             .setValue = setTraceSample,
+             .getValue = getTraceSample},
+            {.name = "LOCAL_SHARD_IN_PROCESS",
+             .helpText = "Run the FT.SEARCH and FT.AGGREGATE requests to the shard of the process"
+                         " itself in the process, on its workers, rather than sending them over a"
+                         " connection to itself. Requires MT_MODE_FULL",
+             .setValue = setLocalShardInProcess,
+             .getValue = getLocalShardInProcess},
+            {.name = "CURSOR_READ_AHEAD",
+             .helpText = "The size in bytes of the replies of a shard to FT.AGGREGATE which may wait"
+                         " to be read by the coordinator. The cursor of the shard is read again once"
+                         " they are read below it, and the number of rows it is read for is adapted"
+                         " to the pace they are read at. 0 is unbounded",
+             .setValue = setCursorReadAhead,
+             .getValue = getCursorReadAhead},
+            {.name = "INFO_CACHE_TTL",
+             .helpText = "The time in milliseconds a reply to FT.INFO merged from the shards is"
+                         " replied again, to the same FT.INFO, without asking them. 0 disables it",
+             .setValue = setInfoCacheTTL,
+             .getValue = getInfoCacheTTL},
             {.name = NULL}
             // fin
         }
     // fin
 };
 
-SearchClusterConfig clusterConfig = {0};
+SearchClusterConfig clusterConfig = {.numIOThreads = 1,
+                                     .connMaxInflight = DEFAULT_CONN_MAX_INFLIGHT,
+                                     .cursorReadAhead = DEFAULT_CURSOR_READ_AHEAD};
 
 /* Detect the cluster type, by trying to see if we are running inside RLEC.
  * If we cannot determine, we return OSS type anyway
@@ -21,10 +21,50 @@ typedef struct {
   int timeoutMS;
   const char* globalPass;
   size_t connPerShard;
+  // The CPUs the threads sending the requests to the shards run on (see CPUList_FromSetting)
+  char *ioThreadCpuList;
+  // The number of threads sending the requests to the shards, each with connections of its own
+  size_t numIOThreads;
+  // FT.SEARCH asks each shard for its share of the requested results times this factor first, and
+  // for the rest of them from the shards which may hold more (0 asks for all of them at once)
+  double searchShardLimitFactor;
+  // The same factor for the top K results of a KNN query, asked for by their distance (0 asks each
+  // shard for all K of them at once)
+  double knnShardLimitFactor;
+  // The shards are not asked for the rest of the top K results of a KNN query, which merges their
+  // first replies only
+  int knnShardLimitApproximate;
+  // The percentage of the requests to the shards which may be sent to another node of the shard as
+  // well, when the node they were sent to is late to reply (0 disables it)
+  double hedgeBudget;
+  // The number of commands sent on a connection to a shard before their replies, from which the
+  // next commands wait for a reply (0 is unbounded)
+  size_t connMaxInflight;
+  // The number of requests waiting for the thread sending them to the shards, from which the
+  // distributed commands are rejected (0 is unbounded)
+  size_t maxPendingRequests;
+  // The interval in milliseconds at which the statistics of the indexes over the cluster are
+  // gathered and pushed to the shards, for them to score with (0 disables it)
+  size_t termStatsInterval;
+  // One of every this many distributed searches is traced over the shards, see DistTrace (0
+  // disables it)
+  size_t traceSample;
+  // The searches and aggregates to the shard of the process itself are run in the process, rather
+  // than sent over a connection to it, see LocalShard
+  int localShardInProcess;
+  // The size in bytes of the replies of a shard to FT.AGGREGATE waiting to be read by the
+  // coordinator, from which the shard cursor is read again only once they are read (0 is unbounded)
+  size_t cursorReadAhead;
+  // The time in milliseconds the merged replies to FT.INFO are answered from, without asking the
+  // shards again (0 disables it)
+  size_t infoCacheTTL;
 } SearchClusterConfig;
 
 extern SearchClusterConfig clusterConfig;
 
+#define DEFAULT_CONN_MAX_INFLIGHT 128
+#define DEFAULT_CURSOR_READ_AHEAD (4 << 20)
+
 #define CLUSTER_TYPE_OSS "redis_oss"
 #define CLUSTER_TYPE_RLABS "redislabs"
 
@@ -35,6 +75,19 @@ extern SearchClusterConfig clusterConfig;
     .type = DetectClusterType(),                                                           \
     .timeoutMS = 500,                                                                      \
     .globalPass = NULL,                                                                    \
+    .ioThreadCpuList = NULL,                                                               \
+    .numIOThreads = 1,                                                                     \
+    .searchShardLimitFactor = 0,                                                           \
+    .knnShardLimitFactor = 0,                                                              \
+    .knnShardLimitApproximate = 0,                                                         \
+    .hedgeBudget = 0,                                                                      \
+    .connMaxInflight = DEFAULT_CONN_MAX_INFLIGHT,                                          \
+    .maxPendingRequests = 0,                                                               \
+    .termStatsInterval = 0,                                                                \
+    .traceSample = 0,                                                                      \
+    .localShardInProcess = 0,                                                              \
+    .cursorReadAhead = DEFAULT_CURSOR_READ_AHEAD,                                          \
+    .infoCacheTTL = 0,                                                                     \
   }
 
 /* Detect the cluster type, by trying to see if we are running inside RLEC.
@@ -1,6 +1,9 @@
 #include "src/module.h"
 #include "util/heap.h"
 #include "query.h"
+#include "dist_result_cache.h"
+#include "dist_trace.h"
+#include "rmutil/cxx/chrono-clock.h"
 
 #include <stdbool.h>
 
@@ -54,7 +57,14 @@ typedef struct {
   int profileArgs;
   int profileLimited;
   clock_t profileClock;
-  void *reducer;
+  void *reducer; // The searchReducerCtx the shard replies are merged into as they arrive
+  DistResultCacheKey *cacheKey; // The key to cache the reply with, if not NULL
+  hires_clock_t startClock;     // When the request was received, for the latency stats
+  double dispatchTime;          // Milliseconds until the request was sent to the shards
+  double lastReplyTime;         // Milliseconds until the last shard replied, 0 if unknown
+  double refillTime;            // Milliseconds until the shards were asked for more results
+  unsigned dialect;
+  DistTrace *trace;             // The trace of the search if it was sampled, or NULL
 } searchRequestCtx;
 
 specialCaseCtx *prepareOptionalTopKCase(const char *query_string, RedisModuleString **argv, int argc,
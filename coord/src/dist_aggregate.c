@@ -15,12 +15,39 @@
 #include "profile.h"
 #include "util/timeout.h"
 #include "resp3.h"
+#include "aggregate/results_blob.h"
+#include "dist_result_cache.h"
+#include "config.h"
+#include "alloc_stats.h"
+#include "util/minmax.h"
 
 #include <err.h>
 
+// The number of rows a shard cursor is read for is scaled by up to this factor from CURSORREADSIZE
+#define CURSOR_COUNT_SCALE 8
+
+/* The number of rows to read the cursor of a shard for next, given the size of its replies not
+ * read yet when its last one arrived. The coordinator waits on a shard whose replies were all read,
+ * which is read for more rows at a time, and lags behind one whose replies take half the budget,
+ * which is read for less */
+static long long nextCursorCount(const MRCommand *cmd, size_t buffered) {
+  long long readSize = RSGlobalConfig.cursorReadSize;
+  long long count = readSize;
+  if (cmd->num == 6 && !strcmp(MRCommand_ArgStringPtrLen(cmd, 0, NULL), "_FT.CURSOR")) {
+    // the last read, as _FT.CURSOR READ <idx> <cid> COUNT <count>
+    count = strtoll(MRCommand_ArgStringPtrLen(cmd, 5, NULL), NULL, 10);
+  }
+  if (buffered == 0) {
+    count = MIN(count * 2, readSize * CURSOR_COUNT_SCALE);
+  } else if (clusterConfig.cursorReadAhead && buffered >= clusterConfig.cursorReadAhead / 2) {
+    count = MAX(count / 2, MAX(readSize / CURSOR_COUNT_SCALE, 1));
+  }
+  return count;
+}
+
 // Get cursor command using a cursor id and an existing aggregate command
 
-static int getCursorCommand(MRReply *res, MRCommand *cmd) {
+static int getCursorCommand(MRReply *res, MRCommand *cmd, long long count) {
   long long cursorId;
   if (!MRReply_ToInteger(MRReply_ArrayElement(res, 1), &cursorId)) {
     // Invalid format?!
@@ -35,11 +62,12 @@ static int getCursorCommand(MRReply *res, MRCommand *cmd) {
     return 0;  // Invalid command!??
   }
 
-  char buf[128];
+  char buf[128], countBuf[32];
   sprintf(buf, "%lld", cursorId);
+  sprintf(countBuf, "%lld", count);
   int shardingKey = MRCommand_GetShardingKey(cmd);
   const char *idx = MRCommand_ArgStringPtrLen(cmd, shardingKey, NULL);
-  MRCommand newCmd = MR_NewCommand(4, "_FT.CURSOR", "READ", idx, buf);
+  MRCommand newCmd = MR_NewCommand(6, "_FT.CURSOR", "READ", idx, buf, "COUNT", countBuf);
   newCmd.targetSlot = cmd->targetSlot;
   newCmd.protocol = cmd->protocol;
   MRCommand_Free(cmd);
@@ -67,12 +95,28 @@ static int netCursorCallback(MRIteratorCallbackCtx *ctx, MRReply *rep, MRCommand
     return REDIS_ERR;
   }
 
-  // rewrite and resend the cursor command if needed
+  // rewrite and resend the cursor command if needed, read for a number of rows adapted to the pace
+  // the replies of the shard are read at
   int rc = REDIS_OK;
-  bool done = !getCursorCommand(rep, cmd);
+  long long count = nextCursorCount(cmd, MRIteratorCallback_GetBuffered(ctx));
+  bool done = !getCursorCommand(rep, cmd, count);
 
   // Push the reply down the chain
-  if (cmd->protocol == 3) // RESP3
+  MRReply *chunk = MRReply_ArrayElement(rep, 0);
+  if (chunk && MRReply_Type(chunk) == MR_REPLY_STRING) // Binary chunk (see results_blob.h)
+  {
+    size_t len;
+    const char *blob = MRReply_String(chunk, &len);
+    uint32_t nrows;
+    if (ResultsBlob_Peek(blob, len, &nrows) == REDISMODULE_OK && nrows > 0) {
+      MRIteratorCallback_AddReply(ctx, rep); // to be picked up by getNextReply
+      // User code now owns the reply, so we can't free it here ourselves!
+      rep = NULL;
+    } else {
+      done = true;
+    }
+  }
+  else if (cmd->protocol == 3) // RESP3
   {
     MRReply *map = MRReply_ArrayElement(rep, 0);
     MRReply *results = NULL;
@@ -180,6 +224,8 @@ typedef struct {
   struct {
     MRReply *root;  // Root reply. We need to free this when done with the rows
     MRReply *rows;  // Array containing reply rows for quick access
+    ResultsBlob blob;  // The reader of the rows, if they are a binary chunk
+    RLookupKey **blobKeys;  // The keys of the columns of the binary chunk
   } current;
   // Lookup - the rows are written in here
   RLookup *lookup;
@@ -205,13 +251,26 @@ static int getNextReply(RPNet *nc) {
     }
 
     MRReply *rows = MRReply_ArrayElement(root, 0);
-    if (   rows == NULL
-        || (MRReply_Type(rows) != MR_REPLY_ARRAY && MRReply_Type(rows) != MR_REPLY_MAP)
-        || MRReply_Length(rows) == 0) {
+    if (rows && MRReply_Type(rows) == MR_REPLY_STRING) {
+      size_t len;
+      const char *blob = MRReply_String(rows, &len);
+      if (ResultsBlob_Open(&nc->current.blob, blob, len) != REDISMODULE_OK) {
+        MRReply_Free(root);
+        root = NULL;
+        rows = NULL;
+        RedisModule_Log(NULL, "warning", "A malformed binary reply was received from a shard");
+        // the results miss the rows of the shard, and are not cached
+        nc->areq->stateflags |= QEXEC_S_INCOMPLETE;
+      }
+    } else if (   rows == NULL
+               || (MRReply_Type(rows) != MR_REPLY_ARRAY && MRReply_Type(rows) != MR_REPLY_MAP)
+               || MRReply_Length(rows) == 0) {
       MRReply_Free(root);
       root = NULL;
       rows = NULL;
       RedisModule_Log(NULL, "warning", "An empty reply was received from a shard");
+      // the results miss the rows of the shard, and are not cached
+      nc->areq->stateflags |= QEXEC_S_INCOMPLETE;
     }
 
     // invariant: either rows == NULL or least one row exists
@@ -221,7 +280,8 @@ static int getNextReply(RPNet *nc) {
 
     assert(   !nc->current.rows
            || MRReply_Type(nc->current.rows) == MR_REPLY_ARRAY
-           || MRReply_Type(nc->current.rows) == MR_REPLY_MAP);
+           || MRReply_Type(nc->current.rows) == MR_REPLY_MAP
+           || MRReply_Type(nc->current.rows) == MR_REPLY_STRING);
     return 1;
   }
 }
@@ -263,10 +323,15 @@ static int rpnetNext(ResultProcessor *self, SearchResult *r) {
   // RESP2: [] or [ 0 ]
   // RESP3: {}
 
+  // or, for both, a binary chunk (see results_blob.h) in place of the rows
+
   if (rows) {
       bool resp3 = MRReply_Type(rows) == MR_REPLY_MAP;
+      bool binary = MRReply_Type(rows) == MR_REPLY_STRING;
       size_t len;
-      if (resp3) {
+      if (binary) {
+        len = nc->current.blob.nrows;
+      } else if (resp3) {
         MRReply *results = MRReply_MapElement(rows, "results");
         RS_LOG_ASSERT(results, "invalid results record: missing 'results' key");
         len = MRReply_Length(results);
@@ -283,6 +348,9 @@ static int rpnetNext(ResultProcessor *self, SearchResult *r) {
         } else {
           MRReply_Free(root);
         }
+        if (binary) {
+          ResultsBlob_Close(&nc->current.blob);
+        }
         nc->current.root = nc->current.rows = root = rows = NULL;
       }
   }
@@ -290,7 +358,7 @@ static int rpnetNext(ResultProcessor *self, SearchResult *r) {
   int new_reply = !root;
 
   // get the next reply from the channel
-  while (!root || !rows || MRReply_Length(rows) == 0) {
+  while (!root || !rows || (MRReply_Type(rows) != MR_REPLY_STRING && MRReply_Length(rows) == 0)) {
       if (!getNextReply(nc)) {
         return RS_RESULT_EOF;
       }
@@ -301,6 +369,37 @@ static int rpnetNext(ResultProcessor *self, SearchResult *r) {
 
   // invariant: at least one row exists
 
+  if (MRReply_Type(rows) == MR_REPLY_STRING) {
+    ResultsBlob *blob = &nc->current.blob;
+    if (new_reply) {
+      nc->curIdx = 0;
+      nc->base.parent->totalResults += blob->totalResults;
+      // Logic of which format to use is done by the shards
+      if (nc->cmd.protocol == 3) {
+        if (blob->flags & RESULTS_BLOB_F_EXPAND) {
+          nc->areq->reqflags |= QEXEC_FORMAT_EXPAND;
+        } else {
+          nc->areq->reqflags &= ~QEXEC_FORMAT_EXPAND;
+        }
+        nc->areq->reqflags &= ~QEXEC_FORMAT_DEFAULT;
+      }
+      nc->current.blobKeys = rm_realloc(nc->current.blobKeys,
+                                        (blob->ncols + 1) * sizeof(*nc->current.blobKeys));
+      for (size_t i = 0; i < blob->ncols; ++i) {
+        nc->current.blobKeys[i] = RLookup_GetWriteKeyByName(nc->lookup, blob->names[i],
+                                                            blob->nameLens[i]);
+      }
+    }
+    nc->curIdx++;
+    for (size_t i = 0; i < blob->ncols; ++i) {
+      RSValue *v = ResultsBlob_Read(blob, i);
+      if (v) {
+        RLookup_WriteOwnKey(nc->current.blobKeys[i], &r->rowdata, v);
+      }
+    }
+    return RS_RESULT_OK;
+  }
+
   bool resp3 = MRReply_Type(rows) == MR_REPLY_MAP;
   if (new_reply) {
     if (resp3) { // RESP3
@@ -383,8 +482,12 @@ static void rpnetFree(ResultProcessor *rp) {
   }
 
   if (nc->current.root) {
+    if (MRReply_Type(nc->current.rows) == MR_REPLY_STRING) {
+      ResultsBlob_Close(&nc->current.blob);
+    }
     MRReply_Free(nc->current.root);
   }
+  rm_free(nc->current.blobKeys);
 
   if (nc->it) MRIterator_Free(nc->it);
   rm_free(rp);
@@ -425,8 +528,17 @@ static void buildMRCommand(RedisModuleString **argv, int argc, int profileArgs,
 
   tmparr = array_append(tmparr, RedisModule_StringPtrLen(argv[2 + profileArgs], NULL));  // Query
   tmparr = array_append(tmparr, "WITHCURSOR");
+  // The shard cursors are read again as soon as a chunk arrives (see netCursorCallback), so with
+  // PREFETCH the shards read their next chunk while the previous one is on its way
+  if (RMUtil_ArgIndex("PREFETCH", argv + 3 + profileArgs, argc - 3 - profileArgs) != -1) {
+    tmparr = array_append(tmparr, "PREFETCH");
+  }
   // Numeric responses are encoded as simple strings.
   tmparr = array_append(tmparr, "_NUM_SSTRING");
+  // The chunks are replied in binary, but for profiling, where they are sent along the profiles
+  if (profileArgs == 0) {
+    tmparr = array_append(tmparr, "_BINARY");
+  }
 
   int argOffset = RMUtil_ArgIndex("DIALECT", argv + 3 + profileArgs, argc - 3 - profileArgs);
   if (argOffset != -1 && argOffset + 3 + 1 + profileArgs < argc) {
@@ -481,7 +593,7 @@ static void buildDistRPChain(AREQ *r, MRCommand *xcmd, SearchCluster *sc,
 
   ResultProcessor *rpProfile = NULL;
   if (IsProfile(r)) {
-    rpProfile = RPProfile_New(&rpRoot->base, &r->qiter);
+    rpProfile = RPProfile_New(&rpRoot->base, &r->qiter, r->reqConfig.profileHwCounters);
   }
 
   assert(!r->qiter.rootProc);
@@ -562,8 +674,9 @@ static int parseProfile(RedisModuleString **argv, int argc, AREQ *r) {
   return profileArgs;
 }
 
-void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                         struct ConcurrentCmdCtx *cmdCtx) {
+// The reply is cached with `ck`, if not NULL and the query is not a cursor
+static void distAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                          struct ConcurrentCmdCtx *cmdCtx, const DistResultCacheKey *ck) {
   RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
   bool has_map = RedisModule_HasMap(reply);
 
@@ -633,6 +746,9 @@ void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
       goto err;
     }
   } else {
+    if (ck) {
+      RedisModule_Reply_Record(reply);
+    }
     if (reply->resp3 || IsProfile(r)) {
       RedisModule_Reply_Map(reply);
     }
@@ -643,6 +759,15 @@ void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
     if (reply->resp3 || IsProfile(r)) {
       RedisModule_Reply_MapEnd(reply);
     }
+    if (ck) {
+      // a recording is dropped on an error
+      arrayof(char) recording = RedisModule_Reply_TakeRecording(reply);
+      if (recording && !(r->stateflags & QEXEC_S_INCOMPLETE)) {
+        DistResultCache_Put(ck, recording);
+      } else {
+        array_free(recording);
+      }
+    }
     AREQ_Free(r);
   }
   SpecialCaseCtx_Free(knnCtx);
@@ -658,3 +783,17 @@ err:
   RedisModule_EndReply(reply);
   return;
 }
+
+void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                         struct ConcurrentCmdCtx *cmdCtx) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_COORD);
+  distAggregate(ctx, argv, argc, cmdCtx, NULL);
+  AllocStats_SetTag(prevTag);
+}
+
+void RSExecDistAggregateCached(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                               const DistResultCacheKey *ck) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_COORD);
+  distAggregate(ctx, argv, argc, NULL, ck);
+  AllocStats_SetTag(prevTag);
+}
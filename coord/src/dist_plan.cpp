@@ -3,6 +3,7 @@
 #include "aggregate/aggregate_plan.h"
 #include "aggregate/reducer.h"
 #include "util/arr.h"
+#include "config.h"
 #include "dist_plan.h"
 
 #include <vector>
@@ -96,8 +97,12 @@ struct ReducerDistCtx {
 typedef int (*reducerDistributionFunc)(ReducerDistCtx *rdctx, QueryError *status);
 reducerDistributionFunc getDistributionFunc(const char *key);
 
-static void distributeGroupStep(AGGPlan *origPlan, AGGPlan *remote, PLN_BaseStep *step,
-                                PLN_DistributeStep *dstp, QueryError *status) {
+/**
+ * Returns the last local step which replaced the group step, or NULL if the group step could not
+ * be distributed and is kept local
+ */
+static PLN_BaseStep *distributeGroupStep(AGGPlan *origPlan, AGGPlan *remote, PLN_BaseStep *step,
+                                         PLN_DistributeStep *dstp, QueryError *status) {
   PLN_GroupStep *gr = (PLN_GroupStep *)step;
   PLN_GroupStep *grLocal = PLNGroupStep_New(gr->properties, gr->nproperties);
   PLN_GroupStep *grRemote = PLNGroupStep_New(gr->properties, gr->nproperties);
@@ -132,7 +137,7 @@ static void distributeGroupStep(AGGPlan *origPlan, AGGPlan *remote, PLN_BaseStep
 
   // Add remote step
   AGPLN_AddStep(remote, &grRemote->base);
-  return;
+  return rdctx.currentLocal;
 
 cleanup:
     // printf("Couldn't find distribution implementation for %s\n", gr->reducers[ii].name);
@@ -151,6 +156,7 @@ cleanup:
       AGPLN_PopStep(origPlan, stp);
       stp->dtor(stp);
     }
+    return NULL;
 }
 
 /**
@@ -234,40 +240,66 @@ static int distributeSingleArgSelf(ReducerDistCtx *rdctx, QueryError *status) {
   return REDISMODULE_OK;
 }
 
-#define RANDOM_SAMPLE_SIZE 500
-
-#define STRINGIFY_(a) STRINGIFY__(a)
-#define STRINGIFY__(a) #a
-#define RANDOM_SAMPLE_SIZE_STR STRINGIFY_(RANDOM_SAMPLE_SIZE)
-
-/* Distribute QUANTILE into remote RANDOM_SAMPLE and local QUANTILE */
+/* Distribute QUANTILE into remote TDIGEST and local TDIGEST_QUANTILE */
 static int distributeQuantile(ReducerDistCtx *rdctx, QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
   CHECK_ARG_COUNT(2);
   const char *alias = NULL;
 
-  if (!rdctx->addRemote("RANDOM_SAMPLE", &alias, status, "2", rdctx->srcarg(0),
-                        RANDOM_SAMPLE_SIZE_STR)) {
+  if (!rdctx->addRemote("TDIGEST", &alias, status, "1", rdctx->srcarg(0))) {
     return REDISMODULE_ERR;
   }
 
-  if (!rdctx->addLocal("QUANTILE", status, "2", alias, rdctx->srcarg(1), "AS", src->alias)) {
+  if (!rdctx->addLocal("TDIGEST_QUANTILE", status, "2", alias, rdctx->srcarg(1), "AS",
+                       src->alias)) {
     return REDISMODULE_ERR;
   }
 
   return REDISMODULE_OK;
 }
 
-/* Distribute STDDEV into remote RANDOM_SAMPLE and local STDDEV */
+/* Distribute STDDEV into the remote partial deviations (count, mean and sum of squared deviations)
+ * and their exact local merge */
 static int distributeStdDev(ReducerDistCtx *rdctx, QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
   const char *alias = NULL;
   CHECK_ARG_COUNT(1);
-  if (!rdctx->addRemote("RANDOM_SAMPLE", &alias, status, "2", rdctx->srcarg(0),
-                        RANDOM_SAMPLE_SIZE_STR)) {
+  if (!rdctx->addRemote("STDDEV_PARTIAL", &alias, status, "1", rdctx->srcarg(0))) {
+    return REDISMODULE_ERR;
+  }
+  if (!rdctx->addLocal("STDDEV_MERGE", status, "1", alias, "AS", src->alias)) {
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+/* Distribute FIRST_VALUE into remote FIRST_VALUE_PARTIAL, which sends the value along with the value
+ * it is sorted by, and local FIRST_VALUE_MERGE */
+static int distributeFirstValue(ReducerDistCtx *rdctx, QueryError *status) {
+  PLN_Reducer *src = rdctx->srcReducer;
+  const char *alias = NULL;
+  size_t argc = src->args.argc;
+  if (argc == 1) {
+    if (!rdctx->addRemote("FIRST_VALUE_PARTIAL", &alias, status, "1", rdctx->srcarg(0))) {
+      return REDISMODULE_ERR;
+    }
+    if (!rdctx->addLocal("FIRST_VALUE_MERGE", status, "1", alias, "AS", src->alias)) {
+      return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+  }
+
+  if ((argc != 3 && argc != 4) || strcasecmp(rdctx->srcarg(1), "BY")) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Invalid arguments for reducer %s",
+                           src->name);
+    return REDISMODULE_ERR;
+  }
+  const char *dir = argc == 4 ? rdctx->srcarg(3) : "ASC";
+  if (!rdctx->addRemote("FIRST_VALUE_PARTIAL", &alias, status, "4", rdctx->srcarg(0), "BY",
+                        rdctx->srcarg(2), dir)) {
     return REDISMODULE_ERR;
   }
-  if (!rdctx->addLocal("STDDEV", status, "1", alias, "AS", src->alias)) {
+  if (!rdctx->addLocal("FIRST_VALUE_MERGE", status, "2", alias, dir, "AS", src->alias)) {
     return REDISMODULE_ERR;
   }
   return REDISMODULE_OK;
@@ -341,6 +373,7 @@ static struct {
     {"AVG", distributeAvg},
     {"TOLIST", distributeSingleArgSelf},
     {"STDDEV", distributeStdDev},
+    {"FIRST_VALUE", distributeFirstValue},
     {"COUNT_DISTINCTISH", distributeCountDistinctish},
     {"QUANTILE", distributeQuantile},
 
@@ -358,6 +391,109 @@ reducerDistributionFunc getDistributionFunc(const char *key) {
   return NULL;
 }
 
+/**
+ * Once a group step which only keeps the groups with the most results is distributed, the shards
+ * only send their groups with the most results as candidates, a multiple of the groups kept.
+ */
+static void distributeTopCount(AGGPlan *remote, const PLN_ArrangeStep *astp) {
+  auto last = DLLIST_ITEM(remote->steps.prev, PLN_BaseStep, llnodePln);
+  if (last->type != PLN_T_GROUP) {
+    return;
+  }
+  ArgsCursorCXX args("0");
+  PLN_Reducer *count = PLNGroupStep_FindReducer((PLN_GroupStep *)last, "COUNT", &args);
+  if (!count) {
+    return;
+  }
+
+  size_t limit = astp->offset + astp->limit;
+  if (!limit) {
+    limit = DEFAULT_LIMIT;
+  }
+  PLN_ArrangeStep *newStp = AGPLN_GetOrCreateArrangeStep(remote);
+  newStp->limit = limit * RSGlobalConfig.groupByTopNFactor;
+  newStp->sortKeys = array_new(const char *, 1);
+  newStp->sortKeys = array_append(newStp->sortKeys, count->alias);
+  newStp->sortAscMap = SORTASCMAP_INIT;
+  SORTASCMAP_SETDESC(newStp->sortAscMap, 0);
+}
+
+static bool isGroupKey(const PLN_GroupStep *gstp, const char *name) {
+  for (size_t ii = 0; ii < gstp->nproperties; ++ii) {
+    if (!strcmp(stripAtPrefix(gstp->properties[ii]), name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Whether a filter only refers to the keys of a group, and so keeps the same groups on every shard */
+static bool isGroupKeysFilter(const PLN_GroupStep *gstp, const PLN_MapFilterStep *fstp) {
+  QueryError status = {QUERY_OK};
+  RSExpr *expr = ExprAST_Parse(fstp->rawExpr, strlen(fstp->rawExpr), &status);
+  if (!expr) {
+    // Leave it to the local step to report the error
+    QueryError_ClearError(&status);
+    return false;
+  }
+  RLookup keys;
+  RLookup_Init(&keys, NULL);
+  keys.options |= RLOOKUP_OPT_UNRESOLVED_OK;
+  ExprAST_GetLookupKeys(expr, &keys, &status);
+  bool ret = !QueryError_HasError(&status);
+  for (RLookupKey *kk = keys.head; ret && kk != NULL; kk = kk->next) {
+    ret = isGroupKey(gstp, kk->name);
+  }
+  QueryError_ClearError(&status);
+  RLookup_Cleanup(&keys);
+  ExprAST_Free(expr);
+  return ret;
+}
+
+/**
+ * Every group of a distributed group step is keyed the same on every shard, so the filters which
+ * only refer to the group keys are moved to the shards, and so is a sort by the group keys with its
+ * limit: a group among the first ones of the whole results is also among the first ones of every
+ * shard it is in.
+ */
+static void distributeAfterGroup(AGGPlan *src, AGGPlan *remote, PLN_BaseStep *lastLocal,
+                                 const PLN_GroupStep *gstp) {
+  bool keptFilter = false;
+  PLN_BaseStep *current = PLN_NEXT_STEP(lastLocal);
+  while (current != PLN_END_STEP(src)) {
+    if (current->type == PLN_T_FILTER) {
+      if (isGroupKeysFilter(gstp, (PLN_MapFilterStep *)current)) {
+        current = moveStep(remote, src, current);
+      } else {
+        keptFilter = true;
+        current = PLN_NEXT_STEP(current);
+      }
+      continue;
+    }
+    if (current->type != PLN_T_ARRANGE) {
+      return;
+    }
+    // A filter left local may drop groups which sorted first, so the shards should send them all
+    PLN_ArrangeStep *astp = (PLN_ArrangeStep *)current;
+    if (keptFilter || astp->runLocal || !astp->sortKeys || !astp->limit) {
+      return;
+    }
+    for (size_t ii = 0; ii < array_len(astp->sortKeys); ++ii) {
+      if (!isGroupKey(gstp, astp->sortKeys[ii])) {
+        return;
+      }
+    }
+    PLN_ArrangeStep *newStp = (PLN_ArrangeStep *)rm_calloc(1, sizeof(*newStp));
+    *newStp = *astp;
+    newStp->sortKeys = array_new(const char *, array_len(astp->sortKeys));
+    for (size_t ii = 0; ii < array_len(astp->sortKeys); ++ii) {
+      newStp->sortKeys = array_append(newStp->sortKeys, astp->sortKeys[ii]);
+    }
+    AGPLN_AddStep(remote, &newStp->base);
+    return;
+  }
+}
+
 static void finalize_distribution(AGGPlan *src, AGGPlan *remote, PLN_DistributeStep *dstp);
 
 int AGGPLN_Distribute(AGGPlan *src, QueryError *status) {
@@ -461,10 +597,18 @@ int AGGPLN_Distribute(AGGPlan *src, QueryError *status) {
       case PLN_T_GROUP:
         // If we had an arrange step, we must have the group step locally
         if (!hadArrange) {
-          distributeGroupStep(src, remote, current, dstp, status);
+          const PLN_ArrangeStep *topCount =
+              PLNGroupStep_GetTopCountArrange(src, (PLN_GroupStep *)current);
+          PLN_BaseStep *lastLocal = distributeGroupStep(src, remote, current, dstp, status);
           if (QueryError_HasError(status)) {
             goto error;
           }
+          if (topCount && RSGlobalConfig.groupByTopNFactor) {
+            distributeTopCount(remote, topCount);
+          }
+          if (lastLocal) {
+            distributeAfterGroup(src, remote, lastLocal, (PLN_GroupStep *)current);
+          }
         }
         // After the group step, the rest of the steps are local only.
       default:
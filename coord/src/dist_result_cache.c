@@ -0,0 +1,130 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "dist_result_cache.h"
+#include "result_cache.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/fnv.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+typedef struct {
+  ResultCache *cache;
+  uint64_t fingerprint;  // of the ids and revisions of the shards at the current generation
+  uint64_t generation;
+} distResultCacheIndex;
+
+typedef struct {
+  uint64_t id;
+  uint64_t revision;
+} shardRevision;
+
+// index name => distResultCacheIndex, the probes are reduced on the IO threads and the queries on
+// the coordinator threads
+static TrieMap *indexes_g = NULL;
+static pthread_mutex_t lock_g = PTHREAD_MUTEX_INITIALIZER;
+
+static void distResultCacheIndex_Free(void *p) {
+  distResultCacheIndex *idx = p;
+  ResultCache_Free(idx->cache);
+  rm_free(idx);
+}
+
+static int cmpShardRevisions(const void *p1, const void *p2) {
+  const shardRevision *r1 = p1, *r2 = p2;
+  if (r1->id != r2->id) return r1->id < r2->id ? -1 : 1;
+  return r1->revision < r2->revision ? -1 : r1->revision > r2->revision;
+}
+
+static distResultCacheIndex *getIndex(const char *index) {
+  if (!indexes_g) {
+    indexes_g = NewTrieMap();
+  }
+  distResultCacheIndex *idx = TrieMap_Find(indexes_g, (char *)index, strlen(index));
+  if (idx == TRIEMAP_NOTFOUND) {
+    idx = rm_calloc(1, sizeof(*idx));
+    idx->cache = NewResultCache();
+    TrieMap_Add(indexes_g, (char *)index, strlen(index), idx, NULL);
+  }
+  return idx;
+}
+
+uint64_t DistResultCache_Generation(const char *index, MRReply **replies, int count,
+                                    int expected) {
+  bool valid = count > 0 && count == expected;
+  shardRevision *revs = rm_malloc(MAX(count, 1) * sizeof(*revs));
+  for (int i = 0; valid && i < count; ++i) {
+    long long id, revision;
+    valid = MRReply_Type(replies[i]) == MR_REPLY_ARRAY && MRReply_Length(replies[i]) == 2 &&
+            MRReply_ToInteger(MRReply_ArrayElement(replies[i], 0), &id) &&
+            MRReply_ToInteger(MRReply_ArrayElement(replies[i], 1), &revision);
+    revs[i] = (shardRevision){.id = id, .revision = revision};
+  }
+
+  uint64_t generation = 0;
+  pthread_mutex_lock(&lock_g);
+  if (!valid) {
+    // A dropped index answers with an error, its cache goes with it
+    if (indexes_g) {
+      TrieMap_Delete(indexes_g, (char *)index, strlen(index), distResultCacheIndex_Free);
+    }
+  } else {
+    // The shards reply in any order
+    qsort(revs, count, sizeof(*revs), cmpShardRevisions);
+    uint64_t fingerprint = fnv_64a_buf(revs, count * sizeof(*revs), 0);
+    distResultCacheIndex *idx = getIndex(index);
+    if (!idx->generation || idx->fingerprint != fingerprint) {
+      idx->fingerprint = fingerprint;
+      idx->generation++;
+    }
+    generation = idx->generation;
+  }
+  pthread_mutex_unlock(&lock_g);
+  rm_free(revs);
+  return generation;
+}
+
+static ResultCache *getCache(const DistResultCacheKey *ck) {
+  distResultCacheIndex *idx =
+      indexes_g ? TrieMap_Find(indexes_g, ck->index, strlen(ck->index)) : TRIEMAP_NOTFOUND;
+  return idx != TRIEMAP_NOTFOUND ? idx->cache : NULL;
+}
+
+arrayof(char) DistResultCache_Get(const DistResultCacheKey *ck) {
+  if (!ck->generation) {
+    return NULL;
+  }
+  // The cache has a lock of its own, the global lock keeps it from being freed meanwhile
+  pthread_mutex_lock(&lock_g);
+  ResultCache *cache = getCache(ck);
+  arrayof(char) reply =
+      cache ? ResultCache_Get(cache, ck->generation, ck->key, array_len(ck->key)) : NULL;
+  pthread_mutex_unlock(&lock_g);
+  return reply;
+}
+
+void DistResultCache_Put(const DistResultCacheKey *ck, arrayof(char) reply) {
+  pthread_mutex_lock(&lock_g);
+  ResultCache *cache = ck->generation ? getCache(ck) : NULL;
+  if (cache) {
+    ResultCache_Put(cache, ck->generation, ck->key, array_len(ck->key), reply,
+                    RSGlobalConfig.resultCacheMaxMemory, RSGlobalConfig.resultCacheTTL);
+  } else {
+    array_free(reply);
+  }
+  pthread_mutex_unlock(&lock_g);
+}
+
+void DistResultCacheKey_Free(DistResultCacheKey *ck) {
+  rm_free(ck->index);
+  array_free(ck->key);
+  rm_free(ck);
+}
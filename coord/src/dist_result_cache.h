@@ -0,0 +1,42 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "rmr/reply.h"
+#include "util/arr.h"
+
+#include <stdint.h>
+
+/* The replies of the coordinator to the queries of the indexes with a result cache (see
+ * Index_ResultCache), merged from the replies of all the shards.
+ *
+ * Before a query is sent to the shards, the coordinator asks every shard for the unique id and the
+ * revision of the index (see _FT._REVISION). The state of the index over the cluster is then
+ * numbered by a generation, bumped whenever the id or the revision of any shard changes, and a
+ * reply is cached for the generation it was merged at - a write to any shard, or a shard replaced
+ * by another, drops the cached replies of the index */
+
+/* The key of a query, and the generation to cache its reply for */
+typedef struct {
+  char *index;
+  arrayof(char) key;
+  uint64_t generation;
+} DistResultCacheKey;
+
+/* Get the generation of the state of an index, given the replies of the `expected` shards to
+ * _FT._REVISION. Returns 0, which is never cached, if a shard did not reply with its revision */
+uint64_t DistResultCache_Generation(const char *index, MRReply **replies, int count,
+                                    int expected);
+
+/* A copy of the reply to the query cached for its generation (the caller frees it with
+ * array_free), or NULL if it is not cached */
+arrayof(char) DistResultCache_Get(const DistResultCacheKey *ck);
+
+/* Cache a recorded reply to the query for its generation. Takes ownership of `reply` */
+void DistResultCache_Put(const DistResultCacheKey *ck, arrayof(char) reply);
+
+void DistResultCacheKey_Free(DistResultCacheKey *ck);
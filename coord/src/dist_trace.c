@@ -0,0 +1,134 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "dist_trace.h"
+#include "config.h"
+#include "slow_log.h"
+#include "rmalloc.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+static size_t sampleCounter_g = 0;
+
+DistTrace *DistTrace_Sample(const char *index, const char *query, unsigned dialect) {
+  size_t sample = clusterConfig.traceSample;
+  if (!sample || RSGlobalConfig.slowLogThreshold < 0) {
+    return NULL;
+  }
+  size_t n = __atomic_fetch_add(&sampleCounter_g, 1, __ATOMIC_RELAXED);
+  if (n % sample) {
+    return NULL;
+  }
+
+  // unique over the coordinators as long as they do not sample in the same nanosecond
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  uint64_t id = ((uint64_t)ts.tv_sec << 30 ^ (uint64_t)ts.tv_nsec) * 0x9E3779B97F4A7C15ULL + n;
+
+  DistTrace *t = rm_calloc(1, sizeof(*t));
+  snprintf(t->id, sizeof(t->id), "%016llx", (unsigned long long)id);
+  t->index = rm_strdup(index);
+  t->query = SlowLog_NormalizeQuery(query, strlen(query));
+  t->dialect = dialect;
+  t->spans = sdsempty();
+  return t;
+}
+
+MRReply *DistTrace_ShardTrace(MRReply *reply, bool resp3) {
+  if (!reply) {
+    return NULL;
+  }
+  if (resp3) {
+    return MRReply_MapElement(reply, "trace");
+  }
+  if (MRReply_Type(reply) == MR_REPLY_ARRAY && MRReply_Length(reply) == 2 &&
+      MRReply_Type(MRReply_ArrayElement(reply, 1)) == MR_REPLY_ARRAY) {
+    return MRReply_ArrayElement(reply, 1);
+  }
+  return NULL;
+}
+
+// The value of a key of the trace of a shard, a map in RESP3 and a flat array in RESP2
+static MRReply *traceField(MRReply *trace, const char *key) {
+  for (size_t i = 0; i + 1 < MRReply_Length(trace); i += 2) {
+    if (MRReply_StringEquals(MRReply_ArrayElement(trace, i), key, false)) {
+      return MRReply_ArrayElement(trace, i + 1);
+    }
+  }
+  return NULL;
+}
+
+static double traceTime(MRReply *trace, const char *key) {
+  double d = 0;
+  MRReply_ToDouble(traceField(trace, key), &d);
+  return d;
+}
+
+void DistTrace_AddReply(DistTrace *t, MRReply *reply, bool resp3, double dispatched, double replied,
+                        bool refill) {
+  const char *kind = refill ? "refill" : "shard";
+  MRReply *trace = DistTrace_ShardTrace(reply, resp3);
+  if (!trace) {
+    t->spans = sdscatprintf(t->spans, "  %s ? replied=%.3f error\n", kind, replied);
+    t->numSpans++;
+    return;
+  }
+
+  size_t len = 0;
+  MRReply *nodeReply = traceField(trace, "node");
+  const char *node = nodeReply ? MRReply_String(nodeReply, &len) : NULL;
+  long long results = 0;
+  MRReply_ToInteger(traceField(trace, "results"), &results);
+  double total = traceTime(trace, "total_time");
+  // the rest of the round trip is the network, the wait of the command on the shard before it
+  // was executed and the parsing of its reply
+  double network = replied - dispatched - total;
+  t->spans = sdscatprintf(
+      t->spans,
+      "  %s %.*s replied=%.3f network=%.3f queue=%.3f parse=%.3f pipeline=%.3f execution=%.3f"
+      " total=%.3f results=%lld\n",
+      kind, node ? (int)len : 1, node ? node : "?", replied, network > 0 ? network : 0,
+      traceTime(trace, "queue_time"), traceTime(trace, "parse_time"),
+      traceTime(trace, "pipeline_time"), traceTime(trace, "execution_time"), total, results);
+  t->numSpans++;
+}
+
+void DistTrace_Log(DistTrace *t, double dispatch, double lastReply, double merge, double total,
+                   size_t numResults) {
+  if (!SlowLog_IsSlow(total)) {
+    return;
+  }
+  sds s = sdscatprintf(sdsempty(),
+                       "coordinator %s dispatch=%.3f last_reply=%.3f merge=%.3f total=%.3f"
+                       " replies=%zu {\n%s}",
+                       t->id, dispatch, lastReply, merge, total, t->numSpans, t->spans);
+  SlowLogEntry entry = {
+      .index = t->index,
+      .query = t->query,
+      .dialect = t->dialect,
+      .parseTime = dispatch,
+      .execTime = lastReply - dispatch,
+      .totalTime = total,
+      .numResults = numResults,
+      .trace = rm_strndup(s, sdslen(s)),
+  };
+  sdsfree(s);
+  // the entry owns the strings
+  t->index = t->query = NULL;
+  SlowLog_Add(&entry);
+}
+
+void DistTrace_Free(DistTrace *t) {
+  if (!t) {
+    return;
+  }
+  rm_free(t->index);
+  rm_free(t->query);
+  sdsfree(t->spans);
+  rm_free(t);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "rmr/reply.h"
+#include "rmutil/sds.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The traces of the distributed searches, one of every TRACE_SAMPLE of them.
+ *
+ * A traced search is sent to the shards with `_TRACE {id}`, and every shard adds the times of its
+ * part of the query to its reply: a "trace" map in RESP3, the second element of the reply in RESP2
+ * (see AREQ.traceId). The coordinator adds a span to the trace for every reply as it arrives, and
+ * once the replies are merged logs the trace to FT.SLOWLOG with its own times, if the search took
+ * at least SLOWLOG_THRESHOLD */
+
+// The trace ids are 64 bits, in hex
+#define DIST_TRACE_ID_LEN 16
+
+typedef struct {
+  char id[DIST_TRACE_ID_LEN + 1];
+  char *index;
+  char *query;
+  unsigned dialect;
+  // A line per reply of a shard, in the order they arrived
+  sds spans;
+  size_t numSpans;
+} DistTrace;
+
+/* A new trace of a search over `index` if it is sampled, or NULL */
+DistTrace *DistTrace_Sample(const char *index, const char *query, unsigned dialect);
+
+/* The trace a shard added to its reply, or NULL if it did not add one, as on an error */
+MRReply *DistTrace_ShardTrace(MRReply *reply, bool resp3);
+
+/* Add a span of the reply of a shard, which arrived `replied` milliseconds after the search
+ * started, `dispatched` milliseconds after it was sent. `refill` is set for the replies of the
+ * shards asked for the rest of their results */
+void DistTrace_AddReply(DistTrace *t, MRReply *reply, bool resp3, double dispatched, double replied,
+                        bool refill);
+
+/* Log the trace to FT.SLOWLOG if the search is slow, given the times in milliseconds of the
+ * coordinator: until the search was sent, until the last shard replied, merging the replies and
+ * in all */
+void DistTrace_Log(DistTrace *t, double dispatch, double lastReply, double merge, double total,
+                   size_t numResults);
+
+void DistTrace_Free(DistTrace *t);
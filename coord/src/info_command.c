@@ -5,7 +5,12 @@
  */
 
 #include "info_command.h"
+#include "config.h"
 #include "resp3.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+
+#include <time.h>
 
 // Type of field returned in INFO
 typedef enum {
@@ -63,11 +68,44 @@ static InfoFieldSpec dialectSpecs[] = {
     {.name = "dialect_4", .type = InfoField_Max},
 };
 
+static InfoFieldSpec expansionCacheSpecs[] = {
+    {.name = "hits", .type = InfoField_WholeSum},
+    {.name = "misses", .type = InfoField_WholeSum},
+    {.name = "entries", .type = InfoField_WholeSum},
+    {.name = "size_mb", .type = InfoField_DoubleSum},
+};
+
+static InfoFieldSpec resultCacheSpecs[] = {
+    {.name = "hits", .type = InfoField_WholeSum},
+    {.name = "misses", .type = InfoField_WholeSum},
+    {.name = "evictions", .type = InfoField_WholeSum},
+    {.name = "entries", .type = InfoField_WholeSum},
+    {.name = "size_mb", .type = InfoField_DoubleSum},
+};
+
+static InfoFieldSpec asyncUpdatesSpecs[] = {
+    {.name = "queue_depth", .type = InfoField_WholeSum},
+    {.name = "lag_ms", .type = InfoField_Max},
+    {.name = "drained", .type = InfoField_WholeSum},
+};
+
+static InfoFieldSpec lazyIndexSpecs[] = {
+    {.name = "loaded", .type = InfoField_WholeSum},  // the number of shards the index is loaded on
+    {.name = "idle_timeout_sec", .type = InfoField_Max},
+    {.name = "loads", .type = InfoField_WholeSum},
+    {.name = "evictions", .type = InfoField_WholeSum},
+    {.name = "last_load_ms", .type = InfoField_Max},
+};
+
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(*arr))
 #define NUM_FIELDS_SPEC (ARRAY_SIZE(toplevelSpecs_g))
 #define NUM_GC_FIELDS_SPEC (ARRAY_SIZE(gcSpecs))
 #define NUM_CURSOR_FIELDS_SPEC (ARRAY_SIZE(cursorSpecs))
 #define NUM_DIALECT_FIELDS_SPEC (ARRAY_SIZE(dialectSpecs))
+#define NUM_EXPANSION_CACHE_FIELDS_SPEC (ARRAY_SIZE(expansionCacheSpecs))
+#define NUM_RESULT_CACHE_FIELDS_SPEC (ARRAY_SIZE(resultCacheSpecs))
+#define NUM_ASYNC_UPDATES_FIELDS_SPEC (ARRAY_SIZE(asyncUpdatesSpecs))
+#define NUM_LAZY_INDEX_FIELDS_SPEC (ARRAY_SIZE(lazyIndexSpecs))
 
 // Variant value type
 typedef struct {
@@ -94,6 +132,13 @@ typedef struct {
   InfoValue gcValues[NUM_GC_FIELDS_SPEC];
   InfoValue cursorValues[NUM_CURSOR_FIELDS_SPEC];
   InfoValue dialectValues[NUM_DIALECT_FIELDS_SPEC];
+  InfoValue expansionCacheValues[NUM_EXPANSION_CACHE_FIELDS_SPEC];
+  int hasResultCache;  // only indexes with RESULTCACHE reply with its stats
+  InfoValue resultCacheValues[NUM_RESULT_CACHE_FIELDS_SPEC];
+  int hasAsyncUpdates;  // only indexes with ASYNCUPDATES reply with their queue stats
+  InfoValue asyncUpdatesValues[NUM_ASYNC_UPDATES_FIELDS_SPEC];
+  int hasLazyIndex;  // only indexes with LAZY reply with their load state
+  InfoValue lazyIndexValues[NUM_LAZY_INDEX_FIELDS_SPEC];
 } InfoFields;
 
 /**
@@ -168,6 +213,21 @@ static void handleSpecialField(InfoFields *fields, const char *name, MRReply *va
     processKvArray(fields, value, fields->cursorValues, cursorSpecs, NUM_CURSOR_FIELDS_SPEC, 1);
   } else if (!strcmp(name, "dialect_stats")) {
     processKvArray(fields, value, fields->dialectValues, dialectSpecs, NUM_DIALECT_FIELDS_SPEC, 1);
+  } else if (!strcmp(name, "expansion_cache_stats")) {
+    processKvArray(fields, value, fields->expansionCacheValues, expansionCacheSpecs,
+                   NUM_EXPANSION_CACHE_FIELDS_SPEC, 1);
+  } else if (!strcmp(name, "result_cache_stats")) {
+    fields->hasResultCache = 1;
+    processKvArray(fields, value, fields->resultCacheValues, resultCacheSpecs,
+                   NUM_RESULT_CACHE_FIELDS_SPEC, 1);
+  } else if (!strcmp(name, "async_updates_stats")) {
+    fields->hasAsyncUpdates = 1;
+    processKvArray(fields, value, fields->asyncUpdatesValues, asyncUpdatesSpecs,
+                   NUM_ASYNC_UPDATES_FIELDS_SPEC, 1);
+  } else if (!strcmp(name, "lazy_index_stats")) {
+    fields->hasLazyIndex = 1;
+    processKvArray(fields, value, fields->lazyIndexValues, lazyIndexSpecs,
+                   NUM_LAZY_INDEX_FIELDS_SPEC, 1);
   }
 }
 
@@ -234,6 +294,15 @@ static void replyKvArray(RedisModule_Reply *reply, InfoFields *fields, InfoValue
   }
 }
 
+static void generateSummaryReply(InfoFields *fields, RedisModule_Reply *reply) {
+  RedisModule_Reply_Map(reply);
+  if (fields->indexName) {
+    RedisModule_ReplyKV_StringBuffer(reply, "index_name", fields->indexName, fields->indexNameLen);
+  }
+  replyKvArray(reply, fields, fields->toplevelValues, toplevelSpecs_g, NUM_FIELDS_SPEC);
+  RedisModule_Reply_MapEnd(reply);
+}
+
 static void generateFieldsReply(InfoFields *fields, RedisModule_Reply *reply) {
   RedisModule_Reply_Map(reply);
 
@@ -266,23 +335,121 @@ static void generateFieldsReply(InfoFields *fields, RedisModule_Reply *reply) {
   replyKvArray(reply, fields, fields->dialectValues, dialectSpecs, NUM_DIALECT_FIELDS_SPEC);
   RedisModule_Reply_MapEnd(reply);
 
+  RedisModule_ReplyKV_Map(reply, "expansion_cache_stats");
+  replyKvArray(reply, fields, fields->expansionCacheValues, expansionCacheSpecs,
+               NUM_EXPANSION_CACHE_FIELDS_SPEC);
+  RedisModule_Reply_MapEnd(reply);
+
+  if (fields->hasResultCache) {
+    RedisModule_ReplyKV_Map(reply, "result_cache_stats");
+    replyKvArray(reply, fields, fields->resultCacheValues, resultCacheSpecs,
+                 NUM_RESULT_CACHE_FIELDS_SPEC);
+    RedisModule_Reply_MapEnd(reply);
+  }
+
+  if (fields->hasAsyncUpdates) {
+    RedisModule_ReplyKV_Map(reply, "async_updates_stats");
+    replyKvArray(reply, fields, fields->asyncUpdatesValues, asyncUpdatesSpecs,
+                 NUM_ASYNC_UPDATES_FIELDS_SPEC);
+    RedisModule_Reply_MapEnd(reply);
+  }
+
+  if (fields->hasLazyIndex) {
+    RedisModule_ReplyKV_Map(reply, "lazy_index_stats");
+    replyKvArray(reply, fields, fields->lazyIndexValues, lazyIndexSpecs,
+                 NUM_LAZY_INDEX_FIELDS_SPEC);
+    RedisModule_Reply_MapEnd(reply);
+  }
+
   replyKvArray(reply, fields, fields->toplevelValues, toplevelSpecs_g, NUM_FIELDS_SPEC);
 
   RedisModule_Reply_MapEnd(reply);
 }
 
+/* The merged replies, by the key of their request. Only used from the main thread */
+static TrieMap *infoCache_g = NULL;
+
+typedef struct {
+  arrayof(char) reply;
+  long long time;  // when it was merged, in milliseconds
+} infoCacheEntry;
+
+static long long nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static void infoCacheEntry_Free(void *p) {
+  infoCacheEntry *e = p;
+  array_free(e->reply);
+  rm_free(e);
+}
+
+InfoRequest *InfoRequest_New(const char *index, bool summary, bool resp3) {
+  InfoRequest *req = rm_malloc(sizeof(*req));
+  rm_asprintf(&req->cacheKey, "%c%c%s", summary ? 'S' : 'F', resp3 ? '3' : '2', index);
+  req->summary = summary;
+  return req;
+}
+
+void InfoRequest_Free(InfoRequest *req) {
+  rm_free(req->cacheKey);
+  rm_free(req);
+}
+
+bool InfoRequest_ReplyCached(RedisModuleCtx *ctx, InfoRequest *req) {
+  if (!infoCache_g) {
+    return false;
+  }
+  size_t len = strlen(req->cacheKey);
+  infoCacheEntry *e = TrieMap_Find(infoCache_g, req->cacheKey, len);
+  if (e == TRIEMAP_NOTFOUND) {
+    return false;
+  }
+  if (nowMs() - e->time >= clusterConfig.infoCacheTTL) {
+    TrieMap_Delete(infoCache_g, req->cacheKey, len, infoCacheEntry_Free);
+    return false;
+  }
+  RedisModule_Reply_Replay(ctx, e->reply, array_len(e->reply));
+  return true;
+}
+
+static void infoCache_Put(InfoRequest *req, arrayof(char) reply) {
+  if (!infoCache_g) {
+    infoCache_g = NewTrieMap();
+  }
+  infoCacheEntry *e = rm_malloc(sizeof(*e));
+  e->reply = reply;
+  e->time = nowMs();
+  TrieMap_Delete(infoCache_g, req->cacheKey, strlen(req->cacheKey), infoCacheEntry_Free);
+  TrieMap_Add(infoCache_g, req->cacheKey, strlen(req->cacheKey), e, NULL);
+}
+
+void InfoCache_Free() {
+  if (infoCache_g) {
+    TrieMap_Free(infoCache_g, infoCacheEntry_Free);
+    infoCache_g = NULL;
+  }
+}
+
 int InfoReplyReducer(struct MRCtx *mc, int count, MRReply **replies) {
   // Summarize all aggregate replies
   InfoFields fields = {0};
   size_t numErrored = 0;
   MRReply *firstError = NULL;
   RedisModuleCtx *ctx = MRCtx_GetRedisCtx(mc);
+  InfoRequest *req = MRCtx_GetPrivData(mc);
 
   if (count == 0) {
+    InfoRequest_Free(req);
     return RedisModule_ReplyWithError(ctx, "ERR no responses received");
   }
 
   RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  if (clusterConfig.infoCacheTTL) {
+    RedisModule_Reply_Record(reply);
+  }
 
   for (size_t ii = 0; ii < count; ++ii) {
     if (MRReply_Type(replies[ii]) == MR_REPLY_ERROR) {
@@ -315,11 +482,22 @@ int InfoReplyReducer(struct MRCtx *mc, int count, MRReply **replies) {
   if (numErrored == count) {
     // Reply with error
     MR_ReplyWithMRReply(reply, firstError);
+  } else if (req->summary) {
+    generateSummaryReply(&fields, reply);
   } else {
     generateFieldsReply(&fields, reply);
   }
 
+  // Only the replies of all the shards are cached
+  arrayof(char) recording = RedisModule_Reply_TakeRecording(reply);
+  if (recording && !numErrored && MRCtx_GetNumErrored(mc) == 0) {
+    infoCache_Put(req, recording);
+  } else {
+    array_free(recording);
+  }
+
   cleanInfoReply(&fields);
+  InfoRequest_Free(req);
   RedisModule_EndReply(reply);
   return REDISMODULE_OK;
 }
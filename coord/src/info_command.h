@@ -11,4 +11,24 @@
 #include "rmr/rmr.h"
 #include "rmr/reply.h"
 
+#include <stdbool.h>
+
+/* An FT.INFO fanned out to the shards, the private data of InfoReplyReducer */
+typedef struct {
+  // the key of the reply in the cache, by the index, the variant and the protocol
+  char *cacheKey;
+  // FT.INFO {index} SUMMARY, replying with the counters only
+  bool summary;
+} InfoRequest;
+
+InfoRequest *InfoRequest_New(const char *index, bool summary, bool resp3);
+void InfoRequest_Free(InfoRequest *req);
+
+/* Reply with the cached reply to the request if it was merged less than INFO_CACHE_TTL ago */
+bool InfoRequest_ReplyCached(RedisModuleCtx *ctx, InfoRequest *req);
+
+/* Merge the replies of the shards to an FT.INFO, caching the merged reply. Frees the request */
 int InfoReplyReducer(struct MRCtx *mc, int count, MRReply **replies);
+
+/* Free the cached replies */
+void InfoCache_Free();
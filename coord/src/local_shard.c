@@ -0,0 +1,178 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "local_shard.h"
+#include "config.h"
+#include "rmr/cluster.h"
+#include "aggregate/aggregate.h"
+#include "commands.h"
+#include "util/workers.h"
+#include "rmalloc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+  RedisModuleString **argv;
+  int argc;
+  bool search;
+  bool resp3;
+  MRLocalRequest *req;
+} LocalShardJob;
+
+static void replySetString(MRReply *r, const char *str, size_t len) {
+  r->str = hi_malloc(len + 1);
+  memcpy(r->str, str, len);
+  r->str[len] = '\0';
+  r->len = len;
+}
+
+/* The shortest text of a double which reads back as the same double, as the shard replies with */
+static size_t formatDouble(double d, char *buf, size_t size) {
+  if (isinf(d)) {
+    return snprintf(buf, size, "%s", d > 0 ? "inf" : "-inf");
+  }
+  int n = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    n = snprintf(buf, size, "%.*g", precision, d);
+    if (strtod(buf, NULL) == d) {
+      break;
+    }
+  }
+  return n;
+}
+
+static MRReply *replyFromRecording(const char **p, bool resp3) {
+  RedisModule_Reply_RecordedValue v;
+  *p = RedisModule_Reply_ReadRecorded(*p, &v);
+  MRReply *r = hi_calloc(1, sizeof(*r));
+  switch (v.type) {
+    case REPLY_RECORD_LONGLONG:
+      r->type = MR_REPLY_INTEGER;
+      r->integer = v.ll;
+      break;
+    case REPLY_RECORD_DOUBLE: {
+      // RESP2 has no doubles, they are replied as strings
+      char buf[64];
+      size_t n = formatDouble(v.d, buf, sizeof(buf));
+      r->type = resp3 ? MR_REPLY_DOUBLE : MR_REPLY_STRING;
+      r->dval = v.d;
+      replySetString(r, buf, n);
+      break;
+    }
+    case REPLY_RECORD_SIMPLE_STRING:
+      r->type = MR_REPLY_STATUS;
+      replySetString(r, v.str, v.len - 1);
+      break;
+    case REPLY_RECORD_STRING:
+      r->type = MR_REPLY_STRING;
+      replySetString(r, v.str, v.len);
+      break;
+    case REPLY_RECORD_ERROR:
+      r->type = MR_REPLY_ERROR;
+      replySetString(r, v.str, v.len - 1);
+      break;
+    case REPLY_RECORD_NULL:
+      r->type = MR_REPLY_NIL;
+      break;
+    case REPLY_RECORD_ARRAY:
+    case REPLY_RECORD_MAP:
+    case REPLY_RECORD_SET:
+      r->type = v.type == REPLY_RECORD_MAP ? MR_REPLY_MAP :
+                v.type == REPLY_RECORD_SET ? MR_REPLY_SET : MR_REPLY_ARRAY;
+      r->elements = v.len;
+      if (v.len) {
+        r->element = hi_calloc(v.len, sizeof(*r->element));
+        for (size_t i = 0; i < v.len; ++i) {
+          r->element[i] = replyFromRecording(p, resp3);
+        }
+      }
+      break;
+  }
+  return r;
+}
+
+MRReply *LocalShard_ReplyFromRecording(const char *recording, size_t len, bool resp3) {
+  if (!len) {
+    return NULL;
+  }
+  const char *p = recording;
+  return replyFromRecording(&p, resp3);
+}
+
+static void localShardJob_Free(LocalShardJob *job) {
+  for (int i = 0; i < job->argc; ++i) {
+    RedisModule_FreeString(NULL, job->argv[i]);
+  }
+  rm_free(job->argv);
+  rm_free(job);
+}
+
+static void localShardJob_Run(LocalShardJob *job) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  RedisModule_Reply _reply = RedisModule_NewRecordedReply(ctx, job->resp3), *reply = &_reply;
+  AREQ_ExecuteRecorded(ctx, job->argv, job->argc, job->search, reply);
+  arrayof(char) recording = RedisModule_Reply_TakeRecording(reply);
+  RedisModule_EndReply(reply);
+  RedisModule_FreeThreadSafeContext(ctx);
+
+  MRReply *rep = NULL;
+  if (recording) {
+    rep = LocalShard_ReplyFromRecording(recording, array_len(recording), job->resp3);
+    array_free(recording);
+  }
+  MRLocalRequest_Reply(job->req, rep);
+  localShardJob_Free(job);
+}
+
+static bool argEquals(const MRCommand *cmd, size_t i, const char *s) {
+  size_t len;
+  const char *arg = MRCommand_ArgStringPtrLen(cmd, i, &len);
+  return len == strlen(s) && !strncasecmp(arg, s, len);
+}
+
+static int localShardExec(MRCommand *cmd, MRLocalRequest *req) {
+#ifdef MT_BUILD
+  if (!clusterConfig.localShardInProcess || !RunInThread() || cmd->num < 2) {
+    return REDIS_ERR;
+  }
+  bool search = argEquals(cmd, 0, RS_SEARCH_CMD);
+  if (!search && !argEquals(cmd, 0, RS_AGGREGATE_CMD)) {
+    return REDIS_ERR;
+  }
+  // The queries of several vectors reply with an array of replies, the shard runs them itself
+  for (size_t i = 2; i < cmd->num; ++i) {
+    if (argEquals(cmd, i, "MULTIVECTOR")) {
+      return REDIS_ERR;
+    }
+  }
+  // A query which would wait behind too many others is sent, for the shard to reject it
+  if (!workersThreadPool_AdmitQuery()) {
+    return REDIS_ERR;
+  }
+
+  LocalShardJob *job = rm_malloc(sizeof(*job));
+  job->argc = cmd->num;
+  job->argv = rm_malloc(cmd->num * sizeof(*job->argv));
+  for (size_t i = 0; i < cmd->num; ++i) {
+    job->argv[i] = RedisModule_CreateString(NULL, cmd->strs[i], cmd->lens[i]);
+  }
+  job->search = search;
+  job->resp3 = cmd->protocol == 3;
+  job->req = req;
+  workersThreadPool_AddWork((redisearch_thpool_proc)localShardJob_Run, job);
+  return REDIS_OK;
+#else
+  return REDIS_ERR;
+#endif
+}
+
+void LocalShard_Init() {
+  MRCluster_SetLocalExecutor(localShardExec);
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "rmr/reply.h"
+
+#include <stddef.h>
+
+/* The searches and aggregates of the coordinator to the shard of its own process, run in the
+ * process (see the LOCAL_SHARD_IN_PROCESS config).
+ *
+ * Rather than being sent over a connection to the process itself, such a command is run on the
+ * workers of the shard as the shard would run it, its reply being recorded (see
+ * RedisModule_NewRecordedReply) and handed to the coordinator as an MRReply. This spares formatting
+ * the command, serializing the reply to RESP, the loopback round trip and parsing the reply. The
+ * cursors of aggregates are read over the connection as usual, from the same cursor list */
+
+/* Set the executor of the commands to the node of the process (see MRCluster_SetLocalExecutor) */
+void LocalShard_Init();
+
+/* The reply recorded by a recorded reply of the shard, in RESP3 if `resp3` */
+MRReply *LocalShard_ReplyFromRecording(const char *recording, size_t len, bool resp3);
@@ -40,8 +40,15 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include "query.h"
+#include "result_cache.h"
+#include "latency_stats.h"
+#include "alloc_stats.h"
+#include "prepared_query.h"
+#include "local_shard.h"
+#include "tag_index.h"
 
 #define CLUSTERDOWN_ERR "ERRCLUSTER Uninitialized cluster state, could not perform command"
+#define OVERLOADED_ERR "BUSY Too many requests pending for the shards, try again later"
 
 extern RSConfig RSGlobalConfig;
 
@@ -73,63 +80,104 @@ int chainReplyReducer(struct MRCtx *mc, int count, MRReply **replies) {
   return REDISMODULE_OK;
 }
 
-// A reducer that just merges N sets of strings by chaining them into one big array with no
-// duplicates
+/* The values of a tag field replied by a shard to FT.TAGVALS, in the order of its index */
+typedef struct {
+  MRReply *rep;
+  size_t pos;
+} tagValsStream;
+
+static const char *tagValsStream_Head(tagValsStream *st, size_t *len) {
+  return st->pos < MRReply_Length(st->rep)
+             ? MRReply_String(MRReply_ArrayElement(st->rep, st->pos), len)
+             : NULL;
+}
 
-int uniqueStringsReducer(struct MRCtx *mc, int count, MRReply **replies) {
+// A reducer that merges the values of a tag field replied by the shards. They reply in the same
+// order, so the replies are merged as sorted streams, each value once, with the sum of its counts
+// with WITHCOUNTS
+
+int tagValsReducer(struct MRCtx *mc, int count, MRReply **replies) {
   RedisModuleCtx *ctx = MRCtx_GetRedisCtx(mc);
   RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  TagValsOptions *opts = MRCtx_GetPrivData(mc);
+  size_t step = opts->withCounts ? 2 : 1;
 
   MRReply *err = NULL;
-
-  TrieMap *dict = NewTrieMap();
-  int nArrs = 0;
-  // Add all the set elements into the dedup dict
+  tagValsStream *streams = rm_calloc(MAX(count, 1), sizeof(*streams));
+  int nstreams = 0;
   for (int i = 0; i < count; i++) {
     if (replies[i] && (MRReply_Type(replies[i]) == MR_REPLY_ARRAY
     || MRReply_Type(replies[i]) == MR_REPLY_SET)) {
-      nArrs++;
-      for (size_t j = 0; j < MRReply_Length(replies[i]); j++) {
-        size_t sl = 0;
-        char *s = MRReply_String(MRReply_ArrayElement(replies[i], j), &sl);
-        if (s && sl) {
-          TrieMap_Add(dict, s, sl, NULL, NULL);
-        }
-      }
-    } else if (MRReply_Type(replies[i]) == MR_REPLY_ERROR && err == NULL) {
+      streams[nstreams++].rep = replies[i];
+    } else if (replies[i] && MRReply_Type(replies[i]) == MR_REPLY_ERROR && err == NULL) {
       err = replies[i];
     }
   }
 
-  // if there are no values - either reply with an empty set or an error
-  if (dict->cardinality == 0) {
-
-    if (nArrs > 0) {
-      // the sets were empty - return an empty set
-      RedisModule_Reply_Set(reply);
-      RedisModule_Reply_SetEnd(reply);
+  if (nstreams == 0) {
+    if (err) {
+      MR_ReplyWithMRReply(reply, err);
     } else {
-      RedisModule_ReplyWithError(ctx, err ? (const char *)err : "Could not perfrom query");
+      RedisModule_Reply_Error(reply, "Could not perfrom query");
     }
     goto cleanup;
   }
 
-  // Iterate the dict and reply with all values
-  RedisModule_Reply_Set(reply);
-    char *s;
-    tm_len_t sl;
-    void *p;
-    TrieMapIterator *it = TrieMap_Iterate(dict, "", 0);
-    while (TrieMapIterator_Next(it, &s, &sl, &p)) {
-      RedisModule_Reply_StringBuffer(reply, s, sl);
+  if (opts->ordered) {
+    RedisModule_Reply_Array(reply);
+  } else {
+    RedisModule_Reply_Set(reply);
+  }
+  size_t skipped = 0, n = 0;
+  while (!opts->limit || n < opts->limit) {
+    // the smallest value at the head of the streams
+    const char *min = NULL;
+    size_t minLen = 0;
+    for (int i = 0; i < nstreams; i++) {
+      size_t len;
+      const char *s = tagValsStream_Head(&streams[i], &len);
+      if (s && (!min || TrieMap_KeyCmp(s, len, min, minLen) < 0)) {
+        min = s;
+        minLen = len;
+      }
     }
-    TrieMapIterator_Free(it);
-  RedisModule_Reply_SetEnd(reply);
+    if (!min) {
+      break;
+    }
+    // take the value off the head of every stream, the replies holding it are kept till the end
+    long long numDocs = 0;
+    for (int i = 0; i < nstreams; i++) {
+      size_t len;
+      const char *s = tagValsStream_Head(&streams[i], &len);
+      if (s && !TrieMap_KeyCmp(s, len, min, minLen)) {
+        long long shardDocs = 0;
+        if (opts->withCounts) {
+          MRReply_ToInteger(MRReply_ArrayElement(streams[i].rep, streams[i].pos + 1), &shardDocs);
+        }
+        numDocs += shardDocs;
+        streams[i].pos += step;
+      }
+    }
+    if (skipped < opts->offset) {
+      skipped++;
+      continue;
+    }
+    RedisModule_Reply_StringBuffer(reply, min, minLen);
+    if (opts->withCounts) {
+      RedisModule_Reply_LongLong(reply, numDocs);
+    }
+    n++;
+  }
+  if (opts->ordered) {
+    RedisModule_Reply_ArrayEnd(reply);
+  } else {
+    RedisModule_Reply_SetEnd(reply);
+  }
 
 cleanup:
-  TrieMap_Free(dict, NULL);
+  rm_free(streams);
+  rm_free(opts);
   RedisModule_EndReply(reply);
-
   return REDISMODULE_OK;
 }
 
@@ -296,7 +344,7 @@ int synonymUpdateFanOutReducer(struct MRCtx *mc, int count, MRReply **replies) {
   cg.Free(cg.ctx);
 
   // we need to call request complete here manualy since we did not unblocked the client
-  MR_requestCompleted();
+  MR_requestCompleted(mc);
   return REDISMODULE_OK;
 }
 
@@ -376,6 +424,7 @@ typedef struct {
   const char *sortKey;
   size_t sortKeyLen;
   double sortKeyNum;
+  uint64_t sortKeyPrefix;  // the first bytes of a string sort key, see StrSortPrefix
 } searchResult;
 
 struct searchReducerCtx; // Predecleration
@@ -390,7 +439,21 @@ typedef struct {
   int sortKey;
 } searchReplyOffsets;
 
-typedef struct{
+// What the first reply of a shard tells of the rest of its results (see searchRefill)
+typedef struct {
+  bool replied;
+  // The number of results it replied with, out of its total number of results
+  size_t nrows;
+  long long total;
+  // The rest of its results were found not to make the cut as they were merged
+  bool pruned;
+  // The last result merged, which the rest of its results follow
+  searchResult last;
+  // Or the distance of the last one merged into the top K results of a KNN query
+  double lastDistance;
+} searchShardReply;
+
+typedef struct searchReducerCtx {
   MRReply *fieldNames;
   MRReply *lastError;
   searchResult *cachedResult;
@@ -404,6 +467,18 @@ typedef struct{
   postProcessReplyCB postProcess;
   specialCaseCtx* reduceSpecialCaseCtxKnn;
   specialCaseCtx* reduceSpecialCaseCtxSortby;
+
+  // When each shard is asked for its top `shardLimit` results only, the state of every shard, the
+  // shard whose reply is being merged, and the position of the LIMIT in the shard commands
+  size_t shardLimit;
+  searchShardReply *shards;
+  size_t numShards;
+  searchShardReply *curShard;
+  int limitArg;
+  // The shards which may hold more of the top results were asked for them
+  bool refilling;
+  // The shards are not asked for more of the top K results of a KNN query
+  bool approximate;
 } searchReducerCtx;
 
 typedef struct {
@@ -439,6 +514,10 @@ void searchRequestCtx_Free(searchRequestCtx *r) {
   if(r->requiredFields) {
     array_free(r->requiredFields);
   }
+  if (r->cacheKey) {
+    DistResultCacheKey_Free(r->cacheKey);
+  }
+  DistTrace_Free(r->trace);
   rm_free(r);
 }
 
@@ -587,6 +666,11 @@ searchRequestCtx *rscParseRequest(RedisModuleString **argv, int argc, QueryError
   }
 
   searchRequestCtx *req = rm_malloc(sizeof *req);
+  req->cacheKey = NULL;
+  req->trace = NULL;
+  hires_clock_get(&req->startClock);
+  req->lastReplyTime = 0;
+  req->refillTime = 0;
 
   if (rscParseProfile(req, argv) != REDISMODULE_OK) {
     searchRequestCtx_Free(req);
@@ -658,6 +742,7 @@ searchRequestCtx *rscParseRequest(RedisModuleString **argv, int argc, QueryError
         return NULL;
       }
   }
+  req->dialect = dialect;
 
   if(dialect >= 2) {
     // Note: currently there is only one single case. For extending those cases we should use a trie here.
@@ -674,6 +759,7 @@ searchRequestCtx *rscParseRequest(RedisModuleString **argv, int argc, QueryError
   }
 
   req->format = QEXEC_FORMAT_DEFAULT;
+  req->reducer = NULL;
   argIndex = RMUtil_ArgExists("FORMAT", argv, argc, argvOffset);
   if(argIndex > 0) {
     argIndex++;
@@ -717,8 +803,12 @@ static int cmp_results(const void *p1, const void *p2, const void *udata) {
         cmp = diff < 0 ? -1 : (diff > 0 ? 1 : 0);
       } else if (r1->sortKey && r2->sortKey) {
 
-        // Sort by string sort keys
-        cmp = cmpStrings(r2->sortKey, r2->sortKeyLen, r1->sortKey, r1->sortKeyLen);
+        // Sort by string sort keys, in full only if their prefixes are the same
+        if (r1->sortKeyPrefix != r2->sortKeyPrefix) {
+          cmp = r2->sortKeyPrefix > r1->sortKeyPrefix ? 1 : -1;
+        } else {
+          cmp = cmpStrings(r2->sortKey, r2->sortKeyLen, r1->sortKey, r1->sortKeyLen);
+        }
         // printf("Using sortKey!! <N=%lu> %.*s vs <N=%lu> %.*s. Result=%d\n", r2->sortKeyLen,
         //        (int)r2->sortKeyLen, r2->sortKey, r1->sortKeyLen, (int)r1->sortKeyLen, r1->sortKey,
         //        cmp);
@@ -818,6 +908,9 @@ searchResult *newResult_resp2(searchResult *cached, MRReply *arr, int j, searchR
     }
     // fprintf(stderr, "Sort key string '%s', num '%f\n", res->sortKey, res->sortKeyNum);
   }
+  if (res->sortKey) {
+    res->sortKeyPrefix = StrSortPrefix(res->sortKey, res->sortKeyLen);
+  }
   return res;
 }
 
@@ -895,6 +988,9 @@ searchResult *newResult_resp3(searchResult *cached, MRReply *results, int j, sea
       }
     }
   }
+  if (res->sortKey) {
+    res->sortKeyPrefix = StrSortPrefix(res->sortKey, res->sortKeyLen);
+  }
 
   return res;
 }
@@ -1038,6 +1134,21 @@ static void proccessKNNSearchResult(searchResult *res, searchReducerCtx *rCtx, d
     }
 }
 
+// Keep track of the last result of the current shard merged into the top K results, which the
+// shard replies with by their distance when asked for part of them first (see searchRefill)
+static void knnShardResult(searchResult *res, searchReducerCtx *rCtx, double score) {
+  searchShardReply *shard = rCtx->curShard;
+  if (!shard) {
+    return;
+  }
+  if (rCtx->cachedResult == res) {
+    // It did not make the cut, and the rest of the results of the shard are further
+    shard->pruned = true;
+  } else if (!shard->pruned) {
+    shard->lastDistance = score;
+  }
+}
+
 static void proccessKNNSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisModuleCtx *ctx) {
   if (arr == NULL) {
     return;
@@ -1065,6 +1176,11 @@ static void proccessKNNSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisMo
     MRReply *results = MRReply_MapElement(arr, "results");
     RS_LOG_ASSERT(results && MRReply_Type(results) == MR_REPLY_ARRAY, "invalid results record");
     size_t len = MRReply_Length(results);
+    MRReply *total_results = MRReply_MapElement(arr, "total_results");
+    if (rCtx->curShard && total_results) {
+      rCtx->curShard->total = MRReply_Integer(total_results);
+      rCtx->curShard->nrows = len;
+    }
     for (int j = 0; j < len; ++j) {
       res = newResult_resp3(rCtx->cachedResult, results, j, &rCtx->offsets, rCtx->searchCtx->withExplainScores, reduceSpecialCaseCtxSortBy);
       if (res && res->id) {
@@ -1086,6 +1202,7 @@ static void proccessKNNSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisMo
       double d;
       GET_NUMERIC_SCORE(d, res, MRReply_String(score_value, NULL));
       proccessKNNSearchResult(res, rCtx, d, &reduceSpecialCaseCtxKnn->knn);
+      knnShardResult(res, rCtx, d);
     }
     processResultFormat(&req->format, arr);
     
@@ -1093,6 +1210,10 @@ static void proccessKNNSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisMo
     size_t len = MRReply_Length(arr);
     int step = rCtx->offsets.step;
     int scoreOffset = reduceSpecialCaseCtxKnn->knn.offset;
+    if (rCtx->curShard) {
+      rCtx->curShard->total = MRReply_Integer(MRReply_ArrayElement(arr, 0));
+      rCtx->curShard->nrows = (len - 1) / step;
+    }
     for (int j = 1; j < len; j += step) {
       if (j + step > len) {
         RedisModule_Log(
@@ -1112,6 +1233,7 @@ static void proccessKNNSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisMo
       double d;
       GET_NUMERIC_SCORE(d, res, MRReply_String(MRReply_ArrayElement(arr, j + scoreOffset), NULL));
       proccessKNNSearchResult(res, rCtx, d, &reduceSpecialCaseCtxKnn->knn);
+      knnShardResult(res, rCtx, d);
     }
   }
   return;
@@ -1123,14 +1245,37 @@ error:
   rCtx->cachedResult = res;
 }
 
-static void processSerchReplyResult(searchResult *res, searchReducerCtx *rCtx, RedisModuleCtx *ctx) {
+// Do the results have the same sort key, or score if there is no SORTBY, leaving them to be
+// ordered by their IDs
+static bool results_tied(const searchResult *r1, const searchResult *r2,
+                         const searchRequestCtx *req) {
+  if (!req->withSortby) {
+    return r1->score == r2->score;
+  }
+  if (!r1->sortKey || !r2->sortKey) {
+    return !r1->sortKey && !r2->sortKey;
+  }
+  if (r1->sortKeyNum != HUGE_VAL && r2->sortKeyNum != HUGE_VAL) {
+    return r1->sortKeyNum == r2->sortKeyNum;
+  }
+  return !cmpStrings(r1->sortKey, r1->sortKeyLen, r2->sortKey, r2->sortKeyLen);
+}
+
+/**
+ * Merge a result of a shard into the top results. Returns false once the rest of the results of
+ * the shard cannot make the cut, so that they are not parsed at all: each shard replies with its
+ * results in the order of the merge, and a result which falls below the smallest of a full heap
+ * by its sort key or score (rather than by its ID, which the shards do not order ties by) is
+ * followed by worse results only
+ */
+static bool processSerchReplyResult(searchResult *res, searchReducerCtx *rCtx, RedisModuleCtx *ctx) {
   if (!res || !res->id) {
     RedisModule_Log(ctx, "warning", "got an unexpected argument when parsing redisearch results");
     rCtx->errorOccured = true;
     // invalid result - usually means something is off with the response, and we should just
     // quit this response
     rCtx->cachedResult = res;
-    return;
+    return false;
   }
 
   rCtx->cachedResult = NULL;
@@ -1150,13 +1295,28 @@ static void processSerchReplyResult(searchResult *res, searchReducerCtx *rCtx, R
       rCtx->cachedResult = smallest;
     } else {
       rCtx->cachedResult = res;
-      if (rCtx->searchCtx->withSortby) {
-        // If the result is lower than the last result in the heap,
-        // AND there is a user-defined sort order - we can stop now
-        return;
-      }
+      // If the result is lower than the last result in the heap by more than its ID,
+      // we can stop now
+      return c == 0 || results_tied(res, smallest, rCtx->searchCtx);
+    }
+  }
+  return true;
+}
+
+// Merge a result of a shard, keeping track of the last one merged if the shards are asked for
+// part of the results first
+static bool processShardResult(searchResult *res, searchReducerCtx *rCtx, RedisModuleCtx *ctx) {
+  searchShardReply *shard = rCtx->curShard;
+  if (!processSerchReplyResult(res, rCtx, ctx)) {
+    if (shard) {
+      shard->pruned = true;
     }
+    return false;
+  }
+  if (shard) {
+    shard->last = *res;
   }
+  return true;
 }
 
 static void processSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisModuleCtx *ctx) {
@@ -1191,11 +1351,18 @@ static void processSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisModule
     }
     size_t len = MRReply_Length(results);
 
+    if (rCtx->curShard) {
+      rCtx->curShard->total = MRReply_Integer(total_results);
+      rCtx->curShard->nrows = len;
+    }
+
     bool needScore = rCtx->offsets.score > 0;
     for (int i = 0; i < len; ++i) {
       searchResult *res = newResult_resp3(rCtx->cachedResult, results, i, &rCtx->offsets, rCtx->searchCtx->withExplainScores, rCtx->reduceSpecialCaseCtxSortby);
-      processSerchReplyResult(res, rCtx, ctx);
-    }    
+      if (!processShardResult(res, rCtx, ctx)) {
+        break;
+      }
+    }
     processResultFormat(&rCtx->searchCtx->format, arr);
   }
   else // RESP2
@@ -1208,6 +1375,11 @@ static void processSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisModule
     // fprintf(stderr, "Step %d, scoreOffset %d, fieldsOffset %d, sortKeyOffset %d\n", step,
     //         scoreOffset, fieldsOffset, sortKeyOffset);
 
+    if (rCtx->curShard) {
+      rCtx->curShard->total = MRReply_Integer(MRReply_ArrayElement(arr, 0));
+      rCtx->curShard->nrows = (len - 1) / step;
+    }
+
     for (int j = 1; j < len; j += step) {
       if (j + step > len) {
         RedisModule_Log(ctx, "warning",
@@ -1216,7 +1388,9 @@ static void processSearchReply(MRReply *arr, searchReducerCtx *rCtx, RedisModule
         break;
       }
       searchResult *res = newResult_resp2(rCtx->cachedResult, arr, j, &rCtx->offsets , rCtx->searchCtx->withExplainScores);
-      processSerchReplyResult(res, rCtx, ctx);
+      if (!processShardResult(res, rCtx, ctx)) {
+        break;
+      }
     }
   }
 }
@@ -1471,90 +1645,294 @@ static void profileSearchReply(RedisModule_Reply *reply, searchReducerCtx *rCtx,
   RedisModule_Reply_MapEnd(reply); // root
 }
 
-static void searchResultReducer_wrapper(void *mc_v) {
-  struct MRCtx *mc = mc_v;
-  searchResultReducer(mc, MRCtx_GetNumReplied(mc), MRCtx_GetReplies(mc));
+// Could the results a shard did not reply with make the cut?
+static bool searchShardMayHoldMore(const searchShardReply *shard, const searchResult *smallest,
+                                   const searchReducerCtx *rCtx) {
+  if (!shard->replied || shard->pruned || shard->nrows < rCtx->shardLimit ||
+      shard->total <= shard->nrows) {
+    return false;
+  }
+  if (rCtx->processReply == (processReplyCB)proccessKNNSearchReply) {
+    // The rest of the top K results of the shard are no closer than its last one
+    knnContext *knn = &rCtx->reduceSpecialCaseCtxKnn->knn;
+    return heap_count(knn->pq) < knn->k ||
+           shard->lastDistance <= ((scoredSearchResultWrapper *)heap_peek(knn->pq))->score;
+  }
+  if (!smallest) {
+    // The heap is not full
+    return true;
+  }
+  // The rest of its results follow its last one, which they may tie with but the shards do not
+  // order ties by their IDs as the heap does
+  return cmp_results(&shard->last, smallest, rCtx->searchCtx) <= 0 ||
+         results_tied(&shard->last, smallest, rCtx->searchCtx);
 }
 
-static int searchResultReducer_background(struct MRCtx *mc, int count, MRReply **replies) {
-  ConcurrentSearch_ThreadPoolRun(searchResultReducer_wrapper, mc, DIST_AGG_THREADPOOL);
-  return REDISMODULE_OK;
+// A generator of the commands sent to some of the shards, each targeting its own shard
+typedef struct {
+  MRCommand *cmds;
+  size_t len;
+  size_t next;
+} searchShardCommands;
+
+static size_t searchShardCommands_Len(void *ctx) {
+  return ((searchShardCommands *)ctx)->len;
 }
 
-static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
-  clock_t postProccessTime;
-  RedisModuleBlockedClient *bc = MRCtx_GetBlockedClient(mc);
-  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(bc);
-  searchRequestCtx *req = MRCtx_GetPrivData(mc);
-  searchReducerCtx rCtx = {NULL};
-  int profile = req->profileArgs > 0;
-  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+static int searchShardCommands_Next(void *ctx, MRCommand *cmd) {
+  searchShardCommands *it = ctx;
+  if (it->next == it->len) {
+    return 0;
+  }
+  *cmd = it->cmds[it->next++];
+  return 1;
+}
 
-  int res = REDISMODULE_OK;
-  // got no replies - this means timeout
-  if (count == 0 || req->limit < 0) {
-    res = RedisModule_Reply_Error(reply, "Could not send query to cluster");
-    goto cleanup;
+static void searchShardCommands_Free(void *ctx) {
+  searchShardCommands *it = ctx;
+  while (it->next < it->len) {
+    MRCommand_Free(&it->cmds[it->next++]);
   }
+  rm_free(it->cmds);
+  rm_free(it);
+}
 
-  if (MRReply_Type(*replies) == MR_REPLY_ERROR) {
-    res = MR_ReplyWithMRReply(reply, *replies);
-    goto cleanup;
+static searchShardCommands *searchShardCommands_New(size_t cap) {
+  searchShardCommands *it = rm_malloc(sizeof(*it));
+  *it = (searchShardCommands){.cmds = rm_malloc(MAX(cap, 1) * sizeof(MRCommand))};
+  return it;
+}
+
+// Add a copy of `cmd` sent to the shard of `slot`
+static MRCommand *searchShardCommands_Add(searchShardCommands *it, const MRCommand *cmd, int slot) {
+  MRCommand *shardCmd = &it->cmds[it->len++];
+  *shardCmd = MRCommand_Copy(cmd);
+  shardCmd->targetSlot = slot;
+  return shardCmd;
+}
+
+// Map the commands to their shards, the generator being freed
+static void searchShardCommands_Map(searchShardCommands *it, struct MRCtx *mc) {
+  MRCommandGenerator cg = {.ctx = it,
+                           .Len = searchShardCommands_Len,
+                           .Next = searchShardCommands_Next,
+                           .Free = searchShardCommands_Free};
+  MR_Map(mc, NULL, cg, false);
+  cg.Free(cg.ctx);
+}
+
+/**
+ * When each shard was asked for its top `shardLimit` results only, ask the shards which may hold
+ * more of the top results for the rest of them, up to the number of requested results. A shard
+ * which replied with all its results, or whose last result falls below the smallest of the full
+ * heap, holds no more of them, so that the top results are the same as if every shard were asked
+ * for all of them. Returns true if any shard was asked, the reducer being called again once they
+ * reply
+ */
+static bool searchRefill(struct MRCtx *mc) {
+  searchRequestCtx *req = MRCtx_GetPrivData(mc);
+  searchReducerCtx *rCtx = req->reducer;
+  if (!rCtx || !rCtx->shards || rCtx->refilling || rCtx->errorOccured || rCtx->approximate) {
+    return false;
+  }
+  rCtx->refilling = true;
+
+  searchResult *smallest = heap_count(rCtx->pq) == heap_size(rCtx->pq) ? heap_peek(rCtx->pq) : NULL;
+  char offset[32], limit[32];
+  snprintf(offset, sizeof(offset), "%zu", rCtx->shardLimit);
+  snprintf(limit, sizeof(limit), "%lld", req->requestedResultsCount - (long long)rCtx->shardLimit);
+
+  searchShardCommands *it = searchShardCommands_New(rCtx->numShards);
+  MRCommand *cmds = MRCtx_GetCmds(mc);
+  for (size_t i = 0; i < rCtx->numShards; ++i) {
+    if (!searchShardMayHoldMore(&rCtx->shards[i], smallest, rCtx)) {
+      continue;
+    }
+    MRCommand *cmd = searchShardCommands_Add(it, &cmds[i], cmds[i].targetSlot);
+    MRCommand_ReplaceArg(cmd, rCtx->limitArg + 1, offset, strlen(offset));
+    MRCommand_ReplaceArg(cmd, rCtx->limitArg + 2, limit, strlen(limit));
+  }
+  if (it->len == 0) {
+    searchShardCommands_Free(it);
+    return false;
+  }
+
+  // we need to call request complete here manualy since we did not unblocked the client, before
+  // the context may be freed by the next round
+  MR_requestCompleted(mc);
+  req->refillTime = hires_clock_since_msec(&req->startClock);
+  searchShardCommands_Map(it, mc);
+  return true;
+}
+
+static void searchResultReducer_wrapper(void *mc_v) {
+  struct MRCtx *mc = mc_v;
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_COORD);
+  if (!searchRefill(mc)) {
+    searchResultReducer(mc, MRCtx_GetNumReplied(mc), MRCtx_GetReplies(mc));
   }
+  AllocStats_SetTag(prevTag);
+}
+
+static int searchResultReducer_background(struct MRCtx *mc, int count, MRReply **replies) {
+  ConcurrentSearch_ThreadPoolRun(searchResultReducer_wrapper, mc, DIST_AGG_THREADPOOL);
+  return REDISMODULE_OK;
+}
 
-  rCtx.searchCtx = req;
+static void searchReducerCtx_Init(searchReducerCtx *rCtx, searchRequestCtx *req) {
+  *rCtx = (searchReducerCtx){NULL};
+  rCtx->searchCtx = req;
 
   // Get reply offsets
-  getReplyOffsets(rCtx.searchCtx, &rCtx.offsets);
+  getReplyOffsets(rCtx->searchCtx, &rCtx->offsets);
 
   // Init results heap.
   size_t num = req->requestedResultsCount;
-  rCtx.pq = rm_malloc(heap_sizeof(num));
-  heap_init(rCtx.pq, cmp_results, req, num);
+  rCtx->pq = rm_malloc(heap_sizeof(num));
+  heap_init(rCtx->pq, cmp_results, req, num);
 
   // Default result process and post process operations
-  rCtx.processReply = (processReplyCB) processSearchReply;
-  rCtx.postProcess = (postProcessReplyCB) noOpPostProcess;
+  rCtx->processReply = (processReplyCB) processSearchReply;
+  rCtx->postProcess = (postProcessReplyCB) noOpPostProcess;
 
   if (req->specialCases) {
     size_t nSpecialCases = array_len(req->specialCases);
     for (size_t i = 0; i < nSpecialCases; ++i) {
       if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_KNN) {
         specialCaseCtx* knnCtx = req->specialCases[i];
-        rCtx.postProcess = (postProcessReplyCB) knnPostProcess;
-        rCtx.reduceSpecialCaseCtxKnn = knnCtx;
+        rCtx->postProcess = (postProcessReplyCB) knnPostProcess;
+        rCtx->reduceSpecialCaseCtxKnn = knnCtx;
         if (knnCtx->knn.shouldSort) {
           knnCtx->knn.pq = rm_malloc(heap_sizeof(knnCtx->knn.k));
           heap_init(knnCtx->knn.pq, cmp_scored_results, NULL, knnCtx->knn.k);
-          rCtx.processReply = (processReplyCB) proccessKNNSearchReply;
+          rCtx->processReply = (processReplyCB) proccessKNNSearchReply;
           break;
         }
       } else if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_SORTBY) {
-        rCtx.reduceSpecialCaseCtxSortby = req->specialCases[i];
+        rCtx->reduceSpecialCaseCtxSortby = req->specialCases[i];
       }
-    } 
+    }
   }
+}
 
-  for (int i = 0; i < count; ++i) {
-    MRReply *mr_reply;
-    if (reply->resp3) {
-      mr_reply = replies[i];
-    } else {
-      mr_reply = !profile ? replies[i] : MRReply_ArrayElement(replies[i], 0);
-    }
-    rCtx.processReply(mr_reply, (struct searchReducerCtx *)&rCtx, ctx);
+static void searchReducerCtx_Clear(searchReducerCtx *rCtx) {
+  if (rCtx->cachedResult) {
+    rm_free(rCtx->cachedResult);
+    rCtx->cachedResult = NULL;
+  }
+  if (rCtx->pq) {
+    heap_destroy(rCtx->pq);
+    rCtx->pq = NULL;
+  }
+  if (rCtx->reduceSpecialCaseCtxKnn &&
+      rCtx->reduceSpecialCaseCtxKnn->knn.pq) {
+    heap_destroy(rCtx->reduceSpecialCaseCtxKnn->knn.pq);
+    rCtx->reduceSpecialCaseCtxKnn->knn.pq = NULL;
+  }
+  if (rCtx->shards) {
+    rm_free(rCtx->shards);
+    rCtx->shards = NULL;
+  }
+}
+
+// The results part of a shard reply - the profile replies of RESP2 hold them in their first element
+// In RESP2, the results of a profiled or traced search are the first element of the reply, unless
+// the shard replied with an error
+static MRReply *searchReplyResults(const searchRequestCtx *req, MRReply *r, bool resp3) {
+  if (resp3 || (req->profileArgs == 0 && !req->trace) || !r || MRReply_Type(r) != MR_REPLY_ARRAY) {
+    return r;
+  }
+  return MRReply_ArrayElement(r, 0);
+}
+
+/**
+ * Merge a shard reply into the top results as soon as it arrives, on the IO thread, rather than
+ * once all the shards replied: the replies of the faster shards are merged while the slower ones
+ * are still searching, and the reducer is left with the reply of the last shard only.
+ */
+static void searchResultReducer_mergeReply(struct MRCtx *mc, MRReply *r, int cmdIdx) {
+  searchRequestCtx *req = MRCtx_GetPrivData(mc);
+  searchReducerCtx *rCtx = req->reducer;
+  size_t totalReplies = rCtx->totalReplies;
+  if (rCtx->shards && !rCtx->refilling && cmdIdx >= 0 && cmdIdx < rCtx->numShards) {
+    rCtx->curShard = &rCtx->shards[cmdIdx];
+    rCtx->curShard->replied = true;
+  }
+  rCtx->processReply(searchReplyResults(req, r, MRCtx_GetProtocol(mc) == 3),
+                     (struct searchReducerCtx *)rCtx, NULL);
+  rCtx->curShard = NULL;
+  // The shards asked for the rest of their results count all of them again
+  if (rCtx->refilling) {
+    rCtx->totalReplies = totalReplies;
+  }
+  req->lastReplyTime = hires_clock_since_msec(&req->startClock);
+  if (req->trace) {
+    DistTrace_AddReply(req->trace, r, MRCtx_GetProtocol(mc) == 3,
+                       rCtx->refilling ? req->refillTime : req->dispatchTime, req->lastReplyTime,
+                       rCtx->refilling);
+  }
+}
+
+// Record the fanout phases of a search to the latency stats of the module
+static void searchRecordLatency(searchRequestCtx *req, hires_clock_t *mergeClock) {
+  double merge = hires_clock_since_msec(mergeClock);
+  double total = hires_clock_since_msec(&req->startClock);
+  // without the merge hook, the last reply is only known to have arrived by the merge
+  double lastReply = req->lastReplyTime ? req->lastReplyTime : total - merge;
+  LatencyStats_Record(NULL, LATENCY_CMD_COORD_SEARCH, LATENCY_PHASE_DISPATCH, req->dispatchTime);
+  LatencyStats_Record(NULL, LATENCY_CMD_COORD_SEARCH, LATENCY_PHASE_SLOWEST_SHARD,
+                      lastReply - req->dispatchTime);
+  LatencyStats_Record(NULL, LATENCY_CMD_COORD_SEARCH, LATENCY_PHASE_MERGE, merge);
+  LatencyStats_Record(NULL, LATENCY_CMD_COORD_SEARCH, LATENCY_PHASE_TOTAL, total);
+  if (req->trace) {
+    searchReducerCtx *rCtx = req->reducer;
+    DistTrace_Log(req->trace, req->dispatchTime, lastReply, merge, total,
+                  rCtx ? rCtx->totalReplies : 0);
+  }
+}
+
+static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
+  clock_t postProccessTime;
+  hires_clock_t mergeClock;
+  hires_clock_get(&mergeClock);
+  RedisModuleBlockedClient *bc = MRCtx_GetBlockedClient(mc);
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(bc);
+  searchRequestCtx *req = MRCtx_GetPrivData(mc);
+  // The replies were merged as they arrived, if the request was sent with the merge hook
+  searchReducerCtx _rCtx = {NULL}, *rCtx = req->reducer ? req->reducer : &_rCtx;
+  int profile = req->profileArgs > 0;
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+
+  if (req->cacheKey) {
+    RedisModule_Reply_Record(reply);
+  }
+
+  int res = REDISMODULE_OK;
+  // got no replies - this means timeout
+  if (count == 0 || req->limit < 0) {
+    res = RedisModule_Reply_Error(reply, "Could not send query to cluster");
+    goto cleanup;
+  }
+
+  if (MRReply_Type(*replies) == MR_REPLY_ERROR) {
+    res = MR_ReplyWithMRReply(reply, *replies);
+    goto cleanup;
   }
 
-  if (rCtx.cachedResult) {
-    rm_free(rCtx.cachedResult);
+  if (!req->reducer) {
+    searchReducerCtx_Init(rCtx, req);
+    for (int i = 0; i < count; ++i) {
+      MRReply *mr_reply = searchReplyResults(req, replies[i], reply->resp3);
+      rCtx->processReply(mr_reply, (struct searchReducerCtx *)rCtx, ctx);
+    }
   }
 
   // If we didn't get any results and we got an error - return it.
   // If some shards returned results and some errors - we prefer to show the results we got an not
   // return an error. This might change in the future
-  if ((rCtx.totalReplies == 0 && rCtx.lastError != NULL) || rCtx.errorOccured) {
-    if (rCtx.lastError) {
-      MR_ReplyWithMRReply(reply, rCtx.lastError);
+  if ((rCtx->totalReplies == 0 && rCtx->lastError != NULL) || rCtx->errorOccured) {
+    if (rCtx->lastError) {
+      MR_ReplyWithMRReply(reply, rCtx->lastError);
     } else {
       RedisModule_Reply_Error(reply, "could not parse redisearch results");
     }
@@ -1563,29 +1941,36 @@ static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
 
   if (!profile) {
     RedisModule_Reply_Map(reply);
-      sendSearchResults(reply, &rCtx);
+      sendSearchResults(reply, rCtx);
     RedisModule_Reply_MapEnd(reply);
+    searchRecordLatency(req, &mergeClock);
   } else {
     postProccessTime = clock();
-    profileSearchReply(reply, &rCtx, count, replies, req->profileClock, postProccessTime);
+    profileSearchReply(reply, rCtx, count, replies, req->profileClock, postProccessTime);
   }
 
 cleanup:
+  if (req->cacheKey) {
+    // a recording is dropped on an error, nor are the results of part of the shards cached
+    arrayof(char) recording = RedisModule_Reply_TakeRecording(reply);
+    if (recording && MRCtx_GetNumErrored(mc) == 0 && !rCtx->lastError && !rCtx->errorOccured) {
+      DistResultCache_Put(req->cacheKey, recording);
+    } else {
+      array_free(recording);
+    }
+  }
   RedisModule_EndReply(reply);
 
-  if (rCtx.pq) {
-    heap_destroy(rCtx.pq);
-  }
-  if (rCtx.reduceSpecialCaseCtxKnn &&
-      rCtx.reduceSpecialCaseCtxKnn->knn.pq) {
-    heap_destroy(rCtx.reduceSpecialCaseCtxKnn->knn.pq);
+  searchReducerCtx_Clear(rCtx);
+  if (req->reducer) {
+    rm_free(req->reducer);
   }
 
   searchRequestCtx_Free(req);
   RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeEnd, bc);
   RedisModule_UnblockClient(bc, mc);
   RedisModule_FreeThreadSafeContext(ctx);
-  MR_requestCompleted();
+  MR_requestCompleted(mc);
   MRCtx_Free(mc);
   return res;
 }
@@ -1677,6 +2062,137 @@ int SingleShardCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int
   return REDISMODULE_OK;
 }
 
+/* FT.MGET is sent to every shard with its own keys only, and the replies of the shards are put
+ * back in the order of the keys */
+typedef struct {
+  int numKeys;
+  int *keyCmd;        // the command of every key
+  int *keyPos;        // the position of every key in the reply to its command
+  MRReply **replies;  // the reply to every command, NULL until it replies
+} mgetCtx;
+
+static void mgetCtx_Free(mgetCtx *mctx) {
+  rm_free(mctx->keyCmd);
+  rm_free(mctx->keyPos);
+  rm_free(mctx->replies);
+  rm_free(mctx);
+}
+
+static void mgetReplyHook(struct MRCtx *mc, MRReply *reply, int cmdIdx) {
+  mgetCtx *mctx = MRCtx_GetPrivData(mc);
+  mctx->replies[cmdIdx] = reply;
+}
+
+static int mgetReducer(struct MRCtx *mc, int count, MRReply **replies) {
+  mgetCtx *mctx = MRCtx_GetPrivData(mc);
+  RedisModuleCtx *ctx = MRCtx_GetRedisCtx(mc);
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+
+  for (int i = 0; i < count; ++i) {
+    if (MRReply_Type(replies[i]) == MR_REPLY_ERROR) {
+      // we got an error reply, something goes wrong so we return the error to the user.
+      MR_ReplyWithMRReply(reply, replies[i]);
+      goto done;
+    }
+  }
+  if (count == 0) {
+    RedisModule_Reply_Error(reply, "Could not process replies");
+    goto done;
+  }
+
+  RedisModule_Reply_Array(reply);
+  for (int i = 0; i < mctx->numKeys; ++i) {
+    MRReply *shardReply = mctx->replies[mctx->keyCmd[i]];
+    if (shardReply && MRReply_Type(shardReply) == MR_REPLY_ARRAY &&
+        mctx->keyPos[i] < MRReply_Length(shardReply)) {
+      MR_ReplyWithMRReply(reply, MRReply_ArrayElement(shardReply, mctx->keyPos[i]));
+    } else {
+      RedisModule_Reply_Null(reply);
+    }
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+
+done:
+  RedisModule_EndReply(reply);
+  mgetCtx_Free(mctx);
+  return REDISMODULE_OK;
+}
+
+// The index of the shard of the topology serving `slot`, or -1
+static int topologyShardForSlot(const MRClusterTopology *topo, int slot) {
+  for (size_t i = 0; i < topo->numShards; ++i) {
+    if (topo->shards[i].startSlot <= slot && slot <= topo->shards[i].endSlot) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Send every shard one FT.MGET of its keys. Returns false if a key has no known shard
+static bool mgetByShard(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  SearchCluster *sc = GetSearchCluster();
+  MRClusterTopology *topo = MR_GetCurrentTopology();
+  if (!topo || !topo->numShards) {
+    return false;
+  }
+
+  int numKeys = argc - 2;
+  int *keyShard = rm_malloc(numKeys * sizeof(*keyShard));
+  for (int i = 0; i < numKeys; ++i) {
+    size_t len;
+    const char *key = RedisModule_StringPtrLen(argv[i + 2], &len);
+    int slot = SearchCluster_SlotForKey(sc, key, len);
+    keyShard[i] = slot < 0 ? -1 : topologyShardForSlot(topo, slot);
+    if (keyShard[i] < 0) {
+      rm_free(keyShard);
+      return false;
+    }
+  }
+
+  mgetCtx *mctx = rm_malloc(sizeof(*mctx));
+  mctx->numKeys = numKeys;
+  mctx->keyCmd = rm_malloc(numKeys * sizeof(*mctx->keyCmd));
+  mctx->keyPos = rm_malloc(numKeys * sizeof(*mctx->keyPos));
+
+  MRCommand cmd = MR_NewCommandFromRedisStrings(2, argv);
+  MRCommand_SetProtocol(&cmd, ctx);
+  /* Replace our own FT command with _FT. command */
+  MRCommand_SetPrefix(&cmd, "_FT");
+
+  // the command of every shard of the topology, -1 for the shards holding none of the keys
+  int *shardCmd = rm_malloc(topo->numShards * sizeof(*shardCmd));
+  for (size_t i = 0; i < topo->numShards; ++i) {
+    shardCmd[i] = -1;
+  }
+  searchShardCommands *it = searchShardCommands_New(MIN(numKeys, topo->numShards));
+  for (int i = 0; i < numKeys; ++i) {
+    int s = keyShard[i];
+    if (shardCmd[s] < 0) {
+      shardCmd[s] = it->len;
+      searchShardCommands_Add(it, &cmd, topo->shards[s].startSlot);
+    }
+    MRCommand *shardCmdPtr = &it->cmds[shardCmd[s]];
+    mctx->keyCmd[i] = shardCmd[s];
+    mctx->keyPos[i] = shardCmdPtr->num - 2;
+    MRCommand_AppendRstr(shardCmdPtr, argv[i + 2]);
+  }
+  mctx->replies = rm_calloc(it->len, sizeof(*mctx->replies));
+  MRCommand_Free(&cmd);
+  rm_free(shardCmd);
+  rm_free(keyShard);
+
+  struct MRCtx *mrctx = MR_CreateCtx(ctx, 0, mctx);
+  MR_SetCoordinationStrategy(mrctx, MRCluster_MastersOnly | MRCluster_FlatCoordination);
+  MRCtx_SetReplyHook(mrctx, mgetReplyHook);
+  MRCommandGenerator cg = {.ctx = it,
+                           .Len = searchShardCommands_Len,
+                           .Next = searchShardCommands_Next,
+                           .Free = searchShardCommands_Free};
+  MR_Map(mrctx, mgetReducer, cg, true);
+  cg.Free(cg.ctx);
+  return true;
+}
+
 /* FT.MGET {idx} {key} ... */
 int MGetCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
@@ -1689,6 +2205,11 @@ int MGetCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
   }
   RS_AutoMemory(ctx);
 
+  if (mgetByShard(ctx, argv, argc)) {
+    return REDISMODULE_OK;
+  }
+
+  // the shards of the keys are not known, every shard is asked for all of them
   MRCommand cmd = MR_NewCommandFromRedisStrings(argc, argv);
   MRCommand_SetProtocol(&cmd, ctx);
   /* Replace our own FT command with _FT. command */
@@ -1784,8 +2305,167 @@ int FanoutCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
   return REDISMODULE_OK;
 }
 
+/**
+ * A query given SLOT {tag} only matches the documents whose keys carry the hash tag {tag}, which
+ * are all in the shard owning the slot of the tag. The query is sent to that shard alone, without
+ * the SLOT argument, and the reply of the shard is returned as is.
+ * Returns 0 if the query has no SLOT argument and should be distributed to every shard.
+ */
+static int SingleSlotCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  int slotIndex = RMUtil_ArgExists("SLOT", argv, argc, 3);
+  if (!slotIndex) {
+    return 0;
+  }
+  if (slotIndex == argc - 1) {
+    RedisModule_ReplyWithError(ctx, "SLOT requires a hash tag");
+    return 1;
+  }
+  if (RMUtil_ArgExists("WITHCURSOR", argv, argc, 3)) {
+    // The cursor would only be known to the shard
+    RedisModule_ReplyWithError(ctx, "SLOT is not supported with WITHCURSOR");
+    return 1;
+  }
+
+  size_t len;
+  const char *tag = RedisModule_StringPtrLen(argv[slotIndex + 1], &len);
+  RedisModuleString **shardArgv = rm_malloc(sizeof(*shardArgv) * (argc - 2));
+  memcpy(shardArgv, argv, sizeof(*shardArgv) * slotIndex);
+  memcpy(shardArgv + slotIndex, argv + slotIndex + 2, sizeof(*shardArgv) * (argc - slotIndex - 2));
+  MRCommand cmd = MR_NewCommandFromRedisStrings(argc - 2, shardArgv);
+  rm_free(shardArgv);
+  MRCommand_SetProtocol(&cmd, ctx);
+  /* Replace our own FT command with _FT. command */
+  MRCommand_SetPrefix(&cmd, "_FT");
+  cmd.targetSlot = SearchCluster_SlotForTag(GetSearchCluster(), tag, len);
+
+  struct MRCtx *mrctx = MR_CreateCtx(ctx, 0, NULL);
+  MR_SetCoordinationStrategy(mrctx, MRCluster_FlatCoordination | MRCluster_MastersOnly);
+  MR_MapSingle(mrctx, singleReplyReducer, cmd);
+  return 1;
+}
+
 void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                          struct ConcurrentCmdCtx *cmdCtx);
+void RSExecDistAggregateCached(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                               const DistResultCacheKey *ck);
+int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol, RedisModuleString **argv,
+                             int argc, DistResultCacheKey *cacheKey);
+
+/******************************* Coordinator result cache ***************************/
+
+typedef enum { DIST_CACHED_AGGREGATE, DIST_CACHED_SEARCH } distCachedQueryType;
+
+// A query of an index with a result cache, blocked while the shards are asked for the revision of
+// the index
+typedef struct {
+  RedisModuleBlockedClient *bc;
+  int protocol;
+  distCachedQueryType type;
+  RedisModuleString **argv;
+  int argc;
+  DistResultCacheKey *cacheKey;
+  arrayof(char) cachedReply;  // The reply to replay, if it was cached
+} distCachedQuery;
+
+static void distCachedQuery_Free(distCachedQuery *q) {
+  for (int i = 0; i < q->argc; ++i) {
+    RedisModule_FreeString(NULL, q->argv[i]);
+  }
+  rm_free(q->argv);
+  if (q->cacheKey) {
+    DistResultCacheKey_Free(q->cacheKey);
+  }
+  array_free(q->cachedReply);
+  rm_free(q);
+}
+
+static void distCachedQuery_Run(void *p) {
+  distCachedQuery *q = p;
+  RedisModuleBlockedClient *bc = q->bc;
+  if (q->type == DIST_CACHED_SEARCH && !q->cachedReply) {
+    // The search request owns the key from here on, and unblocks the client once reduced
+    FlatSearchCommandHandler(bc, q->protocol, q->argv, q->argc, q->cacheKey);
+    q->cacheKey = NULL;
+  } else {
+    RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(bc);
+    if (q->cachedReply) {
+      RedisModule_Reply_Replay(ctx, q->cachedReply, array_len(q->cachedReply));
+    } else {
+      RSExecDistAggregateCached(ctx, q->argv, q->argc, q->cacheKey);
+    }
+    RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeEnd, bc);
+    RedisModule_UnblockClient(bc, NULL);
+    RedisModule_FreeThreadSafeContext(ctx);
+  }
+  distCachedQuery_Free(q);
+}
+
+static int distCachedQuery_Probed(struct MRCtx *mc, int count, MRReply **replies) {
+  distCachedQuery *q = MRCtx_GetPrivData(mc);
+  DistResultCacheKey *ck = q->cacheKey;
+  ck->generation = DistResultCache_Generation(ck->index, replies, count, MRCtx_GetCmdsSize(mc));
+  q->cachedReply = DistResultCache_Get(ck);
+  MR_requestCompleted(mc);
+  MRCtx_Free(mc);
+  // A cached reply is replayed off the IO thread as well
+  ConcurrentSearch_ThreadPoolRun(distCachedQuery_Run, q, DIST_AGG_THREADPOOL);
+  return REDISMODULE_OK;
+}
+
+/**
+ * Start a query of an index with a result cache (see Index_ResultCache). The shards are first asked
+ * for the revision of the index, and the query replies with the reply cached for the state of the
+ * index over the cluster, or runs and caches its reply. Returns false if the query is not cached.
+ */
+static bool distCachedQuery_Start(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                  distCachedQueryType type) {
+  if (RSGlobalConfig.resultCacheTTL == 0 || RMUtil_StringEqualsCaseC(argv[0], "FT.PROFILE") ||
+      RMUtil_ArgExists("WITHCURSOR", argv, argc, 3)) {
+    return false;
+  }
+  const char *indexname = RedisModule_StringPtrLen(argv[1], NULL);
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = indexname},
+      .flags = INDEXSPEC_LOAD_NOCOUNTER | INDEXSPEC_LOAD_NOTIMERUPDATE | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  IndexSpec *sp = StrongRef_Get(IndexSpec_LoadUnsafeEx(ctx, &loadOpts));
+  if (!sp || !(sp->flags & Index_ResultCache)) {
+    return false;
+  }
+
+  // The arguments of the query, following the index name
+  int protocol = is_resp3(ctx) ? 3 : 2;
+  DistResultCacheKey *ck = rm_calloc(1, sizeof(*ck));
+  ck->index = rm_strdup(indexname);
+  ck->key = ResultCache_NewKey(type, protocol);
+  for (int i = 2; i < argc; ++i) {
+    size_t len;
+    const char *arg = RedisModule_StringPtrLen(argv[i], &len);
+    ck->key = ResultCache_AppendKeyArg(ck->key, arg, len);
+  }
+
+  distCachedQuery *q = rm_calloc(1, sizeof(*q));
+  q->bc = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
+  q->protocol = protocol;
+  q->type = type;
+  q->argv = rm_malloc(sizeof(*q->argv) * argc);
+  for (int i = 0; i < argc; ++i) {
+    // The arguments outlive the command
+    q->argv[i] = RedisModule_CreateStringFromString(ctx, argv[i]);
+  }
+  q->argc = argc;
+  q->cacheKey = ck;
+  RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeStart, q->bc);
+
+  MRCommand cmd = MR_NewCommand(2, "_FT._REVISION", indexname);
+  struct MRCtx *mrctx = MR_CreateCtx(ctx, NULL, q);
+  MR_SetCoordinationStrategy(mrctx, MRCluster_MastersOnly | MRCluster_FlatCoordination);
+  MRCtx_SetReduceFunction(mrctx, distCachedQuery_Probed);
+  MRCommandGenerator cg = SearchCluster_MultiplexCommand(GetSearchCluster(), &cmd);
+  MR_Map(mrctx, NULL, cg, false);
+  cg.Free(cg.ctx);
+  return true;
+}
 
 static int DistAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (argc < 3) {
@@ -1794,12 +2474,23 @@ static int DistAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, i
   if (!SearchCluster_Ready(GetSearchCluster())) {
     return RedisModule_ReplyWithError(ctx, CLUSTERDOWN_ERR);
   }
+  if (MR_Overloaded()) {
+    return RedisModule_ReplyWithError(ctx, OVERLOADED_ERR);
+  }
+  if (SingleSlotCommandHandler(ctx, argv, argc)) {
+    return REDISMODULE_OK;
+  }
+  if (distCachedQuery_Start(ctx, argv, argc, DIST_CACHED_AGGREGATE)) {
+    return REDISMODULE_OK;
+  }
   return ConcurrentSearch_HandleRedisCommandEx(DIST_AGG_THREADPOOL, CMDCTX_NO_GIL,
                                                RSExecDistAggregate, ctx, argv, argc);
 }
 
 static void CursorCommandInternal(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, struct ConcurrentCmdCtx *cmdCtx) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_COORD);
   RSCursorCommand(ctx, argv, argc);
+  AllocStats_SetTag(prevTag);
 }
 
 static int CursorCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
@@ -1817,19 +2508,45 @@ int TagValsCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
   if (argc < 3) {
     return RedisModule_WrongArity(ctx);
   }
+  TagValsOptions *opts = rm_calloc(1, sizeof(*opts));
+  QueryError status = {0};
+  ArgsCursor ac;
+  ArgsCursor_InitRString(&ac, argv + 3, argc - 3);
+  if (TagValsOptions_Parse(&ac, opts, &status) != REDISMODULE_OK) {
+    rm_free(opts);
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
   // Check that the cluster state is valid
   if (!SearchCluster_Ready(GetSearchCluster())) {
+    rm_free(opts);
     return RedisModule_ReplyWithError(ctx, CLUSTERDOWN_ERR);
   }
   RS_AutoMemory(ctx);
 
-  MRCommand cmd = MR_NewCommandFromRedisStrings(argc, argv);
+  MRCommand cmd = MR_NewCommandFromRedisStrings(3, argv);
   MRCommand_SetProtocol(&cmd, ctx);
   /* Replace our own FT command with _FT. command */
   MRCommand_SetPrefix(&cmd, "_FT");
+  if (opts->prefix) {
+    MRCommand_AppendArgs(&cmd, 1, "PREFIX");
+    MRCommand_Append(&cmd, opts->prefix, opts->prefixLen);
+  }
+  if (opts->after) {
+    MRCommand_AppendArgs(&cmd, 1, "AFTER");
+    MRCommand_Append(&cmd, opts->after, opts->afterLen);
+  }
+  if (opts->limit) {
+    // each shard may hold all the values of the page, and those before it
+    char buf[32];
+    sprintf(buf, "%zu", opts->offset + opts->limit);
+    MRCommand_AppendArgs(&cmd, 3, "LIMIT", "0", buf);
+  }
+  if (opts->withCounts) {
+    MRCommand_AppendArgs(&cmd, 1, "WITHCOUNTS");
+  }
 
   MRCommandGenerator cg = SearchCluster_MultiplexCommand(GetSearchCluster(), &cmd);
-  MR_Map(MR_CreateCtx(ctx, 0, NULL), uniqueStringsReducer, cg, true);
+  MR_Map(MR_CreateCtx(ctx, 0, opts), tagValsReducer, cg, true);
   cg.Free(cg.ctx);
   return REDISMODULE_OK;
 }
@@ -1861,20 +2578,30 @@ int BroadcastCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 }
 
 int InfoCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-  if (argc != 2) {
-    // FT.INFO {index}
+  if (argc != 2 && argc != 3) {
+    // FT.INFO {index} [SUMMARY]
     return RedisModule_WrongArity(ctx);
   }
+  bool summary = argc == 3;
+  if (summary && strcasecmp(RedisModule_StringPtrLen(argv[2], NULL), "SUMMARY")) {
+    return RedisModule_ReplyWithError(ctx, "Unknown argument, expected SUMMARY");
+  }
   // Check that the cluster state is valid
   if (!SearchCluster_Ready(GetSearchCluster())) {
     return RedisModule_ReplyWithError(ctx, CLUSTERDOWN_ERR);
   }
+  InfoRequest *req = InfoRequest_New(RedisModule_StringPtrLen(argv[1], NULL), summary,
+                                     is_resp3(ctx));
+  if (clusterConfig.infoCacheTTL && InfoRequest_ReplyCached(ctx, req)) {
+    InfoRequest_Free(req);
+    return REDISMODULE_OK;
+  }
   RS_AutoMemory(ctx);
   MRCommand cmd = MR_NewCommandFromRedisStrings(argc, argv);
   MRCommand_SetProtocol(&cmd, ctx);
   MRCommand_SetPrefix(&cmd, "_FT");
 
-  struct MRCtx *mctx = MR_CreateCtx(ctx, 0, NULL);
+  struct MRCtx *mctx = MR_CreateCtx(ctx, 0, req);
   MRCommandGenerator cg = SearchCluster_MultiplexCommand(GetSearchCluster(), &cmd);
   MR_SetCoordinationStrategy(mctx, MRCluster_FlatCoordination);
   MR_Map(mctx, InfoReplyReducer, cg, true);
@@ -1930,6 +2657,7 @@ int LocalSearchCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int
   // we also ask only masters to serve the request, to avoid duplications by random
   MR_SetCoordinationStrategy(mrctx, MRCluster_LocalCoordination | MRCluster_MastersOnly);
 
+  req->dispatchTime = hires_clock_since_msec(&req->startClock);
   MR_Map(mrctx, searchResultReducer, cg, true);
   cg.Free(cg.ctx);
   return REDISMODULE_OK;
@@ -1986,11 +2714,48 @@ void sendRequiredFields(searchRequestCtx *req, MRCommand *cmd) {
   }
 }
 
-int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol, RedisModuleString **argv, int argc) {
+// The KNN special case of the request, if it has one
+static const specialCaseCtx *searchKnnCase(const searchRequestCtx *req) {
+  for (size_t i = 0; req->specialCases && i < array_len(req->specialCases); ++i) {
+    if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_KNN) {
+      return req->specialCases[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * The number of results each shard is asked for first, when the shards are asked for their share of
+ * the requested results first and for the rest of them later (see searchRefill), or 0 to ask every
+ * shard for all of them at once
+ */
+static size_t searchShardLimit(const searchRequestCtx *req) {
+  double factor = clusterConfig.searchShardLimitFactor;
+  const specialCaseCtx *knnCtx = searchKnnCase(req);
+  if (knnCtx) {
+    // The shards reply with the top K results by their distance, unless sorted by another field
+    if (knnCtx->knn.shouldSort && req->withSortby) {
+      return 0;
+    }
+    factor = clusterConfig.knnShardLimitFactor;
+  }
+  size_t numShards = GetSearchCluster()->size;
+  if (factor <= 0 || numShards < 2 || req->profileArgs > 0 || req->limit <= 0) {
+    return 0;
+  }
+  size_t shardLimit = ceil(req->requestedResultsCount * factor / numShards);
+  return shardLimit < req->requestedResultsCount ? MAX(shardLimit, 1) : 0;
+}
+
+int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol, RedisModuleString **argv,
+                             int argc, DistResultCacheKey *cacheKey) {
   QueryError status = {0};
   searchRequestCtx *req = rscParseRequest(argv, argc, &status);
 
   if (!req) {
+    if (cacheKey) {
+      DistResultCacheKey_Free(cacheKey);
+    }
     RedisModuleCtx* clientCtx = RedisModule_GetThreadSafeContext(bc);
     RedisModule_ReplyWithError(clientCtx, QueryError_GetError(&status));
     QueryError_ClearError(&status);
@@ -1999,18 +2764,26 @@ int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol, RedisMo
     RedisModule_FreeThreadSafeContext(clientCtx);
     return REDISMODULE_OK;
   }
+  req->cacheKey = cacheKey;
 
   MRCommand cmd = MR_NewCommandFromRedisStrings(argc, argv);
   cmd.protocol = protocol;
 
-  // replace the LIMIT {offset} {limit} with LIMIT 0 {limit}, because we need all top N to merge
+  // replace the LIMIT {offset} {limit} with LIMIT 0 {limit}, because we need all top N to merge,
+  // or with LIMIT 0 {shard limit} if the shards are asked for part of them first
+  size_t shardLimit = searchShardLimit(req);
   int limitIndex = RMUtil_ArgExists("LIMIT", argv, argc, 3);
   if (limitIndex && req->limit > 0 && limitIndex < argc - 2) {
     size_t k =0;
     MRCommand_ReplaceArg(&cmd, limitIndex + 1, "0", 1);
     char buf[32];
-    snprintf(buf, sizeof(buf), "%lld", req->requestedResultsCount);
+    snprintf(buf, sizeof(buf), "%lld", shardLimit ? (long long)shardLimit : req->requestedResultsCount);
     MRCommand_ReplaceArg(&cmd, limitIndex + 2, buf, strlen(buf));
+  } else if (shardLimit) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%zu", shardLimit);
+    limitIndex = cmd.num;
+    MRCommand_AppendArgs(&cmd, 3, "LIMIT", "0", buf);
   }
 
   /* Replace our own FT command with _FT. command */
@@ -2023,21 +2796,63 @@ int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol, RedisMo
   // adding the WITHSCORES option only if there is no SORTBY (hence the score is the default sort key)
   if (!req->withSortby) {
     MRCommand_AppendArgsAtPos(&cmd, 3 + req->profileArgs, 1, "WITHSCORES");
+    // which moves the LIMIT after it
+    limitIndex++;
   }
 
   if(req->specialCases) {
     sendRequiredFields(req, &cmd);
   }
 
+  // The shards order the top K results of a KNN query by their score, ask them to order them by
+  // their distance for the coordinator to tell which shards may hold more of them
+  const specialCaseCtx *knnCtx = searchKnnCase(req);
+  if (shardLimit && knnCtx && knnCtx->knn.shouldSort) {
+    MRCommand_AppendArgs(&cmd, 2, "SORTBY", knnCtx->knn.fieldName);
+  }
+
+  // The shards of a sampled search reply with their times as well
+  if (req->profileArgs == 0) {
+    req->trace = DistTrace_Sample(RedisModule_StringPtrLen(argv[1], NULL), req->queryString,
+                                  req->dialect);
+    if (req->trace) {
+      MRCommand_AppendArgs(&cmd, 2, "_TRACE", req->trace->id);
+    }
+  }
+
   struct MRCtx *mrctx = MR_CreateCtx(0, bc, req);
   MRCtx_SetProtocol(mrctx, protocol);
 
   // we prefer the next level to be local - we will only approach nodes on our own shard
-  // we also ask only masters to serve the request, to avoid duplications by random
-  MR_SetCoordinationStrategy(mrctx, MRCluster_FlatCoordination | MRCluster_MastersOnly);
+  // we also ask only masters to serve the request, to avoid duplications by random, while a master
+  // which is late to reply may be backed by a replica
+  MR_SetCoordinationStrategy(mrctx, MRCluster_FlatCoordination | MRCluster_MastersOnly |
+                                    MRCluster_Hedged);
+
+  searchReducerCtx *rCtx = rm_malloc(sizeof(*rCtx));
+  searchReducerCtx_Init(rCtx, req);
+  req->reducer = rCtx;
+  MRCtx_SetReplyHook(mrctx, searchResultReducer_mergeReply);
 
   MRCtx_SetReduceFunction(mrctx, searchResultReducer_background);
-  MR_Fanout(mrctx, NULL, cmd, false);
+  if (shardLimit) {
+    // Each shard is sent its own command, to tell which shard a reply comes from
+    rCtx->shardLimit = shardLimit;
+    rCtx->approximate = knnCtx && clusterConfig.knnShardLimitApproximate;
+    rCtx->numShards = GetSearchCluster()->size;
+    rCtx->shards = rm_calloc(rCtx->numShards, sizeof(*rCtx->shards));
+    rCtx->limitArg = limitIndex;
+    searchShardCommands *it = searchShardCommands_New(rCtx->numShards);
+    for (size_t i = 0; i < rCtx->numShards; ++i) {
+      searchShardCommands_Add(it, &cmd, GetSearchCluster()->shardsStartSlots[i]);
+    }
+    MRCommand_Free(&cmd);
+    req->dispatchTime = hires_clock_since_msec(&req->startClock);
+    searchShardCommands_Map(it, mrctx);
+  } else {
+    req->dispatchTime = hires_clock_since_msec(&req->startClock);
+    MR_Fanout(mrctx, NULL, cmd, false);
+  }
   return REDISMODULE_OK;
 }
 
@@ -2050,12 +2865,14 @@ typedef struct SearchCmdCtx {
 
 static void DistSearchCommandHandler(void* pd) {
   SearchCmdCtx* sCmdCtx = pd;
-  FlatSearchCommandHandler(sCmdCtx->bc, sCmdCtx->protocol, sCmdCtx->argv, sCmdCtx->argc);
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_COORD);
+  FlatSearchCommandHandler(sCmdCtx->bc, sCmdCtx->protocol, sCmdCtx->argv, sCmdCtx->argc, NULL);
   for (size_t i = 0 ; i < sCmdCtx->argc ; ++i) {
     RedisModule_FreeString(NULL, sCmdCtx->argv[i]);
   }
   rm_free(sCmdCtx->argv);
   rm_free(sCmdCtx);
+  AllocStats_SetTag(prevTag);
 }
 
 static int DistSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
@@ -2067,6 +2884,19 @@ static int DistSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
   if (!SearchCluster_Ready(GetSearchCluster())) {
     return RedisModule_ReplyWithError(ctx, CLUSTERDOWN_ERR);
   }
+  if (MR_Overloaded()) {
+    return RedisModule_ReplyWithError(ctx, OVERLOADED_ERR);
+  }
+  // The replies of the shards to the queries of every vector are not merged
+  if (RMUtil_ArgExists("MULTIVECTOR", argv, argc, 3)) {
+    return RedisModule_ReplyWithError(ctx, "MULTIVECTOR is not supported in cluster mode");
+  }
+  if (SingleSlotCommandHandler(ctx, argv, argc)) {
+    return REDISMODULE_OK;
+  }
+  if (distCachedQuery_Start(ctx, argv, argc, DIST_CACHED_SEARCH)) {
+    return REDISMODULE_OK;
+  }
   RedisModuleBlockedClient* bc = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
   SearchCmdCtx* sCmdCtx = rm_malloc(sizeof(*sCmdCtx));
   sCmdCtx->argv = rm_malloc(sizeof(RedisModuleString*) * argc);
@@ -2083,6 +2913,42 @@ static int DistSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
   return REDISMODULE_OK;
 }
 
+/* The prepared queries are kept by the coordinator which prepared them, and their executions are
+ * distributed as FT.SEARCH */
+static int PrepareCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 4) {
+    return RedisModule_WrongArity(ctx);
+  }
+  QueryError status = {0};
+  if (PreparedQuery_Add(ctx, argv, argc, &status) != REDISMODULE_OK) {
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+static int ExecuteCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  QueryError status = {0};
+  int nargs = 0;
+  RedisModuleString **args = PreparedQuery_Bind(argv, argc, &nargs, &status);
+  if (!args) {
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+  int rc = DistSearchCommand(ctx, args, nargs);
+  rm_free(args);
+  return rc;
+}
+
+static int DeallocateCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  return RedisModule_ReplyWithLongLong(
+      ctx, PreparedQuery_Del(RedisModule_StringPtrLen(argv[1], NULL)));
+}
+
 int ProfileCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (argc < 5) {
     return RedisModule_WrongArity(ctx);
@@ -2091,6 +2957,9 @@ int ProfileCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
   if (RMUtil_ArgExists("WITHCURSOR", argv, argc, 3)) {
     return RedisModule_ReplyWithError(ctx, "FT.PROFILE does not support cursor");
   }
+  if (RMUtil_ArgExists("SLOT", argv, argc, 3)) {
+    return RedisModule_ReplyWithError(ctx, "FT.PROFILE does not support SLOT");
+  }
 
   const char *typeStr = RedisModule_StringPtrLen(argv[2], NULL);
   if (RMUtil_ArgExists("SEARCH", argv, 3, 2)) {
@@ -2165,6 +3034,13 @@ int ClusterInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
             node->flags & MRNode_Master ? "master " : "slave ", node->flags & MRNode_Self ? "self" : "");
           RedisModule_ReplyKV_String(reply, "role", role);
 
+          MRConnStats stats;
+          if (MR_GetNodeStats(node->id, &stats)) {
+            RedisModule_ReplyKV_LongLong(reply, "inflight", stats.inflight);
+            RedisModule_ReplyKV_LongLong(reply, "queued", stats.queued);
+            RedisModule_ReplyKV_Double(reply, "latency_ms", stats.latency);
+          }
+
           RedisModule_Reply_MapEnd(reply); // >>>>(node)
         }
         RedisModule_Reply_ArrayEnd(reply); // >>>nodes
@@ -2217,6 +3093,12 @@ int ClusterInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
           RedisModule_Reply_Stringf(reply, "%s%s",
                                     node->flags & MRNode_Master ? "master " : "slave ",
                                     node->flags & MRNode_Self ? "self" : "");
+          MRConnStats stats;
+          if (MR_GetNodeStats(node->id, &stats)) {
+            RedisModule_ReplyKV_LongLong(reply, "inflight", stats.inflight);
+            RedisModule_ReplyKV_LongLong(reply, "queued", stats.queued);
+            RedisModule_ReplyKV_Double(reply, "latency_ms", stats.latency);
+          }
         RedisModule_Reply_ArrayEnd(reply); // >>node
       }
 
@@ -2263,10 +3145,12 @@ int SetClusterCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     case MRHashFunc_CRC12:
       PartitionCtx_SetSlotTable(&GetSearchCluster()->part, crc12_slot_table,
                                 MIN(4096, topo->numSlots));
+      GetSearchCluster()->hashFunc = topo->hashFunc;
       break;
     case MRHashFunc_CRC16:
       PartitionCtx_SetSlotTable(&GetSearchCluster()->part, crc16_slot_table,
                                 MIN(16384, topo->numSlots));
+      GetSearchCluster()->hashFunc = topo->hashFunc;
       break;
     case MRHashFunc_None:
     default:
@@ -2286,6 +3170,169 @@ int SetClusterCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
+/* Cluster term statistics
+ *
+ * Every TERM_STATS_INTERVAL milliseconds, the coordinator asks the shards of every index for their
+ * number of documents, their total length and the number of documents of the terms their queries
+ * look up the most (see FT._TERMSTATS), and pushes the sums to the shards (see FT._SETTERMSTATS),
+ * so that every shard scores with the same BM25 inputs. The statistics are valid on the shards
+ * for a few intervals only, so that the shards score with their own statistics again when the
+ * coordinator stops refreshing them. */
+
+/* The timer period while the statistics are not refreshed, to notice TERM_STATS_INTERVAL is set */
+#define TERM_STATS_IDLE_INTERVAL 1000
+/* The statistics pushed to the shards are valid for this many intervals */
+#define TERM_STATS_TTL_INTERVALS 3
+/* A term no shard looked up for this many intervals is not asked for anymore */
+#define TERM_STATS_KEEP_INTERVALS 10
+
+// index name => TrieMap of its terms, mapping a term to the round it was last looked up at
+static TrieMap *termStatsIndexes_g = NULL;
+static pthread_mutex_t termStatsLock_g = PTHREAD_MUTEX_INITIALIZER;
+static uintptr_t termStatsRound_g = 0;
+
+static void termStatsIndexFree(void *p) {
+  TrieMap_Free(p, NULL);
+}
+
+static int termStatsPushReducer(struct MRCtx *mc, int count, MRReply **replies) {
+  rm_free(MRCtx_GetPrivData(mc));
+  MR_requestCompleted(mc);
+  MRCtx_Free(mc);
+  return REDISMODULE_OK;
+}
+
+/* Sum the statistics of the shards and push them back, recording the terms they looked up */
+static int termStatsReducer(struct MRCtx *mc, int count, MRReply **replies) {
+  const char *name = MRCtx_GetPrivData(mc);
+  const MRCommand *cmd = &MRCtx_GetCmds(mc)[0];
+  size_t numTerms = cmd->num - 2;
+  bool complete = count > 0 && count == MRCtx_GetCmdsSize(mc);
+  long long numDocs = 0, totalDocsLen = 0;
+  long long *termDocs = rm_calloc(MAX(numTerms, 1), sizeof(*termDocs));
+  arrayof(MRReply *) hotTerms = array_new(MRReply *, count);
+
+  // The statistics are pushed only if every shard replied, as the sums would be off otherwise
+  for (int i = 0; i < count && complete; ++i) {
+    MRReply *r = replies[i];
+    if (MRReply_Type(r) != MR_REPLY_ARRAY || MRReply_Length(r) != 4 ||
+        MRReply_Length(MRReply_ArrayElement(r, 2)) != numTerms) {
+      complete = false;
+      break;
+    }
+    numDocs += MRReply_Integer(MRReply_ArrayElement(r, 0));
+    totalDocsLen += MRReply_Integer(MRReply_ArrayElement(r, 1));
+    for (size_t j = 0; j < numTerms; ++j) {
+      termDocs[j] += MRReply_Integer(MRReply_ArrayElement(MRReply_ArrayElement(r, 2), j));
+    }
+    array_append(hotTerms, MRReply_ArrayElement(r, 3));
+  }
+
+  if (!complete) {
+    rm_free(termDocs);
+    array_free(hotTerms);
+    return termStatsPushReducer(mc, count, replies);
+  }
+
+  pthread_mutex_lock(&termStatsLock_g);
+  TrieMap *terms = TrieMap_Find(termStatsIndexes_g, (char *)name, strlen(name));
+  if (terms == TRIEMAP_NOTFOUND) {
+    terms = NewTrieMap();
+    TrieMap_Add(termStatsIndexes_g, (char *)name, strlen(name), terms, NULL);
+  }
+  for (size_t i = 0; i < array_len(hotTerms); ++i) {
+    for (size_t j = 0; j < MRReply_Length(hotTerms[i]); ++j) {
+      size_t len;
+      const char *term = MRReply_String(MRReply_ArrayElement(hotTerms[i], j), &len);
+      if (term && (terms->cardinality < CLUSTER_STATS_MAX_HOT_TERMS ||
+                   TrieMap_Find(terms, term, len) != TRIEMAP_NOTFOUND)) {
+        TrieMap_Add(terms, (char *)term, len, (void *)termStatsRound_g, NULL);
+      }
+    }
+  }
+  size_t interval = clusterConfig.termStatsInterval;
+  pthread_mutex_unlock(&termStatsLock_g);
+  array_free(hotTerms);
+
+  char buf[32];
+  MRCommand push = MR_NewCommand(2, "_FT._SETTERMSTATS", name);
+  MRCommand_Append(&push, buf, sprintf(buf, "%zu", MAX(interval, 1) * TERM_STATS_TTL_INTERVALS));
+  MRCommand_Append(&push, buf, sprintf(buf, "%lld", numDocs));
+  MRCommand_Append(&push, buf, sprintf(buf, "%lld", totalDocsLen));
+  for (size_t j = 0; j < numTerms; ++j) {
+    MRCommand_Append(&push, cmd->strs[j + 2], cmd->lens[j + 2]);
+    MRCommand_Append(&push, buf, sprintf(buf, "%lld", termDocs[j]));
+  }
+  rm_free(termDocs);
+
+  // we need to call request complete here manualy since we did not unblocked the client, before
+  // the context may be freed by the next round
+  MR_requestCompleted(mc);
+  MRCtx_SetReduceFunction(mc, termStatsPushReducer);
+  MRCommandGenerator cg = SearchCluster_MultiplexCommand(GetSearchCluster(), &push);
+  MR_Map(mc, NULL, cg, false);
+  cg.Free(cg.ctx);
+  return REDISMODULE_OK;
+}
+
+/* Ask the shards of an index for their statistics, along with the number of documents of the
+ * terms they recently looked up */
+static void refreshTermStats(const char *name, size_t len) {
+  MRCommand cmd = MR_NewCommand(1, "_FT._TERMSTATS");
+  MRCommand_Append(&cmd, name, len);
+
+  pthread_mutex_lock(&termStatsLock_g);
+  TrieMap *terms = TrieMap_Find(termStatsIndexes_g, (char *)name, len);
+  if (terms != TRIEMAP_NOTFOUND) {
+    arrayof(char *) stale = array_new(char *, 0);
+    TrieMapIterator *it = TrieMap_Iterate(terms, "", 0);
+    char *term;
+    tm_len_t termLen;
+    void *lastRound;
+    while (TrieMapIterator_Next(it, &term, &termLen, &lastRound)) {
+      if (termStatsRound_g - (uintptr_t)lastRound > TERM_STATS_KEEP_INTERVALS) {
+        array_append(stale, rm_strndup(term, termLen));
+      } else {
+        MRCommand_Append(&cmd, term, termLen);
+      }
+    }
+    TrieMapIterator_Free(it);
+    for (size_t i = 0; i < array_len(stale); ++i) {
+      TrieMap_Delete(terms, stale[i], strlen(stale[i]), NULL);
+    }
+    array_free_ex(stale, rm_free(*(char **)ptr));
+  }
+  pthread_mutex_unlock(&termStatsLock_g);
+
+  struct MRCtx *mrctx = MR_CreateCtx(RSDummyContext, NULL, rm_strndup(name, len));
+  MR_SetCoordinationStrategy(mrctx, MRCluster_MastersOnly | MRCluster_FlatCoordination);
+  MRCtx_SetReduceFunction(mrctx, termStatsReducer);
+  MRCommandGenerator cg = SearchCluster_MultiplexCommand(GetSearchCluster(), &cmd);
+  MR_Map(mrctx, NULL, cg, false);
+  cg.Free(cg.ctx);
+}
+
+static void termStatsTimerCallback(RedisModuleCtx *ctx, void *data) {
+  size_t interval = clusterConfig.termStatsInterval;
+  if (interval && SearchCluster_Ready(GetSearchCluster()) && !MR_Overloaded()) {
+    pthread_mutex_lock(&termStatsLock_g);
+    termStatsRound_g++;
+    pthread_mutex_unlock(&termStatsLock_g);
+
+    dictIterator *iter = dictGetIterator(specDict_g);
+    dictEntry *entry = NULL;
+    while ((entry = dictNext(iter))) {
+      IndexSpec *sp = StrongRef_Get(dictGetRef(entry));
+      MRKey key = {0};
+      MRKey_Parse(&key, sp->name, sp->nameLen);
+      refreshTermStats(key.base, key.baseLen);
+    }
+    dictReleaseIterator(iter);
+  }
+  RedisModule_CreateTimer(RSDummyContext, interval ? interval : TERM_STATS_IDLE_INTERVAL,
+                          termStatsTimerCallback, NULL);
+}
+
 /* Perform basic configurations and init all threads and global structures */
 int initSearchCluster(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   clusterConfig.type = DetectClusterType();
@@ -2301,12 +3348,14 @@ int initSearchCluster(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   const char **slotTable = NULL;
   size_t tableSize = 0;
+  MRHashFunc hashFunc;
 
   switch (clusterConfig.type) {
     case ClusterType_RedisLabs:
       sf = CRC12ShardFunc;
       slotTable = crc12_slot_table;
       tableSize = 4096;
+      hashFunc = MRHashFunc_CRC12;
 
       break;
     case ClusterType_RedisOSS:
@@ -2319,6 +3368,7 @@ int initSearchCluster(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       sf = CRC16ShardFunc;
       slotTable = crc16_slot_table;
       tableSize = 16384;
+      hashFunc = MRHashFunc_CRC16;
   }
 
   size_t num_connections_per_shard;
@@ -2334,8 +3384,12 @@ int initSearchCluster(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   }
 
   MRCluster *cl = MR_NewCluster(initialTopology, num_connections_per_shard, sf, 2);
-  MR_Init(cl, clusterConfig.timeoutMS);
+  MR_Init(cl, clusterConfig.timeoutMS, clusterConfig.ioThreadCpuList, clusterConfig.numIOThreads);
   InitGlobalSearchCluster(clusterConfig.numPartitions, slotTable, tableSize);
+  GetSearchCluster()->hashFunc = hashFunc;
+
+  termStatsIndexes_g = NewTrieMap();
+  RedisModule_CreateTimer(RSDummyContext, TERM_STATS_IDLE_INTERVAL, termStatsTimerCallback, NULL);
 
   return REDISMODULE_OK;
 }
@@ -2407,6 +3461,7 @@ void setHiredisAllocators(){
 void Coordinator_CleanupModule(void) {
   MR_Destroy();
   GlobalSearchCluster_Release();
+  InfoCache_Free();
 }
 
 void Coordinator_ShutdownEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data) {
@@ -2477,6 +3532,8 @@ RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   // Init the aggregation thread pool
   DIST_AGG_THREADPOOL = ConcurrentSearch_CreatePool(RSGlobalConfig.searchPoolSize);
 
+  LocalShard_Init();
+
   Initialize_CoordKeyspaceNotifications(ctx);
 
   // suggestion commands
@@ -2504,12 +3561,17 @@ RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.FSEARCH", SafeCmd(DistSearchCommand), "readonly", 0, 0, -1));
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.SEARCH", SafeCmd(DistSearchCommand), "readonly", 0, 0, -1));
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.PROFILE", SafeCmd(ProfileCommandHandler), "readonly", 0, 0, -1));
+  RM_TRY(RedisModule_CreateCommand(ctx, "FT.PREPARE", SafeCmd(PrepareCommandHandler), "readonly", 0, 0, -1));
+  RM_TRY(RedisModule_CreateCommand(ctx, "FT.EXECUTE", SafeCmd(ExecuteCommandHandler), "readonly", 0, 0, -1));
+  RM_TRY(RedisModule_CreateCommand(ctx, "FT.DEALLOCATE", SafeCmd(DeallocateCommandHandler), "readonly", 0, 0, -1));
   if (clusterConfig.type == ClusterType_RedisLabs) {
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.CURSOR", SafeCmd(CursorCommand), "readonly", 3, 1, -3));
   } else {
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.CURSOR", SafeCmd(CursorCommand), "readonly", 0, 0, -1));
   }
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.SYNDUMP", SafeCmd(FirstShardCommandHandler), "readonly", 0, 0, -1));
+  RM_TRY(RedisModule_CreateCommand(ctx, "FT.SYNC", SafeCmd(MastersFanoutCommandHandler), "readonly", 0, 0, -1));
+  RM_TRY(RedisModule_CreateCommand(ctx, "FT.WARMUP", SafeCmd(MastersFanoutCommandHandler), "readonly", 0, 0, -1));
   RM_TRY(RedisModule_CreateCommand(ctx, "FT._LIST", SafeCmd(FirstShardCommandHandler), "readonly",0, 0, -1));
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.DICTDUMP", SafeCmd(FirstShardCommandHandler), "readonly", 0, 0, -1));
   RM_TRY(RedisModule_CreateCommand(ctx, "FT.SPELLCHECK", SafeCmd(SpellCheckCommandHandler), "readonly", 0, 0, -1));
@@ -2527,6 +3589,7 @@ RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RM_TRY(RedisModule_CreateCommand(ctx, "FT._DROPIFX", SafeCmd(MastersFanoutCommandHandler), "readonly",0, 0, -1));
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.DROPINDEX", SafeCmd(MastersFanoutCommandHandler), "readonly",0, 0, -1));
     RM_TRY(RedisModule_CreateCommand(ctx, "FT._DROPINDEXIFX", SafeCmd(MastersFanoutCommandHandler), "readonly",0, 0, -1));
+    RM_TRY(RedisModule_CreateCommand(ctx, "FT.REPLACEINDEX", SafeCmd(MastersFanoutCommandHandler), "readonly",0, 0, -1));
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.DELETE", SafeCmd(MastersFanoutCommandHandler), "readonly",0, 0, -1));
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.BROADCAST", SafeCmd(BroadcastCommand), "readonly", 0, 0, -1));
     RM_TRY(RedisModule_CreateCommand(ctx, "FT.DICTADD", SafeCmd(MastersFanoutCommandHandler), "readonly", 0, 0, -1));
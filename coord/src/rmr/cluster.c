@@ -10,8 +10,12 @@
 #include "crc16.h"
 #include "crc12.h"
 #include "rmutil/vector.h"
+#include "reply.h"
+#include "../config.h"
 
 #include <stdlib.h>
+#include <math.h>
+#include <sys/param.h>
 
 void _MRClsuter_UpdateNodes(MRCluster *cl) {
   if (cl->topo) {
@@ -76,6 +80,7 @@ MRCluster *MR_NewCluster(MRClusterTopology *initialTopology, size_t conn_pool_si
   cl->topo = initialTopology;
   cl->nodeMap = NULL;
   cl->myNode = NULL;  // tODO: discover local ip/port
+  cl->q = NULL;
   MRConnManager_Init(&cl->mgr, conn_pool_size);
 
   if (cl->topo) {
@@ -99,7 +104,7 @@ MRClusterShard *_MRCluster_FindShard(MRCluster *cl, uint slot) {
 MRClusterNode *_MRClusterShard_SelectNode(MRClusterShard *sh, MRClusterNode *myNode,
                                           MRCoordinationStrategy strategy) {
 
-  switch (strategy & ~MRCluster_MastersOnly) {
+  switch (strategy & ~(MRCluster_MastersOnly | MRCluster_Hedged)) {
 
     case MRCluster_LocalCoordination:
       for (int i = 0; i < sh->numNodes; i++) {
@@ -145,6 +150,166 @@ MRClusterNode *_MRClusterShard_SelectNode(MRClusterShard *sh, MRClusterNode *myN
   return NULL;
 }
 
+/* The minimal time in milliseconds before a request is hedged */
+#define MR_HEDGE_MIN_DELAY_MS 1
+/* The number of hedged requests which may be sent in a burst */
+#define MR_HEDGE_MAX_TOKENS 10
+
+/* The number of hedged requests which may be sent, accrued by HEDGE_BUDGET percent of every
+ * hedgeable request. Each IO thread has a bucket of its own, for the requests it sends */
+static __thread double hedgeTokens_tl = 0;
+
+/* A request to a node of a shard, which is sent to another node of the shard as well if the first
+ * one is late to reply. The first reply of either is handed to the callback */
+typedef struct {
+  MRCluster *cl;
+  mr_slot_t slot;
+  char *nodeId;  // the node the request was sent to first
+  sds cmd;       // the formatted command
+  int protocol;
+  redisCallbackFn *fn;
+  void *privdata;
+  uv_timer_t timer;
+  int pending;
+  int replied;
+} MRHedgedRequest;
+
+static void freeHedgedRequest(uv_handle_t *timer) {
+  MRHedgedRequest *hr = timer->data;
+  sdsfree(hr->cmd);
+  rm_free(hr->nodeId);
+  rm_free(hr);
+}
+
+static void hedgedRequestCallback(redisAsyncContext *c, void *r, void *privdata) {
+  MRHedgedRequest *hr = privdata;
+  hr->pending--;
+
+  // A failure is handed to the callback only if the other node cannot reply either
+  if (!hr->replied && (r || !hr->pending)) {
+    hr->replied = 1;
+    uv_timer_stop(&hr->timer);
+    hr->fn(c, r, hr->privdata);
+  } else if (r) {
+    MRReply_Free(r);
+  }
+
+  if (!hr->pending) {
+    uv_timer_stop(&hr->timer);
+    uv_close((uv_handle_t *)&hr->timer, freeHedgedRequest);
+  }
+}
+
+static void hedgeTimerCallback(uv_timer_t *timer) {
+  MRHedgedRequest *hr = timer->data;
+  if (hr->replied || hedgeTokens_tl < 1 || !hr->cl->topo) {
+    return;
+  }
+  // The topology may have changed since the request was sent
+  MRClusterShard *sh = _MRCluster_FindShard(hr->cl, hr->slot);
+  for (size_t i = 0; sh && i < sh->numNodes; i++) {
+    if (!strcmp(sh->nodes[i].id, hr->nodeId)) {
+      continue;
+    }
+    MRConn *conn = MRConn_Get(&hr->cl->mgr, sh->nodes[i].id);
+    MRCommand cmd = {.cmd = hr->cmd, .protocol = hr->protocol, .targetSlot = -1};
+    if (conn && MRConn_SendCommand(conn, &cmd, hedgedRequestCallback, hr) != REDIS_ERR) {
+      hr->pending++;
+      hedgeTokens_tl--;
+      return;
+    }
+  }
+}
+
+/* Send a command to a node of a shard, hedging it if the strategy asks for it */
+static int _MRCluster_SendToNode(MRCluster *cl, MRCoordinationStrategy strategy,
+                                 MRClusterShard *sh, MRClusterNode *node, MRConn *conn,
+                                 MRCommand *cmd, redisCallbackFn *fn, void *privdata) {
+  double budget = clusterConfig.hedgeBudget;
+  if (!(strategy & MRCluster_Hedged) || budget <= 0 || !fn || !sh || sh->numNodes < 2 ||
+      !(MRCommand_GetFlags(cmd) & MRCommand_Read)) {
+    return MRConn_SendCommand(conn, cmd, fn, privdata);
+  }
+  hedgeTokens_tl = MIN(hedgeTokens_tl + budget / 100, MR_HEDGE_MAX_TOKENS);
+
+  MRHedgedRequest *hr = rm_malloc(sizeof(*hr));
+  *hr = (MRHedgedRequest){
+      .cl = cl,
+      .slot = sh->startSlot,
+      .protocol = cmd->protocol,
+      .fn = fn,
+      .privdata = privdata,
+      .pending = 1,
+  };
+  if (MRConn_SendCommand(conn, cmd, hedgedRequestCallback, hr) == REDIS_ERR) {
+    rm_free(hr);
+    return REDIS_ERR;
+  }
+  hr->cmd = sdsdup(cmd->cmd);
+  hr->nodeId = rm_strdup(node->id);
+  uv_timer_init(cl->mgr.loop, &hr->timer);
+  hr->timer.data = hr;
+  // Until the latency of the connection is known, the request is not hedged
+  double late = MRConn_LateReplyMS(conn);
+  if (late) {
+    uv_timer_start(&hr->timer, hedgeTimerCallback, MAX((uint64_t)ceil(late), MR_HEDGE_MIN_DELAY_MS),
+                   0);
+  }
+  return REDIS_OK;
+}
+
+/* Find the shard of a node, by its id */
+static MRClusterShard *_MRCluster_FindNodeShard(MRCluster *cl, MRClusterNode *n) {
+  for (size_t i = 0; i < cl->topo->numShards; i++) {
+    MRClusterShard *sh = &cl->topo->shards[i];
+    for (size_t j = 0; j < sh->numNodes; j++) {
+      if (!strcmp(sh->nodes[j].id, n->id)) {
+        return sh;
+      }
+    }
+  }
+  return NULL;
+}
+
+static MRLocalExecutor localExecutor_g = NULL;
+
+void MRCluster_SetLocalExecutor(MRLocalExecutor exec) {
+  localExecutor_g = exec;
+}
+
+struct MRLocalRequest {
+  redisCallbackFn *fn;
+  void *privdata;
+  MRWorkQueue *q;
+  MRReply *reply;
+};
+
+static void localRequestCallback(void *p) {
+  MRLocalRequest *req = p;
+  req->fn(NULL, req->reply, req->privdata);
+  rm_free(req);
+}
+
+void MRLocalRequest_Reply(MRLocalRequest *req, MRReply *reply) {
+  req->reply = reply;
+  RQ_Post(req->q, localRequestCallback, req);
+}
+
+/* Run a command to the node of the process in the process, if the local executor takes it */
+static int _MRCluster_ExecLocal(MRCluster *cl, MRClusterNode *node, MRCommand *cmd,
+                                redisCallbackFn *fn, void *privdata) {
+  if (!localExecutor_g || !fn || !cl->q || !(node->flags & MRNode_Self)) {
+    return REDIS_ERR;
+  }
+  MRLocalRequest *req = rm_malloc(sizeof(*req));
+  *req = (MRLocalRequest){.fn = fn, .privdata = privdata, .q = cl->q};
+  if (localExecutor_g(cmd, req) == REDIS_ERR) {
+    rm_free(req);
+    return REDIS_ERR;
+  }
+  return REDIS_OK;
+}
+
 /* Send a single command to the right shard in the cluster, with an optoinal control over node
  * selection */
 int MRCluster_SendCommand(MRCluster *cl, MRCoordinationStrategy strategy, MRCommand *cmd,
@@ -165,10 +330,13 @@ int MRCluster_SendCommand(MRCluster *cl, MRCoordinationStrategy strategy, MRComm
 
   MRClusterNode *node = _MRClusterShard_SelectNode(sh, cl->myNode, strategy);
   if (!node) return REDIS_ERR;
+  if (_MRCluster_ExecLocal(cl, node, cmd, fn, privdata) == REDIS_OK) {
+    return REDIS_OK;
+  }
 
   MRConn *conn = MRConn_Get(&cl->mgr, node->id);
   if (!conn) return REDIS_ERR;
-  return MRConn_SendCommand(conn, cmd, fn, privdata);
+  return _MRCluster_SendToNode(cl, strategy, sh, node, conn, cmd, fn, privdata);
 }
 
 /* Multiplex a command to all coordinators, using a specific coordination strategy. Returns the
@@ -182,7 +350,7 @@ int MRCluster_FanoutCommand(MRCluster *cl, MRCoordinationStrategy strategy, MRCo
   int cmd_proto = cmd->protocol;
 
   MRNodeMapIterator it;
-  switch (strategy & ~(MRCluster_MastersOnly)) {
+  switch (strategy & ~(MRCluster_MastersOnly | MRCluster_Hedged)) {
     case MRCluster_RemoteCoordination:
       it = MRNodeMap_IterateRandomNodePerhost(cl->nodeMap, cl->myNode);
       break;
@@ -199,6 +367,10 @@ int MRCluster_FanoutCommand(MRCluster *cl, MRCoordinationStrategy strategy, MRCo
     if ((strategy & MRCluster_MastersOnly) && !(n->flags & MRNode_Master)) {
       continue;
     }
+    if (_MRCluster_ExecLocal(cl, n, cmd, fn, privdata) == REDIS_OK) {
+      ret++;
+      continue;
+    }
     MRConn *conn = MRConn_Get(&cl->mgr, n->id);
     // printf("Sending fanout command to %s:%d\n", conn->ep.host, conn->ep.port);
     if (conn) {
@@ -210,7 +382,9 @@ int MRCluster_FanoutCommand(MRCluster *cl, MRCoordinationStrategy strategy, MRCo
         conn->protocol = cmd_proto;
       }
 
-      if (MRConn_SendCommand(conn, cmd, fn, privdata) != REDIS_ERR) {
+      MRClusterShard *sh =
+          (strategy & MRCluster_Hedged) && cl->topo ? _MRCluster_FindNodeShard(cl, n) : NULL;
+      if (_MRCluster_SendToNode(cl, strategy, sh, n, conn, cmd, fn, privdata) != REDIS_ERR) {
         ret++;
       }
     }
@@ -309,6 +483,22 @@ void MRClusterTopology_Free(MRClusterTopology *t) {
   rm_free(t);
 }
 
+MRClusterTopology *MRClusterTopology_Clone(const MRClusterTopology *t) {
+  MRClusterTopology *topo = MR_NewTopology(t->numShards, t->numSlots);
+  topo->hashFunc = t->hashFunc;
+  for (size_t s = 0; s < t->numShards; s++) {
+    const MRClusterShard *src = &t->shards[s];
+    MRClusterShard sh = MR_NewClusterShard(src->startSlot, src->endSlot, src->numNodes);
+    for (size_t n = 0; n < src->numNodes; n++) {
+      MRClusterNode node = {.id = rm_strdup(src->nodes[n].id), .flags = src->nodes[n].flags};
+      MREndpoint_Copy(&node.endpoint, &src->nodes[n].endpoint);
+      MRClusterShard_AddNode(&sh, &node);
+    }
+    MRClusterTopology_AddShard(topo, &sh);
+  }
+  return topo;
+}
+
 int MRClusterTopology_IsValid(MRClusterTopology *t) {
   if (!t || t->numShards <= 0 || t->numSlots <= 0) {
     return 0;
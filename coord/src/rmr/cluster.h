@@ -14,6 +14,8 @@
 #include "endpoint.h"
 #include "command.h"
 #include "node.h"
+#include "reply.h"
+#include "rq.h"
 
 typedef uint16_t mr_slot_t;
 
@@ -58,6 +60,9 @@ void MRClusterTopology_AddShard(MRClusterTopology *topo, MRClusterShard *sh);
 
 void MRClusterTopology_Free(MRClusterTopology *t);
 
+/* Deep copy a topology, for a cluster of another IO thread */
+MRClusterTopology *MRClusterTopology_Clone(const MRClusterTopology *t);
+
 void MRClusterNode_Free(MRClusterNode *n);
 
 /* Check the validity of the topology. A topology is considered valid if we have shards, and the
@@ -88,8 +93,28 @@ typedef struct {
   time_t lastTopologyUpdate;
   // the minimum allowed interval between topology updates
   long long topologyUpdateMinInterval;
+
+  /* The queue of the IO thread the cluster belongs to, on whose loop the replies of the commands
+   * run in the process are handed back */
+  MRWorkQueue *q;
 } MRCluster;
 
+/* A command to the node of the process, run in the process rather than sent to it (see
+ * MRCluster_SetLocalExecutor) */
+typedef struct MRLocalRequest MRLocalRequest;
+
+/* Run a command to the node of the process in the process, sparing the round trip over a connection
+ * to itself. Called on the IO thread, it returns REDIS_ERR for the command to be sent over the
+ * connection instead. Otherwise the command runs on any other thread, which completes the request
+ * with MRLocalRequest_Reply. The command is not used once the executor returns */
+typedef int (*MRLocalExecutor)(MRCommand *cmd, MRLocalRequest *req);
+
+void MRCluster_SetLocalExecutor(MRLocalExecutor exec);
+
+/* Complete a command run in the process with its reply, or NULL if it failed. The reply is handed
+ * to the callback of the command on the loop of the IO thread which sent it */
+void MRLocalRequest_Reply(MRLocalRequest *req, MRReply *reply);
+
 /* Define the coordination strategy of a coordination command */
 typedef enum {
   /* Send the coordination command to all nodes */
@@ -102,6 +127,11 @@ typedef enum {
    * NOTE: This is a flag that should be added to the strategy along with one of the above */
   MRCluster_MastersOnly = 0x08,
 
+  /* If this is set, a read command sent to a node which is late to reply is sent to another node of
+   * its shard as well, the first reply being used (see HEDGE_BUDGET).
+   * NOTE: This is a flag that should be added to the strategy along with one of the above */
+  MRCluster_Hedged = 0x10,
+
 } MRCoordinationStrategy;
 
 /* Multiplex a non-sharding command to all coordinators, using a specific coordination strategy. The
@@ -52,6 +52,9 @@ struct mrCommandConf __commandConfig[] = {
     {"_FT.INFO", MRCommand_Read | MRCommand_SingleKey | MRCommand_Aliased, 1, 1, NULL},
     {"_FT.EXPLAIN", MRCommand_Read | MRCommand_SingleKey | MRCommand_Aliased, 1, 1, NULL},
     {"_FT.TAGVALS", MRCommand_Read | MRCommand_SingleKey | MRCommand_Aliased, 1, 1, NULL},
+    {"_FT._TERMSTATS", MRCommand_Read | MRCommand_SingleKey, 1, 1, NULL},
+    {"_FT._SETTERMSTATS", MRCommand_Read | MRCommand_SingleKey, 1, 1, NULL},
+    {"_FT._REVISION", MRCommand_Read | MRCommand_SingleKey | MRCommand_Aliased, 1, 1, NULL},
 
     // Alias commands
     {"_FT.ALIASADD", MRCommand_Write | MRCommand_SingleKey, 2, 2, NULL},
@@ -8,12 +8,15 @@
 #include "reply.h"
 #include "hiredis/adapters/libuv.h"
 #include "search_cluster.h"
+#include "../config.h"
 
 #include <uv.h>
 #include <signal.h>
 #include <sys/param.h>
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
+#include <time.h>
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
@@ -24,7 +27,7 @@ static int MRConn_Connect(MRConn *conn);
 static void MRConn_SwitchState(MRConn *conn, MRConnState nextState);
 static void MRConn_Free(void *ptr);
 static void MRConn_Stop(MRConn *conn);
-static MRConn *MR_NewConn(MREndpoint *ep);
+static MRConn *MR_NewConn(MREndpoint *ep, uv_loop_t *loop);
 static int MRConn_StartNewConnection(MRConn *conn);
 static int MRConn_SendAuth(MRConn *conn);
 
@@ -35,11 +38,40 @@ static int MRConn_SendAuth(MRConn *conn);
   fprintf(stderr, "[%p %s:%d %s]" fmt "\n", conn, conn->ep.host, conn->ep.port, \
           MRConnState_Str((conn)->state), ##__VA_ARGS__)
 
+/* A command sent on a connection, or waiting in its queue for a place in the pipeline */
+typedef struct MRConnRequest {
+  redisCallbackFn *fn;
+  void *privdata;
+  struct timespec sentAt;
+  // The formatted command and its protocol, while it is queued
+  sds cmd;
+  int protocol;
+  struct MRConnRequest *next;
+} MRConnRequest;
+
+/* Fail the commands waiting in the queue of the connection, when it is lost */
+static void MRConn_FailQueued(MRConn *conn) {
+  MRConnRequest *req = conn->queueHead;
+  conn->queueHead = conn->queueTail = NULL;
+  __atomic_store_n(&conn->queued, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&conn->inflight, 0, __ATOMIC_RELAXED);
+  while (req) {
+    MRConnRequest *next = req->next;
+    if (req->fn) {
+      req->fn(NULL, NULL, req->privdata);
+    }
+    sdsfree(req->cmd);
+    rm_free(req);
+    req = next;
+  }
+}
+
 /** detaches from our redis context */
 static redisAsyncContext *detachFromConn(MRConn *conn, int shouldFree) {
   if (!conn->conn) {
     return NULL;
   }
+  MRConn_FailQueued(conn);
 
   redisAsyncContext *ac = conn->conn;
   ac->data = NULL;
@@ -58,7 +90,7 @@ typedef struct {
   MRConn **conns;
 } MRConnPool;
 
-static MRConnPool *_MR_NewConnPool(MREndpoint *ep, size_t num) {
+static MRConnPool *_MR_NewConnPool(MREndpoint *ep, size_t num, uv_loop_t *loop) {
   MRConnPool *pool = rm_malloc(sizeof(*pool));
   *pool = (MRConnPool){
       .num = num,
@@ -68,7 +100,7 @@ static MRConnPool *_MR_NewConnPool(MREndpoint *ep, size_t num) {
 
   /* Create the connection */
   for (size_t i = 0; i < num; i++) {
-    pool->conns[i] = MR_NewConn(ep);
+    pool->conns[i] = MR_NewConn(ep, loop);
   }
   return pool;
 }
@@ -84,19 +116,21 @@ static void MRConnPool_Free(void *p) {
   rm_free(pool);
 }
 
-/* Get a connection from the connection pool. We select the next available connected connection with
- * a roundrobin selector */
+/* Get a connection from the connection pool. We select the least loaded connected connection,
+ * starting from the next one with a roundrobin selector so that idle connections take turns */
 static MRConn *MRConnPool_Get(MRConnPool *pool) {
+  MRConn *best = NULL;
   for (size_t i = 0; i < pool->num; i++) {
 
     MRConn *conn = pool->conns[pool->rr];
     // increase the round-robin counter
     pool->rr = (pool->rr + 1) % pool->num;
-    if (conn->state == MRConn_Connected) {
-      return conn;
+    if (conn->state == MRConn_Connected &&
+        (!best || conn->inflight + conn->queued < best->inflight + best->queued)) {
+      best = conn;
     }
   }
-  return NULL;
+  return best;
 }
 
 /* Init the connection manager */
@@ -104,6 +138,7 @@ void MRConnManager_Init(MRConnManager *mgr, int nodeConns) {
   /* Create the connection map */
   mgr->map = NewTrieMap();
   mgr->nodeConns = nodeConns;
+  mgr->loop = uv_default_loop();
 }
 
 /* Free the entire connection manager */
@@ -122,6 +157,102 @@ MRConn *MRConn_Get(MRConnManager *mgr, const char *id) {
   return NULL;
 }
 
+int MRConnManager_NodeStats(MRConnManager *mgr, const char *id, MRConnStats *stats) {
+  void *ptr = TrieMap_Find(mgr->map, (char *)id, strlen(id));
+  if (ptr == TRIEMAP_NOTFOUND || !ptr) {
+    return 0;
+  }
+  MRConnPool *pool = ptr;
+  *stats = (MRConnStats){0};
+  size_t measured = 0;
+  for (size_t i = 0; i < pool->num; i++) {
+    MRConn *conn = pool->conns[i];
+    stats->inflight += __atomic_load_n(&conn->inflight, __ATOMIC_RELAXED);
+    stats->queued += __atomic_load_n(&conn->queued, __ATOMIC_RELAXED);
+    double latency = conn->latency;
+    if (latency) {
+      stats->latency += latency;
+      measured++;
+    }
+  }
+  if (measured) {
+    stats->latency /= measured;
+  }
+  return 1;
+}
+
+static void MRConn_ReplyCallback(redisAsyncContext *c, void *r, void *privdata);
+
+/* Write a command to the connection, to be sent along with the other commands written in the same
+ * iteration of the event loop */
+static int MRConn_Write(MRConn *c, MRConnRequest *req, sds cmd, int protocol) {
+  if (protocol != 0 && (!c->protocol || c->protocol != protocol)) {
+    int rc = redisAsyncCommand(c->conn, NULL, NULL, "HELLO %d", protocol);
+    c->protocol = protocol;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &req->sentAt);
+  if (redisAsyncFormattedCommand(c->conn, MRConn_ReplyCallback, req, cmd, sdslen(cmd)) ==
+      REDIS_ERR) {
+    return REDIS_ERR;
+  }
+  __atomic_add_fetch(&c->inflight, 1, __ATOMIC_RELAXED);
+  return REDIS_OK;
+}
+
+static double elapsedMS(const struct timespec *since) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000.0 + (now.tv_nsec - since->tv_nsec) / 1000000.0;
+}
+
+/* Send the queued commands which fit in the pipeline of the connection */
+static void MRConn_Drain(MRConn *c) {
+  size_t maxInflight = clusterConfig.connMaxInflight;
+  while (c->queueHead && c->state == MRConn_Connected &&
+         (!maxInflight || c->inflight < maxInflight)) {
+    MRConnRequest *req = c->queueHead;
+    c->queueHead = req->next;
+    if (!c->queueHead) c->queueTail = NULL;
+    __atomic_sub_fetch(&c->queued, 1, __ATOMIC_RELAXED);
+
+    sds cmd = req->cmd;
+    req->cmd = NULL;
+    req->next = NULL;
+    if (MRConn_Write(c, req, cmd, req->protocol) == REDIS_ERR) {
+      if (req->fn) {
+        req->fn(c->conn, NULL, req->privdata);
+      }
+      rm_free(req);
+    }
+    sdsfree(cmd);
+  }
+}
+
+/* The callback of every command sent on a connection, which accounts for the reply before handing
+ * it to the callback of the command */
+static void MRConn_ReplyCallback(redisAsyncContext *c, void *r, void *privdata) {
+  MRConnRequest *req = privdata;
+  // The connection is detached from the context once it is lost
+  MRConn *conn = c ? c->data : NULL;
+  if (conn) {
+    __atomic_sub_fetch(&conn->inflight, 1, __ATOMIC_RELAXED);
+    if (r) {
+      MRConn_UpdateLatency(conn, elapsedMS(&req->sentAt));
+    }
+  }
+
+  if (req->fn) {
+    req->fn(c, r, req->privdata);
+  } else if (r) {
+    MRReply_Free(r);
+  }
+  rm_free(req);
+
+  if (conn && r) {
+    MRConn_Drain(conn);
+  }
+}
+
 /* Send a command to the connection */
 int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata) {
 
@@ -140,11 +271,50 @@ int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *pri
       return REDIS_ERR;
     }
   }
-  if (cmd->protocol != 0 && (!c->protocol || c->protocol != cmd->protocol)) {
-    int rc = redisAsyncCommand(c->conn, NULL, NULL, "HELLO %d", cmd->protocol);
-    c->protocol = cmd->protocol;
+
+  MRConnRequest *req = rm_malloc(sizeof(*req));
+  *req = (MRConnRequest){.fn = fn, .privdata = privdata};
+
+  // Once the pipeline is full the commands wait their turn, in order
+  size_t maxInflight = clusterConfig.connMaxInflight;
+  if (maxInflight && (c->inflight >= maxInflight || c->queueHead)) {
+    req->cmd = sdsdup(cmd->cmd);
+    req->protocol = cmd->protocol;
+    if (c->queueTail) {
+      c->queueTail->next = req;
+    } else {
+      c->queueHead = req;
+    }
+    c->queueTail = req;
+    __atomic_add_fetch(&c->queued, 1, __ATOMIC_RELAXED);
+    return REDIS_OK;
   }
-  return redisAsyncFormattedCommand(c->conn, fn, privdata, cmd->cmd, sdslen(cmd->cmd));
+
+  if (MRConn_Write(c, req, cmd->cmd, cmd->protocol) == REDIS_ERR) {
+    rm_free(req);
+    return REDIS_ERR;
+  }
+  return REDIS_OK;
+}
+
+// The weights of a new sample in the average latency and its deviation, and the number of
+// deviations above the average from which a reply is late, as in the TCP retransmission timer
+#define MRCONN_LATENCY_ALPHA 0.125
+#define MRCONN_LATENCY_BETA 0.25
+#define MRCONN_LATENCY_DEVS 4
+
+void MRConn_UpdateLatency(MRConn *c, double ms) {
+  if (!c->latency) {
+    c->latency = ms;
+    c->latencyDev = ms / 2;
+    return;
+  }
+  c->latencyDev += MRCONN_LATENCY_BETA * (fabs(ms - c->latency) - c->latencyDev);
+  c->latency += MRCONN_LATENCY_ALPHA * (ms - c->latency);
+}
+
+double MRConn_LateReplyMS(const MRConn *c) {
+  return c->latency ? c->latency + MRCONN_LATENCY_DEVS * c->latencyDev : 0;
 }
 
 // replace an existing coonnection pool with a new one
@@ -171,7 +341,7 @@ int MRConnManager_Add(MRConnManager *m, const char *id, MREndpoint *ep, int conn
     // if the node has changed, we just replace the pool with a new one automatically
   }
 
-  MRConnPool *pool = _MR_NewConnPool(ep, m->nodeConns);
+  MRConnPool *pool = _MR_NewConnPool(ep, m->nodeConns, m->loop);
   if (connect) {
     for (size_t i = 0; i < pool->num; i++) {
       MRConn_Connect(pool->conns[i]);
@@ -231,6 +401,7 @@ static void MRConn_Stop(MRConn *conn) {
 }
 
 static void freeConn(MRConn *conn) {
+  MRConn_FailQueued(conn);
   MREndpoint_Free(&conn->ep);
   if (conn->timer) {
     if (uv_is_active(conn->timer)) {
@@ -278,7 +449,7 @@ static void signalCallback(uv_timer_t *tm) {
 static void MRConn_SwitchState(MRConn *conn, MRConnState nextState) {
   if (!conn->timer) {
     conn->timer = rm_malloc(sizeof(uv_timer_t));
-    uv_timer_init(uv_default_loop(), conn->timer);
+    uv_timer_init(conn->loop, conn->timer);
     ((uv_timer_t *)conn->timer)->data = conn;
   }
   CONN_LOG(conn, "Switching state to %s", MRConnState_Str(nextState));
@@ -516,9 +687,9 @@ static void MRConn_DisconnectCallback(const redisAsyncContext *c, int status) {
   }
 }
 
-static MRConn *MR_NewConn(MREndpoint *ep) {
+static MRConn *MR_NewConn(MREndpoint *ep, uv_loop_t *loop) {
   MRConn *conn = rm_malloc(sizeof(MRConn));
-  *conn = (MRConn){.state = MRConn_Disconnected, .conn = NULL, .protocol = 0};
+  *conn = (MRConn){.state = MRConn_Disconnected, .conn = NULL, .loop = loop, .protocol = 0};
   MREndpoint_Copy(&conn->ep, ep);
   return conn;
 }
@@ -543,7 +714,7 @@ static int MRConn_Connect(MRConn *conn) {
   conn->conn->data = conn;
   conn->state = MRConn_Connecting;
 
-  redisLibuvAttach(conn->conn, uv_default_loop());
+  redisLibuvAttach(conn->conn, conn->loop);
   redisAsyncSetConnectCallback(conn->conn, MRConn_ConnectCallback);
   redisAsyncSetDisconnectCallback(conn->conn, MRConn_DisconnectCallback);
 
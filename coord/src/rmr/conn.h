@@ -51,18 +51,44 @@ static inline const char *MRConnState_Str(MRConnState state) {
   }
 }
 
+struct MRConnRequest;
+struct uv_loop_s;
+
 typedef struct {
   MREndpoint ep;
   redisAsyncContext *conn;
+  /* The loop the connection is handled on, by its IO thread only */
+  struct uv_loop_s *loop;
   MRConnState state;
   void *timer;
   int protocol; // 0 (undetermined), 2, or 3
+  /* The smoothed latency of the replies and its mean deviation in milliseconds, 0 until the first
+   * reply is accounted for (see MRConn_UpdateLatency) */
+  double latency;
+  double latencyDev;
+  /* The number of commands sent which were not replied yet, and of the commands waiting for them
+   * to be replied, when the pipeline of the connection is full (see CONN_MAX_INFLIGHT) */
+  int inflight;
+  int queued;
+  struct MRConnRequest *queueHead;
+  struct MRConnRequest *queueTail;
 } MRConn;
 
+/* The load of the connections to a node */
+typedef struct {
+  size_t inflight;
+  size_t queued;
+  // The average smoothed latency of the connections in milliseconds, 0 if not known yet
+  double latency;
+} MRConnStats;
+
 /* A pool indexes connections by the node id */
 typedef struct {
   TrieMap *map;
   int nodeConns;
+  /* The loop the connections of the manager are handled on, the default loop unless set before any
+   * node is added */
+  struct uv_loop_s *loop;
 } MRConnManager;
 
 void MRConnManager_Init(MRConnManager *mgr, int nodeConns);
@@ -70,8 +96,20 @@ void MRConnManager_Init(MRConnManager *mgr, int nodeConns);
 /* Get the connection for a specific node by id, return NULL if this node is not in the pool */
 MRConn *MRConn_Get(MRConnManager *mgr, const char *id);
 
+/* Send a command to the connection, or queue it until a reply frees a place in its pipeline. The
+ * callback of a queued command is called with a NULL reply if the connection is lost */
 int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata);
 
+/* Account for the latency of a reply, in an exponentially weighted moving average */
+void MRConn_UpdateLatency(MRConn *c, double ms);
+
+/* The time in milliseconds after which a reply is late, estimating a high percentile of the latency
+ * of the connection, or 0 if no reply was accounted for yet */
+double MRConn_LateReplyMS(const MRConn *c);
+
+/* Get the load of the connections to a node by id, return 0 if this node is not in the pool */
+int MRConnManager_NodeStats(MRConnManager *mgr, const char *id, MRConnStats *stats);
+
 /* Add a node to the connection manager */
 int MRConnManager_Add(MRConnManager *m, const char *id, MREndpoint *ep, int connect);
 
@@ -213,6 +213,17 @@ int MRReply_ToInteger(MRReply *reply, long long *i) {
   }
 }
 
+size_t MRReply_Size(MRReply *reply) {
+  size_t size = sizeof(*reply) + reply->len;
+  if (reply->element) {
+    size += reply->elements * sizeof(*reply->element);
+    for (size_t i = 0; i < reply->elements; ++i) {
+      size += MRReply_Size(reply->element[i]);
+    }
+  }
+  return size;
+}
+
 int MRReply_ToDouble(MRReply *reply, double *d) {
   if (reply == NULL) return 0;
 
@@ -13,6 +13,9 @@
 #include "rq.h"
 #include "rmutil/rm_assert.h"
 #include "resp3.h"
+#include "util/cpu_affinity.h"
+#include "alloc_stats.h"
+#include "../config.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,9 +33,29 @@
 
 extern int redisMajorVesion;
 
-/* Currently a single cluster is supported */
+/* An IO thread, running a uv loop with connections of its own to the nodes of the cluster. Each
+ * request runs on a single IO thread, so that its replies are collected without locks */
+typedef struct {
+  uv_loop_t *loop;
+  uv_thread_t thread;
+  MRWorkQueue *q;
+  MRCluster *cl;
+  // The CPUs to pin the thread to, consumed by the thread
+  arrayof(int) cpus;
+} MRIOThread;
+
+static MRIOThread *ioThreads_g = NULL;
+static size_t numIOThreads_g = 0;
+// The IO thread the next request runs on, in round robin
+static size_t nextIOThread_g = 0;
+
+/* Currently a single cluster is supported. This is the cluster of the first IO thread, whose
+ * topology is the one reported by the coordinator */
 static MRCluster *cluster_g = NULL;
-static MRWorkQueue *rq_g = NULL;
+
+static MRIOThread *MR_NextIOThread() {
+  return &ioThreads_g[__atomic_fetch_add(&nextIOThread_g, 1, __ATOMIC_RELAXED) % numIOThreads_g];
+}
 
 /* Coordination request timeout */
 long long timeout_g = 5000;
@@ -55,6 +78,8 @@ typedef struct MRCtx {
   MRCommand *cmds;
   int numCmds;
   int protocol;
+  /* The IO thread the requests of the context run on */
+  MRIOThread *io;
 
   /**
    * This is a reduce function inside the MRCtx.
@@ -66,8 +91,18 @@ typedef struct MRCtx {
    * needs to unblock the client.
    */
   MRReduceFunc fn;
+
+  /* If set, called with every reply as it arrives, before the reducer is called with all of them */
+  MRReplyHook replyHook;
+  /* The private data of the mapped commands, telling the reply hook which command a reply is for */
+  struct MRCommandReplyCtx *cmdReplyCtxs;
 } MRCtx;
 
+typedef struct MRCommandReplyCtx {
+  MRCtx *ctx;
+  int cmdIdx;
+} MRCommandReplyCtx;
+
 /* The request duration in microseconds, relevant only on the reducer */
 int64_t MR_RequestDuration(MRCtx *ctx) {
   return ((int64_t)1000000 * ctx->endTime.tv_sec + ctx->endTime.tv_nsec / 1000) -
@@ -88,7 +123,8 @@ MRCtx *MR_CreateCtx(RedisModuleCtx *ctx, RedisModuleBlockedClient *bc, void *pri
   ret->numReplied = 0;
   ret->numErrored = 0;
   ret->numExpected = 0;
-  ret->repliesCap = MAX(1, MRCluster_NumShards(cluster_g));
+  ret->io = MR_NextIOThread();
+  ret->repliesCap = MAX(1, MRCluster_NumShards(ret->io->cl));
   ret->replies = rm_calloc(ret->repliesCap, sizeof(redisReply *));
   ret->reducer = NULL;
   ret->privdata = privdata;
@@ -98,6 +134,10 @@ MRCtx *MR_CreateCtx(RedisModuleCtx *ctx, RedisModuleBlockedClient *bc, void *pri
   RedisModule_Assert(ctx || bc);
   ret->protocol = ctx ? (is_resp3(ctx) ? 3 : 2) : 0;
   ret->fn = NULL;
+  ret->replyHook = NULL;
+  ret->cmds = NULL;
+  ret->numCmds = 0;
+  ret->cmdReplyCtxs = NULL;
   totalAllocd++;
 
   return ret;
@@ -117,6 +157,7 @@ void MRCtx_Free(MRCtx *ctx) {
     }
   }
   rm_free(ctx->replies);
+  rm_free(ctx->cmdReplyCtxs);
 
   // free the context
   rm_free(ctx);
@@ -131,6 +172,10 @@ int MRCtx_GetNumReplied(struct MRCtx *ctx) {
   return ctx->numReplied;
 }
 
+int MRCtx_GetNumErrored(struct MRCtx *ctx) {
+  return ctx->numErrored;
+}
+
 MRReply** MRCtx_GetReplies(struct MRCtx *ctx) {
   return ctx->replies;
 }
@@ -167,9 +212,13 @@ void MRCtx_SetReduceFunction(struct MRCtx *ctx, MRReduceFunc fn) {
   ctx->fn = fn;
 }
 
+void MRCtx_SetReplyHook(struct MRCtx *ctx, MRReplyHook fn) {
+  ctx->replyHook = fn;
+}
+
 static void freePrivDataCB(void *p) {
   // printf("FreePrivData called!\n");
-  MR_requestCompleted();
+  MR_requestCompleted(p);
   if (p) {
     MRCtx *mc = p;
     MRCtx_Free(mc);
@@ -196,9 +245,8 @@ static int unblockHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
   return mc->reducer(mc, mc->numReplied, mc->replies);
 }
 
-/* The callback called from each fanout request to aggregate their replies */
-static void fanoutCallback(redisAsyncContext *c, void *r, void *privdata) {
-  MRCtx *ctx = privdata;
+/* Aggregate a reply of a request, `cmdIdx` being the index of its command or -1 for a fanout */
+static void collectReply(MRCtx *ctx, MRReply *r, int cmdIdx) {
   struct timespec now;
   clock_gettime(CLOCK_REALTIME, &now);
 
@@ -215,6 +263,9 @@ static void fanoutCallback(redisAsyncContext *c, void *r, void *privdata) {
       ctx->replies = rm_realloc(ctx->replies, ctx->repliesCap * sizeof(MRReply *));
     }
     ctx->replies[ctx->numReplied++] = r;
+    if (ctx->replyHook) {
+      ctx->replyHook(ctx, r, cmdIdx);
+    }
   }
 
   // printf("Unblocking, replied %d, errored %d out of %d\n", ctx->numReplied, ctx->numErrored,
@@ -233,6 +284,17 @@ static void fanoutCallback(redisAsyncContext *c, void *r, void *privdata) {
   }
 }
 
+/* The callback called from each fanout request to aggregate their replies */
+static void fanoutCallback(redisAsyncContext *c, void *r, void *privdata) {
+  collectReply(privdata, r, -1);
+}
+
+/* The callback called from each mapped command, when the replies are hooked */
+static void mapCallback(redisAsyncContext *c, void *r, void *privdata) {
+  MRCommandReplyCtx *rc = privdata;
+  collectReply(rc->ctx, r, rc->cmdIdx);
+}
+
 // temporary request context to pass to the event loop
 struct MRRequestCtx {
   void *ctx;
@@ -241,6 +303,7 @@ struct MRRequestCtx {
   int numCmds;
   void (*cb)(struct MRRequestCtx *);
   int protocol;
+  MRIOThread *io;
 };
 
 void requestCb(void *p) {
@@ -250,45 +313,82 @@ void requestCb(void *p) {
 
 /* start the event loop side thread */
 static void sideThread(void *arg) {
+  MRIOThread *io = arg;
+  if (io->cpus) {
+    if (CPUList_PinCurrentThread(io->cpus) != REDISMODULE_OK) {
+      fprintf(stderr, "Could not set the CPU affinity of the uv loop thread\n");
+    }
+    array_free(io->cpus);
+    io->cpus = NULL;
+  }
+  // everything the loop allocates is on behalf of the coordinator
+  AllocStats_SetTag(ALLOC_TAG_COORD);
 
-  // uv_loop_configure(uv_default_loop(), UV_LOOP_BLOCK_SIGNAL)
+  // uv_loop_configure(io->loop, UV_LOOP_BLOCK_SIGNAL)
   while (1) {
-    if (uv_run(uv_default_loop(), UV_RUN_DEFAULT)) break;
+    if (uv_run(io->loop, UV_RUN_DEFAULT)) break;
     usleep(1000);
     fprintf(stderr, "restarting loop!\n");
   }
   fprintf(stderr, "Uv loop exited!\n");
 }
 
-uv_thread_t loop_th;
-
-/* Initialize the MapReduce engine with a node provider */
-void MR_Init(MRCluster *cl, long long timeoutMS) {
+/* Initialize the MapReduce engine with a node provider. The connections to each node are split
+ * between `numThreads` IO threads, the first one handling the connections of `cl` */
+void MR_Init(MRCluster *cl, long long timeoutMS, const char *cpuList, size_t numThreads) {
 
   cluster_g = cl;
   timeout_g = timeoutMS;
-  // `*50` for following the previous behavior
-  // #define MAX_CONCURRENT_REQUESTS (MR_CONN_POOL_SIZE * 50)
-  rq_g = RQ_New(cl->mgr.nodeConns * 50);
+  numIOThreads_g = MAX(1, numThreads);
+  ioThreads_g = rm_calloc(numIOThreads_g, sizeof(*ioThreads_g));
+  int nodeConns = MAX(1, (cl->mgr.nodeConns + numIOThreads_g - 1) / numIOThreads_g);
+  cl->mgr.nodeConns = nodeConns;
+
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    MRIOThread *io = &ioThreads_g[i];
+    if (i == 0) {
+      io->loop = uv_default_loop();
+      io->cl = cl;
+    } else {
+      io->loop = rm_malloc(sizeof(uv_loop_t));
+      uv_loop_init(io->loop);
+      // The other clusters get their topology along with the first one (see MR_UpdateTopology)
+      io->cl = MR_NewCluster(NULL, nodeConns, cl->sf, cl->topologyUpdateMinInterval);
+      io->cl->mgr.loop = io->loop;
+    }
+    // `*50` for following the previous behavior
+    // #define MAX_CONCURRENT_REQUESTS (MR_CONN_POOL_SIZE * 50)
+    io->q = RQ_New(io->loop, nodeConns * 50);
+    io->cl->q = io->q;
+    // Resolved here, on the main thread, so that NUMA_LOCAL stands for the node of the main thread
+    io->cpus = CPUList_FromSetting(cpuList);
+  }
 
   // MRCluster_ConnectAll(cluster_g);
-  printf("Creating thread...\n");
+  printf("Creating %zu threads...\n", numIOThreads_g);
 
-  if (uv_thread_create(&loop_th, sideThread, NULL) != 0) {
-    perror("thread create");
-    exit(-1);
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    if (uv_thread_create(&ioThreads_g[i].thread, sideThread, &ioThreads_g[i]) != 0) {
+      perror("thread create");
+      exit(-1);
+    }
   }
-  printf("Thread created\n");
+  printf("Threads created\n");
 }
 void MR_Destroy() {
-  if (rq_g) {
-    RQ_Free(rq_g);
-    rq_g = NULL;
-  }
-  if (cluster_g) {
-    MRClust_Free(cluster_g);
-    cluster_g = NULL;
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    MRIOThread *io = &ioThreads_g[i];
+    if (io->q) {
+      RQ_Free(io->q);
+      io->q = NULL;
+    }
+    MRClust_Free(io->cl);
+    io->cl = NULL;
   }
+  rm_free(ioThreads_g);
+  ioThreads_g = NULL;
+  numIOThreads_g = 0;
+  cluster_g = NULL;
 }
 
 MRClusterTopology *MR_GetCurrentTopology() {
@@ -324,14 +424,14 @@ static void uvFanoutRequest(struct MRRequestCtx *mc) {
     int cmd_proto = mc->cmds[0].protocol;
     if (cmd_proto != mc->protocol) {
       MRCommand hello = MR_NewCommand(2, "HELLO", cmd_proto == 3 ? "3" : "2");
-      int rc = MRCluster_SendCommand(cluster_g, MRCluster_FlatCoordination, &hello, helloCallback, mrctx);
+      int rc = MRCluster_SendCommand(mrctx->io->cl, MRCluster_FlatCoordination, &hello, helloCallback, mrctx);
     }
   }
 
-  if (cluster_g->topo) {
+  if (mrctx->io->cl->topo) {
     MRCommand *cmd = &mc->cmds[0];
     mrctx->numExpected =
-        MRCluster_FanoutCommand(cluster_g, mrctx->strategy, cmd, fanoutCallback, mrctx);
+        MRCluster_FanoutCommand(mrctx->io->cl, mrctx->strategy, cmd, fanoutCallback, mrctx);
   }
 
   for (int i = 0; i < mrctx->numCmds; ++i) {
@@ -352,18 +452,25 @@ static void uvFanoutRequest(struct MRRequestCtx *mc) {
 
 static void uvMapRequest(struct MRRequestCtx *mc) {
   MRCtx *mrctx = mc->ctx;
-  mrctx->numReplied = 0;
   mrctx->reducer = mc->f;
-  mrctx->numExpected = 0;
-  mrctx->numCmds = mc->numCmds;
-  mrctx->cmds = rm_calloc(mrctx->numCmds, sizeof(MRCommand));
+  // The commands and the replies of the previous rounds are kept, if the reduce function maps the
+  // context again
+  int firstCmd = mrctx->numCmds;
+  mrctx->numExpected = mrctx->numReplied + mrctx->numErrored;
+  mrctx->numCmds += mc->numCmds;
+  mrctx->cmds = rm_realloc(mrctx->cmds, MAX(1, mrctx->numCmds) * sizeof(MRCommand));
+  if (mrctx->replyHook) {
+    // The replies of the previous rounds all arrived, so their private data can be moved
+    mrctx->cmdReplyCtxs = rm_realloc(mrctx->cmdReplyCtxs,
+                                     MAX(1, mrctx->numCmds) * sizeof(*mrctx->cmdReplyCtxs));
+  }
 
   if (mc->numCmds > 0) {
     int cmd_proto = mc->cmds[0].protocol;
     // @@TODO: this may not be requires as we're hello-ing before command_send
     if (cmd_proto != mc->protocol) {
       MRCommand hello = MR_NewCommand(2, "HELLO", cmd_proto == 3 ? "3" : "2");
-      int rc = MRCluster_SendCommand(cluster_g, MRCluster_FlatCoordination, &hello, helloCallback, mrctx);
+      int rc = MRCluster_SendCommand(mrctx->io->cl, MRCluster_FlatCoordination, &hello, helloCallback, mrctx);
     }
   }
 
@@ -371,16 +478,40 @@ static void uvMapRequest(struct MRRequestCtx *mc) {
     if (!mc->cmds[i].protocol) {
       mc->cmds[i].protocol = mc->protocol; //@@ needed?
     }
-    if (MRCluster_SendCommand(cluster_g, mrctx->strategy, &mc->cmds[i], fanoutCallback, mrctx) == REDIS_OK) {
+    int rc;
+    if (mrctx->replyHook) {
+      MRCommandReplyCtx *replyCtx = &mrctx->cmdReplyCtxs[firstCmd + i];
+      *replyCtx = (MRCommandReplyCtx){.ctx = mrctx, .cmdIdx = firstCmd + i};
+      rc = MRCluster_SendCommand(mrctx->io->cl, mrctx->strategy, &mc->cmds[i], mapCallback,
+                                 replyCtx);
+    } else {
+      rc = MRCluster_SendCommand(mrctx->io->cl, mrctx->strategy, &mc->cmds[i], fanoutCallback,
+                                 mrctx);
+    }
+    if (rc == REDIS_OK) {
       mrctx->numExpected++;
     }
   }
 
-  for (int i = 0; i < mrctx->numCmds; ++i) {
-    mrctx->cmds[i] = mc->cmds[i];
+  for (int i = 0; i < mc->numCmds; ++i) {
+    mrctx->cmds[firstCmd + i] = mc->cmds[i];
   }
 
-  if (mrctx->numExpected == 0) {
+  if (mrctx->numExpected == mrctx->numReplied + mrctx->numErrored && mrctx->numExpected > 0) {
+    // None of the commands of a later round was sent, the reduce function goes on with the
+    // replies of the previous rounds
+    if (mrctx->fn) {
+      mrctx->fn(mrctx, mrctx->numReplied, mrctx->replies);
+    } else {
+      RedisModuleBlockedClient *bc = mrctx->bc;
+      RedisModule_Assert(bc);
+      RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeEnd, bc);
+      RedisModule_UnblockClient(bc, mrctx);
+    }
+  } else if (mrctx->numExpected == 0 && mrctx->fn && !mrctx->bc) {
+    // A request without a client to unblock goes on with the reduce function
+    mrctx->fn(mrctx, mrctx->numReplied, mrctx->replies);
+  } else if (mrctx->numExpected == 0) {
     RedisModuleBlockedClient *bc = mrctx->bc;
     RedisModule_Assert(bc);
     RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeEnd, bc);
@@ -392,8 +523,9 @@ static void uvMapRequest(struct MRRequestCtx *mc) {
   rm_free(mc);
 }
 
-void MR_requestCompleted() {
-  RQ_Done(rq_g);
+void MR_requestCompleted(struct MRCtx *ctx) {
+  // A context freed by its blocked client may be gone, its request ran on the first IO thread then
+  RQ_Done(ctx ? ctx->io->q : ioThreads_g[0].q);
 }
 
 /* Fanout map - send the same command to all the shards, sending the collective
@@ -417,7 +549,7 @@ int MR_Fanout(struct MRCtx *mrctx, MRReduceFunc reducer, MRCommand cmd, bool blo
   rc->numCmds = 1;
   rc->cmds[0] = cmd;
   rc->cb = uvFanoutRequest;
-  RQ_Push(rq_g, requestCb, rc);
+  RQ_Push(mrctx->io->q, requestCb, rc);
   return REDIS_OK;
 }
 
@@ -447,7 +579,7 @@ int MR_Map(struct MRCtx *ctx, MRReduceFunc reducer, MRCommandGenerator cmds, boo
   }
 
   rc->cb = uvMapRequest;
-  RQ_Push(rq_g, requestCb, rc);
+  RQ_Push(ctx->io->q, requestCb, rc);
 
   return REDIS_OK;
 }
@@ -468,7 +600,7 @@ int MR_MapSingle(struct MRCtx *ctx, MRReduceFunc reducer, MRCommand cmd) {
   RS_CHECK_FUNC(RedisModule_BlockedClientMeasureTimeStart, ctx->bc);
 
   rc->cb = uvMapRequest;
-  RQ_Push(rq_g, requestCb, rc);
+  RQ_Push(ctx->io->q, requestCb, rc);
   return REDIS_OK;
 }
 
@@ -477,12 +609,48 @@ size_t MR_NumHosts() {
   return cluster_g ? MRCluster_NumHosts(cluster_g) : 0;
 }
 
+bool MR_Overloaded() {
+  size_t max = clusterConfig.maxPendingRequests;
+  if (!max) {
+    return false;
+  }
+  size_t len = 0;
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    len += RQ_Len(ioThreads_g[i].q);
+  }
+  return len >= max;
+}
+
+int MR_GetNodeStats(const char *id, MRConnStats *stats) {
+  *stats = (MRConnStats){0};
+  size_t found = 0, measured = 0;
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    MRConnStats threadStats;
+    if (!MRConnManager_NodeStats(&ioThreads_g[i].cl->mgr, id, &threadStats)) {
+      continue;
+    }
+    found++;
+    stats->inflight += threadStats.inflight;
+    stats->queued += threadStats.queued;
+    if (threadStats.latency) {
+      stats->latency += threadStats.latency;
+      measured++;
+    }
+  }
+  if (measured) {
+    stats->latency /= measured;
+  }
+  return found > 0;
+}
+
 void SetMyPartition(MRClusterTopology *ct, MRClusterShard *myShard);
 /* on-loop update topology request. This can't be done from the main thread */
 static void uvUpdateTopologyRequest(struct MRRequestCtx *mc) {
-  MRCLuster_UpdateTopology(cluster_g, (MRClusterTopology *)mc->ctx);
-  SetMyPartition((MRClusterTopology *)mc->ctx, cluster_g->myshard);
-  RQ_Done(rq_g);
+  MRCLuster_UpdateTopology(mc->io->cl, (MRClusterTopology *)mc->ctx);
+  if (mc->io->cl == cluster_g) {
+    SetMyPartition((MRClusterTopology *)mc->ctx, cluster_g->myshard);
+  }
+  RQ_Done(mc->io->q);
   // fprintf(stderr, "topo update: conc requests: %d\n", concurrentRequests_g);
   rm_free(mc);
 }
@@ -493,12 +661,23 @@ int MR_UpdateTopology(MRClusterTopology *newTopo) {
     return REDIS_ERR;
   }
 
-  // enqueue a request on the io thread, this can't be done from the main thread
-  struct MRRequestCtx *rc = rm_calloc(1, sizeof(*rc));
-  rc->ctx = newTopo;
-  rc->cb = uvUpdateTopologyRequest;
-  rc->protocol = 0;
-  RQ_Push(rq_g, requestCb, rc);
+  // every IO thread gets a copy of its own, made before the first one may free the topology
+  MRClusterTopology **topos = rm_malloc(numIOThreads_g * sizeof(*topos));
+  topos[0] = newTopo;
+  for (size_t i = 1; i < numIOThreads_g; i++) {
+    topos[i] = MRClusterTopology_Clone(newTopo);
+  }
+
+  // enqueue a request on the io threads, this can't be done from the main thread
+  for (size_t i = 0; i < numIOThreads_g; i++) {
+    struct MRRequestCtx *rc = rm_calloc(1, sizeof(*rc));
+    rc->ctx = topos[i];
+    rc->cb = uvUpdateTopologyRequest;
+    rc->protocol = 0;
+    rc->io = &ioThreads_g[i];
+    RQ_Push(rc->io->q, requestCb, rc);
+  }
+  rm_free(topos);
   return REDIS_OK;
 }
 
@@ -507,18 +686,34 @@ struct MRIteratorCallbackCtx;
 typedef int (*MRIteratorCallback)(struct MRIteratorCallbackCtx *ctx, MRReply *rep, MRCommand *cmd);
 
 typedef struct MRIteratorCtx {
+  MRIOThread *io;
   MRCluster *cluster;
   MRChannel *chan;
   void *privdata;
   MRIteratorCallback cb;
   int pending;
+  // the size of the replies of a shard waiting to be read, from which its next command waits for
+  // them to be read (0 is unbounded, see CURSOR_READ_AHEAD)
+  size_t budget;
 } MRIteratorCtx;
 
 typedef struct MRIteratorCallbackCtx {
   MRIteratorCtx *ic;
   MRCommand cmd;
+  // the size of the replies of the shard pushed to the channel and not read yet
+  size_t buffered;
+  // set while the command of the shard waits for its replies to be read, to be sent by whichever
+  // thread unsets it
+  int parked;
 } MRIteratorCallbackCtx;
 
+/* A reply in the channel of an iterator, along with the shard it came from */
+typedef struct {
+  MRReply *reply;
+  MRIteratorCallbackCtx *src;
+  size_t size;
+} MRIteratorItem;
+
 typedef struct MRIterator {
   MRIteratorCtx ctx;
   MRIteratorCallbackCtx *cbxs;
@@ -539,18 +734,58 @@ static void mrIteratorRedisCB(redisAsyncContext *c, void *r, void *privdata) {
   }
 }
 
+static bool iterOverBudget(MRIteratorCallbackCtx *ctx) {
+  size_t budget = __atomic_load_n(&ctx->ic->budget, __ATOMIC_SEQ_CST);
+  return budget && __atomic_load_n(&ctx->buffered, __ATOMIC_SEQ_CST) >= budget;
+}
+
+/* Take the parked command of a shard, unless the other thread took it */
+static bool iterUnpark(MRIteratorCallbackCtx *ctx) {
+  int parked = 1;
+  return __atomic_compare_exchange_n(&ctx->parked, &parked, 0, false, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_SEQ_CST);
+}
+
+static void iterResendCb(void *p) {
+  MRIteratorCallbackCtx *ctx = p;
+  if (MRCluster_SendCommand(ctx->ic->cluster, MRCluster_MastersOnly, &ctx->cmd, mrIteratorRedisCB,
+                            ctx) == REDIS_ERR) {
+    MRIteratorCallback_Done(ctx, 1);
+  }
+}
+
+/* Resend the parked command of a shard from the thread reading the replies, once they are read
+ * below the budget */
+static void iterResume(MRIteratorCallbackCtx *ctx) {
+  if (!iterOverBudget(ctx) && iterUnpark(ctx)) {
+    RQ_Post(ctx->ic->io->q, iterResendCb, ctx);
+  }
+}
+
 int MRIteratorCallback_ResendCommand(MRIteratorCallbackCtx *ctx, MRCommand *cmd) {
   ctx->cmd = *cmd;
+  if (iterOverBudget(ctx)) {
+    // Park the command, and take it back if the replies were read below the budget meanwhile, as
+    // the reader may have missed it
+    __atomic_store_n(&ctx->parked, 1, __ATOMIC_SEQ_CST);
+    if (iterOverBudget(ctx) || !iterUnpark(ctx)) {
+      return REDIS_OK;
+    }
+  }
   return MRCluster_SendCommand(ctx->ic->cluster, MRCluster_MastersOnly, cmd, mrIteratorRedisCB,
                                ctx);
 }
 
+size_t MRIteratorCallback_GetBuffered(MRIteratorCallbackCtx *ctx) {
+  return __atomic_load_n(&ctx->buffered, __ATOMIC_SEQ_CST);
+}
+
 void *MRITERATOR_DONE = "MRITERATOR_DONE";
 
 int MRIteratorCallback_Done(MRIteratorCallbackCtx *ctx, int error) {
   if (--ctx->ic->pending <= 0) {
     // fprintf(stderr, "FINISHED iterator, error? %d pending %d\n", error, ctx->ic->pending);
-    RQ_Done(rq_g);
+    RQ_Done(ctx->ic->io->q);
 
     MRChannel_Close(ctx->ic->chan);
     return 0;
@@ -561,7 +796,12 @@ int MRIteratorCallback_Done(MRIteratorCallbackCtx *ctx, int error) {
 }
 
 int MRIteratorCallback_AddReply(MRIteratorCallbackCtx *ctx, MRReply *rep) {
-  return MRChannel_Push(ctx->ic->chan, rep);
+  MRIteratorItem *item = rm_malloc(sizeof(*item));
+  item->reply = rep;
+  item->src = ctx;
+  item->size = MRReply_Size(rep);
+  __atomic_add_fetch(&ctx->buffered, item->size, __ATOMIC_SEQ_CST);
+  return MRChannel_Push(ctx->ic->chan, item);
 }
 
 void iterStartCb(void *p) {
@@ -579,14 +819,17 @@ MRIterator *MR_Iterate(MRCommandGenerator cg, MRIteratorCallback cb, void *privd
 
   MRIterator *ret = rm_malloc(sizeof(*ret));
   size_t len = cg.Len(cg.ctx);
+  MRIOThread *io = MR_NextIOThread();
   *ret = (MRIterator){
       .ctx =
           {
-              .cluster = cluster_g,
+              .io = io,
+              .cluster = io->cl,
               .chan = MR_NewChannel(0),
               .privdata = privdata,
               .cb = cb,
               .pending = 0,
+              .budget = clusterConfig.cursorReadAhead,
           },
       .cbxs = rm_calloc(len, sizeof(MRIteratorCallbackCtx)),
       .len = len,
@@ -608,7 +851,7 @@ MRIterator *MR_Iterate(MRCommandGenerator cg, MRIteratorCallback cb, void *privd
   }
   ret->ctx.pending = ret->len;
 
-  RQ_Push(rq_g, iterStartCb, ret);
+  RQ_Push(io->q, iterStartCb, ret);
   return ret;
 }
 
@@ -618,10 +861,20 @@ MRReply *MRIterator_Next(MRIterator *it) {
   if (p == MRCHANNEL_CLOSED) {
     return MRITERATOR_DONE;
   }
-  return p;
+  MRIteratorItem *item = p;
+  MRReply *reply = item->reply;
+  __atomic_sub_fetch(&item->src->buffered, item->size, __ATOMIC_SEQ_CST);
+  iterResume(item->src);
+  rm_free(item);
+  return reply;
 }
 
 void MRIterator_WaitDone(MRIterator *it) {
+  // The replies are no longer read. Lift the budget for the shards to run to their end
+  __atomic_store_n(&it->ctx.budget, 0, __ATOMIC_SEQ_CST);
+  for (size_t i = 0; i < it->len; i++) {
+    iterResume(&it->cbxs[i]);
+  }
   MRChannel_WaitClose(it->ctx.chan);
 }
 
@@ -630,9 +883,10 @@ void MRIterator_Free(MRIterator *it) {
   for (size_t i = 0; i < it->len; i++) {
     MRCommand_Free(&it->cbxs[i].cmd);
   }
-  MRReply *reply;
-  while((reply = MRChannel_ForcePop(it->ctx.chan))){
-      MRReply_Free(reply);
+  MRIteratorItem *item;
+  while((item = MRChannel_ForcePop(it->ctx.chan))){
+      MRReply_Free(item->reply);
+      rm_free(item);
   }
   MRChannel_Free(it->ctx.chan);
   rm_free(it->cbxs);
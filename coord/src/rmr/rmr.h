@@ -19,18 +19,28 @@ struct RedisModuleCtx;
 /* Prototype for all reduce functions */
 typedef int (*MRReduceFunc)(struct MRCtx *ctx, int count, MRReply **replies);
 
+/* A function called on the IO thread with every reply of a request as it arrives, along with the
+ * index of the command it replies to in the commands of the context (see MRCtx_GetCmds), or -1 for
+ * the replies of a fanout */
+typedef void (*MRReplyHook)(struct MRCtx *ctx, MRReply *reply, int cmdIdx);
+
 /* Fanout map - send the same command to all the shards, sending the collective
  * reply to the reducer callback */
 int MR_Fanout(struct MRCtx *ctx, MRReduceFunc reducer, MRCommand cmd, bool block);
 
+/* Map - send every command of the generator to the shard it targets. A context may be mapped again
+ * by its reduce function (see MRCtx_SetReduceFunction), adding the commands and their replies to
+ * those of the previous rounds */
 int MR_Map(struct MRCtx *ctx, MRReduceFunc reducer, MRCommandGenerator cmds, bool block);
 
 int MR_MapSingle(struct MRCtx *ctx, MRReduceFunc reducer, MRCommand cmd);
 
 void MR_SetCoordinationStrategy(struct MRCtx *ctx, MRCoordinationStrategy strategy);
 
-/* Initialize the MapReduce engine with a node provider */
-void MR_Init(MRCluster *cl, long long timeoutMS);
+/* Initialize the MapReduce engine with a node provider. It runs `numThreads` IO threads, each with
+ * an event loop and connections of its own, on the CPUs of `cpuList` (see CPUList_FromSetting), or
+ * anywhere if it is NULL */
+void MR_Init(MRCluster *cl, long long timeoutMS, const char *cpuList, size_t numThreads);
 /* Cleanup used resources at exit */
 void MR_Destroy();
 
@@ -51,6 +61,7 @@ int64_t MR_RequestDuration(struct MRCtx *ctx);
 
 struct RedisModuleCtx *MRCtx_GetRedisCtx(struct MRCtx *ctx);
 int MRCtx_GetNumReplied(struct MRCtx *ctx);
+int MRCtx_GetNumErrored(struct MRCtx *ctx);
 MRReply** MRCtx_GetReplies(struct MRCtx *ctx);
 void MRCtx_SetRedisCtx(struct MRCtx *ctx, void* rctx);
 RedisModuleBlockedClient *MRCtx_GetBlockedClient(struct MRCtx *ctx);
@@ -59,7 +70,10 @@ void MRCtx_SetProtocol(struct MRCtx *ctx, int protocol);
 MRCommand *MRCtx_GetCmds(struct MRCtx *ctx);
 int MRCtx_GetCmdsSize(struct MRCtx *ctx);
 void MRCtx_SetReduceFunction(struct MRCtx *ctx, MRReduceFunc fn);
-void MR_requestCompleted();
+/* Have every reply handed to `fn` as it arrives, to be reduced incrementally */
+void MRCtx_SetReplyHook(struct MRCtx *ctx, MRReplyHook fn);
+/* Mark the request of a context as done, for the next requests of its IO thread to run */
+void MR_requestCompleted(struct MRCtx *ctx);
 
 
 /* Free the MapReduce context */
@@ -85,8 +99,13 @@ int MRIteratorCallback_AddReply(MRIteratorCallbackCtx *ctx, MRReply *rep);
 
 int MRIteratorCallback_Done(MRIteratorCallbackCtx *ctx, int error);
 
+/* Send the next command of a shard. It waits for the replies of the shard to be read first if
+ * they hold more than the budget of the iterator (see CURSOR_READ_AHEAD) */
 int MRIteratorCallback_ResendCommand(MRIteratorCallbackCtx *ctx, MRCommand *cmd);
 
+/* The size of the replies of the shard which were not read yet */
+size_t MRIteratorCallback_GetBuffered(MRIteratorCallbackCtx *ctx);
+
 void MRIterator_Free(MRIterator *it);
 
 /* Wait until the iterators producers are all  done */
@@ -95,3 +114,10 @@ void MRIterator_WaitDone(MRIterator *it);
 #endif // RMR_C__
 
 size_t MR_NumHosts();
+
+/* Return whether the requests waiting to be sent to the shards exceed MAX_PENDING_REQUESTS, so that
+ * the coordinator commands are rejected instead of being queued */
+bool MR_Overloaded();
+
+/* Get the load of the connections to a node of the cluster by id, return 0 if it is not known */
+int MR_GetNodeStats(const char *id, MRConnStats *stats);
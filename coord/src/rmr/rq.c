@@ -20,6 +20,9 @@ struct queueItem {
 typedef struct MRWorkQueue {
   struct queueItem *head;
   struct queueItem *tail;
+  // the callbacks posted with RQ_Post, which are not requests
+  struct queueItem *postedHead;
+  struct queueItem *postedTail;
   int pending;
   int maxPending;
   size_t sz;
@@ -42,12 +45,36 @@ void RQ_Push(MRWorkQueue *q, MRQueueCallback cb, void *privdata) {
   } else {  // no tail means no head - empty queue
     q->head = q->tail = item;
   }
-  q->sz++;
+  __atomic_add_fetch(&q->sz, 1, __ATOMIC_RELAXED);
 
   uv_mutex_unlock(&q->lock);
   uv_async_send(&q->async);
 }
 
+void RQ_Post(MRWorkQueue *q, MRQueueCallback cb, void *privdata) {
+  struct queueItem *item = rm_malloc(sizeof(*item));
+  item->cb = cb;
+  item->privdata = privdata;
+  item->next = NULL;
+  uv_mutex_lock(&q->lock);
+  if (q->postedTail) {
+    q->postedTail->next = item;
+  } else {
+    q->postedHead = item;
+  }
+  q->postedTail = item;
+  uv_mutex_unlock(&q->lock);
+  uv_async_send(&q->async);
+}
+
+static struct queueItem *rqTakePosted(MRWorkQueue *q) {
+  uv_mutex_lock(&q->lock);
+  struct queueItem *posted = q->postedHead;
+  q->postedHead = q->postedTail = NULL;
+  uv_mutex_unlock(&q->lock);
+  return posted;
+}
+
 static struct queueItem *rqPop(MRWorkQueue *q) {
   uv_mutex_lock(&q->lock);
   // fprintf(stderr, "%d %zd\n", concurrentRequests_g, q->sz);
@@ -57,17 +84,15 @@ static struct queueItem *rqPop(MRWorkQueue *q) {
     return NULL;
   }
   if (q->pending >= q->maxPending) {
+    // The queue is drained again once a pending request is done (see RQ_Done)
     uv_mutex_unlock(&q->lock);
-    // If the queue is full we need to wake up the drain callback
-    uv_async_send(&q->async);
-
     return NULL;
   }
 
   struct queueItem *r = q->head;
   q->head = r->next;
   if (!q->head) q->tail = NULL;
-  q->sz--;
+  __atomic_sub_fetch(&q->sz, 1, __ATOMIC_RELAXED);
   q->pending++;
 
   uv_mutex_unlock(&q->lock);
@@ -78,29 +103,45 @@ void RQ_Done(MRWorkQueue *q) {
   uv_mutex_lock(&q->lock);
   --q->pending;
   // fprintf(stderr, "Concurrent requests: %d/%d\n", q->pending, q->maxPending);
+  int waiting = q->head != NULL;
   uv_mutex_unlock(&q->lock);
+  // wake up the drain callback for the requests which waited for this one
+  if (waiting) {
+    uv_async_send(&q->async);
+  }
+}
+
+size_t RQ_Len(MRWorkQueue *q) {
+  return __atomic_load_n(&q->sz, __ATOMIC_RELAXED);
 }
 
 static void rqAsyncCb(uv_async_t *async) {
   MRWorkQueue *q = async->data;
-  struct queueItem *req;
+  struct queueItem *req = rqTakePosted(q);
+  while (req) {
+    struct queueItem *next = req->next;
+    req->cb(req->privdata);
+    rm_free(req);
+    req = next;
+  }
   while (NULL != (req = rqPop(q))) {
     req->cb(req->privdata);
     rm_free(req);
   }
 }
 
-MRWorkQueue *RQ_New(int maxPending) {
+MRWorkQueue *RQ_New(uv_loop_t *loop, int maxPending) {
 
   MRWorkQueue *q = rm_calloc(1, sizeof(*q));
   q->sz = 0;
   q->head = NULL;
   q->tail = NULL;
+  q->postedHead = q->postedTail = NULL;
   q->pending = 0;
   q->maxPending = maxPending;
   uv_mutex_init(&q->lock);
   // TODO: Add close cb
-  uv_async_init(uv_default_loop(), &q->async, rqAsyncCb);
+  uv_async_init(loop, &q->async, rqAsyncCb);
   q->async.data = q;
   return q;
 }
@@ -110,6 +151,12 @@ void RQ_Free(MRWorkQueue *q) {
   while (NULL != (req = rqPop(q))) {
     rm_free(req);
   }
+  req = rqTakePosted(q);
+  while (req) {
+    struct queueItem *next = req->next;
+    rm_free(req);
+    req = next;
+  }
 
   uv_close((uv_handle_t *)&q->async, NULL);
   uv_mutex_destroy(&q->lock);
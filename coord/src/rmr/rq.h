@@ -11,14 +11,24 @@
 
 typedef void (*MRQueueCallback)(void *);
 
+struct uv_loop_s;
+
 #ifndef RQ_C__
 typedef struct MRWorkQueue MRWorkQueue;
 
-MRWorkQueue *RQ_New(int maxPending);
+/* Create a queue of requests run on a uv loop, at most `maxPending` of them running at a time */
+MRWorkQueue *RQ_New(struct uv_loop_s *loop, int maxPending);
 
 void RQ_Free(MRWorkQueue *q);
 
 void RQ_Done(MRWorkQueue *q);
 
 void RQ_Push(MRWorkQueue *q, MRQueueCallback cb, void *privdata);
+
+/* Run a callback on the loop of the queue, ahead of the requests and whatever the number of the
+ * pending ones, for the work of a request done on another thread to be picked up on the loop */
+void RQ_Post(MRWorkQueue *q, MRQueueCallback cb, void *privdata);
+
+/* The number of requests waiting in the queue, which may be read from any thread */
+size_t RQ_Len(MRWorkQueue *q);
 #endif // RQ_C__
@@ -8,6 +8,8 @@
 #include "search_cluster.h"
 #include "partition.h"
 #include "alias.h"
+#include "rmr/crc16.h"
+#include "rmr/crc12.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -262,6 +264,25 @@ int SearchCluster_RewriteCommandToFirstPartition(SearchCluster *sc, MRCommand *c
   return 1;
 }
 
+int SearchCluster_SlotForTag(SearchCluster *sc, const char *tag, size_t len) {
+  if (!SearchCluster_Ready(sc)) return -1;
+
+  uint16_t crc = sc->hashFunc == MRHashFunc_CRC12 ? crc12(tag, len) : crc16(tag, len);
+  return crc % sc->part.tableSize;
+}
+
+int SearchCluster_SlotForKey(SearchCluster *sc, const char *key, size_t len) {
+  // as in Redis Cluster, the hash tag is the content of the first {...} of the key, if not empty
+  const char *open = memchr(key, '{', len);
+  if (open) {
+    const char *close = memchr(open + 1, '}', key + len - open - 1);
+    if (close && close > open + 1) {
+      return SearchCluster_SlotForTag(sc, open + 1, close - open - 1);
+    }
+  }
+  return SearchCluster_SlotForTag(sc, key, len);
+}
+
 /* Get the next multiplexed command for spellcheck command. Return 1 if we are not done, else 0 */
 int SpellCheckMuxIterator_Next(void *ctx, MRCommand *cmd) {
   SCCommandMuxIterator *it = ctx;
@@ -19,6 +19,8 @@ typedef struct {
   int* shardsStartSlots;
   PartitionCtx part;
   size_t myPartition;
+  // The hash function of the cluster, which maps the hash tags to the slots
+  MRHashFunc hashFunc;
 } SearchCluster;
 
 SearchCluster *GetSearchCluster();
@@ -52,6 +54,12 @@ int SearchCluster_RewriteCommand(SearchCluster *c, MRCommand *cmd, int partition
 
 int SearchCluster_RewriteCommandToFirstPartition(SearchCluster *sc, MRCommand *cmd);
 
+/* The slot of the keys with the hash tag {tag}, or -1 if the cluster is not ready */
+int SearchCluster_SlotForTag(SearchCluster *sc, const char *tag, size_t len);
+
+/* The slot of `key`, by its hash tag if it has one, or -1 if the cluster is not ready */
+int SearchCluster_SlotForKey(SearchCluster *sc, const char *key, size_t len);
+
 /* Rewrite a specific argument in a command by tagging it using the partition key, arg is the
  * index
  * of the argument being tagged, and it may be the paritioning key itself */
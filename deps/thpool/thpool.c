@@ -14,6 +14,8 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include <pthread.h>
 #include <errno.h>
 #include <time.h>
@@ -22,6 +24,8 @@
 
 #if defined(__linux__)
 #include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #endif
 
 #include "thpool.h"
@@ -41,17 +45,13 @@
 
 #define LOG_IF_EXISTS(level, str) if (thread_p->log) {thread_p->log(level, str);}
 
+/* The initial number of jobs in the deque of a thread, it grows by doubling when full */
+#define JOB_DEQUE_INITIAL_SIZE 64
+
 static volatile int threads_on_hold;
 
 /* ========================== STRUCTURES ============================ */
 
-/* Binary semaphore */
-typedef struct bsem {
-  pthread_mutex_t mutex;
-  pthread_cond_t cond;
-  int v;
-} bsem;
-
 /* Job */
 typedef struct job {
   struct job* prev;            /* pointer to previous job   */
@@ -59,6 +59,9 @@ typedef struct job {
   void* arg;                   /* function's argument       */
 } job;
 
+/* Returned by a steal which lost the race for the job on top of a deque */
+#define JOB_ABORT ((job*)-1)
+
 /* Job queue */
 typedef struct jobqueue {
   job* front;              /* pointer to front of queue */
@@ -66,21 +69,51 @@ typedef struct jobqueue {
   int len;                 /* number of jobs in queue   */
 } jobqueue;
 
+/* The injection queue, holding the jobs added by threads which are not in the pool */
 typedef struct priority_queue {
   jobqueue high_priority_jobqueue;    /* job queue for high priority tasks */
   jobqueue low_priority_jobqueue;     /* job queue for low priority tasks */
   pthread_mutex_t jobqueues_rwmutex;  /* used for queue r/w access */
-  bsem* has_jobs;                     /* flag as binary semaphore  */
-  unsigned char pulls;                /* number of pulls from queue */
   unsigned char n_privileged_threads; /* number of threads that always run high priority tasks */
+  size_t high_priority_weight;        /* high priority tasks run per low priority task by the others */
 } priority_queue;
 
+/* The circular array of a job deque. Replaced by an array twice its size when full, the arrays it
+ * replaced are kept until the deque is destroyed, since thieves may still read them */
+typedef struct job_array {
+  long size;                  /* power of 2                */
+  struct job_array* retired;  /* the array this one replaced */
+  job* jobs[];
+} job_array;
+
+/* Chase-Lev work stealing deque. Only its thread pushes and takes jobs, at the bottom, without
+ * locking. The other threads steal the oldest jobs, from the top */
+typedef struct job_deque {
+  long top;
+  long bottom;
+  job_array* array;
+} job_deque;
+
+/* Idle threads park on the sequence number, which every wake up bumps. A thread reads it before
+ * its last look for jobs, so that a job added after that look changes it and the thread does not
+ * sleep through the wake up */
+typedef struct parking_lot {
+  uint32_t seq;
+  uint32_t num_parked;
+#if !defined(__linux__)
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+} parking_lot;
+
 /* Thread */
 typedef struct thread {
   int id;                   /* friendly id               */
   pthread_t pthread;        /* pointer to actual thread  */
   struct redisearch_thpool_t* thpool_p; /* access to thpool          */
   LogFunc log;
+  job_deque deques[2];      /* the jobs added by the thread, by priority */
+  size_t pulls;             /* number of jobs taken by the thread */
 } thread;
 
 /* Threadpool */
@@ -94,13 +127,21 @@ typedef struct redisearch_thpool_t {
   pthread_mutex_t thcount_lock;     /* used for thread count etc */
   pthread_cond_t threads_all_idle;  /* signal to thpool_wait     */
   priority_queue jobqueue;          /* job queue                 */
+  size_t num_jobs_pending;          /* jobs in the queue and in the deques */
+  parking_lot parking;              /* where the idle threads wait for jobs */
+  thread_start_func thread_start;   /* run by every thread when it starts */
+  void* thread_start_arg;
 } redisearch_thpool_t;
 
+/* The thread of the pool running on the calling thread, if any */
+static __thread thread* current_thread;
+
 /* ========================== PROTOTYPES ============================ */
 
 static int thread_init(redisearch_thpool_t* thpool_p, struct thread** thread_p, int id, LogFunc log);
 static void* thread_do(struct thread* thread_p);
 static void thread_hold(int sig_id);
+static struct job* thread_take(struct thread* thread_p);
 static void thread_destroy(struct thread* thread_p);
 
 static int jobqueue_init(jobqueue* jobqueue_p);
@@ -110,17 +151,20 @@ static struct job* jobqueue_pull(jobqueue* jobqueue_p);
 static void jobqueue_destroy(jobqueue* jobqueue_p);
 
 static int priority_queue_init(priority_queue* priority_queue_p, size_t num_privileged_threads);
-static void priority_queue_clear(priority_queue* priority_queue_p);
 static void priority_queue_push_chain(priority_queue* priority_queue_p, struct job* first_newjob, struct job* last_newjob, size_t num, thpool_priority priority);
-static struct job* priority_queue_pull(priority_queue* priority_queue_p, int thread_id);
+static struct job* priority_queue_pull(priority_queue* priority_queue_p, thpool_priority priority);
 static void priority_queue_destroy(priority_queue* priority_queue_p);
-static size_t priority_queue_len(priority_queue* priority_queue_p);
 
-static void bsem_init(struct bsem* bsem_p, int value);
-static void bsem_reset(struct bsem* bsem_p);
-static void bsem_post(struct bsem* bsem_p);
-static void bsem_post_all(struct bsem* bsem_p);
-static void bsem_wait(struct bsem* bsem_p);
+static int job_deque_init(job_deque* deque_p);
+static void job_deque_push(job_deque* deque_p, struct job* job_p);
+static struct job* job_deque_take(job_deque* deque_p);
+static struct job* job_deque_steal(job_deque* deque_p);
+static void job_deque_destroy(job_deque* deque_p);
+
+static void parking_init(parking_lot* parking_p);
+static void parking_park(parking_lot* parking_p, redisearch_thpool_t* thpool_p);
+static void parking_unpark(parking_lot* parking_p, int n);
+static void parking_destroy(parking_lot* parking_p);
 
 /* ========================== THREADPOOL ============================ */
 
@@ -140,6 +184,9 @@ struct redisearch_thpool_t* redisearch_thpool_create(size_t num_threads, size_t
   thpool_p->num_threads_working = 0;
   thpool_p->keepalive = 0;
   thpool_p->terminate_when_empty = 0;
+  thpool_p->num_jobs_pending = 0;
+  thpool_p->thread_start = NULL;
+  thpool_p->thread_start_arg = NULL;
 
   /* Initialise the job queue */
   if (num_privileged_threads > num_threads) num_privileged_threads = num_threads;
@@ -159,20 +206,28 @@ struct redisearch_thpool_t* redisearch_thpool_create(size_t num_threads, size_t
   }
 
   for (size_t i = 0; i < num_threads; i++) {
-    thpool_p->threads[i] = (struct thread*)rm_malloc(sizeof(struct thread));
-    if (thpool_p->threads[i] == NULL) {
+    thread* thread_p = (struct thread*)rm_calloc(1, sizeof(struct thread));
+    if (thread_p == NULL || job_deque_init(&thread_p->deques[THPOOL_PRIORITY_HIGH]) == -1 ||
+        job_deque_init(&thread_p->deques[THPOOL_PRIORITY_LOW]) == -1) {
       err("thread_create(): Could not allocate memory for thread\n");
+      if (thread_p) thread_destroy(thread_p);
       priority_queue_destroy(&thpool_p->jobqueue);
       for (size_t j = 0; j < i; j++) {
-        rm_free(thpool_p->threads[j]);
+        thread_destroy(thpool_p->threads[j]);
       }
+      rm_free(thpool_p->threads);
       rm_free(thpool_p);
       return NULL;
     }
+    /* The id and the pool are set before the threads start, since thieves go over all the deques */
+    thread_p->id = i;
+    thread_p->thpool_p = thpool_p;
+    thpool_p->threads[i] = thread_p;
   }
 
   pthread_mutex_init(&(thpool_p->thcount_lock), NULL);
   pthread_cond_init(&thpool_p->threads_all_idle, NULL);
+  parking_init(&thpool_p->parking);
 
   return thpool_p;
 }
@@ -197,6 +252,26 @@ void redisearch_thpool_init(struct redisearch_thpool_t* thpool_p, LogFunc log) {
   }
 }
 
+/* Add a chain of jobs to the pool. Jobs added by a thread of the pool go to its own deque, where
+ * it takes them back without contending with the other threads unless they are idle and steal
+ * them. Jobs added by other threads go to the injection queue */
+static void thpool_push_chain(redisearch_thpool_t* thpool_p, job* first_newjob, job* last_newjob,
+                              size_t num, thpool_priority priority) {
+  thread* thread_p = current_thread;
+  if (thread_p && thread_p->thpool_p == thpool_p) {
+    job* job_p = first_newjob;
+    for (size_t i = 0; i < num; i++) {
+      job* next = job_p->prev;
+      job_deque_push(&thread_p->deques[priority], job_p);
+      job_p = next;
+    }
+  } else {
+    priority_queue_push_chain(&thpool_p->jobqueue, first_newjob, last_newjob, num, priority);
+  }
+  __atomic_add_fetch(&thpool_p->num_jobs_pending, num, __ATOMIC_SEQ_CST);
+  parking_unpark(&thpool_p->parking, num > INT_MAX ? INT_MAX : (int)num);
+}
+
 /* Add work to the thread pool */
 int redisearch_thpool_add_work(redisearch_thpool_t* thpool_p, void (*function_p)(void*), void* arg_p, thpool_priority priority) {
   job* newjob;
@@ -210,9 +285,10 @@ int redisearch_thpool_add_work(redisearch_thpool_t* thpool_p, void (*function_p)
   /* add function and argument */
   newjob->function = function_p;
   newjob->arg = arg_p;
+  newjob->prev = NULL;
 
   /* add job to queue */
-  priority_queue_push_chain(&thpool_p->jobqueue, newjob, newjob, 1, priority);
+  thpool_push_chain(thpool_p, newjob, newjob, 1, priority);
 
   return 0;
 }
@@ -243,7 +319,7 @@ int redisearch_thpool_add_n_work(redisearch_threadpool thpool_p, redisearch_thpo
   }
 
   /* add jobs to queue */
-  priority_queue_push_chain(&thpool_p->jobqueue, first_newjob, last_newjob, n_jobs, priority);
+  thpool_push_chain(thpool_p, first_newjob, last_newjob, n_jobs, priority);
 
   return 0;
 
@@ -257,10 +333,15 @@ fail:
   return -1;
 }
 
+static size_t thpool_num_jobs_pending(redisearch_thpool_t* thpool_p) {
+  return __atomic_load_n(&thpool_p->num_jobs_pending, __ATOMIC_SEQ_CST);
+}
+
 /* Wait until all jobs have finished */
 void redisearch_thpool_wait(redisearch_thpool_t* thpool_p) {
   pthread_mutex_lock(&thpool_p->thcount_lock);
-  while (priority_queue_len(&thpool_p->jobqueue) || thpool_p->num_threads_working) {
+  while (thpool_num_jobs_pending(thpool_p) ||
+         __atomic_load_n(&thpool_p->num_threads_working, __ATOMIC_SEQ_CST)) {
     pthread_cond_wait(&thpool_p->threads_all_idle, &thpool_p->thcount_lock);
   }
   pthread_mutex_unlock(&thpool_p->thcount_lock);
@@ -284,7 +365,7 @@ void redisearch_thpool_drain(redisearch_thpool_t* thpool_p, long timeout,
   }
 
   pthread_mutex_lock(&thpool_p->thcount_lock);
-  while (priority_queue_len(&thpool_p->jobqueue) > threshold) {
+  while (thpool_num_jobs_pending(thpool_p) > threshold) {
     int rc = pthread_cond_timedwait(&thpool_p->threads_all_idle, &thpool_p->thcount_lock, &time_spec);
     if (rc == ETIMEDOUT) {
       pthread_mutex_unlock(&thpool_p->thcount_lock);
@@ -319,18 +400,49 @@ void redisearch_thpool_terminate_threads(redisearch_thpool_t* thpool_p) {
   double tpassed = 0.0;
   time(&start);
   while (tpassed < TIMEOUT && thpool_p->num_threads_alive) {
-    bsem_post_all(thpool_p->jobqueue.has_jobs);
+    parking_unpark(&thpool_p->parking, INT_MAX);
     time(&end);
     tpassed = difftime(end, start);
   }
 
   /* Poll remaining threads */
   while (thpool_p->num_threads_alive) {
-    bsem_post_all(thpool_p->jobqueue.has_jobs);
+    parking_unpark(&thpool_p->parking, INT_MAX);
     sleep(1);
   }
 }
 
+void redisearch_thpool_set_high_priority_weight(redisearch_thpool_t* thpool_p, size_t weight) {
+  assert(thpool_p->keepalive == 0);
+  thpool_p->jobqueue.high_priority_weight = weight ? weight : 1;
+}
+
+void redisearch_thpool_set_thread_start(redisearch_thpool_t* thpool_p, thread_start_func start,
+                                        void* arg) {
+  assert(thpool_p->keepalive == 0);
+  thpool_p->thread_start = start;
+  thpool_p->thread_start_arg = arg;
+}
+
+uint64_t redisearch_thpool_thread_cpu_usec(redisearch_thpool_t* thpool_p, size_t thread_id) {
+  uint64_t usec = 0;
+  if (thread_id >= thpool_p->total_threads_count) {
+    return 0;
+  }
+  /* The threads only exit after leaving the count under the lock, so while all of them are
+   * counted none of them has exited */
+  pthread_mutex_lock(&thpool_p->thcount_lock);
+  clockid_t clock_id;
+  struct timespec ts;
+  if (thpool_p->num_threads_alive == thpool_p->total_threads_count &&
+      pthread_getcpuclockid(thpool_p->threads[thread_id]->pthread, &clock_id) == 0 &&
+      clock_gettime(clock_id, &ts) == 0) {
+    usec = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+  }
+  pthread_mutex_unlock(&thpool_p->thcount_lock);
+  return usec;
+}
+
 void redisearch_thpool_terminate_when_empty(redisearch_thpool_t* thpool_p) {
   thpool_p->terminate_when_empty = 1;
 }
@@ -350,6 +462,7 @@ void redisearch_thpool_destroy(redisearch_thpool_t* thpool_p) {
   for (n = 0; n < thpool_p->total_threads_count; n++) {
     thread_destroy(thpool_p->threads[n]);
   }
+  parking_destroy(&thpool_p->parking);
   rm_free(thpool_p->threads);
   rm_free(thpool_p);
 }
@@ -373,10 +486,7 @@ void redisearch_thpool_resume(redisearch_thpool_t* thpool_p) {
 }
 
 size_t redisearch_thpool_num_threads_working(redisearch_thpool_t* thpool_p) {
-  pthread_mutex_lock(&thpool_p->thcount_lock);
-  int res = thpool_p->num_threads_working;
-  pthread_mutex_unlock(&thpool_p->thcount_lock);
-  return res;
+  return __atomic_load_n(&thpool_p->num_threads_working, __ATOMIC_SEQ_CST);
 }
 
 /* ============================ THREAD ============================== */
@@ -407,6 +517,56 @@ static void thread_hold(int sig_id) {
   }
 }
 
+/* Steal a job of the given priority from the deques of the other threads */
+static struct job* thread_steal(struct thread* thread_p, thpool_priority priority) {
+  redisearch_thpool_t* thpool_p = thread_p->thpool_p;
+  size_t n = thpool_p->total_threads_count;
+  for (size_t i = 1; i < n; i++) {
+    thread* victim = thpool_p->threads[(thread_p->id + i) % n];
+    job* job_p;
+    while ((job_p = job_deque_steal(&victim->deques[priority])) == JOB_ABORT) {
+    }
+    if (job_p) {
+      return job_p;
+    }
+  }
+  return NULL;
+}
+
+/* Take the next job to run: from the deque of the thread, then from the injection queue, and
+ * then from the deques of the other threads. Every priority is looked for everywhere before the
+ * other one, so the priorities hold for stolen jobs as well. Privileged threads take high
+ * priority jobs first, the other threads take a low priority job after every <weight> high
+ * priority jobs */
+static struct job* thread_take(struct thread* thread_p) {
+  redisearch_thpool_t* thpool_p = thread_p->thpool_p;
+  int privileged = thread_p->id < thpool_p->jobqueue.n_privileged_threads;
+  thpool_priority first = THPOOL_PRIORITY_HIGH;
+  size_t weight = thpool_p->jobqueue.high_priority_weight;
+  if (!privileged && thread_p->pulls % (weight + 1) == weight) {
+    first = THPOOL_PRIORITY_LOW;
+  }
+  thpool_priority order[2] = {first, first == THPOOL_PRIORITY_HIGH ? THPOOL_PRIORITY_LOW
+                                                                   : THPOOL_PRIORITY_HIGH};
+  for (int i = 0; i < 2; i++) {
+    job* job_p = job_deque_take(&thread_p->deques[order[i]]);
+    if (!job_p) {
+      job_p = priority_queue_pull(&thpool_p->jobqueue, order[i]);
+    }
+    if (!job_p) {
+      job_p = thread_steal(thread_p, order[i]);
+    }
+    if (job_p) {
+      if (!privileged) {
+        thread_p->pulls++;
+      }
+      __atomic_sub_fetch(&thpool_p->num_jobs_pending, 1, __ATOMIC_SEQ_CST);
+      return job_p;
+    }
+  }
+  return NULL;
+}
+
 /* What each thread is doing
  *
  * In principle this is an endless loop. The only time this loop gets interuppted is once
@@ -432,6 +592,10 @@ static void* thread_do(struct thread* thread_p) {
 
   /* Assure all threads have been created before starting serving */
   redisearch_thpool_t* thpool_p = thread_p->thpool_p;
+  current_thread = thread_p;
+  if (thpool_p->thread_start) {
+    thpool_p->thread_start(thpool_p->thread_start_arg);
+  }
 
   /* Register signal handler */
   struct sigaction act;
@@ -449,37 +613,30 @@ static void* thread_do(struct thread* thread_p) {
 
   while (thpool_p->keepalive) {
 
-    bsem_wait(thpool_p->jobqueue.has_jobs);
+    /* The thread counts as working while it looks for jobs, so that the pool is never seen idle
+     * between the take of a job and its run */
+    __atomic_add_fetch(&thpool_p->num_threads_working, 1, __ATOMIC_SEQ_CST);
 
-    if (thpool_p->keepalive) {
-
-      pthread_mutex_lock(&thpool_p->thcount_lock);
-      thpool_p->num_threads_working++;
-      pthread_mutex_unlock(&thpool_p->thcount_lock);
-
-      /* Read job from queue and execute it */
-      void (*func_buff)(void*);
-      void* arg_buff;
-      job* job_p = priority_queue_pull(&thpool_p->jobqueue, thread_p->id);
-      if (job_p) {
-        func_buff = job_p->function;
-        arg_buff = job_p->arg;
-        func_buff(arg_buff);
-        rm_free(job_p);
-      }
+    /* Read jobs and execute them until there are none left */
+    job* job_p;
+    while (thpool_p->keepalive && (job_p = thread_take(thread_p))) {
+      job_p->function(job_p->arg);
+      rm_free(job_p);
+    }
 
+    if (__atomic_sub_fetch(&thpool_p->num_threads_working, 1, __ATOMIC_SEQ_CST) == 0) {
       pthread_mutex_lock(&thpool_p->thcount_lock);
-      thpool_p->num_threads_working--;
-      if (!thpool_p->num_threads_working) {
-        LOG_IF_EXISTS("debug", "thread pool contains no more jobs")
-        pthread_cond_signal(&thpool_p->threads_all_idle);
-        if (thpool_p->terminate_when_empty) {
-          LOG_IF_EXISTS("verbose", "terminating thread pool after there are no more jobs")
-          thpool_p->keepalive = 0;
-        }
+      LOG_IF_EXISTS("debug", "thread pool contains no more jobs")
+      pthread_cond_broadcast(&thpool_p->threads_all_idle);
+      if (thpool_p->terminate_when_empty && !thpool_num_jobs_pending(thpool_p)) {
+        LOG_IF_EXISTS("verbose", "terminating thread pool after there are no more jobs")
+        thpool_p->keepalive = 0;
+        parking_unpark(&thpool_p->parking, INT_MAX);
       }
       pthread_mutex_unlock(&thpool_p->thcount_lock);
     }
+
+    parking_park(&thpool_p->parking, thpool_p);
   }
   pthread_mutex_lock(&thpool_p->thcount_lock);
   thpool_p->num_threads_alive--;
@@ -488,8 +645,10 @@ static void* thread_do(struct thread* thread_p) {
   return NULL;
 }
 
-/* Frees a thread  */
+/* Frees a thread, along with the jobs left in its deques */
 static void thread_destroy(thread* thread_p) {
+  job_deque_destroy(&thread_p->deques[THPOOL_PRIORITY_HIGH]);
+  job_deque_destroy(&thread_p->deques[THPOOL_PRIORITY_LOW]);
   rm_free(thread_p);
 }
 
@@ -530,7 +689,8 @@ static void jobqueue_push_chain(jobqueue* jobqueue_p, struct job* first_newjob,
       jobqueue_p->rear->prev = first_newjob;
       jobqueue_p->rear = last_newjob;
   }
-  jobqueue_p->len += num;
+  /* the length is read without the lock, to skip over empty queues */
+  __atomic_store_n(&jobqueue_p->len, jobqueue_p->len + num, __ATOMIC_RELAXED);
 }
 
 /* Get first job from queue(removes it from queue)
@@ -548,13 +708,12 @@ static struct job* jobqueue_pull(jobqueue* jobqueue_p) {
     case 1: /* if one job in queue */
       jobqueue_p->front = NULL;
       jobqueue_p->rear = NULL;
-      jobqueue_p->len = 0;
+      __atomic_store_n(&jobqueue_p->len, 0, __ATOMIC_RELAXED);
       break;
 
     default: /* if >1 jobs in queue */
       jobqueue_p->front = job_p->prev;
-      jobqueue_p->len--;
-      /* more than one job in queue -> post it */
+      __atomic_store_n(&jobqueue_p->len, jobqueue_p->len - 1, __ATOMIC_RELAXED);
   }
 
   return job_p;
@@ -568,132 +727,198 @@ static void jobqueue_destroy(jobqueue* jobqueue_p) {
 /* ======================== PRIORITY QUEUE ========================== */
 
 static int priority_queue_init(priority_queue* priority_queue_p, size_t num_privileged_threads) {
-
-  priority_queue_p->has_jobs = (struct bsem*)rm_malloc(sizeof(struct bsem));
-  if (priority_queue_p->has_jobs == NULL) {
-    return -1;
-  }
   jobqueue_init(&priority_queue_p->high_priority_jobqueue);
   jobqueue_init(&priority_queue_p->low_priority_jobqueue);
-  bsem_init(priority_queue_p->has_jobs, 0);
   pthread_mutex_init(&priority_queue_p->jobqueues_rwmutex, NULL);
-  priority_queue_p->pulls = 0;
   priority_queue_p->n_privileged_threads = num_privileged_threads;
+  priority_queue_p->high_priority_weight = 1;
   return 0;
 }
 
-static void priority_queue_clear(priority_queue* priority_queue_p) {
-  jobqueue_clear(&priority_queue_p->high_priority_jobqueue);
-  jobqueue_clear(&priority_queue_p->low_priority_jobqueue);
-  bsem_reset(priority_queue_p->has_jobs);
+static jobqueue* priority_queue_get(priority_queue* priority_queue_p, thpool_priority priority) {
+  return priority == THPOOL_PRIORITY_HIGH ? &priority_queue_p->high_priority_jobqueue
+                                          : &priority_queue_p->low_priority_jobqueue;
 }
 
 static void priority_queue_push_chain(priority_queue* priority_queue_p, struct job* f_newjob_p, struct job* l_newjob_p, size_t n, thpool_priority priority) {
   pthread_mutex_lock(&priority_queue_p->jobqueues_rwmutex);
-  switch (priority) {
-    case THPOOL_PRIORITY_HIGH:
-      jobqueue_push_chain(&priority_queue_p->high_priority_jobqueue, f_newjob_p, l_newjob_p, n);
-      break;
-    case THPOOL_PRIORITY_LOW:
-      jobqueue_push_chain(&priority_queue_p->low_priority_jobqueue, f_newjob_p, l_newjob_p, n);
-      break;
-  }
-  bsem_post(priority_queue_p->has_jobs);
+  jobqueue_push_chain(priority_queue_get(priority_queue_p, priority), f_newjob_p, l_newjob_p, n);
   pthread_mutex_unlock(&priority_queue_p->jobqueues_rwmutex);
 }
 
-static struct job* priority_queue_pull(priority_queue* priority_queue_p, int thread_id) {
-  struct job* job_p = NULL;
-  pthread_mutex_lock(&priority_queue_p->jobqueues_rwmutex);
-
-  if (thread_id < priority_queue_p->n_privileged_threads) {
-    // This is a privileged thread id, try taking from the high priority queue.
-    job_p = jobqueue_pull(&priority_queue_p->high_priority_jobqueue);
-    // If the higher priority queue is empty, pull from the low priority queue.
-    if (!job_p) {
-      job_p = jobqueue_pull(&priority_queue_p->low_priority_jobqueue);
-    }
-  } else {
-    // For non-privileged threads, alternate between both queues every iteration.
-    if (priority_queue_p->pulls % 2 == 1) {
-      job_p = jobqueue_pull(&priority_queue_p->low_priority_jobqueue);
-      // If the lower priority queue is empty, pull from the higher priority queue
-      if (!job_p) {
-        job_p = jobqueue_pull(&priority_queue_p->high_priority_jobqueue);
-      }
-    } else {
-      job_p = jobqueue_pull(&priority_queue_p->high_priority_jobqueue);
-      // If the higher priority queue is empty, pull from the lower priority queue
-      if (!job_p) {
-        job_p = jobqueue_pull(&priority_queue_p->low_priority_jobqueue);
-      }
-    }
-    priority_queue_p->pulls++;
-  }
-  if (priority_queue_p->high_priority_jobqueue.len ||  priority_queue_p->low_priority_jobqueue.len) {
-    bsem_post(priority_queue_p->has_jobs);
+static struct job* priority_queue_pull(priority_queue* priority_queue_p, thpool_priority priority) {
+  jobqueue* jobqueue_p = priority_queue_get(priority_queue_p, priority);
+  // Looking for jobs does not contend on the lock of an empty queue
+  if (!__atomic_load_n(&jobqueue_p->len, __ATOMIC_RELAXED)) {
+    return NULL;
   }
+  pthread_mutex_lock(&priority_queue_p->jobqueues_rwmutex);
+  struct job* job_p = jobqueue_pull(jobqueue_p);
   pthread_mutex_unlock(&priority_queue_p->jobqueues_rwmutex);
-
   return job_p;
-
 }
 
 static void priority_queue_destroy(priority_queue* priority_queue_p) {
   jobqueue_destroy(&priority_queue_p->high_priority_jobqueue);
   jobqueue_destroy(&priority_queue_p->low_priority_jobqueue);
-  rm_free(priority_queue_p->has_jobs);
   pthread_mutex_destroy(&priority_queue_p->jobqueues_rwmutex);
 }
 
-static size_t priority_queue_len(priority_queue* priority_queue_p) {
-  size_t len;
-  pthread_mutex_lock(&priority_queue_p->jobqueues_rwmutex);
-  len = priority_queue_p->high_priority_jobqueue.len + priority_queue_p->low_priority_jobqueue.len;
-  pthread_mutex_unlock(&priority_queue_p->jobqueues_rwmutex);
-  return len;
-}
+/* ========================== JOB DEQUE ============================= */
 
-/* ======================== SYNCHRONISATION ========================= */
+static job_array* job_array_new(long size) {
+  job_array* array_p = (job_array*)rm_malloc(sizeof(job_array) + size * sizeof(job*));
+  if (array_p == NULL) {
+    return NULL;
+  }
+  array_p->size = size;
+  array_p->retired = NULL;
+  return array_p;
+}
+
+static int job_deque_init(job_deque* deque_p) {
+  deque_p->top = 0;
+  deque_p->bottom = 0;
+  deque_p->array = job_array_new(JOB_DEQUE_INITIAL_SIZE);
+  return deque_p->array ? 0 : -1;
+}
+
+/* Push a job at the bottom of the deque. Called by its thread only */
+static void job_deque_push(job_deque* deque_p, struct job* job_p) {
+  long b = __atomic_load_n(&deque_p->bottom, __ATOMIC_RELAXED);
+  long t = __atomic_load_n(&deque_p->top, __ATOMIC_ACQUIRE);
+  job_array* array_p = __atomic_load_n(&deque_p->array, __ATOMIC_RELAXED);
+  if (b - t > array_p->size - 1) {
+    job_array* grown = job_array_new(array_p->size * 2);
+    if (grown == NULL) {
+      err("job_deque_push(): Could not allocate memory for the job deque\n");
+      abort();
+    }
+    for (long i = t; i < b; i++) {
+      grown->jobs[i & (grown->size - 1)] =
+        __atomic_load_n(&array_p->jobs[i & (array_p->size - 1)], __ATOMIC_RELAXED);
+    }
+    grown->retired = array_p;
+    __atomic_store_n(&deque_p->array, grown, __ATOMIC_RELEASE);
+    array_p = grown;
+  }
+  __atomic_store_n(&array_p->jobs[b & (array_p->size - 1)], job_p, __ATOMIC_RELAXED);
+  __atomic_store_n(&deque_p->bottom, b + 1, __ATOMIC_RELEASE);
+}
+
+/* Take the newest job, from the bottom of the deque. Called by its thread only */
+static struct job* job_deque_take(job_deque* deque_p) {
+  long b = __atomic_load_n(&deque_p->bottom, __ATOMIC_RELAXED) - 1;
+  job_array* array_p = __atomic_load_n(&deque_p->array, __ATOMIC_RELAXED);
+  __atomic_store_n(&deque_p->bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long t = __atomic_load_n(&deque_p->top, __ATOMIC_RELAXED);
+  if (t > b) {
+    /* empty */
+    __atomic_store_n(&deque_p->bottom, b + 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+  job* job_p = __atomic_load_n(&array_p->jobs[b & (array_p->size - 1)], __ATOMIC_RELAXED);
+  if (t == b) {
+    /* the last job, which the thieves may race for */
+    if (!__atomic_compare_exchange_n(&deque_p->top, &t, t + 1, 0, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_RELAXED)) {
+      job_p = NULL;
+    }
+    __atomic_store_n(&deque_p->bottom, b + 1, __ATOMIC_RELAXED);
+  }
+  return job_p;
+}
 
-/* Init semaphore to 1 or 0 */
-static void bsem_init(bsem* bsem_p, int value) {
-  if (value < 0 || value > 1) {
-    err("bsem_init(): Binary semaphore can take only values 1 or 0");
-    exit(1);
+/* Steal the oldest job, from the top of the deque. Returns JOB_ABORT if another thread took it
+ * first */
+static struct job* job_deque_steal(job_deque* deque_p) {
+  long t = __atomic_load_n(&deque_p->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long b = __atomic_load_n(&deque_p->bottom, __ATOMIC_ACQUIRE);
+  if (t >= b) {
+    return NULL;
+  }
+  job_array* array_p = __atomic_load_n(&deque_p->array, __ATOMIC_ACQUIRE);
+  job* job_p = __atomic_load_n(&array_p->jobs[t & (array_p->size - 1)], __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&deque_p->top, &t, t + 1, 0, __ATOMIC_SEQ_CST,
+                                   __ATOMIC_RELAXED)) {
+    return JOB_ABORT;
   }
-  pthread_mutex_init(&(bsem_p->mutex), NULL);
-  pthread_cond_init(&(bsem_p->cond), NULL);
-  bsem_p->v = value;
+  return job_p;
 }
 
-/* Reset semaphore to 0 */
-static void bsem_reset(bsem* bsem_p) {
-  bsem_init(bsem_p, 0);
+/* Free the deque, along with the jobs left in it. Called once its thread is terminated */
+static void job_deque_destroy(job_deque* deque_p) {
+  job_array* array_p = deque_p->array;
+  if (array_p == NULL) {
+    return;
+  }
+  for (long i = deque_p->top; i < deque_p->bottom; i++) {
+    rm_free(array_p->jobs[i & (array_p->size - 1)]);
+  }
+  while (array_p) {
+    job_array* retired = array_p->retired;
+    rm_free(array_p);
+    array_p = retired;
+  }
+  deque_p->array = NULL;
 }
 
-/* Post to at least one thread */
-static void bsem_post(bsem* bsem_p) {
-  pthread_mutex_lock(&bsem_p->mutex);
-  bsem_p->v = 1;
-  pthread_cond_signal(&bsem_p->cond);
-  pthread_mutex_unlock(&bsem_p->mutex);
+/* ======================== SYNCHRONISATION ========================= */
+
+static void parking_init(parking_lot* parking_p) {
+  parking_p->seq = 0;
+  parking_p->num_parked = 0;
+#if !defined(__linux__)
+  pthread_mutex_init(&parking_p->mutex, NULL);
+  pthread_cond_init(&parking_p->cond, NULL);
+#endif
 }
 
-/* Post to all threads */
-static void bsem_post_all(bsem* bsem_p) {
-  pthread_mutex_lock(&bsem_p->mutex);
-  bsem_p->v = 1;
-  pthread_cond_broadcast(&bsem_p->cond);
-  pthread_mutex_unlock(&bsem_p->mutex);
+/* Sleep until jobs are added to the pool or it is terminated. Returns at once if there are jobs
+ * pending */
+static void parking_park(parking_lot* parking_p, redisearch_thpool_t* thpool_p) {
+  uint32_t seq = __atomic_load_n(&parking_p->seq, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&parking_p->num_parked, 1, __ATOMIC_SEQ_CST);
+  if (thpool_p->keepalive && !thpool_num_jobs_pending(thpool_p)) {
+#if defined(__linux__)
+    syscall(SYS_futex, &parking_p->seq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&parking_p->mutex);
+    while (__atomic_load_n(&parking_p->seq, __ATOMIC_SEQ_CST) == seq) {
+      pthread_cond_wait(&parking_p->cond, &parking_p->mutex);
+    }
+    pthread_mutex_unlock(&parking_p->mutex);
+#endif
+  }
+  __atomic_sub_fetch(&parking_p->num_parked, 1, __ATOMIC_SEQ_CST);
 }
 
-/* Wait on semaphore until semaphore has value 0 */
-static void bsem_wait(bsem* bsem_p) {
-  pthread_mutex_lock(&bsem_p->mutex);
-  while (bsem_p->v != 1) {
-    pthread_cond_wait(&bsem_p->cond, &bsem_p->mutex);
+/* Wake up to n parked threads. Costs no system call when no thread is parked */
+static void parking_unpark(parking_lot* parking_p, int n) {
+  __atomic_add_fetch(&parking_p->seq, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&parking_p->num_parked, __ATOMIC_SEQ_CST)) {
+    return;
+  }
+#if defined(__linux__)
+  syscall(SYS_futex, &parking_p->seq, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+  pthread_mutex_lock(&parking_p->mutex);
+  if (n == 1) {
+    pthread_cond_signal(&parking_p->cond);
+  } else {
+    pthread_cond_broadcast(&parking_p->cond);
   }
-  bsem_p->v = 0;
-  pthread_mutex_unlock(&bsem_p->mutex);
+  pthread_mutex_unlock(&parking_p->mutex);
+#endif
+}
+
+static void parking_destroy(parking_lot* parking_p) {
+#if !defined(__linux__)
+  pthread_mutex_destroy(&parking_p->mutex);
+  pthread_cond_destroy(&parking_p->cond);
+#else
+  (void)parking_p;
+#endif
 }
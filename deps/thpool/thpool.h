@@ -7,6 +7,7 @@
 #ifndef _THPOOL_
 #define _THPOOL_
 #include <stddef.h>
+#include <stdint.h>
 
 #define DEFAULT_PRIVILEGED_THREADS_NUM 1
 
@@ -59,6 +60,10 @@ void redisearch_thpool_init(redisearch_threadpool, LogFunc logCB);
 /**
  * @brief Add work to the job queue
  *
+ * Work added by one of the threads of the pool goes to the deque of that thread, which takes it
+ * back first, while idle threads steal it. This makes forking work from a job cheap. Work added
+ * by other threads goes to a shared queue.
+ *
  * Takes an action and its argument and adds it to the threadpool's job queue.
  * If you want to add to work a function with more than one arguments then
  * a way to implement this is by passing a pointer to a structure.
@@ -230,6 +235,27 @@ void redisearch_thpool_pause(redisearch_threadpool);
  */
 void redisearch_thpool_resume(redisearch_threadpool);
 
+/**
+ * @brief Set the number of high priority jobs the threads which are not privileged run for every
+ * low priority job, while there are jobs of both priorities (1 by default, alternating). Must be
+ * called before the threadpool is initialized.
+ */
+void redisearch_thpool_set_high_priority_weight(redisearch_threadpool, size_t weight);
+
+typedef void (*thread_start_func)(void *);
+
+/**
+ * @brief Set a function every thread of the pool runs when it starts, before it runs any job,
+ * e.g. to set its CPU affinity. Must be called before the threadpool is initialized.
+ */
+void redisearch_thpool_set_thread_start(redisearch_threadpool, thread_start_func start, void *arg);
+
+/**
+ * @brief The CPU time, in microseconds, consumed by a thread of the pool by its id (0 to
+ * num_threads - 1) since it started. 0 if the threads are not all running.
+ */
+uint64_t redisearch_thpool_thread_cpu_usec(redisearch_threadpool, size_t thread_id);
+
 /**
  * @brief Terminate the working threads (without deallocating the job queue and the thread objects).
  */
@@ -523,6 +523,18 @@ size_t TrieMap_MemUsage(TrieMap *t) {
                     sizeof(char *));         // == 8, string size rounded up to 8 bits due to padding
 }
 
+static size_t TrieMapNode_MemUsage(TrieMapNode *n) {
+  size_t size = __trieMapNode_Sizeof(n->numChildren, n->len);
+  for (tm_len_t i = 0; i < n->numChildren; i++) {
+    size += TrieMapNode_MemUsage(__trieMapNode_children(n)[i]);
+  }
+  return size;
+}
+
+size_t TrieMap_NodesMemUsage(TrieMap *t) {
+  return t->root ? TrieMapNode_MemUsage(t->root) : 0;
+}
+
 void TrieMapNode_Free(TrieMapNode *n, freeCB func) {
   for (tm_len_t i = 0; i < n->numChildren; i++) {
     TrieMapNode *child = __trieMapNode_children(n)[i];
@@ -838,6 +850,85 @@ void TrieMap_IterateRange(TrieMap *trie, const char *min, int minlen, bool inclu
   array_free(tmctx.buf);
 }
 
+int TrieMap_KeyCmp(const char *a, size_t na, const char *b, size_t nb) {
+  size_t minlen = MIN(na, nb);
+  for (size_t ii = 0; ii < minlen; ++ii) {
+    if (a[ii] != b[ii]) {
+      return a[ii] - b[ii];
+    }
+  }
+  return na < nb ? -1 : na > nb;
+}
+
+typedef struct {
+  char *buf;
+  TrieMapVisitCallback *callback;
+  void *cbctx;
+} TrieMapVisitCtx;
+
+/* Visit the keys of the subtree of a node. `prefix` is the rest of the prefix the keys must start
+ * with, and `after` the rest of the key they must be greater than, or NULL once they all are.
+ * Returns 0 if the callback stopped the iteration */
+static int TrieMapVisit(TrieMapNode *n, const char *prefix, int nprefix, const char *after,
+                        int nafter, TrieMapVisitCtx *r) {
+  int k = MIN(n->len, nprefix);
+  if (k && memcmp(n->str, prefix, k)) {
+    return 1;
+  }
+  prefix += k;
+  nprefix -= k;
+
+  if (after) {
+    int m = MIN(n->len, nafter);
+    int ii = 0;
+    while (ii < m && n->str[ii] == after[ii]) {
+      ++ii;
+    }
+    if (ii < m) {
+      if (n->str[ii] < after[ii]) {
+        // the whole subtree is smaller
+        return 1;
+      }
+      after = NULL;
+    } else if (n->len > nafter) {
+      // the string of the node extends the bound
+      after = NULL;
+    } else {
+      after += n->len;
+      nafter -= n->len;
+    }
+  }
+
+  r->buf = array_ensure_append(r->buf, n->str, n->len, char);
+  int rc = 1;
+  // a key equal to the bound or a prefix of it is not greater than it
+  if (!nprefix && !after && __trieMapNode_isTerminal(n) && !__trieMapNode_isDeleted(n)) {
+    rc = r->callback(r->buf, array_len(r->buf), r->cbctx, n->value);
+  }
+  if (after && !nafter) {
+    // the keys of the children extend the bound
+    after = NULL;
+  }
+
+  TrieMapNode **arr = __trieMapNode_children(n);
+  for (int ii = 0; rc && ii < n->numChildren; ++ii) {
+    rc = TrieMapVisit(arr[ii], prefix, nprefix, after, nafter, r);
+  }
+  array_trimm_len(r->buf, n->len);
+  return rc;
+}
+
+void TrieMap_IterateFrom(TrieMap *t, const char *prefix, tm_len_t prefixLen, const char *after,
+                         tm_len_t afterLen, TrieMapVisitCallback callback, void *ctx) {
+  TrieMapVisitCtx r = {
+      .buf = array_new(char, TRIE_INITIAL_STRING_LEN),
+      .callback = callback,
+      .cbctx = ctx,
+  };
+  TrieMapVisit(t->root, prefix, prefix ? prefixLen : 0, after, afterLen, &r);
+  array_free(r.buf);
+}
+
 int TrieMapIterator_Next(TrieMapIterator *it, char **ptr, tm_len_t *len, void **value) {
   while (array_len(it->stack) > 0) {
     if (TimedOut_WithCounter(&it->timeout, &it->timeoutCounter)) {
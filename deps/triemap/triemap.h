@@ -97,6 +97,10 @@ void TrieMap_Free(TrieMap *t, freeCB func);
 
 size_t TrieMap_MemUsage(TrieMap *t);
 
+/* The exact number of bytes allocated for the nodes of the trie, walking all of them. The values
+ * are not counted */
+size_t TrieMap_NodesMemUsage(TrieMap *t);
+
 /**************  Iterator API  - not ported from the textual trie yet
  * ***********/
 /* trie iterator stack node. for internal use only */
@@ -169,6 +173,18 @@ void TrieMap_IterateRange(TrieMap *trie, const char *min, int minlen, bool inclu
                           const char *max, int maxlen, bool includeMax,
                           TrieMapRangeCallback callback, void *ctx);
 
+/* Called on each key visited by TrieMap_IterateFrom, returning 0 to stop */
+typedef int(TrieMapVisitCallback)(const char *, size_t, void *ctx, void *value);
+
+/* Visit the keys starting with `prefix` and greater than `after` (all of them if it is NULL) in
+ * the order of the trie (see TrieMap_KeyCmp), until the callback returns 0. The keys not visited
+ * are skipped by subtrees, so that visiting a page of keys costs about the same wherever it is */
+void TrieMap_IterateFrom(TrieMap *t, const char *prefix, tm_len_t prefixLen, const char *after,
+                         tm_len_t afterLen, TrieMapVisitCallback callback, void *ctx);
+
+/* The order of the keys of a trie when iterated: by their bytes as chars, then shorter first */
+int TrieMap_KeyCmp(const char *a, size_t na, const char *b, size_t nb);
+
 void *TrieMap_RandomValueByPrefix(TrieMap *t, const char *prefix, tm_len_t pflen);
 
 #ifdef __cplusplus
@@ -83,16 +83,45 @@ typedef enum {
   // Compound values are returned serialized (RESP2 or HASH) or expanded (RESP3 w/JSON)
   QEXEC_FORMAT_DEFAULT = 0x100000,
 
+  /* The cursor reads its next chunk ahead on the workers, once the current one is replied */
+  QEXEC_F_CURSOR_PREFETCH = 0x200000,
+
+  /* Reply with the chunks of a cursor in the binary format of results_blob.h. Used by the
+   * coordinator, ignored when profiling */
+  QEXEC_F_BINARY_REPLY = 0x400000,
+
+  /* FT.SEARCH with a KNN clause over several vectors, concatenated in its vector parameter. Each
+   * vector is searched by a query of its own, all sharing the filter of the clause */
+  QEXEC_F_MULTI_VECTOR = 0x800000,
+
+  /* Sampled for FT.SLOWLOG: the iterators are profiled, so that the plan of the query has their
+   * actual results if it is slow */
+  QEXEC_F_SLOWLOG_PLAN = 0x1000000,
+
+  /* The cursor releases the state of its query while it is idle, keeping its remaining results
+   * packed or the point to resume its iterators from */
+  QEXEC_F_CURSOR_FREEZE = 0x2000000,
+
 } QEFlags;
 
 #define IsCount(r) ((r)->reqflags & QEXEC_F_NOROWS)
 #define IsSearch(r) ((r)->reqflags & QEXEC_F_IS_SEARCH)
 #define IsProfile(r) ((r)->reqflags & QEXEC_F_PROFILE)
+#define IsBinaryReply(r)                                                                   \
+  (((r)->reqflags & (QEXEC_F_BINARY_REPLY | QEXEC_F_IS_CURSOR | QEXEC_F_PROFILE)) ==       \
+   (QEXEC_F_BINARY_REPLY | QEXEC_F_IS_CURSOR))
 #define IsOptimized(r) ((r)->reqflags & QEXEC_OPTIMIZE)
 #define IsFormatExpand(r) ((r)->reqflags & QEXEC_FORMAT_EXPAND)
 #define IsWildcard(r) ((r)->ast.root->type == QN_WILDCARD)
 #define HasScorer(r) ((r)->optimizer->scorerType != SCORER_TYPE_NONE)
 
+// The largest number of partitions a query may be executed in (see PARALLEL)
+#define PARALLEL_MAX_PARTITIONS 64
+
+// The number of results each partition of a query executed in parallel is estimated to read at
+// least. Queries estimated to read fewer results are split to fewer partitions
+#define PARALLEL_PARTITION_MIN_RESULTS 10000
+
 #ifdef MT_BUILD
 // Indicates whether a query should run in the background. This
 // will also guarantee that there is a running thread pool with al least 1 thread.
@@ -102,6 +131,15 @@ typedef enum {
 typedef enum {
   /* Received EOF from iterator */
   QEXEC_S_ITERDONE = 0x02,
+
+  /* The reply holds partial results (timed out) or an error, and is not cached */
+  QEXEC_S_INCOMPLETE = 0x04,
+
+  /* The query timed out */
+  QEXEC_S_TIMEDOUT = 0x08,
+
+  /* The iterators of an idle cursor were freed, and are rebuilt by its next read */
+  QEXEC_S_FROZEN = 0x10,
 } QEStateFlags;
 
 typedef struct AREQ {
@@ -162,12 +200,17 @@ typedef struct AREQ {
   unsigned cursorMaxIdle;
   unsigned cursorChunkSize;
 
+  /** The number of partitions to execute the query in, if it is expensive enough */
+  unsigned parallelism;
+
 
-  /** Profile variables */
+  /** Profile variables, also measured for FT.SLOWLOG */
   hires_clock_t initClock;  // Time of start. Reset for each cursor call
   double totalTime;          // Total time. Used to accimulate cursors times
   double parseTime;          // Time for parsing the query
   double pipelineBuildTime;  // Time for creating the pipeline
+  double queueTime;          // Time waiting for a worker before the current read, for FT.INFO
+  double readTime;           // Time reading the results of the current read, for FT.INFO
 
   const char** requiredFields;
 
@@ -178,6 +221,14 @@ typedef struct AREQ {
   size_t maxSearchResults;
   size_t maxAggregateResults;
 
+  /** Result cache variables */
+  arrayof(char) resultCacheKey;  // The key of the reply in the index result cache, if cached
+  uint64_t resultsRevision;      // The revision of the index the query ran at
+
+  /** Set by the coordinator with _TRACE to trace the query over the shards, in which case the
+   * reply has the times of the query as well */
+  const char *traceId;
+
 } AREQ;
 
 /**
@@ -275,6 +326,14 @@ Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, siz
 
 void Grouper_Free(Grouper *g);
 
+struct TagIndex;
+/**
+ * Group the key at `idx` by the doc values of a tag field instead of the value in the source rows.
+ * The doc values code of each document identifies its group, so the key does not need to be
+ * loaded, and a grouper with only such keys hashes no values at all.
+ */
+void Grouper_SetDocValues(Grouper *g, size_t idx, const struct TagIndex *tidx);
+
 /**
  * Gets the result processor associated with the grouper.
  * This is used for building the query pipeline
@@ -287,7 +346,61 @@ ResultProcessor *Grouper_GetRP(Grouper *gr);
  */
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dst);
 
+/* Gets the reducer at `idx`, in the order the reducers were added */
+Reducer *Grouper_GetReducer(const Grouper *g, size_t idx);
+
+/* Whether all the reducers of the grouper can merge their groups (see Reducer::Merge) */
+bool Grouper_CanMerge(const Grouper *g);
+
+/**
+ * Sets the memory the groups may use before they are spilled to temporary files,
+ * partitioned by their hash value, and merged back one partition at a time once
+ * all the results were accumulated. 0 means no limit. Only takes effect if all
+ * the reducers can save and merge their groups, so it must be called after the
+ * reducers are added.
+ */
+void Grouper_SetMaxMemory(Grouper *g, size_t maxMemory);
+
+/**
+ * Keeps at most `maxGroups` groups, those with the most results, approximately (as
+ * the Space-Saving sketch): once there are that many, the half with the least
+ * results is evicted, and a new group counts its results from the largest count
+ * evicted. The reducers of a group created after an eviction only see the results
+ * that follow. 0 (the default) keeps all the groups. Groups kept this way are
+ * never spilled to disk.
+ */
+void Grouper_SetMaxGroups(Grouper *g, size_t maxGroups);
+
+/* The bytes of groups the processor of a grouper spilled to disk */
+size_t RPGrouper_SpilledBytes(const ResultProcessor *rp);
+
+/**
+ * Creates a grouper for a partition of a query executed in parallel, grouping by
+ * the same keys as `g`. Its processor accumulates all the results of the
+ * partition and returns none, and its groups are merged into those of `g` once
+ * added with @ref Grouper_AddPartial(). The reducers added to it must be
+ * equivalent to those of `g`, and added in the same order, to the same keys.
+ */
+Grouper *Grouper_NewPartial(const Grouper *g);
+
+/**
+ * Adds a partial grouper, whose groups are merged into those of `g` once its
+ * upstream processor is done. The partial groupers are merged in the order they
+ * are added, which should be the order of their partitions, and are owned by
+ * the chains of their partitions.
+ */
+void Grouper_AddPartial(Grouper *g, Grouper *partial);
+
 void AREQ_Execute(AREQ *req, RedisModuleCtx *outctx);
+
+/**
+ * Run a search (or an aggregate if not `search`) command on the calling thread, as on the workers,
+ * replying into `reply`, a recorded reply (see RedisModule_NewRecordedReply) of the thread safe
+ * context `ctx`. The index is looked up under the global lock, which must not be held. Used by the
+ * coordinator for the commands to the shard of its own process
+ */
+void AREQ_ExecuteRecorded(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, bool search,
+                          RedisModule_Reply *reply);
 int prepareExecutionPlan(AREQ *req, QueryError *status);
 void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit);
 void AREQ_Free(AREQ *req);
@@ -10,6 +10,7 @@
 #include "aggregate.h"
 #include "cursor.h"
 #include "rmutil/util.h"
+#include "rmutil/sds.h"
 #include "util/timeout.h"
 #include "util/workers.h"
 #include "score_explain.h"
@@ -17,6 +18,11 @@
 #include "profile.h"
 #include "query_optimizer.h"
 #include "resp3.h"
+#include "results_blob.h"
+#include "vector_index.h"
+#include "slow_log.h"
+#include "latency_stats.h"
+#include "alloc_stats.h"
 
 typedef enum { COMMAND_AGGREGATE, COMMAND_SEARCH, COMMAND_EXPLAIN } CommandType;
 
@@ -25,17 +31,23 @@ typedef struct {
   AREQ *req;
   RedisModuleBlockedClient *blockedClient;
   WeakRef spec_ref;
+  hires_clock_t queuedClock;
 } blockedClientReqCtx;
 
 static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num);
+#ifdef MT_BUILD
+static bool cursorPrefetches(const AREQ *req);
+static void cursorPrefetch(Cursor *cursor);
+#endif
 
 /**
  * Get the sorting key of the result. This will be the sorting key of the last
  * RLookup registry. Returns NULL if there is no sorting key
  */
 static const RSValue *getReplyKey(const RLookupKey *kk, const SearchResult *r) {
-  if ((kk->flags & RLOOKUP_F_SVSRC) && (r->rowdata.sv && r->rowdata.sv->len > kk->svidx)) {
-    return r->rowdata.sv->values[kk->svidx];
+  if ((kk->flags & RLOOKUP_F_SVSRC) && (r->rowdata.sv && r->rowdata.sv->len > kk->svidx) &&
+      RSSortingVector_Type(r->rowdata.sv, kk->svidx) != RS_SORTABLE_NUM) {
+    return RSSortingVector_Get(r->rowdata.sv, kk->svidx);
   } else {
     return RLookup_GetItem(kk, &r->rowdata);
   }
@@ -91,6 +103,30 @@ static void reeval_key(RedisModule_Reply *reply, const RSValue *key) {
   }
 }
 
+/**
+ * The value a field of a result is replied with. Duo values are replied with one of their values,
+ * depending on the format and on the API version
+ */
+static const RSValue *replyFieldValue(const AREQ *req, const RSValue *v, SendReplyFlags flags) {
+  if (v && v->t == RSValue_Duo) {
+    // Which value to use for duo value
+    if (!(flags & SENDREPLY_FLAG_EXPAND)) {
+      // STRING
+      if (req->sctx->apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST) {
+        // Multi
+        return RS_DUOVAL_OTHERVAL(*v);
+      } else {
+        // Single
+        return RS_DUOVAL_VAL(*v);
+      }
+    } else {
+      // EXPAND
+      return RS_DUOVAL_OTHER2VAL(*v);
+    }
+  }
+  return v;
+}
+
 static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchResult *r,
                               const cachedVars *cv) {
   const uint32_t options = req->reqflags;
@@ -208,7 +244,7 @@ static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchR
     memset(skipFieldIndex, 0, lk->rowlen * sizeof(*skipFieldIndex));
     size_t nfields = RLookup_GetLength(lk, &r->rowdata, skipFieldIndex, requiredFlags, excludeFlags, rule);
 
-    RedisModule_Reply_Map(reply);
+    RedisModule_Reply_MapOfSize(reply, nfields);
       int i = 0;
       for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
         if (!kk->name || !skipFieldIndex[i++]) {
@@ -222,24 +258,7 @@ static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchR
         SendReplyFlags flags = (req->reqflags & QEXEC_F_TYPED) ? SENDREPLY_FLAG_TYPED : 0;
         flags |= (req->reqflags & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
 
-        unsigned int apiVersion = req->sctx->apiVersion;
-        if (v && v->t == RSValue_Duo) {
-          // Which value to use for duo value
-          if (!(flags & SENDREPLY_FLAG_EXPAND)) {
-            // STRING
-            if (apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST) {
-              // Multi
-              v = RS_DUOVAL_OTHERVAL(*v);
-            } else {
-              // Single
-              v = RS_DUOVAL_VAL(*v);
-            }
-          } else {
-            // EXPAND
-            v = RS_DUOVAL_OTHER2VAL(*v);
-          }
-        }
-        RSValue_SendReply(reply, v, flags);
+        RSValue_SendReply(reply, replyFieldValue(req, v, flags), flags);
       }
     RedisModule_Reply_MapEnd(reply);
   }
@@ -256,6 +275,15 @@ _out:
   return RedisModule_Reply_LocalCount(reply) - count0;
 }
 
+// Read the next result, timing the read apart from the serialization of the results
+static inline int readResult(AREQ *req, ResultProcessor *rp, SearchResult *r) {
+  hires_clock_t start;
+  hires_clock_get(&start);
+  int rc = rp->Next(rp, r);
+  req->readTime += hires_clock_since_msec(&start);
+  return rc;
+}
+
 static size_t getResultsFactor(AREQ *req) {
   size_t count = 0;
 
@@ -292,10 +320,96 @@ static size_t getResultsFactor(AREQ *req) {
   return count;
 }
 
+/**
+ * Sends a chunk of <n> rows as a single blob in the format of results_blob.h, with the fields of
+ * the rows which serializeResult would send. If the query fails, the error is sent instead
+ */
+static void sendChunk_Binary(AREQ *req, RedisModule_Reply *reply, size_t limit) {
+  SearchResult r = {0};
+  int rc = RS_RESULT_OK;
+  ResultProcessor *rp = req->qiter.endProc;
+  const RLookup *lk = AGPLN_GetLookup(&req->ap, NULL, AGPLN_GETLOOKUP_LAST);
+  SendReplyFlags flags = (req->reqflags & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
+
+  // The columns are the fields which the rows are replied with when they have them
+  SchemaRule *rule = (req->sctx && req->sctx->spec) ? req->sctx->spec->rule : NULL;
+  int requiredFlags = (req->outFields.explicitReturn ? RLOOKUP_F_EXPLICITRETURN : 0);
+  const RLookupKey *keys[lk->rowlen];
+  const char *names[lk->rowlen];
+  size_t nameLens[lk->rowlen];
+  size_t ncols = 0;
+  if (!(req->reqflags & (QEXEC_F_SEND_NOFIELDS | QEXEC_F_NOROWS))) {
+    for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+      if (!kk->name || (kk->flags & RLOOKUP_F_HIDDEN) ||
+          (requiredFlags && !(kk->flags & requiredFlags))) {
+        continue;
+      }
+      if (rule && ((rule->lang_field && !strcmp(kk->name, rule->lang_field)) ||
+                   (rule->score_field && !strcmp(kk->name, rule->score_field)) ||
+                   (rule->payload_field && !strcmp(kk->name, rule->payload_field)))) {
+        continue;
+      }
+      keys[ncols] = kk;
+      names[ncols] = kk->name;
+      nameLens[ncols++] = kk->name_len;
+    }
+  }
+  ResultsBlobWriter w;
+  ResultsBlobWriter_Init(&w, names, nameLens, ncols);
+
+  // Set the chunk size limit for the query
+  rp->parent->resultLimit = limit;
+  while (rp->parent->resultLimit && (rc = readResult(req, rp, &r)) == RS_RESULT_OK) {
+    rp->parent->resultLimit--;
+    if (!(req->reqflags & QEXEC_F_NOROWS)) {
+      for (size_t ii = 0; ii < ncols; ++ii) {
+        const RSValue *v = RLookup_GetItem(keys[ii], &r.rowdata);
+        ResultsBlobWriter_Write(&w, ii, replyFieldValue(req, v, flags));
+      }
+      ResultsBlobWriter_EndRow(&w);
+    }
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+
+  if (IsOptimized(req)) {
+    QOptimizer_UpdateTotalResults(req);
+  }
+  if (rc == RS_RESULT_TIMEDOUT || rc == RS_RESULT_ERROR) {
+    req->stateflags |= QEXEC_S_INCOMPLETE;
+    if (rc == RS_RESULT_TIMEDOUT) {
+      req->stateflags |= QEXEC_S_TIMEDOUT;
+    }
+  }
+  if (rc != RS_RESULT_OK) {
+    req->stateflags |= QEXEC_S_ITERDONE;
+  }
+
+  if (rc == RS_RESULT_ERROR) {
+    RedisModule_Reply_Error(reply, QueryError_GetError(req->qiter.err));
+    QueryError_ClearError(req->qiter.err);
+  } else {
+    size_t len;
+    uint8_t blobFlags = (req->reqflags & QEXEC_FORMAT_EXPAND) ? RESULTS_BLOB_F_EXPAND : 0;
+    char *blob = ResultsBlobWriter_Finish(&w, req->qiter.totalResults, blobFlags, &len);
+    RedisModule_Reply_StringBuffer(reply, blob, len);
+    rm_free(blob);
+  }
+  ResultsBlobWriter_Free(&w);
+
+  // Reset the total results length:
+  req->qiter.totalResults = 0;
+}
+
 /**
  * Sends a chunk of <n> rows, optionally also sending the preamble
  */
 void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit) {
+  if (IsBinaryReply(req)) {
+    sendChunk_Binary(req, reply, limit);
+    return;
+  }
+
   size_t nelem = 0;
   SearchResult r = {0};
   int rc = RS_RESULT_EOF;
@@ -319,7 +433,13 @@ void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit) {
     RedisModule_ReplyKV_Array(reply, "attributes");
     RedisModule_Reply_ArrayEnd(reply);
 
-    rc = rp->Next(rp, &r);
+    rc = readResult(req, rp, &r);
+    if (rc == RS_RESULT_TIMEDOUT || rc == RS_RESULT_ERROR) {
+      req->stateflags |= QEXEC_S_INCOMPLETE;
+      if (rc == RS_RESULT_TIMEDOUT) {
+        req->stateflags |= QEXEC_S_TIMEDOUT;
+      }
+    }
     long resultsLen = REDISMODULE_POSTPONED_ARRAY_LEN;
     if (rc == RS_RESULT_TIMEDOUT && !(req->reqflags & QEXEC_F_IS_CURSOR) && !IsProfile(req) &&
         req->reqConfig.timeoutPolicy == TimeoutPolicy_Fail) {
@@ -387,7 +507,7 @@ void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit) {
       goto done_3;
     }
 
-    while (--rp->parent->resultLimit && (rc = rp->Next(rp, &r)) == RS_RESULT_OK) {
+    while (--rp->parent->resultLimit && (rc = readResult(req, rp, &r)) == RS_RESULT_OK) {
       if (!(req->reqflags & QEXEC_F_NOROWS)) {
         serializeResult(req, reply, &r, &cv);
         nelem++;
@@ -398,6 +518,12 @@ void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit) {
 
 done_3:
     SearchResult_Destroy(&r);
+    if (rc == RS_RESULT_TIMEDOUT || rc == RS_RESULT_ERROR) {
+      req->stateflags |= QEXEC_S_INCOMPLETE;
+      if (rc == RS_RESULT_TIMEDOUT) {
+        req->stateflags |= QEXEC_S_TIMEDOUT;
+      }
+    }
     if (rc != RS_RESULT_OK) {
       req->stateflags |= QEXEC_S_ITERDONE;
     }
@@ -409,7 +535,13 @@ done_3:
   //-------------------------------------------------------------------------------------------
   else // ! has_map (RESP2 variant)
   {
-    rc = rp->Next(rp, &r);
+    rc = readResult(req, rp, &r);
+    if (rc == RS_RESULT_TIMEDOUT || rc == RS_RESULT_ERROR) {
+      req->stateflags |= QEXEC_S_INCOMPLETE;
+      if (rc == RS_RESULT_TIMEDOUT) {
+        req->stateflags |= QEXEC_S_TIMEDOUT;
+      }
+    }
     long resultsLen = REDISMODULE_POSTPONED_ARRAY_LEN;
     if (rc == RS_RESULT_TIMEDOUT && !(req->reqflags & QEXEC_F_IS_CURSOR) && !IsProfile(req) &&
         req->reqConfig.timeoutPolicy == TimeoutPolicy_Fail) {
@@ -465,7 +597,7 @@ done_3:
       goto done_2;
     }
 
-    while (--rp->parent->resultLimit && (rc = rp->Next(rp, &r)) == RS_RESULT_OK) {
+    while (--rp->parent->resultLimit && (rc = readResult(req, rp, &r)) == RS_RESULT_OK) {
       if (!(req->reqflags & QEXEC_F_NOROWS)) {
         nelem += serializeResult(req, reply, &r, &cv);
       }
@@ -475,6 +607,12 @@ done_3:
 
   done_2:
     SearchResult_Destroy(&r);
+    if (rc == RS_RESULT_TIMEDOUT || rc == RS_RESULT_ERROR) {
+      req->stateflags |= QEXEC_S_INCOMPLETE;
+      if (rc == RS_RESULT_TIMEDOUT) {
+        req->stateflags |= QEXEC_S_TIMEDOUT;
+      }
+    }
     if (rc != RS_RESULT_OK) {
       req->stateflags |= QEXEC_S_ITERDONE;
     }
@@ -493,19 +631,116 @@ done_3:
   //-------------------------------------------------------------------------------------------
 }
 
-void AREQ_Execute(AREQ *req, RedisModuleCtx *ctx) {
-  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+/* Log the query to FT.SLOWLOG if it took at least its threshold, `totalTime` milliseconds in all.
+ * Called once the query ended, before it is freed */
+static void slowLogQuery(AREQ *req, double totalTime) {
+  if (IsProfile(req) || !req->sctx || !req->sctx->spec || !req->query ||
+      !SlowLog_IsSlow(totalTime)) {
+    return;
+  }
+  SlowLogEntry entry = {
+      .index = rm_strdup(req->sctx->spec->name),
+      .query = SlowLog_NormalizeQuery(req->query, strlen(req->query)),
+      .dialect = req->reqConfig.dialectVersion,
+      .parseTime = req->parseTime,
+      .pipelineTime = req->pipelineBuildTime,
+      .execTime = MAX(totalTime - req->parseTime - req->pipelineBuildTime, 0),
+      .totalTime = totalTime,
+      .numResults = req->qiter.totalResults,
+      .timedOut = !!(req->stateflags & QEXEC_S_TIMEDOUT),
+      .plan = Profile_CompactPlan(req->rootiter, SLOWLOG_PLAN_MAX_LEN),
+  };
+  SlowLog_Add(&entry);
+}
+
+/* Record the latencies of a read of the query to the stats of its index. `elapsed` is the time of
+ * the read since `initClock`, which includes the wait for a worker and the parsing if `withPlan` */
+static void recordLatency(AREQ *req, LatencyCommand cmd, double elapsed, bool withPlan) {
+  if (IsProfile(req) || !req->sctx || !req->sctx->spec) {
+    return;
+  }
+  double exec = req->readTime;
+  if (withPlan) {
+    // the parse time includes the wait for a worker
+    exec += req->parseTime - req->queueTime + req->pipelineBuildTime;
+    elapsed -= req->queueTime;
+  }
+  LatencyStats_RecordQuery(&req->sctx->spec->latency, cmd, req->queueTime, exec,
+                           MAX(elapsed - exec, 0));
+  req->queueTime = 0;
+  req->readTime = 0;
+}
+
+static inline LatencyCommand latencyCommand(const AREQ *req) {
+  return IsSearch(req) ? LATENCY_CMD_SEARCH : LATENCY_CMD_AGGREGATE;
+}
+
+/* Reply with the times of a query traced by the coordinator, once its results were sent: a "trace"
+ * map in RESP3, the second element of the reply in RESP2, as the profile */
+static void sendTrace(AREQ *req, RedisModule_Reply *reply) {
+  double total = hires_clock_since_msec(&req->initClock);
+  const char *node = RedisModule_GetMyClusterID ? RedisModule_GetMyClusterID() : NULL;
+  if (reply->resp3) {
+    RedisModule_ReplyKV_Map(reply, "trace");
+  } else {
+    RedisModule_Reply_Map(reply);
+  }
+    RedisModule_ReplyKV_SimpleString(reply, "id", req->traceId);
+    RedisModule_ReplyKV_SimpleString(reply, "node", node ? node : "-");
+    RedisModule_ReplyKV_Double(reply, "queue_time", req->queueTime);
+    RedisModule_ReplyKV_Double(reply, "parse_time", req->parseTime);
+    RedisModule_ReplyKV_Double(reply, "pipeline_time", req->pipelineBuildTime);
+    RedisModule_ReplyKV_Double(reply, "execution_time",
+                               MAX(total - req->parseTime - req->pipelineBuildTime, 0));
+    RedisModule_ReplyKV_Double(reply, "total_time", total);
+    RedisModule_ReplyKV_LongLong(reply, "results", req->qiter.totalResults);
+  RedisModule_Reply_MapEnd(reply);
+}
 
-  if (reply->resp3 || IsProfile(req)) {
+// Reply with all the results of a query, and its profile or trace
+static void sendResults(AREQ *req, RedisModule_Reply *reply) {
+  bool traced = req->traceId && !IsProfile(req);
+  if (reply->resp3 || IsProfile(req) || traced) {
     RedisModule_Reply_Map(reply);
   }
     sendChunk(req, reply, -1);
     if (IsProfile(req)) {
       Profile_Print(reply, req);
+    } else if (traced) {
+      sendTrace(req, reply);
     }
-  if (reply->resp3 || IsProfile(req)) {
+  if (reply->resp3 || IsProfile(req) || traced) {
     RedisModule_Reply_MapEnd(reply);
   }
+}
+
+// Reply with the results of a query, logging it as slow or measuring its latency
+static void sendResultsAndLog(AREQ *req, RedisModule_Reply *reply) {
+  sendResults(req, reply);
+  double elapsed = hires_clock_since_msec(&req->initClock);
+  slowLogQuery(req, elapsed);
+  recordLatency(req, latencyCommand(req), elapsed, true);
+}
+
+void AREQ_Execute(AREQ *req, RedisModuleCtx *ctx) {
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  if (req->resultCacheKey) {
+    RedisModule_Reply_Record(reply);
+  }
+
+  sendResultsAndLog(req, reply);
+
+  if (req->resultCacheKey) {
+    // a recording is dropped on an error
+    arrayof(char) recording = RedisModule_Reply_TakeRecording(reply);
+    if (recording && !(req->stateflags & QEXEC_S_INCOMPLETE)) {
+      ResultCache_Put(req->sctx->spec->resultCache, req->resultsRevision, req->resultCacheKey,
+                      array_len(req->resultCacheKey), recording,
+                      RSGlobalConfig.resultCacheMaxMemory, RSGlobalConfig.resultCacheTTL);
+    } else {
+      array_free(recording);
+    }
+  }
   RedisModule_EndReply(reply);
   AREQ_Free(req);
 }
@@ -516,6 +751,7 @@ static blockedClientReqCtx *blockedClientReqCtx_New(AREQ *req,
   ret->req = req;
   ret->blockedClient = blockedClient;
   ret->spec_ref = StrongRef_Demote(spec);
+  hires_clock_get(&ret->queuedClock);
   return ret;
 }
 
@@ -537,10 +773,25 @@ static void blockedClientReqCtx_destroy(blockedClientReqCtx *BCRctx) {
   rm_free(BCRctx);
 }
 
+// Lock the spec for a query run by the workers. An index evicted while the query was queued (see
+// LazyIndex) is loaded again first
+static void lockSpecForExecution(RedisSearchCtx *sctx, StrongRef execution_ref) {
+  for (;;) {
+    RedisSearchCtx_LockSpecRead(sctx);
+    if (LazyIndex_IsLoaded(sctx->spec)) {
+      return;
+    }
+    RedisSearchCtx_UnlockSpec(sctx);
+    LazyIndex_EnsureLoaded(execution_ref);
+  }
+}
+
 void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
   AREQ *req = blockedClientReqCtx_getRequest(BCRctx);
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
   RedisModuleCtx *outctx = RedisModule_GetThreadSafeContext(BCRctx->blockedClient);
   QueryError status = {0}, detailed_status = {0};
+  req->queueTime = hires_clock_since_msec(&BCRctx->queuedClock);
 
   StrongRef execution_ref = WeakRef_Promote(BCRctx->spec_ref);
   if (!StrongRef_Get(execution_ref)) {
@@ -550,6 +801,7 @@ void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
     QueryError_ReplyAndClear(outctx, &status);
     RedisModule_FreeThreadSafeContext(outctx);
     blockedClientReqCtx_destroy(BCRctx);
+    AllocStats_SetTag(prevTag);
     return;
   }
   // Cursors are created with a thread-safe context, so we don't want to replace it
@@ -558,7 +810,7 @@ void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
   }
 
   // lock spec
-  RedisSearchCtx_LockSpecRead(req->sctx);
+  lockSpecForExecution(req->sctx, execution_ref);
   if (prepareExecutionPlan(req, &status) != REDISMODULE_OK) {
     goto error;
   }
@@ -594,6 +846,7 @@ cleanup:
   RedisModule_FreeThreadSafeContext(outctx);
   StrongRef_Release(execution_ref);
   blockedClientReqCtx_destroy(BCRctx);
+  AllocStats_SetTag(prevTag);
 }
 
 // Assumes the spec is guarded (by its own lock for read or by the global lock)
@@ -610,6 +863,9 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
   updateTimeout(&req->timeoutTime, req->reqConfig.queryTimeoutMS);
   sctx->timeout = req->timeoutTime;
 
+  // The query runs at the current revision of the index, as it is locked
+  req->resultsRevision = IndexSpec_ResultsRevision(sctx->spec);
+
   ConcurrentSearchCtx_Init(sctx->redisCtx, &req->conc);
   req->rootiter = QAST_Iterate(ast, opts, sctx, &req->conc, req->reqflags, status);
 
@@ -626,21 +882,20 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
 
   if (IsProfile(req)) {
     // Add a Profile iterators before every iterator in the tree
-    Profile_AddIters(&req->rootiter);
+    Profile_AddIters(&req->rootiter, req->reqConfig.profileHwCounters);
+  } else if (req->reqflags & QEXEC_F_SLOWLOG_PLAN) {
+    // Count the results of the iterators, for the plan of the query in the slow log
+    Profile_AddIters(&req->rootiter, false);
   }
 
+  // The times are also measured out of FT.PROFILE, for the slow log
   hires_clock_t parseClock;
-  bool is_profile = IsProfile(req);
-  if (is_profile) {
-    hires_clock_get(&parseClock);
-    req->parseTime += hires_clock_diff_msec(&parseClock, &req->initClock);
-  }
+  hires_clock_get(&parseClock);
+  req->parseTime += hires_clock_diff_msec(&parseClock, &req->initClock);
 
   rc = AREQ_BuildPipeline(req, status);
 
-  if (is_profile) {
-    req->pipelineBuildTime = hires_clock_since_msec(&parseClock);
-  }
+  req->pipelineBuildTime = hires_clock_since_msec(&parseClock);
   return rc;
 }
 
@@ -679,6 +934,10 @@ static int buildRequest(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
     QueryError_SetErrorFmt(status, QUERY_ENOINDEX, "%s: no such index", indexname);
     goto done;
   }
+  if (IsProfile(*r)) {
+    // the profile reports how long the query held the spec lock
+    sctx->lockStats = &(*r)->conc.yield;
+  }
 
   rc = AREQ_ApplyContext(*r, sctx, status);
   thctx = NULL;
@@ -699,6 +958,69 @@ done:
   return rc;
 }
 
+void AREQ_ExecuteRecorded(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, bool search,
+                          RedisModule_Reply *reply) {
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
+  QueryError status = {0};
+  StrongRef execution_ref = {0};
+  AREQ *r = AREQ_New();
+
+  // The index is looked up under the global lock, as on the main thread, and the query runs under
+  // the lock of the spec only, as on the workers
+  RedisModule_ThreadSafeContextLock(ctx);
+  int rc = buildRequest(ctx, argv, argc, search ? COMMAND_SEARCH : COMMAND_AGGREGATE, &status, &r);
+  WeakRef spec_ref = {0};
+  if (rc == REDISMODULE_OK) {
+    SET_DIALECT(r->sctx->spec->used_dialects, r->reqConfig.dialectVersion);
+    SET_DIALECT(RSGlobalConfig.used_dialects, r->reqConfig.dialectVersion);
+    spec_ref = StrongRef_Demote(IndexSpec_GetStrongRefUnsafe(r->sctx->spec));
+  }
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  if (rc != REDISMODULE_OK) {
+    goto error;
+  }
+  if (r->reqflags & QEXEC_F_MULTI_VECTOR) {
+    QERR_MKBADARGS_FMT(&status, "MULTIVECTOR is not supported by a recorded reply");
+    WeakRef_Release(spec_ref);
+    goto error;
+  }
+  r->protocol = reply->resp3 ? 3 : 2;
+  r->reqflags |= QEXEC_F_RUN_IN_BACKGROUND;
+
+  execution_ref = WeakRef_Promote(spec_ref);
+  WeakRef_Release(spec_ref);
+  if (!StrongRef_Get(execution_ref)) {
+    QueryError_SetError(&status, QUERY_ENOINDEX, "The index was dropped before the query could be executed");
+    goto error;
+  }
+  lockSpecForExecution(r->sctx, execution_ref);
+  if (prepareExecutionPlan(r, &status) != REDISMODULE_OK) {
+    goto error;
+  }
+  if (r->reqflags & QEXEC_F_IS_CURSOR) {
+    if (AREQ_StartCursor(r, reply, execution_ref, &status, false) != REDISMODULE_OK) {
+      goto error;
+    }
+  } else {
+    sendResultsAndLog(r, reply);
+    AREQ_Free(r);
+  }
+  goto done;
+
+error:
+  if (r) {
+    AREQ_Free(r);
+  }
+  RedisModule_Reply_QueryError(reply, &status);
+  QueryError_ClearError(&status);
+
+done:
+  if (StrongRef_Get(execution_ref)) {
+    StrongRef_Release(execution_ref);
+  }
+  AllocStats_SetTag(prevTag);
+}
+
 #define NO_PROFILE 0
 #define PROFILE_FULL 1
 #define PROFILE_LIMITED 2
@@ -718,11 +1040,305 @@ static int parseProfile(AREQ *r, int withProfile, RedisModuleString **argv, int
     if (withProfile == PROFILE_LIMITED) {
       r->reqflags |= QEXEC_F_PROFILE_LIMITED;
     }
-    hires_clock_get(&r->initClock);
+  } else if (SlowLog_SamplePlan()) {
+    r->reqflags |= QEXEC_F_SLOWLOG_PLAN;
   }
   return REDISMODULE_OK;
 }
 
+#ifdef MT_BUILD
+// Cached replies of at least this many bytes are replayed by the workers
+#define RESULT_CACHE_WORKERS_REPLAY_MIN_SIZE (16 * 1024)
+
+typedef struct {
+  RedisModuleBlockedClient *bc;
+  arrayof(char) reply;
+} CachedReplyCtx;
+
+static void replayCachedReply_ctx(CachedReplyCtx *cr_ctx) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(cr_ctx->bc);
+  RedisModule_Reply_Replay(ctx, cr_ctx->reply, array_len(cr_ctx->reply));
+  RedisModule_FreeThreadSafeContext(ctx);
+  RedisModule_BlockedClientMeasureTimeEnd(cr_ctx->bc);
+  RedisModule_UnblockClient(cr_ctx->bc, NULL);
+  array_free(cr_ctx->reply);
+  rm_free(cr_ctx);
+}
+
+/* Reply with a copy of a cached reply. A large reply is serialized by a worker into the reply
+ * buffer of the blocked client, which the main thread then hands to the client as is, instead of
+ * serializing every row itself */
+static void replyWithCachedReply(RedisModuleCtx *ctx, arrayof(char) reply) {
+  if (array_len(reply) < RESULT_CACHE_WORKERS_REPLAY_MIN_SIZE) {
+    RedisModule_Reply_Replay(ctx, reply, array_len(reply));
+    array_free(reply);
+    return;
+  }
+  CachedReplyCtx *cr_ctx = rm_new(CachedReplyCtx);
+  cr_ctx->bc = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
+  cr_ctx->reply = reply;
+  RedisModule_BlockedClientMeasureTimeStart(cr_ctx->bc);
+  workersThreadPool_AddWork((redisearch_thpool_proc)replayCachedReply_ctx, cr_ctx);
+}
+#endif // MT_BUILD
+
+/**
+ * Reply to the query from the result cache of its index, if the index has one. Returns true if the
+ * reply was cached. Otherwise, sets `key` to the key to cache the reply with, if the index has a
+ * cache.
+ */
+static bool replyFromResultCache(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                 CommandType type, arrayof(char) *key) {
+  const char *indexname = RedisModule_StringPtrLen(argv[1], NULL);
+  // the use is counted once the query is either replied to or parsed
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = indexname},
+      .flags = INDEXSPEC_LOAD_NOCOUNTER | INDEXSPEC_LOAD_NOTIMERUPDATE | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  IndexSpec *sp = StrongRef_Get(IndexSpec_LoadUnsafeEx(ctx, &loadOpts));
+  if (!sp || !(sp->flags & Index_ResultCache) || !sp->resultCache ||
+      RSGlobalConfig.resultCacheTTL == 0) {
+    return false;
+  }
+
+  // the arguments of the query, following the index name
+  arrayof(char) k = ResultCache_NewKey(type, is_resp3(ctx) ? 3 : 2);
+  for (int i = 2; i < argc; ++i) {
+    size_t len;
+    const char *arg = RedisModule_StringPtrLen(argv[i], &len);
+    k = ResultCache_AppendKeyArg(k, arg, len);
+  }
+
+  uint64_t revision = IndexSpec_ResultsRevision(sp);
+  bool hit;
+#ifdef MT_BUILD
+  if (RunInThread() && !RedisModule_GetBlockedClientHandle(ctx)) {
+    arrayof(char) reply = ResultCache_Get(sp->resultCache, revision, k, array_len(k));
+    hit = reply != NULL;
+    if (hit) {
+      replyWithCachedReply(ctx, reply);
+    }
+  } else
+#endif
+  {
+    hit = ResultCache_Reply(sp->resultCache, revision, k, array_len(k), ctx);
+  }
+  if (hit) {
+    array_free(k);
+    IndexSpec_LoadUnsafe(ctx, indexname, 0);
+    return true;
+  }
+  *key = k;
+  return false;
+}
+
+// The most vectors a MULTIVECTOR query searches
+#define MULTI_VECTOR_MAX 1024
+
+// The KNN clause of a query, which is always the root of its tree
+static VectorQuery *getKnnQuery(const AREQ *req) {
+  QueryNode *root = req->ast.root;
+  if (!root || root->type != QN_VECTOR || root->vn.vq->type != VECSIM_QT_KNN) {
+    return NULL;
+  }
+  return root->vn.vq;
+}
+
+/**
+ * Split a MULTIVECTOR query into a query per vector of its KNN clause, all sharing the filter of the
+ * clause. The query is that of the first vector, the queries of the others are parsed again from
+ * the same arguments. Returns the queries, or NULL with an error set - the query is left for the
+ * caller to free.
+ */
+static arrayof(AREQ *) splitMultiVector(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                        AREQ *r, int withProfile, QueryError *status) {
+  if (!(r->reqflags & QEXEC_F_IS_SEARCH)) {
+    QERR_MKBADARGS_FMT(status, "MULTIVECTOR is only supported by FT.SEARCH");
+    return NULL;
+  }
+  if (withProfile != NO_PROFILE || (r->reqflags & QEXEC_F_IS_CURSOR)) {
+    QERR_MKBADARGS_FMT(status, "MULTIVECTOR is not supported with a profile or a cursor");
+    return NULL;
+  }
+  VectorQuery *vq = getKnnQuery(r);
+  const FieldSpec *fs =
+      vq ? IndexSpec_GetField(r->sctx->spec, vq->property, strlen(vq->property)) : NULL;
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    QERR_MKBADARGS_FMT(status, "MULTIVECTOR requires a KNN query over a vector field");
+    return NULL;
+  }
+  size_t blobSize = fs->vectorOpts.expBlobSize;
+  size_t n = blobSize ? vq->knn.vecLen / blobSize : 0;
+  if (!n || n > MULTI_VECTOR_MAX || vq->knn.vecLen % blobSize) {
+    QERR_MKBADARGS_FMT(status, "MULTIVECTOR expects 1 to %d vectors of %zu bytes each",
+                       MULTI_VECTOR_MAX, blobSize);
+    return NULL;
+  }
+
+  // The queries are not cached, nor is the array of their replies
+  if (r->resultCacheKey) {
+    array_free(r->resultCacheKey);
+    r->resultCacheKey = NULL;
+  }
+  SharedVectorFilter *filter =
+      QueryNode_NumChildren(r->ast.root) > 0 ? NewSharedVectorFilter() : NULL;
+  arrayof(AREQ *) reqs = array_new(AREQ *, n);
+  for (size_t i = 0; i < n; ++i) {
+    AREQ *req = r;
+    if (i > 0) {
+      req = AREQ_New();
+      if (buildRequest(ctx, argv, argc, COMMAND_SEARCH, status, &req) != REDISMODULE_OK) {
+        break;
+      }
+    }
+    // The vectors are concatenated in the parameter of the clause, which each query has a copy of
+    vq = getKnnQuery(req);
+    vq->knn.vector = (char *)vq->knn.vector + i * blobSize;
+    vq->knn.vecLen = blobSize;
+    if (filter) {
+      req->searchopts.vectorFilter = i > 0 ? SharedVectorFilter_Incref(filter) : filter;
+    }
+    array_append(reqs, req);
+  }
+
+  if (QueryError_HasError(status)) {
+    for (size_t i = 1; i < array_len(reqs); ++i) {
+      AREQ_Free(reqs[i]);
+    }
+    array_free(reqs);
+    return NULL;
+  }
+  return reqs;
+}
+
+// Reply with an array of the replies of the queries of every vector, in order
+static void execMultiVector(RedisModuleCtx *ctx, arrayof(AREQ *) reqs) {
+  RedisModule_ReplyWithArray(ctx, array_len(reqs));
+  for (size_t i = 0; i < array_len(reqs); ++i) {
+    AREQ *req = reqs[i];
+    QueryError status = {0};
+    RedisSearchCtx_LockSpecRead(req->sctx);
+    if (prepareExecutionPlan(req, &status) == REDISMODULE_OK) {
+      AREQ_Execute(req, ctx);
+    } else {
+      AREQ_Free(req);
+      QueryError_ReplyAndClear(ctx, &status);
+    }
+  }
+  array_free(reqs);
+}
+
+#ifdef MT_BUILD
+// The queries of the vectors of a MULTIVECTOR query, run concurrently by the workers
+typedef struct {
+  RedisModuleBlockedClient *blockedClient;
+  WeakRef spec_ref;
+  size_t n;
+  size_t pending;
+  AREQ **reqs;
+  RedisModuleCtx **ctxs;     // a detached context for every query
+  arrayof(char) *replies;    // the recorded reply of every query, NULL on an error
+  QueryError *errors;
+} multiVectorCtx;
+
+typedef struct {
+  multiVectorCtx *mv;
+  size_t i;
+} multiVectorJob;
+
+static void multiVectorCtx_Reply(multiVectorCtx *mv) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(mv->blockedClient);
+  RedisModule_ReplyWithArray(ctx, mv->n);
+  for (size_t i = 0; i < mv->n; ++i) {
+    if (mv->replies[i]) {
+      RedisModule_Reply_Replay(ctx, mv->replies[i], array_len(mv->replies[i]));
+      array_free(mv->replies[i]);
+    } else {
+      if (!QueryError_HasError(&mv->errors[i])) {
+        // the reply itself was an error, which is not recorded
+        QueryError_SetError(&mv->errors[i], QUERY_EGENERIC, NULL);
+      }
+      QueryError_ReplyAndClear(ctx, &mv->errors[i]);
+    }
+  }
+  RedisModule_FreeThreadSafeContext(ctx);
+  RedisModule_BlockedClientMeasureTimeEnd(mv->blockedClient);
+  RedisModule_UnblockClient(mv->blockedClient, NULL);
+  WeakRef_Release(mv->spec_ref);
+  rm_free(mv->reqs);
+  rm_free(mv->ctxs);
+  rm_free(mv->replies);
+  rm_free(mv->errors);
+  rm_free(mv);
+}
+
+// Run the query of a vector, recording its reply. The last query to end replies with them all
+static void multiVectorJob_Run(multiVectorJob *job) {
+  multiVectorCtx *mv = job->mv;
+  size_t i = job->i;
+  AREQ *req = mv->reqs[i];
+  QueryError *status = &mv->errors[i];
+
+  StrongRef execution_ref = WeakRef_Promote(mv->spec_ref);
+  if (!StrongRef_Get(execution_ref)) {
+    QueryError_SetError(status, QUERY_ENOINDEX,
+                        "The index was dropped before the query could be executed");
+  } else {
+    req->sctx->redisCtx = mv->ctxs[i];
+    lockSpecForExecution(req->sctx, execution_ref);
+    if (prepareExecutionPlan(req, status) == REDISMODULE_OK) {
+      // The detached context has no client to reply to, the reply is only recorded
+      RedisModule_Reply _reply = RedisModule_NewReply(mv->ctxs[i]), *reply = &_reply;
+      reply->resp3 = req->protocol == 3;
+      RedisModule_Reply_Record(reply);
+      sendResults(req, reply);
+      double elapsed = hires_clock_since_msec(&req->initClock);
+      slowLogQuery(req, elapsed);
+      recordLatency(req, latencyCommand(req), elapsed, true);
+      mv->replies[i] = RedisModule_Reply_TakeRecording(reply);
+      RedisModule_EndReply(reply);
+    }
+  }
+  AREQ_Free(req);
+  RedisModule_FreeThreadSafeContext(mv->ctxs[i]);
+  StrongRef_Release(execution_ref);
+  rm_free(job);
+
+  if (!__atomic_sub_fetch(&mv->pending, 1, __ATOMIC_ACQ_REL)) {
+    multiVectorCtx_Reply(mv);
+  }
+}
+
+// Run the queries of the vectors on the workers, replying once they all end
+static void execMultiVectorInThread(RedisModuleCtx *ctx, arrayof(AREQ *) reqs) {
+  size_t n = array_len(reqs);
+  StrongRef spec_ref = IndexSpec_GetStrongRefUnsafe(reqs[0]->sctx->spec);
+  multiVectorCtx *mv = rm_calloc(1, sizeof(*mv));
+  mv->blockedClient = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
+  RedisModule_BlockedClientMeasureTimeStart(mv->blockedClient);
+  mv->spec_ref = StrongRef_Demote(spec_ref);
+  mv->n = mv->pending = n;
+  mv->reqs = rm_malloc(n * sizeof(*mv->reqs));
+  memcpy(mv->reqs, reqs, n * sizeof(*mv->reqs));
+  mv->ctxs = rm_malloc(n * sizeof(*mv->ctxs));
+  mv->replies = rm_calloc(n, sizeof(*mv->replies));
+  mv->errors = rm_calloc(n, sizeof(*mv->errors));
+  for (size_t i = 0; i < n; ++i) {
+    mv->ctxs[i] = RedisModule_GetDetachedThreadSafeContext(ctx);
+    RedisModule_SelectDb(mv->ctxs[i], RedisModule_GetSelectedDb(ctx));
+    reqs[i]->reqflags |= QEXEC_F_RUN_IN_BACKGROUND;
+  }
+  array_free(reqs);
+
+  for (size_t i = 0; i < n; ++i) {
+    multiVectorJob *job = rm_new(multiVectorJob);
+    job->mv = mv;
+    job->i = i;
+    workersThreadPool_AddWork((redisearch_thpool_proc)multiVectorJob_Run, job);
+  }
+}
+#endif // MT_BUILD
+
 static int execCommandCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                              CommandType type, int withProfile) {
   // Index name is argv[1]
@@ -730,7 +1346,15 @@ static int execCommandCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
     return RedisModule_WrongArity(ctx);
   }
 
+  // A cached reply skips parsing and executing the query altogether
+  arrayof(char) resultCacheKey = NULL;
+  if (withProfile == NO_PROFILE &&
+      replyFromResultCache(ctx, argv, argc, type, &resultCacheKey)) {
+    return REDISMODULE_OK;
+  }
+
   AREQ *r = AREQ_New();
+  r->resultCacheKey = resultCacheKey;
   QueryError status = {0};
   if (parseProfile(r, withProfile, argv, argc, &status) != REDISMODULE_OK) {
     goto error;
@@ -746,8 +1370,44 @@ static int execCommandCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
   SET_DIALECT(r->sctx->spec->used_dialects, r->reqConfig.dialectVersion);
   SET_DIALECT(RSGlobalConfig.used_dialects, r->reqConfig.dialectVersion);
 
+  // The reply of a traced query has its times, it is not cached
+  if (r->traceId && r->resultCacheKey) {
+    array_free(r->resultCacheKey);
+    r->resultCacheKey = NULL;
+  }
+
+  if (r->reqflags & QEXEC_F_MULTI_VECTOR) {
+    arrayof(AREQ *) reqs = splitMultiVector(ctx, argv, argc, r, withProfile, &status);
+    if (!reqs) {
+      goto error;
+    }
+#ifdef MT_BUILD
+    if (RunInThread()) {
+      if (!workersThreadPool_AdmitQuery()) {
+        for (size_t i = 0; i < array_len(reqs); ++i) {
+          AREQ_Free(reqs[i]);
+        }
+        array_free(reqs);
+        r = NULL;
+        QueryError_SetError(&status, QUERY_EOVERLOAD, NULL);
+        goto error;
+      }
+      execMultiVectorInThread(ctx, reqs);
+    } else
+#endif // MT_BUILD
+    {
+      execMultiVector(ctx, reqs);
+    }
+    return REDISMODULE_OK;
+  }
+
 #ifdef MT_BUILD
   if (RunInThread()) {
+    // Shed the query rather than queue it behind too many others
+    if (!workersThreadPool_AdmitQuery()) {
+      QueryError_SetError(&status, QUERY_EOVERLOAD, NULL);
+      goto error;
+    }
     // Prepare context for the worker thread
     // Since we are still in the main thread, and we already validated the
     // spec'c existence, it is safe to directly get the strong reference from the spec
@@ -796,12 +1456,22 @@ error:
   return QueryError_ReplyAndClear(ctx, &status);
 }
 
+/* The allocations of the queries are counted to ALLOC_TAG_QUERY, unless they are run by the
+ * coordinator, which counts them to its own tag */
+static int execCommandTagged(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                             CommandType type, int withProfile) {
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
+  int rc = execCommandCommon(ctx, argv, argc, type, withProfile);
+  AllocStats_SetTag(prevTag);
+  return rc;
+}
+
 int RSAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-  return execCommandCommon(ctx, argv, argc, COMMAND_AGGREGATE, NO_PROFILE);
+  return execCommandTagged(ctx, argv, argc, COMMAND_AGGREGATE, NO_PROFILE);
 }
 
 int RSSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-  return execCommandCommon(ctx, argv, argc, COMMAND_SEARCH, NO_PROFILE);
+  return execCommandTagged(ctx, argv, argc, COMMAND_SEARCH, NO_PROFILE);
 }
 
 #define PROFILE_1ST_PARAM 2
@@ -849,15 +1519,46 @@ int RSProfileCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   int newArgc = argc - curArg + PROFILE_1ST_PARAM;
   RedisModuleString **newArgv = _profileArgsDup(argv, argc, curArg - PROFILE_1ST_PARAM);
-  execCommandCommon(ctx, newArgv, newArgc, cmdType, withProfile);
+  execCommandTagged(ctx, newArgv, newArgc, cmdType, withProfile);
   rm_free(newArgv);
   return REDISMODULE_OK;
 }
 
+static sds dumpPipeline(sds s, const ResultProcessor *rp) {
+  if (rp->upstream) {
+    s = dumpPipeline(s, rp->upstream);
+    s = sdscat(s, " -> ");
+  }
+  return sdscat(s, RPTypeToString(rp->type));
+}
+
+/* The physical plan of the query, as built but not executed: its iterators with their estimated
+ * results and the strategies chosen for them, the optimization chosen for it, and its result
+ * processors from the index on */
+static char *dumpPhysicalPlan(AREQ *r, const char *explain) {
+  sds s = sdsnew(explain);
+  char *iterators = Profile_DumpPlan(QITR_GetRootFilter(&r->qiter));
+  if (iterators) {
+    s = sdscatprintf(s, "ITERATORS:\n%s", iterators);
+    rm_free(iterators);
+  }
+  if (IsOptimized(r)) {
+    s = sdscatprintf(s, "OPTIMIZER: %s\n", QOptimizer_PrintType(r->optimizer));
+  }
+  s = sdscat(s, "PIPELINE: ");
+  s = dumpPipeline(s, r->qiter.endProc);
+  s = sdscat(s, "\n");
+  char *ret = rm_strndup(s, sdslen(s));
+  sdsfree(s);
+  return ret;
+}
+
 char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                          QueryError *status) {
+                          bool withPlan, QueryError *status) {
   AREQ *r = AREQ_New();
-  if (buildRequest(ctx, argv, argc, COMMAND_EXPLAIN, status, &r) != REDISMODULE_OK) {
+  // The plan is of the query as FT.SEARCH would execute it with the same arguments
+  int type = withPlan ? COMMAND_SEARCH : COMMAND_EXPLAIN;
+  if (buildRequest(ctx, argv, argc, type, status, &r) != REDISMODULE_OK) {
     return NULL;
   }
   if (prepareExecutionPlan(r, status) != REDISMODULE_OK) {
@@ -865,10 +1566,107 @@ char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
     return NULL;
   }
   char *ret = QAST_DumpExplain(&r->ast, r->sctx->spec);
+  if (withPlan && ret) {
+    char *plan = dumpPhysicalPlan(r, ret);
+    rm_free(ret);
+    ret = plan;
+  }
   AREQ_Free(r);
   return ret;
 }
 
+/* Whether the results of a cursor were all read by a processor of its chain which sorts or groups
+ * them, so that the remaining ones may be packed. The packed rows keep their docid, score and
+ * fields, but not their document */
+static bool cursorFreezesRows(const AREQ *req) {
+  if (req->reqflags & (QEXEC_F_IS_SEARCH | QEXEC_F_SEND_SORTKEYS | QEXEC_F_SEND_PAYLOADS |
+                       QEXEC_F_SEND_SCOREEXPLAIN)) {
+    return false;
+  }
+  for (const ResultProcessor *rp = req->qiter.endProc; rp; rp = rp->upstream) {
+    if (rp->type == RP_SORTER || rp->type == RP_GROUP) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Whether a cursor reads its results as its iterators yield them, through processors which hold
+ * no result between two reads, so that its iterators may be resumed from the last docid they read */
+static bool cursorFreezesIterators(const AREQ *req) {
+  const IndexIterator *root = req->rootiter;
+  if (IsOptimized(req) || req->ast.metricRequests || !root || root->mode != MODE_SORTED ||
+      root->type == HYBRID_ITERATOR || req->qiter.rootProc->type != RP_INDEX) {
+    return false;
+  }
+  for (const ResultProcessor *rp = req->qiter.endProc; rp != req->qiter.rootProc;
+       rp = rp->upstream) {
+    switch (rp->type) {
+      case RP_LOADER:
+      case RP_DOC_VALUES:
+      case RP_PROJECTOR:
+      case RP_FILTER:
+      case RP_PAGER_LIMITER:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Free the iterators of a request, along with the keys they reopen */
+static void freeRootIterator(AREQ *req) {
+  req->rootiter->Free(req->rootiter);
+  req->rootiter = NULL;
+  ConcurrentSearchCtx_Free(&req->conc);
+  ConcurrentSearchCtx_Init(req->sctx->redisCtx, &req->conc);
+}
+
+/* Release the state of a cursor going idle (see WITHCURSOR FREEZE). The remaining results are
+ * packed if they were all read by a sorter or a grouper, and the iterators are freed otherwise if
+ * the next read can resume them */
+static void cursorFreeze(AREQ *req) {
+  ResultProcessor *root = req->qiter.rootProc;
+  if (!(req->reqflags & QEXEC_F_CURSOR_FREEZE) || IsProfile(req) ||
+      (req->reqflags & QEXEC_F_SLOWLOG_PLAN) || root->type == RP_NETWORK) {
+    return;
+  }
+  if (root->type == RP_FROZEN) {
+    RPFrozen_Shrink(root);
+  } else if (cursorFreezesRows(req)) {
+    // the remaining results are read as the next reads would have
+    updateTimeout(&req->timeoutTime, req->reqConfig.queryTimeoutMS);
+    updateRPIndexTimeout(root, req->timeoutTime);
+    RPFrozen_Freeze(&req->qiter, AGPLN_GetLookup(&req->ap, NULL, AGPLN_GETLOOKUP_LAST));
+    if (req->rootiter) {
+      freeRootIterator(req);
+    }
+  } else if (cursorFreezesIterators(req)) {
+    RPIndexIterator_Resume(root, NULL);
+    freeRootIterator(req);
+    req->stateflags |= QEXEC_S_FROZEN;
+  }
+}
+
+/* Rebuild the iterators of a frozen cursor from its query, resuming after the last docid they
+ * read. The spec is left locked for the read */
+static int cursorThaw(AREQ *req, QueryError *status) {
+  RedisSearchCtx *sctx = req->sctx;
+  req->stateflags &= ~QEXEC_S_FROZEN;
+  updateTimeout(&req->timeoutTime, req->reqConfig.queryTimeoutMS);
+  sctx->timeout = req->timeoutTime;
+  RedisSearchCtx_LockSpecRead(sctx);
+  req->rootiter = QAST_Iterate(&req->ast, &req->searchopts, sctx, &req->conc, req->reqflags, status);
+  if (QueryError_HasError(status)) {
+    return REDISMODULE_ERR;
+  }
+  // the chains of the frozen cursors do not need the index results
+  IndexIterator_EnableDocIdsOnly(req->rootiter);
+  RPIndexIterator_Resume(req->qiter.rootProc, req->rootiter);
+  return REDISMODULE_OK;
+}
+
 // Assumes that the cursor has a strong ref to the relevant spec and that it is already locked.
 int AREQ_StartCursor(AREQ *r, RedisModule_Reply *reply, StrongRef spec_ref, QueryError *err, bool coord) {
   Cursor *cursor = Cursors_Reserve(getCursorList(coord), spec_ref, r->cursorMaxIdle, err);
@@ -884,14 +1682,15 @@ int AREQ_StartCursor(AREQ *r, RedisModule_Reply *reply, StrongRef spec_ref, Quer
 static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num) {
   AREQ *req = cursor->execState;
   bool has_map = RedisModule_HasMap(reply);
+  bool firstRead = req->totalTime == 0;
 
-  // reset profile clock for cursor reads except for 1st
-  if (IsProfile(req) && req->totalTime != 0) {
+  // reset the clock for cursor reads except for 1st, the time between the reads is not counted
+  if (!firstRead) {
     hires_clock_get(&req->initClock);
   }
 
   // update timeout for current cursor read
-  if (req->qiter.rootProc->type != RP_NETWORK) {
+  if (req->qiter.rootProc->type == RP_INDEX) {
     updateTimeout(&req->timeoutTime, req->reqConfig.queryTimeoutMS);
     updateRPIndexTimeout(req->qiter.rootProc, req->timeoutTime);
   }
@@ -903,7 +1702,8 @@ static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num) {
   }
   req->cursorChunkSize = num;
 
-  if (has_map) // RESP3
+  // A binary chunk is a single string, replied with the cursor ID alike for RESP2 and RESP3
+  if (has_map && !IsBinaryReply(req)) // RESP3
   {
     RedisModule_Reply_Array(reply);
     RedisModule_Reply_Map(reply);
@@ -945,19 +1745,33 @@ static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num) {
     RedisModule_Reply_ArrayEnd(reply);
   }
 
+  double elapsed = hires_clock_since_msec(&req->initClock);
+  if (!IsProfile(req)) {
+    req->totalTime += elapsed;
+  }
+  // the first read is counted as the query which created the cursor
+  recordLatency(req, firstRead ? latencyCommand(req) : LATENCY_CMD_CURSOR_READ, elapsed, firstRead);
   if (req->stateflags & QEXEC_S_ITERDONE) {
+    slowLogQuery(req, req->totalTime);
     AREQ_Free(req);
     cursor->execState = NULL;
     Cursor_Free(cursor);
-  } else {
+  }
+#ifdef MT_BUILD
+  else if (cursorPrefetches(req)) {
+    // Paused once the next chunk is read
+    cursorPrefetch(cursor);
+  }
+#endif
+  else {
+    cursorFreeze(req);
     // Update the idle timeout
     Cursor_Pause(cursor);
   }
 }
 
-static void cursorRead(RedisModule_Reply *reply, uint64_t cid, size_t count) {
-  Cursor *cursor = Cursors_TakeForExecution(GetGlobalCursor(cid), cid);
-
+// Read the next chunk of a cursor taken for execution, replying that it was not found if it is NULL
+static void readCursor(RedisModule_Reply *reply, Cursor *cursor, size_t count) {
   if (cursor == NULL) {
     RedisModule_Reply_Error(reply, "Cursor not found");
     return;
@@ -982,22 +1796,43 @@ static void cursorRead(RedisModule_Reply *reply, uint64_t cid, size_t count) {
   AREQ *req = cursor->execState;
   req->qiter.err = &status;
 
-  runCursor(reply, cursor, count);
+  if ((req->stateflags & QEXEC_S_FROZEN) && cursorThaw(req, &status) != REDISMODULE_OK) {
+    RedisModule_Reply_Error(reply, QueryError_GetError(&status));
+    QueryError_ClearError(&status);
+    AREQ_Free(req);
+    cursor->execState = NULL;
+    Cursor_Free(cursor);
+  } else {
+    runCursor(reply, cursor, count);
+  }
   if (has_spec) {
     StrongRef_Release(execution_ref);
   }
 }
 
+static void cursorRead(RedisModule_Reply *reply, uint64_t cid, size_t count) {
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
+  readCursor(reply, Cursors_TakeForExecution(GetGlobalCursor(cid), cid), count);
+  AllocStats_SetTag(prevTag);
+}
+
+#ifdef MT_BUILD
 typedef struct {
   RedisModuleBlockedClient *bc;
   uint64_t cid;
   size_t count;
+  hires_clock_t queuedClock;
 } CursorReadCtx;
 
-static void cursorRead_ctx(CursorReadCtx *cr_ctx) {
+static void cursorReadReply(CursorReadCtx *cr_ctx, Cursor *cursor) {
+  if (cursor && cursor->execState) {
+    ((AREQ *)cursor->execState)->queueTime = hires_clock_since_msec(&cr_ctx->queuedClock);
+  }
   RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(cr_ctx->bc);
   RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
-  cursorRead(reply, cr_ctx->cid, cr_ctx->count);
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
+  readCursor(reply, cursor, cr_ctx->count);
+  AllocStats_SetTag(prevTag);
   RedisModule_EndReply(reply);
   RedisModule_FreeThreadSafeContext(ctx);
   RedisModule_BlockedClientMeasureTimeEnd(cr_ctx->bc);
@@ -1005,6 +1840,49 @@ static void cursorRead_ctx(CursorReadCtx *cr_ctx) {
   rm_free(cr_ctx);
 }
 
+static void cursorRead_ctx(CursorReadCtx *cr_ctx) {
+  bool queued;
+  Cursor *cursor = Cursors_TakeForRead(GetGlobalCursor(cr_ctx->cid), cr_ctx->cid, cr_ctx, &queued);
+  // A read queued on a prefetching cursor is served by the prefetch once it is done
+  if (!queued) {
+    cursorReadReply(cr_ctx, cursor);
+  }
+}
+
+// Prefetching needs the workers, and the pipeline to end with the buffer the chunk is read into
+static bool cursorPrefetches(const AREQ *req) {
+  return (req->reqflags & QEXEC_F_CURSOR_PREFETCH) && RunInThread() &&
+         req->qiter.endProc->type == RP_PREFETCH;
+}
+
+static void cursorPrefetch_job(Cursor *cursor) {
+  AREQ *req = cursor->execState;
+  StrongRef execution_ref = WeakRef_Promote(cursor->spec_ref);
+  // Nothing is read if the index was dropped, the next read finds out
+  if (StrongRef_Get(execution_ref)) {
+    updateTimeout(&req->timeoutTime, req->reqConfig.queryTimeoutMS);
+    updateRPIndexTimeout(req->qiter.rootProc, req->timeoutTime);
+    AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_QUERY);
+    RPPrefetch_Fill(req->qiter.endProc, req->cursorChunkSize);
+    AllocStats_SetTag(prevTag);
+    StrongRef_Release(execution_ref);
+  }
+
+  CursorReadCtx *cr_ctx;
+  cursor = Cursor_EndPrefetch(cursor, (void **)&cr_ctx);
+  if (cr_ctx) {
+    cursorReadReply(cr_ctx, cursor);
+  }
+}
+
+/* Read the next chunk of the cursor on the workers, while the client processes the chunk just
+ * replied. The cursor stays taken until it is read, and a read arriving meanwhile waits for it */
+static void cursorPrefetch(Cursor *cursor) {
+  Cursor_StartPrefetch(cursor);
+  workersThreadPool_AddWork((redisearch_thpool_proc)cursorPrefetch_job, cursor);
+}
+#endif
+
 /**
  * FT.CURSOR READ {index} {CID} {COUNT} [MAXIDLE]
  * FT.CURSOR DEL {index} {CID}
@@ -1043,10 +1921,15 @@ int RSCursorCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 #ifdef MT_BUILD
     // We have to check that we are not blocked yet from elsewhere (e.g. coordinator)
     if (RunInThread() && !RedisModule_GetBlockedClientHandle(ctx)) {
+      if (!workersThreadPool_AdmitQuery()) {
+        RedisModule_ReplyWithError(ctx, QueryError_Strerror(QUERY_EOVERLOAD));
+        return REDISMODULE_OK;
+      }
       CursorReadCtx *cr_ctx = rm_new(CursorReadCtx);
       cr_ctx->bc = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
       cr_ctx->cid = cid;
       cr_ctx->count = count;
+      hires_clock_get(&cr_ctx->queuedClock);
       RedisModule_BlockedClientMeasureTimeStart(cr_ctx->bc);
       workersThreadPool_AddWork((redisearch_thpool_proc)cursorRead_ctx, cr_ctx);
     } else
@@ -155,6 +155,25 @@ PLN_ArrangeStep *AGPLN_AddKNNArrangeStep(AGGPlan *pln, size_t k, const char *dis
   return newStp;
 }
 
+const PLN_ArrangeStep *PLNGroupStep_GetTopCountArrange(const AGGPlan *pln,
+                                                       const PLN_GroupStep *gstp) {
+  const PLN_BaseStep *next = PLN_NEXT_STEP(&gstp->base);
+  if (&next->llnodePln == &pln->steps || next->type != PLN_T_ARRANGE) {
+    return NULL;
+  }
+  const PLN_ArrangeStep *astp = (const PLN_ArrangeStep *)next;
+  if (array_len(astp->sortKeys) != 1 || SORTASCMAP_GETASC(astp->sortAscMap, 0)) {
+    return NULL;
+  }
+  for (size_t ii = 0; ii < array_len(gstp->reducers); ++ii) {
+    const PLN_Reducer *r = gstp->reducers + ii;
+    if (!strcasecmp(r->name, "COUNT") && !strcmp(r->alias, astp->sortKeys[0])) {
+      return astp;
+    }
+  }
+  return NULL;
+}
+
 PLN_ArrangeStep *AGPLN_GetOrCreateArrangeStep(AGGPlan *pln) {
   PLN_ArrangeStep *ret = AGPLN_GetArrangeStep(pln);
   if (ret) {
@@ -86,6 +86,7 @@ typedef struct {
   RSExpr *parsedExpr;
   bool shouldFreeRaw;  // Whether we own the raw expression, used on coordinator only
   bool noOverride;     // Whether we should override the alias if it exists. We allow it by default
+  const RLookupKey *dstkey;  // The key an APPLY writes to, once its result processor is built
 } PLN_MapFilterStep;
 
 /** ARRANGE covers sort, limit, and so on */
@@ -158,6 +159,14 @@ typedef struct PLN_Reducer PLN_Reducer;
  */
 PLN_Reducer *PLNGroupStep_FindReducer(PLN_GroupStep *gstp, const char *name, ArgsCursor *ac);
 
+/**
+ * Get the arrange step right after a group step, if it only keeps the groups
+ * with the most results, i.e. it sorts by the output of a COUNT reducer of the
+ * group step in descending order, and nothing else. Returns NULL otherwise.
+ */
+const PLN_ArrangeStep *PLNGroupStep_GetTopCountArrange(const AGGPlan *pln,
+                                                       const PLN_GroupStep *gstp);
+
 /* A plan is a linked list of all steps */
 struct AGGPlan {
   DLLIST steps;
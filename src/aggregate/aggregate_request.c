@@ -19,6 +19,9 @@
 #include "util/timeout.h"
 #include "query_optimizer.h"
 #include "resp3.h"
+#include "tag_index.h"
+#include "vector_index.h"
+#include "aggregate/expr/exprprog.h"
 
 extern RSConfig RSGlobalConfig;
 
@@ -109,6 +112,8 @@ static int parseCursorSettings(AREQ *req, ArgsCursor *ac, QueryError *status) {
                         .type = AC_ARGTYPE_UINT,
                         .target = &req->cursorChunkSize,
                         .intflags = AC_F_GE1},
+                       {AC_MKBITFLAG("PREFETCH", &req->reqflags, QEXEC_F_CURSOR_PREFETCH)},
+                       {AC_MKBITFLAG("FREEZE", &req->reqflags, QEXEC_F_CURSOR_FREEZE)},
                        {NULL}};
 
   int rv;
@@ -282,12 +287,33 @@ static int handleCommonArgs(AREQ *req, ArgsCursor *ac, QueryError *status, int a
       QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "TIMEOUT requires a non negative integer");
       return ARG_ERROR;
     }
+  } else if (AC_AdvanceIfMatch(ac, "PARALLEL")) {
+    if (AC_GetUnsigned(ac, &req->parallelism, AC_F_GE1) != AC_OK ||
+        req->parallelism > PARALLEL_MAX_PARTITIONS) {
+      QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                             "PARALLEL requires an integer between 1 and %d",
+                             PARALLEL_MAX_PARTITIONS);
+      return ARG_ERROR;
+    }
+  } else if (AC_AdvanceIfMatch(ac, "SLOT")) {
+    // Only the coordinator routes the query by the hash tag
+    if (AC_AdvanceBy(ac, 1) != AC_OK) {
+      QueryError_SetError(status, QUERY_EPARSEARGS, "SLOT requires a hash tag");
+      return ARG_ERROR;
+    }
   } else if (AC_AdvanceIfMatch(ac, "WITHCURSOR")) {
     if (parseCursorSettings(req, ac, status) != REDISMODULE_OK) {
       return ARG_ERROR;
     }
   } else if (AC_AdvanceIfMatch(ac, "_NUM_SSTRING")) {
     req->reqflags |= QEXEC_F_TYPED;
+  } else if (AC_AdvanceIfMatch(ac, "_BINARY")) {
+    req->reqflags |= QEXEC_F_BINARY_REPLY;
+  } else if (AC_AdvanceIfMatch(ac, "_TRACE")) {
+    if (AC_GetString(ac, &req->traceId, NULL, 0) != AC_OK) {
+      QueryError_SetError(status, QUERY_EPARSEARGS, "_TRACE requires a trace id");
+      return ARG_ERROR;
+    }
   } else if (AC_AdvanceIfMatch(ac, "WITHRAWIDS")) {
     req->reqflags |= QEXEC_F_SENDRAWIDS;
   } else if (AC_AdvanceIfMatch(ac, "PARAMS")) {
@@ -471,6 +497,7 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       {AC_MKBITFLAG("NOCONTENT", &req->reqflags, QEXEC_F_SEND_NOFIELDS)},
       {AC_MKBITFLAG("NOSTOPWORDS", &searchOpts->flags, Search_NoStopwrods)},
       {AC_MKBITFLAG("EXPLAINSCORE", &req->reqflags, QEXEC_F_SEND_SCOREEXPLAIN)},
+      {AC_MKBITFLAG("MULTIVECTOR", &req->reqflags, QEXEC_F_MULTI_VECTOR)},
       {.name = "PAYLOAD",
        .type = AC_ARGTYPE_STRING,
        .target = &req->ast.udata,
@@ -837,6 +864,7 @@ AREQ *AREQ_New(void) {
   int printProfileClock;
   */
   req->reqConfig = RSGlobalConfig.requestConfigParams;
+  hires_clock_get(&req->initClock);
 
   // TODO: save only one of the configuration paramters according to the query type
   // once query offset is bounded by both.
@@ -1028,14 +1056,35 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   return REDISMODULE_OK;
 }
 
-static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
-                                     const RLookupKey ***loadKeys, QueryError *err) {
+/* The tag index to read the values of a field from, if the field would otherwise be loaded from
+ * redis and it has doc values. NULL otherwise */
+static const TagIndex *getTagDocValues(RedisSearchCtx *sctx, const char *name, size_t len) {
+  IndexSpec *sp = sctx ? sctx->spec : NULL;
+  // only the values of HASH documents are kept. The tag indexes of legacy specs are redis keys,
+  // which may not be opened without the GIL
+  if (!sp || !sp->keysDict || (sp->rule && sp->rule->type != DocumentType_Hash)) {
+    return NULL;
+  }
+  const FieldSpec *fs = IndexSpec_GetField(sp, name, len);
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_TAG)) {
+    return NULL;
+  }
+  RedisModuleString *kname = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_TAG);
+  const TagIndex *idx = kname ? TagIndex_Open(sctx, kname, 0, NULL) : NULL;
+  return idx && TagIndex_HasDocValues(idx) ? idx : NULL;
+}
+
+static Grouper *buildGrouper(PLN_GroupStep *gstp, RLookup *srclookup, RedisSearchCtx *sctx,
+                             const RLookupKey ***loadKeys, QueryError *err) {
   const RLookupKey *srckeys[gstp->nproperties], *dstkeys[gstp->nproperties];
+  const TagIndex *docValues[gstp->nproperties];
   for (size_t ii = 0; ii < gstp->nproperties; ++ii) {
     const char *fldname = gstp->properties[ii] + 1;  // account for the @-
     size_t fldname_len = strlen(fldname);
     srckeys[ii] = RLookup_GetKeyEx(srclookup, fldname, fldname_len, RLOOKUP_M_READ, RLOOKUP_F_NOFLAGS);
-    if (!srckeys[ii]) {
+    // A tag field that has to be loaded is grouped by its doc values instead
+    docValues[ii] = !srckeys[ii] && loadKeys ? getTagDocValues(sctx, fldname, fldname_len) : NULL;
+    if (!srckeys[ii] && !docValues[ii]) {
       if (loadKeys) {
         // We faild to get the key for reading, so we know getting it for loading will succeed.
         srckeys[ii] = RLookup_GetKey_LoadEx(srclookup, fldname, fldname_len, fldname, RLOOKUP_F_NOFLAGS);
@@ -1056,6 +1105,11 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
   }
 
   Grouper *grp = Grouper_New(srckeys, dstkeys, gstp->nproperties);
+  for (size_t ii = 0; ii < gstp->nproperties; ++ii) {
+    if (docValues[ii]) {
+      Grouper_SetDocValues(grp, ii, docValues[ii]);
+    }
+  }
 
   size_t nreducers = array_len(gstp->reducers);
   for (size_t ii = 0; ii < nreducers; ++ii) {
@@ -1087,7 +1141,47 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
     }
   }
 
-  return Grouper_GetRP(grp);
+  Grouper_SetMaxMemory(grp, RSGlobalConfig.groupByMaxMemory);
+  return grp;
+}
+
+/* Group the results of every partition of a parallel query by a partial grouper of its own, merged
+ * into `grp` once all the partitions are done. The partitions are left as they are if any of the
+ * reducers can't merge their groups */
+static void addPartialGroupers(PLN_GroupStep *gstp, RLookup *srclookup, Grouper *grp,
+                               ResultProcessor *parallel) {
+  if (!Grouper_CanMerge(grp)) {
+    return;
+  }
+
+  size_t numPartitions = RPParallel_NumPartitions(parallel);
+  size_t nreducers = array_len(gstp->reducers);
+  Grouper *partials[numPartitions];
+  for (size_t ii = 0; ii < numPartitions; ++ii) {
+    partials[ii] = Grouper_NewPartial(grp);
+    for (size_t jj = 0; jj < nreducers; ++jj) {
+      // The arguments were already read by the reducer of the grouper
+      PLN_Reducer *pr = gstp->reducers + jj;
+      ArgsCursor args = pr->args;
+      args.offset = 0;
+      QueryError status = {0};
+      ReducerOptions options = REDUCEROPTS_INIT(pr->name, &args, srclookup, NULL, &status);
+      Reducer *rr = RDCR_GetFactory(pr->name)(&options);
+      if (!rr) {
+        QueryError_ClearError(&status);
+        for (size_t kk = 0; kk <= ii; ++kk) {
+          Grouper_Free(partials[kk]);
+        }
+        return;
+      }
+      Grouper_AddReducer(partials[ii], rr, Grouper_GetReducer(grp, jj)->dstkey);
+    }
+  }
+
+  for (size_t ii = 0; ii < numPartitions; ++ii) {
+    QITR_PushRP(RPParallel_GetPartition(parallel, ii), Grouper_GetRP(partials[ii]));
+    Grouper_AddPartial(grp, partials[ii]);
+  }
 }
 
 /** Pushes a processor up the stack. Returns the newly pushed processor
@@ -1103,19 +1197,52 @@ static ResultProcessor *pushRP(AREQ *req, ResultProcessor *rp, ResultProcessor *
   return rp;
 }
 
+/* The number of results kept by an arrange step */
+static size_t getArrangeLimit(const AREQ *req, const PLN_ArrangeStep *astp) {
+  size_t limit = astp->offset + astp->limit;
+  if (!limit) {
+    limit = DEFAULT_LIMIT;
+  }
+
+  // TODO: unify if when req holds only maxResults according to the query type.
+  //(SEARCH / AGGREGATE)
+  if (IsSearch(req) && req->maxSearchResults != UINT64_MAX) {
+    limit = MIN(limit, req->maxSearchResults);
+  }
+
+  if (!IsSearch(req) && req->maxAggregateResults != UINT64_MAX) {
+    limit = MIN(limit, req->maxAggregateResults);
+  }
+  return limit;
+}
+
 static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcessor *rpUpstream,
                                    QueryError *status) {
   AGGPlan *pln = &req->ap;
   RLookup *lookup = AGPLN_GetLookup(pln, &gstp->base, AGPLN_GETLOOKUP_PREV);
   RLookup *firstLk = AGPLN_GetLookup(pln, &gstp->base, AGPLN_GETLOOKUP_FIRST); // first lookup can load fields from redis
   const RLookupKey **loadKeys = NULL;
-  ResultProcessor *groupRP = buildGroupRP(gstp, lookup, (firstLk == lookup && firstLk->spcache) ? &loadKeys : NULL, status);
+  Grouper *grp = buildGrouper(gstp, lookup, req->sctx, (firstLk == lookup && firstLk->spcache) ? &loadKeys : NULL, status);
 
-  if (!groupRP) {
+  if (!grp) {
     array_free(loadKeys);
     return NULL;
   }
 
+  // Only the groups with the most results are kept if the next step keeps only those
+  const PLN_ArrangeStep *topCount = PLNGroupStep_GetTopCountArrange(pln, gstp);
+  size_t maxGroups = 0;
+  if (topCount && RSGlobalConfig.groupByTopNFactor && !IsCount(req)) {
+    maxGroups = getArrangeLimit(req, topCount) * RSGlobalConfig.groupByTopNFactor;
+    Grouper_SetMaxGroups(grp, maxGroups);
+  }
+
+  // The partitions of a query executed in parallel group their own results, unless the grouper
+  // needs fields loaded first
+  if (!loadKeys && !maxGroups && RPParallel_NumPartitions(rpUpstream)) {
+    addPartialGroupers(gstp, lookup, grp, rpUpstream);
+  }
+
   // See if we need a LOADER group here...?
   if (loadKeys) {
     ResultProcessor *rpLoader = RPLoader_New(req, firstLk, loadKeys, array_len(loadKeys));
@@ -1124,7 +1251,7 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
     rpUpstream = pushRP(req, rpLoader, rpUpstream);
   }
 
-  return pushRP(req, groupRP, rpUpstream);
+  return pushRP(req, Grouper_GetRP(grp), rpUpstream);
 }
 
 static ResultProcessor *getAdditionalMetricsRP(AREQ *req, RLookup *rl, QueryError *status) {
@@ -1160,26 +1287,15 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
   IndexSpec *spec = req->sctx ? req->sctx->spec : NULL; // check for sctx?
   // Store and count keys that require loading from Redis.
   const RLookupKey **loadKeys = NULL;
+  // Keys of tag fields that are read from their doc values instead of loading them.
+  const RLookupKey **docValuesKeys = NULL;
+  const TagIndex **docValues = NULL;
 
   if (!astp) {
     astp = &astp_s;
   }
 
-  size_t limit = astp->offset + astp->limit;
-  if (!limit) {
-    limit = DEFAULT_LIMIT;
-  }
-
-  // TODO: unify if when req holds only maxResults according to the query type.
-  //(SEARCH / AGGREGATE)
-  if (IsSearch(req) && req->maxSearchResults != UINT64_MAX) {
-    limit = MIN(limit, req->maxSearchResults);
-  }
-
-  if (!IsSearch(req) && req->maxAggregateResults != UINT64_MAX) {
-    limit = MIN(limit, req->maxAggregateResults);
-  }
-
+  size_t limit = getArrangeLimit(req, astp);
   if (IsCount(req) || !limit) {
     rp = RPCounter_New();
     up = pushRP(req, rp, up);
@@ -1209,10 +1325,20 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
             QueryError_SetErrorFmt(status, QUERY_ENOPROPKEY, "Property `%s` not loaded nor in schema", keystr);
             goto end;
           }
-          *array_ensure_tail(&loadKeys, const RLookupKey *) = sortkey;
+          const TagIndex *tidx = getTagDocValues(req->sctx, keystr, strlen(keystr));
+          if (tidx) {
+            *array_ensure_tail(&docValuesKeys, const RLookupKey *) = sortkey;
+            *array_ensure_tail(&docValues, const TagIndex *) = tidx;
+          } else {
+            *array_ensure_tail(&loadKeys, const RLookupKey *) = sortkey;
+          }
         }
         sortkeys[ii] = sortkey;
       }
+      if (docValuesKeys) {
+        ResultProcessor *rpDocValues = RPDocValues_New(docValuesKeys, docValues, array_len(docValuesKeys));
+        up = pushRP(req, rpDocValues, up);
+      }
       if (loadKeys) {
         // If we have keys to load, add a loader step.
         ResultProcessor *rpLoader = RPLoader_New(req, lk, loadKeys, array_len(loadKeys));
@@ -1238,6 +1364,8 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
 
 end:
   array_free(loadKeys);
+  array_free(docValuesKeys);
+  array_free(docValues);
   return rp;
 }
 
@@ -1256,7 +1384,8 @@ static ResultProcessor *getScorerRP(AREQ *req) {
   IndexSpec_GetStats(req->sctx->spec, &scargs.indexStats);
   scargs.qdata = req->ast.udata;
   scargs.qdatalen = req->ast.udatalen;
-  ResultProcessor *rp = RPScorer_New(fns, &scargs);
+  // The results of FT.SEARCH go through a sorter, which drops their index results
+  ResultProcessor *rp = RPScorer_New(fns, &scargs, IsSearch(req));
   return rp;
 }
 
@@ -1270,6 +1399,76 @@ static int hasQuerySortby(const AGGPlan *pln) {
   rpUpstream = pushRP(req, rp, rpUpstream); \
   rp = NULL;
 
+/* Whether the processors need the index results of the docids read, rather than just the docids:
+ * to score them, to yield their metrics or to highlight their terms */
+static bool needsIndexResults(const AREQ *req, bool scored) {
+  return scored || req->ast.metricRequests || (req->reqflags & QEXEC_F_SEND_HIGHLIGHT);
+}
+
+/* The number of partitions to execute the query in, or 1 if it is executed serially. A query is
+ * executed in parallel if it reads the docids in order, and none of its processors needs the index
+ * results of the docids once they are read */
+static size_t getParallelism(AREQ *req) {
+#ifdef MT_BUILD
+  IndexIterator *root = req->rootiter;
+  if (req->parallelism < 2 || !RunInThread() || IsProfile(req) ||
+      (req->reqflags & QEXEC_F_SLOWLOG_PLAN) || IsCount(req) ||
+      IsOptimized(req) || (req->reqflags & QEXEC_F_IS_CURSOR) || req->ast.metricRequests ||
+      root->mode != MODE_SORTED || root->type == HYBRID_ITERATOR) {
+    return 1;
+  }
+  // the cost of the query is estimated by the number of results it reads
+  size_t n = MIN(req->parallelism, RSGlobalConfig.numWorkerThreads);
+  n = MIN(n, IITER_NUM_ESTIMATED(root) / PARALLEL_PARTITION_MIN_RESULTS);
+  n = MIN(n, req->sctx->spec->docs.maxDocId);
+  return MAX(n, 1);
+#else
+  return 1;
+#endif
+}
+
+/* Create the root processor of a query executed in parallel. Every partition reads its own clone
+ * of the iterator tree and scores its results if needed. If the results are sorted by their score,
+ * every partition only keeps its best results. Returns NULL if the tree could not be cloned */
+static ResultProcessor *getParallelRP(AREQ *req, size_t numPartitions, bool scored) {
+  RedisSearchCtx *sctx = req->sctx;
+  ResultProcessor *rp =
+      RPParallel_New(&req->qiter, req->rootiter, numPartitions, sctx->spec->docs.maxDocId);
+
+  size_t limit = 0;
+  if (scored && IsSearch(req) && !hasQuerySortby(&req->ap)) {
+    PLN_ArrangeStep astp_s = {.base = {.type = PLN_T_ARRANGE}};
+    const PLN_ArrangeStep *astp =
+        (const PLN_ArrangeStep *)AGPLN_FindStep(&req->ap, NULL, NULL, PLN_T_ARRANGE);
+    limit = getArrangeLimit(req, astp ? astp : &astp_s);
+  }
+
+  for (size_t ii = 0; ii < numPartitions; ++ii) {
+    QueryError status = {0};
+    IndexIterator *it = QAST_Iterate(&req->ast, &req->searchopts, sctx, NULL, req->reqflags, &status);
+    if (QueryError_HasError(&status)) {
+      QueryError_ClearError(&status);
+      if (it) {
+        it->Free(it);
+      }
+      rp->Free(rp);
+      return NULL;
+    }
+    if (!needsIndexResults(req, scored)) {
+      IndexIterator_EnableDocIdsOnly(it);
+    }
+    QueryIterator *qiter = RPParallel_GetPartition(rp, ii);
+    QITR_PushRP(qiter, RPIndexIterator_NewPartition(it, req->timeoutTime));
+    if (scored) {
+      QITR_PushRP(qiter, getScorerRP(req));
+    }
+    if (limit) {
+      QITR_PushRP(qiter, RPSorter_NewByScore(limit));
+    }
+  }
+  return rp;
+}
+
 /**
  * Builds the implicit pipeline for querying and scoring, and ensures that our
  * subsequent execution stages actually have data to operate on.
@@ -1286,7 +1485,28 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPIndexIterator_New(req->rootiter, req->timeoutTime);
+  /** Create a scorer if:
+   *  * WITHSCORES is defined
+   *  * there is no subsequent sorter within this grouping */
+  bool scored = (req->reqflags & QEXEC_F_SEND_SCORES) ||
+                (IsSearch(req) && !IsCount(req) &&
+                 (IsOptimized(req) ? HasScorer(req) : !hasQuerySortby(&req->ap)));
+
+  if (!needsIndexResults(req, scored)) {
+    IndexIterator_EnableDocIdsOnly(req->rootiter);
+  }
+
+  // The partitions of a query executed in parallel score their own results
+  ResultProcessor *rp = NULL;
+  size_t numPartitions = getParallelism(req);
+  if (numPartitions > 1) {
+    rp = getParallelRP(req, numPartitions, scored);
+  }
+  if (rp) {
+    scored = false;
+  } else {
+    rp = RPIndexIterator_New(req->rootiter, req->timeoutTime);
+  }
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
   PUSH_RP();
@@ -1301,12 +1521,7 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
     PUSH_RP();
   }
 
-  /** Create a scorer if:
-   *  * WITHSCORES is defined
-   *  * there is no subsequent sorter within this grouping */
-  if ((req->reqflags & QEXEC_F_SEND_SCORES) ||
-      (IsSearch(req) && !IsCount(req) &&
-       (IsOptimized(req) ? HasScorer(req) : !hasQuerySortby(&req->ap)))) {
+  if (scored) {
     rp = getScorerRP(req);
     PUSH_RP();
   }
@@ -1370,6 +1585,36 @@ error:
   return REDISMODULE_ERR;
 }
 
+/* Collect the APPLY steps right before `stp`, whose results the expression of `stp` may read
+ * rather than evaluating them again. An APPLY is skipped once a later one overwrites its result or
+ * a property it reads, and the search stops at any step changing the results otherwise */
+static arrayof(ExprReuse) getReusableExprs(const AGGPlan *pln, const PLN_BaseStep *stp) {
+  arrayof(ExprReuse) reuse = NULL;
+  arrayof(const RLookupKey *) written = NULL;
+  for (const DLLIST_node *nn = stp->llnodePln.prev; nn != &pln->steps; nn = nn->prev) {
+    const PLN_BaseStep *prev = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (prev->type == PLN_T_FILTER) {
+      continue;
+    } else if (prev->type != PLN_T_APPLY) {
+      break;
+    }
+
+    const PLN_MapFilterStep *mstp = (const PLN_MapFilterStep *)prev;
+    bool valid = !ExprAST_ReadsKey(mstp->parsedExpr, mstp->dstkey);
+    for (size_t ii = 0; valid && ii < array_len(written); ++ii) {
+      valid = written[ii]->dstidx != mstp->dstkey->dstidx &&
+              !ExprAST_ReadsKey(mstp->parsedExpr, written[ii]);
+    }
+    if (valid) {
+      ExprReuse r = {.expr = mstp->parsedExpr, .key = mstp->dstkey};
+      array_ensure_append_1(reuse, r);
+    }
+    array_ensure_append_1(written, mstp->dstkey);
+  }
+  array_free(written);
+  return reuse;
+}
+
 int AREQ_BuildPipeline(AREQ *req, QueryError *status) {
   if (!(req->reqflags & QEXEC_F_BUILDPIPELINE_NO_ROOT)) {
     buildImplicitPipeline(req, status);
@@ -1435,9 +1680,14 @@ int AREQ_BuildPipeline(AREQ *req, QueryError *status) {
             QueryError_SetErrorFmt(status, QUERY_EDUPFIELD, "Property `%s` specified more than once", stp->alias);
             goto error;
           }
-          rp = RPEvaluator_NewProjector(mstp->parsedExpr, curLookup, dstkey);
+          arrayof(ExprReuse) reuse = getReusableExprs(pln, stp);
+          rp = RPEvaluator_NewProjector(mstp->parsedExpr, curLookup, dstkey, reuse);
+          array_free(reuse);
+          mstp->dstkey = dstkey;
         } else {
-          rp = RPEvaluator_NewFilter(mstp->parsedExpr, curLookup);
+          arrayof(ExprReuse) reuse = getReusableExprs(pln, stp);
+          rp = RPEvaluator_NewFilter(mstp->parsedExpr, curLookup, reuse);
+          array_free(reuse);
         }
         PUSH_RP();
         break;
@@ -1522,9 +1772,15 @@ int AREQ_BuildPipeline(AREQ *req, QueryError *status) {
     }
   }
 
+  // A prefetching cursor reads its next chunk into a buffer ending the chain. The coordinator has its
+  // shards prefetch instead
+  if ((req->reqflags & QEXEC_F_CURSOR_PREFETCH) && !(req->reqflags & QEXEC_F_BUILDPIPELINE_NO_ROOT)) {
+    QITR_PushRP(&req->qiter, RPPrefetch_New());
+  }
+
   // In profile mode, we need to add RP_Profile before each RP
   if (IsProfile(req) && req->qiter.endProc) {
-    Profile_AddRPs(&req->qiter);
+    Profile_AddRPs(&req->qiter, req->reqConfig.profileHwCounters);
   }
 
   // Copy timeout policy to the parent struct of the result processors
@@ -1543,6 +1799,7 @@ void AREQ_Free(AREQ *req) {
     rp->Free(rp);
     rp = next;
   }
+  QITR_FreeArena(&req->qiter);
   if (req->rootiter) {
     req->rootiter->Free(req->rootiter);
     req->rootiter = NULL;
@@ -1550,6 +1807,9 @@ void AREQ_Free(AREQ *req) {
   if (req->optimizer) {
     QOptimizer_Free(req->optimizer);
   }
+  if (req->resultCacheKey) {
+    array_free(req->resultCacheKey);
+  }
 
   // Go through each of the steps and free it..
   AGPLN_FreeSteps(&req->ap);
@@ -1586,6 +1846,9 @@ void AREQ_Free(AREQ *req) {
     array_free(req->searchopts.legacy.filters);
   }
   rm_free(req->searchopts.inids);
+  if (req->searchopts.vectorFilter) {
+    SharedVectorFilter_Decref(req->searchopts.vectorFilter);
+  }
   if (req->searchopts.params) {
     Param_DictFree(req->searchopts.params);
   }
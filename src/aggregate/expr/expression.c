@@ -5,6 +5,7 @@
  */
 
 #include "expression.h"
+#include "exprprog.h"
 #include "result_processor.h"
 #include "rlookup.h"
 #include "profile.h"
@@ -409,17 +410,30 @@ struct RPEvaluator {
   RSValue *val;
   const RLookupKey *outkey;
   int isFilter;
+  ExprProgram *prog;  // the compiled expression, if it could be compiled
+  double *regs;       // the registers of the program, for `ncap` results
+  bool *fallback;
+  size_t ncap;
 };
 
 #define RESULT_EVAL_ERR RS_RESULT_MAX + 1
 
-static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
-  /** Get the upstream result */
-  int rc = pc->base.upstream->Next(pc->base.upstream, r);
-  if (rc != RS_RESULT_OK) {
-    return rc;
+/* Evaluate the compiled expression over `n` results, returning their values, or NULL if the
+ * expression isn't compiled. The values where pc->fallback is set are left to rpevalInterpret */
+static const double *rpevalCompiled(RPEvaluator *pc, const SearchResult *results, size_t n) {
+  if (!pc->prog || !n) {
+    return NULL;
+  }
+  if (n > pc->ncap) {
+    pc->regs = rm_realloc(pc->regs, ExprProgram_NumRegisters(pc->prog) * n * sizeof(*pc->regs));
+    pc->fallback = rm_realloc(pc->fallback, n * sizeof(*pc->fallback));
+    pc->ncap = n;
   }
+  return ExprProgram_Eval(pc->prog, results, n, pc->regs, pc->fallback);
+}
 
+/* Evaluate the expression for a result into pc->val, with the recursive evaluator */
+static int rpevalInterpret(RPEvaluator *pc, SearchResult *r) {
   pc->eval.res = r;
   pc->eval.srcrow = &r->rowdata;
 
@@ -430,13 +444,42 @@ static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
     pc->val = RS_NewValue(RSValue_Undef);
   }
 
-  rc = ExprEval_Eval(&pc->eval, pc->val);
-  if (rc != EXPR_EVAL_OK) {
+  if (ExprEval_Eval(&pc->eval, pc->val) != EXPR_EVAL_OK) {
     return RS_RESULT_ERROR;
   }
   return RS_RESULT_OK;
 }
 
+/* Evaluate the expression for a result into pc->val */
+static int rpevalResult(RPEvaluator *pc, SearchResult *r) {
+  const double *num = rpevalCompiled(pc, r, 1);
+  if (!num || pc->fallback[0]) {
+    return rpevalInterpret(pc, r);
+  }
+  if (!pc->val) {
+    pc->val = RS_NewValue(RSValue_Undef);
+  }
+  RSValue_SetNumber(pc->val, *num);
+  return RS_RESULT_OK;
+}
+
+static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
+  /** Get the upstream result */
+  int rc = pc->base.upstream->Next(pc->base.upstream, r);
+  if (rc != RS_RESULT_OK) {
+    return rc;
+  }
+  return rpevalResult(pc, r);
+}
+
+/* Drop the results of a batch from `len` on, after an evaluation error */
+static void rpevalTruncateBatch(SearchResultBatch *batch, size_t len) {
+  for (size_t ii = len; ii < batch->len; ++ii) {
+    SearchResult_Clear(&batch->results[ii]);
+  }
+  batch->len = len;
+}
+
 static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc = rpevalCommon(pc, r);
@@ -449,6 +492,26 @@ static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   return RS_RESULT_OK;
 }
 
+static int rpevalNextBatch_project(ResultProcessor *rp, SearchResultBatch *batch) {
+  RPEvaluator *pc = (RPEvaluator *)rp;
+  int rc = RP_NextBatch(rp->upstream, batch);
+  const double *nums = rpevalCompiled(pc, batch->results, batch->len);
+  for (size_t ii = 0; ii < batch->len; ++ii) {
+    SearchResult *r = &batch->results[ii];
+    if (nums && !pc->fallback[ii]) {
+      RLookup_WriteOwnKey(pc->outkey, &r->rowdata, RS_NumVal(nums[ii]));
+      continue;
+    }
+    if (rpevalInterpret(pc, r) != RS_RESULT_OK) {
+      rpevalTruncateBatch(batch, ii);
+      return RS_RESULT_ERROR;
+    }
+    RLookup_WriteOwnKey(pc->outkey, &r->rowdata, pc->val);
+    pc->val = NULL;
+  }
+  return rc;
+}
+
 static int rpevalNext_filter(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc;
@@ -467,34 +530,80 @@ static int rpevalNext_filter(ResultProcessor *rp, SearchResult *r) {
   return rc;
 }
 
+static int rpevalNextBatch_filter(ResultProcessor *rp, SearchResultBatch *batch) {
+  RPEvaluator *pc = (RPEvaluator *)rp;
+  int rc;
+  do {
+    rc = RP_NextBatch(rp->upstream, batch);
+    const double *nums = rpevalCompiled(pc, batch->results, batch->len);
+    // the results passing the filter are moved to the start of the batch
+    size_t len = 0;
+    for (size_t ii = 0; ii < batch->len; ++ii) {
+      SearchResult *r = &batch->results[ii];
+      int boolrv;
+      if (nums && !pc->fallback[ii]) {
+        boolrv = nums[ii] != 0;
+      } else if (rpevalInterpret(pc, r) != RS_RESULT_OK) {
+        rpevalTruncateBatch(batch, ii);
+        batch->len = len;
+        return RS_RESULT_ERROR;
+      } else {
+        boolrv = RSValue_BoolTest(pc->val);
+        RSValue_Clear(pc->val);
+      }
+      if (!boolrv) {
+        SearchResult_Clear(r);
+        continue;
+      }
+      if (len != ii) {
+        SearchResult tmp = batch->results[len];
+        batch->results[len] = *r;
+        *r = tmp;
+      }
+      len++;
+    }
+    batch->len = len;
+  } while (rc == RS_RESULT_OK && batch->len == 0);
+  return rc;
+}
+
 static void rpevalFree(ResultProcessor *rp) {
   RPEvaluator *ee = (RPEvaluator *)rp;
   if (ee->val) {
     RSValue_Decref(ee->val);
   }
+  if (ee->prog) {
+    ExprProgram_Free(ee->prog);
+  }
+  rm_free(ee->regs);
+  rm_free(ee->fallback);
   BlkAlloc_FreeAll(&ee->eval.stralloc, NULL, NULL, 0);
   rm_free(ee);
 }
 static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *lookup,
-                                              const RLookupKey *dstkey, int isFilter) {
+                                              const RLookupKey *dstkey, const ExprReuse *reuse,
+                                              int isFilter) {
   RPEvaluator *rp = rm_calloc(1, sizeof(*rp));
   rp->base.Next = isFilter ? rpevalNext_filter : rpevalNext_project;
+  rp->base.NextBatch = isFilter ? rpevalNextBatch_filter : rpevalNextBatch_project;
   rp->base.Free = rpevalFree;
   rp->base.type = isFilter ? RP_FILTER : RP_PROJECTOR;
   rp->eval.lookup = lookup;
   rp->eval.root = ast;
   rp->outkey = dstkey;
+  rp->prog = ExprProgram_Compile(ast, reuse);
   BlkAlloc_Init(&rp->eval.stralloc);
   return &rp->base;
 }
 
 ResultProcessor *RPEvaluator_NewProjector(const RSExpr *ast, const RLookup *lookup,
-                                          const RLookupKey *dstkey) {
-  return RPEvaluator_NewCommon(ast, lookup, dstkey, 0);
+                                          const RLookupKey *dstkey, const ExprReuse *reuse) {
+  return RPEvaluator_NewCommon(ast, lookup, dstkey, reuse, 0);
 }
 
-ResultProcessor *RPEvaluator_NewFilter(const RSExpr *ast, const RLookup *lookup) {
-  return RPEvaluator_NewCommon(ast, lookup, NULL, 1);
+ResultProcessor *RPEvaluator_NewFilter(const RSExpr *ast, const RLookup *lookup,
+                                       const ExprReuse *reuse) {
+  return RPEvaluator_NewCommon(ast, lookup, NULL, reuse, 1);
 }
 
 void RPEvaluator_Reply(RedisModule_Reply *reply, const char *title, const ResultProcessor *rp) {
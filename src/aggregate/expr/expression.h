@@ -184,6 +184,12 @@ void ExprEval_Cleanup(ExprEval *ev);
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
+/* The expression of an earlier APPLY step, and the key it wrote its result to */
+typedef struct {
+  const RSExpr *expr;
+  const RLookupKey *key;
+} ExprReuse;
+
 /**
  * Creates a new result processor in the form of a projector. The projector will
  * execute the expression in `ast` and write the result of that expression to the
@@ -192,11 +198,14 @@ void ExprEval_Cleanup(ExprEval *ev);
  * @param ast the parsed expression
  * @param lookup the lookup registry that contains the keys to search for
  * @param dstkey the target key (in lookup) to store the result.
+ * @param reuse the earlier APPLY steps whose results can be read rather than evaluating their
+ *  expressions again, where they appear in `ast`. An array, may be NULL
  *
  * @note The ast needs to be paired with the appropriate RLookupKey objects. This
  * can be done by calling EXPR_GetLookupKeys()
  */
-ResultProcessor *RPEvaluator_NewProjector(const RSExpr *ast, const RLookup *lookup, const RLookupKey *dstkey);
+ResultProcessor *RPEvaluator_NewProjector(const RSExpr *ast, const RLookup *lookup, const RLookupKey *dstkey,
+                                          const ExprReuse *reuse);
 
 /**
  * Creates a new result processor in the form of a filter. The filter will
@@ -205,10 +214,12 @@ ResultProcessor *RPEvaluator_NewProjector(const RSExpr *ast, const RLookup *look
  *
  * @param ast the parsed expression
  * @param lookup lookup used to find the key for the value
+ * @param reuse see NewProjector()
  *
  * See notes for NewProjector()
  */
-ResultProcessor *RPEvaluator_NewFilter(const RSExpr *ast, const RLookup *lookup);
+ResultProcessor *RPEvaluator_NewFilter(const RSExpr *ast, const RLookup *lookup,
+                                       const ExprReuse *reuse);
 
 /**
  * Reply with a string which describes the result processor.
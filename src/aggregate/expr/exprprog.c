@@ -0,0 +1,435 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "exprprog.h"
+#include "aggregate/functions/function.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef enum {
+  /* The number `num` */
+  EXPR_OP_CONST,
+  /* The value at `key`, converted to a number, as an operand of an arithmetic operator */
+  EXPR_OP_LOAD,
+  /* The value at `key`, which must already be a number, as an operand of a predicate */
+  EXPR_OP_LOAD_NUMBER,
+  /* The function of register `a`, by its column `kernel` */
+  EXPR_OP_CALL,
+
+  /* The operators below apply to registers `a` and `b` */
+  EXPR_OP_ADD,
+  EXPR_OP_SUB,
+  EXPR_OP_MUL,
+  EXPR_OP_DIV,
+  EXPR_OP_MOD,
+  EXPR_OP_POW,
+  EXPR_OP_EQ,
+  EXPR_OP_NE,
+  EXPR_OP_LT,
+  EXPR_OP_LE,
+  EXPR_OP_GT,
+  EXPR_OP_GE,
+  EXPR_OP_AND,
+  EXPR_OP_OR,
+  /* Unary, `a` and `b` are the same register */
+  EXPR_OP_NOT,
+} ExprOpcode;
+
+/* Every instruction writes to a register of its own, the one of its index in the program */
+typedef struct {
+  ExprOpcode code;
+  uint16_t a;
+  uint16_t b;
+  union {
+    double num;
+    const RLookupKey *key;
+    RSNumericKernel kernel;
+  };
+} ExprInstr;
+
+struct ExprProgram {
+  arrayof(ExprInstr) code;
+  uint32_t result;  // the register of the value of the expression
+};
+
+/* Compare the numbers as RSValue_Cmp does */
+static inline int exprCompare(double x, double y) {
+  return x > y ? 1 : (x < y ? -1 : 0);
+}
+
+/* Apply an operator, the way the recursive evaluator does (see evalOp and evalPredicate) */
+static inline double exprApply(ExprOpcode code, double x, double y) {
+  switch (code) {
+    case EXPR_OP_ADD:
+      return x + y;
+    case EXPR_OP_SUB:
+      return x - y;
+    case EXPR_OP_MUL:
+      return x * y;
+    case EXPR_OP_DIV:
+      return y != 0 ? x / y : NAN;
+    case EXPR_OP_MOD:
+      // workaround for https://gcc.gnu.org/bugzilla/show_bug.cgi?id=30484
+      if (y == -1) {
+        return 0;
+      } else if (y != 0) {
+        return (long long)x % (long long)y;
+      }
+      return NAN;
+    case EXPR_OP_POW:
+      return pow(x, y);
+    case EXPR_OP_EQ:
+      return exprCompare(x, y) == 0;
+    case EXPR_OP_NE:
+      return exprCompare(x, y) != 0;
+    case EXPR_OP_LT:
+      return exprCompare(x, y) < 0;
+    case EXPR_OP_LE:
+      return exprCompare(x, y) <= 0;
+    case EXPR_OP_GT:
+      return exprCompare(x, y) > 0;
+    case EXPR_OP_GE:
+      return exprCompare(x, y) >= 0;
+    case EXPR_OP_AND:
+      return x != 0 && y != 0;
+    case EXPR_OP_OR:
+      return x != 0 || y != 0;
+    case EXPR_OP_NOT:
+      return !(x != 0);
+    default:
+      RS_LOG_ASSERT(0, "not an operator");
+      return NAN;
+  }
+}
+
+static int exprOpcodeOfOperator(unsigned char op) {
+  switch (op) {
+    case '+':
+      return EXPR_OP_ADD;
+    case '-':
+      return EXPR_OP_SUB;
+    case '*':
+      return EXPR_OP_MUL;
+    case '/':
+      return EXPR_OP_DIV;
+    case '%':
+      return EXPR_OP_MOD;
+    case '^':
+      return EXPR_OP_POW;
+    default:
+      return -1;
+  }
+}
+
+static int exprOpcodeOfCondition(RSCondition cond) {
+  switch (cond) {
+    case RSCondition_Eq:
+      return EXPR_OP_EQ;
+    case RSCondition_Ne:
+      return EXPR_OP_NE;
+    case RSCondition_Lt:
+      return EXPR_OP_LT;
+    case RSCondition_Le:
+      return EXPR_OP_LE;
+    case RSCondition_Gt:
+      return EXPR_OP_GT;
+    case RSCondition_Ge:
+      return EXPR_OP_GE;
+    case RSCondition_And:
+      return EXPR_OP_AND;
+    case RSCondition_Or:
+      return EXPR_OP_OR;
+    default:
+      return -1;
+  }
+}
+
+static bool sameKey(const RLookupKey *k1, const RLookupKey *k2) {
+  // an overridden key is replaced by a new one, reading the same slot of the row
+  return k1 && k2 && k1->dstidx == k2->dstidx;
+}
+
+/* Whether the expressions always evaluate to the same number */
+static bool exprEqual(const RSExpr *e1, const RSExpr *e2) {
+  if (e1->t != e2->t) {
+    return false;
+  }
+  switch (e1->t) {
+    case RSExpr_Literal:
+      return e1->literal.t == RSValue_Number && e2->literal.t == RSValue_Number &&
+             e1->literal.numval == e2->literal.numval;
+    case RSExpr_Property:
+      return sameKey(e1->property.lookupObj, e2->property.lookupObj);
+    case RSExpr_Op:
+      return e1->op.op == e2->op.op && exprEqual(e1->op.left, e2->op.left) &&
+             exprEqual(e1->op.right, e2->op.right);
+    case RSExpr_Predicate:
+      return e1->pred.cond == e2->pred.cond && exprEqual(e1->pred.left, e2->pred.left) &&
+             exprEqual(e1->pred.right, e2->pred.right);
+    case RSExpr_Inverted:
+      return exprEqual(e1->inverted.child, e2->inverted.child);
+    case RSExpr_Function:
+    default:
+      return false;
+  }
+}
+
+bool ExprAST_ReadsKey(const RSExpr *expr, const RLookupKey *key) {
+  switch (expr->t) {
+    case RSExpr_Property:
+      return sameKey(expr->property.lookupObj, key);
+    case RSExpr_Function:
+      for (size_t ii = 0; ii < expr->func.args->len; ii++) {
+        if (ExprAST_ReadsKey(expr->func.args->args[ii], key)) {
+          return true;
+        }
+      }
+      return false;
+    case RSExpr_Op:
+      return ExprAST_ReadsKey(expr->op.left, key) || ExprAST_ReadsKey(expr->op.right, key);
+    case RSExpr_Predicate:
+      return ExprAST_ReadsKey(expr->pred.left, key) || ExprAST_ReadsKey(expr->pred.right, key);
+    case RSExpr_Inverted:
+      return ExprAST_ReadsKey(expr->inverted.child, key);
+    case RSExpr_Literal:
+    default:
+      return false;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  arrayof(ExprInstr) code;
+  const ExprReuse *reuse;
+} ExprCompiler;
+
+static bool instrEqual(const ExprInstr *in1, const ExprInstr *in2) {
+  if (in1->code != in2->code) {
+    return false;
+  }
+  switch (in1->code) {
+    case EXPR_OP_CONST:
+      return in1->num == in2->num;
+    case EXPR_OP_LOAD:
+    case EXPR_OP_LOAD_NUMBER:
+      return sameKey(in1->key, in2->key);
+    case EXPR_OP_CALL:
+      return in1->kernel == in2->kernel && in1->a == in2->a;
+    default:
+      return in1->a == in2->a && in1->b == in2->b;
+  }
+}
+
+/* Add an instruction, folding it if its operands are constants. Returns its register, which is
+ * the one of an equal instruction if there is one already, or -1 if the program is too long */
+static int compilerEmit(ExprCompiler *c, ExprInstr in) {
+  if (in.code >= EXPR_OP_ADD && c->code[in.a].code == EXPR_OP_CONST &&
+      c->code[in.b].code == EXPR_OP_CONST) {
+    double num = exprApply(in.code, c->code[in.a].num, c->code[in.b].num);
+    in = (ExprInstr){.code = EXPR_OP_CONST, .num = num};
+  }
+
+  for (uint32_t ii = 0; ii < array_len(c->code); ++ii) {
+    if (instrEqual(&c->code[ii], &in)) {
+      return ii;
+    }
+  }
+  if (array_len(c->code) == EXPR_PROGRAM_MAX_SIZE) {
+    return -1;
+  }
+  c->code = array_append(c->code, in);
+  return array_len(c->code) - 1;
+}
+
+/* Compile an expression, returning its register or -1 if it can't be compiled. `convert` is set
+ * if its value is converted to a number, rather than compared or tested as it is */
+static int compileExpr(ExprCompiler *c, const RSExpr *e, bool convert) {
+  ExprInstr in = {0};
+  int code = -1, a = 0, b = 0;
+
+  if (e->t == RSExpr_Op || e->t == RSExpr_Predicate || e->t == RSExpr_Inverted) {
+    // these always evaluate to a number, which an earlier APPLY may have written already
+    for (uint32_t ii = 0; ii < array_len(c->reuse); ++ii) {
+      if (exprEqual(e, c->reuse[ii].expr)) {
+        in.code = EXPR_OP_LOAD;
+        in.key = c->reuse[ii].key;
+        return compilerEmit(c, in);
+      }
+    }
+  }
+
+  switch (e->t) {
+    case RSExpr_Literal:
+      if (e->literal.t == RSValue_Number) {
+        in.num = e->literal.numval;
+      } else if (!convert || !RSValue_ToNumber(&e->literal, &in.num)) {
+        return -1;
+      }
+      in.code = EXPR_OP_CONST;
+      return compilerEmit(c, in);
+
+    case RSExpr_Property:
+      if (!e->property.lookupObj) {
+        return -1;
+      }
+      in.code = convert ? EXPR_OP_LOAD : EXPR_OP_LOAD_NUMBER;
+      in.key = e->property.lookupObj;
+      return compilerEmit(c, in);
+
+    case RSExpr_Op:
+      code = exprOpcodeOfOperator(e->op.op);
+      if (code < 0 || (a = compileExpr(c, e->op.left, true)) < 0 ||
+          (b = compileExpr(c, e->op.right, true)) < 0) {
+        return -1;
+      }
+      break;
+
+    case RSExpr_Predicate:
+      code = exprOpcodeOfCondition(e->pred.cond);
+      if (code < 0 || (a = compileExpr(c, e->pred.left, false)) < 0 ||
+          (b = compileExpr(c, e->pred.right, false)) < 0) {
+        return -1;
+      }
+      break;
+
+    case RSExpr_Inverted:
+      code = EXPR_OP_NOT;
+      if ((a = b = compileExpr(c, e->inverted.child, false)) < 0) {
+        return -1;
+      }
+      break;
+
+    case RSExpr_Function:
+      // a function of a number, applied to its argument converted as the function does
+      in.kernel = RSFunctionRegistry_GetKernel(e->func.Call);
+      if (!in.kernel || e->func.args->len != 1 ||
+          (a = b = compileExpr(c, e->func.args->args[0], true)) < 0) {
+        return -1;
+      }
+      in.code = EXPR_OP_CALL;
+      in.a = a;
+      in.b = b;
+      return compilerEmit(c, in);
+
+    default:
+      return -1;
+  }
+
+  in.code = code;
+  in.a = a;
+  in.b = b;
+  return compilerEmit(c, in);
+}
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root, const ExprReuse *reuse) {
+  // A literal or a property is evaluated as it is, not as a number
+  if (root->t != RSExpr_Op && root->t != RSExpr_Predicate && root->t != RSExpr_Inverted &&
+      root->t != RSExpr_Function) {
+    return NULL;
+  }
+
+  ExprCompiler c = {.code = array_new(ExprInstr, 8), .reuse = reuse};
+  int result = compileExpr(&c, root, false);
+  if (result < 0) {
+    array_free(c.code);
+    return NULL;
+  }
+
+  ExprProgram *p = rm_new(ExprProgram);
+  p->code = c.code;
+  p->result = result;
+  return p;
+}
+
+void ExprProgram_Free(ExprProgram *p) {
+  array_free(p->code);
+  rm_free(p);
+}
+
+size_t ExprProgram_NumRegisters(const ExprProgram *p) {
+  return array_len(p->code);
+}
+
+/* Load the value of a property as a number, returning false if it is missing or not a number */
+static inline bool exprLoad(const ExprInstr *in, const RLookupRow *row, double *d) {
+  const RSValue *v = RLookup_GetItem(in->key, row);
+  if (!v) {
+    return false;
+  } else if (in->code == EXPR_OP_LOAD) {
+    return RSValue_ToNumber(v, d);
+  }
+  v = RSValue_Dereference(v);
+  if (v->t != RSValue_Number) {
+    return false;
+  }
+  *d = v->numval;
+  return true;
+}
+
+// The operator is a constant in each case, so that the loop is specialized for it
+#define EXPR_OPERATOR_CASE(c)               \
+  case c:                                   \
+    for (size_t jj = 0; jj < n; ++jj) {     \
+      dst[jj] = exprApply(c, a[jj], b[jj]); \
+    }                                       \
+    break;
+
+const double *ExprProgram_Eval(const ExprProgram *p, const SearchResult *results, size_t n,
+                               double *regs, bool *fallback) {
+  memset(fallback, 0, n * sizeof(*fallback));
+
+  for (uint32_t ii = 0; ii < array_len(p->code); ++ii) {
+    const ExprInstr *in = &p->code[ii];
+    double *dst = regs + ii * n;
+    const double *a = regs + in->a * n;
+    const double *b = regs + in->b * n;
+
+    switch (in->code) {
+      case EXPR_OP_CONST:
+        for (size_t jj = 0; jj < n; ++jj) {
+          dst[jj] = in->num;
+        }
+        break;
+
+      case EXPR_OP_LOAD:
+      case EXPR_OP_LOAD_NUMBER:
+        for (size_t jj = 0; jj < n; ++jj) {
+          if (!exprLoad(in, &results[jj].rowdata, &dst[jj])) {
+            // left for the recursive evaluator
+            fallback[jj] = true;
+            dst[jj] = 0;
+          }
+        }
+        break;
+
+      case EXPR_OP_CALL:
+        // the results the function returns NULL for are left for the recursive evaluator
+        in->kernel(a, dst, fallback, n);
+        break;
+
+      EXPR_OPERATOR_CASE(EXPR_OP_ADD)
+      EXPR_OPERATOR_CASE(EXPR_OP_SUB)
+      EXPR_OPERATOR_CASE(EXPR_OP_MUL)
+      EXPR_OPERATOR_CASE(EXPR_OP_DIV)
+      EXPR_OPERATOR_CASE(EXPR_OP_MOD)
+      EXPR_OPERATOR_CASE(EXPR_OP_POW)
+      EXPR_OPERATOR_CASE(EXPR_OP_EQ)
+      EXPR_OPERATOR_CASE(EXPR_OP_NE)
+      EXPR_OPERATOR_CASE(EXPR_OP_LT)
+      EXPR_OPERATOR_CASE(EXPR_OP_LE)
+      EXPR_OPERATOR_CASE(EXPR_OP_GT)
+      EXPR_OPERATOR_CASE(EXPR_OP_GE)
+      EXPR_OPERATOR_CASE(EXPR_OP_AND)
+      EXPR_OPERATOR_CASE(EXPR_OP_OR)
+      EXPR_OPERATOR_CASE(EXPR_OP_NOT)
+    }
+  }
+  return regs + p->result * n;
+}
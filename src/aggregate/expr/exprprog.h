@@ -0,0 +1,61 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "expression.h"
+#include "result_processor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximal number of instructions of a compiled expression */
+#define EXPR_PROGRAM_MAX_SIZE 256
+
+/**
+ * An expression compiled once into a sequence of instructions over numeric registers, evaluated
+ * over a whole batch of results one instruction at a time, without the intermediate values of the
+ * recursive evaluator.
+ *
+ * Only the arithmetic operators, the predicates, the negation and the functions of a number which
+ * have a column kernel (see RSNumericKernel) over numeric literals and properties are compiled.
+ * Constant sub-expressions are folded, and equal sub-expressions share a register. A result whose properties are missing, or are not numbers, is left to the
+ * recursive evaluator (ExprEval_Eval), which also reports its errors, so that both agree.
+ */
+typedef struct ExprProgram ExprProgram;
+
+/**
+ * Compile an expression whose lookup keys were resolved (see ExprAST_GetLookupKeys). Returns NULL
+ * if it can't be compiled.
+ *
+ * @param reuse the expressions of earlier APPLY steps, whose results the program reads from their
+ *  keys rather than evaluating them again. An array, may be NULL
+ */
+ExprProgram *ExprProgram_Compile(const RSExpr *root, const ExprReuse *reuse);
+
+void ExprProgram_Free(ExprProgram *p);
+
+/* Number of registers of the program for each result it is evaluated over */
+size_t ExprProgram_NumRegisters(const ExprProgram *p);
+
+/**
+ * Evaluate the program over `n` results, returning the value of the expression for each. `regs`
+ * has room for ExprProgram_NumRegisters() * n values. `fallback[i]` is set if the i-th result has
+ * to be evaluated by the recursive evaluator instead, in which case its value is undefined.
+ */
+const double *ExprProgram_Eval(const ExprProgram *p, const SearchResult *results, size_t n,
+                               double *regs, bool *fallback);
+
+/* Whether the expression reads the value at the key */
+bool ExprAST_ReadsKey(const RSExpr *expr, const RLookupKey *key);
+
+#ifdef __cplusplus
+}
+#endif
@@ -77,163 +77,89 @@ time_t fast_timegm(const struct tm *ltm) {
   return (tdays * 86400) + (ltm->tm_hour * 3600) + (ltm->tm_min * 60) + ltm->tm_sec;
 }
 
-static int func_hour(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, QueryError *err) {
-  VALIDATE_ARGS("hour", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
+/* The functions below take a timestamp, and return NULL for a negative one or a value which is
+ * not a number. Each is defined by its value for a timestamp, as a function and as a column
+ * kernel */
+#define DATE_FUNCTION(name)                                                                    \
+  static int func_##name(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,          \
+                         QueryError *err) {                                                    \
+    VALIDATE_ARGS(#name, 1, 1, err);                                                           \
+    double d;                                                                                  \
+    if (!RSValue_ToNumber(argv[0], &d) || d < 0) {                                             \
+      /* on runtime error (bad formatting, etc) we just set the result to null */              \
+      RSValue_MakeReference(result, RS_NullVal());                                             \
+      return EXPR_EVAL_OK;                                                                     \
+    }                                                                                          \
+    RSValue_SetNumber(result, date_##name(d));                                                 \
+    return EXPR_EVAL_OK;                                                                       \
+  }                                                                                            \
+  static void kernel_##name(const double *in, double *out, bool *null, size_t n) {             \
+    for (size_t i = 0; i < n; i++) {                                                           \
+      if (in[i] >= 0) {                                                                        \
+        out[i] = date_##name(in[i]);                                                           \
+      } else {                                                                                 \
+        /* negative or NaN */                                                                  \
+        null[i] = true;                                                                        \
+        out[i] = 0;                                                                            \
+      }                                                                                        \
+    }                                                                                          \
   }
+
+/* Round timestamp to its hour start */
+static inline double date_hour(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
-
   gmtime_r(&ts, &tmm);
   tmm.tm_sec = 0;
   tmm.tm_min = 0;
-  ts = fast_timegm(&tmm);
-  RSValue_SetNumber(result, (double)ts);
-
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)fast_timegm(&tmm);
 }
 
-static int func_minute(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                       QueryError *err) {
-  VALIDATE_ARGS("minute", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
-  RSValue_SetNumber(result, floor(d - fmod(d, 60)));
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+static inline double date_minute(double d) {
+  return floor(d - fmod(d, 60));
 }
 
 /* Round timestamp to its day start */
-static int func_day(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, QueryError *err) {
-  VALIDATE_ARGS("day", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_day(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
-
   gmtime_r(&ts, &tmm);
   tmm.tm_sec = 0;
   tmm.tm_hour = 0;
   tmm.tm_min = 0;
-  ts = fast_timegm(&tmm);
-  RSValue_SetNumber(result, (double)ts);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)fast_timegm(&tmm);
 }
 
-static int func_dayofmonth(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                           QueryError *err) {
-  VALIDATE_ARGS("dayofmonth", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_dayofmonth(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
-
-  RSValue_SetNumber(result, (double)tmm.tm_mday);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)tmm.tm_mday;
 }
 
-static int func_dayofweek(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                          QueryError *err) {
-  VALIDATE_ARGS("dayofweek", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_dayofweek(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
-
-  RSValue_SetNumber(result, (double)tmm.tm_wday);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)tmm.tm_wday;
 }
 
-static int func_dayofyear(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                          QueryError *err) {
-  VALIDATE_ARGS("dayofyear", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_dayofyear(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
-
-  RSValue_SetNumber(result, (double)tmm.tm_yday);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)tmm.tm_yday;
 }
 
-static int func_year(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, QueryError *err) {
-  VALIDATE_ARGS("year", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_year(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
-
-  RSValue_SetNumber(result, (double)tmm.tm_year + 1900);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)tmm.tm_year + 1900;
 }
 
 /* Round a timestamp to the beginning of the month */
-static int func_month(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                      QueryError *err) {
-  VALIDATE_ARGS("month", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_month(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
@@ -241,36 +167,26 @@ static int func_month(ExprEval *ctx, RSValue *result, RSValue **argv, size_t arg
   tmm.tm_hour = 0;
   tmm.tm_min = 0;
   tmm.tm_mday = 1;
-  ts = fast_timegm(&tmm);
-  RSValue_SetNumber(result, (double)ts);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)fast_timegm(&tmm);
 }
 
-static int func_monthofyear(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                            QueryError *err) {
-  VALIDATE_ARGS("monthofyear", 1, 1, err);
-
-  double d;
-  if (!RSValue_ToNumber(argv[0], &d) || d < 0) {
-    goto err;
-  }
+static inline double date_monthofyear(double d) {
   time_t ts = (time_t)d;
   struct tm tmm;
   gmtime_r(&ts, &tmm);
-  RSValue_SetNumber(result, (double)tmm.tm_mon);
-  return EXPR_EVAL_OK;
-err:
-  // on runtime error (bad formatting, etc) we just set the result to null
-
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_OK;
+  return (double)tmm.tm_mon;
 }
 
+DATE_FUNCTION(hour)
+DATE_FUNCTION(minute)
+DATE_FUNCTION(day)
+DATE_FUNCTION(dayofmonth)
+DATE_FUNCTION(dayofweek)
+DATE_FUNCTION(dayofyear)
+DATE_FUNCTION(year)
+DATE_FUNCTION(month)
+DATE_FUNCTION(monthofyear)
+
 static int parseTime(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, QueryError *err) {
   VALIDATE_ARGS("parsetime", 2, 2, err);
   VALIDATE_ARG_ISSTRING("parsetime", argv, 0);
@@ -293,17 +209,21 @@ err:
   return EXPR_EVAL_OK;
 }
 
+#define REGISTER_DATEFUNC(name, f)                                     \
+  RSFunctionRegistry_RegisterFunction(name, func_##f, RSValue_Number); \
+  RSFunctionRegistry_RegisterKernel(name, kernel_##f);
+
 void RegisterDateFunctions() {
   RSFunctionRegistry_RegisterFunction("timefmt", timeFormat, RSValue_String);
   RSFunctionRegistry_RegisterFunction("parsetime", parseTime, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("hour", func_hour, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("minute", func_minute, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("day", func_day, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("month", func_month, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("monthofyear", func_monthofyear, RSValue_Number);
-
-  RSFunctionRegistry_RegisterFunction("year", func_year, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("dayofmonth", func_dayofmonth, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("dayofweek", func_dayofweek, RSValue_Number);
-  RSFunctionRegistry_RegisterFunction("dayofyear", func_dayofyear, RSValue_Number);
+  REGISTER_DATEFUNC("hour", hour);
+  REGISTER_DATEFUNC("minute", minute);
+  REGISTER_DATEFUNC("day", day);
+  REGISTER_DATEFUNC("month", month);
+  REGISTER_DATEFUNC("monthofyear", monthofyear);
+
+  REGISTER_DATEFUNC("year", year);
+  REGISTER_DATEFUNC("dayofmonth", dayofmonth);
+  REGISTER_DATEFUNC("dayofweek", dayofweek);
+  REGISTER_DATEFUNC("dayofyear", dayofyear);
 }
\ No newline at end of file
@@ -28,10 +28,30 @@ int RSFunctionRegistry_RegisterFunction(const char *name, RSFunction f, RSValueT
   functions_g.funcs[functions_g.len].f = f;
   functions_g.funcs[functions_g.len].name = name;
   functions_g.funcs[functions_g.len].retType = retType;
+  functions_g.funcs[functions_g.len].kernel = NULL;
   functions_g.len++;
   return 1;
 }
 
+RSNumericKernel RSFunctionRegistry_GetKernel(RSFunction f) {
+  for (size_t i = 0; i < functions_g.len; i++) {
+    if (functions_g.funcs[i].f == f) {
+      return functions_g.funcs[i].kernel;
+    }
+  }
+  return NULL;
+}
+
+int RSFunctionRegistry_RegisterKernel(const char *name, RSNumericKernel kernel) {
+  for (size_t i = 0; i < functions_g.len; i++) {
+    if (!strcasecmp(functions_g.funcs[i].name, name)) {
+      functions_g.funcs[i].kernel = kernel;
+      return 1;
+    }
+  }
+  return 0;
+}
+
 void RegisterAllFunctions() {
   RegisterMathFunctions();
   RegisterDateFunctions();
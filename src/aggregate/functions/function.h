@@ -60,6 +60,16 @@ struct ExprEval;
 typedef int (*RSFunction)(struct ExprEval *e, RSValue *result, RSValue **args, size_t nargs,
                           QueryError *err);
 
+/**
+ * Column kernel of a function of a single number, applying it to `n` numbers at once, for the
+ * compiled expressions (see ExprProgram). It must agree with the function for any number.
+ * @param in the numbers the function is applied to
+ * @param[out] out the numbers the function returns
+ * @param[out] null set for each number the function returns NULL for, left as is otherwise. The
+ *  function itself is then called for it
+ */
+typedef void (*RSNumericKernel)(const double *in, double *out, bool *null, size_t n);
+
 typedef struct {
   size_t len;
   size_t cap;
@@ -69,6 +79,7 @@ typedef struct {
     RSValueType retType;
     unsigned minargs;
     int maxargs;
+    RSNumericKernel kernel;  // NULL if the function has no column kernel
   } * funcs;
 } RSFunctionRegistry;
 
@@ -78,6 +89,12 @@ RSFunction RSFunctionRegistry_Get(const char *name, size_t len);
 
 int RSFunctionRegistry_RegisterFunction(const char *name, RSFunction f, RSValueType retType);
 
+/* The column kernel of a function, or NULL if it has none */
+RSNumericKernel RSFunctionRegistry_GetKernel(RSFunction f);
+
+/* Set the column kernel of a function registered already */
+int RSFunctionRegistry_RegisterKernel(const char *name, RSNumericKernel kernel);
+
 void RegisterMathFunctions();
 void RegisterStringFunctions();
 void RegisterDateFunctions();
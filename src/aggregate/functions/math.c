@@ -24,6 +24,11 @@
     }                                                                                            \
     RSValue_SetNumber(result, f(d));                                                             \
     return EXPR_EVAL_OK;                                                                         \
+  }                                                                                              \
+  static void mathkernel_##f(const double *in, double *out, bool *null, size_t n) {              \
+    for (size_t i = 0; i < n; i++) {                                                             \
+      out[i] = f(in[i]);                                                                         \
+    }                                                                                            \
   }
 
 NUMERIC_SIMPLE_FUNCTION(log);
@@ -34,8 +39,9 @@ NUMERIC_SIMPLE_FUNCTION(sqrt);
 NUMERIC_SIMPLE_FUNCTION(log2);
 NUMERIC_SIMPLE_FUNCTION(exp);
 
-#define REGISTER_MATHFUNC(name, f) \
-  RSFunctionRegistry_RegisterFunction(name, mathfunc_##f, RSValue_Number);
+#define REGISTER_MATHFUNC(name, f)                                        \
+  RSFunctionRegistry_RegisterFunction(name, mathfunc_##f, RSValue_Number); \
+  RSFunctionRegistry_RegisterKernel(name, mathkernel_##f);
 
 void RegisterMathFunctions() {
   REGISTER_MATHFUNC("log", log);
@@ -8,7 +8,15 @@
 #include <result_processor.h>
 #include <util/block_alloc.h>
 #include <util/khash.h>
+#include <util/fnv.h>
+#include "aggregate.h"
 #include "reducer.h"
+#include "tag_index.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 
 /**
  * A group represents the allocated context of all reducers in a group, and the
@@ -39,12 +47,21 @@ typedef struct {
 
 static const int khid = 33;
 KHASH_MAP_INIT_INT64(khid, Group *);
+KHASH_SET_INIT_INT64(khspilled);
 
 #define GROUPER_NREDUCERS(g) (array_len((g)->reducers))
-#define GROUP_BYTESIZE(parent) (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)))
+// A grouper keeping only its top groups counts the results of each group after its reducers
+#define GROUP_BYTESIZE(parent)                                   \
+  (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)) + \
+   ((parent)->maxGroups ? sizeof(size_t) : 0))
+#define GROUP_COUNT(parent, group) (*(size_t *)&(group)->accumdata[GROUPER_NREDUCERS(parent)])
 #define GROUPS_PER_BLOCK 1024
 #define GROUPER_NSRCKEYS(g) ((g)->nkeys)
 
+// The groups are spilled to this many files, partitioned by their hash value
+#define GROUPER_SPILL_PARTITIONS 16
+#define GROUPER_SPILL_BUFFER_SIZE (64 * 1024)
+
 typedef struct Grouper {
   // Result processor base, for use in row processing
   ResultProcessor base;
@@ -65,9 +82,42 @@ typedef struct Grouper {
   const RLookupKey **dstkeys;
   size_t nkeys;
 
+  /**
+   * docValues[i] is the tag index holding the doc values of key i, or NULL if the key is read from
+   * the source rows. ndocValues is the number of keys read from doc values.
+   */
+  const TagIndex **docValues;
+  size_t ndocValues;
+
   // array of reducers
   Reducer **reducers;
 
+  // The groupers accumulating the partitions of a parallel query, merged in order once the
+  // upstream processor is done (see Grouper_AddPartial)
+  arrayof(struct Grouper *) partials;
+
+  /**
+   * The memory the groups may use before they are spilled to temporary files, or 0. Once spilled,
+   * the groups are yielded one partition after another, each loaded back in turn (see
+   * Grouper_SetMaxMemory)
+   */
+  size_t maxMemory;
+  FILE **spillFiles;     // NULL if the groups were never spilled
+  size_t *spillSizes;    // the bytes written to each file
+  size_t spilled;        // the bytes written to all the files
+  size_t nextPartition;  // the next partition to load
+  // The hash values of the spilled groups, counting them before they are loaded back
+  khash_t(khspilled) * spilledGroups;
+
+  /**
+   * The number of groups kept, or 0 to keep all of them. Once there are that many, the half with
+   * the least results is evicted, and their memory is reused for the next groups, which count
+   * their results from the largest count evicted (see Grouper_SetMaxGroups)
+   */
+  size_t maxGroups;
+  size_t evictedCount;
+  arrayof(Group *) freeGroups;
+
   // Used for maintaining state when yielding groups
   khiter_t iter;
 } Grouper;
@@ -79,15 +129,15 @@ typedef struct Grouper {
  *
  * These will be placed in the output row.
  */
-static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
-  size_t numReducers = array_len(g->reducers);
+static Group *allocGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
   size_t elemSize = GROUP_BYTESIZE(g);
-  Group *group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
-  memset(group, 0, elemSize);
-
-  for (size_t ii = 0; ii < numReducers; ++ii) {
-    group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
+  Group *group;
+  if (array_len(g->freeGroups)) {
+    group = array_pop(g->freeGroups);
+  } else {
+    group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
   }
+  memset(group, 0, elemSize);
 
   /** Initialize the row data! */
   for (size_t ii = 0; ii < ngrpvals; ++ii) {
@@ -100,6 +150,16 @@ static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals
   return group;
 }
 
+/* Create a new group, with a new instance of every reducer */
+static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
+  Group *group = allocGroup(g, groupvals, ngrpvals);
+  size_t numReducers = array_len(g->reducers);
+  for (size_t ii = 0; ii < numReducers; ++ii) {
+    group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
+  }
+  return group;
+}
+
 static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r) {
   for (size_t ii = 0; ii < g->nkeys; ++ii) {
     const RLookupKey *dstkey = g->dstkeys[ii];
@@ -110,6 +170,9 @@ static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r)
   }
 }
 
+static void clearGroups(Grouper *g);
+static int loadNextPartition(Grouper *g);
+
 static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
   Grouper *g = (Grouper *)base;
 
@@ -142,14 +205,90 @@ static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
     return RS_RESULT_OK;
   }
 
+  // yield the groups spilled to the next partition
+  if (g->spillFiles && g->nextPartition < GROUPER_SPILL_PARTITIONS) {
+    clearGroups(g);
+    int rc = loadNextPartition(g);
+    if (rc != RS_RESULT_OK) {
+      return rc;
+    }
+    g->iter = kh_begin(g->groups);
+    return Grouper_rpYield(base, r);
+  }
+
   return RS_RESULT_EOF;
 }
 
+typedef struct {
+  size_t count;
+  khiter_t it;
+} groupCount;
+
+static int cmpGroupCount(const void *a, const void *b) {
+  size_t ca = ((const groupCount *)a)->count, cb = ((const groupCount *)b)->count;
+  return ca < cb ? -1 : ca > cb;
+}
+
+/* Evict the half of the groups with the least results, keeping their memory for the next groups */
+static void evictGroups(Grouper *g) {
+  size_t n = kh_size(g->groups);
+  groupCount *counts = rm_malloc(n * sizeof(*counts));
+  size_t ncounts = 0;
+  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
+    if (kh_exist(g->groups, it)) {
+      counts[ncounts++] = (groupCount){GROUP_COUNT(g, kh_value(g->groups, it)), it};
+    }
+  }
+  qsort(counts, ncounts, sizeof(*counts), cmpGroupCount);
+
+  size_t nevict = ncounts - ncounts / 2;
+  for (size_t ii = 0; ii < nevict; ++ii) {
+    Group *gr = kh_value(g->groups, counts[ii].it);
+    RLookupRow_Cleanup(&gr->rowdata);
+    for (size_t jj = 0; jj < GROUPER_NREDUCERS(g); ++jj) {
+      Reducer *rr = g->reducers[jj];
+      if (rr->FreeInstance) {
+        rr->FreeInstance(rr, gr->accumdata[jj]);
+      }
+    }
+    // freed groups are zeroed, so that the allocator cleanup skips them
+    memset(gr, 0, GROUP_BYTESIZE(g));
+    array_ensure_append_1(g->freeGroups, gr);
+    kh_del(khid, g->groups, counts[ii].it);
+  }
+  if (nevict) {
+    g->evictedCount = counts[nevict - 1].count;
+  }
+  rm_free(counts);
+}
+
+/* Get the group of a hash value, creating it with `groupvals` if there is none yet */
+static Group *getGroup(Grouper *g, uint64_t hval, const RSValue **groupvals, size_t ngrpvals) {
+  Group *group = NULL;
+  khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
+  if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
+    if (g->maxGroups && kh_size(g->groups) >= g->maxGroups) {
+      evictGroups(g);
+    }
+    group = createGroup(g, groupvals, ngrpvals);
+    if (g->maxGroups) {
+      GROUP_COUNT(g, group) = g->evictedCount;
+    }
+    kh_set(khid, g->groups, hval, group);
+  } else {
+    group = kh_value(g->groups, k);
+  }
+  return group;
+}
+
 static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
   size_t nreducers = GROUPER_NREDUCERS(g);
   for (size_t ii = 0; ii < nreducers; ii++) {
     g->reducers[ii]->Add(g->reducers[ii], gr->accumdata[ii], srcrow);
   }
+  if (g->maxGroups) {
+    GROUP_COUNT(g, gr)++;
+  }
 }
 
 /**
@@ -172,19 +311,8 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
                           uint64_t hval, RLookupRow *res) {
   // end of the line - create/add to group
   if (xpos == xlen) {
-    Group *group = NULL;
-
-    // Get or create the group
-    khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
-    if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
-      group = createGroup(g, xarr, xlen);
-      kh_set(khid, g->groups, hval, group);
-    } else {
-      group = kh_value(g->groups, k);
-    }
-
     // send the result to the group and its reducers
-    invokeReducers(g, group, res);
+    invokeReducers(g, getGroup(g, hval, xarr, xlen), res);
     return;
   }
 
@@ -221,36 +349,354 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
   }
 }
 
-static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
+/**
+ * Group a result by the doc values codes of its keys. The codes of up to 4 keys are packed as the
+ * hash value as they are, so distinct groups never collide.
+ */
+static void invokeDocValuesGroupReducers(Grouper *g, SearchResult *res) {
   uint64_t hval = 0;
   size_t nkeys = GROUPER_NSRCKEYS(g);
-  const RSValue *groupvals[nkeys];
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    uint16_t code = TagIndex_GetDocCode(g->docValues[ii], res->docId);
+    hval = nkeys <= 4 ? (hval << 16) | code : fnv_64a_buf(&code, sizeof(code), hval);
+  }
+
+  khiter_t k = kh_get(khid, g->groups, hval);
+  Group *group;
+  if (k != kh_end(g->groups)) {
+    group = kh_value(g->groups, k);
+  } else {
+    const RSValue *groupvals[nkeys];
+    for (size_t ii = 0; ii < nkeys; ++ii) {
+      RSValue *v = TagIndex_GetDocValue(g->docValues[ii], res->docId);
+      groupvals[ii] = v ? v : RS_NullVal();
+    }
+    group = getGroup(g, hval, groupvals, nkeys);
+  }
+  invokeReducers(g, group, &res->rowdata);
+}
 
+static void invokeGroupReducers(Grouper *g, SearchResult *res) {
+  size_t nkeys = GROUPER_NSRCKEYS(g);
+  if (g->ndocValues == nkeys) {
+    invokeDocValuesGroupReducers(g, res);
+    return;
+  }
+
+  const RSValue *groupvals[nkeys];
   for (size_t ii = 0; ii < nkeys; ++ii) {
-    const RLookupKey *srckey = g->srckeys[ii];
-    RSValue *v = RLookup_GetItem(srckey, srcrow);
+    RSValue *v;
+    if (g->docValues[ii]) {
+      v = TagIndex_GetDocValue(g->docValues[ii], res->docId);
+    } else {
+      v = RLookup_GetItem(g->srckeys[ii], &res->rowdata);
+    }
     if (v == NULL) {
       v = RS_NullVal();
     }
     groupvals[ii] = v;
   }
-  extractGroups(g, groupvals, 0, nkeys, 0, 0, srcrow);
+  extractGroups(g, groupvals, 0, nkeys, 0, 0, &res->rowdata);
 }
 
-static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
-  Grouper *g = (Grouper *)base;
+static void cleanCallback(void *ptr, void *arg) {
+  Group *group = ptr;
+  Grouper *parent = arg;
+  // Call the reducer's FreeInstance
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(parent); ++ii) {
+    Reducer *rr = parent->reducers[ii];
+    if (rr->FreeInstance && group->accumdata[ii]) {
+      rr->FreeInstance(rr, group->accumdata[ii]);
+    }
+  }
+}
+
+/* Free the groups and the instances of their reducers, keeping the blocks for the next groups */
+static void clearGroups(Grouper *g) {
+  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
+    if (kh_exist(g->groups, it)) {
+      RLookupRow_Cleanup(&kh_value(g->groups, it)->rowdata);
+    }
+  }
+  // a new table, so that the buckets of the largest one aren't kept
+  kh_destroy(khid, g->groups);
+  g->groups = kh_init(khid);
+  BlkAlloc_Clear(&g->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    BlkAlloc_Clear(&g->reducers[ii]->alloc, NULL, NULL, 0);
+  }
+}
+
+/**
+ * Estimate the memory used by the groups. Only the memory allocated in blocks is counted, not
+ * the values of the groups nor what the reducers allocate for themselves.
+ */
+static size_t groupsMemory(const Grouper *g) {
+  size_t mem = g->groupsAlloc.size + kh_n_buckets(g->groups) * (sizeof(uint64_t) + sizeof(Group *));
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    mem += g->reducers[ii]->alloc.size;
+  }
+  return mem;
+}
+
+static void writeSpillBuffer(Grouper *g, size_t part, Buffer *buf, BufferWriter *bw) {
+  fwrite(buf->data, 1, buf->offset, g->spillFiles[part]);
+  g->spillSizes[part] += buf->offset;
+  g->spilled += buf->offset;
+  BufferWriter_Seek(bw, 0);
+}
+
+/**
+ * Write all the groups to the spill files and clear them. A group is written to the partition of
+ * its hash value as the hash value, the values of its keys and the data of its reducers, so that
+ * all the parts of a group end in the same partition.
+ */
+static int spillGroups(Grouper *g) {
+  if (!g->spillFiles) {
+    g->spillFiles = rm_calloc(GROUPER_SPILL_PARTITIONS, sizeof(*g->spillFiles));
+    g->spillSizes = rm_calloc(GROUPER_SPILL_PARTITIONS, sizeof(*g->spillSizes));
+    g->spilledGroups = kh_init(khspilled);
+    for (size_t ii = 0; ii < GROUPER_SPILL_PARTITIONS; ++ii) {
+      if (!(g->spillFiles[ii] = tmpfile())) {
+        QueryError_SetErrorFmt(g->base.parent->err, QUERY_EGENERIC,
+                               "Could not create a file to spill the groups to: %s",
+                               strerror(errno));
+        return RS_RESULT_ERROR;
+      }
+    }
+  }
+
+  Buffer bufs[GROUPER_SPILL_PARTITIONS];
+  BufferWriter bws[GROUPER_SPILL_PARTITIONS];
+  for (size_t ii = 0; ii < GROUPER_SPILL_PARTITIONS; ++ii) {
+    Buffer_Init(&bufs[ii], GROUPER_SPILL_BUFFER_SIZE);
+    bws[ii] = NewBufferWriter(&bufs[ii]);
+  }
+
+  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
+    if (!kh_exist(g->groups, it)) {
+      continue;
+    }
+    uint64_t hval = kh_key(g->groups, it);
+    Group *gr = kh_value(g->groups, it);
+    size_t part = hval % GROUPER_SPILL_PARTITIONS;
+    BufferWriter *bw = &bws[part];
+    int ret;
+    kh_put(khspilled, g->spilledGroups, hval, &ret);
+
+    Buffer_Write(bw, &hval, sizeof(hval));
+    for (size_t ii = 0; ii < g->nkeys; ++ii) {
+      RSValue *v = RLookup_GetItem(g->dstkeys[ii], &gr->rowdata);
+      RSValue_Serialize(v ? v : RS_NullVal(), bw);
+    }
+    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+      g->reducers[ii]->Save(g->reducers[ii], gr->accumdata[ii], bw);
+    }
+    if (bufs[part].offset >= GROUPER_SPILL_BUFFER_SIZE) {
+      writeSpillBuffer(g, part, &bufs[part], bw);
+    }
+  }
+
+  for (size_t ii = 0; ii < GROUPER_SPILL_PARTITIONS; ++ii) {
+    if (bufs[ii].offset) {
+      writeSpillBuffer(g, ii, &bufs[ii], &bws[ii]);
+    }
+    Buffer_Free(&bufs[ii]);
+  }
+  clearGroups(g);
+  return RS_RESULT_OK;
+}
+
+/* Spill the groups if they use more than the memory allowed */
+static int checkMemory(Grouper *g) {
+  if (g->maxMemory && !g->maxGroups && groupsMemory(g) > g->maxMemory) {
+    return spillGroups(g);
+  }
+  return RS_RESULT_OK;
+}
+
+/**
+ * Load the groups of a partition, merging the parts of each group spilled at different times in
+ * the order they were spilled.
+ */
+static int loadPartition(Grouper *g, size_t part) {
+  FILE *fp = g->spillFiles[part];
+  size_t size = g->spillSizes[part];
+  int rc = RS_RESULT_OK;
+  if (!size) {
+    goto done;
+  }
+
+  fflush(fp);
+  char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if (data == MAP_FAILED) {
+    QueryError_SetErrorFmt(g->base.parent->err, QUERY_EGENERIC,
+                           "Could not read the spilled groups: %s", strerror(errno));
+    rc = RS_RESULT_ERROR;
+    goto done;
+  }
+
+  size_t nkeys = GROUPER_NSRCKEYS(g);
+  size_t nreducers = GROUPER_NREDUCERS(g);
+  Buffer buf = {.data = data, .cap = size, .offset = size};
+  BufferReader br = NewBufferReader(&buf);
+  while (!BufferReader_AtEnd(&br)) {
+    uint64_t hval;
+    Buffer_Read(&br, &hval, sizeof(hval));
+    RSValue *groupvals[nkeys];
+    for (size_t ii = 0; ii < nkeys; ++ii) {
+      groupvals[ii] = RSValue_Deserialize(&br);
+    }
+
+    khiter_t k = kh_get(khid, g->groups, hval);
+    if (k != kh_end(g->groups)) {
+      Group *group = kh_value(g->groups, k);
+      for (size_t ii = 0; ii < nreducers; ++ii) {
+        Reducer *rd = g->reducers[ii];
+        void *src = rd->Load(rd, &br);
+        rd->Merge(rd, group->accumdata[ii], src);
+        if (rd->FreeInstance) {
+          rd->FreeInstance(rd, src);
+        }
+      }
+    } else {
+      Group *group = allocGroup(g, (const RSValue **)groupvals, nkeys);
+      for (size_t ii = 0; ii < nreducers; ++ii) {
+        group->accumdata[ii] = g->reducers[ii]->Load(g->reducers[ii], &br);
+      }
+      kh_set(khid, g->groups, hval, group);
+    }
+    // the group holds its own references
+    for (size_t ii = 0; ii < nkeys; ++ii) {
+      RSValue_Decref(groupvals[ii]);
+    }
+  }
+  munmap(data, size);
+
+done:
+  fclose(fp);
+  g->spillFiles[part] = NULL;
+  return rc;
+}
+
+/* Load the groups of the next partition which has any */
+static int loadNextPartition(Grouper *g) {
+  while (g->nextPartition < GROUPER_SPILL_PARTITIONS && !kh_size(g->groups)) {
+    int rc = loadPartition(g, g->nextPartition++);
+    if (rc != RS_RESULT_OK) {
+      return rc;
+    }
+  }
+  return RS_RESULT_OK;
+}
+
+/* Merge the groups of a partial grouper into those of `g` */
+static void mergePartial(Grouper *g, const Grouper *part) {
+  size_t nkeys = GROUPER_NSRCKEYS(g);
+  size_t nreducers = GROUPER_NREDUCERS(g);
+  for (khiter_t it = kh_begin(part->groups); it != kh_end(part->groups); ++it) {
+    if (!kh_exist(part->groups, it)) {
+      continue;
+    }
+    // both groupers hash the values of a group alike
+    uint64_t hval = kh_key(part->groups, it);
+    Group *src = kh_value(part->groups, it);
+    khiter_t k = kh_get(khid, g->groups, hval);
+    Group *group;
+    if (k != kh_end(g->groups)) {
+      group = kh_value(g->groups, k);
+    } else {
+      const RSValue *groupvals[nkeys];
+      for (size_t ii = 0; ii < nkeys; ++ii) {
+        RSValue *v = RLookup_GetItem(part->dstkeys[ii], &src->rowdata);
+        groupvals[ii] = v ? v : RS_NullVal();
+      }
+      group = getGroup(g, hval, groupvals, nkeys);
+    }
+    for (size_t ii = 0; ii < nreducers; ++ii) {
+      g->reducers[ii]->Merge(g->reducers[ii], group->accumdata[ii], src->accumdata[ii]);
+    }
+  }
+}
+
+/* Whether the results are only counted into a single group, as none of them is read by the
+ * grouper (see Reducer.AddCount) */
+static bool canCount(const Grouper *g) {
+  if (GROUPER_NSRCKEYS(g) || !g->base.upstream->Count) {
+    return false;
+  }
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->AddCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Pass all the results of the upstream processor to the groups */
+static int accumulate(Grouper *g) {
+  ResultProcessor *base = &g->base;
   uint32_t chunkLimit = base->parent->resultLimit;
   base->parent->resultLimit = UINT32_MAX; // we want to accumulate all the results
   int rc;
 
-  while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
-    invokeGroupReducers(g, &res->rowdata);
-    SearchResult_Clear(res);
+  if (canCount(g)) {
+    size_t n = 0;
+    rc = base->upstream->Count(base->upstream, &n);
+    if (n) {
+      Group *gr = getGroup(g, 0, NULL, 0);
+      for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+        g->reducers[ii]->AddCount(g->reducers[ii], gr->accumdata[ii], n);
+      }
+      if (g->maxGroups) {
+        GROUP_COUNT(g, gr) += n;
+      }
+    }
+    base->parent->resultLimit = chunkLimit;
+    return rc;
   }
+
+  SearchResultBatch batch;
+  SearchResultBatch_Init(&batch, RESULT_BATCH_SIZE);
+  do {
+    rc = RP_NextBatch(base->upstream, &batch);
+    for (size_t ii = 0; ii < batch.len; ++ii) {
+      invokeGroupReducers(g, &batch.results[ii]);
+    }
+    SearchResultBatch_Clear(&batch);
+    if (rc == RS_RESULT_OK || rc == RS_RESULT_EOF) {
+      int mrc = checkMemory(g);
+      if (mrc != RS_RESULT_OK) {
+        rc = mrc;
+      }
+    }
+  } while (rc == RS_RESULT_OK);
+  SearchResultBatch_Destroy(&batch);
   base->parent->resultLimit = chunkLimit; // restore the limit
+  return rc;
+}
+
+static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
+  Grouper *g = (Grouper *)base;
+  int rc = accumulate(g);
   if (rc == RS_RESULT_EOF) {
+    for (size_t ii = 0; ii < array_len(g->partials) && rc == RS_RESULT_EOF; ++ii) {
+      mergePartial(g, g->partials[ii]);
+      rc = checkMemory(g) == RS_RESULT_OK ? RS_RESULT_EOF : RS_RESULT_ERROR;
+    }
+    // the groups left in memory are spilled too, to be merged with their spilled parts
+    if (rc == RS_RESULT_EOF && g->spillFiles && kh_size(g->groups)) {
+      rc = spillGroups(g) == RS_RESULT_OK ? RS_RESULT_EOF : RS_RESULT_ERROR;
+    }
+    if (rc == RS_RESULT_EOF && g->spillFiles) {
+      rc = loadNextPartition(g) == RS_RESULT_OK ? RS_RESULT_EOF : RS_RESULT_ERROR;
+    }
+    if (rc != RS_RESULT_EOF) {
+      return rc;
+    }
     base->Next = Grouper_rpYield;
-    base->parent->totalResults = kh_size(g->groups);
+    base->parent->totalResults =
+        g->spilledGroups ? kh_size(g->spilledGroups) : kh_size(g->groups);
     g->iter = kh_begin(khid);
     return Grouper_rpYield(base, res);
   } else {
@@ -258,16 +704,9 @@ static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
   }
 }
 
-static void cleanCallback(void *ptr, void *arg) {
-  Group *group = ptr;
-  Grouper *parent = arg;
-  // Call the reducer's FreeInstance
-  for (size_t ii = 0; ii < GROUPER_NREDUCERS(parent); ++ii) {
-    Reducer *rr = parent->reducers[ii];
-    if (rr->FreeInstance) {
-      rr->FreeInstance(rr, group->accumdata[ii]);
-    }
-  }
+/* Next implementation of a partial grouper, keeping the groups to be merged downstream */
+static int Grouper_rpAccumPartial(ResultProcessor *base, SearchResult *res) {
+  return accumulate((Grouper *)base);
 }
 
 static void Grouper_rpFree(ResultProcessor *grrp) {
@@ -288,8 +727,22 @@ static void Grouper_rpFree(ResultProcessor *grrp) {
   if (g->reducers) {
     array_free(g->reducers);
   }
+  // the partial groupers are freed by the chains of their partitions
+  array_free(g->partials);
+  array_free(g->freeGroups);
+  if (g->spillFiles) {
+    for (size_t ii = 0; ii < GROUPER_SPILL_PARTITIONS; ++ii) {
+      if (g->spillFiles[ii]) {
+        fclose(g->spillFiles[ii]);
+      }
+    }
+    rm_free(g->spillFiles);
+    rm_free(g->spillSizes);
+    kh_destroy(khspilled, g->spilledGroups);
+  }
   rm_free(g->srckeys);
   rm_free(g->dstkeys);
+  rm_free(g->docValues);
   rm_free(g);
 }
 
@@ -304,6 +757,7 @@ Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, siz
 
   g->srckeys = rm_calloc(nkeys, sizeof(*g->srckeys));
   g->dstkeys = rm_calloc(nkeys, sizeof(*g->dstkeys));
+  g->docValues = rm_calloc(nkeys, sizeof(*g->docValues));
   g->nkeys = nkeys;
   for (size_t ii = 0; ii < nkeys; ++ii) {
     g->srckeys[ii] = srckeys[ii];
@@ -316,6 +770,59 @@ Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, siz
   return g;
 }
 
+Grouper *Grouper_NewPartial(const Grouper *g) {
+  Grouper *part = Grouper_New(g->srckeys, g->dstkeys, g->nkeys);
+  for (size_t ii = 0; ii < g->nkeys; ++ii) {
+    if (g->docValues[ii]) {
+      Grouper_SetDocValues(part, ii, g->docValues[ii]);
+    }
+  }
+  part->base.Next = Grouper_rpAccumPartial;
+  return part;
+}
+
+void Grouper_AddPartial(Grouper *g, Grouper *partial) {
+  array_ensure_append_1(g->partials, partial);
+}
+
+bool Grouper_CanMerge(const Grouper *g) {
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->Merge) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Grouper_SetMaxMemory(Grouper *g, size_t maxMemory) {
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    const Reducer *r = g->reducers[ii];
+    if (!r->Merge || !r->Save || !r->Load) {
+      return;
+    }
+  }
+  g->maxMemory = maxMemory;
+}
+
+void Grouper_SetMaxGroups(Grouper *g, size_t maxGroups) {
+  g->maxGroups = maxGroups;
+}
+
+size_t RPGrouper_SpilledBytes(const ResultProcessor *rp) {
+  return ((const Grouper *)rp)->spilled;
+}
+
+Reducer *Grouper_GetReducer(const Grouper *g, size_t idx) {
+  return g->reducers[idx];
+}
+
+void Grouper_SetDocValues(Grouper *g, size_t idx, const TagIndex *tidx) {
+  if (!g->docValues[idx]) {
+    g->ndocValues++;
+  }
+  g->docValues[idx] = tidx;
+}
+
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dstkey) {
   Reducer **rpp = array_ensure_tail(&g->reducers, Reducer *);
   *rpp = r;
@@ -35,21 +35,27 @@ ReducerFactory RDCR_GetFactory(const char *name) {
   return NULL;
 }
 
-#define RDCR_XBUILTIN(X)                           \
-  X(RDCRCount_New, "COUNT")                        \
-  X(RDCRSum_New, "SUM")                            \
-  X(RDCRToList_New, "TOLIST")                      \
-  X(RDCRMin_New, "MIN")                            \
-  X(RDCRMax_New, "MAX")                            \
-  X(RDCRAvg_New, "AVG")                            \
-  X(RDCRCountDistinct_New, "COUNT_DISTINCT")       \
-  X(RDCRCountDistinctish_New, "COUNT_DISTINCTISH") \
-  X(RDCRQuantile_New, "QUANTILE")                  \
-  X(RDCRStdDev_New, "STDDEV")                      \
-  X(RDCRFirstValue_New, "FIRST_VALUE")             \
-  X(RDCRRandomSample_New, "RANDOM_SAMPLE")         \
-  X(RDCRHLL_New, "HLL")                            \
-  X(RDCRHLLSum_New, "HLL_SUM")
+#define RDCR_XBUILTIN(X)                              \
+  X(RDCRCount_New, "COUNT")                           \
+  X(RDCRSum_New, "SUM")                               \
+  X(RDCRToList_New, "TOLIST")                         \
+  X(RDCRMin_New, "MIN")                               \
+  X(RDCRMax_New, "MAX")                               \
+  X(RDCRAvg_New, "AVG")                               \
+  X(RDCRCountDistinct_New, "COUNT_DISTINCT")          \
+  X(RDCRCountDistinctish_New, "COUNT_DISTINCTISH")    \
+  X(RDCRQuantile_New, "QUANTILE")                     \
+  X(RDCRStdDev_New, "STDDEV")                         \
+  X(RDCRFirstValue_New, "FIRST_VALUE")                \
+  X(RDCRRandomSample_New, "RANDOM_SAMPLE")            \
+  X(RDCRHLL_New, "HLL")                               \
+  X(RDCRHLLSum_New, "HLL_SUM")                        \
+  X(RDCRTDigest_New, "TDIGEST")                       \
+  X(RDCRTDigestQuantile_New, "TDIGEST_QUANTILE")      \
+  X(RDCRStdDevPartial_New, "STDDEV_PARTIAL")          \
+  X(RDCRStdDevMerge_New, "STDDEV_MERGE")              \
+  X(RDCRFirstValuePartial_New, "FIRST_VALUE_PARTIAL") \
+  X(RDCRFirstValueMerge_New, "FIRST_VALUE_MERGE")
 
 void RDCR_RegisterBuiltins(void) {
 #define X(fn, n) RDCR_RegisterFactory(n, fn);
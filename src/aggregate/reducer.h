@@ -30,6 +30,10 @@ typedef enum {
   REDUCER_T_HLL,
   REDUCER_T_HLLSUM,
   REDUCER_T_SAMPLE,
+  REDUCER_T_TDIGEST,
+  REDUCER_T_TDIGEST_QUANTILE,
+  REDUCER_T_STDDEV_PARTIAL,
+  REDUCER_T_STDDEV_MERGE,
 
   /** Not a reducer, but a marker of the end of the list */
   REDUCER_T__END
@@ -72,12 +76,46 @@ typedef struct Reducer {
    */
   int (*Add)(struct Reducer *parent, void *instance, const RLookupRow *srcrow);
 
+  /**
+   * Passes `n` results through the reducer at once, without their rows.
+   *
+   * This is optional. The results of a grouping by no property are only
+   * counted, rather than read, if all its reducers have it.
+   */
+  void (*AddCount)(struct Reducer *parent, void *instance, size_t n);
+
   /**
    * Called when Add() has been invoked for the last time. This is used to
    * populate the result of the reduce function.
    */
   RSValue *(*Finalize)(struct Reducer *parent, void *instance);
 
+  /**
+   * Merges into `instance` the data accumulated by `src`, an instance of an
+   * equivalent reducer which was passed the results following those passed to
+   * `instance`, as if they were all passed to `instance`. `src` is freed by its
+   * own reducer.
+   *
+   * This is optional. The groups of a query executed in parallel are only
+   * accumulated separately by each partition if all their reducers have it.
+   */
+  void (*Merge)(struct Reducer *parent, void *instance, void *src);
+
+  /**
+   * Writes the data accumulated by an instance, to be read back by Load().
+   */
+  void (*Save)(struct Reducer *parent, void *instance, BufferWriter *bw);
+
+  /**
+   * Creates a new instance with the data written by Save(), as returned by
+   * NewInstance().
+   *
+   * Save() and Load() are optional. The groups of a grouper are only spilled to
+   * disk once they use too much memory if all their reducers have both, and
+   * Merge().
+   */
+  void *(*Load)(struct Reducer *parent, BufferReader *br);
+
   /** Frees the object created by NewInstance() */
   void (*FreeInstance)(struct Reducer *parent, void *instance);
 
@@ -161,10 +199,16 @@ Reducer *RDCRCountDistinct_New(const ReducerOptions *);
 Reducer *RDCRCountDistinctish_New(const ReducerOptions *);
 Reducer *RDCRQuantile_New(const ReducerOptions *);
 Reducer *RDCRStdDev_New(const ReducerOptions *);
+Reducer *RDCRStdDevPartial_New(const ReducerOptions *);
+Reducer *RDCRStdDevMerge_New(const ReducerOptions *);
 Reducer *RDCRFirstValue_New(const ReducerOptions *);
+Reducer *RDCRFirstValuePartial_New(const ReducerOptions *);
+Reducer *RDCRFirstValueMerge_New(const ReducerOptions *);
 Reducer *RDCRRandomSample_New(const ReducerOptions *);
 Reducer *RDCRHLL_New(const ReducerOptions *);
 Reducer *RDCRHLLSum_New(const ReducerOptions *);
+Reducer *RDCRTDigest_New(const ReducerOptions *);
+Reducer *RDCRTDigestQuantile_New(const ReducerOptions *);
 
 typedef Reducer *(*ReducerFactory)(const ReducerOptions *);
 ReducerFactory RDCR_GetFactory(const char *name);
@@ -24,6 +24,24 @@ static int counterAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void counterAddCount(Reducer *r, void *ctx, size_t n) {
+  ((counterData *)ctx)->count += n;
+}
+
+static void counterMerge(Reducer *r, void *instance, void *src) {
+  ((counterData *)instance)->count += ((counterData *)src)->count;
+}
+
+static void counterSave(Reducer *r, void *instance, BufferWriter *bw) {
+  Buffer_Write(bw, &((counterData *)instance)->count, sizeof(size_t));
+}
+
+static void *counterLoad(Reducer *r, BufferReader *br) {
+  counterData *dd = counterNewInstance(r);
+  Buffer_Read(br, &dd->count, sizeof(dd->count));
+  return dd;
+}
+
 static RSValue *counterFinalize(Reducer *r, void *instance) {
   counterData *dd = instance;
   return RS_NumVal(dd->count);
@@ -36,6 +54,10 @@ Reducer *RDCRCount_New(const ReducerOptions *options) {
   }
   Reducer *r = rm_calloc(1, sizeof(*r));
   r->Add = counterAdd;
+  r->AddCount = counterAddCount;
+  r->Merge = counterMerge;
+  r->Save = counterSave;
+  r->Load = counterLoad;
   r->Finalize = counterFinalize;
   r->Free = Reducer_GenericFree;
   r->NewInstance = counterNewInstance;
@@ -51,6 +51,48 @@ static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void distinctMerge(Reducer *r, void *instance, void *src) {
+  distinctCounter *ctr = instance;
+  const distinctCounter *other = src;
+  for (khiter_t k = kh_begin(other->dedup); k != kh_end(other->dedup); ++k) {
+    if (!kh_exist(other->dedup, k)) {
+      continue;
+    }
+    int ret;
+    kh_put(khid, ctr->dedup, kh_key(other->dedup, k), &ret);
+    if (ret) {  // not present yet
+      ctr->count++;
+    }
+  }
+}
+
+static void distinctSave(Reducer *r, void *instance, BufferWriter *bw) {
+  const distinctCounter *ctr = instance;
+  uint64_t count = ctr->count;
+  Buffer_Write(bw, &count, sizeof(count));
+  for (khiter_t k = kh_begin(ctr->dedup); k != kh_end(ctr->dedup); ++k) {
+    if (kh_exist(ctr->dedup, k)) {
+      uint64_t hval = kh_key(ctr->dedup, k);
+      Buffer_Write(bw, &hval, sizeof(hval));
+    }
+  }
+}
+
+static void *distinctLoad(Reducer *r, BufferReader *br) {
+  distinctCounter *ctr = distinctNewInstance(r);
+  uint64_t count;
+  Buffer_Read(br, &count, sizeof(count));
+  kh_resize(khid, ctr->dedup, count);
+  for (uint64_t ii = 0; ii < count; ++ii) {
+    uint64_t hval;
+    int ret;
+    Buffer_Read(br, &hval, sizeof(hval));
+    kh_put(khid, ctr->dedup, hval, &ret);
+  }
+  ctr->count = count;
+  return ctr;
+}
+
 static RSValue *distinctFinalize(Reducer *parent, void *ctx) {
   distinctCounter *ctr = ctx;
   return RS_NumVal(ctr->count);
@@ -70,6 +112,9 @@ Reducer *RDCRCountDistinct_New(const ReducerOptions *options) {
     return NULL;
   }
   r->Add = distinctAdd;
+  r->Merge = distinctMerge;
+  r->Save = distinctSave;
+  r->Load = distinctLoad;
   r->Finalize = distinctFinalize;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctFreeInstance;
@@ -105,6 +150,45 @@ static int distinctishAdd(Reducer *parent, void *instance, const RLookupRow *src
   return 1;
 }
 
+static void distinctishMerge(Reducer *parent, void *instance, void *src) {
+  distinctishCounter *ctr = instance;
+  const distinctishCounter *other = src;
+  hll_merge(&ctr->hll, &other->hll);
+}
+
+static void hllSave(const struct HLL *hll, BufferWriter *bw) {
+  Buffer_WriteU8(bw, !hll->registers);
+  if (hll->registers) {
+    Buffer_Write(bw, hll->registers, hll->size);
+  } else {
+    Buffer_WriteU32(bw, hll->sparseLen);
+    Buffer_Write(bw, hll->sparse, hll->sparseLen * sizeof(*hll->sparse));
+  }
+}
+
+static void hllLoad(struct HLL *hll, uint8_t bits, BufferReader *br) {
+  if (Buffer_ReadU8(br)) {
+    uint32_t n = Buffer_ReadU32(br);
+    hll_load_sparse(hll, bits, BufferReader_Current(br), n);
+    Buffer_Skip(br, n * sizeof(uint32_t));
+  } else {
+    hll_init(hll, bits);
+    hll_densify(hll);
+    Buffer_Read(br, hll->registers, hll->size);
+  }
+}
+
+static void distinctishSave(Reducer *parent, void *instance, BufferWriter *bw) {
+  const distinctishCounter *ctr = instance;
+  hllSave(&ctr->hll, bw);
+}
+
+static void *distinctishLoad(Reducer *parent, BufferReader *br) {
+  distinctishCounter *ctr = distinctishNewInstance(parent);
+  hllLoad(&ctr->hll, HLL_PRECISION_BITS, br);
+  return ctr;
+}
+
 static RSValue *distinctishFinalize(Reducer *parent, void *instance) {
   distinctishCounter *ctr = instance;
   return RS_NumVal((uint64_t)hll_count(&ctr->hll));
@@ -115,23 +199,32 @@ static void distinctishFreeInstance(Reducer *r, void *p) {
   hll_destroy(&ctr->hll);
 }
 
+/** The registers are replaced by the sorted hashes of a sparse HLL */
+#define HLL_SERIALIZED_SPARSE 0x01
+
 /** Serialized HLL format */
 typedef struct __attribute__((packed)) {
-  uint32_t flags;  // Currently unused
+  uint32_t flags;
   uint8_t bits;
-  // uint32_t size -- NOTE - always 1<<bits
+  // uint32_t size -- NOTE - always 1<<bits, or 4 bytes per hash if sparse
 } HLLSerializedHeader;
 
 static RSValue *hllFinalize(Reducer *parent, void *ctx) {
   distinctishCounter *ctr = ctx;
-
-  // Serialize field map.
-  HLLSerializedHeader hdr = {.flags = 0, .bits = ctr->hll.bits};
-  char *str = rm_malloc(sizeof(hdr) + ctr->hll.size);
+  const struct HLL *hll = &ctr->hll;
+
+  // Serialize field map. The hashes of a sparse HLL take less than its registers
+  HLLSerializedHeader hdr = {.flags = hll->registers ? 0 : HLL_SERIALIZED_SPARSE,
+                             .bits = hll->bits};
+  const void *data = hll->registers ? (const void *)hll->registers : (const void *)hll->sparse;
+  size_t datasize = hll->registers ? hll->size : hll->sparseLen * sizeof(*hll->sparse);
+  char *str = rm_malloc(sizeof(hdr) + datasize);
   size_t hdrsize = sizeof(hdr);
   memcpy(str, &hdr, hdrsize);
-  memcpy(str + hdrsize, ctr->hll.registers, ctr->hll.size);
-  RSValue *ret = RS_StringVal(str, sizeof(hdr) + ctr->hll.size);
+  if (datasize) {
+    memcpy(str + hdrsize, data, datasize);
+  }
+  RSValue *ret = RS_StringVal(str, sizeof(hdr) + datasize);
   return ret;
 }
 
@@ -142,6 +235,9 @@ static Reducer *newHllCommon(const ReducerOptions *options, int isRaw) {
     return NULL;
   }
   r->Add = distinctishAdd;
+  r->Merge = distinctishMerge;
+  r->Save = distinctishSave;
+  r->Load = distinctishLoad;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctishFreeInstance;
   r->NewInstance = distinctishNewInstance;
@@ -192,10 +288,29 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
 
   // Can't be an insane bit value - we don't want to overflow either!
   size_t regsz = len - sizeof(*hdr);
-  if (hdr->bits > 64) {
+  if (hdr->bits < 4 || hdr->bits > 20) {
+    return 0;
+  }
+  if (ctr->hll.bits && hdr->bits != ctr->hll.bits) {
     return 0;
   }
 
+  if (hdr->flags & HLL_SERIALIZED_SPARSE) {
+    // The hashes are not aligned, and are added one by one
+    if (regsz % sizeof(uint32_t) || regsz / sizeof(uint32_t) > (1 << hdr->bits) / sizeof(uint32_t)) {
+      return 0;
+    }
+    struct HLL tmphll;
+    hll_load_sparse(&tmphll, hdr->bits, registers, regsz / sizeof(uint32_t));
+    if (ctr->hll.bits) {
+      hll_merge(&ctr->hll, &tmphll);
+      hll_destroy(&tmphll);
+    } else {
+      ctr->hll = tmphll;
+    }
+    return 1;
+  }
+
   // Expected length should be determined from bits (whose value we've also
   // verified)
   if (regsz != 1 << hdr->bits) {
@@ -203,9 +318,6 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   }
 
   if (ctr->hll.bits) {
-    if (hdr->bits != ctr->hll.bits) {
-      return 0;
-    }
     // Merge!
     struct HLL tmphll = {
         .bits = hdr->bits, .size = 1 << hdr->bits, .registers = (uint8_t *)registers};
@@ -214,12 +326,27 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
     }
   } else {
     // Not yet initialized - make this our first register and continue.
-    hll_init(&ctr->hll, hdr->bits);
-    memcpy(ctr->hll.registers, registers, regsz);
+    hll_load(&ctr->hll, registers, regsz);
   }
   return 1;
 }
 
+static void hllsumMerge(Reducer *r, void *instance, void *src) {
+  hllSumCtx *ctr = instance;
+  const hllSumCtx *other = src;
+  if (!other->hll.bits) {
+    return;
+  }
+
+  if (!ctr->hll.bits) {
+    hll_init(&ctr->hll, other->hll.bits);
+  }
+  if (ctr->hll.bits == other->hll.bits) {
+    // Registers of another size were not added either
+    hll_merge(&ctr->hll, &other->hll);
+  }
+}
+
 static RSValue *hllsumFinalize(Reducer *parent, void *ctx) {
   hllSumCtx *ctr = ctx;
   return RS_NumVal(ctr->hll.bits ? (uint64_t)hll_count(&ctr->hll) : 0);
@@ -227,12 +354,28 @@ static RSValue *hllsumFinalize(Reducer *parent, void *ctx) {
 
 static void *hllsumNewInstance(Reducer *r) {
   hllSumCtx *ctr = BlkAlloc_Alloc(&r->alloc, sizeof(*ctr), 1024 * sizeof(*ctr));
-  ctr->hll.bits = 0;
-  ctr->hll.registers = NULL;
+  memset(&ctr->hll, 0, sizeof(ctr->hll));
   ctr->srckey = r->srckey;
   return ctr;
 }
 
+static void hllsumSave(Reducer *r, void *instance, BufferWriter *bw) {
+  const hllSumCtx *ctr = instance;
+  Buffer_WriteU8(bw, ctr->hll.bits);
+  if (ctr->hll.bits) {
+    hllSave(&ctr->hll, bw);
+  }
+}
+
+static void *hllsumLoad(Reducer *r, BufferReader *br) {
+  hllSumCtx *ctr = hllsumNewInstance(r);
+  uint8_t bits = Buffer_ReadU8(br);
+  if (bits) {
+    hllLoad(&ctr->hll, bits, br);
+  }
+  return ctr;
+}
+
 static void hllsumFreeInstance(Reducer *r, void *p) {
   hllSumCtx *ctr = p;
   hll_destroy(&ctr->hll);
@@ -246,6 +389,9 @@ Reducer *RDCRHLLSum_New(const ReducerOptions *options) {
   }
   r->reducerId = REDUCER_T_HLLSUM;
   r->Add = hllsumAdd;
+  r->Merge = hllsumMerge;
+  r->Save = hllsumSave;
+  r->Load = hllsumLoad;
   r->Finalize = hllsumFinalize;
   r->NewInstance = hllsumNewInstance;
   r->FreeInstance = hllsumFreeInstance;
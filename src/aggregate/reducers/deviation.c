@@ -59,6 +59,40 @@ static int stddevAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void stddevMerge(Reducer *r, void *instance, void *src) {
+  // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm
+  devCtx *dctx = instance;
+  const devCtx *other = src;
+  if (!other->n) {
+    return;
+  }
+  size_t n = dctx->n + other->n;
+  double delta = other->oldM - dctx->oldM;
+  dctx->newM = dctx->oldM + delta * other->n / n;
+  dctx->newS = dctx->oldS + other->oldS + delta * delta * ((double)dctx->n * other->n / n);
+  dctx->n = n;
+
+  dctx->oldM = dctx->newM;
+  dctx->oldS = dctx->newS;
+}
+
+static void stddevSave(Reducer *r, void *instance, BufferWriter *bw) {
+  const devCtx *dctx = instance;
+  Buffer_Write(bw, &dctx->n, sizeof(dctx->n));
+  Buffer_Write(bw, &dctx->oldM, sizeof(dctx->oldM));
+  Buffer_Write(bw, &dctx->oldS, sizeof(dctx->oldS));
+}
+
+static void *stddevLoad(Reducer *r, BufferReader *br) {
+  devCtx *dctx = stddevNewInstance(r);
+  Buffer_Read(br, &dctx->n, sizeof(dctx->n));
+  Buffer_Read(br, &dctx->oldM, sizeof(dctx->oldM));
+  Buffer_Read(br, &dctx->oldS, sizeof(dctx->oldS));
+  dctx->newM = dctx->oldM;
+  dctx->newS = dctx->oldS;
+  return dctx;
+}
+
 static RSValue *stddevFinalize(Reducer *parent, void *instance) {
   devCtx *dctx = instance;
   double variance = ((dctx->n > 1) ? dctx->newS / (dctx->n - 1) : 0.0);
@@ -66,16 +100,60 @@ static RSValue *stddevFinalize(Reducer *parent, void *instance) {
   return RS_NumVal(stddev);
 }
 
-Reducer *RDCRStdDev_New(const ReducerOptions *options) {
+/* Merge the partial deviation of a shard, serialized by the STDDEV_PARTIAL reducer */
+static int stddevMergeAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
+  devCtx *dctx = ctx;
+  const RSValue *v = RLookup_GetItem(dctx->srckey, srcrow);
+  if (!v || !RSValue_IsString(v)) {
+    return 1;
+  }
+  size_t len;
+  const char *str = RSValue_StringPtrLen(v, &len);
+  devCtx other = {0};
+  if (len != sizeof(other.n) + sizeof(other.oldM) + sizeof(other.oldS)) {
+    return 1;
+  }
+  memcpy(&other.n, str, sizeof(other.n));
+  memcpy(&other.oldM, str + sizeof(other.n), sizeof(other.oldM));
+  memcpy(&other.oldS, str + sizeof(other.n) + sizeof(other.oldM), sizeof(other.oldS));
+  stddevMerge(r, dctx, &other);
+  return 1;
+}
+
+/* The count, mean and sum of squared deviations, to be merged by STDDEV_MERGE */
+static RSValue *stddevPartialFinalize(Reducer *parent, void *instance) {
+  Buffer buf;
+  Buffer_Init(&buf, sizeof(devCtx));
+  BufferWriter bw = NewBufferWriter(&buf);
+  stddevSave(parent, instance, &bw);
+  return RS_StringVal(buf.data, buf.offset);
+}
+
+static Reducer *newStdDevCommon(const ReducerOptions *options, ReducerType type) {
   Reducer *r = rm_calloc(1, sizeof(*r));
   if (!ReducerOptions_GetKey(options, &r->srckey)) {
     rm_free(r);
     return NULL;
   }
-  r->Add = stddevAdd;
-  r->Finalize = stddevFinalize;
+  r->Add = type == REDUCER_T_STDDEV_MERGE ? stddevMergeAdd : stddevAdd;
+  r->Merge = stddevMerge;
+  r->Save = stddevSave;
+  r->Load = stddevLoad;
+  r->Finalize = type == REDUCER_T_STDDEV_PARTIAL ? stddevPartialFinalize : stddevFinalize;
   r->Free = Reducer_GenericFree;
   r->NewInstance = stddevNewInstance;
-  r->reducerId = REDUCER_T_STDDEV;
+  r->reducerId = type;
   return r;
 }
+
+Reducer *RDCRStdDev_New(const ReducerOptions *options) {
+  return newStdDevCommon(options, REDUCER_T_STDDEV);
+}
+
+Reducer *RDCRStdDevPartial_New(const ReducerOptions *options) {
+  return newStdDevCommon(options, REDUCER_T_STDDEV_PARTIAL);
+}
+
+Reducer *RDCRStdDevMerge_New(const ReducerOptions *options) {
+  return newStdDevCommon(options, REDUCER_T_STDDEV_MERGE);
+}
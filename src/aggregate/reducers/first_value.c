@@ -48,23 +48,21 @@ static int fvAdd_noSort(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
-static int fvAdd_sort(Reducer *r, void *ctx, const RLookupRow *srcrow) {
-  fvCtx *fvx = ctx;
-  RSValue *val = RLookup_GetItem(fvx->retprop, srcrow);
-  if (!val) {
-    return 1;
-  }
-
-  RSValue *curSortval = RLookup_GetItem(fvx->sortprop, srcrow);
-  if (!curSortval) {
-    curSortval = &RS_StaticNull;
+static void fvMerge_noSort(Reducer *r, void *instance, void *src) {
+  fvCtx *fvx = instance;
+  const fvCtx *other = src;
+  if (!fvx->value && other->value) {
+    fvx->value = RSValue_IncrRef(other->value);
   }
+}
 
+/* Keep `val` if its sort value comes before the one of the current value */
+static void fvSelect(fvCtx *fvx, RSValue *val, RSValue *curSortval) {
   if (!fvx->sortval) {
     // No current value: assign value and continue
     fvx->value = RSValue_IncrRef(val);
     fvx->sortval = RSValue_IncrRef(curSortval);
-    return 1;
+    return;
   }
 
   int rc = (fvx->ascending ? -1 : 1) * RSValue_Cmp(curSortval, fvx->sortval, NULL);
@@ -74,10 +72,54 @@ static int fvAdd_sort(Reducer *r, void *ctx, const RLookupRow *srcrow) {
     RSVALUE_REPLACE(&fvx->sortval, curSortval);
     RSVALUE_REPLACE(&fvx->value, val);
   }
+}
 
+static int fvAdd_sort(Reducer *r, void *ctx, const RLookupRow *srcrow) {
+  fvCtx *fvx = ctx;
+  RSValue *val = RLookup_GetItem(fvx->retprop, srcrow);
+  if (!val) {
+    return 1;
+  }
+
+  RSValue *curSortval = RLookup_GetItem(fvx->sortprop, srcrow);
+  if (!curSortval) {
+    curSortval = &RS_StaticNull;
+  }
+
+  fvSelect(fvx, val, curSortval);
   return 1;
 }
 
+static void fvMerge_sort(Reducer *r, void *instance, void *src) {
+  const fvCtx *other = src;
+  if (other->sortval) {
+    fvSelect(instance, other->value, other->sortval);
+  }
+}
+
+static void fvSave(Reducer *r, void *instance, BufferWriter *bw) {
+  const fvCtx *fvx = instance;
+  Buffer_WriteU8(bw, !!fvx->value);
+  if (fvx->value) {
+    RSValue_Serialize(fvx->value, bw);
+  }
+  Buffer_WriteU8(bw, !!fvx->sortval);
+  if (fvx->sortval) {
+    RSValue_Serialize(fvx->sortval, bw);
+  }
+}
+
+static void *fvLoad(Reducer *r, BufferReader *br) {
+  fvCtx *fvx = fvNewInstance(r);
+  if (Buffer_ReadU8(br)) {
+    fvx->value = RSValue_Deserialize(br);
+  }
+  if (Buffer_ReadU8(br)) {
+    fvx->sortval = RSValue_Deserialize(br);
+  }
+  return fvx;
+}
+
 static RSValue *fvFinalize(Reducer *parent, void *ctx) {
   fvCtx *fvx = ctx;
   if (fvx->value) {
@@ -93,6 +135,38 @@ static void fvFreeInstance(Reducer *parent, void *p) {
   RSVALUE_CLEARVAR(fvx->sortval);
 }
 
+/* The value along with the value it is sorted by, to be merged by FIRST_VALUE_MERGE */
+static RSValue *fvPartialFinalize(Reducer *parent, void *ctx) {
+  Buffer buf;
+  Buffer_Init(&buf, 64);
+  BufferWriter bw = NewBufferWriter(&buf);
+  fvSave(parent, ctx, &bw);
+  return RS_StringVal(buf.data, buf.offset);
+}
+
+/* Merge the first value of a shard, serialized by the FIRST_VALUE_PARTIAL reducer */
+static int fvMergeAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
+  const RSValue *v = RLookup_GetItem(r->srckey, srcrow);
+  if (!v || !RSValue_IsString(v)) {
+    return 1;
+  }
+  size_t len;
+  const char *str = RSValue_StringPtrLen(v, &len);
+  Buffer buf = {.data = (char *)str, .cap = len, .offset = len};
+  BufferReader br = NewBufferReader(&buf);
+
+  fvCtx other = {0};
+  if (Buffer_ReadU8(&br)) {
+    other.value = RSValue_Deserialize(&br);
+  }
+  if (Buffer_ReadU8(&br)) {
+    other.sortval = RSValue_Deserialize(&br);
+  }
+  r->Merge(r, ctx, &other);
+  fvFreeInstance(r, &other);
+  return 1;
+}
+
 Reducer *RDCRFirstValue_New(const ReducerOptions *options) {
   FVReducer *fvr = rm_calloc(1, sizeof(*fvr));
   fvr->ascending = 1;
@@ -123,6 +197,51 @@ Reducer *RDCRFirstValue_New(const ReducerOptions *options) {
   Reducer *rbase = &fvr->base;
 
   rbase->Add = fvr->sortprop ? fvAdd_sort : fvAdd_noSort;
+  rbase->Merge = fvr->sortprop ? fvMerge_sort : fvMerge_noSort;
+  rbase->Save = fvSave;
+  rbase->Load = fvLoad;
+  rbase->Finalize = fvFinalize;
+  rbase->Free = Reducer_GenericFree;
+  rbase->FreeInstance = fvFreeInstance;
+  rbase->NewInstance = fvNewInstance;
+  return rbase;
+}
+
+Reducer *RDCRFirstValuePartial_New(const ReducerOptions *options) {
+  Reducer *r = RDCRFirstValue_New(options);
+  if (r) {
+    r->Finalize = fvPartialFinalize;
+  }
+  return r;
+}
+
+/* FIRST_VALUE_MERGE {nargs} {partial} [ASC|DESC], where the direction is given if the partial
+ * values are sorted */
+Reducer *RDCRFirstValueMerge_New(const ReducerOptions *options) {
+  FVReducer *fvr = rm_calloc(1, sizeof(*fvr));
+  fvr->ascending = 1;
+  if (!ReducerOpts_GetKey(options, &fvr->base.srckey)) {
+    rm_free(fvr);
+    return NULL;
+  }
+  int sorted = 1;
+  if (AC_AdvanceIfMatch(options->args, "ASC")) {
+    fvr->ascending = 1;
+  } else if (AC_AdvanceIfMatch(options->args, "DESC")) {
+    fvr->ascending = 0;
+  } else {
+    sorted = 0;
+  }
+  if (!ReducerOpts_EnsureArgsConsumed(options)) {
+    rm_free(fvr);
+    return NULL;
+  }
+
+  Reducer *rbase = &fvr->base;
+  rbase->Add = fvMergeAdd;
+  rbase->Merge = sorted ? fvMerge_sort : fvMerge_noSort;
+  rbase->Save = fvSave;
+  rbase->Load = fvLoad;
   rbase->Finalize = fvFinalize;
   rbase->Free = Reducer_GenericFree;
   rbase->FreeInstance = fvFreeInstance;
@@ -55,6 +55,35 @@ static int minmaxAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void minmaxMerge(Reducer *r, void *instance, void *src) {
+  minmaxCtx *m = instance;
+  const minmaxCtx *other = src;
+  if (!other->numMatches) {
+    return;
+  }
+
+  if (m->mode == Minmax_Max && other->val > m->val) {
+    m->val = other->val;
+  } else if (m->mode == Minmax_Min && other->val < m->val) {
+    m->val = other->val;
+  }
+
+  m->numMatches += other->numMatches;
+}
+
+static void minmaxSave(Reducer *r, void *instance, BufferWriter *bw) {
+  const minmaxCtx *m = instance;
+  Buffer_Write(bw, &m->val, sizeof(m->val));
+  Buffer_Write(bw, &m->numMatches, sizeof(m->numMatches));
+}
+
+static void *minmaxLoad(Reducer *r, BufferReader *br) {
+  minmaxCtx *m = minmaxNewInstance(r);
+  Buffer_Read(br, &m->val, sizeof(m->val));
+  Buffer_Read(br, &m->numMatches, sizeof(m->numMatches));
+  return m;
+}
+
 static RSValue *minmaxFinalize(Reducer *parent, void *instance) {
   minmaxCtx *ctx = instance;
   return RS_NumVal(ctx->numMatches ? ctx->val : 0);
@@ -68,6 +97,9 @@ static Reducer *newMinMax(const ReducerOptions *options, MinmaxMode mode) {
   }
   r->base.NewInstance = minmaxNewInstance;
   r->base.Add = minmaxAdd;
+  r->base.Merge = minmaxMerge;
+  r->base.Save = minmaxSave;
+  r->base.Load = minmaxLoad;
   r->base.Finalize = minmaxFinalize;
   r->base.Free = Reducer_GenericFree;
   r->mode = mode;
@@ -6,6 +6,7 @@
 
 #include <aggregate/reducer.h>
 #include "util/quantile.h"
+#include "util/tdigest.h"
 
 typedef struct {
   Reducer base;
@@ -42,6 +43,20 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
   return 1;
 }
 
+static void quantileMerge(Reducer *r, void *instance, void *src) {
+  QS_Merge(instance, src);
+}
+
+static void quantileSave(Reducer *r, void *instance, BufferWriter *bw) {
+  QS_Serialize(instance, bw);
+}
+
+static void *quantileLoad(Reducer *r, BufferReader *br) {
+  QuantStream *qs = quantileNewInstance(r);
+  QS_Deserialize(qs, br);
+  return qs;
+}
+
 static RSValue *quantileFinalize(Reducer *r, void *ctx) {
   QuantStream *qs = ctx;
   QTLReducer *qt = (QTLReducer *)r;
@@ -87,6 +102,9 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
 
   r->base.NewInstance = quantileNewInstance;
   r->base.Add = quantileAdd;
+  r->base.Merge = quantileMerge;
+  r->base.Save = quantileSave;
+  r->base.Load = quantileLoad;
   r->base.Free = Reducer_GenericFree;
   r->base.FreeInstance = quantileFreeInstance;
   r->base.Finalize = quantileFinalize;
@@ -96,3 +114,124 @@ error:
   rm_free(r);
   return NULL;
 }
+
+static void *tdigestNewInstance(Reducer *r) {
+  return NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+}
+
+static int tdigestAdd(Reducer *r, void *ctx, const RLookupRow *row) {
+  double d;
+  RSValue *v = RLookup_GetItem(r->srckey, row);
+  if (!v) {
+    return 1;
+  }
+
+  if (v->t != RSValue_Array) {
+    if (RSValue_ToNumber(v, &d)) {
+      TDigest_Add(ctx, d);
+    }
+  } else {
+    uint32_t sz = RSValue_ArrayLen(v);
+    for (uint32_t i = 0; i < sz; i++) {
+      if (RSValue_ToNumber(RSValue_ArrayItem(v, i), &d)) {
+        TDigest_Add(ctx, d);
+      }
+    }
+  }
+  return 1;
+}
+
+/* Merge a digest serialized by the TDIGEST reducer */
+static int tdigestMergeAdd(Reducer *r, void *ctx, const RLookupRow *row) {
+  const RSValue *v = RLookup_GetItem(r->srckey, row);
+  if (!v || !RSValue_IsString(v)) {
+    return 0;
+  }
+  size_t len;
+  const char *str = RSValue_StringPtrLen(v, &len);
+  Buffer buf = {.data = (char *)str, .cap = len, .offset = len};
+  BufferReader br = NewBufferReader(&buf);
+  return TDigest_Deserialize(ctx, &br);
+}
+
+static void tdigestMerge(Reducer *r, void *instance, void *src) {
+  TDigest_Merge(instance, src);
+}
+
+static void tdigestSave(Reducer *r, void *instance, BufferWriter *bw) {
+  TDigest_Serialize(instance, bw);
+}
+
+static void *tdigestLoad(Reducer *r, BufferReader *br) {
+  TDigest *td = tdigestNewInstance(r);
+  TDigest_Deserialize(td, br);
+  return td;
+}
+
+/* The digest itself, to be merged by TDIGEST_QUANTILE */
+static RSValue *tdigestFinalize(Reducer *r, void *ctx) {
+  Buffer buf;
+  Buffer_Init(&buf, 64);
+  BufferWriter bw = NewBufferWriter(&buf);
+  TDigest_Serialize(ctx, &bw);
+  return RS_StringVal(buf.data, buf.offset);
+}
+
+static RSValue *tdigestQuantileFinalize(Reducer *r, void *ctx) {
+  QTLReducer *qt = (QTLReducer *)r;
+  return RS_NumVal(TDigest_Quantile(ctx, qt->pct));
+}
+
+static void tdigestFreeInstance(Reducer *unused, void *p) {
+  TDigest_Free(p);
+}
+
+static Reducer *newTDigestCommon(const ReducerOptions *options, bool quantile) {
+  QTLReducer *r = rm_calloc(1, sizeof(*r));
+  if (!ReducerOptions_GetKey(options, &r->base.srckey)) {
+    goto error;
+  }
+  if (quantile) {
+    int rv;
+    if ((rv = AC_GetDouble(options->args, &r->pct, 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(options->status, options->name, rv);
+      goto error;
+    }
+    if (!(r->pct >= 0 && r->pct <= 1.0)) {
+      QERR_MKBADARGS_FMT(options->status, "Percentage must be between 0.0 and 1.0");
+      goto error;
+    }
+  }
+  if (!ReducerOpts_EnsureArgsConsumed(options)) {
+    goto error;
+  }
+
+  if (quantile) {
+    r->base.reducerId = REDUCER_T_TDIGEST_QUANTILE;
+    r->base.Add = tdigestMergeAdd;
+    r->base.Finalize = tdigestQuantileFinalize;
+  } else {
+    r->base.reducerId = REDUCER_T_TDIGEST;
+    r->base.Add = tdigestAdd;
+    r->base.Finalize = tdigestFinalize;
+  }
+  r->base.NewInstance = tdigestNewInstance;
+  r->base.Merge = tdigestMerge;
+  r->base.Save = tdigestSave;
+  r->base.Load = tdigestLoad;
+  r->base.Free = Reducer_GenericFree;
+  r->base.FreeInstance = tdigestFreeInstance;
+  return &r->base;
+
+error:
+  rm_free(r);
+  return NULL;
+}
+
+Reducer *RDCRTDigest_New(const ReducerOptions *options) {
+  return newTDigestCommon(options, false);
+}
+
+Reducer *RDCRTDigestQuantile_New(const ReducerOptions *options) {
+  return newTDigestCommon(options, true);
+}
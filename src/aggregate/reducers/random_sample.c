@@ -47,6 +47,65 @@ static int sampleAdd(Reducer *rbase, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+/* Take a random sample out of the first `*len` values of `vals`, moving it past them */
+static RSValue *takeSample(RSValue **vals, size_t *len) {
+  size_t i = rand() % *len;
+  RSValue *v = vals[i];
+  vals[i] = vals[--*len];
+  vals[*len] = v;
+  return v;
+}
+
+static void sampleMerge(Reducer *rbase, void *instance, void *src) {
+  RSMPLReducer *r = (RSMPLReducer *)rbase;
+  rsmplCtx *sc = instance;
+  rsmplCtx *other = src;
+  if (!other->seen) {
+    return;
+  }
+
+  // Every value is taken from either sample in proportion to the number of values the sample was
+  // taken out of, so that the values seen by both are sampled alike
+  size_t len = RSVALUE_ARRLEN(sc->samplesArray);
+  size_t otherLen = RSVALUE_ARRLEN(other->samplesArray);
+  RSValue *merged = RSValue_NewArrayEx(NULL, r->len, 0);
+  while (RSVALUE_ARRLEN(merged) < r->len && (len || otherLen)) {
+    RSValue *v;
+    if (!otherLen || (len && rand() % (sc->seen + other->seen) < sc->seen)) {
+      v = takeSample(sc->samplesArray->arrval.vals, &len);
+    } else {
+      v = takeSample(other->samplesArray->arrval.vals, &otherLen);
+    }
+    RSVALUE_ARRELEM(merged, RSVALUE_ARRLEN(merged)++) = RSValue_IncrRef(v);
+  }
+  RSValue_Decref(sc->samplesArray);
+  sc->samplesArray = merged;
+  sc->seen += other->seen;
+}
+
+static void sampleSave(Reducer *rbase, void *instance, BufferWriter *bw) {
+  const rsmplCtx *sc = instance;
+  uint64_t seen = sc->seen;
+  Buffer_Write(bw, &seen, sizeof(seen));
+  Buffer_WriteU32(bw, RSVALUE_ARRLEN(sc->samplesArray));
+  for (uint32_t i = 0; i < RSVALUE_ARRLEN(sc->samplesArray); i++) {
+    RSValue_Serialize(RSVALUE_ARRELEM(sc->samplesArray, i), bw);
+  }
+}
+
+static void *sampleLoad(Reducer *rbase, BufferReader *br) {
+  rsmplCtx *sc = sampleNewInstance(rbase);
+  uint64_t seen;
+  Buffer_Read(br, &seen, sizeof(seen));
+  sc->seen = seen;
+  uint32_t len = Buffer_ReadU32(br);
+  for (uint32_t i = 0; i < len; i++) {
+    RSVALUE_ARRELEM(sc->samplesArray, i) = RSValue_Deserialize(br);
+  }
+  RSVALUE_ARRLEN(sc->samplesArray) = len;
+  return sc;
+}
+
 static RSValue *sampleFinalize(Reducer *rbase, void *ctx) {
   rsmplCtx *sc = ctx;
   RSMPLReducer *r = (RSMPLReducer *)rbase;
@@ -86,6 +145,9 @@ Reducer *RDCRRandomSample_New(const ReducerOptions *options) {
   ret->len = samplesize;
   Reducer *rbase = &ret->base;
   rbase->Add = sampleAdd;
+  rbase->Merge = sampleMerge;
+  rbase->Save = sampleSave;
+  rbase->Load = sampleLoad;
   rbase->Finalize = sampleFinalize;
   rbase->Free = Reducer_GenericFree;
   rbase->FreeInstance = sampleFreeInstance;
@@ -42,6 +42,26 @@ static int sumAdd(Reducer *baseparent, void *instance, const RLookupRow *row) {
   return 1;
 }
 
+static void sumMerge(Reducer *baseparent, void *instance, void *src) {
+  sumCtx *ctr = instance;
+  const sumCtx *other = src;
+  ctr->count += other->count;
+  ctr->total += other->total;
+}
+
+static void sumSave(Reducer *baseparent, void *instance, BufferWriter *bw) {
+  const sumCtx *ctr = instance;
+  Buffer_Write(bw, &ctr->count, sizeof(ctr->count));
+  Buffer_Write(bw, &ctr->total, sizeof(ctr->total));
+}
+
+static void *sumLoad(Reducer *baseparent, BufferReader *br) {
+  sumCtx *ctr = sumNewInstance(baseparent);
+  Buffer_Read(br, &ctr->count, sizeof(ctr->count));
+  Buffer_Read(br, &ctr->total, sizeof(ctr->total));
+  return ctr;
+}
+
 static RSValue *sumFinalize(Reducer *baseparent, void *instance) {
   sumCtx *ctr = instance;
   SumReducer *parent = (SumReducer *)baseparent;
@@ -64,6 +84,9 @@ static Reducer *newReducerCommon(const ReducerOptions *options, int isAvg) {
   }
   r->base.NewInstance = sumNewInstance;
   r->base.Add = sumAdd;
+  r->base.Merge = sumMerge;
+  r->base.Save = sumSave;
+  r->base.Load = sumLoad;
   r->base.Finalize = sumFinalize;
   r->base.Free = Reducer_GenericFree;
   r->isAvg = isAvg;
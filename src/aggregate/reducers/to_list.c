@@ -48,6 +48,47 @@ static int tolistAdd(Reducer *rbase, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void tolistMerge(Reducer *rbase, void *instance, void *src) {
+  tolistCtx *tlc = instance;
+  const tolistCtx *other = src;
+  TrieMapIterator *it = TrieMap_Iterate(other->values, "", 0);
+  char *c;
+  tm_len_t l;
+  void *ptr;
+  while (TrieMapIterator_Next(it, &c, &l, &ptr)) {
+    if (ptr && TrieMap_Find(tlc->values, c, l) == TRIEMAP_NOTFOUND) {
+      TrieMap_Add(tlc->values, c, l, RSValue_IncrRef(ptr), NULL);
+    }
+  }
+  TrieMapIterator_Free(it);
+}
+
+static void tolistSave(Reducer *rbase, void *instance, BufferWriter *bw) {
+  const tolistCtx *tlc = instance;
+  Buffer_WriteU32(bw, tlc->values->cardinality);
+  TrieMapIterator *it = TrieMap_Iterate(tlc->values, "", 0);
+  char *c;
+  tm_len_t l;
+  void *ptr;
+  while (TrieMapIterator_Next(it, &c, &l, &ptr)) {
+    // the key is the hash of the value
+    Buffer_Write(bw, c, sizeof(uint64_t));
+    RSValue_Serialize(ptr, bw);
+  }
+  TrieMapIterator_Free(it);
+}
+
+static void *tolistLoad(Reducer *rbase, BufferReader *br) {
+  tolistCtx *tlc = tolistNewInstance(rbase);
+  uint32_t len = Buffer_ReadU32(br);
+  for (uint32_t i = 0; i < len; i++) {
+    uint64_t hval;
+    Buffer_Read(br, &hval, sizeof(hval));
+    TrieMap_Add(tlc->values, (char *)&hval, sizeof(hval), RSValue_Deserialize(br), NULL);
+  }
+  return tlc;
+}
+
 static RSValue *tolistFinalize(Reducer *rbase, void *ctx) {
   tolistCtx *tlc = ctx;
   TrieMapIterator *it = TrieMap_Iterate(tlc->values, "", 0);
@@ -83,6 +124,9 @@ Reducer *RDCRToList_New(const ReducerOptions *opts) {
     return NULL;
   }
   r->Add = tolistAdd;
+  r->Merge = tolistMerge;
+  r->Save = tolistSave;
+  r->Load = tolistLoad;
   r->Finalize = tolistFinalize;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = tolistFreeInstance;
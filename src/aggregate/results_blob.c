@@ -0,0 +1,202 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "results_blob.h"
+#include "rmalloc.h"
+#include "redismodule.h"
+#include "miniz/miniz.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// version, flags, number of rows, total results, payload length
+#define RESULTS_BLOB_HEADER_LEN (1 + 1 + 4 + 8 + 4)
+
+void ResultsBlobWriter_Init(ResultsBlobWriter *w, const char **names, const size_t *nameLens,
+                            size_t ncols) {
+  w->ncols = ncols;
+  w->names = rm_malloc(ncols * sizeof(*w->names));
+  w->nameLens = rm_malloc(ncols * sizeof(*w->nameLens));
+  w->columns = rm_malloc(ncols * sizeof(*w->columns));
+  for (size_t ii = 0; ii < ncols; ++ii) {
+    w->names[ii] = names[ii];
+    w->nameLens[ii] = nameLens[ii];
+    Buffer_Init(&w->columns[ii], 256);
+  }
+  w->nrows = 0;
+}
+
+void ResultsBlobWriter_Write(ResultsBlobWriter *w, size_t col, const RSValue *v) {
+  BufferWriter bw = NewBufferWriter(&w->columns[col]);
+  if (v) {
+    RSValue_Serialize(v, &bw);
+  } else {
+    Buffer_WriteU8(&bw, RSValue_Undef);
+  }
+}
+
+char *ResultsBlobWriter_Finish(ResultsBlobWriter *w, uint64_t totalResults, uint8_t flags,
+                               size_t *len) {
+  Buffer payload;
+  size_t payloadLen = 4;
+  for (size_t ii = 0; ii < w->ncols; ++ii) {
+    payloadLen += 4 + w->nameLens[ii] + 4 + Buffer_Offset(&w->columns[ii]);
+  }
+  Buffer_Init(&payload, payloadLen);
+  BufferWriter bw = NewBufferWriter(&payload);
+  Buffer_WriteU32(&bw, w->ncols);
+  for (size_t ii = 0; ii < w->ncols; ++ii) {
+    Buffer_WriteU32(&bw, w->nameLens[ii]);
+    Buffer_Write(&bw, w->names[ii], w->nameLens[ii]);
+    Buffer_WriteU32(&bw, Buffer_Offset(&w->columns[ii]));
+  }
+  for (size_t ii = 0; ii < w->ncols; ++ii) {
+    Buffer_Write(&bw, w->columns[ii].data, Buffer_Offset(&w->columns[ii]));
+    w->columns[ii].offset = 0;
+  }
+
+  char *blob = NULL;
+  size_t bodyLen = payloadLen;
+  if (payloadLen >= RESULTS_BLOB_COMPRESS_THRESHOLD) {
+    mz_ulong deflatedLen = mz_compressBound(payloadLen);
+    blob = rm_malloc(RESULTS_BLOB_HEADER_LEN + deflatedLen);
+    if (mz_compress2((unsigned char *)blob + RESULTS_BLOB_HEADER_LEN, &deflatedLen,
+                     (const unsigned char *)payload.data, payloadLen, MZ_BEST_SPEED) == MZ_OK &&
+        deflatedLen < payloadLen) {
+      flags |= RESULTS_BLOB_F_COMPRESSED;
+      bodyLen = deflatedLen;
+    } else {
+      rm_free(blob);
+      blob = NULL;
+    }
+  }
+  if (!blob) {
+    flags &= ~RESULTS_BLOB_F_COMPRESSED;
+    blob = rm_malloc(RESULTS_BLOB_HEADER_LEN + payloadLen);
+    memcpy(blob + RESULTS_BLOB_HEADER_LEN, payload.data, payloadLen);
+  }
+  Buffer_Free(&payload);
+
+  char *header = blob;
+  uint32_t nrows = w->nrows, rawLen = payloadLen;
+  header[0] = RESULTS_BLOB_VERSION;
+  header[1] = flags;
+  memcpy(header + 2, &nrows, sizeof(nrows));
+  memcpy(header + 6, &totalResults, sizeof(totalResults));
+  memcpy(header + 14, &rawLen, sizeof(rawLen));
+
+  w->nrows = 0;
+  *len = RESULTS_BLOB_HEADER_LEN + bodyLen;
+  return blob;
+}
+
+void ResultsBlobWriter_Free(ResultsBlobWriter *w) {
+  for (size_t ii = 0; ii < w->ncols; ++ii) {
+    Buffer_Free(&w->columns[ii]);
+  }
+  rm_free(w->columns);
+  rm_free(w->names);
+  rm_free(w->nameLens);
+}
+
+int ResultsBlob_Peek(const char *data, size_t len, uint32_t *nrows) {
+  if (len < RESULTS_BLOB_HEADER_LEN || data[0] != RESULTS_BLOB_VERSION) {
+    return REDISMODULE_ERR;
+  }
+  memcpy(nrows, data + 2, sizeof(*nrows));
+  return REDISMODULE_OK;
+}
+
+int ResultsBlob_Open(ResultsBlob *rb, const char *data, size_t len) {
+  *rb = (ResultsBlob){0};
+  if (ResultsBlob_Peek(data, len, &rb->nrows) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  rb->flags = data[1];
+  memcpy(&rb->totalResults, data + 6, sizeof(rb->totalResults));
+  uint32_t rawLen;
+  memcpy(&rawLen, data + 14, sizeof(rawLen));
+
+  const char *payload = data + RESULTS_BLOB_HEADER_LEN;
+  size_t payloadLen = len - RESULTS_BLOB_HEADER_LEN;
+  if (rb->flags & RESULTS_BLOB_F_COMPRESSED) {
+    mz_ulong inflatedLen = rawLen;
+    rb->inflated = rm_malloc(rawLen);
+    if (mz_uncompress((unsigned char *)rb->inflated, &inflatedLen, (const unsigned char *)payload,
+                      payloadLen) != MZ_OK || inflatedLen != rawLen) {
+      goto error;
+    }
+    payload = rb->inflated;
+    payloadLen = rawLen;
+  } else if (payloadLen != rawLen) {
+    goto error;
+  }
+
+  // The schema, then the data of the columns in turn
+  const char *p = payload, *end = payload + payloadLen;
+  uint32_t ncols;
+  if (end - p < 4) {
+    goto error;
+  }
+  memcpy(&ncols, p, 4);
+  p += 4;
+  rb->ncols = ncols;
+  rb->names = rm_calloc(ncols, sizeof(*rb->names));
+  rb->nameLens = rm_calloc(ncols, sizeof(*rb->nameLens));
+  rb->columnBufs = rm_calloc(ncols, sizeof(*rb->columnBufs));
+  rb->columns = rm_calloc(ncols, sizeof(*rb->columns));
+  for (size_t ii = 0; ii < ncols; ++ii) {
+    uint32_t nameLen, colLen;
+    if (end - p < 4) {
+      goto error;
+    }
+    memcpy(&nameLen, p, 4);
+    p += 4;
+    if (end - p < (ptrdiff_t)nameLen + 4) {
+      goto error;
+    }
+    rb->names[ii] = p;
+    rb->nameLens[ii] = nameLen;
+    p += nameLen;
+    memcpy(&colLen, p, 4);
+    p += 4;
+    rb->columnBufs[ii].cap = rb->columnBufs[ii].offset = colLen;
+  }
+  for (size_t ii = 0; ii < ncols; ++ii) {
+    if (end - p < (ptrdiff_t)rb->columnBufs[ii].cap) {
+      goto error;
+    }
+    rb->columnBufs[ii].data = (char *)p;
+    rb->columns[ii] = NewBufferReader(&rb->columnBufs[ii]);
+    p += rb->columnBufs[ii].cap;
+  }
+  return REDISMODULE_OK;
+
+error:
+  ResultsBlob_Close(rb);
+  return REDISMODULE_ERR;
+}
+
+RSValue *ResultsBlob_Read(ResultsBlob *rb, size_t col) {
+  BufferReader *br = &rb->columns[col];
+  if (BufferReader_AtEnd(br)) {
+    return NULL;
+  }
+  if (br->buf->data[br->pos] == RSValue_Undef) {
+    br->pos++;
+    return NULL;
+  }
+  return RSValue_Deserialize(br);
+}
+
+void ResultsBlob_Close(ResultsBlob *rb) {
+  rm_free(rb->names);
+  rm_free(rb->nameLens);
+  rm_free(rb->columnBufs);
+  rm_free(rb->columns);
+  rm_free(rb->inflated);
+  *rb = (ResultsBlob){0};
+}
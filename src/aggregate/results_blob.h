@@ -0,0 +1,104 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_RESULTS_BLOB_H
+#define RS_RESULTS_BLOB_H
+
+#include "buffer.h"
+#include "value.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The binary format of a chunk of aggregate results, which the shards reply to the coordinator
+ * with instead of RESP when it passes _BINARY (see QEXEC_F_BINARY_REPLY).
+ *
+ * A blob starts with a fixed header:
+ *
+ *   u8 version, u8 flags, u32 number of rows, u64 total results, u32 payload length
+ *
+ * followed by the payload, deflated if RESULTS_BLOB_F_COMPRESSED is set:
+ *
+ *   u32 number of columns
+ *   per column: u32 name length, name, u32 length of the column data
+ *   per column: the value of every row, written by RSValue_Serialize, or a single RSValue_Undef
+ *               byte if the row does not have the field
+ *
+ * The schema is sent once per chunk, and numbers are sent as doubles. Integers are written in the
+ * byte order of the host, so the shards and the coordinator are assumed to share it.
+ */
+
+#define RESULTS_BLOB_VERSION 1
+
+/* The payload is deflated */
+#define RESULTS_BLOB_F_COMPRESSED 0x01
+/* The shard replies with the compound values expanded (see QEXEC_FORMAT_EXPAND) */
+#define RESULTS_BLOB_F_EXPAND 0x02
+
+/* The payload size from which it is deflated */
+#define RESULTS_BLOB_COMPRESS_THRESHOLD (64 * 1024)
+
+typedef struct {
+  size_t ncols;
+  const char **names;
+  size_t *nameLens;
+  Buffer *columns;
+  uint32_t nrows;
+} ResultsBlobWriter;
+
+/* The columns are named by `names`, which should outlive the writer */
+void ResultsBlobWriter_Init(ResultsBlobWriter *w, const char **names, const size_t *nameLens,
+                            size_t ncols);
+
+/* Write the value of a column in the current row, NULL if the row does not have it. Every column
+ * should be written once per row, before ResultsBlobWriter_EndRow */
+void ResultsBlobWriter_Write(ResultsBlobWriter *w, size_t col, const RSValue *v);
+
+static inline void ResultsBlobWriter_EndRow(ResultsBlobWriter *w) {
+  w->nrows++;
+}
+
+/* Return the blob of the rows written so far, allocated with rm_malloc, and its length in
+ * `*len`. The writer is emptied, to write the rows of the next blob */
+char *ResultsBlobWriter_Finish(ResultsBlobWriter *w, uint64_t totalResults, uint8_t flags,
+                               size_t *len);
+
+void ResultsBlobWriter_Free(ResultsBlobWriter *w);
+
+typedef struct {
+  uint8_t flags;
+  uint32_t nrows;
+  uint64_t totalResults;
+  size_t ncols;
+  const char **names;
+  size_t *nameLens;
+  // The data of every column, and its reader positioned at the value of the next row
+  Buffer *columnBufs;
+  BufferReader *columns;
+  // The inflated payload, NULL if the columns point into the blob
+  char *inflated;
+} ResultsBlob;
+
+/* Return whether the header of a blob is valid, along with its number of rows */
+int ResultsBlob_Peek(const char *data, size_t len, uint32_t *nrows);
+
+/* Open a blob for reading, inflating it if needed. The blob should outlive the reader. Returns
+ * REDISMODULE_ERR if it is malformed */
+int ResultsBlob_Open(ResultsBlob *rb, const char *data, size_t len);
+
+/* Read the value of a column in the next row, owned by the caller, or NULL if the row does not
+ * have it. Every column should be read once per row */
+RSValue *ResultsBlob_Read(ResultsBlob *rb, size_t col);
+
+void ResultsBlob_Close(ResultsBlob *rb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_RESULTS_BLOB_H
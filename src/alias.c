@@ -112,6 +112,20 @@ StrongRef IndexAlias_Get(const char *alias) {
   return AliasTable_Get(AliasTable_g, alias);
 }
 
+void IndexSpec_MoveAliases(StrongRef from_ref, StrongRef to_ref) {
+  IndexSpec *from = StrongRef_Get(from_ref);
+  // deleting an alias removes it from the array
+  while (from->aliases && array_len(from->aliases)) {
+    char *alias = rm_strdup(from->aliases[array_len(from->aliases) - 1]);
+    QueryError e = {0};
+    int rc = IndexAlias_Del(alias, from_ref, 0, &e);
+    RS_LOG_ASSERT(rc == REDISMODULE_OK, "Alias delete has failed");
+    rc = IndexAlias_Add(alias, to_ref, 0, &e);
+    RS_LOG_ASSERT(rc == REDISMODULE_OK, "Alias add has failed");
+    rm_free(alias);
+  }
+}
+
 void IndexSpec_ClearAliases(StrongRef spec_ref) {
   IndexSpec *sp = StrongRef_Get(spec_ref);
   for (size_t ii = 0; ii < array_len(sp->aliases); ++ii) {
@@ -0,0 +1,138 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "alloc_stats.h"
+#include "reply.h"
+#include "util/timeout.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *tagNames[ALLOC_TAG_COUNT] = {
+    [ALLOC_TAG_OTHER] = "other",
+    [ALLOC_TAG_INVIDX] = "inverted_index",
+    [ALLOC_TAG_NUMERIC] = "numeric",
+    [ALLOC_TAG_TAG] = "tag",
+    [ALLOC_TAG_TRIE] = "trie",
+    [ALLOC_TAG_DOCTABLE] = "doc_table",
+    [ALLOC_TAG_SORTABLES] = "sortables",
+    [ALLOC_TAG_QUERY] = "query",
+    [ALLOC_TAG_COORD] = "coordinator",
+};
+
+const char *AllocStats_TagName(AllocTag tag) {
+  return tagNames[tag];
+}
+
+#ifdef RS_ALLOC_STATS
+
+__thread AllocTag allocTag_g = ALLOC_TAG_OTHER;
+__thread AllocThreadStats *allocThreadStats_g = NULL;
+
+// The counters of all the threads that ever allocated. They are kept when a thread exits, as the
+// memory it allocated may still be live
+static AllocThreadStats *threads_g = NULL;
+static pthread_mutex_t threadsLock_g = PTHREAD_MUTEX_INITIALIZER;
+
+AllocThreadStats *AllocStats_RegisterThread(void) {
+  // not rm_calloc, which would count the allocation to the thread being registered
+  AllocThreadStats *s = calloc(1, sizeof(*s));
+  pthread_mutex_lock(&threadsLock_g);
+  s->next = threads_g;
+  threads_g = s;
+  pthread_mutex_unlock(&threadsLock_g);
+  allocThreadStats_g = s;
+  return s;
+}
+
+bool AllocStats_Enabled(void) {
+  return true;
+}
+
+void AllocStats_Get(AllocTag tag, AllocCounters *out) {
+  memset(out, 0, sizeof(*out));
+  pthread_mutex_lock(&threadsLock_g);
+  for (AllocThreadStats *s = threads_g; s; s = s->next) {
+    // the counters are written by their thread only, a read may miss its last increments
+    AllocCounters *c = &s->tags[tag];
+    out->allocs += __atomic_load_n(&c->allocs, __ATOMIC_RELAXED);
+    out->frees += __atomic_load_n(&c->frees, __ATOMIC_RELAXED);
+    out->allocBytes += __atomic_load_n(&c->allocBytes, __ATOMIC_RELAXED);
+    out->freeBytes += __atomic_load_n(&c->freeBytes, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&threadsLock_g);
+}
+
+#else
+
+bool AllocStats_Enabled(void) {
+  return false;
+}
+
+void AllocStats_Get(AllocTag tag, AllocCounters *out) {
+  memset(out, 0, sizeof(*out));
+}
+
+#endif  // RS_ALLOC_STATS
+
+static inline long long liveBytes(const AllocCounters *c) {
+  return (long long)c->allocBytes - (long long)c->freeBytes;
+}
+
+// The counters at the previous reply, to report the rates since. Replied on the main thread only
+static AllocCounters lastReply_g[ALLOC_TAG_COUNT];
+static struct timespec lastReplyTime_g;
+
+void AllocStats_Reply(RedisModule_Reply *reply) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  double secs = 0;
+  if (lastReplyTime_g.tv_sec || lastReplyTime_g.tv_nsec) {
+    struct timespec elapsed;
+    rs_timersub(&now, &lastReplyTime_g, &elapsed);
+    secs = elapsed.tv_sec + elapsed.tv_nsec / 1e9;
+  }
+
+  RedisModule_Reply_Map(reply);
+  for (int t = 0; t < ALLOC_TAG_COUNT; t++) {
+    AllocCounters c;
+    AllocStats_Get(t, &c);
+    RedisModule_ReplyKV_Map(reply, tagNames[t]);
+    RedisModule_ReplyKV_LongLong(reply, "live_bytes", liveBytes(&c));
+    RedisModule_ReplyKV_LongLong(reply, "allocations", c.allocs);
+    RedisModule_ReplyKV_LongLong(reply, "frees", c.frees);
+    RedisModule_ReplyKV_LongLong(reply, "allocated_bytes", c.allocBytes);
+    RedisModule_ReplyKV_LongLong(reply, "freed_bytes", c.freeBytes);
+    // the rates since the previous reply, 0 on the first one
+    RedisModule_ReplyKV_Double(reply, "allocations_per_sec",
+                               secs > 0 ? (c.allocs - lastReply_g[t].allocs) / secs : 0);
+    RedisModule_ReplyKV_Double(reply, "allocated_bytes_per_sec",
+                               secs > 0 ? (c.allocBytes - lastReply_g[t].allocBytes) / secs : 0);
+    RedisModule_Reply_MapEnd(reply);
+    lastReply_g[t] = c;
+  }
+  RedisModule_Reply_MapEnd(reply);
+  lastReplyTime_g = now;
+}
+
+void AllocStats_AddToInfo(RedisModuleInfoCtx *ctx) {
+  if (!AllocStats_Enabled()) {
+    return;
+  }
+  RedisModule_InfoAddSection(ctx, "allocations");
+  for (int t = 0; t < ALLOC_TAG_COUNT; t++) {
+    AllocCounters c;
+    AllocStats_Get(t, &c);
+    RedisModule_InfoBeginDictField(ctx, tagNames[t]);
+    RedisModule_InfoAddFieldLongLong(ctx, "live_bytes", liveBytes(&c));
+    RedisModule_InfoAddFieldULongLong(ctx, "allocations", c.allocs);
+    RedisModule_InfoAddFieldULongLong(ctx, "frees", c.frees);
+    RedisModule_InfoAddFieldULongLong(ctx, "allocated_bytes", c.allocBytes);
+    RedisModule_InfoEndDictField(ctx);
+  }
+}
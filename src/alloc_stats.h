@@ -0,0 +1,133 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The allocations made through rm_malloc and friends, counted by the subsystem that made them.
+ *
+ * Built only with RS_ALLOC_STATS (`make ALLOC_STATS=1`), otherwise the tags below are no-ops and
+ * rm_malloc is not instrumented at all. A thread allocates on behalf of the subsystem it tagged
+ * itself with, and counts the allocation in its own counters, so that counting is a couple of
+ * increments of thread local memory. The counters of all the threads are summed when read.
+ *
+ * A free is counted to the tag of the thread freeing, so the live bytes of a subsystem are exact
+ * as long as its structures are allocated and freed under its tag. Memory moving from one
+ * subsystem to another (e.g. the blocks the fork GC receives from its child) shows up as live in
+ * the first and negative in the second */
+
+typedef enum {
+  ALLOC_TAG_OTHER,
+  ALLOC_TAG_INVIDX,     // the inverted indexes of the terms
+  ALLOC_TAG_NUMERIC,    // the numeric range trees
+  ALLOC_TAG_TAG,        // the tag indexes
+  ALLOC_TAG_TRIE,       // the tries of the terms and the suggestions
+  ALLOC_TAG_DOCTABLE,   // the document table and the metadata of the documents
+  ALLOC_TAG_SORTABLES,  // the sorting vectors
+  ALLOC_TAG_QUERY,      // the execution of the queries
+  ALLOC_TAG_COORD,      // the coordinator
+  ALLOC_TAG_COUNT
+} AllocTag;
+
+typedef struct {
+  size_t allocs;
+  size_t frees;
+  size_t allocBytes;
+  size_t freeBytes;
+} AllocCounters;
+
+#ifdef RS_ALLOC_STATS
+
+typedef struct AllocThreadStats {
+  AllocCounters tags[ALLOC_TAG_COUNT];
+  struct AllocThreadStats *next;
+} AllocThreadStats;
+
+extern __thread AllocTag allocTag_g;
+extern __thread AllocThreadStats *allocThreadStats_g;
+
+/* The counters of the calling thread, allocated on its first allocation */
+AllocThreadStats *AllocStats_RegisterThread(void);
+
+static inline AllocCounters *AllocStats_Counters(void) {
+  AllocThreadStats *s = allocThreadStats_g;
+  if (__builtin_expect(!s, 0)) {
+    s = AllocStats_RegisterThread();
+  }
+  return &s->tags[allocTag_g];
+}
+
+static inline void AllocStats_OnAlloc(void *p) {
+  if (p) {
+    AllocCounters *c = AllocStats_Counters();
+    c->allocs++;
+    c->allocBytes += RedisModule_MallocSize(p);
+  }
+}
+
+static inline void AllocStats_OnFree(void *p) {
+  if (p) {
+    AllocCounters *c = AllocStats_Counters();
+    c->frees++;
+    c->freeBytes += RedisModule_MallocSize(p);
+  }
+}
+
+/* Tag the allocations of the calling thread with `tag`, returning the previous tag to restore */
+static inline AllocTag AllocStats_SetTag(AllocTag tag) {
+  AllocTag prev = allocTag_g;
+  allocTag_g = tag;
+  return prev;
+}
+
+/* As AllocStats_SetTag, unless the thread is already tagged. For code shared by the subsystems,
+ * such as the inverted indexes, whose allocations belong to the subsystem calling them */
+static inline AllocTag AllocStats_SetDefaultTag(AllocTag tag) {
+  AllocTag prev = allocTag_g;
+  if (prev == ALLOC_TAG_OTHER) {
+    allocTag_g = tag;
+  }
+  return prev;
+}
+
+#else
+
+static inline AllocTag AllocStats_SetTag(AllocTag tag) {
+  return ALLOC_TAG_OTHER;
+}
+
+static inline AllocTag AllocStats_SetDefaultTag(AllocTag tag) {
+  return ALLOC_TAG_OTHER;
+}
+
+#endif  // RS_ALLOC_STATS
+
+bool AllocStats_Enabled(void);
+
+/* The counters of `tag` summed over all the threads */
+void AllocStats_Get(AllocTag tag, AllocCounters *out);
+
+const char *AllocStats_TagName(AllocTag tag);
+
+/* Reply with a map of the tags to their live bytes, their allocations and frees, and their rate
+ * of allocations since the previous call */
+struct RedisModule_Reply;
+void AllocStats_Reply(struct RedisModule_Reply *reply);
+
+/* Add the counters to INFO as an `allocations` section, if they are built */
+void AllocStats_AddToInfo(RedisModuleInfoCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
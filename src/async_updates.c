@@ -0,0 +1,309 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "async_updates.h"
+#include "spec.h"
+#include "config.h"
+#include "doc_types.h"
+#include "rules.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "util/logging.h"
+#include "util/minmax.h"
+#include "thpool/thpool.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// The keys the background thread indexes each time it holds the GIL
+#define ASYNC_UPDATES_BATCH_SIZE 1000
+
+typedef struct {
+  RedisModuleString *key;
+  long long written;  // monotonic time, in milliseconds, of the first write since it was queued
+} AsyncKey;
+
+struct AsyncUpdates {
+  arrayof(AsyncKey) queue;  // the queued keys in the order they were first written, from `head`
+  size_t head;
+  dict *pending;            // the keys in the queue, owned by it
+  size_t drained;
+  bool scheduled;           // whether the spec is in the specs the background thread (or the batch
+                            // timer) drains
+};
+
+static redisearch_threadpool asyncUpdatesPool = NULL;
+static arrayof(WeakRef) scheduledSpecs_g = NULL;
+static bool drainTaskRunning_g = false;
+
+// The specs with keys batched by BATCH_WRITES, drained by a timer firing on the next event-loop
+// iteration
+static arrayof(WeakRef) batchedSpecs_g = NULL;
+static RedisModuleTimerID batchTimer_g;
+static bool batchTimerSet_g = false;
+
+static long long monotonicMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+static uint64_t pendingHash(const void *key) {
+  size_t len;
+  const char *str = RedisModule_StringPtrLen((RedisModuleString *)key, &len);
+  return dictGenHashFunction(str, len);
+}
+
+static int pendingCompare(void *privdata, const void *key1, const void *key2) {
+  return RedisModule_StringCompare((RedisModuleString *)key1, (RedisModuleString *)key2) == 0;
+}
+
+static dictType pendingDictType = {
+    .hashFunction = pendingHash,
+    .keyCompare = pendingCompare,
+};
+
+static void AsyncUpdates_DrainTask(void *unused);
+
+static void AsyncUpdates_Schedule(IndexSpec *sp) {
+  sp->asyncUpdates->scheduled = true;
+  if (!scheduledSpecs_g) {
+    scheduledSpecs_g = array_new(WeakRef, 8);
+  }
+  scheduledSpecs_g = array_append(scheduledSpecs_g, StrongRef_Demote(sp->own_ref));
+  if (drainTaskRunning_g) {
+    return;
+  }
+  if (!asyncUpdatesPool) {
+    asyncUpdatesPool = redisearch_thpool_create(1, DEFAULT_PRIVILEGED_THREADS_NUM);
+    redisearch_thpool_init(asyncUpdatesPool, LogCallback);
+  }
+  drainTaskRunning_g = true;
+  redisearch_thpool_add_work(asyncUpdatesPool, AsyncUpdates_DrainTask, NULL, THPOOL_PRIORITY_HIGH);
+}
+
+/* Index (or delete from the index) up to `max` of the oldest queued keys */
+static void AsyncUpdates_DrainKeys(IndexSpec *sp, RedisModuleCtx *ctx, size_t max) {
+  AsyncUpdates *au = sp->asyncUpdates;
+  size_t n = MIN(max, array_len(au->queue) - au->head);
+  if (!n) {
+    return;
+  }
+
+  // take the keys out of the queue first, so it may change while they are indexed
+  RedisModuleString **keys = rm_malloc(n * sizeof(*keys));
+  for (size_t ii = 0; ii < n; ++ii) {
+    keys[ii] = au->queue[au->head + ii].key;
+    dictDelete(au->pending, keys[ii]);
+  }
+  au->head += n;
+  if (au->head == array_len(au->queue)) {
+    array_clear(au->queue);
+    au->head = 0;
+  } else if (au->head > array_len(au->queue) / 2) {
+    size_t left = array_len(au->queue) - au->head;
+    memmove(au->queue, au->queue + au->head, left * sizeof(*au->queue));
+    au->queue = array_trimm_len(au->queue, au->head);
+    au->head = 0;
+  }
+  au->drained += n;
+
+  // a key is indexed by its contents now, whatever the writes queuing it were
+  arrayof(RedisModuleString *) toIndex = array_new(RedisModuleString *, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (SchemaRule_ShouldIndex(sp, keys[ii], getDocTypeFromString(keys[ii]))) {
+      toIndex = array_append(toIndex, keys[ii]);
+    } else {
+      IndexSpec_DeleteDoc(sp, ctx, keys[ii]);
+    }
+  }
+  if (array_len(toIndex)) {
+    IndexSpec_UpdateDocs(sp, ctx, toIndex, array_len(toIndex));
+  }
+  array_free(toIndex);
+
+  for (size_t ii = 0; ii < n; ++ii) {
+    RedisModule_FreeString(NULL, keys[ii]);
+  }
+  rm_free(keys);
+}
+
+static void AsyncUpdates_DrainTask(void *unused) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  // let the writes coalesce for half of the allowed lag before competing for the GIL. The lag is
+  // read again while sleeping, so that lowering it takes effect at once
+  long long start = monotonicMs();
+  while (monotonicMs() - start < RSGlobalConfig.asyncUpdatesMaxLag / 2) {
+    usleep(1000);
+  }
+  for (;;) {
+    RedisModule_ThreadSafeContextLock(ctx);
+    arrayof(WeakRef) specs = scheduledSpecs_g;
+    scheduledSpecs_g = NULL;
+    for (size_t ii = 0; ii < array_len(specs); ++ii) {
+      StrongRef ref = WeakRef_Promote(specs[ii]);
+      IndexSpec *sp = StrongRef_Get(ref);
+      if (sp) {
+        if (sp->asyncUpdates) {
+          sp->asyncUpdates->scheduled = false;
+          AsyncUpdates_DrainKeys(sp, ctx, ASYNC_UPDATES_BATCH_SIZE);
+          if (array_len(sp->asyncUpdates->queue) > sp->asyncUpdates->head) {
+            AsyncUpdates_Schedule(sp);
+          }
+        }
+        StrongRef_Release(ref);
+      }
+      WeakRef_Release(specs[ii]);
+    }
+    array_free(specs);
+    bool done = !array_len(scheduledSpecs_g);
+    if (done) {
+      drainTaskRunning_g = false;
+    }
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    if (done) {
+      break;
+    }
+    sched_yield();
+  }
+  RedisModule_FreeThreadSafeContext(ctx);
+}
+
+static void AsyncUpdates_BatchTimerCallback(RedisModuleCtx *ctx, void *unused) {
+  batchTimerSet_g = false;
+  arrayof(WeakRef) specs = batchedSpecs_g;
+  batchedSpecs_g = NULL;
+  for (size_t ii = 0; ii < array_len(specs); ++ii) {
+    StrongRef ref = WeakRef_Promote(specs[ii]);
+    IndexSpec *sp = StrongRef_Get(ref);
+    if (sp) {
+      if (sp->asyncUpdates) {
+        sp->asyncUpdates->scheduled = false;
+        AsyncUpdates_DrainKeys(sp, ctx, SIZE_MAX);
+      }
+      StrongRef_Release(ref);
+    }
+    WeakRef_Release(specs[ii]);
+  }
+  array_free(specs);
+}
+
+static void AsyncUpdates_ScheduleBatch(IndexSpec *sp) {
+  sp->asyncUpdates->scheduled = true;
+  if (!batchedSpecs_g) {
+    batchedSpecs_g = array_new(WeakRef, 8);
+  }
+  batchedSpecs_g = array_append(batchedSpecs_g, StrongRef_Demote(sp->own_ref));
+  if (!batchTimerSet_g) {
+    // a timer of 0 fires once the commands read in this event-loop iteration were processed
+    batchTimer_g = RedisModule_CreateTimer(RSDummyContext, 0, AsyncUpdates_BatchTimerCallback, NULL);
+    batchTimerSet_g = true;
+  }
+}
+
+bool AsyncUpdates_ShouldQueue(const IndexSpec *sp) {
+  return (sp->flags & Index_AsyncUpdates) || RSGlobalConfig.batchWrites;
+}
+
+void AsyncUpdates_Enqueue(IndexSpec *sp, RedisModuleCtx *ctx, RedisModuleString *key) {
+  AsyncUpdates *au = sp->asyncUpdates;
+  if (!au) {
+    au = sp->asyncUpdates = rm_calloc(1, sizeof(*au));
+    au->queue = array_new(AsyncKey, 16);
+    au->pending = dictCreate(&pendingDictType, NULL);
+  }
+
+  long long now = monotonicMs();
+  if (!dictFind(au->pending, key)) {
+    RedisModuleString *copy = RedisModule_CreateStringFromString(NULL, key);
+    dictAdd(au->pending, copy, NULL);
+    au->queue = array_append(au->queue, ((AsyncKey){.key = copy, .written = now}));
+  }
+
+  if (!(sp->flags & Index_AsyncUpdates)) {
+    // a batch of writes, indexed after the current event-loop iteration. A script or a transaction
+    // writing many keys indexes them a batch at a time
+    if (array_len(au->queue) - au->head >= ASYNC_UPDATES_BATCH_SIZE) {
+      AsyncUpdates_DrainKeys(sp, ctx, SIZE_MAX);
+    } else if (!au->scheduled) {
+      AsyncUpdates_ScheduleBatch(sp);
+    }
+    return;
+  }
+
+  if (now - au->queue[au->head].written >= RSGlobalConfig.asyncUpdatesMaxLag) {
+    // the background thread fell behind, index the queued keys with this write
+    AsyncUpdates_DrainKeys(sp, ctx, SIZE_MAX);
+  } else if (!au->scheduled) {
+    AsyncUpdates_Schedule(sp);
+  }
+}
+
+void AsyncUpdates_Drain(IndexSpec *sp, RedisModuleCtx *ctx) {
+  if (sp->asyncUpdates) {
+    AsyncUpdates_DrainKeys(sp, ctx, SIZE_MAX);
+  }
+}
+
+void AsyncUpdates_Flush(IndexSpec *sp, RedisModuleCtx *ctx) {
+  if (sp->asyncUpdates && !(sp->flags & Index_AsyncUpdates)) {
+    AsyncUpdates_DrainKeys(sp, ctx ? ctx : RSDummyContext, SIZE_MAX);
+  }
+}
+
+AsyncUpdatesStats AsyncUpdates_GetStats(IndexSpec *sp) {
+  AsyncUpdatesStats stats = {0};
+  AsyncUpdates *au = sp->asyncUpdates;
+  if (au) {
+    stats.depth = array_len(au->queue) - au->head;
+    stats.lagMs = stats.depth ? monotonicMs() - au->queue[au->head].written : 0;
+    stats.drained = au->drained;
+  }
+  return stats;
+}
+
+void AsyncUpdates_Free(IndexSpec *sp) {
+  AsyncUpdates *au = sp->asyncUpdates;
+  if (!au) {
+    return;
+  }
+  for (size_t ii = au->head; ii < array_len(au->queue); ++ii) {
+    RedisModule_FreeString(NULL, au->queue[ii].key);
+  }
+  array_free(au->queue);
+  dictRelease(au->pending);
+  rm_free(au);
+  sp->asyncUpdates = NULL;
+}
+
+void AsyncUpdates_ThreadPoolDestroy() {
+  if (asyncUpdatesPool) {
+    RedisModule_ThreadSafeContextUnlock(RSDummyContext);
+    redisearch_thpool_destroy(asyncUpdatesPool);
+    asyncUpdatesPool = NULL;
+    RedisModule_ThreadSafeContextLock(RSDummyContext);
+  }
+  for (size_t ii = 0; ii < array_len(scheduledSpecs_g); ++ii) {
+    WeakRef_Release(scheduledSpecs_g[ii]);
+  }
+  array_free(scheduledSpecs_g);
+  scheduledSpecs_g = NULL;
+  drainTaskRunning_g = false;
+
+  if (batchTimerSet_g) {
+    RedisModule_StopTimer(RSDummyContext, batchTimer_g, NULL);
+    batchTimerSet_g = false;
+  }
+  for (size_t ii = 0; ii < array_len(batchedSpecs_g); ++ii) {
+    WeakRef_Release(batchedSpecs_g[ii]);
+  }
+  array_free(batchedSpecs_g);
+  batchedSpecs_g = NULL;
+}
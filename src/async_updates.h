@@ -0,0 +1,63 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* The keys written to an index with ASYNCUPDATES since they were last indexed. A keyspace
+ * notification only adds its key to the queue, so repeated writes of a key before it is indexed
+ * are coalesced, and a background thread indexes the queued keys in batches under the GIL.
+ * Whether a key is indexed or deleted from the index is decided when it is drained, by its
+ * contents at that time.
+ *
+ * The queue is only accessed under the GIL. A write finding its oldest key queued for longer than
+ * ASYNC_UPDATES_MAX_LAG drains the queue itself, which bounds how stale the index may be.
+ *
+ * With BATCH_WRITES, the writes to the keys of the other indexes are queued the same way, and
+ * drained on the main thread once the commands of the current event-loop iteration (a pipeline, a
+ * transaction or a script) were processed. Loading the index for a command drains its queue
+ * first, so that batching is not visible to the commands */
+typedef struct AsyncUpdates AsyncUpdates;
+
+typedef struct {
+  size_t depth;      // keys in the queue
+  long long lagMs;   // time since the oldest key in the queue was written, or 0
+  size_t drained;    // keys drained from the queue since the index was created or loaded
+} AsyncUpdatesStats;
+
+/* Whether the writes to the keys of the index are queued, rather than indexed at once */
+bool AsyncUpdates_ShouldQueue(const struct IndexSpec *sp);
+
+/* Queue a written key to be indexed, or deleted from the index */
+void AsyncUpdates_Enqueue(struct IndexSpec *sp, RedisModuleCtx *ctx, RedisModuleString *key);
+
+/* Index (or delete) the queued keys of the index now */
+void AsyncUpdates_Drain(struct IndexSpec *sp, RedisModuleCtx *ctx);
+
+/* Index the keys batched by BATCH_WRITES for the index. Does nothing for ASYNCUPDATES indexes */
+void AsyncUpdates_Flush(struct IndexSpec *sp, RedisModuleCtx *ctx);
+
+AsyncUpdatesStats AsyncUpdates_GetStats(struct IndexSpec *sp);
+
+/* Drop the queued keys of an index. Called where the index is dropped, under the GIL */
+void AsyncUpdates_Free(struct IndexSpec *sp);
+
+/* Stop the background thread, if it was started, and the batch timer */
+void AsyncUpdates_ThreadPoolDestroy();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "block_retention.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "inverted_index.h"
+#include "tag_index.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+
+typedef struct {
+  size_t blocks;
+  size_t records;
+  size_t bytes;
+} dropped;
+
+/* Drop the blocks of an index which end below `firstLiveId`. The last block is still written to,
+ * and is left alone. The blocks of text and tag postings hold a record per document */
+static void dropIndexBlocks(InvertedIndex *idx, t_docId firstLiveId, dropped *d) {
+  uint32_t n = 0;
+  size_t records = 0;
+  while (n + 1 < idx->size && idx->blocks[n].lastId < firstLiveId) {
+    IndexBlock *blk = idx->blocks + n;
+    records += blk->numEntries;
+    d->bytes += blk->buf.cap;
+    indexBlock_Free(blk);
+    ++n;
+  }
+  if (!n) {
+    return;
+  }
+  // an index of more than one block holds its blocks apart from its header
+  memmove(idx->blocks, idx->blocks + n, (idx->size - n) * sizeof(*idx->blocks));
+  idx->size -= n;
+  idx->numDocs -= records;
+  TotalIIBlocks -= n;
+  // Readers that paused inside a dropped block hold a position in data which was freed. Make them
+  // seek back to their last docId when they reopen the index.
+  ++idx->gcMarker;
+  d->blocks += n;
+  d->records += records;
+}
+
+static void dropTagBlocks(TagIndex *tagIdx, t_docId firstLiveId, dropped *d) {
+  TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+  char *ptr;
+  tm_len_t len;
+  void *value;
+  while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+    dropIndexBlocks(value, firstLiveId, d);
+  }
+  TrieMapIterator_Free(iter);
+}
+
+/* Numeric ranges are left to the collection, as the records of a multi-value document may span two
+ * of their blocks */
+static void dropSpecBlocks(IndexSpec *sp, t_docId firstLiveId, dropped *d) {
+  if (!sp->keysDict) {
+    return;
+  }
+  dictIterator *iter = dictGetIterator(sp->keysDict);
+  dictEntry *de;
+  while ((de = dictNext(iter))) {
+    KeysDictValue *kdv = dictGetVal(de);
+    if (kdv->dtor == InvertedIndex_Free) {
+      dropIndexBlocks(kdv->p, firstLiveId, d);
+    } else if (kdv->dtor == TagIndex_Free) {
+      dropTagBlocks(kdv->p, firstLiveId, d);
+    }
+  }
+  dictReleaseIterator(iter);
+}
+
+/* The first id of a document in the index, or the id after the last one if the index holds none */
+static t_docId firstLiveId(const IndexSpec *sp) {
+  t_docId docId = DocTable_NextLive(&sp->docs, 1);
+  return docId ? docId : sp->docs.maxDocId + 1;
+}
+
+/* Check the spec under the read lock first, as the write lock would drop its cached results */
+static bool needsDrop(BlockRetention *r) {
+  StrongRef spec_ref = WeakRef_Promote(r->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    return false;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(r->ctx, sp);
+  RedisSearchCtx_LockSpecRead(&sctx);
+  bool rv = firstLiveId(sp) != r->firstLiveId;
+  RedisSearchCtx_UnlockSpec(&sctx);
+  StrongRef_Release(spec_ref);
+  return rv;
+}
+
+size_t BlockRetention_Run(BlockRetention *r) {
+  if (!needsDrop(r)) {
+    return 0;
+  }
+
+  StrongRef spec_ref = WeakRef_Promote(r->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    // Index was deleted
+    return 0;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(r->ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  // the ids may have been compacted since the last run, and start over
+  r->firstLiveId = firstLiveId(sp);
+  dropped d = {0};
+  dropSpecBlocks(sp, r->firstLiveId, &d);
+  sp->stats.numRecords -= d.records;
+  sp->stats.invertedSize -= d.bytes;
+  RedisSearchCtx_UnlockSpec(&sctx);
+  StrongRef_Release(spec_ref);
+
+  if (d.blocks) {
+    r->stats.numDrops++;
+    r->stats.blocksDropped += d.blocks;
+    r->stats.recordsDropped += d.records;
+    r->stats.bytesDropped += d.bytes;
+  }
+  return d.blocks;
+}
+
+void BlockRetention_RenderStats(BlockRetention *r, RedisModule_Reply *reply) {
+  RedisModule_ReplyKV_Double(reply, "retention_drops", r->stats.numDrops);
+  RedisModule_ReplyKV_Double(reply, "retention_blocks_dropped", r->stats.blocksDropped);
+  RedisModule_ReplyKV_Double(reply, "retention_records_dropped", r->stats.recordsDropped);
+  RedisModule_ReplyKV_Double(reply, "retention_bytes_dropped", r->stats.bytesDropped);
+}
+
+#ifdef FTINFO_FOR_INFO_MODULES
+void BlockRetention_RenderStatsForInfo(BlockRetention *r, RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoBeginDictField(ctx, "block_retention_stats");
+  RedisModule_InfoAddFieldLongLong(ctx, "retention_drops", r->stats.numDrops);
+  RedisModule_InfoAddFieldLongLong(ctx, "retention_blocks_dropped", r->stats.blocksDropped);
+  RedisModule_InfoAddFieldLongLong(ctx, "retention_records_dropped", r->stats.recordsDropped);
+  RedisModule_InfoAddFieldLongLong(ctx, "retention_bytes_dropped", r->stats.bytesDropped);
+  RedisModule_InfoEndDictField(ctx);
+}
+#endif
+
+BlockRetention *BlockRetention_New(StrongRef spec_ref) {
+  BlockRetention *r = rm_calloc(1, sizeof(*r));
+  r->index = StrongRef_Demote(spec_ref);
+  r->ctx = RedisModule_GetThreadSafeContext(NULL);
+  r->firstLiveId = 1;
+  return r;
+}
+
+void BlockRetention_Free(BlockRetention *r) {
+  WeakRef_Release(r->index);
+  RedisModule_FreeThreadSafeContext(r->ctx);
+  rm_free(r);
+}
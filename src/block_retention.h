@@ -0,0 +1,67 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef SRC_BLOCK_RETENTION_H_
+#define SRC_BLOCK_RETENTION_H_
+
+#include "redismodule.h"
+#include "reply.h"
+#include "doc_table.h"
+#include "util/references.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // number of times blocks were dropped
+  size_t numDrops;
+  // number of blocks dropped, and of the records and bytes they held
+  size_t blocksDropped;
+  size_t recordsDropped;
+  size_t bytesDropped;
+} BlockRetentionStats;
+
+/*
+ * Drops the leading blocks of the text and tag postings of an index which hold only deleted
+ * documents, without decoding them. The ids grow with the time the documents are added, so the
+ * postings of an index of expiring documents (e.g. logs kept for a few days) begin with the blocks
+ * of the documents which expired since. These are dropped whole from the GC thread, ahead of the
+ * collection, rather than repaired document by document. A block holds only deleted documents once
+ * its last id is below the first id of a document in the index.
+ */
+typedef struct BlockRetention {
+  // owner of the retention
+  WeakRef index;
+
+  RedisModuleCtx *ctx;
+
+  // the first id of a document in the index as of the last run
+  t_docId firstLiveId;
+
+  // statistics for reporting
+  BlockRetentionStats stats;
+} BlockRetention;
+
+BlockRetention *BlockRetention_New(StrongRef spec_ref);
+void BlockRetention_Free(BlockRetention *r);
+
+/* Drop the leading blocks of deleted documents, if documents were deleted from the beginning of
+ * the index since the last run. Returns the number of blocks dropped */
+size_t BlockRetention_Run(BlockRetention *r);
+
+void BlockRetention_RenderStats(BlockRetention *r, RedisModule_Reply *reply);
+#ifdef FTINFO_FOR_INFO_MODULES
+void BlockRetention_RenderStatsForInfo(BlockRetention *r, RedisModuleInfoCtx *ctx);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BLOCK_RETENTION_H_ */
@@ -0,0 +1,173 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "block_tiering.h"
+#include "cold_block_cache.h"
+#include "config.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+
+typedef struct {
+  // the bytes the sweep may still deflate
+  size_t budget;
+  size_t frozen;
+  size_t coldBlocks;
+  size_t coldBytes;
+  size_t coldInflatedBytes;
+} sweep;
+
+static time_t now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/* Deflate the blocks of an index which were not accessed since the last sweep, and clear the
+ * access bits of the others. The last block is still written to, and is left alone */
+static void sweepIndex(InvertedIndex *idx, sweep *s) {
+  size_t frozen = 0;
+  for (uint32_t i = 0; i + 1 < idx->size; ++i) {
+    IndexBlock *blk = idx->blocks + i;
+    if (blk->flags & IndexBlock_Accessed) {
+      blk->flags &= ~IndexBlock_Accessed;
+    } else if (!IndexBlock_IsCold(blk) && blk->buf.offset <= s->budget) {
+      s->budget -= blk->buf.offset;
+      frozen += !!IndexBlock_Freeze(blk);
+    }
+    if (IndexBlock_IsCold(blk)) {
+      s->coldBlocks++;
+      s->coldBytes += blk->buf.offset;
+      s->coldInflatedBytes += IndexBlock_WarmLen(blk);
+    }
+  }
+  if (frozen) {
+    // Readers that paused inside a deflated block hold an offset into data which was freed. Make
+    // them seek back to their last docId when they reopen the index.
+    ++idx->gcMarker;
+    s->frozen += frozen;
+  }
+}
+
+static void sweepNumeric(NumericRangeTree *rt, sweep *s) {
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    if (node->range) {
+      sweepIndex(node->range->entries, s);
+    }
+  }
+  NumericRangeTreeIterator_Free(iter);
+}
+
+static void sweepTags(TagIndex *tagIdx, sweep *s) {
+  TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+  char *ptr;
+  tm_len_t len;
+  void *value;
+  while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+    sweepIndex(value, s);
+  }
+  TrieMapIterator_Free(iter);
+}
+
+/* Sweep the inverted indexes of the text, numeric and tag fields of the spec */
+static void sweepSpec(IndexSpec *sp, sweep *s) {
+  if (!sp->keysDict) {
+    return;
+  }
+  dictIterator *iter = dictGetIterator(sp->keysDict);
+  dictEntry *de;
+  while ((de = dictNext(iter))) {
+    KeysDictValue *kdv = dictGetVal(de);
+    if (kdv->dtor == InvertedIndex_Free) {
+      sweepIndex(kdv->p, s);
+    } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+      sweepNumeric(kdv->p, s);
+    } else if (kdv->dtor == TagIndex_Free) {
+      sweepTags(kdv->p, s);
+    }
+  }
+  dictReleaseIterator(iter);
+}
+
+size_t BlockTiering_Run(BlockTiering *t) {
+  size_t period = RSGlobalConfig.gcConfigParams.coldBlocksPeriod;
+  time_t sweepTime = now();
+  if (!period || (size_t)(sweepTime - t->lastSweep) < period) {
+    return 0;
+  }
+
+  StrongRef spec_ref = WeakRef_Promote(t->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    // Index was deleted
+    return 0;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(t->ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  sweep s = {.budget = BLOCK_TIERING_SWEEP_BYTES};
+  sweepSpec(sp, &s);
+  RedisSearchCtx_UnlockSpec(&sctx);
+  StrongRef_Release(spec_ref);
+
+  t->lastSweep = sweepTime;
+  t->stats.numSweeps++;
+  t->stats.blocksFrozen += s.frozen;
+  t->stats.coldBlocks = s.coldBlocks;
+  t->stats.coldBytes = s.coldBytes;
+  t->stats.coldInflatedBytes = s.coldInflatedBytes;
+  return s.frozen;
+}
+
+static double cacheHitRatio(const ColdBlockCacheStats *cs) {
+  size_t lookups = cs->hits + cs->misses;
+  return lookups ? (double)cs->hits / lookups : 0;
+}
+
+void BlockTiering_RenderStats(BlockTiering *t, RedisModule_Reply *reply) {
+  ColdBlockCacheStats cs;
+  ColdBlockCache_GetStats(&cs);
+  RedisModule_ReplyKV_Double(reply, "cold_block_sweeps", t->stats.numSweeps);
+  RedisModule_ReplyKV_Double(reply, "cold_blocks", t->stats.coldBlocks);
+  RedisModule_ReplyKV_Double(reply, "cold_blocks_bytes", t->stats.coldBytes);
+  RedisModule_ReplyKV_Double(reply, "cold_blocks_inflated_bytes", t->stats.coldInflatedBytes);
+  RedisModule_ReplyKV_Double(reply, "cold_blocks_frozen", t->stats.blocksFrozen);
+  RedisModule_ReplyKV_Double(reply, "cold_block_cache_hit_ratio", cacheHitRatio(&cs));
+}
+
+#ifdef FTINFO_FOR_INFO_MODULES
+void BlockTiering_RenderStatsForInfo(BlockTiering *t, RedisModuleInfoCtx *ctx) {
+  ColdBlockCacheStats cs;
+  ColdBlockCache_GetStats(&cs);
+  RedisModule_InfoBeginDictField(ctx, "block_tiering_stats");
+  RedisModule_InfoAddFieldLongLong(ctx, "cold_block_sweeps", t->stats.numSweeps);
+  RedisModule_InfoAddFieldLongLong(ctx, "cold_blocks", t->stats.coldBlocks);
+  RedisModule_InfoAddFieldLongLong(ctx, "cold_blocks_bytes", t->stats.coldBytes);
+  RedisModule_InfoAddFieldLongLong(ctx, "cold_blocks_inflated_bytes", t->stats.coldInflatedBytes);
+  RedisModule_InfoAddFieldLongLong(ctx, "cold_blocks_frozen", t->stats.blocksFrozen);
+  RedisModule_InfoAddFieldDouble(ctx, "cold_block_cache_hit_ratio", cacheHitRatio(&cs));
+  RedisModule_InfoEndDictField(ctx);
+}
+#endif
+
+BlockTiering *BlockTiering_New(StrongRef spec_ref) {
+  BlockTiering *t = rm_calloc(1, sizeof(*t));
+  t->index = StrongRef_Demote(spec_ref);
+  t->ctx = RedisModule_GetThreadSafeContext(NULL);
+  t->lastSweep = now();
+  return t;
+}
+
+void BlockTiering_Free(BlockTiering *t) {
+  WeakRef_Release(t->index);
+  RedisModule_FreeThreadSafeContext(t->ctx);
+  rm_free(t);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef SRC_BLOCK_TIERING_H_
+#define SRC_BLOCK_TIERING_H_
+
+#include "redismodule.h"
+#include "reply.h"
+#include "util/references.h"
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The data of the blocks deflated by a sweep under a single write lock of the index
+#define BLOCK_TIERING_SWEEP_BYTES (4 << 20)
+
+typedef struct {
+  // number of sweeps ran
+  size_t numSweeps;
+  // number of blocks deflated by the sweeps
+  size_t blocksFrozen;
+  // the cold blocks of the index as of the last sweep, and the size of their data deflated and
+  // inflated
+  size_t coldBlocks;
+  size_t coldBytes;
+  size_t coldInflatedBytes;
+} BlockTieringStats;
+
+/*
+ * Deflates the blocks of the inverted indexes of an index which were not read for a while (see
+ * the GC_COLD_BLOCKS_PERIOD config), keeping the blocks which are read uncompressed. Run from the
+ * GC thread after a collection, at most once per period. A sweep deflates the full blocks which
+ * were not accessed since the previous sweep, and clears the access bits of the others, so that a
+ * block goes cold after one to two periods without reads. The readers of a cold block inflate it
+ * into the cold block cache (see the COLD_BLOCKS_CACHE_SIZE config).
+ */
+typedef struct BlockTiering {
+  // owner of the tiering
+  WeakRef index;
+
+  RedisModuleCtx *ctx;
+
+  // the time of the last sweep, or of the creation of the tiering before the first one
+  time_t lastSweep;
+
+  // statistics for reporting
+  BlockTieringStats stats;
+} BlockTiering;
+
+BlockTiering *BlockTiering_New(StrongRef spec_ref);
+void BlockTiering_Free(BlockTiering *t);
+
+/* Sweep the blocks of the index if the period elapsed since the last sweep. Returns the number of
+ * blocks deflated */
+size_t BlockTiering_Run(BlockTiering *t);
+
+void BlockTiering_RenderStats(BlockTiering *t, RedisModule_Reply *reply);
+#ifdef FTINFO_FOR_INFO_MODULES
+void BlockTiering_RenderStatsForInfo(BlockTiering *t, RedisModuleInfoCtx *ctx);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BLOCK_TIERING_H_ */
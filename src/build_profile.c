@@ -0,0 +1,181 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "build_profile.h"
+#include "spec.h"
+#include "field_spec.h"
+#include "rmalloc.h"
+#include "rmutil/cxx/chrono-clock.h"
+
+#include <string.h>
+
+// The throughput of the scan is sampled once a second, and then less often as the scan goes, so
+// that the samples always cover all of it
+#define BUILD_PROFILE_MAX_SAMPLES 64
+#define BUILD_PROFILE_SAMPLE_MS 1000
+
+typedef struct {
+  double elapsedMs;
+  size_t scannedKeys;
+} buildSample;
+
+struct BuildProfile {
+  // Written under the GIL, read by the indexing threads without it
+  bool recording;
+  bool global;
+  hires_clock_t start;
+  double rdbLoadMs;
+  double totalMs;
+  double workMs;
+  double waitMs;
+  double bulkLoadMs;
+  size_t scannedKeys;
+  // Added to by the indexing threads
+  size_t docs;
+  uint64_t preprocessNs[INDEXFLD_NUM_TYPES];
+  uint64_t indexNs[INDEXFLD_NUM_TYPES];
+  size_t fields[INDEXFLD_NUM_TYPES];
+
+  buildSample samples[BUILD_PROFILE_MAX_SAMPLES];
+  size_t numSamples;
+  double sampleMs;
+};
+
+static BuildProfile *getProfile(IndexSpec *sp) {
+  if (!sp->buildProfile) {
+    sp->buildProfile = rm_calloc(1, sizeof(*sp->buildProfile));
+  }
+  return sp->buildProfile;
+}
+
+void BuildProfile_Start(IndexSpec *sp, const BuildProfileStep *step) {
+  BuildProfile *bp = getProfile(sp);
+  double rdbLoadMs = bp->rdbLoadMs;
+  memset(bp, 0, sizeof(*bp));
+  bp->rdbLoadMs = rdbLoadMs;
+  bp->global = step->global;
+  bp->sampleMs = BUILD_PROFILE_SAMPLE_MS;
+  hires_clock_get(&bp->start);
+  __atomic_store_n(&bp->recording, true, __ATOMIC_RELEASE);
+}
+
+static void addSample(BuildProfile *bp, double elapsedMs) {
+  if (bp->numSamples &&
+      elapsedMs - bp->samples[bp->numSamples - 1].elapsedMs < bp->sampleMs) {
+    return;
+  }
+  if (bp->numSamples == BUILD_PROFILE_MAX_SAMPLES) {
+    // keep every other sample, and sample half as often from now on
+    for (size_t i = 1; i < BUILD_PROFILE_MAX_SAMPLES / 2; ++i) {
+      bp->samples[i] = bp->samples[2 * i + 1];
+    }
+    bp->numSamples = BUILD_PROFILE_MAX_SAMPLES / 2;
+    bp->sampleMs *= 2;
+  }
+  bp->samples[bp->numSamples++] = (buildSample){elapsedMs, bp->scannedKeys};
+}
+
+void BuildProfile_Slice(IndexSpec *sp, const BuildProfileStep *step) {
+  BuildProfile *bp = sp->buildProfile;
+  if (!bp || !bp->recording) {
+    return;
+  }
+  bp->workMs += step->workMs;
+  bp->waitMs += step->waitMs;
+  bp->scannedKeys = step->scannedKeys;
+  addSample(bp, hires_clock_since_usec(&bp->start) / 1000);
+}
+
+void BuildProfile_End(IndexSpec *sp, const BuildProfileStep *step) {
+  BuildProfile *bp = sp->buildProfile;
+  if (!bp || !bp->recording) {
+    return;
+  }
+  BuildProfile_Slice(sp, step);
+  bp->bulkLoadMs = step->bulkLoadMs;
+  bp->totalMs = hires_clock_since_usec(&bp->start) / 1000;
+  __atomic_store_n(&bp->recording, false, __ATOMIC_RELEASE);
+}
+
+void BuildProfile_RdbLoaded(IndexSpec *sp, double ms) {
+  getProfile(sp)->rdbLoadMs = ms;
+}
+
+bool BuildProfile_IsRecording(const IndexSpec *sp) {
+  return sp->buildProfile && __atomic_load_n(&sp->buildProfile->recording, __ATOMIC_ACQUIRE);
+}
+
+void BuildProfile_AddFieldTime(IndexSpec *sp, int typePos, uint64_t ns, bool preprocess) {
+  BuildProfile *bp = sp->buildProfile;
+  if (preprocess) {
+    __atomic_add_fetch(&bp->preprocessNs[typePos], ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&bp->fields[typePos], 1, __ATOMIC_RELAXED);
+  } else {
+    __atomic_add_fetch(&bp->indexNs[typePos], ns, __ATOMIC_RELAXED);
+  }
+}
+
+void BuildProfile_AddDocument(IndexSpec *sp) {
+  __atomic_add_fetch(&sp->buildProfile->docs, 1, __ATOMIC_RELAXED);
+}
+
+void BuildProfile_Reply(RedisModule_Reply *reply, const IndexSpec *sp) {
+  static const BuildProfile none = {0};
+  const BuildProfile *bp = sp->buildProfile ? sp->buildProfile : &none;
+  bool recording = BuildProfile_IsRecording(sp);
+  double totalMs =
+      recording ? hires_clock_since_usec((hires_clock_t *)&bp->start) / 1000 : bp->totalMs;
+
+  RedisModule_Reply_Map(reply);
+    RedisModule_ReplyKV_LongLong(reply, "in_progress", recording);
+    RedisModule_ReplyKV_LongLong(reply, "global_scan", bp->global);
+    RedisModule_ReplyKV_Double(reply, "rdb_load_ms", bp->rdbLoadMs);
+    RedisModule_ReplyKV_Double(reply, "total_ms", totalMs);
+    RedisModule_ReplyKV_Double(reply, "gil_held_ms", bp->workMs);
+    RedisModule_ReplyKV_Double(reply, "gil_wait_ms", bp->waitMs);
+    RedisModule_ReplyKV_Double(reply, "bulk_load_ms", bp->bulkLoadMs);
+    RedisModule_ReplyKV_LongLong(reply, "keys_scanned", bp->scannedKeys);
+    RedisModule_ReplyKV_LongLong(reply, "docs_indexed", bp->docs);
+
+    // the keys scanned per second between every sample and the previous one
+    RedisModule_ReplyKV_Array(reply, "keys_per_sec");
+    for (size_t i = 0; i < bp->numSamples; ++i) {
+      double prevMs = i ? bp->samples[i - 1].elapsedMs : 0;
+      size_t prevKeys = i ? bp->samples[i - 1].scannedKeys : 0;
+      double ms = bp->samples[i].elapsedMs - prevMs;
+      RedisModule_Reply_Map(reply);
+        RedisModule_ReplyKV_Double(reply, "elapsed_ms", bp->samples[i].elapsedMs);
+        RedisModule_ReplyKV_Double(reply, "rate",
+                                   ms > 0 ? (bp->samples[i].scannedKeys - prevKeys) * 1000 / ms : 0);
+      RedisModule_Reply_MapEnd(reply);
+    }
+    RedisModule_Reply_ArrayEnd(reply);
+
+    RedisModule_ReplyKV_Array(reply, "field_types");
+    for (int i = 0; i < INDEXFLD_NUM_TYPES; ++i) {
+      if (!bp->fields[i]) {
+        continue;
+      }
+      RedisModule_Reply_Map(reply);
+        RedisModule_ReplyKV_SimpleString(reply, "type", FieldSpec_GetTypeNames(i));
+        RedisModule_ReplyKV_LongLong(reply, "fields", bp->fields[i]);
+        RedisModule_ReplyKV_Double(reply, "preprocess_ms", bp->preprocessNs[i] / 1e6);
+        RedisModule_ReplyKV_Double(reply, "index_ms", bp->indexNs[i] / 1e6);
+      RedisModule_Reply_MapEnd(reply);
+    }
+    RedisModule_Reply_ArrayEnd(reply);
+
+    // The vectors are inserted by the workers with the MT build, so this is the throughput of the
+    // whole build rather than of the inserts alone
+    size_t vectors = bp->fields[INDEXTYPE_TO_POS(INDEXFLD_T_VECTOR)];
+    RedisModule_ReplyKV_Double(reply, "vectors_per_sec", totalMs > 0 ? vectors * 1000 / totalMs : 0);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+void BuildProfile_Free(IndexSpec *sp) {
+  rm_free(sp->buildProfile);
+  sp->buildProfile = NULL;
+}
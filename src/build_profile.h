@@ -0,0 +1,62 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "reply.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* The profile of the last build of an index, the scan of its keys when it is created, altered,
+ * loaded from an RDB without its contents, or loaded lazily, and of the load of its definition
+ * from the RDB. FT.DEBUG BUILD_PROFILE replies with it.
+ *
+ * The scan records a few clock readings per slice it holds the GIL for. The time the fields take
+ * to preprocess and index is only measured while the index is scanned, per document, so the
+ * writes to an index which is not being built read no clock */
+typedef struct BuildProfile BuildProfile;
+
+/* A step of a scan, see Indexes_ScanAndReindexTask */
+typedef struct {
+  bool global;         // the scan builds all the indexes, when loading ends
+  double workMs;       // holding the GIL, for a slice
+  double waitMs;       // waiting for the GIL before the slice
+  double bulkLoadMs;   // packing the geometry indexes, when the scan ends
+  size_t scannedKeys;  // since the scan started
+} BuildProfileStep;
+
+void BuildProfile_Start(struct IndexSpec *sp, const BuildProfileStep *step);
+void BuildProfile_Slice(struct IndexSpec *sp, const BuildProfileStep *step);
+void BuildProfile_End(struct IndexSpec *sp, const BuildProfileStep *step);
+
+/* How long loading the definition of the index, and reading its persisted contents, took */
+void BuildProfile_RdbLoaded(struct IndexSpec *sp, double ms);
+
+/* Whether the index is being built, and its documents should be timed */
+bool BuildProfile_IsRecording(const struct IndexSpec *sp);
+
+/* Add the time a field of a document took to preprocess or index, by the position of its type.
+ * Called from the indexing threads as well */
+void BuildProfile_AddFieldTime(struct IndexSpec *sp, int typePos, uint64_t ns, bool preprocess);
+
+/* Count a document preprocessed while the index is built */
+void BuildProfile_AddDocument(struct IndexSpec *sp);
+
+void BuildProfile_Reply(RedisModule_Reply *reply, const struct IndexSpec *sp);
+
+void BuildProfile_Free(struct IndexSpec *sp);
+
+#ifdef __cplusplus
+}
+#endif
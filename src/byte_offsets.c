@@ -15,9 +15,40 @@ RSByteOffsets *NewByteOffsets() {
 void RSByteOffsets_Free(RSByteOffsets *offsets) {
   rm_free(offsets->offsets.data);
   rm_free(offsets->fields);
+  rm_free(offsets->checkpoints);
   rm_free(offsets);
 }
 
+static void RSByteOffsets_BuildCheckpoints(RSByteOffsets *offsets) {
+  rm_free(offsets->checkpoints);
+  offsets->checkpoints = NULL;
+  offsets->numCheckpoints = 0;
+  // Every offset takes at least one byte
+  size_t maxCheckpoints = offsets->offsets.len / BYTE_OFFSETS_CHECKPOINT_INTERVAL;
+  if (!maxCheckpoints) {
+    return;
+  }
+
+  offsets->checkpoints = rm_malloc(sizeof(*offsets->checkpoints) * maxCheckpoints);
+  Buffer buf = {.data = offsets->offsets.data, .offset = offsets->offsets.len};
+  BufferReader rdr = NewBufferReader(&buf);
+  uint32_t pos = 0, value = 0;
+  while (!BufferReader_AtEnd(&rdr)) {
+    value += ReadVarint(&rdr);
+    if (++pos % BYTE_OFFSETS_CHECKPOINT_INTERVAL == 0) {
+      offsets->checkpoints[offsets->numCheckpoints++] =
+          (RSByteOffsetCheckpoint){.pos = pos, .value = value, .readerPos = rdr.pos};
+    }
+  }
+  if (!offsets->numCheckpoints) {
+    rm_free(offsets->checkpoints);
+    offsets->checkpoints = NULL;
+  } else {
+    offsets->checkpoints = rm_realloc(offsets->checkpoints,
+                                      sizeof(*offsets->checkpoints) * offsets->numCheckpoints);
+  }
+}
+
 void RSByteOffsets_ReserveFields(RSByteOffsets *offsets, size_t numFields) {
   offsets->fields = rm_realloc(offsets->fields, sizeof(*offsets->fields) * numFields);
 }
@@ -34,6 +65,7 @@ void ByteOffsetWriter_Move(ByteOffsetWriter *w, RSByteOffsets *offsets) {
   offsets->offsets.data = w->buf.data;
   offsets->offsets.len = w->buf.offset;
   memset(&w->buf, 0, sizeof w->buf);
+  RSByteOffsets_BuildCheckpoints(offsets);
 }
 
 void RSByteOffsets_Serialize(const RSByteOffsets *offsets, Buffer *b) {
@@ -74,10 +106,29 @@ RSByteOffsets *LoadByteOffsets(Buffer *buf) {
   } else {
     offsets->offsets.data = NULL;
   }
+  RSByteOffsets_BuildCheckpoints(offsets);
 
   return offsets;
 }
 
+/* Read the offsets up to the given position, from the last checkpoint before it if the iterator
+ * is behind it */
+static void RSByteOffsetIterator_Seek(RSByteOffsetIterator *iter, uint32_t pos) {
+  uint32_t n = pos / BYTE_OFFSETS_CHECKPOINT_INTERVAL;
+  if (n && n <= iter->numCheckpoints) {
+    const RSByteOffsetCheckpoint *cp = iter->checkpoints + n - 1;
+    if (cp->pos > iter->curPos) {
+      iter->rdr.pos = cp->readerPos;
+      iter->lastValue = cp->value;
+      iter->curPos = cp->pos;
+    }
+  }
+  while (iter->curPos < pos && !BufferReader_AtEnd(&iter->rdr)) {
+    iter->lastValue = ReadVarint(&iter->rdr) + iter->lastValue;
+    iter->curPos++;
+  }
+}
+
 int RSByteOffset_Iterate(const RSByteOffsets *offsets, uint32_t fieldId,
                          RSByteOffsetIterator *iter) {
   const RSByteOffsetField *offField = NULL;
@@ -98,19 +149,17 @@ int RSByteOffset_Iterate(const RSByteOffsets *offsets, uint32_t fieldId,
   iter->buf.data = offsets->offsets.data;
   iter->buf.offset = offsets->offsets.len;
   iter->rdr = NewBufferReader(&iter->buf);
-  iter->curPos = 1;
+  iter->curPos = 0;
   iter->endPos = offField->lastTokPos;
+  iter->checkpoints = offsets->checkpoints;
+  iter->numCheckpoints = offsets->numCheckpoints;
 
   iter->lastValue = 0;
 
-  while (iter->curPos < offField->firstTokPos && !BufferReader_AtEnd(&iter->rdr)) {
-    // printf("Seeking & incrementing\n");
-    iter->lastValue = ReadVarint(&iter->rdr) + iter->lastValue;
-    iter->curPos++;
+  // Position the iterator before the first token of the field
+  if (offField->firstTokPos) {
+    RSByteOffsetIterator_Seek(iter, offField->firstTokPos - 1);
   }
-
-  // printf("Iterator is now at %lu\n", iter->curPos);
-  iter->curPos--;
   return REDISMODULE_OK;
 }
 
@@ -121,4 +170,17 @@ uint32_t RSByteOffsetIterator_Next(RSByteOffsetIterator *iter) {
 
   iter->lastValue = ReadVarint(&iter->rdr) + iter->lastValue;
   return iter->lastValue;
+}
+
+uint32_t RSByteOffsetIterator_SkipTo(RSByteOffsetIterator *iter, uint32_t pos) {
+  if (pos > iter->endPos) {
+    return RSBYTEOFFSET_EOF;
+  }
+  if (pos > iter->curPos + 1) {
+    RSByteOffsetIterator_Seek(iter, pos - 1);
+  }
+  if (iter->curPos == pos) {
+    return iter->lastValue;
+  }
+  return RSByteOffsetIterator_Next(iter);
 }
\ No newline at end of file
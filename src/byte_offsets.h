@@ -22,6 +22,18 @@ typedef struct __attribute__((packed)) RSByteOffsetMap {
   uint32_t lastTokPos;
 } RSByteOffsetField;
 
+/* Every this many positions the byte offsets have a checkpoint, from which they can be read without
+ * decoding the offsets before it */
+#define BYTE_OFFSETS_CHECKPOINT_INTERVAL 64
+
+typedef struct {
+  // The position and byte offset of the checkpoint
+  uint32_t pos;
+  uint32_t value;
+  // Where the offsets after it begin in the encoded offsets
+  uint32_t readerPos;
+} RSByteOffsetCheckpoint;
+
 typedef struct RSByteOffsets {
   // By-Byte offsets
   RSOffsetVector offsets;
@@ -29,6 +41,9 @@ typedef struct RSByteOffsets {
   RSByteOffsetField *fields;
   // How many fields
   uint8_t numFields;
+  // Built from the offsets when they are written or loaded, they are not serialized
+  RSByteOffsetCheckpoint *checkpoints;
+  uint32_t numCheckpoints;
 } RSByteOffsets;
 
 RSByteOffsets *NewByteOffsets();
@@ -74,6 +89,8 @@ typedef struct {
   uint32_t lastValue;
   uint32_t curPos;
   uint32_t endPos;
+  const RSByteOffsetCheckpoint *checkpoints;
+  uint32_t numCheckpoints;
 } RSByteOffsetIterator;
 
 #define RSBYTEOFFSET_EOF ((uint32_t)-1)
@@ -92,4 +109,11 @@ int RSByteOffset_Iterate(const RSByteOffsets *offsets, uint32_t fieldId,
  */
 uint32_t RSByteOffsetIterator_Next(RSByteOffsetIterator *iter);
 
+/**
+ * Returns the byte offset of the given position, which is at or after the current one, skipping
+ * the offsets before it from the nearest checkpoint. Returns RSBYTEOFFSET_EOF past the end of the
+ * field.
+ */
+uint32_t RSByteOffsetIterator_SkipTo(RSByteOffsetIterator *iter, uint32_t pos);
+
 #endif
\ No newline at end of file
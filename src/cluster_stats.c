@@ -0,0 +1,126 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "cluster_stats.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+struct ClusterStats {
+  pthread_mutex_t lock;
+  size_t numDocs;
+  size_t totalDocsLen;
+  TrieMap *termDocs;      // term => number of documents over the cluster
+  long long expiresAt;    // in monotonic milliseconds, 0 if there are no statistics
+  TrieMap *hotTerms;      // the terms looked up since the coordinator last asked for them
+  bool recording;
+};
+
+static long long monotonicMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+ClusterStats *NewClusterStats() {
+  ClusterStats *cs = rm_calloc(1, sizeof(*cs));
+  pthread_mutex_init(&cs->lock, NULL);
+  cs->hotTerms = NewTrieMap();
+  return cs;
+}
+
+void ClusterStats_Free(ClusterStats *cs) {
+  if (cs->termDocs) {
+    TrieMap_Free(cs->termDocs, NULL);
+  }
+  TrieMap_Free(cs->hotTerms, NULL);
+  pthread_mutex_destroy(&cs->lock);
+  rm_free(cs);
+}
+
+void ClusterStats_Set(ClusterStats *cs, size_t numDocs, size_t totalDocsLen, TrieMap *termDocs,
+                      long long ttl) {
+  pthread_mutex_lock(&cs->lock);
+  TrieMap *old = cs->termDocs;
+  cs->numDocs = numDocs;
+  cs->totalDocsLen = totalDocsLen;
+  cs->termDocs = termDocs;
+  cs->expiresAt = monotonicMillis() + ttl;
+  pthread_mutex_unlock(&cs->lock);
+  if (old) {
+    TrieMap_Free(old, NULL);
+  }
+}
+
+static bool clusterStats_Valid(ClusterStats *cs) {
+  return cs->expiresAt && monotonicMillis() < cs->expiresAt;
+}
+
+bool ClusterStats_Get(ClusterStats *cs, size_t *numDocs, size_t *totalDocsLen) {
+  pthread_mutex_lock(&cs->lock);
+  bool valid = clusterStats_Valid(cs);
+  if (valid) {
+    *numDocs = cs->numDocs;
+    *totalDocsLen = cs->totalDocsLen;
+  }
+  pthread_mutex_unlock(&cs->lock);
+  return valid;
+}
+
+bool ClusterStats_GetTerm(ClusterStats *cs, const char *term, size_t len, size_t localNumDocs,
+                          size_t localTermDocs, size_t *numDocs, size_t *termDocs) {
+  pthread_mutex_lock(&cs->lock);
+  bool valid = clusterStats_Valid(cs);
+  if (valid) {
+    *numDocs = cs->numDocs;
+    void *val = cs->termDocs ? TrieMap_Find(cs->termDocs, term, len) : TRIEMAP_NOTFOUND;
+    if (val != TRIEMAP_NOTFOUND) {
+      *termDocs = (uintptr_t)val;
+    } else if (localNumDocs) {
+      *termDocs = (double)localTermDocs * cs->numDocs / localNumDocs;
+    } else {
+      *termDocs = localTermDocs;
+    }
+    // The local documents may be more recent than the statistics
+    if (*termDocs < localTermDocs) *termDocs = localTermDocs;
+    if (*numDocs < *termDocs) *numDocs = *termDocs;
+  }
+  pthread_mutex_unlock(&cs->lock);
+  return valid;
+}
+
+void ClusterStats_RecordTerm(ClusterStats *cs, const char *term, size_t len) {
+  if (!__atomic_load_n(&cs->recording, __ATOMIC_RELAXED)) {
+    return;
+  }
+  pthread_mutex_lock(&cs->lock);
+  if (cs->hotTerms->cardinality < CLUSTER_STATS_MAX_HOT_TERMS) {
+    TrieMap_Add(cs->hotTerms, (char *)term, len, NULL, NULL);
+  }
+  pthread_mutex_unlock(&cs->lock);
+}
+
+arrayof(char *) ClusterStats_TakeHotTerms(ClusterStats *cs) {
+  pthread_mutex_lock(&cs->lock);
+  TrieMap *hotTerms = cs->hotTerms;
+  cs->hotTerms = NewTrieMap();
+  __atomic_store_n(&cs->recording, true, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&cs->lock);
+
+  arrayof(char *) terms = array_new(char *, hotTerms->cardinality);
+  TrieMapIterator *it = TrieMap_Iterate(hotTerms, "", 0);
+  char *str;
+  tm_len_t len;
+  void *val;
+  while (TrieMapIterator_Next(it, &str, &len, &val)) {
+    array_append(terms, rm_strndup(str, len));
+  }
+  TrieMapIterator_Free(it);
+  TrieMap_Free(hotTerms, NULL);
+  return terms;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "triemap/triemap.h"
+#include "util/arr.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of distinct terms a shard records between two refreshes of the cluster statistics */
+#define CLUSTER_STATS_MAX_HOT_TERMS 1024
+
+/* The statistics of an index over all the shards of a cluster, pushed to every shard by the
+ * coordinator so that the shards score with the same BM25 inputs: the number of documents, their
+ * total length and the number of documents of the terms the queries look up the most. They are
+ * valid for a time to live set by the coordinator, after which the shard scores with its own
+ * statistics again.
+ *
+ * The shard records the terms its queries look up between two refreshes, for the coordinator to
+ * ask the number of documents of. Queries look them up concurrently under the spec read lock, so
+ * the statistics have a lock of their own */
+typedef struct ClusterStats ClusterStats;
+
+ClusterStats *NewClusterStats();
+
+void ClusterStats_Free(ClusterStats *cs);
+
+/* Replace the statistics, valid for `ttl` milliseconds. Takes ownership of `termDocs`, mapping
+ * a term to its number of documents as an uintptr_t */
+void ClusterStats_Set(ClusterStats *cs, size_t numDocs, size_t totalDocsLen, TrieMap *termDocs,
+                      long long ttl);
+
+/* Get the number of documents and their total length over the cluster. Returns false if there
+ * are no valid statistics */
+bool ClusterStats_Get(ClusterStats *cs, size_t *numDocs, size_t *totalDocsLen);
+
+/* Get the number of documents and the number of documents of a term over the cluster, given
+ * their local numbers. A term the coordinator did not push the number of documents of is
+ * estimated from its local ratio. Returns false if there are no valid statistics */
+bool ClusterStats_GetTerm(ClusterStats *cs, const char *term, size_t len, size_t localNumDocs,
+                          size_t localTermDocs, size_t *numDocs, size_t *termDocs);
+
+/* Record a term looked up by a query. Terms are only recorded once the coordinator asked for
+ * them, see ClusterStats_TakeHotTerms */
+void ClusterStats_RecordTerm(ClusterStats *cs, const char *term, size_t len);
+
+/* Return the terms recorded since the previous call, and forget them. The array and the terms
+ * are allocated with rm_malloc */
+arrayof(char *) ClusterStats_TakeHotTerms(ClusterStats *cs);
+
+#ifdef __cplusplus
+}
+#endif
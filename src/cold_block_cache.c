@@ -0,0 +1,133 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "cold_block_cache.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+
+#include <pthread.h>
+
+/* The entries are keyed by the id of their block. A block thawed or freed leaves its entry behind,
+ * as the ids are never reused, to be evicted as it is no longer used */
+static struct {
+  pthread_mutex_t lock;
+  dict *entries;
+  DLLIST lru;
+  ColdBlockCacheStats stats;
+} coldBlockCache_g = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static uint64_t idHash(const void *key) {
+  uint64_t id = (uintptr_t)key;
+  return dictGenHashFunction(&id, sizeof(id));
+}
+
+static dictType idDictType = {
+    .hashFunction = idHash,
+};
+
+static void coldBlockEntry_Free(ColdBlockEntry *e) {
+  Buffer_Free(&e->buf);
+  rm_free(e);
+}
+
+static void coldBlockCache_Delete(ColdBlockEntry *e) {
+  dllist_delete(&e->lru);
+  dictDelete(coldBlockCache_g.entries, (void *)(uintptr_t)e->id);
+  coldBlockCache_g.stats.numEntries--;
+  coldBlockCache_g.stats.bytes -= e->buf.cap;
+  coldBlockEntry_Free(e);
+}
+
+static void coldBlockCache_Evict() {
+  DLLIST *lru = &coldBlockCache_g.lru;
+  while (coldBlockCache_g.stats.bytes > RSGlobalConfig.coldBlocksCacheSize && lru->prev != lru) {
+    coldBlockCache_Delete(DLLIST_ITEM(lru->prev, ColdBlockEntry, lru));
+  }
+}
+
+/* Pin an entry found in the cache. Assumes the cache is locked */
+static ColdBlockEntry *coldBlockCache_Find(uint64_t id) {
+  if (!coldBlockCache_g.entries) {
+    coldBlockCache_g.entries = dictCreate(&idDictType, NULL);
+    dllist_init(&coldBlockCache_g.lru);
+  }
+  dictEntry *de = dictFind(coldBlockCache_g.entries, (void *)(uintptr_t)id);
+  if (!de) {
+    return NULL;
+  }
+  ColdBlockEntry *e = dictGetVal(de);
+  if (!e->refcount++) {
+    dllist_delete(&e->lru);
+  }
+  return e;
+}
+
+ColdBlockEntry *ColdBlockCache_Pin(uint64_t id) {
+  pthread_mutex_lock(&coldBlockCache_g.lock);
+  ColdBlockEntry *e = coldBlockCache_Find(id);
+  if (e) {
+    coldBlockCache_g.stats.hits++;
+  } else {
+    coldBlockCache_g.stats.misses++;
+  }
+  pthread_mutex_unlock(&coldBlockCache_g.lock);
+  return e;
+}
+
+ColdBlockEntry *ColdBlockCache_Add(uint64_t id, Buffer *buf) {
+  pthread_mutex_lock(&coldBlockCache_g.lock);
+  // the block may have been decompressed concurrently
+  ColdBlockEntry *e = coldBlockCache_Find(id);
+  if (e) {
+    pthread_mutex_unlock(&coldBlockCache_g.lock);
+    Buffer_Free(buf);
+    return e;
+  }
+  e = rm_malloc(sizeof(*e));
+  e->id = id;
+  e->buf = *buf;
+  e->refcount = 1;
+  e->lru.next = e->lru.prev = NULL;
+  dictAdd(coldBlockCache_g.entries, (void *)(uintptr_t)id, e);
+  coldBlockCache_g.stats.numEntries++;
+  coldBlockCache_g.stats.bytes += e->buf.cap;
+  coldBlockCache_Evict();
+  pthread_mutex_unlock(&coldBlockCache_g.lock);
+  return e;
+}
+
+void ColdBlockCache_Unpin(ColdBlockEntry *e) {
+  pthread_mutex_lock(&coldBlockCache_g.lock);
+  if (!--e->refcount) {
+    dllist_prepend(&coldBlockCache_g.lru, &e->lru);
+    coldBlockCache_Evict();
+  }
+  pthread_mutex_unlock(&coldBlockCache_g.lock);
+}
+
+void ColdBlockCache_GetStats(ColdBlockCacheStats *stats) {
+  pthread_mutex_lock(&coldBlockCache_g.lock);
+  *stats = coldBlockCache_g.stats;
+  pthread_mutex_unlock(&coldBlockCache_g.lock);
+}
+
+void ColdBlockCache_Free() {
+  pthread_mutex_lock(&coldBlockCache_g.lock);
+  if (coldBlockCache_g.entries) {
+    dictIterator *iter = dictGetIterator(coldBlockCache_g.entries);
+    dictEntry *de;
+    while ((de = dictNext(iter))) {
+      coldBlockEntry_Free(dictGetVal(de));
+    }
+    dictReleaseIterator(iter);
+    dictRelease(coldBlockCache_g.entries);
+    coldBlockCache_g.entries = NULL;
+    coldBlockCache_g.stats.numEntries = 0;
+    coldBlockCache_g.stats.bytes = 0;
+  }
+  pthread_mutex_unlock(&coldBlockCache_g.lock);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "buffer.h"
+#include "util/dllist.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The decompressed data of a cold index block (see IndexBlock_Cold), shared by the readers of the
+ * block. An entry is pinned while a reader is positioned on its block */
+typedef struct ColdBlockEntry {
+  uint64_t id;      // the id the block got when it was compressed
+  Buffer buf;
+  uint32_t refcount;
+  DLLIST_node lru;  // in the list of the unpinned entries, the most recently used first
+} ColdBlockEntry;
+
+typedef struct {
+  size_t hits;
+  size_t misses;
+  size_t numEntries;
+  size_t bytes;
+} ColdBlockCacheStats;
+
+/* Pin the entry of a cold block, NULL if it is not cached */
+ColdBlockEntry *ColdBlockCache_Pin(uint64_t id);
+
+/* Add the decompressed data of a cold block, taking ownership of `buf`, and pin it. If another
+ * reader added the block meanwhile, its entry is pinned and `buf` is freed. Unpinned entries are
+ * evicted from the least recently used while the cache holds more than COLD_BLOCKS_CACHE_SIZE */
+ColdBlockEntry *ColdBlockCache_Add(uint64_t id, Buffer *buf);
+
+void ColdBlockCache_Unpin(ColdBlockEntry *e);
+
+void ColdBlockCache_GetStats(ColdBlockCacheStats *stats);
+
+/* Free the cache. The entries must be unpinned */
+void ColdBlockCache_Free();
+
+#ifdef __cplusplus
+}
+#endif
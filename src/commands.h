@@ -32,6 +32,8 @@
 #define RS_DROP_INDEX_CMD RS_CMD_WRITE_PREFIX ".DROPINDEX"
 #define RS_DROP_IF_X_CMD RS_CMD_WRITE_PREFIX "._DROPIFX"             // for replica of support
 #define RS_DROP_INDEX_IF_X_CMD RS_CMD_WRITE_PREFIX "._DROPINDEXIFX"  // for replica of support
+#define RS_REPLACE_INDEX_CMD RS_CMD_WRITE_PREFIX ".REPLACEINDEX"
+#define RS_IMPORT_CMD RS_CMD_WRITE_PREFIX ".IMPORT"
 #define RS_SYNADD_CMD RS_CMD_WRITE_PREFIX ".SYNADD"
 #define RS_SYNUPDATE_CMD RS_CMD_WRITE_PREFIX ".SYNUPDATE"
 #define RS_ALTER_CMD RS_CMD_WRITE_PREFIX ".ALTER"
@@ -65,5 +67,15 @@
 #define RS_DICT_DUMP RS_CMD_READ_PREFIX ".DICTDUMP"
 #define RS_CONFIG RS_CMD_READ_PREFIX ".CONFIG"
 #define RS_SYNDUMP_CMD RS_CMD_READ_PREFIX ".SYNDUMP"
+#define RS_SYNC_CMD RS_CMD_READ_PREFIX ".SYNC"
+#define RS_WARMUP_CMD RS_CMD_READ_PREFIX ".WARMUP"
+#define RS_EXPORT_CMD RS_CMD_READ_PREFIX ".EXPORT"
+#define RS_SLOWLOG_CMD RS_CMD_READ_PREFIX ".SLOWLOG"
+#define RS_PREPARE_CMD RS_CMD_READ_PREFIX ".PREPARE"
+#define RS_EXECUTE_CMD RS_CMD_READ_PREFIX ".EXECUTE"
+#define RS_DEALLOCATE_CMD RS_CMD_READ_PREFIX ".DEALLOCATE"
+#define RS_TERMSTATS_CMD RS_CMD_READ_PREFIX "._TERMSTATS"        // for the coordinator
+#define RS_SETTERMSTATS_CMD RS_CMD_READ_PREFIX "._SETTERMSTATS"  // for the coordinator
+#define RS_REVISION_CMD RS_CMD_READ_PREFIX "._REVISION"            // for the coordinator
 
 #endif
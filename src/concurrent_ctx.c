@@ -10,6 +10,7 @@
 #include <util/arr.h>
 #include "rmutil/rm_assert.h"
 #include "util/logging.h"
+#include "util/minmax.h"
 
 static arrayof(redisearch_threadpool) threadpools_g = NULL;
 
@@ -137,33 +138,67 @@ void ConcurrentSearchCtx_ReopenKeys(ConcurrentSearchCtx *ctx) {
   }
 }
 
-/** Check the elapsed timer, and release the lock if enough time has passed */
-int ConcurrentSearch_CheckTimer(ConcurrentSearchCtx *ctx) {
-  static struct timespec now;
+// The vDSO serves the raw monotonic clock from the TSC, without entering the kernel
+static inline uint64_t yieldCtl_Now(void) {
+  struct timespec now;
   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void ConcurrentYieldCtl_Init(ConcurrentYieldCtl *ctl, uint64_t targetNS) {
+  *ctl = (ConcurrentYieldCtl){.interval = CONCURRENT_TICK_CHECK, .targetNS = targetNS};
+  ConcurrentYieldCtl_Start(ctl);
+}
+
+void ConcurrentYieldCtl_Start(ConcurrentYieldCtl *ctl) {
+  ctl->holdStartNS = ctl->lastCheckNS = yieldCtl_Now();
+  ctl->ticks = 0;
+}
+
+int ConcurrentYieldCtl_Check(ConcurrentYieldCtl *ctl) {
+  uint64_t now = yieldCtl_Now();
+  uint64_t elapsed = now - ctl->lastCheckNS;
+  if (ctl->ticks) {
+    // The interval which would have taken a fraction of the target, averaged with the current one
+    // so that a single slow (or preempted) tick does not throw it off
+    uint64_t want = ctl->targetNS / CONCURRENT_CHECKS_PER_HOLD;
+    uint64_t next = elapsed ? ctl->ticks * want / elapsed : CONCURRENT_TICK_CHECK_MAX;
+    next = (MIN(next, CONCURRENT_TICK_CHECK_MAX) + ctl->interval) / 2;
+    ctl->interval = MAX(next, 1);
+  }
+  ctl->ticks = 0;
+  ctl->lastCheckNS = now;
+  return now - ctl->holdStartNS >= ctl->targetNS;
+}
+
+void ConcurrentYieldCtl_End(ConcurrentYieldCtl *ctl) {
+  ctl->heldNS += yieldCtl_Now() - ctl->holdStartNS;
+}
 
-  long long durationNS = (long long)1000000000 * (now.tv_sec - ctx->lastTime.tv_sec) +
-                         (now.tv_nsec - ctx->lastTime.tv_nsec);
+uint64_t ConcurrentYieldCtl_HeldNS(const ConcurrentYieldCtl *ctl, int holding) {
+  return ctl->heldNS + (holding ? yieldCtl_Now() - ctl->holdStartNS : 0);
+}
+
+/** Check the elapsed timer, and release the lock if enough time has passed */
+int ConcurrentSearch_CheckTimer(ConcurrentSearchCtx *ctx) {
   // Timeout - release the thread safe context lock and let other threads run as well
-  if (durationNS > CONCURRENT_TIMEOUT_NS) {
+  if (ConcurrentYieldCtl_Check(&ctx->yield)) {
     ConcurrentSearchCtx_Unlock(ctx);
+    ctx->yield.numYields++;
 
     // Right after releasing, we try to acquire the lock again.
     // If other threads are waiting on it, the kernel will decide which one
     // will get the chance to run again. Calling sched_yield is not necessary here.
     // See http://blog.firetree.net/2005/06/22/thread-yield-after-mutex-unlock/
+    // Right after re-acquiring the lock, the hold restarts (see ConcurrentSearchCtx_Lock)
     ConcurrentSearchCtx_Lock(ctx);
-    // Right after re-acquiring the lock, we sample the current time.
-    // This will be used to calculate the elapsed running time
-    ConcurrentSearchCtx_ResetClock(ctx);
     return 1;
   }
   return 0;
 }
 
 void ConcurrentSearchCtx_ResetClock(ConcurrentSearchCtx *ctx) {
-  clock_gettime(CLOCK_MONOTONIC_RAW, &ctx->lastTime);
-  ctx->ticker = 0;
+  ConcurrentYieldCtl_Start(&ctx->yield);
 }
 
 /** Initialize a concurrent context */
@@ -172,10 +207,11 @@ void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx) {
   ctx->isLocked = 0;
   ctx->numOpenKeys = 0;
   ctx->openKeys = NULL;
-  ConcurrentSearchCtx_ResetClock(ctx);
+  ConcurrentYieldCtl_Init(&ctx->yield, CONCURRENT_TIMEOUT_NS);
 }
 
 void ConcurrentSearchCtx_InitSingle(ConcurrentSearchCtx *ctx, RedisModuleCtx *rctx, ConcurrentReopenCallback cb) {
+  ConcurrentYieldCtl_Init(&ctx->yield, CONCURRENT_TIMEOUT_NS);
   ctx->ctx = rctx;
   ctx->isLocked = 0;
   ctx->numOpenKeys = 1;
@@ -224,10 +260,12 @@ void ConcurrentSearchCtx_Lock(ConcurrentSearchCtx *ctx) {
   RS_LOG_ASSERT(!ctx->isLocked, "Redis GIL shouldn't be locked");
   RedisModule_ThreadSafeContextLock(ctx->ctx);
   ctx->isLocked = 1;
+  ConcurrentYieldCtl_Start(&ctx->yield);
   ConcurrentSearchCtx_ReopenKeys(ctx);
 }
 
 void ConcurrentSearchCtx_Unlock(ConcurrentSearchCtx *ctx) {
+  ConcurrentYieldCtl_End(&ctx->yield);
   RedisModule_ThreadSafeContextUnlock(ctx->ctx);
   ctx->isLocked = 0;
 }
@@ -33,8 +33,9 @@
  * for every "cycle" - meaning a processed search result. The concurrency engine will switch
  * execution to another query when the current thread has spent enough time working.
  *
- * The current switch threshold is 200 microseconds. Since measuring time is slow in itself (~50ns)
- * we sample the elapsed time every 20 "cycles" of the query processor.
+ * The switch threshold is CONCURRENT_TIMEOUT_NS. Since measuring time is slow in itself (~50ns)
+ * we only sample the elapsed time every few "cycles", and the number of cycles between two samples
+ * adapts to what a cycle costs (see ConcurrentYieldCtl).
  *
  */
 
@@ -50,10 +51,46 @@ typedef struct {
   void (*freePrivData)(void *);
 } ConcurrentKeyCtx;
 
+/* The adaptive yielding of a holder of a lock, which releases it once it held it for a target time.
+ * The clock is read every `interval` ticks, and after every read the interval is scaled by the
+ * measured cost of a tick, so that the reads are CONCURRENT_CHECKS_PER_HOLD per target time
+ * whether a tick takes a few nanoseconds or many microseconds.
+ *
+ * It also keeps the statistics of the holds: how many times the holder yielded, and for how long
+ * it held the lock in total */
+typedef struct ConcurrentYieldCtl {
+  uint32_t interval;     // ticks between two clock reads
+  uint32_t ticks;        // since the last clock read
+  uint64_t targetNS;     // the time to hold the lock for before yielding
+  uint64_t holdStartNS;  // when the lock was taken
+  uint64_t lastCheckNS;  // when the clock was last read
+  size_t numYields;
+  uint64_t heldNS;       // of the holds which ended
+} ConcurrentYieldCtl;
+
+/* Reset the controller and its statistics, and start a hold */
+void ConcurrentYieldCtl_Init(ConcurrentYieldCtl *ctl, uint64_t targetNS);
+
+/* Start a hold - called when the lock is taken */
+void ConcurrentYieldCtl_Start(ConcurrentYieldCtl *ctl);
+
+/* Read the clock and adapt the interval. Returns 1 if the lock was held for the target time */
+int ConcurrentYieldCtl_Check(ConcurrentYieldCtl *ctl);
+
+/* End a hold - called when the lock is released */
+void ConcurrentYieldCtl_End(ConcurrentYieldCtl *ctl);
+
+/* The total time the lock was held for, including the current hold if `holding` */
+uint64_t ConcurrentYieldCtl_HeldNS(const ConcurrentYieldCtl *ctl, int holding);
+
+/* Count a tick of the holder. Returns 1 if it should yield the lock now */
+static inline int ConcurrentYieldCtl_Tick(ConcurrentYieldCtl *ctl) {
+  return ++ctl->ticks >= ctl->interval && ConcurrentYieldCtl_Check(ctl);
+}
+
 /* The concurrent execution context struct itself. See above for details */
 typedef struct {
-  long long ticker;
-  struct timespec lastTime;
+  ConcurrentYieldCtl yield;
   RedisModuleCtx *ctx;
   ConcurrentKeyCtx *openKeys;
   uint32_t numOpenKeys;
@@ -74,9 +111,14 @@ typedef struct {
  * source file
  */
 
-/** The number of execution "ticks" per elapsed time check. This is intended to reduce the number of
- * calls to clock_gettime() */
+/** The number of execution "ticks" per elapsed time check a holder starts with. This is intended to
+ * reduce the number of calls to clock_gettime(), and then adapts to the cost of the ticks, up to
+ * CONCURRENT_TICK_CHECK_MAX */
 #define CONCURRENT_TICK_CHECK 50
+#define CONCURRENT_TICK_CHECK_MAX 4096
+
+/** The number of elapsed time checks the tick interval is tuned to make per switch threshold */
+#define CONCURRENT_CHECKS_PER_HOLD 4
 
 /** The timeout after which we try to switch to another query thread - in Nanoseconds */
 #define CONCURRENT_TIMEOUT_NS 100000
@@ -137,7 +179,7 @@ void ConcurrentSearchCtx_Init(RedisModuleCtx *rctx, ConcurrentSearchCtx *ctx);
  */
 void ConcurrentSearchCtx_InitSingle(ConcurrentSearchCtx *ctx, RedisModuleCtx *rctx, ConcurrentReopenCallback cb);
 
-/** Reset the clock variables in the concurrent search context */
+/** Reset the clock variables in the concurrent search context - starts a hold of the lock */
 void ConcurrentSearchCtx_ResetClock(ConcurrentSearchCtx *ctx);
 
 /* Free the execution context's dynamically allocated resources */
@@ -179,15 +221,15 @@ int ConcurrentSearch_HandleRedisCommandEx(int poolType, int options, ConcurrentC
 /** This macro is called by concurrent executors (currently the query only).
  * It checks if enough time has passed and releases the global lock if that is the case.
  */
-#define CONCURRENT_CTX_TICK(x)                               \
-  ({                                                         \
-    int conctx__didSwitch = 0;                               \
-    if ((x) && ++(x)->ticker % CONCURRENT_TICK_CHECK == 0) { \
-      if (ConcurrentSearch_CheckTimer((x))) {                \
-        conctx__didSwitch = 1;                               \
-      }                                                      \
-    }                                                        \
-    conctx__didSwitch;                                       \
+#define CONCURRENT_CTX_TICK(x)                                     \
+  ({                                                               \
+    int conctx__didSwitch = 0;                                     \
+    if ((x) && ++(x)->yield.ticks >= (x)->yield.interval) {        \
+      if (ConcurrentSearch_CheckTimer((x))) {                      \
+        conctx__didSwitch = 1;                                     \
+      }                                                            \
+    }                                                              \
+    conctx__didSwitch;                                             \
   })
 
 // Check if the current request can be executed in a threadb
@@ -17,6 +17,7 @@
 #include "rules.h"
 #include "spec.h"
 #include "util/dict.h"
+#include "util/cpu_affinity.h"
 #include "resp3.h"
 
 #define RETURN_ERROR(s) return REDISMODULE_ERR;
@@ -302,6 +303,46 @@ CONFIG_GETTER(getPrivilegedThreadsNum) {
   sds ss = sdsempty();
   return sdscatprintf(ss, "%lu", config->privilegedThreadsNum);
 }
+
+// WORKERS_QUERY_WEIGHT
+CONFIG_SETTER(setWorkersQueryWeight) {
+  int acrc = AC_GetSize(ac, &config->workersQueryWeight, AC_F_GE1);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getWorkersQueryWeight) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->workersQueryWeight);
+}
+
+// MAX_PENDING_QUERIES
+CONFIG_SETTER(setMaxPendingQueries) {
+  int acrc = AC_GetSize(ac, &config->maxPendingQueries, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getMaxPendingQueries) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->maxPendingQueries);
+}
+
+// WORKERS_CPU_LIST
+CONFIG_SETTER(setWorkersCpuList) {
+  const char *list;
+  int acrc = AC_GetString(ac, &list, NULL, 0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (!CPUList_IsValidSetting(list)) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, "Invalid CPU list");
+    return REDISMODULE_ERR;
+  }
+  rm_free(config->workersCpuList);
+  config->workersCpuList = *list ? rm_strdup(list) : NULL;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getWorkersCpuList) {
+  return sdsnew(config->workersCpuList ? config->workersCpuList : "");
+}
 #endif // MT_BUILD
 
 // FRISOINI
@@ -341,6 +382,28 @@ CONFIG_GETTER(getGcScanSize) {
   return sdscatprintf(ss, "%lu", config->gcConfigParams.gcScanSize);
 }
 
+// GC_COMPACT_DOCIDS_RATIO
+CONFIG_SETTER(setGcCompactDocIdsRatio) {
+  int acrc = AC_GetSize(ac, &config->gcConfigParams.compactDocIdsRatio, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getGcCompactDocIdsRatio) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcConfigParams.compactDocIdsRatio);
+}
+
+// GC_COLD_BLOCKS_PERIOD
+CONFIG_SETTER(setGcColdBlocksPeriod) {
+  int acrc = AC_GetSize(ac, &config->gcConfigParams.coldBlocksPeriod, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getGcColdBlocksPeriod) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcConfigParams.coldBlocksPeriod);
+}
+
 // MIN_PHONETIC_TERM_LEN
 CONFIG_SETTER(setForkGcInterval) {
   int acrc = AC_GetSize(ac, &config->gcConfigParams.forkGc.forkGcRunIntervalSec, AC_F_GE1);
@@ -399,6 +462,10 @@ CONFIG_BOOLEAN_GETTER(getForkGCCleanNumericEmptyNodes, gcConfigParams.forkGc.for
 CONFIG_BOOLEAN_SETTER(set_ForkGCCleanNumericEmptyNodes, gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes)
 CONFIG_BOOLEAN_GETTER(get_ForkGCCleanNumericEmptyNodes, gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes, 0)
 
+// FORK_GC_SHARED_MEMORY
+CONFIG_BOOLEAN_SETTER(setForkGcSharedMemory, gcConfigParams.forkGc.forkGcSharedMemory)
+CONFIG_BOOLEAN_GETTER(getForkGcSharedMemory, gcConfigParams.forkGc.forkGcSharedMemory, 0)
+
 CONFIG_GETTER(getMaxResultsToUnsortedMode) {
   sds ss = sdsempty();
   return sdscatprintf(ss, "%lld", config->iteratorsConfigParams.maxResultsToUnsortedMode);
@@ -436,10 +503,26 @@ CONFIG_BOOLEAN_GETTER(getFreeResourcesThread, freeResourcesThread, 0)
 CONFIG_BOOLEAN_SETTER(setPrintProfileClock, requestConfigParams.printProfileClock)
 CONFIG_BOOLEAN_GETTER(getPrintProfileClock, requestConfigParams.printProfileClock, 0)
 
+// PROFILE_HW_COUNTERS
+CONFIG_BOOLEAN_SETTER(setProfileHwCounters, requestConfigParams.profileHwCounters)
+CONFIG_BOOLEAN_GETTER(getProfileHwCounters, requestConfigParams.profileHwCounters, 0)
+
 // RAW_DOCID_ENCODING
 CONFIG_BOOLEAN_SETTER(setRawDocIDEncoding, invertedIndexRawDocidEncoding)
 CONFIG_BOOLEAN_GETTER(getRawDocIDEncoding, invertedIndexRawDocidEncoding, 0)
 
+// STREAM_VBYTE_ENCODING
+CONFIG_BOOLEAN_SETTER(setStreamVByteEncoding, invertedIndexStreamVByteEncoding)
+CONFIG_BOOLEAN_GETTER(getStreamVByteEncoding, invertedIndexStreamVByteEncoding, 0)
+
+// PACKED_OFFSETS_ENCODING
+CONFIG_BOOLEAN_SETTER(setPackedOffsetsEncoding, invertedIndexPackedOffsets)
+CONFIG_BOOLEAN_GETTER(getPackedOffsetsEncoding, invertedIndexPackedOffsets, 0)
+
+// NUMERIC_SORTED_COLUMN
+CONFIG_BOOLEAN_SETTER(setNumericSortedColumn, numericSortedColumn)
+CONFIG_BOOLEAN_GETTER(getNumericSortedColumn, numericSortedColumn, 0)
+
 CONFIG_SETTER(setNumericTreeMaxDepthRange) {
   size_t maxDepthRange;
   int acrc = AC_GetSize(ac, &maxDepthRange, AC_F_GE0);
@@ -502,6 +585,8 @@ CONFIG_SETTER(setGcPolicy) {
   CHECK_RETURN_PARSE_ERROR(acrc);
   if (!strcasecmp(policy, "DEFAULT") || !strcasecmp(policy, "FORK")) {
     config->gcConfigParams.gcPolicy = GCPolicy_Fork;
+  } else if (!strcasecmp(policy, "INCREMENTAL")) {
+    config->gcConfigParams.gcPolicy = GCPolicy_Incremental;
   } else if (!strcasecmp(policy, "LEGACY")) {
     QueryError_SetError(status, QUERY_EPARSEARGS, "Legacy GC policy is no longer supported (since 2.6.0)");
     return REDISMODULE_ERR;
@@ -606,6 +691,167 @@ CONFIG_GETTER(getBGIndexSleepGap) {
   return sdscatprintf(ss, "%u", config->numBGIndexingIterationsBeforeSleep);
 }
 
+// RESULT_CACHE_MAX_MEMORY
+CONFIG_SETTER(setResultCacheMaxMemory) {
+  size_t maxMemory;
+  int acrc = AC_GetSize(ac, &maxMemory, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->resultCacheMaxMemory = maxMemory;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getResultCacheMaxMemory) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->resultCacheMaxMemory);
+}
+
+// GROUPBY_MAX_MEMORY
+CONFIG_SETTER(setGroupByMaxMemory) {
+  size_t maxMemory;
+  int acrc = AC_GetSize(ac, &maxMemory, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->groupByMaxMemory = maxMemory;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getGroupByMaxMemory) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->groupByMaxMemory);
+}
+
+// GROUPBY_TOPN_FACTOR
+CONFIG_SETTER(setGroupByTopNFactor) {
+  unsigned int factor;
+  int acrc = AC_GetUnsigned(ac, &factor, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->groupByTopNFactor = factor;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getGroupByTopNFactor) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->groupByTopNFactor);
+}
+
+// RESULT_CACHE_TTL
+CONFIG_SETTER(setResultCacheTTL) {
+  long long ttl;
+  int acrc = AC_GetLongLong(ac, &ttl, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->resultCacheTTL = ttl;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getResultCacheTTL) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->resultCacheTTL);
+}
+
+// BG_INDEX_CONCURRENT
+CONFIG_BOOLEAN_SETTER(setBGIndexConcurrent, bgIndexConcurrent)
+CONFIG_BOOLEAN_GETTER(getBGIndexConcurrent, bgIndexConcurrent, 0)
+
+// BG_INDEX_SLICE_USEC
+CONFIG_SETTER(setBGIndexSliceUsec) {
+  long long usec;
+  int acrc = AC_GetLongLong(ac, &usec, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->bgIndexSliceUsec = usec;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getBGIndexSliceUsec) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->bgIndexSliceUsec);
+}
+
+// STEM_CACHE_SIZE
+CONFIG_SETTER(setStemCacheSize) {
+  int acrc = AC_GetSize(ac, &config->stemCacheSize, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getStemCacheSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->stemCacheSize);
+}
+
+// ASYNC_UPDATES_MAX_LAG
+CONFIG_SETTER(setAsyncUpdatesMaxLag) {
+  long long lag;
+  int acrc = AC_GetLongLong(ac, &lag, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->asyncUpdatesMaxLag = lag;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getAsyncUpdatesMaxLag) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->asyncUpdatesMaxLag);
+}
+
+// BATCH_WRITES
+CONFIG_BOOLEAN_SETTER(setBatchWrites, batchWrites)
+CONFIG_BOOLEAN_GETTER(getBatchWrites, batchWrites, 0)
+
+// PERSIST_INDEXES
+CONFIG_BOOLEAN_SETTER(setPersistIndexes, persistIndexes)
+CONFIG_BOOLEAN_GETTER(getPersistIndexes, persistIndexes, 0)
+
+// INDEX_SEGMENTS_DIR
+CONFIG_SETTER(setIndexSegmentsDir) {
+  int acrc = AC_GetString(ac, &config->indexSegmentsDir, NULL, 0);
+  RETURN_STATUS(acrc);
+}
+CONFIG_GETTER(getIndexSegmentsDir) {
+  return config->indexSegmentsDir ? sdsnew(config->indexSegmentsDir) : NULL;
+}
+
+// COLD_BLOCKS_CACHE_SIZE
+CONFIG_SETTER(setColdBlocksCacheSize) {
+  int acrc = AC_GetSize(ac, &config->coldBlocksCacheSize, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getColdBlocksCacheSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->coldBlocksCacheSize);
+}
+
+// SLOWLOG_THRESHOLD
+CONFIG_SETTER(setSlowLogThreshold) {
+  long long threshold;
+  int acrc = AC_GetLongLong(ac, &threshold, 0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  // any negative threshold disables the log
+  config->slowLogThreshold = threshold < 0 ? -1 : threshold;
+  return REDISMODULE_OK;
+}
+CONFIG_GETTER(getSlowLogThreshold) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->slowLogThreshold);
+}
+
+// SLOWLOG_MAX_LEN
+CONFIG_SETTER(setSlowLogMaxLen) {
+  int acrc = AC_GetSize(ac, &config->slowLogMaxLen, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+CONFIG_GETTER(getSlowLogMaxLen) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->slowLogMaxLen);
+}
+
+// SLOWLOG_PLAN_SAMPLE
+CONFIG_SETTER(setSlowLogPlanSample) {
+  int acrc = AC_GetSize(ac, &config->slowLogPlanSample, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+CONFIG_GETTER(getSlowLogPlanSample) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%zu", config->slowLogPlanSample);
+}
+
 RSConfig RSGlobalConfig = RS_DEFAULT_CONFIG;
 
 static RSConfigVar *findConfigVar(const RSConfigOptions *config, const char *name) {
@@ -761,6 +1007,26 @@ RSConfigOptions RSGlobalConfigOptions = {
             .getValue = getPrivilegedThreadsNum,
             .flags = RSCONFIGVAR_F_IMMUTABLE,  // TODO: can this be mutable?
         },
+        {.name = "WORKERS_QUERY_WEIGHT",
+         .helpText = "The number of query jobs the workers which are not privileged run for every"
+                     " vector indexing job, while there are jobs of both kinds waiting",
+         .setValue = setWorkersQueryWeight,
+         .getValue = getWorkersQueryWeight,
+         .flags = RSCONFIGVAR_F_IMMUTABLE,
+        },
+        {.name = "MAX_PENDING_QUERIES",
+         .helpText = "Reject the queries which would run in the workers while this number of query"
+                     " jobs are waiting for them (0 to never reject)",
+         .setValue = setMaxPendingQueries,
+         .getValue = getMaxPendingQueries,
+        },
+        {.name = "WORKERS_CPU_LIST",
+         .helpText = "The CPUs the workers run on, as a list of CPUs and ranges (e.g. 0-3,8), or"
+                     " NUMA_LOCAL for the CPUs of the NUMA node the module is loaded on",
+         .setValue = setWorkersCpuList,
+         .getValue = getWorkersCpuList,
+         .flags = RSCONFIGVAR_F_IMMUTABLE,
+        },
 #endif
         {.name = "FRISOINI",
          .helpText = "Path to Chinese dictionary configuration file (for Chinese tokenization)",
@@ -780,7 +1046,7 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setMinPhoneticTermLen,
          .getValue = getMinPhoneticTermLen},
         {.name = "GC_POLICY",
-         .helpText = "gc policy to use (DEFAULT/LEGACY)",
+         .helpText = "gc policy to use (DEFAULT/FORK/INCREMENTAL)",
          .setValue = setGcPolicy,
          .getValue = getGcPolicy,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
@@ -806,6 +1072,21 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "clean empty nodes from numeric tree",
          .setValue = set_ForkGCCleanNumericEmptyNodes,
          .getValue = get_ForkGCCleanNumericEmptyNodes},
+        {.name = "FORK_GC_SHARED_MEMORY",
+         .helpText = "Have the fork gc child pass the repaired index blocks to the main process "
+                     "through a shared memory region, rather than writing them to a pipe.",
+         .setValue = setForkGcSharedMemory,
+         .getValue = getForkGcSharedMemory},
+        {.name = "GC_COMPACT_DOCIDS_RATIO",
+         .helpText = "Have the gc renumber the documents of an index densely once its max doc id "
+                     "is this many times its number of documents. 0 disables the compaction.",
+         .setValue = setGcCompactDocIdsRatio,
+         .getValue = getGcCompactDocIdsRatio},
+        {.name = "GC_COLD_BLOCKS_PERIOD",
+         .helpText = "Have the gc deflate the full blocks of the inverted indexes which were not "
+                     "read for this many seconds. 0 disables it.",
+         .setValue = setGcColdBlocksPeriod,
+         .getValue = getGcColdBlocksPeriod},
         {.name = "_MAX_RESULTS_TO_UNSORTED_MODE",
          .helpText = "max results for union interator in which the interator will switch to "
                      "unsorted mode, should be used for debug only.",
@@ -849,11 +1130,35 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "Disable print of time for ft.profile. For testing only.",
          .setValue = setPrintProfileClock,
          .getValue = getPrintProfileClock},
+        {.name = "PROFILE_HW_COUNTERS",
+         .helpText = "Count the cycles, instructions and cache misses of every iterator and result "
+                     "processor in ft.profile, where the system allows it. Slows the profiled "
+                     "queries down.",
+         .setValue = setProfileHwCounters,
+         .getValue = getProfileHwCounters},
         {.name = "RAW_DOCID_ENCODING",
          .helpText = "Disable compression for DocID inverted index. Boost CPU performance.",
          .setValue = setRawDocIDEncoding,
          .getValue = getRawDocIDEncoding,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "STREAM_VBYTE_ENCODING",
+         .helpText = "Convert full blocks of DocID and frequency only inverted indexes to a "
+                     "stream-vbyte format, decoded a block at a time.",
+         .setValue = setStreamVByteEncoding,
+         .getValue = getStreamVByteEncoding,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "PACKED_OFFSETS_ENCODING",
+         .helpText = "Bit-pack the term offset vectors of inverted indexes in frames of deltas. "
+                     "Smaller than a varint per offset on long text fields.",
+         .setValue = setPackedOffsetsEncoding,
+         .getValue = getPackedOffsetsEncoding,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "NUMERIC_SORTED_COLUMN",
+         .helpText = "Keep a value-sorted copy of the entries of each numeric tree leaf, so ranges "
+                     "partially overlapping a filter are searched instead of fully decoded.",
+         .setValue = setNumericSortedColumn,
+         .getValue = getNumericSortedColumn,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
         {.name = "_NUMERIC_RANGES_PARENTS",
          .helpText = "Keep numeric ranges in numeric tree parent nodes of leafs "
                      "for `x` generations.",
@@ -880,6 +1185,92 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setBGIndexSleepGap,
          .getValue = getBGIndexSleepGap,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "RESULT_CACHE_MAX_MEMORY",
+         .helpText = "The memory (in bytes) each index created with RESULTCACHE may use for "
+                     "cached query replies.",
+         .setValue = setResultCacheMaxMemory,
+         .getValue = getResultCacheMaxMemory},
+        {.name = "RESULT_CACHE_TTL",
+         .helpText = "The time (in milliseconds) a cached query reply is valid for, 0 disables "
+                     "the cache.",
+         .setValue = setResultCacheTTL,
+         .getValue = getResultCacheTTL},
+        {.name = "GROUPBY_MAX_MEMORY",
+         .helpText = "The memory (in bytes) the groups of a GROUPBY may use before they are "
+                     "spilled to temporary files, 0 for no limit.",
+         .setValue = setGroupByMaxMemory,
+         .getValue = getGroupByMaxMemory},
+        {.name = "GROUPBY_TOPN_FACTOR",
+         .helpText = "If set, a GROUPBY sorted by one of its COUNT reducers in descending order, "
+                     "keeping n groups, keeps only this many times n groups, approximating their "
+                     "counts. 0 keeps all the groups.",
+         .setValue = setGroupByTopNFactor,
+         .getValue = getGroupByTopNFactor},
+        {.name = "BG_INDEX_CONCURRENT",
+         .helpText = "Tokenize and stem the documents indexed in the background on the index "
+                     "threads (see INDEX_THREADS), and only add them to the index under the lock.",
+         .setValue = setBGIndexConcurrent,
+         .getValue = getBGIndexConcurrent},
+        {.name = "BG_INDEX_SLICE_USEC",
+         .helpText = "The longest time (in microseconds) a background scan holds the GIL for. "
+                     "The slices are shortened while commands wait for the GIL. 0 releases it "
+                     "after every batch of scanned keys.",
+         .setValue = setBGIndexSliceUsec,
+         .getValue = getBGIndexSliceUsec},
+        {.name = "STEM_CACHE_SIZE",
+         .helpText = "The number of stems each thread caches for each language, 0 disables the "
+                     "cache.",
+         .setValue = setStemCacheSize,
+         .getValue = getStemCacheSize},
+        {.name = "ASYNC_UPDATES_MAX_LAG",
+         .helpText = "The longest time (in milliseconds) a write to an index created with "
+                     "ASYNCUPDATES may wait to be indexed, before the write indexes the pending "
+                     "keys itself. 0 indexes them on every write.",
+         .setValue = setAsyncUpdatesMaxLag,
+         .getValue = getAsyncUpdatesMaxLag},
+        {.name = "BATCH_WRITES",
+         .helpText = "Coalesce the writes to indexed keys during an event-loop iteration, and index "
+                     "the written keys in one batch after it. Commands using an index index its "
+                     "batched keys first, so they see all the writes which preceded them.",
+         .setValue = setBatchWrites,
+         .getValue = getBatchWrites},
+        {.name = "PERSIST_INDEXES",
+         .helpText = "Save the contents of the indexes in the RDB along with their schemas, so "
+                     "that loading the RDB restores them instead of reindexing all of their keys. "
+                     "This includes the RDB of a full sync, which replicas restore the indexes "
+                     "from. Indexes with vector or geometry fields, or with suffix tries or n-gram "
+                     "indexes, are reindexed.",
+         .setValue = setPersistIndexes,
+         .getValue = getPersistIndexes},
+        {.name = "INDEX_SEGMENTS_DIR",
+         .helpText = "A directory to create scratch files in, which the data of the full blocks of "
+                     "the inverted indexes is moved to and mapped from, so that the postings which "
+                     "are not read can be paged out. The files are deleted as soon as they are "
+                     "created. By default the blocks are kept in memory.",
+         .setValue = setIndexSegmentsDir,
+         .getValue = getIndexSegmentsDir,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "COLD_BLOCKS_CACHE_SIZE",
+         .helpText = "The memory, in bytes, the inflated data of the cold index blocks being read "
+                     "may use (see GC_COLD_BLOCKS_PERIOD). The blocks read the least recently are "
+                     "evicted first.",
+         .setValue = setColdBlocksCacheSize,
+         .getValue = getColdBlocksCacheSize},
+        {.name = "SLOWLOG_THRESHOLD",
+         .helpText = "Log the queries which take at least this many milliseconds to FT.SLOWLOG. "
+                     "0 logs every query, a negative threshold none.",
+         .setValue = setSlowLogThreshold,
+         .getValue = getSlowLogThreshold},
+        {.name = "SLOWLOG_MAX_LEN",
+         .helpText = "The number of the latest slow queries FT.SLOWLOG keeps.",
+         .setValue = setSlowLogMaxLen,
+         .getValue = getSlowLogMaxLen},
+        {.name = "SLOWLOG_PLAN_SAMPLE",
+         .helpText = "Count the results of the iterators of one query of this many, so that "
+                     "the plan FT.SLOWLOG logs for it if it is slow has their actual results "
+                     "next to their estimates. 0 logs the estimates only.",
+         .setValue = setSlowLogPlanSample,
+         .getValue = getSlowLogPlanSample},
         {.name = NULL}}};
 
 void RSConfigOptions_AddConfigs(RSConfigOptions *src, RSConfigOptions *dst) {
@@ -993,6 +1384,10 @@ int RSConfig_SetOption(RSConfig *config, RSConfigOptions *options, const char *n
   ArgsCursor_InitRString(&ac, argv + *offset, argc - *offset);
   int rc = var->setValue(config, &ac, status);
   *offset += ac.offset;
+  if (rc == REDISMODULE_OK) {
+    // a configuration may change the reply to a query
+    config->revision++;
+  }
   return rc;
 }
 
@@ -1006,6 +1401,9 @@ void RSConfig_AddToInfo(RedisModuleInfoCtx *ctx) {
   if (RSGlobalConfig.frisoIni != NULL) {
     RedisModule_InfoAddFieldCString(ctx, "friso_ini", (char*)RSGlobalConfig.frisoIni);
   }
+  if (RSGlobalConfig.indexSegmentsDir != NULL) {
+    RedisModule_InfoAddFieldCString(ctx, "index_segments_dir", (char*)RSGlobalConfig.indexSegmentsDir);
+  }
   RedisModule_InfoAddFieldCString(ctx, "enableGC", RSGlobalConfig.gcConfigParams.enableGC ? "ON" : "OFF");
   RedisModule_InfoAddFieldLongLong(ctx, "minimal_term_prefix", RSGlobalConfig.iteratorsConfigParams.minTermPrefix);
   RedisModule_InfoAddFieldLongLong(ctx, "maximal_prefix_expansions", RSGlobalConfig.iteratorsConfigParams.maxPrefixExpansions);
@@ -18,7 +18,7 @@ typedef enum {
   TimeoutPolicy_Invalid       // Not a real value
 } RSTimeoutPolicy;
 
-typedef enum { GCPolicy_Fork = 0 } GCPolicy;
+typedef enum { GCPolicy_Fork = 0, GCPolicy_Incremental } GCPolicy;
 
 const char *TimeoutPolicy_ToString(RSTimeoutPolicy);
 
@@ -31,6 +31,8 @@ static inline const char *GCPolicy_ToString(GCPolicy policy) {
   switch (policy) {
     case GCPolicy_Fork:
       return "fork";
+    case GCPolicy_Incremental:
+      return "incremental";
     default:          // LCOV_EXCL_LINE cannot be reached
       return "huh?";  // LCOV_EXCL_LINE cannot be reached
   }
@@ -41,6 +43,8 @@ typedef struct {
   size_t forkGcRetryInterval;
   size_t forkGcSleepBeforeExit;
   int forkGCCleanNumericEmptyNodes;
+  // transfer the repaired blocks from the child through shared memory rather than the pipe
+  int forkGcSharedMemory;
 } forkGcConfig;
 
 typedef struct {
@@ -48,6 +52,12 @@ typedef struct {
   int enableGC;
   size_t gcScanSize;
   GCPolicy gcPolicy;
+  // compact the document ids of an index once its max doc id is this many times its number of
+  // documents. 0 disables the compaction
+  size_t compactDocIdsRatio;
+  // deflate the blocks of the inverted indexes which were not read for this many seconds. 0
+  // disables it
+  size_t coldBlocksPeriod;
 
   forkGcConfig forkGc;
 } GCConfig;
@@ -62,6 +72,8 @@ typedef struct {
   RSTimeoutPolicy timeoutPolicy;
   // reply with time on profile
   int printProfileClock;
+  // reply with the hardware counters of the iterators and result processors on profile
+  int profileHwCounters;
 } RequestConfig;
 
 // Configuration parameters related to the query execution.
@@ -119,6 +131,12 @@ typedef struct {
   MTMode mt_mode;
   size_t tieredVecSimIndexBufferLimit;
   size_t privilegedThreadsNum;
+  // The query jobs the workers run for every vector indexing job
+  size_t workersQueryWeight;
+  // Queries are rejected while this many query jobs wait for the workers, 0 for no limit
+  size_t maxPendingQueries;
+  // The CPUs the workers run on (see CPUList_FromSetting), or NULL to let them run anywhere
+  char *workersCpuList;
 #endif
 
   size_t minPhoneticTermLen;
@@ -142,6 +160,12 @@ typedef struct {
   size_t numericTreeMaxDepthRange;
   // disable compression for inverted index DocIdsOnly
   int invertedIndexRawDocidEncoding;
+  // stream-vbyte encode full blocks of DocIdsOnly / freqs only inverted indexes
+  int invertedIndexStreamVByteEncoding;
+  // bit-pack the term offset vectors of inverted indexes storing them
+  int invertedIndexPackedOffsets;
+  // keep a value-sorted column of the entries of numeric tree leaves
+  int numericSortedColumn;
 
   // sets the memory limit for vector indexes to resize by (in bytes).
   // 0 indicates no limit. Default value is 0.
@@ -156,6 +180,38 @@ typedef struct {
   // before we call usleep(1) (sleep for 1 micro-second) and make sure that
   // we allow redis process other commands.
   unsigned int numBGIndexingIterationsBeforeSleep;
+  // The memory, in bytes, each index with RESULTCACHE may use for cached query replies
+  size_t resultCacheMaxMemory;
+  // The time, in milliseconds, a cached query reply is valid for
+  long long resultCacheTTL;
+  // The memory, in bytes, the groups of a GROUPBY may use before they are spilled to disk, or 0
+  size_t groupByMaxMemory;
+  // The multiple of the groups sorted by a COUNT in descending order a GROUPBY keeps, or 0 for all
+  unsigned int groupByTopNFactor;
+  // Preprocess the documents indexed by a background scan concurrently, on the index thread pool
+  int bgIndexConcurrent;
+  // The longest time, in microseconds, a background scan holds the GIL for, or 0 for a batch of keys
+  long long bgIndexSliceUsec;
+  // The stems each thread caches per language, or 0 not to cache them
+  size_t stemCacheSize;
+  // The longest time, in milliseconds, a write to an index with ASYNCUPDATES may wait to be indexed
+  long long asyncUpdatesMaxLag;
+  // Coalesce the writes to the keys of all the indexes, and index them once per event-loop iteration
+  int batchWrites;
+  // Save the contents of the indexes in the RDB, for loading it to restore them instead of reindexing
+  int persistIndexes;
+  // If not null, the directory of the files the data of the sealed index blocks is mapped from
+  const char *indexSegmentsDir;
+  // The memory, in bytes, the inflated data of the cold index blocks being read may use
+  size_t coldBlocksCacheSize;
+  // Queries which take at least this many milliseconds are logged to FT.SLOWLOG, -1 logs none
+  long long slowLogThreshold;
+  // The number of the latest slow queries FT.SLOWLOG keeps
+  size_t slowLogMaxLen;
+  // One query of this many records the actual results of its iterators for FT.SLOWLOG, 0 for none
+  size_t slowLogPlanSample;
+  // Bumped whenever a configuration is set, invalidating the cached query replies
+  uint64_t revision;
 } RSConfig;
 
 typedef enum {
@@ -234,12 +290,25 @@ void DialectsGlobalStats_AddToInfo(RedisModuleInfoCtx *ctx);
 #define GET_DIALECT(barr, d) (!!(barr & DIALECT_OFFSET(d)))  // return the truth value of the d'th dialect in the dialect bitarray.
 #define SET_DIALECT(barr, d) (barr |= DIALECT_OFFSET(d))     // set the d'th dialect in the dialect bitarray to true.
 #define VECSIM_DEFAULT_BLOCK_SIZE   1024
+#define DEFAULT_RESULT_CACHE_MAX_MEMORY (16 * 1024 * 1024)
+#define DEFAULT_RESULT_CACHE_TTL 10000
+#define DEFAULT_GROUPBY_MAX_MEMORY 0
+#define DEFAULT_GROUPBY_TOPN_FACTOR 0
+#define DEFAULT_STEM_CACHE_SIZE 4096
+#define DEFAULT_ASYNC_UPDATES_MAX_LAG 100
+#define DEFAULT_SLOWLOG_THRESHOLD 100
+#define DEFAULT_SLOWLOG_MAX_LEN 128
+#define DEFAULT_SLOWLOG_PLAN_SAMPLE 100
+#define DEFAULT_COLD_BLOCKS_CACHE_SIZE (64 * 1024 * 1024)
 
 #ifdef MT_BUILD  
 #define MT_BUILD_CONFIG .numWorkerThreads = 0,                                                                     \
     .mt_mode = MT_MODE_OFF,                                                                                                     \
     .tieredVecSimIndexBufferLimit = DEFAULT_BLOCK_SIZE,                                                            \
-    .privilegedThreadsNum = DEFAULT_PRIVILEGED_THREADS_NUM,
+    .privilegedThreadsNum = DEFAULT_PRIVILEGED_THREADS_NUM,                                                        \
+    .workersQueryWeight = 1,                                                                                       \
+    .maxPendingQueries = 0,                                                                                        \
+    .workersCpuList = NULL,
 #else 
 #define MT_BUILD_CONFIG
 #endif 
@@ -263,6 +332,8 @@ void DialectsGlobalStats_AddToInfo(RedisModuleInfoCtx *ctx);
     .gcConfigParams.gcScanSize = GC_SCANSIZE,                                                                                        \
     .minPhoneticTermLen = DEFAULT_MIN_PHONETIC_TERM_LEN,                                                              \
     .gcConfigParams.gcPolicy = GCPolicy_Fork,                                                                                        \
+    .gcConfigParams.compactDocIdsRatio = 0,                                                                                          \
+    .gcConfigParams.coldBlocksPeriod = 0,                                                                                            \
     .gcConfigParams.forkGc.forkGcRunIntervalSec = DEFAULT_FORK_GC_RUN_INTERVAL,                                                             \
     .gcConfigParams.forkGc.forkGcSleepBeforeExit = 0,                                                                                       \
     .iteratorsConfigParams.maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE,                                                 \
@@ -277,13 +348,32 @@ void DialectsGlobalStats_AddToInfo(RedisModuleInfoCtx *ctx);
     .numericTreeMaxDepthRange = 0,                                                                                    \
     .requestConfigParams.printProfileClock = 1,                                                                                           \
     .invertedIndexRawDocidEncoding = false,                                                                           \
+    .invertedIndexStreamVByteEncoding = false,                                                                        \
+    .invertedIndexPackedOffsets = false,                                                                              \
+    .numericSortedColumn = false,                                                                                     \
     .gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes = true,                                                                             \
+    .gcConfigParams.forkGc.forkGcSharedMemory = false,                                                                                      \
     .freeResourcesThread = true,                                                                                      \
     .requestConfigParams.dialectVersion = 1,                                                                                       \
     .vssMaxResize = 0,                                                                                                \
     .multiTextOffsetDelta = 100,                                                                                      \
     .used_dialects = 0,                                                                                               \
     .numBGIndexingIterationsBeforeSleep = 100,                                                                         \
+    .resultCacheMaxMemory = DEFAULT_RESULT_CACHE_MAX_MEMORY,                                                          \
+    .resultCacheTTL = DEFAULT_RESULT_CACHE_TTL,                                                                       \
+    .groupByMaxMemory = DEFAULT_GROUPBY_MAX_MEMORY,                                                                   \
+    .groupByTopNFactor = DEFAULT_GROUPBY_TOPN_FACTOR,                                                                 \
+    .bgIndexConcurrent = false,                                                                                       \
+    .bgIndexSliceUsec = 0,                                                                                            \
+    .stemCacheSize = DEFAULT_STEM_CACHE_SIZE,                                                                         \
+    .asyncUpdatesMaxLag = DEFAULT_ASYNC_UPDATES_MAX_LAG,                                                              \
+    .batchWrites = 0,                                                                                                 \
+    .persistIndexes = 0,                                                                                              \
+    .indexSegmentsDir = NULL,                                                                                         \
+    .coldBlocksCacheSize = DEFAULT_COLD_BLOCKS_CACHE_SIZE,                                                            \
+    .slowLogThreshold = DEFAULT_SLOWLOG_THRESHOLD,                                                                    \
+    .slowLogMaxLen = DEFAULT_SLOWLOG_MAX_LEN,                                                                         \
+    .slowLogPlanSample = DEFAULT_SLOWLOG_PLAN_SAMPLE,                                                                 \
   }
 
 #define REDIS_ARRAY_LIMIT 7
@@ -7,10 +7,12 @@
 #include "cursor.h"
 #include "resp3.h"
 #include <time.h>
+#include <stdlib.h>
 #include "rmutil/rm_assert.h"
 #include <err.h>
 
-#define Cursor_IsIdle(cur) ((cur)->pos != -1)
+// dllist_delete resets the node of a cursor taken out of the wheel
+#define Cursor_IsIdle(cur) ((cur)->idleNode.next != NULL)
 
 // coord cursors will have odd ids and regular cursors will have even ids
 CursorList g_CursorsList;
@@ -23,54 +25,53 @@ static uint64_t curTimeNs() {
   return tv.tv_nsec + (tv.tv_sec * 1000000000);
 }
 
-static void CursorList_Lock(CursorList *cl) {
-  pthread_mutex_lock(&cl->lock);
+// The parity of the ID tells the list, so the shard is chosen by the bits above it
+static inline CursorListShard *CursorList_Shard(CursorList *cl, uint64_t cid) {
+  return &cl->shards[(cid >> 1) % RSCURSORS_NUM_SHARDS];
 }
 
-static void CursorList_Unlock(CursorList *cl) {
-  pthread_mutex_unlock(&cl->lock);
+static void CursorListShard_Lock(CursorListShard *shard) {
+  pthread_mutex_lock(&shard->lock);
+}
+
+static void CursorListShard_Unlock(CursorListShard *shard) {
+  pthread_mutex_unlock(&shard->lock);
 }
 
 void CursorList_Init(CursorList *cl, bool is_coord) {
   *cl = (CursorList) {0};
-  pthread_mutex_init(&cl->lock, NULL);
-  cl->lookup = kh_init(cursors);
-  Array_Init(&cl->idle);
+  uint64_t tick = curTimeNs() / RSCURSORS_WHEEL_TICK_NS;
+  for (size_t ii = 0; ii < RSCURSORS_NUM_SHARDS; ++ii) {
+    CursorListShard *shard = &cl->shards[ii];
+    pthread_mutex_init(&shard->lock, NULL);
+    shard->lookup = kh_init(cursors);
+    for (size_t jj = 0; jj < RSCURSORS_WHEEL_SLOTS; ++jj) {
+      dllist_init(&shard->wheel[jj]);
+    }
+    shard->lastTick = tick;
+  }
   cl->is_coord = is_coord;
-  srand48(getpid());
 }
 
-static void Cursor_RemoveFromIdle(Cursor *cur) {
-  CursorList *cl = getCursorList(cur->is_coord);
-  Array *idle = &cl->idle;
-  Cursor **ll = ARRAY_GETARRAY_AS(idle, Cursor **);
-  size_t n = ARRAY_GETSIZE_AS(idle, Cursor *);
-
-  if (n > 1) {
-    Cursor *last = ll[n - 1]; /** Last cursor - move to current position */
-    last->pos = cur->pos;
-    ll[last->pos] = last;
-  }
-
-  Array_Resize(idle, sizeof(Cursor *) * (n - 1));
-  if (cur->nextTimeoutNs == cl->nextIdleTimeoutNs) {
-    cl->nextIdleTimeoutNs = 0;
-  }
-  cur->pos = -1;
+// The shard of the cursor is assumed to be locked upon calling this function
+static void Cursor_RemoveFromIdle(CursorList *cl, Cursor *cur) {
+  dllist_delete(&cur->idleNode);
+  __atomic_sub_fetch(&cl->numIdle, 1, __ATOMIC_RELAXED);
 }
 
 #define get_g_CursorsList(is_coord) ((is_coord) ? &g_CursorsListCoord : &g_CursorsList)
 
-/* Assumed to be called under the cursors global lock or upon server shut down. */
-static void Cursor_FreeInternal(Cursor *cur, khiter_t khi) {
+/* Assumed to be called under the lock of the cursor's shard or upon server shut down. */
+static void Cursor_FreeInternal(CursorListShard *shard, Cursor *cur, khiter_t khi) {
   CursorList *cl = get_g_CursorsList(cur->is_coord);
-  /* Decrement the used count */
-  RS_LOG_ASSERT(khi != kh_end(cl->lookup), "Iterator shouldn't be at end of cursor list");
-  RS_LOG_ASSERT(kh_get(cursors, cl->lookup, cur->id) != kh_end(cl->lookup),
+  RS_LOG_ASSERT(khi != kh_end(shard->lookup), "Iterator shouldn't be at end of cursor list");
+  RS_LOG_ASSERT(kh_get(cursors, shard->lookup, cur->id) != kh_end(shard->lookup),
                                                     "Cursor was not found");
-  kh_del(cursors, cl->lookup, khi);
-  RS_LOG_ASSERT(kh_get(cursors, cl->lookup, cur->id) == kh_end(cl->lookup),
+  kh_del(cursors, shard->lookup, khi);
+  RS_LOG_ASSERT(kh_get(cursors, shard->lookup, cur->id) == kh_end(shard->lookup),
                                                     "Failed to delete cursor");
+  /* Decrement the used count */
+  __atomic_sub_fetch(&cl->numTotal, 1, __ATOMIC_RELAXED);
   if (cur->execState) {
     Cursor_FreeExecState(cur->execState);
     cur->execState = NULL;
@@ -81,7 +82,7 @@ static void Cursor_FreeInternal(Cursor *cur, khiter_t khi) {
     IndexSpec *spec = StrongRef_Get(spec_ref);
     // the spec may have been dropped, so we need to make sure it is still valid.
     if(spec) {
-      spec->activeCursors--;
+      __atomic_sub_fetch(&spec->activeCursors, 1, __ATOMIC_RELAXED);
       StrongRef_Release(spec_ref);
     }
     WeakRef_Release(cur->spec_ref);
@@ -90,204 +91,275 @@ static void Cursor_FreeInternal(Cursor *cur, khiter_t khi) {
   rm_free(cur);
 }
 
-static void Cursors_ForEach(CursorList *cl, void (*callback)(CursorList *, Cursor *, void *),
-                            void *arg) {
-  for (size_t ii = 0; ii < ARRAY_GETSIZE_AS(&cl->idle, Cursor *); ++ii) {
-    Cursor *cur = *ARRAY_GETITEM_AS(&cl->idle, ii, Cursor **);
-    Cursor *oldCur = NULL;
-    /**
-     * The cursor `cur` might have been changed in the callback, if it has been
-     * swapped with another one, as deletion means swapping the last cursor to
-     * the current position. We ensure that we do not 'skip' over this cursor
-     * (effectively skipping over the cursor that was just relocated).
-     */
-
-    while (cur && cur != oldCur) {
-      callback(cl, cur, arg);
-      oldCur = cur;
-      if (ARRAY_GETSIZE_AS(&cl->idle, Cursor *) > ii) {
-        cur = *ARRAY_GETITEM_AS(&cl->idle, ii, Cursor **);
-      }
+// Free the idle cursors of a wheel slot which timed out by `now`
+static int CursorListShard_CollectSlot(CursorList *cl, CursorListShard *shard, DLLIST *slot,
+                                       uint64_t now) {
+  int numCollected = 0;
+  DLLIST_node *it = slot->next;
+  while (it != slot) {
+    Cursor *cur = DLLIST_ITEM(it, Cursor, idleNode);
+    it = it->next;
+    if (cur->nextTimeoutNs <= now) {
+      Cursor_RemoveFromIdle(cl, cur);
+      Cursor_FreeInternal(shard, cur, kh_get(cursors, shard->lookup, cur->id));
+      numCollected++;
     }
   }
-}
-
-typedef struct {
-  uint64_t now;
-  int numCollected;
-} cursorGcCtx;
-
-static void cursorGcCb(CursorList *cl, Cursor *cur, void *arg) {
-  cursorGcCtx *ctx = arg;
-  if (cur->nextTimeoutNs <= ctx->now) {
-    Cursor_RemoveFromIdle(cur);
-    Cursor_FreeInternal(cur, kh_get(cursors, cl->lookup, cur->id));
-    ctx->numCollected++;
-  }
+  return numCollected;
 }
 
 /**
  * Garbage collection:
  *
- * Garbage collection is performed:
- *
- * - Every <n> operations
- * - If there are too many active cursors and we want to create a cursor
- * - If NextTimeout is set and is earlier than the current time.
+ * Every operation on a shard first advances its wheel to the current tick,
+ * visiting the slots of the ticks which passed since the previous one - so that
+ * the sweep is spread over the operations, and an operation within the same
+ * tick only re-checks the current slot when forced to.
  *
- * Garbage collection is throttled within a given interval as well.
- *
- * Assumed to be called under the cursors global lock or upon server shut down.
+ * Assumed to be called under the lock of the shard or upon server shut down.
  *
  */
-static int Cursors_GCInternal(CursorList *cl, int force) {
+static int CursorListShard_Advance(CursorList *cl, CursorListShard *shard, int force) {
   uint64_t now = curTimeNs();
-  if ((cl->nextIdleTimeoutNs && cl->nextIdleTimeoutNs > now) ||
-      (!force && now - cl->lastCollect < RSCURSORS_SWEEP_THROTTLE)) {
-    return -1;
+  uint64_t tick = now / RSCURSORS_WHEEL_TICK_NS;
+  if (tick == shard->lastTick && !force) {
+    return 0;
   }
 
-  cl->lastCollect = now;
-  cursorGcCtx ctx = {.now = now};
-  Cursors_ForEach(cl, cursorGcCb, &ctx);
-  return ctx.numCollected;
-}
+  // The slot of the last tick is visited again, as it may hold cursors which
+  // timed out after the previous visit
+  uint64_t first = shard->lastTick;
+  if (tick - first >= RSCURSORS_WHEEL_SLOTS) {
+    first = tick - RSCURSORS_WHEEL_SLOTS + 1;
+  }
+  shard->lastTick = tick;
 
-int Cursors_CollectIdle(CursorList *cl) {
-  CursorList_Lock(cl);
-  int rc = Cursors_GCInternal(cl, 1);
-  CursorList_Unlock(cl);
-  return rc;
+  int numCollected = 0;
+  for (uint64_t t = first; t <= tick; ++t) {
+    DLLIST *slot = &shard->wheel[t % RSCURSORS_WHEEL_SLOTS];
+    if (!DLLIST_IS_EMPTY(slot)) {
+      numCollected += CursorListShard_CollectSlot(cl, shard, slot, now);
+    }
+  }
+  return numCollected;
 }
 
-// The cursors list is assumed to be locked upon calling this function
-static void CursorList_IncrCounter(CursorList *cl) {
-  if (++cl->counter % RSCURSORS_SWEEP_INTERVAL == 0) {
-    Cursors_GCInternal(cl, 0);
+int Cursors_CollectIdle(CursorList *cl) {
+  int rc = 0;
+  for (size_t ii = 0; ii < RSCURSORS_NUM_SHARDS; ++ii) {
+    CursorListShard *shard = &cl->shards[ii];
+    CursorListShard_Lock(shard);
+    rc += CursorListShard_Advance(cl, shard, 1);
+    CursorListShard_Unlock(shard);
   }
+  return rc;
 }
 
 #define mask31(x) ((x) & 0x7fffffffUL) // mask to prevent overflow when adding 1 to the id
-#define rand_even48() (mask31(lrand48()) & ~(1UL))
-#define rand_odd48() (mask31(lrand48()) | (1UL))
+#define rand_even48(xsubi) (mask31(nrand48(xsubi)) & ~(1UL))
+#define rand_odd48(xsubi) (mask31(nrand48(xsubi)) | (1UL))
 
 /**
- * Cursor ID is a 64 bit opaque integer. The upper 32 bits consist of the PID
- * of the process which generated the cursor, and the lower 32 bits consist of
- * the counter at the time at which it was generated. This doesn't make it
+ * Cursor ID is a 64 bit opaque integer, drawn at random, which is odd for the
+ * coordinator cursors and even for the others. This doesn't make it
  * particularly "secure" but it does prevent accidental collisions from both
- * a stuck client and a crashed server
+ * a stuck client and a crashed server.
+ *
+ * The IDs are drawn by the threads concurrently, each from its own random state
  */
-static uint64_t CursorList_GenerateId(CursorList *curlist) {
-  uint64_t id = (curlist->is_coord ? rand_even48() : rand_odd48()) + 1;  // 0 should never be returned as cursor id
+static uint64_t CursorList_DrawId(CursorList *curlist) {
+  static __thread unsigned short xsubi[3];
+  static __thread bool seeded = false;
+  if (!seeded) {
+    uint64_t seed = (uint64_t)getpid() ^ (uint64_t)(uintptr_t)pthread_self() ^ curTimeNs();
+    xsubi[0] = seed;
+    xsubi[1] = seed >> 16;
+    xsubi[2] = seed >> 32;
+    seeded = true;
+  }
+  return (curlist->is_coord ? rand_even48(xsubi) : rand_odd48(xsubi)) + 1;  // 0 should never be returned as cursor id
+}
+
+// Reserve a cursor slot in the index, collecting the idle cursors once if it is full
+static bool Cursors_ReserveInSpec(CursorList *cl, IndexSpec *spec) {
+  if (__atomic_add_fetch(&spec->activeCursors, 1, __ATOMIC_RELAXED) <= spec->cursorsCap) {
+    return true;
+  }
+  __atomic_sub_fetch(&spec->activeCursors, 1, __ATOMIC_RELAXED);
 
-  // For fast lookup we would like the coord cusors to have odd ids and the non-coord to have even
-  while((kh_get(cursors, curlist->lookup, id) != kh_end(curlist->lookup))) {
-    id = (curlist->is_coord ? rand_even48() : rand_odd48()) + 1;  // 0 should never be returned as cursor id
+  /** Collect idle cursors now */
+  Cursors_CollectIdle(cl);
+  if (__atomic_add_fetch(&spec->activeCursors, 1, __ATOMIC_RELAXED) <= spec->cursorsCap) {
+    return true;
   }
-  return id;
+  __atomic_sub_fetch(&spec->activeCursors, 1, __ATOMIC_RELAXED);
+  return false;
 }
 
 Cursor *Cursors_Reserve(CursorList *cl, StrongRef global_spec_ref, unsigned interval,
                         QueryError *status) {
-  CursorList_Lock(cl);
-  CursorList_IncrCounter(cl);
-  Cursor *cur = NULL;
-
   // If the cursor should be associated with a spec,
   // we assume that global_spec_ref points to a valid spec, else the function returns NULL.
   IndexSpec *spec = StrongRef_Get(global_spec_ref);
 
   // If we are in a coordinator ctx, the spec is NULL
-  if (spec && (spec->activeCursors >= spec->cursorsCap)) {
-    /** Collect idle cursors now */
-    Cursors_GCInternal(cl, 0);
-    if (spec->activeCursors >= spec->cursorsCap) {
-      QueryError_SetError(status, QUERY_ELIMIT, "Too many cursors allocated for index");
-      goto done;
-    }
-
+  if (spec && !Cursors_ReserveInSpec(cl, spec)) {
+    QueryError_SetError(status, QUERY_ELIMIT, "Too many cursors allocated for index");
+    return NULL;
   }
 
-  cur = rm_calloc(1, sizeof(*cur));
-  cur->id = CursorList_GenerateId(cl);
-  cur->pos = -1;
+  Cursor *cur = rm_calloc(1, sizeof(*cur));
   cur->timeoutIntervalMs = interval;
   cur->is_coord = cl->is_coord;
   if(spec) {
     // Get a a weak reference to the spec out of the strong ref, and save it in the
     // cursor's struct.
     cur->spec_ref = StrongRef_Demote(global_spec_ref);
-    spec->activeCursors++;
   }
 
-  int dummy;
-  khiter_t iter = kh_put(cursors, cl->lookup, cur->id, &dummy);
-  kh_value(cl->lookup, iter) = cur;
-
-done:
-  CursorList_Unlock(cl);
+  // The shard depends on the ID, so a colliding ID is drawn again under the lock of its own shard
+  CursorListShard *shard;
+  khiter_t iter;
+  int absent;
+  while (true) {
+    cur->id = CursorList_DrawId(cl);
+    shard = CursorList_Shard(cl, cur->id);
+    CursorListShard_Lock(shard);
+    iter = kh_put(cursors, shard->lookup, cur->id, &absent);
+    if (absent) {
+      break;
+    }
+    CursorListShard_Unlock(shard);
+  }
+  kh_value(shard->lookup, iter) = cur;
+  __atomic_add_fetch(&cl->numTotal, 1, __ATOMIC_RELAXED);
+  CursorListShard_Advance(cl, shard, 0);
+  CursorListShard_Unlock(shard);
   return cur;
 }
 
-int Cursor_Pause(Cursor *cur) {
-  CursorList *cl = get_g_CursorsList(cur->is_coord);
+// The shard of the cursor is assumed to be locked upon calling this function
+static void Cursor_PauseInternal(CursorList *cl, CursorListShard *shard, Cursor *cur) {
+  cur->nextTimeoutNs = curTimeNs() + ((uint64_t)cur->timeoutIntervalMs * 1000000);
 
-  CursorList_Lock(cl);
-  CursorList_IncrCounter(cl);
+  /* Add to the wheel slot of its timeout */
+  uint64_t tick = cur->nextTimeoutNs / RSCURSORS_WHEEL_TICK_NS;
+  dllist_append(&shard->wheel[tick % RSCURSORS_WHEEL_SLOTS], &cur->idleNode);
+  __atomic_add_fetch(&cl->numIdle, 1, __ATOMIC_RELAXED);
+}
 
-  cur->nextTimeoutNs = curTimeNs() + ((uint64_t)cur->timeoutIntervalMs * 1000000);
-  if (cur->nextTimeoutNs < cl->nextIdleTimeoutNs || cl->nextIdleTimeoutNs == 0) {
-    cl->nextIdleTimeoutNs = cur->nextTimeoutNs;
-  }
+int Cursor_Pause(Cursor *cur) {
+  CursorList *cl = get_g_CursorsList(cur->is_coord);
+  CursorListShard *shard = CursorList_Shard(cl, cur->id);
 
-  /* Add to idle list */
-  *(Cursor **)(ARRAY_ADD_AS(&cl->idle, Cursor *)) = cur;
-  cur->pos = ARRAY_GETSIZE_AS(&cl->idle, Cursor **) - 1;
-  CursorList_Unlock(cl);
+  CursorListShard_Lock(shard);
+  CursorListShard_Advance(cl, shard, 0);
+  Cursor_PauseInternal(cl, shard, cur);
+  CursorListShard_Unlock(shard);
 
   return REDISMODULE_OK;
 }
 
 Cursor *Cursors_TakeForExecution(CursorList *cl, uint64_t cid) {
-  CursorList_Lock(cl);
-  CursorList_IncrCounter(cl);
+  CursorListShard *shard = CursorList_Shard(cl, cid);
+  CursorListShard_Lock(shard);
+  CursorListShard_Advance(cl, shard, 0);
 
   Cursor *cur = NULL;
-  khiter_t iter = kh_get(cursors, cl->lookup, cid);
-  if (iter != kh_end(cl->lookup)) {
-    cur = kh_value(cl->lookup, iter);
-    if (cur->pos == -1) {
+  khiter_t iter = kh_get(cursors, shard->lookup, cid);
+  if (iter != kh_end(shard->lookup)) {
+    cur = kh_value(shard->lookup, iter);
+    if (!Cursor_IsIdle(cur)) {
       // Cursor is not idle!
       cur = NULL;
     } else {
       // Remove from idle
-      Cursor_RemoveFromIdle(cur);
+      Cursor_RemoveFromIdle(cl, cur);
     }
   }
 
-  CursorList_Unlock(cl);
+  CursorListShard_Unlock(shard);
+  return cur;
+}
+
+Cursor *Cursors_TakeForRead(CursorList *cl, uint64_t cid, void *reader, bool *queued) {
+  CursorListShard *shard = CursorList_Shard(cl, cid);
+  CursorListShard_Lock(shard);
+  CursorListShard_Advance(cl, shard, 0);
+
+  Cursor *cur = NULL;
+  *queued = false;
+  khiter_t iter = kh_get(cursors, shard->lookup, cid);
+  if (iter != kh_end(shard->lookup)) {
+    cur = kh_value(shard->lookup, iter);
+    if (cur->prefetching) {
+      // Served once the prefetch ends, unless another read is already waiting for it
+      if (!cur->deleted && !cur->reader) {
+        cur->reader = reader;
+        *queued = true;
+      }
+      cur = NULL;
+    } else if (!Cursor_IsIdle(cur)) {
+      // Cursor is not idle!
+      cur = NULL;
+    } else {
+      Cursor_RemoveFromIdle(cl, cur);
+    }
+  }
+
+  CursorListShard_Unlock(shard);
+  return cur;
+}
+
+void Cursor_StartPrefetch(Cursor *cur) {
+  CursorListShard *shard = CursorList_Shard(get_g_CursorsList(cur->is_coord), cur->id);
+  CursorListShard_Lock(shard);
+  cur->prefetching = true;
+  CursorListShard_Unlock(shard);
+}
+
+Cursor *Cursor_EndPrefetch(Cursor *cur, void **reader) {
+  CursorList *cl = get_g_CursorsList(cur->is_coord);
+  CursorListShard *shard = CursorList_Shard(cl, cur->id);
+  CursorListShard_Lock(shard);
+  cur->prefetching = false;
+  *reader = cur->reader;
+  cur->reader = NULL;
+  if (cur->deleted) {
+    Cursor_FreeInternal(shard, cur, kh_get(cursors, shard->lookup, cur->id));
+    cur = NULL;
+  } else if (!*reader) {
+    Cursor_PauseInternal(cl, shard, cur);
+    cur = NULL;
+  }
+  CursorListShard_Unlock(shard);
   return cur;
 }
 
 int Cursors_Purge(CursorList *cl, uint64_t cid) {
-  CursorList_Lock(cl);
-  CursorList_IncrCounter(cl);
+  CursorListShard *shard = CursorList_Shard(cl, cid);
+  CursorListShard_Lock(shard);
+  CursorListShard_Advance(cl, shard, 0);
 
   int rc;
-  khiter_t iter = kh_get(cursors, cl->lookup, cid);
-  if (iter != kh_end(cl->lookup)) {
-    Cursor *cur = kh_value(cl->lookup, iter);
-    if (Cursor_IsIdle(cur)) {
-      Cursor_RemoveFromIdle(cur);
+  khiter_t iter = kh_get(cursors, shard->lookup, cid);
+  if (iter != kh_end(shard->lookup)) {
+    Cursor *cur = kh_value(shard->lookup, iter);
+    if (cur->prefetching) {
+      // The prefetch still reads the cursor, it frees it once it is done
+      cur->deleted = true;
+    } else {
+      if (Cursor_IsIdle(cur)) {
+        Cursor_RemoveFromIdle(cl, cur);
+      }
+      Cursor_FreeInternal(shard, cur, iter);
     }
-    Cursor_FreeInternal(cur, iter);
     rc = REDISMODULE_OK;
 
   } else {
     rc = REDISMODULE_ERR;
   }
-  CursorList_Unlock(cl);
+  CursorListShard_Unlock(shard);
   return rc;
 }
 
@@ -295,51 +367,47 @@ int Cursor_Free(Cursor *cur) {
   return Cursors_Purge(get_g_CursorsList(cur->is_coord), cur->id);
 }
 
-void Cursors_RenderStats(CursorList *cl, CursorList *cl_coord, IndexSpec *spec, RedisModule_Reply *reply) {
-  CursorList_Lock(cl);
+#define CursorList_NumIdle(cl) __atomic_load_n(&(cl)->numIdle, __ATOMIC_RELAXED)
+#define CursorList_NumTotal(cl) __atomic_load_n(&(cl)->numTotal, __ATOMIC_RELAXED)
 
+void Cursors_RenderStats(CursorList *cl, CursorList *cl_coord, IndexSpec *spec, RedisModule_Reply *reply) {
   RedisModule_ReplyKV_Map(reply, "cursor_stats");
 
-    RedisModule_ReplyKV_LongLong(reply, "global_idle", ARRAY_GETSIZE_AS(&cl->idle, Cursor **) +
-                                                        ARRAY_GETSIZE_AS(&cl_coord->idle, Cursor **));
-    RedisModule_ReplyKV_LongLong(reply, "global_total", kh_size(cl->lookup) + kh_size(cl_coord->lookup));
+    RedisModule_ReplyKV_LongLong(reply, "global_idle", CursorList_NumIdle(cl) + CursorList_NumIdle(cl_coord));
+    RedisModule_ReplyKV_LongLong(reply, "global_total", CursorList_NumTotal(cl) + CursorList_NumTotal(cl_coord));
     RedisModule_ReplyKV_LongLong(reply, "index_capacity", spec->cursorsCap);
-    RedisModule_ReplyKV_LongLong(reply, "index_total", spec->activeCursors);
+    RedisModule_ReplyKV_LongLong(reply, "index_total", __atomic_load_n(&spec->activeCursors, __ATOMIC_RELAXED));
 
   RedisModule_Reply_MapEnd(reply);
-
-  CursorList_Unlock(cl);
 }
 
 #ifdef FTINFO_FOR_INFO_MODULES
 void Cursors_RenderStatsForInfo(CursorList *cl, CursorList *cl_coord, IndexSpec *spec, RedisModuleInfoCtx *ctx) {
-  CursorList_Lock(cl);
-
   RedisModule_InfoBeginDictField(ctx, "cursor_stats");
-  RedisModule_InfoAddFieldLongLong(ctx, "global_idle", ARRAY_GETSIZE_AS(&cl->idle, Cursor **) +
-                                                        ARRAY_GETSIZE_AS(&cl_coord->idle, Cursor **));
-  RedisModule_InfoAddFieldLongLong(ctx, "global_total", kh_size(cl->lookup) + kh_size(cl_coord->lookup));
+  RedisModule_InfoAddFieldLongLong(ctx, "global_idle", CursorList_NumIdle(cl) + CursorList_NumIdle(cl_coord));
+  RedisModule_InfoAddFieldLongLong(ctx, "global_total", CursorList_NumTotal(cl) + CursorList_NumTotal(cl_coord));
   RedisModule_InfoAddFieldLongLong(ctx, "index_capacity", spec->cursorsCap);
-  RedisModule_InfoAddFieldLongLong(ctx, "index_total", spec->activeCursors);
+  RedisModule_InfoAddFieldLongLong(ctx, "index_total", __atomic_load_n(&spec->activeCursors, __ATOMIC_RELAXED));
   RedisModule_InfoEndDictField(ctx);
-
-  CursorList_Unlock(cl);
 }
 #endif // FTINFO_FOR_INFO_MODULES
 
 void CursorList_Destroy(CursorList *cl) {
-  Cursors_GCInternal(cl, 1);
-  for (khiter_t ii = 0; ii != kh_end(cl->lookup); ++ii) {
-    if (!kh_exist(cl->lookup, ii)) {
-      continue;
+  for (size_t ii = 0; ii < RSCURSORS_NUM_SHARDS; ++ii) {
+    CursorListShard *shard = &cl->shards[ii];
+    for (khiter_t jj = 0; jj != kh_end(shard->lookup); ++jj) {
+      if (!kh_exist(shard->lookup, jj)) {
+        continue;
+      }
+      Cursor *c = kh_val(shard->lookup, jj);
+      if (Cursor_IsIdle(c)) {
+        Cursor_RemoveFromIdle(cl, c);
+      }
+      Cursor_FreeInternal(shard, c, jj);
     }
-    Cursor *c = kh_val(cl->lookup, ii);
-    Cursor_FreeInternal(c, ii);
+    kh_destroy(cursors, shard->lookup);
+    pthread_mutex_destroy(&shard->lock);
   }
-  kh_destroy(cursors, cl->lookup);
-
-  pthread_mutex_destroy(&cl->lock);
-  Array_Free(&cl->idle);
 }
 
 void CursorList_Empty(CursorList *cl) {
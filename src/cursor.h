@@ -10,7 +10,7 @@
 #include <unistd.h>
 #include <pthread.h>
 #include "util/khash.h"
-#include "util/array.h"
+#include "util/dllist.h"
 #include "search_ctx.h"
 
 struct CursorList;
@@ -35,44 +35,60 @@ typedef struct Cursor {
   /** Initial timeout interval */
   unsigned timeoutIntervalMs;
 
-  /** Position within idle list */
-  int pos;
+  /** Node in the idle wheel of the cursor's shard, unlinked while the cursor is not idle */
+  DLLIST_node idleNode;
 
   /** Is it an internal coordinator cursor or a user cursor*/
   bool is_coord;
+
+  /** Set while the next chunk is read ahead (see Cursor_StartPrefetch) */
+  bool prefetching;
+
+  /** Set if the cursor was deleted while it was prefetching, to be freed once it is done */
+  bool deleted;
+
+  /** A read waiting for the prefetch to end, opaque to the cursor */
+  void *reader;
 } Cursor;
 
 KHASH_MAP_INIT_INT64(cursors, Cursor *);
+
+#define RSCURSORS_NUM_SHARDS 16
+#define RSCURSORS_WHEEL_SLOTS 256
+#define RSCURSORS_WHEEL_TICK_NS (100 * 1000000) /* The timeouts each wheel slot spans, in NS */
+
 /**
- * Cursor list. This is the global cursor list and does not distinguish
- * between different specs.
+ * A shard of the cursor list, holding the cursors whose ID maps to it.
+ *
+ * The idle cursors are kept in a timing wheel: a cursor is linked in the slot of the tick its
+ * timeout falls in, modulo the number of slots. Collecting the idle cursors only visits the slots
+ * of the ticks which passed since the last collection, and frees the cursors of those slots which
+ * timed out (a slot also holds cursors which time out in later rounds of the wheel).
  */
-typedef struct CursorList {
+typedef struct CursorListShard {
+  pthread_mutex_t lock;
+
   /** Cursor lookup by ID */
   khash_t(cursors) * lookup;
 
-  /** List of idle cursors */
-  Array idle;
-
-  pthread_mutex_t lock;
+  /** The idle cursors, by the tick of their timeout */
+  DLLIST wheel[RSCURSORS_WHEEL_SLOTS];
 
-  /**
-   * Counter - this serves two purposes:
-   * 1) When counter % n == 0, a GC sweep is performed
-   * 2) Used to calculate a monotonically incrementing cursor ID.
-   */
-  uint32_t counter;
+  /** The tick the wheel was last collected at */
+  uint64_t lastTick;
+} __attribute__((aligned(64))) CursorListShard;
 
-  /**
-   * Last time GC was performed.
-   */
-  uint64_t lastCollect;
+/**
+ * Cursor list. This is the global cursor list and does not distinguish
+ * between different specs. It is sharded by the cursor ID, so that the
+ * operations on different cursors seldom take the same lock.
+ */
+typedef struct CursorList {
+  CursorListShard shards[RSCURSORS_NUM_SHARDS];
 
-  /**
-   * Next timeout - set to the lowest entry.
-   * This is used as a hint to avoid excessive sweeps.
-   */
-  uint64_t nextIdleTimeoutNs;
+  /** The number of idle cursors, and of all the cursors - read without a lock */
+  size_t numIdle;
+  size_t numTotal;
 
   /** Is it an internal coordinator cursor or a user cursor */
   bool is_coord;
@@ -91,15 +107,14 @@ static inline CursorList *GetGlobalCursor(uint64_t cid) {
 /**
  * Threading/Concurrency behavior
  *
- * Any manipulation of the cursor list happens with the GIL locked. Sequence
+ * Any manipulation of a cursor happens with the lock of its shard held. Sequence
  * is as follows:
  *
  * (1) New cursor is allocated -- happens from main thread. New cursor is
  *     allocated and is passed to query execution thread. The cursor is not
  *     placed inside the cursor list yet, but the total count is incremented
  *
- * (2) If the cursor has results, the GIL is locked and the cursor is placed
- *     inside the idle list.
+ * (2) If the cursor has results, the cursor is placed inside the idle wheel.
  *
  * (3) When the cursor is subsequently accessed, it is again removed from the
  *     idle list.
@@ -131,8 +146,6 @@ void CursorList_Destroy(CursorList *cl);
 void CursorList_Empty(CursorList *cl);
 
 #define RSCURSORS_DEFAULT_CAPACITY 128
-#define RSCURSORS_SWEEP_INTERVAL 500                /* GC Every 500 requests */
-#define RSCURSORS_SWEEP_THROTTLE (1 * (1000000000)) /* Throttle, in NS */
 
 /**
  * Check if the cursor has a reference to a spec.
@@ -158,6 +171,29 @@ Cursor *Cursors_Reserve(CursorList *cl, StrongRef global_spec_ref, unsigned time
  */
 Cursor *Cursors_TakeForExecution(CursorList *cl, uint64_t cid);
 
+/**
+ * Retrieve a cursor for a read, like Cursors_TakeForExecution. If the cursor
+ * is reading its next chunk ahead, `reader` is queued on it instead: NULL is
+ * returned, `*queued` is set, and the reader is handed the cursor by
+ * Cursor_EndPrefetch
+ */
+Cursor *Cursors_TakeForRead(CursorList *cl, uint64_t cid, void *reader, bool *queued);
+
+/**
+ * Mark a cursor taken for execution as reading its next chunk ahead. It is
+ * not idle meanwhile, and if it is deleted it is only freed by
+ * Cursor_EndPrefetch
+ */
+void Cursor_StartPrefetch(Cursor *cur);
+
+/**
+ * End the read ahead of a cursor. If a read was queued on the cursor meanwhile,
+ * it is returned in `*reader` along with the cursor, still taken for execution,
+ * or with NULL if the cursor was deleted. Otherwise the cursor is paused, or
+ * freed if it was deleted, and NULL is returned
+ */
+Cursor *Cursor_EndPrefetch(Cursor *cur, void **reader);
+
 /**
  * Pause a cursor, setting it to idle and placing it back in the cursor
  * list
@@ -174,10 +210,14 @@ int Cursor_Free(Cursor *cl);
  */
 int Cursors_Purge(CursorList *cl, uint64_t cid);
 
+/**
+ * Free the idle cursors which timed out, in all the shards. Returns the number
+ * of cursors freed
+ */
 int Cursors_CollectIdle(CursorList *cl);
 
 /**
- * Assumed to be called by the main thread with a valid locked spec, under the cursors lock.
+ * Assumed to be called by the main thread with a valid locked spec.
  */
 void Cursors_RenderStats(CursorList *cl, CursorList *cl_coord, IndexSpec *spec, RedisModule_Reply *reply);
 
@@ -16,6 +16,8 @@
 #include "gc.h"
 #include "module.h"
 #include "suffix.h"
+#include "index_memory.h"
+#include "alloc_stats.h"
 
 #define DUMP_PHONETIC_HASH "DUMP_PHONETIC_HASH"
 
@@ -118,6 +120,7 @@ DEBUG_COMMAND(InvertedIndexSummary) {
     REPLY_WITH_LONG_LONG("firstId", block->firstId, blockBulkLen);
     REPLY_WITH_LONG_LONG("lastId", block->lastId, blockBulkLen);
     REPLY_WITH_LONG_LONG("numEntries", block->numEntries, blockBulkLen);
+    REPLY_WITH_LONG_LONG("capacity", InvertedIndex_BlockCapacity(invidx, i), blockBulkLen);
 
     RedisModule_ReplySetArrayLength(ctx, blockBulkLen);
   }
@@ -289,7 +292,6 @@ void NumericRange_DebugReply(RedisModuleCtx *ctx, NumericRange *r) {
   if (r) {
     REPLY_WITH_LONG_LONG("minVal", r->minVal, len);
     REPLY_WITH_LONG_LONG("maxVal", r->maxVal, len);
-    REPLY_WITH_LONG_LONG("unique_sum", r->unique_sum, len);
     REPLY_WITH_LONG_LONG("invertedIndexSize", r->invertedIndexSize, len);
     REPLY_WITH_LONG_LONG("card", r->card, len);
     REPLY_WITH_LONG_LONG("cardCheck", r->cardCheck, len);
@@ -415,38 +417,36 @@ end:
   return REDISMODULE_OK;
 }
 
+typedef struct {
+  RedisModuleCtx *ctx;
+  long resultSize;
+} DumpSuffixCtx;
+
+static void replySuffix(const char *str, size_t len, void *p) {
+  DumpSuffixCtx *dctx = p;
+  RedisModule_ReplyWithStringBuffer(dctx->ctx, str, len);
+  ++dctx->resultSize;
+}
+
+static void replySuffixes(RedisModuleCtx *ctx, SuffixArray *suffix) {
+  DumpSuffixCtx dctx = {.ctx = ctx};
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  SuffixArray_IterateSuffixes(suffix, replySuffix, &dctx);
+  RedisModule_ReplySetArrayLength(ctx, dctx.resultSize);
+}
+
 DEBUG_COMMAND(DumpSuffix) {
   if (argc != 1 && argc != 2) {
     return RedisModule_WrongArity(ctx);
   }
   GET_SEARCH_CTX(argv[0]);
   if (argc == 1) { // suffix trie of global text field
-    Trie *suffix = sctx->spec->suffix;
+    SuffixArray *suffix = sctx->spec->suffix;
     if (!suffix) {
       RedisModule_ReplyWithError(ctx, "Index does not have suffix trie");
       goto end;
     }
-
-    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
-    long resultSize = 0;
-
-    // iterate trie and reply with terms
-    TrieIterator *it = TrieNode_Iterate(suffix->root, NULL, NULL, NULL);
-    rune *rstr;
-    t_len len;
-    float score;
-
-    while (TrieIterator_Next(it, &rstr, &len, NULL, &score, NULL)) {
-      size_t slen = 0;
-      char *s = runesToStr(rstr, len, &slen);
-      RedisModule_ReplyWithSimpleString(ctx, s);
-      rm_free(s);
-      ++resultSize;
-    }
-
-    TrieIterator_Free(it);
-
-    RedisModule_ReplySetArrayLength(ctx, resultSize);
+    replySuffixes(ctx, suffix);
 
   } else { // suffix triemap of tag field
     RedisModuleString *keyName = getFieldKeyName(sctx->spec, argv[1], INDEXFLD_T_TAG);
@@ -464,22 +464,7 @@ DEBUG_COMMAND(DumpSuffix) {
       goto end;
     }
 
-    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
-    long resultSize = 0;
-
-    TrieMapIterator *it = TrieMap_Iterate(idx->suffix, "", 0);
-    char *str;
-    tm_len_t len;
-    void *value;
-    while (TrieMapIterator_Next(it, &str, &len, &value)) {
-      str[len] = '\0';
-      RedisModule_ReplyWithSimpleString(ctx, str);
-      ++resultSize;
-    }
-
-    TrieMapIterator_Free(it);
-
-    RedisModule_ReplySetArrayLength(ctx, resultSize);
+    replySuffixes(ctx, idx->suffix);
   }
 end:
   SearchCtx_Free(sctx);
@@ -607,6 +592,7 @@ DEBUG_COMMAND(GCCleanNumeric) {
 
   rt->numRanges += rv.numRanges;
   rt->emptyLeaves = 0;
+  rt->numRanges += NumericRangeTree_Rebalance(rt).numRanges;
 
 end:
   if (keyp) {
@@ -807,9 +793,7 @@ static void replySortVector(const char *name, const RSDocumentMetadata *dmd,
   RSSortingVector *sv = dmd->sortVector;
   RedisModule_ReplyKV_Array(reply, name);
   for (size_t ii = 0; ii < sv->len; ++ii) {
-    if (!sv->values[ii]) {
-      continue;
-    }
+    RSValue *val = RSSortingVector_NewValue(sv, ii);
     RedisModule_Reply_Array(reply);
       RedisModule_ReplyKV_LongLong(reply, "index", ii);
 
@@ -818,8 +802,11 @@ static void replySortVector(const char *name, const RSDocumentMetadata *dmd,
       RedisModule_Reply_Stringf(reply, "%s AS %s", fs ? fs->path : "!!!", fs ? fs->name : "???");
 
       RedisModule_Reply_SimpleString(reply, "value");
-      RSValue_SendReply(reply, sv->values[ii], 0);
+      RSValue_SendReply(reply, val ? val : RS_NullVal(), 0);
     RedisModule_Reply_ArrayEnd(reply);
+    if (val) {
+      RSValue_Decref(val);
+    }
   }
   RedisModule_Reply_ArrayEnd(reply);
 }
@@ -913,6 +900,73 @@ DEBUG_COMMAND(VecsimInfo) {
   return REDISMODULE_OK;
 }
 
+/**
+ * FT.DEBUG MEMORY <index> [TOP <n>]
+ */
+DEBUG_COMMAND(IndexMemory) {
+  if (argc != 1 && argc != 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+  long long topTerms = INDEX_MEMORY_DEFAULT_TOP_TERMS;
+  if (argc == 3) {
+    const char *opt = RedisModule_StringPtrLen(argv[1], NULL);
+    if (strcasecmp(opt, "TOP") || RedisModule_StringToLongLong(argv[2], &topTerms) != REDISMODULE_OK ||
+        topTerms < 0 || topTerms > INDEX_MEMORY_MAX_TOP_TERMS) {
+      return RedisModule_ReplyWithError(ctx, "Invalid TOP argument");
+    }
+  }
+  GET_SEARCH_CTX(argv[0]);
+  RedisSearchCtx_LockSpecRead(sctx);
+
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  IndexSpec_ReplyMemory(reply, sctx->spec, topTerms);
+  RedisModule_EndReply(reply);
+
+  SearchCtx_Free(sctx);
+  return REDISMODULE_OK;
+}
+
+/**
+ * FT.DEBUG BUILD_PROFILE <index>
+ */
+DEBUG_COMMAND(BuildProfileCommand) {
+  if (argc != 1) {
+    return RedisModule_WrongArity(ctx);
+  }
+  // reading the profile of a lazy index does not load it
+  IndexLoadOptions loadOpts = {
+      .name = {.rstring = argv[0]},
+      .flags = INDEXSPEC_LOAD_KEY_RSTRING | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  BuildProfile_Reply(reply, sp);
+  RedisModule_EndReply(reply);
+  return REDISMODULE_OK;
+}
+
+/**
+ * FT.DEBUG ALLOCSTATS
+ */
+DEBUG_COMMAND(AllocStatsCommand) {
+  if (argc != 0) {
+    return RedisModule_WrongArity(ctx);
+  }
+  if (!AllocStats_Enabled()) {
+    return RedisModule_ReplyWithError(ctx, "Allocation stats are not built, build with ALLOC_STATS=1");
+  }
+
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  AllocStats_Reply(reply);
+  RedisModule_EndReply(reply);
+  return REDISMODULE_OK;
+}
+
 typedef struct DebugCommandType {
   char *name;
   int (*callback)(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
@@ -938,6 +992,9 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex},
                                {"GIT_SHA", GitSha},
                                {"TTL", ttl},
                                {"VECSIM_INFO", VecsimInfo},
+                               {"MEMORY", IndexMemory},
+                               {"BUILD_PROFILE", BuildProfileCommand},
+                               {"ALLOCSTATS", AllocStatsCommand},
                                {NULL, NULL}};
 
 int DebugCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
@@ -10,9 +10,9 @@
 #include <stdio.h>
 #include "redismodule.h"
 #include "util/fnv.h"
-#include "triemap/triemap.h"
 #include "sortable.h"
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "spec.h"
 #include "config.h"
 
@@ -27,23 +27,29 @@
     RS_LOG_ASSERT(count < (1 << 16) - 1, "overflow of dmd ref_count");        \
   })
 
-/* Creates a new DocTable with a given capacity */
+/* Creates a new DocTable, with room for the pages of `cap` documents */
 DocTable NewDocTable(size_t cap, size_t max_size) {
   DocTable ret = {
       .size = 1,
-      .cap = cap,
+      .numPages = (cap >> DOCTABLE_PAGE_BITS) + 1,
       .maxDocId = 0,
       .memsize = 0,
       .sortablesSize = 0,
+      .maxScore = 0,
       .maxSize = max_size,
       .dim = NewDocIdMap(),
   };
-  ret.buckets = rm_calloc(cap, sizeof(*ret.buckets));
+  ret.pages = rm_calloc(ret.numPages, sizeof(*ret.pages));
   return ret;
 }
 
-static inline uint32_t DocTable_GetBucket(const DocTable *t, t_docId docId) {
-  return docId < t->maxSize ? docId : docId % t->maxSize;
+/* Get the metadata in the slot of a document id, or NULL if the slot is empty */
+static inline RSDocumentMetadata *DocTable_GetSlot(const DocTable *t, t_docId docId) {
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  if (pageIndex >= t->numPages || !t->pages[pageIndex]) {
+    return NULL;
+  }
+  return t->pages[pageIndex]->slots[docId & (DOCTABLE_PAGE_SIZE - 1)];
 }
 
 static inline int DocTable_ValidateDocId(const DocTable *t, t_docId docId) {
@@ -54,25 +60,14 @@ static RSDocumentMetadata *DocTable_GetOwn(const DocTable *t, t_docId docId) {
   if (!DocTable_ValidateDocId(t, docId)) {
     return NULL;
   }
-  uint32_t bucketIndex = DocTable_GetBucket(t, docId);
-  if (bucketIndex >= t->cap) {
+  // We have locked the index spec (R/W), so we either have a writer alone or multiple readers. In
+  // any case, we can safely read the slot without a lock and increment the ref count of the
+  // document metadata when we find it.
+  RSDocumentMetadata *dmd = DocTable_GetSlot(t, docId);
+  if (!dmd || (dmd->flags & Document_Deleted)) {
     return NULL;
   }
-  // While we iterate over the chain, we have locked the index spec (R/W), so we either a writer alone or
-  // multiple readers. In any case, we can safely iterate over the chain without a lock and
-  // increment the ref count of the document metadata when we find it.
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  DLLIST2_FOREACH(it, &dmdChain->lroot) {
-    RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    
-    if (dmd->id == docId) {
-      if (dmd->flags & Document_Deleted) {
-        return NULL;
-      }
-      return dmd;
-    }
-  }
-  return NULL;
+  return dmd;
 }
 
 const RSDocumentMetadata *DocTable_Borrow(const DocTable *t, t_docId docId) {
@@ -84,24 +79,7 @@ const RSDocumentMetadata *DocTable_Borrow(const DocTable *t, t_docId docId) {
 }
 
 int DocTable_Exists(const DocTable *t, t_docId docId) {
-  if (!docId || docId > t->maxDocId) {
-    return 0;
-  }
-  uint32_t ix = DocTable_GetBucket(t, docId);
-  if (ix >= t->cap) {
-    return 0;
-  }
-  const DMDChain *chain = t->buckets + ix;
-  if (chain == NULL) {
-    return 0;
-  }
-  DLLIST2_FOREACH(it, &chain->lroot) {
-    const RSDocumentMetadata *md = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (md->id == docId && !(md->flags & Document_Deleted)) {
-      return 1;
-    }
-  }
-  return 0;
+  return DocTable_GetOwn(t, docId) != NULL;
 }
 
 const RSDocumentMetadata *DocTable_BorrowByKeyR(const DocTable *t, RedisModuleString *s) {
@@ -112,30 +90,108 @@ const RSDocumentMetadata *DocTable_BorrowByKeyR(const DocTable *t, RedisModuleSt
   return DocTable_Borrow(t, id);
 }
 
+static void DocTable_SetLive(DocTable *t, t_docId docId) {
+  size_t word = docId / 64;
+  if (word >= t->liveDocsWords) {
+    size_t oldWords = t->liveDocsWords;
+    t->liveDocsWords = MAX(word + 1, oldWords * 2);
+    t->liveDocs = rm_realloc(t->liveDocs, t->liveDocsWords * sizeof(*t->liveDocs));
+    memset(t->liveDocs + oldWords, 0, (t->liveDocsWords - oldWords) * sizeof(*t->liveDocs));
+  }
+  __atomic_fetch_or(&t->liveDocs[word], 1ULL << (docId % 64), __ATOMIC_RELAXED);
+}
+
+static void DocTable_ClearLive(DocTable *t, t_docId docId) {
+  size_t word = docId / 64;
+  if (word < t->liveDocsWords) {
+    __atomic_fetch_and(&t->liveDocs[word], ~(1ULL << (docId % 64)), __ATOMIC_RELAXED);
+  }
+}
+
+t_docId DocTable_NextLive(const DocTable *t, t_docId docId) {
+  size_t word = docId / 64;
+  if (word >= t->liveDocsWords) {
+    return 0;
+  }
+  // clear the bits of the lower ids, then scan a word at a time
+  uint64_t bits = __atomic_load_n(&t->liveDocs[word], __ATOMIC_RELAXED) & (~0ULL << (docId % 64));
+  while (!bits) {
+    if (++word == t->liveDocsWords) {
+      return 0;
+    }
+    bits = __atomic_load_n(&t->liveDocs[word], __ATOMIC_RELAXED);
+  }
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+t_docId DocTable_NextDead(const DocTable *t, t_docId docId) {
+  if (docId > t->maxDocId) {
+    return 0;
+  }
+  size_t word = docId / 64;
+  if (word >= t->liveDocsWords) {
+    // the bitmap only grows as documents are added, the ids beyond it hold none
+    return docId;
+  }
+  uint64_t bits = ~__atomic_load_n(&t->liveDocs[word], __ATOMIC_RELAXED) & (~0ULL << (docId % 64));
+  while (!bits) {
+    if (++word == t->liveDocsWords) {
+      bits = 1;
+      break;
+    }
+    bits = ~__atomic_load_n(&t->liveDocs[word], __ATOMIC_RELAXED);
+  }
+  t_docId dead = word * 64 + __builtin_ctzll(bits);
+  return dead <= t->maxDocId ? dead : 0;
+}
+
 static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *dmd) {
-  uint32_t bucket = DocTable_GetBucket(t, docId);
-  if (bucket >= t->cap && t->cap < t->maxSize) {
-    /* We have to grow the array capacity.
-     * We only grow till we reach maxSize, then we starts to add the dmds to
-     * the already existing chains.
-     */
-    size_t oldcap = t->cap;
-    // We grow by half of the current capacity with maximum of 1m
-    t->cap += 1 + (t->cap ? MIN(t->cap / 2, 1024 * 1024) : 1);
-    t->cap = MIN(t->cap, t->maxSize);  // make sure we do not excised maxSize
-    t->cap = MAX(t->cap, bucket + 1);  // docs[bucket] needs to be valid, so t->cap > bucket
-    t->buckets = rm_realloc(t->buckets, t->cap * sizeof(DMDChain));
-
-    // We clear new extra allocation to Null all list pointers
-    size_t memsetSize = (t->cap - oldcap) * sizeof(DMDChain);
-    memset(&t->buckets[oldcap], 0, memsetSize);
-  }
-
-  DMDChain *chain = &t->buckets[bucket];
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  if (pageIndex >= t->numPages) {
+    // The directory only holds a pointer per page, so we can afford doubling it
+    size_t oldPages = t->numPages;
+    t->numPages = MAX(pageIndex + 1, oldPages * 2);
+    t->pages = rm_realloc(t->pages, t->numPages * sizeof(*t->pages));
+    memset(t->pages + oldPages, 0, (t->numPages - oldPages) * sizeof(*t->pages));
+  }
+  DocTablePage *page = t->pages[pageIndex];
+  if (!page) {
+    page = t->pages[pageIndex] = rm_calloc(1, sizeof(*page));
+  }
+
   dmd->ref_count = 1; // Index reference
+  page->slots[docId & (DOCTABLE_PAGE_SIZE - 1)] = dmd;
+  ++page->numDocs;
+  DocTable_SetLive(t, docId);
+}
 
-  // Adding the dmd to the chain
-  dllist2_append(&chain->lroot, &dmd->llnode);
+/* Empty the slot of a document id, freeing its page if it was the last document in it */
+static void DocTable_Unset(DocTable *t, t_docId docId) {
+  size_t pageIndex = docId >> DOCTABLE_PAGE_BITS;
+  DocTablePage *page = t->pages[pageIndex];
+  page->slots[docId & (DOCTABLE_PAGE_SIZE - 1)] = NULL;
+  if (!--page->numDocs) {
+    rm_free(page);
+    t->pages[pageIndex] = NULL;
+  }
+}
+
+void DocTable_Remap(DocTable *t, const DocIdRemap *remap) {
+  // By increasing ids, so the slot of a new id is always free: its document either moved to an
+  // even lower id already, or was deleted
+  for (t_docId docId = remap->from; docId < remap->to; ++docId) {
+    t_docId newId = remap->newIds[docId - remap->from];
+    if (!newId || newId == docId) {
+      continue;
+    }
+    RSDocumentMetadata *dmd = DocTable_GetSlot(t, docId);
+    uint16_t refCount = dmd->ref_count;
+    DocTable_Unset(t, docId);
+    DocTable_ClearLive(t, docId);
+    dmd->id = newId;
+    DocTable_Set(t, newId, dmd);
+    dmd->ref_count = refCount;
+  }
 }
 
 /** Get the docId of a key if it exists in the table, or 0 if it doesnt */
@@ -224,6 +280,7 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   }
   t_docId docId = ++t->maxDocId;
 
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_DOCTABLE);
   RSDocumentMetadata *dmd;
   if (payload && payloadSize) {
     dmd = rm_calloc(1, sizeof(*dmd));
@@ -238,6 +295,7 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   sds keyPtr = sdsnewlen(s, n);
   dmd->keyPtr = keyPtr;
   dmd->score = score;
+  DocTable_UpdateMaxScore(t, score);
   dmd->flags = flags;
   dmd->maxFreq = 1;
   dmd->id = docId;
@@ -258,7 +316,8 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   DocTable_Set(t, docId, dmd);
   ++t->size;
   t->memsize += sdsAllocSize(keyPtr);
-  DocIdMap_Put(&t->dim, s, n, docId);
+  DocIdMap_Put(&t->dim, dmd);
+  AllocStats_SetTag(prevTag);
   DMD_Incref(dmd); // Reference for the caller
   return dmd;
 }
@@ -286,6 +345,8 @@ sds DocTable_GetKey(const DocTable *t, t_docId docId, size_t *lenp) {
 
 void DMD_Free(const RSDocumentMetadata *cmd) {
   RSDocumentMetadata * md = (RSDocumentMetadata *)cmd;
+  // metadata dropped by the last query holding it is still counted to the doc table
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_DOCTABLE);
   if (hasPayload(md->flags)) {
     rm_free(md->payload->data);
     rm_free(md->payload);
@@ -304,29 +365,25 @@ void DMD_Free(const RSDocumentMetadata *cmd) {
   }
   sdsfree(md->keyPtr);
   rm_free(md);
+  AllocStats_SetTag(prevTag);
 }
 
 void DocTable_Free(DocTable *t) {
-  for (int i = 0; i < t->cap; ++i) {
-    DMDChain *chain = &t->buckets[i];
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_DOCTABLE);
+  for (size_t i = 0; i < t->numPages; ++i) {
+    DocTablePage *page = t->pages[i];
+    if (!page) {
       continue;
     }
-    DLLIST2_node *nn = chain->lroot.head;
-    while (nn) {
-      RSDocumentMetadata *md = DLLIST2_ITEM(nn, RSDocumentMetadata, llnode);
-      nn = nn->next;
-      DMD_Return(md);
+    for (size_t j = 0; j < DOCTABLE_PAGE_SIZE; ++j) {
+      DMD_Return(page->slots[j]);
     }
+    rm_free(page);
   }
-  rm_free(t->buckets);
+  rm_free(t->pages);
+  rm_free(t->liveDocs);
   DocIdMap_Free(&t->dim);
-}
-
-static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
-  uint32_t bucketIndex = DocTable_GetBucket(t, md->id);
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  dllist2_delete(&dmdChain->lroot, &md->llnode);
+  AllocStats_SetTag(prevTag);
 }
 
 int DocTable_Delete(DocTable *t, const char *s, size_t n) {
@@ -362,8 +419,11 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
       t->sortablesSize -= RSSortingVector_GetMemorySize(md->sortVector);
     }
 
-    DocTable_DmdUnchain(t, md);
+    AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_DOCTABLE);
+    DocTable_Unset(t, docId);
+    DocTable_ClearLive(t, docId);
     DocIdMap_Delete(&t->dim, s, n);
+    AllocStats_SetTag(prevTag);
     --t->size;
     DMD_Return(md); // Index ref. The caller gets a ref from the `Get` call
 
@@ -379,53 +439,48 @@ int DocTable_Replace(DocTable *t, const char *from_str, size_t from_len, const c
   if (id == 0) {
     return REDISMODULE_ERR;
   }
-  DocIdMap_Delete(&t->dim, from_str, from_len);
-  DocIdMap_Put(&t->dim, to_str, to_len, id);
   RSDocumentMetadata *dmd = DocTable_GetOwn(t, id);
+  // the map holds the key of the metadata, so it is removed before the key is released
+  DocIdMap_Delete(&t->dim, from_str, from_len);
   sdsfree(dmd->keyPtr);
   dmd->keyPtr = sdsnewlen(to_str, to_len);
+  DocIdMap_Put(&t->dim, dmd);
   return REDISMODULE_OK;
 }
 
-void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
+static void DocTable_RdbSaveDmd(const RSDocumentMetadata *dmd, RedisModuleIO *rdb) {
+  RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
+  RedisModule_SaveUnsigned(rdb, dmd->id);
+  RedisModule_SaveUnsigned(rdb, dmd->flags);
+  RedisModule_SaveUnsigned(rdb, dmd->type);
+  RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
+  RedisModule_SaveUnsigned(rdb, dmd->len);
+  RedisModule_SaveFloat(rdb, dmd->score);
+  RedisModule_SaveUnsigned(rdb, dmd->indexedHash);
+  if (hasPayload(dmd->flags)) {
+    RedisModule_SaveStringBuffer(rdb, dmd->payload->data, dmd->payload->len);
+  }
+  if (dmd->flags & Document_HasSortVector) {
+    RSSortingVector_RdbSave(rdb, dmd->sortVector);
+  }
+  if (dmd->flags & Document_HasOffsetVector) {
+    Buffer tmp;
+    Buffer_Init(&tmp, 16);
+    RSByteOffsets_Serialize(dmd->byteOffsets, &tmp);
+    RedisModule_SaveStringBuffer(rdb, tmp.data, tmp.offset);
+    Buffer_Free(&tmp);
+  }
+}
 
-  RedisModule_SaveUnsigned(rdb, t->size);
+void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb) {
+  RedisModule_SaveUnsigned(rdb, t->maxDocId);
+  RedisModule_SaveUnsigned(rdb, t->size - 1);
 
   uint32_t elements_written = 0;
-  for (uint32_t i = 0; i < t->cap; ++i) {
-    if (DLLIST2_IS_EMPTY(&t->buckets[i].lroot)) {
-      continue;
-    }
-    DLLIST2_FOREACH(it, &t->buckets[i].lroot) {
-      const RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-      RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
-      RedisModule_SaveUnsigned(rdb, dmd->flags);
-      RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
-      RedisModule_SaveUnsigned(rdb, dmd->len);
-      RedisModule_SaveFloat(rdb, dmd->score);
-      if (dmd->flags & Document_HasPayload) {
-        if (hasPayload(dmd->flags)) {
-          // save an extra space for the null terminator to make the payload null terminated on
-          RedisModule_SaveStringBuffer(rdb, dmd->payload->data, dmd->payload->len + 1);
-        } else {
-          RedisModule_SaveStringBuffer(rdb, "", 1);
-        }
-      }
-
-      //      if (dmd->flags & Document_HasSortVector) {
-      //        SortingVector_RdbSave(rdb, dmd->sortVector);
-      //      }
-
-      if (dmd->flags & Document_HasOffsetVector) {
-        Buffer tmp;
-        Buffer_Init(&tmp, 16);
-        RSByteOffsets_Serialize(dmd->byteOffsets, &tmp);
-        RedisModule_SaveStringBuffer(rdb, tmp.data, tmp.offset);
-        Buffer_Free(&tmp);
-      }
-      ++elements_written;
-    }
-  }
+  DOCTABLE_FOREACH(t, {
+    DocTable_RdbSaveDmd(dmd, rdb);
+    ++elements_written;
+  });
   RS_LOG_ASSERT((elements_written + 1 == t->size), "Wrong number of written elements");
 }
 
@@ -439,20 +494,6 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     t->maxSize = MIN(RSGlobalConfig.maxDocTableSize, t->maxDocId);
   }
 
-  if (t->maxDocId > t->maxSize) {
-    /**
-     * If the maximum doc id is greater than the maximum cap size
-     * then it means there is a possibility that any index under maxId can
-     * be accessed. However, it is possible that this bucket does not have
-     * any documents inside it (and thus might not be populated below), but
-     * could still be accessed for simple queries (e.g. get, exist). Ensure
-     * we don't have to rely on Set/Put to ensure the doc table array.
-     */
-    t->cap = t->maxSize;
-    rm_free(t->buckets);
-    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
-  }
-
   for (size_t i = 1; i < t->size; i++) {
     size_t len;
 
@@ -480,6 +521,7 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     }
 
     dmd->score = RedisModule_LoadFloat(rdb);
+    DocTable_UpdateMaxScore(t, dmd->score);
     // read payload if set
     if (hasPayload(dmd->flags)) {
       dmd->payload = NULL;
@@ -515,7 +557,7 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
       ++deletedElements;
       DMD_Free(dmd);
     } else {
-      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
+      DocIdMap_Put(&t->dim, dmd);
       DocTable_Set(t, dmd->id, dmd);
       t->memsize += sizeof(RSDocumentMetadata) + len;
     }
@@ -523,135 +565,171 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
   t->size -= deletedElements;
 }
 
-void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
-  long long deletedElements = 0;
+int DocTable_RdbLoad(DocTable *t, RSSortingTable *sortables, RedisModuleIO *rdb) {
+  t_docId maxDocId = RedisModule_LoadUnsigned(rdb);
   size_t size = RedisModule_LoadUnsigned(rdb);
-  //  t->maxDocId = RedisModule_LoadUnsigned(rdb);
-  //  if (encver >= INDEX_MIN_COMPACTED_DOCTABLE_VERSION) {
-  //    t->maxSize = RedisModule_LoadUnsigned(rdb);
-  //  } else {
-  //    t->maxSize = MIN(RSGlobalConfig.maxDocTableSize, t->maxDocId);
-  //  }
-
-  //  if (t->maxDocId > t->maxSize) {
-  //    /**
-  //     * If the maximum doc id is greater than the maximum cap size
-  //     * then it means there is a possibility that any index under maxId can
-  //     * be accessed. However, it is possible that this bucket does not have
-  //     * any documents inside it (and thus might not be populated below), but
-  //     * could still be accessed for simple queries (e.g. get, exist). Ensure
-  //     * we don't have to rely on Set/Put to ensure the doc table array.
-  //     */
-  //    t->cap = t->maxSize;
-  //    rm_free(t->buckets);
-  //    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
-  //  }
-
-  for (size_t i = 1; i < size; i++) {
-    size_t len;
 
-    RSDocumentMetadata *dmd = rm_calloc(1, sizeof(RSDocumentMetadata));
+  for (size_t i = 0; i < size && !RedisModule_IsIOError(rdb); i++) {
+    size_t len;
     char *tmpPtr = RedisModule_LoadStringBuffer(rdb, &len);
-    if (encver < INDEX_MIN_BINKEYS_VERSION) {
-      // Previous versions would encode the NUL byte
-      len--;
+    t_docId id = RedisModule_LoadUnsigned(rdb);
+    RSDocumentFlags flags = RedisModule_LoadUnsigned(rdb);
+    if (!tmpPtr || !id || DocIdMap_Get(&t->dim, tmpPtr, len)) {
+      if (tmpPtr) RedisModule_Free(tmpPtr);
+      return REDISMODULE_ERR;
     }
-    //    dmd->id = encver < INDEX_MIN_COMPACTED_DOCTABLE_VERSION ? i :
-    //    RedisModule_LoadUnsigned(rdb);
-    dmd->keyPtr = sdsnewlen(tmpPtr, len);
-    RedisModule_Free(tmpPtr);
 
-    dmd->flags = RedisModule_LoadUnsigned(rdb);
-    dmd->maxFreq = 1;
-    dmd->len = 1;
-    if (encver > 1) {
-      dmd->maxFreq = RedisModule_LoadUnsigned(rdb);
-    }
-    if (encver >= INDEX_MIN_DOCLEN_VERSION) {
-      dmd->len = RedisModule_LoadUnsigned(rdb);
+    // Allocated as DocTable_Put does, the lean metadata has no payload pointer
+    RSDocumentMetadata *dmd;
+    if (hasPayload(flags)) {
+      dmd = rm_calloc(1, sizeof(*dmd));
+      t->memsize += sizeof(RSDocumentMetadata);
     } else {
-      // In older versions, default the len to max freq to avoid division by zero.
-      dmd->len = dmd->maxFreq;
+      size_t leanSize = sizeof(*dmd) - sizeof(RSPayload *);
+      dmd = rm_calloc(1, leanSize);
+      t->memsize += leanSize;
     }
-
+    dmd->keyPtr = sdsnewlen(tmpPtr, len);
+    RedisModule_Free(tmpPtr);
+    dmd->id = id;
+    dmd->flags = flags;
+    dmd->type = RedisModule_LoadUnsigned(rdb);
+    dmd->maxFreq = RedisModule_LoadUnsigned(rdb);
+    dmd->len = RedisModule_LoadUnsigned(rdb);
     dmd->score = RedisModule_LoadFloat(rdb);
-    dmd->payload = NULL;
-    // read payload if set
-    if ((dmd->flags & Document_HasPayload)) {
-      if (!(dmd->flags & Document_Deleted)) {
-        dmd->payload = rm_malloc(sizeof(RSPayload));
-        dmd->payload->data = RedisModule_LoadStringBuffer(rdb, &dmd->payload->len);
-        char *buf = rm_malloc(dmd->payload->len);
-        memcpy(buf, dmd->payload->data, dmd->payload->len);
-        RedisModule_Free(dmd->payload->data);
-        dmd->payload->data = buf;
-        dmd->payload->len--;
-        t->memsize += dmd->payload->len + sizeof(RSPayload);
-      } else if ((dmd->flags & Document_Deleted) && (encver == INDEX_MIN_EXPIRE_VERSION)) {
-        RedisModule_Free(RedisModule_LoadStringBuffer(rdb, NULL));  // throw this string to garbage
+    dmd->indexedHash = RedisModule_LoadUnsigned(rdb);
+    DocTable_UpdateMaxScore(t, dmd->score);
+
+    if (hasPayload(flags)) {
+      size_t plen;
+      char *data = RedisModule_LoadStringBuffer(rdb, &plen);
+      dmd->payload = rm_malloc(sizeof(RSPayload));
+      dmd->payload->data = rm_calloc(1, plen + 1);
+      if (data) {
+        memcpy(dmd->payload->data, data, plen);
+        RedisModule_Free(data);
       }
+      dmd->payload->len = plen;
+      t->memsize += plen + sizeof(RSPayload);
     }
-    dmd->sortVector = NULL;
-    //    if (dmd->flags & Document_HasSortVector) {
-    //      dmd->sortVector = SortingVector_RdbLoad(rdb, encver);
-    //      t->sortablesSize += RSSortingVector_GetMemorySize(dmd->sortVector);
-    //    }
-
-    if (dmd->flags & Document_HasOffsetVector) {
+    if (flags & Document_HasSortVector) {
+      dmd->sortVector = RSSortingTable_RdbLoadVector(sortables, rdb);
+      t->sortablesSize += RSSortingVector_GetMemorySize(dmd->sortVector);
+    }
+    if (flags & Document_HasOffsetVector) {
       size_t nTmp = 0;
       char *tmp = RedisModule_LoadStringBuffer(rdb, &nTmp);
       Buffer *bufTmp = Buffer_Wrap(tmp, nTmp);
       dmd->byteOffsets = LoadByteOffsets(bufTmp);
       rm_free(bufTmp);
-      RedisModule_Free(tmp);
+      if (tmp) RedisModule_Free(tmp);
     }
 
-    if (dmd->flags & Document_Deleted) {
-      DMD_Free(dmd);
-    } else {
-      RedisModuleString *keyRedisStr =
-          RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr));
-      RedisModule_FreeString(NULL, keyRedisStr);
-      //      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
-      //      DocTable_Set(t, dmd->id, dmd);
-      //      t->memsize += sizeof(RSDocumentMetadata) + len;
-    }
+    DocTable_Set(t, id, dmd);
+    ++t->size;
+    t->memsize += sdsAllocSize(dmd->keyPtr);
+    DocIdMap_Put(&t->dim, dmd);
   }
+  t->maxDocId = maxDocId;
+  return RedisModule_IsIOError(rdb) ? REDISMODULE_ERR : REDISMODULE_OK;
 }
 
-DocIdMap NewDocIdMap() {
+#define DOCIDMAP_INITIAL_CAP 16
 
-  TrieMap *m = NewTrieMap();
-  return (DocIdMap){m};
+static inline uint64_t DocIdMap_Hash(const char *s, size_t n) {
+  return fnv_64a_buf(s, n, 0xcbf29ce484222325ULL);
 }
 
-t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+DocIdMap NewDocIdMap() {
+  return (DocIdMap){0};
+}
 
-  void *val = TrieMap_Find(m->tm, (char *)s, n);
-  if (val && val != TRIEMAP_NOTFOUND) {
-    return *((t_docId *)val);
+static DocIdMapEntry *DocIdMap_Find(const DocIdMap *m, const char *s, size_t n) {
+  if (!m->size) {
+    return NULL;
   }
-  return 0;
+  uint64_t hash = DocIdMap_Hash(s, n);
+  size_t mask = m->cap - 1;
+  // the table is never full, so the probe ends on an empty slot
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    DocIdMapEntry *e = &m->entries[i];
+    if (!e->dmd) {
+      return NULL;
+    }
+    if (e->hash == hash && sdslen(e->dmd->keyPtr) == n && !memcmp(e->dmd->keyPtr, s, n)) {
+      return e;
+    }
+  }
+}
+
+static void DocIdMap_Insert(DocIdMapEntry *entries, size_t cap, uint64_t hash,
+                            RSDocumentMetadata *dmd) {
+  size_t mask = cap - 1;
+  size_t i = hash & mask;
+  while (entries[i].dmd) {
+    i = (i + 1) & mask;
+  }
+  entries[i].hash = hash;
+  entries[i].dmd = dmd;
 }
 
-void *_docIdMap_replace(void *oldval, void *newval) {
-  if (oldval) {
-    rm_free(oldval);
+static void DocIdMap_Grow(DocIdMap *m) {
+  size_t cap = m->cap ? m->cap * 2 : DOCIDMAP_INITIAL_CAP;
+  DocIdMapEntry *entries = rm_calloc(cap, sizeof(*entries));
+  for (size_t i = 0; i < m->cap; ++i) {
+    if (m->entries[i].dmd) {
+      DocIdMap_Insert(entries, cap, m->entries[i].hash, m->entries[i].dmd);
+    }
   }
-  return newval;
+  rm_free(m->entries);
+  m->entries = entries;
+  m->cap = cap;
 }
 
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId) {
+t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+  const DocIdMapEntry *e = DocIdMap_Find(m, s, n);
+  return e ? e->dmd->id : 0;
+}
 
-  t_docId *pd = rm_malloc(sizeof(t_docId));
-  *pd = docId;
-  TrieMap_Add(m->tm, (char *)s, n, pd, _docIdMap_replace);
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd) {
+  size_t n = sdslen(dmd->keyPtr);
+  DocIdMapEntry *e = DocIdMap_Find(m, dmd->keyPtr, n);
+  if (e) {
+    e->dmd = dmd;
+    return;
+  }
+  // keep the load factor under 3/4, so the probes stay short
+  if ((m->size + 1) * 4 > m->cap * 3) {
+    DocIdMap_Grow(m);
+  }
+  DocIdMap_Insert(m->entries, m->cap, DocIdMap_Hash(dmd->keyPtr, n), dmd);
+  ++m->size;
 }
 
 void DocIdMap_Free(DocIdMap *m) {
-  TrieMap_Free(m->tm, rm_free);
+  rm_free(m->entries);
+  *m = NewDocIdMap();
 }
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n) {
-  return TrieMap_Delete(m->tm, (char *)s, n, rm_free);
+  DocIdMapEntry *e = DocIdMap_Find(m, s, n);
+  if (!e) {
+    return 0;
+  }
+  // Shift back the entries of the probe following the deleted one, rather than leaving a
+  // tombstone. An entry moves to the hole unless its home slot lies after the hole
+  size_t mask = m->cap - 1;
+  size_t hole = e - m->entries;
+  for (size_t i = (hole + 1) & mask; m->entries[i].dmd; i = (i + 1) & mask) {
+    size_t home = m->entries[i].hash & mask;
+    int afterHole = hole <= i ? (home > hole && home <= i) : (home > hole || home <= i);
+    if (!afterHole) {
+      m->entries[hole] = m->entries[i];
+      hole = i;
+    }
+  }
+  m->entries[hole].hash = 0;
+  m->entries[hole].dmd = NULL;
+  --m->size;
+  return 1;
 }
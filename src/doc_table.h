@@ -34,22 +34,38 @@ static inline RedisModuleString *DMD_CreateKeyString(const RSDocumentMetadata *d
   return RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
 }
 
-/* Map between external id an incremental id */
 typedef struct {
-  TrieMap *tm;
+  // hash of the key, compared before the key itself
+  uint64_t hash;
+  // the owner of the key, or NULL for an empty slot
+  RSDocumentMetadata *dmd;
+} DocIdMapEntry;
+
+/* Map between external id an incremental id. An open addressing hash table over the metadata of
+ * the documents, so the key is only stored once, by its metadata */
+typedef struct {
+  DocIdMapEntry *entries;
+  // number of slots, a power of 2
+  size_t cap;
+  size_t size;
 } DocIdMap;
 
 DocIdMap NewDocIdMap();
 /* Get docId from a did-map. Returns 0  if the key is not in the map */
 t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n);
 
-/* Put a new doc id in the map if it does not already exist */
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId);
+/* Put a document in the map by its key, replacing the document currently mapped to it. The map
+ * references the key of the metadata, which must be kept until it is deleted from the map */
+void DocIdMap_Put(DocIdMap *m, RSDocumentMetadata *dmd);
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n);
-/* Free the doc id map */
+/* Free the doc id map. The metadata it maps to is not freed */
 void DocIdMap_Free(DocIdMap *m);
 
+static inline size_t DocIdMap_MemUsage(const DocIdMap *m) {
+  return m->cap * sizeof(*m->entries);
+}
+
 /* The DocTable is a simple mapping between incremental ids and the original document key and
  * metadata. It is also responsible for storing the id incrementor for the index and assigning
  * new
@@ -59,36 +75,53 @@ void DocIdMap_Free(DocIdMap *m);
  * the
  * same key. This may result in document duplication in results  */
 
+#define DOCTABLE_PAGE_BITS 10
+#define DOCTABLE_PAGE_SIZE (1 << DOCTABLE_PAGE_BITS)
+
+/* The metadata of DOCTABLE_PAGE_SIZE consecutive document ids. A page is allocated when the first
+ * of its documents is added, and freed once the last one is removed */
 typedef struct {
-  DLLIST2 lroot;
-} DMDChain;
+  size_t numDocs;
+  RSDocumentMetadata *slots[DOCTABLE_PAGE_SIZE];
+} DocTablePage;
 
 typedef struct {
   size_t size;
-  // the maximum size this table is allowed to grow to
+  // the maximum size of the table in the older versions, where it bounded the number of buckets.
+  // Only kept for the RDB format, since the pages are indexed by the document id
   t_docId maxSize;
   t_docId maxDocId;
-  size_t cap;
   size_t memsize;
   size_t sortablesSize;
+  // the highest score a document was ever given in the table. Never lowered, so it can be used as
+  // an upper bound of the score of any document in the table
+  double maxScore;
 
-  DMDChain *buckets;
+  // the pages of the table, by document id. NULL for the ranges of ids holding no document
+  DocTablePage **pages;
+  size_t numPages;
   DocIdMap dim;
+
+  // A bit per document id, set while the document is in the table. The ids of deleted documents
+  // remain in the inverted indexes until they are garbage collected, so iterators skip them with
+  // it rather than looking up their metadata. Grown and updated under the spec write lock
+  uint64_t *liveDocs;
+  size_t liveDocsWords;
 } DocTable;
 
-#define DOCTABLE_FOREACH(dt, code)                                           \
-  for (size_t i = 0; i < dt->cap; ++i) {                                     \
-    DMDChain *chain = &dt->buckets[i];                                       \
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {                                   \
-      continue;                                                              \
-    }                                                                        \
-    DLLIST2_FOREACH(it, &chain->lroot) {                                     \
-      RSDocumentMetadata *dmd = DLLIST_ITEM(it, RSDocumentMetadata, llnode); \
-      code;                                                                  \
-    }                                                                        \
+// Iterates the documents of the table by increasing id. The page is looked up for every slot, as
+// `code` may remove the document, and free the page along with it
+#define DOCTABLE_FOREACH(dt, code)                                               \
+  for (size_t i = 0; i < (dt)->numPages; ++i) {                                  \
+    for (size_t j = 0; (dt)->pages[i] && j < DOCTABLE_PAGE_SIZE; ++j) {          \
+      RSDocumentMetadata *dmd = (dt)->pages[i]->slots[j];                        \
+      if (dmd) {                                                                 \
+        code;                                                                    \
+      }                                                                          \
+    }                                                                            \
   }
 
-/* Creates a new DocTable with a given capacity */
+/* Creates a new DocTable, with room for the pages of `cap` documents */
 DocTable NewDocTable(size_t cap, size_t max_size);
 
 #define DocTable_New(cap) NewDocTable(cap, RSGlobalConfig.maxDocTableSize)
@@ -118,8 +151,34 @@ sds DocTable_GetKey(const DocTable *t, t_docId docId, size_t *n);
  * document */
 int DocTable_SetPayload(DocTable *t, RSDocumentMetadata *dmd, const char *data, size_t len);
 
+/* Account for a document score set outside of DocTable_Put (e.g. partial updates) */
+static inline void DocTable_UpdateMaxScore(DocTable *t, double score) {
+  if (score > t->maxScore) {
+    t->maxScore = score;
+  }
+}
+
 int DocTable_Exists(const DocTable *t, t_docId docId);
 
+/* Returns 1 if the document is in the table, without looking up its metadata */
+static inline int DocTable_IsLive(const DocTable *t, t_docId docId) {
+  size_t word = docId / 64;
+  return word < t->liveDocsWords &&
+         ((__atomic_load_n(&t->liveDocs[word], __ATOMIC_RELAXED) >> (docId % 64)) & 1);
+}
+
+/* Get the first id of a document in the table from `docId` on, or 0 if there is none */
+t_docId DocTable_NextLive(const DocTable *t, t_docId docId);
+
+/* Number of ids up to maxDocId which hold no document, i.e. of deleted documents (or of the ids
+ * of documents updated since) */
+static inline size_t DocTable_NumDead(const DocTable *t) {
+  return t->maxDocId + 1 - t->size;
+}
+
+/* Get the first id up to maxDocId from `docId` on which holds no document, or 0 if there is none */
+t_docId DocTable_NextDead(const DocTable *t, t_docId docId);
+
 /* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done */
 int DocTable_SetSortingVector(DocTable *t, RSDocumentMetadata *dmd, RSSortingVector *v);
@@ -179,13 +238,33 @@ static inline void DMD_Return(const RSDocumentMetadata *cdmd) {
   }
 }
 
-/* Save the table to RDB. Called from the owning index */
+/* A renumbering of the documents with ids in [from, to), by the docid compaction. newIds[id - from]
+ * is the new id of the document, or 0 if it is no longer in the table. The ids outside the range
+ * are kept. New ids are never above the old ones, and keep the order of the documents */
+typedef struct {
+  t_docId from;
+  t_docId to;
+  const t_docId *newIds;
+} DocIdRemap;
+
+static inline t_docId DocIdRemap_Get(const DocIdRemap *m, t_docId docId) {
+  return docId < m->from || docId >= m->to ? docId : m->newIds[docId - m->from];
+}
+
+/* Move the documents of the table to their new ids. The metadata keeps its references, and the
+ * key map its entries, as both point at the metadata */
+void DocTable_Remap(DocTable *t, const DocIdRemap *remap);
+
+/* Save the documents of the table to RDB, with their ids. Called from the owning index when its
+ * contents are persisted (see IndexPersistence_RdbSave) */
 void DocTable_RdbSave(DocTable *t, RedisModuleIO *rdb);
 
 void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver);
 
-/* Load the table from RDB */
-void DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb, int encver);
+/* Load the documents saved by DocTable_RdbSave into an empty table, their sorting vectors sharing
+ * the strings of the index's sorting table. Returns REDISMODULE_ERR on a short read or a corrupt
+ * table */
+int DocTable_RdbLoad(DocTable *t, RSSortingTable *sortables, RedisModuleIO *rdb);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,238 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "docid_compaction.h"
+#include "config.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "doc_table.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+#include "util/logging.h"
+#include "util/minmax.h"
+
+#include <sched.h>
+
+typedef struct {
+  size_t entries;
+  size_t bytesBefore;
+  size_t bytesAfter;
+} remapped;
+
+// Assumes the spec is locked.
+static void updateStats(IndexSpec *sp, const remapped *r) {
+  sp->stats.numRecords -= r->entries;
+  sp->stats.invertedSize += r->bytesAfter;
+  sp->stats.invertedSize -= r->bytesBefore;
+}
+
+static size_t remapIndex(InvertedIndex *idx, const DocIdRemap *remap, remapped *out) {
+  IndexRepairParams params = {0};
+  size_t dropped = InvertedIndex_Remap(idx, remap, &params);
+  out->entries += params.entriesCollected;
+  out->bytesBefore += params.bytesBeforFix;
+  out->bytesAfter += params.bytesAfterFix;
+  return dropped;
+}
+
+static void remapNumeric(NumericRangeTree *rt, const DocIdRemap *remap, remapped *out) {
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    NumericRange *r = node->range;
+    if (!r) {
+      continue;
+    }
+    InvertedIndex *idx = r->entries;
+    bool wasEmpty = idx->numDocs == 0;
+    remapped rr = {0};
+    remapIndex(idx, remap, &rr);
+    idx->numEntries -= rr.entries;
+    r->invertedIndexSize += rr.bytesAfter;
+    r->invertedIndexSize -= rr.bytesBefore;
+    rt->numEntries -= rr.entries;
+    if (!wasEmpty && idx->numDocs == 0) {
+      rt->emptyLeaves++;
+    }
+    if (r->column) {
+      NumericRange_RebuildColumn(r);
+    }
+    out->entries += rr.entries;
+    out->bytesBefore += rr.bytesBefore;
+    out->bytesAfter += rr.bytesAfter;
+  }
+  NumericRangeTreeIterator_Free(iter);
+  rt->lastDocId = DocIdRemap_Get(remap, rt->lastDocId);
+}
+
+static void remapTags(TagIndex *tagIdx, const DocIdRemap *remap, remapped *out) {
+  TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+  char *ptr;
+  tm_len_t len;
+  void *value;
+  while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+    remapIndex(value, remap, out);
+  }
+  TrieMapIterator_Free(iter);
+  TagIndex_RemapDocValues(tagIdx, remap);
+}
+
+/* Remap the ids of a segment in every index of the spec, then in its doc table */
+static void remapSegment(IndexSpec *sp, const DocIdRemap *remap) {
+  remapped r = {0};
+  if (sp->keysDict) {
+    dictIterator *iter = dictGetIterator(sp->keysDict);
+    dictEntry *de;
+    while ((de = dictNext(iter))) {
+      KeysDictValue *kdv = dictGetVal(de);
+      if (kdv->dtor == InvertedIndex_Free) {
+        remapIndex(kdv->p, remap, &r);
+      } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+        remapNumeric(kdv->p, remap, &r);
+      } else if (kdv->dtor == TagIndex_Free) {
+        remapTags(kdv->p, remap, &r);
+      }
+    }
+    dictReleaseIterator(iter);
+  }
+  updateStats(sp, &r);
+  for (size_t i = 0; i < array_len(sp->existence); ++i) {
+    ExistenceIndex_Remap(sp->existence[i], remap);
+  }
+  DocTable_Remap(&sp->docs, remap);
+  ++sp->docIdsEpoch;
+}
+
+/* Whether the ids of the spec are sparse enough to be compacted. The labels of the vector and
+ * geometry indexes are the doc ids, and cannot be renumbered in place */
+static bool shouldCompact(const IndexSpec *sp) {
+  size_t ratio = RSGlobalConfig.gcConfigParams.compactDocIdsRatio;
+  if (!ratio || (sp->flags & (Index_HasVecSim | Index_HasGeometry))) {
+    return false;
+  }
+  t_docId maxDocId = sp->docs.maxDocId;
+  return maxDocId >= DOCID_COMPACTION_MIN_MAX_DOCID && maxDocId >= ratio * (sp->docs.size - 1);
+}
+
+/* Check the spec under the read lock first, as the write lock would drop its cached results */
+static bool needsCompaction(DocIdCompaction *c) {
+  if (!RSGlobalConfig.gcConfigParams.compactDocIdsRatio) {
+    return false;
+  }
+  StrongRef spec_ref = WeakRef_Promote(c->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    return false;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(c->ctx, sp);
+  RedisSearchCtx_LockSpecRead(&sctx);
+  bool rv = shouldCompact(sp);
+  RedisSearchCtx_UnlockSpec(&sctx);
+  StrongRef_Release(spec_ref);
+  return rv;
+}
+
+int DocIdCompaction_Run(DocIdCompaction *c) {
+  if (!needsCompaction(c)) {
+    return 0;
+  }
+
+  t_docId *newIds = NULL;
+  // the last id to renumber, the first id of the next segment, and the last id assigned
+  t_docId end = 0, from = 0, next = 0;
+  int compacted = 0;
+
+  while (1) {
+    StrongRef spec_ref = WeakRef_Promote(c->index);
+    IndexSpec *sp = StrongRef_Get(spec_ref);
+    if (!sp) {
+      // Index was deleted
+      break;
+    }
+    RedisSearchCtx sctx = SEARCH_CTX_STATIC(c->ctx, sp);
+    RedisSearchCtx_LockSpecWrite(&sctx);
+
+    if (!end) {
+      if (!shouldCompact(sp)) {
+        RedisSearchCtx_UnlockSpec(&sctx);
+        StrongRef_Release(spec_ref);
+        break;
+      }
+      // The documents below the first gap keep their ids
+      end = sp->docs.maxDocId;
+      from = 1;
+      while (from <= end && DocTable_IsLive(&sp->docs, from)) {
+        ++from;
+      }
+      next = from - 1;
+      newIds = rm_malloc(DOCID_COMPACTION_SEGMENT * sizeof(*newIds));
+    }
+
+    // Ids added since the compaction began are above `end`, and keep their ids
+    t_docId to = MIN(from + DOCID_COMPACTION_SEGMENT, end + 1);
+    for (t_docId docId = from; docId < to; ++docId) {
+      newIds[docId - from] = DocTable_IsLive(&sp->docs, docId) ? ++next : 0;
+    }
+    DocIdRemap remap = {.from = from, .to = to, .newIds = newIds};
+    remapSegment(sp, &remap);
+    c->stats.numSegments++;
+    from = to;
+
+    bool done = from > end;
+    if (done) {
+      if (sp->docs.maxDocId == end) {
+        sp->docs.maxDocId = next;
+      }
+      c->stats.numCompactions++;
+      c->stats.idsReclaimed += end - next;
+      compacted = 1;
+      RedisModule_Log(c->ctx, "verbose", "Compacted the doc ids of %s from %lu to %lu",
+                      sp->name, (unsigned long)end, (unsigned long)next);
+    }
+    RedisSearchCtx_UnlockSpec(&sctx);
+    StrongRef_Release(spec_ref);
+    if (done) {
+      break;
+    }
+    // let the writers and the queries waiting on the lock in
+    sched_yield();
+  }
+
+  rm_free(newIds);
+  return compacted;
+}
+
+void DocIdCompaction_RenderStats(DocIdCompaction *c, RedisModule_Reply *reply) {
+  RedisModule_ReplyKV_Double(reply, "docids_compactions", c->stats.numCompactions);
+  RedisModule_ReplyKV_Double(reply, "docids_compaction_segments", c->stats.numSegments);
+  RedisModule_ReplyKV_Double(reply, "docids_reclaimed", c->stats.idsReclaimed);
+}
+
+#ifdef FTINFO_FOR_INFO_MODULES
+void DocIdCompaction_RenderStatsForInfo(DocIdCompaction *c, RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoBeginDictField(ctx, "docid_compaction_stats");
+  RedisModule_InfoAddFieldLongLong(ctx, "docids_compactions", c->stats.numCompactions);
+  RedisModule_InfoAddFieldLongLong(ctx, "docids_compaction_segments", c->stats.numSegments);
+  RedisModule_InfoAddFieldLongLong(ctx, "docids_reclaimed", c->stats.idsReclaimed);
+  RedisModule_InfoEndDictField(ctx);
+}
+#endif
+
+DocIdCompaction *DocIdCompaction_New(StrongRef spec_ref) {
+  DocIdCompaction *c = rm_calloc(1, sizeof(*c));
+  c->index = StrongRef_Demote(spec_ref);
+  c->ctx = RedisModule_GetThreadSafeContext(NULL);
+  return c;
+}
+
+void DocIdCompaction_Free(DocIdCompaction *c) {
+  WeakRef_Release(c->index);
+  RedisModule_FreeThreadSafeContext(c->ctx);
+  rm_free(c);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef SRC_DOCID_COMPACTION_H_
+#define SRC_DOCID_COMPACTION_H_
+
+#include "redismodule.h"
+#include "reply.h"
+#include "util/references.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of old ids renumbered under a single write lock of the index
+#define DOCID_COMPACTION_SEGMENT 65536
+
+// An index is not compacted before its max doc id reaches this
+#define DOCID_COMPACTION_MIN_MAX_DOCID 1000
+
+typedef struct {
+  // number of compactions ran
+  size_t numCompactions;
+  // number of times the compaction took the write lock of the index
+  size_t numSegments;
+  // by how much the compactions brought the max doc id down
+  size_t idsReclaimed;
+} DocIdCompactionStats;
+
+/*
+ * Renumbers the documents of an index densely, once deletes and updates left the ids sparse
+ * (see the GC_COMPACT_DOCIDS_RATIO config). Run from the GC thread after a collection. The ids are
+ * remapped in segments of increasing ids, in the doc table and in the postings of the text,
+ * numeric and tag fields, taking the write lock of the index for one segment at a time.
+ */
+typedef struct DocIdCompaction {
+  // owner of the compaction
+  WeakRef index;
+
+  RedisModuleCtx *ctx;
+
+  // statistics for reporting
+  DocIdCompactionStats stats;
+} DocIdCompaction;
+
+DocIdCompaction *DocIdCompaction_New(StrongRef spec_ref);
+void DocIdCompaction_Free(DocIdCompaction *c);
+
+/* Compact the ids of the index if they are sparse enough. Returns 1 if the index was compacted */
+int DocIdCompaction_Run(DocIdCompaction *c);
+
+void DocIdCompaction_RenderStats(DocIdCompaction *c, RedisModule_Reply *reply);
+#ifdef FTINFO_FOR_INFO_MODULES
+void DocIdCompaction_RenderStatsForInfo(DocIdCompaction *c, RedisModuleInfoCtx *ctx);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_DOCID_COMPACTION_H_ */
@@ -6,6 +6,7 @@
 
 #include <string.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "document.h"
 #include "forward_index.h"
@@ -18,11 +19,15 @@
 #include "tokenize.h"
 #include "util/logging.h"
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "indexer.h"
 #include "tag_index.h"
+#include "suffix.h"
 #include "geometry/geometry_api.h"
 #include "aggregate/expr/expression.h"
 #include "rmutil/rm_assert.h"
+#include "util/fnv.h"
+#include "rmutil/cxx/chrono-clock.h"
 
 // Memory pool for RSAddDocumentContext contexts
 static mempool_t *actxPool_g = NULL;
@@ -82,6 +87,7 @@ static int AddDocumentCtx_SetDocument(RSAddDocumentCtx *aCtx, IndexSpec *sp) {
       aCtx->fspecs[i].name = NULL;
       aCtx->fspecs[i].path = NULL;
       aCtx->fspecs[i].types = 0;
+      aCtx->fspecs[i].options = 0;
       continue;
     }
 
@@ -143,7 +149,7 @@ static int AddDocumentCtx_SetDocument(RSAddDocumentCtx *aCtx, IndexSpec *sp) {
   }
 
   if ((aCtx->stateFlags & ACTX_F_SORTABLES) && aCtx->sv == NULL) {
-    aCtx->sv = NewSortingVector(sp->sortables->len);
+    aCtx->sv = RSSortingTable_NewVector(sp->sortables);
   }
 
   int empty = (aCtx->sv == NULL) && !hasTextFields && !hasOtherFields;
@@ -177,6 +183,7 @@ RSAddDocumentCtx *NewAddDocumentCtx(IndexSpec *sp, Document *doc, QueryError *st
   QueryError_ClearError(&aCtx->status);
   aCtx->totalTokens = 0;
   aCtx->docFlags = 0;
+  aCtx->indexedHash = 0;
   aCtx->client.bc = NULL;
   aCtx->next = NULL;
   aCtx->specFlags = sp->flags;
@@ -306,6 +313,28 @@ static int AddDocumentCtx_ReplaceMerge(RSAddDocumentCtx *aCtx, RedisSearchCtx *s
   return 0;
 }
 
+/* The size of the text and tag values of the document, which are most of its preprocessing */
+static size_t AddDocumentCtx_TextSize(const RSAddDocumentCtx *aCtx) {
+  size_t totalSize = 0;
+  for (size_t ii = 0; ii < aCtx->doc->numFields; ++ii) {
+    const DocumentField *ff = aCtx->doc->fields + ii;
+    if ((ff->indexAs & (INDEXFLD_T_FULLTEXT | INDEXFLD_T_TAG))) {
+      // TODO: GEOMETRY - handle geometry fields?
+      size_t n;
+      if (ff->unionType == FLD_VAR_T_CSTR || ff->unionType == FLD_VAR_T_RMS) {
+        DocumentField_GetValueCStr(&aCtx->doc->fields[ii], &n);
+        totalSize += n;
+      } else if (ff->unionType == FLD_VAR_T_ARRAY) {
+        for (size_t jj = 0; jj < ff->arrayLen; ++jj) {
+          DocumentField_GetArrayValueCStr(&aCtx->doc->fields[ii], &n, jj);
+          totalSize += n;
+        }
+      }
+    }
+  }
+  return totalSize;
+}
+
 static int handlePartialUpdate(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   // Handle partial update of fields
   if (aCtx->stateFlags & ACTX_F_INDEXABLES) {
@@ -339,24 +368,7 @@ void AddDocumentCtx_Submit(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, uint32_
 
   bool concurrentSearch = false;
   if (AddDocumentCtx_IsBlockable(aCtx)) {
-    size_t totalSize = 0;
-    for (size_t ii = 0; ii < aCtx->doc->numFields; ++ii) {
-      const DocumentField *ff = aCtx->doc->fields + ii;
-      if ((ff->indexAs & (INDEXFLD_T_FULLTEXT | INDEXFLD_T_TAG))) {
-        // TODO: GEOMETRY - handle geometry fields?
-        size_t n;
-        if (ff->unionType == FLD_VAR_T_CSTR || ff->unionType == FLD_VAR_T_RMS) {
-          DocumentField_GetValueCStr(&aCtx->doc->fields[ii], &n);
-          totalSize += n;
-        } else if (ff->unionType == FLD_VAR_T_ARRAY) {
-          for (size_t jj = 0; jj < ff->arrayLen; ++jj) {
-            DocumentField_GetArrayValueCStr(&aCtx->doc->fields[ii], &n, jj);
-            totalSize += n;
-          }
-        }
-      }
-    }
-    concurrentSearch = (totalSize >= SELF_EXEC_THRESHOLD);
+    concurrentSearch = (AddDocumentCtx_TextSize(aCtx) >= SELF_EXEC_THRESHOLD);
   }
 
   if (!concurrentSearch) {
@@ -493,7 +505,8 @@ FIELD_PREPROCESSOR(fulltextPreprocessor) {
       if (i) {
         c = DocumentField_GetArrayValueCStr(field, &fl, i);
       }
-      ForwardIndexTokenizerCtx_Init(&tokCtx, aCtx->fwIdx, c, curOffsetWriter, fs->ftId, fs->ftWeight);
+      ForwardIndexTokenizerCtx_Init(&tokCtx, aCtx->fwIdx, c, curOffsetWriter, fs->ftId, fs->ftWeight,
+                                    FieldSpec_IsNoOffsets(fs));
       aCtx->tokenizer->Start(aCtx->tokenizer, (char *)c, fl, options);
 
       Token tok = {0};
@@ -646,6 +659,9 @@ FIELD_BULK_INDEXER(numericIndexer) {
       QueryError_SetError(status, QUERY_EGENERIC, "Could not open numeric index for indexing");
       return -1;
     }
+    if (FieldSpec_IsNumericBKD(fs)) {
+      NumericRangeTree_SetBKD(rt);
+    }
   }
 
   if (!fdata->isMulti) {
@@ -811,13 +827,22 @@ FIELD_BULK_INDEXER(tagIndexer) {
       return -1;
     }
     if (FieldSpec_HasSuffixTrie(fs) && !tidx->suffix) {
-      tidx->suffix = NewTrieMap();
+      tidx->suffix = NewSuffixArray();
     }
   }
 
   ctx->spec->stats.invertedSize +=
       TagIndex_Index(tidx, (const char **)fdata->tags, array_len(fdata->tags), aCtx->doc->docId);
   ctx->spec->stats.numRecords++;
+
+  if (aCtx->doc->type == DocumentType_Hash &&
+      (field->unionType == FLD_VAR_T_RMS || field->unionType == FLD_VAR_T_CSTR)) {
+    size_t len;
+    const char *str = DocumentField_GetValueCStr(field, &len);
+    AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TAG);
+    TagIndex_SetDocValue(tidx, str, len, aCtx->doc->docId);
+    AllocStats_SetTag(prevTag);
+  }
   return 0;
 }
 
@@ -835,9 +860,14 @@ int IndexerBulkAdd(IndexBulkData *bulk, RSAddDocumentCtx *cur, RedisSearchCtx *s
                    const DocumentField *field, const FieldSpec *fs, FieldIndexerData *fdata,
                    QueryError *status) {
   int rc = 0;
+  bool profiled = BuildProfile_IsRecording(cur->spec);
   for (size_t ii = 0; ii < INDEXFLD_NUM_TYPES && rc == 0; ++ii) {
     // see which types are supported in the current field...
     if (field->indexAs & INDEXTYPE_FROM_POS(ii)) {
+      hires_clock_t t0;
+      if (profiled) {
+        hires_clock_get(&t0);
+      }
       switch (ii) {
         case IXFLDPOS_TAG:
           rc = tagIndexer(bulk, cur, sctx, field, fs, fdata, status);
@@ -859,6 +889,9 @@ int IndexerBulkAdd(IndexBulkData *bulk, RSAddDocumentCtx *cur, RedisSearchCtx *s
           QueryError_SetError(status, QUERY_EINVAL, "BUG: invalid index type");
           break;
       }
+      if (profiled) {
+        BuildProfile_AddFieldTime(cur->spec, ii, hires_clock_since_nsec(&t0), false);
+      }
     }
   }
   return rc;
@@ -872,9 +905,13 @@ void IndexerBulkCleanup(IndexBulkData *cur, RedisSearchCtx *sctx) {
   }
 }
 
-int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+/* Run the preprocessors of the fields of the document. This only reads the spec */
+static int Document_Preprocess(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   Document *doc = aCtx->doc;
-  int ourRv = REDISMODULE_OK;
+  bool profiled = BuildProfile_IsRecording(aCtx->spec);
+  if (profiled) {
+    BuildProfile_AddDocument(aCtx->spec);
+  }
 
   for (size_t i = 0; i < doc->numFields; i++) {
     const FieldSpec *fs = aCtx->fspecs + i;
@@ -887,10 +924,16 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
       }
 
       PreprocessorFunc pp = preprocessorMap[ii];
-      if (pp(aCtx, sctx, &doc->fields[i], fs, fdata, &aCtx->status) != 0) {
-        ++aCtx->spec->stats.indexingFailures;
-        ourRv = REDISMODULE_ERR;
-        goto cleanup;
+      hires_clock_t t0;
+      if (profiled) {
+        hires_clock_get(&t0);
+      }
+      int rc = pp(aCtx, sctx, &doc->fields[i], fs, fdata, &aCtx->status);
+      if (profiled) {
+        BuildProfile_AddFieldTime(aCtx->spec, ii, hires_clock_since_nsec(&t0), true);
+      }
+      if (rc != 0) {
+        return REDISMODULE_ERR;
       }
       if (!(fs->options & FieldSpec_Dynamic)) {
         // Non-dynamic fields are only indexed as a single type.
@@ -899,13 +942,19 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
       }
     }
   }
+  return REDISMODULE_OK;
+}
 
-  if (Indexer_Add(aCtx->indexer, aCtx) != 0) {
+/* Add the preprocessed document to the indexes, or discard it if its preprocessing failed */
+static int Document_AddPreprocessed(RSAddDocumentCtx *aCtx, int ourRv) {
+  Document *doc = aCtx->doc;
+
+  if (ourRv != REDISMODULE_OK) {
+    ++aCtx->spec->stats.indexingFailures;
+  } else if (Indexer_Add(aCtx->indexer, aCtx) != 0) {
     ourRv = REDISMODULE_ERR;
-    goto cleanup;
   }
 
-cleanup:
   if (ourRv != REDISMODULE_OK) {
     // if a document did not load properly, it is deleted
     // to prevent mismatch of index and hash
@@ -919,6 +968,96 @@ cleanup:
   return ourRv;
 }
 
+int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  return Document_AddPreprocessed(aCtx, Document_Preprocess(aCtx, sctx));
+}
+
+typedef struct {
+  RedisSearchCtx *sctx;
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+  size_t pending;  // Documents not yet preprocessed by the index pool
+} PreprocessBatch;
+
+typedef struct {
+  PreprocessBatch *batch;
+  RSAddDocumentCtx *aCtx;
+  bool concurrent;
+  int rv;
+} PreprocessTask;
+
+static void preprocessThreadCallback(void *p) {
+  PreprocessTask *task = p;
+  PreprocessBatch *batch = task->batch;
+  task->rv = Document_Preprocess(task->aCtx, batch->sctx);
+
+  pthread_mutex_lock(&batch->lock);
+  if (--batch->pending == 0) {
+    pthread_cond_signal(&batch->done);
+  }
+  pthread_mutex_unlock(&batch->lock);
+}
+
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options) {
+  RS_LOG_ASSERT(!(options & DOCUMENT_ADD_PARTIAL), "Partial updates can't be batched");
+  PreprocessBatch batch = {.sctx = sctx};
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.done, NULL);
+  PreprocessTask *tasks = rm_calloc(n, sizeof(*tasks));
+
+  // The large documents are preprocessed by the index pool, while this thread preprocesses the
+  // small ones, which are not worth the hand off
+  for (size_t ii = 0; ii < n; ++ii) {
+    RSAddDocumentCtx *aCtx = aCtxs[ii];
+    RS_LOG_ASSERT(!AddDocumentCtx_IsBlockable(aCtx), "Batched documents can't be blockable");
+    aCtx->options = options;
+    aCtx->client.sctx = sctx;
+    Document_MakeStringsOwner(aCtx->doc);
+
+    tasks[ii] = (PreprocessTask){.batch = &batch, .aCtx = aCtx};
+    if (n > 1 && CONCURRENT_POOL_INDEX != -1 &&
+        AddDocumentCtx_TextSize(aCtx) >= SELF_EXEC_THRESHOLD) {
+      tasks[ii].concurrent = true;
+      pthread_mutex_lock(&batch.lock);
+      ++batch.pending;
+      pthread_mutex_unlock(&batch.lock);
+      ConcurrentSearch_ThreadPoolRun(preprocessThreadCallback, tasks + ii, CONCURRENT_POOL_INDEX);
+    }
+  }
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (!tasks[ii].concurrent) {
+      tasks[ii].rv = Document_Preprocess(aCtxs[ii], sctx);
+    }
+  }
+
+  pthread_mutex_lock(&batch.lock);
+  while (batch.pending) {
+    pthread_cond_wait(&batch.done, &batch.lock);
+  }
+  pthread_mutex_unlock(&batch.lock);
+
+  // Only then are the documents written, in their order, with their terms merged so that each
+  // inverted index is appended to once per batch
+  RSAddDocumentCtx **preprocessed = rm_malloc(n * sizeof(*preprocessed));
+  size_t numPreprocessed = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (tasks[ii].rv == REDISMODULE_OK) {
+      preprocessed[numPreprocessed++] = aCtxs[ii];
+    } else {
+      Document_AddPreprocessed(aCtxs[ii], tasks[ii].rv);
+    }
+  }
+  if (numPreprocessed) {
+    Indexer_AddBatch(preprocessed[0]->indexer, preprocessed, numPreprocessed);
+  }
+
+  rm_free(preprocessed);
+  rm_free(tasks);
+  pthread_cond_destroy(&batch.done);
+  pthread_mutex_destroy(&batch.lock);
+}
+
 /* Evaluate an IF expression (e.g. IF "@foo == 'bar'") against a document, by getting the properties
  * from the sorting table or from the hash representation of the document.
  *
@@ -999,6 +1138,7 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
 
   // Update the score
   md->score = doc->score;
+  DocTable_UpdateMaxScore(&sctx->spec->docs, md->score);
   // Set the payload if needed
   if (doc->payload) {
     DocTable_SetPayload(&sctx->spec->docs, md, doc->payload, doc->payloadSize);
@@ -1024,7 +1164,7 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
       if (idx < 0) continue;
 
       if (!md->sortVector) {
-        md->sortVector = NewSortingVector(sctx->spec->sortables->len);
+        md->sortVector = RSSortingTable_NewVector(sctx->spec->sortables);
       }
 
       RS_LOG_ASSERT((fs->options & FieldSpec_Dynamic) == 0, "Dynamic field cannot use PARTIAL");
@@ -1059,6 +1199,97 @@ done:
   AddDocumentCtx_Free(aCtx);
 }
 
+uint64_t Document_IndexedHash(const Document *doc, const IndexSpec *sp) {
+  if (doc->type != DocumentType_Hash) {
+    return 0;
+  }
+  uint64_t h = fnv_64a_buf(&doc->language, sizeof(doc->language), 0xcbf29ce484222325ULL);
+  h = fnv_64a_buf(&doc->score, sizeof(doc->score), h);
+  h = fnv_64a_buf(&doc->payloadSize, sizeof(doc->payloadSize), h);
+  if (doc->payload) {
+    h = fnv_64a_buf(doc->payload, doc->payloadSize, h);
+  }
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const DocumentField *f = doc->fields + ii;
+    const FieldSpec *fs = IndexSpec_GetField(sp, f->name, strlen(f->name));
+    if (!fs) {
+      continue;
+    }
+    h = fnv_64a_buf(&fs->index, sizeof(fs->index), h);
+    if (!FieldSpec_IsIndexable(fs)) {
+      continue;
+    }
+    if (f->unionType != FLD_VAR_T_RMS) {
+      return 0;
+    }
+    size_t len;
+    const char *s = RedisModule_StringPtrLen(f->text, &len);
+    h = fnv_64a_buf(&len, sizeof(len), h);
+    h = fnv_64a_buf(s, len, h);
+  }
+  return h ? h : 1;
+}
+
+int Document_UpdateUnindexed(Document *doc, RedisSearchCtx *sctx, uint64_t indexedHash) {
+  IndexSpec *sp = sctx->spec;
+  if (!indexedHash) {
+    return 0;
+  }
+  t_docId docId = DocTable_GetIdR(&sp->docs, doc->docKey);
+  RSDocumentMetadata *md = docId ? (RSDocumentMetadata *)DocTable_Borrow(&sp->docs, docId) : NULL;
+  if (!md) {
+    return 0;
+  }
+  int rc = 0;
+  if (md->indexedHash != indexedHash) {
+    goto done;
+  }
+
+  // check the values first, as indexing would, not to update a document which would fail to index
+  double numval;
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const DocumentField *f = doc->fields + ii;
+    const FieldSpec *fs = IndexSpec_GetField(sp, f->name, strlen(f->name));
+    if (!fs || FieldSpec_IsIndexable(fs)) {
+      continue;
+    }
+    if (f->unionType != FLD_VAR_T_RMS || (fs->options & FieldSpec_Dynamic)) {
+      goto done;
+    }
+    if (fs->types == INDEXFLD_T_NUMERIC) {
+      if (RedisModule_StringToDouble(f->text, &numval) == REDISMODULE_ERR) {
+        goto done;
+      }
+    } else if (fs->types != INDEXFLD_T_FULLTEXT) {
+      // the sortable values of the other types depend on how they are parsed
+      goto done;
+    }
+  }
+
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const DocumentField *f = doc->fields + ii;
+    const FieldSpec *fs = IndexSpec_GetField(sp, f->name, strlen(f->name));
+    if (!fs || FieldSpec_IsIndexable(fs) || !FieldSpec_IsSortable(fs)) {
+      continue;
+    }
+    if (!md->sortVector) {
+      md->sortVector = RSSortingTable_NewVector(sp->sortables);
+    }
+    if (fs->types == INDEXFLD_T_NUMERIC) {
+      RedisModule_StringToDouble(f->text, &numval);
+      RSSortingVector_Put(md->sortVector, fs->sortIdx, &numval, RS_SORTABLE_NUM, 0);
+    } else {
+      RSSortingVector_Put(md->sortVector, fs->sortIdx, RedisModule_StringPtrLen(f->text, NULL),
+                          RS_SORTABLE_STR, fs->options & FieldSpec_UNF);
+    }
+  }
+  rc = 1;
+
+done:
+  DMD_Return(md);
+  return rc;
+}
+
 DocumentField *Document_GetField(Document *d, const char *fieldName) {
   if (!d || !fieldName) return NULL;
 
@@ -298,6 +298,9 @@ typedef struct RSAddDocumentCtx {
   // New flags to assign to the document
   RSDocumentFlags docFlags;
 
+  // Hash of the indexed values of the document to keep in its metadata, or 0
+  uint64_t indexedHash;
+
   // Scratch space used by per-type field preprocessors (see the source)
   struct FieldIndexerData *fdatas;
   QueryError status;     // Error message is placed here if there is an error during processing
@@ -348,6 +351,32 @@ void AddDocumentCtx_Finish(RSAddDocumentCtx *aCtx);
  */
 int Document_AddToIndexes(RSAddDocumentCtx *ctx, RedisSearchCtx *sctx);
 
+/**
+ * Like AddDocumentCtx_Submit() for several non-blockable contexts at once. The preprocessing of
+ * the documents (tokenizing, stemming, building their forward index) only reads the spec, so the
+ * large documents are preprocessed concurrently on the index thread pool. The documents are then
+ * added to the indexes by the calling thread, in their order and with their terms merged (see
+ * Indexer_AddBatch), so the caller must hold the spec write lock throughout, and the GIL for the
+ * documents not to change meanwhile.
+ */
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options);
+
+/**
+ * A hash of what is indexed of a hash document in the spec: the values of its indexed fields,
+ * which of its unindexed fields it has, its language, score and payload. Two versions of a
+ * document with the same hash have the same indexes, and only the sortable values of their
+ * unindexed fields may differ. Returns 0 if the document can't be hashed.
+ */
+uint64_t Document_IndexedHash(const Document *doc, const IndexSpec *sp);
+
+/**
+ * If the document is indexed with the same indexed hash, update the sortable values of its
+ * unindexed fields in place, keeping its id, and return 1. Returns 0 if the document has to be
+ * reindexed. The spec must be locked for writing.
+ */
+int Document_UpdateUnindexed(Document *doc, RedisSearchCtx *sctx, uint64_t indexedHash);
+
 /**
  * Free the AddDocumentCtx. Should be done once AddToIndexes() completes; or
  * when the client is unblocked.
@@ -374,6 +403,12 @@ int Redis_SaveDocument(RedisSearchCtx *ctx, const AddDocumentOptions *opts, Quer
 /* Serialzie the document's fields to a redis client */
 int Document_ReplyAllFields(RedisModuleCtx *ctx, IndexSpec *spec, RedisModuleString *id);
 
+/* Reply with the fields of every document of `ids` as Document_ReplyAllFields, or with a null for
+ * the keys which are not indexed. The keys are all opened at once and their hashes scanned in
+ * place, rather than copied by a call to HGETALL for every key */
+void Document_ReplyAllFieldsOfKeys(RedisModuleCtx *ctx, IndexSpec *spec, RedisModuleString **ids,
+                                   size_t n);
+
 DocumentField *Document_GetField(Document *d, const char *fieldName);
 
 /* return value as c string (if array - return the first entry)*/
@@ -171,6 +171,7 @@ int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx) {
   RedisModuleCtx *ctx = sctx->redisCtx;
   size_t nitems = sctx->spec->numFields;
   JSONResultsIterator jsonIter = NULL;
+  arrayof(RedisJSON) *values = NULL;
 
   RedisJSON jsonRoot = japi->openKey(ctx, doc->docKey);
   if (!jsonRoot) {
@@ -183,22 +184,36 @@ int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx) {
   doc->score = SchemaRule_JsonScore(sctx->redisCtx, rule, jsonRoot, keyName);
   // No payload on JSON as RedisJSON does not support binary fields
 
+  // extract the values of all the fields with simple paths in a single walk of the document
+  JSONPlan *plan = IndexSpec_GetJSONPlan(spec);
+  values = rm_calloc(nitems, sizeof(*values));
+  JSONPlan_Eval(plan, jsonRoot, values);
+
   doc->fields = rm_calloc(nitems, sizeof(*doc->fields));
   size_t ii = 0;
   for (; ii < spec->numFields; ++ii) {
     FieldSpec *field = &spec->fields[ii];
+    bool planned = JSONPlan_HasField(plan, ii);
 
-    jsonIter = japi->get(jsonRoot, field->path);
-    // if field does not exist or is empty (can happen after JSON.DEL)
-    if (!jsonIter) {
+    size_t len;
+    if (planned) {
+      len = array_len(values[ii]);
+      if (len == 0) {
         continue;
-    }
+      }
+    } else {
+      jsonIter = japi->get(jsonRoot, field->path);
+      // if field does not exist or is empty (can happen after JSON.DEL)
+      if (!jsonIter) {
+          continue;
+      }
 
-    size_t len = japi->len(jsonIter);
-    if (len == 0) {
-      japi->freeIter(jsonIter);
-      jsonIter = NULL;
-      continue;
+      len = japi->len(jsonIter);
+      if (len == 0) {
+        japi->freeIter(jsonIter);
+        jsonIter = NULL;
+        continue;
+      }
     }
 
     size_t oix = doc->numFields++;
@@ -208,12 +223,17 @@ int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx) {
 
     // on crdt the return value might be the underline value, we must copy it!!!
     // TODO: change `fs->text` to support hash or json not RedisModuleString
-    if (JSON_LoadDocumentField(jsonIter, len, field, &doc->fields[oix], ctx) != REDISMODULE_OK) {
+    int rc = planned ? JSON_LoadDocumentFieldFromValues(values[ii], len, field, &doc->fields[oix],
+                                                        jsonRoot, ctx)
+                     : JSON_LoadDocumentField(jsonIter, len, field, &doc->fields[oix], ctx);
+    if (rc != REDISMODULE_OK) {
       RedisModule_Log(ctx, "verbose", "Failed to load value from field %s", field->path);
       goto done;
     }
-    japi->freeIter(jsonIter);
-    jsonIter = NULL;
+    if (jsonIter) {
+      japi->freeIter(jsonIter);
+      jsonIter = NULL;
+    }
   }
   rv = REDISMODULE_OK;
 
@@ -221,6 +241,12 @@ done:
   if (jsonIter) {
     japi->freeIter(jsonIter);
   }
+  if (values) {
+    for (size_t jj = 0; jj < nitems; ++jj) {
+      array_free(values[jj]);
+    }
+    rm_free(values);
+  }
   return rv;
 }
 
@@ -265,6 +291,17 @@ done:
   return rc;
 }
 
+// Whether a field of the hash of a document holds its language, score or payload
+static bool isRuleField(const SchemaRule *rule, const char *str, size_t len) {
+  const char *fields[] = {rule->lang_field, rule->score_field, rule->payload_field};
+  for (size_t i = 0; i < sizeof(fields) / sizeof(*fields); ++i) {
+    if (fields[i] && strlen(fields[i]) == len && !strncasecmp(str, fields[i], len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 int Document_ReplyAllFields(RedisModuleCtx *ctx, IndexSpec *spec, RedisModuleString *id) {
   int rc = REDISMODULE_ERR;
   RedisModuleCallReply *rep = NULL;
@@ -286,22 +323,15 @@ int Document_ReplyAllFields(RedisModuleCtx *ctx, IndexSpec *spec, RedisModuleStr
 
   size_t strLen;
   RedisModuleCallReply *e;
-  SchemaRule *rule = spec->rule;
   RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
   size_t numElems = 0;
 
-  size_t lang_len = rule->lang_field ? strlen(rule->lang_field) : 0;
-  size_t score_len = rule->score_field ? strlen(rule->score_field) : 0;
-  size_t payload_len = rule->payload_field ? strlen(rule->payload_field) : 0;
-
   for (size_t i = 0; i < hashLen; i += 2) {
     // parse field
     e = RedisModule_CallReplyArrayElement(rep, i);
     const char *str = RedisModule_CallReplyStringPtr(e, &strLen);
     RS_LOG_ASSERT(strLen > 0, "field string cannot be empty");
-    if ((lang_len == strLen && strncasecmp(str, rule->lang_field, strLen) == 0) ||
-        (score_len == strLen && strncasecmp(str, rule->score_field, strLen) == 0) ||
-        (payload_len == strLen && strncasecmp(str, rule->payload_field, strLen) == 0)) {
+    if (isRuleField(spec->rule, str, strLen)) {
       continue;
     }
     RedisModule_ReplyWithStringBuffer(ctx, str, strLen);
@@ -326,6 +356,82 @@ done:
   return rc;
 }
 
+typedef struct {
+  RedisModuleCtx *ctx;
+  const SchemaRule *rule;
+  size_t numElems;
+} replyFieldsCtx;
+
+static void replyFields_scanCallback(RedisModuleKey *key, RedisModuleString *field,
+                                     RedisModuleString *value, void *privdata) {
+  REDISMODULE_NOT_USED(key);
+  replyFieldsCtx *rctx = privdata;
+  size_t len;
+  const char *str = RedisModule_StringPtrLen(field, &len);
+  if (isRuleField(rctx->rule, str, len)) {
+    return;
+  }
+  RedisModule_ReplyWithString(rctx->ctx, field);
+  RedisModule_StringPtrLen(value, &len);
+  if (len != 0) {
+    RedisModule_ReplyWithString(rctx->ctx, value);
+  } else {
+    RedisModule_ReplyWithNull(rctx->ctx);
+  }
+  rctx->numElems += 2;
+}
+
+void Document_ReplyAllFieldsOfKeys(RedisModuleCtx *ctx, IndexSpec *spec, RedisModuleString **ids,
+                                   size_t n) {
+  const DocTable *dt = &spec->docs;
+  // The scan API can only be used from Redis 6.0.6, and not on enterprise-crdt
+  if (!isFeatureSupported(RM_SCAN_KEY_API_FIX) || isCrdt) {
+    for (size_t i = 0; i < n; i++) {
+      if (DocTable_GetIdR(dt, ids[i]) == 0) {
+        RedisModule_ReplyWithNull(ctx);
+      } else {
+        Document_ReplyAllFields(ctx, spec, ids[i]);
+      }
+    }
+    return;
+  }
+
+  // Open all the keys before replying with any, rather than alternating between the keyspace and
+  // the reply of every key
+  struct {
+    RedisModuleKey *key;
+    bool indexed;
+  } *docs = rm_calloc(n, sizeof(*docs));
+  for (size_t i = 0; i < n; i++) {
+    docs[i].indexed = DocTable_GetIdR(dt, ids[i]) != 0;
+    if (docs[i].indexed) {
+      docs[i].key = RedisModule_OpenKey(ctx, ids[i], REDISMODULE_READ | REDISMODULE_OPEN_KEY_NOEFFECTS);
+    }
+  }
+
+  RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
+  for (size_t i = 0; i < n; i++) {
+    RedisModuleKey *key = docs[i].key;
+    if (!docs[i].indexed) {
+      // Document does not exist in index; even though it exists in keyspace
+      RedisModule_ReplyWithNull(ctx);
+    } else if (!key || RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_HASH) {
+      RedisModule_ReplyWithArray(ctx, 0);
+    } else {
+      replyFieldsCtx rctx = {.ctx = ctx, .rule = spec->rule};
+      RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+      RedisModule_ScanCursorRestart(cursor);
+      while (RedisModule_ScanKey(key, cursor, replyFields_scanCallback, &rctx));
+      RedisModule_ReplySetArrayLength(ctx, rctx.numElems);
+    }
+    if (key) {
+      RedisModule_CloseKey(key);
+    }
+  }
+  RedisModule_ScanCursorDestroy(cursor);
+  rm_free(docs);
+}
+
 void Document_LoadPairwiseArgs(Document *d, RedisModuleString **args, size_t nargs) {
   d->fields = rm_calloc(nargs / 2, sizeof(*d->fields));
   d->numFields = nargs / 2;
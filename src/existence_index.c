@@ -0,0 +1,97 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "existence_index.h"
+#include "rmalloc.h"
+
+#include <string.h>
+#include <sys/param.h>
+
+ExistenceIndex *NewExistenceIndex(uint16_t fieldIndex) {
+  ExistenceIndex *ex = rm_calloc(1, sizeof(*ex));
+  ex->fieldIndex = fieldIndex;
+  return ex;
+}
+
+void ExistenceIndex_Free(ExistenceIndex *ex) {
+  if (!ex) {
+    return;
+  }
+  rm_free(ex->words);
+  rm_free(ex);
+}
+
+void ExistenceIndex_Add(ExistenceIndex *ex, t_docId docId) {
+  size_t word = docId / 64;
+  if (word >= ex->numWords) {
+    size_t oldWords = ex->numWords;
+    ex->numWords = MAX(word + 1, oldWords * 2);
+    ex->words = rm_realloc(ex->words, ex->numWords * sizeof(*ex->words));
+    memset(ex->words + oldWords, 0, (ex->numWords - oldWords) * sizeof(*ex->words));
+  }
+  uint64_t bit = 1ULL << (docId % 64);
+  if (!(__atomic_fetch_or(&ex->words[word], bit, __ATOMIC_RELAXED) & bit)) {
+    ++ex->numDocs;
+  }
+}
+
+void ExistenceIndex_Remove(ExistenceIndex *ex, t_docId docId) {
+  size_t word = docId / 64;
+  uint64_t bit = 1ULL << (docId % 64);
+  if (word < ex->numWords && (__atomic_fetch_and(&ex->words[word], ~bit, __ATOMIC_RELAXED) & bit)) {
+    --ex->numDocs;
+  }
+}
+
+t_docId ExistenceIndex_Next(const ExistenceIndex *ex, const DocTable *docs, t_docId docId,
+                            bool missing) {
+  size_t word = docId / 64;
+  if (word >= docs->liveDocsWords) {
+    return 0;
+  }
+  // the live documents of a word, less the ones having the field or the ones missing it. The
+  // documents beyond the bitmap are all missing the field
+  uint64_t bits = __atomic_load_n(&docs->liveDocs[word], __ATOMIC_RELAXED) & (~0ULL << (docId % 64));
+  while (1) {
+    uint64_t has = word < ex->numWords ? __atomic_load_n(&ex->words[word], __ATOMIC_RELAXED) : 0;
+    bits &= missing ? ~has : has;
+    if (bits) {
+      return word * 64 + __builtin_ctzll(bits);
+    }
+    if (++word == docs->liveDocsWords || (!missing && word >= ex->numWords)) {
+      return 0;
+    }
+    bits = __atomic_load_n(&docs->liveDocs[word], __ATOMIC_RELAXED);
+  }
+}
+
+void ExistenceIndex_Remap(ExistenceIndex *ex, const DocIdRemap *remap) {
+  // By increasing ids, as DocTable_Remap, so the bit of a new id is never one still to be moved
+  for (t_docId docId = remap->from; docId < remap->to; ++docId) {
+    t_docId newId = remap->newIds[docId - remap->from];
+    if (newId == docId) {
+      continue;
+    }
+    bool has = ExistenceIndex_Has(ex, docId);
+    ExistenceIndex_Remove(ex, docId);
+    if (newId && has) {
+      ExistenceIndex_Add(ex, newId);
+    } else if (newId) {
+      ExistenceIndex_Remove(ex, newId);
+    }
+  }
+}
+
+void ExistenceIndex_Clear(ExistenceIndex *ex) {
+  rm_free(ex->words);
+  ex->words = NULL;
+  ex->numWords = 0;
+  ex->numDocs = 0;
+}
+
+size_t ExistenceIndex_MemUsage(const ExistenceIndex *ex) {
+  return sizeof(*ex) + ex->numWords * sizeof(*ex->words);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "doc_table.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The documents having an INDEXMISSING field, as a bitmap of their ids, for the `ismissing`
+ * queries.
+ *
+ * The bits of deleted documents are cleared, but as the ids are not reused, a stale bit is
+ * harmless: the bitmap is only read together with the live documents of the table, so that the
+ * documents missing the field are found a word at a time, without reading any other index */
+typedef struct ExistenceIndex {
+  uint64_t *words;
+  size_t numWords;
+  size_t numDocs;       // the bits set
+  uint16_t fieldIndex;  // the index of the field in the spec
+} ExistenceIndex;
+
+ExistenceIndex *NewExistenceIndex(uint16_t fieldIndex);
+
+void ExistenceIndex_Free(ExistenceIndex *ex);
+
+/* Mark a document as having the field */
+void ExistenceIndex_Add(ExistenceIndex *ex, t_docId docId);
+
+void ExistenceIndex_Remove(ExistenceIndex *ex, t_docId docId);
+
+static inline bool ExistenceIndex_Has(const ExistenceIndex *ex, t_docId docId) {
+  size_t word = docId / 64;
+  return word < ex->numWords &&
+         ((__atomic_load_n(&ex->words[word], __ATOMIC_RELAXED) >> (docId % 64)) & 1);
+}
+
+/* The first live document of `docs` with an id from `docId` on which has the field, or is missing
+ * it if `missing` is set. Returns 0 if there is none */
+t_docId ExistenceIndex_Next(const ExistenceIndex *ex, const DocTable *docs, t_docId docId,
+                            bool missing);
+
+/* Move the bits of the documents renumbered by the docid compaction */
+void ExistenceIndex_Remap(ExistenceIndex *ex, const DocIdRemap *remap);
+
+/* Forget all the documents, when the contents of the index are dropped */
+void ExistenceIndex_Clear(ExistenceIndex *ex);
+
+size_t ExistenceIndex_MemUsage(const ExistenceIndex *ex);
+
+#ifdef __cplusplus
+}
+#endif
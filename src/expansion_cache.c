@@ -0,0 +1,177 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "expansion_cache.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/arr.h"
+#include "util/dllist.h"
+
+#include <pthread.h>
+#include <string.h>
+
+struct ExpansionCache {
+  pthread_mutex_t lock;
+  TrieMap *entries;   // key => ExpansionEntry
+  DLLIST lru;         // the most recently used entry first
+  size_t size;
+  size_t memory;
+  uint64_t revision;  // the revision of the index the entries were expanded at
+  size_t hits;
+  size_t misses;
+};
+
+typedef struct {
+  DLLIST_node llnode;
+  char *key;
+  tm_len_t keylen;
+  size_t limit;
+  size_t memory;
+  Expansion *exp;
+} ExpansionEntry;
+
+Expansion *NewExpansion(char **values) {
+  Expansion *exp = rm_new(Expansion);
+  exp->values = values;
+  exp->refcount = 1;
+  return exp;
+}
+
+void Expansion_Release(Expansion *exp) {
+  if (__atomic_sub_fetch(&exp->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  array_free_ex(exp->values, rm_free(*(char **)ptr));
+  rm_free(exp);
+}
+
+ExpansionCache *NewExpansionCache() {
+  ExpansionCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = NewTrieMap();
+  dllist_init(&cache->lru);
+  return cache;
+}
+
+static void expansionEntry_Free(void *p) {
+  ExpansionEntry *e = p;
+  Expansion_Release(e->exp);
+  rm_free(e->key);
+  rm_free(e);
+}
+
+void ExpansionCache_Free(ExpansionCache *cache) {
+  TrieMap_Free(cache->entries, expansionEntry_Free);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+static void expansionCache_Clear(ExpansionCache *cache) {
+  TrieMap_Free(cache->entries, expansionEntry_Free);
+  cache->entries = NewTrieMap();
+  dllist_init(&cache->lru);
+  cache->size = 0;
+  cache->memory = 0;
+}
+
+static void expansionCache_Delete(ExpansionCache *cache, ExpansionEntry *e) {
+  dllist_delete(&e->llnode);
+  cache->size--;
+  cache->memory -= e->memory;
+  // deleting the key frees the entry
+  char *key = e->key;
+  e->key = NULL;
+  TrieMap_Delete(cache->entries, key, e->keylen, expansionEntry_Free);
+  rm_free(key);
+}
+
+/* Lock the cache, dropping its entries if they were expanded at another revision */
+static void expansionCache_Lock(ExpansionCache *cache, uint64_t revision) {
+  pthread_mutex_lock(&cache->lock);
+  if (cache->revision != revision) {
+    expansionCache_Clear(cache);
+    cache->revision = revision;
+  }
+}
+
+/* The memory an entry accounts for, including its share of the expansion */
+static size_t expansionEntry_Memory(size_t keylen, const Expansion *exp) {
+  size_t n = array_len(exp->values);
+  size_t memory = sizeof(ExpansionEntry) + sizeof(Expansion) + keylen + n * sizeof(char *);
+  for (size_t i = 0; i < n; ++i) {
+    memory += strlen(exp->values[i]) + 1;
+  }
+  return memory;
+}
+
+Expansion *ExpansionCache_Get(ExpansionCache *cache, uint64_t revision, const char *key,
+                              size_t keylen, size_t limit) {
+  if (keylen >= UINT16_MAX) {
+    return NULL;
+  }
+
+  Expansion *exp = NULL;
+  expansionCache_Lock(cache, revision);
+  ExpansionEntry *e = TrieMap_Find(cache->entries, (char *)key, keylen);
+  if (e != TRIEMAP_NOTFOUND && e->limit == limit) {
+    dllist_delete(&e->llnode);
+    dllist_prepend(&cache->lru, &e->llnode);
+    exp = e->exp;
+    __atomic_add_fetch(&exp->refcount, 1, __ATOMIC_RELAXED);
+    cache->hits++;
+  } else {
+    cache->misses++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return exp;
+}
+
+void ExpansionCache_Put(ExpansionCache *cache, uint64_t revision, const char *key, size_t keylen,
+                        size_t limit, Expansion *exp) {
+  if (keylen >= UINT16_MAX) {
+    return;
+  }
+  size_t memory = expansionEntry_Memory(keylen, exp);
+  if (memory > EXPANSION_CACHE_MEMORY) {
+    return;
+  }
+
+  expansionCache_Lock(cache, revision);
+  ExpansionEntry *e = TrieMap_Find(cache->entries, (char *)key, keylen);
+  if (e != TRIEMAP_NOTFOUND) {
+    // expanded concurrently, or with another limit
+    expansionCache_Delete(cache, e);
+  }
+
+  e = rm_new(ExpansionEntry);
+  e->key = rm_malloc(keylen);
+  memcpy(e->key, key, keylen);
+  e->keylen = keylen;
+  e->limit = limit;
+  e->memory = memory;
+  e->exp = exp;
+  __atomic_add_fetch(&exp->refcount, 1, __ATOMIC_RELAXED);
+  TrieMap_Add(cache->entries, e->key, e->keylen, e, NULL);
+  dllist_prepend(&cache->lru, &e->llnode);
+  cache->size++;
+  cache->memory += memory;
+  while (cache->size > EXPANSION_CACHE_SIZE || cache->memory > EXPANSION_CACHE_MEMORY) {
+    expansionCache_Delete(cache, DLLIST_ITEM(cache->lru.prev, ExpansionEntry, llnode));
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+ExpansionCacheStats ExpansionCache_GetStats(ExpansionCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  ExpansionCacheStats stats = {
+      .hits = cache->hits,
+      .misses = cache->misses,
+      .entries = cache->size,
+      .memory = cache->memory,
+  };
+  pthread_mutex_unlock(&cache->lock);
+  return stats;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of pattern expansions kept by an expansion cache */
+#define EXPANSION_CACHE_SIZE 256
+
+/* Number of bytes of pattern expansions kept by an expansion cache */
+#define EXPANSION_CACHE_MEMORY (1 << 20)
+
+/* The values (terms or tags) a pattern expanded to. It is shared by the queries expanding the
+ * same pattern, so it is released rather than freed */
+typedef struct {
+  char **values;
+  uint32_t refcount;
+} Expansion;
+
+typedef enum {
+  Expansion_Prefix = 'P',
+  Expansion_Suffix = 'S',
+  Expansion_Contains = 'C',
+  Expansion_Wildcard = 'W',
+  Expansion_Fuzzy = 'F',
+} ExpansionType;
+
+/* An LRU cache of the most recent pattern expansions of an index, bounded both by the number of
+ * expansions and by their memory. Queries expand patterns concurrently under the spec read lock,
+ * so the cache has a lock of its own.
+ *
+ * Every entry was expanded at a revision of its index, a counter the index bumps whenever the
+ * values a pattern may expand to change. Accessing the cache at another revision drops all of its
+ * entries */
+typedef struct ExpansionCache ExpansionCache;
+
+typedef struct {
+  size_t hits;
+  size_t misses;
+  size_t entries;
+  size_t memory;   // bytes used by the entries
+} ExpansionCacheStats;
+
+/* Create an expansion holding the values, with a single reference. Takes ownership of `values` */
+Expansion *NewExpansion(char **values);
+
+void Expansion_Release(Expansion *exp);
+
+ExpansionCache *NewExpansionCache();
+
+void ExpansionCache_Free(ExpansionCache *cache);
+
+/* Get the cached expansion of a key, expanded with at most `limit` values at `revision`. Returns
+ * NULL if it is not cached. The caller releases the expansion */
+Expansion *ExpansionCache_Get(ExpansionCache *cache, uint64_t revision, const char *key,
+                              size_t keylen, size_t limit);
+
+/* Cache the expansion of a key, expanded with at most `limit` values at `revision`, evicting the
+ * least recently used expansions if the cache is full */
+void ExpansionCache_Put(ExpansionCache *cache, uint64_t revision, const char *key, size_t keylen,
+                        size_t limit, Expansion *exp);
+
+ExpansionCacheStats ExpansionCache_GetStats(ExpansionCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
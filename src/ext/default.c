@@ -137,6 +137,53 @@ static double TFIDFNormDocLenScorer(const ScoringFunctionArgs *ctx, const RSInde
   return tfIdfInternal(ctx, h, dmd, minScore, NORM_DOCLEN);
 }
 
+/******************************************************************************************
+ *
+ * Batch scoring functions
+ *
+ * The scores of the leaves of all the results are computed in one loop over the batch's arrays,
+ * which the compiler can vectorize, and then added up per result in the same order as the
+ * recursive scorers add them, so that both yield the very same scores.
+ *
+ ******************************************************************************************/
+
+/* Add up the scores of the leaves of every result, multiplied by the weight of the result */
+static void sumLeafScores(const RSScoringBatch *b, double *scores) {
+  for (size_t i = 0; i < b->numResults; i++) {
+    double ret = 0;
+    for (uint32_t j = b->leafStart[i]; j < b->leafStart[i + 1]; j++) {
+      ret += b->leafScores[j];
+    }
+    scores[i] = b->weights[i] * ret;
+  }
+}
+
+static inline void tfIdfBatchInternal(const RSScoringBatch *b, double minScore, double *scores,
+                                      int normMode) {
+  const size_t n = b->numLeaves;
+  for (size_t j = 0; j < n; j++) {
+    double tf = b->leafWeights[j] * b->freqs[j];
+    b->leafScores[j] = b->leafTypes[j] == RSResultType_Term ? tf * b->idfs[j] : tf;
+  }
+  sumLeafScores(b, scores);
+
+  for (size_t i = 0; i < b->numResults; i++) {
+    uint32_t norm = normMode == NORM_MAXFREQ ? b->docMaxFreqs[i] : b->docLens[i];
+    double tfidf = b->docScores[i] * scores[i] / norm;
+    scores[i] = b->docScores[i] == 0 || tfidf < minScore ? 0 : tfidf / b->slops[i];
+  }
+}
+
+static void TFIDFBatchScorer(const ScoringFunctionArgs *ctx, const RSScoringBatch *b,
+                             double minScore, double *scores) {
+  tfIdfBatchInternal(b, minScore, scores, NORM_MAXFREQ);
+}
+
+static void TFIDFNormDocLenBatchScorer(const ScoringFunctionArgs *ctx, const RSScoringBatch *b,
+                                       double minScore, double *scores) {
+  tfIdfBatchInternal(b, minScore, scores, NORM_DOCLEN);
+}
+
 /******************************************************************************************
  *
  * BM25 Scoring Functions
@@ -209,6 +256,26 @@ static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
   return score;
 }
 
+/* BM25 batch scoring function */
+static void BM25BatchScorer(const ScoringFunctionArgs *ctx, const RSScoringBatch *b,
+                            double minScore, double *scores) {
+  static const float b_ = 0.5;
+  static const float k1 = 1.2;
+  const double norm = k1 * (1.0f - b_ + b_ * ctx->indexStats.avgDocLen);
+  const size_t n = b->numLeaves;
+  for (size_t j = 0; j < n; j++) {
+    double f = b->freqs[j];
+    double coef = b->leafTypes[j] == RSResultType_Term ? b->idfs[j] : b->leafWeights[j];
+    b->leafScores[j] = f ? coef * f / (f + norm) : 0;
+  }
+  sumLeafScores(b, scores);
+
+  for (size_t i = 0; i < b->numResults; i++) {
+    double score = b->docScores[i] * scores[i];
+    scores[i] = score < minScore ? 0 : score / b->slops[i];
+  }
+}
+
 /******************************************************************************************
  *
  * BM25 Scoring Functions - standard version according to https://en.wikipedia.org/wiki/Okapi_BM25
@@ -225,11 +292,20 @@ static double inline CalculateBM25Std(float b, float k1, double idf, double f, i
   return ret;
 }
 
+#define BM25STD_B 0.5f
+#define BM25STD_K1 1.2f
+
+/* BM25STD is increasing in the term frequency and decreasing in the document length, so the score
+ * of a zero length document with the maximal frequency bounds the score of any document */
+double BM25Std_TermUpperBound(double idf, uint32_t maxFreq) {
+  return CalculateBM25Std(BM25STD_B, BM25STD_K1, idf, maxFreq, 0, 1, NULL, NULL);
+}
+
 /* recursively calculate score for each token, summing up sub tokens */
 static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                             const RSDocumentMetadata *dmd, RSScoreExplain *scrExp) {
-  static const float b = 0.5f;
-  static const float k1 = 1.2f;
+  static const float b = BM25STD_B;
+  static const float k1 = BM25STD_K1;
   double f = (double)r->freq;
   double ret = 0;
   if (r->type == RSResultType_Term) {
@@ -283,6 +359,31 @@ static double BM25StdScorer(const ScoringFunctionArgs *ctx, const RSIndexResult
   return score;
 }
 
+/* BM25 batch scoring function - standard version */
+static void BM25StdBatchScorer(const ScoringFunctionArgs *ctx, const RSScoringBatch *b,
+                               double minScore, double *scores) {
+  static const float b_ = BM25STD_B;
+  static const float k1 = BM25STD_K1;
+  const double avgDocLen = ctx->indexStats.avgDocLen;
+  const size_t n = b->numLeaves;
+  for (size_t j = 0; j < n; j++) {
+    int docLen = b->docLens[b->leafResults[j]];
+    double f = b->freqs[j];
+    double ret = 0;
+    if (b->leafTypes[j] == RSResultType_Term) {
+      ret = CalculateBM25Std(b_, k1, b->bm25Idfs[j], f, docLen, avgDocLen, NULL, NULL);
+    } else if (b->leafTypes[j] == RSResultType_Virtual && f && b->leafWeights[j]) {
+      ret = b->leafWeights[j] * CalculateBM25Std(b_, k1, 1.0, 1, docLen, avgDocLen, NULL, NULL);
+    }
+    b->leafScores[j] = ret;
+  }
+  sumLeafScores(b, scores);
+
+  for (size_t i = 0; i < b->numResults; i++) {
+    scores[i] = b->docScores[i] * scores[i];
+  }
+}
+
 
 /******************************************************************************************
  *
@@ -469,19 +570,18 @@ int StemmerExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
     return REDISMODULE_OK;
   }
 
-  const sb_symbol *b = (const sb_symbol *)token->str;
-  const sb_symbol *stemmed = sb_stemmer_stem(sb, b, token->len);
+  size_t sl;
+  const char *stemmed = StemmerCache_Stem(sb, ctx->language, token->str, token->len, &sl);
 
   if (stemmed) {
-    int sl = sb_stemmer_length(sb);
-
     // Make a copy of the stemmed buffer with the + prefix given to stems
     char *dup = rm_malloc(sl + 2);
     dup[0] = STEM_PREFIX;
-    memcpy(dup + 1, stemmed, sl + 1);
+    memcpy(dup + 1, stemmed, sl);
+    dup[sl + 1] = '\0';
     ctx->ExpandToken(ctx, dup, sl + 1, 0x0);  // TODO: Set proper flags here
-    if (sl != token->len || strncmp((const char *)stemmed, token->str, token->len)) {
-      ctx->ExpandToken(ctx, rm_strndup((const char *)stemmed, sl), sl, 0x0);
+    if (sl != token->len || strncmp(stemmed, token->str, token->len)) {
+      ctx->ExpandToken(ctx, rm_strndup(stemmed, sl), sl, 0x0);
     }
   }
   return REDISMODULE_OK;
@@ -602,7 +702,8 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
 
   /* TF-IDF scorer is the default scorer */
   if (ctx->RegisterScoringFunction(DEFAULT_SCORER_NAME, TFIDFScorer, NULL, NULL) ==
-      REDISEARCH_ERR) {
+          REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(DEFAULT_SCORER_NAME, TFIDFBatchScorer) == REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
 
@@ -613,12 +714,15 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
   }
 
   /* Register BM25 scorer - DEPRECATED NON-STANDARD VARIATION */
-  if (ctx->RegisterScoringFunction(BM25_SCORER_NAME, BM25Scorer, NULL, NULL) == REDISEARCH_ERR) {
+  if (ctx->RegisterScoringFunction(BM25_SCORER_NAME, BM25Scorer, NULL, NULL) == REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(BM25_SCORER_NAME, BM25BatchScorer) == REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
 
   /* Register BM25 scorer - STANDARD VARIATION */
-  if (ctx->RegisterScoringFunction(BM25_STD_SCORER_NAME, BM25StdScorer, NULL, NULL) == REDISEARCH_ERR) {
+  if (ctx->RegisterScoringFunction(BM25_STD_SCORER_NAME, BM25StdScorer, NULL, NULL) == REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(BM25_STD_SCORER_NAME, BM25StdBatchScorer) ==
+          REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
 
@@ -629,7 +733,9 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
   }
   /* Register TFIDF.DOCNORM */
   if (ctx->RegisterScoringFunction(TFIDF_DOCNORM_SCORER_NAME, TFIDFNormDocLenScorer, NULL, NULL) ==
-      REDISEARCH_ERR) {
+          REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(TFIDF_DOCNORM_SCORER_NAME, TFIDFNormDocLenBatchScorer) ==
+          REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
 
@@ -22,4 +22,8 @@
 
 int DefaultExtensionInit(RSExtensionCtx *ctx);
 
+/* An upper bound of the BM25STD score of a term, over all the documents it appears in at most
+ * `maxFreq` times */
+double BM25Std_TermUpperBound(double idf, uint32_t maxFreq);
+
 #endif
\ No newline at end of file
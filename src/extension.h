@@ -22,6 +22,8 @@ typedef struct {
   RSScoringFunction sf;
   RSFreeFunction ff;
   void *privdata;
+  // Optional, scores many results at once
+  RSBatchScoringFunction bsf;
 } ExtScoringFunctionCtx;
 
 /* Context for saving the a token expander and its free / privdata */
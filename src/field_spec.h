@@ -64,6 +64,12 @@ typedef enum {
   FieldSpec_UNF = 0x20,
   FieldSpec_WithSuffixTrie = 0x40,
   FieldSpec_UndefinedOrder = 0x80,
+  FieldSpec_NumericBKD = 0x100,
+  FieldSpec_WithNgrams = 0x200,
+  FieldSpec_NoOffsets = 0x400,
+  FieldSpec_IndexMissing = 0x800,
+  FieldSpec_WithSortIndex = 0x1000,
+  FieldSpec_WithSeparatePostings = 0x2000,
 } FieldSpecOptions;
 
 RS_ENUM_BITWISE_HELPER(FieldSpecOptions)
@@ -79,6 +85,15 @@ typedef enum {
 
 RS_ENUM_BITWISE_HELPER(TagFieldFlags)
 
+/* What the queries of a vector field asked of its index, reported by FT.INFO. The queries of
+ * the field add to them concurrently (see VectorQueryStats_Add) */
+typedef struct {
+  size_t queries;
+  size_t distances;     // The distances measured ad-hoc, for the results of a filter
+  size_t batches;       // The batches of the hybrid queries
+  size_t batchResults;  // The results of these batches
+} VectorQueryStats;
+
 /* The fieldSpec represents a single field in the document's field spec.
 Each field has a unique id that's a power of two, so we can filter fields
 by a bit mask.
@@ -87,7 +102,7 @@ typedef struct FieldSpec {
   char *name;
   char *path;
   FieldType types : 8;
-  FieldSpecOptions options : 8;
+  FieldSpecOptions options : 16;
 
   /** If this field is sortable, the sortable index */
   int16_t sortIdx;
@@ -106,6 +121,7 @@ typedef struct FieldSpec {
       VecSimParams vecSimParams;
       // expected size of vector blob.
       size_t expBlobSize;
+      VectorQueryStats queryStats;
     } vectorOpts;
     struct {
       // Geometry index parameters
@@ -133,8 +149,14 @@ typedef struct FieldSpec {
 #define FieldSpec_IsPhonetics(fs) ((fs)->options & FieldSpec_Phonetics)
 #define FieldSpec_IsIndexable(fs) (0 == ((fs)->options & FieldSpec_NotIndexable))
 #define FieldSpec_HasSuffixTrie(fs) ((fs)->options & FieldSpec_WithSuffixTrie)
+#define FieldSpec_HasNgrams(fs) ((fs)->options & FieldSpec_WithNgrams)
 #define FieldSpec_IsUndefinedOrder(fs) ((fs)->options & FieldSpec_UndefinedOrder)
 #define FieldSpec_IsUnf(fs) ((fs)->options & FieldSpec_UNF)
+#define FieldSpec_IsNumericBKD(fs) ((fs)->options & FieldSpec_NumericBKD)
+#define FieldSpec_IsNoOffsets(fs) ((fs)->options & FieldSpec_NoOffsets)
+#define FieldSpec_IndexesMissing(fs) ((fs)->options & FieldSpec_IndexMissing)
+#define FieldSpec_HasSortIndex(fs) ((fs)->options & FieldSpec_WithSortIndex)
+#define FieldSpec_HasSeparatePostings(fs) ((fs)->options & FieldSpec_WithSeparatePostings)
 
 void FieldSpec_SetSortable(FieldSpec* fs);
 void FieldSpec_Cleanup(FieldSpec* fs);
@@ -12,14 +12,15 @@
 #include "numeric_index.h"
 #include "tag_index.h"
 #include "time_sample.h"
+#include "alloc_stats.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
-#include "rwlock.h"
-#include "util/khash.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <float.h>
 #include "module.h"
 #include "rmutil/rm_assert.h"
@@ -33,6 +34,9 @@
 #define GC_WRITERFD 1
 #define GC_READERFD 0
 
+// the initial size of the shared memory region the child writes the repaired blocks to
+#define FGC_SHM_MIN_SIZE (1 << 20)
+
 typedef enum {
   // Terms have been collected
   FGC_COLLECTED,
@@ -53,6 +57,22 @@ static void FGC_updateStats(ForkGC *gc, RedisSearchCtx *sctx, size_t recordsRemo
   gc->stats.totalCollected += bytesCollected;
 }
 
+/* Whether the child should repair a block or an index spanning the ids [first, last] */
+static bool FGC_isDirty(const ForkGC *gc, t_docId first, t_docId last) {
+  return gc->fullScan || GC_HasDeletedIds(gc->dirtyIds, first, last);
+}
+
+/* Leave the dirty ids from `from` on to the next cycle, when their blocks were not repaired */
+static void FGC_requeueDirtyIds(ForkGC *gc, t_docId from) {
+  pthread_mutex_lock(&gc->deletedLock);
+  for (size_t ii = 0; ii < array_len(gc->dirtyIds); ++ii) {
+    if (gc->dirtyIds[ii] >= from) {
+      gc->deletedIds = array_append(gc->deletedIds, gc->dirtyIds[ii]);
+    }
+  }
+  pthread_mutex_unlock(&gc->deletedLock);
+}
+
 static void FGC_sendFixed(ForkGC *fgc, const void *buff, size_t len) {
   RS_LOG_ASSERT(len > 0, "buffer length cannot be 0");
   ssize_t size = write(fgc->pipefd[GC_WRITERFD], buff, len);
@@ -73,6 +93,40 @@ static void FGC_sendBuffer(ForkGC *fgc, const void *buff, size_t len) {
   }
 }
 
+/**
+ * Write the data of a repaired block to the shared memory region, if any, and send its position.
+ * The region is grown as needed, the parent maps it again when it reads past its end
+ */
+static void FGC_sendBlockData(ForkGC *fgc, const void *buff, size_t len) {
+  if (fgc->shmFd == -1 || len == 0) {
+    FGC_sendBuffer(fgc, buff, len);
+    return;
+  }
+
+  if (fgc->shmOffset + len > fgc->shmMapSize) {
+    size_t size = MAX(MAX(fgc->shmMapSize * 2, fgc->shmOffset + len), FGC_SHM_MIN_SIZE);
+    if (fgc->shmMap) {
+      munmap(fgc->shmMap, fgc->shmMapSize);
+    }
+    fgc->shmMap = NULL;
+    if (ftruncate(fgc->shmFd, size) == 0) {
+      void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fgc->shmFd, 0);
+      fgc->shmMap = map == MAP_FAILED ? NULL : map;
+    }
+    if (!fgc->shmMap) {
+      perror("GC fork: could not grow the shared memory region");
+      RedisModule_Log(NULL, "warning", "GC fork: could not grow the shared memory region, exiting");
+      exit(1);
+    }
+    fgc->shmMapSize = size;
+  }
+
+  memcpy(fgc->shmMap + fgc->shmOffset, buff, len);
+  FGC_SEND_VAR(fgc, len);
+  FGC_SEND_VAR(fgc, fgc->shmOffset);
+  fgc->shmOffset += len;
+}
+
 static int FGC_recvFixed(ForkGC *fgc, void *buf, size_t len);
 
 /**
@@ -84,6 +138,7 @@ static void FGC_sendTerminator(ForkGC *fgc) {
 }
 
 static int __attribute__((warn_unused_result)) FGC_recvFixed(ForkGC *fgc, void *buf, size_t len) {
+  fgc->stats.lastBytesReceived += len;
   while (len) {
     ssize_t nrecvd = read(fgc->pipefd[GC_READERFD], buf, len);
     if (nrecvd > 0) {
@@ -125,6 +180,49 @@ FGC_recvBuffer(ForkGC *fgc, void **buf, size_t *len) {
   return REDISMODULE_OK;
 }
 
+/**
+ * Receive the data of a repaired block, sent with FGC_sendBlockData. It is copied out of the shared
+ * memory region to a buffer of its size
+ */
+static int __attribute__((warn_unused_result))
+FGC_recvBlockData(ForkGC *fgc, void **buf, size_t *len) {
+  if (fgc->shmFd == -1) {
+    return FGC_recvBuffer(fgc, buf, len);
+  }
+
+  TRY_RECV_FIXED(fgc, len, sizeof *len);
+  if (*len == 0) {
+    *buf = NULL;
+    return REDISMODULE_OK;
+  }
+  size_t offset;
+  TRY_RECV_FIXED(fgc, &offset, sizeof offset);
+
+  if (offset + *len > fgc->shmMapSize) {
+    // the child grew the region since we mapped it
+    struct stat st;
+    if (fstat(fgc->shmFd, &st) == -1 || offset + *len > (size_t)st.st_size) {
+      return REDISMODULE_ERR;
+    }
+    if (fgc->shmMap) {
+      munmap(fgc->shmMap, fgc->shmMapSize);
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fgc->shmFd, 0);
+    if (map == MAP_FAILED) {
+      fgc->shmMap = NULL;
+      fgc->shmMapSize = 0;
+      return REDISMODULE_ERR;
+    }
+    fgc->shmMap = map;
+    fgc->shmMapSize = st.st_size;
+  }
+
+  *buf = rm_malloc(*len);
+  memcpy(*buf, fgc->shmMap + offset, *len);
+  fgc->stats.lastBytesReceived += *len;
+  return REDISMODULE_OK;
+}
+
 #define TRY_RECV_BUFFER(gc, buf, len)                   \
   if (FGC_recvBuffer(gc, buf, len) != REDISMODULE_OK) { \
     return REDISMODULE_ERR;                             \
@@ -158,8 +256,7 @@ typedef struct {
 } MSG_RepairedBlock;
 
 typedef struct {
-  void *ptr;       // Address of the buffer to free
-  uint32_t oldix;  // Old index of deleted block
+  uint32_t oldix;  // Old index of deleted block, the parent frees its data
   uint32_t _pad;   // Uninitialized reads, otherwise
 } MSG_DeletedBlock;
 
@@ -195,10 +292,13 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
       blocklist = array_append(blocklist, *blk);
       continue;
     }
+    // The entries of a numeric range are all counted for its cardinality
+    if (!params->RepairCallback && !FGC_isDirty(gc, blk->firstId, blk->lastId)) {
+      // no deleted document within the block
+      blocklist = array_append(blocklist, *blk);
+      continue;
+    }
 
-    // Capture the pointer address before the block is cleared; otherwise
-    // the pointer might be freed!
-    void *bufptr = blk->buf.data;
     int nrepaired = IndexBlock_Repair(blk, &sctx->spec->docs, idx->flags, params);
     // We couldn't repair the block - return 0
     if (nrepaired == -1) {
@@ -212,7 +312,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     if (blk->numEntries == 0) {
       // this block should be removed
       MSG_DeletedBlock *delmsg = array_ensure_tail(&deleted, MSG_DeletedBlock);
-      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .oldix = i};
+      *delmsg = (MSG_DeletedBlock){.oldix = i};
     } else {
       blocklist = array_append(blocklist, *blk);
       MSG_RepairedBlock *fixmsg = array_ensure_tail(&fixed, MSG_RepairedBlock);
@@ -254,7 +354,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     const MSG_RepairedBlock *msg = fixed + i;
     const IndexBlock *blk = blocklist + msg->newix;
     FGC_sendFixed(gc, msg, sizeof(*msg));
-    FGC_sendBuffer(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    FGC_sendBlockData(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
   }
   rv = true;
 
@@ -270,8 +370,8 @@ static void sendHeaderString(ForkGC *gc, void *arg) {
   FGC_sendBuffer(gc, iov->iov_base, iov->iov_len);
 }
 
-static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
-  TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
+static void FGC_childCollectTrieTerms(ForkGC *gc, RedisSearchCtx *sctx, Trie *terms) {
+  TrieIterator *iter = Trie_Iterate(terms, "", 0, 0, 1);
   rune *rstr = NULL;
   t_len slen = 0;
   float score = 0;
@@ -281,7 +381,7 @@ static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
     char *term = runesToStr(rstr, slen, &termLen);
     RedisModuleKey *idxKey = NULL;
     InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, strlen(term), 1, NULL, &idxKey);
-    if (idx) {
+    if (idx && FGC_isDirty(gc, idx->blocks[0].firstId, idx->lastId)) {
       struct iovec iov = {.iov_base = (void *)term, termLen};
       FGC_childRepairInvidx(gc, sctx, idx, sendHeaderString, &iov, NULL);
     }
@@ -291,23 +391,26 @@ static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
     rm_free(term);
   }
   TrieIterator_Free(iter);
+}
+
+static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
+  FGC_childCollectTrieTerms(gc, sctx, sctx->spec->terms);
+  if (sctx->spec->phonetics) {
+    FGC_childCollectTrieTerms(gc, sctx, sctx->spec->phonetics);
+  }
+  if (sctx->spec->fieldTerms) {
+    FGC_childCollectTrieTerms(gc, sctx, sctx->spec->fieldTerms);
+  }
 
   // we are done with terms
   FGC_sendTerminator(gc);
 }
 
-KHASH_MAP_INIT_INT64(cardvals, size_t)
-
 typedef struct {
   int collectIdx;
-  khash_t(cardvals) * cardVals;
+  KMVSketch cardSketch;
 } numCbCtx;
 
-typedef union {
-  uint64_t u64;
-  double d48;
-} numUnion;
-
 static void countRemain(const RSIndexResult *r, const IndexBlock *blk, void *arg) {
   numCbCtx *ctx = arg;
 
@@ -316,21 +419,7 @@ static void countRemain(const RSIndexResult *r, const IndexBlock *blk, void *arg
     return;
   }
   ctx->collectIdx = NR_CARD_CHECK;
-
-  khash_t(cardvals) *ht = NULL;
-  if ((ht = ctx->cardVals) == NULL) {
-    ht = ctx->cardVals = kh_init(cardvals);
-  }
-  RS_LOG_ASSERT(ht, "cardvals should not be NULL");
-  int added = 0;
-  numUnion u = {r->num.value};
-  khiter_t it = kh_put(cardvals, ht, u.u64, &added);
-  if (!added) {
-    // i.e. already existed
-    kh_val(ht, it)++;
-  } else {
-    kh_val(ht, it) = 1;
-  }
+  KMV_Add(&ctx->cardSketch, r->num.value);
 }
 
 typedef struct {
@@ -375,33 +464,11 @@ static FGCError recvNumericTagHeader(ForkGC *fgc, char **fieldName, size_t *fiel
   return FGC_COLLECTED;
 }
 
-static void sendKht(ForkGC *gc, const khash_t(cardvals) * kh) {
-  size_t n = 0;
-  if (!kh) {
-    FGC_SEND_VAR(gc, n);
-    return;
+static void sendCardSketch(ForkGC *gc, const KMVSketch *sketch) {
+  FGC_SEND_VAR(gc, sketch->len);
+  if (sketch->len) {
+    FGC_sendFixed(gc, sketch->samples, sketch->len * sizeof(*sketch->samples));
   }
-  n = kh_size(kh);
-  size_t nsent = 0;
-
-  double uniqueSum = 0;
-
-  FGC_SEND_VAR(gc, n);
-  for (khiter_t it = kh_begin(kh); it != kh_end(kh); ++it) {
-    if (!kh_exist(kh, it)) {
-      continue;
-    }
-    numUnion u = {kh_key(kh, it)};
-    size_t count = kh_val(kh, it);
-    CardinalityValue cu = {.value = u.d48, .appearances = count};
-    FGC_SEND_VAR(gc, cu);
-    nsent++;
-
-    uniqueSum += cu.value;
-  }
-
-  FGC_SEND_VAR(gc, uniqueSum);
-  RS_LOG_ASSERT(nsent == n, "Not all hashes has been sent");
 }
 
 static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
@@ -423,18 +490,19 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
       if (!currNode->range) {
         continue;
       }
-      numCbCtx nctx = {.cardVals = NULL, .collectIdx = 1};
       InvertedIndex *idx = currNode->range->entries;
+      if (!FGC_isDirty(gc, idx->blocks[0].firstId, idx->lastId)) {
+        continue;
+      }
+      numCbCtx nctx = {.cardSketch = {0}, .collectIdx = 1};
       IndexRepairParams params = {.RepairCallback = countRemain, .arg = &nctx};
       header.curPtr = currNode;
       bool repaired = FGC_childRepairInvidx(gc, sctx, idx, sendNumericTagHeader, &header, &params);
 
       if (repaired) {
-        sendKht(gc, nctx.cardVals);
-      }
-      if (nctx.cardVals) {
-        kh_destroy(cardvals, nctx.cardVals);
+        sendCardSketch(gc, &nctx.cardSketch);
       }
+      KMV_Clear(&nctx.cardSketch);
     }
 
     if (header.sentFieldName) {
@@ -477,6 +545,9 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
       tm_len_t len;
       InvertedIndex *value;
       while (TrieMapIterator_Next(iter, &ptr, &len, (void **)&value)) {
+        if (!FGC_isDirty(gc, value->blocks[0].firstId, value->lastId)) {
+          continue;
+        }
         header.curPtr = value;
         header.tagValue = ptr;
         header.tagLen = len;
@@ -535,10 +606,13 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
     return REDISMODULE_ERR;
   }
   Buffer *b = &binfo->blk.buf;
-  if (FGC_recvBuffer(gc, (void **)&b->data, &b->offset) != REDISMODULE_OK) {
+  if (FGC_recvBlockData(gc, (void **)&b->data, &b->offset) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
   b->cap = b->offset;
+  // Skip points are not sent, the pointer belongs to the child. They are built again when the block
+  // is applied to the index
+  binfo->blk.skips = NULL;
   return REDISMODULE_OK;
 }
 
@@ -632,6 +706,11 @@ static void checkLastBlock(ForkGC *gc, InvIdxBuffers *idxData, MSG_IndexInfo *in
     }
   }
 
+  // the garbage left in the block is collected on the next cycle
+  if (!gc->minDeniedId || lastOld->firstId < gc->minDeniedId) {
+    gc->minDeniedId = lastOld->firstId;
+  }
+
   info->ndocsCollected -= info->lastblkDocsRemoved;
   info->nbytesCollected -= info->lastblkBytesCollected;
   idxData->lastBlockIgnored = 1;
@@ -640,6 +719,8 @@ static void checkLastBlock(ForkGC *gc, InvIdxBuffers *idxData, MSG_IndexInfo *in
 
 static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_IndexInfo *info,
                                    InvertedIndex *idx) {
+  TimeSample ts;
+  TimeSampler_Start(&ts);
   checkLastBlock(gc, idxData, info, idx);
   for (size_t i = 0; i < info->nblocksRepaired; ++i) {
     MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
@@ -647,8 +728,9 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
   }
   for (size_t i = 0; i < idxData->numDelBlocks; ++i) {
     // Blocks that were deleted entirely:
+    // The data is freed the way the parent holds it, inline, mapped from a segment or on the heap
     MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
-    rm_free(delinfo->ptr);
+    indexBlock_Free(&idx->blocks[delinfo->oldix]);
   }
   TotalIIBlocks -= idxData->numDelBlocks;
   rm_free(idxData->delBlocks);
@@ -684,7 +766,9 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
     memcpy(idxData->newBlocklist + idxData->newBlocklistSize, (idx->blocks + info->nblocksOrig),
            newAddedLen * sizeof(*idxData->newBlocklist));
 
-    rm_free(idx->blocks);
+    if (!InvertedIndex_HasInlineBlock(idx)) {
+      rm_free(idx->blocks);
+    }
     idxData->newBlocklistSize += newAddedLen;
     idx->blocks = idxData->newBlocklist;
     idx->size = idxData->newBlocklistSize;
@@ -704,10 +788,24 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
   for (size_t i = 0; i < info->nblocksRepaired; ++i) {
     MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
     idx->blocks[blockModified->newix] = blockModified->blk;
+    // The last block is still written to, and is sealed when a new block is added after it
+    if (blockModified->newix + 1 < idx->size) {
+      IndexBlock_Seal(&idx->blocks[blockModified->newix], idx->flags);
+    }
+  }
+
+  // The repaired blocks are merged back up to their capacity, so deletes do not leave long chains
+  // of blocks holding a few entries each
+  if (info->nblocksRepaired) {
+    IndexRepairParams params = {0};
+    gc->stats.gcBlocksMerged += InvertedIndex_MergeBlocks(idx, &params);
+    info->nbytesCollected += params.bytesBeforFix - params.bytesAfterFix;
   }
 
   idx->numDocs -= info->ndocsCollected;
   idx->gcMarker++;
+  TimeSampler_End(&ts);
+  gc->stats.lastApplyNS += TimeSampler_DurationNS(&ts);
 }
 
 static FGCError FGC_parentHandleTerms(ForkGC *gc) {
@@ -739,9 +837,15 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc) {
 
   RedisSearchCtx sctx_ = SEARCH_CTX_STATIC(gc->ctx, sp);
   RedisSearchCtx *sctx = &sctx_;
+  sctx->lockStats = &gc->lockStats;
 
   RedisSearchCtx_LockSpecWrite(sctx);
 
+  if (sp->docIdsEpoch != gc->docIdsEpoch) {
+    status = FGC_PARENT_ERROR;
+    goto cleanup;
+  }
+
   InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, len, 1, NULL, &idxKey);
 
   if (idx == NULL) {
@@ -760,13 +864,18 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc) {
     if (sctx->spec->keysDict) {
       dictDelete(sctx->spec->keysDict, termKey);
     }
-    Trie_Delete(sctx->spec->terms, term, len);
+    Trie_Delete(IndexSpec_GetTermsTrie(sctx->spec, term), term, len);
     sctx->spec->stats.numTerms--;
     sctx->spec->stats.termsSize -= len;
+    gc->stats.gcTermsRemoved++;
+    IndexSpec_TermsChanged(sctx->spec);
     RedisModule_FreeString(sctx->redisCtx, termKey);
     if (sctx->spec->suffix) {
       deleteSuffixTrie(sctx->spec->suffix, term, len);
     }
+    if (sctx->spec->ngrams) {
+      NgramIndex_Delete(sctx->spec->ngrams, term, len);
+    }
   }
 
 cleanup:
@@ -793,31 +902,26 @@ typedef struct {
   InvIdxBuffers idxbufs;
   MSG_IndexInfo info;
 
-  arrayof(CardinalityValue) cardValsArr;
-  size_t numCardVals;
-  double uniqueSum;
+  // the cardinality sketch of the entries which remain
+  KMVSketch cardSketch;
 } NumGcInfo;
 
-static int recvCardvals(ForkGC *fgc, arrayof(CardinalityValue) *tgt, size_t *len, double *uniqueSum) {
-  if (FGC_recvFixed(fgc, len, sizeof(*len)) != REDISMODULE_OK) {
+static int recvCardSketch(ForkGC *fgc, KMVSketch *sketch) {
+  if (FGC_recvFixed(fgc, &sketch->len, sizeof(sketch->len)) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
-  *len *= sizeof(**tgt);
-  if (!*len) {
-    *tgt = NULL;
+  if (!sketch->len) {
     return REDISMODULE_OK;
   }
-  if (*tgt) {
-    rm_free(*tgt);
-  }
-  *tgt = array_new(CardinalityValue, *len);
-
-  if (FGC_recvFixed(fgc, *tgt, *len) != REDISMODULE_OK) {
+  if (sketch->len > KMV_SIZE) {
+    sketch->len = 0;
     return REDISMODULE_ERR;
   }
-  *len /= sizeof(**tgt);
-
-  if (FGC_recvFixed(fgc, uniqueSum, sizeof(*uniqueSum)) != REDISMODULE_OK) {
+  // allocated as the sketch would have grown, so values can be added to it later
+  sketch->samples = rm_malloc(KMV_MemUsage(sketch));
+  if (FGC_recvFixed(fgc, sketch->samples, sketch->len * sizeof(*sketch->samples)) !=
+      REDISMODULE_OK) {
+    KMV_Clear(sketch);
     return REDISMODULE_ERR;
   }
   return REDISMODULE_OK;
@@ -835,8 +939,7 @@ static FGCError recvNumIdx(ForkGC *gc, NumGcInfo *ninfo) {
     goto error;
   }
 
-  if (recvCardvals(gc, &ninfo->cardValsArr, &ninfo->numCardVals,
-                       &ninfo->uniqueSum) != REDISMODULE_OK) {
+  if (recvCardSketch(gc, &ninfo->cardSketch) != REDISMODULE_OK) {
     goto error;
   }
   return FGC_COLLECTED;
@@ -848,18 +951,6 @@ error:
   return FGC_CHILD_ERROR;
 }
 
-static void resetCardinality(NumGcInfo *info, NumericRangeNode *currNone) {
-  arrayof(CardinalityValue) cardValsArr = info->cardValsArr;
-
-  NumericRange *r = currNone->range;
-  array_free(r->values);
-  r->values = cardValsArr ? cardValsArr : array_new(CardinalityValue, 1);
-  info->cardValsArr = NULL;
-
-  r->unique_sum = info->uniqueSum;
-  r->card = array_len(r->values);
-}
-
 static void applyNumIdx(ForkGC *gc, RedisSearchCtx *sctx, NumGcInfo *ninfo) {
   NumericRangeNode *currNode = ninfo->node;
   InvIdxBuffers *idxbufs = &ninfo->idxbufs;
@@ -874,7 +965,10 @@ static void applyNumIdx(ForkGC *gc, RedisSearchCtx *sctx, NumGcInfo *ninfo) {
   //   NumericRangeTree_DeleteNode(rt, (currNode->range->minVal + currNode->range->maxVal) / 2);
   // }
 
-  resetCardinality(ninfo, currNode);
+  NumericRange_SetCardSketch(currNode->range, &ninfo->cardSketch);
+  if (currNode->range->column) {
+    NumericRange_RebuildColumn(currNode->range);
+  }
 }
 
 static FGCError FGC_parentHandleNumeric(ForkGC *gc) {
@@ -906,9 +1000,15 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc) {
     }
     RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
     RedisSearchCtx *sctx = &_sctx;
+    sctx->lockStats = &gc->lockStats;
 
     RedisSearchCtx_LockSpecWrite(sctx);
 
+    if (sp->docIdsEpoch != gc->docIdsEpoch) {
+      status = FGC_PARENT_ERROR;
+      goto loop_cleanup;
+    }
+
     RedisModuleString *keyName = IndexSpec_GetFormattedKeyByName(sctx->spec, fieldName, INDEXFLD_T_NUMERIC);
     rt = OpenNumericIndex(sctx, keyName, &idxKey);
 
@@ -935,30 +1035,44 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc) {
     } else {
       rm_free(ninfo.idxbufs.changedBlocks);
     }
+    // left to us if the range was not found
+    KMV_Clear(&ninfo.cardSketch);
     if (idxKey) {
       RedisModule_CloseKey(idxKey);
     }
-    RedisSearchCtx_UnlockSpec(sctx);
     if (sp) {
+      RedisSearchCtx_UnlockSpec(sctx);
       StrongRef_Release(cur_iter_spec_ref);
     }
   }
 
   rm_free(fieldName);
 
-  if (rt && rt->emptyLeaves >= rt->numRanges / 2) {
+  if (rt) {
     StrongRef spec_ref = WeakRef_Promote(gc->index);
     IndexSpec *sp = StrongRef_Get(spec_ref);
     if (!sp) {
       return FGC_SPEC_DELETED;
     }
     RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+    sctx.lockStats = &gc->lockStats;
     RedisSearchCtx_LockSpecWrite(&sctx);
-    if (gc->cleanNumericEmptyNodes) {
+    // the tree was freed with the contents of the index
+    if (sp->docIdsEpoch != gc->docIdsEpoch) {
+      RedisSearchCtx_UnlockSpec(&sctx);
+      StrongRef_Release(spec_ref);
+      return FGC_PARENT_ERROR;
+    }
+    if (gc->cleanNumericEmptyNodes && rt->emptyLeaves >= rt->numRanges / 2) {
       NRN_AddRv rv = NumericRangeTree_TrimEmptyLeaves(rt);
       rt->numRanges += rv.numRanges;
       rt->emptyLeaves = 0;
     }
+    if (gc->cleanNumericEmptyNodes) {
+      rt->numRanges += NumericRangeTree_Rebalance(rt).numRanges;
+    }
+    // the collected entries are still counted in the histogram
+    NumericRangeTree_RefreshHistogram(rt);
     RedisSearchCtx_UnlockSpec(&sctx);
     StrongRef_Release(spec_ref);
   }
@@ -1001,6 +1115,7 @@ static FGCError FGC_parentHandleTags(ForkGC *gc) {
     }
     RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
     RedisSearchCtx *sctx = &_sctx;
+    sctx->lockStats = &gc->lockStats;
 
     if (FGC_recvBuffer(gc, (void **)&tagVal, &tagValLen) != REDISMODULE_OK) {
       status = FGC_CHILD_ERROR;
@@ -1014,6 +1129,11 @@ static FGCError FGC_parentHandleTags(ForkGC *gc) {
 
     RedisSearchCtx_LockSpecWrite(sctx);
 
+    if (sp->docIdsEpoch != gc->docIdsEpoch) {
+      status = FGC_PARENT_ERROR;
+      goto loop_cleanup;
+    }
+
     keyName = IndexSpec_GetFormattedKeyByName(sctx->spec, fieldName, INDEXFLD_T_TAG);
     tagIdx = TagIndex_Open(sctx, keyName, false, &idxKey);
 
@@ -1034,9 +1154,10 @@ static FGCError FGC_parentHandleTags(ForkGC *gc) {
     // if tag value is empty, let's remove it.
     if (idx->numDocs == 0) {
       TrieMap_Delete(tagIdx->values, tagVal, tagValLen, InvertedIndex_Free);
+      tagIdx->revision++;
 
       if (tagIdx->suffix) {
-        deleteSuffixTrieMap(tagIdx->suffix, tagVal, tagValLen);
+        deleteSuffixTrie(tagIdx->suffix, tagVal, tagValLen);
       }
     }
 
@@ -1062,17 +1183,21 @@ static FGCError FGC_parentHandleTags(ForkGC *gc) {
 
 FGCError FGC_parentHandleFromChild(ForkGC *gc) {
   FGCError status = FGC_COLLECTED;
+  // the repairs are counted to the indexes they are applied to
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_OTHER);
 
-#define COLLECT_FROM_CHILD(e)               \
+#define COLLECT_FROM_CHILD(tag, e)          \
+  AllocStats_SetTag(tag);                   \
   while ((status = (e)) == FGC_COLLECTED) { \
   }                                         \
+  AllocStats_SetTag(prevTag);               \
   if (status != FGC_DONE) {                 \
     return status;                          \
   }
 
-  COLLECT_FROM_CHILD(FGC_parentHandleTerms(gc));
-  COLLECT_FROM_CHILD(FGC_parentHandleNumeric(gc));
-  COLLECT_FROM_CHILD(FGC_parentHandleTags(gc));
+  COLLECT_FROM_CHILD(ALLOC_TAG_INVIDX, FGC_parentHandleTerms(gc));
+  COLLECT_FROM_CHILD(ALLOC_TAG_NUMERIC, FGC_parentHandleNumeric(gc));
+  COLLECT_FROM_CHILD(ALLOC_TAG_TAG, FGC_parentHandleTags(gc));
 
   return status;
 }
@@ -1081,6 +1206,32 @@ FGCError FGC_parentHandleFromChild(ForkGC *gc) {
  * In future versions of Redis, Redis will have its own fork() call.
  * The following two functions wrap this functionality.
  */
+/* Create the shared memory region of a cycle, if FORK_GC_SHARED_MEMORY is set. The blocks are
+ * sent through the pipe if it could not be created */
+static void FGC_openSharedMemory(ForkGC *gc) {
+  gc->shmFd = -1;
+  gc->shmMap = NULL;
+  gc->shmMapSize = 0;
+  gc->shmOffset = 0;
+#ifdef __linux__
+  if (RSGlobalConfig.gcConfigParams.forkGc.forkGcSharedMemory) {
+    gc->shmFd = memfd_create("redisearch-fork-gc", MFD_CLOEXEC);
+  }
+#endif
+}
+
+static void FGC_closeSharedMemory(ForkGC *gc) {
+  if (gc->shmMap) {
+    munmap(gc->shmMap, gc->shmMapSize);
+    gc->shmMap = NULL;
+    gc->shmMapSize = 0;
+  }
+  if (gc->shmFd != -1) {
+    close(gc->shmFd);
+    gc->shmFd = -1;
+  }
+}
+
 static int FGC_haveRedisFork() {
   return RedisModule_Fork != NULL;
 }
@@ -1126,12 +1277,36 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
     return 1;
   }
 
+  // The documents deleted from now on are left to the next cycle
+  pthread_mutex_lock(&gc->deletedLock);
+  arrayof(t_docId) deleted = gc->deletedIds;
+  gc->deletedIds = gc->dirtyIds;
+  gc->dirtyIds = deleted;
+  pthread_mutex_unlock(&gc->deletedLock);
+  GC_SortDeletedIds(&gc->dirtyIds);
+  gc->minDeniedId = 0;
+  FGC_openSharedMemory(gc);
+  gc->stats.lastForkNS = gc->stats.lastApplyNS = gc->stats.lastLockedNS = 0;
+  gc->stats.lastBytesReceived = 0;
+  ConcurrentYieldCtl_Init(&gc->lockStats, UINT64_MAX);
+
   // We need to acquire the GIL to use the fork api
   RedisModule_ThreadSafeContextLock(ctx);
 
+  StrongRef fork_ref = WeakRef_Promote(gc->index);
+  IndexSpec *fork_sp = StrongRef_Get(fork_ref);
+  if (fork_sp) {
+    gc->docIdsEpoch = fork_sp->docIdsEpoch;
+    StrongRef_Release(fork_ref);
+  }
+
   gc->execState = FGC_STATE_SCANNING;
 
+  TimeSample forkTs;
+  TimeSampler_Start(&forkTs);
   cpid = FGC_fork(gc, ctx);  // duplicate the current process
+  TimeSampler_End(&forkTs);
+  gc->stats.lastForkNS = TimeSampler_DurationNS(&forkTs);
 
   if (cpid == -1) {
     gc->retryInterval.tv_sec = RSGlobalConfig.gcConfigParams.forkGc.forkGcRetryInterval;
@@ -1140,7 +1315,10 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
 
     close(gc->pipefd[GC_READERFD]);
     close(gc->pipefd[GC_WRITERFD]);
+    FGC_closeSharedMemory(gc);
 
+    FGC_requeueDirtyIds(gc, 0);
+    array_clear(gc->dirtyIds);
     return 1;
   }
 
@@ -1182,10 +1360,22 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
 
     gc->execState = FGC_STATE_APPLYING;
     gc->cleanNumericEmptyNodes = RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes;
-    if (FGC_parentHandleFromChild(gc) == FGC_SPEC_DELETED) {
+    FGCError status = FGC_parentHandleFromChild(gc);
+    if (status == FGC_SPEC_DELETED) {
       gcrv = 0;
+    } else if (status != FGC_DONE) {
+      // not all the repairs were applied
+      FGC_requeueDirtyIds(gc, 0);
+    } else {
+      if (gc->minDeniedId) {
+        FGC_requeueDirtyIds(gc, gc->minDeniedId);
+      }
+      gc->fullScan = 0;
     }
+    array_clear(gc->dirtyIds);
     close(gc->pipefd[GC_READERFD]);
+    FGC_closeSharedMemory(gc);
+    gc->stats.lastLockedNS = ConcurrentYieldCtl_HeldNS(&gc->lockStats, 0);
     if (FGC_haveRedisFork()) {
       // We need to acquire the GIL to use the fork api
       RedisModule_ThreadSafeContextLock(ctx);
@@ -1216,6 +1406,14 @@ static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
   gc->stats.totalMSRun += msRun;
   gc->stats.lastRunTimeMs = msRun;
 
+  StrongRef spec_ref = WeakRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (sp) {
+    LatencyStats_Record(&sp->latency, LATENCY_CMD_GC, LATENCY_PHASE_TOTAL,
+                        TimeSampler_DurationNS(&ts) / 1000000.0);
+    StrongRef_Release(spec_ref);
+  }
+
   return gcrv;
 }
 
@@ -1260,6 +1458,9 @@ static void onTerminateCb(void *privdata) {
   WeakRef_Release(gc->index);
   RedisModule_FreeThreadSafeContext(gc->ctx);
   array_free(gc->tieredIndexes);
+  array_free(gc->deletedIds);
+  array_free(gc->dirtyIds);
+  pthread_mutex_destroy(&gc->deletedLock);
   rm_free(gc);
 }
 
@@ -1274,6 +1475,8 @@ static void statsCb(RedisModule_Reply *reply, void *gcCtx) {
   REPLY_KVNUM("last_run_time_ms", (double)gc->stats.lastRunTimeMs);
   REPLY_KVNUM("gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
   REPLY_KVNUM("gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+  REPLY_KVNUM("gc_blocks_merged", (double)gc->stats.gcBlocksMerged);
+  REPLY_KVNUM("gc_terms_removed", (double)gc->stats.gcTermsRemoved);
 }
 
 #ifdef FTINFO_FOR_INFO_MODULES
@@ -1287,13 +1490,18 @@ static void statsForInfoCb(RedisModuleInfoCtx *ctx, void *gcCtx) {
   RedisModule_InfoAddFieldDouble(ctx, "last_run_time_ms", (double)gc->stats.lastRunTimeMs);
   RedisModule_InfoAddFieldDouble(ctx, "gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
   RedisModule_InfoAddFieldDouble(ctx, "gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+  RedisModule_InfoAddFieldDouble(ctx, "gc_blocks_merged", (double)gc->stats.gcBlocksMerged);
+  RedisModule_InfoAddFieldDouble(ctx, "gc_terms_removed", (double)gc->stats.gcTermsRemoved);
   RedisModule_InfoEndDictField(ctx);
 }
 #endif
 
-static void deleteCb(void *ctx) {
+static void deleteCb(void *ctx, t_docId docId) {
   ForkGC *gc = ctx;
   ++gc->deletedDocsFromLastRun;
+  pthread_mutex_lock(&gc->deletedLock);
+  gc->deletedIds = array_append(gc->deletedIds, docId);
+  pthread_mutex_unlock(&gc->deletedLock);
 }
 
 static struct timespec getIntervalCb(void *ctx) {
@@ -1311,6 +1519,11 @@ ForkGC *FGC_New(StrongRef spec_ref, GCCallbacks *callbacks) {
   forkGc->retryInterval.tv_nsec = 0;
 
   forkGc->cleanNumericEmptyNodes = RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes;
+  pthread_mutex_init(&forkGc->deletedLock, NULL);
+  forkGc->deletedIds = array_new(t_docId, 16);
+  forkGc->dirtyIds = array_new(t_docId, 16);
+  forkGc->fullScan = 1;
+  forkGc->shmFd = -1;
 #ifdef MT_BUILD
   forkGc->tieredIndexes = VecSim_GetAllTieredIndexes(spec_ref);
 #endif
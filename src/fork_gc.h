@@ -10,8 +10,11 @@
 
 #include "redismodule.h"
 #include "gc.h"
+#include "concurrent_ctx.h"
 #include "VecSim/vec_sim.h"
 
+#include <pthread.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,6 +30,18 @@ typedef struct {
 
   uint64_t gcNumericNodesMissed;
   uint64_t gcBlocksDenied;
+  // blocks merged into the blocks preceding them, once repaired
+  uint64_t gcBlocksMerged;
+  // terms whose inverted indexes were emptied, and were removed from the terms trie
+  uint64_t gcTermsRemoved;
+
+  // The costs of the last cycle to the parent, in nanoseconds: forking the child, applying its
+  // repairs, and holding the write lock of the index while doing so
+  long long lastForkNS;
+  long long lastApplyNS;
+  long long lastLockedNS;
+  // the bytes received from the child in the last cycle, through the pipe or the shared memory
+  size_t lastBytesReceived;
 } ForkGCStats;
 
 /* Internal definition of the garbage collector context (each index has one) */
@@ -47,10 +62,38 @@ typedef struct ForkGC {
   struct timespec retryInterval;
   volatile size_t deletedDocsFromLastRun;
 
+  // guards `deletedIds`, which is appended to by the writers
+  pthread_mutex_t deletedLock;
+  // the documents deleted since the last fork
+  arrayof(t_docId) deletedIds;
+  // sorted ids of the documents deleted before the current fork. The child only repairs the
+  // blocks whose ids range over one of them
+  arrayof(t_docId) dirtyIds;
+  // whether the child repairs every block. Set until a cycle completes, as the documents deleted
+  // before the index was loaded are not known
+  int fullScan;
+  // the lowest first id of the last blocks whose repair was denied in the current cycle
+  t_docId minDeniedId;
+  // the doc ids epoch of the index when the child was forked. The repairs of the child do not apply
+  // to the contents of an index compacted or evicted since
+  uint64_t docIdsEpoch;
+
+  // When FORK_GC_SHARED_MEMORY is set, the child writes the data of the repaired blocks to this
+  // shared memory region, and only their position to the pipe. -1 otherwise
+  int shmFd;
+  // the mapping of the region in the current process, and its size
+  char *shmMap;
+  size_t shmMapSize;
+  // where the child writes the next block
+  size_t shmOffset;
+
   // current value of RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes
   // This value is updated during the periodic callback execution.
   int cleanNumericEmptyNodes;
   VecSimIndex **tieredIndexes;
+
+  // the holds of the write lock of the index by the parent in the current cycle
+  ConcurrentYieldCtl lockStats;
 } ForkGC;
 
 ForkGC *FGC_New(StrongRef spec_ref, GCCallbacks *callbacks);
@@ -15,10 +15,13 @@
 typedef struct {
   KHTableEntry khBase;
   ForwardIndexEntry ent;
+  VarintVectorWriter vvw;  // the offsets of the entry, if the index stores them
 } khIdxEntry;
 
 #define ENTRIES_PER_BLOCK 32
 #define TERM_BLOCK_SIZE 128
+#define OFFSETS_BLOCK_SIZE 4096
+#define OFFSETS_INITIAL_CAP 32
 
 static int khtCompare(const KHTableEntry *entBase, const void *s, size_t n, uint32_t h) {
   khIdxEntry *ee = (khIdxEntry *)entBase;
@@ -62,18 +65,6 @@ static size_t estimtateTermCount(const Document *doc) {
   return nChars / CHARS_PER_TERM;
 }
 
-static void *vvwAlloc(void) {
-  VarintVectorWriter *vvw = rm_calloc(1, sizeof(*vvw));
-  VVW_Init(vvw, 64);
-  return vvw;
-}
-
-static void vvwFree(void *p) {
-  // printf("Releasing VVW=%p\n", p);
-  VVW_Cleanup(p);
-  rm_free(p);
-}
-
 static void ForwardIndex_InitCommon(ForwardIndex *idx, Document *doc, uint32_t idxFlags) {
   idx->idxFlags = idxFlags;
   idx->maxFreq = 0;
@@ -94,6 +85,7 @@ ForwardIndex *NewForwardIndex(Document *doc, uint32_t idxFlags) {
 
   BlkAlloc_Init(&idx->terms);
   BlkAlloc_Init(&idx->entries);
+  BlkAlloc_Init(&idx->offsets);
 
   static const KHTableProcs procs = {
       .Alloc = allocBucketEntry,
@@ -107,25 +99,17 @@ ForwardIndex *NewForwardIndex(Document *doc, uint32_t idxFlags) {
   idx->totalFreq = 0;
 
   KHTable_Init(idx->hits, &procs, &idx->entries, termCount);
-  mempool_options options = {.initialCap = termCount, .alloc = vvwAlloc, .free = vvwFree};
-  idx->vvwPool = mempool_new(&options);
 
   ForwardIndex_InitCommon(idx, doc, idxFlags);
   return idx;
 }
 
-static void clearEntry(void *elem, void *pool) {
-  khIdxEntry *ent = elem;
-  ForwardIndexEntry *fwEnt = &ent->ent;
-  if (fwEnt->vw) {
-    mempool_release(pool, fwEnt->vw);
-    fwEnt->vw = NULL;
-  }
-}
-
 void ForwardIndex_Reset(ForwardIndex *idx, Document *doc, uint32_t idxFlags) {
+  // the entries and their offset vectors own nothing outside of the block allocators, so the
+  // blocks are recycled without visiting the entries
   BlkAlloc_Clear(&idx->terms, NULL, NULL, 0);
-  BlkAlloc_Clear(&idx->entries, clearEntry, idx->vvwPool, sizeof(khIdxEntry));
+  BlkAlloc_Clear(&idx->entries, NULL, NULL, 0);
+  BlkAlloc_Clear(&idx->offsets, NULL, NULL, 0);
   KHTable_Clear(idx->hits);
   if (idx->smap) {
     SynonymMap_Free(idx->smap);
@@ -140,11 +124,11 @@ static inline int hasOffsets(const ForwardIndex *idx) {
 }
 
 void ForwardIndexFree(ForwardIndex *idx) {
-  BlkAlloc_FreeAll(&idx->entries, clearEntry, idx->vvwPool, sizeof(khIdxEntry));
+  BlkAlloc_FreeAll(&idx->entries, NULL, NULL, 0);
   BlkAlloc_FreeAll(&idx->terms, NULL, NULL, 0);
+  BlkAlloc_FreeAll(&idx->offsets, NULL, NULL, 0);
   KHTable_Free(idx->hits);
   rm_free(idx->hits);
-  mempool_destroy(idx->vvwPool);
 
   if (idx->stemmer) {
     idx->stemmer->Free(idx->stemmer);
@@ -166,6 +150,22 @@ static char *copyTempString(ForwardIndex *idx, const char *s, size_t n) {
   return dst;
 }
 
+/* Write an offset to the vector of an entry. The buffer of the vector is moved to a larger chunk of
+ * the offsets arena when it fills up, so that VVW_Write never reallocates it */
+static void writeEntryOffset(ForwardIndex *idx, VarintVectorWriter *vw, uint32_t pos) {
+  // VVW_Write reserves 16 bytes before writing
+  if (vw->buf.offset + 16 > vw->buf.cap) {
+    size_t cap = MAX(vw->buf.cap * 2, OFFSETS_INITIAL_CAP);
+    char *data = BlkAlloc_Alloc(&idx->offsets, cap, MAX(cap, OFFSETS_BLOCK_SIZE));
+    if (vw->buf.offset) {
+      memcpy(data, vw->buf.data, vw->buf.offset);
+    }
+    vw->buf.data = data;
+    vw->buf.cap = cap;
+  }
+  VVW_Write(vw, pos);
+}
+
 static khIdxEntry *makeEntry(ForwardIndex *idx, const char *s, size_t n, uint32_t h, int *isNew) {
   KHTableEntry *bb = KHTable_GetEntry(idx->hits, s, n, h, isNew);
   return (khIdxEntry *)bb;
@@ -175,6 +175,7 @@ static khIdxEntry *makeEntry(ForwardIndex *idx, const char *s, size_t n, uint32_
 #define TOKOPT_F_COPYSTR 0x02
 #define TOKOPT_F_SUFFIX_TRIE 0x04
 #define TOKOPT_F_RAW 0x08
+#define TOKOPT_F_NOOFFSETS 0x10
 
 static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t tokLen,
                                      uint32_t pos, float fieldScore, t_fieldId fieldId,
@@ -201,8 +202,8 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
     h->freq = 0;
 
     if (hasOffsets(idx)) {
-      h->vw = mempool_get(idx->vvwPool);
-      // printf("Got VVW=%p\n", h->vw);
+      h->vw = &kh->vvw;
+      h->vw->buf = (Buffer){0};
       VVW_Reset(h->vw);
     } else {
       h->vw = NULL;
@@ -225,8 +226,8 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
     // Account for this term as part of the document's length.
     idx->totalFreq += MAX(1, (uint32_t)score);
   }
-  if (h->vw) {
-    VVW_Write(h->vw, pos);
+  if (h->vw && !(options & TOKOPT_F_NOOFFSETS)) {
+    writeEntryOffset(idx, h->vw, pos);
   }
 
   // LG_DEBUG("%d) %s, token freq: %f total freq: %f\n", t.pos, t.s, h->freq, idx->totalFreq);
@@ -238,7 +239,9 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
 int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
 #define SYNONYM_BUFF_LEN 100
   const ForwardIndexTokenizerCtx *tokCtx = ctx;
-  int options = TOKOPT_F_RAW;  // this is the actual word given in the query
+  // the terms of a NOOFFSETS field are recorded without their positions
+  int fieldopts = tokCtx->noOffsets ? TOKOPT_F_NOOFFSETS : 0;
+  int options = TOKOPT_F_RAW | fieldopts;  // this is the actual word given in the query
   if (tokInfo->flags & Token_CopyRaw) {
     options |= TOKOPT_F_COPYSTR;
     options |= TOKOPT_F_SUFFIX_TRIE;
@@ -251,7 +254,7 @@ int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
   }
 
   if (tokInfo->stem) {
-    int stemopts = TOKOPT_F_STEM;
+    int stemopts = TOKOPT_F_STEM | fieldopts;
     if (tokInfo->flags & Token_CopyStem) {
       stemopts |= TOKOPT_F_COPYSTR;
     }
@@ -266,7 +269,7 @@ int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
       size_t synonym_len;
       for (int i = 0; i < array_len(t_data->groupIds); ++i) {
         ForwardIndex_HandleToken(tokCtx->idx, t_data->groupIds[i], strlen(t_data->groupIds[i]), tokInfo->pos,
-                                 tokCtx->fieldScore, tokCtx->fieldId, TOKOPT_F_COPYSTR);
+                                 tokCtx->fieldScore, tokCtx->fieldId, TOKOPT_F_COPYSTR | fieldopts);
       }
     }
   }
@@ -274,7 +277,7 @@ int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
   if (tokInfo->phoneticsPrimary) {
     ForwardIndex_HandleToken(tokCtx->idx, tokInfo->phoneticsPrimary,
                              strlen(tokInfo->phoneticsPrimary), tokInfo->pos, tokCtx->fieldScore,
-                             tokCtx->fieldId, TOKOPT_F_COPYSTR);
+                             tokCtx->fieldId, TOKOPT_F_COPYSTR | fieldopts);
   }
 
   return 0;
@@ -15,6 +15,8 @@
 #include "tokenize.h"
 #include "document.h"
 
+#include <stdbool.h>
+
 typedef struct ForwardIndexEntry {
   struct ForwardIndexEntry *next;
   t_docId docId;
@@ -40,7 +42,9 @@ typedef struct ForwardIndex {
   SynonymMap *smap;
   BlkAlloc terms;
   BlkAlloc entries;
-  mempool_t *vvwPool;
+  // The buffers of the offset vectors of the entries. They grow inside the arena, and are all
+  // recycled at once when the index is reset
+  BlkAlloc offsets;
 
 } ForwardIndex;
 
@@ -50,14 +54,17 @@ typedef struct {
   ForwardIndex *idx;
   t_fieldId fieldId;
   float fieldScore;
+  bool noOffsets;  // the field is NOOFFSETS, its term positions are not recorded
 } ForwardIndexTokenizerCtx;
 
 static inline void ForwardIndexTokenizerCtx_Init(ForwardIndexTokenizerCtx *ctx, ForwardIndex *idx,
                                                  const char *doc, VarintVectorWriter *vvw,
-                                                 t_fieldId fieldId, float score) {
+                                                 t_fieldId fieldId, float score,
+                                                 bool noOffsets) {
   ctx->idx = idx;
   ctx->fieldId = fieldId;
   ctx->fieldScore = score;
+  ctx->noOffsets = noOffsets;
   ctx->doc = doc;
   ctx->allOffsets = vvw;
 }
@@ -429,11 +429,7 @@ void FragmentList_FragmentizeIter(FragmentList *fragList, const char *doc, size_
   size_t lastByteEnd = 0;
 
   while (FragmentTermIterator_Next(iter, &curTerm)) {
-    if (curTerm == NULL) {
-      fragList->numToksSinceLastMatch++;
-      continue;
-    }
-
+    fragList->numToksSinceLastMatch += curTerm->numSkipped;
     if (curTerm->tokPos == lastTokPos) {
       continue;
     }
@@ -480,12 +476,15 @@ int FragmentTermIterator_Next(FragmentTermIterator *iter, FragmentTerm **termInf
     return 0;
   }
 
+  // Skip the byte offsets of the tokens up to the matching term at once, rather than decoding
+  // them one by one
+  iter->tmpTerm.numSkipped = 0;
   if (iter->byteIter->curPos < iter->curTokPos) {
-    iter->curByteOffset = RSByteOffsetIterator_Next(iter->byteIter);
-    // No matching term at this position.
-    // printf("IterPos=%lu. LastMatchPos=%u\n", iter->byteIter->curPos, iter->curTokPos);
-    *termInfo = NULL;
-    return 1;
+    iter->tmpTerm.numSkipped = iter->curTokPos - iter->byteIter->curPos;
+    iter->curByteOffset = RSByteOffsetIterator_SkipTo(iter->byteIter, iter->curTokPos);
+    if (iter->curByteOffset == RSBYTEOFFSET_EOF) {
+      return 0;
+    }
   }
 
   // printf("ByteOffset=%lu. LastMatchPos=%u\n", iter->curByteOffset, iter->curTokPos);
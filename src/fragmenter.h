@@ -53,6 +53,8 @@ typedef struct {
   uint32_t termId;
   uint32_t len;
   float score;
+  // Number of tokens without a match since the previous term
+  uint32_t numSkipped;
 } FragmentTerm;
 
 typedef struct {
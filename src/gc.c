@@ -10,6 +10,7 @@
 
 #include "gc.h"
 #include "fork_gc.h"
+#include "incremental_gc.h"
 #include "config.h"
 #include "redismodule.h"
 #include "rmalloc.h"
@@ -35,7 +36,13 @@ GCContext* GCContext_CreateGC(StrongRef spec_ref, uint32_t gcPolicy) {
     case GCPolicy_Fork:
       ret->gcCtx = FGC_New(spec_ref, &ret->callbacks);
       break;
+    case GCPolicy_Incremental:
+      ret->gcCtx = IGC_New(spec_ref, &ret->callbacks);
+      break;
   }
+  ret->compaction = DocIdCompaction_New(spec_ref);
+  ret->tiering = BlockTiering_New(spec_ref);
+  ret->retention = BlockRetention_New(spec_ref);
   return ret;
 }
 
@@ -64,7 +71,14 @@ static void threadCallback(void* data) {
   RedisModuleBlockedClient* bc = task->bClient;
   RedisModuleCtx* ctx = RedisModule_GetThreadSafeContext(NULL);
 
+  // the blocks of the documents deleted from the beginning of the index need no repair
+  BlockRetention_Run(gc->retention);
   int ret = gc->callbacks.periodicCallback(ctx, gc->gcCtx);
+  if (ret) {
+    // the ids freed by the collection are reclaimed right after it
+    DocIdCompaction_Run(gc->compaction);
+    BlockTiering_Run(gc->tiering);
+  }
 
   // if GC was invoke by debug command, we release the client
   // and terminate without rescheduling the task again.
@@ -93,6 +107,9 @@ static void destroyCallback(void* data) {
   GCContext* gc = data;
 
   gc->callbacks.onTerm(gc->gcCtx);
+  DocIdCompaction_Free(gc->compaction);
+  BlockTiering_Free(gc->tiering);
+  BlockRetention_Free(gc->retention);
   rm_free(gc);
 }
 
@@ -122,8 +139,13 @@ void GCContext_Stop(GCContext* gc) {
     // for fork gc debug
     RedisModule_FreeThreadSafeContext(((ForkGC *)gc->gcCtx)->ctx);
     array_free(((ForkGC *)gc->gcCtx)->tieredIndexes);
+    array_free(((ForkGC *)gc->gcCtx)->deletedIds);
+    array_free(((ForkGC *)gc->gcCtx)->dirtyIds);
     WeakRef_Release(((ForkGC *)gc->gcCtx)->index);
     free(gc->gcCtx);
+    DocIdCompaction_Free(gc->compaction);
+    BlockTiering_Free(gc->tiering);
+    BlockRetention_Free(gc->retention);
     free(gc);
     return;
   }
@@ -144,17 +166,23 @@ void GCContext_Stop(GCContext* gc) {
 
 void GCContext_RenderStats(GCContext* gc, RedisModule_Reply* reply) {
   gc->callbacks.renderStats(reply, gc->gcCtx);
+  DocIdCompaction_RenderStats(gc->compaction, reply);
+  BlockTiering_RenderStats(gc->tiering, reply);
+  BlockRetention_RenderStats(gc->retention, reply);
 }
 
 #ifdef FTINFO_FOR_INFO_MODULES
 void GCContext_RenderStatsForInfo(GCContext* gc, RedisModuleInfoCtx* ctx) {
   gc->callbacks.renderStatsForInfo(ctx, gc->gcCtx);
+  DocIdCompaction_RenderStatsForInfo(gc->compaction, ctx);
+  BlockTiering_RenderStatsForInfo(gc->tiering, ctx);
+  BlockRetention_RenderStatsForInfo(gc->retention, ctx);
 }
 #endif
 
-void GCContext_OnDelete(GCContext* gc) {
+void GCContext_OnDelete(GCContext* gc, t_docId docId) {
   if (gc->callbacks.onDelete) {
-    gc->callbacks.onDelete(gc->gcCtx);
+    gc->callbacks.onDelete(gc->gcCtx, docId);
   }
 }
 
@@ -171,6 +199,40 @@ void GCContext_ForceBGInvoke(GCContext* gc) {
   GCContext_CommonForceInvoke(gc, NULL);
 }
 
+static int cmpDocIds(const void *p1, const void *p2) {
+  t_docId d1 = *(const t_docId *)p1, d2 = *(const t_docId *)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+void GC_SortDeletedIds(arrayof(t_docId) *ids) {
+  size_t n = array_len(*ids);
+  if (!n) {
+    return;
+  }
+  qsort(*ids, n, sizeof(**ids), cmpDocIds);
+  size_t uniq = 1;
+  for (size_t ii = 1; ii < n; ++ii) {
+    if ((*ids)[ii] != (*ids)[uniq - 1]) {
+      (*ids)[uniq++] = (*ids)[ii];
+    }
+  }
+  *ids = array_trimm_len(*ids, n - uniq);
+}
+
+bool GC_HasDeletedIds(const arrayof(t_docId) ids, t_docId first, t_docId last) {
+  size_t lo = 0, hi = array_len(ids);
+  // the first id which is not below `first`
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (ids[mid] < first) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < array_len(ids) && ids[lo] <= last;
+}
+
 void GC_ThreadPoolStart() {
   if (gcThreadpool_g == NULL) {
     gcThreadpool_g = redisearch_thpool_create(GC_THREAD_POOL_SIZE, DEFAULT_PRIVILEGED_THREADS_NUM);
@@ -9,11 +9,17 @@
 #define SRC_GC_H_
 
 #include "reply.h"
+#include "redisearch.h"
 
 #include "redismodule.h"
 #include "util/dllist.h"
 #include "util/references.h"
+#include "util/arr.h"
+#include "docid_compaction.h"
+#include "block_tiering.h"
+#include "block_retention.h"
 #include <time.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,7 +31,7 @@ typedef struct GCCallbacks {
   int (*periodicCallback)(RedisModuleCtx* ctx, void* gcCtx);
   void (*renderStats)(RedisModule_Reply* reply, void* gc);
   void (*renderStatsForInfo)(RedisModuleInfoCtx* ctx, void* gc);
-  void (*onDelete)(void* ctx);
+  void (*onDelete)(void* ctx, t_docId docId);
   void (*onTerm)(void* ctx);
   struct timespec (*getInterval)(void* ctx);
 } GCCallbacks;
@@ -34,6 +40,12 @@ typedef struct GCContext {
   void* gcCtx;
   RedisModuleTimerID timerID;
   GCCallbacks callbacks;
+  // renumbers the documents once their ids are sparse, after a collection
+  DocIdCompaction* compaction;
+  // deflates the blocks which are not read, after a collection
+  BlockTiering* tiering;
+  // drops the leading blocks of deleted documents, before a collection
+  BlockRetention* retention;
 } GCContext;
 
 typedef struct GCTask {
@@ -49,10 +61,18 @@ void GCContext_RenderStats(GCContext* gc, RedisModule_Reply* ctx);
 #ifdef FTINFO_FOR_INFO_MODULES
 void GCContext_RenderStatsForInfo(GCContext* gc, RedisModuleInfoCtx* ctx);
 #endif
-void GCContext_OnDelete(GCContext* gc);
+void GCContext_OnDelete(GCContext* gc, t_docId docId);
 void GCContext_ForceInvoke(GCContext* gc, RedisModuleBlockedClient* bc);
 void GCContext_ForceBGInvoke(GCContext* gc);
 
+/* Sort the ids of the documents deleted since the last run of a GC, dropping the duplicates. A
+ * document is deleted more than once when it is updated */
+void GC_SortDeletedIds(arrayof(t_docId) *ids);
+
+/* Whether one of the sorted `ids` is within [first, last], i.e. if the block or the index spanning
+ * these ids holds entries of deleted documents */
+bool GC_HasDeletedIds(const arrayof(t_docId) ids, t_docId first, t_docId last);
+
 void GC_ThreadPoolStart();
 void GC_ThreadPoolDestroy();
 
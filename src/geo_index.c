@@ -12,8 +12,6 @@
 #include "query_node.h"
 #include "query_param.h"
 
-static double extractUnitFactor(GeoDistance unit);
-
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0], and FILTER
  * is not passed to us.
  * The GEO filter syntax is (FILTER) <property> LONG LAT DIST m|km|ft|mi
@@ -63,9 +61,9 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->property) rm_free((char *)gf->property);
   if (gf->numericFilters) {
-    for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
-      if (gf->numericFilters[i])
-        NumericFilter_Free(gf->numericFilters[i]);
+    // NULL terminated, see NewGeoRangeIterator
+    for (NumericFilter **filt = gf->numericFilters; *filt; ++filt) {
+      NumericFilter_Free(*filt);
     }
     rm_free(gf->numericFilters);
   }
@@ -119,23 +117,21 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf, Ite
     return NULL;
   }
 
-  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
+  GeoHashRange ranges[GEO_COVER_MAX_CELLS] = {{0}};
   double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
+  size_t rangesCount = calcCovering(gf->lon, gf->lat, radius_meter, ranges);
 
-  IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
+  IndexIterator **iters = rm_calloc(rangesCount, sizeof(*iters));
+  ((GeoFilter *)gf)->numericFilters = rm_calloc(rangesCount + 1, sizeof(*gf->numericFilters));
   size_t itersCount = 0;
-  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
-    if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1, true);
-      filt->fieldName = rm_strdup(gf->property);
-      filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO, config);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
+  for (size_t ii = 0; ii < rangesCount; ++ii) {
+    NumericFilter *filt = gf->numericFilters[ii] =
+            NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1, true);
+    filt->fieldName = rm_strdup(gf->property);
+    filt->geoFilter = gf;
+    struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO, config);
+    if (numIter != NULL) {
+      iters[itersCount++] = numIter;
     }
   }
 
@@ -238,7 +234,7 @@ double calcGeoHash(double lon, double lat) {
 /**
  * Convert different units to meters
  */
-static double extractUnitFactor(GeoDistance unit) {
+double extractUnitFactor(GeoDistance unit) {
   double rv;
   switch (unit) {
     case GEO_DISTANCE_M:
@@ -44,6 +44,7 @@ typedef struct GeoFilter {
   double radius;
   GeoDistance unitType;
   NumericFilter **numericFilters;
+  size_t limit;  // when yielding the distance, keep only this many nearest documents (0 for all)
 } GeoFilter;
 
 /* Create a geo filter from parsed strings and numbers */
@@ -70,3 +71,5 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf, Ite
 #define INVALID_GEOHASH -1.0
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
+/* The number of meters in a distance unit */
+double extractUnitFactor(GeoDistance unit);
@@ -0,0 +1,308 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "geo_nearest_reader.h"
+#include "doc_table.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/minmax.h"
+
+typedef struct {
+  t_docId docId;
+  double distance;
+} GeoNearestEntry;
+
+static int cmpDistance(const void *p1, const void *p2) {
+  const GeoNearestEntry *e1 = p1, *e2 = p2;
+  if (e1->distance != e2->distance) {
+    return e1->distance < e2->distance ? -1 : 1;
+  }
+  return e1->docId < e2->docId ? -1 : e1->docId > e2->docId ? 1 : 0;
+}
+
+static int cmpDocId(const void *p1, const void *p2) {
+  const GeoNearestEntry *e1 = p1, *e2 = p2;
+  return e1->docId < e2->docId ? -1 : e1->docId > e2->docId ? 1 : 0;
+}
+
+/* The distance (in meters) of the nearest point of a geo range hit inside the filter. A hit of
+ * several ranges is a union of numeric results, one per point of the document */
+static bool hitDistance(const GeoFilter *gf, const RSIndexResult *r, double *distance) {
+  if (r->type == RSResultType_Numeric) {
+    return isWithinRadius(gf, r->num.value, distance);
+  }
+  bool found = false;
+  for (size_t i = 0; i < r->agg.numChildren; ++i) {
+    double d;
+    if (hitDistance(gf, r->agg.children[i], &d) && (!found || d < *distance)) {
+      *distance = d;
+      found = true;
+    }
+  }
+  return found;
+}
+
+/* Scan a ring of `radius` around the center of the filter, and collect the documents in it that
+ * the child matches */
+static void GNI_ScanRing(GeoNearestIterator *it, double radius) {
+  const GeoFilter *gf = it->gf;
+  GeoFilter *ring = NewGeoFilter(gf->lon, gf->lat, radius, NULL, 0);
+  ring->unitType = gf->unitType;
+  ring->property = rm_strdup(gf->property);
+  double unitFactor = extractUnitFactor(gf->unitType);
+
+  array_clear(it->docIds);
+  array_clear(it->distances);
+  IndexIterator *geoIt = NewGeoRangeIterator(it->sctx, ring, it->config);
+  IndexIterator *child = it->child;
+  if (child) {
+    child->Rewind(child->ctx);
+  }
+  t_docId childId = 0;
+  RSIndexResult *hit, *childHit;
+  while (geoIt && geoIt->Read(geoIt->ctx, &hit) != INDEXREAD_EOF) {
+    double distance;
+    if (!hitDistance(ring, hit, &distance)) {
+      continue;
+    }
+    distance /= unitFactor;
+    size_t n = array_len(it->docIds);
+    if (n && it->docIds[n - 1] == hit->docId) {
+      // another point of a multi value field
+      it->distances[n - 1] = MIN(it->distances[n - 1], distance);
+      continue;
+    }
+
+    if (child) {
+      if (childId < hit->docId) {
+        if (child->SkipTo(child->ctx, hit->docId, &childHit) == INDEXREAD_EOF) {
+          break;
+        }
+        childId = childHit->docId;
+      }
+      if (childId != hit->docId) {
+        continue;
+      }
+    }
+
+    const RSDocumentMetadata *dmd = DocTable_Borrow(&it->sctx->spec->docs, hit->docId);
+    if (!dmd) {
+      continue;
+    }
+    DMD_Return(dmd);
+    array_append(it->docIds, hit->docId);
+    array_append(it->distances, distance);
+  }
+
+  if (geoIt) {
+    geoIt->Free(geoIt);
+  }
+  GeoFilter_Free(ring);
+  it->numRings++;
+}
+
+/* Collect the documents to yield. Any document beyond a ring is farther than all the documents
+ * inside of it, so once a ring holds `limit` documents the nearest ones are among them */
+static void GNI_Collect(GeoNearestIterator *it) {
+  const GeoFilter *gf = it->gf;
+  double radius = it->limit ? gf->radius / (1 << GEO_NEAREST_RINGS) : gf->radius;
+  while (1) {
+    GNI_ScanRing(it, radius);
+    if (radius >= gf->radius || array_len(it->docIds) >= it->limit) {
+      break;
+    }
+    radius = MIN(radius * 2, gf->radius);
+  }
+
+  size_t n = array_len(it->docIds);
+  if (it->limit && n > it->limit) {
+    GeoNearestEntry *entries = rm_malloc(n * sizeof(*entries));
+    for (size_t i = 0; i < n; ++i) {
+      entries[i] = (GeoNearestEntry){.docId = it->docIds[i], .distance = it->distances[i]};
+    }
+    qsort(entries, n, sizeof(*entries), cmpDistance);
+    qsort(entries, it->limit, sizeof(*entries), cmpDocId);
+    for (size_t i = 0; i < it->limit; ++i) {
+      it->docIds[i] = entries[i].docId;
+      it->distances[i] = entries[i].distance;
+    }
+    it->docIds = array_trimm_len(it->docIds, n - it->limit);
+    it->distances = array_trimm_len(it->distances, n - it->limit);
+    rm_free(entries);
+  }
+
+  if (it->child) {
+    it->child->Rewind(it->child->ctx);
+  }
+  it->collected = true;
+  if (!array_len(it->docIds)) {
+    IITER_SET_EOF(&it->base);
+  }
+}
+
+/* Yield the document at `idx`, along with the child result for it if there is a child */
+static int GNI_Yield(GeoNearestIterator *it, size_t idx, RSIndexResult **hit) {
+  RSIndexResult *res = it->base.current;
+  t_docId docId = it->lastDocId = it->docIds[idx];
+  double distance = it->distances[idx];
+  it->curIndex = idx + 1;
+  if (it->curIndex == array_len(it->docIds)) {
+    IITER_SET_EOF(&it->base);
+  }
+
+  if (it->child) {
+    // the child matched the document while collecting, so it finds it again
+    RSIndexResult *childHit;
+    int rc = it->child->SkipTo(it->child->ctx, docId, &childHit);
+    RS_LOG_ASSERT(rc == INDEXREAD_OK, "child must match the collected document");
+    AggregateResult_Reset(res);
+    it->metricResult->docId = docId;
+    it->metricResult->num.value = distance;
+    AggregateResult_AddChild(res, it->metricResult);
+    AggregateResult_AddChild(res, childHit);
+  } else {
+    ResultMetrics_Reset(res);
+    res->docId = docId;
+    res->num.value = distance;
+  }
+  if (it->base.ownKey) {
+    ResultMetrics_Add(res, it->base.ownKey, RS_NumVal(distance));
+  }
+  *hit = res;
+  return INDEXREAD_OK;
+}
+
+static int GNI_Read(void *ctx, RSIndexResult **hit) {
+  GeoNearestIterator *it = ctx;
+  if (!it->collected) {
+    GNI_Collect(it);
+  }
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  return GNI_Yield(it, it->curIndex, hit);
+}
+
+static int GNI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  GeoNearestIterator *it = ctx;
+  if (!it->collected) {
+    GNI_Collect(it);
+  }
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+
+  // binary search for the first document not smaller than docId
+  size_t lo = it->curIndex, hi = array_len(it->docIds);
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (it->docIds[mid] < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == array_len(it->docIds)) {
+    it->curIndex = lo;
+    IITER_SET_EOF(&it->base);
+    return INDEXREAD_EOF;
+  }
+  GNI_Yield(it, lo, hit);
+  return (*hit)->docId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+static size_t GNI_NumEstimated(void *ctx) {
+  GeoNearestIterator *it = ctx;
+  if (it->collected) {
+    return array_len(it->docIds);
+  }
+  if (it->limit) {
+    return it->limit;
+  }
+  return it->child ? it->child->NumEstimated(it->child->ctx) : it->sctx->spec->docs.size;
+}
+
+static int GNI_HasNext(void *ctx) {
+  GeoNearestIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static t_docId GNI_LastDocId(void *ctx) {
+  GeoNearestIterator *it = ctx;
+  return it->lastDocId;
+}
+
+static void GNI_Rewind(void *ctx) {
+  GeoNearestIterator *it = ctx;
+  it->curIndex = 0;
+  it->lastDocId = 0;
+  if (it->child) {
+    it->child->Rewind(it->child->ctx);
+  }
+  if (!it->collected || array_len(it->docIds)) {
+    IITER_CLEAR_EOF(&it->base);
+  }
+}
+
+static void GNI_Abort(void *ctx) {
+  GeoNearestIterator *it = ctx;
+  IITER_SET_EOF(&it->base);
+  if (it->child) {
+    it->child->Abort(it->child->ctx);
+  }
+}
+
+static void GNI_Free(IndexIterator *self) {
+  GeoNearestIterator *it = self->ctx;
+  if (it == NULL) {
+    return;
+  }
+  if (it->child) {
+    it->child->Free(it->child);
+    IndexResult_Free(it->metricResult);
+  }
+  IndexResult_Free(it->base.current);
+  array_free(it->docIds);
+  array_free(it->distances);
+  rm_free(it);
+}
+
+IndexIterator *NewGeoNearestIterator(RedisSearchCtx *sctx, const GeoFilter *gf,
+                                     IndexIterator *child, size_t limit, IteratorsConfig *config) {
+  GeoNearestIterator *gi = rm_calloc(1, sizeof(*gi));
+  gi->sctx = sctx;
+  gi->gf = gf;
+  gi->config = config;
+  gi->child = child;
+  gi->limit = limit;
+  gi->docIds = array_new(t_docId, limit ? limit : 16);
+  gi->distances = array_new(double, limit ? limit : 16);
+  gi->base.isValid = 1;
+
+  IndexIterator *ri = &gi->base;
+  ri->ctx = gi;
+  ri->type = GEO_NEAREST_ITERATOR;
+  ri->mode = MODE_SORTED;
+  ri->ownKey = NULL;
+  if (child) {
+    ri->current = NewHybridResult();
+    gi->metricResult = NewMetricResult();
+  } else {
+    ri->current = NewMetricResult();
+  }
+
+  ri->Read = GNI_Read;
+  ri->SkipTo = GNI_SkipTo;
+  ri->Rewind = GNI_Rewind;
+  ri->Free = GNI_Free;
+  ri->HasNext = GNI_HasNext;
+  ri->ReadBatch = NULL;
+  ri->NumEstimated = ri->Len = GNI_NumEstimated;
+  ri->Abort = GNI_Abort;
+  ri->LastDocId = GNI_LastDocId;
+  ri->GetCriteriaTester = NULL;
+  return ri;
+}
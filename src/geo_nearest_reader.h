@@ -0,0 +1,49 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "index_iterator.h"
+#include "geo_index.h"
+#include "search_ctx.h"
+
+// The first ring scanned for the nearest documents is 2^GEO_NEAREST_RINGS times smaller than the
+// radius of the filter, each following ring doubles it.
+#define GEO_NEAREST_RINGS 4
+
+typedef struct {
+  IndexIterator base;
+  RedisSearchCtx *sctx;
+  const GeoFilter *gf;
+  IteratorsConfig *config;
+  IndexIterator *child;         // other filters of the query, NULL if there are none
+  size_t limit;                 // number of nearest documents to yield, 0 for all of them
+
+  bool collected;               // the documents are collected on the first Read/SkipTo
+  t_docId *docIds;              // the nearest documents, sorted by id
+  double *distances;            // distances[i] is the distance of docIds[i], in the filter's unit
+  size_t curIndex;              // index of the next document to yield
+  t_docId lastDocId;
+  size_t numRings;              // number of rings scanned until enough documents were found
+
+  RSIndexResult *metricResult;  // holds the distance when yielding along with a child result
+} GeoNearestIterator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create an iterator over the documents matching both a geo filter and `child` (if not NULL),
+ * yielding their distance from the center of the filter. With a `limit` it yields only the
+ * `limit` nearest of them, found by scanning progressively larger rings around the center
+ * until enough documents match. The documents are yielded sorted by id. Takes ownership of
+ * `child` */
+IndexIterator *NewGeoNearestIterator(RedisSearchCtx *sctx, const GeoFilter *gf,
+                                     IndexIterator *child, size_t limit, IteratorsConfig *config);
+
+#ifdef __cplusplus
+}
+#endif
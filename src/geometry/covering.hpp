@@ -0,0 +1,120 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include <bitset>                       // std::bitset
+#include <cstddef>                      // std::size_t
+#include <utility>                      // std::pair
+#include <algorithm>                    // std::clamp
+#include <boost/geometry/geometry.hpp>  // duh...
+
+namespace RediSearch {
+namespace GeoShape {
+
+namespace bg = boost::geometry;
+namespace bgm = bg::model;
+
+// the grid sizes of the coverings of the indexed polygons and of the query polygons
+constexpr std::size_t doc_covering_grid = 8;
+constexpr std::size_t query_covering_grid = 16;
+// polygons with fewer points are checked exactly, which is about as cheap as their covering
+constexpr std::size_t covering_min_points = 64;
+
+/* A grid of NxN cells over the bounding rect of a polygon, telling the cells strictly inside of it
+ * (interior) and the ones which do not touch it (exterior) from the ones crossing its boundary.
+ * A geometry whose rect only falls in interior cells is within the polygon, and one whose rect
+ * only falls in exterior cells is disjoint from it, so only the geometries reaching boundary cells
+ * need an exact check */
+template <typename CoordSystem, std::size_t N>
+class Covering {
+ public:
+  using point_type = bgm::point<double, 2, CoordSystem>;
+  using rect_type = bgm::box<point_type>;
+
+  enum class Relation { INTERIOR, EXTERIOR, BOUNDARY };
+
+ private:
+  rect_type mbr_;
+  std::bitset<N * N> interior_;
+  std::bitset<N * N> exterior_;
+
+ public:
+  template <typename Polygon>
+  explicit Covering(Polygon const& poly) : mbr_{bg::return_envelope<rect_type>(poly)} {
+    for (std::size_t x = 0; x < N; ++x) {
+      for (std::size_t y = 0; y < N; ++y) {
+        auto cell = cell_rect(x, y);
+        if (bg::disjoint(cell, poly)) {
+          exterior_.set(x * N + y);
+          continue;
+        }
+        // grown a little, the cell may not touch the boundary of the polygon from the inside
+        auto eps = (bg::get<bg::max_corner, 0>(cell) - bg::get<bg::min_corner, 0>(cell)) * 1e-6;
+        bg::set<bg::min_corner, 0>(cell, bg::get<bg::min_corner, 0>(cell) - eps);
+        bg::set<bg::min_corner, 1>(cell, bg::get<bg::min_corner, 1>(cell) - eps);
+        bg::set<bg::max_corner, 0>(cell, bg::get<bg::max_corner, 0>(cell) + eps);
+        bg::set<bg::max_corner, 1>(cell, bg::get<bg::max_corner, 1>(cell) + eps);
+        // boost relates rings to polygons, not boxes
+        auto ring = bgm::ring<point_type>{};
+        bg::convert(cell, ring);
+        if (bg::within(ring, poly)) {
+          interior_.set(x * N + y);
+        }
+      }
+    }
+  }
+
+  /* The relation of a rect, and so of any geometry inside of it, to the polygon */
+  [[nodiscard]] auto relate(rect_type const& rect) const -> Relation {
+    if (bg::disjoint(rect, mbr_)) {
+      return Relation::EXTERIOR;
+    }
+    // the parts of the rect outside of the bounding rect are not in the polygon
+    bool in = bg::covered_by(rect, mbr_);
+    bool out = true;
+    auto [x0, x1] = cell_range<0>(rect);
+    auto [y0, y1] = cell_range<1>(rect);
+    for (auto x = x0; x <= x1 && (in || out); ++x) {
+      for (auto y = y0; y <= y1 && (in || out); ++y) {
+        in = in && interior_.test(x * N + y);
+        out = out && exterior_.test(x * N + y);
+      }
+    }
+    return in ? Relation::INTERIOR : out ? Relation::EXTERIOR : Relation::BOUNDARY;
+  }
+
+ private:
+  template <std::size_t D>
+  auto cell_of(double pos) const -> std::size_t {
+    auto lo = bg::get<bg::min_corner, D>(mbr_);
+    auto hi = bg::get<bg::max_corner, D>(mbr_);
+    if (!(lo < hi)) {
+      return 0;
+    }
+    auto cell = (std::clamp(pos, lo, hi) - lo) / (hi - lo) * N;
+    return std::min(static_cast<std::size_t>(cell), N - 1);
+  }
+
+  template <std::size_t D>
+  auto cell_range(rect_type const& rect) const -> std::pair<std::size_t, std::size_t> {
+    return {cell_of<D>(bg::get<bg::min_corner, D>(rect)),
+            cell_of<D>(bg::get<bg::max_corner, D>(rect))};
+  }
+
+  auto cell_rect(std::size_t x, std::size_t y) const -> rect_type {
+    auto at = [&]<std::size_t D>(std::size_t i) -> double {
+      auto lo = bg::get<bg::min_corner, D>(mbr_);
+      auto hi = bg::get<bg::max_corner, D>(mbr_);
+      return i == N ? hi : lo + (hi - lo) * i / N;
+    };
+    return rect_type{point_type{at.template operator()<0>(x), at.template operator()<1>(y)},
+                     point_type{at.template operator()<0>(x + 1), at.template operator()<1>(y + 1)}};
+  }
+};
+
+}  // namespace GeoShape
+}  // namespace RediSearch
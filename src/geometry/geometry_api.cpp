@@ -73,6 +73,12 @@ namespace {
   std::size_t Index_##variant##_Report(const GeometryIndex *idx) {                          \
     return std::get<rtree_ptr<variant>>(idx->index)->report();                              \
   }                                                                                         \
+  void Index_##variant##_StartBulkLoad(GeometryIndex *idx) {                                \
+    std::get<rtree_ptr<variant>>(idx->index)->startBulkLoad();                              \
+  }                                                                                         \
+  void Index_##variant##_FinishBulkLoad(GeometryIndex *idx) {                               \
+    std::get<rtree_ptr<variant>>(idx->index)->finishBulkLoad();                             \
+  }                                                                                         \
   constexpr GeometryApi GeometryApi_##variant = {                                           \
       .freeIndex = Index_##variant##_Free,                                                  \
       .addGeomStr = Index_##variant##_Insert,                                               \
@@ -80,6 +86,8 @@ namespace {
       .query = Index_##variant##_Query,                                                     \
       .dump = Index_##variant##_Dump,                                                       \
       .report = Index_##variant##_Report,                                                   \
+      .startBulkLoad = Index_##variant##_StartBulkLoad,                                     \
+      .finishBulkLoad = Index_##variant##_FinishBulkLoad,                                   \
   };                                                                                        \
   auto Index_##variant##_New()->GeometryIndex * {                                           \
     return new GeometryIndex{&GeometryApi_##variant, std::make_unique<RTree<variant>>()};   \
@@ -28,6 +28,9 @@ struct GeometryApi {
                           const char *str, size_t len, RedisModuleString **err_msg);
   void (*dump)(const GeometryIndex *index, RedisModuleCtx *ctx);
   size_t (*report)(const GeometryIndex *index);
+  // Buffer the geometries added until `finishBulkLoad`, which packs them all into the index at once
+  void (*startBulkLoad)(GeometryIndex *index);
+  void (*finishBulkLoad)(GeometryIndex *index);
 };
 
 #ifdef __cplusplus
@@ -7,16 +7,28 @@
 #include "query_iterator.hpp"
 
 #include <utility>    // std::move
-#include <iterator>   // ranges::distance
-#include <algorithm>  // ranges::sort, ranges::lower_bound
+#include <algorithm>  // ranges::push_heap, ranges::pop_heap, lower_bound
 
 namespace RediSearch {
 namespace GeoShape {
 
-QueryIterator::QueryIterator(container_type &&docs)
-    : base_{init_base()}, iter_{std::move(docs)}, index_{0} {
+namespace {
+// min-heap by id
+constexpr auto greater_id = [](auto const &a, auto const &b) -> bool { return a.id > b.id; };
+}  // anonymous namespace
+
+QueryIterator::QueryIterator(runs_type &&runs, filter_type &&filter)
+    : base_{init_base()},
+      runs_{std::move(runs)},
+      heap_{heap_type::allocator_type{runs_.get_allocator()}},
+      filter_{std::move(filter)},
+      len_{0} {
   base_.ctx = this;
-  std::ranges::sort(iter_);
+  heap_.reserve(runs_.size());
+  for (auto const &run : runs_) {
+    len_ += run.size();
+  }
+  rewind();
 }
 QueryIterator::~QueryIterator() noexcept {
   IndexResult_Free(base_.current);
@@ -26,34 +38,53 @@ auto QueryIterator::base() noexcept -> IndexIterator * {
   return &base_;
 }
 
+void QueryIterator::push(std::size_t run, std::size_t pos) {
+  if (pos < runs_[run].size()) {
+    heap_.push_back(head_type{runs_[run][pos], run, pos});
+    std::ranges::push_heap(heap_, greater_id);
+  }
+}
+auto QueryIterator::next() -> int {
+  while (!heap_.empty()) {
+    std::ranges::pop_heap(heap_, greater_id);
+    auto const head = heap_.back();
+    heap_.pop_back();
+    push(head.run, head.pos + 1);
+    if (filter_(head.id)) {
+      base_.current->docId = head.id;
+      return INDEXREAD_OK;
+    }
+  }
+  abort();
+  return INDEXREAD_EOF;
+}
+
 int QueryIterator::read(RSIndexResult *&hit) noexcept {
-  if (!base_.isValid || !has_next()) {
+  if (!base_.isValid || next() == INDEXREAD_EOF) {
     return INDEXREAD_EOF;
   }
-
-  base_.current->docId = iter_[index_++];
   hit = base_.current;
   return INDEXREAD_OK;
 }
 int QueryIterator::skip_to(t_docId docId, RSIndexResult *&hit) {
-  if (!base_.isValid || !has_next()) {
+  if (!base_.isValid) {
     return INDEXREAD_EOF;
   }
-  if (docId > iter_.back()) {
-    base_.isValid = false;
-    return INDEXREAD_EOF;
+  // move the runs which are behind to their first candidate not smaller than docId
+  while (!heap_.empty() && heap_.front().id < docId) {
+    std::ranges::pop_heap(heap_, greater_id);
+    auto const head = heap_.back();
+    heap_.pop_back();
+    auto const &run = runs_[head.run];
+    auto it = std::lower_bound(run.cbegin() + head.pos + 1, run.cend(), docId);
+    push(head.run, it - run.cbegin());
   }
-
-  auto it = std::ranges::lower_bound(iter_.cbegin() + index_, iter_.cend(), docId);
-  index_ = std::ranges::distance(iter_.cbegin(), it + 1);
-  if (!has_next()) {
-    abort();
+  if (next() == INDEXREAD_EOF) {
+    return INDEXREAD_EOF;
   }
-
-  base_.current->docId = *it;
   hit = base_.current;
 
-  if (*it == docId) {
+  if (current() == docId) {
     return INDEXREAD_OK;
   }
   return INDEXREAD_NOTFOUND;
@@ -62,10 +93,10 @@ t_docId QueryIterator::current() const noexcept {
   return base_.current->docId;
 }
 int QueryIterator::has_next() const noexcept {
-  return index_ < len();
+  return !heap_.empty();
 }
 std::size_t QueryIterator::len() const noexcept {
-  return iter_.size();
+  return len_;
 }
 void QueryIterator::abort() noexcept {
   base_.isValid = false;
@@ -73,7 +104,10 @@ void QueryIterator::abort() noexcept {
 void QueryIterator::rewind() noexcept {
   base_.isValid = true;
   base_.current->docId = 0;
-  index_ = 0;
+  heap_.clear();
+  for (std::size_t run = 0; run < runs_.size(); ++run) {
+    push(run, 0);
+  }
 }
 
 namespace {
@@ -101,6 +135,30 @@ void QIter_Abort(void *ctx) {
 void QIter_Rewind(void *ctx) {
   static_cast<QueryIterator *>(ctx)->rewind();
 }
+
+// Checks documents exactly, without going through the candidates
+struct QueryCriteriaTester : IndexCriteriaTester {
+  QueryIterator::filter_type filter_;
+
+  void *operator new(std::size_t) noexcept {
+    using alloc_type = Allocator::Allocator<QueryCriteriaTester>;
+    return static_cast<void *>(alloc_type::allocate(1));
+  }
+  void operator delete(void *p) noexcept {
+    using alloc_type = Allocator::Allocator<QueryCriteriaTester>;
+    alloc_type::deallocate(static_cast<QueryCriteriaTester *>(p), 1);
+  }
+};
+int QIter_Test(IndexCriteriaTester *ct, t_docId id) {
+  return static_cast<QueryCriteriaTester *>(ct)->filter_(id);
+}
+void QIter_TesterFree(IndexCriteriaTester *ct) {
+  delete static_cast<QueryCriteriaTester *>(ct);
+}
+auto QIter_GetCriteriaTester(void *ctx) -> IndexCriteriaTester * {
+  auto const *it = static_cast<QueryIterator const *>(ctx);
+  return new QueryCriteriaTester{{.Test = QIter_Test, .Free = QIter_TesterFree}, it->filter_};
+}
 }  // anonymous namespace
 
 IndexIterator QueryIterator::init_base() {
@@ -111,7 +169,7 @@ IndexIterator QueryIterator::init_base() {
       .mode = MODE_SORTED,
       .type = ID_LIST_ITERATOR,
       .NumEstimated = QIter_Len,
-      .GetCriteriaTester = nullptr,
+      .GetCriteriaTester = QIter_GetCriteriaTester,
       .Read = QIter_Read,
       .SkipTo = QIter_SkipTo,
       .LastDocId = QIter_LastDocId,
@@ -129,7 +187,7 @@ void *QueryIterator::operator new(std::size_t, std::size_t& alloc) noexcept {
 }
 void QueryIterator::operator delete(QueryIterator *ptr, std::destroying_delete_t) noexcept {
   using alloc_type = Allocator::TrackingAllocator<QueryIterator>;
-  auto alloc = alloc_type{ptr->iter_.get_allocator()};
+  auto alloc = alloc_type{ptr->runs_.get_allocator()};
   ptr->~QueryIterator();
   alloc.deallocate(ptr, 1);
 }
@@ -9,26 +9,35 @@
 #include "../index_iterator.h"
 #include "allocator/tracking_allocator.hpp"
 
-#include <vector>  // std::vector
-#include <ranges>  // ranges::input_range, ranges::begin, ranges::end
+#include <vector>      // std::vector
+#include <functional>  // std::function
 
 namespace RediSearch {
 namespace GeoShape {
+/* Iterates the candidates of a query in id order. The candidates only match the query's
+ * bounding rect, they are checked exactly against the query geometry as they are reached, so
+ * the ones skipped over by an intersection are never checked */
 struct QueryIterator {
   using alloc_type = RediSearch::Allocator::TrackingAllocator<t_docId>;
   using container_type = std::vector<t_docId, alloc_type>;
+  using runs_type = std::vector<container_type, Allocator::TrackingAllocator<container_type>>;
+  using filter_type = std::function<bool(t_docId)>;
+
+  struct head_type {
+    t_docId id;
+    std::size_t run;
+    std::size_t pos;
+  };
+  using heap_type = std::vector<head_type, Allocator::TrackingAllocator<head_type>>;
 
   IndexIterator base_;
-  container_type iter_;
-  std::size_t index_;
+  runs_type runs_;      // the candidates of each tile of the query window, sorted
+  heap_type heap_;      // the next candidate of each run, merged in id order
+  filter_type filter_;  // exact check of a candidate
+  std::size_t len_;
 
   explicit QueryIterator() = delete;
-  explicit QueryIterator(container_type &&docs);
-  template <std::ranges::input_range R>  // the elements of the range must be convertible to t_docId
-    requires std::is_convertible_v<t_docId, std::decay_t<decltype(*std::declval<R>().begin())>>
-  explicit QueryIterator(R &&range, std::size_t &alloc)
-      : QueryIterator(container_type{range.begin(), range.end(), alloc_type{alloc}}) {
-  }
+  explicit QueryIterator(runs_type &&runs, filter_type &&filter);
 
   /* rule of 5 */
   QueryIterator(QueryIterator const &) = delete;
@@ -51,6 +60,10 @@ struct QueryIterator {
 
   void *operator new(std::size_t, std::size_t &alloc) noexcept;
   void operator delete(QueryIterator *ptr, std::destroying_delete_t) noexcept;
+
+ private:
+  void push(std::size_t run, std::size_t pos);
+  auto next() -> int;
 };
 
 }  // namespace GeoShape
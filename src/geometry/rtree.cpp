@@ -8,7 +8,8 @@
 
 #include <string>     // std::string, std::char_traits
 #include <sstream>    // std::stringstream
-#include <algorithm>  // ranges::for_each, views::transform
+#include <optional>   // std::optional
+#include <algorithm>  // ranges::for_each, ranges::sort, clamp
 #include <exception>  // std::exception
 
 namespace RediSearch {
@@ -85,11 +86,29 @@ auto from_wkt(std::string_view wkt) -> geom_type {
   return geom;
 }
 
-template <typename cs, typename query_results = RTree<cs>::query_results>
-auto generate_query_iterator(query_results&& results, std::size_t& alloc) -> IndexIterator* {
-  auto geometry_query_iterator = new (alloc) QueryIterator{
-      results | std::views::transform([](auto&& doc) -> t_docId { return get_id<cs>(doc); }),
-      alloc};
+// the query window is split into query_tiles x query_tiles tiles, each one holding a sorted run of
+// the candidates whose rect starts in it
+constexpr std::size_t query_tiles = 4;
+
+template <typename cs, typename rect_type = RTree<cs>::rect_type>
+auto get_tile(rect_type const& rect, rect_type const& window) -> std::size_t {
+  auto tile_on = [&]<std::size_t D>() -> std::size_t {
+    auto lo = bg::get<bg::min_corner, D>(window);
+    auto hi = bg::get<bg::max_corner, D>(window);
+    if (!(lo < hi)) {
+      // degenerate or wrapping around the antimeridian, a single tile
+      return 0;
+    }
+    auto pos = std::clamp(bg::get<bg::min_corner, D>(rect), lo, hi);
+    return std::min(static_cast<std::size_t>((pos - lo) / (hi - lo) * query_tiles), query_tiles - 1);
+  };
+  return tile_on.template operator()<0>() * query_tiles + tile_on.template operator()<1>();
+}
+
+template <typename cs, typename query_runs = RTree<cs>::query_runs>
+auto generate_query_iterator(query_runs&& runs, QueryIterator::filter_type&& filter,
+                             std::size_t& alloc) -> IndexIterator* {
+  auto geometry_query_iterator = new (alloc) QueryIterator{std::move(runs), std::move(filter)};
   return geometry_query_iterator->base();
 }
 
@@ -108,6 +127,32 @@ constexpr auto geometry_reporter = [](auto&& geom) -> std::size_t {
   }
 };
 
+// the covering of a polygon large enough to be worth one
+template <typename cs, typename covering_type, typename geom_type = RTree<cs>::geom_type>
+auto make_covering(geom_type const& geom) -> std::optional<covering_type> {
+  using poly_type = typename RTree<cs>::poly_type;
+  if constexpr (std::is_same_v<cs, Cartesian>) {
+    auto poly = std::get_if<poly_type>(&geom);
+    if (poly && bg::num_points(*poly) >= covering_min_points) {
+      return covering_type{*poly};
+    }
+  }
+  return std::nullopt;
+}
+
+// whether a geometry inside of `rect` is within the covered polygon, unless it crosses its boundary
+template <typename covering_type, typename rect_type>
+auto check_covering(covering_type const& covering, rect_type const& rect) -> std::optional<bool> {
+  switch (covering.relate(rect)) {
+    case covering_type::Relation::INTERIOR:
+      return true;
+    case covering_type::Relation::EXTERIOR:
+      return false;
+    default:
+      return std::nullopt;
+  }
+}
+
 template <typename cs>
 constexpr auto filter_results = [](auto&& geom1, auto&& geom2) -> bool {
   using point_type = typename RTree<cs>::point_type;
@@ -124,7 +169,10 @@ template <typename cs>
 RTree<cs>::RTree()
     : allocated_{sizeof *this},
       rtree_{{}, {}, {}, doc_alloc{allocated_}},
-      docLookup_{0, lookup_alloc{allocated_}} {
+      docLookup_{0, lookup_alloc{allocated_}},
+      coveringLookup_{0, covering_alloc{allocated_}},
+      bulkLoading_{false},
+      bulkDocs_{doc_alloc{allocated_}} {
 }
 
 template <typename cs>
@@ -142,7 +190,14 @@ auto RTree<cs>::lookup(doc_type const& doc) const -> boost::optional<geom_type c
 template <typename cs>
 void RTree<cs>::insert(geom_type const& geom, t_docId id) {
   docLookup_.insert(lookup_type{id, geom});
-  rtree_.insert(make_doc<cs>(geom, id));
+  if (auto covering = make_covering<cs, doc_covering>(geom); covering.has_value()) {
+    coveringLookup_.insert(covering_lookup_type{id, *covering});
+  }
+  if (bulkLoading_) {
+    bulkDocs_.push_back(make_doc<cs>(geom, id));
+  } else {
+    rtree_.insert(make_doc<cs>(geom, id));
+  }
   allocated_ += std::visit(geometry_reporter<cs>, geom);
 }
 
@@ -165,11 +220,32 @@ bool RTree<cs>::remove(t_docId id) {
     allocated_ -= std::visit(geometry_reporter<cs>, *geom);
     rtree_.remove(make_doc<cs>(*geom, id));
     docLookup_.erase(id);
+    coveringLookup_.erase(id);
     return true;
   }
   return false;
 }
 
+template <typename cs>
+void RTree<cs>::startBulkLoad() {
+  bulkLoading_ = true;
+}
+
+template <typename cs>
+void RTree<cs>::finishBulkLoad() {
+  if (!bulkLoading_) {
+    return;
+  }
+  bulkLoading_ = false;
+  // documents removed during the load are no longer in the lookup table. the ones inserted
+  // before the load started are packed along with the rest
+  std::erase_if(bulkDocs_, [&](doc_type const& doc) -> bool { return !lookup(doc).has_value(); });
+  bulkDocs_.insert(bulkDocs_.end(), rtree_.begin(), rtree_.end());
+  auto packed = rtree_type{bulkDocs_.begin(), bulkDocs_.end(), {}, {}, {}, doc_alloc{allocated_}};
+  rtree_.swap(packed);
+  bulkDocs_ = decltype(bulkDocs_){doc_alloc{allocated_}};
+}
+
 template <typename cs>
 void RTree<cs>::dump(RedisModuleCtx* ctx) const {
   std::size_t lenTop = 0;
@@ -225,40 +301,90 @@ std::size_t RTree<cs>::report() const noexcept {
 }
 
 template <typename cs>
-template <typename Predicate, typename Filter>
-auto RTree<cs>::apply_predicate(Predicate&& p, Filter&& f) const -> query_results {
-  auto results = query_results{rtree_.qbegin(std::forward<Predicate>(p)), rtree_.qend(),
-                               Allocator::TrackingAllocator<doc_type>{allocated_}};
-  std::erase_if(results, std::forward<Filter>(f));
-  return results;
+template <typename Predicate, typename Relation>
+auto RTree<cs>::apply_predicate(Predicate&& p, Relation&& r, rect_type const& window) const
+    -> query_runs {
+  using run_type = typename query_runs::value_type;
+  auto runs = query_runs{query_tiles * query_tiles, run_type{run_type::allocator_type{allocated_}},
+                         typename query_runs::allocator_type{allocated_}};
+  auto add = [&](doc_type const& doc) -> void {
+    runs[get_tile<cs>(get_rect<cs>(doc), window)].push_back(get_id<cs>(doc));
+  };
+  std::for_each(rtree_.qbegin(std::forward<Predicate>(p)), rtree_.qend(), add);
+  // documents of an ongoing bulk load are not in the tree yet
+  std::ranges::for_each(bulkDocs_, [&](doc_type const& doc) -> void {
+    if (lookup(doc).has_value() && r(get_rect<cs>(doc))) {
+      add(doc);
+    }
+  });
+  std::ranges::for_each(runs, [](run_type& run) -> void { std::ranges::sort(run); });
+  return runs;
+}
+
+template <typename cs>
+auto RTree<cs>::contains(doc_type const& query_doc) const -> query_runs {
+  auto const& query_rect = get_rect<cs>(query_doc);
+  return apply_predicate(
+      bgi::contains(query_rect),
+      [&](rect_type const& rect) -> bool { return bg::within(query_rect, rect); }, query_rect);
 }
 
 template <typename cs>
-auto RTree<cs>::contains(doc_type const& query_doc, geom_type const& query_geom) const
-    -> query_results {
-  return apply_predicate(bgi::contains(get_rect<cs>(query_doc)), [&](auto const& doc) -> bool {
-    auto geom = lookup(doc);
-    return geom.has_value() && std::visit(filter_results<cs>, query_geom, *geom);
-  });
+auto RTree<cs>::within(doc_type const& query_doc) const -> query_runs {
+  auto const& query_rect = get_rect<cs>(query_doc);
+  return apply_predicate(
+      bgi::within(query_rect),
+      [&](rect_type const& rect) -> bool { return bg::within(rect, query_rect); }, query_rect);
 }
 
 template <typename cs>
-auto RTree<cs>::within(doc_type const& query_doc, geom_type const& query_geom) const
-    -> query_results {
-  return apply_predicate(bgi::within(get_rect<cs>(query_doc)), [&](auto const& doc) -> bool {
-    auto geom = lookup(doc);
-    return geom.has_value() && std::visit(filter_results<cs>, *geom, query_geom);
-  });
+auto RTree<cs>::generate_predicate(doc_type const& query_doc, QueryType query_type) const
+    -> query_runs {
+  switch (query_type) {
+    case QueryType::CONTAINS:
+      return contains(query_doc);
+    case QueryType::WITHIN:
+      return within(query_doc);
+    default:
+      throw std::runtime_error{"unknown query"};
+  }
 }
 
 template <typename cs>
-auto RTree<cs>::generate_predicate(doc_type const& query_doc, QueryType query_type,
-                                   geom_type const& query_geom) const -> query_results {
+auto RTree<cs>::generate_filter(QueryType query_type, geom_type const& query_geom) const
+    -> QueryIterator::filter_type {
   switch (query_type) {
     case QueryType::CONTAINS:
-      return contains(query_doc, query_geom);
+      // the query is within the candidates, which may be covered
+      return [this, query_geom,
+              query_rect = std::visit(make_mbr<cs>, query_geom)](t_docId id) -> bool {
+        auto geom = lookup(id);
+        if (!geom.has_value()) {
+          return false;
+        }
+        if (auto it = coveringLookup_.find(id); it != coveringLookup_.end()) {
+          if (auto res = check_covering(it->second, query_rect); res.has_value()) {
+            return *res;
+          }
+        }
+        return !std::visit(filter_results<cs>, query_geom, *geom);
+      };
     case QueryType::WITHIN:
-      return within(query_doc, query_geom);
+      // the candidates are within the query, covered once for all of them
+      return [this, query_geom,
+              covering = make_covering<cs, query_covering>(query_geom)](t_docId id) -> bool {
+        auto geom = lookup(id);
+        if (!geom.has_value()) {
+          return false;
+        }
+        if (covering.has_value()) {
+          auto res = check_covering(*covering, std::visit(make_mbr<cs>, *geom));
+          if (res.has_value()) {
+            return *res;
+          }
+        }
+        return !std::visit(filter_results<cs>, *geom, query_geom);
+      };
     default:
       throw std::runtime_error{"unknown query"};
   }
@@ -269,8 +395,8 @@ auto RTree<cs>::query(std::string_view wkt, QueryType query_type, RedisModuleStr
     -> IndexIterator* {
   try {
     auto query_geom = from_wkt<cs>(wkt);
-    return generate_query_iterator<cs>(
-        generate_predicate(make_doc<cs>(query_geom), query_type, query_geom), allocated_);
+    return generate_query_iterator<cs>(generate_predicate(make_doc<cs>(query_geom), query_type),
+                                       generate_filter(query_type, query_geom), allocated_);
   } catch (const std::exception& e) {
     if (err_msg) {
       *err_msg = RedisModule_CreateString(nullptr, e.what(), strlen(e.what()));
@@ -10,6 +10,7 @@
 #include "allocator/stateful_allocator.hpp"
 #include "allocator/tracking_allocator.hpp"
 #include "query_iterator.hpp"
+#include "covering.hpp"
 #include "geometry_types.h"
 
 #include <vector>                                  // std::vector
@@ -52,18 +53,33 @@ class RTree {
   using LUT_type = boost::unordered_flat_map<t_docId, geom_type, std::hash<t_docId>,
                                              std::equal_to<t_docId>, lookup_alloc>;
 
-  using query_results = std::vector<doc_type, Allocator::TrackingAllocator<doc_type>>;
+  // the coverings of the large polygons, telling most candidates apart without an exact check.
+  // only built in the plane
+  using doc_covering = Covering<CoordSystem, doc_covering_grid>;
+  using query_covering = Covering<CoordSystem, query_covering_grid>;
+  using covering_lookup_type = std::pair<t_docId const, doc_covering>;
+  using covering_alloc = Allocator::TrackingAllocator<covering_lookup_type>;
+  using covering_LUT_type = boost::unordered_flat_map<t_docId, doc_covering, std::hash<t_docId>,
+                                                      std::equal_to<t_docId>, covering_alloc>;
+
+  using query_runs = QueryIterator::runs_type;
 
  private:
   mutable std::size_t allocated_;
   rtree_type rtree_;
   LUT_type docLookup_;
+  covering_LUT_type coveringLookup_;
+  // Documents inserted during a bulk load, packed into the tree once it finishes
+  bool bulkLoading_;
+  std::vector<doc_type, doc_alloc> bulkDocs_;
 
  public:
   explicit RTree();
 
   int insertWKT(std::string_view wkt, t_docId id, RedisModuleString** err_msg);
   bool remove(t_docId id);
+  void startBulkLoad();
+  void finishBulkLoad();
   [[nodiscard]] auto query(std::string_view wkt, QueryType query_type,
                            RedisModuleString** err_msg) const -> IndexIterator*;
 
@@ -78,14 +94,15 @@ class RTree {
   [[nodiscard]] auto lookup(doc_type const& doc) const -> boost::optional<geom_type const&>;
   void insert(geom_type const& geom, t_docId id);
 
-  template <typename Predicate, typename Filter>
-  [[nodiscard]] auto apply_predicate(Predicate&& p, Filter&& f) const -> query_results;
-  [[nodiscard]] auto contains(doc_type const& query_doc, geom_type const& query_geom) const
-      -> query_results;
-  [[nodiscard]] auto within(doc_type const& query_doc, geom_type const& query_geom) const
-      -> query_results;
-  [[nodiscard]] auto generate_predicate(doc_type const& query_doc, QueryType query_type,
-                                        geom_type const& query_geom) const -> query_results;
+  template <typename Predicate, typename Relation>
+  [[nodiscard]] auto apply_predicate(Predicate&& p, Relation&& r, rect_type const& window) const
+      -> query_runs;
+  [[nodiscard]] auto contains(doc_type const& query_doc) const -> query_runs;
+  [[nodiscard]] auto within(doc_type const& query_doc) const -> query_runs;
+  [[nodiscard]] auto generate_predicate(doc_type const& query_doc, QueryType query_type) const
+      -> query_runs;
+  [[nodiscard]] auto generate_filter(QueryType query_type, geom_type const& query_geom) const
+      -> QueryIterator::filter_type;
 };
 
 }  // namespace GeoShape
@@ -16,6 +16,8 @@
 
 #include "rmalloc.h"
 
+#define HLL_SPARSE_INITIAL_CAP 4
+
 static __inline uint8_t _hll_rank(uint32_t hash, uint8_t bits) {
   uint8_t i;
 
@@ -36,18 +38,24 @@ int hll_init(struct HLL *hll, uint8_t bits) {
 
   hll->bits = bits;
   hll->size = (size_t)1 << bits;
-  hll->registers = rm_calloc(hll->size, 1);
+  hll->registers = NULL;
+  hll->sparse = NULL;
+  hll->sparseLen = 0;
+  hll->sparseCap = 0;
 
   return 0;
 }
 
 void hll_destroy(struct HLL *hll) {
   rm_free(hll->registers);
+  rm_free(hll->sparse);
 
   hll->registers = NULL;
+  hll->sparse = NULL;
+  hll->sparseLen = hll->sparseCap = 0;
 }
 
-static __inline void _hll_add_hash(struct HLL *hll, uint32_t hash) {
+static __inline void _hll_add_dense(struct HLL *hll, uint32_t hash) {
   uint32_t index = hash >> (32 - hll->bits);
   uint8_t rank = _hll_rank(hash, hll->bits);
 
@@ -56,6 +64,59 @@ static __inline void _hll_add_hash(struct HLL *hll, uint32_t hash) {
   }
 }
 
+int hll_densify(struct HLL *hll) {
+  if (hll->registers) return 0;
+
+  hll->registers = rm_calloc(hll->size, 1);
+  for (uint32_t i = 0; i < hll->sparseLen; i++) {
+    _hll_add_dense(hll, hll->sparse[i]);
+  }
+
+  rm_free(hll->sparse);
+  hll->sparse = NULL;
+  hll->sparseLen = hll->sparseCap = 0;
+
+  return 1;
+}
+
+static void _hll_add_sparse(struct HLL *hll, uint32_t hash) {
+  // the hashes are sorted, find where this one belongs
+  uint32_t lo = 0, hi = hll->sparseLen;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (hll->sparse[mid] < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < hll->sparseLen && hll->sparse[lo] == hash) return;
+
+  if (hll->sparseLen == HLL_SPARSE_MAX(hll)) {
+    // the hashes would take more memory than the registers
+    hll_densify(hll);
+    _hll_add_dense(hll, hash);
+    return;
+  }
+
+  if (hll->sparseLen == hll->sparseCap) {
+    hll->sparseCap = hll->sparseCap ? hll->sparseCap * 2 : HLL_SPARSE_INITIAL_CAP;
+    if (hll->sparseCap > HLL_SPARSE_MAX(hll)) hll->sparseCap = HLL_SPARSE_MAX(hll);
+    hll->sparse = rm_realloc(hll->sparse, hll->sparseCap * sizeof(*hll->sparse));
+  }
+  memmove(hll->sparse + lo + 1, hll->sparse + lo, (hll->sparseLen - lo) * sizeof(*hll->sparse));
+  hll->sparse[lo] = hash;
+  hll->sparseLen++;
+}
+
+static __inline void _hll_add_hash(struct HLL *hll, uint32_t hash) {
+  if (hll->registers) {
+    _hll_add_dense(hll, hash);
+  } else {
+    _hll_add_sparse(hll, hash);
+  }
+}
+
 void hll_add_hash(struct HLL *hll, uint32_t h) {
   _hll_add_hash(hll, h);
 }
@@ -66,10 +127,63 @@ void hll_add(struct HLL *hll, const void *buf, size_t size) {
   _hll_add_hash(hll, hash);
 }
 
+/* Helpers of the estimator of "New cardinality estimation algorithms for HyperLogLog sketches",
+ * Otmar Ertl, 2017 */
+static double _hll_sigma(double x) {
+  if (x == 1.) return INFINITY;
+  double zPrime;
+  double y = 1;
+  double z = x;
+  do {
+    x *= x;
+    zPrime = z;
+    z += x * y;
+    y += y;
+  } while (zPrime != z);
+  return z;
+}
+
+static double _hll_tau(double x) {
+  if (x == 0. || x == 1.) return 0.;
+  double zPrime;
+  double y = 1.0;
+  double z = 1 - x;
+  do {
+    x = sqrt(x);
+    zPrime = z;
+    y *= 0.5;
+    z -= pow(1 - x, 2) * y;
+  } while (zPrime != z);
+  return z / 3;
+}
+
+/* An estimate without the bias of the raw one at small cardinalities, from the histogram of the
+ * registers */
+static double _hll_count_corrected(const struct HLL *hll) {
+  uint32_t q = 32 - hll->bits;
+  uint32_t histogram[34] = {0};
+  for (uint32_t i = 0; i < hll->size; i++) histogram[hll->registers[i]]++;
+
+  double m = (double)hll->size;
+  double z = m * _hll_tau((m - histogram[q + 1]) / m);
+  for (uint32_t j = q; j >= 1; --j) {
+    z += histogram[j];
+    z *= 0.5;
+  }
+  z += m * _hll_sigma(histogram[0] / m);
+  return 0.5 / log(2) * m * m / z;
+}
+
 double hll_count(const struct HLL *hll) {
   double alpha_mm;
   uint32_t i;
 
+  if (!hll->registers) {
+    // the hashes are all kept, as if by registers of 32 bits: their linear counting estimate is
+    // their number
+    return hll->sparseLen;
+  }
+
   switch (hll->bits) {
     case 4:
       alpha_mm = 0.673;
@@ -94,12 +208,10 @@ double hll_count(const struct HLL *hll) {
 
   double estimate = alpha_mm / sum;
 
-  if (estimate <= 5.0 / 2.0 * (double)hll->size) {
-    int zeros = 0;
-
-    for (i = 0; i < hll->size; i++) zeros += (hll->registers[i] == 0);
-
-    if (zeros) estimate = (double)hll->size * log((double)hll->size / zeros);
+  if (estimate <= 5.0 * (double)hll->size) {
+    // the raw estimate is biased up to about 5 times the registers, as in HLL++, but the
+    // correction needs no empirical tables
+    estimate = _hll_count_corrected(hll);
 
   } else if (estimate > (1.0 / 30.0) * 4294967296.0) {
     estimate = -4294967296.0 * log(1.0 - (estimate / 4294967296.0));
@@ -116,6 +228,12 @@ int hll_merge(struct HLL *dst, const struct HLL *src) {
     return -1;
   }
 
+  if (!src->registers) {
+    for (i = 0; i < src->sparseLen; i++) _hll_add_hash(dst, src->sparse[i]);
+    return 0;
+  }
+
+  hll_densify(dst);
   for (i = 0; i < dst->size; i++) {
     if (src->registers[i] > dst->registers[i]) dst->registers[i] = src->registers[i];
   }
@@ -142,11 +260,27 @@ int hll_load(struct HLL *hll, const void *registers, size_t size) {
 
   if (hll_init(hll, bits) == -1) return -1;
 
+  hll_densify(hll);
   memcpy(hll->registers, registers, size);
 
   return 0;
 }
 
+int hll_load_sparse(struct HLL *hll, uint8_t bits, const void *hashes, size_t n) {
+  if (hll_init(hll, bits) == -1) return -1;
+
+  for (size_t i = 0; i < n; i++) {
+    uint32_t hash;
+    memcpy(&hash, (const char *)hashes + i * sizeof(hash), sizeof(hash));
+    _hll_add_hash(hll, hash);
+  }
+
+  return 0;
+}
+
 extern uint32_t _hll_hash(const struct HLL *hll) {
+  if (!hll->registers) {
+    return rs_fnv_32a_buf(hll->sparse, hll->sparseLen * sizeof(*hll->sparse), 0);
+  }
   return rs_fnv_32a_buf(hll->registers, (uint32_t)hll->size, 0);
 }
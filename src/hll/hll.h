@@ -10,15 +10,30 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+/* The most hashes kept by a sparse HLL, storing more takes more memory than its registers */
+#define HLL_SPARSE_MAX(hll) ((uint32_t)((hll)->size / sizeof(uint32_t)))
+
+/**
+ * An HLL starts sparse: it keeps the sorted distinct hashes added to it, and counts them exactly.
+ * It is made dense, with registers, once it has more than HLL_SPARSE_MAX hashes.
+ */
 struct HLL {
   uint8_t bits;
 
   size_t size;
-  uint8_t *registers;
+  uint8_t *registers;  // NULL while sparse
+
+  uint32_t *sparse;
+  uint32_t sparseLen;
+  uint32_t sparseCap;
 };
 
 extern int hll_init(struct HLL *hll, uint8_t bits);
 extern int hll_load(struct HLL *hll, const void *registers, size_t size);
+/* Load a sparse HLL from `n` hashes. They may be unaligned */
+extern int hll_load_sparse(struct HLL *hll, uint8_t bits, const void *hashes, size_t n);
+/* Allocate the registers of a sparse HLL. Returns 1 if it was sparse */
+extern int hll_densify(struct HLL *hll);
 extern void hll_destroy(struct HLL *hll);
 extern int hll_merge(struct HLL *dst, const struct HLL *src);
 extern void hll_add(struct HLL *hll, const void *buf, size_t size);
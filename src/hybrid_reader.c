@@ -5,12 +5,50 @@
  */
 
 #include <math.h>
+#include <pthread.h>
 #include "hybrid_reader.h"
 #include "VecSim/vec_sim.h"
 #include "VecSim/query_results.h"
 
 #define VECTOR_RESULT(p) (p->type == RSResultType_Metric ? p : p->agg.children[0])
 
+// The results of a selective child are read up front, so that the batches are sized by their
+// exact number and filtered by looking their ids up, rather than by intersecting every batch with
+// the child again. A child matching more of the index is met early in the batches anyway.
+#define HYBRID_FILTER_MAX_IDS (1 << 20)
+#define HYBRID_FILTER_MAX_RATIO 0.05
+
+// The pass rate of a filter among the nearest vectors, as observed by the last query in batches
+// mode, is kept in a direct mapped table by the key of the index and the filter (see
+// HybridIteratorParams.filterKey). The next query with the same filter starts from it, when it is
+// lower than the estimation of the child.
+#define HYBRID_HISTORY_SIZE 1024
+
+typedef struct {
+  uint64_t key;
+  float passRate;
+} hybridHistoryEntry;
+
+static hybridHistoryEntry history_g[HYBRID_HISTORY_SIZE];
+static pthread_mutex_t historyLock_g = PTHREAD_MUTEX_INITIALIZER;
+
+static bool hybridHistory_Get(uint64_t key, float *passRate) {
+  pthread_mutex_lock(&historyLock_g);
+  hybridHistoryEntry *e = &history_g[key % HYBRID_HISTORY_SIZE];
+  bool found = e->key == key;
+  if (found) {
+    *passRate = e->passRate;
+  }
+  pthread_mutex_unlock(&historyLock_g);
+  return found;
+}
+
+static void hybridHistory_Put(uint64_t key, float passRate) {
+  pthread_mutex_lock(&historyLock_g);
+  history_g[key % HYBRID_HISTORY_SIZE] = (hybridHistoryEntry){.key = key, .passRate = passRate};
+  pthread_mutex_unlock(&historyLock_g);
+}
+
 static VecSimQueryReply_Code prepareResults(HybridIterator *hr); // forward declaration
 
 static int cmpVecSimResByScore(const void *p1, const void *p2, const void *udata) {
@@ -172,6 +210,7 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
     VecSim_Normalize(qvector, hr->dimension, hr->vecType);
   }
 
+  size_t n_child = 0;
   VecSimTieredIndex_AcquireSharedLocks(hr->index);
   while (hr->child->Read(hr->child->ctx, &cur_child_res) != INDEXREAD_EOF) {
     if (TimedOut_WithCtx(&hr->timeoutCtx)) {
@@ -179,6 +218,8 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
       VecSimTieredIndex_ReleaseSharedLocks(hr->index);
       break;
     }
+    n_child++;
+    hr->stats.distances++;
     double metric = VecSimIndex_GetDistanceFrom_Unsafe(hr->index, cur_child_res->docId, qvector);
     // If this id is not in the vector index (since it was deleted), metric will return as NaN.
     if (isnan(metric)) {
@@ -196,12 +237,89 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
     rm_free(qvector);
   }
   IndexResult_Free(cur_vec_res);
+  if (rc != VecSim_QueryReply_TimedOut && VecSimIndex_IndexSize(hr->index)) {
+    hr->passRate = (float)n_child / VecSimIndex_IndexSize(hr->index);
+  }
   return rc;
 }
 
+// Read the ids of the child results into hr->filterIds. Returns false if it timed out.
+static bool readFilterIds(HybridIterator *hr, size_t child_num_estimated) {
+  RSIndexResult *cur_child_res;
+  hr->filterIds = array_new(t_docId, child_num_estimated);
+  while (hr->child->Read(hr->child->ctx, &cur_child_res) != INDEXREAD_EOF) {
+    if (TimedOut_WithCtx(&hr->timeoutCtx)) {
+      return false;
+    }
+    hr->filterIds = array_append(hr->filterIds, cur_child_res->docId);
+  }
+  return true;
+}
+
+// Gather the results of the current batch which pass the filter into `candidates`, by their
+// distance only. The batch is sorted by id, like the filter, so every lookup starts from the
+// position of the previous one.
+static void filterBatch(HybridIterator *hr, mm_heap_t *candidates, double *upper_bound) {
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  size_t lo = 0, n = array_len(hr->filterIds);
+  while (lo < n && HR_ReadInBatch(hr, &cur_vec_res) == INDEXREAD_OK) {
+    size_t hi = n;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (hr->filterIds[mid] < cur_vec_res->docId) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == n || hr->filterIds[lo] != cur_vec_res->docId) {
+      continue;
+    }
+    if (candidates->count < hr->query.k) {
+      mmh_insert(candidates, cur_vec_res);
+      cur_vec_res = NewMetricResult();
+    } else if (cur_vec_res->num.value < *upper_bound) {
+      cur_vec_res = mmh_exchange_max(candidates, cur_vec_res);
+    } else {
+      continue;
+    }
+    RSIndexResult *worst = mmh_peek_max(candidates);
+    *upper_bound = worst->num.value;
+  }
+  IndexResult_Free(cur_vec_res);
+}
+
+static int cmpResultsById(const void *p1, const void *p2) {
+  const RSIndexResult *e1 = *(const RSIndexResult **)p1, *e2 = *(const RSIndexResult **)p2;
+  return e1->docId < e2->docId ? -1 : e1->docId > e2->docId;
+}
+
+// Insert the filtered candidates into the results heap, along with their child results, which
+// are skipped to in a single pass over the child.
+static void insertCandidates(HybridIterator *hr, mm_heap_t *candidates) {
+  double upper_bound = INFINITY;
+  size_t n = candidates->count;
+  RSIndexResult **sorted = rm_malloc(MAX(n, 1) * sizeof(*sorted));
+  for (size_t i = 0; i < n; i++) {
+    sorted[i] = mmh_pop_min(candidates);
+  }
+  qsort(sorted, n, sizeof(*sorted), cmpResultsById);
+
+  RSIndexResult *cur_child_res;  // This will use the memory of hr->child->current.
+  hr->child->Rewind(hr->child->ctx);
+  for (size_t i = 0; i < n; i++) {
+    RSIndexResult *cur_vec_res = sorted[i];
+    if (hr->child->SkipTo(hr->child->ctx, cur_vec_res->docId, &cur_child_res) == INDEXREAD_OK) {
+      insertResultToHeap(hr, hr->base.current, cur_child_res, &cur_vec_res, &upper_bound);
+    }
+    IndexResult_Free(cur_vec_res);
+  }
+  rm_free(sorted);
+}
+
 // Review the estimated child results num, and returns true if hybrid policy should change.
-static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size_t child_upper_bound,
-                                     size_t *child_num_estimated) {
+static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size_t new_results_cur_batch,
+                                     size_t child_upper_bound, size_t *child_num_estimated) {
 
   // If user asked explicitly to run in batches with a fixed batch size, continue immediately
   // to the next batch without revisiting the hybrid policy.
@@ -209,14 +327,18 @@ static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size
     return false;
   }
   // Re-evaluate the child num estimated results and the hybrid policy based on the current batch.
-  size_t new_results_cur_batch = (hr->topResults->count) - (hr->query.k - n_res_left);
-  // This is the ratio between index_size to child results size as reflected by this batch.
-  float cur_ratio = (float)new_results_cur_batch / n_res_left;
-  // Child estimated number of results as reflected by this batch.
-  size_t cur_child_num_estimated = cur_ratio * VecSimIndex_IndexSize(hr->index);
-  // Conclude the new estimation of the child res num as the average between the old
-  // and new estimation (get the accumulated estimation).
-  *child_num_estimated = (*child_num_estimated + cur_child_num_estimated) / 2;
+  size_t batch_len = VecSimQueryReply_Len(hr->reply);
+  if (batch_len) {
+    // This is the ratio of the batch results that passed the filter.
+    float cur_pass_rate = (float)new_results_cur_batch / batch_len;
+    // Child estimated number of results as reflected by this batch.
+    size_t cur_child_num_estimated = cur_pass_rate * VecSimIndex_IndexSize(hr->index);
+    // Conclude the new estimation of the child res num as the average between the old
+    // and new estimation (get the accumulated estimation).
+    *child_num_estimated = (*child_num_estimated + cur_child_num_estimated) / 2;
+  }
+  // The next batch size is computed by the estimation, which is never below a single result.
+  *child_num_estimated = MAX(*child_num_estimated, 1);
   if (*child_num_estimated > child_upper_bound) {
     *child_num_estimated = child_upper_bound;
   }
@@ -227,6 +349,7 @@ static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size
 }
 
 static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
+  hr->stats.queries++;
   if (hr->searchMode == VECSIM_STANDARD_KNN) {
     hr->reply = VecSimIndex_TopKQuery(hr->index, hr->query.vector, hr->query.k, &(hr->runtimeParams), hr->query.order);
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
@@ -244,16 +367,49 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
   VecSimBatchIterator *batch_it = VecSimBatchIterator_New(hr->index, hr->query.vector, &hr->runtimeParams);
   double upper_bound = INFINITY;
   VecSimQueryReply_Code code = VecSim_QueryReply_OK;
-  size_t child_num_estimated = hr->child->NumEstimated(hr->child->ctx);
+  size_t child_upper_bound = hr->child->NumEstimated(hr->child->ctx);
   // Since NumEstimated(child) is an upper bound, it can be higher than index size.
-  if (child_num_estimated > VecSimIndex_IndexSize(hr->index)) {
-    child_num_estimated = VecSimIndex_IndexSize(hr->index);
+  if (child_upper_bound > VecSimIndex_IndexSize(hr->index)) {
+    child_upper_bound = VecSimIndex_IndexSize(hr->index);
+  }
+  // The estimation may be lower than the upper bound, by the pass rate history of the filter.
+  size_t child_num_estimated = MIN(hr->childNumEstimated, child_upper_bound);
+  mm_heap_t *candidates = NULL;
+  if (child_upper_bound <= HYBRID_FILTER_MAX_IDS &&
+      child_upper_bound <= HYBRID_FILTER_MAX_RATIO * VecSimIndex_IndexSize(hr->index)) {
+    if (!readFilterIds(hr, child_upper_bound)) {
+      VecSimBatchIterator_Free(batch_it);
+      return VecSim_QueryReply_TimedOut;
+    }
+    child_num_estimated = MIN(array_len(hr->filterIds), child_upper_bound);
+    if (child_num_estimated == 0) {
+      VecSimBatchIterator_Free(batch_it);
+      return VecSim_QueryReply_OK;
+    }
+    hr->passRate = (float)child_num_estimated / VecSimIndex_IndexSize(hr->index);
+    if (hr->filterKey) {
+      hybridHistory_Put(hr->filterKey, hr->passRate);
+    }
+    // The exact number of results may well be below the estimation the policy was chosen by
+    if ((VecSimSearchMode)hr->runtimeParams.searchMode != VECSIM_HYBRID_BATCHES &&
+        VecSimIndex_PreferAdHocSearch(hr->index, child_num_estimated, hr->query.k, false)) {
+      VecSimBatchIterator_Free(batch_it);
+      hr->searchMode = VECSIM_HYBRID_BATCHES_TO_ADHOC_BF;
+      hr->child->Rewind(hr->child->ctx);
+      return computeDistances(hr);
+    }
+    candidates = mmh_init_with_size(hr->query.k, cmpVecSimResByScore, NULL,
+                                    (mmh_free_func)IndexResult_Free);
   }
-  size_t child_upper_bound = child_num_estimated;
+  // The results found so far, either filtered candidates or results joined with the child
+  mm_heap_t *found = candidates ? candidates : hr->topResults;
+  // The number of batch results that were joined with the child, and that passed the filter
+  size_t n_scanned = 0, n_passed = 0;
   while (VecSimBatchIterator_HasNext(batch_it)) {
     hr->numIterations++;
+    hr->stats.batches++;
     size_t vec_index_size = VecSimIndex_IndexSize(hr->index);
-    size_t n_res_left = hr->query.k - hr->topResults->count;
+    size_t n_res_left = hr->query.k - found->count;
     // If user requested explicitly a batch size, use it. Otherwise, compute optimal batch size
     // based on the ratio between child_num_estimated and the index size.
     size_t batch_size = hr->runtimeParams.batchSize;
@@ -270,15 +426,28 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
       break;
     }
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
+    hr->stats.batchResults += VecSimQueryReply_Len(hr->reply);
+    if (candidates) {
+      // The number of child results is exact, there is no estimation to review
+      filterBatch(hr, candidates, &upper_bound);
+      if (candidates->count == hr->query.k) {
+        break;
+      }
+      continue;
+    }
     hr->child->Rewind(hr->child->ctx);
 
     // Go over both iterators and save mutual results in the heap.
     alternatingIterate(hr, hr->iter, &upper_bound);
+    size_t new_results_cur_batch = hr->topResults->count - (hr->query.k - n_res_left);
+    n_scanned += VecSimQueryReply_Len(hr->reply);
+    n_passed += new_results_cur_batch;
     if (hr->topResults->count == hr->query.k) {
       break;
     }
 
-    if (reviewHybridSearchPolicy(hr, n_res_left, child_num_estimated, &child_num_estimated)) {
+    if (reviewHybridSearchPolicy(hr, n_res_left, new_results_cur_batch, child_upper_bound,
+                                 &child_num_estimated)) {
       // Change policy from batches to AD-HOC BF.
       hr->searchMode = VECSIM_HYBRID_BATCHES_TO_ADHOC_BF;
       // Clean the saved results, and restart the hybrid search in ad-hoc BF mode.
@@ -289,6 +458,19 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
     }
   }
   VecSimBatchIterator_Free(batch_it);
+  if (n_scanned && code != VecSim_QueryReply_TimedOut &&
+      hr->searchMode == VECSIM_HYBRID_BATCHES) {
+    hr->passRate = (float)n_passed / n_scanned;
+  }
+  if (hr->filterKey && n_scanned && code != VecSim_QueryReply_TimedOut) {
+    hybridHistory_Put(hr->filterKey, (float)n_passed / n_scanned);
+  }
+  if (candidates) {
+    if (code != VecSim_QueryReply_TimedOut) {
+      insertCandidates(hr, candidates);
+    }
+    mmh_free(candidates);
+  }
   return code;
 }
 
@@ -383,6 +565,8 @@ static void HR_Rewind(void *ctx) {
     array_clear(hr->returnedResults);
     hr->child->Rewind(hr->child->ctx);
   }
+  array_free(hr->filterIds);
+  hr->filterIds = NULL;
 }
 
 void HybridIterator_Free(struct indexIterator *self) {
@@ -396,12 +580,16 @@ void HybridIterator_Free(struct indexIterator *self) {
   if (it->returnedResults) {   // Iterator is in one of the hybrid modes.
     array_free_ex(it->returnedResults, IndexResult_Free(*(RSIndexResult **)ptr));
   }
+  array_free(it->filterIds);
   IndexResult_Free(it->base.current);
   VecSimQueryReply_Free(it->reply);
   VecSimQueryReply_IteratorFree(it->iter);
   if (it->child) {
     it->child->Free(it->child);
   }
+  if (it->fieldStats) {
+    VectorQueryStats_Add(it->fieldStats, &it->stats);
+  }
   rm_free(it);
 }
 
@@ -428,6 +616,13 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   hi->topResults = NULL;
   hi->returnedResults = NULL;
   hi->numIterations = 0;
+  hi->filterIds = NULL;
+  hi->filterKey = hParams.filterKey;
+  hi->childNumEstimated = 0;
+  hi->usedHistory = false;
+  hi->stats = (VectorQueryStats){0};
+  hi->fieldStats = hParams.fieldStats;
+  hi->passRate = -1;
   hi->ignoreScores = hParams.ignoreDocScore;
   hi->timeoutCtx = (TimeoutCtx){ .timeout = hParams.timeout, .counter = 0 };
   hi->runtimeParams.timeoutCtx = &hi->timeoutCtx;
@@ -448,6 +643,18 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
     if (subset_size > VecSimIndex_IndexSize(hParams.index)) {
       subset_size = VecSimIndex_IndexSize(hParams.index);
     }
+    // Unless the user chose the policy or the batch size, start from the pass rate the filter had
+    // in the previous query, if it is lower than the estimation.
+    float passRate;
+    if (!hParams.qParams.searchMode && !hParams.qParams.batchSize && hParams.filterKey &&
+        hybridHistory_Get(hParams.filterKey, &passRate)) {
+      size_t history_size = MAX(passRate * VecSimIndex_IndexSize(hParams.index), 1);
+      if (history_size < subset_size) {
+        subset_size = history_size;
+        hi->usedHistory = true;
+      }
+    }
+    hi->childNumEstimated = subset_size;
     // If user asks explicitly for a policy - use it.
     if (hParams.qParams.searchMode) {
       hi->searchMode = (VecSimSearchMode)hParams.qParams.searchMode;
@@ -479,6 +686,7 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   ri->Abort = HR_Abort;
   ri->Rewind = HR_Rewind;
   ri->HasNext = HR_HasNext;
+  ri->ReadBatch = NULL;
   ri->SkipTo = NULL; // As long as we return results by score (unsorted by id), this has no meaning.
   if (hi->searchMode == VECSIM_STANDARD_KNN) {
     ri->Read = HR_ReadKnnUnsorted;
@@ -494,3 +702,20 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   }
   return ri;
 }
+
+const char *HybridIterator_PrintSearchMode(VecSimSearchMode mode) {
+  switch (mode) {
+    case VECSIM_STANDARD_KNN:
+      return "STANDARD_KNN";
+    case VECSIM_HYBRID_ADHOC_BF:
+      return "HYBRID_ADHOC_BF";
+    case VECSIM_HYBRID_BATCHES:
+      return "HYBRID_BATCHES";
+    case VECSIM_HYBRID_BATCHES_TO_ADHOC_BF:
+      return "HYBRID_BATCHES_TO_ADHOC_BF";
+    case VECSIM_RANGE_QUERY:
+      return "RANGE_QUERY";
+    default:
+      return "EMPTY_MODE";
+  }
+}
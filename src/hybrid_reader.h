@@ -24,6 +24,9 @@ typedef struct {
   bool ignoreDocScore;
   IndexIterator *childIt;
   struct timespec timeout;
+  uint64_t filterKey;              // Identifies the child filter in the pass rate history (see
+                                   // HYBRID_HISTORY_SIZE), 0 to not use the history
+  VectorQueryStats *fieldStats;    // The stats of the vector field the query adds to, if any
 } HybridIteratorParams;
 
 typedef struct {
@@ -47,6 +50,14 @@ typedef struct {
   size_t numIterations;
   bool ignoreScores;               // Ignore the document scores, only vector score matters.
   TimeoutCtx timeoutCtx;           // Timeout parameters
+  t_docId *filterIds;              // The sorted ids of the child results, if they were read up
+                                   // front to filter the batches by (see HYBRID_FILTER_MAX_IDS)
+  uint64_t filterKey;
+  size_t childNumEstimated;        // The number of child results the policy was chosen by
+  bool usedHistory;                // The estimation was lowered by the pass rate history
+  VectorQueryStats stats;          // What this query asked of the vector index (see FT.PROFILE)
+  VectorQueryStats *fieldStats;    // Added to when the iterator is freed
+  float passRate;                  // The ratio of the vectors observed to pass the filter, or -1
 } HybridIterator;
 
 #ifdef __cplusplus
@@ -55,6 +66,8 @@ extern "C" {
 
 IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError *status);
 
+const char *HybridIterator_PrintSearchMode(VecSimSearchMode mode);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,9 +11,11 @@
 typedef struct {
   IndexIterator base;
   t_docId *docIds;
+  double *values;  // the values of the numeric records, if any
   t_docId lastDocId;
   t_offset size;
   t_offset offset;
+  bool ownIds;  // false if the ids are borrowed from the caller
 } IdListIterator;
 
 static inline void setEof(IdListIterator *it, int value) {
@@ -68,6 +70,9 @@ int IL_Read(void *ctx, RSIndexResult **r) {
     return INDEXREAD_EOF;
   }
 
+  if (it->values) {
+    it->base.current->num.value = it->values[it->offset];
+  }
   it->lastDocId = it->docIds[it->offset++];
 
   // TODO: Filter here
@@ -110,6 +115,10 @@ int IL_SkipTo(void *ctx, t_docId docId, RSIndexResult **r) {
       bottom = i + 1;
     }
   }
+  // the search may stop on the last id below docId; the one after it is next
+  if (it->docIds[i] < docId) {
+    ++i;
+  }
   it->offset = i + 1;
   if (it->offset >= it->size) {
     setEof(it, 1);
@@ -117,6 +126,9 @@ int IL_SkipTo(void *ctx, t_docId docId, RSIndexResult **r) {
 
   it->lastDocId = it->docIds[i];
   it->base.current->docId = it->lastDocId;
+  if (it->values) {
+    it->base.current->num.value = it->values[i];
+  }
 
   *r = it->base.current;
 
@@ -135,9 +147,10 @@ t_docId IL_LastDocId(void *ctx) {
 void IL_Free(struct indexIterator *self) {
   IdListIterator *it = self->ctx;
   IndexResult_Free(it->base.current);
-  if (it->docIds) {
+  if (it->docIds && it->ownIds) {
     rm_free(it->docIds);
   }
+  rm_free(it->values);
   rm_free(self);
 }
 
@@ -161,19 +174,17 @@ void IL_Rewind(void *p) {
   il->offset = 0;
 }
 
-IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
-
-  // first sort the ids, so the caller will not have to deal with it
-  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
-
+static IndexIterator *newIdListIterator(t_docId *docIds, double *values, t_offset num,
+                                        bool ownIds, double weight) {
   IdListIterator *it = rm_new(IdListIterator);
 
   it->size = num;
-  it->docIds = rm_calloc(num, sizeof(t_docId));
-  if (num > 0) memcpy(it->docIds, ids, num * sizeof(t_docId));
+  it->docIds = docIds;
+  it->values = values;
+  it->ownIds = ownIds;
   setEof(it, 0);
   it->lastDocId = 0;
-  it->base.current = NewVirtualResult(weight);
+  it->base.current = values ? NewNumericResult() : NewVirtualResult(weight);
   it->base.current->fieldMask = RS_FIELDMASK_ALL;
 
   it->offset = 0;
@@ -188,6 +199,7 @@ IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
   ret->Len = IL_Len;
   ret->Read = IL_Read;
   ret->SkipTo = IL_SkipTo;
+  ret->ReadBatch = NULL;
   ret->Abort = IL_Abort;
   ret->Rewind = IL_Rewind;
   ret->mode = MODE_SORTED;
@@ -195,3 +207,21 @@ IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
   ret->HasNext = NULL;
   return ret;
 }
+
+IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
+
+  // first sort the ids, so the caller will not have to deal with it
+  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
+
+  t_docId *docIds = rm_calloc(num, sizeof(t_docId));
+  if (num > 0) memcpy(docIds, ids, num * sizeof(t_docId));
+  return newIdListIterator(docIds, NULL, num, true, weight);
+}
+
+IndexIterator *NewBorrowedIdListIterator(const t_docId *ids, t_offset num, double weight) {
+  return newIdListIterator((t_docId *)ids, NULL, num, false, weight);
+}
+
+IndexIterator *NewNumericIdListIterator(t_docId *ids, double *values, t_offset num) {
+  return newIdListIterator(ids, values, num, true, 1);
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "incremental_gc.h"
+#include "config.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "suffix.h"
+#include "time_sample.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+#include "rmutil/rm_assert.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Repairing a block costs as much of the budget of a slice as checking this many blocks, which
+// only takes a binary search over the deleted documents
+#define IGC_REPAIR_COST 16
+
+typedef struct {
+  int collectIdx;
+  KMVSketch cardSketch;
+} numCbCtx;
+
+typedef struct {
+  size_t entries;
+  size_t bytes;
+} collected;
+
+/* Whether a document deleted before the pass has an id within [first, last] */
+static bool isDirty(const IncrementalGC *gc, t_docId first, t_docId last) {
+  if (gc->fullPass) {
+    return last != 0;
+  }
+  return GC_HasDeletedIds(gc->dirty, first, last);
+}
+
+static void charge(size_t *budget, size_t cost) {
+  *budget = *budget > cost ? *budget - cost : 0;
+}
+
+/* Repair the dirty blocks of `idx`, starting with the block `gc->block`. Blocks left empty are
+ * removed, except for the last one which is still written to. Returns false if the budget ran out
+ * before the end of the index */
+static bool collectIndex(IncrementalGC *gc, RedisSearchCtx *sctx, InvertedIndex *idx,
+                         IndexRepairParams *params, size_t *budget, collected *out) {
+  if (gc->block == 0 && !isDirty(gc, idx->blocks[0].firstId, idx->lastId)) {
+    charge(budget, 1);
+    gc->stats.blocksSkipped += idx->size;
+    return true;
+  }
+
+  while (gc->block < idx->size) {
+    if (!*budget) {
+      return false;
+    }
+    IndexBlock *blk = idx->blocks + gc->block;
+    if (!isDirty(gc, blk->firstId, blk->lastId)) {
+      charge(budget, 1);
+      ++gc->stats.blocksSkipped;
+      ++gc->block;
+      continue;
+    }
+
+    charge(budget, IGC_REPAIR_COST);
+    ++gc->stats.blocksRepaired;
+    params->bytesCollected = params->entriesCollected = 0;
+    params->limit = 1;
+    InvertedIndex_Repair(idx, &sctx->spec->docs, gc->block, params);
+    out->entries += params->entriesCollected;
+    out->bytes += params->bytesCollected;
+
+    if (blk->numEntries == 0 && gc->block + 1 < idx->size) {
+      indexBlock_Free(blk);
+      memmove(blk, blk + 1, (idx->size - gc->block - 1) * sizeof(*blk));
+      --idx->size;
+      --TotalIIBlocks;
+      ++idx->gcMarker;
+    } else {
+      ++gc->block;
+    }
+  }
+  return true;
+}
+
+// Assumes the spec is locked.
+static void updateStats(IncrementalGC *gc, RedisSearchCtx *sctx, const collected *c) {
+  sctx->spec->stats.numRecords -= c->entries;
+  sctx->spec->stats.invertedSize -= c->bytes;
+  gc->stats.totalCollected += c->bytes;
+}
+
+static bool collectTerm(IncrementalGC *gc, RedisSearchCtx *sctx, RedisModuleString *key,
+                        InvertedIndex *idx, size_t *budget) {
+  IndexRepairParams params = {0};
+  collected c = {0};
+  bool done = collectIndex(gc, sctx, idx, &params, budget, &c);
+  updateStats(gc, sctx, &c);
+  if (!done || idx->numDocs != 0) {
+    return done;
+  }
+
+  // inverted index was cleaned entirely lets free it. The key is formatted by fmtRedisTermKey
+  size_t keyLen;
+  const char *keyStr = RedisModule_StringPtrLen(key, &keyLen);
+  size_t prefixLen = strlen("ft:") + sctx->spec->nameLen + 1;
+  const char *term = keyStr + prefixLen;
+  size_t len = keyLen - prefixLen;
+  dictDelete(sctx->spec->keysDict, key);
+  Trie_Delete(IndexSpec_GetTermsTrie(sctx->spec, term), term, len);
+  sctx->spec->stats.numTerms--;
+  sctx->spec->stats.termsSize -= len;
+  IndexSpec_TermsChanged(sctx->spec);
+  if (sctx->spec->suffix) {
+    deleteSuffixTrie(sctx->spec->suffix, term, len);
+  }
+  if (sctx->spec->ngrams) {
+    NgramIndex_Delete(sctx->spec->ngrams, term, len);
+  }
+  return true;
+}
+
+static void countRemain(const RSIndexResult *r, const IndexBlock *blk, void *arg) {
+  numCbCtx *ctx = arg;
+
+  // check cardinality every 10 elements
+  if (--ctx->collectIdx != 0) {
+    return;
+  }
+  ctx->collectIdx = NR_CARD_CHECK;
+  KMV_Add(&ctx->cardSketch, r->num.value);
+}
+
+/* Collect a numeric range. A range with a dirty block is repaired whole, so its cardinality can be
+ * counted again from the entries which remain */
+static void collectRange(IncrementalGC *gc, RedisSearchCtx *sctx, NumericRangeTree *rt,
+                         NumericRange *r, size_t *budget) {
+  InvertedIndex *idx = r->entries;
+  if (!isDirty(gc, idx->blocks[0].firstId, idx->lastId)) {
+    charge(budget, 1);
+    gc->stats.blocksSkipped += idx->size;
+    return;
+  }
+
+  bool wasEmpty = idx->numDocs == 0;
+  numCbCtx nctx = {.cardSketch = {0}, .collectIdx = 1};
+  IndexRepairParams params = {.RepairCallback = countRemain, .arg = &nctx};
+  collected c = {0};
+  size_t unbounded = SIZE_MAX;
+  bool fullPass = gc->fullPass;
+  // every block is read to count the cardinality
+  gc->fullPass = true;
+  gc->block = 0;
+  collectIndex(gc, sctx, idx, &params, &unbounded, &c);
+  gc->fullPass = fullPass;
+  charge(budget, idx->size * IGC_REPAIR_COST);
+
+  idx->numEntries -= c.entries;
+  r->invertedIndexSize -= c.bytes;
+  rt->numEntries -= c.entries;
+  updateStats(gc, sctx, &c);
+  NumericRange_SetCardSketch(r, &nctx.cardSketch);
+  if (r->column) {
+    NumericRange_RebuildColumn(r);
+  }
+  if (!wasEmpty && idx->numDocs == 0) {
+    rt->emptyLeaves++;
+  }
+  gc->numericCollected |= c.entries != 0;
+}
+
+static bool collectNumeric(IncrementalGC *gc, RedisSearchCtx *sctx, NumericRangeTree *rt,
+                           size_t *budget) {
+  if (rt->revisionId != gc->revision) {
+    // the tree was split since the last slice, and the entries moved to other ranges
+    gc->revision = rt->revisionId;
+    gc->nested = 0;
+  }
+
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  size_t ordinal = 0;
+  bool done = true;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    if (!node->range || ordinal++ < gc->nested) {
+      continue;
+    }
+    if (!*budget) {
+      done = false;
+      break;
+    }
+    collectRange(gc, sctx, rt, node->range, budget);
+    ++gc->nested;
+  }
+  NumericRangeTreeIterator_Free(iter);
+
+  if (done && gc->numericCollected) {
+    if (RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes &&
+        rt->emptyLeaves >= rt->numRanges / 2) {
+      NRN_AddRv rv = NumericRangeTree_TrimEmptyLeaves(rt);
+      rt->numRanges += rv.numRanges;
+      rt->emptyLeaves = 0;
+    }
+    if (RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes) {
+      rt->numRanges += NumericRangeTree_Rebalance(rt).numRanges;
+    }
+    // the collected entries are still counted in the histogram
+    NumericRangeTree_RefreshHistogram(rt);
+  }
+  return done;
+}
+
+static void freeTagValues(IncrementalGC *gc) {
+  if (gc->tagValues) {
+    array_free_ex(gc->tagValues, sdsfree(*(sds *)ptr));
+    gc->tagValues = NULL;
+  }
+}
+
+static bool collectTags(IncrementalGC *gc, RedisSearchCtx *sctx, TagIndex *tagIdx,
+                        size_t *budget) {
+  if (!gc->tagValues) {
+    // Values added from now on only hold documents added after the pass began
+    gc->tagValues = array_new(sds, 8);
+    TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+    char *ptr;
+    tm_len_t len;
+    void *value;
+    while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+      gc->tagValues = array_append(gc->tagValues, sdsnewlen(ptr, len));
+    }
+    TrieMapIterator_Free(iter);
+  }
+
+  for (; gc->nested < array_len(gc->tagValues); ++gc->nested, gc->block = 0) {
+    if (!*budget) {
+      return false;
+    }
+    sds tagVal = gc->tagValues[gc->nested];
+    InvertedIndex *idx = TrieMap_Find(tagIdx->values, tagVal, sdslen(tagVal));
+    if (idx == TRIEMAP_NOTFOUND) {
+      continue;
+    }
+
+    IndexRepairParams params = {0};
+    collected c = {0};
+    bool done = collectIndex(gc, sctx, idx, &params, budget, &c);
+    updateStats(gc, sctx, &c);
+    if (!done) {
+      return false;
+    }
+
+    // if tag value is empty, let's remove it.
+    if (idx->numDocs == 0) {
+      TrieMap_Delete(tagIdx->values, tagVal, sdslen(tagVal), InvertedIndex_Free);
+      tagIdx->revision++;
+
+      if (tagIdx->suffix) {
+        deleteSuffixTrie(tagIdx->suffix, tagVal, sdslen(tagVal));
+      }
+    }
+  }
+  return true;
+}
+
+static void collectScannedKey(void *privdata, const dictEntry *de) {
+  IncrementalGC *gc = privdata;
+  RedisModuleString *key = dictGetKey(de);
+  gc->pending = array_append(gc->pending, RedisModule_CreateStringFromString(gc->ctx, key));
+}
+
+static void nextKey(IncrementalGC *gc) {
+  RedisModule_FreeString(gc->ctx, array_pop(gc->pending));
+  gc->current = NULL;
+  gc->nested = 0;
+  gc->block = 0;
+  gc->numericCollected = false;
+  freeTagValues(gc);
+}
+
+/* Collect from the keys of the index until the budget of the slice runs out. Returns true once
+ * all the keys were collected */
+static bool runSlice(IncrementalGC *gc, RedisSearchCtx *sctx) {
+  dict *keysDict = sctx->spec->keysDict;
+  if (!keysDict) {
+    return true;
+  }
+
+  size_t budget = RSGlobalConfig.gcConfigParams.gcScanSize * IGC_REPAIR_COST;
+  while (budget) {
+    if (!array_len(gc->pending)) {
+      if (gc->scanDone) {
+        return true;
+      }
+      gc->cursor = dictScan(keysDict, gc->cursor, collectScannedKey, NULL, gc);
+      gc->scanDone = gc->cursor == 0;
+      charge(&budget, 1);
+      continue;
+    }
+
+    RedisModuleString *key = array_tail(gc->pending);
+    KeysDictValue *kdv = dictFetchValue(keysDict, key);
+    if (kdv && kdv->p != gc->current) {
+      gc->current = kdv->p;
+      gc->nested = 0;
+      gc->block = 0;
+      freeTagValues(gc);
+      if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+        gc->revision = ((NumericRangeTree *)kdv->p)->revisionId;
+      }
+    }
+
+    bool done = true;
+    if (!kdv) {
+      // deleted since it was scanned
+    } else if (kdv->dtor == InvertedIndex_Free) {
+      done = collectTerm(gc, sctx, key, kdv->p, &budget);
+    } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+      done = collectNumeric(gc, sctx, kdv->p, &budget);
+    } else if (kdv->dtor == TagIndex_Free) {
+      done = collectTags(gc, sctx, kdv->p, &budget);
+    }
+    if (!done) {
+      return false;
+    }
+    nextKey(gc);
+  }
+  return false;
+}
+
+static void endPass(IncrementalGC *gc) {
+  while (array_len(gc->pending)) {
+    nextKey(gc);
+  }
+  array_clear(gc->dirty);
+  gc->cursor = 0;
+  gc->scanDone = false;
+}
+
+static int periodicCb(RedisModuleCtx *ctx, void *privdata) {
+  IncrementalGC *gc = privdata;
+
+  StrongRef early_check = WeakRef_Promote(gc->index);
+  if (!StrongRef_Get(early_check)) {
+    // Index was deleted
+    return 0;
+  }
+  StrongRef_Release(early_check);
+
+  pthread_mutex_lock(&gc->lock);
+  if (array_len(gc->deleted) < RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold ||
+      (!array_len(gc->deleted) && !gc->fullPass)) {
+    pthread_mutex_unlock(&gc->lock);
+    return 1;
+  }
+  arrayof(t_docId) deleted = gc->deleted;
+  gc->deleted = gc->dirty;
+  gc->dirty = deleted;
+  pthread_mutex_unlock(&gc->lock);
+
+  GC_SortDeletedIds(&gc->dirty);
+
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+
+  int gcrv = 1;
+  bool done = false;
+  while (!done) {
+    StrongRef spec_ref = WeakRef_Promote(gc->index);
+    IndexSpec *sp = StrongRef_Get(spec_ref);
+    if (!sp) {
+      gcrv = 0;
+      break;
+    }
+    RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+    RedisSearchCtx_LockSpecWrite(&sctx);
+    done = runSlice(gc, &sctx);
+    RedisSearchCtx_UnlockSpec(&sctx);
+    StrongRef_Release(spec_ref);
+    gc->stats.numSlices++;
+    if (!done) {
+      // let the writers and the queries waiting on the lock in
+      sched_yield();
+    }
+  }
+  endPass(gc);
+  gc->fullPass = false;
+
+  TimeSampler_End(&ts);
+  long long msRun = TimeSampler_DurationMS(&ts);
+
+  gc->stats.numCycles++;
+  gc->stats.totalMSRun += msRun;
+  gc->stats.lastRunTimeMs = msRun;
+
+  return gcrv;
+}
+
+static void onTerminateCb(void *privdata) {
+  IncrementalGC *gc = privdata;
+  endPass(gc);
+  array_free(gc->pending);
+  array_free(gc->dirty);
+  array_free(gc->deleted);
+  pthread_mutex_destroy(&gc->lock);
+  WeakRef_Release(gc->index);
+  RedisModule_FreeThreadSafeContext(gc->ctx);
+  rm_free(gc);
+}
+
+static void statsCb(RedisModule_Reply *reply, void *gcCtx) {
+#define REPLY_KVNUM(k, v) RedisModule_ReplyKV_Double(reply, (k), (v))
+  IncrementalGC *gc = gcCtx;
+  if (!gc) return;
+  REPLY_KVNUM("bytes_collected", gc->stats.totalCollected);
+  REPLY_KVNUM("total_ms_run", gc->stats.totalMSRun);
+  REPLY_KVNUM("total_cycles", gc->stats.numCycles);
+  REPLY_KVNUM("average_cycle_time_ms", (double)gc->stats.totalMSRun / gc->stats.numCycles);
+  REPLY_KVNUM("last_run_time_ms", (double)gc->stats.lastRunTimeMs);
+  REPLY_KVNUM("total_slices", (double)gc->stats.numSlices);
+  REPLY_KVNUM("gc_blocks_repaired", (double)gc->stats.blocksRepaired);
+  REPLY_KVNUM("gc_blocks_skipped", (double)gc->stats.blocksSkipped);
+}
+
+#ifdef FTINFO_FOR_INFO_MODULES
+static void statsForInfoCb(RedisModuleInfoCtx *ctx, void *gcCtx) {
+  IncrementalGC *gc = gcCtx;
+  RedisModule_InfoBeginDictField(ctx, "gc_stats");
+  RedisModule_InfoAddFieldLongLong(ctx, "bytes_collected", gc->stats.totalCollected);
+  RedisModule_InfoAddFieldLongLong(ctx, "total_ms_run", gc->stats.totalMSRun);
+  RedisModule_InfoAddFieldLongLong(ctx, "total_cycles", gc->stats.numCycles);
+  RedisModule_InfoAddFieldDouble(ctx, "average_cycle_time_ms", (double)gc->stats.totalMSRun / gc->stats.numCycles);
+  RedisModule_InfoAddFieldDouble(ctx, "last_run_time_ms", (double)gc->stats.lastRunTimeMs);
+  RedisModule_InfoAddFieldLongLong(ctx, "total_slices", gc->stats.numSlices);
+  RedisModule_InfoAddFieldLongLong(ctx, "gc_blocks_repaired", gc->stats.blocksRepaired);
+  RedisModule_InfoAddFieldLongLong(ctx, "gc_blocks_skipped", gc->stats.blocksSkipped);
+  RedisModule_InfoEndDictField(ctx);
+}
+#endif
+
+static void deleteCb(void *ctx, t_docId docId) {
+  IncrementalGC *gc = ctx;
+  pthread_mutex_lock(&gc->lock);
+  gc->deleted = array_append(gc->deleted, docId);
+  pthread_mutex_unlock(&gc->lock);
+}
+
+static struct timespec getIntervalCb(void *ctx) {
+  IncrementalGC *gc = ctx;
+  return gc->retryInterval;
+}
+
+IncrementalGC *IGC_New(StrongRef spec_ref, GCCallbacks *callbacks) {
+  IncrementalGC *gc = rm_calloc(1, sizeof(*gc));
+  gc->index = StrongRef_Demote(spec_ref);
+  gc->retryInterval.tv_sec = RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec;
+  gc->retryInterval.tv_nsec = 0;
+  pthread_mutex_init(&gc->lock, NULL);
+  gc->deleted = array_new(t_docId, 16);
+  gc->dirty = array_new(t_docId, 16);
+  gc->pending = array_new(RedisModuleString *, 8);
+  gc->fullPass = true;
+  gc->ctx = RedisModule_GetThreadSafeContext(NULL);
+
+  callbacks->onTerm = onTerminateCb;
+  callbacks->periodicCallback = periodicCb;
+  callbacks->renderStats = statsCb;
+#ifdef FTINFO_FOR_INFO_MODULES
+  callbacks->renderStatsForInfo = statsForInfoCb;
+#endif
+  callbacks->getInterval = getIntervalCb;
+  callbacks->onDelete = deleteCb;
+
+  return gc;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef SRC_INCREMENTAL_GC_H_
+#define SRC_INCREMENTAL_GC_H_
+
+#include "redismodule.h"
+#include "redisearch.h"
+#include "gc.h"
+#include "util/arr.h"
+#include "rmutil/sds.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // total bytes collected by the GC
+  size_t totalCollected;
+  // number of passes ran
+  size_t numCycles;
+
+  long long totalMSRun;
+  long long lastRunTimeMs;
+
+  // number of times the GC took the write lock of the index
+  size_t numSlices;
+  // blocks which held deleted documents, and were rewritten
+  size_t blocksRepaired;
+  // blocks which were skipped, since no deleted document falls within their ids
+  size_t blocksSkipped;
+} IncrementalGCStats;
+
+/*
+ * An in-process alternative to the fork GC. A pass repairs the blocks of the inverted indexes in
+ * place, from the GC thread, taking the write lock of the index for a bounded number of blocks at
+ * a time so the writers and the queries can run in between. Only the blocks whose ids range over
+ * a document deleted since the previous pass are rewritten.
+ */
+typedef struct IncrementalGC {
+
+  // owner of the gc
+  WeakRef index;
+
+  RedisModuleCtx *ctx;
+
+  // statistics for reporting
+  IncrementalGCStats stats;
+
+  struct timespec retryInterval;
+
+  // guards `deleted`, which is appended to by the writers
+  pthread_mutex_t lock;
+  // the documents deleted since the current pass began
+  arrayof(t_docId) deleted;
+
+  // The state of a pass, only touched from the GC thread
+
+  // sorted ids of the documents the pass collects
+  arrayof(t_docId) dirty;
+  // whether the pass checks every block, regardless of its ids. Set for the first pass, as the
+  // documents deleted before the index was loaded are not known
+  bool fullPass;
+
+  // cursor of the scan over the keys of the index
+  unsigned long cursor;
+  bool scanDone;
+  // keys returned by the scan, and not collected yet. The last one is in progress
+  arrayof(RedisModuleString *) pending;
+  // the index of the key in progress, and where to resume it from
+  void *current;
+  uint32_t revision;
+  size_t nested;
+  uint32_t block;
+  // the tag values of the tag index in progress
+  arrayof(sds) tagValues;
+  // whether entries were collected from the numeric tree in progress
+  bool numericCollected;
+} IncrementalGC;
+
+IncrementalGC *IGC_New(StrongRef spec_ref, GCCallbacks *callbacks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INCREMENTAL_GC_H_ */
@@ -15,20 +15,31 @@
 #include <sys/param.h>
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
+#include "rmutil/sds.h"
 #include "util/heap.h"
+#include "util/prefetch.h"
 #include "profile.h"
 #include "hybrid_reader.h"
 #include "metric_iterator.h"
 #include "optimizer_reader.h"
+#include "geo_nearest_reader.h"
+#include "sort_index_reader.h"
+#include "ext/default.h"
 
 static int UI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static int UI_SkipToHigh(void *ctx, t_docId docId, RSIndexResult **hit);
 static inline int UI_ReadUnsorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSortedHigh(void *ctx, RSIndexResult **hit);
+static int UI_SkipToTournament(void *ctx, t_docId docId, RSIndexResult **hit);
+static int UI_ReadSortedTournament(void *ctx, RSIndexResult **hit);
 static size_t UI_NumEstimated(void *ctx);
 static IndexCriteriaTester *UI_GetCriteriaTester(void *ctx);
 static size_t UI_Len(void *ctx);
+static int UI_ReadBatch(void *ctx, t_docId *out, size_t max, size_t *n);
+static int UI_ReadBatchBitmap(void *ctx, t_docId *out, size_t max, size_t *n);
+static int UI_ReadSortedBitmap(void *ctx, RSIndexResult **hit);
+static int UI_SkipToBitmap(void *ctx, t_docId docId, RSIndexResult **hit);
 
 static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static int II_ReadUnsorted(void *ctx, RSIndexResult **hit);
@@ -38,8 +49,170 @@ static size_t II_NumEstimated(void *ctx);
 static size_t II_Len(void *ctx);
 static t_docId II_LastDocId(void *ctx);
 
+static IndexIterator *PI_Unwrap(IndexIterator *it);
+
 #define CURRENT_RECORD(ii) (ii)->base.current
 
+/* Block-max pruning state of a union or intersect iterator (see IndexIterator_EnableBlockMax) */
+typedef struct {
+  // The score a document has to beat to make it to the results
+  const double *threshold;
+  // An upper bound of the factor the scores of the terms are multiplied by (the document score)
+  double scale;
+  // The iterator's read function, before pruning was enabled
+  int (*Read)(void *ctx, RSIndexResult **hit);
+} BlockMaxPruning;
+
+/* A child of a union taking part in MaxScore pruning (see IndexIterator_EnableMaxScore) */
+typedef struct {
+  IndexIterator *it;
+  // An upper bound of the score the child contributes to a document
+  double bound;
+} MaxScoreChild;
+
+// The number of docids read from a child iterator at once by a batch reading parent
+#define ITERATOR_BATCH_SIZE 256
+
+/* Docids read ahead from a child iterator by a batch reading union or intersect iterator */
+typedef struct {
+  IndexIterator *it;
+  t_docId *ids;
+  uint32_t pos;
+  uint32_t len;
+  // The status of the last batch read from the child. Once it is not INDEXREAD_OK, the child has
+  // nothing left to read
+  int rc;
+} IteratorBatch;
+
+static IteratorBatch *IteratorBatches_New(IndexIterator **its, uint32_t num) {
+  IteratorBatch *batches = rm_calloc(num, sizeof(*batches));
+  for (uint32_t i = 0; i < num; ++i) {
+    batches[i].it = its[i];
+    batches[i].ids = rm_malloc(ITERATOR_BATCH_SIZE * sizeof(t_docId));
+    batches[i].rc = INDEXREAD_OK;
+  }
+  return batches;
+}
+
+static void IteratorBatches_Free(IteratorBatch *batches, uint32_t num) {
+  if (!batches) {
+    return;
+  }
+  for (uint32_t i = 0; i < num; ++i) {
+    rm_free(batches[i].ids);
+  }
+  rm_free(batches);
+}
+
+/* Move the batch to the first docid of the child which is not smaller than docId, reading more
+ * batches from the child as needed. Returns INDEXREAD_OK if there is one, or the status the child
+ * stopped with otherwise */
+static int IteratorBatch_SkipTo(IteratorBatch *b, t_docId docId) {
+  while (b->pos == b->len || b->ids[b->len - 1] < docId) {
+    if (b->rc != INDEXREAD_OK) {
+      b->pos = b->len;
+      return b->rc;
+    }
+    size_t n = 0;
+    b->rc = IndexIterator_ReadBatch(b->it, b->ids, ITERATOR_BATCH_SIZE, &n);
+    b->pos = 0;
+    b->len = n;
+  }
+
+  // The docid is in this batch; gallop from the current position, then binary search the range
+  uint32_t lo = b->pos, hi = b->pos, step = 1;
+  while (b->ids[hi] < docId) {
+    lo = hi + 1;
+    hi = MIN(hi + step, b->len - 1);
+    step <<= 1;
+  }
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (b->ids[mid] < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  b->pos = lo;
+  return INDEXREAD_OK;
+}
+
+// The number of children from which a union merges them with a tournament tree rather than a heap,
+// as long as they are expected to yield this many docids each on average
+#define UNION_TOURNAMENT_MIN_CHILDREN 64
+#define UNION_TOURNAMENT_MIN_AVERAGE 4
+// The number of children from which a batch reading union may merge them in a docid bitmap
+#define UNION_BITMAP_MIN_CHILDREN 64
+// The number of docids covered by the bitmap of a batch reading union at once
+#define UNION_BITMAP_WINDOW (1 << 16)
+
+/* A tournament tree over the children of a wide union. The leaves hold the next docid of each
+ * child, each inner node the leaf with the smallest docid below it. Unlike a heap, updating a leaf
+ * takes a single comparison per level, and the docids are kept in one array instead of being read
+ * through the children */
+typedef struct {
+  // The number of leaves, a power of 2. Node 1 is the root, node size + i the leaf of child i
+  uint32_t size;
+  uint32_t *nodes;
+  // The next docid of every leaf, 0 before the child is read and DOCID_MAX once it is exhausted
+  t_docId *keys;
+  // The result each child read its next docid into
+  RSIndexResult **hits;
+} UnionTournament;
+
+static UnionTournament *NewUnionTournament(uint32_t num) {
+  UnionTournament *tt = rm_malloc(sizeof(*tt));
+  tt->size = 2;
+  while (tt->size < num) {
+    tt->size <<= 1;
+  }
+  tt->nodes = rm_malloc(tt->size * sizeof(*tt->nodes));
+  tt->keys = rm_malloc(tt->size * sizeof(*tt->keys));
+  tt->hits = rm_malloc(tt->size * sizeof(*tt->hits));
+  return tt;
+}
+
+static void UnionTournament_Free(UnionTournament *tt) {
+  if (!tt) {
+    return;
+  }
+  rm_free(tt->nodes);
+  rm_free(tt->keys);
+  rm_free(tt->hits);
+  rm_free(tt);
+}
+
+static inline uint32_t UnionTournament_Leaf(const UnionTournament *tt, uint32_t node) {
+  return node >= tt->size ? node - tt->size : tt->nodes[node];
+}
+
+static inline void UnionTournament_Play(UnionTournament *tt, uint32_t node) {
+  uint32_t l = UnionTournament_Leaf(tt, 2 * node), r = UnionTournament_Leaf(tt, 2 * node + 1);
+  tt->nodes[node] = tt->keys[l] <= tt->keys[r] ? l : r;
+}
+
+/* Reset the tree to `num` children which were not read yet */
+static void UnionTournament_Reset(UnionTournament *tt, uint32_t num) {
+  for (uint32_t i = 0; i < tt->size; ++i) {
+    tt->keys[i] = i < num ? 0 : DOCID_MAX;
+    tt->hits[i] = NULL;
+  }
+  for (uint32_t node = tt->size - 1; node > 0; --node) {
+    UnionTournament_Play(tt, node);
+  }
+}
+
+/* Set the next docid of a leaf, and replay the matches on its way to the root */
+static void UnionTournament_Update(UnionTournament *tt, uint32_t leaf, t_docId docId,
+                                   RSIndexResult *hit) {
+  tt->keys[leaf] = docId;
+  tt->hits[leaf] = hit;
+  for (uint32_t node = (tt->size + leaf) / 2; node > 0; node /= 2) {
+    UnionTournament_Play(tt, node);
+  }
+}
+
 int cmpMinId(const void *e1, const void *e2, const void *udata) {
   const IndexIterator *it1 = e1, *it2 = e2;
   if (it1->minId < it2->minId) {
@@ -66,6 +239,8 @@ typedef struct {
   uint32_t currIt;
   t_docId minDocId;
   heap_t *heapMinId;
+  // Replaces the heap for unions with many more children
+  UnionTournament *tournament;
 
   // If set to 1, we exit skips after the first hit found and not merge further results
   int quickExit;
@@ -77,6 +252,31 @@ typedef struct {
   QueryNodeType origType;
   // original string for fuzzy or prefix unions
   const char *qstr;
+
+  // The score bounds of the children, used while bounding the union itself. Only allocated if it
+  // takes part in block-max pruning
+  double *childBounds;
+  BlockMaxPruning prune;
+  // The children ordered by their score bounds, lowest first. Only allocated if the union takes
+  // part in MaxScore pruning
+  MaxScoreChild *byBound;
+
+  // Batches of the active children, allocated on the first batch read. The first numActiveBatches
+  // are of the children which are not exhausted yet
+  IteratorBatch *batches;
+  uint32_t numBatches;
+  uint32_t numActiveBatches;
+  // Docids of the children's batches from windowStart on, merged by the batch reads of a union with
+  // many children. Scanned from bit windowPos, refilled once all of it was scanned
+  uint64_t *window;
+  t_docId windowStart;
+  uint32_t windowPos;
+  // Set when reads and skips may merge the children in bitmap windows too, once the records of the
+  // children are not needed (see UI_AllowBitmapMerge)
+  int bitmapMergeable;
+
+  // Set by the creator of the union, handed out instead of a tester made of the children's
+  IndexCriteriaTester *tester;
 } UnionIterator;
 
 static void resetMinIdHeap(UnionIterator *ui) {
@@ -107,6 +307,9 @@ static void UI_SyncIterList(UnionIterator *ui) {
   if (ui->heapMinId) {
     resetMinIdHeap(ui);
   }
+  if (ui->tournament) {
+    UnionTournament_Reset(ui->tournament, ui->num);
+  }
 }
 
 /**
@@ -143,6 +346,9 @@ static void UI_Rewind(void *ctx) {
   CURRENT_RECORD(ui)->docId = 0;
 
   UI_SyncIterList(ui);
+  IteratorBatches_Free(ui->batches, ui->numBatches);
+  ui->batches = NULL;
+  ui->windowPos = UNION_BITMAP_WINDOW;
 
   // rewind all child iterators
   for (size_t i = 0; i < ui->num; i++) {
@@ -194,6 +400,11 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *dt, int
       it->Read = UI_ReadUnsorted;
     }
   }
+  // the children may share many documents, such as the values of a multi-value tag field, but
+  // there are only so many in the index
+  if (dt && ctx->nexpected > dt->size) {
+    ctx->nexpected = dt->size;
+  }
 
   const size_t maxresultsSorted = config->maxResultsToUnsortedMode;
   // this code is normally (and should be) dead.
@@ -216,12 +427,34 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *dt, int
     }
   }
 
+  // Past a few children, finding the next docid by scanning all of them costs more than keeping
+  // them ordered by it. A tournament tree is cheaper to update than a heap, but a heap shrinks as its
+  // children are exhausted, which pays off for shorter children
   if (it->mode == MODE_SORTED && ctx->norig > config->minUnionIterHeap) {
-    it->Read = UI_ReadSortedHigh;
-    it->SkipTo = UI_SkipToHigh;
-    ctx->heapMinId = rm_malloc(heap_sizeof(num));
-    heap_init(ctx->heapMinId, cmpMinId, NULL, num);
-    resetMinIdHeap(ctx);
+    if (ctx->norig >= UNION_TOURNAMENT_MIN_CHILDREN &&
+        ctx->nexpected >= (size_t)ctx->norig * UNION_TOURNAMENT_MIN_AVERAGE) {
+      it->Read = UI_ReadSortedTournament;
+      it->SkipTo = UI_SkipToTournament;
+      ctx->tournament = NewUnionTournament(num);
+      UnionTournament_Reset(ctx->tournament, num);
+    } else {
+      it->Read = UI_ReadSortedHigh;
+      it->SkipTo = UI_SkipToHigh;
+      ctx->heapMinId = rm_malloc(heap_sizeof(num));
+      heap_init(ctx->heapMinId, cmpMinId, NULL, num);
+      resetMinIdHeap(ctx);
+    }
+  }
+  // Merging the batches of many children costs a scan of all of them per docid, while setting their
+  // docids in a bitmap costs a bit each and a scan of its words, which pays off unless the docids are
+  // too sparse
+  if (it->mode == MODE_SORTED) {
+    it->ReadBatch = UI_ReadBatch;
+    if (ctx->norig >= UNION_BITMAP_MIN_CHILDREN &&
+        (!dt || ctx->nexpected * UNION_BITMAP_MIN_CHILDREN >= dt->maxDocId / ctx->norig)) {
+      it->ReadBatch = UI_ReadBatchBitmap;
+      ctx->windowPos = UNION_BITMAP_WINDOW;
+    }
   }
 
   return it;
@@ -231,7 +464,11 @@ void UI_Foreach(IndexIterator *index_it, void (*callback)(IndexReader *it, void
   UnionIterator *ui = index_it->ctx;
   for (int i = 0; i < ui->num; ++i) {
     IndexIterator *it = ui->its[i];
-    callback(it->ctx, privdata);
+    // id-list children (e.g. numeric ranges answered from their sorted column) own a copy of
+    // their ids and have no reader to call back on
+    if (it->type == READ_ITERATOR) {
+      callback(it->ctx, privdata);
+    }
   }
 }
 
@@ -264,6 +501,11 @@ static void UI_TesterFree(struct IndexCriteriaTester *ct) {
 
 static IndexCriteriaTester *UI_GetCriteriaTester(void *ctx) {
   UnionIterator *ui = ctx;
+  if (ui->tester) {
+    IndexCriteriaTester *tester = ui->tester;
+    ui->tester = NULL;
+    return tester;
+  }
   IndexCriteriaTester **children = rm_malloc(ui->num * sizeof(IndexCriteriaTester *));
   for (size_t i = 0; i < ui->num; ++i) {
     children[i] = IITER_GET_CRITERIA_TESTER(ui->origits[i]);
@@ -288,6 +530,37 @@ static size_t UI_NumEstimated(void *ctx) {
   return ui->nexpected;
 }
 
+void UI_SetNumEstimated(IndexIterator *it, size_t nexpected) {
+  RS_LOG_ASSERT(it->type == UNION_ITERATOR, "only union iterators have their estimate set");
+  UnionIterator *ui = it->ctx;
+  ui->nexpected = nexpected;
+}
+
+void UI_AllowBitmapMerge(IndexIterator *it) {
+  RS_LOG_ASSERT(it->type == UNION_ITERATOR, "only union iterators merge in bitmaps");
+  ((UnionIterator *)it->ctx)->bitmapMergeable = 1;
+}
+
+static void UI_SetBitmapMerge(IndexIterator *it) {
+  UnionIterator *ui = it->ctx;
+  if (it->mode != MODE_SORTED) {
+    return;
+  }
+  it->Read = UI_ReadSortedBitmap;
+  it->SkipTo = UI_SkipToBitmap;
+  it->ReadBatch = UI_ReadBatchBitmap;
+  ui->windowPos = UNION_BITMAP_WINDOW;
+}
+
+void UI_SetCriteriaTester(IndexIterator *it, IndexCriteriaTester *tester) {
+  RS_LOG_ASSERT(it->type == UNION_ITERATOR, "only union iterators have their tester set");
+  UnionIterator *ui = it->ctx;
+  if (ui->tester) {
+    ui->tester->Free(ui->tester);
+  }
+  ui->tester = tester;
+}
+
 static inline int UI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
   UnionIterator *ui = ctx;
   int rc = INDEXREAD_OK;
@@ -324,6 +597,14 @@ static inline int UI_ReadSorted(void *ctx, RSIndexResult **hit) {
     unsigned nits = ui->num;
 
     for (unsigned i = 0; i < nits; i++) {
+      // bring in the iterator two children ahead and the record of the next one, so that their
+      // misses overlap the reads of this child
+      if (i + 2 < nits) {
+        RS_PREFETCH(ui->its[i + 2]);
+      }
+      if (i + 1 < nits) {
+        RS_PREFETCH(IITER_CURRENT_RECORD(ui->its[i + 1]));
+      }
       IndexIterator *it = ui->its[i];
       RSIndexResult *res = IITER_CURRENT_RECORD(it);
       rc = INDEXREAD_OK;
@@ -433,6 +714,159 @@ static inline int UI_ReadSortedHigh(void *ctx, RSIndexResult **hit) {
   return INDEXREAD_OK;
 }
 
+/* Batch read of a sorted union: merge the children's batches, dropping duplicate docids */
+static int UI_ReadBatch(void *ctx, t_docId *out, size_t max, size_t *n) {
+  UnionIterator *ui = ctx;
+  if (!ui->batches) {
+    ui->batches = IteratorBatches_New(ui->its, ui->num);
+    ui->numBatches = ui->numActiveBatches = ui->num;
+  }
+
+  *n = 0;
+  while (*n < max) {
+    t_docId minId = UINT64_MAX;
+    for (uint32_t i = 0; i < ui->numActiveBatches; ++i) {
+      IteratorBatch *b = ui->batches + i;
+      int rc = IteratorBatch_SkipTo(b, ui->minDocId + 1);
+      if (rc == INDEXREAD_TIMEOUT) {
+        ui->len += *n;
+        return *n ? INDEXREAD_OK : rc;
+      } else if (rc != INDEXREAD_OK) {
+        // Exhausted child, move it past the active ones
+        IteratorBatch tmp = *b;
+        *b = ui->batches[--ui->numActiveBatches];
+        ui->batches[ui->numActiveBatches] = tmp;
+        --i;
+        continue;
+      }
+      minId = MIN(minId, b->ids[b->pos]);
+    }
+    if (!ui->numActiveBatches) {
+      IITER_SET_EOF(&ui->base);
+      break;
+    }
+    out[(*n)++] = ui->minDocId = minId;
+  }
+  ui->len += *n;
+  return *n ? INDEXREAD_OK : INDEXREAD_EOF;
+}
+
+/* Batch read of a sorted union with many children: set the docids of the children's batches in a
+ * bitmap window, then yield the set bits. Each child is only moved past a window once */
+static int UI_ReadBatchBitmap(void *ctx, t_docId *out, size_t max, size_t *n) {
+  UnionIterator *ui = ctx;
+  if (!ui->batches) {
+    ui->batches = IteratorBatches_New(ui->its, ui->num);
+    ui->numBatches = ui->numActiveBatches = ui->num;
+  }
+  if (!ui->window) {
+    ui->window = rm_malloc(UNION_BITMAP_WINDOW / 64 * sizeof(*ui->window));
+  }
+
+  *n = 0;
+  while (*n < max) {
+    if (ui->windowPos == UNION_BITMAP_WINDOW) {
+      // start the next window at the smallest docid left in the batches
+      t_docId start = DOCID_MAX;
+      for (uint32_t i = 0; i < ui->numActiveBatches; ++i) {
+        IteratorBatch *b = ui->batches + i;
+        int rc = IteratorBatch_SkipTo(b, ui->minDocId + 1);
+        if (rc == INDEXREAD_TIMEOUT) {
+          ui->len += *n;
+          return *n ? INDEXREAD_OK : rc;
+        } else if (rc != INDEXREAD_OK) {
+          // Exhausted child, move it past the active ones
+          IteratorBatch tmp = *b;
+          *b = ui->batches[--ui->numActiveBatches];
+          ui->batches[ui->numActiveBatches] = tmp;
+          --i;
+          continue;
+        }
+        start = MIN(start, b->ids[b->pos]);
+      }
+      if (!ui->numActiveBatches) {
+        IITER_SET_EOF(&ui->base);
+        break;
+      }
+
+      memset(ui->window, 0, UNION_BITMAP_WINDOW / 64 * sizeof(*ui->window));
+      t_docId end = start + UNION_BITMAP_WINDOW;
+      for (uint32_t i = 0; i < ui->numActiveBatches; ++i) {
+        IteratorBatch *b = ui->batches + i;
+        // the batch is not exhausted yet, it was just moved to its next docid
+        while (b->ids[b->pos] < end) {
+          t_docId bit = b->ids[b->pos] - start;
+          ui->window[bit / 64] |= 1ULL << (bit % 64);
+          if (++b->pos == b->len &&
+              IteratorBatch_SkipTo(b, b->ids[b->len - 1] + 1) != INDEXREAD_OK) {
+            // left for the next window to find out
+            break;
+          }
+        }
+      }
+      ui->windowStart = start;
+      ui->windowPos = 0;
+    }
+
+    // yield the set bits from windowPos on
+    uint32_t word = ui->windowPos / 64;
+    uint64_t bits = ui->window[word] & (~0ULL << (ui->windowPos % 64));
+    while (!bits && ++word < UNION_BITMAP_WINDOW / 64) {
+      bits = ui->window[word];
+    }
+    if (!bits) {
+      ui->windowPos = UNION_BITMAP_WINDOW;
+      continue;
+    }
+    uint32_t bit = word * 64 + __builtin_ctzll(bits);
+    out[(*n)++] = ui->minDocId = ui->windowStart + bit;
+    ui->windowPos = bit + 1;
+  }
+  ui->len += *n;
+  return *n ? INDEXREAD_OK : INDEXREAD_EOF;
+}
+
+/* Read of a union merging its children in bitmap windows: the next set bit, as a record without
+ * children */
+static int UI_ReadSortedBitmap(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+  t_docId docId;
+  size_t n;
+  int rc = UI_ReadBatchBitmap(ctx, &docId, 1, &n);
+  if (rc != INDEXREAD_OK) {
+    return rc;
+  }
+  AggregateResult_Reset(CURRENT_RECORD(ui));
+  CURRENT_RECORD(ui)->weight = ui->weight;
+  CURRENT_RECORD(ui)->docId = docId;
+  *hit = CURRENT_RECORD(ui);
+  return INDEXREAD_OK;
+}
+
+/* Skip of a union merging its children in bitmap windows. A docid in the current window moves the
+ * scan of its bits, a docid past it starts the next window there */
+static int UI_SkipToBitmap(void *ctx, t_docId docId, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (docId > ui->minDocId + 1) {
+    if (!ui->window || ui->windowPos == UNION_BITMAP_WINDOW ||
+        docId >= ui->windowStart + UNION_BITMAP_WINDOW) {
+      ui->windowPos = UNION_BITMAP_WINDOW;
+      ui->minDocId = docId - 1;
+    } else if (docId > ui->windowStart + ui->windowPos) {
+      // the window has no docid below its start
+      ui->windowPos = docId - ui->windowStart;
+    }
+  }
+  int rc = UI_ReadSortedBitmap(ctx, hit);
+  if (rc != INDEXREAD_OK) {
+    return rc;
+  }
+  return (*hit)->docId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
 /**
 Skip to the given docId, or one place after it
 @param ctx IndexReader context
@@ -601,6 +1035,92 @@ static int UI_SkipToHigh(void *ctx, t_docId docId, RSIndexResult **hit) {
   return rc;
 }
 
+/* Collect the results of all the children below `node` which are at docId */
+static void UI_TournamentAddChildren(UnionIterator *ui, uint32_t node, t_docId docId) {
+  UnionTournament *tt = ui->tournament;
+  uint32_t leaf = UnionTournament_Leaf(tt, node);
+  if (tt->keys[leaf] != docId) {
+    return;
+  }
+  if (node >= tt->size) {
+    AggregateResult_AddChild(CURRENT_RECORD(ui), tt->hits[leaf]);
+    return;
+  }
+  UI_TournamentAddChildren(ui, 2 * node, docId);
+  UI_TournamentAddChildren(ui, 2 * node + 1, docId);
+}
+
+/* Move the children of the tournament which are behind docId to it or past it, and yield the
+ * results of the ones at the smallest docid */
+static int UI_TournamentAdvance(UnionIterator *ui, t_docId docId, RSIndexResult **hit) {
+  UnionTournament *tt = ui->tournament;
+  AggregateResult_Reset(CURRENT_RECORD(ui));
+  CURRENT_RECORD(ui)->weight = ui->weight;
+
+  uint32_t leaf;
+  while (1) {
+    leaf = tt->nodes[1];
+    t_docId minId = tt->keys[leaf];
+    if (minId >= docId) {
+      break;
+    }
+    IndexIterator *it = ui->its[leaf];
+    RSIndexResult *res = NULL;
+    if (it->SkipTo(it->ctx, docId, &res) == INDEXREAD_EOF) {
+      UnionTournament_Update(tt, leaf, DOCID_MAX, NULL);
+      continue;
+    }
+    it->minId = res->docId;
+    UnionTournament_Update(tt, leaf, res->docId, res);
+    // the other children may still be behind, but one result is enough
+    if (ui->quickExit && res->docId == docId) {
+      break;
+    }
+  }
+
+  t_docId minId = tt->keys[leaf];
+  if (minId == DOCID_MAX) {
+    IITER_SET_EOF(&ui->base);
+    return INDEXREAD_EOF;
+  }
+
+  // On quickExit we just return one result.
+  // Otherwise, we collect all the results that equal to the root of the tree.
+  if (ui->quickExit) {
+    AggregateResult_AddChild(CURRENT_RECORD(ui), tt->hits[leaf]);
+  } else {
+    UI_TournamentAddChildren(ui, 1, minId);
+  }
+  ui->minDocId = minId;
+  *hit = CURRENT_RECORD(ui);
+  return minId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+// UI_Read for iterator with a tournament tree of children
+static int UI_ReadSortedTournament(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+  if (UI_TournamentAdvance(ui, ui->minDocId + 1, hit) == INDEXREAD_EOF) {
+    return INDEXREAD_EOF;
+  }
+  ui->len++;
+  return INDEXREAD_OK;
+}
+
+// UI_SkipTo for iterator with a tournament tree of children
+static int UI_SkipToTournament(void *ctx, t_docId docId, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (docId == 0) {
+    return UI_ReadSortedTournament(ctx, hit);
+  }
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+  return UI_TournamentAdvance(ui, docId, hit);
+}
+
 void UnionIterator_Free(IndexIterator *itbase) {
   if (itbase == NULL) return;
 
@@ -612,8 +1132,16 @@ void UnionIterator_Free(IndexIterator *itbase) {
     }
   }
 
+  if (ui->tester) {
+    ui->tester->Free(ui->tester);
+  }
   IndexResult_Free(CURRENT_RECORD(ui));
   if (ui->heapMinId) heap_free(ui->heapMinId);
+  UnionTournament_Free(ui->tournament);
+  IteratorBatches_Free(ui->batches, ui->numBatches);
+  rm_free(ui->window);
+  rm_free(ui->childBounds);
+  rm_free(ui->byBound);
   rm_free(ui->its);
   rm_free(ui->origits);
   rm_free(ui);
@@ -661,6 +1189,7 @@ void trimUnionIterator(IndexIterator *iter, size_t offset, size_t limit, bool as
   }
   if (unsort) {
     iter->Read = UI_ReadUnsorted;
+    iter->ReadBatch = NULL;
   }
 }
 
@@ -671,6 +1200,8 @@ typedef struct {
   IndexIterator **its;
   IndexIterator *bestIt;
   IndexCriteriaTester **testers;
+  // Children whose documents are tested rather than iterated, kept until the intersection is freed
+  IndexIterator **testedIts;
   t_docId *docIds;
   int *rcs;
   unsigned num;
@@ -687,8 +1218,26 @@ typedef struct {
   t_fieldMask fieldMask;
   double weight;
   size_t nexpected;
+  BlockMaxPruning prune;
+
+  // Batches of the children, allocated on the first batch read
+  IteratorBatch *batches;
+  uint32_t numBatches;
+
+  // Set if nothing needs the records of the children, only the docid (see
+  // IndexIterator_EnableDocIdsOnly)
+  int docIdsOnly;
 } IntersectIterator;
 
+/* Add the record of a child matching the current docid to the intersection */
+static inline void II_AddChild(IntersectIterator *ic, RSIndexResult *res) {
+  if (ic->docIdsOnly) {
+    ic->base.current->docId = res->docId;
+  } else {
+    AggregateResult_AddChild(ic->base.current, res);
+  }
+}
+
 void IntersectIterator_Free(IndexIterator *it) {
   if (it == NULL) return;
   IntersectIterator *ui = it->ctx;
@@ -707,7 +1256,12 @@ void IntersectIterator_Free(IndexIterator *it) {
   if (ui->bestIt) {
     ui->bestIt->Free(ui->bestIt);
   }
+  for (size_t i = 0; i < array_len(ui->testedIts); i++) {
+    ui->testedIts[i]->Free(ui->testedIts[i]);
+  }
+  array_free(ui->testedIts);
 
+  IteratorBatches_Free(ui->batches, ui->numBatches);
   rm_free(ui->docIds);
   rm_free(ui->its);
   IndexResult_Free(it->current);
@@ -729,6 +1283,8 @@ static void II_Rewind(void *ctx) {
   IntersectIterator *ii = ctx;
   ii->base.isValid = 1;
   ii->lastDocId = 0;
+  IteratorBatches_Free(ii->batches, ii->numBatches);
+  ii->batches = NULL;
 
   // rewind all child iterators
   for (int i = 0; i < ii->num; i++) {
@@ -826,7 +1382,9 @@ static void II_SortChildren(IntersectIterator *ctx) {
         continue;
       }
       IndexCriteriaTester *tester = IITER_GET_CRITERIA_TESTER(cur);
-      ctx->testers = array_ensure_append(ctx->testers, &tester, 1, IndexCriteriaTester *);
+      if (tester) {
+        ctx->testers = array_ensure_append(ctx->testers, &tester, 1, IndexCriteriaTester *);
+      }
       cur->Free(cur);
     }
   } else {
@@ -839,6 +1397,59 @@ static void II_SortChildren(IntersectIterator *ctx) {
   array_free(unsortedIts);
 }
 
+// A child is tested against the documents of the others rather than intersected with them when
+// it is expected to yield at least this many times more documents than the most selective one
+#define II_TESTER_RATIO 16
+
+/* Choose, for each child, between skipping through it and testing the documents of the others
+ * against it. Skipping through a broad union of numeric ranges costs a step on each of its ranges,
+ * while its tester checks a document at once. A tested child leaves no record in the results, and
+ * so no share of their score, hence the testers are only planned for queries needing no records
+ * (see IndexIterator_EnableDocIdsOnly). Only intersections without slop, order or field
+ * constraints can leave children out of the results */
+static void II_PlanTesters(IntersectIterator *ctx) {
+  if (ctx->num < 2 || ctx->maxSlop >= 0 || ctx->inOrder || ctx->fieldMask != RS_FIELDMASK_ALL) {
+    return;
+  }
+  size_t best = SIZE_MAX;
+  for (size_t i = 0; i < ctx->num; ++i) {
+    if (!ctx->its[i]) {
+      return;
+    }
+    best = MIN(best, IITER_NUM_ESTIMATED(ctx->its[i]));
+  }
+
+  size_t n = 0;
+  for (size_t i = 0; i < ctx->num; ++i) {
+    IndexIterator *cur = ctx->its[i];
+    // a profiled child is tested as the iterator it wraps, and still reported as a child
+    IndexIterator *inner = PI_Unwrap(cur);
+    IndexCriteriaTester *tester = NULL;
+    // the most selective child always drives the iteration
+    if (n + (ctx->num - i) > 1 && inner->type == UNION_ITERATOR &&
+        ((UnionIterator *)inner->ctx)->origType == QN_NUMERIC &&
+        IITER_NUM_ESTIMATED(cur) >= MAX(best, 1) * II_TESTER_RATIO) {
+      tester = IITER_GET_CRITERIA_TESTER(inner);
+    }
+    if (!tester) {
+      ctx->its[n++] = cur;
+      continue;
+    }
+    ctx->testers = array_ensure_append(ctx->testers, &tester, 1, IndexCriteriaTester *);
+    ctx->testedIts = array_ensure_append(ctx->testedIts, &cur, 1, IndexIterator *);
+  }
+  ctx->num = n;
+}
+
+static inline int II_TestCriteria(const IntersectIterator *ic, t_docId docId) {
+  for (size_t i = 0; i < array_len(ic->testers); ++i) {
+    if (!ic->testers[i]->Test(ic->testers[i], docId)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 void AddIntersectIterator(IndexIterator *parentIter, IndexIterator *childIter) {
   RS_LOG_ASSERT(parentIter->type == INTERSECT_ITERATOR, "add applies to intersect iterators only");
   IntersectIterator *ii = (IntersectIterator *)parentIter;
@@ -847,6 +1458,48 @@ void AddIntersectIterator(IndexIterator *parentIter, IndexIterator *childIter) {
   ii->its[ii->num - 1] = childIter;
 }
 
+/* Batch read of an intersection without slop, order or field constraints: leapfrog over the
+ * children's batches, moving each one to the highest docid seen so far until they all agree */
+static int II_ReadBatch(void *ctx, t_docId *out, size_t max, size_t *n) {
+  IntersectIterator *ic = ctx;
+  *n = 0;
+  if (!ic->num || !ic->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  if (!ic->batches) {
+    ic->batches = IteratorBatches_New(ic->its, ic->num);
+    ic->numBatches = ic->num;
+  }
+
+  while (*n < max) {
+    // lastDocId is the next docid to look for
+    unsigned matched = 0;
+    for (unsigned i = 0; matched < ic->num; i = (i + 1) % ic->num) {
+      IteratorBatch *b = ic->batches + i;
+      int rc = IteratorBatch_SkipTo(b, ic->lastDocId);
+      if (rc != INDEXREAD_OK) {
+        if (rc == INDEXREAD_EOF) {
+          ic->base.isValid = 0;
+        }
+        ic->len += *n;
+        return *n ? INDEXREAD_OK : rc;
+      }
+      if (b->ids[b->pos] == ic->lastDocId) {
+        ++matched;
+      } else {
+        ic->lastDocId = b->ids[b->pos];
+        matched = 1;
+      }
+    }
+    t_docId docId = ic->lastDocId++;
+    if (II_TestCriteria(ic, docId)) {
+      out[(*n)++] = ic->lastFoundId = docId;
+    }
+  }
+  ic->len += *n;
+  return INDEXREAD_OK;
+}
+
 IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *dt,
                                    t_fieldMask fieldMask, int maxSlop, int inOrder, double weight) {
   // printf("Creating new intersection iterator with fieldMask=%llx\n", fieldMask);
@@ -888,6 +1541,9 @@ IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *d
   it->HasNext = NULL;
   it->mode = MODE_SORTED;
   II_SortChildren(ctx);
+  if (it->mode == MODE_SORTED && maxSlop < 0 && !inOrder && fieldMask == RS_FIELDMASK_ALL) {
+    it->ReadBatch = II_ReadBatch;
+  }
   return it;
 }
 
@@ -925,7 +1581,7 @@ static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     } else if (rc == INDEXREAD_OK) {
       // YAY! found!
       if (res && res->docId == docId) {
-        AggregateResult_AddChild(ic->base.current, res);
+        II_AddChild(ic, res);
       }
       ic->lastDocId = docId;
 
@@ -944,8 +1600,9 @@ static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
     // Update the last found id
     // if maxSlop == -1 there is no need to verify maxSlop and inorder, otherwise lets verify
-    if (ic->maxSlop == -1 ||
-        IndexResult_IsWithinRange(ic->base.current, ic->maxSlop, ic->inOrder)) {
+    if ((ic->maxSlop == -1 ||
+         IndexResult_IsWithinRange(ic->base.current, ic->maxSlop, ic->inOrder)) &&
+        II_TestCriteria(ic, docId)) {
       ic->lastFoundId = ic->base.current->docId;
       ic->lastDocId++;
       if (hit) *hit = ic->base.current;
@@ -971,14 +1628,7 @@ static int II_ReadUnsorted(void *ctx, RSIndexResult **hit) {
     if (rc == INDEXREAD_EOF) {
       return INDEXREAD_EOF;
     }
-    int isMatch = 1;
-    for (size_t i = 0; i < array_len(ic->testers); ++i) {
-      if (!ic->testers[i]->Test(ic->testers[i], res->docId)) {
-        isMatch = 0;
-        break;
-      }
-    }
-    if (!isMatch) {
+    if (!II_TestCriteria(ic, res->docId)) {
       continue;
     }
     *hit = res;
@@ -1012,6 +1662,10 @@ static void II_TesterFree(struct IndexCriteriaTester *ct) {
 
 static IndexCriteriaTester *II_GetCriteriaTester(void *ctx) {
   IntersectIterator *ic = ctx;
+  if (array_len(ic->testers)) {
+    // the children tested by the intersection have handed their testers to it already
+    return NULL;
+  }
   for (size_t i = 0; i < ic->num; ++i) {
     IndexCriteriaTester *tester = NULL;
     if (ic->its[i]) {
@@ -1055,6 +1709,9 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
       IndexIterator *it = ic->its[i];
 
       if (!it) goto eof;
+      if (i + 1 < ic->num) {
+        RS_PREFETCH(ic->its[i + 1]);
+      }
 
       RSIndexResult *h = IITER_CURRENT_RECORD(it);
       // skip to the next
@@ -1079,7 +1736,7 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
       }
       if (rc == INDEXREAD_OK) {
         ++nh;
-        AggregateResult_AddChild(ic->base.current, h);
+        II_AddChild(ic, h);
       } else {
         ic->lastDocId++;
       }
@@ -1112,11 +1769,9 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
         }
       }
 
-      //      for(size_t i = 0 ; i < array_len(ic->testers) ; ++i){
-      //        if(!ic->testers[i]->TextCriteria(ic->testers[i]->ctx, ic->lastFoundId)){
-      //          continue;
-      //        }
-      //      }
+      if (!II_TestCriteria(ic, ic->lastFoundId)) {
+        continue;
+      }
 
       ic->len++;
       // printf("Returning OK\n");
@@ -1137,6 +1792,246 @@ static size_t II_Len(void *ctx) {
   return ((IntersectIterator *)ctx)->len;
 }
 
+/**********************************************************************************************
+ * Block-max pruning.
+ *
+ * When the results are the top-k documents by BM25STD score, a document can only make it to the
+ * results if its score beats the lowest score in the top-k heap. Every block of a term's inverted
+ * index holds the maximal frequency of its entries, which bounds the score the term contributes to
+ * the documents of that block. After reading a document we work out a window of ids, starting at
+ * that document, in which each term stays within its current block, and the bound of the window
+ * is the (weighted) sum of the bounds of the terms which can appear in it. If it does not beat the
+ * threshold, we skip all the children past the whole window without scoring any of its documents.
+ **********************************************************************************************/
+
+/* Return an upper bound of the score of any document yielded by `it` from its current document up
+ * to `*windowEnd`, lowering `*windowEnd` to the last document the bound holds for */
+static double blockMaxBound(IndexIterator *it, t_docId *windowEnd) {
+  switch (it->type) {
+    case READ_ITERATOR: {
+      IndexReader *ir = it->ctx;
+      const IndexBlock *blk = IR_CurrentBlock(ir);
+      if (blk->lastId < *windowEnd) {
+        *windowEnd = blk->lastId;
+      }
+      return BM25Std_TermUpperBound(ir->record->term.term->bm25_idf, blk->maxFreq);
+    }
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      for (size_t i = 0; i < ui->num; ++i) {
+        ui->childBounds[i] = IITER_HAS_NEXT(ui->its[i]) ? blockMaxBound(ui->its[i], windowEnd) : 0;
+      }
+      // Children which are already past the window do not contribute to it
+      double bound = 0;
+      for (size_t i = 0; i < ui->num; ++i) {
+        if (ui->its[i]->minId <= *windowEnd) {
+          bound += ui->childBounds[i];
+        }
+      }
+      return bound * ui->weight;
+    }
+    case INTERSECT_ITERATOR: {
+      IntersectIterator *ic = it->ctx;
+      double bound = 0;
+      for (size_t i = 0; i < ic->num; ++i) {
+        bound += blockMaxBound(ic->its[i], windowEnd);
+      }
+      return bound * ic->weight;
+    }
+    default:
+      RS_LOG_ASSERT(0, "iterator does not support block-max pruning");
+      return INFINITY;
+  }
+}
+
+static int blockMaxRead(IndexIterator *it, const BlockMaxPruning *prune, RSIndexResult **hit) {
+  int rc = prune->Read(it->ctx, hit);
+  // The threshold is 0 until the heap is full
+  while (rc == INDEXREAD_OK && *prune->threshold > 0) {
+    t_docId windowEnd = DOCID_MAX;
+    double bound = blockMaxBound(it, &windowEnd) * prune->scale;
+    if (bound >= *prune->threshold || windowEnd < (*hit)->docId || windowEnd == DOCID_MAX) {
+      break;
+    }
+    // Nothing up to the end of the window can make it to the results
+    t_docId target = windowEnd + 1;
+    while ((rc = it->SkipTo(it->ctx, target, hit)) == INDEXREAD_NOTFOUND) {
+      target = (*hit)->docId > target ? (*hit)->docId : target + 1;
+    }
+  }
+  return rc;
+}
+
+static int UI_ReadBlockMax(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  return blockMaxRead(&ui->base, &ui->prune, hit);
+}
+
+static int II_ReadBlockMax(void *ctx, RSIndexResult **hit) {
+  IntersectIterator *ic = ctx;
+  return blockMaxRead(&ic->base, &ic->prune, hit);
+}
+
+static int blockMaxSupported(IndexIterator *it) {
+  if (!it) return 0;
+  switch (it->type) {
+    case READ_ITERATOR: {
+      IndexReader *ir = it->ctx;
+      return ir->record->type == RSResultType_Term && ir->record->term.term != NULL;
+    }
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      if (it->mode != MODE_SORTED || ui->quickExit) return 0;
+      for (size_t i = 0; i < ui->norig; ++i) {
+        if (!blockMaxSupported(ui->origits[i])) return 0;
+      }
+      return 1;
+    }
+    case INTERSECT_ITERATOR: {
+      IntersectIterator *ic = it->ctx;
+      if (it->mode != MODE_SORTED) return 0;
+      for (size_t i = 0; i < ic->num; ++i) {
+        if (!blockMaxSupported(ic->its[i])) return 0;
+      }
+      return 1;
+    }
+    default:
+      return 0;
+  }
+}
+
+static void blockMaxAllocBounds(IndexIterator *it) {
+  if (it->type == UNION_ITERATOR) {
+    UnionIterator *ui = it->ctx;
+    ui->childBounds = rm_calloc(ui->norig, sizeof(*ui->childBounds));
+    for (size_t i = 0; i < ui->norig; ++i) {
+      blockMaxAllocBounds(ui->origits[i]);
+    }
+  } else if (it->type == INTERSECT_ITERATOR) {
+    IntersectIterator *ic = it->ctx;
+    for (size_t i = 0; i < ic->num; ++i) {
+      blockMaxAllocBounds(ic->its[i]);
+    }
+  }
+}
+
+int IndexIterator_EnableBlockMax(IndexIterator *it, const double *threshold, double scale) {
+  if ((it->type != UNION_ITERATOR && it->type != INTERSECT_ITERATOR) || !blockMaxSupported(it)) {
+    return 0;
+  }
+  blockMaxAllocBounds(it);
+
+  BlockMaxPruning prune = {.threshold = threshold, .scale = scale, .Read = it->Read};
+  // Batch reads fall back to the pruned Read
+  it->ReadBatch = NULL;
+  if (it->type == UNION_ITERATOR) {
+    ((UnionIterator *)it->ctx)->prune = prune;
+    it->Read = UI_ReadBlockMax;
+  } else {
+    ((IntersectIterator *)it->ctx)->prune = prune;
+    it->Read = II_ReadBlockMax;
+  }
+  return 1;
+}
+
+/**********************************************************************************************
+ * MaxScore pruning.
+ *
+ * The TFIDF score a term contributes to a document is normalized by the highest frequency of any
+ * term in the document, so it is bounded by the (weighted) IDF of the term wherever it appears.
+ * The children of a union of terms are ordered by their bounds, and the children with the lowest
+ * bounds, which cannot beat the threshold even together, are non-essential: a document matched by
+ * them alone cannot make it to the results. When the union reads such a document, we skip all the
+ * children to the next document of an essential child without scoring the ones in between.
+ **********************************************************************************************/
+
+/* Return the first document from docId on which may beat the threshold, or DOCID_MAX if no
+ * document can */
+static t_docId maxScoreTarget(const UnionIterator *ui, t_docId docId) {
+  double threshold = *ui->prune.threshold;
+  double scale = ui->prune.scale * ui->weight;
+  double bound = 0;
+  t_docId target = DOCID_MAX;
+  for (size_t i = 0; i < ui->norig; ++i) {
+    const MaxScoreChild *c = &ui->byBound[i];
+    if (!IITER_HAS_NEXT(c->it)) {
+      continue;
+    }
+    if (target == DOCID_MAX) {
+      bound += c->bound;
+      if (bound * scale < threshold) {
+        continue;
+      }
+    }
+    // This child and the ones after it are essential
+    target = MIN(target, c->it->minId);
+    if (target <= docId) {
+      break;
+    }
+  }
+  return target;
+}
+
+static int UI_ReadMaxScore(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  int rc = ui->prune.Read(ctx, hit);
+  // The threshold is 0 until the heap is full
+  while (rc == INDEXREAD_OK && *ui->prune.threshold > 0) {
+    t_docId target = maxScoreTarget(ui, (*hit)->docId);
+    if (target <= (*hit)->docId) {
+      break;
+    }
+    if (target == DOCID_MAX) {
+      // Nothing left can make it to the results
+      ui->base.Abort(ctx);
+      return INDEXREAD_EOF;
+    }
+    while ((rc = ui->base.SkipTo(ctx, target, hit)) == INDEXREAD_NOTFOUND) {
+      target = (*hit)->docId > target ? (*hit)->docId : target + 1;
+    }
+  }
+  return rc;
+}
+
+static int cmpMaxScoreChild(const void *p1, const void *p2) {
+  const MaxScoreChild *c1 = p1, *c2 = p2;
+  return c1->bound < c2->bound ? -1 : (c1->bound > c2->bound ? 1 : 0);
+}
+
+int IndexIterator_EnableMaxScore(IndexIterator *it, const double *threshold, double scale) {
+  if (it->type != UNION_ITERATOR || it->mode != MODE_SORTED) {
+    return 0;
+  }
+  UnionIterator *ui = it->ctx;
+  if (ui->quickExit || ui->norig < 2 || ui->norig > MAXSCORE_MAX_CHILDREN) {
+    return 0;
+  }
+  for (size_t i = 0; i < ui->norig; ++i) {
+    const IndexIterator *child = ui->origits[i];
+    if (child->type != READ_ITERATOR) {
+      return 0;
+    }
+    const IndexReader *ir = child->ctx;
+    if (ir->record->type != RSResultType_Term || !ir->record->term.term) {
+      return 0;
+    }
+  }
+
+  ui->byBound = rm_malloc(ui->norig * sizeof(*ui->byBound));
+  for (size_t i = 0; i < ui->norig; ++i) {
+    const IndexReader *ir = ui->origits[i]->ctx;
+    ui->byBound[i].it = ui->origits[i];
+    ui->byBound[i].bound = ir->record->term.term->idf * ir->record->weight;
+  }
+  qsort(ui->byBound, ui->norig, sizeof(*ui->byBound), cmpMaxScoreChild);
+
+  ui->prune = (BlockMaxPruning){.threshold = threshold, .scale = scale, .Read = it->Read};
+  // Batch reads fall back to the pruned Read
+  it->ReadBatch = NULL;
+  it->Read = UI_ReadMaxScore;
+  return 1;
+}
+
 /* A Not iterator works by wrapping another iterator, and returning OK for misses, and NOTFOUND
  * for hits */
 typedef struct {
@@ -1147,6 +2042,8 @@ typedef struct {
   t_docId maxDocId;
   size_t len;
   double weight;
+  const DocTable *docs;  // if set, the live documents are complemented rather than all the ids
+  int childEOF;
 } NotIterator, NotContext;
 
 static void NI_Abort(void *ctx) {
@@ -1157,6 +2054,7 @@ static void NI_Abort(void *ctx) {
 
 static void NI_Rewind(void *ctx) {
   NotContext *nc = ctx;
+  nc->childEOF = 0;
   nc->lastDocId = 0;
   nc->base.current->docId = 0;
   nc->base.isValid = 1;
@@ -1186,6 +2084,14 @@ static int NI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     return INDEXREAD_EOF;
   }
 
+  // deleted documents never match
+  if (nc->docs && !DocTable_IsLive(nc->docs, docId)) {
+    nc->base.current->docId = docId;
+    nc->lastDocId = docId;
+    *hit = nc->base.current;
+    return INDEXREAD_NOTFOUND;
+  }
+
   // Get the child's last read docId
   // if lastDocId is 0, Read & Skipto weren't called yet and child lastId
   // might not be be updated (ex. NUMERIC filter) (PR-2440)
@@ -1324,6 +2230,36 @@ ok:
   return INDEXREAD_OK;
 }
 
+/* Read from a NOT iterator complementing the live documents. Deleted documents are skipped a
+ * word of the live documents bitmap at a time, and the child is skipped to the next candidate */
+static int NI_ReadSortedLive(void *ctx, RSIndexResult **hit) {
+  NotContext *nc = ctx;
+  t_docId docId = nc->base.current->docId;
+  while (1) {
+    docId = DocTable_NextLive(nc->docs, docId + 1);
+    if (!docId || docId > nc->maxDocId) {
+      nc->lastDocId = nc->maxDocId + 1;
+      IITER_SET_EOF(&nc->base);
+      return INDEXREAD_EOF;
+    }
+
+    RSIndexResult *cr = IITER_CURRENT_RECORD(nc->child);
+    if (!nc->childEOF && (!cr || cr->docId < docId)) {
+      if (nc->child->SkipTo(nc->child->ctx, docId, &cr) == INDEXREAD_EOF) {
+        nc->childEOF = 1;
+      }
+    }
+    if (nc->childEOF || !cr || cr->docId != docId) {
+      break;
+    }
+  }
+
+  nc->base.current->docId = nc->lastDocId = docId;
+  if (hit) *hit = nc->base.current;
+  ++nc->len;
+  return INDEXREAD_OK;
+}
+
 /* We always have next, in case anyone asks... ;) */
 static int NI_HasNext(void *ctx) {
   NotContext *nc = ctx;
@@ -1344,7 +2280,8 @@ static t_docId NI_LastDocId(void *ctx) {
   return nc->lastDocId;
 }
 
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight) {
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight,
+                              const DocTable *docs) {
   NotContext *nc = rm_malloc(sizeof(*nc));
   nc->base.current = NewVirtualResult(weight);
   nc->base.current->fieldMask = RS_FIELDMASK_ALL;
@@ -1355,6 +2292,8 @@ IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight
   nc->maxDocId = maxDocId;
   nc->len = 0;
   nc->weight = weight;
+  nc->docs = docs;
+  nc->childEOF = 0;
   nc->base.isValid = 1;
 
   IndexIterator *ret = &nc->base;
@@ -1368,6 +2307,7 @@ IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight
   ret->Len = NI_Len;
   ret->Read = NI_ReadSorted;
   ret->SkipTo = NI_SkipTo;
+  ret->ReadBatch = NULL;
   ret->Abort = NI_Abort;
   ret->Rewind = NI_Rewind;
   ret->mode = MODE_SORTED;
@@ -1376,6 +2316,8 @@ IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight
     nc->childCT = IITER_GET_CRITERIA_TESTER(nc->child);
     RS_LOG_ASSERT(nc->childCT, "childCT should not be NULL");
     ret->Read = NI_ReadUnsorted;
+  } else if (docs) {
+    ret->Read = NI_ReadSortedLive;
   }
 
   return ret;
@@ -1605,6 +2547,100 @@ IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double w
   return ret;
 }
 
+/**********************************************************************************************
+ * Docid-only evaluation.
+ *
+ * Queries whose results are not scored, highlighted or yielding metrics only need the docids of
+ * the matches. The unions of such a query stop at the first child matching a docid, rather than
+ * collecting the records of all the matching children, and its intersections keep the docid
+ * without collecting the records of their children.
+ **********************************************************************************************/
+
+static void enableDocIdsOnly(IndexIterator *it) {
+  if (!it) return;
+  switch (it->type) {
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      ui->quickExit = 1;
+      // the records of a bitmap merged union have no children
+      if (ui->bitmapMergeable) {
+        UI_SetBitmapMerge(it);
+      }
+      for (size_t i = 0; i < ui->norig; ++i) {
+        enableDocIdsOnly(ui->origits[i]);
+      }
+      break;
+    }
+    case INTERSECT_ITERATOR: {
+      IntersectIterator *ic = it->ctx;
+      // the slop, order and field checks need the records of the children
+      if (ic->maxSlop >= 0 || ic->inOrder || ic->fieldMask != RS_FIELDMASK_ALL) {
+        break;
+      }
+      ic->docIdsOnly = 1;
+      it->current->fieldMask = RS_FIELDMASK_ALL;
+      for (size_t i = 0; i < ic->num; ++i) {
+        enableDocIdsOnly(ic->its[i]);
+      }
+      if (ic->bestIt) {
+        enableDocIdsOnly(ic->bestIt);
+      }
+      break;
+    }
+    case NOT_ITERATOR:
+      enableDocIdsOnly(((NotIterator *)it->ctx)->child);
+      break;
+    case OPTIONAL_ITERATOR:
+      enableDocIdsOnly(((OptionalIterator *)it->ctx)->child);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Plan the criteria testers of the sorted intersections of the tree. Unlike the records of the
+ * children, which the profile iterators keep reporting, the testers are planned through them, so
+ * that a profiled query runs the plan of the query it profiles */
+static void planTesters(IndexIterator *it) {
+  if (!it) return;
+  switch (it->type) {
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      for (size_t i = 0; i < ui->norig; ++i) {
+        planTesters(ui->origits[i]);
+      }
+      break;
+    }
+    case INTERSECT_ITERATOR: {
+      IntersectIterator *ic = it->ctx;
+      for (size_t i = 0; i < ic->num; ++i) {
+        planTesters(ic->its[i]);
+      }
+      if (it->mode == MODE_SORTED) {
+        II_PlanTesters(ic);
+      }
+      break;
+    }
+    case NOT_ITERATOR:
+      planTesters(((NotIterator *)it->ctx)->child);
+      break;
+    case OPTIONAL_ITERATOR:
+      planTesters(((OptionalIterator *)it->ctx)->child);
+      break;
+    case PROFILE_ITERATOR:
+      planTesters(PI_Unwrap(it));
+      break;
+    default:
+      break;
+  }
+}
+
+void IndexIterator_EnableDocIdsOnly(IndexIterator *it) {
+  enableDocIdsOnly(it);
+  // a tested child adds no record to the results, which are not needed anymore
+  planTesters(it);
+}
+
 /* Wildcard iterator, matchin ALL documents in the index. This is used for one thing only -
  * purely negative queries. If the root of the query is a negative expression, we cannot process
  * it
@@ -1616,8 +2652,21 @@ typedef struct {
   t_docId topId;
   t_docId current;
   t_docId numDocs;
+  const DocTable *docs;  // if set, only the live documents are iterated
+  const ExistenceIndex *exists;  // if set, only the live documents missing the field, or having it
+  bool missing;
 } WildcardIterator, WildcardIteratorCtx;
 
+/* The next id to iterate from `docId` on, or past the top id if there is none */
+static inline t_docId WI_Next(const WildcardIteratorCtx *nc, t_docId docId) {
+  if (!nc->docs || docId > nc->topId) {
+    return docId;
+  }
+  t_docId next = nc->exists ? ExistenceIndex_Next(nc->exists, nc->docs, docId, nc->missing)
+                            : DocTable_NextLive(nc->docs, docId);
+  return next && next <= nc->topId ? next : nc->topId + 1;
+}
+
 /* Free a wildcard iterator */
 static void WI_Free(IndexIterator *it) {
 
@@ -1629,7 +2678,7 @@ static void WI_Free(IndexIterator *it) {
 /* Read reads the next consecutive id, unless we're at the end */
 static int WI_Read(void *ctx, RSIndexResult **hit) {
   WildcardIteratorCtx *nc = ctx;
-  CURRENT_RECORD(nc)->docId = ++nc->current;
+  CURRENT_RECORD(nc)->docId = nc->current = WI_Next(nc, nc->current + 1);
   if (nc->current > nc->topId) {
     return INDEXREAD_EOF;
   }
@@ -1639,6 +2688,23 @@ static int WI_Read(void *ctx, RSIndexResult **hit) {
   return INDEXREAD_OK;
 }
 
+/* Batch read of the next consecutive ids */
+static int WI_ReadBatch(void *ctx, t_docId *out, size_t max, size_t *n) {
+  WildcardIteratorCtx *nc = ctx;
+  *n = 0;
+  t_docId next;
+  while (*n < max && (next = WI_Next(nc, nc->current + 1)) <= nc->topId) {
+    out[(*n)++] = nc->current = next;
+  }
+  if (!*n) {
+    // Same state as WI_Read leaves at the end
+    CURRENT_RECORD(nc)->docId = nc->current = nc->topId + 1;
+    return INDEXREAD_EOF;
+  }
+  CURRENT_RECORD(nc)->docId = nc->current;
+  return INDEXREAD_OK;
+}
+
 /* Skipto for wildcard iterator - always succeeds, but this should normally not happen as it has
  * no
  * meaning */
@@ -1650,12 +2716,16 @@ static int WI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
   if (docId == 0) return WI_Read(ctx, hit);
 
-  nc->current = docId;
-  CURRENT_RECORD(nc)->docId = docId;
+  nc->current = WI_Next(nc, docId);
+  CURRENT_RECORD(nc)->docId = nc->current;
+  if (nc->docs && nc->current > nc->topId) {
+    return INDEXREAD_EOF;
+  }
   if (hit) {
     *hit = CURRENT_RECORD(nc);
   }
-  return INDEXREAD_OK;
+  // a deleted document was skipped
+  return nc->current == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
 }
 
 static void WI_Abort(void *ctx) {
@@ -1694,11 +2764,12 @@ static size_t WI_NumEstimated(void *p) {
 }
 
 /* Create a new wildcard iterator */
-IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs) {
+IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs, const DocTable *docs) {
   WildcardIteratorCtx *c = rm_calloc(1, sizeof(*c));
   c->current = 0;
   c->topId = maxId;
   c->numDocs = numDocs;
+  c->docs = docs;
 
   CURRENT_RECORD(c) = NewVirtualResult(1);
   CURRENT_RECORD(c)->freq = 1;
@@ -1713,12 +2784,26 @@ IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs) {
   ret->Len = WI_Len;
   ret->Read = WI_Read;
   ret->SkipTo = WI_SkipTo;
+  ret->ReadBatch = WI_ReadBatch;
   ret->Abort = WI_Abort;
   ret->Rewind = WI_Rewind;
   ret->NumEstimated = WI_NumEstimated;
   return ret;
 }
 
+IndexIterator *NewExistenceIterator(const ExistenceIndex *ex, bool missing, t_docId maxId,
+                                    const DocTable *docs, double weight) {
+  // the documents are live ones, of which the ones with stale bits are deleted
+  size_t numDocs = missing ? docs->size - 1 - MIN(ex->numDocs, docs->size - 1) : ex->numDocs;
+  IndexIterator *ret = NewWildcardIterator(maxId, numDocs, docs);
+  WildcardIteratorCtx *c = ret->ctx;
+  c->exists = ex;
+  c->missing = missing;
+  CURRENT_RECORD(c)->weight = weight;
+  ret->type = EXISTENCE_ITERATOR;
+  return ret;
+}
+
 static int EOI_Read(void *p, RSIndexResult **e) {
   return INDEXREAD_EOF;
 }
@@ -1793,29 +2878,54 @@ typedef struct {
   size_t counter;
   double cpuTime;
   int eof;
+  ProfileCounters counters;
 } ProfileIterator, ProfileIteratorCtx;
 
+/* The iterator a profile iterator wraps, or the iterator itself */
+static IndexIterator *PI_Unwrap(IndexIterator *it) {
+  return it->type == PROFILE_ITERATOR ? ((ProfileIterator *)it->ctx)->child : it;
+}
+
+static inline void PI_Start(ProfileIterator *pi, hires_clock_t *t0, PerfCounters *hw0) {
+  if (pi->counters.withHw && !PerfCounters_Read(hw0)) {
+    pi->counters.withHw = false;
+  }
+  hires_clock_get(t0);
+}
+
+static inline void PI_Stop(ProfileIterator *pi, hires_clock_t *t0, const PerfCounters *hw0) {
+  pi->cpuTime += hires_clock_since_msec(t0);
+  PerfCounters hw1;
+  if (pi->counters.withHw && PerfCounters_Read(&hw1)) {
+    PerfCounters_AddSince(&pi->counters.hw, hw0, &hw1);
+  }
+}
+
 static int PI_Read(void *ctx, RSIndexResult **e) {
   ProfileIterator *pi = ctx;
   pi->counter++;
-  hires_clock_t t0; 
-  hires_clock_get(&t0);
+  hires_clock_t t0;
+  PerfCounters hw0;
+  PI_Start(pi, &t0, &hw0);
   int ret = pi->child->Read(pi->child->ctx, e);
   if (ret == INDEXREAD_EOF) pi->eof = 1;
   pi->base.current = pi->child->current;
-  pi->cpuTime += hires_clock_since_msec(&t0);
+  PI_Stop(pi, &t0, &hw0);
   return ret;
 }
 
 static int PI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   ProfileIterator *pi = ctx;
   pi->counter++;
-  hires_clock_t t0; 
-  hires_clock_get(&t0);
+  pi->counters.skipTos++;
+  hires_clock_t t0;
+  PerfCounters hw0;
+  PI_Start(pi, &t0, &hw0);
   int ret = pi->child->SkipTo(pi->child->ctx, docId, hit);
   if (ret == INDEXREAD_EOF) pi->eof = 1;
+  if (ret == INDEXREAD_OK) pi->counters.skipToHits++;
   pi->base.current = pi->child->current;
-  pi->cpuTime += hires_clock_since_msec(&t0);
+  PI_Stop(pi, &t0, &hw0);
   return ret;
 }
 
@@ -1843,12 +2953,13 @@ static int PI_HasNext(void *ctx) {
 }
 
 /* Create a new wildcard iterator */
-IndexIterator *NewProfileIterator(IndexIterator *child) {
+IndexIterator *NewProfileIterator(IndexIterator *child, bool withHw) {
   ProfileIteratorCtx *pc = rm_calloc(1, sizeof(*pc));
   pc->child = child;
   pc->counter = 0;
   pc->cpuTime = 0;
   pc->eof = 0;
+  pc->counters.withHw = withHw;
 
   IndexIterator *ret = &pc->base;
   ret->ctx = pc;
@@ -1907,7 +3018,7 @@ PRINT_PROFILE_FUNC(printUnionIt) {
     printProfileTime(cpuTime);
   }
 
-  printProfileCounter(counter);
+  printProfileIteratorCounters(counter);
 
   // if MAXPREFIXEXPANSIONS reached
   if (ui->norig == config->iteratorsConfig->maxPrefixExpansions) {
@@ -1944,7 +3055,12 @@ PRINT_PROFILE_FUNC(printIntersectIt) {
     printProfileTime(cpuTime);
   }
 
-  printProfileCounter(counter);
+  printProfileIteratorCounters(counter);
+
+  if (array_len(ii->testers)) {
+    RedisModule_ReplyKV_SimpleString(reply, "Strategy", "Criteria testers");
+    RedisModule_ReplyKV_LongLong(reply, "Tested children", array_len(ii->testers));
+  }
 
   RedisModule_Reply_SimpleString(reply, "Child iterators");
   if (reply->resp3) {
@@ -1984,7 +3100,7 @@ PRINT_PROFILE_FUNC(printMetricIt) {
     printProfileTime(cpuTime);
   }
 
-  printProfileCounter(counter);
+  printProfileIteratorCounters(counter);
 
   RedisModule_Reply_MapEnd(reply);
 }
@@ -1999,13 +3115,33 @@ void PrintIteratorChildProfile(RedisModule_Reply *reply, IndexIterator *root, si
     if (config->printProfileClock) {
       printProfileTime(cpuTime);
     }
-    printProfileCounter(counter);
+    printProfileIteratorCounters(counter);
 
     if (root->type == HYBRID_ITERATOR) {
       HybridIterator *hi = root->ctx;
+      if (hi->searchMode != VECSIM_STANDARD_KNN) {
+        printProfileHybridPolicy(hi);
+        // The policy was chosen by the pass rate of the filter in a previous query
+        if (hi->usedHistory) {
+          RedisModule_ReplyKV_SimpleString(reply, "Filter history", "applied");
+        }
+      }
       if (hi->searchMode == VECSIM_HYBRID_BATCHES ||
           hi->searchMode == VECSIM_HYBRID_BATCHES_TO_ADHOC_BF) {
         printProfileNumBatches(hi);
+        printProfileBatchResults(hi);
+      }
+      if (hi->searchMode == VECSIM_HYBRID_ADHOC_BF ||
+          hi->searchMode == VECSIM_HYBRID_BATCHES_TO_ADHOC_BF) {
+        printProfileDistances(hi);
+      }
+      if (hi->passRate >= 0) {
+        printProfilePassRate(hi);
+      }
+      // The time of the iterator includes the time of its child, profiled on its own
+      if (config->printProfileClock && child && child->type == PROFILE_ITERATOR) {
+        double childTime = ((ProfileIterator *)child->ctx)->cpuTime;
+        RedisModule_ReplyKV_Double(reply, "Vector index time", MAX(cpuTime - childTime, 0));
       }
     }
 
@@ -2037,11 +3173,15 @@ PRINT_PROFILE_SINGLE(printOptionalIt, OptionalIterator, "OPTIONAL", 1);
 PRINT_PROFILE_SINGLE(printWildcardIt, DummyIterator, "WILDCARD", 0);
 PRINT_PROFILE_SINGLE(printIdListIt, DummyIterator, "ID-LIST", 0);
 PRINT_PROFILE_SINGLE(printEmptyIt, DummyIterator, "EMPTY", 0);
+PRINT_PROFILE_SINGLE(printExistenceIt, DummyIterator, "EXISTENCE", 0);
 PRINT_PROFILE_SINGLE(printHybridIt, HybridIterator, "VECTOR", 1);
 PRINT_PROFILE_SINGLE(printOptimusIt, OptimizerIterator, "OPTIMIZER", 1);
+PRINT_PROFILE_SINGLE(printGeoNearestIt, GeoNearestIterator, "GEO-NEAREST", 1);
+PRINT_PROFILE_SINGLE(printSortIndexIt, SortIndexIterator, "SORT-INDEX", 1);
 
 PRINT_PROFILE_FUNC(printProfileIt) {
   ProfileIterator *pi = (ProfileIterator *)root;
+  config->counters = &pi->counters;
   printIteratorProfile(reply, pi->child, pi->counter - pi->eof, \
                        (double)pi->cpuTime, depth, limited, config);
 }
@@ -2072,12 +3212,15 @@ void printIteratorProfile(RedisModule_Reply *reply, IndexIterator *root, size_t
     case HYBRID_ITERATOR:     { printHybridIt(reply, root, counter, cpuTime, depth, limited, config);     break; }
     case METRIC_ITERATOR:     { printMetricIt(reply, root, counter, cpuTime, depth, limited, config);     break; }
     case OPTIMUS_ITERATOR:    { printOptimusIt(reply, root, counter, cpuTime, depth, limited, config);    break; }
+    case GEO_NEAREST_ITERATOR:{ printGeoNearestIt(reply, root, counter, cpuTime, depth, limited, config); break; }
+    case SORT_INDEX_ITERATOR: { printSortIndexIt(reply, root, counter, cpuTime, depth, limited, config);  break; }
+    case EXISTENCE_ITERATOR:  { printExistenceIt(reply, root, counter, cpuTime, depth, limited, config);  break; }
     case MAX_ITERATOR:        { RS_LOG_ASSERT(0, "nope");   break; }
   }
 }
 
 /** Add Profile iterator before any iterator in the tree */
-void Profile_AddIters(IndexIterator **root) {
+void Profile_AddIters(IndexIterator **root, bool withHw) {
   UnionIterator *ui;
   IntersectIterator *ini;
 
@@ -2086,31 +3229,38 @@ void Profile_AddIters(IndexIterator **root) {
   // Add profile iterator before child iterators
   switch((*root)->type) {
     case NOT_ITERATOR:
-      Profile_AddIters(&((NotIterator *)((*root)->ctx))->child);
+      Profile_AddIters(&((NotIterator *)((*root)->ctx))->child, withHw);
       break;
     case OPTIONAL_ITERATOR:
-      Profile_AddIters(&((OptionalIterator *)((*root)->ctx))->child);
+      Profile_AddIters(&((OptionalIterator *)((*root)->ctx))->child, withHw);
       break;
     case HYBRID_ITERATOR:
-      Profile_AddIters(&((HybridIterator *)((*root)->ctx))->child);
+      Profile_AddIters(&((HybridIterator *)((*root)->ctx))->child, withHw);
       break;
     case OPTIMUS_ITERATOR:
-      Profile_AddIters(&((OptimizerIterator *)((*root)->ctx))->child);
+      Profile_AddIters(&((OptimizerIterator *)((*root)->ctx))->child, withHw);
+      break;
+    case GEO_NEAREST_ITERATOR:
+      Profile_AddIters(&((GeoNearestIterator *)((*root)->ctx))->child, withHw);
+      break;
+    case SORT_INDEX_ITERATOR:
+      Profile_AddIters(&((SortIndexIterator *)((*root)->ctx))->child, withHw);
       break;
     case UNION_ITERATOR:
       ui = (*root)->ctx;
       for (int i = 0; i < ui->norig; i++) {
-        Profile_AddIters(&(ui->origits[i]));
+        Profile_AddIters(&(ui->origits[i]), withHw);
       }
       UI_SyncIterList(ui);
       break;
     case INTERSECT_ITERATOR:
       ini = (*root)->ctx;
       for (int i = 0; i < ini->num; i++) {
-        Profile_AddIters(&(ini->its[i]));
+        Profile_AddIters(&(ini->its[i]), withHw);
       }
       break;
     case WILDCARD_ITERATOR:
+    case EXISTENCE_ITERATOR:
     case READ_ITERATOR:
     case EMPTY_ITERATOR:
     case ID_LIST_ITERATOR:
@@ -2122,5 +3272,199 @@ void Profile_AddIters(IndexIterator **root) {
   }
 
   // Create a profile iterator and update outparam pointer
-  *root = NewProfileIterator(*root);
+  *root = NewProfileIterator(*root, withHw);
+}
+
+// The children of a union a compact plan lists, the rest are only counted
+#define COMPACT_PLAN_MAX_CHILDREN 8
+
+static sds compactPlanChildren(sds s, IndexIterator **its, int n, size_t maxLen);
+
+/* Append the name of the iterator to `s`, and set `child` to its only child if it wraps one */
+static sds planIteratorName(sds s, IndexIterator *it, IndexIterator **child) {
+  switch (it->type) {
+    case READ_ITERATOR: {
+      IndexReader *ir = it->ctx;
+      if (ir->idx->flags == Index_DocIdsOnly) {
+        s = sdscatprintf(s, "TAG:%s", ir->record->term.term->str);
+      } else if (ir->idx->flags & Index_StoreNumeric) {
+        NumericFilter *flt = ir->decoderCtx.ptr;
+        s = (!flt || !flt->geoFilter) ? sdscatprintf(s, "NUMERIC:%g-%g", ir->decoderCtx.rangeMin,
+                                                     ir->decoderCtx.rangeMax)
+                                      : sdscat(s, "GEO");
+      } else {
+        s = sdscatprintf(s, "TEXT:%s", ir->record->term.term->str);
+      }
+      break;
+    }
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      s = ui->qstr ? sdscatprintf(s, "UNION:%s", ui->qstr) : sdscat(s, "UNION");
+      break;
+    }
+    case INTERSECT_ITERATOR:   s = sdscat(s, "INTERSECT"); break;
+    case NOT_ITERATOR:         s = sdscat(s, "NOT"); *child = ((NotIterator *)it->ctx)->child; break;
+    case OPTIONAL_ITERATOR:    s = sdscat(s, "OPTIONAL"); *child = ((OptionalIterator *)it->ctx)->child; break;
+    case WILDCARD_ITERATOR:    s = sdscat(s, "WILDCARD"); break;
+    case EXISTENCE_ITERATOR:   s = sdscat(s, ((WildcardIterator *)it->ctx)->missing ? "MISSING" : "EXISTS"); break;
+    case EMPTY_ITERATOR:       s = sdscat(s, "EMPTY"); break;
+    case ID_LIST_ITERATOR:     s = sdscat(s, "ID-LIST"); break;
+    case HYBRID_ITERATOR:      s = sdscat(s, "VECTOR"); *child = ((HybridIterator *)it->ctx)->child; break;
+    case METRIC_ITERATOR:      s = sdscat(s, "METRIC"); break;
+    case OPTIMUS_ITERATOR:     s = sdscat(s, "OPTIMIZER"); *child = ((OptimizerIterator *)it->ctx)->child; break;
+    case GEO_NEAREST_ITERATOR: s = sdscat(s, "GEO-NEAREST"); *child = ((GeoNearestIterator *)it->ctx)->child; break;
+    case SORT_INDEX_ITERATOR:  s = sdscat(s, "SORT-INDEX"); *child = ((SortIndexIterator *)it->ctx)->child; break;
+    case PROFILE_ITERATOR:
+    case MAX_ITERATOR:
+      RS_LOG_ASSERT(0, "Error");
+  }
+  return s;
+}
+
+static sds compactPlan(sds s, IndexIterator *it, size_t maxLen) {
+  size_t actual = 0;
+  bool profiled = it->type == PROFILE_ITERATOR;
+  if (profiled) {
+    ProfileIterator *pi = (ProfileIterator *)it;
+    actual = pi->counter - pi->eof;
+    it = pi->child;
+  }
+
+  IndexIterator *child = NULL;
+  s = planIteratorName(s, it, &child);
+  s = sdscatprintf(s, " est=%zu", (size_t)IITER_NUM_ESTIMATED(it));
+  if (profiled) {
+    s = sdscatprintf(s, " act=%zu", actual);
+  }
+
+  if (it->type == UNION_ITERATOR) {
+    UnionIterator *ui = it->ctx;
+    s = compactPlanChildren(s, ui->origits, ui->norig, maxLen);
+  } else if (it->type == INTERSECT_ITERATOR) {
+    IntersectIterator *ii = it->ctx;
+    s = compactPlanChildren(s, ii->its, ii->num, maxLen);
+  } else if (child) {
+    s = compactPlanChildren(s, &child, 1, maxLen);
+  }
+  return s;
+}
+
+static sds compactPlanChildren(sds s, IndexIterator **its, int n, size_t maxLen) {
+  s = sdscat(s, " (");
+  int shown = 0;
+  for (int i = 0; i < n; i++) {
+    if (!its[i]) {
+      continue;
+    }
+    if (shown == COMPACT_PLAN_MAX_CHILDREN || sdslen(s) >= maxLen) {
+      s = sdscatprintf(s, ", ... %d more", n - i);
+      break;
+    }
+    if (shown++) {
+      s = sdscat(s, ", ");
+    }
+    s = compactPlan(s, its[i], maxLen);
+  }
+  return sdscat(s, ")");
+}
+
+char *Profile_CompactPlan(IndexIterator *root, size_t maxLen) {
+  if (!root) {
+    return NULL;
+  }
+  sds s = compactPlan(sdsempty(), root, maxLen);
+  char *plan = rm_strndup(s, MIN(sdslen(s), maxLen));
+  sdsfree(s);
+  return plan;
+}
+
+/* Append how a union or an intersection reads its children, as chosen when it was built and
+ * when its pruning was enabled */
+static sds planStrategy(sds s, IndexIterator *it) {
+  int (*read)(void *, RSIndexResult **) = it->Read;
+  const char *pruning = NULL;
+  if (it->type == UNION_ITERATOR) {
+    UnionIterator *ui = it->ctx;
+    if (read == UI_ReadBlockMax || read == UI_ReadMaxScore) {
+      pruning = read == UI_ReadBlockMax ? "blockmax" : "maxscore";
+      read = ui->prune.Read;
+    }
+    s = sdscat(s, read == UI_ReadUnsorted           ? " strategy=unsorted"
+                  : read == UI_ReadSortedTournament ? " strategy=tournament"
+                  : read == UI_ReadSortedHigh       ? " strategy=heap"
+                                                    : " strategy=flat");
+  } else {
+    IntersectIterator *ii = it->ctx;
+    if (read == II_ReadBlockMax) {
+      pruning = "blockmax";
+      read = ii->prune.Read;
+    }
+    s = sdscat(s, read == II_ReadUnsorted ? " strategy=unsorted" : " strategy=sorted");
+  }
+  if (pruning) {
+    s = sdscatprintf(s, " pruning=%s", pruning);
+  }
+  return s;
+}
+
+static sds dumpPlan(sds s, IndexIterator *it, int depth) {
+  if (it->type == PROFILE_ITERATOR) {
+    it = ((ProfileIterator *)it)->child;
+  }
+
+  IndexIterator *child = NULL;
+  s = sdscatprintf(s, "%*s", depth * 2, "");
+  s = planIteratorName(s, it, &child);
+  s = sdscatprintf(s, " est=%zu", (size_t)IITER_NUM_ESTIMATED(it));
+
+  IndexIterator **its = child ? &child : NULL;
+  int n = child ? 1 : 0;
+  if (it->type == UNION_ITERATOR) {
+    UnionIterator *ui = it->ctx;
+    if (ui->qstr) {
+      // the terms a prefix, suffix or fuzzy node expanded to
+      s = sdscatprintf(s, " expansions=%d", ui->norig);
+    }
+    s = planStrategy(s, it);
+    its = ui->origits;
+    n = ui->norig;
+  } else if (it->type == INTERSECT_ITERATOR) {
+    IntersectIterator *ii = it->ctx;
+    s = planStrategy(s, it);
+    its = ii->its;
+    n = ii->num;
+  } else if (it->type == HYBRID_ITERATOR) {
+    HybridIterator *hr = it->ctx;
+    s = sdscatprintf(s, " mode=%s", HybridIterator_PrintSearchMode(hr->searchMode));
+  } else if (it->type == OPTIMUS_ITERATOR) {
+    OptimizerIterator *oi = it->ctx;
+    s = sdscatprintf(s, " mode=%s", QOptimizer_PrintType(oi->optim));
+  }
+
+  if (!n) {
+    return sdscat(s, "\n");
+  }
+  s = sdscat(s, " {\n");
+  int shown = 0;
+  for (int i = 0; i < n; i++) {
+    if (!its[i]) {
+      continue;
+    }
+    if (shown++ == COMPACT_PLAN_MAX_CHILDREN) {
+      s = sdscatprintf(s, "%*s... %d more\n", (depth + 1) * 2, "", n - i);
+      break;
+    }
+    s = dumpPlan(s, its[i], depth + 1);
+  }
+  return sdscatprintf(s, "%*s}\n", depth * 2, "");
+}
+
+char *Profile_DumpPlan(IndexIterator *root) {
+  if (!root) {
+    return NULL;
+  }
+  sds s = dumpPlan(sdsempty(), root, 0);
+  char *plan = rm_strndup(s, sdslen(s));
+  sdsfree(s);
+  return plan;
 }
@@ -8,6 +8,7 @@
 #define __INDEX_H__
 
 #include "doc_table.h"
+#include "existence_index.h"
 #include "forward_index.h"
 #include "index_result.h"
 #include "index_iterator.h"
@@ -18,6 +19,7 @@
 #include "reply.h"
 
 #include "util/logging.h"
+#include "util/perf_counters.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -52,6 +54,21 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int q
 
 void UI_Foreach(IndexIterator *it, void (*callback)(IndexReader *it, void *privdata), void *privdata);
 
+/* Set the number of results a union iterator is expected to yield, when its creator can tell
+ * better than the sum of its children's estimates */
+void UI_SetNumEstimated(IndexIterator *it, size_t nexpected);
+
+/* Set the criteria tester a union iterator hands out, when its creator can test its documents
+ * cheaper than its children can. The union owns the tester until it is asked for one */
+void UI_SetCriteriaTester(IndexIterator *it, IndexCriteriaTester *tester);
+
+/* Let a sorted union merge its children in docid bitmap windows when reading and skipping too, not
+ * only in batch reads, once its records are not needed (see IndexIterator_EnableDocIdsOnly). Each
+ * docid is then set once however many children share it, and the union yields it without the
+ * children's records, which the scores need. Suits dense children which share many documents, such
+ * as the ranges of a multi-value numeric field */
+void UI_AllowBitmapMerge(IndexIterator *it);
+
 /* Create a new intersect iterator over the given list of child iterators. If maxSlop is not a
  * negative number, we will allow at most maxSlop intervening positions between the terms. If
  * maxSlop is set and inOrder is 1, we assert that the terms are in
@@ -66,8 +83,32 @@ void AddIntersectIterator(IndexIterator *parentIter, IndexIterator *childIter);
  * This is used to optimize queries with no additional filters. */
 void trimUnionIterator(IndexIterator *iter, size_t offset, size_t limit, bool asc, bool unsorted);
 
-/* Create a NOT iterator by wrapping another index iterator */
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight);
+/* Make a union or intersect iterator of terms skip the blocks of documents whose BM25STD score,
+ * multiplied by at most `scale`, cannot beat `*threshold`. `threshold` is read on every document,
+ * and should be kept up to date with the lowest score of the top results. Returns 0 if the
+ * iterator tree does not support pruning */
+int IndexIterator_EnableBlockMax(IndexIterator *it, const double *threshold, double scale);
+
+// The number of children up to which a union of terms may take part in MaxScore pruning
+#define MAXSCORE_MAX_CHILDREN 64
+
+/* Make a union iterator of terms skip the documents matched only by terms whose TFIDF scores,
+ * multiplied by at most `scale`, cannot beat `*threshold` together. Like block-max pruning,
+ * `threshold` should be kept up to date with the lowest score of the top results. Returns 0 if the
+ * iterator is not a union of terms */
+int IndexIterator_EnableMaxScore(IndexIterator *it, const double *threshold, double scale);
+
+/* Make the unions and intersections of an iterator tree skip collecting the records of their
+ * children, for queries which only need the docids of the matches. The aggregate records they
+ * return have no children then, and the intersections may test their broad numeric children
+ * against the docids of the others rather than skip through them */
+void IndexIterator_EnableDocIdsOnly(IndexIterator *it);
+
+/* Create a NOT iterator by wrapping another index iterator. If `docs` is set, the iterator
+ * returns the live documents of the table not matched by the child, rather than all the ids up
+ * to `maxDocId` */
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight,
+                              const DocTable *docs);
 
 /* Create an Optional clause iterator by wrapping another index iterator. An optional iterator
  * always returns OK on skips, but a virtual hit with frequency of 0 if there is no hit */
@@ -76,26 +117,64 @@ IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double w
 /* Create a wildcard iterator, matching ALL documents in the index. This is used for one thing only
  * - purely negative queries. If the root of the query is a negative expression, we cannot process
  * it without a positive expression. So we create a wildcard iterator that basically just iterates
- * all the incremental document ids, and matches every skip within its range. */
-IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs);
+ * all the incremental document ids, and matches every skip within its range. If `docs` is set,
+ * only the ids of its live documents are iterated, and skips to deleted ones land on the next
+ * live document */
+IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs, const DocTable *docs);
+
+/* An iterator over the live documents of `docs` up to `maxId` which are missing the field of the
+ * existence index, or have it if `missing` is not set. As the wildcard iterator, skips to other
+ * documents land on the next one matching */
+IndexIterator *NewExistenceIterator(const ExistenceIndex *ex, bool missing, t_docId maxId,
+                                    const DocTable *docs, double weight);
 
 /* Create a new IdListIterator from a pre populated list of document ids of size num. The doc ids
  * are sorted in this function, so there is no need to sort them. They are automatically freed in
  * the end and assumed to be allocated using rm_malloc */
 IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight);
 
+/* Create a new IdListIterator over a sorted list of document ids it does not copy nor free, which
+ * must outlive the iterator */
+IndexIterator *NewBorrowedIdListIterator(const t_docId *ids, t_offset num, double weight);
+
+/* Create a new IdListIterator yielding numeric records, over a sorted list of distinct document ids
+ * and the value of each. Both lists are taken over, and assumed to be allocated using rm_malloc */
+IndexIterator *NewNumericIdListIterator(t_docId *ids, double *values, t_offset num);
+
 /** Create a new iterator which returns no results */
 IndexIterator *NewEmptyIterator(void);
 
 /** Return a string containing the type of the iterator */
 const char *IndexIterator_GetTypeString(const IndexIterator *it);
 
-/** Add Profile iterator layer between iterators */
-void Profile_AddIters(IndexIterator **root);
+/** Add Profile iterator layer between iterators. With `withHw`, they also read the hardware
+ * counters around the calls to their child */
+void Profile_AddIters(IndexIterator **root, bool withHw);
+
+/** A one line description of the iterator tree, of up to `maxLen` characters, listing the
+ * estimated results of every iterator and, below a profile iterator, its actual results. The
+ * string is allocated with rm_malloc */
+char *Profile_CompactPlan(IndexIterator *root, size_t maxLen);
+
+/** The iterator tree on multiple lines, a line per iterator indented by its depth, with its
+ * estimated results, the strategy a union or an intersection reads its children with, and the
+ * number of terms a prefix or fuzzy union was expanded to. The string is allocated with rm_malloc */
+char *Profile_DumpPlan(IndexIterator *root);
+
+/* What a profile iterator counted of the calls to its child, besides their number and time */
+typedef struct {
+  size_t skipTos;     // SkipTo calls
+  size_t skipToHits;  // SkipTo calls which landed on the requested id
+  bool withHw;        // whether the hardware counters are read, and were readable so far
+  PerfCounters hw;    // the hardware counters of the calls, including their children's
+} ProfileCounters;
 
 typedef struct {
     IteratorsConfig *iteratorsConfig;
     int printProfileClock;    
+    // The counters of the profile iterator of the iterator being printed, if any. Consumed by
+    // the first printer, as its children have their own
+    const ProfileCounters *counters;
 } PrintProfileConfig;
 
 // Print profile of iterators
@@ -0,0 +1,158 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "index_buffers.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// Two classes per power of 2: 16, 24, 32, 48, 64, ... INDEX_BUFFERS_MAX_CLASS
+#define NUM_CLASSES 25
+
+typedef struct freeBuffer {
+  struct freeBuffer *next;
+} freeBuffer;
+
+typedef struct {
+  pthread_mutex_t lock;
+  freeBuffer *free;
+  size_t numFree;
+  // buffers allocated for the class, and taken from its free list
+  size_t allocated;
+  size_t reused;
+} sizeClass;
+
+static sizeClass classes_g[NUM_CLASSES];
+
+static pthread_once_t init_g = PTHREAD_ONCE_INIT;
+
+static void classes_Init() {
+  for (size_t i = 0; i < NUM_CLASSES; ++i) {
+    pthread_mutex_init(&classes_g[i].lock, NULL);
+  }
+}
+
+static inline size_t classSize(int i) {
+  size_t base = (size_t)INDEX_BUFFERS_MIN_CLASS << (i / 2);
+  return i % 2 ? base + base / 2 : base;
+}
+
+/* The smallest class of at least `size` bytes, or -1 if it is larger than the largest one */
+static int classOf(size_t size) {
+  if (size > INDEX_BUFFERS_MAX_CLASS) {
+    return -1;
+  }
+  int i = 0;
+  while (classSize(i) < size) {
+    ++i;
+  }
+  return i;
+}
+
+void IndexBuffer_Init(Buffer *b, size_t cap) {
+  pthread_once(&init_g, classes_Init);
+  b->offset = 0;
+  int i = classOf(cap);
+  if (i < 0) {
+    b->cap = cap;
+    b->data = rm_malloc(cap);
+    return;
+  }
+  b->cap = classSize(i);
+  b->data = NULL;
+  sizeClass *c = classes_g + i;
+  if (pthread_mutex_trylock(&c->lock) == 0) {
+    if (c->free) {
+      b->data = (char *)c->free;
+      c->free = c->free->next;
+      c->numFree--;
+      c->reused++;
+    } else {
+      c->allocated++;
+    }
+    pthread_mutex_unlock(&c->lock);
+  }
+  if (!b->data) {
+    b->data = rm_malloc(b->cap);
+  }
+}
+
+void IndexBuffer_Reserve(Buffer *b, size_t n) {
+  if (b->offset + n <= b->cap) {
+    return;
+  }
+  Buffer grown;
+  IndexBuffer_Init(&grown, b->offset + n);
+  memcpy(grown.data, b->data, b->offset);
+  grown.offset = b->offset;
+  IndexBuffer_Free(b);
+  *b = grown;
+}
+
+void IndexBuffer_Free(Buffer *b) {
+  pthread_once(&init_g, classes_Init);
+  int i = b->data ? classOf(b->cap) : -1;
+  if (i >= 0 && classSize(i) == b->cap) {
+    sizeClass *c = classes_g + i;
+    if (pthread_mutex_trylock(&c->lock) == 0) {
+      bool keep = (c->numFree + 1) * b->cap <= INDEX_BUFFERS_CLASS_CACHE;
+      if (keep) {
+        freeBuffer *f = (freeBuffer *)b->data;
+        f->next = c->free;
+        c->free = f;
+        c->numFree++;
+      }
+      pthread_mutex_unlock(&c->lock);
+      if (keep) {
+        b->data = NULL;
+        b->cap = b->offset = 0;
+        return;
+      }
+    }
+  }
+  Buffer_Free(b);
+  b->data = NULL;
+  b->cap = b->offset = 0;
+}
+
+void IndexBuffers_AddToInfo(RedisModuleInfoCtx *ctx) {
+  pthread_once(&init_g, classes_Init);
+  RedisModule_InfoAddSection(ctx, "index_buffers");
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+    sizeClass *c = classes_g + i;
+    pthread_mutex_lock(&c->lock);
+    size_t allocated = c->allocated, reused = c->reused, numFree = c->numFree;
+    pthread_mutex_unlock(&c->lock);
+    if (!allocated && !reused) {
+      continue;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "class_%zu", classSize(i));
+    RedisModule_InfoBeginDictField(ctx, name);
+    RedisModule_InfoAddFieldULongLong(ctx, "allocated", allocated);
+    RedisModule_InfoAddFieldULongLong(ctx, "reused", reused);
+    RedisModule_InfoAddFieldULongLong(ctx, "free", numFree);
+    RedisModule_InfoEndDictField(ctx);
+  }
+}
+
+void IndexBuffers_Free() {
+  pthread_once(&init_g, classes_Init);
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+    sizeClass *c = classes_g + i;
+    pthread_mutex_lock(&c->lock);
+    while (c->free) {
+      freeBuffer *f = c->free;
+      c->free = f->next;
+      rm_free(f);
+    }
+    c->numFree = 0;
+    pthread_mutex_unlock(&c->lock);
+  }
+}
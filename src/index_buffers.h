@@ -0,0 +1,54 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "buffer.h"
+#include "redismodule.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size classes for the data of the blocks of the inverted indexes. A block buffer grows from a
+ * class to the next one instead of by reallocation, and the buffers of the blocks freed by the GC
+ * are kept on a free list of their class, up to INDEX_BUFFERS_CLASS_CACHE bytes per class, for the
+ * blocks written next. This keeps the block data in a few sizes which are reused, rather than in
+ * as many sizes as the blocks went through while growing, which the allocator cannot fit the
+ * later allocations into once the blocks are freed.
+ *
+ * The buffers are plain allocations: any heap buffer can be released to its class if its capacity
+ * is the size of one, and a buffer taken from a class can be reallocated or freed as any other.
+ * The free lists are only tried, never waited on, so that the fork GC child does not block on a
+ * lock held when it was forked */
+
+// The smallest and the largest size classes. Larger buffers are allocated as they are
+#define INDEX_BUFFERS_MIN_CLASS 16
+#define INDEX_BUFFERS_MAX_CLASS (64 * 1024)
+
+// The bytes of free buffers kept per class
+#define INDEX_BUFFERS_CLASS_CACHE (1 << 20)
+
+/* Initialize a buffer of at least `cap` bytes, rounded up to its size class */
+void IndexBuffer_Init(Buffer *b, size_t cap);
+
+/* Make room in the buffer for `n` more bytes, moving it to a larger size class if needed */
+void IndexBuffer_Reserve(Buffer *b, size_t n);
+
+/* Free the data of the buffer, keeping it for reuse if its capacity is the size of a class */
+void IndexBuffer_Free(Buffer *b);
+
+/* Report the allocations and reuses of each size class in use */
+void IndexBuffers_AddToInfo(RedisModuleInfoCtx *ctx);
+
+/* Free the buffers kept for reuse */
+void IndexBuffers_Free();
+
+#ifdef __cplusplus
+}
+#endif
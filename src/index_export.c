@@ -0,0 +1,223 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "index_export.h"
+#include "spec.h"
+#include "config.h"
+#include "index_persistence.h"
+#include "rmalloc.h"
+#include "util/misc.h"
+#include "rmutil/sds.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Followed by the encoding version and the length of the name of the index, 4 bytes each, the name,
+// and the saved index
+#define EXPORT_MAGIC "RSEXPORT"
+#define EXPORT_MAGIC_LEN 8
+#define EXPORT_HEADER_LEN (EXPORT_MAGIC_LEN + 8)
+
+// The index is saved and loaded by the methods of this type, which is never the type of a key
+static RedisModuleType *IndexExportType;
+
+// The value loaded by the type is only a success marker, the index is registered by its name
+static int imported_g;
+
+static void exportRdbSave(RedisModuleIO *rdb, void *value) {
+  IndexSpec_RdbSave(rdb, value);
+}
+
+static void *exportRdbLoad(RedisModuleIO *rdb, int encver) {
+  QueryError status = {0};
+  if (IndexSpec_CreateFromRdb(RedisModule_GetContextFromIO(rdb), rdb, encver, &status) !=
+      REDISMODULE_OK) {
+    RedisModule_Log(NULL, "warning", "Import: %s", QueryError_GetError(&status));
+    QueryError_ClearError(&status);
+    return NULL;
+  }
+  return &imported_g;
+}
+
+static void exportFree(void *value) {
+}
+
+int IndexExport_RegisterType(RedisModuleCtx *ctx) {
+  RedisModuleTypeMethods tm = {.version = REDISMODULE_TYPE_METHOD_VERSION,
+                               .rdb_load = exportRdbLoad,
+                               .rdb_save = exportRdbSave,
+                               .aof_rewrite = GenericAofRewrite_DisabledHandler,
+                               .free = exportFree};
+
+  IndexExportType = RedisModule_CreateDataType(ctx, "ft_idxexp", INDEX_CURRENT_VERSION, &tm);
+  if (IndexExportType == NULL) {
+    RedisModule_Log(ctx, "error", "Could not create index export type");
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static void writeU32(char *p, uint32_t u) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = u >> (8 * i);
+  }
+}
+
+static uint32_t readU32(const char *p) {
+  uint32_t u = 0;
+  for (int i = 0; i < 4; i++) {
+    u |= (uint32_t)(uint8_t)p[i] << (8 * i);
+  }
+  return u;
+}
+
+/* Write the export file next to its path and move it there once it is complete, so that a failed
+ * export does not leave a truncated file behind. Called in the child */
+static bool writeExport(IndexSpec *sp, const char *path) {
+  // This process only writes the file, the contents are saved whatever the config
+  RSGlobalConfig.persistIndexes = 1;
+  RedisModuleString *saved = RedisModule_SaveDataTypeToString(NULL, sp, IndexExportType);
+  size_t len;
+  const char *data = RedisModule_StringPtrLen(saved, &len);
+
+  char header[EXPORT_HEADER_LEN];
+  memcpy(header, EXPORT_MAGIC, EXPORT_MAGIC_LEN);
+  writeU32(header + EXPORT_MAGIC_LEN, INDEX_CURRENT_VERSION);
+  writeU32(header + EXPORT_MAGIC_LEN + 4, sp->nameLen);
+
+  sds tmp = sdscatfmt(sdsempty(), "%s.tmp", path);
+  FILE *f = fopen(tmp, "wb");
+  bool ok = f && fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+            fwrite(sp->name, 1, sp->nameLen, f) == sp->nameLen &&
+            fwrite(data, 1, len, f) == len && !fflush(f) && !fsync(fileno(f));
+  if (f && fclose(f)) {
+    ok = false;
+  }
+  ok = ok && !rename(tmp, path);
+  if (!ok) {
+    RedisModule_Log(NULL, "warning", "Could not write the export file %s (%s)", path,
+                    strerror(errno));
+    unlink(tmp);
+  }
+  sdsfree(tmp);
+  RedisModule_FreeString(NULL, saved);
+  return ok;
+}
+
+typedef struct {
+  RedisModuleBlockedClient *bc;
+  bool ok;
+} exportJob;
+
+static int exportReply(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  exportJob *job = RedisModule_GetBlockedClientPrivateData(ctx);
+  if (!job->ok) {
+    return RedisModule_ReplyWithError(ctx, "Could not write the export file, see the server log");
+  }
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+static void exportJob_Free(RedisModuleCtx *ctx, void *p) {
+  rm_free(p);
+}
+
+static void exportDone(int exitcode, int bysignal, void *user_data) {
+  exportJob *job = user_data;
+  job->ok = !exitcode && !bysignal;
+  RedisModule_UnblockClient(job->bc, job);
+}
+
+int IndexExport_Export(RedisModuleCtx *ctx, IndexSpec *sp, const char *path) {
+  if (!RedisModule_Fork) {
+    return RedisModule_ReplyWithError(ctx, "Exporting an index requires Redis 6.0.9 or above");
+  }
+  exportJob *job = rm_calloc(1, sizeof(*job));
+  job->bc = RedisModule_BlockClient(ctx, exportReply, NULL, exportJob_Free, 0);
+  int pid = RedisModule_Fork(exportDone, job);
+  if (pid == -1) {
+    RedisModule_AbortBlock(job->bc);
+    rm_free(job);
+    return RedisModule_ReplyWithError(ctx, "Could not fork, another child process may be active");
+  } else if (pid == 0) {
+    RedisModule_ExitFromChild(writeExport(sp, path) ? 0 : 1);
+  }
+  return REDISMODULE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the contents of a file, or NULL and sets errno
+static char *readFile(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  char *data = NULL;
+  long n;
+  if (!fseek(f, 0, SEEK_END) && (n = ftell(f)) >= 0 && !fseek(f, 0, SEEK_SET)) {
+    data = rm_malloc(n ? n : 1);
+    if (fread(data, 1, n, f) != (size_t)n) {
+      rm_free(data);
+      data = NULL;
+    }
+    *len = n;
+  }
+  fclose(f);
+  return data;
+}
+
+int IndexExport_Import(RedisModuleCtx *ctx, const char *path) {
+  size_t len;
+  char *data = readFile(path, &len);
+  if (!data) {
+    sds err = sdscatfmt(sdsempty(), "Could not read %s: %s", path, strerror(errno));
+    RedisModule_ReplyWithError(ctx, err);
+    sdsfree(err);
+    return REDISMODULE_OK;
+  }
+
+  int encver = 0;
+  uint32_t nameLen = 0;
+  if (len >= EXPORT_HEADER_LEN && !memcmp(data, EXPORT_MAGIC, EXPORT_MAGIC_LEN)) {
+    encver = readU32(data + EXPORT_MAGIC_LEN);
+    nameLen = readU32(data + EXPORT_MAGIC_LEN + 4);
+  }
+  if (encver < INDEX_MIN_COMPAT_VERSION || encver > INDEX_CURRENT_VERSION ||
+      nameLen > len - EXPORT_HEADER_LEN) {
+    rm_free(data);
+    return RedisModule_ReplyWithError(ctx, "Not an export file of a supported version");
+  }
+  char *name = rm_strndup(data + EXPORT_HEADER_LEN, nameLen);
+  if (dictFetchValue(specDict_g, name)) {
+    rm_free(name);
+    rm_free(data);
+    return RedisModule_ReplyWithError(ctx, "Index already exists");
+  }
+
+  size_t offset = EXPORT_HEADER_LEN + nameLen;
+  RedisModuleString *saved = RedisModule_CreateString(ctx, data + offset, len - offset);
+  rm_free(data);
+  void *loaded = RedisModule_LoadDataTypeFromStringEncver(saved, IndexExportType, encver);
+  RedisModule_FreeString(ctx, saved);
+  StrongRef ref = {dictFetchValue(specDict_g, name)};
+  rm_free(name);
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!loaded || !sp) {
+    return RedisModule_ReplyWithError(ctx, "Corrupt export file");
+  }
+
+  if (sp->restore) {
+    // Check the restored contents against the keyspace, as when the loading of an RDB ends
+    IndexPersistence_LoadingEnded(ctx, true);
+  } else if (!(sp->flags & (Index_SkipInitialScan | Index_Lazy))) {
+    IndexSpec_ScanAndReindex(ctx, ref);
+  }
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* Export files of single indexes (FT.EXPORT and FT.IMPORT), to create an index on another server
+ * without indexing its keys again.
+ *
+ * An export file holds the definition of the index and its contents in the format they are
+ * persisted in the RDB with (see index_persistence.h), behind a header with the name of the index
+ * and the encoding version. It is written by a forked child, like an RDB, so the server goes on
+ * serving meanwhile and the contents are a snapshot of the moment of the fork. The indexes whose
+ * contents are not persisted (vector, geometry, suffix and n-gram fields, LAZY indexes, or an
+ * index being scanned) are exported without them, and are scanned when they are imported.
+ *
+ * Importing expects the keyspace the index was exported with: the documents of the keys which no
+ * longer exist are dropped, and the keys written after the export are not indexed until they are
+ * written again. An imported index is not replicated, replicas get it with their next full sync */
+
+/* Write the export file of an index from a forked child, and reply to the client once it exits */
+int IndexExport_Export(RedisModuleCtx *ctx, struct IndexSpec *sp, const char *path);
+
+/* Create an index from an export file, and reply to the client */
+int IndexExport_Import(RedisModuleCtx *ctx, const char *path);
+
+int IndexExport_RegisterType(RedisModuleCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
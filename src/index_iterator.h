@@ -34,6 +34,9 @@ enum iteratorType {
   METRIC_ITERATOR,
   PROFILE_ITERATOR,
   OPTIMUS_ITERATOR,
+  GEO_NEAREST_ITERATOR,
+  SORT_INDEX_ITERATOR,
+  EXISTENCE_ITERATOR,
   MAX_ITERATOR,
 };
 
@@ -77,6 +80,13 @@ typedef struct indexIterator {
    * matches */
   int (*SkipTo)(void *ctx, t_docId docId, RSIndexResult **hit);
 
+  /* Read the docids of up to `max` next entries into `out`, and put their number in *n. Returns
+   * INDEXREAD_OK if any docid was read, INDEXREAD_EOF or INDEXREAD_TIMEOUT otherwise.
+   * Optional, used for consumers which only need docids (see IndexIterator_ReadBatch). Iterators
+   * may read ahead of the docids they return, so an iterator read in batches must only be read in
+   * batches until it is rewound */
+  int (*ReadBatch)(void *ctx, t_docId *out, size_t max, size_t *n);
+
   /* the last docId read */
   t_docId (*LastDocId)(void *ctx);
 
@@ -124,6 +134,26 @@ typedef struct indexIterator {
 
 #define IITER_INVALID_NUM_ESTIMATED_RESULTS UINT32_MAX
 
+/* Read a batch of docids from an iterator (see ReadBatch), falling back to reading them one by one
+ * if the iterator does not implement it */
+static inline int IndexIterator_ReadBatch(IndexIterator *it, t_docId *out, size_t max, size_t *n) {
+  if (it->ReadBatch) {
+    return it->ReadBatch(it->ctx, out, max, n);
+  }
+  *n = 0;
+  RSIndexResult *hit = NULL;
+  while (*n < max) {
+    int rc = it->Read(it->ctx, &hit);
+    if (rc == INDEXREAD_NOTFOUND || (rc == INDEXREAD_OK && !hit)) {
+      continue;
+    } else if (rc != INDEXREAD_OK) {
+      return *n ? INDEXREAD_OK : rc;
+    }
+    out[(*n)++] = hit->docId;
+  }
+  return INDEXREAD_OK;
+}
+
 // #define IITER_HAS_NEXT(ii) ((ii)->HasNext ? (ii)->HasNext((ii)->ctx) : (!(ii)->atEnd))
 
 #endif
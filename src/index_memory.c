@@ -0,0 +1,331 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "index_memory.h"
+#include "doc_table.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "vector_index.h"
+#include "sortable.h"
+#include "byte_offsets.h"
+#include "suffix.h"
+#include "trie/trie.h"
+#include "trie/trie_type.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/dict.h"
+
+static void addArray(MemSize *m, const void *arr) {
+  if (arr) {
+    const array_hdr_t *hdr = array_hdr(arr);
+    m->allocated += array_sizeof(hdr);
+    m->used += sizeof(*hdr) + (size_t)hdr->len * hdr->elem_sz;
+  }
+}
+
+static void addBytes(MemSize *m, size_t n) {
+  m->allocated += n;
+  m->used += n;
+}
+
+void InvertedIndex_AddMemory(const InvertedIndex *idx, InvertedIndexMemory *m) {
+  size_t header = InvertedIndex_HeaderSize(idx->flags);
+  m->numIndexes++;
+  m->numBlocks += idx->size;
+
+  // The inline block and its data are allocated along with the header, used or not
+  m->headers.allocated += header + sizeof(IndexBlock);
+  m->headers.used += header + idx->size * sizeof(IndexBlock);
+  if (!InvertedIndex_HasInlineBlock(idx)) {
+    m->headers.allocated += idx->size * sizeof(IndexBlock);
+    m->data.allocated += INDEX_BLOCK_INLINE_CAP;
+  }
+  for (uint32_t i = 0; i < idx->size; i++) {
+    const IndexBlock *blk = idx->blocks + i;
+    // Data mapped from a segment is used but not allocated on the heap
+    if (blk->flags & IndexBlock_InlineData) {
+      m->data.allocated += INDEX_BLOCK_INLINE_CAP;
+    } else if (!(blk->flags & IndexBlock_MappedData)) {
+      m->data.allocated += blk->buf.cap;
+    }
+    m->data.used += blk->buf.offset;
+    addArray(&m->skips, blk->skips);
+  }
+}
+
+static void replyMem(RedisModule_Reply *reply, const char *name, const MemSize *m) {
+  RedisModule_ReplyKV_Map(reply, name);
+    RedisModule_ReplyKV_LongLong(reply, "allocated", m->allocated);
+    RedisModule_ReplyKV_LongLong(reply, "used", m->used);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+static void replyInvertedIndexes(RedisModule_Reply *reply, const char *name,
+                                 const InvertedIndexMemory *m) {
+  RedisModule_ReplyKV_Map(reply, name);
+    RedisModule_ReplyKV_LongLong(reply, "num_indexes", m->numIndexes);
+    RedisModule_ReplyKV_LongLong(reply, "num_blocks", m->numBlocks);
+    replyMem(reply, "headers", &m->headers);
+    replyMem(reply, "data", &m->data);
+    replyMem(reply, "skips", &m->skips);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+/* Tries count their entries, and triemaps their nodes */
+static void replyTrie(RedisModule_Reply *reply, const char *name, const char *countName,
+                      size_t count, size_t bytes) {
+  RedisModule_ReplyKV_Map(reply, name);
+    RedisModule_ReplyKV_LongLong(reply, countName, count);
+    RedisModule_ReplyKV_LongLong(reply, "bytes", bytes);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+/* The entries of a trie, and the ones deleted since its last compaction whose nodes it still holds */
+static void replyTermsTrie(RedisModule_Reply *reply, const char *name, Trie *t) {
+  RedisModule_ReplyKV_Map(reply, name);
+    RedisModule_ReplyKV_LongLong(reply, "entries", t->size);
+    RedisModule_ReplyKV_LongLong(reply, "deleted", t->deleted);
+    RedisModule_ReplyKV_LongLong(reply, "bytes", TrieNode_MemUsage(t->root));
+  RedisModule_Reply_MapEnd(reply);
+}
+
+static void replyDocTable(RedisModule_Reply *reply, const DocTable *dt,
+                          const RSSortingTable *sortingTable) {
+  MemSize metadata = {0}, keys = {0}, payloads = {0}, sortables = {0}, offsets = {0}, pages = {0};
+  pages.allocated = dt->numPages * sizeof(*dt->pages);
+  for (size_t i = 0; i < dt->numPages; ++i) {
+    const DocTablePage *page = dt->pages[i];
+    if (!page) {
+      continue;
+    }
+    pages.allocated += sizeof(*page);
+    pages.used += sizeof(*dt->pages) + sizeof(page->numDocs) + page->numDocs * sizeof(*page->slots);
+  }
+
+  DOCTABLE_FOREACH(dt, {
+    addBytes(&metadata, sizeof(*dmd));
+    keys.allocated += sdsAllocSize(dmd->keyPtr);
+    keys.used += sdslen(dmd->keyPtr) + 1;
+    if (dmd->payload) {
+      addBytes(&payloads, sizeof(*dmd->payload) + dmd->payload->len);
+    }
+    if (dmd->sortVector) {
+      addBytes(&sortables, RSSortingVector_GetMemorySize(dmd->sortVector));
+    }
+    if (dmd->byteOffsets) {
+      addBytes(&offsets, sizeof(*dmd->byteOffsets) + dmd->byteOffsets->offsets.len +
+                             dmd->byteOffsets->numFields * sizeof(*dmd->byteOffsets->fields));
+    }
+  });
+
+  size_t stringsSize = RSSortingTable_StringsMemorySize(sortingTable);
+  MemSize strings = {.allocated = stringsSize, .used = stringsSize};
+  MemSize keyMap = {.allocated = DocIdMap_MemUsage(&dt->dim),
+                    .used = dt->dim.size * sizeof(*dt->dim.entries)};
+  size_t liveWords = MIN(dt->liveDocsWords, dt->maxDocId / 64 + 1);
+  MemSize liveBitmap = {.allocated = dt->liveDocsWords * sizeof(*dt->liveDocs),
+                        .used = liveWords * sizeof(*dt->liveDocs)};
+
+  RedisModule_ReplyKV_Map(reply, "doc_table");
+    RedisModule_ReplyKV_LongLong(reply, "num_docs", dt->size - 1);
+    replyMem(reply, "metadata", &metadata);
+    replyMem(reply, "keys", &keys);
+    replyMem(reply, "payloads", &payloads);
+    replyMem(reply, "sorting_vectors", &sortables);
+    replyMem(reply, "sortable_strings", &strings);
+    replyMem(reply, "byte_offsets", &offsets);
+    replyMem(reply, "pages", &pages);
+    replyMem(reply, "key_map", &keyMap);
+    replyMem(reply, "live_bitmap", &liveBitmap);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+static void replyNumeric(RedisModule_Reply *reply, NumericRangeTree *rt) {
+  InvertedIndexMemory postings = {0};
+  MemSize nodes = {0}, ranges = {0}, values = {0}, columns = {0}, histogram = {0};
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    addBytes(&nodes, sizeof(*node));
+    NumericRange *r = node->range;
+    if (!r) {
+      continue;
+    }
+    addBytes(&ranges, sizeof(*r));
+    InvertedIndex_AddMemory(r->entries, &postings);
+    values.allocated += KMV_MemUsage(&r->cardSketch);
+    values.used += r->cardSketch.len * sizeof(KMVSample);
+    addArray(&columns, r->column);
+  }
+  NumericRangeTreeIterator_Free(iter);
+  addBytes(&histogram, sizeof(rt->histogram));
+  addArray(&histogram, rt->histogram.buckets);
+
+  RedisModule_ReplyKV_LongLong(reply, "num_ranges", rt->numRanges);
+  replyMem(reply, "nodes", &nodes);
+  replyMem(reply, "ranges", &ranges);
+  replyInvertedIndexes(reply, "postings", &postings);
+  replyMem(reply, "cardinality_sketches", &values);
+  replyMem(reply, "sorted_columns", &columns);
+  replyMem(reply, "histogram", &histogram);
+}
+
+static void replyTag(RedisModule_Reply *reply, TagIndex *idx) {
+  InvertedIndexMemory postings = {0};
+  TrieMapIterator *iter = TrieMap_Iterate(idx->values, "", 0);
+  char *ptr;
+  tm_len_t len;
+  void *value;
+  while (TrieMapIterator_Next(iter, &ptr, &len, &value)) {
+    InvertedIndex_AddMemory(value, &postings);
+  }
+  TrieMapIterator_Free(iter);
+
+  RedisModule_ReplyKV_LongLong(reply, "num_values", idx->values->cardinality);
+  replyTrie(reply, "values_trie", "nodes", idx->values->size, TrieMap_NodesMemUsage(idx->values));
+  replyInvertedIndexes(reply, "postings", &postings);
+  if (idx->suffix) {
+    replyTrie(reply, "suffix_trie", "entries", SuffixArray_NumSuffixes(idx->suffix),
+              SuffixArray_MemUsage(idx->suffix));
+  }
+
+  const TagDocValues *dv = &idx->docValues;
+  MemSize values = {0}, docCodes = {0};
+  addArray(&values, dv->values);
+  for (uint32_t i = 0; i < array_len(dv->values); ++i) {
+    size_t n;
+    RSValue_StringPtrLen(dv->values[i], &n);
+    addBytes(&values, sizeof(RSValue) + n + 1);
+  }
+  addArray(&docCodes, dv->docCodes);
+  RedisModule_ReplyKV_Map(reply, "doc_values");
+    if (dv->codes) {
+      replyTrie(reply, "codes_trie", "nodes", dv->codes->size, TrieMap_NodesMemUsage(dv->codes));
+    }
+    replyMem(reply, "values", &values);
+    replyMem(reply, "doc_codes", &docCodes);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+static void *fieldIndex(IndexSpec *sp, const FieldSpec *fs, FieldType t) {
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, t);
+  KeysDictValue *kdv = key && sp->keysDict ? dictFetchValue(sp->keysDict, key) : NULL;
+  return kdv ? kdv->p : NULL;
+}
+
+static void replyField(RedisModule_Reply *reply, IndexSpec *sp, const FieldSpec *fs) {
+  RedisModule_Reply_Map(reply);
+  RedisModule_ReplyKV_SimpleString(reply, "identifier", fs->path);
+  RedisModule_ReplyKV_SimpleString(reply, "attribute", fs->name);
+  RedisModule_ReplyKV_SimpleString(reply, "type", FieldSpec_GetTypeNames(INDEXTYPE_TO_POS(fs->types)));
+
+  NumericRangeTree *rt;
+  TagIndex *tag;
+  if (FIELD_IS(fs, INDEXFLD_T_NUMERIC) && (rt = fieldIndex(sp, fs, INDEXFLD_T_NUMERIC))) {
+    replyNumeric(reply, rt);
+  } else if (FIELD_IS(fs, INDEXFLD_T_GEO) && (rt = fieldIndex(sp, fs, INDEXFLD_T_GEO))) {
+    replyNumeric(reply, rt);
+  } else if (FIELD_IS(fs, INDEXFLD_T_TAG) && (tag = fieldIndex(sp, fs, INDEXFLD_T_TAG))) {
+    replyTag(reply, tag);
+  } else if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_VECTOR);
+    VecSimIndex *vecsim = OpenVectorIndex(sp, key);
+    RedisModule_ReplyKV_LongLong(reply, "bytes", VecSimIndex_Info(vecsim).commonInfo.memory);
+  }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+typedef struct {
+  const char *term;
+  size_t len;
+  size_t numDocs;
+  size_t allocated;
+} TermMemory;
+
+/* Insert a term into the `n` largest ones, sorted by decreasing size */
+static void addTopTerm(TermMemory *top, size_t *size, size_t n, const TermMemory *t) {
+  size_t pos = *size;
+  while (pos > 0 && top[pos - 1].allocated < t->allocated) {
+    --pos;
+  }
+  if (pos >= n) {
+    return;
+  }
+  size_t moved = MIN(*size, n - 1) - pos;
+  memmove(top + pos + 1, top + pos, moved * sizeof(*top));
+  top[pos] = *t;
+  *size = MIN(*size + 1, n);
+}
+
+void IndexSpec_ReplyMemory(RedisModule_Reply *reply, IndexSpec *sp, size_t topTerms) {
+  InvertedIndexMemory text = {0};
+  TermMemory *top = rm_malloc(MAX(topTerms, 1) * sizeof(*top));
+  size_t numTop = 0;
+  // The keys of the terms are formatted by fmtRedisTermKey
+  size_t prefixLen = strlen("ft:") + sp->nameLen + 1;
+  if (sp->keysDict) {
+    dictIterator *iter = dictGetIterator(sp->keysDict);
+    dictEntry *de;
+    while ((de = dictNext(iter))) {
+      KeysDictValue *kdv = dictGetVal(de);
+      if (kdv->dtor != InvertedIndex_Free) {
+        continue;
+      }
+      InvertedIndex *idx = kdv->p;
+      InvertedIndexMemory m = {0};
+      InvertedIndex_AddMemory(idx, &text);
+      InvertedIndex_AddMemory(idx, &m);
+      size_t keyLen;
+      const char *key = RedisModule_StringPtrLen(dictGetKey(de), &keyLen);
+      TermMemory t = {.term = key + prefixLen,
+                      .len = keyLen - prefixLen,
+                      .numDocs = idx->numDocs,
+                      .allocated = InvertedIndexMemory_Allocated(&m)};
+      addTopTerm(top, &numTop, topTerms, &t);
+    }
+    dictReleaseIterator(iter);
+  }
+
+  RedisModule_Reply_Map(reply);
+    replyDocTable(reply, &sp->docs, sp->sortables);
+    replyTermsTrie(reply, "terms_trie", sp->terms);
+    if (sp->phonetics) {
+      replyTermsTrie(reply, "phonetics_trie", sp->phonetics);
+    }
+    if (sp->fieldTerms) {
+      replyTermsTrie(reply, "field_terms_trie", sp->fieldTerms);
+    }
+    if (sp->suffix) {
+      replyTrie(reply, "suffix_trie", "entries", SuffixArray_NumSuffixes(sp->suffix),
+                SuffixArray_MemUsage(sp->suffix));
+    }
+    if (sp->ngrams) {
+      replyTrie(reply, "ngram_index", "terms", NgramIndex_NumTerms(sp->ngrams),
+                NgramIndex_MemUsage(sp->ngrams));
+    }
+    replyInvertedIndexes(reply, "text_postings", &text);
+    RedisModule_ReplyKV_LongLong(reply, "offset_vectors", sp->stats.offsetVecsSize);
+
+    RedisModule_ReplyKV_Array(reply, "fields");
+    for (size_t i = 0; i < sp->numFields; ++i) {
+      replyField(reply, sp, sp->fields + i);
+    }
+    RedisModule_Reply_ArrayEnd(reply);
+
+    RedisModule_ReplyKV_Array(reply, "top_terms");
+    for (size_t i = 0; i < numTop; ++i) {
+      RedisModule_Reply_Map(reply);
+        RedisModule_Reply_SimpleString(reply, "term");
+        RedisModule_Reply_StringBuffer(reply, top[i].term, top[i].len);
+        RedisModule_ReplyKV_LongLong(reply, "num_docs", top[i].numDocs);
+        RedisModule_ReplyKV_LongLong(reply, "allocated", top[i].allocated);
+      RedisModule_Reply_MapEnd(reply);
+    }
+    RedisModule_Reply_ArrayEnd(reply);
+  RedisModule_Reply_MapEnd(reply);
+
+  rm_free(top);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef SRC_INDEX_MEMORY_H_
+#define SRC_INDEX_MEMORY_H_
+
+#include "inverted_index.h"
+#include "spec.h"
+#include "reply.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of largest terms FT.DEBUG MEMORY lists by default, and at most
+#define INDEX_MEMORY_DEFAULT_TOP_TERMS 10
+#define INDEX_MEMORY_MAX_TOP_TERMS 1000
+
+/* The bytes allocated for a structure, and how many of them hold its data. The difference is the
+ * slack of its buffers and arrays */
+typedef struct {
+  size_t allocated;
+  size_t used;
+} MemSize;
+
+/* The memory of one or more inverted indexes, by part */
+typedef struct {
+  size_t numIndexes;
+  size_t numBlocks;
+  MemSize headers;  // the headers of the indexes and of their blocks
+  MemSize data;     // the encoded entries of the blocks
+  MemSize skips;    // the skip points of the sealed blocks
+} InvertedIndexMemory;
+
+/* Add the memory of an inverted index to `m` */
+void InvertedIndex_AddMemory(const InvertedIndex *idx, InvertedIndexMemory *m);
+
+static inline size_t InvertedIndexMemory_Allocated(const InvertedIndexMemory *m) {
+  return m->headers.allocated + m->data.allocated + m->skips.allocated;
+}
+
+/* Reply with the memory of every structure of the index, by field, along with its `topTerms`
+ * largest terms. Assumes the spec is locked */
+void IndexSpec_ReplyMemory(RedisModule_Reply *reply, IndexSpec *sp, size_t topTerms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INDEX_MEMORY_H_ */
@@ -0,0 +1,807 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "index_persistence.h"
+#include "spec.h"
+#include "config.h"
+#include "async_updates.h"
+#include "concurrent_ctx.h"
+#include "doc_table.h"
+#include "inverted_index.h"
+#include "redis_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "search_ctx.h"
+#include "buffer.h"
+#include "rdb.h"
+#include "rmalloc.h"
+#include "trie/trie_type.h"
+#include "trie/rune_util.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "util/logging.h"
+#include "util/minmax.h"
+#include "miniz/miniz.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+// The kinds of the sections of an index, after its doc table
+typedef enum {
+  PersistedSection_Terms = 0,
+  PersistedKey_Term = 1,
+  PersistedKey_Numeric = 2,
+  PersistedKey_Tag = 3,
+} PersistedSectionKind;
+
+// The encoding of a section, its first byte since INDEX_COMPRESSED_CONTENT_VERSION
+typedef enum {
+  SectionEncoding_Raw = 0,
+  // Followed by the length of the section, and its deflated bytes
+  SectionEncoding_Deflate = 1,
+} SectionEncoding;
+
+// Smaller sections are not worth compressing
+#define SECTION_COMPRESS_MIN 256
+// The best ratio deflate achieves, bounding the length a corrupt section may claim
+#define SECTION_MAX_DEFLATE_RATIO 1032
+
+struct IndexRestore {
+  size_t pending;     // sections not decoded yet, under decodeLock_g
+  bool failed;        // a section did not decode, under decodeLock_g
+  size_t loadedKeys;  // keys loaded from the RDB that the spec holds a document of
+};
+
+static arrayof(StrongRef) restored_g = NULL;
+static bool keyLoading_g = false;
+
+// Since the module was loaded, reported to INFO
+static size_t restoredIndexes_g = 0;
+static size_t restoredDocs_g = 0;
+static size_t corruptIndexes_g = 0;
+
+static pthread_mutex_t decodeLock_g = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t decoded_g = PTHREAD_COND_INITIALIZER;
+
+static int keyKind(const KeysDictValue *kdv) {
+  if (kdv->dtor == InvertedIndex_Free) {
+    return PersistedKey_Term;
+  } else if (kdv->dtor == (void (*)(void *))NumericRangeTree_Free) {
+    return PersistedKey_Numeric;
+  } else if (kdv->dtor == TagIndex_Free) {
+    return PersistedKey_Tag;
+  }
+  return 0;
+}
+
+// Assumes the spec is locked for read
+static bool canPersist(IndexSpec *sp) {
+  // a lazy index is loaded evicted
+  if ((sp->flags & (Index_HasVecSim | Index_HasGeometry | Index_Lazy)) || sp->suffix ||
+      sp->ngrams || sp->existence) {
+    return false;
+  }
+  for (int i = 0; i < sp->numFields; i++) {
+    if (FieldSpec_HasSuffixTrie(sp->fields + i)) {
+      return false;
+    }
+  }
+  if (sp->scan_in_progress || AsyncUpdates_GetStats(sp).depth) {
+    return false;
+  }
+  bool known = true;
+  if (sp->keysDict) {
+    dictIterator *iter = dictGetIterator(sp->keysDict);
+    dictEntry *de;
+    while (known && (de = dictNext(iter))) {
+      known = keyKind(dictGetVal(de)) != 0;
+    }
+    dictReleaseIterator(iter);
+  }
+  return known;
+}
+
+static void statsRdbSave(RedisModuleIO *rdb, const IndexStats *st) {
+  RedisModule_SaveUnsigned(rdb, st->numDocuments);
+  RedisModule_SaveUnsigned(rdb, st->numTerms);
+  RedisModule_SaveUnsigned(rdb, st->numRecords);
+  RedisModule_SaveUnsigned(rdb, st->invertedSize);
+  RedisModule_SaveUnsigned(rdb, st->invertedCap);
+  RedisModule_SaveUnsigned(rdb, st->skipIndexesSize);
+  RedisModule_SaveUnsigned(rdb, st->scoreIndexesSize);
+  RedisModule_SaveUnsigned(rdb, st->offsetVecsSize);
+  RedisModule_SaveUnsigned(rdb, st->offsetVecRecords);
+  RedisModule_SaveUnsigned(rdb, st->termsSize);
+  RedisModule_SaveUnsigned(rdb, st->indexingFailures);
+  RedisModule_SaveDouble(rdb, st->totalIndexTime);
+  RedisModule_SaveUnsigned(rdb, st->totalDocsLen);
+}
+
+static void statsRdbLoad(RedisModuleIO *rdb, IndexStats *st) {
+  st->numDocuments = RedisModule_LoadUnsigned(rdb);
+  st->numTerms = RedisModule_LoadUnsigned(rdb);
+  st->numRecords = RedisModule_LoadUnsigned(rdb);
+  st->invertedSize = RedisModule_LoadUnsigned(rdb);
+  st->invertedCap = RedisModule_LoadUnsigned(rdb);
+  st->skipIndexesSize = RedisModule_LoadUnsigned(rdb);
+  st->scoreIndexesSize = RedisModule_LoadUnsigned(rdb);
+  st->offsetVecsSize = RedisModule_LoadUnsigned(rdb);
+  st->offsetVecRecords = RedisModule_LoadUnsigned(rdb);
+  st->termsSize = RedisModule_LoadUnsigned(rdb);
+  st->indexingFailures = RedisModule_LoadUnsigned(rdb);
+  st->totalIndexTime = RedisModule_LoadDouble(rdb);
+  st->totalDocsLen = RedisModule_LoadUnsigned(rdb);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+/* The terms trie and the entries of the keys dictionary are saved as sections, each a string of
+ * the RDB, so that the main thread reads a section at once and hands it to a worker to decode.
+ * Numbers are encoded little endian, strings are prefixed by their length */
+
+static void writeU64(BufferWriter *bw, uint64_t u) {
+  uint8_t b[8];
+  for (int i = 0; i < 8; i++) {
+    b[i] = u >> (8 * i);
+  }
+  Buffer_Write(bw, b, sizeof(b));
+}
+
+static void writeDouble(BufferWriter *bw, double d) {
+  uint64_t u;
+  memcpy(&u, &d, sizeof(u));
+  writeU64(bw, u);
+}
+
+static void writeString(BufferWriter *bw, const char *s, size_t len) {
+  writeU64(bw, len);
+  Buffer_Write(bw, s, len);
+}
+
+// 7 bits per byte, the high bit set on all but the last one
+static void writeVarU64(BufferWriter *bw, uint64_t u) {
+  uint8_t b[10];
+  size_t n = 0;
+  do {
+    b[n] = u & 0x7f;
+    u >>= 7;
+    b[n++] |= u ? 0x80 : 0;
+  } while (u);
+  Buffer_Write(bw, b, n);
+}
+
+typedef struct {
+  const char *data;
+  size_t len;
+  size_t pos;
+  bool err;  // read past the end of the section
+} sectionReader;
+
+static uint64_t readU64(sectionReader *r) {
+  if (r->len - r->pos < 8) {
+    r->err = true;
+    return 0;
+  }
+  uint64_t u = 0;
+  for (int i = 0; i < 8; i++) {
+    u |= (uint64_t)(uint8_t)r->data[r->pos + i] << (8 * i);
+  }
+  r->pos += 8;
+  return u;
+}
+
+static uint64_t readVarU64(sectionReader *r) {
+  uint64_t u = 0;
+  for (int shift = 0; shift < 64 && r->pos < r->len; shift += 7) {
+    uint8_t b = r->data[r->pos++];
+    u |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return u;
+    }
+  }
+  r->err = true;
+  return 0;
+}
+
+static double readDouble(sectionReader *r) {
+  uint64_t u = readU64(r);
+  double d;
+  memcpy(&d, &u, sizeof(d));
+  return d;
+}
+
+// Returns a pointer into the section
+static const char *readString(sectionReader *r, size_t *len) {
+  *len = readU64(r);
+  if (r->err || r->len - r->pos < *len) {
+    r->err = true;
+    *len = 0;
+    return "";
+  }
+  const char *s = r->data + r->pos;
+  r->pos += *len;
+  return s;
+}
+
+// A section is deflated when that makes it smaller. It is compressed in the fork, and decompressed
+// on the indexing pool with the rest of its decoding
+static void saveSection(RedisModuleIO *rdb, void (*write)(BufferWriter *, void *), void *p) {
+  Buffer buf;
+  Buffer_Init(&buf, 64);
+  BufferWriter bw = NewBufferWriter(&buf);
+  uint8_t enc = SectionEncoding_Raw;
+  Buffer_Write(&bw, &enc, 1);
+  write(&bw, p);
+
+  size_t rawLen = buf.offset - 1;
+  if (rawLen >= SECTION_COMPRESS_MIN) {
+    mz_ulong zlen = mz_compressBound(rawLen);
+    Buffer zbuf;
+    Buffer_Init(&zbuf, 9 + zlen);
+    BufferWriter zw = NewBufferWriter(&zbuf);
+    enc = SectionEncoding_Deflate;
+    Buffer_Write(&zw, &enc, 1);
+    writeU64(&zw, rawLen);
+    if (mz_compress2((unsigned char *)zbuf.data + 9, &zlen, (unsigned char *)buf.data + 1, rawLen,
+                     MZ_BEST_SPEED) == MZ_OK &&
+        9 + zlen < buf.offset) {
+      zbuf.offset = 9 + zlen;
+      Buffer_Free(&buf);
+      buf = zbuf;
+    } else {
+      Buffer_Free(&zbuf);
+    }
+  }
+  RedisModule_SaveStringBuffer(rdb, buf.data, buf.offset);
+  Buffer_Free(&buf);
+}
+
+// Point the reader at the contents of a section, inflating them if they were deflated. Returns
+// false if the section is corrupt
+static bool sectionOpen(sectionReader *r, const char *data, size_t len, char **inflated) {
+  *r = (sectionReader){.data = data + 1, .len = len ? len - 1 : 0};
+  if (!len || data[0] == SectionEncoding_Raw) {
+    return len > 0;
+  } else if (data[0] != SectionEncoding_Deflate) {
+    return false;
+  }
+  uint64_t rawLen = readU64(r);
+  if (r->err || rawLen > (r->len - r->pos) * SECTION_MAX_DEFLATE_RATIO) {
+    return false;
+  }
+  char *raw = rm_malloc(rawLen ? rawLen : 1);
+  mz_ulong n = rawLen;
+  if (mz_uncompress((unsigned char *)raw, &n, (const unsigned char *)r->data + r->pos,
+                    r->len - r->pos) != MZ_OK ||
+      n != rawLen) {
+    rm_free(raw);
+    return false;
+  }
+  *inflated = raw;
+  *r = (sectionReader){.data = raw, .len = rawLen};
+  return true;
+}
+
+static size_t termsWriteTrie(BufferWriter *bw, Trie *terms) {
+  size_t count = 0;
+  TrieIterator *it = Trie_Iterate(terms, "", 0, 0, 1);
+  rune *rstr;
+  t_len slen;
+  float score;
+  int dist;
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    size_t len;
+    char *s = runesToStr(rstr, slen, &len);
+    writeString(bw, s, len);
+    writeDouble(bw, score);
+    rm_free(s);
+    count++;
+  }
+  TrieIterator_Free(it);
+  RS_LOG_ASSERT(count == terms->size, "not all the terms were saved to rdb");
+  return count;
+}
+
+// The terms trie of the spec is sorted lexicographically, unlike the one TrieType_GenericLoad builds.
+// The phonetic codes and the terms of the SEPARATEPOSTINGS fields are saved along with the terms, and
+// told apart by their prefix when loaded
+static void termsWrite(BufferWriter *bw, void *p) {
+  IndexSpec *sp = p;
+  writeU64(bw, sp->terms->size + (sp->phonetics ? sp->phonetics->size : 0) +
+                   (sp->fieldTerms ? sp->fieldTerms->size : 0));
+  termsWriteTrie(bw, sp->terms);
+  if (sp->phonetics) {
+    termsWriteTrie(bw, sp->phonetics);
+  }
+  if (sp->fieldTerms) {
+    termsWriteTrie(bw, sp->fieldTerms);
+  }
+}
+
+static void termsRead(sectionReader *r, IndexSpec *sp) {
+  size_t n = readU64(r);
+  for (size_t i = 0; i < n && !r->err; i++) {
+    size_t len;
+    const char *s = readString(r, &len);
+    double score = readDouble(r);
+    if (!r->err && len) {
+      Trie_InsertStringBuffer(IndexSpec_GetTermsTrie(sp, s), s, len, score, 0, NULL);
+    }
+  }
+  // The whole tries were just built, freeze them at once
+  if (sp->terms->uncompacted) {
+    Trie_Compact(sp->terms);
+  }
+  if (sp->phonetics && sp->phonetics->uncompacted) {
+    Trie_Compact(sp->phonetics);
+  }
+  if (sp->fieldTerms && sp->fieldTerms->uncompacted) {
+    Trie_Compact(sp->fieldTerms);
+  }
+}
+
+// The blocks are written in the record format, whatever format they are held in
+static void invertedIndexWrite(BufferWriter *bw, void *p) {
+  InvertedIndex *idx = p;
+  writeU64(bw, idx->flags);
+  writeU64(bw, idx->lastId);
+  writeU64(bw, idx->numDocs);
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < idx->size; i++) {
+    size += idx->blocks[i].numEntries > 0;
+  }
+  writeU64(bw, size);
+  for (uint32_t i = 0; i < idx->size; i++) {
+    if (idx->blocks[i].numEntries == 0) {
+      continue;
+    }
+    IndexBlock warm;
+    const IndexBlock *blk = IndexBlock_Warm(&idx->blocks[i], &warm);
+    writeU64(bw, blk->firstId);
+    writeU64(bw, blk->lastId);
+    writeU64(bw, blk->numEntries);
+    if (IndexBlock_IsSealed(blk)) {
+      Buffer records;
+      IndexBlock_ToRecordBuffer(blk, idx->flags, &records);
+      writeString(bw, records.data, records.offset);
+      Buffer_Free(&records);
+    } else {
+      writeString(bw, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    }
+    IndexBlock_ReleaseWarm(&idx->blocks[i], &warm);
+  }
+}
+
+static InvertedIndex *invertedIndexRead(sectionReader *r) {
+  InvertedIndex *idx = NewInvertedIndex(readU64(r), 0);
+  idx->lastId = readU64(r);
+  idx->numDocs = readU64(r);
+  uint32_t size = readU64(r);
+  // the count is not trusted before the blocks are read
+  uint32_t cap = MAX(MIN(size, 1024), 1);
+  IndexBlock *blocks = rm_malloc(cap * sizeof(IndexBlock));
+  uint32_t n = 0;
+  for (; n < size && !r->err; n++) {
+    if (n == cap) {
+      cap *= 2;
+      blocks = rm_realloc(blocks, cap * sizeof(IndexBlock));
+    }
+    IndexBlock *blk = &blocks[n];
+    *blk = (IndexBlock){0};
+    blk->firstId = readU64(r);
+    blk->lastId = readU64(r);
+    blk->numEntries = readU64(r);
+    // The frequencies of the stored entries are not known without decoding them
+    blk->maxFreq = UINT32_MAX;
+    size_t len;
+    const char *data = readString(r, &len);
+    if (r->err) {
+      break;
+    }
+    if (len) {
+      blk->buf.data = rm_malloc(len);
+      memcpy(blk->buf.data, data, len);
+      blk->buf.cap = blk->buf.offset = len;
+    }
+  }
+  InvertedIndex_SetLoadedBlocks(idx, blocks, n);
+  return idx;
+}
+
+// Whether a value is saved as an integer rather than as a double
+static bool isIntegral(double d) {
+  return fabs(d) < 9007199254740992.0 && d == (double)(int64_t)d && !(d == 0 && signbit(d));
+}
+
+/* The entries of every leaf range are prefixed by their count, a 0 count ends them. An entry is
+ * the delta of its doc id from the previous one in its range (0 for another value of the same
+ * document), shifted left by one with the low bit set if the value is integral. The value follows,
+ * zigzag encoded if integral and as a double otherwise */
+static void numericIndexWrite(BufferWriter *bw, void *p) {
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(p);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    if (!NumericRangeNode_IsLeaf(node) || !node->range || !node->range->entries->numEntries) {
+      continue;
+    }
+    writeVarU64(bw, node->range->entries->numEntries);
+    RSIndexResult *res = NULL;
+    IndexReader *ir = NewNumericReader(NULL, node->range->entries, NULL, 0, 0, false);
+    t_docId last = 0;
+    size_t count = 0;
+    while (INDEXREAD_OK == IR_Read(ir, &res)) {
+      double v = res->num.value;
+      bool integral = isIntegral(v);
+      writeVarU64(bw, ((res->docId - last) << 1) | integral);
+      if (integral) {
+        int64_t i = v;
+        writeVarU64(bw, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+      } else {
+        writeDouble(bw, v);
+      }
+      last = res->docId;
+      count++;
+    }
+    IR_Free(ir);
+    RS_LOG_ASSERT(count == node->range->entries->numEntries, "not all the entries were saved to rdb");
+  }
+  NumericRangeTreeIterator_Free(iter);
+  writeVarU64(bw, 0);
+}
+
+static NumericRangeTree *numericIndexRead(sectionReader *r, int encver) {
+  arrayof(NumericRangeEntry) entries = array_new(NumericRangeEntry, 64);
+  if (encver < INDEX_COMPRESSED_CONTENT_VERSION) {
+    // Doc ids and doubles, up to a 0 doc id
+    t_docId docId;
+    while ((docId = readU64(r))) {
+      NumericRangeEntry cur = {.docId = docId, .value = readDouble(r)};
+      entries = array_append(entries, cur);
+    }
+  } else {
+    size_t n;
+    while ((n = readVarU64(r)) && !r->err) {
+      t_docId docId = 0;
+      // the count is not trusted before the entries are read
+      for (size_t i = 0; i < n && !r->err; i++) {
+        uint64_t u = readVarU64(r);
+        docId += u >> 1;
+        NumericRangeEntry cur = {.docId = docId};
+        if (u & 1) {
+          uint64_t z = readVarU64(r);
+          cur.value = (double)(int64_t)((z >> 1) ^ -(z & 1));
+        } else {
+          cur.value = readDouble(r);
+        }
+        entries = array_append(entries, cur);
+      }
+    }
+  }
+  NumericRangeTree *t = NumericRangeTree_FromEntries(entries, array_len(entries));
+  array_free(entries);
+  return t;
+}
+
+static void tagIndexWrite(BufferWriter *bw, void *p) {
+  TagIndex *idx = p;
+  writeU64(bw, idx->values->cardinality);
+  TrieMapIterator *it = TrieMap_Iterate(idx->values, "", 0);
+  char *str;
+  tm_len_t slen;
+  void *ptr;
+  while (TrieMapIterator_Next(it, &str, &slen, &ptr)) {
+    writeString(bw, str, slen);
+    invertedIndexWrite(bw, ptr);
+  }
+  TrieMapIterator_Free(it);
+}
+
+static TagIndex *tagIndexRead(sectionReader *r) {
+  TagIndex *idx = NewTagIndex();
+  size_t n = readU64(r);
+  for (size_t i = 0; i < n && !r->err; i++) {
+    size_t len;
+    const char *s = readString(r, &len);
+    InvertedIndex *inv = invertedIndexRead(r);
+    TrieMap_Add(idx->values, (char *)s, MIN(len, MAX_TAG_LEN), inv, NULL);
+  }
+  TagIndex_ForgetDocValues(idx);
+  return idx;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  IndexSpec *sp;
+  PersistedSectionKind kind;
+  KeysDictValue *kdv;  // NULL for the terms
+  char *data;          // allocated by the RDB loader
+  size_t len;
+  int encver;
+} decodeJob;
+
+static void decodeJob_Run(void *p) {
+  decodeJob *job = p;
+  sectionReader r = {.data = job->data, .len = job->len};
+  char *inflated = NULL;
+  if (job->encver >= INDEX_COMPRESSED_CONTENT_VERSION &&
+      !sectionOpen(&r, job->data, job->len, &inflated)) {
+    // Decoded as an empty section, so that its key still gets an index
+    r = (sectionReader){.data = "", .err = true};
+  }
+  switch (job->kind) {
+    case PersistedSection_Terms:
+      termsRead(&r, job->sp);
+      break;
+    case PersistedKey_Term:
+      job->kdv->p = invertedIndexRead(&r);
+      break;
+    case PersistedKey_Numeric:
+      job->kdv->p = numericIndexRead(&r, job->encver);
+      break;
+    case PersistedKey_Tag:
+      job->kdv->p = tagIndexRead(&r);
+      break;
+  }
+  bool failed = r.err || r.pos != r.len;
+  rm_free(inflated);
+  RedisModule_Free(job->data);
+
+  pthread_mutex_lock(&decodeLock_g);
+  struct IndexRestore *restore = job->sp->restore;
+  restore->failed |= failed;
+  if (!--restore->pending) {
+    pthread_cond_broadcast(&decoded_g);
+  }
+  pthread_mutex_unlock(&decodeLock_g);
+  rm_free(job);
+}
+
+// Read a section and queue it to be decoded by the indexing pool, or decode it right away if
+// there is none
+static int loadSection(RedisModuleIO *rdb, IndexSpec *sp, PersistedSectionKind kind,
+                       KeysDictValue *kdv, int encver) {
+  size_t len;
+  char *data = LoadStringBuffer_IOError(rdb, &len, return REDISMODULE_ERR);
+  decodeJob *job = rm_malloc(sizeof(*job));
+  *job = (decodeJob){
+      .sp = sp, .kind = kind, .kdv = kdv, .data = data, .len = len, .encver = encver};
+
+  pthread_mutex_lock(&decodeLock_g);
+  ++sp->restore->pending;
+  pthread_mutex_unlock(&decodeLock_g);
+  if (CONCURRENT_POOL_INDEX != -1) {
+    ConcurrentSearch_ThreadPoolRun(decodeJob_Run, job, CONCURRENT_POOL_INDEX);
+  } else {
+    decodeJob_Run(job);
+  }
+  return REDISMODULE_OK;
+}
+
+static int keysRdbLoad(RedisModuleIO *rdb, IndexSpec *sp, int encver) {
+  size_t n = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  while (n--) {
+    int kind = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+    if (kind < PersistedKey_Term || kind > PersistedKey_Tag) {
+      return REDISMODULE_ERR;
+    }
+    RedisModuleString *key = RedisModule_LoadString(rdb);
+    if (RedisModule_IsIOError(rdb)) {
+      if (key) RedisModule_FreeString(NULL, key);
+      return REDISMODULE_ERR;
+    }
+    KeysDictValue *kdv = rm_calloc(1, sizeof(*kdv));
+    kdv->dtor = kind == PersistedKey_Term      ? InvertedIndex_Free
+                : kind == PersistedKey_Numeric ? (void (*)(void *))NumericRangeTree_Free
+                                               : TagIndex_Free;
+    // The dictionary copies the key
+    int rc = dictAdd(sp->keysDict, key, kdv);
+    RedisModule_FreeString(NULL, key);
+    if (rc != DICT_OK) {
+      rm_free(kdv);
+      return REDISMODULE_ERR;
+    }
+    // Until it is decoded the entry has no index, which the spec waits for before it is used
+    if (loadSection(rdb, sp, kind, kdv, encver) != REDISMODULE_OK) {
+      kdv->dtor = NULL;
+      return REDISMODULE_ERR;
+    }
+  }
+  return REDISMODULE_OK;
+}
+
+static void waitDecoded(struct IndexRestore *restore) {
+  pthread_mutex_lock(&decodeLock_g);
+  while (restore->pending) {
+    pthread_cond_wait(&decoded_g, &decodeLock_g);
+  }
+  pthread_mutex_unlock(&decodeLock_g);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+void IndexPersistence_RdbSave(RedisModuleIO *rdb, IndexSpec *sp) {
+  // A fork may snapshot the spec halfway through a write, in which case it is not saved. The lock
+  // is copied locked into the child, so trying it tells
+  bool persist = false;
+  if (RSGlobalConfig.persistIndexes && !pthread_rwlock_tryrdlock(&sp->rwlock)) {
+    persist = canPersist(sp);
+    if (!persist) {
+      pthread_rwlock_unlock(&sp->rwlock);
+    }
+  }
+  RedisModule_SaveUnsigned(rdb, persist);
+  if (!persist) {
+    return;
+  }
+
+  statsRdbSave(rdb, &sp->stats);
+  DocTable_RdbSave(&sp->docs, rdb);
+  saveSection(rdb, termsWrite, sp);
+
+  RedisModule_SaveUnsigned(rdb, sp->keysDict ? dictSize(sp->keysDict) : 0);
+  if (sp->keysDict) {
+    dictIterator *iter = dictGetIterator(sp->keysDict);
+    dictEntry *de;
+    while ((de = dictNext(iter))) {
+      KeysDictValue *kdv = dictGetVal(de);
+      int kind = keyKind(kdv);
+      RedisModule_SaveUnsigned(rdb, kind);
+      RedisModule_SaveString(rdb, dictGetKey(de));
+      saveSection(rdb,
+                  kind == PersistedKey_Term      ? invertedIndexWrite
+                  : kind == PersistedKey_Numeric ? numericIndexWrite
+                                                 : tagIndexWrite,
+                  kdv->p);
+    }
+    dictReleaseIterator(iter);
+  }
+  pthread_rwlock_unlock(&sp->rwlock);
+}
+
+int IndexPersistence_RdbLoad(RedisModuleIO *rdb, IndexSpec *sp, int encver) {
+  bool persisted = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  if (!persisted) {
+    return REDISMODULE_OK;
+  }
+  // The spec is not registered yet, and its GC is only scheduled from the event loop, so no one
+  // else can reach it meanwhile. The doc table is loaded right away, as the keys loaded next are
+  // looked up in it
+  sp->restore = rm_calloc(1, sizeof(*sp->restore));
+  statsRdbLoad(rdb, &sp->stats);
+  if (RedisModule_IsIOError(rdb) ||
+      DocTable_RdbLoad(&sp->docs, sp->sortables, rdb) != REDISMODULE_OK ||
+      loadSection(rdb, sp, PersistedSection_Terms, NULL, encver) != REDISMODULE_OK ||
+      keysRdbLoad(rdb, sp, encver) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+void IndexPersistence_Track(IndexSpec *sp) {
+  if (!restored_g) {
+    restored_g = array_new(StrongRef, 1);
+  }
+  restored_g = array_append(restored_g, StrongRef_Clone(sp->own_ref));
+}
+
+void IndexPersistence_KeyLoadStart(RedisModuleString *key) {
+  if (!restored_g || !array_len(restored_g)) {
+    return;
+  }
+  keyLoading_g = true;
+  size_t n;
+  const char *s = RedisModule_StringPtrLen(key, &n);
+  for (size_t i = 0; i < array_len(restored_g); ++i) {
+    IndexSpec *sp = StrongRef_Get(restored_g[i]);
+    if (sp && sp->restore && DocIdMap_Get(&sp->docs.dim, s, n)) {
+      sp->restore->loadedKeys++;
+    }
+  }
+}
+
+void IndexPersistence_KeyLoadEnd() {
+  keyLoading_g = false;
+}
+
+bool IndexPersistence_Skip(IndexSpec *sp) {
+  if (!sp->restore) {
+    return false;
+  }
+  if (keyLoading_g) {
+    return true;
+  }
+  // A command replayed from the AOF after its RDB preamble is indexed as usual, into the whole
+  // contents
+  waitDecoded(sp->restore);
+  return false;
+}
+
+void IndexPersistence_Free(IndexSpec *sp) {
+  if (!sp->restore) {
+    return;
+  }
+  waitDecoded(sp->restore);
+  rm_free(sp->restore);
+  sp->restore = NULL;
+}
+
+// Drop the documents of the keys that were not loaded
+static void dropMissingDocs(RedisModuleCtx *ctx, IndexSpec *sp) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  size_t dropped = 0;
+  DOCTABLE_FOREACH((&sp->docs), {
+    RedisModuleString *key = RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
+    RedisModuleKey *k = RedisModule_OpenKey(ctx, key, REDISMODULE_READ);
+    if (!k || RedisModule_KeyType(k) == REDISMODULE_KEYTYPE_EMPTY) {
+      IndexSpec_DeleteDoc_Unsafe(sp, ctx, key, dmd->id);
+      ++dropped;
+    }
+    if (k) RedisModule_CloseKey(k);
+    RedisModule_FreeString(ctx, key);
+  });
+  RedisSearchCtx_UnlockSpec(&sctx);
+  RedisModule_Log(ctx, "warning", "Index %s: dropped %zu restored documents of missing keys",
+                  sp->name, dropped);
+}
+
+void IndexPersistence_LoadingEnded(RedisModuleCtx *ctx, bool verify) {
+  if (!restored_g) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(restored_g); ++i) {
+    IndexSpec *sp = StrongRef_Get(restored_g[i]);
+    if (sp && sp->restore) {
+      waitDecoded(sp->restore);
+      size_t numDocs = sp->docs.size - 1;
+      bool failed = sp->restore->failed;
+      if (verify && sp->restore->loadedKeys != numDocs) {
+        dropMissingDocs(ctx, sp);
+      } else if (!failed) {
+        RedisModule_Log(ctx, "notice", "Index %s: restored %zu documents from the RDB", sp->name,
+                        numDocs);
+      }
+      IndexPersistence_Free(sp);
+      if (!failed && verify) {
+        restoredIndexes_g++;
+        restoredDocs_g += sp->docs.size - 1;
+      } else if (failed) {
+        corruptIndexes_g++;
+        RedisModule_Log(ctx, "warning", "Index %s: corrupt contents in the RDB, reindexing",
+                        sp->name);
+        IndexSpec_ScanAndReindex(ctx, restored_g[i]);
+      }
+    }
+    StrongRef_Release(restored_g[i]);
+  }
+  array_free(restored_g);
+  restored_g = NULL;
+}
+
+void IndexPersistence_Reset() {
+  if (!restored_g) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(restored_g); ++i) {
+    IndexSpec *sp = StrongRef_Get(restored_g[i]);
+    if (sp) {
+      IndexPersistence_Free(sp);
+    }
+    StrongRef_Release(restored_g[i]);
+  }
+  array_free(restored_g);
+  restored_g = NULL;
+  keyLoading_g = false;
+}
+
+void IndexPersistence_AddToInfo(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "index_persistence");
+  RedisModule_InfoAddFieldULongLong(ctx, "restored_indexes", restoredIndexes_g);
+  RedisModule_InfoAddFieldULongLong(ctx, "restored_documents", restoredDocs_g);
+  RedisModule_InfoAddFieldULongLong(ctx, "corrupt_indexes", corruptIndexes_g);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* The contents of the indexes saved along with their definitions in the RDB (see the
+ * PERSIST_INDEXES config), so that loading it restores them instead of indexing every key again.
+ *
+ * Past the doc table, the contents are saved as self contained sections: the terms trie, and
+ * every inverted index, numeric tree and tag index. The main thread reads a section at once and
+ * queues it to the indexing pool to be decoded, and goes on reading the RDB, so the indexes are
+ * rebuilt on all the cores while the keys load. A spec waits for its sections before it is
+ * written to or freed.
+ *
+ * The aux data of the module is saved before the keys, in the same snapshot, so the restored
+ * contents match the keys loaded after them. While they load, the restored indexes do not index
+ * them again but count those they already hold. Once loading ends, an index that does not hold
+ * exactly the loaded keys - some expired, or the RDB was edited - drops the documents of the
+ * missing keys.
+ *
+ * An index is only saved in a consistent state: not scanning, no pending async updates, and not
+ * locked for write when the snapshot is taken. The vector and geometry indexes, and the suffix
+ * tries, have no serialization, so their indexes are saved without contents and reindexed as
+ * before.
+ *
+ * Since INDEX_COMPRESSED_CONTENT_VERSION each section starts with its encoding, and is deflated when
+ * that makes it smaller, and the numeric entries are delta and varint encoded.
+ *
+ * A full sync sends the replica an RDB produced the same way, so a replica restores the indexes of
+ * a primary that persists them, whatever its own config, and indexes the replicated writes that
+ * follow as usual. Its indexes are then ready as soon as the sync completes, rather than after
+ * scanning the whole keyspace. The LAZY indexes are saved without contents too, they are loaded on first access */
+
+/* Save the contents of an index, or a marker that they are not saved */
+void IndexPersistence_RdbSave(RedisModuleIO *rdb, struct IndexSpec *sp);
+
+/* Load the contents of an index saved by IndexPersistence_RdbSave into the newly loaded spec,
+ * marking it as restoring if they were saved. Its sections are decoded in the background. Returns
+ * REDISMODULE_ERR on a short read */
+int IndexPersistence_RdbLoad(RedisModuleIO *rdb, struct IndexSpec *sp, int encver);
+
+/* Track a restored spec, once it is registered, until loading ends */
+void IndexPersistence_Track(struct IndexSpec *sp);
+
+/* Called around the indexing of a key loaded from the RDB */
+void IndexPersistence_KeyLoadStart(RedisModuleString *key);
+void IndexPersistence_KeyLoadEnd();
+
+/* Whether the spec should not index the key being loaded, as it was restored with it. Otherwise
+ * waits for the contents of a restored spec to be decoded, as it is about to be written to */
+bool IndexPersistence_Skip(struct IndexSpec *sp);
+
+/* Wait for the sections of a restored spec and free its restore state. Called when the spec is
+ * freed */
+void IndexPersistence_Free(struct IndexSpec *sp);
+
+/* Wait for the restored specs to be decoded, check them against the loaded keys, and stop
+ * tracking them. A spec with a corrupt section is reindexed. If `verify` is false the keys were
+ * not reported as they loaded, and the specs are rescanned anyway */
+void IndexPersistence_LoadingEnded(RedisModuleCtx *ctx, bool verify);
+
+/* Stop tracking the restored specs, when a load starts or fails */
+void IndexPersistence_Reset();
+
+/* Report the indexes restored from the RDBs loaded since startup, and those found corrupt */
+void IndexPersistence_AddToInfo(RedisModuleInfoCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,6 +9,7 @@
 #include "rmalloc.h"
 #include <math.h>
 #include <sys/param.h>
+#include <string.h>
 #include "src/util/arr.h"
 #include "value.h"
 
@@ -223,8 +224,17 @@ int RSIndexResult_HasOffsets(const RSIndexResult *res) {
     case RSResultType_Intersection:
     case RSResultType_Union:
       // the intersection and union aggregates can have offsets if they are not purely made of
-      // virtual results
-      return res->agg.typeMask != RSResultType_Virtual && res->agg.typeMask != RSResultType_Numeric;
+      // virtual results, and one of their children has them. The terms found only in NOOFFSETS
+      // fields have no offsets, and do not constrain the distance of the others
+      if (res->agg.typeMask == RSResultType_Virtual || res->agg.typeMask == RSResultType_Numeric) {
+        return 0;
+      }
+      for (int i = 0; i < res->agg.numChildren; i++) {
+        if (RSIndexResult_HasOffsets(res->agg.children[i])) {
+          return 1;
+        }
+      }
+      return 0;
 
     // a virtual result doesn't have offsets!
     case RSResultType_Virtual:
@@ -468,6 +478,146 @@ int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positi
   return 0;
 }
 
+/* Results with up to this many children, each with up to this many offsets, are checked over
+ * decoded arrays of their offsets rather than through offset iterators */
+#define RANGE_MAX_DECODED_CHILDREN 16
+#define RANGE_MAX_DECODED_OFFSETS 64
+
+typedef struct {
+  uint32_t len;
+  uint32_t offsets[RANGE_MAX_DECODED_OFFSETS];
+} DecodedOffsets;
+
+/* Decode the offsets of a result. Returns false if it has none, or too many of them */
+static bool decodeOffsets(const RSIndexResult *r, DecodedOffsets *d) {
+  if (r->type == RSResultType_Term) {
+    d->len = RSOffsetVector_Decode(&r->term.offsets, d->offsets, RANGE_MAX_DECODED_OFFSETS);
+    return d->len && d->len <= RANGE_MAX_DECODED_OFFSETS;
+  }
+  RSOffsetIterator it = RSIndexResult_IterateOffsets(r);
+  uint32_t pos;
+  d->len = 0;
+  while ((pos = it.Next(it.ctx, NULL)) != RS_OFFSETVECTOR_EOF &&
+         d->len < RANGE_MAX_DECODED_OFFSETS) {
+    d->offsets[d->len++] = pos;
+  }
+  it.Free(it.ctx);
+  return d->len && pos == RS_OFFSETVECTOR_EOF;
+}
+
+/* The same as __indexResult_withinRangeInOrder, over decoded offsets */
+static int withinRangeInOrderDecoded(const DecodedOffsets *d, int num, int maxSlop) {
+  uint32_t cur[num];
+  memset(cur, 0, sizeof(cur));
+  for (uint32_t first = 0; first < d[0].len; ++first) {
+    uint32_t lastPos = d[0].offsets[first];
+    int span = 0;
+    for (int i = 1; i < num; ++i) {
+      // the first offset of the child not before the previous one
+      const uint32_t *offsets = d[i].offsets;
+      uint32_t j = cur[i], len = d[i].len;
+      while (j < len && offsets[j] < lastPos) {
+        ++j;
+      }
+      if (j == len) {
+        return 0;
+      }
+      cur[i] = j;
+      span += (int)offsets[j] - (int)lastPos - 1;
+      if (span > maxSlop) {
+        break;
+      }
+      lastPos = offsets[j];
+    }
+    if (span <= maxSlop) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* The same as __indexResult_withinRangeUnordered, over decoded offsets */
+static int withinRangeUnorderedDecoded(const DecodedOffsets *d, int num, int maxSlop) {
+  uint32_t cur[num], positions[num];
+  for (int i = 0; i < num; ++i) {
+    cur[i] = 0;
+    positions[i] = d[i].offsets[0];
+  }
+  uint32_t minPos, maxPos, min, max;
+  max = _arrayMax(positions, num, &maxPos);
+  while (1) {
+    min = _arrayMin(positions, num, &minPos);
+    if (min != max && (int)max - (int)min - (num - 1) <= maxSlop) {
+      return 1;
+    }
+    if (++cur[minPos] == d[minPos].len) {
+      return 0;
+    }
+    positions[minPos] = d[minPos].offsets[cur[minPos]];
+    if (positions[minPos] > max) {
+      maxPos = minPos;
+      max = positions[minPos];
+    }
+  }
+}
+
+/* An exact phrase: whether there is an offset p of the first child such that p + i is an offset
+ * of child i. The candidates are intersected with each child in a branchless merge */
+static int withinRangeExactDecoded(const DecodedOffsets *d, int num) {
+  uint32_t cand[RANGE_MAX_DECODED_OFFSETS];
+  uint32_t ncand = d[0].len;
+  memcpy(cand, d[0].offsets, ncand * sizeof(*cand));
+  for (int i = 1; i < num && ncand; ++i) {
+    const uint32_t *offsets = d[i].offsets;
+    uint32_t len = d[i].len, c = 0, j = 0, n = 0;
+    while (c < ncand && j < len) {
+      uint32_t a = cand[c] + i, b = offsets[j];
+      cand[n] = cand[c];
+      n += a == b;
+      c += a <= b;
+      j += b <= a;
+    }
+    ncand = n;
+  }
+  return ncand != 0;
+}
+
+/* Whether all the children are terms, different from one another. Different terms can't share an
+ * offset, which is what an exact phrase over intersected offsets relies on */
+static bool distinctTerms(RSIndexResult **children, int num) {
+  for (int i = 0; i < num; ++i) {
+    const RSQueryTerm *t = children[i]->term.term;
+    if (children[i]->type != RSResultType_Term || !t || !t->str) {
+      return false;
+    }
+    for (int j = 0; j < i; ++j) {
+      const RSQueryTerm *other = children[j]->term.term;
+      if (other->len == t->len && !memcmp(other->str, t->str, t->len)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Check the range over the decoded offsets of the children. Returns -1 if they have too many
+ * offsets to be decoded */
+static int withinRangeDecoded(RSIndexResult **children, int num, int maxSlop, int inOrder) {
+  DecodedOffsets decoded[num];
+  for (int i = 0; i < num; ++i) {
+    if (!decodeOffsets(children[i], &decoded[i])) {
+      return -1;
+    }
+  }
+  if (!inOrder) {
+    return withinRangeUnorderedDecoded(decoded, num, maxSlop);
+  }
+  if (maxSlop == 0 && distinctTerms(children, num)) {
+    return withinRangeExactDecoded(decoded, num);
+  }
+  return withinRangeInOrderDecoded(decoded, num, maxSlop);
+}
+
 /** Test the result offset vectors to see if they fall within a max "slop" or distance between the
  * terms. That is the total number of non matched offsets between the terms is no bigger than
  * maxSlop.
@@ -483,6 +633,24 @@ int IndexResult_IsWithinRange(RSIndexResult *ir, int maxSlop, int inOrder) {
   RSAggregateResult *r = &ir->agg;
   int num = r->numChildren;
 
+  if (num <= RANGE_MAX_DECODED_CHILDREN) {
+    // collect only nodes that can have offsets
+    RSIndexResult *children[num];
+    int n = 0;
+    for (int i = 0; i < num; i++) {
+      if (RSIndexResult_HasOffsets(r->children[i])) {
+        children[n++] = r->children[i];
+      }
+    }
+    if (n == 0) {
+      return 1;
+    }
+    int rc = withinRangeDecoded(children, n, maxSlop, inOrder);
+    if (rc != -1) {
+      return rc;
+    }
+  }
+
   // Fill a list of iterators and the last read positions
   RSOffsetIterator iters[num];
   uint32_t positions[num];
@@ -115,6 +115,10 @@ int IndexResult_MinOffsetDelta(const RSIndexResult *r);
  * matching terms is returned */
 size_t IndexResult_GetMatchedTerms(RSIndexResult *r, RSQueryTerm **arr, size_t cap);
 
+/* Decode the offsets of a vector into `out`, which holds up to `cap` offsets. Returns the number
+ * of offsets, or `cap + 1` if the vector has more than `cap` of them */
+uint32_t RSOffsetVector_Decode(const RSOffsetVector *v, uint32_t *out, uint32_t cap);
+
 /* Return 1 if the the result is within a given slop range, inOrder determines whether the tokens
  * need to be ordered as in the query or not */
 int IndexResult_IsWithinRange(RSIndexResult *r, int maxSlop, int inOrder);
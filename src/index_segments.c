@@ -0,0 +1,143 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "index_segments.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "redismodule.h"
+#include "rmutil/sds.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define INDEX_SEGMENT_SIZE (64 * 1024 * 1024)
+
+typedef struct IndexSegment {
+  char *base;
+  size_t used;
+  // The bytes of the live blocks held in the segment, plus one while it is appended to. The last
+  // one to release it unmaps it
+  size_t live;
+} IndexSegment;
+
+/* Precedes the data of every block in a segment, so that it is released by its address alone */
+typedef struct {
+  IndexSegment *seg;
+  size_t size;  // Including this header and the padding following the data
+} segmentEntry;
+
+// Blocks are sealed on the main thread and on the indexing pool, the lock guards the current
+// segment. Releasing a block does not take it, so the fork GC child never waits on it
+static pthread_mutex_t lock_g = PTHREAD_MUTEX_INITIALIZER;
+static IndexSegment *current_g = NULL;
+static bool failed_g = false;
+
+static size_t mapped_g = 0;
+static size_t live_g = 0;
+
+static void segment_Free(IndexSegment *seg) {
+  munmap(seg->base, INDEX_SEGMENT_SIZE);
+  __atomic_sub_fetch(&mapped_g, INDEX_SEGMENT_SIZE, __ATOMIC_RELAXED);
+  rm_free(seg);
+}
+
+static void segment_Unref(IndexSegment *seg, size_t n) {
+  if (__atomic_sub_fetch(&seg->live, n, __ATOMIC_ACQ_REL) == 0) {
+    segment_Free(seg);
+  }
+}
+
+/* Create and map a new segment file. The file is unlinked right away, its space stays reserved as
+ * long as it is mapped. Logs and returns NULL on failure */
+static IndexSegment *segment_New(const char *dir) {
+  sds path = sdscatfmt(sdsempty(), "%s/redisearch-segment-XXXXXX", dir);
+  void *base = MAP_FAILED;
+  int fd = mkstemp(path);
+  if (fd != -1) {
+    unlink(path);
+    // Reserve the blocks of the file, so that writing to the mapping does not fault on a full disk
+    int rc = posix_fallocate(fd, 0, INDEX_SEGMENT_SIZE);
+    if (rc == 0) {
+      base = mmap(NULL, INDEX_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+      errno = rc;
+    }
+  }
+  if (base == MAP_FAILED) {
+    RedisModule_Log(NULL, "warning",
+                    "Could not create an index segment in %s (%s), keeping the indexes in memory",
+                    dir, strerror(errno));
+    if (fd != -1) close(fd);
+    sdsfree(path);
+    return NULL;
+  }
+  close(fd);
+  sdsfree(path);
+
+  IndexSegment *seg = rm_calloc(1, sizeof(*seg));
+  seg->base = base;
+  seg->live = 1;
+  __atomic_add_fetch(&mapped_g, INDEX_SEGMENT_SIZE, __ATOMIC_RELAXED);
+  return seg;
+}
+
+bool IndexSegments_Adopt(Buffer *buf) {
+  const char *dir = RSGlobalConfig.indexSegmentsDir;
+  size_t len = buf->offset;
+  size_t size = sizeof(segmentEntry) + ((len + 7) & ~(size_t)7);
+  if (!dir || !len || size > INDEX_SEGMENT_SIZE) {
+    return false;
+  }
+
+  pthread_mutex_lock(&lock_g);
+  if (current_g && current_g->used + size > INDEX_SEGMENT_SIZE) {
+    // Full, no longer appended to
+    segment_Unref(current_g, 1);
+    current_g = NULL;
+  }
+  if (!current_g && !failed_g) {
+    current_g = segment_New(dir);
+    // Do not try again for every block
+    failed_g = !current_g;
+  }
+  IndexSegment *seg = current_g;
+  segmentEntry *entry = NULL;
+  if (seg) {
+    entry = (segmentEntry *)(seg->base + seg->used);
+    seg->used += size;
+    __atomic_add_fetch(&seg->live, size, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&lock_g);
+  if (!entry) {
+    return false;
+  }
+
+  *entry = (segmentEntry){.seg = seg, .size = size};
+  memcpy(entry + 1, buf->data, len);
+  __atomic_add_fetch(&live_g, size, __ATOMIC_RELAXED);
+  Buffer_Free(buf);
+  buf->data = (char *)(entry + 1);
+  buf->cap = len;
+  return true;
+}
+
+void IndexSegments_Release(void *data) {
+  segmentEntry *entry = (segmentEntry *)data - 1;
+  size_t size = entry->size;
+  __atomic_sub_fetch(&live_g, size, __ATOMIC_RELAXED);
+  segment_Unref(entry->seg, size);
+}
+
+void IndexSegments_AddToInfo(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "index_segments");
+  RedisModule_InfoAddFieldULongLong(ctx, "mapped_bytes",
+                                    __atomic_load_n(&mapped_g, __ATOMIC_RELAXED));
+  RedisModule_InfoAddFieldULongLong(ctx, "live_bytes", __atomic_load_n(&live_g, __ATOMIC_RELAXED));
+}
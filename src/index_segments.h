@@ -0,0 +1,42 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "buffer.h"
+#include "redismodule.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Segments of mapped files holding the data of the sealed blocks of the inverted indexes (see the
+ * INDEX_SEGMENTS_DIR config), so that the kernel can page out the postings which are not read
+ * instead of keeping them all on the heap.
+ *
+ * A sealed block is immutable, so its data is appended to the current segment once and never
+ * written again. A block the GC repairs, or a full block written to again after the GC removed the
+ * blocks following it, moves back to a buffer of its own. The files are unlinked as soon as they
+ * are created - they are scratch space and are not read on restart. A segment is unmapped once it
+ * holds no live block, and is otherwise kept whole: the data of the dead blocks in it is not
+ * compacted */
+
+/* Move the data of a buffer to the current segment, freeing the buffer. Returns false, leaving the
+ * buffer as is, if segments are disabled or the data could not be mapped */
+bool IndexSegments_Adopt(Buffer *buf);
+
+/* Release the data of a block held in a segment */
+void IndexSegments_Release(void *data);
+
+/* Report the total size of the mapped segments, and of the live blocks held in them */
+void IndexSegments_AddToInfo(RedisModuleInfoCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,7 @@
 #include "suffix.h"
 #include "rmutil/rm_assert.h"
 #include "phonetic_manager.h"
+#include "alloc_stats.h"
 
 extern RedisModuleCtx *RSDummyContext;
 
@@ -39,12 +40,49 @@ static void writeIndexEntry(IndexSpec *spec, InvertedIndex *idx, IndexEncoder en
   }
 }
 
+/* Write the entry again to the inverted index of its term in each SEPARATEPOSTINGS field it occurs
+ * in, with the field mask of that field only */
+static void writeFieldEntries(RedisSearchCtx *ctx, IndexEncoder encoder, ForwardIndexEntry *entry) {
+  IndexSpec *spec = ctx->spec;
+  t_fieldMask mask = entry->fieldMask & spec->separatePostingsMask;
+  if (!mask) {
+    return;
+  }
+  t_fieldMask entryMask = entry->fieldMask;
+  char term[FIELD_TERM_BUFLEN(entry->len)];
+  for (int i = 0; i < spec->numFields && mask; ++i) {
+    const FieldSpec *fs = spec->fields + i;
+    if (!FIELD_IS(fs, INDEXFLD_T_FULLTEXT) || !(mask & FIELD_BIT(fs))) {
+      continue;
+    }
+    mask &= ~FIELD_BIT(fs);
+    size_t len = IndexSpec_FormatFieldTerm(term, fs, entry->term, entry->len);
+    RedisModuleKey *idxKey = NULL;
+    bool isNew;
+    InvertedIndex *invidx = Redis_OpenInvertedIndexEx(ctx, term, len, 1, &isNew, &idxKey);
+    if (isNew) {
+      IndexSpec_AddTerm(spec, term, len);
+    }
+    if (invidx) {
+      entry->fieldMask = FIELD_BIT(fs);
+      writeIndexEntry(spec, invidx, encoder, entry);
+    }
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+  }
+  entry->fieldMask = entryMask;
+}
+
 // Number of terms for each block-allocator block
 #define TERMS_PER_BLOCK 128
 
 // Effectively limits the maximum number of documents whose terms can be merged
 #define MAX_BULK_DOCS 1024
 
+// The documents of a batch whose terms are merged at once, within the limits of doMerge
+#define BATCH_MERGE_DOCS 512
+
 // Entry for the merged dictionary
 typedef struct mergedEntry {
   KHTableEntry base;        // Base structure
@@ -175,6 +213,7 @@ static int writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
         IndexSpec_AddTerm(ctx->spec, fwent->term, fwent->len);
       }
 
+      t_fieldMask fieldMask = 0;
       for (; fwent != NULL; fwent = fwent->next) {
         // Get the Doc ID for this entry.
         // Note that we cache the lookup result itself, since accessing the
@@ -196,6 +235,24 @@ static int writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
         // Finally assign the document ID to the entry
         fwent->docId = docId;
         writeIndexEntry(ctx->spec, invidx, encoder, fwent);
+        writeFieldEntries(ctx, encoder, fwent);
+        fieldMask |= fwent->fieldMask;
+      }
+
+      IndexSpec *spec = ctx->spec;
+      const char *term = merged->head->term;
+      if (Index_StoreFieldMask(spec) && (invidx->fieldMask | fieldMask) != invidx->fieldMask) {
+        // the term now expands in queries restricted to the fields of the entries
+        invidx->fieldMask |= fieldMask;
+        IndexSpec_TermsChanged(spec);
+      }
+      if (spec->suffixMask & fieldMask && term[0] != STEM_PREFIX && term[0] != PHONETIC_PREFIX &&
+          term[0] != SYNONYM_PREFIX_CHAR) {
+        addSuffixTrie(spec->suffix, term, merged->head->len);
+      }
+      if (spec->ngramMask & fieldMask && term[0] != STEM_PREFIX && term[0] != PHONETIC_PREFIX &&
+          term[0] != SYNONYM_PREFIX_CHAR) {
+        NgramIndex_Add(spec->ngrams, term, merged->head->len);
       }
 
       if (idxKey) {
@@ -237,8 +294,11 @@ static void writeCurEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx, Re
       entry->docId = aCtx->doc->docId;
       RS_LOG_ASSERT(entry->docId, "docId should not be 0");
       writeIndexEntry(spec, invidx, encoder, entry);
-      if (Index_StoreFieldMask(spec)) {
+      writeFieldEntries(ctx, encoder, entry);
+      if (Index_StoreFieldMask(spec) && (invidx->fieldMask | entry->fieldMask) != invidx->fieldMask) {
+        // the term now expands in queries restricted to the fields of the entry
         invidx->fieldMask |= entry->fieldMask;
+        IndexSpec_TermsChanged(spec);
       }
     }
 
@@ -247,6 +307,11 @@ static void writeCurEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx, Re
                                             && entry->term[0] != SYNONYM_PREFIX_CHAR) {
       addSuffixTrie(spec->suffix, entry->term, entry->len);
     }
+    if (spec->ngramMask & entry->fieldMask && entry->term[0] != STEM_PREFIX
+                                           && entry->term[0] != PHONETIC_PREFIX
+                                           && entry->term[0] != SYNONYM_PREFIX_CHAR) {
+      NgramIndex_Add(spec->ngrams, entry->term, entry->len);
+    }
 
     if (idxKey) {
       RedisModule_CloseKey(idxKey);
@@ -265,15 +330,18 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
                                           int replace, QueryError *status) {
   DocTable *table = &spec->docs;
   Document *doc = aCtx->doc;
+  RSDocumentFlags flags = aCtx->docFlags;
   if (replace) {
     RSDocumentMetadata *dmd = DocTable_PopR(table, doc->docKey);
     if (dmd) {
+      // the queries reading the index since before keep seeing the document (see RPIndexIterator)
+      flags |= Document_Replaced;
       // decrease the number of documents in the index stats only if the document was there
       --spec->stats.numDocuments;
       DMD_Return(aCtx->oldMd);
       aCtx->oldMd = dmd;
       if (spec->gc) {
-        GCContext_OnDelete(spec->gc);
+        GCContext_OnDelete(spec->gc, dmd->id);
       }
       if (spec->flags & Index_HasVecSim) {
         for (int i = 0; i < spec->numFields; ++i) {
@@ -289,6 +357,7 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
       if (spec->flags & Index_HasGeometry) {
         GeometryIndex_RemoveId(ctx, spec, dmd->id);
       }
+      IndexSpec_RemoveExistence(spec, dmd->id);
     }
   }
 
@@ -296,9 +365,10 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
   const char *s = RedisModule_StringPtrLen(doc->docKey, &n);
 
   RSDocumentMetadata *dmd =
-      DocTable_Put(table, s, n, doc->score, aCtx->docFlags, doc->payload, doc->payloadSize, doc->type);
+      DocTable_Put(table, s, n, doc->score, flags, doc->payload, doc->payloadSize, doc->type);
   if (dmd) {
     doc->docId = dmd->id;
+    dmd->indexedHash = aCtx->indexedHash;
     ++spec->stats.numDocuments;
   }
 
@@ -359,6 +429,9 @@ static void indexBulkFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
     for (size_t ii = 0; ii < doc->numFields; ++ii) {
       const FieldSpec *fs = cur->fspecs + ii;
       FieldIndexerData *fdata = cur->fdatas + ii;
+      if (FieldSpec_IndexesMissing(fs) && !fdata->isNull) {
+        ExistenceIndex_Add(IndexSpec_GetExistence(sctx->spec, fs), doc->docId);
+      }
       if (fs->types == INDEXFLD_T_FULLTEXT || !FieldSpec_IsIndexable(fs) || fdata->isNull) {
         continue;
       }
@@ -405,7 +478,9 @@ static void Indexer_Process(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
     }
   }
 
-  int useTermHt = indexer->size > 1 && (aCtx->stateFlags & ACTX_F_TEXTINDEXED) == 0;
+  // The queue of a blockable document, or a batch of non-blockable ones, are merged
+  int useTermHt = (indexer->size > 1 || (!AddDocumentCtx_IsBlockable(aCtx) && aCtx->next)) &&
+                  (aCtx->stateFlags & ACTX_F_TEXTINDEXED) == 0;
   if (useTermHt) {
     firstZeroId = doMerge(aCtx, &indexer->mergeHt, parentMap);
     if (firstZeroId && firstZeroId->stateFlags & ACTX_F_ERRORED) {
@@ -429,7 +504,6 @@ static void Indexer_Process(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
     ctx.redisCtx = indexer->redisCtx;
     ctx.specId = indexer->specId;
     ConcurrentSearch_SetKey(&indexer->concCtx, indexer->specKeyName, &ctx);
-    ConcurrentSearchCtx_ResetClock(&indexer->concCtx);
     ConcurrentSearchCtx_Lock(&indexer->concCtx);
   } else {
     ctx = *aCtx->client.sctx;
@@ -463,11 +537,13 @@ static void Indexer_Process(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
   }
 
   // Handle FULLTEXT indexes
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_INVIDX);
   if (useTermHt) {
     writeMergedEntries(indexer, aCtx, &ctx, &indexer->mergeHt, parentMap);
   } else if ((aCtx->fwIdx && (aCtx->stateFlags & ACTX_F_ERRORED) == 0)) {
     writeCurEntries(indexer, aCtx, &ctx);
   }
+  AllocStats_SetTag(prevTag);
 
   if (!(aCtx->stateFlags & ACTX_F_OTHERINDEXED)) {
     indexBulkFields(aCtx, &ctx);
@@ -539,6 +615,24 @@ int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
   return 0;
 }
 
+void Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx **aCtxs, size_t n) {
+  for (size_t ii = 0; ii < n; ii += BATCH_MERGE_DOCS) {
+    size_t end = MIN(n, ii + BATCH_MERGE_DOCS);
+    for (size_t jj = ii; jj < end; ++jj) {
+      RS_LOG_ASSERT(!AddDocumentCtx_IsBlockable(aCtxs[jj]), "Batched documents can't be blockable");
+      aCtxs[jj]->next = jj + 1 < end ? aCtxs[jj + 1] : NULL;
+    }
+
+    // The first document of the chain merges the terms of all of them, and assigns their ids
+    Indexer_Process(indexer, aCtxs[ii]);
+
+    for (size_t jj = ii; jj < end; ++jj) {
+      aCtxs[jj]->next = NULL;
+      AddDocumentCtx_Finish(aCtxs[jj]);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 /// Multiple Indexers                                                        ///
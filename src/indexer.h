@@ -82,6 +82,13 @@ DocumentIndexer *NewIndexer(IndexSpec *spec);
  */
 int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx);
 
+/**
+ * Index several preprocessed non-blockable documents at once, in their order. Their terms are
+ * merged, so that each inverted index is opened and appended to once per batch rather than once
+ * per document. The contexts are finished (DocumentAddCtx_Finish) when done.
+ */
+void Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx **aCtxs, size_t n);
+
 /**
  * Function to preprocess field data. This should do as much stateless processing
  * as possible on the field - this means things like input validation and normalization.
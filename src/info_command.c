@@ -39,6 +39,18 @@ static void renderIndexOptions(RedisModule_Reply *reply, IndexSpec *sp) {
   if (sp->flags & Index_WideSchema) {
     RedisModule_Reply_SimpleString(reply, SPEC_SCHEMA_EXPANDABLE_STR);
   }
+  if (sp->flags & Index_ResultCache) {
+    RedisModule_Reply_SimpleString(reply, SPEC_RESULTCACHE_STR);
+  }
+  if (sp->flags & Index_AsyncUpdates) {
+    RedisModule_Reply_SimpleString(reply, SPEC_ASYNCUPDATES_STR);
+  }
+  if (sp->flags & Index_Lazy) {
+    RedisModule_Reply_SimpleString(reply, SPEC_LAZY_STR);
+  }
+  if (sp->flags & Index_SpellIndex) {
+    RedisModule_Reply_SimpleString(reply, SPEC_SPELLINDEX_STR);
+  }
   RedisModule_Reply_ArrayEnd(reply);
 }
 
@@ -85,19 +97,50 @@ static int renderIndexDefinitions(RedisModule_Reply *reply, IndexSpec *sp) {
   RedisModule_Reply_MapEnd(reply); // index_definition
 }
 
-/* FT.INFO {index}
- *  Provide info and stats about an index
+/* The counters of FT.INFO kept up to date as the index is written to and collected, without the
+ * walks over the fields and their indexes */
+static void renderSummary(RedisModule_Reply *reply, IndexSpec *sp) {
+  RedisModule_Reply_Map(reply);
+  REPLY_KVSTR("index_name", sp->name);
+  REPLY_KVNUM("num_docs", sp->stats.numDocuments);
+  REPLY_KVNUM("max_doc_id", sp->docs.maxDocId);
+  REPLY_KVNUM("num_terms", sp->stats.numTerms);
+  REPLY_KVNUM("num_records", sp->stats.numRecords);
+  REPLY_KVNUM("inverted_sz_mb", sp->stats.invertedSize / (float)0x100000);
+  REPLY_KVNUM("offset_vectors_sz_mb", sp->stats.offsetVecsSize / (float)0x100000);
+  REPLY_KVNUM("doc_table_size_mb", sp->docs.memsize / (float)0x100000);
+  REPLY_KVNUM("hash_indexing_failures", sp->stats.indexingFailures);
+  REPLY_KVNUM("indexing", !!global_spec_scanner || sp->scan_in_progress);
+  IndexesScanner *scanner = global_spec_scanner ? global_spec_scanner : sp->scanner;
+  REPLY_KVNUM("percent_indexed", IndexesScanner_IndexedPercent(scanner, sp));
+  REPLY_KVINT("number_of_uses", sp->counter);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+/* FT.INFO {index} [SUMMARY]
+ *  Provide info and stats about an index, or only its counters with SUMMARY
  */
 int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (argc < 2) return RedisModule_WrongArity(ctx);
-
-  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 1);
+  bool summary = argc > 2 && !strcasecmp(RedisModule_StringPtrLen(argv[2], NULL), "SUMMARY");
+
+  // reports the load state of a lazy index, without loading it
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = RedisModule_StringPtrLen(argv[1], NULL)},
+      .flags = INDEXSPEC_LOAD_WRITEABLE | INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
     return RedisModule_ReplyWithError(ctx, "Unknown index name");
   }
 
   RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  if (summary) {
+    renderSummary(reply, sp);
+    RedisModule_EndReply(reply);
+    return REDISMODULE_OK;
+  }
   bool has_map = RedisModule_HasMap(reply);
 
   RedisModule_Reply_Map(reply); // top
@@ -150,6 +193,10 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       }
     }
 
+    if (FieldSpec_IsNumericBKD(fs)) {
+      REPLY_KVSTR(SPEC_INDEXTYPE_STR, SPEC_NUMERIC_BKD_STR);
+    }
+
     if (FIELD_IS(fs, INDEXFLD_T_GEOMETRY)) {
       REPLY_KVSTR("coord_system", GeometryCoordsToName(fs->geometryOpts.geometryCoords));
       const GeometryIndex *idx = OpenGeometryIndex(ctx, sp, NULL, fs);
@@ -157,6 +204,15 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       geom_idx_sz += api->report(idx);
     }
 
+    if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+      // What the queries of the field asked of its vector index since the index was loaded
+      const VectorQueryStats *qs = &fs->vectorOpts.queryStats;
+      REPLY_KVINT("vector_queries", __atomic_load_n(&qs->queries, __ATOMIC_RELAXED));
+      REPLY_KVINT("vector_distances", __atomic_load_n(&qs->distances, __ATOMIC_RELAXED));
+      REPLY_KVINT("vector_batches", __atomic_load_n(&qs->batches, __ATOMIC_RELAXED));
+      REPLY_KVINT("vector_batch_results", __atomic_load_n(&qs->batchResults, __ATOMIC_RELAXED));
+    }
+
     if (has_map) {
       RedisModule_ReplyKV_Array(reply, "flags"); // >>>flags
     }
@@ -179,6 +235,21 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (FieldSpec_HasSuffixTrie(fs)) {
       RedisModule_Reply_SimpleString(reply, SPEC_WITHSUFFIXTRIE_STR);
     }
+    if (FieldSpec_HasNgrams(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_WITHNGRAMS_STR);
+    }
+    if (FieldSpec_IsNoOffsets(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_NOOFFSETS_STR);
+    }
+    if (FieldSpec_IndexesMissing(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_INDEXMISSING_STR);
+    }
+    if (FieldSpec_HasSortIndex(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_SORTINDEX_STR);
+    }
+    if (FieldSpec_HasSeparatePostings(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_SEPARATEPOSTINGS_STR);
+    }
 
     if (has_map) {
       RedisModule_Reply_ArrayEnd(reply); // >>>flags
@@ -205,9 +276,9 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   // REPLY_KVNUM("score_index_size_mb", sp->stats.scoreIndexesSize / (float)0x100000);
 
   REPLY_KVNUM("doc_table_size_mb", sp->docs.memsize / (float)0x100000);
-  REPLY_KVNUM("sortable_values_size_mb", sp->docs.sortablesSize / (float)0x100000);
+  REPLY_KVNUM("sortable_values_size_mb", IndexSpec_SortablesSize(sp) / (float)0x100000);
 
-  REPLY_KVNUM("key_table_size_mb", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  REPLY_KVNUM("key_table_size_mb", DocIdMap_MemUsage(&sp->docs.dim) / (float)0x100000);
   REPLY_KVNUM("geoshapes_sz_mb", geom_idx_sz / (float)0x100000);
   REPLY_KVNUM("records_per_doc_avg",
               (float)sp->stats.numRecords / (float)sp->stats.numDocuments);
@@ -219,6 +290,7 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
               8.0F * (float)sp->stats.offsetVecsSize / (float)sp->stats.offsetVecRecords);
   REPLY_KVNUM("hash_indexing_failures", sp->stats.indexingFailures);
   REPLY_KVNUM("total_indexing_time", sp->stats.totalIndexTime / 1000.0);
+  REPLY_KVNUM("geoshapes_bulk_load_time", sp->stats.geometryBulkLoadTime / 1000.0);
   REPLY_KVNUM("indexing", !!global_spec_scanner || sp->scan_in_progress);
 
   IndexesScanner *scanner = global_spec_scanner ? global_spec_scanner : sp->scanner;
@@ -237,6 +309,52 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   Cursors_RenderStats(&g_CursorsList, &g_CursorsListCoord, sp, reply);
 
+  if (sp->termExpansions) {
+    ExpansionCacheStats stats = ExpansionCache_GetStats(sp->termExpansions);
+    REPLY_KVMAP("expansion_cache_stats");
+    REPLY_KVINT("hits", stats.hits);
+    REPLY_KVINT("misses", stats.misses);
+    REPLY_KVINT("entries", stats.entries);
+    REPLY_KVNUM("size_mb", stats.memory / (float)0x100000);
+    REPLY_MAP_END;
+  }
+
+  if ((sp->flags & Index_ResultCache) && sp->resultCache) {
+    ResultCacheStats stats = ResultCache_GetStats(sp->resultCache);
+    REPLY_KVMAP("result_cache_stats");
+    REPLY_KVINT("hits", stats.hits);
+    REPLY_KVINT("misses", stats.misses);
+    REPLY_KVINT("evictions", stats.evictions);
+    REPLY_KVINT("entries", stats.entries);
+    REPLY_KVNUM("size_mb", stats.memory / (float)0x100000);
+    REPLY_MAP_END;
+  }
+
+  if (sp->flags & Index_AsyncUpdates) {
+    AsyncUpdatesStats stats = AsyncUpdates_GetStats(sp);
+    REPLY_KVMAP("async_updates_stats");
+    REPLY_KVINT("queue_depth", stats.depth);
+    REPLY_KVINT("lag_ms", stats.lagMs);
+    REPLY_KVINT("drained", stats.drained);
+    REPLY_MAP_END;
+  }
+
+  if (sp->flags & Index_Lazy) {
+    LazyIndexStats stats = LazyIndex_GetStats(sp);
+    REPLY_KVMAP("lazy_index_stats");
+    REPLY_KVINT("loaded", stats.loaded);
+    REPLY_KVINT("idle_timeout_sec", sp->timeout / 1000);
+    REPLY_KVINT("loads", stats.loads);
+    REPLY_KVINT("evictions", stats.evictions);
+    REPLY_KVINT("last_load_ms", stats.lastLoadMs);
+    REPLY_MAP_END;
+  }
+
+  if (!LatencyStats_IsEmpty(&sp->latency)) {
+    RedisModule_Reply_SimpleString(reply, "latency_stats");
+    LatencyStats_Reply(&sp->latency, reply);
+  }
+
   if (sp->flags & Index_HasCustomStopwords) {
     ReplyWithStopWordsList(reply, sp->stopwords);
   }
@@ -10,15 +10,26 @@
 #include "varint.h"
 #include <stdio.h>
 #include <float.h>
+#include <pthread.h>
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "qint.h"
 #include "qint.c"
+#include "stream_vbyte.h"
 #include "redis_index.h"
 #include "numeric_filter.h"
 #include "redismodule.h"
 #include "rmutil/rm_assert.h"
+#include "util/arr.h"
+#include "util/bitpack.h"
+#include "util/mempool.h"
+#include "util/prefetch.h"
 #include "geo_index.h"
 #include "module.h"
+#include "index_segments.h"
+#include "cold_block_cache.h"
+#include "index_buffers.h"
+#include "miniz/miniz.h"
 
 uint64_t TotalIIBlocks = 0;
 
@@ -26,15 +37,38 @@ uint64_t TotalIIBlocks = 0;
 #define INDEX_BLOCK_SIZE 100
 #define INDEX_BLOCK_SIZE_DOCID_ONLY 1000
 
+// Blocks of large indexes grow geometrically: the block size doubles every N blocks, up to
+// INDEX_BLOCK_MAX_GROWTH times, so that frequent terms do not end up with a huge number of blocks
+#define INDEX_BLOCK_GROWTH_INTERVAL 8
+#define INDEX_BLOCK_MAX_GROWTH 4
+
+// Skip points are kept for every N-th record of sealed blocks in the record format
+#define INDEX_BLOCK_SKIP_INTERVAL 16
+
 // Initial capacity (in bytes) of a new block
 #define INDEX_BLOCK_INITIAL_CAP 6
 
+// An upper bound of the length of an entry written by the encoders, besides its offsets
+#define INDEX_ENTRY_MAX_LEN 48
+
+// Blocks are deflated when they go cold if their data is at least this large, and deflating saves
+// at least 1/N of it
+#define INDEX_BLOCK_COLD_MIN_SIZE 256
+#define INDEX_BLOCK_COLD_MIN_GAIN 8
+
 // The last block of the index
 #define INDEX_LAST_BLOCK(idx) (idx->blocks[idx->size - 1])
 
 // pointer to the current block while reading the index
 #define IR_CURRENT_BLOCK(ir) (ir->idx->blocks[ir->currentBlock])
 
+// Whether the reader consumed all the entries of the current block
+#define IR_BLOCK_AT_END(ir) \
+  ((ir)->blockLen ? (ir)->blockPos >= (ir)->blockLen : BufferReader_AtEnd(&(ir)->br))
+
+// How far ahead of its position in the current block a reader prefetches, in bytes
+#define IR_PREFETCH_DISTANCE 128
+
 static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *idx,
                                           IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx, int skipMulti,
                                           RSIndexResult *record);
@@ -43,29 +77,62 @@ static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *id
 IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId) {
   TotalIIBlocks++;
   idx->size++;
-  idx->blocks = rm_realloc(idx->blocks, idx->size * sizeof(IndexBlock));
+  if (!InvertedIndex_HasInlineBlock(idx)) {
+    idx->blocks = rm_realloc(idx->blocks, idx->size * sizeof(IndexBlock));
+  } else if (idx->size > 1) {
+    // The index outgrows its inline block
+    IndexBlock *blocks = rm_malloc(idx->size * sizeof(IndexBlock));
+    memcpy(blocks, idx->blocks, (idx->size - 1) * sizeof(IndexBlock));
+    idx->blocks = blocks;
+  }
   IndexBlock *last = idx->blocks + (idx->size - 1);
   memset(last, 0, sizeof(*last));  // for msan
   last->firstId = last->lastId = firstId;
-  Buffer_Init(&INDEX_LAST_BLOCK(idx).buf, INDEX_BLOCK_INITIAL_CAP);
-  return &INDEX_LAST_BLOCK(idx);
+  if (last == InvertedIndex_InlineBlock(idx)) {
+    last->buf = (Buffer){.data = InvertedIndex_InlineData(idx), .cap = INDEX_BLOCK_INLINE_CAP};
+    last->flags = IndexBlock_InlineData;
+  } else {
+    IndexBuffer_Init(&last->buf, INDEX_BLOCK_INITIAL_CAP);
+  }
+  return last;
+}
+
+uint16_t InvertedIndex_BlockCapacity(const InvertedIndex *idx, uint32_t blockIdx) {
+  // use proper block size. Index_DocIdsOnly == 0x00
+  uint16_t blockSize =
+      (idx->flags & INDEX_STORAGE_MASK) ? INDEX_BLOCK_SIZE : INDEX_BLOCK_SIZE_DOCID_ONLY;
+  return blockSize << MIN(blockIdx / INDEX_BLOCK_GROWTH_INTERVAL, INDEX_BLOCK_MAX_GROWTH);
+}
+
+/* Stream encoded blocks hold nothing but docids and frequencies, and are searched by the reader
+ * itself; indexes with a dedicated seeker keep their format */
+static int InvertedIndex_SupportsStreamVByte(IndexFlags flags) {
+  IndexFlags storage = flags & INDEX_STORAGE_MASK;
+  return (storage == Index_DocIdsOnly || storage == Index_StoreFreqs) &&
+         !InvertedIndex_GetDecoder(storage).seeker;
 }
 
 InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
   int useFieldMask = flags & Index_StoreFieldFlags;
   int useNumEntries = flags & Index_StoreNumeric;
   RedisModule_Assert(!(useFieldMask && useNumEntries));
-  // Avoid some of the allocation if not needed
-  size_t size = (useFieldMask || useNumEntries) ? sizeof(InvertedIndex) :
-                                                  sizeof(InvertedIndex) - sizeof(t_fieldMask);
-
-  InvertedIndex *idx = rm_malloc(size);
-  idx->blocks = NULL;
+  // numeric and tag indexes count their inverted indexes to their own tags
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_INVIDX);
+  // Avoid some of the allocation if not needed. The first block and its data follow the header
+  InvertedIndex *idx =
+      rm_malloc(InvertedIndex_HeaderSize(flags) + sizeof(IndexBlock) + INDEX_BLOCK_INLINE_CAP);
+  idx->flags = flags;
+  idx->blocks = InvertedIndex_InlineBlock(idx);
   idx->size = 0;
   idx->lastId = 0;
   idx->gcMarker = 0;
-  idx->flags = flags;
   idx->numDocs = 0;
+  if (RSGlobalConfig.invertedIndexStreamVByteEncoding && InvertedIndex_SupportsStreamVByte(flags)) {
+    idx->flags |= Index_StreamVByte;
+  }
+  if (RSGlobalConfig.invertedIndexPackedOffsets && (flags & Index_StoreTermOffsets)) {
+    idx->flags |= Index_PackedOffsets;
+  }
   if (useFieldMask) {
     idx->fieldMask = (t_fieldMask)0;
   } else if (useNumEntries) {
@@ -74,21 +141,65 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
   if (initBlock) {
     InvertedIndex_AddBlock(idx, 0);
   }
+  AllocStats_SetTag(prevTag);
   return idx;
 }
 
+/* Free the data of a block, unless it is held inline */
+static void IndexBlock_FreeData(IndexBlock *blk) {
+  if (blk->flags & IndexBlock_InlineData) {
+    blk->flags &= ~IndexBlock_InlineData;
+    blk->buf = (Buffer){0};
+  } else if (blk->flags & IndexBlock_MappedData) {
+    blk->flags &= ~IndexBlock_MappedData;
+    IndexSegments_Release(blk->buf.data);
+    blk->buf = (Buffer){0};
+  } else {
+    blk->flags &= ~IndexBlock_Cold;
+    IndexBuffer_Free(&blk->buf);
+  }
+}
+
+/* Move the inline data of a block to a buffer of its own, with room for `extra` more bytes */
+static void IndexBlock_MoveInlineData(IndexBlock *blk, size_t extra) {
+  Buffer buf;
+  IndexBuffer_Init(&buf, blk->buf.offset + extra);
+  memcpy(buf.data, blk->buf.data, blk->buf.offset);
+  buf.offset = blk->buf.offset;
+  blk->buf = buf;
+  blk->flags &= ~IndexBlock_InlineData;
+}
+
+/* Move the data of a block held in a segment back to a buffer of its own, with room for `extra`
+ * more bytes. The records stay at the same offsets */
+static void IndexBlock_UnmapData(IndexBlock *blk, size_t extra) {
+  Buffer buf;
+  IndexBuffer_Init(&buf, blk->buf.offset + extra);
+  memcpy(buf.data, blk->buf.data, blk->buf.offset);
+  buf.offset = blk->buf.offset;
+  IndexSegments_Release(blk->buf.data);
+  blk->buf = buf;
+  blk->flags &= ~IndexBlock_MappedData;
+}
+
 void indexBlock_Free(IndexBlock *blk) {
-  Buffer_Free(&blk->buf);
+  IndexBlock_FreeData(blk);
+  array_free(blk->skips);
+  blk->skips = NULL;
 }
 
 void InvertedIndex_Free(void *ctx) {
   InvertedIndex *idx = ctx;
+  AllocTag prevTag = AllocStats_SetDefaultTag(ALLOC_TAG_INVIDX);
   TotalIIBlocks -= idx->size;
   for (uint32_t i = 0; i < idx->size; i++) {
     indexBlock_Free(&idx->blocks[i]);
   }
-  rm_free(idx->blocks);
+  if (!InvertedIndex_HasInlineBlock(idx)) {
+    rm_free(idx->blocks);
+  }
   rm_free(idx);
+  AllocStats_SetTag(prevTag);
 }
 
 static void IR_SetAtEnd(IndexReader *r, int value) {
@@ -123,18 +234,14 @@ void IndexReader_OnReopen(void *privdata) {
   // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
   if (ir->gcMarker == ir->idx->gcMarker) {
     // no GC - we just go to the same offset we were at
-    size_t offset = ir->br.pos;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-    ir->br.pos = offset;
+    IndexReader_ResumeBlock(ir);
   } else {
     // if there has been a GC cycle on this key while we were asleep, the offset might not be valid
     // anymore. This means that we need to seek to last docId we were at
 
     // reset the state of the reader
     t_docId lastId = ir->lastId;
-    ir->currentBlock = 0;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-    ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+    IndexReader_SetBlock(ir, 0);
 
     // seek to the previous last id
     RSIndexResult *dummy = NULL;
@@ -499,7 +606,70 @@ IndexEncoder InvertedIndex_GetEncoder(IndexFlags flags) {
   return NULL;
 }
 
+/* Write an entry to a block whose data is held inline. Encoders grow the buffer they write to, so
+ * the entry is written to a buffer of its own, which the block keeps if its data no longer fits
+ * inline */
+static size_t IndexBlock_WriteInline(IndexBlock *blk, IndexEncoder encoder, t_docId delta,
+                                     RSIndexResult *entry) {
+  Buffer inlineBuf = blk->buf;
+  IndexBlock_MoveInlineData(blk, INDEX_BLOCK_INITIAL_CAP);
+  BufferWriter bw = NewBufferWriter(&blk->buf);
+  size_t ret = encoder(&bw, delta, entry);
+  if (blk->buf.offset <= inlineBuf.cap) {
+    memcpy(inlineBuf.data, blk->buf.data, blk->buf.offset);
+    inlineBuf.offset = blk->buf.offset;
+    IndexBuffer_Free(&blk->buf);
+    blk->buf = inlineBuf;
+    blk->flags |= IndexBlock_InlineData;
+  }
+  return ret;
+}
+
+/* Seal the last block before a new one is added after it, and move its data to an index segment
+ * if they are enabled */
+static void InvertedIndex_SealLastBlock(InvertedIndex *idx) {
+  IndexBlock *blk = &INDEX_LAST_BLOCK(idx);
+  if (IndexBlock_Seal(blk, idx->flags)) {
+    // Readers that paused inside this block hold a buffer offset which is no longer valid. Make
+    // them seek back to their last docId when they reopen the index.
+    ++idx->gcMarker;
+  }
+  // The data is copied as is, the offsets of paused readers stay valid
+  if (!(blk->flags & (IndexBlock_InlineData | IndexBlock_MappedData)) &&
+      IndexSegments_Adopt(&blk->buf)) {
+    blk->flags |= IndexBlock_MappedData;
+  }
+}
+
 /* Write a forward-index entry to an index writer */
+/* The largest float which is not above v */
+static inline float floatFloor(double v) {
+  if (v > FLT_MAX) return isinf(v) ? INFINITY : FLT_MAX;
+  if (v < -FLT_MAX) return -INFINITY;
+  float f = v;
+  return f > v ? nextafterf(f, -INFINITY) : f;
+}
+
+/* The smallest float which is not below v */
+static inline float floatCeil(double v) {
+  if (v < -FLT_MAX) return isinf(v) ? -INFINITY : -FLT_MAX;
+  if (v > FLT_MAX) return INFINITY;
+  float f = v;
+  return f < v ? nextafterf(f, INFINITY) : f;
+}
+
+/* Widen the value range of a numeric block to a value about to be added to it */
+static inline void IndexBlock_AddValue(IndexBlock *blk, double value) {
+  float lo = floatFloor(value), hi = floatCeil(value);
+  if (blk->numEntries == 0) {
+    blk->valueRange.min = lo;
+    blk->valueRange.max = hi;
+    return;
+  }
+  if (lo < blk->valueRange.min) blk->valueRange.min = lo;
+  if (hi > blk->valueRange.max) blk->valueRange.max = hi;
+}
+
 size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
                                        RSIndexResult *entry) {
 
@@ -518,14 +688,13 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   t_docId delta = 0;
   IndexBlock *blk = &INDEX_LAST_BLOCK(idx);
 
-  // use proper block size. Index_DocIdsOnly == 0x00
-  uint16_t blockSize = (idx->flags & INDEX_STORAGE_MASK) ?
-          INDEX_BLOCK_SIZE :
-          INDEX_BLOCK_SIZE_DOCID_ONLY;
-
   // see if we need to grow the current block
-  if (blk->numEntries >= blockSize && !same_doc) {
+  if (blk->numEntries >= InvertedIndex_BlockCapacity(idx, idx->size - 1) && !same_doc) {
     // If same doc can span more than a single block - need to adjust IndexReader_SkipToBlock
+    InvertedIndex_SealLastBlock(idx);
+    blk = InvertedIndex_AddBlock(idx, docId);
+  } else if (IndexBlock_IsSealed(blk) || IndexBlock_IsCold(blk)) {
+    // A sealed or cold block can become the last one if the GC removed all the blocks after it
     blk = InvertedIndex_AddBlock(idx, docId);
   } else if (blk->numEntries == 0) {
     blk->firstId = blk->lastId = docId;
@@ -541,17 +710,35 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   //
   // For numeric encoder the maximal delta is practically not a limit (see structs `EncodingHeader` and `NumEncodingCommon`)
   if (delta > UINT32_MAX && encoder != encodeNumeric) {
+    InvertedIndex_SealLastBlock(idx);
     blk = InvertedIndex_AddBlock(idx, docId);
     delta = 0;
   }
 
-  BufferWriter bw = NewBufferWriter(&blk->buf);
-
-  size_t ret = encoder(&bw, delta, entry);
+  size_t ret;
+  if (blk->flags & IndexBlock_InlineData) {
+    ret = IndexBlock_WriteInline(blk, encoder, delta, entry);
+  } else {
+    if (blk->flags & IndexBlock_MappedData) {
+      // A full block in the record format, which became the last one when the GC removed the
+      // blocks after it
+      IndexBlock_UnmapData(blk, INDEX_BLOCK_INITIAL_CAP);
+    }
+    // Grow the buffer by size classes rather than letting the encoder reallocate it
+    IndexBuffer_Reserve(&blk->buf, INDEX_ENTRY_MAX_LEN + entry->offsetsSz);
+    BufferWriter bw = NewBufferWriter(&blk->buf);
+    ret = encoder(&bw, delta, entry);
+  }
 
+  if (encoder == encodeNumeric) {
+    IndexBlock_AddValue(blk, entry->num.value);
+  } else if (entry->freq > blk->maxFreq) {
+    blk->maxFreq = entry->freq;
+  }
   idx->lastId = docId;
   blk->lastId = docId;
   ++blk->numEntries;
+  blk->flags |= IndexBlock_Accessed;
   if (!same_doc) {
     ++idx->numDocs;
   }
@@ -565,6 +752,9 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
 /** Write a forward-index entry to the index */
 size_t InvertedIndex_WriteForwardIndexEntry(InvertedIndex *idx, IndexEncoder encoder,
                                             ForwardIndexEntry *ent) {
+  if (ent->vw && (idx->flags & Index_PackedOffsets)) {
+    VVW_Pack(ent->vw);
+  }
   RSIndexResult rec = {.type = RSResultType_Term,
                        .docId = ent->docId,
                        .offsetsSz = VVW_GetByteLength(ent->vw),
@@ -590,10 +780,748 @@ size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double
   return InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec);
 }
 
+/******************************************************************************
+ * Sealed blocks.
+ *
+ * Once a block is full it is never appended to again, and it may be converted from the per-record
+ * encoding into a format which can only be read as a whole:
+ *
+ * - Bitmap: docids-only blocks which are dense enough - i.e. where a bit per docid in the block's
+ *   range takes less space than the records - hold a bitmap of their docids, relative to the
+ *   block's firstId. The reader tests and scans the bitmap directly, so skipping inside the block
+ *   is O(1). This is the case for popular tag values, which match most of the documents.
+ *
+ * - Stream: with Index_StreamVByte, docids-only and freqs-only blocks hold two stream-vbyte
+ *   streams: the docid deltas, followed by the frequencies (if the index stores them). The first
+ *   delta in the block is relative to the block's firstId. Readers decode such a block as a whole
+ *   into an array, instead of decoding it record by record.
+ *
+ * - Bit-packed: otherwise, docids-only and freqs-only blocks hold their docid deltas packed with
+ *   the bit width of the largest one, followed by the frequencies packed the same way, if this is
+ *   smaller than the records. Readers decode them as a whole, like stream encoded blocks.
+ *
+ * - Series: numeric blocks hold their docid deltas bit-packed, followed by their values encoded as
+ *   a time series, if this is smaller than the records. Blocks of integers hold the zigzag encoded
+ *   second differences of their values, other blocks the xor of the bits of each value with the
+ *   previous one, without the trailing zero bits they all share. Either is packed with the bit
+ *   width of the largest one, so that values which follow a trend - timestamps, counters, or
+ *   measures at a fixed precision - take a few bits each. Readers decode the block as a whole, and
+ *   filter the decoded values.
+ *
+ * Blocks which keep the record format have their buffer shrunk to the records, since nothing is
+ * appended to them anymore.
+ *
+ ******************************************************************************/
+
+/* The size of the bitmap of a block spanning [firstId, lastId], rounded up to whole words */
+#define BLOCK_BITMAP_LEN(firstId, lastId) ((((lastId) - (firstId)) / 64 + 1) * sizeof(uint64_t))
+
+/* The size of a bit-packed block of n entries: the widths of the deltas and of the frequencies
+ * (a byte each), followed by the packed deltas and the packed frequencies */
+#define BLOCK_BITPACKED_LEN(n, idBits, freqBits) \
+  (2 + BITPACK_LEN(n, idBits) + BITPACK_LEN(n, freqBits))
+
+/* Pick the sealed format of a block spanning [firstId, lastId], holding the given n entries, which
+ * take `recordLen` bytes in the record format. Returns 0 if the block should keep the record
+ * format */
+static uint8_t IndexBlock_SealedFormat(IndexFlags flags, t_docId firstId, t_docId lastId,
+                                       const t_docId *ids, const uint32_t *freqs, size_t n,
+                                       size_t recordLen) {
+  if (!InvertedIndex_SupportsStreamVByte(flags)) {
+    return 0;
+  }
+  if ((flags & INDEX_STORAGE_MASK) == Index_DocIdsOnly && lastId - firstId < UINT16_MAX &&
+      BLOCK_BITMAP_LEN(firstId, lastId) < recordLen) {
+    return IndexBlock_Bitmap;
+  }
+  if (flags & Index_StreamVByte) {
+    return IndexBlock_StreamEncoded;
+  }
+
+  // The deltas of a block always fit in 32 bits (see InvertedIndex_WriteEntryGeneric)
+  uint32_t deltaMask = 0;
+  t_docId prevId = firstId;
+  for (size_t i = 0; i < n; ++i) {
+    deltaMask |= ids[i] - prevId;
+    prevId = ids[i];
+  }
+  uint8_t idBits = BitPack_Width(&deltaMask, 1);
+  uint8_t freqBits = (flags & Index_StoreFreqs) ? BitPack_Width(freqs, n) : 0;
+  if (BLOCK_BITPACKED_LEN(n, idBits, freqBits) < recordLen) {
+    return IndexBlock_BitPacked;
+  }
+  return 0;
+}
+
+static void IndexBlock_EncodeBitmap(IndexBlock *blk, const t_docId *ids, size_t n) {
+  size_t len = BLOCK_BITMAP_LEN(blk->firstId, blk->lastId);
+  Buffer_Init(&blk->buf, len);
+  memset(blk->buf.data, 0, len);
+  uint64_t *bits = (uint64_t *)blk->buf.data;
+  for (size_t i = 0; i < n; ++i) {
+    t_docId bit = ids[i] - blk->firstId;
+    bits[bit / 64] |= 1ULL << (bit % 64);
+  }
+  blk->buf.offset = len;
+}
+
+static void IndexBlock_EncodeStream(Buffer *buf, IndexFlags flags, const uint32_t *deltas,
+                                    const uint32_t *freqs, size_t n) {
+  int withFreqs = flags & Index_StoreFreqs;
+  size_t len = StreamVByte_EncodedLen(deltas, n);
+  if (withFreqs) {
+    len += StreamVByte_EncodedLen(freqs, n);
+  }
+  Buffer_Init(buf, len);
+  buf->offset = StreamVByte_Encode(deltas, n, (uint8_t *)buf->data);
+  if (withFreqs) {
+    buf->offset += StreamVByte_Encode(freqs, n, (uint8_t *)buf->data + buf->offset);
+  }
+}
+
+static void IndexBlock_EncodeBitPacked(Buffer *buf, IndexFlags flags, const uint32_t *deltas,
+                                       const uint32_t *freqs, size_t n) {
+  uint8_t idBits = BitPack_Width(deltas, n);
+  uint8_t freqBits = (flags & Index_StoreFreqs) ? BitPack_Width(freqs, n) : 0;
+  Buffer_Init(buf, BLOCK_BITPACKED_LEN(n, idBits, freqBits));
+  uint8_t *p = (uint8_t *)buf->data;
+  p[0] = idBits;
+  p[1] = freqBits;
+  buf->offset = 2;
+  buf->offset += BitPack_Pack(deltas, n, idBits, p + buf->offset);
+  if (freqBits) {
+    buf->offset += BitPack_Pack(freqs, n, freqBits, p + buf->offset);
+  }
+}
+
+/* Encode the n entries of a block into `buf` in the record format */
+static void IndexBlock_EncodeRecords(Buffer *buf, IndexFlags flags, t_docId firstId,
+                                     const t_docId *ids, const uint32_t *freqs, size_t n) {
+  Buffer_Init(buf, INDEX_BLOCK_INITIAL_CAP);
+  IndexEncoder encoder = InvertedIndex_GetEncoder(flags);
+  BufferWriter bw = NewBufferWriter(buf);
+  RSIndexResult res = {.type = RSResultType_Term, .fieldMask = RS_FIELDMASK_ALL};
+  t_docId lastId = firstId;
+  for (size_t i = 0; i < n; ++i) {
+    res.docId = ids[i];
+    res.freq = freqs[i];
+    encoder(&bw, ids[i] - lastId, &res);
+    lastId = ids[i];
+  }
+}
+
+/* Encode the n entries of a block, whose firstId and lastId are set, in the given sealed format */
+static void IndexBlock_EncodeSealed(IndexBlock *blk, IndexFlags flags, uint8_t format,
+                                    const t_docId *ids, uint32_t *freqs, size_t n) {
+  blk->flags &= ~IndexBlock_SealedFlags;
+  if (format == IndexBlock_Bitmap) {
+    IndexBlock_EncodeBitmap(blk, ids, n);
+  } else {
+    uint32_t *deltas = rm_malloc(n * sizeof(*deltas));
+    t_docId lastId = blk->firstId;
+    for (size_t i = 0; i < n; ++i) {
+      deltas[i] = ids[i] - lastId;
+      lastId = ids[i];
+    }
+    if (format == IndexBlock_BitPacked) {
+      IndexBlock_EncodeBitPacked(&blk->buf, flags, deltas, freqs, n);
+    } else {
+      IndexBlock_EncodeStream(&blk->buf, flags, deltas, freqs, n);
+    }
+    rm_free(deltas);
+  }
+  blk->flags |= format;
+}
+
+void IndexBlock_Decode(const IndexBlock *blk, IndexFlags flags, t_docId *ids, uint32_t *freqs) {
+  const uint8_t *p = (const uint8_t *)blk->buf.data;
+  const uint8_t *end = p + blk->buf.offset;
+  size_t n = blk->numEntries;
+
+  if (IndexBlock_IsBitmap(blk)) {
+    const uint64_t *bits = (const uint64_t *)p;
+    size_t nwords = blk->buf.offset / sizeof(uint64_t);
+    size_t i = 0;
+    for (size_t w = 0; w < nwords; ++w) {
+      for (uint64_t word = bits[w]; word; word &= word - 1) {
+        ids[i] = blk->firstId + w * 64 + __builtin_ctzll(word);
+        freqs[i++] = 1;
+      }
+    }
+    RS_LOG_ASSERT(i == n, "Block entries do not match its bitmap");
+    return;
+  }
+
+  // The deltas are decoded into the frequencies array, which is then overwritten
+  uint8_t freqBits = 0;
+  if (IndexBlock_IsBitPacked(blk)) {
+    uint8_t idBits = p[0];
+    freqBits = p[1];
+    p += 2;
+    p += BitPack_Unpack(p, n, idBits, freqs);
+  } else {
+    p += StreamVByte_Decode(p, end, freqs, n);
+  }
+  t_docId docId = blk->firstId;
+  for (size_t i = 0; i < n; ++i) {
+    docId += freqs[i];
+    ids[i] = docId;
+  }
+
+  if (flags & Index_StoreFreqs) {
+    if (IndexBlock_IsBitPacked(blk)) {
+      BitPack_Unpack(p, n, freqBits, freqs);
+    } else {
+      StreamVByte_Decode(p, end, freqs, n);
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      freqs[i] = 1;
+    }
+  }
+}
+
+/* Build the skip points of a block in the record format. Indexes whose seeker binary searches the
+ * block (raw docids) and blocks with too few records do not need them */
+static void IndexBlock_BuildSkips(IndexBlock *blk, IndexFlags flags) {
+  array_free(blk->skips);
+  blk->skips = NULL;
+
+  if (blk->numEntries <= INDEX_BLOCK_SKIP_INTERVAL ||
+      InvertedIndex_GetEncoder(flags) == encodeRawDocIdsOnly ||
+      blk->lastId - blk->firstId > UINT32_MAX) {
+    return;
+  }
+
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(flags & INDEX_STORAGE_MASK);
+
+  // Filtering is irrelevant here, we only follow the docids
+  static const IndexDecoderCtx empty = {0};
+  RSIndexResult *res = (flags & INDEX_STORAGE_MASK) == Index_StoreNumeric ? NewNumericResult()
+                                                                          : NewTokenRecord(NULL, 1);
+  IndexBlockSkip *skips = array_new(IndexBlockSkip, blk->numEntries / INDEX_BLOCK_SKIP_INTERVAL);
+  BufferReader br = NewBufferReader(&blk->buf);
+  t_docId lastId = blk->firstId;
+  for (uint16_t n = 0; !BufferReader_AtEnd(&br); ++n) {
+    if (n && n % INDEX_BLOCK_SKIP_INTERVAL == 0) {
+      IndexBlockSkip skip = {.offset = br.pos, .prevId = lastId - blk->firstId};
+      skips = array_append(skips, skip);
+    }
+    size_t pos = br.pos;
+    decoders.decoder(&br, &empty, res);
+    // We write the docid as a 32 bit number when decoding it with qint. In old rdb versions the
+    // first entry is the docid itself rather than the delta (see IndexBlock_Repair)
+    uint32_t delta = *(uint32_t *)&res->docId;
+    lastId = (pos == 0 && delta) ? delta : lastId + delta;
+  }
+  IndexResult_Free(res);
+
+  if (array_len(skips)) {
+    blk->skips = skips;
+  } else {
+    array_free(skips);
+  }
+}
+
+/* Decode the entries of a block of a docids-only or freqs-only index in the record format */
+static void IndexBlock_DecodeRecords(const IndexBlock *blk, IndexFlags flags, t_docId *ids,
+                                     uint32_t *freqs) {
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(flags & INDEX_STORAGE_MASK);
+
+  // Decoders of docids-only and freqs-only indexes do not filter, and ignore the context
+  static const IndexDecoderCtx empty = {0};
+  BufferReader br = NewBufferReader((Buffer *)&blk->buf);
+  RSIndexResult res = {.type = RSResultType_Term};
+  t_docId lastId = blk->firstId;
+  uint16_t n = 0;
+  while (n < blk->numEntries && !BufferReader_AtEnd(&br)) {
+    res.docId = 0;
+    res.freq = 1;
+    decoders.decoder(&br, &empty, &res);
+    // We write the docid as a 32 bit number when decoding it with qint. In old rdb versions the
+    // first entry is the docid itself rather than the delta (see IndexBlock_Repair)
+    uint32_t delta = *(uint32_t *)&res.docId;
+    lastId = (n == 0 && delta) ? delta : lastId + delta;
+    ids[n] = lastId;
+    freqs[n] = res.freq;
+    ++n;
+  }
+  RS_LOG_ASSERT(n == blk->numEntries, "Block entries do not match its number of records");
+}
+
+/* The kinds of values of a numeric series block */
+#define SERIES_INTEGERS 0
+#define SERIES_FLOATS 1
+
+/* Integers of a series block are below this magnitude, so that their second differences fit in 64
+ * bits, and they convert back to the same doubles */
+#define SERIES_INTEGER_MAX 9007199254740992.0  // 2^53
+
+/* The header of a series block: the widths of the deltas and of the values, the kind of the
+ * values and the shift of their xors (a byte each), followed by the bits of the first value */
+#define SERIES_HEADER_LEN (4 + sizeof(double))
+
+/* Compute the n words a series block holds for its values: the zigzag encoded second differences
+ * of integers, or the xor of the bits of each value with the previous one's, shifted right by the
+ * trailing zeros they all have. The first word is always 0, the first value is held as is.
+ * Returns the kind of the values */
+static uint8_t NumericSeries_Words(const double *values, size_t n, uint64_t *words,
+                                   uint8_t *shift) {
+  int integers = 1;
+  for (size_t i = 0; i < n && integers; ++i) {
+    double v = values[i];
+    integers = v > -SERIES_INTEGER_MAX && v < SERIES_INTEGER_MAX && v == (double)(int64_t)v;
+  }
+
+  *shift = 0;
+  words[0] = 0;
+  if (integers) {
+    int64_t prev = values[0], prevDelta = 0;
+    for (size_t i = 1; i < n; ++i) {
+      int64_t v = values[i];
+      int64_t delta = v - prev;
+      int64_t dd = delta - prevDelta;
+      words[i] = ((uint64_t)dd << 1) ^ (uint64_t)(dd >> 63);
+      prev = v;
+      prevDelta = delta;
+    }
+    return SERIES_INTEGERS;
+  }
+
+  uint64_t prev, mask = 0;
+  memcpy(&prev, values, sizeof(prev));
+  for (size_t i = 1; i < n; ++i) {
+    uint64_t bits;
+    memcpy(&bits, values + i, sizeof(bits));
+    words[i] = bits ^ prev;
+    mask |= words[i];
+    prev = bits;
+  }
+  if (mask) {
+    *shift = __builtin_ctzll(mask);
+    for (size_t i = 1; i < n; ++i) {
+      words[i] >>= *shift;
+    }
+  }
+  return SERIES_FLOATS;
+}
+
+/* Encode the n entries of a numeric block starting at firstId into `buf` in the series format, if
+ * it takes less than `maxLen` bytes. Returns 1 if it did */
+static int IndexBlock_EncodeSeries(Buffer *buf, t_docId firstId, const t_docId *ids,
+                                   const double *values, size_t n, size_t maxLen) {
+  uint64_t *deltas = rm_malloc(n * sizeof(*deltas));
+  uint64_t *words = rm_malloc(n * sizeof(*words));
+  t_docId lastId = firstId;
+  for (size_t i = 0; i < n; ++i) {
+    deltas[i] = ids[i] - lastId;
+    lastId = ids[i];
+  }
+  uint8_t shift;
+  uint8_t kind = NumericSeries_Words(values, n, words, &shift);
+  uint8_t idBits = BitPack64_Width(deltas, n);
+  uint8_t valueBits = BitPack64_Width(words, n);
+
+  size_t len = SERIES_HEADER_LEN + BITPACK_LEN(n, idBits) + BITPACK_LEN(n, valueBits);
+  int encoded = len < maxLen;
+  if (encoded) {
+    Buffer_Init(buf, len);
+    uint8_t *p = (uint8_t *)buf->data;
+    p[0] = idBits;
+    p[1] = valueBits;
+    p[2] = kind;
+    p[3] = shift;
+    memcpy(p + 4, values, sizeof(*values));
+    buf->offset = SERIES_HEADER_LEN;
+    buf->offset += BitPack64_Pack(deltas, n, idBits, p + buf->offset);
+    buf->offset += BitPack64_Pack(words, n, valueBits, p + buf->offset);
+  }
+  rm_free(deltas);
+  rm_free(words);
+  return encoded;
+}
+
+/* Decode the entries of a numeric series block. Every step is a loop over the whole block */
+static void IndexBlock_DecodeSeries(const IndexBlock *blk, t_docId *ids, double *values) {
+  const uint8_t *p = (const uint8_t *)blk->buf.data;
+  size_t n = blk->numEntries;
+  uint8_t idBits = p[0], valueBits = p[1], kind = p[2], shift = p[3];
+  double first;
+  memcpy(&first, p + 4, sizeof(first));
+  p += SERIES_HEADER_LEN;
+
+  p += BitPack64_Unpack(p, n, idBits, ids);
+  t_docId docId = blk->firstId;
+  for (size_t i = 0; i < n; ++i) {
+    docId += ids[i];
+    ids[i] = docId;
+  }
+
+  // The words are unpacked into the values array, each is overwritten by the value it encodes
+  uint64_t *words = (uint64_t *)values;
+  BitPack64_Unpack(p, n, valueBits, words);
+  if (kind == SERIES_INTEGERS) {
+    int64_t v = first, delta = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t w = words[i];
+      delta += (int64_t)(w >> 1) ^ -(int64_t)(w & 1);
+      v += delta;
+      values[i] = v;
+    }
+  } else {
+    uint64_t bits;
+    memcpy(&bits, &first, sizeof(bits));
+    for (size_t i = 0; i < n; ++i) {
+      bits ^= words[i] << shift;
+      memcpy(values + i, &bits, sizeof(bits));
+    }
+  }
+}
+
+/* Decode the entries of a numeric block in the record format */
+static void IndexBlock_DecodeNumericRecords(const IndexBlock *blk, t_docId *ids, double *values) {
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(Index_StoreNumeric);
+
+  // Without a filter in the context every record is decoded
+  static const IndexDecoderCtx empty = {0};
+  BufferReader br = NewBufferReader((Buffer *)&blk->buf);
+  RSIndexResult res = {.type = RSResultType_Numeric};
+  t_docId lastId = blk->firstId;
+  uint16_t n = 0;
+  while (n < blk->numEntries && !BufferReader_AtEnd(&br)) {
+    decoders.decoder(&br, &empty, &res);
+    // The deltas are decoded as in IndexBlock_DecodeRecords
+    uint32_t delta = *(uint32_t *)&res.docId;
+    lastId = (n == 0 && delta) ? delta : lastId + delta;
+    ids[n] = lastId;
+    values[n] = res.num.value;
+    ++n;
+  }
+  RS_LOG_ASSERT(n == blk->numEntries, "Block entries do not match its number of records");
+}
+
+/* Decode the entries of a numeric block, in any format */
+static void IndexBlock_DecodeNumeric(const IndexBlock *blk, t_docId *ids, double *values) {
+  if (IndexBlock_IsNumericSeries(blk)) {
+    IndexBlock_DecodeSeries(blk, ids, values);
+  } else {
+    IndexBlock_DecodeNumericRecords(blk, ids, values);
+  }
+}
+
+/* Encode the n entries of a numeric block into `buf` in the record format */
+static void IndexBlock_EncodeNumericRecords(Buffer *buf, t_docId firstId, const t_docId *ids,
+                                            const double *values, size_t n) {
+  Buffer_Init(buf, INDEX_BLOCK_INITIAL_CAP);
+  BufferWriter bw = NewBufferWriter(buf);
+  RSIndexResult res = {.type = RSResultType_Numeric};
+  t_docId lastId = firstId;
+  for (size_t i = 0; i < n; ++i) {
+    res.docId = ids[i];
+    res.num.value = values[i];
+    encodeNumeric(&bw, ids[i] - lastId, &res);
+    lastId = ids[i];
+  }
+}
+
+/* Seal a full numeric block in the series format if it is smaller than its records. The records
+ * are decoded first, so the values are the ones a reader of the records gets. Returns 1 if the
+ * block was converted */
+static int IndexBlock_SealNumeric(IndexBlock *blk) {
+  // The deltas of the records are decoded as 32 bit numbers
+  if (blk->lastId - blk->firstId > UINT32_MAX) {
+    return 0;
+  }
+  size_t n = blk->numEntries;
+  t_docId *ids = rm_malloc(n * sizeof(*ids));
+  double *values = rm_malloc(n * sizeof(*values));
+  IndexBlock_DecodeNumericRecords(blk, ids, values);
+  Buffer series;
+  int sealed = IndexBlock_EncodeSeries(&series, blk->firstId, ids, values, n, blk->buf.offset);
+  if (sealed) {
+    IndexBlock_FreeData(blk);
+    // A block repaired in the record format may have skip points
+    array_free(blk->skips);
+    blk->skips = NULL;
+    blk->buf = series;
+    blk->flags |= IndexBlock_NumericSeries;
+  }
+  rm_free(ids);
+  rm_free(values);
+  return sealed;
+}
+
+int IndexBlock_Seal(IndexBlock *blk, IndexFlags flags) {
+  if (IndexBlock_IsSealed(blk) || IndexBlock_IsCold(blk) || !blk->numEntries) {
+    return 0;
+  }
+  if ((flags & INDEX_STORAGE_MASK) == Index_StoreNumeric && IndexBlock_SealNumeric(blk)) {
+    return 1;
+  }
+
+  uint8_t format = 0;
+  t_docId *ids = NULL;
+  uint32_t *freqs = NULL;
+  if (InvertedIndex_SupportsStreamVByte(flags)) {
+    ids = rm_malloc(blk->numEntries * sizeof(*ids));
+    freqs = rm_malloc(blk->numEntries * sizeof(*freqs));
+    IndexBlock_DecodeRecords(blk, flags, ids, freqs);
+    format = IndexBlock_SealedFormat(flags, blk->firstId, blk->lastId, ids, freqs,
+                                     blk->numEntries, blk->buf.offset);
+  }
+
+  if (format) {
+    IndexBlock_FreeData(blk);
+    IndexBlock_EncodeSealed(blk, flags, format, ids, freqs, blk->numEntries);
+  } else {
+    // Neither shrinking the buffer nor the skip points move the records inside it, readers'
+    // offsets stay valid. Inline and mapped data are as small as they get
+    if (!(blk->flags & (IndexBlock_InlineData | IndexBlock_MappedData))) {
+      Buffer_ShrinkToSize(&blk->buf);
+    }
+    IndexBlock_BuildSkips(blk, flags);
+  }
+
+  rm_free(ids);
+  rm_free(freqs);
+  return format != 0;
+}
+
+void IndexBlock_ToRecordBuffer(const IndexBlock *blk, IndexFlags flags, Buffer *out) {
+  if (!blk->numEntries) {
+    Buffer_Init(out, INDEX_BLOCK_INITIAL_CAP);
+    return;
+  }
+
+  t_docId *ids = rm_malloc(blk->numEntries * sizeof(*ids));
+  if (IndexBlock_IsNumericSeries(blk)) {
+    double *values = rm_malloc(blk->numEntries * sizeof(*values));
+    IndexBlock_DecodeSeries(blk, ids, values);
+    IndexBlock_EncodeNumericRecords(out, blk->firstId, ids, values, blk->numEntries);
+    rm_free(ids);
+    rm_free(values);
+    return;
+  }
+
+  uint32_t *freqs = rm_malloc(blk->numEntries * sizeof(*freqs));
+  IndexBlock_Decode(blk, flags, ids, freqs);
+  IndexBlock_EncodeRecords(out, flags, blk->firstId, ids, freqs, blk->numEntries);
+  rm_free(ids);
+  rm_free(freqs);
+}
+
+// The ids of the cold blocks, the keys of their inflated data in the cold block cache
+static uint64_t coldBlockIds_g = 0;
+
+size_t IndexBlock_Freeze(IndexBlock *blk) {
+  size_t len = blk->buf.offset;
+  if ((blk->flags & (IndexBlock_Cold | IndexBlock_InlineData | IndexBlock_MappedData)) ||
+      len < INDEX_BLOCK_COLD_MIN_SIZE) {
+    return 0;
+  }
+  ColdBlockHeader hdr = {.len = len};
+  mz_ulong zlen = mz_compressBound(len);
+  Buffer cold;
+  Buffer_Init(&cold, sizeof(hdr) + zlen);
+  if (mz_compress2((unsigned char *)cold.data + sizeof(hdr), &zlen,
+                   (const unsigned char *)blk->buf.data, len, MZ_DEFAULT_LEVEL) != MZ_OK ||
+      sizeof(hdr) + zlen > len - len / INDEX_BLOCK_COLD_MIN_GAIN) {
+    Buffer_Free(&cold);
+    return 0;
+  }
+  hdr.id = __atomic_add_fetch(&coldBlockIds_g, 1, __ATOMIC_RELAXED);
+  memcpy(cold.data, &hdr, sizeof(hdr));
+  cold.offset = sizeof(hdr) + zlen;
+  Buffer_ShrinkToSize(&cold);
+  Buffer_Free(&blk->buf);
+  blk->buf = cold;
+  blk->flags |= IndexBlock_Cold;
+  return len - cold.offset;
+}
+
+static inline ColdBlockHeader IndexBlock_ColdHeader(const IndexBlock *blk) {
+  ColdBlockHeader hdr;
+  memcpy(&hdr, blk->buf.data, sizeof(hdr));
+  return hdr;
+}
+
+size_t IndexBlock_WarmLen(const IndexBlock *blk) {
+  return IndexBlock_IsCold(blk) ? IndexBlock_ColdHeader(blk).len : blk->buf.offset;
+}
+
+/* Inflate the data of a cold block into a buffer of its own */
+static void IndexBlock_Inflate(const IndexBlock *blk, Buffer *out) {
+  ColdBlockHeader hdr = IndexBlock_ColdHeader(blk);
+  Buffer_Init(out, hdr.len);
+  mz_ulong len = hdr.len;
+  int rc = mz_uncompress((unsigned char *)out->data, &len,
+                         (const unsigned char *)blk->buf.data + sizeof(hdr),
+                         blk->buf.offset - sizeof(hdr));
+  RS_LOG_ASSERT(rc == MZ_OK && len == hdr.len, "corrupt cold index block");
+  out->offset = len;
+}
+
+void IndexBlock_Thaw(IndexBlock *blk) {
+  if (!IndexBlock_IsCold(blk)) {
+    return;
+  }
+  Buffer warm;
+  IndexBlock_Inflate(blk, &warm);
+  Buffer_Free(&blk->buf);
+  blk->buf = warm;
+  blk->flags &= ~IndexBlock_Cold;
+}
+
+const IndexBlock *IndexBlock_Warm(const IndexBlock *blk, IndexBlock *warm) {
+  if (!IndexBlock_IsCold(blk)) {
+    return blk;
+  }
+  *warm = *blk;
+  IndexBlock_Inflate(blk, &warm->buf);
+  warm->flags &= ~IndexBlock_Cold;
+  return warm;
+}
+
+void IndexBlock_ReleaseWarm(const IndexBlock *blk, IndexBlock *warm) {
+  if (IndexBlock_IsCold(blk)) {
+    Buffer_Free(&warm->buf);
+  }
+}
+
+/* Pin the inflated data of a cold block in the cold block cache, inflating it on a miss */
+static ColdBlockEntry *IndexBlock_PinCold(const IndexBlock *blk) {
+  uint64_t id = IndexBlock_ColdHeader(blk).id;
+  ColdBlockEntry *e = ColdBlockCache_Pin(id);
+  if (!e) {
+    // inflated without the lock of the cache, the same block may be inflated concurrently
+    Buffer warm;
+    IndexBlock_Inflate(blk, &warm);
+    e = ColdBlockCache_Add(id, &warm);
+  }
+  return e;
+}
+
+/* Readers hold the read lock only, and race with each other on the flag */
+static inline void IndexBlock_MarkAccessed(IndexBlock *blk) {
+  if (!(__atomic_load_n(&blk->flags, __ATOMIC_RELAXED) & IndexBlock_Accessed)) {
+    __atomic_fetch_or(&blk->flags, IndexBlock_Accessed, __ATOMIC_RELAXED);
+  }
+}
+
+static inline void IndexReader_ReleaseColdBlock(IndexReader *ir) {
+  if (ir->coldBlock) {
+    ColdBlockCache_Unpin(ir->coldBlock);
+    ir->coldBlock = NULL;
+  }
+}
+
+void IndexReader_ResumeBlock(IndexReader *ir) {
+  size_t offset = ir->br.pos;
+  ir->br = NewBufferReader(ir->coldBlock ? &ir->coldBlock->buf : &IR_CURRENT_BLOCK(ir).buf);
+  ir->br.pos = offset;
+}
+
+/* Whether none of the values of a numeric block can pass a numeric filter */
+static inline int IndexBlock_OutsideFilter(const IndexBlock *blk, const NumericFilter *f) {
+  double min = blk->valueRange.min, max = blk->valueRange.max;
+  return max < f->min || min > f->max || (!f->inclusiveMin && max == f->min) ||
+         (!f->inclusiveMax && min == f->max);
+}
+
+/* Set up the reader at the beginning of its current block. Stream encoded and numeric series
+ * blocks are decoded into the reader's arrays, bitmap blocks are read in place. Numeric blocks none of whose values pass
+ * the reader's filter are left as if they were read through. Cold blocks are read from their
+ * inflated data in the cold block cache */
+static void IndexReader_LoadBlock(IndexReader *ir) {
+  IndexBlock *blk = &IR_CURRENT_BLOCK(ir);
+  if (ir->currentBlock + 1 < ir->idx->size) {
+    RS_PREFETCH(blk + 1);
+  }
+  IndexReader_ReleaseColdBlock(ir);
+  ir->br = NewBufferReader(&blk->buf);
+  ir->lastId = blk->firstId;
+  ir->blockPos = 0;
+  ir->blockBits = NULL;
+
+  const NumericFilter *flt = ir->decoderCtx.ptr;
+  if ((ir->idx->flags & Index_StoreNumeric) && flt && NumericFilter_IsNumeric(flt) &&
+      blk->numEntries && IndexBlock_OutsideFilter(blk, flt)) {
+    ir->br.pos = blk->buf.offset;
+    ir->blockLen = 0;
+    ++ir->blocksSkipped;
+    return;
+  }
+  ++ir->blocksRead;
+  ir->bytesRead += blk->buf.offset;
+  IndexBlock_MarkAccessed(blk);
+  IndexBlock warm;
+  if (IndexBlock_IsCold(blk)) {
+    ir->coldBlock = IndexBlock_PinCold(blk);
+    ir->br = NewBufferReader(&ir->coldBlock->buf);
+    warm = *blk;
+    warm.buf = ir->coldBlock->buf;
+    warm.flags &= ~IndexBlock_Cold;
+    blk = &warm;
+  }
+  if (!IndexBlock_IsSealed(blk)) {
+    ir->blockLen = 0;
+    return;
+  }
+
+  if (IndexBlock_IsBitmap(blk)) {
+    ir->blockBits = (const uint64_t *)blk->buf.data;
+    ir->blockLen = blk->lastId - blk->firstId + 1;
+    return;
+  }
+
+  if (ir->blockCap < blk->numEntries) {
+    ir->blockCap = blk->numEntries;
+    ir->blockIds = rm_realloc(ir->blockIds, ir->blockCap * sizeof(*ir->blockIds));
+    ir->blockFreqs = rm_realloc(ir->blockFreqs, ir->blockCap * sizeof(*ir->blockFreqs));
+  }
+  if (IndexBlock_IsNumericSeries(blk)) {
+    if (ir->blockValuesCap < blk->numEntries) {
+      ir->blockValuesCap = blk->numEntries;
+      ir->blockValues = rm_realloc(ir->blockValues, ir->blockValuesCap * sizeof(*ir->blockValues));
+    }
+    IndexBlock_DecodeSeries(blk, ir->blockIds, ir->blockValues);
+  } else {
+    IndexBlock_Decode(blk, ir->idx->flags, ir->blockIds, ir->blockFreqs);
+  }
+  ir->blockLen = blk->numEntries;
+}
+
+/* Return the position of the first set bit from `pos` in the reader's bitmap block. The block's
+ * lastId is always set, so there is one as long as pos < blockLen */
+static inline uint16_t IndexReader_NextBit(const IndexReader *ir, uint16_t pos) {
+  size_t w = pos / 64;
+  uint64_t word = ir->blockBits[w] & (~0ULL << (pos % 64));
+  while (!word) {
+    word = ir->blockBits[++w];
+  }
+  return w * 64 + __builtin_ctzll(word);
+}
+
+/* Prefetch the data of the reader's next reads. A parent reading its children in turn finds it in
+ * cache once it gets back to this reader, rather than stalling on a miss for every child */
+static inline void IndexReader_Prefetch(const IndexReader *ir) {
+  if (ir->blockBits) {
+    RS_PREFETCH((const char *)ir->blockBits + ir->blockPos / 8 + IR_PREFETCH_DISTANCE);
+  } else if (ir->blockLen) {
+    RS_PREFETCH((const char *)(ir->blockIds + ir->blockPos) + IR_PREFETCH_DISTANCE);
+  } else {
+    RS_PREFETCH(ir->br.buf->data + ir->br.pos + IR_PREFETCH_DISTANCE);
+  }
+}
+
+void IndexReader_SetBlock(IndexReader *ir, uint32_t blockIdx) {
+  ir->currentBlock = blockIdx;
+  IndexReader_LoadBlock(ir);
+}
+
 static void IndexReader_AdvanceBlock(IndexReader *ir) {
   ir->currentBlock++;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  IndexReader_LoadBlock(ir);
 }
 
 /******************************************************************************
@@ -706,11 +1634,27 @@ DECODER(readFreqOffsetsFlagsWide) {
 
   qint_decode3(br, (uint32_t *)&res->docId, &res->freq, &res->offsetsSz);
   res->fieldMask = ReadVarintFieldMask(br);
-  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(br), .len = res->offsetsSz};
+  res->term.offsets.data = BufferReader_Current(br);
+  res->term.offsets.len = res->offsetsSz;
   Buffer_Skip(br, res->offsetsSz);
   CHECK_FLAGS(ctx, res);
 }
 
+/* Whether a numeric record passes the numeric or geo filter of the context, if it has one. The
+ * value of a record within a geo filter's radius is replaced by its distance */
+static inline int numericRecordMatches(const IndexDecoderCtx *ctx, RSIndexResult *res) {
+  NumericFilter *f = ctx->ptr;
+  if (f) {
+    if (NumericFilter_IsNumeric(f)) {
+      return NumericFilter_Match(f, res->num.value);
+    } else {
+      return isWithinRadius(f->geoFilter, res->num.value, &res->num.value);
+    }
+  }
+
+  return 1;
+}
+
 // special decoder for decoding numeric results
 DECODER(readNumeric) {
   EncodingHeader header;
@@ -751,22 +1695,13 @@ DECODER(readNumeric) {
         Buffer_Read(br, &num, header.encInt.valueByteCount + 1);
         res->num.value = num;
         if (header.encCommon.type == NUM_ENCODING_COMMON_TYPE_NEG_INT) {
-          res->num.value = -res->num.value;
-        }
-      }
-      break;
-  }
-
-  NumericFilter *f = ctx->ptr;
-  if (f) {
-    if (NumericFilter_IsNumeric(f)) {
-      return NumericFilter_Match(f, res->num.value);
-    } else {
-      return isWithinRadius(f->geoFilter, res->num.value, &res->num.value);
-    }
+          res->num.value = -res->num.value;
+        }
+      }
+      break;
   }
 
-  return 1;
+  return numericRecordMatches(ctx, res);
 }
 
 DECODER(readFreqs) {
@@ -788,7 +1723,8 @@ DECODER(readFlagsWide) {
 
 DECODER(readFlagsOffsets) {
   qint_decode3(br, (uint32_t *)&res->docId, (uint32_t *)&res->fieldMask, &res->offsetsSz);
-  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(br), .len = res->offsetsSz};
+  res->term.offsets.data = BufferReader_Current(br);
+  res->term.offsets.len = res->offsetsSz;
   Buffer_Skip(br, res->offsetsSz);
   CHECK_FLAGS(ctx, res);
 }
@@ -797,7 +1733,8 @@ DECODER(readFlagsOffsetsWide) {
 
   qint_decode2(br, (uint32_t *)&res->docId, &res->offsetsSz);
   res->fieldMask = ReadVarintFieldMask(br);
-  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(br), .len = res->offsetsSz};
+  res->term.offsets.data = BufferReader_Current(br);
+  res->term.offsets.len = res->offsetsSz;
 
   Buffer_Skip(br, res->offsetsSz);
   CHECK_FLAGS(ctx, res);
@@ -805,14 +1742,16 @@ DECODER(readFlagsOffsetsWide) {
 
 DECODER(readOffsets) {
   qint_decode2(br, (uint32_t *)&res->docId, &res->offsetsSz);
-  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(br), .len = res->offsetsSz};
+  res->term.offsets.data = BufferReader_Current(br);
+  res->term.offsets.len = res->offsetsSz;
   Buffer_Skip(br, res->offsetsSz);
   return 1;
 }
 
 DECODER(readFreqsOffsets) {
   qint_decode3(br, (uint32_t *)&res->docId, &res->freq, &res->offsetsSz);
-  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(br), .len = res->offsetsSz};
+  res->term.offsets.data = BufferReader_Current(br);
+  res->term.offsets.len = res->offsetsSz;
   Buffer_Skip(br, res->offsetsSz);
   return 1;
 }
@@ -1054,7 +1993,7 @@ IndexCriteriaTester *IR_GetCriteriaTester(void *ctx) {
 
 size_t IR_NumEstimated(void *ctx) {
   IndexReader *ir = ctx;
-  return ir->idx->numDocs;
+  return ir->numEstimated ? ir->numEstimated : ir->idx->numDocs;
 }
 
 int IR_Read(void *ctx, RSIndexResult **e) {
@@ -1066,7 +2005,7 @@ int IR_Read(void *ctx, RSIndexResult **e) {
   do {
 
     // if needed - skip to the next block (skipping empty blocks that may appear here due to GC)
-    while (BufferReader_AtEnd(&ir->br)) {
+    while (IR_BLOCK_AT_END(ir)) {
       // We're at the end of the last block...
       if (ir->currentBlock + 1 == ir->idx->size) {
         goto eof;
@@ -1074,6 +2013,47 @@ int IR_Read(void *ctx, RSIndexResult **e) {
       IndexReader_AdvanceBlock(ir);
     }
 
+    if (ir->blockLen && ir->decoders.decoder == readNumeric) {
+      // Numeric series block: its values are filtered as the records would be
+      RSIndexResult *record = ir->record;
+      ir->lastId = record->docId = ir->blockIds[ir->blockPos];
+      record->num.value = ir->blockValues[ir->blockPos];
+      ++ir->blockPos;
+      if (!numericRecordMatches(&ir->decoderCtx, record)) {
+        ++ir->recordsFiltered;
+        continue;
+      }
+      if (ir->skipMulti) {
+        if (ir->sameId == ir->lastId) {
+          continue;
+        }
+        ir->sameId = ir->lastId;
+      }
+      ++ir->len;
+      IndexReader_Prefetch(ir);
+      *e = record;
+      return INDEXREAD_OK;
+    }
+
+    if (ir->blockLen) {
+      // Other sealed blocks hold neither filtered entries nor multiple values of the same doc.
+      RSIndexResult *record = ir->record;
+      if (ir->blockBits) {
+        uint16_t bit = IndexReader_NextBit(ir, ir->blockPos);
+        ir->lastId = record->docId = IR_CURRENT_BLOCK(ir).firstId + bit;
+        record->freq = 1;
+        ir->blockPos = bit + 1;
+      } else {
+        ir->lastId = record->docId = ir->blockIds[ir->blockPos];
+        record->freq = ir->blockFreqs[ir->blockPos];
+        ++ir->blockPos;
+      }
+      ++ir->len;
+      IndexReader_Prefetch(ir);
+      *e = record;
+      return INDEXREAD_OK;
+    }
+
     size_t pos = ir->br.pos;
     int rv = ir->decoders.decoder(&ir->br, &ir->decoderCtx, ir->record);
     RSIndexResult *record = ir->record;
@@ -1089,6 +2069,7 @@ int IR_Read(void *ctx, RSIndexResult **e) {
     // The decoder also acts as a filter. A zero return value means that the
     // current record should not be processed.
     if (!rv) {
+      ++ir->recordsFiltered;
       continue;
     }
 
@@ -1105,6 +2086,7 @@ int IR_Read(void *ctx, RSIndexResult **e) {
 
 
     ++ir->len;
+    IndexReader_Prefetch(ir);
     *e = record;
     return INDEXREAD_OK;
 
@@ -1114,6 +2096,45 @@ eof:
   return INDEXREAD_EOF;
 }
 
+/* Batch read. The docids of sealed blocks are copied straight from the decoded block (or bitmap),
+ * other blocks, and numeric series blocks whose values are filtered, are read record by record */
+static int IR_ReadBatch(void *ctx, t_docId *out, size_t max, size_t *n) {
+  IndexReader *ir = ctx;
+  RSIndexResult *record = ir->record;
+  *n = 0;
+  while (*n < max) {
+    if (ir->blockLen && ir->decoders.decoder != readNumeric && !IR_BLOCK_AT_END(ir) &&
+        !IR_IS_AT_END(ir)) {
+      size_t start = *n;
+      if (ir->blockBits) {
+        t_docId firstId = IR_CURRENT_BLOCK(ir).firstId;
+        while (*n < max && ir->blockPos < ir->blockLen) {
+          uint16_t bit = IndexReader_NextBit(ir, ir->blockPos);
+          out[(*n)++] = firstId + bit;
+          ir->blockPos = bit + 1;
+        }
+        record->freq = 1;
+      } else {
+        size_t len = MIN(ir->blockLen - ir->blockPos, max - *n);
+        memcpy(out + *n, ir->blockIds + ir->blockPos, len * sizeof(*out));
+        ir->blockPos += len;
+        *n += len;
+        record->freq = ir->blockFreqs[ir->blockPos - 1];
+      }
+      ir->lastId = record->docId = out[*n - 1];
+      ir->len += *n - start;
+      continue;
+    }
+
+    RSIndexResult *hit;
+    if (IR_Read(ir, &hit) != INDEXREAD_OK) {
+      break;
+    }
+    out[(*n)++] = hit->docId;
+  }
+  return *n ? INDEXREAD_OK : INDEXREAD_EOF;
+}
+
 #define BLOCK_MATCHES(blk, docId) ((blk).firstId <= docId && docId <= (blk).lastId)
 
 static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
@@ -1147,11 +2168,30 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
   ir->currentBlock = i;
 
 new_block:
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IndexReader_LoadBlock(ir);
   return rc;
 }
 
+/* Move the reader of a block with skip points to the last skip point before docId, unless the reader
+ * is already past it. Every record skipped this way has a docid smaller than docId */
+static void IndexReader_SeekSkips(IndexReader *ir, t_docId docId) {
+  const IndexBlock *blk = &IR_CURRENT_BLOCK(ir);
+  const IndexBlockSkip *skips = blk->skips;
+  uint32_t lo = 0, hi = array_len(skips);
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (blk->firstId + skips[mid].prevId < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo && skips[lo - 1].offset > ir->br.pos) {
+    ir->br.pos = skips[lo - 1].offset;
+    ir->lastId = blk->firstId + skips[lo - 1].prevId;
+  }
+}
+
 int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   IndexReader *ir = ctx;
   if (!docId) {
@@ -1168,7 +2208,7 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
   if (!BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId)) {
     IndexReader_SkipToBlock(ir, docId);
-  } else if (BufferReader_AtEnd(&ir->br)) {
+  } else if (IR_BLOCK_AT_END(ir)) {
     // Current block, but there's nothing here
     if (IR_Read(ir, hit) == INDEXREAD_EOF) {
       goto eof;
@@ -1198,9 +2238,37 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
    *    - ID is equal, return OK
    */
 
+  if (ir->blockBits) {
+    // Bitmap block: move straight to docId's bit, the next read returns the first docid from it.
+    // If docId is beyond the block, the loop below moves on to the next block.
+    const IndexBlock *blk = &IR_CURRENT_BLOCK(ir);
+    if (docId > blk->lastId) {
+      ir->blockPos = ir->blockLen;
+    } else if (docId > blk->firstId && docId - blk->firstId > ir->blockPos) {
+      ir->blockPos = docId - blk->firstId;
+    }
+  } else if (ir->blockLen) {
+    // Decoded block: binary search the decoded ids for the first one which is not smaller than
+    // docId. If there is none, the loop below moves on to the next block.
+    uint16_t lo = ir->blockPos, hi = ir->blockLen;
+    while (lo < hi) {
+      uint16_t mid = (lo + hi) / 2;
+      if (ir->blockIds[mid] < docId) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    ir->blockPos = lo;
+  } else if (IR_CURRENT_BLOCK(ir).skips) {
+    // Record block: start decoding from the closest skip point
+    IndexReader_SeekSkips(ir, docId);
+  }
+
+  // Indexes with a seeker are never sealed
   if (ir->decoders.seeker) {
     // // if needed - skip to the next block (skipping empty blocks that may appear here due to GC)
-    while (BufferReader_AtEnd(&ir->br)) {
+    while (IR_BLOCK_AT_END(ir)) {
       // We're at the end of the last block...
       if (ir->currentBlock + 1 == ir->idx->size) {
         goto eof;
@@ -1221,6 +2289,7 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
       }
     }
     // Found a document that match the field mask and greater or equal the searched docid
+    IndexReader_Prefetch(ir);
     *hit = ir->record;
     return (ir->record->docId == docId) ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
   } else {
@@ -1244,6 +2313,18 @@ size_t IR_NumDocs(void *ctx) {
   return ir->len;
 }
 
+int IR_ReadsWholeIndex(const IndexReader *ir) {
+  if (ir->decoders.decoder == readNumeric) {
+    return 0;
+  }
+  // the field mask of the index has the fields of all its entries
+  return !(ir->idx->flags & Index_StoreFieldFlags) || !(ir->idx->fieldMask & ~ir->decoderCtx.num);
+}
+
+const IndexBlock *IR_CurrentBlock(const IndexReader *ir) {
+  return &IR_CURRENT_BLOCK(ir);
+}
+
 static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedIndex *idx,
                              IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx, int skipMulti,
                              RSIndexResult *record) {
@@ -1252,21 +2333,87 @@ static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedInde
   ret->gcMarker = idx->gcMarker;
   ret->record = record;
   ret->len = 0;
-  ret->lastId = IR_CURRENT_BLOCK(ret).firstId;
   ret->sameId = 0;
   ret->skipMulti = skipMulti;
-  ret->br = NewBufferReader(&IR_CURRENT_BLOCK(ret).buf);
+  ret->blockBits = NULL;
+  // the buffers of the blocks, if any, are kept from the reader's previous use (see IR_Free)
+  ret->blocksSkipped = 0;
+  ret->blocksRead = 0;
+  ret->bytesRead = 0;
+  ret->recordsFiltered = 0;
+  ret->numEstimated = 0;
   ret->decoders = decoder;
   ret->decoderCtx = decoderCtx;
+  IndexReader_LoadBlock(ret);
   ret->isValidP = NULL;
   ret->sp = sp;
   IR_SetAtEnd(ret, 0);
 }
 
+/* The readers and their read iterators are taken from pools of each thread rather than allocated
+ * for each query, which only reads a few short lists when it is selective. A reader keeps the
+ * buffers of its decoded blocks while it is in the pool, unless they are too large */
+typedef struct {
+  mempool_t *readers;
+  mempool_t *iterators;
+} readerThreadPools;
+
+#define READER_POOL_MAX 128
+// Number of entries of the largest block buffers kept by a pooled reader
+#define READER_POOL_MAX_BLOCK 1024
+
+static pthread_key_t readerPoolsKey_g;
+
+static void readerThreadPoolsDtor(void *p) {
+  readerThreadPools *tp = p;
+  mempool_destroy(tp->readers);
+  mempool_destroy(tp->iterators);
+  rm_free(tp);
+}
+
+static void __attribute__((constructor)) initReaderPoolsKey() {
+  pthread_key_create(&readerPoolsKey_g, readerThreadPoolsDtor);
+}
+
+static void *readerAlloc() {
+  return rm_calloc(1, sizeof(IndexReader));
+}
+
+static void readerFree(void *p) {
+  IndexReader *ir = p;
+  rm_free(ir->blockIds);
+  rm_free(ir->blockFreqs);
+  rm_free(ir->blockValues);
+  rm_free(ir);
+}
+
+static void *readIteratorAlloc() {
+  return rm_malloc(sizeof(IndexIterator));
+}
+
+static void readIteratorFree(void *p) {
+  rm_free(p);
+}
+
+static readerThreadPools *getReaderPools() {
+  readerThreadPools *tp = pthread_getspecific(readerPoolsKey_g);
+  if (tp == NULL) {
+    tp = rm_calloc(1, sizeof(*tp));
+    mempool_options opts = {
+        .initialCap = 0, .maxCap = READER_POOL_MAX, .alloc = readerAlloc, .free = readerFree};
+    tp->readers = mempool_new(&opts);
+    opts.alloc = readIteratorAlloc;
+    opts.free = readIteratorFree;
+    tp->iterators = mempool_new(&opts);
+    pthread_setspecific(readerPoolsKey_g, tp);
+  }
+  return tp;
+}
+
 static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *idx,
                                           IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx, int skipMulti,
                                           RSIndexResult *record) {
-  IndexReader *ret = rm_malloc(sizeof(IndexReader));
+  IndexReader *ret = mempool_get(getReaderPools()->readers);
   IndexReader_Init(sp, ret, idx, decoder, decoderCtx, skipMulti, record);
   return ret;
 }
@@ -1274,9 +2421,18 @@ static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *id
 IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask fieldMask,
                                 RSQueryTerm *term, double weight) {
   if (term && sp) {
-    // compute IDF based on num of docs in the header
-    term->idf = CalculateIDF(sp->docs.size, idx->numDocs);
-    term->bm25_idf = CalculateIDF_BM25(sp->stats.numDocuments, idx->numDocs);
+    size_t numDocs, termDocs;
+    if (sp->clusterStats && term->str &&
+        ClusterStats_GetTerm(sp->clusterStats, term->str, term->len, sp->stats.numDocuments,
+                             idx->numDocs, &numDocs, &termDocs)) {
+      // compute IDF based on the statistics of the whole cluster
+      term->idf = CalculateIDF(numDocs, termDocs);
+      term->bm25_idf = CalculateIDF_BM25(numDocs, termDocs);
+    } else {
+      // compute IDF based on num of docs in the header
+      term->idf = CalculateIDF(sp->docs.size, idx->numDocs);
+      term->bm25_idf = CalculateIDF_BM25(sp->stats.numDocuments, idx->numDocs);
+    }
   }
 
   // Get the decoder
@@ -1288,6 +2444,8 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
   RSIndexResult *record = NewTokenRecord(term, weight);
   record->fieldMask = RS_FIELDMASK_ALL;
   record->freq = 1;
+  // The decoders only set the offsets' data, the format is the index's
+  record->term.offsets.packed = !!(idx->flags & Index_PackedOffsets);
 
   IndexDecoderCtx dctx = {.num = fieldMask};
 
@@ -1297,7 +2455,21 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
 void IR_Free(IndexReader *ir) {
 
   IndexResult_Free(ir->record);
-  rm_free(ir);
+  IndexReader_ReleaseColdBlock(ir);
+  if (ir->blockCap > READER_POOL_MAX_BLOCK) {
+    rm_free(ir->blockIds);
+    rm_free(ir->blockFreqs);
+    ir->blockIds = NULL;
+    ir->blockFreqs = NULL;
+    ir->blockCap = 0;
+  }
+  if (ir->blockValuesCap > READER_POOL_MAX_BLOCK) {
+    rm_free(ir->blockValues);
+    ir->blockValues = NULL;
+    ir->blockValuesCap = 0;
+  }
+  // released to the pool of the current thread, which may not be the one of the query
+  mempool_release(getReaderPools()->readers, ir);
 }
 
 void IR_Abort(void *ctx) {
@@ -1311,7 +2483,7 @@ void ReadIterator_Free(IndexIterator *it) {
   }
 
   IR_Free(it->ctx);
-  rm_free(it);
+  mempool_release(getReaderPools()->iterators, it);
 }
 
 inline t_docId IR_LastDocId(void *ctx) {
@@ -1322,14 +2494,12 @@ void IR_Rewind(void *ctx) {
 
   IndexReader *ir = ctx;
   IR_SetAtEnd(ir, 0);
-  ir->currentBlock = 0;
   ir->gcMarker = ir->idx->gcMarker;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
-  ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  IndexReader_SetBlock(ir, 0);
 }
 
 IndexIterator *NewReadIterator(IndexReader *ir) {
-  IndexIterator *ri = rm_malloc(sizeof(IndexIterator));
+  IndexIterator *ri = mempool_get(getReaderPools()->iterators);
   ri->ctx = ir;
   ri->mode = MODE_SORTED;
   ri->type = READ_ITERATOR;
@@ -1337,6 +2507,7 @@ IndexIterator *NewReadIterator(IndexReader *ir) {
   ri->GetCriteriaTester = IR_GetCriteriaTester;
   ri->Read = IR_Read;
   ri->SkipTo = IR_SkipTo;
+  ri->ReadBatch = IR_ReadBatch;
   ri->LastDocId = IR_LastDocId;
   ri->Free = ReadIterator_Free;
   ri->Len = IR_NumDocs;
@@ -1350,11 +2521,179 @@ IndexIterator *NewReadIterator(IndexReader *ir) {
   return ri;
 }
 
+/* Encode the `n` entries which remain of a sealed block again, in the format that fits them best
+ * (which may be the record format, if they are too sparse for a bitmap) */
+static void IndexBlock_Reseal(IndexBlock *blk, IndexFlags flags, t_docId *ids, uint32_t *freqs,
+                              uint16_t n) {
+  t_docId oldLastId = blk->lastId;
+  IndexBlock_FreeData(blk);
+  blk->numEntries = n;
+  blk->flags &= ~IndexBlock_SealedFlags;
+  if (n) {
+    blk->firstId = ids[0];
+    blk->lastId = ids[n - 1];
+    IndexBlock_EncodeRecords(&blk->buf, flags, blk->firstId, ids, freqs, n);
+    uint8_t format = IndexBlock_SealedFormat(flags, blk->firstId, blk->lastId, ids, freqs, n,
+                                             blk->buf.offset);
+    if (format) {
+      Buffer_Free(&blk->buf);
+      IndexBlock_EncodeSealed(blk, flags, format, ids, freqs, n);
+    } else {
+      Buffer_ShrinkToSize(&blk->buf);
+      IndexBlock_BuildSkips(blk, flags);
+    }
+  } else {
+    // Same as a regular empty block (see IndexBlock_Repair)
+    blk->buf = (Buffer){0};
+    blk->firstId = oldLastId;
+    blk->lastId = 0;
+  }
+}
+
+/* Encode the `n` entries which remain of a numeric block again, in the series format if it is
+ * smaller than the records */
+static void IndexBlock_ResealNumeric(IndexBlock *blk, IndexFlags flags, const t_docId *ids,
+                                     const double *values, uint16_t n) {
+  t_docId oldLastId = blk->lastId;
+  IndexBlock_FreeData(blk);
+  blk->numEntries = n;
+  blk->flags &= ~IndexBlock_SealedFlags;
+  if (n) {
+    blk->firstId = ids[0];
+    blk->lastId = ids[n - 1];
+    IndexBlock_EncodeNumericRecords(&blk->buf, blk->firstId, ids, values, n);
+    Buffer series;
+    if (blk->lastId - blk->firstId <= UINT32_MAX &&
+        IndexBlock_EncodeSeries(&series, blk->firstId, ids, values, n, blk->buf.offset)) {
+      Buffer_Free(&blk->buf);
+      blk->buf = series;
+      blk->flags |= IndexBlock_NumericSeries;
+    } else {
+      Buffer_ShrinkToSize(&blk->buf);
+      IndexBlock_BuildSkips(blk, flags);
+    }
+  } else {
+    // Same as a regular empty block (see IndexBlock_Repair)
+    blk->buf = (Buffer){0};
+    blk->firstId = oldLastId;
+    blk->lastId = 0;
+  }
+}
+
+/* Repair a numeric series block. The values of the surviving entries are passed to the repair
+ * callback, and they are sealed again (see IndexBlock_ResealNumeric) */
+static int IndexBlock_RepairSeries(IndexBlock *blk, DocTable *dt, IndexFlags flags,
+                                   IndexRepairParams *params) {
+  uint16_t n = blk->numEntries;
+  t_docId *ids = rm_malloc(n * sizeof(*ids));
+  double *values = rm_malloc(n * sizeof(*values));
+  IndexBlock_DecodeSeries(blk, ids, values);
+
+  params->bytesBeforFix = blk->buf.offset;
+
+  RSIndexResult *res = NewNumericResult();
+  uint16_t kept = 0;
+  int frags = 0, docExists = 0;
+  for (uint16_t i = 0; i < n; ++i) {
+    // The values of a multi value document follow each other, it is looked up once
+    if (i == 0 || ids[i] != ids[i - 1]) {
+      docExists = DocTable_Exists(dt, ids[i]);
+      frags += !docExists;
+    }
+    if (!docExists) {
+      ++params->entriesCollected;
+      continue;
+    }
+    if (params->RepairCallback) {
+      res->docId = ids[i];
+      res->num.value = values[i];
+      params->RepairCallback(res, blk, params->arg);
+    }
+    ids[kept] = ids[i];
+    values[kept] = values[i];
+    ++kept;
+  }
+
+  if (kept < n) {
+    IndexBlock_ResealNumeric(blk, flags, ids, values, kept);
+  }
+
+  params->bytesAfterFix = blk->buf.offset;
+  params->bytesCollected += params->bytesBeforFix - params->bytesAfterFix;
+
+  IndexResult_Free(res);
+  rm_free(ids);
+  rm_free(values);
+  return frags;
+}
+
+/* Repair a sealed block. The surviving entries are sealed again (see IndexBlock_Reseal) */
+static int IndexBlock_RepairSealed(IndexBlock *blk, DocTable *dt, IndexFlags flags,
+                                   IndexRepairParams *params) {
+  uint16_t n = blk->numEntries;
+  t_docId *ids = rm_malloc(n * sizeof(*ids));
+  uint32_t *freqs = rm_malloc(n * sizeof(*freqs));
+  IndexBlock_Decode(blk, flags, ids, freqs);
+
+  params->bytesBeforFix = blk->buf.offset;
+
+  RSIndexResult *res = NewTokenRecord(NULL, 1);
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < n; ++i) {
+    if (!DocTable_Exists(dt, ids[i])) {
+      continue;
+    }
+    if (params->RepairCallback) {
+      res->docId = ids[i];
+      res->freq = freqs[i];
+      params->RepairCallback(res, blk, params->arg);
+    }
+    ids[kept] = ids[i];
+    freqs[kept] = freqs[i];
+    ++kept;
+  }
+
+  int frags = n - kept;
+  if (frags) {
+    IndexBlock_Reseal(blk, flags, ids, freqs, kept);
+    params->entriesCollected += frags;
+  }
+
+  params->bytesAfterFix = blk->buf.offset;
+  params->bytesCollected += params->bytesBeforFix - params->bytesAfterFix;
+
+  IndexResult_Free(res);
+  rm_free(ids);
+  rm_free(freqs);
+  return frags;
+}
+
 /* Repair an index block by removing garbage - records pointing at deleted documents.
  * Returns the number of records collected, and puts the number of bytes collected in the given
  * pointer. If an error occurred - returns -1
  */
 int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepairParams *params) {
+  if (IndexBlock_IsCold(blk)) {
+    // A cold block stays as it is unless entries are removed from it, as the fork GC child passes
+    // the blocks it leaves alone back to the main process, which still holds them
+    IndexBlock warm;
+    IndexBlock_Warm(blk, &warm);
+    int rv = IndexBlock_Repair(&warm, dt, flags, params);
+    if (rv > 0) {
+      Buffer_Free(&blk->buf);
+      *blk = warm;
+    } else {
+      IndexBlock_ReleaseWarm(blk, &warm);
+    }
+    return rv;
+  }
+  if (IndexBlock_IsNumericSeries(blk)) {
+    return IndexBlock_RepairSeries(blk, dt, flags, params);
+  }
+  if (IndexBlock_IsSealed(blk)) {
+    return IndexBlock_RepairSealed(blk, dt, flags, params);
+  }
+
   t_docId firstReadId = blk->firstId;
   t_docId lastReadId = blk->firstId;
   bool isFirstRes = true;
@@ -1459,9 +2798,13 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     // If we deleted stuff from this block, we need to change the number of entries and the data
     // pointer
     blk->numEntries -= params->entriesCollected;
-    Buffer_Free(&blk->buf);
+    IndexBlock_FreeData(blk);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    // The records moved, skip points of a sealed block have to be built again
+    if (blk->skips) {
+      IndexBlock_BuildSkips(blk, flags);
+    }
   }
   if (blk->numEntries == 0) {
     // if we left with no elements we do need to keep the
@@ -1499,6 +2842,12 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
       params->docsCollected += repaired;
       idx->numDocs -= repaired;
 
+      // Blocks in the record format are repaired in place, seal them again in the format which
+      // fits their remaining entries. The last block may still be appended to
+      if (startBlock + 1 < idx->size) {
+        IndexBlock_Seal(blk, idx->flags);
+      }
+
       // Increase the GC marker so other queries can tell that we did something
       ++idx->gcMarker;
     }
@@ -1506,3 +2855,329 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
 
   return startBlock < idx->size ? startBlock : 0;
 }
+
+static int IndexBlock_RemapSeries(IndexBlock *blk, IndexFlags flags, const DocIdRemap *remap,
+                                  IndexRepairParams *params) {
+  uint16_t n = blk->numEntries;
+  t_docId *ids = rm_malloc(n * sizeof(*ids));
+  double *values = rm_malloc(n * sizeof(*values));
+  IndexBlock_DecodeSeries(blk, ids, values);
+
+  uint16_t kept = 0;
+  int dropped = 0;
+  t_docId newId = 0;
+  for (uint16_t i = 0; i < n; ++i) {
+    // the entries of a multi value document follow each other
+    if (i == 0 || ids[i] != ids[i - 1]) {
+      newId = DocIdRemap_Get(remap, ids[i]);
+      dropped += !newId;
+    }
+    if (!newId) {
+      ++params->entriesCollected;
+      continue;
+    }
+    ids[kept] = newId;
+    values[kept] = values[i];
+    ++kept;
+  }
+  IndexBlock_ResealNumeric(blk, flags, ids, values, kept);
+
+  rm_free(ids);
+  rm_free(values);
+  return dropped;
+}
+
+static int IndexBlock_RemapSealed(IndexBlock *blk, IndexFlags flags, const DocIdRemap *remap,
+                                  IndexRepairParams *params) {
+  uint16_t n = blk->numEntries;
+  t_docId *ids = rm_malloc(n * sizeof(*ids));
+  uint32_t *freqs = rm_malloc(n * sizeof(*freqs));
+  IndexBlock_Decode(blk, flags, ids, freqs);
+
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < n; ++i) {
+    t_docId newId = DocIdRemap_Get(remap, ids[i]);
+    if (!newId) {
+      continue;
+    }
+    ids[kept] = newId;
+    freqs[kept] = freqs[i];
+    ++kept;
+  }
+  IndexBlock_Reseal(blk, flags, ids, freqs, kept);
+  params->entriesCollected += n - kept;
+
+  rm_free(ids);
+  rm_free(freqs);
+  return n - kept;
+}
+
+/* Rewrite a block with the ids of its entries remapped, dropping the entries of the documents which
+ * are no longer in the table. Returns the number of documents dropped, or -1 on error */
+static int IndexBlock_Remap(IndexBlock *blk, IndexFlags flags, const DocIdRemap *remap,
+                            IndexRepairParams *params) {
+  if (IndexBlock_IsNumericSeries(blk)) {
+    return IndexBlock_RemapSeries(blk, flags, remap, params);
+  }
+  if (IndexBlock_IsSealed(blk)) {
+    return IndexBlock_RemapSealed(blk, flags, remap, params);
+  }
+
+  uint32_t readFlags = flags & INDEX_STORAGE_MASK;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
+  IndexEncoder encoder = InvertedIndex_GetEncoder(readFlags);
+  if (!encoder || !decoders.decoder) {
+    fprintf(stderr, "Could not get decoder/encoder for index\n");
+    return -1;
+  }
+
+  Buffer remapped = {0};
+  BufferReader br = NewBufferReader(&blk->buf);
+  BufferWriter bw = NewBufferWriter(&remapped);
+  RSIndexResult *res = flags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
+
+  t_docId oldFirstId = blk->firstId, oldLastId = blk->lastId;
+  t_docId lastReadId = blk->firstId;
+  t_docId newId = 0, firstId = 0, lastId = 0;
+  bool isFirstRes = true;
+  uint16_t kept = 0;
+  int dropped = 0;
+  while (!BufferReader_AtEnd(&br)) {
+    static const IndexDecoderCtx empty = {0};
+    decoders.decoder(&br, &empty, res);
+    // The deltas are decoded as in IndexBlock_Repair
+    if (!(isFirstRes && res->docId != 0)) {
+      if (decoders.decoder != readRawDocIdsOnly) {
+        res->docId = (*(uint32_t *)&res->docId) + lastReadId;
+      } else {
+        res->docId = (*(uint32_t *)&res->docId) + oldFirstId;
+      }
+    }
+    // the entries of a multi value document follow each other
+    if (isFirstRes || res->docId != lastReadId) {
+      newId = DocIdRemap_Get(remap, res->docId);
+      dropped += !newId;
+    }
+    isFirstRes = false;
+    lastReadId = res->docId;
+
+    if (!newId) {
+      ++params->entriesCollected;
+      continue;
+    }
+    if (!kept) {
+      firstId = lastId = newId;
+    }
+    encoder(&bw, encoder == encodeRawDocIdsOnly ? newId - firstId : newId - lastId, res);
+    lastId = newId;
+    ++kept;
+  }
+  IndexResult_Free(res);
+
+  IndexBlock_FreeData(blk);
+  blk->buf = remapped;
+  blk->numEntries = kept;
+  if (kept) {
+    Buffer_ShrinkToSize(&blk->buf);
+    blk->firstId = firstId;
+    blk->lastId = lastId;
+  } else {
+    // Same as a regular empty block (see IndexBlock_Repair)
+    blk->firstId = oldLastId;
+    blk->lastId = 0;
+  }
+  if (blk->skips) {
+    IndexBlock_BuildSkips(blk, flags);
+  }
+  return dropped;
+}
+
+size_t InvertedIndex_Remap(InvertedIndex *idx, const DocIdRemap *remap,
+                           IndexRepairParams *params) {
+  if (!idx->size || idx->lastId < remap->from || idx->blocks[0].firstId >= remap->to) {
+    return 0;
+  }
+
+  // The last block starting below the range may hold some of its entries
+  uint32_t lo = 0, hi = idx->size;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (idx->blocks[mid].firstId < remap->from) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  uint32_t i = lo ? lo - 1 : 0;
+
+  size_t dropped = 0;
+  while (i < idx->size && idx->blocks[i].firstId < remap->to) {
+    IndexBlock *blk = idx->blocks + i;
+    if (!blk->numEntries || blk->lastId < remap->from) {
+      ++i;
+      continue;
+    }
+    IndexBlock_Thaw(blk);
+    params->bytesBeforFix += blk->buf.offset;
+    int rc = IndexBlock_Remap(blk, idx->flags, remap, params);
+    params->bytesAfterFix += blk->buf.offset;
+    if (rc == -1) {
+      break;
+    }
+    dropped += rc;
+
+    if (!blk->numEntries && i + 1 < idx->size) {
+      // An empty block would break the order of the first ids of the blocks, as its first id is
+      // no longer remapped
+      indexBlock_Free(blk);
+      memmove(blk, blk + 1, (idx->size - i - 1) * sizeof(*blk));
+      --idx->size;
+      --TotalIIBlocks;
+      continue;
+    }
+    // Seal the rewritten blocks in the format which fits them, as the repaired ones
+    if (i + 1 < idx->size) {
+      IndexBlock_Seal(blk, idx->flags);
+    }
+    ++i;
+  }
+
+  if (idx->lastId < remap->to) {
+    t_docId lastId = DocIdRemap_Get(remap, idx->lastId);
+    for (uint32_t j = idx->size; !lastId && j > 0; --j) {
+      lastId = idx->blocks[j - 1].lastId;
+    }
+    idx->lastId = lastId;
+  }
+  idx->numDocs -= dropped;
+  ++idx->gcMarker;
+  return dropped;
+}
+
+/* Decode the entries of a block of a docids-only or freqs-only index, in any format */
+static void IndexBlock_DecodeAny(const IndexBlock *blk, IndexFlags flags, t_docId *ids,
+                                 uint32_t *freqs) {
+  if (IndexBlock_IsSealed(blk)) {
+    IndexBlock_Decode(blk, flags, ids, freqs);
+  } else {
+    IndexBlock_DecodeRecords(blk, flags, ids, freqs);
+  }
+}
+
+/* Re-encode the records of `src` into `bw`, as the records following `*lastId` in a block starting
+ * at `firstId`. `*lastId` is 0 for the first record of the block */
+static void IndexBlock_CopyRecords(const IndexBlock *src, IndexFlags flags, BufferWriter *bw,
+                                   t_docId firstId, t_docId *lastId, RSIndexResult *res) {
+  uint32_t readFlags = flags & INDEX_STORAGE_MASK;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
+  IndexEncoder encoder = InvertedIndex_GetEncoder(readFlags);
+  static const IndexDecoderCtx empty = {0};
+
+  BufferReader br = NewBufferReader((Buffer *)&src->buf);
+  t_docId lastReadId = src->firstId;
+  bool isFirstRes = true;
+  while (!BufferReader_AtEnd(&br)) {
+    decoders.decoder(&br, &empty, res);
+    // The deltas are decoded as in IndexBlock_Repair
+    if (!(isFirstRes && res->docId != 0)) {
+      if (decoders.decoder != readRawDocIdsOnly) {
+        res->docId = (*(uint32_t *)&res->docId) + lastReadId;
+      } else {
+        res->docId = (*(uint32_t *)&res->docId) + src->firstId;
+      }
+    }
+    isFirstRes = false;
+    lastReadId = res->docId;
+
+    t_docId prevId = *lastId ? *lastId : firstId;
+    encoder(bw, encoder == encodeRawDocIdsOnly ? res->docId - firstId : res->docId - prevId, res);
+    *lastId = res->docId;
+  }
+}
+
+/* Merge the entries of `next` into the block `blk` preceding it. Both blocks hold entries */
+static void IndexBlock_Merge(IndexBlock *blk, IndexBlock *next, IndexFlags flags) {
+  uint16_t n = blk->numEntries + next->numEntries;
+  if (flags == Index_StoreNumeric) {
+    blk->valueRange.min = MIN(blk->valueRange.min, next->valueRange.min);
+    blk->valueRange.max = MAX(blk->valueRange.max, next->valueRange.max);
+  } else {
+    blk->maxFreq = MAX(blk->maxFreq, next->maxFreq);
+  }
+
+  if (flags == Index_StoreNumeric) {
+    t_docId *ids = rm_malloc(n * sizeof(*ids));
+    double *values = rm_malloc(n * sizeof(*values));
+    IndexBlock_DecodeNumeric(blk, ids, values);
+    IndexBlock_DecodeNumeric(next, ids + blk->numEntries, values + blk->numEntries);
+    array_free(blk->skips);
+    blk->skips = NULL;
+    IndexBlock_ResealNumeric(blk, flags, ids, values, n);
+    rm_free(ids);
+    rm_free(values);
+    return;
+  }
+
+  if (InvertedIndex_SupportsStreamVByte(flags)) {
+    t_docId *ids = rm_malloc(n * sizeof(*ids));
+    uint32_t *freqs = rm_malloc(n * sizeof(*freqs));
+    IndexBlock_DecodeAny(blk, flags, ids, freqs);
+    IndexBlock_DecodeAny(next, flags, ids + blk->numEntries, freqs + blk->numEntries);
+    IndexBlock_FreeData(blk);
+    array_free(blk->skips);
+    blk->skips = NULL;
+    IndexBlock_Reseal(blk, flags, ids, freqs, n);
+    rm_free(ids);
+    rm_free(freqs);
+    return;
+  }
+
+  Buffer merged = {0};
+  BufferWriter bw = NewBufferWriter(&merged);
+  RSIndexResult *res = flags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
+  t_docId lastId = 0;
+  IndexBlock_CopyRecords(blk, flags, &bw, blk->firstId, &lastId, res);
+  IndexBlock_CopyRecords(next, flags, &bw, blk->firstId, &lastId, res);
+  IndexResult_Free(res);
+
+  IndexBlock_FreeData(blk);
+  blk->buf = merged;
+  blk->numEntries = n;
+  blk->lastId = next->lastId;
+  array_free(blk->skips);
+  blk->skips = NULL;
+  IndexBlock_Seal(blk, flags);
+}
+
+size_t InvertedIndex_MergeBlocks(InvertedIndex *idx, IndexRepairParams *params) {
+  size_t merged = 0;
+  // The last block is still written to, and is left alone
+  uint32_t i = 0;
+  while (i + 2 < idx->size) {
+    IndexBlock *blk = idx->blocks + i, *next = blk + 1;
+    if (blk->numEntries + next->numEntries > InvertedIndex_BlockCapacity(idx, i)) {
+      ++i;
+      continue;
+    }
+    IndexBlock_Thaw(blk);
+    IndexBlock_Thaw(next);
+    params->bytesBeforFix += blk->buf.offset + next->buf.offset;
+    if (!blk->numEntries) {
+      IndexBlock tmp = *blk;
+      *blk = *next;
+      *next = tmp;
+    } else if (next->numEntries) {
+      IndexBlock_Merge(blk, next, idx->flags);
+    }
+    params->bytesAfterFix += blk->buf.offset;
+    indexBlock_Free(next);
+    memmove(next, next + 1, (idx->size - i - 2) * sizeof(*next));
+    --idx->size;
+    --TotalIIBlocks;
+    ++merged;
+  }
+  if (merged) {
+    ++idx->gcMarker;
+  }
+  return merged;
+}
@@ -24,14 +24,82 @@ extern "C" {
 
 extern uint64_t TotalIIBlocks;
 
+typedef enum {
+  // The block holds its docid deltas (and frequencies) as stream-vbyte streams, and can only be
+  // decoded as a whole. Blocks are converted to this format once they are full (see
+  // Index_StreamVByte)
+  IndexBlock_StreamEncoded = 0x01,
+  // The block holds a bitmap of its docids, relative to its firstId. Dense blocks of docids-only
+  // indexes are converted to this format once they are full
+  IndexBlock_Bitmap = 0x02,
+  // The block holds its docid deltas (and frequencies) bit-packed with a fixed width per block.
+  // Full blocks of docids-only and freqs-only indexes are converted to this format when it is
+  // smaller than the records
+  IndexBlock_BitPacked = 0x04,
+  // The block's data is held in the allocation of its index rather than in a buffer of its own
+  // (see InvertedIndex_InlineData). It moves to a buffer of its own once it outgrows it
+  IndexBlock_InlineData = 0x08,
+  // The block's data is held in an index segment rather than on the heap (see index_segments.h).
+  // Only full blocks are moved there, and move back to a buffer of their own if written to again
+  IndexBlock_MappedData = 0x10,
+  // The block holds its docid deltas bit-packed, followed by its values encoded as a time series.
+  // Full blocks of numeric indexes are converted to this format when it is smaller than the records
+  IndexBlock_NumericSeries = 0x20,
+  // The block's data is deflated, behind a ColdBlockHeader, as it was not read for a while (see
+  // block_tiering.h). It keeps its format flags and skip points, which apply to the inflated data.
+  // Readers inflate it into the cold block cache, the GC and other writers inflate it in place
+  IndexBlock_Cold = 0x40,
+  // The block was read or written since the last sweep of the block tiering. Set by the readers
+  // with an atomic or, as they hold the read lock only
+  IndexBlock_Accessed = 0x80,
+} IndexBlockFlags;
+
+/* The header of the data of a cold block, followed by the deflated data */
+typedef struct {
+  uint64_t id;   // the key of the inflated data in the cold block cache, unique to the block
+  uint32_t len;  // the length of the inflated data
+} ColdBlockHeader;
+
+/* A skip point of a block in the record format: the offset of a record in the block's buffer, and
+ * the docid of the record preceding it, which the record's delta is relative to */
+typedef struct {
+  uint32_t offset;
+  uint32_t prevId;  // Relative to the block's firstId
+} IndexBlockSkip;
+
 /* A single block of data in the index. The index is basically a list of blocks we iterate */
 typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
   uint16_t numEntries;
+  uint8_t flags;  // IndexBlockFlags
+  union {
+    // An upper bound of the frequency of the block's entries. Used to bound the score of the
+    // documents in the block without decoding it. Garbage collection does not lower it
+    uint32_t maxFreq;
+    // The range of the values of a numeric block's entries, rounded outwards to floats. Lets
+    // filtered readers skip blocks without decoding them. Garbage collection does not narrow it
+    struct {
+      float min;
+      float max;
+    } valueRange;
+  };
+  // Skip points (an arr.h array) of every INDEX_BLOCK_SKIP_INTERVAL-th record, built when a block
+  // in the record format is sealed. Lets SkipTo jump close to its target instead of decoding the
+  // block from its beginning. NULL if the block has none
+  IndexBlockSkip *skips;
 } IndexBlock;
 
+#define IndexBlock_IsStreamEncoded(b) ((b)->flags & IndexBlock_StreamEncoded)
+#define IndexBlock_IsBitmap(b) ((b)->flags & IndexBlock_Bitmap)
+#define IndexBlock_IsBitPacked(b) ((b)->flags & IndexBlock_BitPacked)
+#define IndexBlock_IsNumericSeries(b) ((b)->flags & IndexBlock_NumericSeries)
+#define IndexBlock_SealedFlags \
+  (IndexBlock_StreamEncoded | IndexBlock_Bitmap | IndexBlock_BitPacked | IndexBlock_NumericSeries)
+#define IndexBlock_IsSealed(b) ((b)->flags & IndexBlock_SealedFlags)
+#define IndexBlock_IsCold(b) ((b)->flags & IndexBlock_Cold)
+
 typedef struct InvertedIndex {
   IndexBlock *blocks;
   uint32_t size;
@@ -47,6 +115,24 @@ typedef struct InvertedIndex {
   };
 } InvertedIndex;
 
+/* The size of the header of an index with the given flags (see NewInvertedIndex) */
+#define InvertedIndex_HeaderSize(flags)                          \
+  (((flags) & (Index_StoreFieldFlags | Index_StoreNumeric))      \
+       ? sizeof(InvertedIndex)                                   \
+       : sizeof(InvertedIndex) - sizeof(t_fieldMask))
+
+/* The first block of an index is allocated along with the index, right after its header, so that
+ * indexes of a single block (e.g. rare terms) take a single allocation. The blocks move to a
+ * separately allocated array once the index grows past it */
+#define InvertedIndex_InlineBlock(idx) \
+  ((IndexBlock *)((char *)(idx) + InvertedIndex_HeaderSize((idx)->flags)))
+#define InvertedIndex_HasInlineBlock(idx) ((idx)->blocks == InvertedIndex_InlineBlock(idx))
+
+/* The data of the first block follows the inline block. Rare terms have one to a few postings, which
+ * fit in it, so that they do not take an allocation of their own */
+#define INDEX_BLOCK_INLINE_CAP 8
+#define InvertedIndex_InlineData(idx) ((char *)(InvertedIndex_InlineBlock(idx) + 1))
+
 struct indexReadCtx;
 
 /**
@@ -86,6 +172,9 @@ typedef struct {
  * block */
 InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock);
 IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId);
+
+/* The number of entries after which the block at `blockIdx` is full, and a new block is added */
+uint16_t InvertedIndex_BlockCapacity(const InvertedIndex *idx, uint32_t blockIdx);
 void indexBlock_Free(IndexBlock *blk);
 void InvertedIndex_Free(void *idx);
 
@@ -95,6 +184,38 @@ void InvertedIndex_Free(void *idx);
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params);
 
+/* Decode all the entries of a sealed block of a docids-only or freqs-only index. `ids` and `freqs` must hold at least
+ * blk->numEntries entries. `freqs` is used as scratch space even if the index does not store
+ * frequencies, in which case it is filled with 1 */
+void IndexBlock_Decode(const IndexBlock *blk, IndexFlags flags, t_docId *ids, uint32_t *freqs);
+
+/* Convert a full block to a sealed format (a bitmap, stream-vbyte with Index_StreamVByte,
+ * bit-packed deltas, or a numeric series) if it applies to the block. Otherwise the block keeps the record format, its
+ * buffer is shrunk to the records and its skip points are built.
+ * Returns 1 if the block was converted (which invalidates readers' offsets into it) */
+int IndexBlock_Seal(IndexBlock *blk, IndexFlags flags);
+
+/* Deflate the data of a block which is no longer written to, if it is large enough and deflating
+ * saves enough of it. Blocks held inline or in an index segment are left as they are. Returns the
+ * number of bytes saved, 0 if the block was left as it was */
+size_t IndexBlock_Freeze(IndexBlock *blk);
+
+/* Inflate the data of a cold block in place. Does nothing if the block is not cold */
+void IndexBlock_Thaw(IndexBlock *blk);
+
+/* The length of the data of a block once inflated */
+size_t IndexBlock_WarmLen(const IndexBlock *blk);
+
+/* A block to read the data of `blk` from without changing it. If `blk` is cold, `warm` is set to a
+ * copy of it with its data inflated into a buffer of its own, which IndexBlock_ReleaseWarm frees.
+ * Otherwise `blk` itself is returned */
+const IndexBlock *IndexBlock_Warm(const IndexBlock *blk, IndexBlock *warm);
+void IndexBlock_ReleaseWarm(const IndexBlock *blk, IndexBlock *warm);
+
+/* Write the content of a block, in the regular per-record encoding, into `out`. Used where the
+ * records are consumed one by one from a buffer (e.g. the legacy inverted index RDB format) */
+void IndexBlock_ToRecordBuffer(const IndexBlock *blk, IndexFlags flags, Buffer *out);
+
 /**
  * Decode a single record from the buffer reader. This function is responsible for:
  * (1) Decoding the record at the given position of br
@@ -152,9 +273,35 @@ typedef struct IndexReader {
   /* The number of records read */
   size_t len;
 
+  /* The number of blocks skipped as none of their values passes the numeric filter */
+  uint32_t blocksSkipped;
+
+  /* For FT.PROFILE: the blocks loaded, the bytes of their data, and the records decoded but
+   * dropped by the field mask or the numeric filter */
+  uint32_t blocksRead;
+  size_t bytesRead;
+  size_t recordsFiltered;
+
+  /* The number of records the reader is expected to yield, if it is known better than by the
+   * number of documents in the index. 0 if it is not */
+  size_t numEstimated;
+
   /* The record we are decoding into */
   RSIndexResult *record;
 
+  /* Decoded entries of the current block, if it is stream encoded. blockLen is 0 if the current
+   * block is read from `br` record by record. For bitmap blocks, blockBits points at the bitmap,
+   * and blockLen and blockPos count bits rather than entries. Numeric series blocks are decoded
+   * into blockIds and blockValues */
+  const uint64_t *blockBits;
+  t_docId *blockIds;
+  uint32_t *blockFreqs;
+  double *blockValues;
+  uint16_t blockCap;
+  uint16_t blockValuesCap;
+  uint16_t blockLen;
+  uint16_t blockPos;
+
   int atEnd_;
 
   // If present, this pointer is updated when the end has been reached. This is
@@ -165,10 +312,24 @@ typedef struct IndexReader {
    * thread was asleep, and reset the state in a deeper way
    */
   uint32_t gcMarker;
+
+  /* The inflated data of the current block if it is cold, pinned in the cold block cache while the
+   * reader is on the block */
+  struct ColdBlockEntry *coldBlock;
 } IndexReader;
 
 void IndexReader_OnReopen(void *privdata);
 
+/* Point the reader back at the data of its current block, at the same offset, once it reopened
+ * the index and the GC did not run on it meanwhile */
+void IndexReader_ResumeBlock(IndexReader *ir);
+
+/* The block the reader is positioned at, i.e. the block of the last record read */
+const IndexBlock *IR_CurrentBlock(const IndexReader *ir);
+
+/* Position the reader at the beginning of the given block */
+void IndexReader_SetBlock(IndexReader *ir, uint32_t blockIdx);
+
 /* An index encoder is a callback that writes records to the index. It accepts a pre-calculated
  * delta for encoding */
 typedef size_t (*IndexEncoder)(BufferWriter *bw, uint32_t delta, RSIndexResult *record);
@@ -235,14 +396,33 @@ RSIndexResult *IR_Current(void *ctx);
 /* The number of docs in an inverted index entry */
 size_t IR_NumDocs(void *ctx);
 
+/* Whether the reader returns every document of its index, i.e. it filters none of the entries by
+ * their fields or values. The documents are then counted by the index (see InvertedIndex.numDocs) */
+int IR_ReadsWholeIndex(const IndexReader *ir);
+
 /* LastDocId of an inverted index stateful reader */
 t_docId IR_LastDocId(void *ctx);
 
+/* Rewind the reader to the beginning of the index */
+void IR_Rewind(void *ctx);
+
 /* Create a reader iterator that iterates an inverted index record */
 IndexIterator *NewReadIterator(IndexReader *ir);
 
 int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepairParams *params);
 
+/* Remap the ids of the entries of an index to the new ids of their documents (see DocIdRemap).
+ * The entries of documents which are no longer in the table are dropped, along with the blocks
+ * they leave empty. Returns the number of documents dropped. The entries dropped, and the sizes of
+ * the rewritten blocks before and after, are added up in `params` */
+size_t InvertedIndex_Remap(InvertedIndex *idx, const DocIdRemap *remap,
+                           IndexRepairParams *params);
+
+/* Merge the adjacent blocks of an index which fit together in the capacity of the first one, as
+ * left by the repairs of the GC. The last block is still written to, and is not merged. Returns the
+ * number of blocks merged away. The sizes of the blocks before and after are added up in `params` */
+size_t InvertedIndex_MergeBlocks(InvertedIndex *idx, IndexRepairParams *params);
+
 static inline double CalculateIDF(size_t totalDocs, size_t termDocs) {
   return logb(1.0F + totalDocs / (termDocs ? termDocs : (double)1));
 }
@@ -346,6 +346,12 @@ RedisJSON JSONIterable_Next(JSONIterable *iterable) {
     case ITERABLE_ARRAY:
       return japi->getAt(iterable->array.arr, iterable->array.index++);
 
+    case ITERABLE_VALUES:
+      if (iterable->values.index == iterable->values.len) {
+        return NULL;
+      }
+      return iterable->values.vals[iterable->values.index++];
+
     default:
       return NULL;
   }
@@ -510,12 +516,12 @@ int JSON_StoreInDocField(RedisJSON json, JSONType jsonType, FieldSpec *fs, struc
   return rv;
 }
 
-int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len,
-                              FieldSpec *fs, struct DocumentField *df, RedisModuleCtx *ctx) {
+static int JSON_LoadDocumentFieldFromIterable(JSONIterable *iterable, size_t len, FieldSpec *fs,
+                                              struct DocumentField *df) {
   int rv = REDISMODULE_OK;
 
   if (len == 1) {
-    RedisJSON json = japi->next(jsonIter);
+    RedisJSON json = JSONIterable_Next(iterable);
 
     JSONType jsonType = japi->getType(json);
     if (FieldSpec_CheckJsonType(fs->types, jsonType) != REDISMODULE_OK) {
@@ -532,21 +538,29 @@ int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len,
       case INDEXFLD_T_GEO:
         // Handling multiple values as Text
         // (initially GEO is stored as TEXT)
-        rv = JSON_StoreTextInDocFieldFromIter(len, jsonIter, df);
+        rv = JSON_StoreTextInDocField(len, iterable, df);
         break;
       case INDEXFLD_T_NUMERIC:
         // Handling multiple values as Numeric
-        rv = JSON_StoreNumericInDocFieldFromIter(len, jsonIter, df);
+        rv = JSON_StoreNumericInDocField(len, iterable, df);
         break;
       case INDEXFLD_T_VECTOR:;
         // Handling multiple values as Vector
-        rv = JSON_StoreMultiVectorInDocFieldFromIter(fs, jsonIter, len, df);
+        rv = JSON_StoreMultiVectorInDocField(fs, iterable, len, df);
         break;
       default:
         rv = REDISMODULE_ERR;
         break;
     }
   }
+  return rv;
+}
+
+int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len,
+                              FieldSpec *fs, struct DocumentField *df, RedisModuleCtx *ctx) {
+  JSONIterable iterable = (JSONIterable) {.type = ITERABLE_ITER,
+                                          .iter = jsonIter};
+  int rv = JSON_LoadDocumentFieldFromIterable(&iterable, len, fs, df);
 
   df->multisv = NULL;
   // If all is successful up til here,
@@ -558,11 +572,37 @@ int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len,
     // There is no api version (DIALECT) specified during ingestion,
     // So we need to prepare a value using newer api version,
     // in order to be able to handle a query later on with either old or new api version
-    if (jsonIterToValue(ctx, jsonIter, APIVERSION_RETURN_MULTI_CMP_FIRST, &rsv) == REDISMODULE_OK) {
+    if (jsonIterToValue(ctx, jsonIter, APIVERSION_RETURN_MULTI_CMP_FIRST, true, &rsv) ==
+        REDISMODULE_OK) {
+      df->multisv = rsv;
+    } else {
+      rv = REDISMODULE_ERR;
+    }
+  }
+  return rv;
+}
+
+int JSON_LoadDocumentFieldFromValues(const RedisJSON *values, size_t len, FieldSpec *fs,
+                                     struct DocumentField *df, RedisJSON root, RedisModuleCtx *ctx) {
+  JSONIterable iterable = (JSONIterable) {.type = ITERABLE_VALUES,
+                                          .values = {.vals = values, .len = len, .index = 0}};
+  int rv = JSON_LoadDocumentFieldFromIterable(&iterable, len, fs, df);
+
+  df->multisv = NULL;
+  if (rv == REDISMODULE_OK && FieldSpec_IsSortable(fs) && df->unionType == FLD_VAR_T_ARRAY && japi_ver >= 3) {
+    // the sortable value of multiple values is made of their serialization, which only an
+    // iterator provides. Sortable multi-value fields are rare enough to evaluate their path again
+    JSONResultsIterator jsonIter = japi->get(root, fs->path);
+    RSValue *rsv = NULL;
+    if (jsonIter && jsonIterToValue(ctx, jsonIter, APIVERSION_RETURN_MULTI_CMP_FIRST, true,
+                                    &rsv) == REDISMODULE_OK) {
       df->multisv = rsv;
     } else {
       rv = REDISMODULE_ERR;
     }
+    if (jsonIter) {
+      japi->freeIter(jsonIter);
+    }
   }
   return rv;
 }
@@ -24,7 +24,8 @@ struct DocumentField;
 
 typedef enum {
   ITERABLE_ITER = 0,
-  ITERABLE_ARRAY = 1
+  ITERABLE_ARRAY = 1,
+  ITERABLE_VALUES = 2
 } JSONIterableType;
 
 // An adapter for iterator operations, such as `next`, over an underlying container/collection or iterator
@@ -36,6 +37,11 @@ typedef struct {
       RedisJSON arr;
       size_t index;
     } array;
+    struct {
+      const RedisJSON *vals;
+      size_t len;
+      size_t index;
+    } values;
   };
 } JSONIterable;
 
@@ -47,6 +53,10 @@ int GetJSONAPIs(RedisModuleCtx *ctx, int subscribeToModuleChange);
 int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len, FieldSpec *fs,
                            struct DocumentField *df, RedisModuleCtx *ctx);
 
+/* Same as above, from the values of the field extracted from the document `root` */
+int JSON_LoadDocumentFieldFromValues(const RedisJSON *values, size_t len, FieldSpec *fs,
+                                     struct DocumentField *df, RedisJSON root, RedisModuleCtx *ctx);
+
 /* Checks if JSONType fits the FieldType */
 int FieldSpec_CheckJsonType(FieldType fieldType, JSONType type);
 
@@ -0,0 +1,264 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "json_plan.h"
+#include "json.h"
+#include "rmalloc.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+  JSONSTEP_ROOT,
+  JSONSTEP_MEMBER,
+  JSONSTEP_INDEX,
+  JSONSTEP_WILDCARD,
+} JSONStepType;
+
+typedef struct JSONPlanNode {
+  JSONStepType type;  // the step from the parent node to this one
+  char *member;
+  size_t memberLen;
+  long long index;
+
+  arrayof(int) fields;  // the fields whose path ends with this node
+  arrayof(struct JSONPlanNode *) children;
+  bool hasMemberChildren;  // members or wildcards, walked into on objects
+  bool hasIndexChildren;   // indexes or wildcards, walked into on arrays
+} JSONPlanNode;
+
+struct JSONPlan {
+  JSONPlanNode *root;
+  int numFields;
+  bool *compiled;  // per field, whether its path is in the trie
+};
+
+typedef struct {
+  JSONStepType type;
+  const char *member;
+  size_t memberLen;
+  long long index;
+} JSONStep;
+
+/* Parse the next step of a path at `*p`. Returns false if it is not a simple step */
+static bool parseStep(const char **p, JSONStep *step) {
+  const char *s = *p;
+  if (*s == '.') {
+    ++s;
+    if (*s == '*') {
+      step->type = JSONSTEP_WILDCARD;
+      *p = s + 1;
+      return true;
+    }
+    const char *start = s;
+    while (isalnum((unsigned char)*s) || *s == '_') {
+      ++s;
+    }
+    if (s == start) {
+      // a recursive descent, or not a simple member name
+      return false;
+    }
+    step->type = JSONSTEP_MEMBER;
+    step->member = start;
+    step->memberLen = s - start;
+    *p = s;
+    return true;
+  }
+
+  if (*s != '[') {
+    return false;
+  }
+  ++s;
+  if (*s == '*') {
+    step->type = JSONSTEP_WILDCARD;
+    ++s;
+  } else if (*s == '\'' || *s == '"') {
+    char quote = *s++;
+    const char *start = s;
+    while (*s && *s != quote) {
+      if (*s == '\\') {
+        return false;
+      }
+      ++s;
+    }
+    if (!*s) {
+      return false;
+    }
+    step->type = JSONSTEP_MEMBER;
+    step->member = start;
+    step->memberLen = s - start;
+    ++s;
+  } else if (*s == '-' || isdigit((unsigned char)*s)) {
+    char *end;
+    step->type = JSONSTEP_INDEX;
+    step->index = strtoll(s, &end, 10);
+    if (end == s || (*s == '-' && end == s + 1)) {
+      return false;
+    }
+    s = end;
+  } else {
+    return false;
+  }
+  if (*s != ']') {
+    // a union, a slice or a filter
+    return false;
+  }
+  *p = s + 1;
+  return true;
+}
+
+static JSONPlanNode *newNode(JSONStepType type) {
+  JSONPlanNode *node = rm_calloc(1, sizeof(*node));
+  node->type = type;
+  node->fields = array_new(int, 1);
+  node->children = array_new(JSONPlanNode *, 1);
+  return node;
+}
+
+static JSONPlanNode *getChild(JSONPlanNode *node, const JSONStep *step) {
+  for (size_t ii = 0; ii < array_len(node->children); ++ii) {
+    JSONPlanNode *child = node->children[ii];
+    if (child->type != step->type) {
+      continue;
+    }
+    if ((step->type == JSONSTEP_WILDCARD) ||
+        (step->type == JSONSTEP_INDEX && child->index == step->index) ||
+        (step->type == JSONSTEP_MEMBER && child->memberLen == step->memberLen &&
+         !memcmp(child->member, step->member, step->memberLen))) {
+      return child;
+    }
+  }
+
+  JSONPlanNode *child = newNode(step->type);
+  if (step->type == JSONSTEP_MEMBER) {
+    child->member = rm_strndup(step->member, step->memberLen);
+    child->memberLen = step->memberLen;
+  } else if (step->type == JSONSTEP_INDEX) {
+    child->index = step->index;
+  }
+  node->hasMemberChildren |= step->type != JSONSTEP_INDEX;
+  node->hasIndexChildren |= step->type != JSONSTEP_MEMBER;
+  node->children = array_append(node->children, child);
+  return child;
+}
+
+/* Add the path to the trie, if it is only made of simple steps */
+static bool addPath(JSONPlanNode *root, const char *path, int field) {
+  if (!path || path[0] != '$') {
+    // a legacy path
+    return false;
+  }
+  // validate the whole path before adding any of its steps
+  const char *p = path + 1;
+  JSONStep step;
+  while (*p) {
+    if (!parseStep(&p, &step)) {
+      return false;
+    }
+  }
+
+  JSONPlanNode *node = root;
+  for (p = path + 1; *p;) {
+    parseStep(&p, &step);
+    node = getChild(node, &step);
+  }
+  node->fields = array_append(node->fields, field);
+  return true;
+}
+
+JSONPlan *JSONPlan_New(const FieldSpec *fields, int numFields) {
+  JSONPlan *plan = rm_malloc(sizeof(*plan));
+  plan->root = newNode(JSONSTEP_ROOT);
+  plan->numFields = numFields;
+  plan->compiled = rm_calloc(numFields ? numFields : 1, sizeof(*plan->compiled));
+  if (japi_ver >= 4) {
+    for (int ii = 0; ii < numFields; ++ii) {
+      plan->compiled[ii] = addPath(plan->root, fields[ii].path, ii);
+    }
+  }
+  return plan;
+}
+
+int JSONPlan_NumFields(const JSONPlan *plan) {
+  return plan->numFields;
+}
+
+bool JSONPlan_HasField(const JSONPlan *plan, int field) {
+  return field < plan->numFields && plan->compiled[field];
+}
+
+static void walk(const JSONPlanNode *node, RedisJSON json, arrayof(RedisJSON) *values) {
+  for (size_t ii = 0; ii < array_len(node->fields); ++ii) {
+    int field = node->fields[ii];
+    if (!values[field]) {
+      values[field] = array_new(RedisJSON, 1);
+    }
+    values[field] = array_append(values[field], json);
+  }
+
+  size_t nchildren = array_len(node->children);
+  if (!nchildren) {
+    return;
+  }
+  JSONType type = japi->getType(json);
+  if (type == JSONType_Object && node->hasMemberChildren) {
+    // the only way to get the members of an object through the API, without parsing a path
+    JSONKeyValuesIterator iter = japi->getKeyValues(json);
+    RedisModuleString *keyName;
+    RedisJSON value;
+    while ((value = japi->nextKeyValue(iter, &keyName))) {
+      size_t len;
+      const char *name = RedisModule_StringPtrLen(keyName, &len);
+      for (size_t ii = 0; ii < nchildren; ++ii) {
+        const JSONPlanNode *child = node->children[ii];
+        if (child->type == JSONSTEP_WILDCARD ||
+            (child->type == JSONSTEP_MEMBER && child->memberLen == len &&
+             !memcmp(child->member, name, len))) {
+          walk(child, value, values);
+        }
+      }
+      RedisModule_FreeString(NULL, keyName);
+    }
+    japi->freeKeyValuesIter(iter);
+  } else if (type == JSONType_Array && node->hasIndexChildren) {
+    size_t len;
+    japi->getLen(json, &len);
+    for (size_t ii = 0; ii < nchildren; ++ii) {
+      const JSONPlanNode *child = node->children[ii];
+      if (child->type == JSONSTEP_WILDCARD) {
+        for (size_t jj = 0; jj < len; ++jj) {
+          walk(child, japi->getAt(json, jj), values);
+        }
+      } else if (child->type == JSONSTEP_INDEX) {
+        long long index = child->index < 0 ? (long long)len + child->index : child->index;
+        if (index >= 0 && index < (long long)len) {
+          walk(child, japi->getAt(json, index), values);
+        }
+      }
+    }
+  }
+}
+
+void JSONPlan_Eval(const JSONPlan *plan, RedisJSON root, arrayof(RedisJSON) *values) {
+  walk(plan->root, root, values);
+}
+
+static void freeNode(JSONPlanNode *node) {
+  for (size_t ii = 0; ii < array_len(node->children); ++ii) {
+    freeNode(node->children[ii]);
+  }
+  array_free(node->children);
+  array_free(node->fields);
+  rm_free(node->member);
+  rm_free(node);
+}
+
+void JSONPlan_Free(JSONPlan *plan) {
+  freeNode(plan->root);
+  rm_free(plan->compiled);
+  rm_free(plan);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "rejson_api.h"
+#include "field_spec.h"
+#include "util/arr.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The JSONPaths of the fields of a JSON index, merged into a trie of their steps, so that the
+ * values of all the fields are extracted from a document in a single walk of it, instead of a
+ * traversal of the document per field.
+ *
+ * Only paths made of member (`.a`, `['a']`), index (`[1]`, `[-1]`) and wildcard (`.*`, `[*]`)
+ * steps from the root are compiled into the plan. The values of the other fields (legacy paths,
+ * recursive descents, filters, slices and unions) are still extracted through the RedisJSON API.
+ * The plan is only used with the RedisJSON API version 4 or later, which iterates the members of
+ * objects */
+typedef struct JSONPlan JSONPlan;
+
+/* Compile the paths of the fields of a spec */
+JSONPlan *JSONPlan_New(const FieldSpec *fields, int numFields);
+
+/* The number of fields the plan was compiled for */
+int JSONPlan_NumFields(const JSONPlan *plan);
+
+/* Whether the values of the field are extracted by the plan */
+bool JSONPlan_HasField(const JSONPlan *plan, int field);
+
+/* Append the values each path of the plan matches in the document to `values[field]`, in the
+ * order RedisJSON returns them. `values` has an array (possibly NULL) for every field of the plan */
+void JSONPlan_Eval(const JSONPlan *plan, RedisJSON root, arrayof(RedisJSON) *values);
+
+void JSONPlan_Free(JSONPlan *plan);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "latency_stats.h"
+#include "rmalloc.h"
+
+#include <stdio.h>
+
+LatencyStats globalLatencyStats_g = {0};
+
+static const char *commandNames[LATENCY_CMD_COUNT] = {
+    [LATENCY_CMD_SEARCH] = "search",         [LATENCY_CMD_AGGREGATE] = "aggregate",
+    [LATENCY_CMD_CURSOR_READ] = "cursor_read", [LATENCY_CMD_SUGGET] = "sugget",
+    [LATENCY_CMD_SPELLCHECK] = "spellcheck", [LATENCY_CMD_INDEXING] = "indexing",
+    [LATENCY_CMD_GC] = "gc",                 [LATENCY_CMD_COORD_SEARCH] = "coord_search",
+};
+
+static const char *phaseNames[LATENCY_PHASE_COUNT] = {
+    [LATENCY_PHASE_QUEUE] = "queue",
+    [LATENCY_PHASE_EXEC] = "execution",
+    [LATENCY_PHASE_REPLY] = "reply",
+    [LATENCY_PHASE_DISPATCH] = "dispatch",
+    [LATENCY_PHASE_SLOWEST_SHARD] = "slowest_shard",
+    [LATENCY_PHASE_MERGE] = "merge",
+    [LATENCY_PHASE_TOTAL] = "total",
+};
+
+static const struct {
+  const char *name;
+  double percent;
+} percentiles[] = {{"p50", 50}, {"p90", 90}, {"p99", 99}, {"p999", 99.9}};
+
+static inline LatencyHistogram *getHist(const LatencyStats *ls, LatencyCommand cmd,
+                                        LatencyPhase phase) {
+  return __atomic_load_n(&ls->hists[cmd][phase], __ATOMIC_ACQUIRE);
+}
+
+static void latencyStats_Record(LatencyStats *ls, LatencyCommand cmd, LatencyPhase phase,
+                                uint64_t usec) {
+  LatencyHistogram *h = getHist(ls, cmd, phase);
+  if (!h) {
+    // the commands of an index may run on several threads at once, the first one wins
+    LatencyHistogram *expected = NULL;
+    h = rm_calloc(1, sizeof(*h));
+    if (!__atomic_compare_exchange_n(&ls->hists[cmd][phase], &expected, h, 0, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+      rm_free(h);
+      h = expected;
+    }
+  }
+  LatencyHistogram_Record(h, usec);
+}
+
+void LatencyStats_Record(LatencyStats *ls, LatencyCommand cmd, LatencyPhase phase, double ms) {
+  uint64_t usec = ms > 0 ? ms * 1000 : 0;
+  if (ls) {
+    latencyStats_Record(ls, cmd, phase, usec);
+  }
+  latencyStats_Record(&globalLatencyStats_g, cmd, phase, usec);
+}
+
+void LatencyStats_RecordQuery(LatencyStats *ls, LatencyCommand cmd, double queue, double exec,
+                              double reply) {
+  LatencyStats_Record(ls, cmd, LATENCY_PHASE_QUEUE, queue);
+  LatencyStats_Record(ls, cmd, LATENCY_PHASE_EXEC, exec);
+  LatencyStats_Record(ls, cmd, LATENCY_PHASE_REPLY, reply);
+  LatencyStats_Record(ls, cmd, LATENCY_PHASE_TOTAL, queue + exec + reply);
+}
+
+void LatencyStats_Reset(LatencyStats *ls) {
+  for (int c = 0; c < LATENCY_CMD_COUNT; c++) {
+    for (int p = 0; p < LATENCY_PHASE_COUNT; p++) {
+      LatencyHistogram *h = getHist(ls, c, p);
+      if (h) {
+        LatencyHistogram_Reset(h);
+      }
+    }
+  }
+}
+
+void LatencyStats_Free(LatencyStats *ls) {
+  for (int c = 0; c < LATENCY_CMD_COUNT; c++) {
+    for (int p = 0; p < LATENCY_PHASE_COUNT; p++) {
+      rm_free(ls->hists[c][p]);
+      ls->hists[c][p] = NULL;
+    }
+  }
+}
+
+static bool commandIsEmpty(const LatencyStats *ls, LatencyCommand cmd) {
+  for (int p = 0; p < LATENCY_PHASE_COUNT; p++) {
+    LatencyHistogram *h = getHist(ls, cmd, p);
+    if (h && LatencyHistogram_Count(h)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LatencyStats_IsEmpty(const LatencyStats *ls) {
+  for (int c = 0; c < LATENCY_CMD_COUNT; c++) {
+    if (!commandIsEmpty(ls, c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LatencyStats_Reply(const LatencyStats *ls, RedisModule_Reply *reply) {
+  RedisModule_Reply_Map(reply);
+  for (int c = 0; c < LATENCY_CMD_COUNT; c++) {
+    if (commandIsEmpty(ls, c)) {
+      continue;
+    }
+    RedisModule_ReplyKV_Map(reply, commandNames[c]);
+    for (int p = 0; p < LATENCY_PHASE_COUNT; p++) {
+      LatencyHistogram *h = getHist(ls, c, p);
+      if (!h || !LatencyHistogram_Count(h)) {
+        continue;
+      }
+      RedisModule_ReplyKV_Map(reply, phaseNames[p]);
+      RedisModule_ReplyKV_LongLong(reply, "count", LatencyHistogram_Count(h));
+      for (size_t i = 0; i < sizeof(percentiles) / sizeof(*percentiles); i++) {
+        RedisModule_ReplyKV_Double(reply, percentiles[i].name,
+                                   LatencyHistogram_Percentile(h, percentiles[i].percent) / 1000.0);
+      }
+      RedisModule_Reply_MapEnd(reply);
+    }
+    RedisModule_Reply_MapEnd(reply);
+  }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+void LatencyStats_AddToInfo(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "latency");
+  for (int c = 0; c < LATENCY_CMD_COUNT; c++) {
+    for (int p = 0; p < LATENCY_PHASE_COUNT; p++) {
+      LatencyHistogram *h = getHist(&globalLatencyStats_g, c, p);
+      if (!h || !LatencyHistogram_Count(h)) {
+        continue;
+      }
+      char name[64];
+      snprintf(name, sizeof(name), "%s_%s", commandNames[c], phaseNames[p]);
+      RedisModule_InfoBeginDictField(ctx, name);
+      RedisModule_InfoAddFieldULongLong(ctx, "count", LatencyHistogram_Count(h));
+      for (size_t i = 0; i < sizeof(percentiles) / sizeof(*percentiles); i++) {
+        RedisModule_InfoAddFieldDouble(ctx, percentiles[i].name,
+                                       LatencyHistogram_Percentile(h, percentiles[i].percent) / 1000.0);
+      }
+      RedisModule_InfoEndDictField(ctx);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+#include "reply.h"
+#include "util/latency_histogram.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  LATENCY_CMD_SEARCH,
+  LATENCY_CMD_AGGREGATE,
+  LATENCY_CMD_CURSOR_READ,
+  LATENCY_CMD_SUGGET,
+  LATENCY_CMD_SPELLCHECK,
+  LATENCY_CMD_INDEXING,      // per document
+  LATENCY_CMD_GC,            // per cycle
+  LATENCY_CMD_COORD_SEARCH,  // FT.SEARCH on the coordinator
+  LATENCY_CMD_COUNT
+} LatencyCommand;
+
+typedef enum {
+  LATENCY_PHASE_QUEUE,          // waiting in the queue of the workers
+  LATENCY_PHASE_EXEC,           // parsing and reading the results
+  LATENCY_PHASE_REPLY,          // serializing the results
+  LATENCY_PHASE_DISPATCH,       // coordinator: parsing and sending to the shards
+  LATENCY_PHASE_SLOWEST_SHARD,  // coordinator: from the dispatch to the last shard reply
+  LATENCY_PHASE_MERGE,          // coordinator: merging the shard replies
+  LATENCY_PHASE_TOTAL,
+  LATENCY_PHASE_COUNT
+} LatencyPhase;
+
+/* The latency histograms of the commands run on an index, or of the whole module. The histograms
+ * are allocated on the first latency recorded to them, since most of the pairs of command and
+ * phase are never recorded */
+typedef struct {
+  LatencyHistogram *hists[LATENCY_CMD_COUNT][LATENCY_PHASE_COUNT];
+} LatencyStats;
+
+// The latencies of all the indexes, reported by INFO
+extern LatencyStats globalLatencyStats_g;
+
+/* Record a latency of `ms` milliseconds to `ls`, which may be NULL, and to the global stats */
+void LatencyStats_Record(LatencyStats *ls, LatencyCommand cmd, LatencyPhase phase, double ms);
+
+/* Record the phases of a query along with their total */
+void LatencyStats_RecordQuery(LatencyStats *ls, LatencyCommand cmd, double queue, double exec,
+                              double reply);
+
+void LatencyStats_Reset(LatencyStats *ls);
+
+void LatencyStats_Free(LatencyStats *ls);
+
+bool LatencyStats_IsEmpty(const LatencyStats *ls);
+
+/* Reply with a map of the recorded commands, each a map of its recorded phases to their count and
+ * their p50, p90, p99 and p999 in milliseconds */
+void LatencyStats_Reply(const LatencyStats *ls, RedisModule_Reply *reply);
+
+/* Add the global stats to INFO as a `latency` section */
+void LatencyStats_AddToInfo(RedisModuleInfoCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
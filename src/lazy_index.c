@@ -0,0 +1,88 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "lazy_index.h"
+#include "spec.h"
+#include "rmalloc.h"
+#include "rmutil/cxx/chrono-clock.h"
+
+struct LazyIndex {
+  // Written under the GIL, read by the workers without it
+  bool loaded;
+  size_t loads;
+  size_t evictions;
+  long long lastLoadMs;
+};
+
+void LazyIndex_Init(IndexSpec *sp) {
+  if (!sp->lazy) {
+    sp->lazy = rm_calloc(1, sizeof(*sp->lazy));
+  }
+}
+
+bool LazyIndex_IsLoaded(const IndexSpec *sp) {
+  return !sp->lazy || __atomic_load_n(&sp->lazy->loaded, __ATOMIC_ACQUIRE);
+}
+
+void LazyIndex_Load(RedisModuleCtx *ctx, StrongRef spec_ref) {
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  LazyIndex *li = sp->lazy;
+  if (LazyIndex_IsLoaded(sp)) {
+    return;
+  }
+
+  hires_clock_t t0;
+  hires_clock_get(&t0);
+  // Set first, so that the writes to the keys of the index are indexed from now on
+  __atomic_store_n(&li->loaded, true, __ATOMIC_RELEASE);
+  IndexSpec_ScanAndReindexSync(ctx, spec_ref);
+  li->lastLoadMs = hires_clock_since_msec(&t0);
+  li->loads++;
+  RedisModule_Log(ctx, "verbose", "Loaded lazy index %s in %lld ms", sp->name, li->lastLoadMs);
+}
+
+void LazyIndex_EnsureLoaded(StrongRef spec_ref) {
+  if (LazyIndex_IsLoaded(StrongRef_Get(spec_ref))) {
+    return;
+  }
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  RedisModule_ThreadSafeContextLock(ctx);
+  LazyIndex_Load(ctx, spec_ref);
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  RedisModule_FreeThreadSafeContext(ctx);
+}
+
+bool LazyIndex_Evict(IndexSpec *sp) {
+  LazyIndex *li = sp->lazy;
+  if (!LazyIndex_IsLoaded(sp)) {
+    return true;
+  }
+  if (sp->activeCursors || sp->scan_in_progress || (sp->flags & Index_HasVecSim)) {
+    return false;
+  }
+
+  __atomic_store_n(&li->loaded, false, __ATOMIC_RELEASE);
+  IndexSpec_ClearContents(sp);
+  li->evictions++;
+  RedisModule_Log(NULL, "verbose", "Evicted idle lazy index %s", sp->name);
+  return true;
+}
+
+LazyIndexStats LazyIndex_GetStats(const IndexSpec *sp) {
+  LazyIndexStats stats = {.loaded = LazyIndex_IsLoaded(sp)};
+  const LazyIndex *li = sp->lazy;
+  if (li) {
+    stats.loads = li->loads;
+    stats.evictions = li->evictions;
+    stats.lastLoadMs = li->lastLoadMs;
+  }
+  return stats;
+}
+
+void LazyIndex_Free(IndexSpec *sp) {
+  rm_free(sp->lazy);
+  sp->lazy = NULL;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+#include "util/references.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* The load state of an index created with LAZY. Such an index holds no contents until it is first
+ * accessed: it is created, and loaded from the RDB, evicted. The keyspace is its persistent form -
+ * loading it scans the keys of the index at once, on the main thread, and it does not index the
+ * writes to its keys while it is evicted.
+ *
+ * Every access resets its idle timer (the timer of the TEMPORARY indexes), and once it fires the
+ * contents of the index are freed, keeping its definition. The eviction is deferred to the next
+ * timeout while cursors are open on the index or it is scanned, and indexes with vector fields are
+ * never evicted, as their indexes are referenced by the jobs of the workers */
+typedef struct LazyIndex LazyIndex;
+
+typedef struct {
+  bool loaded;
+  size_t loads;            // times the index was loaded since it was created or loaded
+  size_t evictions;        // times it was evicted
+  long long lastLoadMs;    // how long its last load took
+} LazyIndexStats;
+
+/* Create the load state of an index with LAZY, evicted */
+void LazyIndex_Init(struct IndexSpec *sp);
+
+/* Whether the index holds its contents. Always true for an index without LAZY */
+bool LazyIndex_IsLoaded(const struct IndexSpec *sp);
+
+/* Load an evicted index by scanning its keys. Called with the GIL held */
+void LazyIndex_Load(RedisModuleCtx *ctx, StrongRef spec_ref);
+
+/* Load an index a query is about to run on, which was evicted while the query was queued to the
+ * workers. Called without the GIL, and without the spec locked */
+void LazyIndex_EnsureLoaded(StrongRef spec_ref);
+
+/* Free the contents of an idle index. Returns false if it cannot be evicted now. Called from its
+ * idle timer */
+bool LazyIndex_Evict(struct IndexSpec *sp);
+
+LazyIndexStats LazyIndex_GetStats(const struct IndexSpec *sp);
+
+void LazyIndex_Free(struct IndexSpec *sp);
+
+#ifdef __cplusplus
+}
+#endif
@@ -145,6 +145,7 @@ IndexIterator *NewMetricIterator(t_docId *ids_list, double *metric_list, Metric
   ri->Rewind = MR_Rewind;
   ri->Free = MR_Free;
   ri->HasNext = MR_HasNext;
+  ri->ReadBatch = NULL;
   ri->NumEstimated = ri->Len = MR_Len;
   ri->Abort = MR_Abort;
   ri->LastDocId = MR_LastDocId;
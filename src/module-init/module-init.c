@@ -8,6 +8,12 @@
 #include "module.h"
 #include "version.h"
 #include "config.h"
+#include "stemmer.h"
+#include "index_segments.h"
+#include "index_buffers.h"
+#include "latency_stats.h"
+#include "alloc_stats.h"
+#include "index_persistence.h"
 #include "redisearch_api.h"
 #include <assert.h>
 #include <ctype.h>
@@ -18,10 +24,10 @@
 #include "notifications.h"
 #include "aggregate/aggregate.h"
 #include "ext/default.h"
-#include "rwlock.h"
 #include "json.h"
 #include "VecSim/vec_sim.h"
 #include "util/workers.h"
+#include "util/coarse_clock.h"
 
 #ifndef RS_NO_ONLOAD
 int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
@@ -136,9 +142,32 @@ void RS_moduleInfoFunc(RedisModuleInfoCtx *ctx, int for_crash_report) {
   // Dialect statistics
   DialectsGlobalStats_AddToInfo(ctx);
 
+  // Stemmer cache statistics
+  StemmerCache_AddToInfo(ctx);
+
+  // Latencies of the commands
+  LatencyStats_AddToInfo(ctx);
+
+  // Allocations by subsystem, if built with them
+  AllocStats_AddToInfo(ctx);
+
+  // Index segments statistics
+  IndexSegments_AddToInfo(ctx);
+
+  // Size classes of the index block buffers
+  IndexBuffers_AddToInfo(ctx);
+
+  // Restored indexes statistics
+  IndexPersistence_AddToInfo(ctx);
+
   // Run time configuration
   RSConfig_AddToInfo(ctx);
 
+#ifdef MT_BUILD
+  // Workers queues
+  workersThreadPool_AddToInfo(ctx);
+#endif
+
   #ifdef FTINFO_FOR_INFO_MODULES
   // FT.INFO for some of the indexes
   dictIterator *iter = dictGetIterator(specDict_g);
@@ -174,10 +203,6 @@ int RediSearch_Init(RedisModuleCtx *ctx, int mode) {
     }                                               \
   } while (false)
 
-  if (RediSearch_LockInit(ctx) != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-
   // Print version string!
   DO_LOG("notice", "RediSearch version %d.%d.%d (Git=%s)", REDISEARCH_VERSION_MAJOR,
          REDISEARCH_VERSION_MINOR, REDISEARCH_VERSION_PATCH, RS_GetExtraVersion());
@@ -215,6 +240,10 @@ int RediSearch_Init(RedisModuleCtx *ctx, int mode) {
   CleanPool_ThreadPoolStart();
   DO_LOG("notice", "Initialized thread pools!");
 
+  if (CoarseClock_Start() != REDISMODULE_OK) {
+    DO_LOG("warning", "Failed to start the coarse clock thread, the timeouts read the clock");
+  }
+
 #ifdef MT_BUILD
   // Init threadpool.
   // Threadpool size can only be set on load.
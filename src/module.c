@@ -25,6 +25,7 @@
 #include "util/logging.h"
 #include "util/workers.h"
 #include "util/references.h"
+#include "util/coarse_clock.h"
 #include "config.h"
 #include "aggregate/aggregate.h"
 #include "rmalloc.h"
@@ -37,12 +38,18 @@
 #include "redisearch_api.h"
 #include "alias.h"
 #include "module.h"
-#include "rwlock.h"
 #include "info_command.h"
 #include "rejson_api.h"
 #include "geometry/geometry_api.h"
 #include "reply.h"
 #include "resp3.h"
+#include "index_export.h"
+#include "slow_log.h"
+#include "prepared_query.h"
+#include "latency_stats.h"
+#include "trie/levenshtein.h"
+#include "cold_block_cache.h"
+#include "index_buffers.h"
 
 
 /* FT.MGET {index} {key} ...
@@ -63,17 +70,8 @@ int GetDocumentsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     return RedisModule_ReplyWithError(ctx, "Unknown Index name");
   }
 
-  const DocTable *dt = &sctx->spec->docs;
   RedisModule_ReplyWithArray(ctx, argc - 2);
-  for (size_t i = 2; i < argc; i++) {
-
-    if (DocTable_GetIdR(dt, argv[i]) == 0) {
-      // Document does not exist in index; even though it exists in keyspace
-      RedisModule_ReplyWithNull(ctx);
-      continue;
-    }
-    Document_ReplyAllFields(ctx, sctx->spec, argv[i]);
-  }
+  Document_ReplyAllFieldsOfKeys(ctx, sctx->spec, argv + 2, argc - 2);
 
   SearchCtx_Free(sctx);
 
@@ -138,6 +136,8 @@ int SpellCheckCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (sctx == NULL) {
     return RedisModule_ReplyWithError(ctx, "Unknown Index name");
   }
+  hires_clock_t t0;
+  hires_clock_get(&t0);
   QueryError status = {0};
   size_t len;
   const char *rawQuery = RedisModule_StringPtrLen(argv[2], &len);
@@ -203,6 +203,9 @@ int SpellCheckCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
                          .fullScoreInfo = fullScoreInfo};
 
   SpellCheck_Reply(&scCtx, &qast);
+  // the suggestions of a term are looked up as they are replied, they are not timed apart
+  LatencyStats_Record(&sctx->spec->latency, LATENCY_CMD_SPELLCHECK, LATENCY_PHASE_TOTAL,
+                      hires_clock_since_msec(&t0));
 
 end:
   QueryError_ClearError(&status);
@@ -218,7 +221,7 @@ end:
 }
 
 char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                          QueryError *status);
+                          bool withPlan, QueryError *status);
 
 static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                               int newlinesAsElements) {
@@ -226,7 +229,19 @@ static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
     return RedisModule_WrongArity(ctx);
   }
   QueryError status = {0};
-  char *explainRoot = RS_GetExplainOutput(ctx, argv, argc, &status);
+  // WITHPLAN may come anywhere after the query, the rest of the arguments are the query's
+  int withPlan = RMUtil_ArgExists("WITHPLAN", argv, argc, 3);
+  RedisModuleString **args = argv;
+  if (withPlan) {
+    args = rm_malloc(sizeof(*args) * (argc - 1));
+    memcpy(args, argv, sizeof(*args) * withPlan);
+    memcpy(args + withPlan, argv + withPlan + 1, sizeof(*args) * (argc - withPlan - 1));
+    argc--;
+  }
+  char *explainRoot = RS_GetExplainOutput(ctx, args, argc, withPlan, &status);
+  if (args != argv) {
+    rm_free(args);
+  }
   if (!explainRoot) {
     return QueryError_ReplyAndClear(ctx, &status);
   }
@@ -248,7 +263,7 @@ static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
   return REDISMODULE_OK;
 }
 
-/* FT.EXPLAIN {index_name} {query} */
+/* FT.EXPLAIN {index_name} {query} [WITHPLAN] */
 int QueryExplainCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return queryExplainCommon(ctx, argv, argc, 0);
 }
@@ -293,15 +308,23 @@ int DeleteCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
-/* FT.TAGVALS {idx} {field}
- * Return all the values of a tag field.
- * There is no sorting or paging, so be careful with high-cradinality tag fields */
+/* FT.TAGVALS {idx} {field} [PREFIX {prefix}] [AFTER {value}] [LIMIT {offset} {num}] [WITHCOUNTS]
+ * Return the values of a tag field, in the order of its index, all of them in a set without any
+ * option. With the options they are replied in an array, a page following the value AFTER
+ * starting where the previous one ended, each value followed by its number of documents with
+ * WITHCOUNTS */
 
 int TagValsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-  // at least one field, and number of field/text args must be even
-  if (argc != 3) {
+  if (argc < 3) {
     return RedisModule_WrongArity(ctx);
   }
+  TagValsOptions opts = {0};
+  QueryError status = {0};
+  ArgsCursor ac;
+  ArgsCursor_InitRString(&ac, argv + 3, argc - 3);
+  if (TagValsOptions_Parse(&ac, &opts, &status) != REDISMODULE_OK) {
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
 
   RedisSearchCtx *sctx = NewSearchCtx(ctx, argv[1], true);
   if (sctx == NULL) {
@@ -324,11 +347,15 @@ int TagValsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   TagIndex *idx = TagIndex_Open(sctx, rstr, 0, NULL);
   RedisModule_FreeString(ctx, rstr);
   if (!idx) {
-    RedisModule_ReplyWithSetOrArray(ctx, 0);
+    if (opts.ordered) {
+      RedisModule_ReplyWithArray(ctx, 0);
+    } else {
+      RedisModule_ReplyWithSetOrArray(ctx, 0);
+    }
     goto cleanup;
   }
 
-  TagIndex_SerializeValues(idx, ctx);
+  TagIndex_SerializeValues(idx, ctx, &opts);
 
 cleanup:
   SearchCtx_Free(sctx);
@@ -422,7 +449,11 @@ int DropIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   }
 
   const char* spec_name = RedisModule_StringPtrLen(argv[1], NULL);
-  StrongRef global_ref = IndexSpec_LoadUnsafe(ctx, spec_name, 0);
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = spec_name},
+      .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef global_ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(global_ref);
   if (!sp) {
     return RedisModule_ReplyWithError(ctx, "Unknown Index name");
@@ -470,13 +501,81 @@ int DropIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return RedisModule_ReplyWithSimpleString(ctx, "OK");
 }
 
+/*
+ * FT.REPLACEINDEX <index> <replacement>
+ * Moves all the aliases of an index to its replacement and drops the index, keeping its documents.
+ * An index is rebuilt under a new name while its alias keeps serving the queries, and replaced at
+ * once when it is ready. The dropped index is freed in the background.
+ */
+int ReplaceIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+
+  int flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING | INDEXSPEC_LOAD_NOALIAS |
+              INDEXSPEC_LOAD_NOLAZYLOAD;
+  IndexLoadOptions loadOpts = {.name = {.rstring = argv[1]}, .flags = flags};
+  IndexLoadOptions replacementOpts = {.name = {.rstring = argv[2]}, .flags = flags};
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
+  StrongRef replacement_ref = IndexSpec_LoadUnsafeEx(ctx, &replacementOpts);
+  if (!StrongRef_Get(ref) || !StrongRef_Get(replacement_ref)) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+  if (StrongRef_Equals(ref, replacement_ref)) {
+    return RedisModule_ReplyWithError(ctx, "An index cannot replace itself");
+  }
+
+  IndexSpec_MoveAliases(ref, replacement_ref);
+  IndexSpec_RemoveFromGlobals(ref);
+
+  RedisModule_ReplicateVerbatim(ctx);
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/*
+ * FT.EXPORT <index> <path>
+ * Writes the definition and the contents of an index to a file, which FT.IMPORT creates the index
+ * from on another server. The file is written by a forked child, the reply is sent once it exits.
+ */
+int ExportIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+
+  IndexLoadOptions loadOpts = {
+      .name = {.rstring = argv[1]},
+      .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  IndexSpec *sp = StrongRef_Get(IndexSpec_LoadUnsafeEx(ctx, &loadOpts));
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+  return IndexExport_Export(ctx, sp, RedisModule_StringPtrLen(argv[2], NULL));
+}
+
+/*
+ * FT.IMPORT <path>
+ * Creates an index from a file written by FT.EXPORT, under the name it was exported with, without
+ * indexing the keys again. The documents of the keys which no longer exist are dropped.
+ */
+int ImportIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  return IndexExport_Import(ctx, RedisModule_StringPtrLen(argv[1], NULL));
+}
+
 int DropIfExistsIndexCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   // at least one field, and number of field/text args must be even
   if (argc < 2 || argc > 3) {
     return RedisModule_WrongArity(ctx);
   }
 
-  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = RedisModule_StringPtrLen(argv[1], NULL)},
+      .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
     return RedisModule_ReplyWithSimpleString(ctx, "OK");
@@ -517,7 +616,11 @@ int SynUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   const char *id = RedisModule_StringPtrLen(argv[2], NULL);
 
-  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = RedisModule_StringPtrLen(argv[1], NULL)},
+      .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
     return RedisModule_ReplyWithError(ctx, "Unknown index name");
@@ -536,11 +639,25 @@ int SynUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   IndexSpec_InitializeSynonym(sp);
 
+  // The group is indexed along with its synonyms, so only the documents with the synonyms which
+  // are new to it are reindexed
+  const char **added = array_new(const char *, argc - offset);
+  for (int i = offset; i < argc; ++i) {
+    const char *term = RedisModule_StringPtrLen(argv[i], NULL);
+    if (!SynonymMap_InGroup(sp->smap, term, id)) {
+      char *lower = rm_strdup(term);
+      strtolower(lower);
+      added = array_append(added, lower);
+    }
+  }
+
   SynonymMap_UpdateRedisStr(sp->smap, argv + offset, argc - offset, id);
 
-  if (initialScan) {
-    IndexSpec_ScanAndReindex(ctx, ref);
+  // an evicted lazy index is scanned with the synonyms once it is loaded
+  if (initialScan && LazyIndex_IsLoaded(sp) && array_len(added)) {
+    IndexSpec_ReindexTermsDocs(ctx, ref, added, array_len(added));
   }
+  array_free_ex(added, rm_free(*(char **)ptr));
 
   RedisSearchCtx_UnlockSpec(&sctx);
 
@@ -550,6 +667,146 @@ int SynUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
+/**
+ * FT.SYNC <index>
+ *
+ * Index the keys queued by an index created with ASYNCUPDATES, so that the following queries
+ * see all the writes which preceded the command.
+ */
+int SyncCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) return RedisModule_WrongArity(ctx);
+
+  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  AsyncUpdates_Drain(sp, ctx);
+
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * FT.WARMUP <index>
+ *
+ * Load an index created with LAZY now, rather than on its first query, and reset its idle timeout.
+ * Does nothing more than that for an index which is already loaded, or not lazy.
+ */
+int WarmupCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) return RedisModule_WrongArity(ctx);
+
+  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  if (!StrongRef_Get(ref)) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * FT._TERMSTATS <index> [term ...]
+ *
+ * Reply with the local statistics the coordinator merges into the statistics of the cluster: the
+ * number of documents, their total length, the number of documents of every given term, and the
+ * terms the queries looked up since the previous call.
+ */
+int TermStatsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2) return RedisModule_WrongArity(ctx);
+
+  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisSearchCtx_LockSpecRead(&sctx);
+
+  RedisModule_ReplyWithArray(ctx, 4);
+  RedisModule_ReplyWithLongLong(ctx, sp->stats.numDocuments);
+  RedisModule_ReplyWithLongLong(ctx, sp->stats.totalDocsLen);
+  RedisModule_ReplyWithArray(ctx, argc - 2);
+  for (int i = 2; i < argc; ++i) {
+    size_t len;
+    const char *term = RedisModule_StringPtrLen(argv[i], &len);
+    InvertedIndex *idx = Redis_OpenInvertedIndex(&sctx, term, len, 0, NULL);
+    RedisModule_ReplyWithLongLong(ctx, idx ? idx->numDocs : 0);
+  }
+
+  arrayof(char *) hotTerms = ClusterStats_TakeHotTerms(sp->clusterStats);
+  RedisModule_ReplyWithArray(ctx, array_len(hotTerms));
+  for (size_t i = 0; i < array_len(hotTerms); ++i) {
+    RedisModule_ReplyWithStringBuffer(ctx, hotTerms[i], strlen(hotTerms[i]));
+  }
+  array_free_ex(hotTerms, rm_free(*(char **)ptr));
+
+  RedisSearchCtx_UnlockSpec(&sctx);
+  return REDISMODULE_OK;
+}
+
+/**
+ * FT._SETTERMSTATS <index> <ttl> <num docs> <total docs length> [term num_docs ...]
+ *
+ * Set the statistics of the index over the cluster, which the queries score with for `ttl`
+ * milliseconds. Sent by the coordinator, see FT._TERMSTATS.
+ */
+int SetTermStatsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 5 || (argc - 5) % 2) return RedisModule_WrongArity(ctx);
+
+  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  long long ttl, numDocs, totalDocsLen;
+  if (RedisModule_StringToLongLong(argv[2], &ttl) != REDISMODULE_OK || ttl <= 0 ||
+      RedisModule_StringToLongLong(argv[3], &numDocs) != REDISMODULE_OK || numDocs < 0 ||
+      RedisModule_StringToLongLong(argv[4], &totalDocsLen) != REDISMODULE_OK || totalDocsLen < 0) {
+    return RedisModule_ReplyWithError(ctx, "Bad statistics");
+  }
+
+  TrieMap *termDocs = NewTrieMap();
+  for (int i = 5; i < argc; i += 2) {
+    size_t len;
+    const char *term = RedisModule_StringPtrLen(argv[i], &len);
+    long long docs;
+    if (RedisModule_StringToLongLong(argv[i + 1], &docs) != REDISMODULE_OK || docs < 0) {
+      TrieMap_Free(termDocs, NULL);
+      return RedisModule_ReplyWithError(ctx, "Bad statistics");
+    }
+    TrieMap_Add(termDocs, (char *)term, len, (void *)(uintptr_t)docs, NULL);
+  }
+  ClusterStats_Set(sp->clusterStats, numDocs, totalDocsLen, termDocs, ttl);
+
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * FT._REVISION <index>
+ *
+ * Reply with the unique id of the index and its revision, which the coordinator checks its cached
+ * replies against. Any write to the index bumps its revision, and a recreated index has another id.
+ */
+int RevisionCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) return RedisModule_WrongArity(ctx);
+
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = RedisModule_StringPtrLen(argv[1], NULL)},
+      .flags = INDEXSPEC_LOAD_NOCOUNTER | INDEXSPEC_LOAD_NOTIMERUPDATE | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  IndexSpec *sp = StrongRef_Get(IndexSpec_LoadUnsafeEx(ctx, &loadOpts));
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  RedisModule_ReplyWithArray(ctx, 2);
+  RedisModule_ReplyWithLongLong(ctx, sp->uniqueId);
+  RedisModule_ReplyWithLongLong(ctx, IndexSpec_ResultsRevision(sp));
+  return REDISMODULE_OK;
+}
+
 /**
  * FT.SYNDUMP <index>
  *
@@ -565,7 +822,11 @@ int SynUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 int SynDumpCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (argc != 2) return RedisModule_WrongArity(ctx);
 
-  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[1], NULL), 0);
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = RedisModule_StringPtrLen(argv[1], NULL)},
+      .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
     return RedisModule_ReplyWithError(ctx, "Unknown index name");
@@ -613,7 +874,12 @@ static int AlterIndexInternalCommand(RedisModuleCtx *ctx, RedisModuleString **ar
   QueryError status = {0};
 
   const char *ixname = AC_GetStringNC(&ac, NULL);
-  StrongRef ref = IndexSpec_LoadUnsafe(ctx, ixname, 1);
+  // the new fields of an evicted lazy index are indexed once it is loaded
+  IndexLoadOptions loadOpts = {
+      .name = {.cstring = ixname},
+      .flags = INDEXSPEC_LOAD_WRITEABLE | INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_NOLAZYLOAD,
+  };
+  StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
     return RedisModule_ReplyWithError(ctx, "Unknown index name");
@@ -683,7 +949,8 @@ static int aliasAddCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
   ArgsCursor_InitRString(&ac, argv + 1, argc - 1);
   IndexLoadOptions loadOpts = {
       .name = {.rstring = argv[2]},
-      .flags = INDEXSPEC_LOAD_NOALIAS | INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING};
+      .flags = INDEXSPEC_LOAD_NOALIAS | INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING |
+               INDEXSPEC_LOAD_NOLAZYLOAD};
   StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &loadOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
@@ -727,7 +994,8 @@ static int AliasDelCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
     return RedisModule_WrongArity(ctx);
   }
   IndexLoadOptions lOpts = {.name = {.rstring = argv[1]},
-                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING};
+                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING |
+                                     INDEXSPEC_LOAD_NOLAZYLOAD};
   StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &lOpts);
   IndexSpec *sp = StrongRef_Get(ref);
   if (!sp) {
@@ -748,7 +1016,8 @@ static int AliasDelIfExCommand(RedisModuleCtx *ctx, RedisModuleString **argv, in
     return RedisModule_WrongArity(ctx);
   }
   IndexLoadOptions lOpts = {.name = {.rstring = argv[1]},
-                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING};
+                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING |
+                                     INDEXSPEC_LOAD_NOLAZYLOAD};
   StrongRef ref = IndexSpec_LoadUnsafeEx(ctx, &lOpts);
   if (!StrongRef_Get(ref)) {
     return RedisModule_ReplyWithSimpleString(ctx, "OK");
@@ -763,7 +1032,8 @@ static int AliasUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
 
   QueryError status = {0};
   IndexLoadOptions lOpts = {.name = {.rstring = argv[1]},
-                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING};
+                            .flags = INDEXSPEC_LOAD_KEYLESS | INDEXSPEC_LOAD_KEY_RSTRING |
+                                     INDEXSPEC_LOAD_NOLAZYLOAD};
   StrongRef Orig_ref = IndexSpec_LoadUnsafeEx(ctx, &lOpts);
   IndexSpec *spOrig = StrongRef_Get(Orig_ref);
   if (spOrig) {
@@ -786,11 +1056,29 @@ static int AliasUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
   }
 }
 
+// Reset the latency histograms of the module and of all the indexes, like CONFIG RESETSTAT does
+static void resetLatencyStats() {
+  LatencyStats_Reset(&globalLatencyStats_g);
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry = NULL;
+  while ((entry = dictNext(iter))) {
+    StrongRef ref = dictGetRef(entry);
+    IndexSpec *sp = StrongRef_Get(ref);
+    LatencyStats_Reset(&sp->latency);
+  }
+  dictReleaseIterator(iter);
+}
+
 int ConfigCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   // Not bound to a specific index, so...
   QueryError status = {0};
 
   // CONFIG <GET|SET> <NAME> [value]
+  // CONFIG RESETSTAT
+  if (argc == 2 && !strcasecmp(RedisModule_StringPtrLen(argv[1], NULL), "RESETSTAT")) {
+    resetLatencyStats();
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+  }
   if (argc < 3) {
     return RedisModule_WrongArity(ctx);
   }
@@ -827,6 +1115,82 @@ int ConfigCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
+/*
+ * FT.SLOWLOG GET [count] | LEN | RESET
+ * The latest queries which took at least SLOWLOG_THRESHOLD milliseconds, over all the indexes.
+ */
+int SlowLogCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2 || argc > 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+
+  const char *action = RedisModule_StringPtrLen(argv[1], NULL);
+  if (!strcasecmp(action, "GET")) {
+    long long count = -1;
+    if (argc == 3 && (RedisModule_StringToLongLong(argv[2], &count) != REDISMODULE_OK || count < 0)) {
+      return RedisModule_ReplyWithError(ctx, "Bad count");
+    }
+    RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+    SlowLog_Reply(reply, count);
+    RedisModule_EndReply(reply);
+    return REDISMODULE_OK;
+  } else if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  } else if (!strcasecmp(action, "LEN")) {
+    return RedisModule_ReplyWithLongLong(ctx, SlowLog_Len());
+  } else if (!strcasecmp(action, "RESET")) {
+    SlowLog_Reset();
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+  }
+  return RedisModule_ReplyWithError(ctx, "Unknown subcommand");
+}
+
+/*
+ * FT.PREPARE {name} {index} {query} [options]
+ * Prepare an FT.SEARCH under a name, with the $params of its query bound by FT.EXECUTE.
+ */
+int PrepareCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 4) {
+    return RedisModule_WrongArity(ctx);
+  }
+  QueryError status = {0};
+  if (PreparedQuery_Add(ctx, argv, argc, &status) != REDISMODULE_OK) {
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/*
+ * FT.EXECUTE {name} [PARAMS {nargs} {name} {value} ...]
+ * Run the query prepared under a name, replying as FT.SEARCH.
+ */
+int ExecuteCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  QueryError status = {0};
+  int nargs = 0;
+  RedisModuleString **args = PreparedQuery_Bind(argv, argc, &nargs, &status);
+  if (!args) {
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+  int rc = RSSearchCommand(ctx, args, nargs);
+  rm_free(args);
+  return rc;
+}
+
+/*
+ * FT.DEALLOCATE {name}
+ * Remove the query prepared under a name. Returns 1 if there was one, 0 otherwise.
+ */
+int DeallocateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  return RedisModule_ReplyWithLongLong(
+      ctx, PreparedQuery_Del(RedisModule_StringPtrLen(argv[1], NULL)));
+}
+
 int IndexList(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   if (argc != 1) {
     return RedisModule_WrongArity(ctx);
@@ -988,6 +1352,8 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx, RedisModuleString **argv,
 
   RM_TRY(InvertedIndex_RegisterType, ctx);
 
+  RM_TRY(IndexExport_RegisterType, ctx);
+
   RM_TRY(NumericIndexType_Register, ctx);
 
 #ifndef RS_COORDINATOR
@@ -1051,6 +1417,12 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx, RedisModuleString **argv,
          INDEX_ONLY_CMD_ARGS);
   RM_TRY(RedisModule_CreateCommand, ctx, RS_DROP_INDEX_IF_X_CMD, DropIfExistsIndexCommand, "write",
          INDEX_ONLY_CMD_ARGS);
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_REPLACE_INDEX_CMD, ReplaceIndexCommand, "write",
+         INDEX_ONLY_CMD_ARGS);
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_EXPORT_CMD, ExportIndexCommand, "readonly admin",
+         INDEX_ONLY_CMD_ARGS);
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_IMPORT_CMD, ImportIndexCommand,
+         "write deny-oom admin", 0, 0, 0);
 
   RM_TRY(RedisModule_CreateCommand, ctx, RS_INFO_CMD, IndexInfoCommand, "readonly",
          INDEX_ONLY_CMD_ARGS);
@@ -1091,6 +1463,21 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx, RedisModuleString **argv,
   RM_TRY(RedisModule_CreateCommand, ctx, RS_SYNDUMP_CMD, SynDumpCommand, "readonly",
          INDEX_ONLY_CMD_ARGS);
 
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_SYNC_CMD, SyncCommand, "readonly",
+         INDEX_ONLY_CMD_ARGS);
+
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_WARMUP_CMD, WarmupCommand, "readonly",
+         INDEX_ONLY_CMD_ARGS);
+
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_TERMSTATS_CMD, TermStatsCommand, "readonly",
+         INDEX_ONLY_CMD_ARGS);
+
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_SETTERMSTATS_CMD, SetTermStatsCommand, "readonly",
+         INDEX_ONLY_CMD_ARGS);
+
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_REVISION_CMD, RevisionCommand, "readonly",
+         INDEX_ONLY_CMD_ARGS);
+
   RM_TRY(RedisModule_CreateCommand, ctx, RS_ALTER_CMD, AlterIndexCommand, "write",
          INDEX_ONLY_CMD_ARGS);
   RM_TRY(RedisModule_CreateCommand, ctx, RS_ALTER_IF_NX_CMD, AlterIndexIfNXCommand, "write",
@@ -1109,6 +1496,14 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx, RedisModuleString **argv,
 
   RM_TRY(RedisModule_CreateCommand, ctx, RS_CONFIG, ConfigCommand, "readonly", 0, 0, 0);
 
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_SLOWLOG_CMD, SlowLogCommand, "readonly admin", 0, 0,
+         0);
+
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_PREPARE_CMD, PrepareCommand, "readonly", 0, 0, 0);
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_EXECUTE_CMD, ExecuteCommand, "readonly", 0, 0, 0);
+  RM_TRY(RedisModule_CreateCommand, ctx, RS_DEALLOCATE_CMD, DeallocateCommand, "readonly", 0, 0,
+         0);
+
 // alias is a special case, we can not use the INDEX_ONLY_CMD_ARGS/INDEX_DOC_CMD_ARGS macros
 #ifndef RS_COORDINATOR
   // we are running in a normal mode so we should raise cross slot error on alias commands
@@ -1169,7 +1564,9 @@ void RediSearch_CleanupModule(void) {
   GC_ThreadPoolDestroy();
   CleanPool_ThreadPoolDestroy();
   ReindexPool_ThreadPoolDestroy();
+  AsyncUpdates_ThreadPoolDestroy();
   ConcurrentSearch_ThreadPoolDestroy();
+  CoarseClock_Stop();
 
   // free global structures
   Extensions_Free();
@@ -1179,9 +1576,12 @@ void RediSearch_CleanupModule(void) {
   IndexAlias_DestroyGlobal(&AliasTable_g);
   freeGlobalAddStrings();
   SchemaPrefixes_Free(ScemaPrefixes_g);
+  DFACache_Clear();
+  ColdBlockCache_Free();
+  IndexBuffers_Free();
   // GeometryApi_Free();
 
   RedisModule_FreeThreadSafeContext(RSDummyContext);
   Dictionary_Free();
-  RediSearch_LockDestory();
+  PreparedQuery_Clear();
 }
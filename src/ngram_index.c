@@ -0,0 +1,339 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "ngram_index.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/arr.h"
+#include "util/timeout.h"
+#include "wildcard/wildcard.h"
+
+#include <string.h>
+
+typedef struct {
+  char *str;  // NULL for a free id
+  uint32_t len;
+} ngramTerm;
+
+struct NgramIndex {
+  TrieMap *ids;         // term => its id + 1
+  TrieMap *grams;       // gram => sorted array of the ids of the terms containing it
+  ngramTerm *terms;     // by id
+  uint32_t *freeIds;
+  size_t numTerms;
+  size_t postingsSize;  // bytes of the ids listed under the grams
+};
+
+#define ID_TO_PTR(id) ((void *)(uintptr_t)((id) + 1))
+#define PTR_TO_ID(p) ((uint32_t)((uintptr_t)(p)-1))
+
+static void noopFree(void *p) {
+}
+
+static void postingsFree(void *p) {
+  array_free(p);
+}
+
+NgramIndex *NewNgramIndex() {
+  NgramIndex *idx = rm_calloc(1, sizeof(*idx));
+  idx->ids = NewTrieMap();
+  idx->grams = NewTrieMap();
+  idx->terms = array_new(ngramTerm, 16);
+  idx->freeIds = array_new(uint32_t, 0);
+  return idx;
+}
+
+void NgramIndex_Free(NgramIndex *idx) {
+  TrieMap_Free(idx->ids, noopFree);
+  TrieMap_Free(idx->grams, postingsFree);
+  array_free_ex(idx->terms, rm_free(((ngramTerm *)ptr)->str));
+  array_free(idx->freeIds);
+  rm_free(idx);
+}
+
+size_t NgramIndex_NumTerms(const NgramIndex *idx) {
+  return idx->numTerms;
+}
+
+size_t NgramIndex_MemUsage(const NgramIndex *idx) {
+  size_t sz = sizeof(*idx) + TrieMap_MemUsage(idx->ids) + TrieMap_MemUsage(idx->grams);
+  sz += idx->postingsSize + array_len(idx->terms) * sizeof(*idx->terms);
+  for (uint32_t i = 0; i < array_len(idx->terms); i++) {
+    sz += idx->terms[i].len;
+  }
+  return sz;
+}
+
+/* The folded runes of a string, in `buf` */
+static rune *foldRunes(const char *s, size_t n, runeBuf *buf, size_t *len) {
+  rune *runes = runeBufFill(s, n, buf, len);
+  for (size_t i = 0; i < *len; i++) {
+    runes[i] = runeFold(runes[i]);
+  }
+  return runes;
+}
+
+// The first position in a sorted array of ids whose id is not below `id`
+static uint32_t lowerBound(const uint32_t *ids, uint32_t from, uint32_t n, uint32_t id) {
+  while (from < n) {
+    uint32_t mid = from + (n - from) / 2;
+    if (ids[mid] < id) {
+      from = mid + 1;
+    } else {
+      n = mid;
+    }
+  }
+  return from;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static void *postingsReplace(void *oldval, void *newval) {
+  // the old array was reallocated into the new one
+  return newval;
+}
+
+static void addGram(NgramIndex *idx, const char *gram, uint32_t id) {
+  uint32_t *ids = TrieMap_Find(idx->grams, (char *)gram, NGRAM_LEN);
+  if (ids == TRIEMAP_NOTFOUND) {
+    ids = array_new(uint32_t, 1);
+    ids = array_append(ids, id);
+    TrieMap_Add(idx->grams, (char *)gram, NGRAM_LEN, ids, NULL);
+    idx->postingsSize += sizeof(*ids);
+    return;
+  }
+
+  uint32_t n = array_len(ids);
+  uint32_t pos = lowerBound(ids, 0, n, id);
+  if (pos < n && ids[pos] == id) {
+    // the gram is repeated in the term
+    return;
+  }
+  uint32_t *old = ids;
+  ids = array_append(ids, id);
+  memmove(ids + pos + 1, ids + pos, (n - pos) * sizeof(*ids));
+  ids[pos] = id;
+  if (ids != old) {
+    TrieMap_Add(idx->grams, (char *)gram, NGRAM_LEN, ids, postingsReplace);
+  }
+  idx->postingsSize += sizeof(*ids);
+}
+
+static void deleteGram(NgramIndex *idx, const char *gram, uint32_t id) {
+  uint32_t *ids = TrieMap_Find(idx->grams, (char *)gram, NGRAM_LEN);
+  if (ids == TRIEMAP_NOTFOUND) {
+    return;
+  }
+  uint32_t pos = lowerBound(ids, 0, array_len(ids), id);
+  if (pos == array_len(ids) || ids[pos] != id) {
+    // the gram is repeated in the term, and was deleted already
+    return;
+  }
+  memmove(ids + pos, ids + pos + 1, (array_len(ids) - pos - 1) * sizeof(*ids));
+  array_hdr(ids)->len--;
+  idx->postingsSize -= sizeof(*ids);
+  if (!array_len(ids)) {
+    TrieMap_Delete(idx->grams, (char *)gram, NGRAM_LEN, postingsFree);
+  }
+}
+
+typedef void (*gramCallback)(NgramIndex *idx, const char *gram, uint32_t id);
+
+static void forEachGram(NgramIndex *idx, const char *term, size_t len, gramCallback cb,
+                        uint32_t id) {
+  runeBuf buf;
+  size_t rlen;
+  rune *runes = foldRunes(term, len, &buf, &rlen);
+  size_t flen;
+  char *folded = runesToStr(runes, rlen, &flen);
+  runeBufFree(&buf);
+  for (size_t i = 0; i + NGRAM_LEN <= flen; i++) {
+    cb(idx, folded + i, id);
+  }
+  rm_free(folded);
+}
+
+void NgramIndex_Add(NgramIndex *idx, const char *term, size_t len) {
+  // a shorter term has no gram, and a pattern which can be filtered has a longer literal part
+  if (len < NGRAM_LEN || TrieMap_Find(idx->ids, (char *)term, len) != TRIEMAP_NOTFOUND) {
+    return;
+  }
+
+  ngramTerm t = {.str = rm_strndup(term, len), .len = len};
+  uint32_t id;
+  if (array_len(idx->freeIds)) {
+    id = array_pop(idx->freeIds);
+    idx->terms[id] = t;
+  } else {
+    id = array_len(idx->terms);
+    idx->terms = array_append(idx->terms, t);
+  }
+  TrieMap_Add(idx->ids, (char *)term, len, ID_TO_PTR(id), NULL);
+  forEachGram(idx, term, len, addGram, id);
+  idx->numTerms++;
+}
+
+void NgramIndex_Delete(NgramIndex *idx, const char *term, size_t len) {
+  void *p = TrieMap_Find(idx->ids, (char *)term, len);
+  if (p == TRIEMAP_NOTFOUND) {
+    return;
+  }
+  uint32_t id = PTR_TO_ID(p);
+  forEachGram(idx, term, len, deleteGram, id);
+  TrieMap_Delete(idx->ids, (char *)term, len, noopFree);
+  rm_free(idx->terms[id].str);
+  idx->terms[id].str = NULL;
+  idx->freeIds = array_append(idx->freeIds, id);
+  idx->numTerms--;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static int cmpPostingsLen(const void *p1, const void *p2) {
+  uint32_t a = array_len(*(uint32_t **)p1), b = array_len(*(uint32_t **)p2);
+  return a < b ? -1 : a > b;
+}
+
+/* The ids of the terms listed under all the grams of the literal parts of a pattern, given by their
+ * folded runes. Returns NULL if the parts have no gram */
+static uint32_t *findCandidates(NgramIndex *idx, const rune **parts, const size_t *partLens,
+                                size_t numParts) {
+  uint32_t **postings = array_new(uint32_t *, 8);
+  bool missing = false;
+  for (size_t i = 0; i < numParts && !missing; i++) {
+    size_t len;
+    char *part = runesToStr(parts[i], partLens[i], &len);
+    for (size_t j = 0; j + NGRAM_LEN <= len; j++) {
+      uint32_t *ids = TrieMap_Find(idx->grams, part + j, NGRAM_LEN);
+      if (ids == TRIEMAP_NOTFOUND) {
+        // no term has all the grams
+        missing = true;
+        break;
+      }
+      postings = array_append(postings, ids);
+    }
+    rm_free(part);
+  }
+  if (!missing && !array_len(postings)) {
+    array_free(postings);
+    return NULL;
+  }
+
+  uint32_t *candidates = array_new(uint32_t, 0);
+  if (!missing) {
+    // Intersect from the shortest array, looking the candidates up in the longer ones
+    qsort(postings, array_len(postings), sizeof(*postings), cmpPostingsLen);
+    candidates = array_ensure_append_n(candidates, postings[0], array_len(postings[0]));
+    for (uint32_t i = 1; i < array_len(postings) && array_len(candidates); i++) {
+      const uint32_t *ids = postings[i];
+      uint32_t n = array_len(ids), pos = 0, kept = 0;
+      for (uint32_t j = 0; j < array_len(candidates) && pos < n; j++) {
+        pos = lowerBound(ids, pos, n, candidates[j]);
+        if (pos < n && ids[pos] == candidates[j]) {
+          candidates[kept++] = candidates[j];
+        }
+      }
+      array_hdr(candidates)->len = kept;
+    }
+  }
+  array_free(postings);
+  return candidates;
+}
+
+typedef bool (*termMatcher)(const rune *term, size_t len, const void *ctx);
+
+typedef struct {
+  const rune *str;
+  size_t len;
+  bool contains;
+} containsCtx;
+
+static bool matchContains(const rune *term, size_t len, const void *p) {
+  const containsCtx *ctx = p;
+  if (len < ctx->len) {
+    return false;
+  }
+  size_t bytes = ctx->len * sizeof(rune);
+  if (!ctx->contains) {
+    return !memcmp(term + len - ctx->len, ctx->str, bytes);
+  }
+  for (size_t i = 0; i + ctx->len <= len; i++) {
+    if (!memcmp(term + i, ctx->str, bytes)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+typedef struct {
+  const rune *pattern;
+  size_t len;
+} wildcardCtx;
+
+static bool matchWildcard(const rune *term, size_t len, const void *p) {
+  const wildcardCtx *ctx = p;
+  return Wildcard_MatchRune(ctx->pattern, ctx->len, term, len) == FULL_MATCH;
+}
+
+/* Call `cb` with the candidates which match */
+static void iterateCandidates(NgramIndex *idx, const uint32_t *candidates, termMatcher match,
+                              const void *matchCtx, TrieSuffixCallback *cb, void *ctx,
+                              struct timespec *timeout) {
+  size_t timeoutCounter = 0;
+  for (uint32_t i = 0; i < array_len(candidates); i++) {
+    const ngramTerm *t = &idx->terms[candidates[i]];
+    runeBuf buf;
+    size_t rlen;
+    rune *runes = foldRunes(t->str, t->len, &buf, &rlen);
+    bool matched = match(runes, rlen, matchCtx);
+    runeBufFree(&buf);
+    if (matched && cb(t->str, t->len, ctx, NULL) != REDISEARCH_OK) {
+      return;
+    }
+    if (timeout && TimedOut_WithCounter(timeout, &timeoutCounter)) {
+      return;
+    }
+  }
+}
+
+int NgramIndex_IterateContains(NgramIndex *idx, const rune *str, size_t len, bool contains,
+                               TrieSuffixCallback *cb, void *ctx, struct timespec *timeout) {
+  uint32_t *candidates = findCandidates(idx, &str, &len, 1);
+  if (!candidates) {
+    return 0;
+  }
+  containsCtx mctx = {.str = str, .len = len, .contains = contains};
+  iterateCandidates(idx, candidates, matchContains, &mctx, cb, ctx, timeout);
+  array_free(candidates);
+  return 1;
+}
+
+int NgramIndex_IterateWildcard(NgramIndex *idx, const rune *pattern, size_t len,
+                               TrieSuffixCallback *cb, void *ctx, struct timespec *timeout) {
+  // The literal parts are the runs between the wildcards
+  const rune **parts = array_new(const rune *, 4);
+  size_t *partLens = array_new(size_t, 4);
+  size_t start = 0;
+  for (size_t i = 0; i <= len; i++) {
+    if (i == len || pattern[i] == '*' || pattern[i] == '?') {
+      if (i > start) {
+        parts = array_append(parts, pattern + start);
+        partLens = array_append(partLens, i - start);
+      }
+      start = i + 1;
+    }
+  }
+  uint32_t *candidates = findCandidates(idx, parts, partLens, array_len(parts));
+  array_free(parts);
+  array_free(partLens);
+  if (!candidates) {
+    return 0;
+  }
+  wildcardCtx mctx = {.pattern = pattern, .len = len};
+  iterateCandidates(idx, candidates, matchWildcard, &mctx, cb, ctx, timeout);
+  array_free(candidates);
+  return 1;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "trie/trie.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Length in bytes of the grams of the index */
+#define NGRAM_LEN 3
+
+/* A trigram index of the terms of the WITHNGRAMS fields, to find the terms of contains, suffix and
+ * wildcard queries without scanning the terms trie, and with much less memory than the suffix trie.
+ *
+ * Every term is listed under the trigrams of the UTF-8 bytes of its folded form, in a sorted
+ * array of term ids. The candidates of a pattern are the terms listed under all the trigrams of its
+ * literal parts, found by intersecting their arrays from the shortest one, and each candidate is
+ * matched against the pattern. Patterns without a literal part of NGRAM_LEN bytes can not be
+ * filtered, and are left to the terms trie */
+typedef struct NgramIndex NgramIndex;
+
+NgramIndex *NewNgramIndex();
+
+void NgramIndex_Free(NgramIndex *idx);
+
+/* Add a term to the index, if it is not there already */
+void NgramIndex_Add(NgramIndex *idx, const char *term, size_t len);
+
+void NgramIndex_Delete(NgramIndex *idx, const char *term, size_t len);
+
+size_t NgramIndex_NumTerms(const NgramIndex *idx);
+
+size_t NgramIndex_MemUsage(const NgramIndex *idx);
+
+/* Call `cb` with the terms containing the folded runes `str`, or ending with them if `contains`
+ * is false. Returns 0 if the string is too short to be filtered by the index, without calling
+ * `cb`, and 1 otherwise. The iteration stops if `cb` does not return REDISEARCH_OK */
+int NgramIndex_IterateContains(NgramIndex *idx, const rune *str, size_t len, bool contains,
+                               TrieSuffixCallback *cb, void *ctx, struct timespec *timeout);
+
+/* As NgramIndex_IterateContains, with the terms matching the folded wildcard pattern */
+int NgramIndex_IterateWildcard(NgramIndex *idx, const rune *pattern, size_t len,
+                               TrieSuffixCallback *cb, void *ctx, struct timespec *timeout);
+
+#ifdef __cplusplus
+}
+#endif
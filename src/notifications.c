@@ -12,6 +12,7 @@
 #include "rdb.h"
 #include "module.h"
 #include "util/workers.h"
+#include "index_persistence.h"
 
 #define JSON_LEN 5 // length of string "json."
 
@@ -128,7 +129,10 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
       // on loaded event the key is stack allocated so to use it to load the
       // document we must copy it
       key = RedisModule_CreateStringFromString(ctx, key);
+      // the indexes restored from the RDB already hold the key
+      IndexPersistence_KeyLoadStart(key);
       Indexes_UpdateMatchingWithSchemaRules(ctx, key, getDocTypeFromString(key), hashFields); //TODO: avoid getDocTypeFromString ?
+      IndexPersistence_KeyLoadEnd();
       RedisModule_FreeString(ctx, key);
       break;
 
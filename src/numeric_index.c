@@ -14,20 +14,35 @@
 #include <math.h>
 #include "redismodule.h"
 #include "util/misc.h"
+#include "alloc_stats.h"
 //#include "tests/time_sample.h"
 #define NR_EXPONENT 4
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
+// the minimal unsorted tail a range column keeps before merging it into its sorted part
+#define NR_COLUMN_MIN_TAIL 64
+// the number of entries a leaf of a BKD tree holds before it splits
+#define NR_BKD_LEAF_SIZE 4096
+// the number of entries below which adjacent leaves are merged by the rebalancing
+#define NR_SPARSE_LEAF_SIZE 256
 
 typedef struct {
   IndexIterator *it;
-  uint32_t lastRevId;
   IndexSpec *sp;
   const char *fieldName;
+  // the ranges read by the iterator are not freed while the epoch is pinned
+  EpochDomain *epochs;
+  uint64_t epoch;
 } NumericUnionCtx;
 
 void NumericRangeIterator_OnReopen(void *privdata);
 
+static void numericUnionCtx_Free(void *p) {
+  NumericUnionCtx *uc = p;
+  EpochDomain_Unpin(uc->epochs, uc->epoch);
+  rm_free(uc);
+}
+
 #ifdef _DEBUG
 void NumericRangeTree_Dump(NumericRangeTree *t, int indent) {
   PRINT_INDENT(indent);
@@ -77,7 +92,7 @@ void NumericRange_Dump(NumericRange *r, int indent) {
   printf("NumericRange {\n");
   ++indent;
   PRINT_INDENT(indent);
-  printf("minVal %f, maxVal %f, unique_sum %f, invertedIndexSize %zu, card %hu, cardCheck %hu, splitCard %u\n", r->minVal, r->maxVal, r->unique_sum, r->invertedIndexSize, r->card, r->cardCheck, r->splitCard);
+  printf("minVal %f, maxVal %f, invertedIndexSize %zu, card %hu, cardCheck %hu, splitCard %u\n", r->minVal, r->maxVal, r->invertedIndexSize, r->card, r->cardCheck, r->splitCard);
   InvertedIndex_Dump(r->entries, indent + 1);
   --indent;
   PRINT_INDENT(indent);
@@ -117,20 +132,64 @@ static inline void checkCardinality(NumericRange *n, double value) {
   }
   n->cardCheck = NR_CARD_CHECK; 
 
-  // check if value exists and increase appearance
-  uint32_t arrlen = array_len(n->values);
-  for (int i = 0; i < arrlen; i++) {
-    if (n->values[i].value == value) {
-      n->values[i].appearances++;
-      return;
-    }
+  if (KMV_Add(&n->cardSketch, value)) {
+    n->card = MIN(KMV_Estimate(&n->cardSketch), UINT16_MAX);
+  }
+}
+
+void NumericRange_SetCardSketch(NumericRange *n, KMVSketch *sketch) {
+  KMV_Clear(&n->cardSketch);
+  n->cardSketch = *sketch;
+  *sketch = (KMVSketch){0};
+  n->card = MIN(KMV_Estimate(&n->cardSketch), UINT16_MAX);
+}
+
+static int cmpEntryValue(const void *p1, const void *p2) {
+  const NumericRangeEntry *e1 = p1, *e2 = p2;
+  return (e1->value > e2->value) - (e1->value < e2->value);
+}
+
+/* Sort the tail of the range's column and merge it into the sorted part */
+static void NumericRange_MergeColumn(NumericRange *n) {
+  NumericRangeEntry *col = n->column;
+  uint32_t len = array_len(col), nsorted = n->columnSorted;
+  qsort(col + nsorted, len - nsorted, sizeof(*col), cmpEntryValue);
+
+  NumericRangeEntry *merged = array_newlen(NumericRangeEntry, len);
+  uint32_t i = 0, j = nsorted, k = 0;
+  while (i < nsorted && j < len) {
+    merged[k++] = col[j].value < col[i].value ? col[j++] : col[i++];
   }
+  while (i < nsorted) merged[k++] = col[i++];
+  while (j < len) merged[k++] = col[j++];
 
-  // add new value to cardinality values
-  CardinalityValue val = {.value = value, .appearances = 1};
-  n->values = array_append(n->values, val);
-  n->unique_sum += value;
-  ++n->card;
+  array_free(col);
+  n->column = merged;
+  n->columnSorted = len;
+}
+
+static inline void NumericRange_AddColumn(NumericRange *n, t_docId docId, double value) {
+  NumericRangeEntry ent = {.docId = docId, .value = value};
+  n->column = array_append(n->column, ent);
+  // keep the unsorted tail short, but merge it geometrically so appends stay cheap
+  if (array_len(n->column) - n->columnSorted > MAX(NR_COLUMN_MIN_TAIL, n->columnSorted / 8)) {
+    NumericRange_MergeColumn(n);
+  }
+}
+
+void NumericRange_RebuildColumn(NumericRange *n) {
+  array_free(n->column);
+  n->column = array_new(NumericRangeEntry, n->entries->numEntries + 1);
+  n->columnSorted = 0;
+
+  RSIndexResult *res = NULL;
+  IndexReader *ir = NewNumericReader(NULL, n->entries, NULL, 0, 0, false);
+  while (INDEXREAD_OK == IR_Read(ir, &res)) {
+    NumericRangeEntry ent = {.docId = res->docId, .value = res->num.value};
+    n->column = array_append(n->column, ent);
+  }
+  IR_Free(ir);
+  NumericRange_MergeColumn(n);
 }
 
 size_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkCard) {
@@ -142,26 +201,58 @@ size_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkC
   if (value < n->minVal) n->minVal = value;
   if (value > n->maxVal) n->maxVal = value;
 
+  if (n->column) {
+    NumericRange_AddColumn(n, docId, value);
+  }
+
   size_t size = InvertedIndex_WriteNumericEntry(n->entries, docId, value);
   n->invertedIndexSize += size;
   return size;
 }
 
+/* The value splitting a BKD range in two halves: its median, unless that is also its minimum, in
+ * which case the smallest value above it */
+static double NumericRange_Median(NumericRange *n) {
+  NumericRange_MergeColumn(n);
+  const NumericRangeEntry *col = n->column;
+  uint32_t len = array_len(col);
+  double split = col[len / 2].value;
+  if (split == col[0].value) {
+    uint32_t i = len / 2;
+    while (i < len && col[i].value == split) ++i;
+    split = i < len ? col[i].value : n->maxVal;
+  }
+  return split;
+}
+
+/* Make the given leaf a BKD one */
+static void NumericRangeNode_SetBKD(NumericRangeNode *n) {
+  n->range->bkd = 1;
+  if (!n->range->column) {
+    n->range->column = array_new(NumericRangeEntry, 16);
+  }
+}
+
 double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNode **rp,
                           NRN_AddRv *rv) {
 
-  double split = (n->unique_sum) / (double)n->card;
+  // the sketch samples the distinct values evenly, regardless of how often each appears
+  double split = n->bkd ? NumericRange_Median(n) : KMV_Median(&n->cardSketch);
 
   *lp = NewLeafNode(n->entries->numDocs / 2 + 1, 
                     MIN(NR_MAXRANGE_CARD, 1 + n->splitCard * NR_EXPONENT));
   *rp = NewLeafNode(n->entries->numDocs / 2 + 1,
                     MIN(NR_MAXRANGE_CARD, 1 + n->splitCard * NR_EXPONENT));
+  if (n->bkd) {
+    NumericRangeNode_SetBKD(*lp);
+    NumericRangeNode_SetBKD(*rp);
+  }
 
   RSIndexResult *res = NULL;
   IndexReader *ir = NewNumericReader(NULL, n->entries, NULL ,0, 0, false);
   while (INDEXREAD_OK == IR_Read(ir, &res)) {
     rv->sz += NumericRange_Add(res->num.value < split ? (*lp)->range : (*rp)->range, res->docId,
-                               res->num.value, 1);
+                               res->num.value, !n->bkd);
     ++rv->numRecords;
   }
   IR_Free(ir);
@@ -182,19 +273,27 @@ NumericRangeNode *NewLeafNode(size_t cap, size_t splitCard) {
   *n->range = (NumericRange){
       .minVal = __DBL_MAX__,
       .maxVal = __DBL_MIN__,
-      .unique_sum = 0,
       .card = 0,
       .cardCheck = NR_CARD_CHECK,
       .splitCard = splitCard,
-      .values = array_new(CardinalityValue, 1),
-      //.values = rm_calloc(splitCard, sizeof(CardinalityValue)),
+      .cardSketch = {0},
       .entries = NewInvertedIndex(Index_StoreNumeric, 1),
       .invertedIndexSize = 0,
+      .column = RSGlobalConfig.numericSortedColumn ? array_new(NumericRangeEntry, cap) : NULL,
+      .columnSorted = 0,
   };
   return n;
 }
 
-static void removeRange(NumericRangeNode *n, NRN_AddRv *rv) {
+static void NumericRange_Free(void *p) {
+  NumericRange *r = p;
+  InvertedIndex_Free(r->entries);
+  KMV_Clear(&r->cardSketch);
+  array_free(r->column);
+  rm_free(r);
+}
+
+static void removeRange(NumericRangeTree *t, NumericRangeNode *n, NRN_AddRv *rv) {
   if (!n || !n->range) {
     return;
   }
@@ -203,16 +302,24 @@ static void removeRange(NumericRangeNode *n, NRN_AddRv *rv) {
   NumericRange *temp = n->range;
   n->range = NULL;
 
-  // free resources
   rv->sz -= temp->invertedIndexSize;
   rv->numRecords -= temp->entries->numEntries;
-  InvertedIndex_Free(temp->entries);
-  array_free(temp->values);
-  rm_free(temp);
+  EpochDomain_Retire(t->epochs, temp, NumericRange_Free);
 
   rv->numRanges--;
 }
 
+/* Free a subtree unlinked from the tree, retiring its ranges */
+static void NumericRangeNode_Retire(NumericRangeTree *t, NumericRangeNode *n) {
+  if (!n) return;
+  if (n->range) {
+    EpochDomain_Retire(t->epochs, n->range, NumericRange_Free);
+  }
+  NumericRangeNode_Retire(t, n->left);
+  NumericRangeNode_Retire(t, n->right);
+  rm_free(n);
+}
+
 static void NumericRangeNode_Balance(NumericRangeNode **n) {
   NumericRangeNode *node = *n;
   node->maxDepth = MAX(node->right->maxDepth, node->left->maxDepth) + 1;
@@ -235,7 +342,8 @@ static void NumericRangeNode_Balance(NumericRangeNode **n) {
   }
 }
 
-NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value) {
+NRN_AddRv NumericRangeNode_Add(NumericRangeTree *t, NumericRangeNode *n, t_docId docId,
+                               double value) {
   NRN_AddRv rv = {.sz = 0, .changed = 0, .numRecords = 0, .numRanges = 0};
   if (!NumericRangeNode_IsLeaf(n)) {
     // if this node has already split but retains a range, just add to the range without checking
@@ -251,7 +359,7 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
     NumericRangeNode **childP = value < n->value ? &n->left : &n->right;
     NumericRangeNode *child = *childP;
     // if the child has split we get 1 in return
-    rv = NumericRangeNode_Add(child, docId, value);
+    rv = NumericRangeNode_Add(t, child, docId, value);
     rv.sz += s;
     rv.numRecords += nRecords;
 
@@ -260,7 +368,7 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
       // we are too deep - we don't retain this node's range anymore.
       // this keeps memory footprint in check
       if (++n->maxDepth > RSGlobalConfig.numericTreeMaxDepthRange && n->range) {
-        removeRange(n, &rv);
+        removeRange(t, n, &rv);
       }
 
       NumericRangeNode_Balance(childP);
@@ -270,20 +378,28 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
   }
 
   // if this node is a leaf - we add AND check the cardinality. We only split leaf nodes
-  rv.sz = (uint32_t)NumericRange_Add(n->range, docId, value, 1);
+  // BKD leaves split on their size instead
+  NumericRange *r = n->range;
+  rv.sz = (uint32_t)NumericRange_Add(r, docId, value, !r->bkd);
   ++rv.numRecords;
-  int card = n->range->card;
-  
-  if (card * NR_CARD_CHECK >= n->range->splitCard || 
-      (n->range->entries->numEntries > NR_MAXRANGE_SIZE && card > 1)) {
+  int card = r->card;
+  int split = r->bkd ? r->entries->numEntries >= NR_BKD_LEAF_SIZE && r->minVal < r->maxVal
+                     : card * NR_CARD_CHECK >= r->splitCard ||
+                           (r->entries->numEntries > NR_MAXRANGE_SIZE && card > 1);
+
+  if (split) {
 
     // split this node but don't delete its range
-    double split = NumericRange_Split(n->range, &n->left, &n->right, &rv);
+    double splitValue = NumericRange_Split(r, &n->left, &n->right, &rv);
     rv.numRanges += 2;
-    if (RSGlobalConfig.numericTreeMaxDepthRange == 0) {
-      removeRange(n, &rv);
+    // a retained parent range is only used when it is fully contained in a filter, so it has no
+    // use for its column. BKD trees retain none
+    array_free(r->column);
+    r->column = NULL;
+    if (r->bkd || RSGlobalConfig.numericTreeMaxDepthRange == 0) {
+      removeRange(t, n, &rv);
     }
-    n->value = split;
+    n->value = splitValue;
     n->maxDepth = 1;
     rv.changed = 1;
   }
@@ -370,9 +486,7 @@ Vector *NumericRangeNode_FindRange(NumericRangeNode *n, const NumericFilter *nf)
 void NumericRangeNode_Free(NumericRangeNode *n) {
   if (!n) return;
   if (n->range) {
-    InvertedIndex_Free(n->range->entries);
-    array_free(n->range->values);
-    rm_free(n->range);
+    NumericRange_Free(n->range);
     n->range = NULL;
   }
 
@@ -386,6 +500,7 @@ uint16_t numericTreesUniqueId = 0;
 
 /* Create a new numeric range tree */
 NumericRangeTree *NewNumericRangeTree() {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_NUMERIC);
   NumericRangeTree *ret = rm_malloc(sizeof(NumericRangeTree));
 
   // updated value since splitCard should be >NR_CARD_CHECK
@@ -395,10 +510,108 @@ NumericRangeTree *NewNumericRangeTree() {
   ret->revisionId = 0;
   ret->lastDocId = 0;
   ret->emptyLeaves = 0;
-  ret->uniqueId = numericTreesUniqueId++;
+  // trees are also built by the workers decoding the indexes restored from the RDB
+  ret->uniqueId = __atomic_fetch_add(&numericTreesUniqueId, 1, __ATOMIC_RELAXED);
+  ret->histogram = (NumericHistogram){0};
+  ret->epochs = EpochDomain_New();
+  AllocStats_SetTag(prevTag);
   return ret;
 }
 
+void NumericRangeTree_SetBKD(NumericRangeTree *t) {
+  NumericRangeNode *root = t->root;
+  if (NumericRangeNode_IsLeaf(root) && !root->range->bkd && !root->range->entries->numEntries) {
+    NumericRangeNode_SetBKD(root);
+  }
+}
+
+/* Add the leaves under a node to the histogram, in value order. A leaf joins the last bucket
+ * until that one holds `depth` documents */
+static void NumericHistogram_AddLeaves(NumericHistogramBucket **buckets, NumericRangeNode *n,
+                                       size_t depth) {
+  if (n->left) NumericHistogram_AddLeaves(buckets, n->left, depth);
+  if (n->right) NumericHistogram_AddLeaves(buckets, n->right, depth);
+  if (!NumericRangeNode_IsLeaf(n) || !n->range || !n->range->entries->numDocs) {
+    return;
+  }
+
+  const NumericRange *r = n->range;
+  size_t len = array_len(*buckets);
+  NumericHistogramBucket *last = len ? *buckets + len - 1 : NULL;
+  if (last && last->numDocs < depth) {
+    last->maxVal = MAX(last->maxVal, r->maxVal);
+    last->numDocs += r->entries->numDocs;
+    last->card += MAX(1, r->card);
+  } else {
+    NumericHistogramBucket b = {.minVal = r->minVal,
+                                .maxVal = r->maxVal,
+                                .numDocs = r->entries->numDocs,
+                                .card = MAX(1, r->card)};
+    array_append(*buckets, b);
+  }
+}
+
+void NumericRangeTree_RefreshHistogram(NumericRangeTree *t) {
+  NumericHistogram *h = &t->histogram;
+  if (h->buckets) {
+    array_clear(h->buckets);
+  } else {
+    h->buckets = array_new(NumericHistogramBucket, NR_HISTOGRAM_BUCKETS);
+  }
+  size_t depth = t->numEntries / NR_HISTOGRAM_BUCKETS + 1;
+  NumericHistogram_AddLeaves(&h->buckets, t->root, depth);
+  h->numEntries = t->numEntries;
+}
+
+/* Count a value added to the tree in the histogram */
+static void NumericHistogram_Add(NumericRangeTree *t, double value) {
+  NumericHistogram *h = &t->histogram;
+  if (t->numEntries > 2 * h->numEntries) {
+    NumericRangeTree_RefreshHistogram(t);
+    return;
+  }
+  if (!array_len(h->buckets)) {
+    return;
+  }
+
+  // the first bucket which does not end below the value, or the last bucket
+  size_t lo = 0, hi = array_len(h->buckets) - 1;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (h->buckets[mid].maxVal < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  NumericHistogramBucket *b = h->buckets + lo;
+  b->minVal = MIN(b->minVal, value);
+  b->maxVal = MAX(b->maxVal, value);
+  b->numDocs++;
+}
+
+size_t NumericRangeTree_EstimateMatches(const NumericRangeTree *t, const NumericFilter *f) {
+  const NumericHistogram *h = &t->histogram;
+  double estimate = 0;
+  for (size_t i = 0; i < array_len(h->buckets); ++i) {
+    const NumericHistogramBucket *b = h->buckets + i;
+    if (b->maxVal < f->min || b->minVal > f->max) {
+      continue;
+    }
+    // values are assumed to be spread evenly over the bucket, and a single value to be matched by
+    // its share out of the bucket's distinct values
+    double ratio = 1.0 / b->card;
+    if (b->minVal < b->maxVal) {
+      double overlap = MIN(b->maxVal, f->max) - MAX(b->minVal, f->min);
+      ratio = MAX(ratio, overlap / (b->maxVal - b->minVal));
+    } else {
+      ratio = 1;
+    }
+    estimate += MIN(1, ratio) * b->numDocs;
+  }
+  return ceil(estimate);
+}
+
 NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value, int isMulti) {
 
   if (docId <= t->lastDocId && !isMulti) {
@@ -406,17 +619,22 @@ NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value,
     // from it
     return (NRN_AddRv){0, 0, 0};
   }
+  if (docId == t->lastDocId) {
+    t->multiValued = 1;
+  }
   t->lastDocId = docId;
 
-  NRN_AddRv rv = NumericRangeNode_Add(t->root, docId, value);
-  // rc != 0 means the tree nodes have changed, and concurrent iteration is not allowed now
-  // we increment the revision id of the tree, so currently running query iterators on it
-  // will abort the next time they get execution context
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_NUMERIC);
+  NRN_AddRv rv = NumericRangeNode_Add(t, t->root, docId, value);
+  // rc != 0 means the tree nodes have changed. Running queries keep reading the ranges they
+  // started with, which are retired rather than freed
   if (rv.changed) {
     t->revisionId++;
   }
   t->numRanges += rv.numRanges;
   t->numEntries++;
+  NumericHistogram_Add(t, value);
+  AllocStats_SetTag(prevTag);
 
   return rv;
 }
@@ -441,7 +659,8 @@ void NumericRangeNode_Traverse(NumericRangeNode *n,
 #define CHILD_EMPTY 1
 #define CHILD_NOT_EMPTY 0
 
-int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
+static int NumericRangeNode_RemoveChild(NumericRangeTree *t, NumericRangeNode **node,
+                                        NRN_AddRv *rv) {
   NumericRangeNode *n = *node;
   // stop condition - we are at leaf
   if (NumericRangeNode_IsLeaf(n)) {
@@ -453,8 +672,8 @@ int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
   }
 
   // run recursively on both children
-  int rvRight = NumericRangeNode_RemoveChild(&n->right, rv);
-  int rvLeft = NumericRangeNode_RemoveChild(&n->left, rv);
+  int rvRight = NumericRangeNode_RemoveChild(t, &n->right, rv);
+  int rvLeft = NumericRangeNode_RemoveChild(t, &n->left, rv);
   NumericRangeNode *rightChild = n->right;
   NumericRangeNode *leftChild = n->left;
 
@@ -473,7 +692,7 @@ int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
     if (n->range->invertedIndexSize != 0) {
       return CHILD_NOT_EMPTY;
     }
-    removeRange(n, rv);
+    removeRange(t, n, rv);
     n->range = NULL;
     rv->numRanges--;
   }
@@ -482,7 +701,7 @@ int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
   if (rvRight == CHILD_EMPTY && rvLeft == CHILD_EMPTY) {
     rm_free(n);
     *node = rightChild;
-    NumericRangeNode_Free(leftChild);
+    NumericRangeNode_Retire(t, leftChild);
     rv->numRanges--;
 
     return CHILD_EMPTY;
@@ -493,12 +712,12 @@ int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
     // right child is empty, save left as parent
     rm_free(n);
     *node = leftChild;
-    NumericRangeNode_Free(rightChild);
+    NumericRangeNode_Retire(t, rightChild);
   } else {
     // left child is empty, save right as parent
     rm_free(n);
     *node = rightChild;
-    NumericRangeNode_Free(leftChild);
+    NumericRangeNode_Retire(t, leftChild);
   }
   rv->numRanges--;
   return CHILD_NOT_EMPTY;
@@ -507,13 +726,229 @@ int NumericRangeNode_RemoveChild(NumericRangeNode **node, NRN_AddRv *rv) {
 NRN_AddRv NumericRangeTree_TrimEmptyLeaves(NumericRangeTree *t) {
   NRN_AddRv rv = {.numRanges = 0,
                   .changed = 0 };
-  NumericRangeNode_RemoveChild(&t->root, &rv);
+  NumericRangeNode_RemoveChild(t, &t->root, &rv);
+  return rv;
+}
+
+/* The shape of a subtree, as measured by the rebalancing. Inner nodes always have two children */
+typedef struct {
+  size_t leaves;
+  int depth;
+} NRN_Shape;
+
+static NRN_Shape NumericRangeNode_Shape(NumericRangeNode *n) {
+  if (NumericRangeNode_IsLeaf(n)) {
+    return (NRN_Shape){.leaves = 1, .depth = 0};
+  }
+  NRN_Shape l = NumericRangeNode_Shape(n->left);
+  NRN_Shape r = NumericRangeNode_Shape(n->right);
+  return (NRN_Shape){.leaves = l.leaves + r.leaves, .depth = MAX(l.depth, r.depth) + 1};
+}
+
+/* A subtree is skewed once it is more than twice as deep as a balanced tree of its leaves */
+static int NumericRangeNode_IsSkewed(NRN_Shape s) {
+  int balanced = 0;
+  while (((size_t)1 << balanced) < s.leaves) ++balanced;
+  return s.depth > 2 * balanced + NR_MAX_DEPTH_BALANCE;
+}
+
+/* Two adjacent leaves are merged if they hold few entries together, and few enough distinct values
+ * for the merged leaf not to split again soon */
+static int NumericRangeNode_CanMerge(NumericRangeNode *a, NumericRangeNode *b) {
+  NumericRange *ra = a->range, *rb = b->range;
+  if (ra->bkd != rb->bkd || ra->entries->numEntries + rb->entries->numEntries >= NR_SPARSE_LEAF_SIZE) {
+    return 0;
+  }
+  return ra->bkd || 2 * (ra->card + rb->card) * NR_CARD_CHECK < MAX(ra->splitCard, rb->splitCard);
+}
+
+/* Merge two adjacent leaves into a new one, retiring their ranges */
+static NumericRangeNode *NumericRangeNode_MergeLeaves(NumericRangeTree *t, NumericRangeNode *a,
+                                                      NumericRangeNode *b) {
+  NumericRange *ra = a->range, *rb = b->range;
+  NumericRangeNode *n = NewLeafNode(ra->entries->numEntries + rb->entries->numEntries + 1,
+                                    MAX(ra->splitCard, rb->splitCard));
+  if (ra->bkd) {
+    NumericRangeNode_SetBKD(n);
+  }
+
+  // both indexes are sorted by docId, so they are interleaved into the merged one
+  RSIndexResult *resa = NULL, *resb = NULL;
+  IndexReader *ira = NewNumericReader(NULL, ra->entries, NULL, 0, 0, false);
+  IndexReader *irb = NewNumericReader(NULL, rb->entries, NULL, 0, 0, false);
+  int rca = IR_Read(ira, &resa), rcb = IR_Read(irb, &resb);
+  while (rca == INDEXREAD_OK || rcb == INDEXREAD_OK) {
+    int fromA = rca == INDEXREAD_OK && (rcb != INDEXREAD_OK || resa->docId <= resb->docId);
+    RSIndexResult *res = fromA ? resa : resb;
+    NumericRange_Add(n->range, res->docId, res->num.value, !ra->bkd);
+    if (fromA) {
+      rca = IR_Read(ira, &resa);
+    } else {
+      rcb = IR_Read(irb, &resb);
+    }
+  }
+  IR_Free(ira);
+  IR_Free(irb);
+
+  EpochDomain_Retire(t->epochs, ra, NumericRange_Free);
+  EpochDomain_Retire(t->epochs, rb, NumericRange_Free);
+  rm_free(a);
+  rm_free(b);
+  return n;
+}
+
+/* Collect the leaves under a node in value order, and the values of the inner nodes between them,
+ * so that `splits[i]` separates `leaves[i]` from `leaves[i + 1]`. Sparse adjacent leaves are merged
+ * on the way. The inner nodes are freed, and the ranges they retained are retired */
+static void NumericRangeNode_Flatten(NumericRangeTree *t, NumericRangeNode *n,
+                                     NumericRangeNode ***leaves, double **splits, NRN_AddRv *rv) {
+  if (NumericRangeNode_IsLeaf(n)) {
+    size_t len = array_len(*leaves);
+    if (len && NumericRangeNode_CanMerge((*leaves)[len - 1], n)) {
+      (*leaves)[len - 1] = NumericRangeNode_MergeLeaves(t, (*leaves)[len - 1], n);
+      *splits = array_trimm_len(*splits, 1);
+      rv->numRanges--;
+    } else {
+      array_append(*leaves, n);
+    }
+    return;
+  }
+
+  NumericRangeNode_Flatten(t, n->left, leaves, splits, rv);
+  array_append(*splits, n->value);
+  NumericRangeNode_Flatten(t, n->right, leaves, splits, rv);
+  removeRange(t, n, rv);
+  rm_free(n);
+}
+
+/* Build a balanced subtree over leaves[lo, hi) */
+static NumericRangeNode *NumericRangeNode_Build(NumericRangeNode **leaves, double *splits,
+                                                size_t lo, size_t hi) {
+  if (hi - lo == 1) {
+    return leaves[lo];
+  }
+  size_t mid = (lo + hi) / 2;
+  NumericRangeNode *n = rm_malloc(sizeof(*n));
+  n->value = splits[mid - 1];
+  n->range = NULL;
+  n->left = NumericRangeNode_Build(leaves, splits, lo, mid);
+  n->right = NumericRangeNode_Build(leaves, splits, mid, hi);
+  n->maxDepth = MAX(n->left->maxDepth, n->right->maxDepth) + 1;
+  return n;
+}
+
+/* Rebuild the highest skewed subtrees under a node, and merge the sparse sibling leaves of the
+ * others, fixing the depths of the nodes on the way back up */
+static void NumericRangeNode_Rebalance(NumericRangeTree *t, NumericRangeNode **np, NRN_AddRv *rv) {
+  NumericRangeNode *n = *np;
+  if (NumericRangeNode_IsLeaf(n)) {
+    return;
+  }
+
+  NRN_Shape shape = NumericRangeNode_Shape(n);
+  if (NumericRangeNode_IsSkewed(shape)) {
+    NumericRangeNode **leaves = array_new(NumericRangeNode *, shape.leaves);
+    double *splits = array_new(double, shape.leaves);
+    NumericRangeNode_Flatten(t, n, &leaves, &splits, rv);
+    *np = NumericRangeNode_Build(leaves, splits, 0, array_len(leaves));
+    array_free(leaves);
+    array_free(splits);
+    rv->changed = 1;
+    return;
+  }
+
+  NumericRangeNode_Rebalance(t, &n->left, rv);
+  NumericRangeNode_Rebalance(t, &n->right, rv);
+  if (NumericRangeNode_IsLeaf(n->left) && NumericRangeNode_IsLeaf(n->right) &&
+      NumericRangeNode_CanMerge(n->left, n->right)) {
+    removeRange(t, n, rv);
+    *np = NumericRangeNode_MergeLeaves(t, n->left, n->right);
+    rm_free(n);
+    rv->numRanges--;
+    rv->changed = 1;
+    return;
+  }
+  n->maxDepth = MAX(n->left->maxDepth, n->right->maxDepth) + 1;
+}
+
+NRN_AddRv NumericRangeTree_Rebalance(NumericRangeTree *t) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_NUMERIC);
+  NRN_AddRv rv = {.numRanges = 0, .changed = 0};
+  NumericRangeNode_Rebalance(t, &t->root, &rv);
+  // the ranges moved, running queries keep reading the retired ones
+  if (rv.changed) {
+    t->revisionId++;
+  }
+  AllocStats_SetTag(prevTag);
   return rv;
 }
 
 void NumericRangeTree_Free(NumericRangeTree *t) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_NUMERIC);
   NumericRangeNode_Free(t->root);
+  EpochDomain_Release(t->epochs);
+  array_free(t->histogram.buckets);
   rm_free(t);
+  AllocStats_SetTag(prevTag);
+}
+
+static int cmpEntryDocId(const void *p1, const void *p2) {
+  const NumericRangeEntry *e1 = p1, *e2 = p2;
+  if (e1->docId != e2->docId) {
+    return (e1->docId > e2->docId) - (e1->docId < e2->docId);
+  }
+  return (e1->value > e2->value) - (e1->value < e2->value);
+}
+
+/* Iterate the docs of a range matching a numeric filter using the range's sorted column. Only the
+ * sorted entries within the filter bounds and the short unsorted tail are inspected. As with the
+ * numeric reader, every doc yields a numeric record, of which the docs of multi-value fields yield
+ * one, with their lowest matching value */
+static IndexIterator *NumericRange_IterateColumn(const NumericRange *nr, const NumericFilter *f) {
+  const NumericRangeEntry *col = nr->column;
+  uint32_t len = array_len(col), nsorted = nr->columnSorted;
+
+  // find the first sorted entry which is not below the filter
+  uint32_t lo = 0, hi = nsorted;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (col[mid].value < f->min) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  NumericRangeEntry *matches = array_new(NumericRangeEntry, 16);
+  for (uint32_t i = lo; i < nsorted && col[i].value <= f->max; ++i) {
+    if (NumericFilter_Match(f, col[i].value)) {
+      matches = array_append(matches, col[i]);
+    }
+  }
+  for (uint32_t i = nsorted; i < len; ++i) {
+    if (NumericFilter_Match(f, col[i].value)) {
+      matches = array_append(matches, col[i]);
+    }
+  }
+
+  uint32_t n = array_len(matches);
+  qsort(matches, n, sizeof(*matches), cmpEntryDocId);
+  t_docId *ids = rm_malloc(MAX(n, 1) * sizeof(*ids));
+  double *values = rm_malloc(MAX(n, 1) * sizeof(*values));
+  uint32_t k = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (k && ids[k - 1] == matches[i].docId) {
+      continue;
+    }
+    ids[k] = matches[i].docId;
+    values[k++] = matches[i].value;
+  }
+  array_free(matches);
+
+  IndexIterator *it = NewNumericIdListIterator(ids, values, k);
+  // numeric readers have no criteria tester either; without one, a union of ranges stays sorted
+  it->GetCriteriaTester = NULL;
+  return it;
 }
 
 IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
@@ -526,12 +961,87 @@ IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
       NumericFilter_Match(f, nr->minVal) && NumericFilter_Match(f, nr->maxVal)) {
     // make the filter NULL so the reader will ignore it
     f = NULL;
+  } else if (nr->column && NumericFilter_IsNumeric(f)) {
+    return NumericRange_IterateColumn(nr, f);
   }
   IndexReader *ir = NewNumericReader(sp, nr->entries, f, nr->minVal, nr->maxVal, skipMulti);
 
   return NewReadIterator(ir);
 }
 
+typedef struct {
+  IndexCriteriaTester base;
+  const DocTable *docs;
+  NumericFilter nf;
+  int sortIdx;
+} NumericSortingTester;
+
+static bool numericSortingTester_Match(const NumericFilter *f, const RSValue *v) {
+  v = RSValue_Dereference(v);
+  if (v->t == RSValue_Number) {
+    return NumericFilter_Match(f, v->numval);
+  }
+  if (v->t == RSValue_Array) {
+    // the values of a multi-value field, any of them may match
+    for (uint32_t i = 0; i < RSVALUE_ARRLEN(v); ++i) {
+      if (numericSortingTester_Match(f, RSVALUE_ARRELEM(v, i))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static int NumericSortingTester_Test(IndexCriteriaTester *ct, t_docId id) {
+  NumericSortingTester *nt = (NumericSortingTester *)ct;
+  const RSDocumentMetadata *dmd = DocTable_Borrow(nt->docs, id);
+  if (!dmd) {
+    return 0;
+  }
+  int rc = 0;
+  double num;
+  if (!dmd->sortVector) {
+    // no sortable values
+  } else if (RSSortingVector_GetNumber(dmd->sortVector, nt->sortIdx, &num)) {
+    rc = NumericFilter_Match(&nt->nf, num);
+  } else {
+    RSValue *v = RSSortingVector_Get(dmd->sortVector, nt->sortIdx);
+    rc = v && numericSortingTester_Match(&nt->nf, v);
+  }
+  DMD_Return(dmd);
+  return rc;
+}
+
+static void NumericSortingTester_Free(IndexCriteriaTester *ct) {
+  rm_free(ct);
+}
+
+/* Test documents against a numeric filter by the values in their sorting vectors, instead of
+ * skipping through the ranges of the tree. Only sortable numeric fields have their values there,
+ * returns NULL for any other filter */
+static IndexCriteriaTester *NewNumericSortingTester(const IndexSpec *sp, const NumericFilter *f) {
+  if (!f || !NumericFilter_IsNumeric(f) || !f->fieldName) {
+    return NULL;
+  }
+  const FieldSpec *fs = IndexSpec_GetField(sp, f->fieldName, strlen(f->fieldName));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsSortable(fs) || fs->sortIdx < 0) {
+    return NULL;
+  }
+  NumericSortingTester *nt = rm_malloc(sizeof(*nt));
+  nt->docs = &sp->docs;
+  nt->nf = *f;
+  nt->nf.fieldName = NULL;
+  nt->sortIdx = fs->sortIdx;
+  nt->base.Test = NumericSortingTester_Test;
+  nt->base.Free = NumericSortingTester_Free;
+  return &nt->base;
+}
+
+// The number of ranges of a multi-value field from which a filter merges them in docid bitmap
+// windows, as long as they hold a document every NR_MULTI_BITMAP_MAX_GAP docids on average
+#define NR_MULTI_BITMAP_MIN_RANGES 8
+#define NR_MULTI_BITMAP_MAX_GAP 64
+
 /* Create a union iterator from the numeric filter, over all the sub-ranges in the tree that fit
  * the filter */
 IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
@@ -545,6 +1055,10 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
     return NULL;
   }
 
+  // the ranges at the edges of the filter are only partially matched, so their sizes say little.
+  // the optimizer pages through the ranges of limited filters by their sizes, these keep them
+  size_t estimate = f && !f->limit ? NumericRangeTree_EstimateMatches(t, f) : 0;
+
   int n = Vector_Size(v);
   // if we only selected one range - we can just iterate it without union or anything
   if (n == 1) {
@@ -552,6 +1066,10 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
     Vector_Get(v, 0, &rng);
     IndexIterator *it = NewNumericRangeIterator(sp, rng, f, true);
     Vector_Free(v);
+    if (estimate && it->type == READ_ITERATOR) {
+      IndexReader *ir = it->ctx;
+      ir->numEstimated = MIN(estimate, ir->idx->numDocs);
+    }
     return it;
   }
 
@@ -572,6 +1090,21 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
 
   QueryNodeType type = (!f || NumericFilter_IsNumeric(f)) ? QN_NUMERIC : QN_GEO;
   IndexIterator *it = NewUnionIterator(its, n, NULL, 1, 1, type, NULL, config);
+  // the ranges of a multi-value field yield the same documents over and over, merging them costs a
+  // heap or tournament update per value where a bitmap window sets a bit, for queries which need no
+  // records. geo filters keep their records, which hold the distances
+  if (t->multiValued && type == QN_NUMERIC && n >= NR_MULTI_BITMAP_MIN_RANGES &&
+      IITER_NUM_ESTIMATED(it) * NR_MULTI_BITMAP_MAX_GAP >= sp->docs.maxDocId) {
+    UI_AllowBitmapMerge(it);
+  }
+  if (estimate && estimate < IITER_NUM_ESTIMATED(it)) {
+    UI_SetNumEstimated(it, estimate);
+  }
+  // an intersection may rather test its documents against a broad filter than skip through it
+  IndexCriteriaTester *tester = NewNumericSortingTester(sp, f);
+  if (tester) {
+    UI_SetCriteriaTester(it, tester);
+  }
 
   return it;
 }
@@ -630,11 +1163,12 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
 
   if (csx) {
     NumericUnionCtx *uc = rm_malloc(sizeof(*uc));
-    uc->lastRevId = t->revisionId;
     uc->it = it;
     uc->sp = ctx->spec;
     uc->fieldName = flt->fieldName;
-    ConcurrentSearch_AddKey(csx, NumericRangeIterator_OnReopen, uc, rm_free);
+    uc->epochs = t->epochs;
+    uc->epoch = EpochDomain_Pin(t->epochs);
+    ConcurrentSearch_AddKey(csx, NumericRangeIterator_OnReopen, uc, numericUnionCtx_Free);
   }
   return it;
 }
@@ -677,7 +1211,10 @@ void __numericIndex_memUsageCallback(NumericRangeNode *n, void *ctx) {
 
   if (n->range) {
     *sz += sizeof(NumericRange);
-    *sz += n->range->card * sizeof(double);
+    *sz += KMV_MemUsage(&n->range->cardSketch);
+    if (n->range->column) {
+      *sz += array_len(n->range->column) * sizeof(NumericRangeEntry);
+    }
     if (n->range->entries) {
       *sz += InvertedIndex_MemUsage(n->range->entries);
     }
@@ -687,11 +1224,11 @@ void __numericIndex_memUsageCallback(NumericRangeNode *n, void *ctx) {
 unsigned long NumericIndexType_MemUsage(const void *value) {
   const NumericRangeTree *t = value;
   unsigned long ret = sizeof(NumericRangeTree);
+  ret += array_len(t->histogram.buckets) * sizeof(NumericHistogramBucket);
   NumericRangeNode_Traverse(t->root, __numericIndex_memUsageCallback, &ret);
   return ret;
 }
 
-#define NUMERIC_INDEX_ENCVER 1
 
 int NumericIndexType_Register(RedisModuleCtx *ctx) {
 
@@ -710,13 +1247,6 @@ int NumericIndexType_Register(RedisModuleCtx *ctx) {
   return REDISMODULE_OK;
 }
 
-/* A single entry in a numeric index's single range. Since entries are binned together, each needs
- * to have the exact value */
-typedef struct {
-  t_docId docId;
-  double value;
-} NumericRangeEntry;
-
 static int cmpdocId(const void *p1, const void *p2) {
   NumericRangeEntry *e1 = (NumericRangeEntry *)p1;
   NumericRangeEntry *e2 = (NumericRangeEntry *)p2;
@@ -772,15 +1302,20 @@ void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver) {
     return NULL;  // Unknown version
   }
 
+  NumericRangeTree *t = NumericRangeTree_FromEntries(entries, numEntries);
+  array_free(entries);
+  return t;
+}
+
+NumericRangeTree *NumericRangeTree_FromEntries(NumericRangeEntry *entries, size_t n) {
   // sort the entries by doc id, as they were not saved in this order
-  qsort(entries, numEntries, sizeof(NumericRangeEntry), cmpdocId);
+  qsort(entries, n, sizeof(NumericRangeEntry), cmpdocId);
   NumericRangeTree *t = NewNumericRangeTree();
 
   // now push them in order into the tree
-  for (size_t i = 0; i < numEntries; i++) {
+  for (size_t i = 0; i < n; i++) {
     NumericRangeTree_Add(t, entries[i].docId, entries[i].value, true);
   }
-  array_free(entries);
   return t;
 }
 
@@ -853,18 +1388,14 @@ void IndexReader_Reopen(IndexReader *ir, void *privdata) {
   // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
   if (ir->gcMarker == ir->idx->gcMarker) {
     // no GC - we just go to the same offset we were at
-    size_t offset = ir->br.pos;
-    ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-    ir->br.pos = offset;
+    IndexReader_ResumeBlock(ir);
   } else {
     // if there has been a GC cycle on this key while we were asleep, the offset might not be valid
     // anymore. This means that we need to seek to last docId we were at
 
-    // reset the state of the reader
+    // reset the state of the reader, along with the block it may have decoded
     t_docId lastId = ir->lastId;
-    ir->currentBlock = 0;
-    ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-    ir->lastId = ir->idx->blocks[ir->currentBlock].firstId;
+    IndexReader_SetBlock(ir, 0);
 
     // seek to the previous last id
     RSIndexResult *dummy = NULL;
@@ -873,8 +1404,8 @@ void IndexReader_Reopen(IndexReader *ir, void *privdata) {
 }
 
 /* A callback called after a concurrent context regains execution context. When this happen we need
- * to make sure the key hasn't been deleted or its structure changed, which will render the
- * underlying iterators invalid */
+ * to make sure the key hasn't been deleted. Splits and trims of the tree do not invalidate the
+ * iterators: the ranges they read are pinned, and only receive documents the query does not need */
 void NumericRangeIterator_OnReopen(void *privdata) {
   NumericUnionCtx *nu = privdata;
   IndexSpec *sp = nu->sp;
@@ -883,9 +1414,8 @@ void NumericRangeIterator_OnReopen(void *privdata) {
   RedisModuleString *numField = IndexSpec_GetFormattedKeyByName(sp, nu->fieldName, INDEXFLD_T_NUMERIC);
   NumericRangeTree *rt = openNumericKeysDict(sp, numField, 0);
 
-  if (!rt || rt->revisionId != nu->lastRevId) {
-    // The numeric tree was either completely deleted or a node was splitted or removed.
-    // The cursor is invalidated.
+  if (!rt || rt->epochs != nu->epochs) {
+    // The numeric tree was deleted, the cursor is invalidated.
     it->Abort(it->ctx);
     return;
   }
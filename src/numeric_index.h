@@ -17,6 +17,8 @@
 #include "concurrent_ctx.h"
 #include "inverted_index.h"
 #include "numeric_filter.h"
+#include "util/kmv.h"
+#include "util/epoch.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,10 +26,12 @@ extern "C" {
 
 #define NR_CARD_CHECK 10
 
+/* A single entry in a numeric index's single range. Since entries are binned together, each needs
+ * to have the exact value */
 typedef struct {
+  t_docId docId;
   double value;
-  size_t appearances;
-} CardinalityValue;
+} NumericRangeEntry;
 
 /* A numeric range is a node in a numeric range tree, representing a range of values bunched
  * toghether.
@@ -39,15 +43,27 @@ typedef struct {
   double minVal;
   double maxVal;
 
-  double unique_sum;
-
   size_t invertedIndexSize;
 
+  // Every NR_CARD_CHECK-th value added is sampled into the sketch, and `card` is its estimate of
+  // their distinct values. The range splits at the median of the sketch once `card` reaches
+  // `splitCard` / NR_CARD_CHECK
   u_int16_t card;
   u_int16_t cardCheck;
   uint32_t splitCard;
-  CardinalityValue *values;
+  KMVSketch cardSketch;
   InvertedIndex *entries;
+
+  // A copy of the leaf's entries ordered by value, so filters which only partially overlap the
+  // range can binary search it instead of decoding every posting. The first `columnSorted`
+  // entries are sorted, the rest is a short tail of recent additions. NULL unless the
+  // NUMERIC_SORTED_COLUMN config is set, and dropped once the leaf splits
+  NumericRangeEntry *column;
+  uint32_t columnSorted;
+
+  // Set on the ranges of BKD fields (see NumericRangeTree_SetBKD). Their leaves split at their
+  // median value once they hold NR_BKD_LEAF_SIZE entries, and always keep a column
+  uint8_t bkd;
 } NumericRange;
 
 /* NumericRangeNode is a node in the range tree that can have a range in it or not, and can be a
@@ -72,6 +88,26 @@ typedef struct {
   NumericRangeNode **nodesStack;
 } NumericRangeTreeIterator;
 
+// The number of buckets a numeric tree's histogram aims at
+#define NR_HISTOGRAM_BUCKETS 64
+
+/* A run of adjacent leaves in the histogram of a numeric tree */
+typedef struct {
+  double minVal;
+  double maxVal;
+  size_t numDocs;
+  size_t card;
+} NumericHistogramBucket;
+
+/* An equi-depth histogram of a numeric tree's values. Adjacent leaves are merged into buckets of
+ * about the same number of documents, so filters are estimated without walking the tree. Values
+ * added later are counted in the bucket they fall in, and the histogram is rebuilt from the leaves
+ * once the tree doubles in size, or by the GC */
+typedef struct {
+  NumericHistogramBucket *buckets;  // sorted by value
+  size_t numEntries;                // the entries of the tree when the histogram was built
+} NumericHistogram;
+
 /* The root tree and its metadata */
 typedef struct {
   NumericRangeNode *root;
@@ -85,6 +121,15 @@ typedef struct {
 
   size_t emptyLeaves;
 
+  NumericHistogram histogram;
+
+  // Set once a document added several values, from when the ranges of the tree may share documents
+  uint8_t multiValued;
+
+  // The ranges unlinked from the tree by splits and by the GC are retired here rather than freed,
+  // as the queries which released the lock of the index may still be reading them. Each query
+  // pins the epoch it opened the tree at, so it keeps reading the ranges it started with
+  EpochDomain *epochs;
 } NumericRangeTree;
 
 #define NumericRangeNode_IsLeaf(n) (n->left == NULL && n->right == NULL)
@@ -100,6 +145,13 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
  * No deduplication is done */
 size_t NumericRange_Add(NumericRange *r, t_docId docId, double value, int checkCard);
 
+/* Replace the cardinality sketch of a range, taking the ownership of `sketch`. The GC rebuilds it
+ * from the entries which remain, as values cannot be removed from it */
+void NumericRange_SetCardSketch(NumericRange *n, KMVSketch *sketch);
+
+/* Rebuild the column of a range from its entries, after some of them were garbage collected */
+void NumericRange_RebuildColumn(NumericRange *n);
+
 /* Split n into two ranges, lp for left, and rp for right. We split by the median score */
 double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNode **rp,
                           NRN_AddRv *rv);
@@ -107,9 +159,11 @@ double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNo
 /* Create a new range node with the given capacity, minimum and maximum values */
 NumericRangeNode *NewLeafNode(size_t cap, size_t splitCard);
 
-/* Add a value to a tree node or its children recursively. Splits the relevant node if needed.
+/* Add a value to a tree node or its children recursively. Splits the relevant node if needed, and
+ * retires the ranges it no longer retains to the epochs of the tree.
  * Returns 0 if no nodes were split, 1 if we splitted nodes */
-NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value);
+NRN_AddRv NumericRangeNode_Add(NumericRangeTree *t, NumericRangeNode *n, t_docId docId,
+                               double value);
 
 /* Recursively find all the leaves under a node that correspond to a given min-max range. Returns a
  * vector with range node pointers.  */
@@ -121,9 +175,22 @@ void NumericRangeNode_Free(NumericRangeNode *n);
 /* Recursively trim empty nodes from tree  */
 NRN_AddRv NumericRangeTree_TrimEmptyLeaves(NumericRangeTree *t);
 
+/* Rebuild the subtrees which grew much deeper than a balanced tree of their leaves, as trees of
+ * increasing values do, and merge the adjacent leaves left sparse by the GC. The unlinked ranges
+ * are retired to the epochs of the tree, and its revision is bumped if it changed. Frees nodes, so
+ * it is only run by the GC after it is done with the tree. Returns the change in the number of
+ * ranges */
+NRN_AddRv NumericRangeTree_Rebalance(NumericRangeTree *t);
+
 /* Create a new tree */
 NumericRangeTree *NewNumericRangeTree();
 
+/* Index the values of an empty tree BKD style: leaves are kept balanced in size rather than in
+ * cardinality, and are searched through their sorted column. Suits high cardinality values, such
+ * as timestamps, which otherwise split into deep trees of small ranges. Does nothing if the tree
+ * already holds entries */
+void NumericRangeTree_SetBKD(NumericRangeTree *t);
+
 /* Add a value to a tree. Returns 0 if no nodes were split, 1 if we splitted nodes */
 NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value, int isMulti);
 
@@ -135,15 +202,27 @@ int NumericRangeTree_DeleteNode(NumericRangeTree *t, double value);
  * Returns a vector with range node pointers. */
 Vector *NumericRangeTree_Find(NumericRangeTree *t, const NumericFilter *nf);
 
+/* Rebuild the histogram of the tree from its leaves */
+void NumericRangeTree_RefreshHistogram(NumericRangeTree *t);
+
+/* Estimate the number of documents a filter matches, using the tree's histogram */
+size_t NumericRangeTree_EstimateMatches(const NumericRangeTree *t, const NumericFilter *f);
+
 /* Free the tree and all nodes */
 void NumericRangeTree_Free(NumericRangeTree *t);
 
+/* Build a tree of the (doc id, value) entries of a loaded index, sorting them by doc id first */
+NumericRangeTree *NumericRangeTree_FromEntries(NumericRangeEntry *entries, size_t n);
+
 extern RedisModuleType *NumericIndexType;
 
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey);
 
 int NumericIndexType_Register(RedisModuleCtx *ctx);
+
+#define NUMERIC_INDEX_ENCVER 1
+
 void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver);
 void NumericIndexType_RdbSave(RedisModuleIO *rdb, void *value);
 void NumericIndexType_Digest(RedisModuleDigest *digest, void *value);
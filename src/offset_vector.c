@@ -7,9 +7,11 @@
 #include <pthread.h>
 
 #include "redisearch.h"
+#include "index_result.h"
 #include "varint.h"
 #include "rmalloc.h"
 #include "util/mempool.h"
+#include "util/bitpack.h"
 #include <sys/param.h>
 
 /* We have two types of offset vector iterators - for terms and for aggregates. For terms we simply
@@ -18,12 +20,18 @@
  * callbacks and context matching the appropriate implementation.
  */
 
-/* A raw offset vector iterator */
+/* A raw offset vector iterator. Packed vectors are decoded a frame at a time into `frame` */
 typedef struct {
   Buffer buf;
   BufferReader br;
   uint32_t lastValue;
   RSQueryTerm *term;
+  int packed;
+  // the number of deltas left in the frames of a packed vector
+  uint32_t remaining;
+  uint16_t framePos;
+  uint16_t frameLen;
+  uint32_t frame[VVW_PACKED_FRAME_SIZE];
 } _RSOffsetVectorIterator;
 
 typedef struct {
@@ -41,6 +49,85 @@ uint32_t _ovi_Next(void *ctx, RSQueryTerm **t);
 /* Rewind the iterator */
 void _ovi_Rewind(void *ctx);
 
+/* Start reading the vector from the beginning */
+static void _ovi_Start(_RSOffsetVectorIterator *it) {
+  it->br = NewBufferReader(&it->buf);
+  it->lastValue = 0;
+  it->remaining = 0;
+  it->framePos = it->frameLen = 0;
+  if (it->packed && !BufferReader_AtEnd(&it->br)) {
+    uint32_t header = ReadVarint(&it->br);
+    if (header & 1) {
+      it->remaining = header >> 1;
+    } else {
+      // A plain varint vector, the header is its first delta
+      it->frame[0] = header >> 1;
+      it->frameLen = 1;
+    }
+  }
+}
+
+/* Decode the next frame of a packed vector */
+static void _ovi_ReadFrame(_RSOffsetVectorIterator *it) {
+  BufferReader *br = &it->br;
+  uint16_t len = MIN(it->remaining, VVW_PACKED_FRAME_SIZE);
+  uint8_t width = BUFFER_READ_BYTE(br);
+  uint8_t nexc = BUFFER_READ_BYTE(br);
+  Buffer_Skip(br, BitPack_Unpack((const uint8_t *)BufferReader_Current(br), len, width, it->frame));
+  while (nexc--) {
+    uint8_t pos = BUFFER_READ_BYTE(br);
+    it->frame[pos] |= ReadVarint(br) << width;
+  }
+  it->remaining -= len;
+  it->framePos = 0;
+  it->frameLen = len;
+}
+
+uint32_t RSOffsetVector_Decode(const RSOffsetVector *v, uint32_t *out, uint32_t cap) {
+  Buffer buf = {.data = v->data, .offset = v->len, .cap = v->len};
+  BufferReader reader = NewBufferReader(&buf);
+  BufferReader *br = &reader;
+  uint32_t n = 0, remaining = 0;
+  if (v->packed && !BufferReader_AtEnd(br)) {
+    uint32_t header = ReadVarint(br);
+    if (header & 1) {
+      remaining = header >> 1;
+      if (remaining > cap) {
+        return cap + 1;
+      }
+    } else if (cap) {
+      out[n++] = header >> 1;
+    } else {
+      return 1;
+    }
+  }
+  while (remaining) {
+    uint16_t len = MIN(remaining, VVW_PACKED_FRAME_SIZE);
+    uint32_t *frame = out + n;
+    uint8_t width = BUFFER_READ_BYTE(br);
+    uint8_t nexc = BUFFER_READ_BYTE(br);
+    Buffer_Skip(br, BitPack_Unpack((const uint8_t *)BufferReader_Current(br), len, width, frame));
+    while (nexc--) {
+      uint8_t pos = BUFFER_READ_BYTE(br);
+      frame[pos] |= ReadVarint(br) << width;
+    }
+    remaining -= len;
+    n += len;
+  }
+  while (!BufferReader_AtEnd(br)) {
+    if (n == cap) {
+      return cap + 1;
+    }
+    out[n++] = ReadVarint(br);
+  }
+
+  // the deltas to offsets
+  for (uint32_t i = 1; i < n; ++i) {
+    out[i] += out[i - 1];
+  }
+  return n;
+}
+
 /* memory pool for buffer iterators */
 static pthread_key_t __offsetIters;
 static pthread_key_t __aggregateIters;
@@ -69,9 +156,9 @@ RSOffsetIterator RSOffsetVector_Iterate(const RSOffsetVector *v, RSQueryTerm *t)
   }
   _RSOffsetVectorIterator *it = mempool_get(pool);
   it->buf = (Buffer){.data = v->data, .offset = v->len, .cap = v->len};
-  it->br = NewBufferReader(&it->buf);
-  it->lastValue = 0;
+  it->packed = v->packed;
   it->term = t;
+  _ovi_Start(it);
 
   return (RSOffsetIterator){.Next = _ovi_Next, .Rewind = _ovi_Rewind, .Free = _ovi_free, .ctx = it};
 }
@@ -166,10 +253,7 @@ RSOffsetIterator RSIndexResult_IterateOffsets(const RSIndexResult *res) {
 
 /* Rewind an offset vector iterator and start reading it from the beginning. */
 void _ovi_Rewind(void *ctx) {
-  _RSOffsetVectorIterator *it = ctx;
-  it->lastValue = 0;
-  it->buf.offset = 0;
-  it->br.pos = 0;
+  _ovi_Start(ctx);
 }
 
 void _ovi_Free(void *ctx) {
@@ -179,13 +263,18 @@ void _ovi_Free(void *ctx) {
 uint32_t _ovi_Next(void *ctx, RSQueryTerm **t) {
   _RSOffsetVectorIterator *vi = ctx;
 
-  if (!BufferReader_AtEnd(&vi->br)) {
+  if (vi->framePos == vi->frameLen && vi->remaining) {
+    _ovi_ReadFrame(vi);
+  }
+  if (vi->framePos < vi->frameLen) {
+    vi->lastValue += vi->frame[vi->framePos++];
+  } else if (!vi->remaining && !BufferReader_AtEnd(&vi->br)) {
     vi->lastValue = ReadVarint(&vi->br) + vi->lastValue;
-    if (t) *t = vi->term;
-    return vi->lastValue;
+  } else {
+    return RS_OFFSETVECTOR_EOF;
   }
-
-  return RS_OFFSETVECTOR_EOF;
+  if (t) *t = vi->term;
+  return vi->lastValue;
 }
 
 uint32_t _aoi_Next(void *ctx, RSQueryTerm **t) {
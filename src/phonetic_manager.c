@@ -9,6 +9,48 @@
 #include <string.h>
 #include <stdlib.h>
 #include "rmalloc.h"
+#include "util/fnv.h"
+#include <pthread.h>
+
+/* The phonetic codes of the latest terms of each thread, as the same terms are met again and again
+ * while indexing. The codes have up to 4 characters */
+#define PHONETIC_CACHE_SIZE 1024
+#define PHONETIC_CACHE_TERM_MAX 24
+#define PHONETIC_CODE_MAX 6
+
+typedef struct {
+  char term[PHONETIC_CACHE_TERM_MAX];
+  size_t len;                          // 0 for an empty slot
+  char primary[PHONETIC_CODE_MAX];     // with the prefix, empty if the term has no code
+  char secondary[PHONETIC_CODE_MAX];
+} phoneticCacheEntry;
+
+static pthread_key_t phoneticCacheKey_g;
+
+static void __attribute__((constructor)) initPhoneticCacheKey() {
+  pthread_key_create(&phoneticCacheKey_g, rm_free);
+}
+
+static phoneticCacheEntry *getPhoneticCache() {
+  phoneticCacheEntry *cache = pthread_getspecific(phoneticCacheKey_g);
+  if (!cache) {
+    cache = rm_calloc(PHONETIC_CACHE_SIZE, sizeof(*cache));
+    pthread_setspecific(phoneticCacheKey_g, cache);
+  }
+  return cache;
+}
+
+static void setCode(char *dst, const char *code) {
+  if (code && strlen(code) < PHONETIC_CODE_MAX) {
+    strcpy(dst, code);
+  } else {
+    dst[0] = '\0';
+  }
+}
+
+static char *getCode(const char *code) {
+  return code[0] ? rm_strdup(code) : NULL;
+}
 
 static void PhoneticManager_AddPrefix(char** phoneticTerm) {
   if (!phoneticTerm || !(*phoneticTerm)) {
@@ -24,10 +66,38 @@ void PhoneticManager_ExpandPhonetics(PhoneticManagerCtx* ctx, const char* term,
                                      char** primary, char** secondary) {
   // currently ctx is irrelevant we support only one universal algorithm for all 4 languages
   // this phonetic manager was built for future thinking and easily add more algorithms
+  phoneticCacheEntry *ent = NULL;
+  if (len && len <= PHONETIC_CACHE_TERM_MAX) {
+    ent = getPhoneticCache() + rs_fnv_32a_buf(term, len, 0) % PHONETIC_CACHE_SIZE;
+    if (ent->len == len && !memcmp(ent->term, term, len)) {
+      if (primary) *primary = getCode(ent->primary);
+      if (secondary) *secondary = getCode(ent->secondary);
+      return;
+    }
+  }
+
   char bufTmp[len + 1];
   bufTmp[len] = 0;
   memcpy(bufTmp, term, len);
-  DoubleMetaphone(bufTmp, primary, secondary);
-  PhoneticManager_AddPrefix(primary);
-  PhoneticManager_AddPrefix(secondary);
+  char *p = NULL, *s = NULL;
+  DoubleMetaphone(bufTmp, &p, &s);
+  PhoneticManager_AddPrefix(&p);
+  PhoneticManager_AddPrefix(&s);
+
+  if (ent) {
+    memcpy(ent->term, term, len);
+    ent->len = len;
+    setCode(ent->primary, p);
+    setCode(ent->secondary, s);
+  }
+  if (primary) {
+    *primary = p;
+  } else {
+    rm_free(p);
+  }
+  if (secondary) {
+    *secondary = s;
+  } else {
+    rm_free(s);
+  }
 }
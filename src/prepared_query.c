@@ -0,0 +1,152 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "prepared_query.h"
+#include "aggregate/aggregate.h"
+#include "search_ctx.h"
+#include "stopwords.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <string.h>
+#include <strings.h>
+
+// The first arguments of FT.PREPARE and of FT.EXECUTE, before the name of the query
+#define PREPARE_NAME_ARG 1
+#define PREPARE_INDEX_ARG 2
+#define EXECUTE_PARAMS_ARG 2
+
+typedef struct {
+  // FT.SEARCH, the index, the query and its options
+  RedisModuleString **argv;
+  int argc;
+} PreparedQuery;
+
+static dict *preparedQueries_g = NULL;
+
+static void preparedQuery_Free(PreparedQuery *pq) {
+  for (int i = 0; i < pq->argc; i++) {
+    RedisModule_FreeString(NULL, pq->argv[i]);
+  }
+  rm_free(pq->argv);
+  rm_free(pq);
+}
+
+// Parse the query with its options, without binding its params
+static int parseQuery(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                      QueryError *status) {
+  const char *indexname = RedisModule_StringPtrLen(argv[0], NULL);
+  RedisSearchCtx *sctx = NULL;
+  AREQ *r = AREQ_New();
+  r->reqflags |= QEXEC_F_IS_SEARCH | QEXEC_FORMAT_DEFAULT;
+  int rc = REDISMODULE_ERR;
+
+  if (AREQ_Compile(r, argv, argc, status) != REDISMODULE_OK) {
+    goto done;
+  }
+  if (r->searchopts.params) {
+    QueryError_SetError(status, QUERY_EPARSEARGS,
+                        "PARAMS are given to FT.EXECUTE, not to FT.PREPARE");
+    goto done;
+  }
+  sctx = NewSearchCtxC(ctx, indexname, true);
+  if (!sctx) {
+    QueryError_SetErrorFmt(status, QUERY_ENOINDEX, "%s: no such index", indexname);
+    goto done;
+  }
+  if (!(r->searchopts.flags & Search_NoStopwrods)) {
+    r->searchopts.stopwords = sctx->spec->stopwords;
+    StopWordList_Ref(sctx->spec->stopwords);
+  }
+  // the params are only recorded in the nodes of the tree, they are resolved by QAST_EvalParams
+  rc = QAST_Parse(&r->ast, sctx, &r->searchopts, r->query, strlen(r->query),
+                  r->reqConfig.dialectVersion, status);
+
+done:
+  if (sctx) {
+    SearchCtx_Free(sctx);
+  }
+  AREQ_Free(r);
+  return rc;
+}
+
+int PreparedQuery_Add(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                      QueryError *status) {
+  if (parseQuery(ctx, argv + PREPARE_INDEX_ARG, argc - PREPARE_INDEX_ARG, status) !=
+      REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  PreparedQuery *pq = rm_malloc(sizeof(*pq));
+  pq->argc = argc - PREPARE_NAME_ARG;
+  pq->argv = rm_malloc(pq->argc * sizeof(*pq->argv));
+  pq->argv[0] = RedisModule_CreateString(NULL, "FT.SEARCH", strlen("FT.SEARCH"));
+  for (int i = 1; i < pq->argc; i++) {
+    pq->argv[i] = RedisModule_CreateStringFromString(NULL, argv[PREPARE_NAME_ARG + i]);
+  }
+
+  if (!preparedQueries_g) {
+    preparedQueries_g = dictCreate(&dictTypeHeapStrings, NULL);
+  }
+  const char *name = RedisModule_StringPtrLen(argv[PREPARE_NAME_ARG], NULL);
+  dictEntry *existing = NULL;
+  dictEntry *de = dictAddRaw(preparedQueries_g, (void *)name, &existing);
+  if (de) {
+    dictSetVal(preparedQueries_g, de, pq);
+  } else {
+    preparedQuery_Free(dictGetVal(existing));
+    dictSetVal(preparedQueries_g, existing, pq);
+  }
+  return REDISMODULE_OK;
+}
+
+RedisModuleString **PreparedQuery_Bind(RedisModuleString **argv, int argc, int *nargs,
+                                       QueryError *status) {
+  const char *name = RedisModule_StringPtrLen(argv[PREPARE_NAME_ARG], NULL);
+  PreparedQuery *pq = preparedQueries_g ? dictFetchValue(preparedQueries_g, name) : NULL;
+  if (!pq) {
+    QueryError_SetErrorFmt(status, QUERY_EGENERIC, "%s: no such prepared query", name);
+    return NULL;
+  }
+  if (argc > EXECUTE_PARAMS_ARG &&
+      strcasecmp(RedisModule_StringPtrLen(argv[EXECUTE_PARAMS_ARG], NULL), "PARAMS")) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Unknown argument `%s`, expected PARAMS",
+                           RedisModule_StringPtrLen(argv[EXECUTE_PARAMS_ARG], NULL));
+    return NULL;
+  }
+
+  // the params follow the options of the query, FT.SEARCH takes its options in any order
+  int nparams = argc - EXECUTE_PARAMS_ARG;
+  *nargs = pq->argc + nparams;
+  RedisModuleString **out = rm_malloc(*nargs * sizeof(*out));
+  memcpy(out, pq->argv, pq->argc * sizeof(*out));
+  memcpy(out + pq->argc, argv + EXECUTE_PARAMS_ARG, nparams * sizeof(*out));
+  return out;
+}
+
+bool PreparedQuery_Del(const char *name) {
+  PreparedQuery *pq = preparedQueries_g ? dictFetchValue(preparedQueries_g, name) : NULL;
+  if (!pq) {
+    return false;
+  }
+  dictDelete(preparedQueries_g, name);
+  preparedQuery_Free(pq);
+  return true;
+}
+
+void PreparedQuery_Clear(void) {
+  if (!preparedQueries_g) {
+    return;
+  }
+  dictIterator *it = dictGetIterator(preparedQueries_g);
+  dictEntry *de;
+  while ((de = dictNext(it))) {
+    preparedQuery_Free(dictGetVal(de));
+  }
+  dictReleaseIterator(it);
+  dictRelease(preparedQueries_g);
+  preparedQueries_g = NULL;
+}
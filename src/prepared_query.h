@@ -0,0 +1,46 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+#include "query_error.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Prepared queries, see FT.PREPARE and FT.EXECUTE.
+ *
+ * FT.PREPARE stores an FT.SEARCH under a name, with the $params of its query left unbound, and
+ * FT.EXECUTE runs it with the PARAMS it is given. The query is parsed when it is prepared, so that
+ * its errors are reported then rather than on every execution. Its parse tree is not kept though:
+ * the params are resolved into the nodes of the tree and the expanders rewrite it, so the tree of
+ * an execution is parsed anew.
+ *
+ * The prepared queries are only accessed by the main thread */
+
+/* Parse the query of `FT.PREPARE {name} {index} {query} [options]` and store it under its name,
+ * replacing the query prepared under that name, if any */
+int PreparedQuery_Add(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                      QueryError *status);
+
+/* The arguments of the FT.SEARCH run by `FT.EXECUTE {name} [PARAMS {nargs} {name} {value} ...]`,
+ * as `*nargs` strings. The array is allocated with rm_malloc, its strings are borrowed from the
+ * prepared query and from `argv`, for the duration of the command */
+RedisModuleString **PreparedQuery_Bind(RedisModuleString **argv, int argc, int *nargs,
+                                       QueryError *status);
+
+/* Remove the query prepared under `name`, returning whether there was one */
+bool PreparedQuery_Del(const char *name);
+
+void PreparedQuery_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
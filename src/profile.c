@@ -6,6 +6,28 @@
 
 #include "profile.h"
 
+static void printProfileHwCounters(RedisModule_Reply *reply, const PerfCounters *hw) {
+  RedisModule_ReplyKV_LongLong(reply, "Cycles", hw->cycles);
+  RedisModule_ReplyKV_LongLong(reply, "Instructions", hw->instructions);
+  RedisModule_ReplyKV_LongLong(reply, "Cache misses", hw->cacheMisses);
+}
+
+void Profile_PrintIteratorCounters(RedisModule_Reply *reply, size_t counter,
+                                   PrintProfileConfig *config) {
+  printProfileCounter(counter);
+
+  const ProfileCounters *pc = config->counters;
+  config->counters = NULL;
+  if (!pc || !config->printProfileClock) {
+    return;
+  }
+  RedisModule_ReplyKV_LongLong(reply, "SkipTo calls", pc->skipTos);
+  RedisModule_ReplyKV_LongLong(reply, "SkipTo hits", pc->skipToHits);
+  if (pc->withHw) {
+    printProfileHwCounters(reply, &pc->hw);
+  }
+}
+
 void printReadIt(RedisModule_Reply *reply, IndexIterator *root, size_t counter, double cpuTime, PrintProfileConfig *config) {
   IndexReader *ir = root->ctx;
 
@@ -21,6 +43,9 @@ void printReadIt(RedisModule_Reply *reply, IndexIterator *root, size_t counter,
       printProfileType("NUMERIC");
       RedisModule_Reply_SimpleString(reply, "Term");
       RedisModule_Reply_Stringf(reply, "%g - %g", ir->decoderCtx.rangeMin, ir->decoderCtx.rangeMax);
+      if (ir->blocksSkipped) {
+        RedisModule_ReplyKV_LongLong(reply, "Skipped blocks", ir->blocksSkipped);
+      }
     } else {
       printProfileType("GEO");
       RedisModule_Reply_SimpleString(reply, "Term");
@@ -40,18 +65,30 @@ void printReadIt(RedisModule_Reply *reply, IndexIterator *root, size_t counter,
     printProfileTime(cpuTime);
   }
 
-  printProfileCounter(counter);
+  printProfileIteratorCounters(counter);
+
+  // what the reader went through to yield its records
+  if (config->printProfileClock) {
+    RedisModule_ReplyKV_LongLong(reply, "Blocks read", ir->blocksRead);
+    RedisModule_ReplyKV_LongLong(reply, "Bytes read", ir->bytesRead);
+    RedisModule_ReplyKV_LongLong(reply, "Filtered records", ir->recordsFiltered);
+  }
 
   RedisModule_ReplyKV_LongLong(reply, "Size", root->NumEstimated(ir));
 
   RedisModule_Reply_MapEnd(reply);
 }
 
-static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock) {
+/* Print the profile of `rp` and its upstream. Returns the time spent in them, and sets `hw` to
+ * their hardware counters, if they are read */
+static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock,
+                                     PerfCounters *hw) {
+  *hw = (PerfCounters){0};
   if (rp == NULL) {
     return 0;
   }
-  double upstreamTime = _recursiveProfilePrint(reply, rp->upstream, printProfileClock);
+  PerfCounters upstreamHw;
+  double upstreamTime = _recursiveProfilePrint(reply, rp->upstream, printProfileClock, &upstreamHw);
 
   // Array is filled backward in pair of [common, profile] result processors
   if (rp->type != RP_PROFILE) {
@@ -59,7 +96,14 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
 
     switch (rp->type) {
       case RP_INDEX:
+        printProfileType(RPTypeToString(rp->type));
+        if (printProfileClock) {
+          RedisModule_ReplyKV_LongLong(reply, "Document lookups", RPIndexIterator_NumDocLookups(rp));
+        }
+        break;
+
       case RP_METRICS:
+      case RP_DOC_VALUES:
       case RP_LOADER:
       case RP_SAFE_LOADER:
       case RP_SCORER:
@@ -67,11 +111,19 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
       case RP_COUNTER:
       case RP_PAGER_LIMITER:
       case RP_HIGHLIGHTER:
-      case RP_GROUP:
       case RP_NETWORK:
+      case RP_PREFETCH:
+      case RP_FROZEN:
         printProfileType(RPTypeToString(rp->type));
         break;
 
+      case RP_GROUP:
+        printProfileType(RPTypeToString(rp->type));
+        if (RPGrouper_SpilledBytes(rp)) {
+          RedisModule_ReplyKV_LongLong(reply, "Spilled bytes", RPGrouper_SpilledBytes(rp));
+        }
+        break;
+
       case RP_PROJECTOR:
       case RP_FILTER:
         RPEvaluator_Reply(reply, "Type", rp);
@@ -83,6 +135,7 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
         break;
     }
 
+    *hw = upstreamHw;
     return upstreamTime;
   }
 
@@ -91,12 +144,29 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
     printProfileTime(totalRPTime - upstreamTime);
   }
   printProfileCounter(RPProfile_GetCount(rp) - 1);
+  // like the time, the counters of the processor are those of its upstream calls less theirs
+  const PerfCounters *totalRPHw = RPProfile_GetHwCounters(rp);
+  if (totalRPHw) {
+    if (printProfileClock) {
+      PerfCounters rpHw = {0};
+      PerfCounters_AddSince(&rpHw, &upstreamHw, totalRPHw);
+      printProfileHwCounters(reply, &rpHw);
+    }
+    *hw = *totalRPHw;
+  }
   RedisModule_Reply_MapEnd(reply); // end of resursive map
   return totalRPTime;
 }
 
 static double printProfileRP(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock) {
-  return _recursiveProfilePrint(reply, rp, printProfileClock);
+  PerfCounters hw;
+  return _recursiveProfilePrint(reply, rp, printProfileClock, &hw);
+}
+
+// The time the query held the spec lock for, in milliseconds
+static double lockHoldTimeMSec(AREQ *req) {
+  int holding = req->sctx && req->sctx->flags != RS_CTX_UNSET;
+  return (double)ConcurrentYieldCtl_HeldNS(&req->conc.yield, holding) / 1000000;
 }
 
 int Profile_Print(RedisModule_Reply *reply, AREQ *req) {
@@ -141,6 +211,12 @@ int Profile_Print(RedisModule_Reply *reply, AREQ *req) {
         printProfileRP(reply, rp, req->reqConfig.printProfileClock);
       RedisModule_Reply_ArrayEnd(reply);
 
+      // Print the holds of the spec lock
+      if (root && profile_verbose) {
+        RedisModule_ReplyKV_LongLong(reply, "Index lock yields", req->conc.yield.numYields);
+        RedisModule_ReplyKV_Double(reply, "Index lock hold time", lockHoldTimeMSec(req));
+      }
+
       RedisModule_Reply_MapEnd(reply); // profile
   }
   //-------------------------------------------------------------------------------------------
@@ -193,6 +269,18 @@ int Profile_Print(RedisModule_Reply *reply, AREQ *req) {
       printProfileRP(reply, rp, req->reqConfig.printProfileClock);
     RedisModule_Reply_ArrayEnd(reply);
 
+    // Print the holds of the spec lock
+    if (root && profile_verbose) {
+      RedisModule_Reply_Array(reply);
+        RedisModule_Reply_SimpleString(reply, "Index lock yields");
+        RedisModule_Reply_LongLong(reply, req->conc.yield.numYields);
+      RedisModule_Reply_ArrayEnd(reply);
+      RedisModule_Reply_Array(reply);
+        RedisModule_Reply_SimpleString(reply, "Index lock hold time");
+        RedisModule_Reply_Double(reply, lockHoldTimeMSec(req));
+      RedisModule_Reply_ArrayEnd(reply);
+    }
+
     RedisModule_Reply_ArrayEnd(reply);
   }
   //-------------------------------------------------------------------------------------------
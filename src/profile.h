@@ -17,10 +17,26 @@
 #define printProfileCounter(vcounter) RedisModule_ReplyKV_LongLong(reply, "Counter", (vcounter))
 #define printProfileNumBatches(hybrid_reader) \
   RedisModule_ReplyKV_LongLong(reply, "Batches number", (hybrid_reader)->numIterations)
+#define printProfileBatchResults(hybrid_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Batch results", (hybrid_reader)->stats.batchResults)
+#define printProfileDistances(hybrid_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Distances computed", (hybrid_reader)->stats.distances)
+#define printProfilePassRate(hybrid_reader) \
+  RedisModule_ReplyKV_Double(reply, "Filter pass rate", (hybrid_reader)->passRate)
+#define printProfileHybridPolicy(hybrid_reader) \
+  RedisModule_ReplyKV_SimpleString(reply, "Hybrid policy", \
+                                   HybridIterator_PrintSearchMode((hybrid_reader)->searchMode))
 #define printProfileOptimizationType(oi) \
   RedisModule_ReplyKV_SimpleString(reply, "Optimizer mode", QOptimizer_PrintType((oi)->optim))
 
 int Profile_Print(RedisModule_Reply *reply, AREQ *req);
 
+/* Print the counter of an iterator, and with the profile clock, what its profile iterator
+ * counted besides (see ProfileCounters) */
+void Profile_PrintIteratorCounters(RedisModule_Reply *reply, size_t counter,
+                                   PrintProfileConfig *config);
+#define printProfileIteratorCounters(vcounter) \
+  Profile_PrintIteratorCounters(reply, (vcounter), config)
+
 void printReadIt(RedisModule_Reply *reply, IndexIterator *root, size_t counter,
                  double cpuTime, PrintProfileConfig *config);
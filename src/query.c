@@ -11,6 +11,7 @@
 #include <sys/param.h>
 
 #include "geo_index.h"
+#include "geo_nearest_reader.h"
 #include "index.h"
 #include "query.h"
 #include "config.h"
@@ -34,9 +35,12 @@
 #include "suffix.h"
 #include "wildcard/wildcard.h"
 #include "geometry/geometry_api.h"
+#include "util/fnv.h"
 
 #define EFFECTIVE_FIELDMASK(q_, qn_) ((qn_)->opts.fieldMask & (q)->opts->fieldmask)
 
+static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs, int depth);
+
 static void QueryTokenNode_Free(QueryTokenNode *tn) {
   if (tn->str) rm_free(tn->str);
 }
@@ -45,6 +49,10 @@ static void QueryTagNode_Free(QueryTagNode *tag) {
   rm_free((char *)tag->fieldName);
 }
 
+static void QueryMissingNode_Free(QueryMissingNode *miss) {
+  rm_free((char *)miss->fieldName);
+}
+
 static void QueryGeometryNode_Free(QueryGeometryNode *geom) {
   if (geom->geomq) {
     GeometryQuery_Free(geom->geomq);
@@ -122,6 +130,9 @@ void QueryNode_Free(QueryNode *n) {
     case QN_GEOMETRY:
       QueryGeometryNode_Free(&n->gmn);
       break;
+    case QN_MISSING:
+      QueryMissingNode_Free(&n->miss);
+      break;
     case QN_UNION:
     case QN_NOT:
     case QN_OPTIONAL:
@@ -295,6 +306,13 @@ QueryNode *NewTagNode(const char *field, size_t len) {
   return ret;
 }
 
+QueryNode *NewMissingNode(const char *field, size_t len) {
+  QueryNode *ret = NewQueryNode(QN_MISSING);
+  ret->miss.fieldName = field;
+  ret->miss.len = len;
+  return ret;
+}
+
 QueryNode *NewNumericNode(QueryParam *p) {
   QueryNode *ret = NewQueryNode(QN_NUMERIC);
   // Move data and params pointers
@@ -309,6 +327,7 @@ QueryNode *NewNumericNode(QueryParam *p) {
 QueryNode *NewGeofilterNode(QueryParam *p) {
   assert(p->type == QP_GEO_FILTER);
   QueryNode *ret = NewQueryNode(QN_GEO);
+  ret->opts.flags |= QueryNode_YieldsDistance;
   // Move data and params pointers
   ret->gn.gf = p->gf;
   ret->params = p->params;
@@ -441,6 +460,41 @@ static void QueryNode_Expand(RSQueryTokenExpander expander, RSQueryExpanderCtx *
   }
 }
 
+/* Read a token restricted to SEPARATEPOSTINGS fields from the postings of these fields only,
+ * rather than from the postings of all the fields, and union them if there are several */
+static IndexIterator *Query_EvalFieldsToken(QueryEvalCtx *q, QueryNode *qn, RSQueryTerm *term,
+                                            t_fieldMask fieldMask) {
+  IndexSpec *spec = q->sctx->spec;
+  IndexIterator **its = rm_calloc(spec->numFields, sizeof(*its));
+  size_t itsSz = 0;
+  for (int i = 0; i < spec->numFields; ++i) {
+    const FieldSpec *fs = spec->fields + i;
+    if (!FIELD_IS(fs, INDEXFLD_T_FULLTEXT) || !(fieldMask & FIELD_BIT(fs))) {
+      continue;
+    }
+    if (!term) {
+      // each reader owns its term
+      term = NewQueryTerm(&qn->tn, q->tokenId - 1);
+    }
+    IndexReader *ir = Redis_OpenFieldReader(q->sctx, term, fs, q->conc, qn->opts.weight);
+    if (!ir) {
+      continue;
+    }
+    term = NULL;
+    its[itsSz++] = NewReadIterator(ir);
+  }
+  if (term) {
+    Term_Free(term);
+  }
+
+  if (itsSz <= 1) {
+    IndexIterator *it = itsSz ? its[0] : NULL;
+    rm_free(its);
+    return it;
+  }
+  return NewUnionIterator(its, itsSz, q->docTable, 0, qn->opts.weight, QN_UNION, NULL, q->config);
+}
+
 IndexIterator *Query_EvalTokenNode(QueryEvalCtx *q, QueryNode *qn) {
   if (qn->type != QN_TOKEN) {
     return NULL;
@@ -452,11 +506,19 @@ IndexIterator *Query_EvalTokenNode(QueryEvalCtx *q, QueryNode *qn) {
   int isSingleWord = q->numTokens == 1 && q->opts->fieldmask == RS_FIELDMASK_ALL;
 
   RSQueryTerm *term = NewQueryTerm(&qn->tn, q->tokenId++);
+  if (q->sctx->spec->clusterStats) {
+    ClusterStats_RecordTerm(q->sctx->spec->clusterStats, term->str, term->len);
+  }
 
   // printf("Opening reader.. `%s` FieldMask: %llx\n", term->str, EFFECTIVE_FIELDMASK(q, qn));
 
+  t_fieldMask fieldMask = EFFECTIVE_FIELDMASK(q, qn);
+  if (fieldMask && !(fieldMask & ~q->sctx->spec->separatePostingsMask)) {
+    return Query_EvalFieldsToken(q, qn, term, fieldMask);
+  }
+
   IndexReader *ir = Redis_OpenReader(q->sctx, term, q->docTable, isSingleWord,
-                                     EFFECTIVE_FIELDMASK(q, qn), q->conc, qn->opts.weight);
+                                     fieldMask, q->conc, qn->opts.weight);
   if (ir == NULL) {
     Term_Free(term);
     return NULL;
@@ -465,14 +527,92 @@ IndexIterator *Query_EvalTokenNode(QueryEvalCtx *q, QueryNode *qn) {
   return NewReadIterator(ir);
 }
 
+// The cache key of a term expansion is its type, the maximum distance of a fuzzy term and the
+// fields the expanded terms are read from, followed by the pattern
+#define TERM_EXPANSION_KEYLEN(len) (2 + sizeof(t_fieldMask) + (len))
+#define TERM_EXPANSION_KEY(key, type, maxDist, fieldMask, pattern, len) \
+  char key[TERM_EXPANSION_KEYLEN(len)];                                 \
+  key[0] = (type);                                                      \
+  key[1] = (maxDist);                                                   \
+  memcpy(key + 2, &(fieldMask), sizeof(t_fieldMask));                   \
+  memcpy(key + 2 + sizeof(t_fieldMask), (pattern), (len));
+
+/* Get the cached expansion of a text pattern, or NULL if the terms of the spec changed since it
+ * was cached */
+static Expansion *Query_GetTermExpansion(QueryEvalCtx *q, ExpansionType type, int maxDist,
+                                         t_fieldMask fieldMask, const char *str, size_t len) {
+  IndexSpec *spec = q->sctx->spec;
+  if (!spec->termExpansions || len >= UINT16_MAX) {
+    return NULL;
+  }
+  TERM_EXPANSION_KEY(key, type, maxDist, fieldMask, str, len);
+  return ExpansionCache_Get(spec->termExpansions, spec->termsRevision, key,
+                            TERM_EXPANSION_KEYLEN(len), q->config->maxPrefixExpansions);
+}
+
+/* Cache the terms a text pattern expanded to, unless the expansion was cut short by the query
+ * timing out or failing. Takes ownership of `terms` */
+static void Query_CacheTermExpansion(QueryEvalCtx *q, ExpansionType type, int maxDist,
+                                     t_fieldMask fieldMask, const char *str, size_t len,
+                                     arrayof(char *) terms) {
+  IndexSpec *spec = q->sctx->spec;
+  Expansion *exp = NewExpansion(terms);
+  if (spec->termExpansions && len < UINT16_MAX && !QueryError_HasError(q->status) &&
+      TimedOut(&q->sctx->timeout) == NOT_TIMED_OUT) {
+    TERM_EXPANSION_KEY(key, type, maxDist, fieldMask, str, len);
+    ExpansionCache_Put(spec->termExpansions, spec->termsRevision, key, TERM_EXPANSION_KEYLEN(len),
+                       q->config->maxPrefixExpansions, exp);
+  }
+  Expansion_Release(exp);
+}
+
+/* Open a reader for each of the terms a text pattern expanded to, and union them */
+static IndexIterator *Query_EvalTermExpansion(QueryEvalCtx *q, Expansion *exp,
+                                              QueryNodeOptions *opts, QueryNodeType type,
+                                              const char *str) {
+  size_t itsSz = 0, n = array_len(exp->values);
+  if (n == 0) {
+    return NULL;
+  }
+  IndexIterator **its = rm_calloc(n, sizeof(*its));
+  for (size_t i = 0; i < n; ++i) {
+    RSToken tok = {.str = exp->values[i], .len = strlen(exp->values[i])};
+    RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
+    IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0,
+                                       q->opts->fieldmask & opts->fieldMask, q->conc, 1);
+    if (!ir) {
+      Term_Free(term);
+      continue;
+    }
+    its[itsSz++] = NewReadIterator(ir);
+  }
+
+  if (itsSz == 0) {
+    rm_free(its);
+    return NULL;
+  }
+  return NewUnionIterator(its, itsSz, q->docTable, 1, opts->weight, type, str, q->config);
+}
+
 static IndexIterator *iterateExpandedTerms(QueryEvalCtx *q, Trie *terms, const char *str,
                                            size_t len, int maxDist, int prefixMode,
                                            QueryNodeOptions *opts) {
+  QueryNodeType type = prefixMode ? QN_PREFIX : QN_FUZZY;
+  ExpansionType expType = prefixMode ? Expansion_Prefix : Expansion_Fuzzy;
+  t_fieldMask fieldMask = q->opts->fieldmask & opts->fieldMask;
+  Expansion *exp = Query_GetTermExpansion(q, expType, maxDist, fieldMask, str, len);
+  if (exp) {
+    IndexIterator *ret = Query_EvalTermExpansion(q, exp, opts, type, str);
+    Expansion_Release(exp);
+    return ret;
+  }
+
   TrieIterator *it = Trie_Iterate(terms, str, len, maxDist, prefixMode);
   if (!it) return NULL;
 
   size_t itsSz = 0, itsCap = 8;
   IndexIterator **its = rm_calloc(itsCap, sizeof(*its));
+  arrayof(char *) expanded = array_new(char *, itsCap);
 
   rune *rstr = NULL;
   t_len slen = 0;
@@ -497,17 +637,18 @@ static IndexIterator *iterateExpandedTerms(QueryEvalCtx *q, Trie *terms, const c
     RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
 
     // Open an index reader
-    IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0,
-                                       q->opts->fieldmask & opts->fieldMask, q->conc, 1);
+    IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0, fieldMask,
+                                       q->conc, 1);
 
-    rm_free(tok.str);
     if (!ir) {
+      rm_free(tok.str);
       Term_Free(term);
       continue;
     }
 
-    // Add the reader to the iterator array
+    // Add the reader to the iterator array, and keep the term for the expansion cache
     its[itsSz++] = NewReadIterator(ir);
+    expanded = array_append(expanded, tok.str);
     if (itsSz == itsCap) {
       itsCap *= 2;
       its = rm_realloc(its, itsCap * sizeof(*its));
@@ -515,12 +656,12 @@ static IndexIterator *iterateExpandedTerms(QueryEvalCtx *q, Trie *terms, const c
   }
 
   TrieIterator_Free(it);
+  Query_CacheTermExpansion(q, expType, maxDist, fieldMask, str, len, expanded);
   // printf("Expanded %d terms!\n", itsSz);
   if (itsSz == 0) {
     rm_free(its);
     return NULL;
   }
-  QueryNodeType type = prefixMode ? QN_PREFIX : QN_FUZZY;
   return NewUnionIterator(its, itsSz, q->docTable, 1, opts->weight, type, str, q->config);
 }
 
@@ -531,11 +672,27 @@ typedef struct {
   QueryEvalCtx *q;
   QueryNodeOptions *opts;
   double weight;
+  arrayof(char *) terms;  // the expanded terms, kept for the expansion cache if not NULL
 } ContainsCtx;
 
 static int runeIterCb(const rune *r, size_t n, void *p, void *payload);
 static int charIterCb(const char *s, size_t n, void *p, void *payload);
 
+// Whether all the text fields in the mask have the trigrams of their terms
+static bool ngramsCover(const IndexSpec *spec, t_fieldMask fieldMask) {
+  if (!spec->ngrams) {
+    return false;
+  }
+  for (int i = 0; i < spec->numFields; i++) {
+    const FieldSpec *fs = spec->fields + i;
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && (fieldMask & FIELD_BIT(fs)) &&
+        !(spec->ngramMask & FIELD_BIT(fs))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /* Ealuate a prefix node by expanding all its possible matches and creating one big UNION on all
  * of them.
  * Used for Prefix, Contains and suffix nodes.
@@ -556,6 +713,20 @@ static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
     return NULL;
   }
 
+  RSToken *tok = &qn->pfx.tok;
+  ExpansionType type = !qn->pfx.suffix ? Expansion_Prefix :
+                       qn->pfx.prefix ? Expansion_Contains : Expansion_Suffix;
+  t_fieldMask fieldMask = q->opts->fieldmask & qn->opts.fieldMask;
+  if (tok->str) {
+    Expansion *exp = Query_GetTermExpansion(q, type, 0, fieldMask, tok->str, tok->len);
+    if (exp) {
+      IndexIterator *ret = Query_EvalTermExpansion(q, exp, &qn->opts, QN_PREFIX, tok->str);
+      Expansion_Release(exp);
+      return ret;
+    }
+    ctx.terms = array_new(char *, 8);
+  }
+
   rune *str = NULL;
   size_t nstr;
   if (qn->pfx.tok.str) {
@@ -567,18 +738,22 @@ static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
   ctx.nits = 0;
 
   // spec support contains queries
-  if (spec->suffix && qn->pfx.suffix) {
+  if (str && qn->pfx.suffix && ngramsCover(spec, fieldMask) &&
+      NgramIndex_IterateContains(spec->ngrams, str, nstr, qn->pfx.prefix, charIterCb, &ctx,
+                                 &q->sctx->timeout)) {
+    // the terms were found by their trigrams
+  } else if (spec->suffix && qn->pfx.suffix) {
     // all modifier fields are supported
     if (qn->opts.fieldMask == RS_FIELDMASK_ALL ||
        (spec->suffixMask & qn->opts.fieldMask) == qn->opts.fieldMask) {
       SuffixCtx sufCtx = {
-        .root = spec->suffix->root,
+        .sa = spec->suffix,
         .rune = str,
         .runelen = nstr,
         .type = qn->pfx.prefix ? SUFFIX_TYPE_CONTAINS : SUFFIX_TYPE_SUFFIX,
         .callback = charIterCb,
         .cbCtx = &ctx,
-
+        .timeout = &q->sctx->timeout,
       };
       Suffix_IterateContains(&sufCtx);
     } else {
@@ -591,6 +766,9 @@ static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
   }
 
   rm_free(str);
+  if (ctx.terms) {
+    Query_CacheTermExpansion(q, type, 0, fieldMask, tok->str, tok->len, ctx.terms);
+  }
   if (!ctx.its || ctx.nits == 0) {
     rm_free(ctx.its);
     return NULL;
@@ -617,6 +795,16 @@ static IndexIterator *Query_EvalWildcardQueryNode(QueryEvalCtx *q, QueryNode *qn
   }
 
   token->len = Wildcard_RemoveEscape(token->str, token->len);
+  t_fieldMask fieldMask = q->opts->fieldmask & qn->opts.fieldMask;
+  Expansion *exp = Query_GetTermExpansion(q, Expansion_Wildcard, 0, fieldMask, token->str,
+                                          token->len);
+  if (exp) {
+    IndexIterator *ret = Query_EvalTermExpansion(q, exp, &qn->opts, QN_WILDCARD_QUERY, token->str);
+    Expansion_Release(exp);
+    return ret;
+  }
+  ctx.terms = array_new(char *, 8);
+
   size_t nstr;
   rune *str = strToFoldedRunes(token->str, &nstr);
 
@@ -625,13 +813,16 @@ static IndexIterator *Query_EvalWildcardQueryNode(QueryEvalCtx *q, QueryNode *qn
   ctx.nits = 0;
 
   bool fallbackBruteForce = false;
-  // spec support using suffix trie
-  if (spec->suffix) {
+  if (ngramsCover(spec, fieldMask) &&
+      NgramIndex_IterateWildcard(spec->ngrams, str, nstr, charIterCb, &ctx, &q->sctx->timeout)) {
+    // the terms were found by their trigrams
+  } else if (spec->suffix) {
+    // spec support using suffix trie
     // all modifier fields are supported
     if (qn->opts.fieldMask == RS_FIELDMASK_ALL ||
        (spec->suffixMask & qn->opts.fieldMask) == qn->opts.fieldMask) {
       SuffixCtx sufCtx = {
-        .root = spec->suffix->root,
+        .sa = spec->suffix,
         .rune = str,
         .runelen = nstr,
         .cstr = token->str,
@@ -648,13 +839,16 @@ static IndexIterator *Query_EvalWildcardQueryNode(QueryEvalCtx *q, QueryNode *qn
     } else {
       QueryError_SetErrorFmt(q->status, QUERY_EGENERIC, "Contains query on fields without WITHSUFFIXTRIE support");
     }
+  } else {
+    fallbackBruteForce = true;
   }
 
-  if (!spec->suffix || fallbackBruteForce) {
+  if (fallbackBruteForce) {
     TrieNode_IterateWildcard(t->root, str, nstr, runeIterCb, &ctx, &q->sctx->timeout);
   }
 
   rm_free(str);
+  Query_CacheTermExpansion(q, Expansion_Wildcard, 0, fieldMask, token->str, token->len, ctx.terms);
   if (!ctx.its || ctx.nits == 0) {
     rm_free(ctx.its);
     return NULL;
@@ -671,6 +865,7 @@ typedef struct {
   QueryEvalCtx *q;
   QueryNodeOptions *opts;
   double weight;
+  arrayof(char *) terms;
 } LexRangeCtx;
 
 static void rangeItersAddIterator(LexRangeCtx *ctx, IndexReader *ir) {
@@ -708,13 +903,18 @@ static int runeIterCb(const rune *r, size_t n, void *p, void *payload) {
   RSQueryTerm *term = NewQueryTerm(&tok, ctx->q->tokenId++);
   IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0,
                                      q->opts->fieldmask & ctx->opts->fieldMask, q->conc, 1);
-  rm_free(tok.str);
   if (!ir) {
+    rm_free(tok.str);
     Term_Free(term);
     return REDISEARCH_OK;
   }
 
   rangeItersAddIterator(ctx, ir);
+  if (ctx->terms) {
+    ctx->terms = array_append(ctx->terms, tok.str);
+  } else {
+    rm_free(tok.str);
+  }
   return REDISEARCH_OK;
 }
 
@@ -735,6 +935,9 @@ static int charIterCb(const char *s, size_t n, void *p, void *payload) {
   }
 
   rangeItersAddIterator(ctx, ir);
+  if (ctx->terms) {
+    ctx->terms = array_append(ctx->terms, rm_strndup(s, n));
+  }
   return REDISEARCH_OK;
 }
 
@@ -781,6 +984,8 @@ static IndexIterator *Query_EvalFuzzyNode(QueryEvalCtx *q, QueryNode *qn) {
   return iterateExpandedTerms(q, terms, qn->pfx.tok.str, qn->pfx.tok.len, qn->fz.maxDist, 0, &qn->opts);
 }
 
+static IndexIterator *evalVectorNode(QueryEvalCtx *q, QueryNode *qn, IndexIterator *rangeFilter);
+
 static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
   if (qn->type != QN_PHRASE) {
     // printf("Not a phrase node!\n");
@@ -794,11 +999,34 @@ static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
     return Query_EvalNode(q, qn->children[0]);
   }
 
-  // recursively eval the children
-  IndexIterator **iters = rm_calloc(QueryNode_NumChildren(qn), sizeof(IndexIterator *));
-  for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+  // recursively eval the children. A vector range among children which are not vector queries is
+  // evaluated last, among the results of the most selective of them (see NewVectorIterator)
+  size_t numChildren = QueryNode_NumChildren(qn);
+  IndexIterator **iters = rm_calloc(numChildren, sizeof(IndexIterator *));
+  size_t rangeIdx = numChildren;
+  for (size_t ii = 0; ii < numChildren; ++ii) {
+    if (qn->children[ii]->type != QN_VECTOR) continue;
+    if (rangeIdx != numChildren || qn->children[ii]->vn.vq->type != VECSIM_QT_RANGE) {
+      rangeIdx = numChildren;
+      break;
+    }
+    rangeIdx = ii;
+  }
+  for (size_t ii = 0; ii < numChildren; ++ii) {
     qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
-    iters[ii] = Query_EvalNode(q, qn->children[ii]);
+    if (ii != rangeIdx) {
+      iters[ii] = Query_EvalNode(q, qn->children[ii]);
+    }
+  }
+  if (rangeIdx != numChildren) {
+    IndexIterator *filter = NULL;
+    for (size_t ii = 0; ii < numChildren; ++ii) {
+      if (iters[ii] && (!filter || iters[ii]->NumEstimated(iters[ii]->ctx) <
+                                       filter->NumEstimated(filter->ctx))) {
+        filter = iters[ii];
+      }
+    }
+    iters[rangeIdx] = evalVectorNode(q, qn->children[rangeIdx], filter);
   }
   IndexIterator *ret;
 
@@ -831,7 +1059,30 @@ static IndexIterator *Query_EvalWildcardNode(QueryEvalCtx *q, QueryNode *qn) {
     return NULL;
   }
 
-  return NewWildcardIterator(q->docTable->maxDocId, q->docTable->size);
+  return NewWildcardIterator(q->docTable->maxDocId, q->docTable->size, q->docTable);
+}
+
+/* The documents missing the field of the node, or having it. The field must be INDEXMISSING */
+static IndexIterator *evalExistence(QueryEvalCtx *q, QueryNode *qn, bool missing, double weight) {
+  const FieldSpec *fs = IndexSpec_GetField(q->sctx->spec, qn->miss.fieldName, qn->miss.len);
+  const ExistenceIndex *ex = fs ? IndexSpec_GetExistence(q->sctx->spec, fs) : NULL;
+  if (!ex) {
+    QueryError_SetErrorFmt(q->status, QUERY_EINVAL,
+                           "`ismissing` requires the field `%.*s` to be " SPEC_INDEXMISSING_STR,
+                           (int)qn->miss.len, qn->miss.fieldName);
+    return NULL;
+  }
+  if (!q->docTable) {
+    return NULL;
+  }
+  return NewExistenceIterator(ex, missing, q->docTable->maxDocId, q->docTable, weight);
+}
+
+static IndexIterator *Query_EvalMissingNode(QueryEvalCtx *q, QueryNode *qn) {
+  if (qn->type != QN_MISSING) {
+    return NULL;
+  }
+  return evalExistence(q, qn, true, qn->opts.weight);
 }
 
 static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -840,8 +1091,13 @@ static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
   }
   QueryNotNode *node = &qn->inverted;
 
+  // the complement of the documents missing a field is read from the same bitmap
+  if (QueryNode_NumChildren(qn) && qn->children[0]->type == QN_MISSING) {
+    return evalExistence(q, qn->children[0], false, qn->opts.weight);
+  }
+
   return NewNotIterator(QueryNode_NumChildren(qn) ? Query_EvalNode(q, qn->children[0]) : NULL,
-                        q->docTable->maxDocId, qn->opts.weight);
+                        q->docTable->maxDocId, qn->opts.weight, q->docTable);
 }
 
 static IndexIterator *Query_EvalOptionalNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -875,7 +1131,15 @@ static IndexIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
   if (!fs || !FIELD_IS(fs, INDEXFLD_T_GEO)) {
     return NULL;
   }
-  return NewGeoRangeIterator(q->sctx, node->gn.gf, q->config);
+  if (!node->opts.distField) {
+    return NewGeoRangeIterator(q->sctx, node->gn.gf, q->config);
+  }
+
+  // Yield the distance of the documents, limited to the nearest ones when sorting by it
+  size_t idx = addMetricRequest(q, node->opts.distField, NULL);
+  IndexIterator *it = NewGeoNearestIterator(q->sctx, node->gn.gf, NULL, node->gn.gf->limit, q->config);
+  array_ensure_at(q->metricRequestsP, idx, MetricRequest)->key_ptr = &it->ownKey;
+  return it;
 }
 
 static IndexIterator *Query_EvalGeometryNode(QueryEvalCtx *q, QueryNode *node) {
@@ -902,7 +1166,30 @@ static IndexIterator *Query_EvalGeometryNode(QueryEvalCtx *q, QueryNode *node) {
 }
 
 
-static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
+// Evaluate the filter of the KNN clause of a MULTIVECTOR query. The first query of its vectors to
+// get here reads the ids of the filter, the others only iterate over them.
+static IndexIterator *evalSharedVectorFilter(QueryEvalCtx *q, QueryNode *child) {
+  SharedVectorFilter *f = q->opts->vectorFilter;
+  pthread_mutex_lock(&f->lock);
+  if (!f->evaluated) {
+    IndexIterator *it = Query_EvalNode(q, child);
+    if (it) {
+      RSIndexResult *res;
+      f->ids = array_new(t_docId, 16);
+      int rc;
+      while ((rc = it->Read(it->ctx, &res)) == INDEXREAD_OK || rc == INDEXREAD_NOTFOUND) {
+        if (rc == INDEXREAD_OK) array_append(f->ids, res->docId);
+      }
+      it->Free(it);
+    }
+    f->evaluated = true;
+  }
+  pthread_mutex_unlock(&f->lock);
+  return array_len(f->ids) ? NewBorrowedIdListIterator(f->ids, array_len(f->ids), 1) : NULL;
+}
+
+// `rangeFilter` is an iterator a range query is intersected with (see NewVectorIterator)
+static IndexIterator *evalVectorNode(QueryEvalCtx *q, QueryNode *qn, IndexIterator *rangeFilter) {
   if (qn->type != QN_VECTOR) {
     return NULL;
   }
@@ -938,15 +1225,27 @@ static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
     idx = addMetricRequest(q, qn->vn.vq->scoreField, NULL);
   }
   IndexIterator *child_it = NULL;
+  uint64_t filterKey = 0;
   if (QueryNode_NumChildren(qn) > 0) {
     RedisModule_Assert(QueryNode_NumChildren(qn) == 1);
-    child_it = Query_EvalNode(q, qn->children[0]);
+    child_it = q->opts->vectorFilter ? evalSharedVectorFilter(q, qn->children[0])
+                                     : Query_EvalNode(q, qn->children[0]);
     // If child iterator is in valid or empty, the hybrid iterator is empty as well.
     if (child_it == NULL) {
       return NULL;
     }
-  }
-  IndexIterator *it = NewVectorIterator(q, qn->vn.vq, child_it);
+    // The filter is identified in the pass rate history of the hybrid iterator by the index and
+    // its revision, the vector field and the dump of the child node - a write to the index
+    // invalidates the pass rates observed before it.
+    const IndexSpec *spec = q->sctx->spec;
+    uint64_t ids[2] = {spec->uniqueId, IndexSpec_ResultsRevision(spec)};
+    sds s = QueryNode_DumpSds(sdsnew(""), spec, qn->children[0], 0);
+    filterKey = fnv_64a_buf(ids, sizeof(ids), 0);
+    filterKey = fnv_64a_buf(qn->vn.vq->property, strlen(qn->vn.vq->property), filterKey);
+    filterKey = fnv_64a_buf(s, sdslen(s), filterKey);
+    sdsfree(s);
+  }
+  IndexIterator *it = NewVectorIterator(q, qn->vn.vq, child_it, filterKey, rangeFilter);
   // If iterator was created successfully, and we have a metric to yield, update the
   // relevant position in the metricRequests ptr array to the iterator's RLookup key ptr.
   if (it && qn->vn.vq->scoreField) {
@@ -958,6 +1257,10 @@ static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
   return it;
 }
 
+static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
+  return evalVectorNode(q, qn, NULL);
+}
+
 static IndexIterator *Query_EvalIdFilterNode(QueryEvalCtx *q, QueryIdFilterNode *node) {
   return NewIdListIterator(node->ids, node->len, 1);
 }
@@ -1025,23 +1328,57 @@ static IndexIterator *Query_EvalTagLexRangeNode(QueryEvalCtx *q, TagIndex *idx,
   }
 }
 
-/* Evaluate a tag prefix by expanding it with a lookup on the tag index */
-static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
-                                              IndexIteratorArray *iterout, double weight,
-                                              int withSuffixTrie) {
-  RSToken *tok = &qn->pfx.tok;
-  if (qn->type != QN_PREFIX) {
+static inline bool tagValueHasDocs(TagIndex *idx, const char *s, size_t len) {
+  InvertedIndex *iv = TrieMap_Find(idx->values, (char *)s, len);
+  return iv != TRIEMAP_NOTFOUND && iv && iv->numDocs;
+}
+
+/* Open a reader for each of the values a tag pattern expanded to, and union them */
+static IndexIterator *Query_EvalTagExpansion(QueryEvalCtx *q, TagIndex *idx, Expansion *exp,
+                                             IndexIteratorArray *iterout, double weight,
+                                             QueryNodeType type, const char *str) {
+  size_t itsSz = 0, n = array_len(exp->values);
+  if (n == 0) {
     return NULL;
   }
+  IndexIterator **its = rm_calloc(n, sizeof(*its));
+  for (size_t i = 0; i < n; ++i) {
+    IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, exp->values[i], strlen(exp->values[i]), 1);
+    if (ret) {
+      its[itsSz++] = ret;
+    }
+  }
 
-  // we allow a minimum of 2 letters in the prefx by default (configurable)
-  if (tok->len < q->config->minTermPrefix) {
+  // printf("Expanded %d terms!\n", itsSz);
+  if (itsSz == 0) {
+    rm_free(its);
     return NULL;
   }
-  if (!idx || !idx->values) return NULL;
+  if (itsSz == 1) {
+    // TODO:
+    IndexIterator *iter = its[0];
+    rm_free(its);
+    return iter;
+  }
 
-  size_t itsSz = 0, itsCap = 8;
-  IndexIterator **its = rm_calloc(itsCap, sizeof(*its));
+  *iterout = array_ensure_append(*iterout, its, itsSz, IndexIterator *);
+  return NewUnionIterator(its, itsSz, q->docTable, 1, weight, type, str, q->config);
+}
+
+/* Cache an expansion of a tag pattern, unless it was cut short by the query timing out */
+static void Query_CacheTagExpansion(QueryEvalCtx *q, TagIndex *idx, ExpansionType type,
+                                    const RSToken *tok, Expansion *exp) {
+  if (TimedOut(&q->sctx->timeout) == NOT_TIMED_OUT) {
+    TagIndex_CacheExpansion(idx, type, tok->str, tok->len, q->config->maxPrefixExpansions, exp);
+  }
+}
+
+/* Expand a tag prefix, suffix or contains pattern to the values of the tag index matching it */
+static arrayof(char *) Query_ExpandTagPrefix(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
+                                             int withSuffixTrie) {
+  RSToken *tok = &qn->pfx.tok;
+  size_t limit = q->config->maxPrefixExpansions;
+  arrayof(char *) values = NULL;
 
   if (!qn->pfx.suffix || !withSuffixTrie) {    // prefix query or no suffix triemap, use bruteforce
     TrieMapIterator *it = TrieMap_Iterate(idx->values, tok->str, tok->len);
@@ -1058,106 +1395,88 @@ static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
       }
     }
 
-
     // an upper limit on the number of expansions is enforced to avoid stuff like "*"
     char *s;
     tm_len_t sl;
     void *ptr;
 
     // Find all completions of the prefix
-    while (nextFunc(it, &s, &sl, &ptr) &&
-          (itsSz < q->config->maxPrefixExpansions)) {
-      IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, s, sl, 1);
-      if (!ret) continue;
-
-      // Add the reader to the iterator array
-      its[itsSz++] = ret;
-      if (itsSz == itsCap) {
-        itsCap *= 2;
-        its = rm_realloc(its, itsCap * sizeof(*its));
+    values = array_new(char *, 8);
+    while (nextFunc(it, &s, &sl, &ptr) && (array_len(values) < limit)) {
+      InvertedIndex *iv = ptr;
+      if (iv && iv->numDocs) {
+        values = array_append(values, rm_strndup(s, sl));
       }
     }
     TrieMapIterator_Free(it);
   } else {    // TAG field has suffix triemap
-    arrayof(char**) arr = GetList_SuffixTrieMap(idx->suffix, tok->str, tok->len,
-                                                qn->pfx.prefix, q->sctx->timeout);
+    arrayof(char*) arr = GetList_SuffixTrieMap(idx->suffix, tok->str, tok->len,
+                                               qn->pfx.prefix, q->sctx->timeout);
     if (!arr) return NULL;
-    for (int i = 0; i < array_len(arr); ++i) {
-      size_t iarrlen = array_len(arr);
-      for (int j = 0; j < array_len(arr[i]); ++j) {
-        size_t jarrlen = array_len(arr[i]);
-        if (itsSz >= q->config->maxPrefixExpansions) {
-          break;
-        }
-        IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, arr[i][j], strlen(arr[i][j]), 1);
-        if (!ret) continue;
-
-        // Add the reader to the iterator array
-        its[itsSz++] = ret;
-        if (itsSz == itsCap) {
-          itsCap *= 2;
-          its = rm_realloc(its, itsCap * sizeof(*its));
-        }
+    values = array_new(char *, 8);
+    for (int i = 0; i < array_len(arr) && array_len(values) < limit; ++i) {
+      size_t sl = strlen(arr[i]);
+      if (tagValueHasDocs(idx, arr[i], sl)) {
+        values = array_append(values, rm_strndup(arr[i], sl));
       }
     }
     array_free(arr);
   }
+  return values;
+}
 
-  // printf("Expanded %d terms!\n", itsSz);
-  if (itsSz == 0) {
-    rm_free(its);
+/* Evaluate a tag prefix by expanding it with a lookup on the tag index */
+static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
+                                              IndexIteratorArray *iterout, double weight,
+                                              int withSuffixTrie) {
+  RSToken *tok = &qn->pfx.tok;
+  if (qn->type != QN_PREFIX) {
     return NULL;
   }
-  if (itsSz == 1) {
-    // TODO:
-    IndexIterator *iter = its[0];
-    rm_free(its);
-    return iter;
-  }
-
-  *iterout = array_ensure_append(*iterout, its, itsSz, IndexIterator *);
-  return NewUnionIterator(its, itsSz, q->docTable, 1, weight, QN_PREFIX, qn->pfx.tok.str, q->config);
-}
 
-/* Evaluate a tag prefix by expanding it with a lookup on the tag index */
-static IndexIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
-                                              IndexIteratorArray *iterout, double weight) {
-  if (qn->type != QN_WILDCARD_QUERY) {
+  // we allow a minimum of 2 letters in the prefx by default (configurable)
+  if (tok->len < q->config->minTermPrefix) {
     return NULL;
   }
   if (!idx || !idx->values) return NULL;
 
-  RSToken *tok = &qn->verb.tok;
-  tok->len = Wildcard_RemoveEscape(tok->str, tok->len);
+  ExpansionType type = !qn->pfx.suffix ? Expansion_Prefix :
+                       qn->pfx.prefix ? Expansion_Contains : Expansion_Suffix;
+  Expansion *exp = TagIndex_GetExpansion(idx, type, tok->str, tok->len, q->config->maxPrefixExpansions);
+  if (!exp) {
+    arrayof(char *) values = Query_ExpandTagPrefix(q, idx, qn, withSuffixTrie);
+    if (!values) return NULL;
+    exp = NewExpansion(values);
+    Query_CacheTagExpansion(q, idx, type, tok, exp);
+  }
 
-  size_t itsSz = 0, itsCap = 8;
-  IndexIterator **its = rm_calloc(itsCap, sizeof(*its));
+  IndexIterator *ret = Query_EvalTagExpansion(q, idx, exp, iterout, weight, QN_PREFIX, qn->pfx.tok.str);
+  Expansion_Release(exp);
+  return ret;
+}
+
+/* Expand a tag wildcard pattern to the values of the tag index matching it */
+static arrayof(char *) Query_ExpandTagWildcard(QueryEvalCtx *q, TagIndex *idx, const RSToken *tok) {
+  size_t limit = q->config->maxPrefixExpansions;
+  arrayof(char *) values = array_new(char *, 8);
 
   bool fallbackBruteForce = false;
   if (idx->suffix) {
     // with suffix
     arrayof(char*) arr = GetList_SuffixTrieMap_Wildcard(idx->suffix, tok->str, tok->len,
-                                                        q->sctx->timeout, q->config->maxPrefixExpansions);
+                                                        q->sctx->timeout, limit);
     if (!arr) {
       // No matching terms
-      rm_free(its);
+      array_free(values);
       return NULL;
     } else if (arr == BAD_POINTER) {
       // The wildcard pattern does not include tokens that can be used with suffix trie
       fallbackBruteForce = true;
     } else {
-      for (int i = 0; i < array_len(arr); ++i) {
-        if (itsSz >= q->config->maxPrefixExpansions) {
-          break;
-        }
-        IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, arr[i], strlen(arr[i]), 1);
-        if (!ret) continue;
-
-          // Add the reader to the iterator array
-        its[itsSz++] = ret;
-        if (itsSz == itsCap) {
-          itsCap *= 2;
-          its = rm_realloc(its, itsCap * sizeof(*its));
+      for (int i = 0; i < array_len(arr) && array_len(values) < limit; ++i) {
+        size_t sl = strlen(arr[i]);
+        if (tagValueHasDocs(idx, arr[i], sl)) {
+          values = array_append(values, rm_strndup(arr[i], sl));
         }
       }
       array_free(arr);
@@ -1176,34 +1495,40 @@ static IndexIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx,
     void *ptr;
 
     // Find all completions of the prefix
-    while (TrieMapIterator_NextWildcard(it, &s, &sl, &ptr) &&
-          (itsSz < q->config->maxPrefixExpansions)) {
-      IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, s, sl, 1);
-      if (!ret) continue;
-
-      // Add the reader to the iterator array
-      its[itsSz++] = ret;
-      if (itsSz == itsCap) {
-        itsCap *= 2;
-        its = rm_realloc(its, itsCap * sizeof(*its));
+    while (TrieMapIterator_NextWildcard(it, &s, &sl, &ptr) && (array_len(values) < limit)) {
+      InvertedIndex *iv = ptr;
+      if (iv && iv->numDocs) {
+        values = array_append(values, rm_strndup(s, sl));
       }
     }
     TrieMapIterator_Free(it);
-  } else
+  }
+  return values;
+}
 
-  if (itsSz == 0) {
-    rm_free(its);
+/* Evaluate a tag prefix by expanding it with a lookup on the tag index */
+static IndexIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
+                                              IndexIteratorArray *iterout, double weight) {
+  if (qn->type != QN_WILDCARD_QUERY) {
     return NULL;
   }
-  if (itsSz == 1) {
-    // TODO:
-    IndexIterator *iter = its[0];
-    rm_free(its);
-    return iter;
+  if (!idx || !idx->values) return NULL;
+
+  RSToken *tok = &qn->verb.tok;
+  tok->len = Wildcard_RemoveEscape(tok->str, tok->len);
+
+  Expansion *exp = TagIndex_GetExpansion(idx, Expansion_Wildcard, tok->str, tok->len,
+                                         q->config->maxPrefixExpansions);
+  if (!exp) {
+    arrayof(char *) values = Query_ExpandTagWildcard(q, idx, tok);
+    if (!values) return NULL;
+    exp = NewExpansion(values);
+    Query_CacheTagExpansion(q, idx, Expansion_Wildcard, tok, exp);
   }
 
-  *iterout = array_ensure_append(*iterout, its, itsSz, IndexIterator *);
-  return NewUnionIterator(its, itsSz, q->docTable, 1, weight, QN_WILDCARD_QUERY, qn->pfx.tok.str, q->config);
+  IndexIterator *ret = Query_EvalTagExpansion(q, idx, exp, iterout, weight, QN_WILDCARD_QUERY, qn->pfx.tok.str);
+  Expansion_Release(exp);
+  return ret;
 }
 
 static void tag_strtolower(char *str, size_t *len, int caseSensitive) {
@@ -1378,6 +1703,8 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
       return Query_EvalWildcardQueryNode(q,n);
     case QN_GEOMETRY:
       return Query_EvalGeometryNode(q, n);
+    case QN_MISSING:
+      return Query_EvalMissingNode(q, n);
     case QN_NULL:
       return NewEmptyIterator();
   }
@@ -1517,6 +1844,7 @@ int QueryNode_EvalParams(dict *params, QueryNode *n, QueryError *status) {
     case QN_GEOMETRY:
       res = QueryNode_EvalParamsCommon(params, n, status);
       break;
+    case QN_MISSING:
     case QN_UNION:
       // no immediately owned params to resolve
       assert(n->params == NULL);
@@ -1573,6 +1901,7 @@ int QueryNode_CheckIsValid(QueryNode *n, IndexSpec *spec, RSSearchOptions *opts,
     case QN_LEXRANGE:
     case QN_VECTOR:
     case QN_GEOMETRY:
+    case QN_MISSING:
       break;
   }
   // Handle children
@@ -1656,8 +1985,6 @@ static sds doPad(sds s, int len) {
   return sdscat(s, buf);
 }
 
-static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs, int depth);
-
 static sds QueryNode_DumpChildren(sds s, const IndexSpec *spec, const QueryNode *qs, int depth);
 
 static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs, int depth) {
@@ -1814,6 +2141,9 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
     case QN_GEOMETRY:
       s = sdscatprintf(s, "GEOSHAPE{%d %s}\n", qs->gmn.geomq->query_type, qs->gmn.geomq->str);
       break;
+    case QN_MISSING:
+      s = sdscatprintf(s, "ISMISSING{@%.*s", (int)qs->miss.len, qs->miss.fieldName);
+      break;
   }
 
   s = sdscat(s, "}");
@@ -61,6 +61,7 @@ extern "C" {
   X(QUERY_EADHOCWBATCHSIZE, "'batch size' is irrelevant for 'ADHOC_BF' policy")           \
   X(QUERY_EADHOCWEFRUNTIME, "'EF_RUNTIME' is irrelevant for 'ADHOC_BF' policy")           \
   X(QUERY_ENRANGE, "range query attributes were sent for a non-range query")              \
+  X(QUERY_EOVERLOAD, "Too many queries are waiting for the workers")                      \
 
 typedef enum {
   QUERY_OK = 0,
@@ -64,6 +64,9 @@ typedef enum {
   /* Wildcard */
   QN_WILDCARD_QUERY,
 
+  /* The documents missing an INDEXMISSING field */
+  QN_MISSING,
+
   /* Null term - take no action */
   QN_NULL
 } QueryNodeType;
@@ -87,6 +90,11 @@ typedef struct {
   size_t len;
 } QueryTagNode;
 
+typedef struct {
+  const char *fieldName;
+  size_t len;
+} QueryMissingNode;
+
 /* A token node is a terminal, single term/token node. An expansion of synonyms is represented by a
  * Union node with several token nodes. A token can have private metadata written by expanders or
  * tokenizers. Later this gets passed to scoring functions in a Term object. See RSIndexRecord */
@@ -196,6 +204,7 @@ typedef struct RSQueryNode {
     QueryFuzzyNode fz;
     QueryLexRangeNode lxrng;
     QueryVerbatimNode verb;
+    QueryMissingNode miss;
   };
 
   /* The node type, for resolving the union access */
@@ -1,5 +1,7 @@
 #include "query_optimizer.h"
 #include "optimizer_reader.h"
+#include "geo_nearest_reader.h"
+#include "sort_index_reader.h"
 #include "numeric_index.h"
 #include "ext/default.h"
 
@@ -34,8 +36,16 @@ void QOptimizer_Parse(AREQ *req) {
         opt->fieldName = name;
         opt->asc = arng->sortAscMap & 0x01;
       } else {
-        // sortby other fields, no optimization
+        // sortby other fields, no optimization unless the field is SORTINDEX.
+        // Keep the name in case it is the distance yielded by a geo filter
         opt->type = Q_OPT_NONE;
+        if (field && (opt->sortIndex = IndexSpec_GetSortIndex(req->sctx->spec, field))) {
+          opt->asc = arng->sortAscMap & 0x01;
+        }
+        if (array_len(arng->sortKeys) == 1) {
+          opt->fieldName = name;
+          opt->asc = arng->sortAscMap & 0x01;
+        }
       }
     }
   }
@@ -45,16 +55,20 @@ void QOptimizer_Parse(AREQ *req) {
     opt->scorerType = SCORER_TYPE_NONE;
   } else {
     const char *scorer = req->searchopts.scorerName;
-    if (!scorer) {      // default is TFIDF
-      opt->scorerType = SCORER_TYPE_TERM;
-    } else if (!strcmp(scorer, DEFAULT_SCORER_NAME)) {  // TFIDF
+    if (!scorer || !strcmp(scorer, DEFAULT_SCORER_NAME)) {  // default is TFIDF
       opt->scorerType = SCORER_TYPE_TERM;
+      // with many results the threshold stays low for too long to skip anything
+      opt->maxScore = IsSearch(req) && !(arng && arng->sortKeys) && opt->limit &&
+                      opt->limit <= MAXSCORE_MAX_LIMIT;
     } else if (!strcmp(scorer, TFIDF_DOCNORM_SCORER_NAME)) {
       opt->scorerType = SCORER_TYPE_TERM;
     } else if (!strcmp(scorer, DISMAX_SCORER_NAME)) {
       opt->scorerType = SCORER_TYPE_TERM;
     } else if (!strcmp(scorer, BM25_SCORER_NAME)) {
       opt->scorerType = SCORER_TYPE_TERM;
+    } else if (!strcmp(scorer, BM25_STD_SCORER_NAME)) {
+      opt->scorerType = SCORER_TYPE_TERM;
+      opt->blockMax = IsSearch(req) && !(arng && arng->sortKeys);
     } else if (!strcmp(scorer, DOCSCORE_SCORER)) {
       opt->scorerType = SCORER_TYPE_DOC;
     } else if (!strcmp(scorer, HAMMINGDISTANCE_SCORER)) {
@@ -117,6 +131,7 @@ static QueryNode *checkQueryTypes(QueryNode *node, const char *name, QueryNode *
 
     case QN_GEO:       // TODO: ADD GEO support
     case QN_GEOMETRY:
+    case QN_MISSING:   // NO SCORE
     case QN_IDS:       // NO SCORE
     case QN_TAG:       // NO SCORE
     case QN_VECTOR:    // NO SCORE
@@ -127,6 +142,41 @@ static QueryNode *checkQueryTypes(QueryNode *node, const char *name, QueryNode *
   return ret;
 }
 
+static bool isGeoDistanceNode(const QueryNode *node, const char *name) {
+  return node->type == QN_GEO && node->opts.distField && !strcmp(node->opts.distField, name);
+}
+
+/* find the geo filter yielding the sortby distance, either as the root or as a child of an
+ * intersection root, and limit it to the nearest documents. A valid filter is required, since
+ * it is not evaluated (and validated) with the rest of the tree once taken out of the intersection */
+static bool checkGeoNearest(QueryNode *root, QOptimizer *opt) {
+  if (isGeoDistanceNode(root, opt->fieldName)) {
+    ((GeoFilter *)root->gn.gf)->limit = opt->limit;
+    return true;
+  }
+  if (root->type != QN_PHRASE || root->opts.weight != 1 || QueryNode_NumChildren(root) < 2) {
+    return false;
+  }
+  for (int i = 0; i < QueryNode_NumChildren(root); ++i) {
+    QueryNode *node = root->children[i];
+    if (!isGeoDistanceNode(node, opt->fieldName)) {
+      continue;
+    }
+    const GeoFilter *gf = node->gn.gf;
+    const FieldSpec *fs = IndexSpec_GetField(opt->sctx->spec, gf->property, strlen(gf->property));
+    QueryError status = {0};
+    bool valid = fs && FIELD_IS(fs, INDEXFLD_T_GEO) && GeoFilter_Validate(gf, &status);
+    QueryError_ClearError(&status);
+    if (!valid) {
+      return false;
+    }
+    array_del_fast(root->children, i);
+    opt->sortbyNode = node;
+    return true;
+  }
+  return false;
+}
+
 size_t QOptimizer_EstimateLimit(size_t numDocs, size_t estimate, size_t limit) {
   if (numDocs == 0 || estimate == 0) {
     return 0;
@@ -149,6 +199,19 @@ void QOptimizer_QueryNodes(QueryNode *root, QOptimizer *opt) {
     opt->scorerType = SCORER_TYPE_NONE;
   }
 
+  // sortby a SORTINDEX field. only the first documents in its order are needed
+  if (opt->sortIndex && opt->limit &&
+      !(root->type == QN_VECTOR && root->vn.vq->type == VECSIM_QT_KNN)) {
+    opt->type = Q_OPT_SORT_INDEX;
+    return;
+  }
+
+  // sortby the distance from a geo filter. only the nearest documents are needed
+  if (!isSortby && opt->fieldName && opt->asc && opt->limit && checkGeoNearest(root, opt)) {
+    opt->type = Q_OPT_GEO_NEAREST;
+    return;
+  }
+
   // find the sortby numeric node and remove it from query node tree
   QueryNode *parentNode = NULL;
   QueryNode *numSortbyNode = checkQueryTypes(root, name, &parentNode, &opt->scorerReq);
@@ -218,10 +281,47 @@ void QOptimizer_Iterators(AREQ *req, QOptimizer *opt) {
     case Q_OPT_HYBRID:
       RS_LOG_ASSERT(0, "cannot be decided earlier");
 
+    // All the results are scored, but we can skip the ones that cannot beat the top results
+    case Q_OPT_NONE:
+      if (opt->blockMax &&
+          IndexIterator_EnableBlockMax(root, &req->qiter.minScore, spec->docs.maxScore)) {
+        opt->type = Q_OPT_BLOCK_MAX;
+      } else if (opt->maxScore &&
+                 IndexIterator_EnableMaxScore(root, &req->qiter.minScore, spec->docs.maxScore)) {
+        opt->type = Q_OPT_MAX_SCORE;
+      }
+      return;
+
+    // the geo filter was taken out of the intersection. collect its nearest documents
+    // matching the rest of it
+    case Q_OPT_GEO_NEAREST: {
+      QueryNode *geoNode = opt->sortbyNode;
+      if (geoNode) {
+        req->rootiter = NewGeoNearestIterator(req->sctx, geoNode->gn.gf, root, opt->limit,
+                                              &req->ast.config);
+        MetricRequest mr = {geoNode->opts.distField, &req->rootiter->ownKey};
+        req->ast.metricRequests = array_ensure_append_1(req->ast.metricRequests, mr);
+      }
+      return;
+    }
+
+    // read the documents in the order of the sortby field, unless the filters match so few
+    // documents that reading them all is cheaper
+    case Q_OPT_SORT_INDEX: {
+      size_t estimate = IITER_NUM_ESTIMATED(root);
+      if (!estimate || QOptimizer_EstimateLimit(spec->docs.size, estimate, opt->limit) > estimate) {
+        opt->type = Q_OPT_NONE;
+        return;
+      }
+      req->rootiter = NewSortIndexIterator(req->sctx, opt->sortIndex, root, opt->limit, opt->asc);
+      return;
+    }
+
     // Nothing to do here
     case Q_OPT_NO_SORTER:
-    case Q_OPT_NONE:
     case Q_OPT_FILTER:
+    case Q_OPT_BLOCK_MAX:
+    case Q_OPT_MAX_SCORE:
       return;
 
     // limit range to number of required LIMIT
@@ -279,6 +379,14 @@ const char *QOptimizer_PrintType(QOptimizer *opt) {
       return "Undecided";
     case Q_OPT_FILTER:
       return "Filter";
+    case Q_OPT_BLOCK_MAX:
+      return "Block-max pruning";
+    case Q_OPT_MAX_SCORE:
+      return "MaxScore pruning";
+    case Q_OPT_GEO_NEAREST:
+      return "Nearest first";
+    case Q_OPT_SORT_INDEX:
+      return "Sort index";
   }
   return NULL;
 }
@@ -40,10 +40,25 @@ typedef enum {
   // Use `FILTER` result processor instead of numeric range
   Q_OPT_FILTER = 4,
 
+  // Skip blocks of documents which cannot make it to the top results by score
+  Q_OPT_BLOCK_MAX = 5,
+
+  // Sortby the distance yielded by a geo filter. Collect its nearest documents only
+  Q_OPT_GEO_NEAREST = 6,
+
+  // Skip the documents matched only by terms which cannot make it to the top results by score
+  Q_OPT_MAX_SCORE = 7,
+
+  // Sortby a SORTINDEX field. Read the documents in its order until enough of them match
+  Q_OPT_SORT_INDEX = 8,
+
   // sortby other field. currently no optimization
   // Q_OPT_SORTBY_OTHER
 } Q_Optimize_Type;
 
+// The number of top results up to which MaxScore pruning is used
+#define MAXSCORE_MAX_LIMIT 1000
+
 typedef enum {
   SCORER_TYPE_NONE = 0,
   SCORER_TYPE_TERM = 1,
@@ -57,10 +72,13 @@ typedef struct QOptimizer {
 
     bool scorerReq;             // does the query require a scorer (WITHSCORES does not count)
     ScorerType scorerType;      // 
+    bool blockMax;              // results are sorted by a scorer supporting block-max pruning
+    bool maxScore;              // results are sorted by a scorer supporting MaxScore pruning
 
     const char *fieldName;      // name of sortby field
     const FieldSpec *field;     // spec of sortby field
-    QueryNode *sortbyNode;      // pointer to QueryNode
+    QueryNode *sortbyNode;      // pointer to QueryNode (numeric, or geo for Q_OPT_GEO_NEAREST)
+    SortIndex *sortIndex;       // order of the sortby field, if it is a SORTINDEX field
     NumericFilter *nf;          // filter with required parameters
     bool asc;                   // ASC/DESC order of sortby
 
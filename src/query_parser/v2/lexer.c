@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 #include <math.h>
 
@@ -27,12 +28,21 @@ void RSQuery_Parse_v2(void *yyp, int yymajor, QueryToken yyminor, QueryParseCtx
 void *RSQuery_ParseAlloc_v2(void *(*mallocProc)(size_t));
 void RSQuery_ParseFree_v2(void *p, void (*freeProc)(void *));
 
+/* The token of a term: ISMISSING for the name of the function when it is called, as in
+ * `ismissing(@field)`, and TERM otherwise */
+static int termToken(const char *ts, const char *te, const QueryParseCtx *q) {
+  if (te - ts == 9 && !strncasecmp(ts, "ismissing", 9) && te < q->raw + q->len && *te == '(') {
+    return ISMISSING;
+  }
+  return TERM;
+}
 
-/* #line 319 "lexer.rl" */
 
+/* #line 329 "lexer.rl" */
 
 
-/* #line 36 "lexer.c" */
+
+/* #line 47 "lexer.c" */
 static const char _query_actions[] = {
 	0, 1, 0, 1, 1, 1, 2, 1, 
 	14, 1, 15, 1, 16, 1, 17, 1, 
@@ -244,7 +254,7 @@ static const int query_error = -1;
 static const int query_en_main = 21;
 
 
-/* #line 322 "lexer.rl" */
+/* #line 332 "lexer.rl" */
 
 QueryNode *RSQuery_ParseRaw_v2(QueryParseCtx *q) {
   void *pParser = RSQuery_ParseAlloc_v2(rm_malloc);
@@ -254,7 +264,7 @@ QueryNode *RSQuery_ParseRaw_v2(QueryParseCtx *q) {
   const char* ts = q->raw;
   const char* te = q->raw + q->len;
   
-/* #line 258 "lexer.c" */
+/* #line 269 "lexer.c" */
 	{
 	cs = query_start;
 	ts = 0;
@@ -262,7 +272,7 @@ QueryNode *RSQuery_ParseRaw_v2(QueryParseCtx *q) {
 	act = 0;
 	}
 
-/* #line 331 "lexer.rl" */
+/* #line 341 "lexer.rl" */
   QueryToken tok = {.len = 0, .pos = 0, .s = 0};
   
   //parseCtx ctx = {.root = NULL, .ok = 1, .errorMsg = NULL, .q = q};
@@ -271,7 +281,7 @@ QueryNode *RSQuery_ParseRaw_v2(QueryParseCtx *q) {
   const char* eof = pe;
   
   
-/* #line 275 "lexer.c" */
+/* #line 286 "lexer.c" */
 	{
 	int _klen;
 	unsigned int _trans;
@@ -290,7 +300,7 @@ _resume:
 /* #line 1 "NONE" */
 	{ts = p;}
 	break;
-/* #line 294 "lexer.c" */
+/* #line 305 "lexer.c" */
 		}
 	}
 
@@ -361,51 +371,51 @@ _eof_trans:
 	{te = p+1;}
 	break;
 	case 3:
-/* #line 66 "lexer.rl" */
+/* #line 76 "lexer.rl" */
 	{act = 1;}
 	break;
 	case 4:
-/* #line 77 "lexer.rl" */
+/* #line 87 "lexer.rl" */
 	{act = 2;}
 	break;
 	case 5:
-/* #line 88 "lexer.rl" */
+/* #line 98 "lexer.rl" */
 	{act = 3;}
 	break;
 	case 6:
-/* #line 97 "lexer.rl" */
+/* #line 107 "lexer.rl" */
 	{act = 4;}
 	break;
 	case 7:
-/* #line 115 "lexer.rl" */
+/* #line 125 "lexer.rl" */
 	{act = 6;}
 	break;
 	case 8:
-/* #line 124 "lexer.rl" */
+/* #line 134 "lexer.rl" */
 	{act = 7;}
 	break;
 	case 9:
-/* #line 193 "lexer.rl" */
+/* #line 203 "lexer.rl" */
 	{act = 16;}
 	break;
 	case 10:
-/* #line 207 "lexer.rl" */
+/* #line 217 "lexer.rl" */
 	{act = 18;}
 	break;
 	case 11:
-/* #line 236 "lexer.rl" */
+/* #line 246 "lexer.rl" */
 	{act = 23;}
 	break;
 	case 12:
-/* #line 239 "lexer.rl" */
+/* #line 249 "lexer.rl" */
 	{act = 25;}
 	break;
 	case 13:
-/* #line 263 "lexer.rl" */
+/* #line 273 "lexer.rl" */
 	{act = 27;}
 	break;
 	case 14:
-/* #line 106 "lexer.rl" */
+/* #line 116 "lexer.rl" */
 	{te = p+1;{
     tok.pos = ts-q->raw;
     tok.len = te - ts;
@@ -417,7 +427,7 @@ _eof_trans:
   }}
 	break;
 	case 15:
-/* #line 124 "lexer.rl" */
+/* #line 134 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     tok.s = ts;
@@ -430,7 +440,7 @@ _eof_trans:
   }}
 	break;
 	case 16:
-/* #line 135 "lexer.rl" */
+/* #line 145 "lexer.rl" */
 	{te = p+1;{
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, QUOTE, tok, q);  
@@ -440,7 +450,7 @@ _eof_trans:
   }}
 	break;
 	case 17:
-/* #line 142 "lexer.rl" */
+/* #line 152 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, OR, tok, q);
@@ -450,7 +460,7 @@ _eof_trans:
   }}
 	break;
 	case 18:
-/* #line 149 "lexer.rl" */
+/* #line 159 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, LP, tok, q);
@@ -460,7 +470,7 @@ _eof_trans:
   }}
 	break;
 	case 19:
-/* #line 157 "lexer.rl" */
+/* #line 167 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, RP, tok, q);
@@ -470,7 +480,7 @@ _eof_trans:
   }}
 	break;
 	case 20:
-/* #line 164 "lexer.rl" */
+/* #line 174 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, LB, tok, q);
@@ -480,7 +490,7 @@ _eof_trans:
   }}
 	break;
 	case 21:
-/* #line 171 "lexer.rl" */
+/* #line 181 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, RB, tok, q);
@@ -490,7 +500,7 @@ _eof_trans:
   }}
 	break;
 	case 22:
-/* #line 178 "lexer.rl" */
+/* #line 188 "lexer.rl" */
 	{te = p+1;{ 
      tok.pos = ts-q->raw;
      RSQuery_Parse_v2(pParser, COLON, tok, q);
@@ -500,7 +510,7 @@ _eof_trans:
    }}
 	break;
 	case 23:
-/* #line 185 "lexer.rl" */
+/* #line 195 "lexer.rl" */
 	{te = p+1;{ 
      tok.pos = ts-q->raw;
      RSQuery_Parse_v2(pParser, SEMICOLON, tok, q);
@@ -510,7 +520,7 @@ _eof_trans:
    }}
 	break;
 	case 24:
-/* #line 200 "lexer.rl" */
+/* #line 210 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, TILDE, tok, q);  
@@ -520,7 +530,7 @@ _eof_trans:
   }}
 	break;
 	case 25:
-/* #line 214 "lexer.rl" */
+/* #line 224 "lexer.rl" */
 	{te = p+1;{
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, PERCENT, tok, q);
@@ -530,7 +540,7 @@ _eof_trans:
   }}
 	break;
 	case 26:
-/* #line 221 "lexer.rl" */
+/* #line 231 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, LSQB, tok, q);  
@@ -540,7 +550,7 @@ _eof_trans:
   }}
 	break;
 	case 27:
-/* #line 228 "lexer.rl" */
+/* #line 238 "lexer.rl" */
 	{te = p+1;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, RSQB, tok, q);   
@@ -550,19 +560,19 @@ _eof_trans:
   }}
 	break;
 	case 28:
-/* #line 235 "lexer.rl" */
+/* #line 245 "lexer.rl" */
 	{te = p+1;}
 	break;
 	case 29:
-/* #line 236 "lexer.rl" */
+/* #line 246 "lexer.rl" */
 	{te = p+1;}
 	break;
 	case 30:
-/* #line 237 "lexer.rl" */
+/* #line 247 "lexer.rl" */
 	{te = p+1;}
 	break;
 	case 31:
-/* #line 249 "lexer.rl" */
+/* #line 259 "lexer.rl" */
 	{te = p+1;{
     int is_attr = (*ts == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_TERM : QT_TERM;
@@ -579,7 +589,7 @@ _eof_trans:
   }}
 	break;
 	case 32:
-/* #line 277 "lexer.rl" */
+/* #line 287 "lexer.rl" */
 	{te = p+1;{
     int is_attr = (*(ts+1) == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_TERM : QT_TERM;
@@ -596,7 +606,7 @@ _eof_trans:
   }}
 	break;
 	case 33:
-/* #line 292 "lexer.rl" */
+/* #line 302 "lexer.rl" */
 	{te = p+1;{
     int is_attr = (*(ts+2) == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_TERM : QT_TERM;
@@ -611,7 +621,7 @@ _eof_trans:
   }}
 	break;
 	case 34:
-/* #line 305 "lexer.rl" */
+/* #line 315 "lexer.rl" */
 	{te = p+1;{
     int is_attr = (*(ts+2) == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_WILDCARD : QT_WILDCARD;
@@ -626,7 +636,7 @@ _eof_trans:
   }}
 	break;
 	case 35:
-/* #line 66 "lexer.rl" */
+/* #line 76 "lexer.rl" */
 	{te = p;p--;{ 
     tok.s = ts;
     tok.len = te-ts;
@@ -640,7 +650,7 @@ _eof_trans:
   }}
 	break;
 	case 36:
-/* #line 77 "lexer.rl" */
+/* #line 87 "lexer.rl" */
 	{te = p;p--;{ 
     tok.s = ts;
     tok.len = te-ts;
@@ -654,7 +664,7 @@ _eof_trans:
   }}
 	break;
 	case 37:
-/* #line 97 "lexer.rl" */
+/* #line 107 "lexer.rl" */
 	{te = p;p--;{
     tok.pos = ts-q->raw;
     tok.len = te - (ts + 1);
@@ -666,7 +676,7 @@ _eof_trans:
   }}
 	break;
 	case 38:
-/* #line 124 "lexer.rl" */
+/* #line 134 "lexer.rl" */
 	{te = p;p--;{ 
     tok.pos = ts-q->raw;
     tok.s = ts;
@@ -679,7 +689,7 @@ _eof_trans:
   }}
 	break;
 	case 39:
-/* #line 193 "lexer.rl" */
+/* #line 203 "lexer.rl" */
 	{te = p;p--;{ 
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, MINUS, tok, q);  
@@ -689,7 +699,7 @@ _eof_trans:
   }}
 	break;
 	case 40:
-/* #line 207 "lexer.rl" */
+/* #line 217 "lexer.rl" */
 	{te = p;p--;{
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, STAR, tok, q);
@@ -699,24 +709,24 @@ _eof_trans:
   }}
 	break;
 	case 41:
-/* #line 236 "lexer.rl" */
+/* #line 246 "lexer.rl" */
 	{te = p;p--;}
 	break;
 	case 42:
-/* #line 239 "lexer.rl" */
+/* #line 249 "lexer.rl" */
 	{te = p;p--;{
     tok.len = te-ts;
     tok.s = ts;
     tok.numval = 0;
     tok.pos = ts-q->raw;
-    RSQuery_Parse_v2(pParser, TERM, tok, q);
+    RSQuery_Parse_v2(pParser, termToken(ts, te, q), tok, q);
     if (!QPCTX_ISOK(q)) {
       {p++; goto _out; }
     }
   }}
 	break;
 	case 43:
-/* #line 263 "lexer.rl" */
+/* #line 273 "lexer.rl" */
 	{te = p;p--;{
     int is_attr = (*(ts+1) == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_TERM : QT_TERM;
@@ -733,7 +743,7 @@ _eof_trans:
   }}
 	break;
 	case 44:
-/* #line 77 "lexer.rl" */
+/* #line 87 "lexer.rl" */
 	{{p = ((te))-1;}{ 
     tok.s = ts;
     tok.len = te-ts;
@@ -747,7 +757,7 @@ _eof_trans:
   }}
 	break;
 	case 45:
-/* #line 207 "lexer.rl" */
+/* #line 217 "lexer.rl" */
 	{{p = ((te))-1;}{
     tok.pos = ts-q->raw;
     RSQuery_Parse_v2(pParser, STAR, tok, q);
@@ -757,24 +767,24 @@ _eof_trans:
   }}
 	break;
 	case 46:
-/* #line 236 "lexer.rl" */
+/* #line 246 "lexer.rl" */
 	{{p = ((te))-1;}}
 	break;
 	case 47:
-/* #line 239 "lexer.rl" */
+/* #line 249 "lexer.rl" */
 	{{p = ((te))-1;}{
     tok.len = te-ts;
     tok.s = ts;
     tok.numval = 0;
     tok.pos = ts-q->raw;
-    RSQuery_Parse_v2(pParser, TERM, tok, q);
+    RSQuery_Parse_v2(pParser, termToken(ts, te, q), tok, q);
     if (!QPCTX_ISOK(q)) {
       {p++; goto _out; }
     }
   }}
 	break;
 	case 48:
-/* #line 263 "lexer.rl" */
+/* #line 273 "lexer.rl" */
 	{{p = ((te))-1;}{
     int is_attr = (*(ts+1) == '$') ? 1 : 0;
     tok.type = is_attr ? QT_PARAM_TERM : QT_TERM;
@@ -888,7 +898,7 @@ _eof_trans:
     tok.s = ts;
     tok.numval = 0;
     tok.pos = ts-q->raw;
-    RSQuery_Parse_v2(pParser, TERM, tok, q);
+    RSQuery_Parse_v2(pParser, termToken(ts, te, q), tok, q);
     if (!QPCTX_ISOK(q)) {
       {p++; goto _out; }
     }
@@ -916,7 +926,7 @@ _eof_trans:
 	}
 	}
 	break;
-/* #line 920 "lexer.c" */
+/* #line 931 "lexer.c" */
 		}
 	}
 
@@ -929,7 +939,7 @@ _again:
 /* #line 1 "NONE" */
 	{ts = 0;}
 	break;
-/* #line 933 "lexer.c" */
+/* #line 944 "lexer.c" */
 		}
 	}
 
@@ -947,7 +957,7 @@ _again:
 	_out: {}
 	}
 
-/* #line 339 "lexer.rl" */
+/* #line 349 "lexer.rl" */
   
   if (QPCTX_ISOK(q)) {
     RSQuery_Parse_v2(pParser, 0, tok, q);
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 #include <math.h>
 
@@ -25,6 +26,15 @@ void RSQuery_Parse_v2(void *yyp, int yymajor, QueryToken yyminor, QueryParseCtx
 void *RSQuery_ParseAlloc_v2(void *(*mallocProc)(size_t));
 void RSQuery_ParseFree_v2(void *p, void (*freeProc)(void *));
 
+/* The token of a term: ISMISSING for the name of the function when it is called, as in
+ * `ismissing(@field)`, and TERM otherwise */
+static int termToken(const char *ts, const char *te, const QueryParseCtx *q) {
+  if (te - ts == 9 && !strncasecmp(ts, "ismissing", 9) && te < q->raw + q->len && *te == '(') {
+    return ISMISSING;
+  }
+  return TERM;
+}
+
 %%{
 
 machine query;
@@ -241,7 +251,7 @@ main := |*
     tok.s = ts;
     tok.numval = 0;
     tok.pos = ts-q->raw;
-    RSQuery_Parse_v2(pParser, TERM, tok, q);
+    RSQuery_Parse_v2(pParser, termToken(ts, te, q), tok, q);
     if (!QPCTX_ISOK(q)) {
       fbreak;
     }
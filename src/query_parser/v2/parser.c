@@ -109,25 +109,26 @@ static void reportSyntaxError(QueryError *status, QueryToken* tok, const char *m
 #define LP                             11
 #define LB                             12
 #define LSQB                           13
-#define TILDE                          14
-#define MINUS                          15
-#define AND                            16
-#define ARROW                          17
-#define COLON                          18
-#define NUMBER                         19
-#define SIZE                           20
-#define STAR                           21
-#define TAGLIST                        22
-#define TERMLIST                       23
-#define PREFIX                         24
-#define SUFFIX                         25
-#define CONTAINS                       26
-#define PERCENT                        27
-#define ATTRIBUTE                      28
-#define VERBATIM                       29
-#define WILDCARD                       30
-#define AS_T                           31
-#define SEMICOLON                      32
+#define ISMISSING                      14
+#define TILDE                          15
+#define MINUS                          16
+#define AND                            17
+#define ARROW                          18
+#define COLON                          19
+#define NUMBER                         20
+#define SIZE                           21
+#define STAR                           22
+#define TAGLIST                        23
+#define TERMLIST                       24
+#define PREFIX                         25
+#define SUFFIX                         26
+#define CONTAINS                       27
+#define PERCENT                        28
+#define ATTRIBUTE                      29
+#define VERBATIM                       30
+#define WILDCARD                       31
+#define AS_T                           32
+#define SEMICOLON                      33
 #endif
 /**************** End token definitions ***************************************/
 
@@ -187,20 +188,20 @@ static void reportSyntaxError(QueryError *status, QueryToken* tok, const char *m
 #endif
 /************* Begin control #defines *****************************************/
 #define YYCODETYPE unsigned char
-#define YYNOCODE 66
+#define YYNOCODE 67
 #define YYACTIONTYPE unsigned short int
 #define RSQueryParser_v2_TOKENTYPE QueryToken
 typedef union {
   int yyinit;
   RSQueryParser_v2_TOKENTYPE yy0;
-  VectorQueryParams yy2;
-  Vector* yy42;
-  QueryAttribute yy43;
-  QueryAttribute * yy45;
-  RangeNumber yy47;
-  QueryParam * yy62;
-  QueryNode * yy119;
-  SingleVectorQueryParam yy125;
+  VectorQueryParams yy4;
+  QueryNode * yy13;
+  QueryAttribute yy35;
+  Vector* yy50;
+  QueryParam * yy72;
+  SingleVectorQueryParam yy79;
+  RangeNumber yy93;
+  QueryAttribute * yy95;
 } YYMINORTYPE;
 #ifndef YYSTACKDEPTH
 #define YYSTACKDEPTH 256
@@ -216,18 +217,18 @@ typedef union {
 #define RSQueryParser_v2_CTX_FETCH
 #define RSQueryParser_v2_CTX_STORE
 #define YYFALLBACK 1
-#define YYNSTATE             122
-#define YYNRULE              100
-#define YYNRULE_WITH_ACTION  97
-#define YYNTOKEN             33
-#define YY_MAX_SHIFT         121
-#define YY_MIN_SHIFTREDUCE   188
-#define YY_MAX_SHIFTREDUCE   287
-#define YY_ERROR_ACTION      288
-#define YY_ACCEPT_ACTION     289
-#define YY_NO_ACTION         290
-#define YY_MIN_REDUCE        291
-#define YY_MAX_REDUCE        390
+#define YYNSTATE             125
+#define YYNRULE              101
+#define YYNRULE_WITH_ACTION  98
+#define YYNTOKEN             34
+#define YY_MAX_SHIFT         124
+#define YY_MIN_SHIFTREDUCE   192
+#define YY_MAX_SHIFTREDUCE   292
+#define YY_ERROR_ACTION      293
+#define YY_ACCEPT_ACTION     294
+#define YY_NO_ACTION         295
+#define YY_MIN_REDUCE        296
+#define YY_MAX_REDUCE        396
 /************* End control #defines *******************************************/
 #define YY_NLOOKAHEAD ((int)(sizeof(yy_lookahead)/sizeof(yy_lookahead[0])))
 
@@ -294,211 +295,212 @@ typedef union {
 **  yy_default[]       Default action for each state.
 **
 *********** Begin parsing tables **********************************************/
-#define YY_ACTTAB_COUNT (753)
+#define YY_ACTTAB_COUNT (758)
 static const YYACTIONTYPE yy_action[] = {
- /*     0 */   369,   46,   52,  339,   12,  234,  206,  374,  386,  273,
- /*    10 */    45,   15,  359,   54,   13,   14,   55,  105,   74,  274,
- /*    20 */   275,   59,  117,   53,  227,  228,  229,   51,  277,  273,
- /*    30 */   230,   16,  234,  207,  118,  386,  273,   45,   15,  274,
- /*    40 */   275,   13,   14,  107,  119,  287,  274,  275,  116,   93,
- /*    50 */   368,  227,  228,  229,   51,  277,  291,  230,  273,  375,
- /*    60 */    12,  234,  358,   54,  386,  273,   45,   15,  274,  275,
- /*    70 */    13,   14,   47,   85,   76,  274,  275,  277,  273,  338,
- /*    80 */   227,  228,  229,   51,  277,  292,  230,   75,  274,  275,
- /*    90 */   234,  273,  114,  379,  273,   45,    1,  279,  234,   13,
- /*   100 */    14,  274,  275,  101,  274,  275,  285,  115,  379,  227,
- /*   110 */   228,  229,   51,  277,  313,  230,   16,  234,  325,  379,
- /*   120 */   280,  273,   45,   15,  367,  379,   13,   14,  281,   79,
- /*   130 */   356,  274,  275,  381,  362,  364,  227,  228,  229,   51,
- /*   140 */   277,   61,  230,   16,  234,  109,  379,   94,  273,   45,
- /*   150 */    15,  112,  379,   13,   14,   97,  119,  102,  274,  275,
- /*   160 */   324,  379,  286,  227,  228,  229,   51,  277,   35,  230,
- /*   170 */   207,  312,   77,  273,   45,   34,  311,  379,   32,   33,
- /*   180 */    76,  119,   76,  274,  275,   78,   95,   43,  227,  228,
- /*   190 */   229,   51,  277,  365,  230,  234,  312,   80,   63,  273,
- /*   200 */    45,    1,   99,   43,   13,   14,  312,   83,   81,  274,
- /*   210 */   275,  285,  312,   86,  227,  228,  229,   51,  277,   64,
- /*   220 */   230,  234,  104,   43,  263,  273,   45,   15,  357,  363,
- /*   230 */    13,   14,   65,  105,   84,  274,  275,  312,   92,   67,
- /*   240 */   227,  228,  229,   51,  277,   98,  230,  234,   68,   62,
- /*   250 */   268,  273,   45,   15,  273,  215,   13,   14,  267,  119,
- /*   260 */   213,  274,  275,  251,  274,  275,  227,  228,  229,   51,
- /*   270 */   277,  106,  230,  277,  249,  386,  273,   45,   34,   27,
- /*   280 */    44,   32,   33,   49,  293,   76,  274,  275,  355,   67,
- /*   290 */    66,  227,  228,  229,   51,  277,  382,  230,  234,  382,
- /*   300 */   233,  100,  273,   45,   15,  103,   71,   13,   14,  214,
- /*   310 */    70,   72,  274,  275,  270,  269,   73,  227,  228,  229,
- /*   320 */    51,  277,   68,  230,  110,   31,  111,  273,   45,   34,
- /*   330 */    26,  232,   32,   33,   76,  119,  113,  274,  275,  217,
- /*   340 */   231,  216,  227,  228,  229,   51,  277,   69,  230,   36,
- /*   350 */    60,   70,  273,   45,   34,  270,  269,   32,   33,   17,
- /*   360 */   290,  290,  274,  275,  108,  290,  290,  227,  228,  229,
- /*   370 */    51,  277,    4,  230,  381,  322,   41,  381,  323,  237,
- /*   380 */   121,  120,    5,   48,  290,   69,  290,  290,  290,   70,
- /*   390 */   290,  290,   87,  270,  269,  289,   82,   91,  321,  379,
- /*   400 */   290,    2,  282,  290,  322,  290,  290,  323,  290,  121,
- /*   410 */   120,    3,  322,  290,   22,  323,  290,  322,  120,   39,
- /*   420 */   323,   87,  121,  120,   25,   96,   91,  321,  379,  290,
- /*   430 */   290,  290,  290,  290,   87,  321,  379,  290,  290,   91,
- /*   440 */   321,  379,  290,   23,  290,  290,  322,  290,  290,  323,
- /*   450 */   290,  121,  120,   24,  322,  290,    9,  323,  290,  322,
- /*   460 */   120,   40,  323,   87,  121,  120,   10,  290,   91,  321,
- /*   470 */   379,  290,  290,  290,  290,  290,   87,  321,  379,  290,
- /*   480 */   290,   91,  321,  379,  290,   19,  290,  290,  322,  290,
- /*   490 */   290,  323,  290,  121,  120,   20,  322,  290,   18,  323,
- /*   500 */   290,  322,  120,   37,  323,   87,  121,  120,   21,  290,
- /*   510 */    91,  321,  379,  290,  290,  290,  290,  290,   87,  321,
- /*   520 */   379,  290,  290,   91,  321,  379,  290,    2,  290,  290,
- /*   530 */   322,  290,  290,  323,  290,  121,  120,    3,  322,  290,
- /*   540 */     8,  323,  290,  322,  120,   38,  323,   87,  121,  120,
- /*   550 */    11,  290,   91,  321,  379,  290,  290,  290,  290,  290,
- /*   560 */    87,  321,  379,  290,  290,   91,  321,  379,  290,    7,
- /*   570 */   290,  290,  322,  290,  290,  323,  290,  121,  120,    6,
- /*   580 */   290,  322,  290,  290,  323,  290,  290,  120,   28,   87,
- /*   590 */   105,  290,  274,  275,   91,  321,  379,  227,  228,  229,
- /*   600 */    51,  277,  290,  230,  321,  379,  290,  119,  290,  274,
- /*   610 */   275,  290,  290,  290,  227,  228,  229,   51,  277,  290,
- /*   620 */   230,  290,  290,  290,  290,  290,  290,  322,  290,  290,
- /*   630 */   323,  290,  342,  120,   42,  343,   57,  351,  353,  290,
- /*   640 */   290,   90,  290,  273,  290,  290,  349,  290,  290,  290,
- /*   650 */   321,  379,  290,  274,  275,   59,   89,  341,  227,  228,
- /*   660 */   229,  290,   88,  290,  230,  290,  274,  275,  290,  290,
- /*   670 */   290,  227,  228,  229,   51,  277,  290,  230,  322,  290,
- /*   680 */   322,  323,  290,  323,  120,   29,  120,   30,  346,   69,
- /*   690 */   290,  347,   56,   70,  290,  290,  290,  270,  269,  273,
- /*   700 */   290,  321,  379,  321,  379,  290,  282,  290,  290,  274,
- /*   710 */   275,   59,   89,  345,  290,  290,  290,   58,  277,  273,
- /*   720 */   247,  290,  290,   69,  290,  290,  290,   70,  290,  274,
- /*   730 */   275,  270,  269,  290,  290,   71,  290,   50,  277,   70,
- /*   740 */   282,  290,  290,  270,  269,  290,  290,  290,  290,  290,
- /*   750 */   290,  290,  284,
+ /*     0 */   375,   46,  344,   52,   12,  238,  210,  117,  385,  278,
+ /*    10 */    45,   15,  365,   54,  108,   13,   14,   74,  106,   94,
+ /*    20 */   279,  280,   59,  120,  278,  231,  232,  233,   51,  282,
+ /*    30 */   121,  234,   16,  238,  211,  279,  280,  278,   45,   15,
+ /*    40 */   380,   53,  108,   13,   14,   77,  122,  362,  279,  280,
+ /*    50 */   118,  385,  392,  231,  232,  233,   51,  282,  296,  234,
+ /*    60 */    55,   71,   12,  238,  292,   95,   70,  278,   45,   15,
+ /*    70 */   275,  274,  108,   13,   14,  381,   86,  343,  279,  280,
+ /*    80 */   387,  368,  374,  231,  232,  233,   51,  282,  297,  234,
+ /*    90 */   317,   78,  392,  238,  364,   54,  238,  278,   45,    1,
+ /*   100 */   110,   75,  108,   13,   14,  330,  385,   98,  279,  280,
+ /*   110 */   290,  373,  385,  231,  232,  233,   51,  282,  102,  234,
+ /*   120 */    16,  238,  112,  385,  107,  278,   45,   15,  115,  385,
+ /*   130 */   108,   13,   14,   77,   80,  370,  279,  280,  392,  329,
+ /*   140 */   385,  231,  232,  233,   51,  282,   47,  234,   16,  238,
+ /*   150 */   316,  385,  318,  278,   45,   15,   96,   43,  108,   13,
+ /*   160 */    14,  363,  122,   61,  279,  280,  317,   81,   79,  231,
+ /*   170 */   232,  233,   51,  282,  291,  234,  238,  100,   43,   99,
+ /*   180 */   278,   45,    1,  317,   84,  108,   13,   14,  105,   43,
+ /*   190 */   371,  279,  280,  290,  317,   87,  231,  232,  233,   51,
+ /*   200 */   282,  388,  234,  238,  388,  317,   93,  278,   45,   15,
+ /*   210 */    82,  103,  108,   13,   14,  298,  106,   72,  279,  280,
+ /*   220 */   285,   68,   62,  231,  232,  233,   51,  282,  286,  234,
+ /*   230 */   238,  361,   31,  101,  278,   45,   15,   77,   63,  108,
+ /*   240 */    13,   14,   64,  122,  217,  279,  280,   67,   66,  104,
+ /*   250 */   231,  232,  233,   51,  282,   35,  234,  211,   73,  218,
+ /*   260 */   278,   45,   34,  268,  369,  387,   32,   33,  387,  122,
+ /*   270 */    77,  279,  280,   26,   65,   85,  231,  232,  233,   51,
+ /*   280 */   282,   41,  234,  238,  241,   77,   67,  278,   45,   15,
+ /*   290 */   278,  219,  108,   13,   14,  250,   76,  273,  279,  280,
+ /*   300 */   272,  279,  280,  231,  232,  233,   51,  282,  256,  234,
+ /*   310 */   282,  254,  237,  278,   45,   34,   27,   44,   69,   32,
+ /*   320 */    33,  113,  114,   70,  279,  280,  236,  275,  274,  231,
+ /*   330 */   232,  233,   51,  282,  116,  234,  111,  235,  221,  278,
+ /*   340 */    45,   34,   48,   60,   69,   32,   33,  220,  122,   70,
+ /*   350 */   279,  280,   68,  275,  274,  231,  232,  233,   51,  282,
+ /*   360 */   295,  234,  287,  295,  295,  278,   45,   34,  295,  295,
+ /*   370 */    69,   32,   33,  295,  295,   70,  279,  280,  295,  275,
+ /*   380 */   274,  231,  232,  233,   51,  282,    4,  234,  287,  327,
+ /*   390 */    36,   17,  328,  295,  124,  123,    5,  327,  295,  295,
+ /*   400 */   328,  295,  295,  123,   39,  295,   88,  295,  295,  294,
+ /*   410 */    83,   92,  326,  385,  295,  295,    2,  295,  295,  327,
+ /*   420 */   326,  385,  328,  295,  124,  123,    3,  327,  295,   22,
+ /*   430 */   328,  295,  327,  123,   40,  328,   88,  124,  123,   25,
+ /*   440 */    97,   92,  326,  385,  295,  295,  295,  295,  295,   88,
+ /*   450 */   326,  385,  295,  295,   92,  326,  385,   23,  295,  295,
+ /*   460 */   327,  295,  295,  328,  295,  124,  123,   24,  327,  295,
+ /*   470 */     9,  328,  295,  327,  123,   37,  328,   88,  124,  123,
+ /*   480 */    10,  109,   92,  326,  385,  392,  295,  295,  295,  295,
+ /*   490 */    88,  326,  385,   49,  295,   92,  326,  385,   19,  295,
+ /*   500 */   295,  327,  295,  295,  328,  295,  124,  123,   20,  327,
+ /*   510 */   295,   18,  328,  295,  327,  123,   38,  328,   88,  124,
+ /*   520 */   123,   21,  295,   92,  326,  385,  295,  295,  295,  295,
+ /*   530 */   295,   88,  326,  385,  295,  295,   92,  326,  385,    2,
+ /*   540 */   295,  295,  327,  295,  295,  328,  295,  124,  123,    3,
+ /*   550 */   327,  295,    8,  328,  295,  327,  123,   28,  328,   88,
+ /*   560 */   124,  123,   11,  295,   92,  326,  385,  295,  295,  295,
+ /*   570 */   295,  295,   88,  326,  385,  295,  295,   92,  326,  385,
+ /*   580 */     7,  295,  278,  327,  278,  295,  328,  295,  124,  123,
+ /*   590 */     6,  295,  295,  279,  280,  279,  280,  295,  295,  295,
+ /*   600 */    88,   58,  282,   50,  282,   92,  326,  385,  106,  295,
+ /*   610 */   279,  280,  295,  295,  295,  231,  232,  233,   51,  282,
+ /*   620 */   295,  234,  295,  295,  122,  295,  279,  280,  295,  295,
+ /*   630 */   295,  231,  232,  233,   51,  282,  295,  234,  327,  295,
+ /*   640 */   295,  328,  295,  295,  123,   42,  295,  278,  357,  359,
+ /*   650 */   295,  295,  295,  295,  295,  295,  295,  355,  279,  280,
+ /*   660 */   295,  326,  385,  231,  232,  233,  295,   89,  295,  234,
+ /*   670 */   279,  280,  278,  295,  295,  231,  232,  233,   51,  282,
+ /*   680 */   295,  234,  347,  279,  280,  348,   57,  295,  295,  295,
+ /*   690 */   295,   91,  119,  295,  295,  327,  295,  327,  328,  295,
+ /*   700 */   328,  123,   29,  123,   30,   59,   90,  346,  351,  295,
+ /*   710 */   295,  352,   56,  295,  252,  295,  295,   69,  326,  385,
+ /*   720 */   326,  385,   70,  295,  295,  295,  275,  274,  295,   71,
+ /*   730 */   278,   59,   90,  350,   70,  287,  295,  278,  275,  274,
+ /*   740 */   295,  279,  280,  295,  295,  295,  295,  289,  279,  280,
+ /*   750 */   282,  295,  295,  295,  295,  295,  295,  284,
 };
 static const YYCODETYPE yy_lookahead[] = {
- /*     0 */    51,   52,   40,   60,    4,    5,    6,   54,   54,    9,
- /*    10 */    10,   11,   63,   64,   14,   15,   62,   17,    9,   19,
- /*    20 */    20,   59,   60,    9,   24,   25,   26,   27,   28,    9,
- /*    30 */    30,    4,    5,    6,   28,   54,    9,   10,   11,   19,
- /*    40 */    20,   14,   15,   62,   17,   31,   19,   20,   28,    7,
- /*    50 */    51,   24,   25,   26,   27,   28,    0,   30,    9,   54,
- /*    60 */     4,    5,   63,   64,   54,    9,   10,   11,   19,   20,
- /*    70 */    14,   15,   62,   17,   32,   19,   20,   28,    9,   60,
- /*    80 */    24,   25,   26,   27,   28,    0,   30,   65,   19,   20,
- /*    90 */     5,    9,   59,   60,    9,   10,   11,   28,    5,   14,
- /*   100 */    15,   19,   20,   58,   19,   20,   21,   59,   60,   24,
- /*   110 */    25,   26,   27,   28,   34,   30,    4,    5,   59,   60,
- /*   120 */    20,    9,   10,   11,   59,   60,   14,   15,   28,   17,
- /*   130 */     0,   19,   20,   60,   61,    0,   24,   25,   26,   27,
- /*   140 */    28,   12,   30,    4,    5,   59,   60,   17,    9,   10,
- /*   150 */    11,   59,   60,   14,   15,    7,   17,    7,   19,   20,
- /*   160 */    59,   60,    6,   24,   25,   26,   27,   28,    4,   30,
- /*   170 */     6,   34,   35,    9,   10,   11,   59,   60,   14,   15,
- /*   180 */    32,   17,   32,   19,   20,    8,   48,   49,   24,   25,
- /*   190 */    26,   27,   28,    0,   30,    5,   34,   35,   12,    9,
- /*   200 */    10,   11,   48,   49,   14,   15,   34,   35,    8,   19,
- /*   210 */    20,   21,   34,   35,   24,   25,   26,   27,   28,   13,
- /*   220 */    30,    5,   48,   49,   28,    9,   10,   11,    0,    0,
- /*   230 */    14,   15,   12,   17,    8,   19,   20,   34,   35,   12,
- /*   240 */    24,   25,   26,   27,   28,   17,   30,    5,   12,   13,
- /*   250 */    28,    9,   10,   11,    9,   10,   14,   15,    8,   17,
- /*   260 */     7,   19,   20,    8,   19,   20,   24,   25,   26,   27,
- /*   270 */    28,   50,   30,   28,    8,   54,    9,   10,   11,   12,
- /*   280 */    13,   14,   15,   62,    0,   32,   19,   20,    0,   12,
- /*   290 */    13,   24,   25,   26,   27,   28,    4,   30,    5,    7,
- /*   300 */    27,   17,    9,   10,   11,   17,   11,   14,   15,    7,
- /*   310 */    15,    4,   19,   20,   19,   20,    4,   24,   25,   26,
- /*   320 */    27,   28,   12,   30,   27,   18,   27,    9,   10,   11,
- /*   330 */    18,   27,   14,   15,   32,   17,   27,   19,   20,   10,
- /*   340 */    27,   10,   24,   25,   26,   27,   28,   11,   30,    4,
- /*   350 */    18,   15,    9,   10,   11,   19,   20,   14,   15,    4,
- /*   360 */    66,   66,   19,   20,   28,   66,   66,   24,   25,   26,
- /*   370 */    27,   28,   33,   30,    4,   36,    4,    7,   39,    7,
- /*   380 */    41,   42,   43,    9,   66,   11,   66,   66,   66,   15,
- /*   390 */    66,   66,   53,   19,   20,   56,   57,   58,   59,   60,
- /*   400 */    66,   33,   28,   66,   36,   66,   66,   39,   66,   41,
- /*   410 */    42,   43,   36,   66,   33,   39,   66,   36,   42,   43,
- /*   420 */    39,   53,   41,   42,   43,   57,   58,   59,   60,   66,
- /*   430 */    66,   66,   66,   66,   53,   59,   60,   66,   66,   58,
- /*   440 */    59,   60,   66,   33,   66,   66,   36,   66,   66,   39,
- /*   450 */    66,   41,   42,   43,   36,   66,   33,   39,   66,   36,
- /*   460 */    42,   43,   39,   53,   41,   42,   43,   66,   58,   59,
- /*   470 */    60,   66,   66,   66,   66,   66,   53,   59,   60,   66,
- /*   480 */    66,   58,   59,   60,   66,   33,   66,   66,   36,   66,
- /*   490 */    66,   39,   66,   41,   42,   43,   36,   66,   33,   39,
- /*   500 */    66,   36,   42,   43,   39,   53,   41,   42,   43,   66,
- /*   510 */    58,   59,   60,   66,   66,   66,   66,   66,   53,   59,
- /*   520 */    60,   66,   66,   58,   59,   60,   66,   33,   66,   66,
- /*   530 */    36,   66,   66,   39,   66,   41,   42,   43,   36,   66,
- /*   540 */    33,   39,   66,   36,   42,   43,   39,   53,   41,   42,
- /*   550 */    43,   66,   58,   59,   60,   66,   66,   66,   66,   66,
- /*   560 */    53,   59,   60,   66,   66,   58,   59,   60,   66,   33,
- /*   570 */    66,   66,   36,   66,   66,   39,   66,   41,   42,   43,
- /*   580 */    66,   36,   66,   66,   39,   66,   66,   42,   43,   53,
- /*   590 */    17,   66,   19,   20,   58,   59,   60,   24,   25,   26,
- /*   600 */    27,   28,   66,   30,   59,   60,   66,   17,   66,   19,
- /*   610 */    20,   66,   66,   66,   24,   25,   26,   27,   28,   66,
- /*   620 */    30,   66,   66,   66,   66,   66,   66,   36,   66,   66,
- /*   630 */    39,   66,   36,   42,   43,   39,   40,   46,   47,   66,
- /*   640 */    66,   45,   66,    9,   66,   66,   55,   66,   66,   66,
- /*   650 */    59,   60,   66,   19,   20,   59,   60,   61,   24,   25,
- /*   660 */    26,   66,   28,   66,   30,   66,   19,   20,   66,   66,
- /*   670 */    66,   24,   25,   26,   27,   28,   66,   30,   36,   66,
- /*   680 */    36,   39,   66,   39,   42,   43,   42,   43,   36,   11,
- /*   690 */    66,   39,   40,   15,   66,   66,   66,   19,   20,    9,
- /*   700 */    66,   59,   60,   59,   60,   66,   28,   66,   66,   19,
- /*   710 */    20,   59,   60,   61,   66,   66,   66,   27,   28,    9,
- /*   720 */     8,   66,   66,   11,   66,   66,   66,   15,   66,   19,
- /*   730 */    20,   19,   20,   66,   66,   11,   66,   27,   28,   15,
- /*   740 */    28,   66,   66,   19,   20,   66,   66,   66,   66,   66,
- /*   750 */    66,   66,   28,   66,   66,   66,   66,   66,   66,   66,
- /*   760 */    66,   66,   66,   66,   66,   66,   66,   66,   66,   33,
- /*   770 */    33,   33,   33,   33,   33,   33,   33,   33,   33,   33,
- /*   780 */    33,   33,   33,   33,   33,   33,
+ /*     0 */    52,   53,   61,   41,    4,    5,    6,   60,   61,    9,
+ /*    10 */    10,   11,   64,   65,   14,   15,   16,    9,   18,    7,
+ /*    20 */    20,   21,   60,   61,    9,   25,   26,   27,   28,   29,
+ /*    30 */    29,   31,    4,    5,    6,   20,   21,    9,   10,   11,
+ /*    40 */    55,    9,   14,   15,   16,   33,   18,    0,   20,   21,
+ /*    50 */    60,   61,   55,   25,   26,   27,   28,   29,    0,   31,
+ /*    60 */    63,   11,    4,    5,   32,   18,   16,    9,   10,   11,
+ /*    70 */    20,   21,   14,   15,   16,   55,   18,   61,   20,   21,
+ /*    80 */    61,   62,   52,   25,   26,   27,   28,   29,    0,   31,
+ /*    90 */    35,   36,   55,    5,   64,   65,    5,    9,   10,   11,
+ /*   100 */    63,   66,   14,   15,   16,   60,   61,    7,   20,   21,
+ /*   110 */    22,   60,   61,   25,   26,   27,   28,   29,   59,   31,
+ /*   120 */     4,    5,   60,   61,   59,    9,   10,   11,   60,   61,
+ /*   130 */    14,   15,   16,   33,   18,    0,   20,   21,   55,   60,
+ /*   140 */    61,   25,   26,   27,   28,   29,   63,   31,    4,    5,
+ /*   150 */    60,   61,   35,    9,   10,   11,   49,   50,   14,   15,
+ /*   160 */    16,    0,   18,   12,   20,   21,   35,   36,    8,   25,
+ /*   170 */    26,   27,   28,   29,    6,   31,    5,   49,   50,   18,
+ /*   180 */     9,   10,   11,   35,   36,   14,   15,   16,   49,   50,
+ /*   190 */     0,   20,   21,   22,   35,   36,   25,   26,   27,   28,
+ /*   200 */    29,    4,   31,    5,    7,   35,   36,    9,   10,   11,
+ /*   210 */     8,    7,   14,   15,   16,    0,   18,    4,   20,   21,
+ /*   220 */    21,   12,   13,   25,   26,   27,   28,   29,   29,   31,
+ /*   230 */     5,    0,   19,   18,    9,   10,   11,   33,   12,   14,
+ /*   240 */    15,   16,   13,   18,    7,   20,   21,   12,   13,   18,
+ /*   250 */    25,   26,   27,   28,   29,    4,   31,    6,    4,    7,
+ /*   260 */     9,   10,   11,   29,    0,    4,   15,   16,    7,   18,
+ /*   270 */    33,   20,   21,   19,   12,    8,   25,   26,   27,   28,
+ /*   280 */    29,    4,   31,    5,    7,   33,   12,    9,   10,   11,
+ /*   290 */     9,   10,   14,   15,   16,    6,   11,   29,   20,   21,
+ /*   300 */     8,   20,   21,   25,   26,   27,   28,   29,    8,   31,
+ /*   310 */    29,    8,   28,    9,   10,   11,   12,   13,   11,   15,
+ /*   320 */    16,   28,   28,   16,   20,   21,   28,   20,   21,   25,
+ /*   330 */    26,   27,   28,   29,   28,   31,   29,   28,   10,    9,
+ /*   340 */    10,   11,    9,   19,   11,   15,   16,   10,   18,   16,
+ /*   350 */    20,   21,   12,   20,   21,   25,   26,   27,   28,   29,
+ /*   360 */    67,   31,   29,   67,   67,    9,   10,   11,   67,   67,
+ /*   370 */    11,   15,   16,   67,   67,   16,   20,   21,   67,   20,
+ /*   380 */    21,   25,   26,   27,   28,   29,   34,   31,   29,   37,
+ /*   390 */     4,    4,   40,   67,   42,   43,   44,   37,   67,   67,
+ /*   400 */    40,   67,   67,   43,   44,   67,   54,   67,   67,   57,
+ /*   410 */    58,   59,   60,   61,   67,   67,   34,   67,   67,   37,
+ /*   420 */    60,   61,   40,   67,   42,   43,   44,   37,   67,   34,
+ /*   430 */    40,   67,   37,   43,   44,   40,   54,   42,   43,   44,
+ /*   440 */    58,   59,   60,   61,   67,   67,   67,   67,   67,   54,
+ /*   450 */    60,   61,   67,   67,   59,   60,   61,   34,   67,   67,
+ /*   460 */    37,   67,   67,   40,   67,   42,   43,   44,   37,   67,
+ /*   470 */    34,   40,   67,   37,   43,   44,   40,   54,   42,   43,
+ /*   480 */    44,   51,   59,   60,   61,   55,   67,   67,   67,   67,
+ /*   490 */    54,   60,   61,   63,   67,   59,   60,   61,   34,   67,
+ /*   500 */    67,   37,   67,   67,   40,   67,   42,   43,   44,   37,
+ /*   510 */    67,   34,   40,   67,   37,   43,   44,   40,   54,   42,
+ /*   520 */    43,   44,   67,   59,   60,   61,   67,   67,   67,   67,
+ /*   530 */    67,   54,   60,   61,   67,   67,   59,   60,   61,   34,
+ /*   540 */    67,   67,   37,   67,   67,   40,   67,   42,   43,   44,
+ /*   550 */    37,   67,   34,   40,   67,   37,   43,   44,   40,   54,
+ /*   560 */    42,   43,   44,   67,   59,   60,   61,   67,   67,   67,
+ /*   570 */    67,   67,   54,   60,   61,   67,   67,   59,   60,   61,
+ /*   580 */    34,   67,    9,   37,    9,   67,   40,   67,   42,   43,
+ /*   590 */    44,   67,   67,   20,   21,   20,   21,   67,   67,   67,
+ /*   600 */    54,   28,   29,   28,   29,   59,   60,   61,   18,   67,
+ /*   610 */    20,   21,   67,   67,   67,   25,   26,   27,   28,   29,
+ /*   620 */    67,   31,   67,   67,   18,   67,   20,   21,   67,   67,
+ /*   630 */    67,   25,   26,   27,   28,   29,   67,   31,   37,   67,
+ /*   640 */    67,   40,   67,   67,   43,   44,   67,    9,   47,   48,
+ /*   650 */    67,   67,   67,   67,   67,   67,   67,   56,   20,   21,
+ /*   660 */    67,   60,   61,   25,   26,   27,   67,   29,   67,   31,
+ /*   670 */    20,   21,    9,   67,   67,   25,   26,   27,   28,   29,
+ /*   680 */    67,   31,   37,   20,   21,   40,   41,   67,   67,   67,
+ /*   690 */    67,   46,   29,   67,   67,   37,   67,   37,   40,   67,
+ /*   700 */    40,   43,   44,   43,   44,   60,   61,   62,   37,   67,
+ /*   710 */    67,   40,   41,   67,    8,   67,   67,   11,   60,   61,
+ /*   720 */    60,   61,   16,   67,   67,   67,   20,   21,   67,   11,
+ /*   730 */     9,   60,   61,   62,   16,   29,   67,    9,   20,   21,
+ /*   740 */    67,   20,   21,   67,   67,   67,   67,   29,   20,   21,
+ /*   750 */    29,   67,   67,   67,   67,   67,   67,   29,   67,   67,
+ /*   760 */    67,   67,   67,   67,   67,   67,   67,   67,   67,   67,
+ /*   770 */    67,   67,   34,   34,   34,   34,   34,   34,   34,   34,
+ /*   780 */    34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+ /*   790 */    34,   34,
 };
-#define YY_SHIFT_COUNT    (121)
+#define YY_SHIFT_COUNT    (124)
 #define YY_SHIFT_MIN      (0)
-#define YY_SHIFT_MAX      (724)
+#define YY_SHIFT_MAX      (728)
 static const unsigned short int yy_shift_ofst[] = {
- /*     0 */    85,  190,    0,   27,   56,  112,  139,  216,  216,  216,
- /*    10 */   242,  242,  293,  293,  293,  293,  293,  293,  573,  573,
- /*    20 */   590,  590,  573,  573,  590,  590,  267,  634,  164,  318,
- /*    30 */   318,  343,  343,  343,  343,  343,  343,  590,  590,  590,
- /*    40 */   647,  634,  647,   14,  374,   20,   14,  712,  336,  678,
- /*    50 */   690,  710,  245,   49,   69,   49,   49,   49,   49,   49,
- /*    60 */    49,    6,    9,    6,    9,    6,    9,    6,    6,  724,
- /*    70 */   295,  295,   82,   82,  100,   93,    6,   42,  130,  236,
- /*    80 */   148,  228,  284,  150,  288,  277,  253,  307,  292,  370,
- /*    90 */   372,  312,  302,  135,  129,  177,  156,  193,  186,  200,
- /*   100 */   206,  196,  229,  220,  226,  227,  250,  222,  255,  266,
- /*   110 */   273,  297,  299,  304,  309,  313,  329,  331,  332,  310,
- /*   120 */   345,  355,
+ /*     0 */    88,  171,    0,   28,   58,  116,  144,  198,  198,  198,
+ /*    10 */   225,  225,  278,  278,  278,  278,  278,  278,  590,  590,
+ /*    20 */   606,  606,  590,  590,  606,  606,  304,  638,  251,  330,
+ /*    30 */   330,  356,  356,  356,  356,  356,  356,  606,  606,  606,
+ /*    40 */   650,  638,  650,   32,  333,  663,   32,  706,  307,  359,
+ /*    50 */   573,  575,  281,  721,  728,  721,  721,  721,  721,  721,
+ /*    60 */   721,    1,    8,    1,    8,    1,    8,    1,    1,  718,
+ /*    70 */    50,   50,   15,   15,  199,   91,   91,    1,   12,   47,
+ /*    80 */   209,  100,  161,  215,  204,  231,  235,  237,  213,  197,
+ /*    90 */   261,  277,  254,  252,  135,  151,  160,  168,  190,  226,
+ /*   100 */   202,  229,  234,  264,  262,  267,  274,  289,  285,  292,
+ /*   110 */   268,  300,  303,  284,  293,  294,  298,  306,  309,  328,
+ /*   120 */   337,  324,  340,  386,  387,
 };
-#define YY_REDUCE_COUNT (76)
-#define YY_REDUCE_MIN   (-57)
-#define YY_REDUCE_MAX   (652)
+#define YY_REDUCE_COUNT (77)
+#define YY_REDUCE_MIN   (-59)
+#define YY_REDUCE_MAX   (671)
 static const short yy_reduce_ofst[] = {
- /*     0 */   339,  368,  381,  410,  381,  410,  410,  381,  381,  381,
- /*    10 */   410,  410,  423,  452,  465,  494,  507,  536,  381,  381,
- /*    20 */   410,  410,  381,  381,  410,  410,  591,  596,  376,  376,
- /*    30 */   376,  418,  460,  502,  545,  642,  644,  376,  376,  376,
- /*    40 */   376,  652,  376,  -51,  221,  -38,   -1,  -46,  -19,   10,
- /*    50 */    33,   48,   59,   65,   73,   86,   59,   59,   92,  101,
- /*    60 */   117,  137,  138,  162,  154,  172,  174,  178,  203,  -47,
- /*    70 */     5,  -47,  -57,   19,   22,   45,   80,
+ /*     0 */   352,  382,  395,  423,  395,  423,  423,  395,  395,  395,
+ /*    10 */   423,  423,  436,  464,  477,  505,  518,  546,  395,  395,
+ /*    20 */   423,  423,  395,  395,  423,  423,  601,  645,  360,  360,
+ /*    30 */   360,  390,  431,  472,  513,  658,  660,  360,  360,  360,
+ /*    40 */   360,  671,  360,  -52,  430,  -38,   30,   -3,   37,   83,
+ /*    50 */   -53,  -10,   45,   51,   19,   62,   45,   45,   68,   79,
+ /*    60 */    90,   55,  107,  131,  128,  148,  139,  159,  170,  -15,
+ /*    70 */    20,  -15,  -59,   16,   35,   59,   65,  117,
 };
 static const YYACTIONTYPE yy_default[] = {
- /*     0 */   288,  288,  288,  288,  288,  294,  294,  301,  302,  300,
- /*    10 */   303,  305,  288,  288,  288,  288,  288,  288,  326,  328,
- /*    20 */   329,  327,  295,  296,  298,  297,  288,  288,  288,  305,
- /*    30 */   306,  288,  288,  288,  288,  288,  288,  329,  327,  298,
- /*    40 */   308,  288,  307,  361,  288,  288,  360,  288,  288,  288,
- /*    50 */   288,  288,  288,  288,  288,  288,  348,  344,  288,  288,
- /*    60 */   288,  315,  288,  315,  288,  315,  288,  315,  315,  288,
- /*    70 */   288,  288,  288,  288,  288,  288,  314,  288,  288,  288,
- /*    80 */   288,  288,  288,  288,  288,  288,  288,  288,  380,  379,
- /*    90 */   288,  288,  288,  288,  288,  288,  288,  288,  288,  288,
- /*   100 */   288,  288,  288,  288,  288,  288,  288,  288,  385,  288,
- /*   110 */   288,  288,  288,  288,  288,  288,  380,  379,  288,  288,
- /*   120 */   304,  299,
+ /*     0 */   293,  293,  293,  293,  293,  299,  299,  306,  307,  305,
+ /*    10 */   308,  310,  293,  293,  293,  293,  293,  293,  331,  333,
+ /*    20 */   334,  332,  300,  301,  303,  302,  293,  293,  293,  310,
+ /*    30 */   311,  293,  293,  293,  293,  293,  293,  334,  332,  303,
+ /*    40 */   313,  293,  312,  367,  293,  293,  366,  293,  293,  293,
+ /*    50 */   293,  293,  293,  293,  293,  293,  353,  349,  293,  293,
+ /*    60 */   293,  320,  293,  320,  293,  320,  293,  320,  320,  293,
+ /*    70 */   293,  293,  293,  293,  293,  293,  293,  319,  293,  293,
+ /*    80 */   293,  293,  293,  293,  293,  293,  293,  293,  293,  386,
+ /*    90 */   385,  293,  293,  293,  293,  293,  293,  293,  293,  293,
+ /*   100 */   293,  293,  293,  293,  293,  293,  293,  293,  293,  293,
+ /*   110 */   293,  391,  293,  293,  293,  293,  293,  293,  293,  386,
+ /*   120 */   385,  293,  293,  309,  304,
 };
 /********** End of lemon-generated parsing tables *****************************/
 
@@ -532,6 +534,7 @@ static const YYCODETYPE yyFallback[] = {
     0,  /*         LP => nothing */
     0,  /*         LB => nothing */
     0,  /*       LSQB => nothing */
+    0,  /*  ISMISSING => nothing */
     0,  /*      TILDE => nothing */
     0,  /*      MINUS => nothing */
     0,  /*        AND => nothing */
@@ -653,58 +656,59 @@ static const char *const yyTokenName[] = {
   /*   11 */ "LP",
   /*   12 */ "LB",
   /*   13 */ "LSQB",
-  /*   14 */ "TILDE",
-  /*   15 */ "MINUS",
-  /*   16 */ "AND",
-  /*   17 */ "ARROW",
-  /*   18 */ "COLON",
-  /*   19 */ "NUMBER",
-  /*   20 */ "SIZE",
-  /*   21 */ "STAR",
-  /*   22 */ "TAGLIST",
-  /*   23 */ "TERMLIST",
-  /*   24 */ "PREFIX",
-  /*   25 */ "SUFFIX",
-  /*   26 */ "CONTAINS",
-  /*   27 */ "PERCENT",
-  /*   28 */ "ATTRIBUTE",
-  /*   29 */ "VERBATIM",
-  /*   30 */ "WILDCARD",
-  /*   31 */ "AS_T",
-  /*   32 */ "SEMICOLON",
-  /*   33 */ "expr",
-  /*   34 */ "attribute",
-  /*   35 */ "attribute_list",
-  /*   36 */ "affix",
-  /*   37 */ "suffix",
-  /*   38 */ "contains",
-  /*   39 */ "verbatim",
-  /*   40 */ "termlist",
-  /*   41 */ "union",
-  /*   42 */ "text_union",
-  /*   43 */ "text_expr",
-  /*   44 */ "fuzzy",
-  /*   45 */ "tag_list",
-  /*   46 */ "geo_filter",
-  /*   47 */ "geometry_query",
-  /*   48 */ "vector_query",
-  /*   49 */ "vector_command",
-  /*   50 */ "vector_range_command",
-  /*   51 */ "vector_attribute",
-  /*   52 */ "vector_attribute_list",
-  /*   53 */ "modifierlist",
-  /*   54 */ "num",
-  /*   55 */ "numeric_range",
-  /*   56 */ "query",
-  /*   57 */ "star",
-  /*   58 */ "modifier",
-  /*   59 */ "param_term",
-  /*   60 */ "term",
-  /*   61 */ "param_term_case",
-  /*   62 */ "param_num",
-  /*   63 */ "vector_score_field",
-  /*   64 */ "as",
-  /*   65 */ "param_size",
+  /*   14 */ "ISMISSING",
+  /*   15 */ "TILDE",
+  /*   16 */ "MINUS",
+  /*   17 */ "AND",
+  /*   18 */ "ARROW",
+  /*   19 */ "COLON",
+  /*   20 */ "NUMBER",
+  /*   21 */ "SIZE",
+  /*   22 */ "STAR",
+  /*   23 */ "TAGLIST",
+  /*   24 */ "TERMLIST",
+  /*   25 */ "PREFIX",
+  /*   26 */ "SUFFIX",
+  /*   27 */ "CONTAINS",
+  /*   28 */ "PERCENT",
+  /*   29 */ "ATTRIBUTE",
+  /*   30 */ "VERBATIM",
+  /*   31 */ "WILDCARD",
+  /*   32 */ "AS_T",
+  /*   33 */ "SEMICOLON",
+  /*   34 */ "expr",
+  /*   35 */ "attribute",
+  /*   36 */ "attribute_list",
+  /*   37 */ "affix",
+  /*   38 */ "suffix",
+  /*   39 */ "contains",
+  /*   40 */ "verbatim",
+  /*   41 */ "termlist",
+  /*   42 */ "union",
+  /*   43 */ "text_union",
+  /*   44 */ "text_expr",
+  /*   45 */ "fuzzy",
+  /*   46 */ "tag_list",
+  /*   47 */ "geo_filter",
+  /*   48 */ "geometry_query",
+  /*   49 */ "vector_query",
+  /*   50 */ "vector_command",
+  /*   51 */ "vector_range_command",
+  /*   52 */ "vector_attribute",
+  /*   53 */ "vector_attribute_list",
+  /*   54 */ "modifierlist",
+  /*   55 */ "num",
+  /*   56 */ "numeric_range",
+  /*   57 */ "query",
+  /*   58 */ "star",
+  /*   59 */ "modifier",
+  /*   60 */ "param_term",
+  /*   61 */ "term",
+  /*   62 */ "param_term_case",
+  /*   63 */ "param_num",
+  /*   64 */ "vector_score_field",
+  /*   65 */ "as",
+  /*   66 */ "param_size",
 };
 #endif /* defined(YYCOVERAGE) || !defined(NDEBUG) */
 
@@ -770,48 +774,49 @@ static const char *const yyRuleName[] = {
  /*  55 */ "tag_list ::= tag_list OR affix",
  /*  56 */ "tag_list ::= tag_list OR verbatim",
  /*  57 */ "tag_list ::= tag_list OR termlist",
- /*  58 */ "expr ::= modifier COLON numeric_range",
- /*  59 */ "numeric_range ::= LSQB param_num param_num RSQB",
- /*  60 */ "expr ::= modifier COLON geo_filter",
- /*  61 */ "geo_filter ::= LSQB param_num param_num param_num param_term RSQB",
- /*  62 */ "expr ::= modifier COLON geometry_query",
- /*  63 */ "geometry_query ::= LSQB TERM ATTRIBUTE RSQB",
- /*  64 */ "query ::= expr ARROW LSQB vector_query RSQB",
- /*  65 */ "query ::= text_expr ARROW LSQB vector_query RSQB",
- /*  66 */ "query ::= star ARROW LSQB vector_query RSQB",
- /*  67 */ "vector_query ::= vector_command vector_attribute_list vector_score_field",
- /*  68 */ "vector_query ::= vector_command vector_score_field",
- /*  69 */ "vector_query ::= vector_command vector_attribute_list",
- /*  70 */ "vector_query ::= vector_command",
- /*  71 */ "vector_score_field ::= as param_term_case",
- /*  72 */ "query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
- /*  73 */ "query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
- /*  74 */ "query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
- /*  75 */ "vector_command ::= TERM param_size modifier ATTRIBUTE",
- /*  76 */ "vector_attribute ::= TERM param_term",
- /*  77 */ "vector_attribute_list ::= vector_attribute_list vector_attribute",
- /*  78 */ "vector_attribute_list ::= vector_attribute",
- /*  79 */ "expr ::= modifier COLON LSQB vector_range_command RSQB",
- /*  80 */ "vector_range_command ::= TERM param_num ATTRIBUTE",
- /*  81 */ "num ::= SIZE",
- /*  82 */ "num ::= NUMBER",
- /*  83 */ "num ::= LP num",
- /*  84 */ "num ::= MINUS num",
- /*  85 */ "term ::= TERM",
- /*  86 */ "term ::= NUMBER",
- /*  87 */ "term ::= SIZE",
- /*  88 */ "param_term ::= term",
- /*  89 */ "param_term ::= ATTRIBUTE",
- /*  90 */ "param_term_case ::= term",
- /*  91 */ "param_term_case ::= ATTRIBUTE",
- /*  92 */ "param_size ::= SIZE",
- /*  93 */ "param_size ::= ATTRIBUTE",
- /*  94 */ "param_num ::= ATTRIBUTE",
- /*  95 */ "param_num ::= num",
- /*  96 */ "param_num ::= LP ATTRIBUTE",
- /*  97 */ "star ::= STAR",
- /*  98 */ "star ::= LP star RP",
- /*  99 */ "as ::= AS_T",
+ /*  58 */ "expr ::= ISMISSING LP modifier RP",
+ /*  59 */ "expr ::= modifier COLON numeric_range",
+ /*  60 */ "numeric_range ::= LSQB param_num param_num RSQB",
+ /*  61 */ "expr ::= modifier COLON geo_filter",
+ /*  62 */ "geo_filter ::= LSQB param_num param_num param_num param_term RSQB",
+ /*  63 */ "expr ::= modifier COLON geometry_query",
+ /*  64 */ "geometry_query ::= LSQB TERM ATTRIBUTE RSQB",
+ /*  65 */ "query ::= expr ARROW LSQB vector_query RSQB",
+ /*  66 */ "query ::= text_expr ARROW LSQB vector_query RSQB",
+ /*  67 */ "query ::= star ARROW LSQB vector_query RSQB",
+ /*  68 */ "vector_query ::= vector_command vector_attribute_list vector_score_field",
+ /*  69 */ "vector_query ::= vector_command vector_score_field",
+ /*  70 */ "vector_query ::= vector_command vector_attribute_list",
+ /*  71 */ "vector_query ::= vector_command",
+ /*  72 */ "vector_score_field ::= as param_term_case",
+ /*  73 */ "query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
+ /*  74 */ "query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
+ /*  75 */ "query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB",
+ /*  76 */ "vector_command ::= TERM param_size modifier ATTRIBUTE",
+ /*  77 */ "vector_attribute ::= TERM param_term",
+ /*  78 */ "vector_attribute_list ::= vector_attribute_list vector_attribute",
+ /*  79 */ "vector_attribute_list ::= vector_attribute",
+ /*  80 */ "expr ::= modifier COLON LSQB vector_range_command RSQB",
+ /*  81 */ "vector_range_command ::= TERM param_num ATTRIBUTE",
+ /*  82 */ "num ::= SIZE",
+ /*  83 */ "num ::= NUMBER",
+ /*  84 */ "num ::= LP num",
+ /*  85 */ "num ::= MINUS num",
+ /*  86 */ "term ::= TERM",
+ /*  87 */ "term ::= NUMBER",
+ /*  88 */ "term ::= SIZE",
+ /*  89 */ "param_term ::= term",
+ /*  90 */ "param_term ::= ATTRIBUTE",
+ /*  91 */ "param_term_case ::= term",
+ /*  92 */ "param_term_case ::= ATTRIBUTE",
+ /*  93 */ "param_size ::= SIZE",
+ /*  94 */ "param_size ::= ATTRIBUTE",
+ /*  95 */ "param_num ::= ATTRIBUTE",
+ /*  96 */ "param_num ::= num",
+ /*  97 */ "param_num ::= LP ATTRIBUTE",
+ /*  98 */ "star ::= STAR",
+ /*  99 */ "star ::= LP star RP",
+ /* 100 */ "as ::= AS_T",
 };
 #endif /* NDEBUG */
 
@@ -938,83 +943,83 @@ static void yy_destructor(
     */
 /********* Begin destructor definitions ***************************************/
       /* Default NON-TERMINAL Destructor */
-    case 51: /* vector_attribute */
-    case 54: /* num */
-    case 56: /* query */
-    case 57: /* star */
-    case 58: /* modifier */
-    case 59: /* param_term */
-    case 60: /* term */
-    case 61: /* param_term_case */
-    case 62: /* param_num */
-    case 63: /* vector_score_field */
-    case 64: /* as */
-    case 65: /* param_size */
+    case 52: /* vector_attribute */
+    case 55: /* num */
+    case 57: /* query */
+    case 58: /* star */
+    case 59: /* modifier */
+    case 60: /* param_term */
+    case 61: /* term */
+    case 62: /* param_term_case */
+    case 63: /* param_num */
+    case 64: /* vector_score_field */
+    case 65: /* as */
+    case 66: /* param_size */
 {
  
 }
       break;
-    case 33: /* expr */
-    case 36: /* affix */
-    case 37: /* suffix */
-    case 38: /* contains */
-    case 39: /* verbatim */
-    case 40: /* termlist */
-    case 41: /* union */
-    case 42: /* text_union */
-    case 43: /* text_expr */
-    case 44: /* fuzzy */
-    case 45: /* tag_list */
-    case 47: /* geometry_query */
-    case 48: /* vector_query */
-    case 49: /* vector_command */
-    case 50: /* vector_range_command */
-{
- QueryNode_Free((yypminor->yy119)); 
+    case 34: /* expr */
+    case 37: /* affix */
+    case 38: /* suffix */
+    case 39: /* contains */
+    case 40: /* verbatim */
+    case 41: /* termlist */
+    case 42: /* union */
+    case 43: /* text_union */
+    case 44: /* text_expr */
+    case 45: /* fuzzy */
+    case 46: /* tag_list */
+    case 48: /* geometry_query */
+    case 49: /* vector_query */
+    case 50: /* vector_command */
+    case 51: /* vector_range_command */
+{
+ QueryNode_Free((yypminor->yy13)); 
 }
       break;
-    case 34: /* attribute */
+    case 35: /* attribute */
 {
- rm_free((char*)(yypminor->yy43).value); 
+ rm_free((char*)(yypminor->yy35).value); 
 }
       break;
-    case 35: /* attribute_list */
+    case 36: /* attribute_list */
 {
- array_free_ex((yypminor->yy45), rm_free((char*)((QueryAttribute*)ptr )->value)); 
+ array_free_ex((yypminor->yy95), rm_free((char*)((QueryAttribute*)ptr )->value)); 
 }
       break;
-    case 46: /* geo_filter */
+    case 47: /* geo_filter */
 {
- QueryParam_Free((yypminor->yy62)); 
+ QueryParam_Free((yypminor->yy72)); 
 }
       break;
-    case 52: /* vector_attribute_list */
+    case 53: /* vector_attribute_list */
 {
 
-  array_free((yypminor->yy2).needResolve);
-  array_free_ex((yypminor->yy2).params, {
+  array_free((yypminor->yy4).needResolve);
+  array_free_ex((yypminor->yy4).params, {
     rm_free((char*)((VecSimRawParam*)ptr)->value);
     rm_free((char*)((VecSimRawParam*)ptr)->name);
   });
 
 }
       break;
-    case 53: /* modifierlist */
+    case 54: /* modifierlist */
 {
 
-    for (size_t i = 0; i < Vector_Size((yypminor->yy42)); i++) {
+    for (size_t i = 0; i < Vector_Size((yypminor->yy50)); i++) {
         char *s;
-        Vector_Get((yypminor->yy42), i, &s);
+        Vector_Get((yypminor->yy50), i, &s);
         rm_free(s);
     }
-    Vector_Free((yypminor->yy42));
+    Vector_Free((yypminor->yy50));
 
 }
       break;
-    case 55: /* numeric_range */
+    case 56: /* numeric_range */
 {
 
-  QueryParam_Free((yypminor->yy62));
+  QueryParam_Free((yypminor->yy72));
 
 }
       break;
@@ -1307,106 +1312,107 @@ static void yy_shift(
 /* For rule J, yyRuleInfoLhs[J] contains the symbol on the left-hand side
 ** of that rule */
 static const YYCODETYPE yyRuleInfoLhs[] = {
-    56,  /* (0) query ::= expr */
-    56,  /* (1) query ::= */
-    56,  /* (2) query ::= star */
-    33,  /* (3) expr ::= text_expr */
-    33,  /* (4) expr ::= expr expr */
-    33,  /* (5) expr ::= text_expr expr */
-    33,  /* (6) expr ::= expr text_expr */
-    43,  /* (7) text_expr ::= text_expr text_expr */
-    33,  /* (8) expr ::= union */
-    41,  /* (9) union ::= expr OR expr */
-    41,  /* (10) union ::= union OR expr */
-    41,  /* (11) union ::= text_expr OR expr */
-    41,  /* (12) union ::= expr OR text_expr */
-    43,  /* (13) text_expr ::= text_union */
-    42,  /* (14) text_union ::= text_expr OR text_expr */
-    42,  /* (15) text_union ::= text_union OR text_expr */
-    33,  /* (16) expr ::= modifier COLON text_expr */
-    33,  /* (17) expr ::= modifierlist COLON text_expr */
-    33,  /* (18) expr ::= LP expr RP */
-    43,  /* (19) text_expr ::= LP text_expr RP */
-    34,  /* (20) attribute ::= ATTRIBUTE COLON param_term */
-    35,  /* (21) attribute_list ::= attribute */
-    35,  /* (22) attribute_list ::= attribute_list SEMICOLON attribute */
-    35,  /* (23) attribute_list ::= attribute_list SEMICOLON */
-    35,  /* (24) attribute_list ::= */
-    33,  /* (25) expr ::= expr ARROW LB attribute_list RB */
-    43,  /* (26) text_expr ::= text_expr ARROW LB attribute_list RB */
-    43,  /* (27) text_expr ::= QUOTE termlist QUOTE */
-    43,  /* (28) text_expr ::= QUOTE term QUOTE */
-    43,  /* (29) text_expr ::= QUOTE ATTRIBUTE QUOTE */
-    43,  /* (30) text_expr ::= param_term */
-    43,  /* (31) text_expr ::= affix */
-    43,  /* (32) text_expr ::= verbatim */
-    40,  /* (33) termlist ::= param_term param_term */
-    40,  /* (34) termlist ::= termlist param_term */
-    33,  /* (35) expr ::= MINUS expr */
-    43,  /* (36) text_expr ::= MINUS text_expr */
-    33,  /* (37) expr ::= TILDE expr */
-    43,  /* (38) text_expr ::= TILDE text_expr */
-    36,  /* (39) affix ::= PREFIX */
-    36,  /* (40) affix ::= SUFFIX */
-    36,  /* (41) affix ::= CONTAINS */
-    39,  /* (42) verbatim ::= WILDCARD */
-    43,  /* (43) text_expr ::= PERCENT param_term PERCENT */
-    43,  /* (44) text_expr ::= PERCENT PERCENT param_term PERCENT PERCENT */
-    43,  /* (45) text_expr ::= PERCENT PERCENT PERCENT param_term PERCENT PERCENT PERCENT */
-    58,  /* (46) modifier ::= MODIFIER */
-    53,  /* (47) modifierlist ::= modifier OR term */
-    53,  /* (48) modifierlist ::= modifierlist OR term */
-    33,  /* (49) expr ::= modifier COLON LB tag_list RB */
-    45,  /* (50) tag_list ::= param_term_case */
-    45,  /* (51) tag_list ::= affix */
-    45,  /* (52) tag_list ::= verbatim */
-    45,  /* (53) tag_list ::= termlist */
-    45,  /* (54) tag_list ::= tag_list OR param_term_case */
-    45,  /* (55) tag_list ::= tag_list OR affix */
-    45,  /* (56) tag_list ::= tag_list OR verbatim */
-    45,  /* (57) tag_list ::= tag_list OR termlist */
-    33,  /* (58) expr ::= modifier COLON numeric_range */
-    55,  /* (59) numeric_range ::= LSQB param_num param_num RSQB */
-    33,  /* (60) expr ::= modifier COLON geo_filter */
-    46,  /* (61) geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
-    33,  /* (62) expr ::= modifier COLON geometry_query */
-    47,  /* (63) geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
-    56,  /* (64) query ::= expr ARROW LSQB vector_query RSQB */
-    56,  /* (65) query ::= text_expr ARROW LSQB vector_query RSQB */
-    56,  /* (66) query ::= star ARROW LSQB vector_query RSQB */
-    48,  /* (67) vector_query ::= vector_command vector_attribute_list vector_score_field */
-    48,  /* (68) vector_query ::= vector_command vector_score_field */
-    48,  /* (69) vector_query ::= vector_command vector_attribute_list */
-    48,  /* (70) vector_query ::= vector_command */
-    63,  /* (71) vector_score_field ::= as param_term_case */
-    56,  /* (72) query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-    56,  /* (73) query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-    56,  /* (74) query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-    49,  /* (75) vector_command ::= TERM param_size modifier ATTRIBUTE */
-    51,  /* (76) vector_attribute ::= TERM param_term */
-    52,  /* (77) vector_attribute_list ::= vector_attribute_list vector_attribute */
-    52,  /* (78) vector_attribute_list ::= vector_attribute */
-    33,  /* (79) expr ::= modifier COLON LSQB vector_range_command RSQB */
-    50,  /* (80) vector_range_command ::= TERM param_num ATTRIBUTE */
-    54,  /* (81) num ::= SIZE */
-    54,  /* (82) num ::= NUMBER */
-    54,  /* (83) num ::= LP num */
-    54,  /* (84) num ::= MINUS num */
-    60,  /* (85) term ::= TERM */
-    60,  /* (86) term ::= NUMBER */
-    60,  /* (87) term ::= SIZE */
-    59,  /* (88) param_term ::= term */
-    59,  /* (89) param_term ::= ATTRIBUTE */
-    61,  /* (90) param_term_case ::= term */
-    61,  /* (91) param_term_case ::= ATTRIBUTE */
-    65,  /* (92) param_size ::= SIZE */
-    65,  /* (93) param_size ::= ATTRIBUTE */
-    62,  /* (94) param_num ::= ATTRIBUTE */
-    62,  /* (95) param_num ::= num */
-    62,  /* (96) param_num ::= LP ATTRIBUTE */
-    57,  /* (97) star ::= STAR */
-    57,  /* (98) star ::= LP star RP */
-    64,  /* (99) as ::= AS_T */
+    57,  /* (0) query ::= expr */
+    57,  /* (1) query ::= */
+    57,  /* (2) query ::= star */
+    34,  /* (3) expr ::= text_expr */
+    34,  /* (4) expr ::= expr expr */
+    34,  /* (5) expr ::= text_expr expr */
+    34,  /* (6) expr ::= expr text_expr */
+    44,  /* (7) text_expr ::= text_expr text_expr */
+    34,  /* (8) expr ::= union */
+    42,  /* (9) union ::= expr OR expr */
+    42,  /* (10) union ::= union OR expr */
+    42,  /* (11) union ::= text_expr OR expr */
+    42,  /* (12) union ::= expr OR text_expr */
+    44,  /* (13) text_expr ::= text_union */
+    43,  /* (14) text_union ::= text_expr OR text_expr */
+    43,  /* (15) text_union ::= text_union OR text_expr */
+    34,  /* (16) expr ::= modifier COLON text_expr */
+    34,  /* (17) expr ::= modifierlist COLON text_expr */
+    34,  /* (18) expr ::= LP expr RP */
+    44,  /* (19) text_expr ::= LP text_expr RP */
+    35,  /* (20) attribute ::= ATTRIBUTE COLON param_term */
+    36,  /* (21) attribute_list ::= attribute */
+    36,  /* (22) attribute_list ::= attribute_list SEMICOLON attribute */
+    36,  /* (23) attribute_list ::= attribute_list SEMICOLON */
+    36,  /* (24) attribute_list ::= */
+    34,  /* (25) expr ::= expr ARROW LB attribute_list RB */
+    44,  /* (26) text_expr ::= text_expr ARROW LB attribute_list RB */
+    44,  /* (27) text_expr ::= QUOTE termlist QUOTE */
+    44,  /* (28) text_expr ::= QUOTE term QUOTE */
+    44,  /* (29) text_expr ::= QUOTE ATTRIBUTE QUOTE */
+    44,  /* (30) text_expr ::= param_term */
+    44,  /* (31) text_expr ::= affix */
+    44,  /* (32) text_expr ::= verbatim */
+    41,  /* (33) termlist ::= param_term param_term */
+    41,  /* (34) termlist ::= termlist param_term */
+    34,  /* (35) expr ::= MINUS expr */
+    44,  /* (36) text_expr ::= MINUS text_expr */
+    34,  /* (37) expr ::= TILDE expr */
+    44,  /* (38) text_expr ::= TILDE text_expr */
+    37,  /* (39) affix ::= PREFIX */
+    37,  /* (40) affix ::= SUFFIX */
+    37,  /* (41) affix ::= CONTAINS */
+    40,  /* (42) verbatim ::= WILDCARD */
+    44,  /* (43) text_expr ::= PERCENT param_term PERCENT */
+    44,  /* (44) text_expr ::= PERCENT PERCENT param_term PERCENT PERCENT */
+    44,  /* (45) text_expr ::= PERCENT PERCENT PERCENT param_term PERCENT PERCENT PERCENT */
+    59,  /* (46) modifier ::= MODIFIER */
+    54,  /* (47) modifierlist ::= modifier OR term */
+    54,  /* (48) modifierlist ::= modifierlist OR term */
+    34,  /* (49) expr ::= modifier COLON LB tag_list RB */
+    46,  /* (50) tag_list ::= param_term_case */
+    46,  /* (51) tag_list ::= affix */
+    46,  /* (52) tag_list ::= verbatim */
+    46,  /* (53) tag_list ::= termlist */
+    46,  /* (54) tag_list ::= tag_list OR param_term_case */
+    46,  /* (55) tag_list ::= tag_list OR affix */
+    46,  /* (56) tag_list ::= tag_list OR verbatim */
+    46,  /* (57) tag_list ::= tag_list OR termlist */
+    34,  /* (58) expr ::= ISMISSING LP modifier RP */
+    34,  /* (59) expr ::= modifier COLON numeric_range */
+    56,  /* (60) numeric_range ::= LSQB param_num param_num RSQB */
+    34,  /* (61) expr ::= modifier COLON geo_filter */
+    47,  /* (62) geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
+    34,  /* (63) expr ::= modifier COLON geometry_query */
+    48,  /* (64) geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
+    57,  /* (65) query ::= expr ARROW LSQB vector_query RSQB */
+    57,  /* (66) query ::= text_expr ARROW LSQB vector_query RSQB */
+    57,  /* (67) query ::= star ARROW LSQB vector_query RSQB */
+    49,  /* (68) vector_query ::= vector_command vector_attribute_list vector_score_field */
+    49,  /* (69) vector_query ::= vector_command vector_score_field */
+    49,  /* (70) vector_query ::= vector_command vector_attribute_list */
+    49,  /* (71) vector_query ::= vector_command */
+    64,  /* (72) vector_score_field ::= as param_term_case */
+    57,  /* (73) query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+    57,  /* (74) query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+    57,  /* (75) query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+    50,  /* (76) vector_command ::= TERM param_size modifier ATTRIBUTE */
+    52,  /* (77) vector_attribute ::= TERM param_term */
+    53,  /* (78) vector_attribute_list ::= vector_attribute_list vector_attribute */
+    53,  /* (79) vector_attribute_list ::= vector_attribute */
+    34,  /* (80) expr ::= modifier COLON LSQB vector_range_command RSQB */
+    51,  /* (81) vector_range_command ::= TERM param_num ATTRIBUTE */
+    55,  /* (82) num ::= SIZE */
+    55,  /* (83) num ::= NUMBER */
+    55,  /* (84) num ::= LP num */
+    55,  /* (85) num ::= MINUS num */
+    61,  /* (86) term ::= TERM */
+    61,  /* (87) term ::= NUMBER */
+    61,  /* (88) term ::= SIZE */
+    60,  /* (89) param_term ::= term */
+    60,  /* (90) param_term ::= ATTRIBUTE */
+    62,  /* (91) param_term_case ::= term */
+    62,  /* (92) param_term_case ::= ATTRIBUTE */
+    66,  /* (93) param_size ::= SIZE */
+    66,  /* (94) param_size ::= ATTRIBUTE */
+    63,  /* (95) param_num ::= ATTRIBUTE */
+    63,  /* (96) param_num ::= num */
+    63,  /* (97) param_num ::= LP ATTRIBUTE */
+    58,  /* (98) star ::= STAR */
+    58,  /* (99) star ::= LP star RP */
+    65,  /* (100) as ::= AS_T */
 };
 
 /* For rule J, yyRuleInfoNRhs[J] contains the negative of the number
@@ -1470,48 +1476,49 @@ static const signed char yyRuleInfoNRhs[] = {
    -3,  /* (55) tag_list ::= tag_list OR affix */
    -3,  /* (56) tag_list ::= tag_list OR verbatim */
    -3,  /* (57) tag_list ::= tag_list OR termlist */
-   -3,  /* (58) expr ::= modifier COLON numeric_range */
-   -4,  /* (59) numeric_range ::= LSQB param_num param_num RSQB */
-   -3,  /* (60) expr ::= modifier COLON geo_filter */
-   -6,  /* (61) geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
-   -3,  /* (62) expr ::= modifier COLON geometry_query */
-   -4,  /* (63) geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
-   -5,  /* (64) query ::= expr ARROW LSQB vector_query RSQB */
-   -5,  /* (65) query ::= text_expr ARROW LSQB vector_query RSQB */
-   -5,  /* (66) query ::= star ARROW LSQB vector_query RSQB */
-   -3,  /* (67) vector_query ::= vector_command vector_attribute_list vector_score_field */
-   -2,  /* (68) vector_query ::= vector_command vector_score_field */
-   -2,  /* (69) vector_query ::= vector_command vector_attribute_list */
-   -1,  /* (70) vector_query ::= vector_command */
-   -2,  /* (71) vector_score_field ::= as param_term_case */
-   -9,  /* (72) query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-   -9,  /* (73) query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-   -9,  /* (74) query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-   -4,  /* (75) vector_command ::= TERM param_size modifier ATTRIBUTE */
-   -2,  /* (76) vector_attribute ::= TERM param_term */
-   -2,  /* (77) vector_attribute_list ::= vector_attribute_list vector_attribute */
-   -1,  /* (78) vector_attribute_list ::= vector_attribute */
-   -5,  /* (79) expr ::= modifier COLON LSQB vector_range_command RSQB */
-   -3,  /* (80) vector_range_command ::= TERM param_num ATTRIBUTE */
-   -1,  /* (81) num ::= SIZE */
-   -1,  /* (82) num ::= NUMBER */
-   -2,  /* (83) num ::= LP num */
-   -2,  /* (84) num ::= MINUS num */
-   -1,  /* (85) term ::= TERM */
-   -1,  /* (86) term ::= NUMBER */
-   -1,  /* (87) term ::= SIZE */
-   -1,  /* (88) param_term ::= term */
-   -1,  /* (89) param_term ::= ATTRIBUTE */
-   -1,  /* (90) param_term_case ::= term */
-   -1,  /* (91) param_term_case ::= ATTRIBUTE */
-   -1,  /* (92) param_size ::= SIZE */
-   -1,  /* (93) param_size ::= ATTRIBUTE */
-   -1,  /* (94) param_num ::= ATTRIBUTE */
-   -1,  /* (95) param_num ::= num */
-   -2,  /* (96) param_num ::= LP ATTRIBUTE */
-   -1,  /* (97) star ::= STAR */
-   -3,  /* (98) star ::= LP star RP */
-   -1,  /* (99) as ::= AS_T */
+   -4,  /* (58) expr ::= ISMISSING LP modifier RP */
+   -3,  /* (59) expr ::= modifier COLON numeric_range */
+   -4,  /* (60) numeric_range ::= LSQB param_num param_num RSQB */
+   -3,  /* (61) expr ::= modifier COLON geo_filter */
+   -6,  /* (62) geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
+   -3,  /* (63) expr ::= modifier COLON geometry_query */
+   -4,  /* (64) geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
+   -5,  /* (65) query ::= expr ARROW LSQB vector_query RSQB */
+   -5,  /* (66) query ::= text_expr ARROW LSQB vector_query RSQB */
+   -5,  /* (67) query ::= star ARROW LSQB vector_query RSQB */
+   -3,  /* (68) vector_query ::= vector_command vector_attribute_list vector_score_field */
+   -2,  /* (69) vector_query ::= vector_command vector_score_field */
+   -2,  /* (70) vector_query ::= vector_command vector_attribute_list */
+   -1,  /* (71) vector_query ::= vector_command */
+   -2,  /* (72) vector_score_field ::= as param_term_case */
+   -9,  /* (73) query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+   -9,  /* (74) query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+   -9,  /* (75) query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+   -4,  /* (76) vector_command ::= TERM param_size modifier ATTRIBUTE */
+   -2,  /* (77) vector_attribute ::= TERM param_term */
+   -2,  /* (78) vector_attribute_list ::= vector_attribute_list vector_attribute */
+   -1,  /* (79) vector_attribute_list ::= vector_attribute */
+   -5,  /* (80) expr ::= modifier COLON LSQB vector_range_command RSQB */
+   -3,  /* (81) vector_range_command ::= TERM param_num ATTRIBUTE */
+   -1,  /* (82) num ::= SIZE */
+   -1,  /* (83) num ::= NUMBER */
+   -2,  /* (84) num ::= LP num */
+   -2,  /* (85) num ::= MINUS num */
+   -1,  /* (86) term ::= TERM */
+   -1,  /* (87) term ::= NUMBER */
+   -1,  /* (88) term ::= SIZE */
+   -1,  /* (89) param_term ::= term */
+   -1,  /* (90) param_term ::= ATTRIBUTE */
+   -1,  /* (91) param_term_case ::= term */
+   -1,  /* (92) param_term_case ::= ATTRIBUTE */
+   -1,  /* (93) param_size ::= SIZE */
+   -1,  /* (94) param_size ::= ATTRIBUTE */
+   -1,  /* (95) param_num ::= ATTRIBUTE */
+   -1,  /* (96) param_num ::= num */
+   -2,  /* (97) param_num ::= LP ATTRIBUTE */
+   -1,  /* (98) star ::= STAR */
+   -3,  /* (99) star ::= LP star RP */
+   -1,  /* (100) as ::= AS_T */
 };
 
 static void yy_accept(yyParser*);  /* Forward Declaration */
@@ -1556,7 +1563,7 @@ static YYACTIONTYPE yy_reduce(
       case 0: /* query ::= expr */
 {
   setup_trace(ctx);
-  ctx->root = yymsp[0].minor.yy119;
+  ctx->root = yymsp[0].minor.yy13;
 }
         break;
       case 1: /* query ::= */
@@ -1565,7 +1572,7 @@ static YYACTIONTYPE yy_reduce(
 }
         break;
       case 2: /* query ::= star */
-{  yy_destructor(yypParser,57,&yymsp[0].minor);
+{  yy_destructor(yypParser,58,&yymsp[0].minor);
 {
   setup_trace(ctx);
   ctx->root = NewWildcardNode();
@@ -1575,119 +1582,119 @@ static YYACTIONTYPE yy_reduce(
       case 3: /* expr ::= text_expr */
       case 8: /* expr ::= union */ yytestcase(yyruleno==8);
       case 13: /* text_expr ::= text_union */ yytestcase(yyruleno==13);
-      case 70: /* vector_query ::= vector_command */ yytestcase(yyruleno==70);
+      case 71: /* vector_query ::= vector_command */ yytestcase(yyruleno==71);
 {
-  yylhsminor.yy119 = yymsp[0].minor.yy119;
+  yylhsminor.yy13 = yymsp[0].minor.yy13;
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 4: /* expr ::= expr expr */
       case 5: /* expr ::= text_expr expr */ yytestcase(yyruleno==5);
       case 6: /* expr ::= expr text_expr */ yytestcase(yyruleno==6);
       case 7: /* text_expr ::= text_expr text_expr */ yytestcase(yyruleno==7);
 {
-    int rv = one_not_null(yymsp[-1].minor.yy119, yymsp[0].minor.yy119, (void**)&yylhsminor.yy119);
+    int rv = one_not_null(yymsp[-1].minor.yy13, yymsp[0].minor.yy13, (void**)&yylhsminor.yy13);
     if (rv == NODENN_BOTH_INVALID) {
-        yylhsminor.yy119 = NULL;
+        yylhsminor.yy13 = NULL;
     } else if (rv == NODENN_ONE_NULL) {
         // Nothing- `out` is already assigned
     } else {
-        if (yymsp[-1].minor.yy119 && yymsp[-1].minor.yy119->type == QN_PHRASE && yymsp[-1].minor.yy119->pn.exact == 0 &&
-            yymsp[-1].minor.yy119->opts.fieldMask == RS_FIELDMASK_ALL ) {
-            yylhsminor.yy119 = yymsp[-1].minor.yy119;
+        if (yymsp[-1].minor.yy13 && yymsp[-1].minor.yy13->type == QN_PHRASE && yymsp[-1].minor.yy13->pn.exact == 0 &&
+            yymsp[-1].minor.yy13->opts.fieldMask == RS_FIELDMASK_ALL ) {
+            yylhsminor.yy13 = yymsp[-1].minor.yy13;
         } else {
-            yylhsminor.yy119 = NewPhraseNode(0);
-            QueryNode_AddChild(yylhsminor.yy119, yymsp[-1].minor.yy119);
+            yylhsminor.yy13 = NewPhraseNode(0);
+            QueryNode_AddChild(yylhsminor.yy13, yymsp[-1].minor.yy13);
         }
-        QueryNode_AddChild(yylhsminor.yy119, yymsp[0].minor.yy119);
+        QueryNode_AddChild(yylhsminor.yy13, yymsp[0].minor.yy13);
     }
 }
-  yymsp[-1].minor.yy119 = yylhsminor.yy119;
+  yymsp[-1].minor.yy13 = yylhsminor.yy13;
         break;
       case 9: /* union ::= expr OR expr */
       case 11: /* union ::= text_expr OR expr */ yytestcase(yyruleno==11);
       case 12: /* union ::= expr OR text_expr */ yytestcase(yyruleno==12);
       case 14: /* text_union ::= text_expr OR text_expr */ yytestcase(yyruleno==14);
 {
-    int rv = one_not_null(yymsp[-2].minor.yy119, yymsp[0].minor.yy119, (void**)&yylhsminor.yy119);
+    int rv = one_not_null(yymsp[-2].minor.yy13, yymsp[0].minor.yy13, (void**)&yylhsminor.yy13);
     if (rv == NODENN_BOTH_INVALID) {
-        yylhsminor.yy119 = NULL;
+        yylhsminor.yy13 = NULL;
     } else if (rv == NODENN_ONE_NULL) {
         // Nothing- already assigned
     } else {
-        if (yymsp[-2].minor.yy119->type == QN_UNION && yymsp[-2].minor.yy119->opts.fieldMask == RS_FIELDMASK_ALL) {
-            yylhsminor.yy119 = yymsp[-2].minor.yy119;
+        if (yymsp[-2].minor.yy13->type == QN_UNION && yymsp[-2].minor.yy13->opts.fieldMask == RS_FIELDMASK_ALL) {
+            yylhsminor.yy13 = yymsp[-2].minor.yy13;
         } else {
-            yylhsminor.yy119 = NewUnionNode();
-            QueryNode_AddChild(yylhsminor.yy119, yymsp[-2].minor.yy119);
-            yylhsminor.yy119->opts.fieldMask |= yymsp[-2].minor.yy119->opts.fieldMask;
+            yylhsminor.yy13 = NewUnionNode();
+            QueryNode_AddChild(yylhsminor.yy13, yymsp[-2].minor.yy13);
+            yylhsminor.yy13->opts.fieldMask |= yymsp[-2].minor.yy13->opts.fieldMask;
         }
-        // Handle yymsp[0].minor.yy119
-        QueryNode_AddChild(yylhsminor.yy119, yymsp[0].minor.yy119);
-        yylhsminor.yy119->opts.fieldMask |= yymsp[0].minor.yy119->opts.fieldMask;
-        QueryNode_SetFieldMask(yylhsminor.yy119, yylhsminor.yy119->opts.fieldMask);
+        // Handle yymsp[0].minor.yy13
+        QueryNode_AddChild(yylhsminor.yy13, yymsp[0].minor.yy13);
+        yylhsminor.yy13->opts.fieldMask |= yymsp[0].minor.yy13->opts.fieldMask;
+        QueryNode_SetFieldMask(yylhsminor.yy13, yylhsminor.yy13->opts.fieldMask);
     }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
       case 10: /* union ::= union OR expr */
       case 15: /* text_union ::= text_union OR text_expr */ yytestcase(yyruleno==15);
 {
-    yylhsminor.yy119 = yymsp[-2].minor.yy119;
-    if (yymsp[0].minor.yy119) {
-        QueryNode_AddChild(yylhsminor.yy119, yymsp[0].minor.yy119);
-        yylhsminor.yy119->opts.fieldMask |= yymsp[0].minor.yy119->opts.fieldMask;
-        QueryNode_SetFieldMask(yymsp[0].minor.yy119, yylhsminor.yy119->opts.fieldMask);
+    yylhsminor.yy13 = yymsp[-2].minor.yy13;
+    if (yymsp[0].minor.yy13) {
+        QueryNode_AddChild(yylhsminor.yy13, yymsp[0].minor.yy13);
+        yylhsminor.yy13->opts.fieldMask |= yymsp[0].minor.yy13->opts.fieldMask;
+        QueryNode_SetFieldMask(yymsp[0].minor.yy13, yylhsminor.yy13->opts.fieldMask);
     }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
       case 16: /* expr ::= modifier COLON text_expr */
 {
-    if (yymsp[0].minor.yy119 == NULL) {
-        yylhsminor.yy119 = NULL;
+    if (yymsp[0].minor.yy13 == NULL) {
+        yylhsminor.yy13 = NULL;
     } else {
         if (ctx->sctx->spec) {
-            QueryNode_SetFieldMask(yymsp[0].minor.yy119, IndexSpec_GetFieldBit(ctx->sctx->spec, yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len));
+            QueryNode_SetFieldMask(yymsp[0].minor.yy13, IndexSpec_GetFieldBit(ctx->sctx->spec, yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len));
         }
-        yylhsminor.yy119 = yymsp[0].minor.yy119;
+        yylhsminor.yy13 = yymsp[0].minor.yy13;
     }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
       case 17: /* expr ::= modifierlist COLON text_expr */
 {
 
-    if (yymsp[0].minor.yy119 == NULL) {
-        for (size_t i = 0; i < Vector_Size(yymsp[-2].minor.yy42); i++) {
+    if (yymsp[0].minor.yy13 == NULL) {
+        for (size_t i = 0; i < Vector_Size(yymsp[-2].minor.yy50); i++) {
           char *s;
-          Vector_Get(yymsp[-2].minor.yy42, i, &s);
+          Vector_Get(yymsp[-2].minor.yy50, i, &s);
           rm_free(s);
         }
-        Vector_Free(yymsp[-2].minor.yy42);
-        yylhsminor.yy119 = NULL;
+        Vector_Free(yymsp[-2].minor.yy50);
+        yylhsminor.yy13 = NULL;
     } else {
-        //yymsp[0].minor.yy119->opts.fieldMask = 0;
+        //yymsp[0].minor.yy13->opts.fieldMask = 0;
         t_fieldMask mask = 0;
-        for (int i = 0; i < Vector_Size(yymsp[-2].minor.yy42); i++) {
+        for (int i = 0; i < Vector_Size(yymsp[-2].minor.yy50); i++) {
             char *p;
-            Vector_Get(yymsp[-2].minor.yy42, i, &p);
+            Vector_Get(yymsp[-2].minor.yy50, i, &p);
             if (ctx->sctx->spec) {
               mask |= IndexSpec_GetFieldBit(ctx->sctx->spec, p, strlen(p));
             }
             rm_free(p);
         }
-        Vector_Free(yymsp[-2].minor.yy42);
-        QueryNode_SetFieldMask(yymsp[0].minor.yy119, mask);
-        yylhsminor.yy119=yymsp[0].minor.yy119;
+        Vector_Free(yymsp[-2].minor.yy50);
+        QueryNode_SetFieldMask(yymsp[0].minor.yy13, mask);
+        yylhsminor.yy13=yymsp[0].minor.yy13;
     }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
       case 18: /* expr ::= LP expr RP */
       case 19: /* text_expr ::= LP text_expr RP */ yytestcase(yyruleno==19);
 {
-  yymsp[-2].minor.yy119 = yymsp[-1].minor.yy119;
+  yymsp[-2].minor.yy13 = yymsp[-1].minor.yy13;
 }
         break;
       case 20: /* attribute ::= ATTRIBUTE COLON param_term */
@@ -1703,60 +1710,60 @@ static YYACTIONTYPE yy_reduce(
       value_len = found_value_len;
     }
   }
-  yylhsminor.yy43 = (QueryAttribute){ .name = yymsp[-2].minor.yy0.s, .namelen = yymsp[-2].minor.yy0.len, .value = value, .vallen = value_len };
+  yylhsminor.yy35 = (QueryAttribute){ .name = yymsp[-2].minor.yy0.s, .namelen = yymsp[-2].minor.yy0.len, .value = value, .vallen = value_len };
 }
-  yymsp[-2].minor.yy43 = yylhsminor.yy43;
+  yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
       case 21: /* attribute_list ::= attribute */
 {
-  yylhsminor.yy45 = array_new(QueryAttribute, 2);
-  yylhsminor.yy45 = array_append(yylhsminor.yy45, yymsp[0].minor.yy43);
+  yylhsminor.yy95 = array_new(QueryAttribute, 2);
+  yylhsminor.yy95 = array_append(yylhsminor.yy95, yymsp[0].minor.yy35);
 }
-  yymsp[0].minor.yy45 = yylhsminor.yy45;
+  yymsp[0].minor.yy95 = yylhsminor.yy95;
         break;
       case 22: /* attribute_list ::= attribute_list SEMICOLON attribute */
 {
-  yylhsminor.yy45 = array_append(yymsp[-2].minor.yy45, yymsp[0].minor.yy43);
+  yylhsminor.yy95 = array_append(yymsp[-2].minor.yy95, yymsp[0].minor.yy35);
 }
-  yymsp[-2].minor.yy45 = yylhsminor.yy45;
+  yymsp[-2].minor.yy95 = yylhsminor.yy95;
         break;
       case 23: /* attribute_list ::= attribute_list SEMICOLON */
 {
-  yylhsminor.yy45 = yymsp[-1].minor.yy45;
+  yylhsminor.yy95 = yymsp[-1].minor.yy95;
 }
-  yymsp[-1].minor.yy45 = yylhsminor.yy45;
+  yymsp[-1].minor.yy95 = yylhsminor.yy95;
         break;
       case 24: /* attribute_list ::= */
 {
-  yymsp[1].minor.yy45 = NULL;
+  yymsp[1].minor.yy95 = NULL;
 }
         break;
       case 25: /* expr ::= expr ARROW LB attribute_list RB */
       case 26: /* text_expr ::= text_expr ARROW LB attribute_list RB */ yytestcase(yyruleno==26);
 {
 
-    if (yymsp[-4].minor.yy119 && yymsp[-1].minor.yy45) {
-        QueryNode_ApplyAttributes(yymsp[-4].minor.yy119, yymsp[-1].minor.yy45, array_len(yymsp[-1].minor.yy45), ctx->status);
+    if (yymsp[-4].minor.yy13 && yymsp[-1].minor.yy95) {
+        QueryNode_ApplyAttributes(yymsp[-4].minor.yy13, yymsp[-1].minor.yy95, array_len(yymsp[-1].minor.yy95), ctx->status);
     }
-    array_free_ex(yymsp[-1].minor.yy45, rm_free((char*)((QueryAttribute*)ptr )->value));
-    yylhsminor.yy119 = yymsp[-4].minor.yy119;
+    array_free_ex(yymsp[-1].minor.yy95, rm_free((char*)((QueryAttribute*)ptr )->value));
+    yylhsminor.yy13 = yymsp[-4].minor.yy13;
 }
-  yymsp[-4].minor.yy119 = yylhsminor.yy119;
+  yymsp[-4].minor.yy13 = yylhsminor.yy13;
         break;
       case 27: /* text_expr ::= QUOTE termlist QUOTE */
 {
   // TODO: Quoted/verbatim string in termlist should not be handled as parameters
   // Also need to add the leading '$' which was consumed by the lexer
-  yymsp[-1].minor.yy119->pn.exact = 1;
-  yymsp[-1].minor.yy119->opts.flags |= QueryNode_Verbatim;
+  yymsp[-1].minor.yy13->pn.exact = 1;
+  yymsp[-1].minor.yy13->opts.flags |= QueryNode_Verbatim;
 
-  yymsp[-2].minor.yy119 = yymsp[-1].minor.yy119;
+  yymsp[-2].minor.yy13 = yymsp[-1].minor.yy13;
 }
         break;
       case 28: /* text_expr ::= QUOTE term QUOTE */
 {
-  yymsp[-2].minor.yy119 = NewTokenNode(ctx, rm_strdupcase(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len), -1);
-  yymsp[-2].minor.yy119->opts.flags |= QueryNode_Verbatim;
+  yymsp[-2].minor.yy13 = NewTokenNode(ctx, rm_strdupcase(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len), -1);
+  yymsp[-2].minor.yy13->opts.flags |= QueryNode_Verbatim;
 }
         break;
       case 29: /* text_expr ::= QUOTE ATTRIBUTE QUOTE */
@@ -1766,102 +1773,102 @@ static YYACTIONTYPE yy_reduce(
   char *s = rm_malloc(yymsp[-1].minor.yy0.len + 1);
   *s = '$';
   memcpy(s + 1, yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len);
-  yymsp[-2].minor.yy119 = NewTokenNode(ctx, rm_strdupcase(s, yymsp[-1].minor.yy0.len + 1), -1);
+  yymsp[-2].minor.yy13 = NewTokenNode(ctx, rm_strdupcase(s, yymsp[-1].minor.yy0.len + 1), -1);
   rm_free(s);
-  yymsp[-2].minor.yy119->opts.flags |= QueryNode_Verbatim;
+  yymsp[-2].minor.yy13->opts.flags |= QueryNode_Verbatim;
 }
         break;
       case 30: /* text_expr ::= param_term */
 {
   if (yymsp[0].minor.yy0.type == QT_TERM && StopWordList_Contains(ctx->opts->stopwords, yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len)) {
-    yylhsminor.yy119 = NULL;
+    yylhsminor.yy13 = NULL;
   } else {
-    yylhsminor.yy119 = NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0);
+    yylhsminor.yy13 = NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0);
   }
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 31: /* text_expr ::= affix */
       case 32: /* text_expr ::= verbatim */ yytestcase(yyruleno==32);
 {
-yylhsminor.yy119 = yymsp[0].minor.yy119;
+yylhsminor.yy13 = yymsp[0].minor.yy13;
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 33: /* termlist ::= param_term param_term */
 {
-  yylhsminor.yy119 = NewPhraseNode(0);
-  QueryNode_AddChild(yylhsminor.yy119, NewTokenNode_WithParams(ctx, &yymsp[-1].minor.yy0));
-  QueryNode_AddChild(yylhsminor.yy119, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
+  yylhsminor.yy13 = NewPhraseNode(0);
+  QueryNode_AddChild(yylhsminor.yy13, NewTokenNode_WithParams(ctx, &yymsp[-1].minor.yy0));
+  QueryNode_AddChild(yylhsminor.yy13, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
 }
-  yymsp[-1].minor.yy119 = yylhsminor.yy119;
+  yymsp[-1].minor.yy13 = yylhsminor.yy13;
         break;
       case 34: /* termlist ::= termlist param_term */
 {
-    yylhsminor.yy119 = yymsp[-1].minor.yy119;
+    yylhsminor.yy13 = yymsp[-1].minor.yy13;
     if (!(yymsp[0].minor.yy0.type == QT_TERM && StopWordList_Contains(ctx->opts->stopwords, yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len))) {
-       QueryNode_AddChild(yylhsminor.yy119, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
+       QueryNode_AddChild(yylhsminor.yy13, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
     }
 }
-  yymsp[-1].minor.yy119 = yylhsminor.yy119;
+  yymsp[-1].minor.yy13 = yylhsminor.yy13;
         break;
       case 35: /* expr ::= MINUS expr */
       case 36: /* text_expr ::= MINUS text_expr */ yytestcase(yyruleno==36);
 {
-    if (yymsp[0].minor.yy119) {
-        yymsp[-1].minor.yy119 = NewNotNode(yymsp[0].minor.yy119);
+    if (yymsp[0].minor.yy13) {
+        yymsp[-1].minor.yy13 = NewNotNode(yymsp[0].minor.yy13);
     } else {
-        yymsp[-1].minor.yy119 = NULL;
+        yymsp[-1].minor.yy13 = NULL;
     }
 }
         break;
       case 37: /* expr ::= TILDE expr */
       case 38: /* text_expr ::= TILDE text_expr */ yytestcase(yyruleno==38);
 {
-    if (yymsp[0].minor.yy119) {
-        yymsp[-1].minor.yy119 = NewOptionalNode(yymsp[0].minor.yy119);
+    if (yymsp[0].minor.yy13) {
+        yymsp[-1].minor.yy13 = NewOptionalNode(yymsp[0].minor.yy13);
     } else {
-        yymsp[-1].minor.yy119 = NULL;
+        yymsp[-1].minor.yy13 = NULL;
     }
 }
         break;
       case 39: /* affix ::= PREFIX */
 {
-    yylhsminor.yy119 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, true, false);
+    yylhsminor.yy13 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, true, false);
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 40: /* affix ::= SUFFIX */
 {
-    yylhsminor.yy119 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, false, true);
+    yylhsminor.yy13 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, false, true);
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 41: /* affix ::= CONTAINS */
 {
-    yylhsminor.yy119 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, true, true);
+    yylhsminor.yy13 = NewPrefixNode_WithParams(ctx, &yymsp[0].minor.yy0, true, true);
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 42: /* verbatim ::= WILDCARD */
 {
-    yylhsminor.yy119 = NewWildcardNode_WithParams(ctx, &yymsp[0].minor.yy0);
+    yylhsminor.yy13 = NewWildcardNode_WithParams(ctx, &yymsp[0].minor.yy0);
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 43: /* text_expr ::= PERCENT param_term PERCENT */
 {
-  yymsp[-2].minor.yy119 = NewFuzzyNode_WithParams(ctx, &yymsp[-1].minor.yy0, 1);
+  yymsp[-2].minor.yy13 = NewFuzzyNode_WithParams(ctx, &yymsp[-1].minor.yy0, 1);
 }
         break;
       case 44: /* text_expr ::= PERCENT PERCENT param_term PERCENT PERCENT */
 {
-  yymsp[-4].minor.yy119 = NewFuzzyNode_WithParams(ctx, &yymsp[-2].minor.yy0, 2);
+  yymsp[-4].minor.yy13 = NewFuzzyNode_WithParams(ctx, &yymsp[-2].minor.yy0, 2);
 }
         break;
       case 45: /* text_expr ::= PERCENT PERCENT PERCENT param_term PERCENT PERCENT PERCENT */
 {
-  yymsp[-6].minor.yy119 = NewFuzzyNode_WithParams(ctx, &yymsp[-3].minor.yy0, 3);
+  yymsp[-6].minor.yy13 = NewFuzzyNode_WithParams(ctx, &yymsp[-3].minor.yy0, 3);
 }
         break;
       case 46: /* modifier ::= MODIFIER */
@@ -1873,86 +1880,92 @@ yylhsminor.yy119 = yymsp[0].minor.yy119;
         break;
       case 47: /* modifierlist ::= modifier OR term */
 {
-    yylhsminor.yy42 = NewVector(char *, 2);
+    yylhsminor.yy50 = NewVector(char *, 2);
     char *s = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
-    Vector_Push(yylhsminor.yy42, s);
+    Vector_Push(yylhsminor.yy50, s);
     s = rm_strndup(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
-    Vector_Push(yylhsminor.yy42, s);
+    Vector_Push(yylhsminor.yy50, s);
 }
-  yymsp[-2].minor.yy42 = yylhsminor.yy42;
+  yymsp[-2].minor.yy50 = yylhsminor.yy50;
         break;
       case 48: /* modifierlist ::= modifierlist OR term */
 {
     char *s = rm_strndup(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
-    Vector_Push(yymsp[-2].minor.yy42, s);
-    yylhsminor.yy42 = yymsp[-2].minor.yy42;
+    Vector_Push(yymsp[-2].minor.yy50, s);
+    yylhsminor.yy50 = yymsp[-2].minor.yy50;
 }
-  yymsp[-2].minor.yy42 = yylhsminor.yy42;
+  yymsp[-2].minor.yy50 = yylhsminor.yy50;
         break;
       case 49: /* expr ::= modifier COLON LB tag_list RB */
 {
-    if (!yymsp[-1].minor.yy119) {
-        yylhsminor.yy119 = NULL;
+    if (!yymsp[-1].minor.yy13) {
+        yylhsminor.yy13 = NULL;
     } else {
       // Tag field names must be case sensitive, we can't do rm_strdupcase
         char *s = rm_strndup(yymsp[-4].minor.yy0.s, yymsp[-4].minor.yy0.len);
         size_t slen = unescapen((char*)s, yymsp[-4].minor.yy0.len);
 
-        yylhsminor.yy119 = NewTagNode(s, slen);
-        QueryNode_AddChildren(yylhsminor.yy119, yymsp[-1].minor.yy119->children, QueryNode_NumChildren(yymsp[-1].minor.yy119));
+        yylhsminor.yy13 = NewTagNode(s, slen);
+        QueryNode_AddChildren(yylhsminor.yy13, yymsp[-1].minor.yy13->children, QueryNode_NumChildren(yymsp[-1].minor.yy13));
 
-        // Set the children count on yymsp[-1].minor.yy119 to 0 so they won't get recursively free'd
-        QueryNode_ClearChildren(yymsp[-1].minor.yy119, 0);
-        QueryNode_Free(yymsp[-1].minor.yy119);
+        // Set the children count on yymsp[-1].minor.yy13 to 0 so they won't get recursively free'd
+        QueryNode_ClearChildren(yymsp[-1].minor.yy13, 0);
+        QueryNode_Free(yymsp[-1].minor.yy13);
     }
 }
-  yymsp[-4].minor.yy119 = yylhsminor.yy119;
+  yymsp[-4].minor.yy13 = yylhsminor.yy13;
         break;
       case 50: /* tag_list ::= param_term_case */
 {
-  yylhsminor.yy119 = NewPhraseNode(0);
-  QueryNode_AddChild(yylhsminor.yy119, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
+  yylhsminor.yy13 = NewPhraseNode(0);
+  QueryNode_AddChild(yylhsminor.yy13, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 51: /* tag_list ::= affix */
       case 52: /* tag_list ::= verbatim */ yytestcase(yyruleno==52);
       case 53: /* tag_list ::= termlist */ yytestcase(yyruleno==53);
 {
-    yylhsminor.yy119 = NewPhraseNode(0);
-    QueryNode_AddChild(yylhsminor.yy119, yymsp[0].minor.yy119);
+    yylhsminor.yy13 = NewPhraseNode(0);
+    QueryNode_AddChild(yylhsminor.yy13, yymsp[0].minor.yy13);
 }
-  yymsp[0].minor.yy119 = yylhsminor.yy119;
+  yymsp[0].minor.yy13 = yylhsminor.yy13;
         break;
       case 54: /* tag_list ::= tag_list OR param_term_case */
 {
-  QueryNode_AddChild(yymsp[-2].minor.yy119, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
-  yylhsminor.yy119 = yymsp[-2].minor.yy119;
+  QueryNode_AddChild(yymsp[-2].minor.yy13, NewTokenNode_WithParams(ctx, &yymsp[0].minor.yy0));
+  yylhsminor.yy13 = yymsp[-2].minor.yy13;
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
       case 55: /* tag_list ::= tag_list OR affix */
       case 56: /* tag_list ::= tag_list OR verbatim */ yytestcase(yyruleno==56);
       case 57: /* tag_list ::= tag_list OR termlist */ yytestcase(yyruleno==57);
 {
-    QueryNode_AddChild(yymsp[-2].minor.yy119, yymsp[0].minor.yy119);
-    yylhsminor.yy119 = yymsp[-2].minor.yy119;
+    QueryNode_AddChild(yymsp[-2].minor.yy13, yymsp[0].minor.yy13);
+    yylhsminor.yy13 = yymsp[-2].minor.yy13;
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 58: /* expr ::= modifier COLON numeric_range */
+      case 58: /* expr ::= ISMISSING LP modifier RP */
 {
-  if (yymsp[0].minor.yy62) {
+  // Field names are case sensitive
+  yymsp[-3].minor.yy13 = NewMissingNode(rm_strndup(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len), yymsp[-1].minor.yy0.len);
+}
+        break;
+      case 59: /* expr ::= modifier COLON numeric_range */
+{
+  if (yymsp[0].minor.yy72) {
     // we keep the capitalization as is
-    yymsp[0].minor.yy62->nf->fieldName = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
-    yylhsminor.yy119 = NewNumericNode(yymsp[0].minor.yy62);
+    yymsp[0].minor.yy72->nf->fieldName = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
+    yylhsminor.yy13 = NewNumericNode(yymsp[0].minor.yy72);
   } else {
-    yylhsminor.yy119 = NewQueryNode(QN_NULL);
+    yylhsminor.yy13 = NewQueryNode(QN_NULL);
   }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 59: /* numeric_range ::= LSQB param_num param_num RSQB */
+      case 60: /* numeric_range ::= LSQB param_num param_num RSQB */
 {
   if (yymsp[-2].minor.yy0.type == QT_PARAM_NUMERIC) {
     yymsp[-2].minor.yy0.type = QT_PARAM_NUMERIC_MIN_RANGE;
@@ -1960,22 +1973,22 @@ yylhsminor.yy119 = yymsp[0].minor.yy119;
   if (yymsp[-1].minor.yy0.type == QT_PARAM_NUMERIC) {
     yymsp[-1].minor.yy0.type = QT_PARAM_NUMERIC_MAX_RANGE;
   }
-  yymsp[-3].minor.yy62 = NewNumericFilterQueryParam_WithParams(ctx, &yymsp[-2].minor.yy0, &yymsp[-1].minor.yy0, yymsp[-2].minor.yy0.inclusive, yymsp[-1].minor.yy0.inclusive);
+  yymsp[-3].minor.yy72 = NewNumericFilterQueryParam_WithParams(ctx, &yymsp[-2].minor.yy0, &yymsp[-1].minor.yy0, yymsp[-2].minor.yy0.inclusive, yymsp[-1].minor.yy0.inclusive);
 }
         break;
-      case 60: /* expr ::= modifier COLON geo_filter */
+      case 61: /* expr ::= modifier COLON geo_filter */
 {
-  if (yymsp[0].minor.yy62) {
+  if (yymsp[0].minor.yy72) {
     // we keep the capitalization as is
-    yymsp[0].minor.yy62->gf->property = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
-    yylhsminor.yy119 = NewGeofilterNode(yymsp[0].minor.yy62);
+    yymsp[0].minor.yy72->gf->property = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
+    yylhsminor.yy13 = NewGeofilterNode(yymsp[0].minor.yy72);
   } else {
-    yylhsminor.yy119 = NewQueryNode(QN_NULL);
+    yylhsminor.yy13 = NewQueryNode(QN_NULL);
   }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 61: /* geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
+      case 62: /* geo_filter ::= LSQB param_num param_num param_num param_term RSQB */
 {
   if (yymsp[-4].minor.yy0.type == QT_PARAM_NUMERIC)
     yymsp[-4].minor.yy0.type = QT_PARAM_GEO_COORD;
@@ -1985,274 +1998,274 @@ yylhsminor.yy119 = yymsp[0].minor.yy119;
   if (yymsp[-1].minor.yy0.type == QT_PARAM_TERM)
     yymsp[-1].minor.yy0.type = QT_PARAM_GEO_UNIT;
 
-  yymsp[-5].minor.yy62 = NewGeoFilterQueryParam_WithParams(ctx, &yymsp[-4].minor.yy0, &yymsp[-3].minor.yy0, &yymsp[-2].minor.yy0, &yymsp[-1].minor.yy0);
+  yymsp[-5].minor.yy72 = NewGeoFilterQueryParam_WithParams(ctx, &yymsp[-4].minor.yy0, &yymsp[-3].minor.yy0, &yymsp[-2].minor.yy0, &yymsp[-1].minor.yy0);
 }
         break;
-      case 62: /* expr ::= modifier COLON geometry_query */
+      case 63: /* expr ::= modifier COLON geometry_query */
 {
-  if (yymsp[0].minor.yy119) {
+  if (yymsp[0].minor.yy13) {
     // we keep the capitalization as is
-    yymsp[0].minor.yy119->gmn.geomq->attr = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
-    yylhsminor.yy119 = yymsp[0].minor.yy119;
+    yymsp[0].minor.yy13->gmn.geomq->attr = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
+    yylhsminor.yy13 = yymsp[0].minor.yy13;
   } else {
-    yylhsminor.yy119 = NewQueryNode(QN_NULL);
+    yylhsminor.yy13 = NewQueryNode(QN_NULL);
   }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 63: /* geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
+      case 64: /* geometry_query ::= LSQB TERM ATTRIBUTE RSQB */
 {
   // Geometry param is actually a case sensitive term
   yymsp[-1].minor.yy0.type = QT_PARAM_TERM_CASE;
-  yymsp[-3].minor.yy119 = NewGeometryNode_FromWkt_WithParams(ctx, yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len, &yymsp[-1].minor.yy0);
-  if (!yymsp[-3].minor.yy119) {
+  yymsp[-3].minor.yy13 = NewGeometryNode_FromWkt_WithParams(ctx, yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len, &yymsp[-1].minor.yy0);
+  if (!yymsp[-3].minor.yy13) {
     reportSyntaxError(ctx->status, &yymsp[-1].minor.yy0, "Syntax error: Expecting a geoshape predicate");
   }
 }
         break;
-      case 64: /* query ::= expr ARROW LSQB vector_query RSQB */
-      case 65: /* query ::= text_expr ARROW LSQB vector_query RSQB */ yytestcase(yyruleno==65);
+      case 65: /* query ::= expr ARROW LSQB vector_query RSQB */
+      case 66: /* query ::= text_expr ARROW LSQB vector_query RSQB */ yytestcase(yyruleno==66);
 { // main parse, hybrid query as entire query case.
   setup_trace(ctx);
-  RS_LOG_ASSERT(yymsp[-1].minor.yy119->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
-  ctx->root = yymsp[-1].minor.yy119;
-  if (yymsp[-4].minor.yy119) {
-    QueryNode_AddChild(yymsp[-1].minor.yy119, yymsp[-4].minor.yy119);
+  RS_LOG_ASSERT(yymsp[-1].minor.yy13->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
+  ctx->root = yymsp[-1].minor.yy13;
+  if (yymsp[-4].minor.yy13) {
+    QueryNode_AddChild(yymsp[-1].minor.yy13, yymsp[-4].minor.yy13);
   }
 }
         break;
-      case 66: /* query ::= star ARROW LSQB vector_query RSQB */
-{  yy_destructor(yypParser,57,&yymsp[-4].minor);
+      case 67: /* query ::= star ARROW LSQB vector_query RSQB */
+{  yy_destructor(yypParser,58,&yymsp[-4].minor);
 { // main parse, simple vecsim search as entire query case.
   setup_trace(ctx);
-  RS_LOG_ASSERT(yymsp[-1].minor.yy119->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
-  yymsp[-1].minor.yy119->vn.vq->knn.order = BY_SCORE;
+  RS_LOG_ASSERT(yymsp[-1].minor.yy13->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
+  yymsp[-1].minor.yy13->vn.vq->knn.order = BY_SCORE;
 
-  ctx->root = yymsp[-1].minor.yy119;
+  ctx->root = yymsp[-1].minor.yy13;
 }
 }
         break;
-      case 67: /* vector_query ::= vector_command vector_attribute_list vector_score_field */
+      case 68: /* vector_query ::= vector_command vector_attribute_list vector_score_field */
 {
-  if (yymsp[-2].minor.yy119->vn.vq->scoreField) {
-    rm_free(yymsp[-2].minor.yy119->vn.vq->scoreField);
-    yymsp[-2].minor.yy119->vn.vq->scoreField = NULL;
+  if (yymsp[-2].minor.yy13->vn.vq->scoreField) {
+    rm_free(yymsp[-2].minor.yy13->vn.vq->scoreField);
+    yymsp[-2].minor.yy13->vn.vq->scoreField = NULL;
   }
-  yymsp[-2].minor.yy119->params = array_grow(yymsp[-2].minor.yy119->params, 1);
-  memset(&array_tail(yymsp[-2].minor.yy119->params), 0, sizeof(*yymsp[-2].minor.yy119->params));
-  QueryNode_SetParam(ctx, &(array_tail(yymsp[-2].minor.yy119->params)), &(yymsp[-2].minor.yy119->vn.vq->scoreField), NULL, &yymsp[0].minor.yy0);
-  yymsp[-2].minor.yy119->vn.vq->params = yymsp[-1].minor.yy2;
-  yylhsminor.yy119 = yymsp[-2].minor.yy119;
+  yymsp[-2].minor.yy13->params = array_grow(yymsp[-2].minor.yy13->params, 1);
+  memset(&array_tail(yymsp[-2].minor.yy13->params), 0, sizeof(*yymsp[-2].minor.yy13->params));
+  QueryNode_SetParam(ctx, &(array_tail(yymsp[-2].minor.yy13->params)), &(yymsp[-2].minor.yy13->vn.vq->scoreField), NULL, &yymsp[0].minor.yy0);
+  yymsp[-2].minor.yy13->vn.vq->params = yymsp[-1].minor.yy4;
+  yylhsminor.yy13 = yymsp[-2].minor.yy13;
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 68: /* vector_query ::= vector_command vector_score_field */
+      case 69: /* vector_query ::= vector_command vector_score_field */
 {
-  if (yymsp[-1].minor.yy119->vn.vq->scoreField) {
-    rm_free(yymsp[-1].minor.yy119->vn.vq->scoreField);
-    yymsp[-1].minor.yy119->vn.vq->scoreField = NULL;
+  if (yymsp[-1].minor.yy13->vn.vq->scoreField) {
+    rm_free(yymsp[-1].minor.yy13->vn.vq->scoreField);
+    yymsp[-1].minor.yy13->vn.vq->scoreField = NULL;
   }
-  yymsp[-1].minor.yy119->params = array_grow(yymsp[-1].minor.yy119->params, 1);
-  memset(&array_tail(yymsp[-1].minor.yy119->params), 0, sizeof(*yymsp[-1].minor.yy119->params));
-  QueryNode_SetParam(ctx, &(array_tail(yymsp[-1].minor.yy119->params)), &(yymsp[-1].minor.yy119->vn.vq->scoreField), NULL, &yymsp[0].minor.yy0);
-  yylhsminor.yy119 = yymsp[-1].minor.yy119;
+  yymsp[-1].minor.yy13->params = array_grow(yymsp[-1].minor.yy13->params, 1);
+  memset(&array_tail(yymsp[-1].minor.yy13->params), 0, sizeof(*yymsp[-1].minor.yy13->params));
+  QueryNode_SetParam(ctx, &(array_tail(yymsp[-1].minor.yy13->params)), &(yymsp[-1].minor.yy13->vn.vq->scoreField), NULL, &yymsp[0].minor.yy0);
+  yylhsminor.yy13 = yymsp[-1].minor.yy13;
 }
-  yymsp[-1].minor.yy119 = yylhsminor.yy119;
+  yymsp[-1].minor.yy13 = yylhsminor.yy13;
         break;
-      case 69: /* vector_query ::= vector_command vector_attribute_list */
+      case 70: /* vector_query ::= vector_command vector_attribute_list */
 {
-  yymsp[-1].minor.yy119->vn.vq->params = yymsp[0].minor.yy2;
-  yylhsminor.yy119 = yymsp[-1].minor.yy119;
+  yymsp[-1].minor.yy13->vn.vq->params = yymsp[0].minor.yy4;
+  yylhsminor.yy13 = yymsp[-1].minor.yy13;
 }
-  yymsp[-1].minor.yy119 = yylhsminor.yy119;
+  yymsp[-1].minor.yy13 = yylhsminor.yy13;
         break;
-      case 71: /* vector_score_field ::= as param_term_case */
-{  yy_destructor(yypParser,64,&yymsp[-1].minor);
+      case 72: /* vector_score_field ::= as param_term_case */
+{  yy_destructor(yypParser,65,&yymsp[-1].minor);
 {
   yymsp[-1].minor.yy0 = yymsp[0].minor.yy0;
 }
 }
         break;
-      case 72: /* query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+      case 73: /* query ::= expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
 {
   setup_trace(ctx);
-  RS_LOG_ASSERT(yymsp[-5].minor.yy119->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
-  ctx->root = yymsp[-5].minor.yy119;
-  if (yymsp[-5].minor.yy119 && yymsp[-1].minor.yy45) {
-     QueryNode_ApplyAttributes(yymsp[-5].minor.yy119, yymsp[-1].minor.yy45, array_len(yymsp[-1].minor.yy45), ctx->status);
+  RS_LOG_ASSERT(yymsp[-5].minor.yy13->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
+  ctx->root = yymsp[-5].minor.yy13;
+  if (yymsp[-5].minor.yy13 && yymsp[-1].minor.yy95) {
+     QueryNode_ApplyAttributes(yymsp[-5].minor.yy13, yymsp[-1].minor.yy95, array_len(yymsp[-1].minor.yy95), ctx->status);
   }
-  array_free_ex(yymsp[-1].minor.yy45, rm_free((char*)((QueryAttribute*)ptr )->value));
+  array_free_ex(yymsp[-1].minor.yy95, rm_free((char*)((QueryAttribute*)ptr )->value));
 
-  if (yymsp[-8].minor.yy119) {
-      QueryNode_AddChild(yymsp[-5].minor.yy119, yymsp[-8].minor.yy119);
+  if (yymsp[-8].minor.yy13) {
+      QueryNode_AddChild(yymsp[-5].minor.yy13, yymsp[-8].minor.yy13);
   }
 }
         break;
-      case 73: /* query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+      case 74: /* query ::= text_expr ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
 {
   setup_trace(ctx);
-  RS_LOG_ASSERT(yymsp[-5].minor.yy119->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
-  ctx->root = yymsp[-5].minor.yy119;
-  if (yymsp[-5].minor.yy119 && yymsp[-1].minor.yy45) {
-     QueryNode_ApplyAttributes(yymsp[-5].minor.yy119, yymsp[-1].minor.yy45, array_len(yymsp[-1].minor.yy45), ctx->status);
+  RS_LOG_ASSERT(yymsp[-5].minor.yy13->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
+  ctx->root = yymsp[-5].minor.yy13;
+  if (yymsp[-5].minor.yy13 && yymsp[-1].minor.yy95) {
+     QueryNode_ApplyAttributes(yymsp[-5].minor.yy13, yymsp[-1].minor.yy95, array_len(yymsp[-1].minor.yy95), ctx->status);
   }
-  array_free_ex(yymsp[-1].minor.yy45, rm_free((char*)((QueryAttribute*)ptr )->value));
+  array_free_ex(yymsp[-1].minor.yy95, rm_free((char*)((QueryAttribute*)ptr )->value));
 
-  if (yymsp[-8].minor.yy119) {
-    QueryNode_AddChild(yymsp[-5].minor.yy119, yymsp[-8].minor.yy119);
+  if (yymsp[-8].minor.yy13) {
+    QueryNode_AddChild(yymsp[-5].minor.yy13, yymsp[-8].minor.yy13);
   }
 }
         break;
-      case 74: /* query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
-{  yy_destructor(yypParser,57,&yymsp[-8].minor);
+      case 75: /* query ::= star ARROW LSQB vector_query RSQB ARROW LB attribute_list RB */
+{  yy_destructor(yypParser,58,&yymsp[-8].minor);
 {
   setup_trace(ctx);
-  RS_LOG_ASSERT(yymsp[-5].minor.yy119->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
-  yymsp[-5].minor.yy119->vn.vq->knn.order = BY_SCORE;
+  RS_LOG_ASSERT(yymsp[-5].minor.yy13->vn.vq->type == VECSIM_QT_KNN, "vector_query must be KNN");
+  yymsp[-5].minor.yy13->vn.vq->knn.order = BY_SCORE;
 
-  ctx->root = yymsp[-5].minor.yy119;
-  if (yymsp[-5].minor.yy119 && yymsp[-1].minor.yy45) {
-     QueryNode_ApplyAttributes(yymsp[-5].minor.yy119, yymsp[-1].minor.yy45, array_len(yymsp[-1].minor.yy45), ctx->status);
+  ctx->root = yymsp[-5].minor.yy13;
+  if (yymsp[-5].minor.yy13 && yymsp[-1].minor.yy95) {
+     QueryNode_ApplyAttributes(yymsp[-5].minor.yy13, yymsp[-1].minor.yy95, array_len(yymsp[-1].minor.yy95), ctx->status);
   }
-  array_free_ex(yymsp[-1].minor.yy45, rm_free((char*)((QueryAttribute*)ptr )->value));
+  array_free_ex(yymsp[-1].minor.yy95, rm_free((char*)((QueryAttribute*)ptr )->value));
 
 }
 }
         break;
-      case 75: /* vector_command ::= TERM param_size modifier ATTRIBUTE */
+      case 76: /* vector_command ::= TERM param_size modifier ATTRIBUTE */
 {
   if (!strncasecmp("KNN", yymsp[-3].minor.yy0.s, yymsp[-3].minor.yy0.len)) {
     yymsp[0].minor.yy0.type = QT_PARAM_VEC;
-    yylhsminor.yy119 = NewVectorNode_WithParams(ctx, VECSIM_QT_KNN, &yymsp[-2].minor.yy0, &yymsp[0].minor.yy0);
-    yylhsminor.yy119->vn.vq->property = rm_strndup(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len);
-    RedisModule_Assert(-1 != (rm_asprintf(&yylhsminor.yy119->vn.vq->scoreField, "__%.*s_score", yymsp[-1].minor.yy0.len, yymsp[-1].minor.yy0.s)));
+    yylhsminor.yy13 = NewVectorNode_WithParams(ctx, VECSIM_QT_KNN, &yymsp[-2].minor.yy0, &yymsp[0].minor.yy0);
+    yylhsminor.yy13->vn.vq->property = rm_strndup(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len);
+    RedisModule_Assert(-1 != (rm_asprintf(&yylhsminor.yy13->vn.vq->scoreField, "__%.*s_score", yymsp[-1].minor.yy0.len, yymsp[-1].minor.yy0.s)));
   } else {
     reportSyntaxError(ctx->status, &yymsp[-3].minor.yy0, "Syntax error: Expecting Vector Similarity command");
-    yylhsminor.yy119 = NULL;
+    yylhsminor.yy13 = NULL;
   }
 }
-  yymsp[-3].minor.yy119 = yylhsminor.yy119;
+  yymsp[-3].minor.yy13 = yylhsminor.yy13;
         break;
-      case 76: /* vector_attribute ::= TERM param_term */
+      case 77: /* vector_attribute ::= TERM param_term */
 {
   const char *value = rm_strndup(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
   const char *name = rm_strndup(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len);
-  yylhsminor.yy125.param = (VecSimRawParam){ .name = name, .nameLen = yymsp[-1].minor.yy0.len, .value = value, .valLen = yymsp[0].minor.yy0.len };
+  yylhsminor.yy79.param = (VecSimRawParam){ .name = name, .nameLen = yymsp[-1].minor.yy0.len, .value = value, .valLen = yymsp[0].minor.yy0.len };
   if (yymsp[0].minor.yy0.type == QT_PARAM_TERM) {
-    yylhsminor.yy125.needResolve = true;
+    yylhsminor.yy79.needResolve = true;
   }
   else { // if yymsp[0].minor.yy0.type == QT_TERM
-    yylhsminor.yy125.needResolve = false;
+    yylhsminor.yy79.needResolve = false;
   }
 }
-  yymsp[-1].minor.yy125 = yylhsminor.yy125;
+  yymsp[-1].minor.yy79 = yylhsminor.yy79;
         break;
-      case 77: /* vector_attribute_list ::= vector_attribute_list vector_attribute */
+      case 78: /* vector_attribute_list ::= vector_attribute_list vector_attribute */
 {
-  yylhsminor.yy2.params = array_append(yymsp[-1].minor.yy2.params, yymsp[0].minor.yy125.param);
-  yylhsminor.yy2.needResolve = array_append(yymsp[-1].minor.yy2.needResolve, yymsp[0].minor.yy125.needResolve);
+  yylhsminor.yy4.params = array_append(yymsp[-1].minor.yy4.params, yymsp[0].minor.yy79.param);
+  yylhsminor.yy4.needResolve = array_append(yymsp[-1].minor.yy4.needResolve, yymsp[0].minor.yy79.needResolve);
 }
-  yymsp[-1].minor.yy2 = yylhsminor.yy2;
+  yymsp[-1].minor.yy4 = yylhsminor.yy4;
         break;
-      case 78: /* vector_attribute_list ::= vector_attribute */
+      case 79: /* vector_attribute_list ::= vector_attribute */
 {
-  yylhsminor.yy2.params = array_new(VecSimRawParam, 1);
-  yylhsminor.yy2.needResolve = array_new(bool, 1);
-  yylhsminor.yy2.params = array_append(yylhsminor.yy2.params, yymsp[0].minor.yy125.param);
-  yylhsminor.yy2.needResolve = array_append(yylhsminor.yy2.needResolve, yymsp[0].minor.yy125.needResolve);
+  yylhsminor.yy4.params = array_new(VecSimRawParam, 1);
+  yylhsminor.yy4.needResolve = array_new(bool, 1);
+  yylhsminor.yy4.params = array_append(yylhsminor.yy4.params, yymsp[0].minor.yy79.param);
+  yylhsminor.yy4.needResolve = array_append(yylhsminor.yy4.needResolve, yymsp[0].minor.yy79.needResolve);
 }
-  yymsp[0].minor.yy2 = yylhsminor.yy2;
+  yymsp[0].minor.yy4 = yylhsminor.yy4;
         break;
-      case 79: /* expr ::= modifier COLON LSQB vector_range_command RSQB */
+      case 80: /* expr ::= modifier COLON LSQB vector_range_command RSQB */
 {
-    yymsp[-1].minor.yy119->vn.vq->property = rm_strndup(yymsp[-4].minor.yy0.s, yymsp[-4].minor.yy0.len);
-    yylhsminor.yy119 = yymsp[-1].minor.yy119;
+    yymsp[-1].minor.yy13->vn.vq->property = rm_strndup(yymsp[-4].minor.yy0.s, yymsp[-4].minor.yy0.len);
+    yylhsminor.yy13 = yymsp[-1].minor.yy13;
 }
-  yymsp[-4].minor.yy119 = yylhsminor.yy119;
+  yymsp[-4].minor.yy13 = yylhsminor.yy13;
         break;
-      case 80: /* vector_range_command ::= TERM param_num ATTRIBUTE */
+      case 81: /* vector_range_command ::= TERM param_num ATTRIBUTE */
 {
   if (!strncasecmp("VECTOR_RANGE", yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len)) {
     yymsp[0].minor.yy0.type = QT_PARAM_VEC;
-    yylhsminor.yy119 = NewVectorNode_WithParams(ctx, VECSIM_QT_RANGE, &yymsp[-1].minor.yy0, &yymsp[0].minor.yy0);
+    yylhsminor.yy13 = NewVectorNode_WithParams(ctx, VECSIM_QT_RANGE, &yymsp[-1].minor.yy0, &yymsp[0].minor.yy0);
   } else {
     reportSyntaxError(ctx->status, &yymsp[-2].minor.yy0, "Syntax error: expecting vector similarity range command");
-    yylhsminor.yy119 = NULL;
+    yylhsminor.yy13 = NULL;
   }
 }
-  yymsp[-2].minor.yy119 = yylhsminor.yy119;
+  yymsp[-2].minor.yy13 = yylhsminor.yy13;
         break;
-      case 81: /* num ::= SIZE */
-      case 82: /* num ::= NUMBER */ yytestcase(yyruleno==82);
+      case 82: /* num ::= SIZE */
+      case 83: /* num ::= NUMBER */ yytestcase(yyruleno==83);
 {
-  yylhsminor.yy47.num = yymsp[0].minor.yy0.numval;
-  yylhsminor.yy47.inclusive = 1;
+  yylhsminor.yy93.num = yymsp[0].minor.yy0.numval;
+  yylhsminor.yy93.inclusive = 1;
 }
-  yymsp[0].minor.yy47 = yylhsminor.yy47;
+  yymsp[0].minor.yy93 = yylhsminor.yy93;
         break;
-      case 83: /* num ::= LP num */
+      case 84: /* num ::= LP num */
 {
-  yymsp[-1].minor.yy47=yymsp[0].minor.yy47;
-  yymsp[-1].minor.yy47.inclusive = 0;
+  yymsp[-1].minor.yy93=yymsp[0].minor.yy93;
+  yymsp[-1].minor.yy93.inclusive = 0;
 }
         break;
-      case 84: /* num ::= MINUS num */
+      case 85: /* num ::= MINUS num */
 {
-  yymsp[0].minor.yy47.num = -yymsp[0].minor.yy47.num;
-  yymsp[-1].minor.yy47 = yymsp[0].minor.yy47;
+  yymsp[0].minor.yy93.num = -yymsp[0].minor.yy93.num;
+  yymsp[-1].minor.yy93 = yymsp[0].minor.yy93;
 }
         break;
-      case 85: /* term ::= TERM */
-      case 86: /* term ::= NUMBER */ yytestcase(yyruleno==86);
-      case 87: /* term ::= SIZE */ yytestcase(yyruleno==87);
+      case 86: /* term ::= TERM */
+      case 87: /* term ::= NUMBER */ yytestcase(yyruleno==87);
+      case 88: /* term ::= SIZE */ yytestcase(yyruleno==88);
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 88: /* param_term ::= term */
+      case 89: /* param_term ::= term */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_TERM;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 89: /* param_term ::= ATTRIBUTE */
+      case 90: /* param_term ::= ATTRIBUTE */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_PARAM_TERM;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 90: /* param_term_case ::= term */
+      case 91: /* param_term_case ::= term */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_TERM_CASE;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 91: /* param_term_case ::= ATTRIBUTE */
+      case 92: /* param_term_case ::= ATTRIBUTE */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_PARAM_TERM_CASE;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 92: /* param_size ::= SIZE */
+      case 93: /* param_size ::= SIZE */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_SIZE;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 93: /* param_size ::= ATTRIBUTE */
+      case 94: /* param_size ::= ATTRIBUTE */
 {
   yylhsminor.yy0 = yymsp[0].minor.yy0;
   yylhsminor.yy0.type = QT_PARAM_SIZE;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 94: /* param_num ::= ATTRIBUTE */
+      case 95: /* param_num ::= ATTRIBUTE */
 {
     yylhsminor.yy0 = yymsp[0].minor.yy0;
     yylhsminor.yy0.type = QT_PARAM_NUMERIC;
@@ -2260,29 +2273,29 @@ yylhsminor.yy119 = yymsp[0].minor.yy119;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 95: /* param_num ::= num */
+      case 96: /* param_num ::= num */
 {
-  yylhsminor.yy0.numval = yymsp[0].minor.yy47.num;
-  yylhsminor.yy0.inclusive = yymsp[0].minor.yy47.inclusive;
+  yylhsminor.yy0.numval = yymsp[0].minor.yy93.num;
+  yylhsminor.yy0.inclusive = yymsp[0].minor.yy93.inclusive;
   yylhsminor.yy0.type = QT_NUMERIC;
 }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 96: /* param_num ::= LP ATTRIBUTE */
+      case 97: /* param_num ::= LP ATTRIBUTE */
 {
     yymsp[-1].minor.yy0 = yymsp[0].minor.yy0;
     yymsp[-1].minor.yy0.type = QT_PARAM_NUMERIC;
     yymsp[-1].minor.yy0.inclusive = 0;
 }
         break;
-      case 98: /* star ::= LP star RP */
+      case 99: /* star ::= LP star RP */
 {
 }
-  yy_destructor(yypParser,57,&yymsp[-1].minor);
+  yy_destructor(yypParser,58,&yymsp[-1].minor);
         break;
       default:
-      /* (97) star ::= STAR */ yytestcase(yyruleno==97);
-      /* (99) as ::= AS_T */ yytestcase(yyruleno==99);
+      /* (98) star ::= STAR */ yytestcase(yyruleno==98);
+      /* (100) as ::= AS_T */ yytestcase(yyruleno==100);
         break;
 /********** End reduce actions ************************************************/
   };
@@ -11,22 +11,23 @@
 #define LP                              11
 #define LB                              12
 #define LSQB                            13
-#define TILDE                           14
-#define MINUS                           15
-#define AND                             16
-#define ARROW                           17
-#define COLON                           18
-#define NUMBER                          19
-#define SIZE                            20
-#define STAR                            21
-#define TAGLIST                         22
-#define TERMLIST                        23
-#define PREFIX                          24
-#define SUFFIX                          25
-#define CONTAINS                        26
-#define PERCENT                         27
-#define ATTRIBUTE                       28
-#define VERBATIM                        29
-#define WILDCARD                        30
-#define AS_T                            31
-#define SEMICOLON                       32
+#define ISMISSING                       14
+#define TILDE                           15
+#define MINUS                           16
+#define AND                             17
+#define ARROW                           18
+#define COLON                           19
+#define NUMBER                          20
+#define SIZE                            21
+#define STAR                            22
+#define TAGLIST                         23
+#define TERMLIST                        24
+#define PREFIX                          25
+#define SUFFIX                          26
+#define CONTAINS                        27
+#define PERCENT                         28
+#define ATTRIBUTE                       29
+#define VERBATIM                        30
+#define WILDCARD                        31
+#define AS_T                            32
+#define SEMICOLON                       33
@@ -20,7 +20,7 @@
 
 %left TERM.
 %left QUOTE.
-%left LP LB LSQB.
+%left LP LB LSQB ISMISSING.
 
 %left TILDE MINUS.
 %left AND.
@@ -776,6 +776,15 @@ tag_list(A) ::= tag_list(B) OR termlist(C) . [TAGLIST] {
     A = B;
 }
 
+/////////////////////////////////////////////////////////////////
+// Missing Fields
+/////////////////////////////////////////////////////////////////
+
+expr(A) ::= ISMISSING LP modifier(B) RP . {
+  // Field names are case sensitive
+  A = NewMissingNode(rm_strndup(B.s, B.len), B.len);
+}
+
 /////////////////////////////////////////////////////////////////
 // Numeric Ranges
 /////////////////////////////////////////////////////////////////
@@ -14,15 +14,137 @@
 #include "util/misc.h"
 #include "tag_index.h"
 #include "rmalloc.h"
+#include "util/arr.h"
+#include "util/minmax.h"
+#include "rdb.h"
 #include <stdio.h>
 
 RedisModuleType *InvertedIndexType;
 
+// Small blocks are coalesced into chunks of this size, larger ones are saved on their own
+#define INVERTED_INDEX_SAVE_CHUNK (64 * 1024)
+
+// The header of a block in the block index
+typedef struct {
+  uint64_t firstId;
+  uint64_t lastId;
+  uint64_t len;
+  uint32_t numEntries;
+  uint32_t format;  // The sealed flags of the block
+  uint32_t maxFreq;
+  float min;        // The value range of a numeric block
+  float max;
+  uint32_t pad;
+} savedBlock;
+
+typedef struct {
+  RedisModuleIO *rdb;
+  char *chunk;
+  size_t len;
+  size_t pos;
+} chunkReader;
+
+/* Read the data of the next block from the chunks. A block saved in a chunk of its own is adopted
+ * as is when the module allocates with the allocator of Redis. Returns NULL on an IO error */
+static char *chunkReader_Read(chunkReader *r, size_t len) {
+  char *data = NULL;
+  size_t off = 0;
+  while (off < len) {
+    if (r->pos == r->len) {
+      RedisModule_Free(r->chunk);
+      r->chunk = NULL;
+      r->len = r->pos = 0;
+      char *chunk = LoadStringBuffer_IOError(r->rdb, &r->len, goto err);
+      if (!r->len) {
+        // Empty chunks are never saved
+        RedisModule_Free(chunk);
+        goto err;
+      }
+#ifdef REDIS_MODULE_TARGET
+      if (!off && r->len == len) {
+        r->len = 0;
+        return chunk;
+      }
+#endif
+      r->chunk = chunk;
+    }
+    if (!data) {
+      data = rm_malloc(len);
+    }
+    size_t n = MIN(len - off, r->len - r->pos);
+    memcpy(data + off, r->chunk + r->pos, n);
+    off += n;
+    r->pos += n;
+  }
+  return data;
+
+err:
+  rm_free(data);
+  return NULL;
+}
+
+/* Load the blocks saved behind a block index. The block array is allocated at once from the index,
+ * and every block's data with a single allocation. Returns NULL on an IO error or a corrupt index */
+static IndexBlock *loadIndexedBlocks(RedisModuleIO *rdb, IndexFlags flags, uint32_t *size) {
+  size_t indexLen;
+  savedBlock *index = (savedBlock *)LoadStringBuffer_IOError(rdb, &indexLen, return NULL);
+  uint32_t n = indexLen / sizeof(*index);
+  IndexBlock *blocks = rm_calloc(MAX(n, 1), sizeof(*blocks));
+  chunkReader r = {.rdb = rdb};
+  uint32_t i = 0;
+  for (; i < n; i++) {
+    const savedBlock *sb = &index[i];
+    IndexBlock *blk = &blocks[i];
+    if ((sb->format & ~IndexBlock_SealedFlags) || !sb->numEntries || sb->numEntries > UINT16_MAX ||
+        !sb->len) {
+      break;
+    }
+    blk->firstId = sb->firstId;
+    blk->lastId = sb->lastId;
+    blk->numEntries = sb->numEntries;
+    blk->flags = sb->format;
+    if (flags & Index_StoreNumeric) {
+      blk->valueRange.min = sb->min;
+      blk->valueRange.max = sb->max;
+    } else {
+      blk->maxFreq = sb->maxFreq;
+    }
+    if (!(blk->buf.data = chunkReader_Read(&r, sb->len))) {
+      break;
+    }
+    blk->buf.cap = blk->buf.offset = sb->len;
+  }
+  RedisModule_Free(r.chunk);
+  RedisModule_Free(index);
+
+  if (i < n || indexLen % sizeof(*index)) {
+    for (uint32_t j = 0; j < i; j++) {
+      rm_free(blocks[j].buf.data);
+    }
+    rm_free(blocks);
+    return NULL;
+  }
+  *size = n;
+  return blocks;
+}
+
 void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
   if (encver > INVERTED_INDEX_ENCVER) {
     return NULL;
   }
   InvertedIndex *idx = NewInvertedIndex(RedisModule_LoadUnsigned(rdb), 0);
+  if (encver >= INVERTED_INDEX_BLOCK_INDEX_VER) {
+    idx->lastId = RedisModule_LoadUnsigned(rdb);
+    idx->numDocs = RedisModule_LoadUnsigned(rdb);
+    uint32_t size = 0;
+    IndexBlock *blocks = loadIndexedBlocks(rdb, idx->flags, &size);
+    if (!blocks) {
+      InvertedIndex_Free(idx);
+      return NULL;
+    }
+    InvertedIndex_SetLoadedBlocks(idx, blocks, size);
+    return idx;
+  }
 
   // If the data was encoded with a version that did not include the store numeric / store freqs
   // options - we force adding StoreFreqs.
@@ -31,15 +153,17 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
   }
   idx->lastId = RedisModule_LoadUnsigned(rdb);
   idx->numDocs = RedisModule_LoadUnsigned(rdb);
-  idx->size = RedisModule_LoadUnsigned(rdb);
-  idx->blocks = rm_calloc(idx->size, sizeof(IndexBlock));
+  uint32_t size = RedisModule_LoadUnsigned(rdb);
+  IndexBlock *blocks = rm_calloc(size, sizeof(IndexBlock));
 
   size_t actualSize = 0;
-  for (uint32_t i = 0; i < idx->size; i++) {
-    IndexBlock *blk = &idx->blocks[actualSize];
+  for (uint32_t i = 0; i < size; i++) {
+    IndexBlock *blk = &blocks[actualSize];
     blk->firstId = RedisModule_LoadUnsigned(rdb);
     blk->lastId = RedisModule_LoadUnsigned(rdb);
     blk->numEntries = RedisModule_LoadUnsigned(rdb);
+    // The frequencies of the stored entries are not known without decoding them
+    blk->maxFreq = UINT32_MAX;
     if (blk->numEntries > 0) {
       ++actualSize;
     }
@@ -57,54 +181,112 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       blk->buf.data = buf;
     }
   }
-  idx->size = actualSize;
-  if (idx->size == 0) {
-    InvertedIndex_AddBlock(idx, 0);
+  InvertedIndex_SetLoadedBlocks(idx, blocks, actualSize);
+  return idx;
+}
+
+void InvertedIndex_SetLoadedBlocks(InvertedIndex *idx, IndexBlock *blocks, uint32_t size) {
+  idx->blocks = blocks;
+  idx->size = size;
+  if (idx->size <= 1) {
+    // Indexes of a single block hold it inline (see InvertedIndex_InlineBlock)
+    IndexBlock *blocks = idx->blocks;
+    idx->blocks = InvertedIndex_InlineBlock(idx);
+    if (idx->size) {
+      idx->blocks[0] = blocks[0];
+    } else {
+      InvertedIndex_AddBlock(idx, 0);
+    }
+    rm_free(blocks);
   } else {
     idx->blocks = rm_realloc(idx->blocks, idx->size * sizeof(IndexBlock));
+    // Seal the blocks loaded in the record format as the writer would have, except for the last one
+    // which is still written to. Blocks saved sealed are kept as they are
+    for (uint32_t i = 0; i + 1 < idx->size; i++) {
+      IndexBlock_Seal(&idx->blocks[i], idx->flags);
+    }
   }
-  return idx;
 }
+/* The headers of the non empty blocks are saved first, as a single block index. Their data follows
+ * as it is held, sealed or not, concatenated and cut into chunks: small blocks are coalesced into a
+ * chunk, and a block of INVERTED_INDEX_SAVE_CHUNK bytes or more is saved from its own buffer. The
+ * blocks are neither converted nor copied to temporary buffers of their own, which would touch
+ * (and in the fork, copy) more pages */
 void InvertedIndex_RdbSave(RedisModuleIO *rdb, void *value) {
-
   InvertedIndex *idx = value;
   RedisModule_SaveUnsigned(rdb, idx->flags);
   RedisModule_SaveUnsigned(rdb, idx->lastId);
   RedisModule_SaveUnsigned(rdb, idx->numDocs);
-  uint32_t readSize = 0;
+
+  // Zeroed, so that the padding is saved as zeros
+  savedBlock *index = rm_calloc(MAX(idx->size, 1), sizeof(*index));
+  uint32_t n = 0;
   for (uint32_t i = 0; i < idx->size; i++) {
-    IndexBlock *blk = &idx->blocks[i];
+    const IndexBlock *blk = &idx->blocks[i];
     if (blk->numEntries == 0) {
       continue;
     }
-    ++readSize;
+    savedBlock *sb = &index[n++];
+    sb->firstId = blk->firstId;
+    sb->lastId = blk->lastId;
+    sb->len = IndexBlock_WarmLen(blk);
+    sb->numEntries = blk->numEntries;
+    sb->format = blk->flags & IndexBlock_SealedFlags;
+    if (idx->flags & Index_StoreNumeric) {
+      sb->min = blk->valueRange.min;
+      sb->max = blk->valueRange.max;
+    } else {
+      sb->maxFreq = blk->maxFreq;
+    }
   }
-  RedisModule_SaveUnsigned(rdb, readSize);
+  RedisModule_SaveStringBuffer(rdb, (const char *)index, n * sizeof(*index));
+  rm_free(index);
 
+  char *chunk = NULL;
+  size_t used = 0;
   for (uint32_t i = 0; i < idx->size; i++) {
-    IndexBlock *blk = &idx->blocks[i];
-    if (blk->numEntries == 0) {
+    if (idx->blocks[i].numEntries == 0) {
       continue;
     }
-    RedisModule_SaveUnsigned(rdb, blk->firstId);
-    RedisModule_SaveUnsigned(rdb, blk->lastId);
-    RedisModule_SaveUnsigned(rdb, blk->numEntries);
-    if (IndexBlock_DataLen(blk)) {
-      RedisModule_SaveStringBuffer(rdb, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    // cold blocks are saved inflated
+    IndexBlock warm;
+    const IndexBlock *blk = IndexBlock_Warm(&idx->blocks[i], &warm);
+    size_t len = IndexBlock_DataLen(blk);
+    if (used && (len >= INVERTED_INDEX_SAVE_CHUNK || used + len > INVERTED_INDEX_SAVE_CHUNK)) {
+      RedisModule_SaveStringBuffer(rdb, chunk, used);
+      used = 0;
+    }
+    if (len >= INVERTED_INDEX_SAVE_CHUNK) {
+      RedisModule_SaveStringBuffer(rdb, IndexBlock_DataBuf(blk), len);
     } else {
-      RedisModule_SaveStringBuffer(rdb, "", 0);
+      if (!chunk) {
+        chunk = rm_malloc(INVERTED_INDEX_SAVE_CHUNK);
+      }
+      memcpy(chunk + used, IndexBlock_DataBuf(blk), len);
+      used += len;
     }
+    IndexBlock_ReleaseWarm(&idx->blocks[i], &warm);
   }
+  if (used) {
+    RedisModule_SaveStringBuffer(rdb, chunk, used);
+  }
+  rm_free(chunk);
 }
 void InvertedIndex_Digest(RedisModuleDigest *digest, void *value) {
 }
 
 unsigned long InvertedIndex_MemUsage(const void *value) {
   const InvertedIndex *idx = value;
-  unsigned long ret = sizeof(InvertedIndex);
+  unsigned long ret =
+      InvertedIndex_HeaderSize(idx->flags) + sizeof(IndexBlock) + INDEX_BLOCK_INLINE_CAP;
+  if (!InvertedIndex_HasInlineBlock(idx)) {
+    ret += idx->size * sizeof(IndexBlock);
+  }
   for (size_t i = 0; i < idx->size; i++) {
-    ret += sizeof(IndexBlock);
-    ret += IndexBlock_DataLen(&idx->blocks[i]);
+    if (!(idx->blocks[i].flags & (IndexBlock_InlineData | IndexBlock_MappedData))) {
+      ret += IndexBlock_DataLen(&idx->blocks[i]);
+    }
+    ret += array_len(idx->blocks[i].skips) * sizeof(IndexBlockSkip);
   }
   return ret;
 }
@@ -170,12 +352,22 @@ void RedisSearchCtx_LockSpecRead(RedisSearchCtx *ctx) {
   // Assert that the pause value before we pause is valid.
   RedisModule_Assert(dictPauseRehashing(ctx->spec->keysDict));
   ctx->flags = RS_CTX_READONLY;
+  if (ctx->lockStats) {
+    ConcurrentYieldCtl_Start(ctx->lockStats);
+  }
 }
 
 void RedisSearchCtx_LockSpecWrite(RedisSearchCtx *ctx) {
   RedisModule_Assert(ctx->flags == RS_CTX_UNSET);
+  __atomic_add_fetch(&ctx->spec->writersWaiting, 1, __ATOMIC_RELAXED);
   pthread_rwlock_wrlock(&ctx->spec->rwlock);
+  __atomic_sub_fetch(&ctx->spec->writersWaiting, 1, __ATOMIC_RELAXED);
+  // invalidates the cached query replies, read without the lock
+  __atomic_add_fetch(&ctx->spec->revision, 1, __ATOMIC_RELEASE);
   ctx->flags = RS_CTX_READWRITE;
+  if (ctx->lockStats) {
+    ConcurrentYieldCtl_Start(ctx->lockStats);
+  }
 }
 
 // DOES NOT INCREMENT REF COUNT
@@ -206,6 +398,9 @@ void RedisSearchCtx_UnlockSpec(RedisSearchCtx *sctx) {
     // Assert that it was actually previously paused
     RedisModule_Assert(dictResumeRehashing(sctx->spec->keysDict));
   }
+  if (sctx->lockStats) {
+    ConcurrentYieldCtl_End(sctx->lockStats);
+  }
   pthread_rwlock_unlock(&sctx->spec->rwlock);
   sctx->flags = RS_CTX_UNSET;
 }
@@ -292,11 +487,9 @@ end:
   return idx;
 }
 
-IndexReader *Redis_OpenReader(RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
-                              int singleWordMode, t_fieldMask fieldMask, ConcurrentSearchCtx *csx,
-                              double weight) {
-
-  RedisModuleString *termKey = fmtRedisTermKey(ctx, term->str, term->len);
+/* Open a reader of `term` on the inverted index stored under `termKey`, taking ownership of the key */
+static IndexReader *openReader(RedisSearchCtx *ctx, RedisModuleString *termKey, RSQueryTerm *term,
+                               t_fieldMask fieldMask, ConcurrentSearchCtx *csx, double weight) {
   InvertedIndex *idx = NULL;
   RedisModuleKey *k = NULL;
   if (!ctx->spec->keysDict) {
@@ -340,6 +533,21 @@ err:
   return NULL;
 }
 
+IndexReader *Redis_OpenReader(RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
+                              int singleWordMode, t_fieldMask fieldMask, ConcurrentSearchCtx *csx,
+                              double weight) {
+  RedisModuleString *termKey = fmtRedisTermKey(ctx, term->str, term->len);
+  return openReader(ctx, termKey, term, fieldMask, csx, weight);
+}
+
+IndexReader *Redis_OpenFieldReader(RedisSearchCtx *ctx, RSQueryTerm *term, const FieldSpec *fs,
+                                   ConcurrentSearchCtx *csx, double weight) {
+  char fieldTerm[FIELD_TERM_BUFLEN(term->len)];
+  size_t len = IndexSpec_FormatFieldTerm(fieldTerm, fs, term->str, term->len);
+  RedisModuleString *termKey = fmtRedisTermKey(ctx, fieldTerm, len);
+  return openReader(ctx, termKey, term, FIELD_BIT(fs), csx, weight);
+}
+
 int Redis_ScanKeys(RedisModuleCtx *ctx, const char *prefix, ScanFunc f, void *opaque) {
   long long ptr = 0;
 
@@ -423,12 +631,14 @@ int Redis_DeleteKey(RedisModuleCtx *ctx, RedisModuleString *s) {
   return res;
 }
 
+// Unlinked, so that the values of large documents are freed in the background rather than while
+// the whole index is dropped
 int Redis_DeleteKeyC(RedisModuleCtx *ctx, char *cstr) {
   RedisModuleCallReply *rep;
   if (!isCrdt) {
-    rep = RedisModule_Call(ctx, "DEL", "c!", cstr);
+    rep = RedisModule_Call(ctx, "UNLINK", "c!", cstr);
   } else {
-    rep = RedisModule_Call(ctx, "DEL", "c", cstr);
+    rep = RedisModule_Call(ctx, "UNLINK", "c", cstr);
   }
   RedisModule_Assert(RedisModule_CallReplyType(rep) == REDISMODULE_REPLY_INTEGER);
   long long res = RedisModule_CallReplyInteger(rep);
@@ -21,6 +21,11 @@ IndexReader *Redis_OpenReader(RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *
                               int singleWordMode, t_fieldMask fieldMask, ConcurrentSearchCtx *csx,
                               double weight);
 
+/* Open a reader for a term on the postings of a SEPARATEPOSTINGS field, which hold only the
+ * documents having the term in that field */
+IndexReader *Redis_OpenFieldReader(RedisSearchCtx *ctx, RSQueryTerm *term, const FieldSpec *fs,
+                                   ConcurrentSearchCtx *csx, double weight);
+
 InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term, size_t len,
                                          int write, bool *outIsNew, RedisModuleKey **keyp);
 #define Redis_OpenInvertedIndex(ctx, term, len, isWrite, outIsNew) \
@@ -38,8 +43,10 @@ const char *Redis_SelectRandomTerm(RedisSearchCtx *ctx, size_t *tlen);
 #define SKIPINDEX_KEY_FORMAT "si:%s/%.*s"
 #define SCOREINDEX_KEY_FORMAT "ss:%s/%.*s"
 
-#define INVERTED_INDEX_ENCVER 1
+#define INVERTED_INDEX_ENCVER 2
 #define INVERTED_INDEX_NOFREQFLAG_VER 0
+// The blocks are saved as they are held, behind a block index (see InvertedIndex_RdbSave)
+#define INVERTED_INDEX_BLOCK_INDEX_VER 2
 
 typedef int (*ScanFunc)(RedisModuleCtx *ctx, RedisModuleString *keyName, void *opaque);
 
@@ -70,6 +77,10 @@ extern RedisModuleType *InvertedIndexType;
 void InvertedIndex_Free(void *idx);
 void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver);
 void InvertedIndex_RdbSave(RedisModuleIO *rdb, void *value);
+
+/* Hand the non empty blocks of a loaded index over to it, in the record format they are saved in.
+ * Takes ownership of the `blocks` array */
+void InvertedIndex_SetLoadedBlocks(InvertedIndex *idx, IndexBlock *blocks, uint32_t size);
 void InvertedIndex_Digest(RedisModuleDigest *digest, void *value);
 int InvertedIndex_RegisterType(RedisModuleCtx *ctx);
 unsigned long InvertedIndex_MemUsage(const void *value);
@@ -78,6 +78,7 @@ typedef enum {
   Document_HasOffsetVector = 0x08,
   Document_FailedToOpen = 0x10, // Document was failed to opened by a loader (might expired) but not yet marked as deleted.
                                 // This is an optimization to avoid attempting opening the document for loading. May be used UN-ATOMICALLY
+  Document_Replaced = 0x20,     // Document replaced an older version of itself, which had a smaller id
 } RSDocumentFlags;
 
 #define hasPayload(x) (x & Document_HasPayload)
@@ -115,10 +116,12 @@ typedef struct RSDocumentMetadata_s {
 
   uint16_t ref_count;
 
+  /* The hash of the indexed values of the document (see Document_IndexedHash), or 0 if unknown */
+  uint64_t indexedHash;
+
   struct RSSortingVector *sortVector;
   /* Offsets of all terms in the document (in bytes). Used by highlighter */
   struct RSByteOffsets *byteOffsets;
-  DLLIST2_node llnode;
 
   /* Optional user payload */
   RSPayload *payload;
@@ -232,6 +235,8 @@ typedef struct {
 typedef struct RSOffsetVector {
   char *data;
   uint32_t len;
+  // The vector is in the packed offsets format (see VVW_Pack)
+  uint8_t packed;
 } RSOffsetVector;
 
 /* RSOffsetIterator is an interface for iterating offset vectors of aggregate and token records */
@@ -396,6 +401,40 @@ typedef struct {
 typedef double (*RSScoringFunction)(const ScoringFunctionArgs *ctx, const RSIndexResult *res,
                                     const RSDocumentMetadata *dmd, double minScore);
 
+/* A batch of results to score at once, in structure-of-arrays form. Every result is a single
+ * record (a leaf), or an aggregate (RS_RESULT_AGGREGATE) of leaves. The leaves of result i are
+ * leafStart[i] up to leafStart[i + 1], in the order of the aggregate's children */
+typedef struct {
+  size_t numResults;
+  /* Per result: the document's score, length and highest term frequency */
+  const double *docScores;
+  const uint32_t *docLens;
+  const uint32_t *docMaxFreqs;
+  /* Per result: the slop of its terms, as returned by ScoringFunctionArgs.GetSlop */
+  const int *slops;
+  /* Per result: the weight of the aggregate, or 1 for a leaf */
+  const double *weights;
+  /* numResults + 1 offsets into the leaves */
+  const uint32_t *leafStart;
+
+  size_t numLeaves;
+  /* Per leaf: the result it belongs to, its type, weight and frequency */
+  const uint32_t *leafResults;
+  const RSResultType *leafTypes;
+  const double *leafWeights;
+  const double *freqs;
+  /* Per leaf: the IDF and the BM25 IDF of a term, 0 for other records */
+  const double *idfs;
+  const double *bm25Idfs;
+  /* Scratch space of numLeaves entries for the scoring function */
+  double *leafScores;
+} RSScoringBatch;
+
+/* RSBatchScoringFunction scores every result of a batch into `scores`, exactly as the scoring
+ * function it was registered for would score each of them */
+typedef void (*RSBatchScoringFunction)(const ScoringFunctionArgs *ctx, const RSScoringBatch *batch,
+                                       double minScore, double *scores);
+
 /* The extension registeration context, containing the callbacks avaliable to the extension for
  * registering query expanders and scorers. */
 typedef struct RSExtensionCtx {
@@ -403,6 +442,9 @@ typedef struct RSExtensionCtx {
                                  void *privdata);
   int (*RegisterQueryExpander)(const char *alias, RSQueryTokenExpander exp, RSFreeFunction ff,
                                void *privdata);
+  /* Register the batch version of a scoring function registered under `alias`. Optional: the
+   * results of scoring functions without one are scored one by one */
+  int (*RegisterBatchScoringFunction)(const char *alias, RSBatchScoringFunction func);
 } RSExtensionCtx;
 
 /* An extension initialization function  */
@@ -20,7 +20,6 @@
 #include "extension.h"
 #include "ext/default.h"
 #include <float.h>
-#include "rwlock.h"
 #include "fork_gc.h"
 #include "module.h"
 
@@ -31,6 +30,61 @@
  * we can cast it to (wrap it with) a strong reference and use it as such.
  */
 
+/* The read locks the calling thread holds on the specs through the API, and how many times each is
+ * held. The lock of a spec prefers its writers: a thread taking it again, for a second iterator,
+ * while a writer waits for it would wait for itself. So a thread only takes it on its first hold */
+typedef struct {
+  IndexSpec *sp;
+  size_t holds;
+} ApiReadHold;
+
+static __thread ApiReadHold *apiReadHolds_g = NULL;
+
+static ApiReadHold *apiFindReadHold(const IndexSpec *sp) {
+  for (size_t ii = 0; ii < array_len(apiReadHolds_g); ++ii) {
+    if (apiReadHolds_g[ii].sp == sp) {
+      return &apiReadHolds_g[ii];
+    }
+  }
+  return NULL;
+}
+
+static void apiLockSpecRead(RedisSearchCtx *sctx) {
+  ApiReadHold *hold = apiFindReadHold(sctx->spec);
+  if (hold) {
+    ++hold->holds;
+    sctx->flags = RS_CTX_READONLY;
+    return;
+  }
+  RedisSearchCtx_LockSpecRead(sctx);
+  ApiReadHold newHold = {.sp = sctx->spec, .holds = 1};
+  apiReadHolds_g = array_ensure_append_1(apiReadHolds_g, newHold);
+}
+
+static void apiLockSpecWrite(RedisSearchCtx *sctx) {
+  // as with the global lock of the API before, a thread cannot write an index it reads
+  RS_LOG_ASSERT(!apiFindReadHold(sctx->spec), "writing an index while iterating it");
+  RedisSearchCtx_LockSpecWrite(sctx);
+}
+
+static void apiUnlockSpec(RedisSearchCtx *sctx) {
+  ApiReadHold *hold = sctx->flags == RS_CTX_READONLY ? apiFindReadHold(sctx->spec) : NULL;
+  if (hold && --hold->holds) {
+    // the lock is released by the last hold, whichever it is
+    sctx->flags = RS_CTX_UNSET;
+    return;
+  }
+  if (hold) {
+    size_t ix = hold - apiReadHolds_g;
+    array_del_fast(apiReadHolds_g, ix);
+    if (!array_len(apiReadHolds_g)) {
+      array_free(apiReadHolds_g);
+      apiReadHolds_g = NULL;
+    }
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+}
+
 int RediSearch_GetCApiVersion() {
   return REDISEARCH_CAPI_VERSION;
 }
@@ -72,11 +126,13 @@ RefManager* RediSearch_CreateIndex(const char* name, const RSIndexOptions* optio
 }
 
 void RediSearch_DropIndex(RefManager* rm) {
-  RWLOCK_ACQUIRE_WRITE();
   StrongRef ref = {rm};
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, StrongRef_Get(ref));
+  // wait for the iterators and the writers of the index
+  apiLockSpecWrite(&sctx);
   StrongRef_Invalidate(ref);
+  apiUnlockSpec(&sctx);
   StrongRef_Release(ref);
-  RWLOCK_RELEASE();
 }
 
 char **RediSearch_IndexGetStopwords(RefManager* rm, size_t *size) {
@@ -117,8 +173,9 @@ int RediSearch_ValidateLanguage(const char *lang) {
 RSFieldID RediSearch_CreateField(RefManager* rm, const char* name, unsigned types,
                                  unsigned options) {
   RS_LOG_ASSERT(types, "types should not be RSFLDTYPE_DEFAULT");
-  RWLOCK_ACQUIRE_WRITE();
   IndexSpec *sp = __RefManager_Get_Object(rm);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecWrite(&sctx);
 
   // TODO: add a function which can take both path and name
   FieldSpec* fs = IndexSpec_CreateField(sp, name, NULL);
@@ -128,7 +185,7 @@ RSFieldID RediSearch_CreateField(RefManager* rm, const char* name, unsigned type
     numTypes++;
     int txtId = IndexSpec_CreateTextId(sp);
     if (txtId < 0) {
-      RWLOCK_RELEASE();
+      apiUnlockSpec(&sctx);
       return RSFIELD_INVALID;
     }
     fs->ftId = txtId;
@@ -180,13 +237,13 @@ RSFieldID RediSearch_CreateField(RefManager* rm, const char* name, unsigned type
     if (fs->types == INDEXFLD_T_FULLTEXT) {
       sp->suffixMask |= FIELD_BIT(fs);
       if (!sp->suffix) {
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
+        sp->suffix = NewSuffixArray();
         sp->flags |= Index_HasSuffixTrie;
       }
     }
   }
 
-  RWLOCK_RELEASE();
+  apiUnlockSpec(&sctx);
   return fs->index;
 }
 
@@ -248,8 +305,9 @@ void RediSearch_FreeDocument(RSDoc* doc) {
 }
 
 int RediSearch_DeleteDocument(RefManager* rm, const void* docKey, size_t len) {
-  RWLOCK_ACQUIRE_WRITE();
   IndexSpec* sp = __RefManager_Get_Object(rm);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecWrite(&sctx);
   int rc = REDISMODULE_OK;
   t_docId id = DocTable_GetId(&sp->docs, docKey, len);
   if (id == 0) {
@@ -259,14 +317,14 @@ int RediSearch_DeleteDocument(RefManager* rm, const void* docKey, size_t len) {
       // Delete returns true/false, not RM_{OK,ERR}
       sp->stats.numDocuments--;
       if (sp->gc) {
-        GCContext_OnDelete(sp->gc);
+        GCContext_OnDelete(sp->gc, id);
       }
     } else {
       rc = REDISMODULE_ERR;
     }
   }
 
-  RWLOCK_RELEASE();
+  apiUnlockSpec(&sctx);
   return rc;
 }
 
@@ -315,7 +373,8 @@ typedef struct {
 
 void RediSearch_AddDocDone(RSAddDocumentCtx* aCtx, RedisModuleCtx* ctx, void* err) {
   RSError* ourErr = err;
-  if (QueryError_HasError(&aCtx->status)) {
+  // only the first error of a batch is kept
+  if (QueryError_HasError(&aCtx->status) && !ourErr->hasErr) {
     if (ourErr->s) {
       *ourErr->s = rm_strdup(QueryError_GetError(&aCtx->status));
     }
@@ -324,8 +383,9 @@ void RediSearch_AddDocDone(RSAddDocumentCtx* aCtx, RedisModuleCtx* ctx, void* er
 }
 
 int RediSearch_IndexAddDocument(RefManager* rm, Document* d, int options, char** errs) {
-  RWLOCK_ACQUIRE_WRITE();
   IndexSpec* sp = __RefManager_Get_Object(rm);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecWrite(&sctx);
 
   RSError err = {.s = errs};
   QueryError status = {0};
@@ -334,12 +394,11 @@ int RediSearch_IndexAddDocument(RefManager* rm, Document* d, int options, char**
     if (status.detail) {
       QueryError_ClearError(&status);
     }
-    RWLOCK_RELEASE();
+    apiUnlockSpec(&sctx);
     return REDISMODULE_ERR;
   }
   aCtx->donecb = RediSearch_AddDocDone;
   aCtx->donecbData = &err;
-  RedisSearchCtx sctx = {.redisCtx = NULL, .spec = sp};
   int exists = !!DocTable_GetIdR(&sp->docs, d->docKey);
   if (exists) {
     if (options & REDISEARCH_ADD_REPLACE) {
@@ -349,7 +408,7 @@ int RediSearch_IndexAddDocument(RefManager* rm, Document* d, int options, char**
         *errs = rm_strdup("Document already exists");
       }
       AddDocumentCtx_Free(aCtx);
-      RWLOCK_RELEASE();
+      apiUnlockSpec(&sctx);
       return REDISMODULE_ERR;
     }
   }
@@ -359,7 +418,60 @@ int RediSearch_IndexAddDocument(RefManager* rm, Document* d, int options, char**
   AddDocumentCtx_Submit(aCtx, &sctx, options);
   rm_free(d);
 
-  RWLOCK_RELEASE();
+  apiUnlockSpec(&sctx);
+  return err.hasErr ? REDISMODULE_ERR : REDISMODULE_OK;
+}
+
+int RediSearch_IndexAddDocuments(RefManager* rm, Document** docs, size_t n, int options,
+                                 char** errs) {
+  IndexSpec* sp = __RefManager_Get_Object(rm);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecWrite(&sctx);
+
+  RSError err = {.s = errs};
+  RSAddDocumentCtx** aCtxs = array_new(RSAddDocumentCtx*, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    Document* d = docs[ii];
+    if (!(options & REDISEARCH_ADD_REPLACE) && DocTable_GetIdR(&sp->docs, d->docKey)) {
+      if (!err.hasErr) {
+        if (errs) {
+          *errs = rm_strdup("Document already exists");
+        }
+        err.hasErr = QUERY_EDOCEXISTS;
+      }
+      Document_Free(d);
+      continue;
+    }
+
+    QueryError status = {0};
+    RSAddDocumentCtx* aCtx = NewAddDocumentCtx(sp, d, &status);
+    if (aCtx == NULL) {
+      if (!err.hasErr) {
+        if (errs) {
+          *errs = rm_strdup(QueryError_GetError(&status));
+        }
+        err.hasErr = status.code;
+      }
+      QueryError_ClearError(&status);
+      Document_Free(d);
+      continue;
+    }
+    aCtx->donecb = RediSearch_AddDocDone;
+    aCtx->donecbData = &err;
+    aCtx->stateFlags |= ACTX_F_NOBLOCK;
+    aCtxs = array_append(aCtxs, aCtx);
+  }
+
+  // replacing documents which don't exist yet just adds them
+  AddDocumentCtx_SubmitBatch(aCtxs, array_len(aCtxs), &sctx,
+                             DOCUMENT_ADD_REPLACE | DOCUMENT_ADD_NOSAVE);
+  array_free(aCtxs);
+  // the contents of the documents were freed with their contexts
+  for (size_t ii = 0; ii < n; ++ii) {
+    rm_free(docs[ii]);
+  }
+
+  apiUnlockSpec(&sctx);
   return err.hasErr ? REDISMODULE_ERR : REDISMODULE_OK;
 }
 
@@ -550,6 +662,8 @@ typedef struct RS_ApiIter {
   double minscore;  // Used for scoring
   QueryAST qast;    // Used for string queries..
   IndexSpec* sp;
+  // holds the read lock of the index until the iterator is freed
+  RedisSearchCtx sctx;
 } RS_ApiIter;
 
 #define QUERY_INPUT_STRING 1
@@ -568,20 +682,18 @@ typedef struct {
 } QueryInput;
 
 static RS_ApiIter* handleIterCommon(IndexSpec* sp, QueryInput* input, char** error) {
-  // here we only take the read lock and we will free it when the iterator will be freed
-  RWLOCK_ACQUIRE_READ();
-  /* We might have multiple readers that reads from the index,
-   * Avoid rehashing the terms dictionary */
-  dictPauseRehashing(sp->keysDict);
-
-  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
   RSSearchOptions options = {0};
   QueryError status = {0};
   RSSearchOptions_Init(&options);
   RS_ApiIter* it = rm_calloc(1, sizeof(*it));
+  // here we only take the read lock of the index and we will free it when the iterator will be
+  // freed. It also pauses the rehashing of the terms dictionary
+  it->sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecRead(&it->sctx);
+  RedisSearchCtx *sctx = &it->sctx;
 
   if (input->qtype == QUERY_INPUT_STRING) {
-    if (QAST_Parse(&it->qast, &sctx, &options, input->u.s.qs, input->u.s.n, input->u.s.dialect, &status) !=
+    if (QAST_Parse(&it->qast, sctx, &options, input->u.s.qs, input->u.s.n, input->u.s.dialect, &status) !=
         REDISMODULE_OK) {
       goto end;
     }
@@ -592,11 +704,11 @@ static RS_ApiIter* handleIterCommon(IndexSpec* sp, QueryInput* input, char** err
   // set queryAST configuration parameters
   iteratorsConfig_init(&it->qast.config);
 
-  if (QAST_Expand(&it->qast, NULL, &options, &sctx, &status) != REDISMODULE_OK) {
+  if (QAST_Expand(&it->qast, NULL, &options, sctx, &status) != REDISMODULE_OK) {
     goto end;
   }
 
-  it->internal = QAST_Iterate(&it->qast, &options, &sctx, NULL, 0, &status);
+  it->internal = QAST_Iterate(&it->qast, &options, sctx, NULL, 0, &status);
   if (!it->internal) {
     goto end;
   }
@@ -672,6 +784,48 @@ const void* RediSearch_ResultsIteratorNext(RS_ApiIter* iter, RefManager* rm, siz
   return NULL;
 }
 
+size_t RediSearch_ResultsIteratorNextBatch(RS_ApiIter* iter, RefManager* rm, uint64_t* ids,
+                                           const char** keys, size_t* lens, size_t max) {
+  IndexSpec* sp = __RefManager_Get_Object(rm);
+  size_t n = 0;
+  while (n < max) {
+    size_t read = 0;
+    if (IndexIterator_ReadBatch(iter->internal, ids + n, max - n, &read) != INDEXREAD_OK) {
+      break;
+    }
+    // keep the documents still in the index, in place
+    for (size_t ii = n; ii < n + read; ++ii) {
+      t_docId docId = ids[ii];
+      if (!keys) {
+        if (DocTable_IsLive(&sp->docs, docId)) {
+          ids[n++] = docId;
+        }
+        continue;
+      }
+      const RSDocumentMetadata* md = DocTable_Borrow(&sp->docs, docId);
+      if (md == NULL) {
+        continue;
+      }
+      // the key outlives the reference, as documents aren't deleted while the iterator holds the
+      // read lock of the index
+      ids[n] = docId;
+      keys[n] = md->keyPtr;
+      if (lens) {
+        lens[n] = sdslen(md->keyPtr);
+      }
+      ++n;
+      DMD_Return(md);
+    }
+  }
+  return n;
+}
+
+const uint64_t* RediSearch_IndexLiveDocs(RefManager* rm, size_t* nwords) {
+  IndexSpec* sp = __RefManager_Get_Object(rm);
+  *nwords = sp->docs.liveDocsWords;
+  return sp->docs.liveDocs;
+}
+
 double RediSearch_ResultsIteratorGetScore(const RS_ApiIter* it) {
   return it->scorer(&it->scargs, it->res, it->lastmd, 0);
 }
@@ -687,11 +841,8 @@ void RediSearch_ResultsIteratorFree(RS_ApiIter* iter) {
   }
   QAST_Destroy(&iter->qast);
   DMD_Return(iter->lastmd);
-  if (iter->sp && iter->sp->keysDict) {
-    dictResumeRehashing(iter->sp->keysDict);
-  }
+  apiUnlockSpec(&iter->sctx);
   rm_free(iter);
-  RWLOCK_RELEASE();
 }
 
 void RediSearch_ResultsIteratorReset(RS_ApiIter* iter) {
@@ -836,11 +987,10 @@ int RediSearch_IndexInfo(RSIndex* rm, RSIdxInfo *info) {
     return REDISEARCH_ERR;
   }
 
-  RWLOCK_ACQUIRE_READ();
   IndexSpec *sp = __RefManager_Get_Object(rm);
-  /* We might have multiple readers that reads from the index,
-   * Avoid rehashing the terms dictionary */
-  dictPauseRehashing(sp->keysDict);
+  // read locking the index also pauses the rehashing of the terms dictionary
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  apiLockSpecRead(&sctx);
 
   info->gcPolicy = sp->gc ? GC_POLICY_FORK : GC_POLICY_NONE;
   if (sp->rule) {
@@ -860,8 +1010,8 @@ int RediSearch_IndexInfo(RSIndex* rm, RSIdxInfo *info) {
   info->numDocuments = sp->stats.numDocuments;
   info->maxDocId = sp->docs.maxDocId;
   info->docTableSize = sp->docs.memsize;
-  info->sortablesSize = sp->docs.sortablesSize;
-  info->docTrieSize = TrieMap_MemUsage(sp->docs.dim.tm);
+  info->sortablesSize = IndexSpec_SortablesSize(sp);
+  info->docTrieSize = DocIdMap_MemUsage(&sp->docs.dim);
   info->numTerms = sp->stats.numTerms;
   info->numRecords = sp->stats.numRecords;
   info->invertedSize = sp->stats.invertedSize;
@@ -883,8 +1033,7 @@ int RediSearch_IndexInfo(RSIndex* rm, RSIdxInfo *info) {
     info->lastRunTimeMs = gcStats.lastRunTimeMs;
   }
 
-  dictResumeRehashing(sp->keysDict);
-  RWLOCK_RELEASE();
+  apiUnlockSpec(&sctx);
 
   return REDISEARCH_OK;
 }
@@ -894,7 +1043,7 @@ size_t RediSearch_MemUsage(RSIndex* rm) {
   size_t res = 0;
   res += sp->docs.memsize;
   res += sp->docs.sortablesSize;
-  res += TrieMap_MemUsage(sp->docs.dim.tm);
+  res += DocIdMap_MemUsage(&sp->docs.dim);
   res += sp->stats.invertedSize;
   res += sp->stats.skipIndexesSize;
   res += sp->stats.scoreIndexesSize;
@@ -261,6 +261,15 @@ MODULE_API_FUNC(int, RediSearch_IndexAddDocument)(RSIndex* sp, RSDoc* d, int fla
 #define RediSearch_SpecAddDocument(sp, d) \
   RediSearch_IndexAddDocument(sp, d, REDISEARCH_ADD_REPLACE, NULL)
 
+/**
+ * Add several documents at once, as RediSearch_IndexAddDocument does for each of them in their
+ * order, but merging their terms so that each inverted index is written once per batch. This is
+ * much faster for a bulk load. The documents are consumed. If some of them can't be added, the
+ * others still are, REDISMODULE_ERR is returned and the first error is set in `errs`.
+ */
+MODULE_API_FUNC(int, RediSearch_IndexAddDocuments)
+(RSIndex* sp, RSDoc** docs, size_t n, int flags, char**);
+
 MODULE_API_FUNC(RSQNode*, RediSearch_CreateTokenNode)
 (RSIndex* sp, const char* fieldName, const char* token);
 
@@ -346,6 +355,26 @@ MODULE_API_FUNC(int, RediSearch_DocumentExists)
 MODULE_API_FUNC(const void*, RediSearch_ResultsIteratorNext)
 (RSResultsIterator* iter, RSIndex* sp, size_t* len);
 
+/**
+ * Read up to `max` next results at once, in their order, rather than one by one. An iterator read
+ * in batches is only read in batches until it is reset, and has no score.
+ * @param[out] ids the ids of the documents of the results
+ * @param[out] keys if not NULL, the keys of the documents, and `lens` their lengths. They remain
+ *  valid until the iterator is freed
+ * @return the number of results read, 0 once there are none
+ */
+MODULE_API_FUNC(size_t, RediSearch_ResultsIteratorNextBatch)
+(RSResultsIterator* iter, RSIndex* sp, uint64_t* ids, const char** keys, size_t* lens, size_t max);
+
+/**
+ * The bitmap of the ids of the documents in the index: bit `id % 64` of word `id / 64` is set if
+ * the document with that id is in the index. Documents are looked up in it without their
+ * metadata, to filter the ids read in batches for instance. It remains valid until a document is
+ * added to or deleted from the index.
+ * @param[out] nwords the number of words of the bitmap
+ */
+MODULE_API_FUNC(const uint64_t*, RediSearch_IndexLiveDocs)(RSIndex* sp, size_t* nwords);
+
 MODULE_API_FUNC(void, RediSearch_ResultsIteratorFree)(RSResultsIterator* iter);
 
 MODULE_API_FUNC(void, RediSearch_ResultsIteratorReset)(RSResultsIterator* iter);
@@ -390,6 +419,7 @@ MODULE_API_FUNC(void, RediSearch_IndexInfoFree)(RSIdxInfo *info);
   X(DocumentAddFieldNumber)          \
   X(DocumentAddFieldString)          \
   X(IndexAddDocument)                \
+  X(IndexAddDocuments)               \
   X(CreateTokenNode)                 \
   X(CreateNumericNode)               \
   X(CreatePrefixNode)                \
@@ -414,6 +444,8 @@ MODULE_API_FUNC(void, RediSearch_IndexInfoFree)(RSIdxInfo *info);
   X(QueryNodeGetFieldMask)           \
   X(GetResultsIterator)              \
   X(ResultsIteratorNext)             \
+  X(ResultsIteratorNextBatch)        \
+  X(IndexLiveDocs)                   \
   X(ResultsIteratorFree)             \
   X(ResultsIteratorReset)            \
   X(IterateQuery)                    \
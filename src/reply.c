@@ -19,7 +19,7 @@ typedef struct RedisModule_Reply_StackEntry StackEntry;
 //---------------------------------------------------------------------------------------------
 
 bool RedisModule_HasMap(RedisModule_Reply *reply) {
-  return _ReplyMap(reply->ctx);
+  return reply->recordOnly ? reply->resp3 : _ReplyMap(reply->ctx);
 }
 
 int RedisModule_Reply_LocalCount(RedisModule_Reply *reply) {
@@ -109,6 +109,149 @@ static inline void json_add_close(RedisModule_Reply *reply, const char *s) {}
 
 //---------------------------------------------------------------------------------------------
 
+static void _Record(RedisModule_Reply *reply, char type, const void *val, size_t len) {
+  if (!reply->recording) {
+    return;
+  }
+  reply->recording = array_append(reply->recording, type);
+  if (len) {
+    reply->recording = array_ensure_append_n(reply->recording, (const char *)val, len);
+  }
+}
+
+static void _RecordString(RedisModule_Reply *reply, char type, const char *val, size_t len) {
+  uint32_t n = len;
+  _Record(reply, type, &n, sizeof(n));
+  if (reply->recording && len) {
+    reply->recording = array_ensure_append_n(reply->recording, val, len);
+  }
+}
+
+// Returns the offset of the container length in the recording
+static size_t _RecordContainer(RedisModule_Reply *reply, int type) {
+  if (!reply->recording) {
+    return SIZE_MAX;
+  }
+  char rtype = type == REDISMODULE_REPLY_MAP ? REPLY_RECORD_MAP :
+               type == REDISMODULE_REPLY_SET ? REPLY_RECORD_SET : REPLY_RECORD_ARRAY;
+  uint32_t n = 0;
+  _Record(reply, rtype, &n, sizeof(n));
+  return array_len(reply->recording) - sizeof(n);
+}
+
+static void _ReplyLongLong(RedisModule_Reply *reply, long long val) {
+  RedisModule_ReplyWithLongLong(reply->ctx, val);
+  _Record(reply, REPLY_RECORD_LONGLONG, &val, sizeof(val));
+}
+
+static void _ReplyDouble(RedisModule_Reply *reply, double val) {
+  RedisModule_ReplyWithDouble(reply->ctx, val);
+  _Record(reply, REPLY_RECORD_DOUBLE, &val, sizeof(val));
+}
+
+static void _ReplySimpleString(RedisModule_Reply *reply, const char *val) {
+  RedisModule_ReplyWithSimpleString(reply->ctx, val);
+  _RecordString(reply, REPLY_RECORD_SIMPLE_STRING, val, strlen(val) + 1);
+}
+
+static void _ReplyStringBuffer(RedisModule_Reply *reply, const char *val, size_t len) {
+  RedisModule_ReplyWithStringBuffer(reply->ctx, val, len);
+  _RecordString(reply, REPLY_RECORD_STRING, val, len);
+}
+
+static void _ReplyString(RedisModule_Reply *reply, RedisModuleString *val) {
+  RedisModule_ReplyWithString(reply->ctx, val);
+  if (reply->recording) {
+    size_t len;
+    const char *p = RedisModule_StringPtrLen(val, &len);
+    _RecordString(reply, REPLY_RECORD_STRING, p, len);
+  }
+}
+
+static void _ReplyNull(RedisModule_Reply *reply) {
+  RedisModule_ReplyWithNull(reply->ctx);
+  _Record(reply, REPLY_RECORD_NULL, NULL, 0);
+}
+
+void RedisModule_Reply_Record(RedisModule_Reply *reply) {
+  if (!reply->recording) {
+    reply->recording = array_new(char, 256);
+  }
+}
+
+arrayof(char) RedisModule_Reply_TakeRecording(RedisModule_Reply *reply) {
+  arrayof(char) recording = reply->recording;
+  reply->recording = NULL;
+  return recording;
+}
+
+const char *RedisModule_Reply_ReadRecorded(const char *p, RedisModule_Reply_RecordedValue *v) {
+  *v = (RedisModule_Reply_RecordedValue){.type = *p++};
+  switch (v->type) {
+    case REPLY_RECORD_LONGLONG:
+      memcpy(&v->ll, p, sizeof(v->ll));
+      return p + sizeof(v->ll);
+    case REPLY_RECORD_DOUBLE:
+      memcpy(&v->d, p, sizeof(v->d));
+      return p + sizeof(v->d);
+    case REPLY_RECORD_NULL:
+      return p;
+    case REPLY_RECORD_SIMPLE_STRING:
+    case REPLY_RECORD_STRING:
+    case REPLY_RECORD_ERROR:
+      memcpy(&v->len, p, sizeof(v->len));
+      v->str = p + sizeof(v->len);
+      return v->str + v->len;
+    case REPLY_RECORD_ARRAY:
+    case REPLY_RECORD_MAP:
+    case REPLY_RECORD_SET:
+      memcpy(&v->len, p, sizeof(v->len));
+      return p + sizeof(v->len);
+    default:
+      RS_LOG_ASSERT(0, "corrupt reply recording");
+      return NULL;
+  }
+}
+
+void RedisModule_Reply_Replay(RedisModuleCtx *ctx, const char *recording, size_t len) {
+  const char *p = recording, *end = recording + len;
+  while (p < end) {
+    RedisModule_Reply_RecordedValue v;
+    p = RedisModule_Reply_ReadRecorded(p, &v);
+    switch (v.type) {
+      case REPLY_RECORD_LONGLONG:
+        RedisModule_ReplyWithLongLong(ctx, v.ll);
+        break;
+      case REPLY_RECORD_DOUBLE:
+        RedisModule_ReplyWithDouble(ctx, v.d);
+        break;
+      case REPLY_RECORD_SIMPLE_STRING:
+        RedisModule_ReplyWithSimpleString(ctx, v.str);
+        break;
+      case REPLY_RECORD_STRING:
+        RedisModule_ReplyWithStringBuffer(ctx, v.str, v.len);
+        break;
+      case REPLY_RECORD_ERROR:
+        RedisModule_ReplyWithError(ctx, v.str);
+        break;
+      case REPLY_RECORD_NULL:
+        RedisModule_ReplyWithNull(ctx);
+        break;
+      case REPLY_RECORD_ARRAY:
+        RedisModule_ReplyWithArray(ctx, v.len);
+        break;
+      case REPLY_RECORD_MAP:
+        RedisModule_ReplyWithMap(ctx, v.len / 2);
+        break;
+      case REPLY_RECORD_SET:
+        RedisModule_ReplyWithSet(ctx, v.len);
+        break;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------------------------
+
 RedisModule_Reply RedisModule_NewReply(RedisModuleCtx *ctx) {
 #ifdef REDISMODULE_REPLY_DEBUG
   RedisModule_Reply reply = { ctx, _ReplyMap(ctx) && _ReplySet(ctx), 0, NULL, NULL };
@@ -120,6 +263,14 @@ RedisModule_Reply RedisModule_NewReply(RedisModuleCtx *ctx) {
   return reply;
 }
 
+RedisModule_Reply RedisModule_NewRecordedReply(RedisModuleCtx *ctx, bool resp3) {
+  RedisModule_Reply reply = RedisModule_NewReply(ctx);
+  reply.resp3 = resp3;
+  reply.recordOnly = true;
+  RedisModule_Reply_Record(&reply);
+  return reply;
+}
+
 int RedisModule_EndReply(RedisModule_Reply *reply) {
   int n = reply->stack ? array_len(reply->stack) : -1;
   RS_LOG_ASSERT(!reply->stack || !array_len(reply->stack), "incomplete reply");
@@ -131,6 +282,10 @@ int RedisModule_EndReply(RedisModule_Reply *reply) {
     array_free(reply->json);
   }
 #endif
+  if (reply->recording) {
+    array_free(reply->recording);
+    reply->recording = NULL;
+  }
   reply->stack = 0;
   return REDISMODULE_OK;
 }
@@ -151,19 +306,28 @@ static void _RedisModule_Reply_Next(RedisModule_Reply *reply) {
   ++*count;
 }
 
-static void _RedisModule_Reply_Push(RedisModule_Reply *reply, int type) {
+static void _RedisModule_Reply_Push(RedisModule_Reply *reply, int type, int size) {
   StackEntry *e = array_ensure_tail(&reply->stack, StackEntry);
   e->count = 0;
   e->type = type;
+  e->size = size;
+  e->recorded = _RecordContainer(reply, type);
 }
 
+// Returns the number of values of the container, or -1 if its length was sent when it started
 static int _RedisModule_Reply_Pop(RedisModule_Reply *reply) {
   RS_LOG_ASSERT(reply->stack && array_len(reply->stack) > 0, "incomplete reply");
   if (reply->stack && array_len(reply->stack) > 0) {
     StackEntry *e = &array_tail(reply->stack);
     int count = e->count;
+    RS_LOG_ASSERT(e->size < 0 || e->size == count, "reply: container of the wrong size");
+    if (reply->recording && e->recorded != SIZE_MAX) {
+      uint32_t n = count;
+      memcpy(reply->recording + e->recorded, &n, sizeof(n));
+    }
+    int size = e->size;
     reply->stack = array_trimm_len(reply->stack, 1);
-    return count;
+    return size < 0 ? count : -1;
   } else {
     return reply->count;
   }
@@ -172,28 +336,28 @@ static int _RedisModule_Reply_Pop(RedisModule_Reply *reply) {
 //---------------------------------------------------------------------------------------------
 
 int RedisModule_Reply_LongLong(RedisModule_Reply *reply, long long val) {
-  RedisModule_ReplyWithLongLong(reply->ctx, val);
+  _ReplyLongLong(reply, val);
   json_add(reply, false, "%ld", val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_Reply_Double(RedisModule_Reply *reply, double val) {
-  RedisModule_ReplyWithDouble(reply->ctx, val);
+  _ReplyDouble(reply, val);
   json_add(reply, false, "%f", val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_Reply_SimpleString(RedisModule_Reply *reply, const char *val) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, val);
+  _ReplySimpleString(reply, val);
   json_add(reply, false, "\"%s\"", val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_Reply_StringBuffer(RedisModule_Reply *reply, const char *val, size_t len) {
-  RedisModule_ReplyWithStringBuffer(reply->ctx, val, len);
+  _ReplyStringBuffer(reply, val, len);
   json_add(reply, false, "\"%.*s\"", len, val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
@@ -204,7 +368,7 @@ int RedisModule_Reply_Stringf(RedisModule_Reply *reply, const char *fmt, ...) {
   va_start(args, fmt);
   char *p;
   rm_vasprintf(&p, fmt, args);
-  RedisModule_ReplyWithSimpleString(reply->ctx, p);
+  _ReplySimpleString(reply, p);
   json_add(reply, false, "\"%s\"", p);
   rm_free(p);
   _RedisModule_Reply_Next(reply);
@@ -213,7 +377,7 @@ int RedisModule_Reply_Stringf(RedisModule_Reply *reply, const char *fmt, ...) {
 }
 
 int RedisModule_Reply_String(RedisModule_Reply *reply, RedisModuleString *val) {
-  RedisModule_ReplyWithString(reply->ctx, val);
+  _ReplyString(reply, val);
 #ifdef REDISMODULE_REPLY_DEBUG
   size_t n;
   const char *p = RedisModule_StringPtrLen(val, &n);
@@ -224,7 +388,7 @@ int RedisModule_Reply_String(RedisModule_Reply *reply, RedisModuleString *val) {
 }
 
 int RedisModule_Reply_Null(RedisModule_Reply *reply) {
-  RedisModule_ReplyWithNull(reply->ctx);
+  _ReplyNull(reply);
   json_add(reply, false, "null");
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
@@ -232,6 +396,13 @@ int RedisModule_Reply_Null(RedisModule_Reply *reply) {
 
 int RedisModule_Reply_Error(RedisModule_Reply *reply, const char *error) {
   RedisModule_ReplyWithError(reply->ctx, error);
+  if (reply->recordOnly) {
+    _RecordString(reply, REPLY_RECORD_ERROR, error, strlen(error) + 1);
+  } else if (reply->recording) {
+    // errors are not recorded, a reply with an error is not replayed
+    array_free(reply->recording);
+    reply->recording = NULL;
+  }
   json_add(reply, false, "\"ERR: %s\"", error);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
@@ -255,7 +426,25 @@ int RedisModule_Reply_Map(RedisModule_Reply *reply) {
     type = REDISMODULE_REPLY_ARRAY;
   }
   _RedisModule_Reply_Next(reply);
-  _RedisModule_Reply_Push(reply, type);
+  _RedisModule_Reply_Push(reply, type, -1);
+  return REDISMODULE_OK;
+}
+
+int RedisModule_Reply_MapOfSize(RedisModule_Reply *reply, int npairs) {
+  RS_LOG_ASSERT(!RedisModule_Reply_LocalIsKey(reply), "reply: should not write a map as a key");
+
+  int type;
+  if (reply->resp3) {
+    RedisModule_ReplyWithMap(reply->ctx, npairs);
+    json_add(reply, true, "{ ");
+    type = REDISMODULE_REPLY_MAP;
+  } else {
+    RedisModule_ReplyWithArray(reply->ctx, npairs * 2);
+    json_add(reply, true, "[ ");
+    type = REDISMODULE_REPLY_ARRAY;
+  }
+  _RedisModule_Reply_Next(reply);
+  _RedisModule_Reply_Push(reply, type, npairs * 2);
   return REDISMODULE_OK;
 }
 
@@ -266,7 +455,9 @@ int RedisModule_Reply_MapEnd(RedisModule_Reply *reply) {
     json_add_close(reply, " ]");
   }
   int count = _RedisModule_Reply_Pop(reply);
-  if (reply->resp3) {
+  if (count < 0) {
+    // sent with the map
+  } else if (reply->resp3) {
     RedisModule_ReplySetMapLength(reply->ctx, count / 2);
   } else {
     RedisModule_ReplySetArrayLength(reply->ctx, count);
@@ -280,20 +471,33 @@ int RedisModule_Reply_Array(RedisModule_Reply *reply) {
   RedisModule_ReplyWithArray(reply->ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
   json_add(reply, true, "[ ");
   _RedisModule_Reply_Next(reply);
-  _RedisModule_Reply_Push(reply, REDISMODULE_REPLY_ARRAY);
+  _RedisModule_Reply_Push(reply, REDISMODULE_REPLY_ARRAY, -1);
+  return REDISMODULE_OK;
+}
+
+int RedisModule_Reply_ArrayOfSize(RedisModule_Reply *reply, int n) {
+  RS_LOG_ASSERT(!RedisModule_Reply_LocalIsKey(reply), "reply: should not write an array as a key");
+
+  RedisModule_ReplyWithArray(reply->ctx, n);
+  json_add(reply, true, "[ ");
+  _RedisModule_Reply_Next(reply);
+  _RedisModule_Reply_Push(reply, REDISMODULE_REPLY_ARRAY, n);
   return REDISMODULE_OK;
 }
 
 int RedisModule_Reply_ArrayEnd(RedisModule_Reply *reply) {
   json_add_close(reply, " ]");
   int count = _RedisModule_Reply_Pop(reply);
-  RedisModule_ReplySetArrayLength(reply->ctx, count);
+  if (count >= 0) {
+    RedisModule_ReplySetArrayLength(reply->ctx, count);
+  }
   return REDISMODULE_OK;
 }
 
 int RedisModule_Reply_EmptyArray(RedisModule_Reply *reply) {
   json_add(reply, false, "[]");
   RedisModule_ReplyWithArray(reply->ctx, 0);
+  _RecordContainer(reply, REDISMODULE_REPLY_ARRAY);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
@@ -310,7 +514,7 @@ int RedisModule_Reply_Set(RedisModule_Reply *reply) {
     type = REDISMODULE_REPLY_ARRAY;
   }
   _RedisModule_Reply_Next(reply);
-  _RedisModule_Reply_Push(reply, type);
+  _RedisModule_Reply_Push(reply, type, -1);
   return REDISMODULE_OK;
 }
 
@@ -332,31 +536,31 @@ int RedisModule_Reply_SetEnd(RedisModule_Reply *reply) {
 //---------------------------------------------------------------------------------------------
 
 int RedisModule_ReplyKV_LongLong(RedisModule_Reply *reply, const char *key, long long val) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
-  RedisModule_ReplyWithLongLong(reply->ctx, val);
+  _ReplyLongLong(reply, val);
   json_add(reply, false, "%ld", val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_ReplyKV_Double(RedisModule_Reply *reply, const char *key, double val) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
 #if 1
-  RedisModule_ReplyWithDouble(reply->ctx, val);
+  _ReplyDouble(reply, val);
 #else
   if (reply->resp3) {
     int c = fpclassify(val);
     if (c == FP_INFINITE) {
-      RedisModule_ReplyWithSimpleString(reply->ctx, "inf");
+      _ReplySimpleString(reply, "inf");
     } else if (c == FP_NAN) {
-      RedisModule_ReplyWithSimpleString(reply->ctx, "nan");
+      _ReplySimpleString(reply, "nan");
     } else {
-      RedisModule_ReplyWithDouble(reply->ctx, val);
+      _ReplyDouble(reply, val);
     }
   } else {
-    RedisModule_ReplyWithDouble(reply->ctx, val);
+    _ReplyDouble(reply, val);
   }
 #endif
   json_add(reply, false, "\"%s\"", key);
@@ -367,18 +571,18 @@ int RedisModule_ReplyKV_Double(RedisModule_Reply *reply, const char *key, double
 }
 
 int RedisModule_ReplyKV_SimpleString(RedisModule_Reply *reply, const char *key, const char *val) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
-  RedisModule_ReplyWithSimpleString(reply->ctx, val);
+  _ReplySimpleString(reply, val);
   json_add(reply, false, "\"%s\"", val);
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_ReplyKV_StringBuffer(RedisModule_Reply *reply, const char *key, const char *val, size_t len) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
-  RedisModule_ReplyWithStringBuffer(reply->ctx, val, len);
+  _ReplySimpleString(reply, key);
+  _ReplyStringBuffer(reply, val, len);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
   json_add(reply, false, "\"%.*s\"", len, val);
@@ -387,9 +591,9 @@ int RedisModule_ReplyKV_StringBuffer(RedisModule_Reply *reply, const char *key,
 }
 
 int RedisModule_ReplyKV_String(RedisModule_Reply *reply, const char *key, RedisModuleString *val) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
-  RedisModule_ReplyWithString(reply->ctx, val);
+  _ReplyString(reply, val);
   _RedisModule_Reply_Next(reply);
 
 #ifdef REDISMODULE_REPLY_DEBUG
@@ -402,17 +606,17 @@ int RedisModule_ReplyKV_String(RedisModule_Reply *reply, const char *key, RedisM
 }
 
 int RedisModule_ReplyKV_Null(RedisModule_Reply *reply, const char *key) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
-  RedisModule_ReplyWithNull(reply->ctx);
+  _ReplyNull(reply);
   json_add(reply, false, "null");
   _RedisModule_Reply_Next(reply);
   return REDISMODULE_OK;
 }
 
 int RedisModule_ReplyKV_Array(RedisModule_Reply *reply, const char *key) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
   
@@ -423,7 +627,7 @@ int RedisModule_ReplyKV_Array(RedisModule_Reply *reply, const char *key) {
 }
 
 int RedisModule_ReplyKV_Map(RedisModule_Reply *reply, const char *key) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
 
@@ -433,7 +637,7 @@ int RedisModule_ReplyKV_Map(RedisModule_Reply *reply, const char *key) {
 }
 
 int RedisModule_ReplyKV_Set(RedisModule_Reply *reply, const char *key) {
-  RedisModule_ReplyWithSimpleString(reply->ctx, key);
+  _ReplySimpleString(reply, key);
   json_add(reply, false, "\"%s\"", key);
   _RedisModule_Reply_Next(reply);
 
@@ -24,6 +24,8 @@ struct QueryError;
 struct RedisModule_Reply_StackEntry {
     int count;
     int type; // REDISMODULE_REPLY_ARRAY|MAP|SET
+    int size; // the number of values the container was sent with, -1 if it is set when it ends
+    size_t recorded; // offset of the length of the container in the recording
 };
 
 typedef struct RedisModule_Reply {
@@ -34,6 +36,8 @@ typedef struct RedisModule_Reply {
 #ifdef REDISMODULE_REPLY_DEBUG
   arrayof(char) json;
 #endif
+  arrayof(char) recording; // the reply sent so far, if it is recorded
+  bool recordOnly; // the reply is not sent to a client, see RedisModule_NewRecordedReply
 } RedisModule_Reply;
 
 //---------------------------------------------------------------------------------------------
@@ -42,6 +46,11 @@ bool RedisModule_HasMap(RedisModule_Reply *reply);
 int RedisModule_Reply_LocalCount(RedisModule_Reply *reply);
 
 RedisModule_Reply RedisModule_NewReply(RedisModuleCtx *ctx);
+
+/* A reply which is recorded only, for a context without a client to send it to (a thread safe
+ * context which is not of a blocked client), in RESP3 if `resp3`. Unlike a reply sent to a client,
+ * an error is recorded as well */
+RedisModule_Reply RedisModule_NewRecordedReply(RedisModuleCtx *ctx, bool resp3);
 int RedisModule_EndReply(RedisModule_Reply *reply);
 
 int RedisModule_Reply_LongLong(RedisModule_Reply *reply, long long val);
@@ -61,6 +70,13 @@ int RedisModule_Reply_Set(RedisModule_Reply *reply);
 int RedisModule_Reply_SetEnd(RedisModule_Reply *reply);
 int RedisModule_Reply_EmptyArray(RedisModule_Reply *reply);
 
+/* Like RedisModule_Reply_Array and RedisModule_Reply_Map, for a container whose length is known
+ * when it starts: its length is sent with it, rather than set once the container ends, sparing
+ * the postponed length. `npairs` counts the keys of the map, as RESP3 does. The container ends
+ * after as many values, with RedisModule_Reply_ArrayEnd or RedisModule_Reply_MapEnd */
+int RedisModule_Reply_ArrayOfSize(RedisModule_Reply *reply, int n);
+int RedisModule_Reply_MapOfSize(RedisModule_Reply *reply, int npairs);
+
 int RedisModule_ReplyKV_LongLong(RedisModule_Reply *reply, const char *key, long long val);
 int RedisModule_ReplyKV_Double(RedisModule_Reply *reply, const char *key, double val);
 int RedisModule_ReplyKV_SimpleString(RedisModule_Reply *reply, const char *key, const char *val);
@@ -72,6 +88,41 @@ int RedisModule_ReplyKV_Map(RedisModule_Reply *reply, const char *key);
 
 int RedisModule_ReplyKVorV_SimpleString(RedisModule_Reply *reply, const char *key, const char *val);
 
+/* Record the reply from here on, so it can be sent again with RedisModule_Reply_Replay. A reply
+ * holding an error is not recorded */
+void RedisModule_Reply_Record(RedisModule_Reply *reply);
+
+/* Take the recording of a complete reply (the caller frees it with array_free), or NULL if it
+ * was not recorded */
+arrayof(char) RedisModule_Reply_TakeRecording(RedisModule_Reply *reply);
+
+/* Send a recorded reply as is */
+void RedisModule_Reply_Replay(RedisModuleCtx *ctx, const char *recording, size_t len);
+
+// A recorded reply is a sequence of the values sent, each a type followed by the value. Strings
+// and containers start with their 32 bit length, a container length is set when it ends.
+#define REPLY_RECORD_LONGLONG 'i'
+#define REPLY_RECORD_DOUBLE 'd'
+#define REPLY_RECORD_SIMPLE_STRING '+'  // includes its terminating null
+#define REPLY_RECORD_STRING '$'
+#define REPLY_RECORD_ERROR '-'          // includes its terminating null
+#define REPLY_RECORD_NULL '_'
+#define REPLY_RECORD_ARRAY '*'
+#define REPLY_RECORD_MAP '%'            // the length counts both keys and values
+#define REPLY_RECORD_SET '~'
+
+typedef struct {
+  char type;    // one of REPLY_RECORD_*
+  long long ll;
+  double d;
+  const char *str;
+  uint32_t len; // of a string, or the number of values of a container
+} RedisModule_Reply_RecordedValue;
+
+/* Read the recorded value at `p`, returning the position of the next one. The values of a
+ * container follow it */
+const char *RedisModule_Reply_ReadRecorded(const char *p, RedisModule_Reply_RecordedValue *v);
+
 void print_reply(RedisModule_Reply *reply);
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,213 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "result_cache.h"
+#include "reply.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/dllist.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+struct ResultCache {
+  pthread_mutex_t lock;
+  TrieMap *entries;   // key => ResultEntry
+  DLLIST lru;         // the most recently used entry first
+  size_t size;
+  size_t memory;
+  uint64_t revision;  // the revision of the index the replies were sent at
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+};
+
+typedef struct {
+  DLLIST_node llnode;
+  char *key;
+  tm_len_t keylen;
+  size_t memory;
+  long long expires;  // monotonic time, in milliseconds
+  arrayof(char) reply;
+} ResultEntry;
+
+static long long monotonicMS() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+ResultCache *NewResultCache() {
+  ResultCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = NewTrieMap();
+  dllist_init(&cache->lru);
+  return cache;
+}
+
+static void resultEntry_Free(void *p) {
+  ResultEntry *e = p;
+  array_free(e->reply);
+  rm_free(e->key);
+  rm_free(e);
+}
+
+void ResultCache_Free(ResultCache *cache) {
+  TrieMap_Free(cache->entries, resultEntry_Free);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+arrayof(char) ResultCache_NewKey(int type, int protocol) {
+  arrayof(char) key = array_new(char, 64);
+  key = array_append(key, (char)type);
+  key = array_append(key, (char)protocol);
+  return key;
+}
+
+arrayof(char) ResultCache_AppendKeyArg(arrayof(char) key, const char *arg, size_t len) {
+  // length prefixed, so that the arguments can't be confused with one another
+  uint32_t n = len;
+  size_t nlen = sizeof(n);
+  key = array_ensure_append(key, (const char *)&n, nlen, char);
+  if (len) {
+    key = array_ensure_append(key, arg, len, char);
+  }
+  return key;
+}
+
+static void resultCache_Clear(ResultCache *cache) {
+  TrieMap_Free(cache->entries, resultEntry_Free);
+  cache->entries = NewTrieMap();
+  dllist_init(&cache->lru);
+  cache->size = 0;
+  cache->memory = 0;
+}
+
+static void resultCache_Delete(ResultCache *cache, ResultEntry *e) {
+  dllist_delete(&e->llnode);
+  cache->size--;
+  cache->memory -= e->memory;
+  // deleting the key frees the entry
+  char *key = e->key;
+  e->key = NULL;
+  TrieMap_Delete(cache->entries, key, e->keylen, resultEntry_Free);
+  rm_free(key);
+}
+
+/* Lock the cache, dropping its entries if they were sent at an older revision. Returns false if
+ * the revision is older than the cache's */
+static bool resultCache_Lock(ResultCache *cache, uint64_t revision) {
+  pthread_mutex_lock(&cache->lock);
+  if (cache->revision < revision) {
+    resultCache_Clear(cache);
+    cache->revision = revision;
+  }
+  return cache->revision == revision;
+}
+
+/* Lock the cache and find the live entry of a key, counting the hit or the miss. The caller
+ * unlocks the cache */
+static ResultEntry *resultCache_Find(ResultCache *cache, uint64_t revision, const char *key,
+                                     size_t keylen) {
+  ResultEntry *e = TRIEMAP_NOTFOUND;
+  if (resultCache_Lock(cache, revision)) {
+    e = TrieMap_Find(cache->entries, (char *)key, keylen);
+  }
+  if (e != TRIEMAP_NOTFOUND && e->expires <= monotonicMS()) {
+    resultCache_Delete(cache, e);
+    cache->evictions++;
+    e = TRIEMAP_NOTFOUND;
+  }
+  if (e != TRIEMAP_NOTFOUND) {
+    dllist_delete(&e->llnode);
+    dllist_prepend(&cache->lru, &e->llnode);
+    cache->hits++;
+    return e;
+  }
+  cache->misses++;
+  return NULL;
+}
+
+bool ResultCache_Reply(ResultCache *cache, uint64_t revision, const char *key, size_t keylen,
+                       RedisModuleCtx *ctx) {
+  if (keylen >= UINT16_MAX) {
+    return false;
+  }
+  ResultEntry *e = resultCache_Find(cache, revision, key, keylen);
+  if (e) {
+    RedisModule_Reply_Replay(ctx, e->reply, array_len(e->reply));
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return e != NULL;
+}
+
+arrayof(char) ResultCache_Get(ResultCache *cache, uint64_t revision, const char *key,
+                              size_t keylen) {
+  if (keylen >= UINT16_MAX) {
+    return NULL;
+  }
+  ResultEntry *e = resultCache_Find(cache, revision, key, keylen);
+  arrayof(char) reply = NULL;
+  if (e) {
+    reply = array_new(char, array_len(e->reply));
+    reply = array_ensure_append_n(reply, e->reply, array_len(e->reply));
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return reply;
+}
+
+void ResultCache_Put(ResultCache *cache, uint64_t revision, const char *key, size_t keylen,
+                     arrayof(char) reply, size_t maxMemory, long long ttl) {
+  size_t memory = sizeof(ResultEntry) + keylen + array_len(reply);
+  if (keylen >= UINT16_MAX || memory > maxMemory || ttl <= 0) {
+    array_free(reply);
+    return;
+  }
+  if (!resultCache_Lock(cache, revision)) {
+    // the index changed while the query was running
+    pthread_mutex_unlock(&cache->lock);
+    array_free(reply);
+    return;
+  }
+
+  ResultEntry *e = TrieMap_Find(cache->entries, (char *)key, keylen);
+  if (e != TRIEMAP_NOTFOUND) {
+    // sent concurrently
+    resultCache_Delete(cache, e);
+  }
+
+  e = rm_new(ResultEntry);
+  e->key = rm_malloc(keylen);
+  memcpy(e->key, key, keylen);
+  e->keylen = keylen;
+  e->memory = memory;
+  e->expires = monotonicMS() + ttl;
+  e->reply = reply;
+  TrieMap_Add(cache->entries, e->key, e->keylen, e, NULL);
+  dllist_prepend(&cache->lru, &e->llnode);
+  cache->size++;
+  cache->memory += memory;
+  while (cache->memory > maxMemory) {
+    resultCache_Delete(cache, DLLIST_ITEM(cache->lru.prev, ResultEntry, llnode));
+    cache->evictions++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+ResultCacheStats ResultCache_GetStats(ResultCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  ResultCacheStats stats = {
+      .hits = cache->hits,
+      .misses = cache->misses,
+      .evictions = cache->evictions,
+      .entries = cache->size,
+      .memory = cache->memory,
+  };
+  pthread_mutex_unlock(&cache->lock);
+  return stats;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redismodule.h"
+#include "util/arr.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An LRU cache of the replies to the most recent queries of an index, bounded by their memory and
+ * expiring after a TTL. A query is keyed by its command and arguments, so a hit replies without
+ * parsing or executing the query. Queries run concurrently in the worker threads, so the cache
+ * has a lock of its own.
+ *
+ * Every reply was sent at a revision of its index, a counter bumped whenever the index (or the
+ * configuration) is written to. Accessing the cache at a newer revision drops all of its
+ * entries */
+typedef struct ResultCache ResultCache;
+
+typedef struct {
+  size_t hits;
+  size_t misses;
+  size_t evictions; // entries dropped to make room, or expired
+  size_t entries;
+  size_t memory;    // bytes used by the entries
+} ResultCacheStats;
+
+ResultCache *NewResultCache();
+
+void ResultCache_Free(ResultCache *cache);
+
+/* Start the key of a query, given its command type and the protocol of its reply */
+arrayof(char) ResultCache_NewKey(int type, int protocol);
+
+/* Append an argument of the query to its key */
+arrayof(char) ResultCache_AppendKeyArg(arrayof(char) key, const char *arg, size_t len);
+
+/* Reply with the cached reply to the query key, sent at `revision`. Returns false, without
+ * replying, if it is not cached */
+bool ResultCache_Reply(ResultCache *cache, uint64_t revision, const char *key, size_t keylen,
+                       RedisModuleCtx *ctx);
+
+/* A copy of the cached reply to the query key, sent at `revision` (the caller frees it with
+ * array_free), or NULL if it is not cached. Lets the caller replay it without holding the cache */
+arrayof(char) ResultCache_Get(ResultCache *cache, uint64_t revision, const char *key,
+                              size_t keylen);
+
+/* Cache a reply recorded at `revision` (see RedisModule_Reply_Record) for `ttl` milliseconds,
+ * evicting the least recently used replies beyond `maxMemory` bytes. Takes ownership of `reply` */
+void ResultCache_Put(ResultCache *cache, uint64_t revision, const char *key, size_t keylen,
+                     arrayof(char) reply, size_t maxMemory, long long ttl);
+
+ResultCacheStats ResultCache_GetStats(ResultCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,12 @@
 #include "rmutil/cxx/chrono-clock.h"
 #include "util/timeout.h"
 #include "util/arr.h"
+#include "util/strconv.h"
+#include "tag_index.h"
+#include "util/workers.h"
+
+#include <math.h>
+#include <pthread.h>
 
 /*******************************************************************************************************************
  *  General Result Processor Helper functions
@@ -28,6 +34,22 @@ void QITR_Cleanup(QueryIterator *qitr) {
     }
     p = next;
   }
+  QITR_FreeArena(qitr);
+}
+
+#define QITR_ARENA_BLOCK_SIZE 16384
+
+void *QITR_Alloc(QueryIterator *it, size_t size) {
+  // keep the allocations aligned as those of the allocator
+  size = (size + 15) & ~(size_t)15;
+  void *p = BlkAlloc_Alloc(&it->arena, size, MAX(size, QITR_ARENA_BLOCK_SIZE));
+  memset(p, 0, size);
+  return p;
+}
+
+void QITR_FreeArena(QueryIterator *it) {
+  BlkAlloc_FreeAll(&it->arena, NULL, NULL, 0);
+  BlkAlloc_Init(&it->arena);
 }
 
 void SearchResult_Clear(SearchResult *r) {
@@ -55,6 +77,41 @@ void SearchResult_Destroy(SearchResult *r) {
   RLookupRow_Cleanup(&r->rowdata);
 }
 
+void SearchResultBatch_Init(SearchResultBatch *batch, size_t cap) {
+  batch->results = rm_calloc(cap, sizeof(*batch->results));
+  batch->len = 0;
+  batch->cap = cap;
+}
+
+void SearchResultBatch_Clear(SearchResultBatch *batch) {
+  for (size_t ii = 0; ii < batch->len; ++ii) {
+    SearchResult_Clear(&batch->results[ii]);
+  }
+  batch->len = 0;
+}
+
+void SearchResultBatch_Destroy(SearchResultBatch *batch) {
+  for (size_t ii = 0; ii < batch->cap; ++ii) {
+    SearchResult_Destroy(&batch->results[ii]);
+  }
+  rm_free(batch->results);
+  batch->results = NULL;
+  batch->len = batch->cap = 0;
+}
+
+int RP_NextBatch(ResultProcessor *rp, SearchResultBatch *batch) {
+  if (rp->NextBatch) {
+    return rp->NextBatch(rp, batch);
+  }
+  int rc = RS_RESULT_OK;
+  batch->len = 0;
+  while (batch->len < batch->cap &&
+         (rc = rp->Next(rp, &batch->results[batch->len])) == RS_RESULT_OK) {
+    batch->len++;
+  }
+  return rc;
+}
+
 
 /*******************************************************************************************************************
  *  Base Result Processor - this processor is the topmost processor of every processing chain.
@@ -78,50 +135,130 @@ typedef struct {
   IndexIterator *iiter;
   struct timespec timeout;  // milliseconds until timeout
   size_t timeoutLimiter;    // counter to limit number of calls to TimedOut_WithCounter()
+  // Set on the partitions of a parallel query (see RPParallel), and on resumed processors
+  RSIndexResult *first;     // read by seeking to the start of the partition, returned first
+  t_docId lastId;           // the last docid of the partition
+  t_docId lastRead;         // the last docid read from the iterator, to resume after
+  // The max docid of the spec when the iterators were first read. The documents added later are
+  // not returned, but for the new versions of the documents which were updated
+  t_docId snapshotId;
+  // The doc ids epoch of the spec when the iterators were first read. The ids they hold are no
+  // longer valid once the docid compaction bumps it
+  uint64_t docIdsEpoch;
+  bool started;
+  // Whether the read lock may be released between two results for the writers waiting on the spec
+  bool canYield;
+  // The documents looked up in the doc table, for FT.PROFILE
+  size_t docLookups;
 } RPIndexIterator;
 
-/* Next implementation */
-static int rpidxNext(ResultProcessor *base, SearchResult *res) {
+/* Lock the spec to resume reading the iterators. Returns false if the doc ids were renumbered
+ * since the iterators were last read, in which case they cannot be resumed */
+static bool rpidxLock(ResultProcessor *base) {
   RPIndexIterator *self = (RPIndexIterator *)base;
-  IndexIterator *it = self->iiter;
+  RedisSearchCtx *sctx = RP_SCTX(base);
+  RedisSearchCtx_LockSpecRead(sctx);
+  if (self->started && self->docIdsEpoch != sctx->spec->docIdsEpoch) {
+    return false;
+  }
+  // reopen the keys in the concurrent search context (iterators' validation)
+  ConcurrentSearchCtx_ReopenKeys(base->parent->conc);
+  return true;
+}
 
-  if (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == TIMED_OUT) {
-    return UnlockSpec_and_ReturnRPResult(base, RS_RESULT_TIMEDOUT);
+/* Set the error of a query whose iterators cannot be resumed, since the doc ids were renumbered
+ * while the spec was unlocked */
+static int rpidxRenumbered(ResultProcessor *base) {
+  QueryError_SetError(base->parent->err, QUERY_EGENERIC,
+                      "Index documents were renumbered while the query was reading them");
+  return RS_RESULT_ERROR;
+}
+
+/* Called with the spec locked, before reading the iterators.
+ * The query reads a snapshot of the index as of its first read: the documents added later get
+ * larger ids, and are not returned. The documents updated meanwhile are returned under their new
+ * id, as their old one is deleted, possibly once more if it was already returned. So the read lock
+ * can be released while the query runs, and
+ * the writers apply in between. The readers of the iterators resume where they were when the keys
+ * are reopened, and the numeric ranges they read are not freed before the query ends (see
+ * NumericRangeTree.epochs). The vector and geometry indexes have no such guarantees */
+static void rpidxStart(RPIndexIterator *self) {
+  if (!self->started) {
+    IndexSpec *sp = RP_SCTX(&self->base)->spec;
+    self->started = true;
+    self->docIdsEpoch = sp->docIdsEpoch;
+    self->snapshotId = sp->docs.maxDocId;
+    self->canYield = !(sp->flags & (Index_HasVecSim | Index_HasGeometry));
   }
+}
 
-  if (RP_SCTX(base)->flags == RS_CTX_UNSET) {
-    // If we need to read the iterators and we didn't lock the spec yet, lock it now
-    // and reopen the keys in the concurrent search context (iterators' validation)
-    RedisSearchCtx_LockSpecRead(RP_SCTX(base));
-    ConcurrentSearchCtx_ReopenKeys(base->parent->conc);
+/* Let the writers waiting on the spec in before reading the next result. Returns false if the
+ * iterators cannot be resumed */
+static bool rpidxYield(ResultProcessor *base) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  RedisSearchCtx *sctx = RP_SCTX(base);
+  if (self->docIdsEpoch != sctx->spec->docIdsEpoch) {
+    // a cursor resumed over renumbered doc ids
+    return false;
+  }
+  if (!self->canYield ||
+      !__atomic_load_n(&sctx->spec->writersWaiting, __ATOMIC_RELAXED)) {
+    return true;
   }
+  // the lock prefers writers, the waiting ones take it before we get it back
+  RedisSearchCtx_UnlockSpec(sctx);
+  if (sctx->lockStats) {
+    sctx->lockStats->numYields++;
+  }
+  return rpidxLock(base);
+}
 
+/* Read the next valid result of the iterator into `res` */
+static inline int rpidxRead(ResultProcessor *base, SearchResult *res) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  IndexIterator *it = self->iiter;
   RSIndexResult *r;
   const RSDocumentMetadata *dmd;
   int rc;
 
   // Read from the root filter until we have a valid result
   while (1) {
-    rc = it->Read(it->ctx, &r);
+    if (self->first) {
+      r = self->first;
+      self->first = NULL;
+      rc = INDEXREAD_OK;
+    } else {
+      rc = it->Read(it->ctx, &r);
+    }
     // This means we are done!
     switch (rc) {
     case INDEXREAD_EOF:
-      return UnlockSpec_and_ReturnRPResult(base, RS_RESULT_EOF);
+      return RS_RESULT_EOF;
     case INDEXREAD_TIMEOUT:
-      return UnlockSpec_and_ReturnRPResult(base, RS_RESULT_TIMEDOUT);
+      return RS_RESULT_TIMEDOUT;
     case INDEXREAD_NOTFOUND:
       continue;
     default: // INDEXREAD_OK
       if (!r)
         continue;
     }
+    self->lastRead = r->docId;
+    if (r->docId > self->lastId) {
+      return RS_RESULT_EOF;
+    }
 
     if (r->dmd) {
       dmd = r->dmd;
     } else {
+      // skip deleted documents without looking them up
+      if (!DocTable_IsLive(&RP_SPEC(base)->docs, r->docId)) {
+        continue;
+      }
       dmd = DocTable_Borrow(&RP_SPEC(base)->docs, r->docId);
+      self->docLookups++;
     }
-    if (!dmd || (dmd->flags & Document_Deleted)) {
+    if (!dmd || (dmd->flags & Document_Deleted) ||
+        (r->docId > self->snapshotId && !(dmd->flags & Document_Replaced))) {
       DMD_Return(dmd);
       continue;
     }
@@ -152,15 +289,213 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   return RS_RESULT_OK;
 }
 
+/* Next implementation */
+static int rpidxNext(ResultProcessor *base, SearchResult *res) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+
+  if (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == TIMED_OUT) {
+    return UnlockSpec_and_ReturnRPResult(base, RS_RESULT_TIMEDOUT);
+  }
+
+  if (RP_SCTX(base)->flags == RS_CTX_UNSET) {
+    // If we need to read the iterators and we didn't lock the spec yet, lock it now
+    if (!rpidxLock(base)) {
+      return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+    }
+  } else if (self->started && !rpidxYield(base)) {
+    return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+  }
+  rpidxStart(self);
+
+  int rc = rpidxRead(base, res);
+  if (rc != RS_RESULT_OK) {
+    return UnlockSpec_and_ReturnRPResult(base, rc);
+  }
+  return rc;
+}
+
+static int rpidxNextBatch(ResultProcessor *base, SearchResultBatch *batch) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  batch->len = 0;
+
+  if (RP_SCTX(base)->flags == RS_CTX_UNSET) {
+    if (!rpidxLock(base)) {
+      return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+    }
+  } else if (self->started && !rpidxYield(base)) {
+    return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+  }
+  rpidxStart(self);
+
+  int rc = RS_RESULT_OK;
+  while (batch->len < batch->cap) {
+    if (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == TIMED_OUT) {
+      rc = RS_RESULT_TIMEDOUT;
+      break;
+    }
+    if ((rc = rpidxRead(base, &batch->results[batch->len])) != RS_RESULT_OK) {
+      break;
+    }
+    batch->len++;
+  }
+  if (rc != RS_RESULT_OK) {
+    return UnlockSpec_and_ReturnRPResult(base, rc);
+  }
+  return rc;
+}
+
+// The docids read at once when counting the results of the iterators
+#define COUNT_BATCH_SIZE 1024
+// The documents of a single index are counted by looking up its deleted documents in it when
+// there are fewer than this fraction of its documents
+#define COUNT_SEEK_DEAD_RATIO 16
+
+/* Count the documents of the index read by `ir`: those the index holds, less the deleted ones
+ * which remain in it until they are garbage collected. The reader is at the start of the index */
+static int rpidxCountIndex(RPIndexIterator *self, IndexReader *ir, size_t *count) {
+  const DocTable *dt = &RP_SPEC(&self->base)->docs;
+  RSIndexResult *hit = NULL;
+  size_t dead = 0;
+  t_docId at = 0;  // the id the reader is at
+  for (t_docId id = DocTable_NextDead(dt, 1); id && id <= self->lastId;
+       id = DocTable_NextDead(dt, id + 1)) {
+    if (id > at) {
+      int rc = IR_SkipTo(ir, id, &hit);
+      if (rc == INDEXREAD_EOF) {
+        break;
+      }
+      at = rc == INDEXREAD_OK ? id : hit->docId;
+    }
+    dead += at == id;
+  }
+  *count = ir->idx->numDocs - dead;
+  return RS_RESULT_EOF;
+}
+
+/* Count the live documents of the docids read from the iterators */
+static int rpidxCountBatches(RPIndexIterator *self, size_t *count) {
+  t_docId ids[COUNT_BATCH_SIZE];
+  size_t n;
+  while (1) {
+    if (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == TIMED_OUT) {
+      return RS_RESULT_TIMEDOUT;
+    }
+    if (!rpidxYield(&self->base)) {
+      return rpidxRenumbered(&self->base);
+    }
+    int rc = IndexIterator_ReadBatch(self->iiter, ids, COUNT_BATCH_SIZE, &n);
+    if (rc == INDEXREAD_TIMEOUT) {
+      return RS_RESULT_TIMEDOUT;
+    } else if (rc != INDEXREAD_OK) {
+      return RS_RESULT_EOF;
+    }
+    const DocTable *dt = &RP_SPEC(&self->base)->docs;
+    for (size_t i = 0; i < n; ++i) {
+      if (ids[i] > self->lastId) {
+        return RS_RESULT_EOF;
+      }
+      if (ids[i] > self->snapshotId && DocTable_IsLive(dt, ids[i])) {
+        const RSDocumentMetadata *dmd = DocTable_Borrow(dt, ids[i]);
+        *count += dmd && (dmd->flags & Document_Replaced);
+        DMD_Return(dmd);
+        continue;
+      }
+      *count += DocTable_IsLive(dt, ids[i]);
+    }
+  }
+}
+
+/* Count implementation. The docids are counted without looking up the documents, and a single
+ * index is counted without reading it when few of its documents were deleted */
+static int rpidxCount(ResultProcessor *base, size_t *count) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  *count = 0;
+
+  if (RP_SCTX(base)->flags == RS_CTX_UNSET) {
+    if (!rpidxLock(base)) {
+      return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+    }
+  } else if (self->started && !rpidxYield(base)) {
+    return UnlockSpec_and_ReturnRPResult(base, rpidxRenumbered(base));
+  }
+  bool atStart = !self->started;
+  rpidxStart(self);
+
+  int rc = RS_RESULT_OK;
+  IndexIterator *it = self->iiter;
+  if (isTrimming && RedisModule_ShardingGetKeySlot) {
+    // the documents of the slots being trimmed are told apart by their keys
+    SearchResult res = {0};
+    while (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == NOT_TIMED_OUT &&
+           (rc = rpidxRead(base, &res)) == RS_RESULT_OK) {
+      ++*count;
+      SearchResult_Clear(&res);
+    }
+    SearchResult_Destroy(&res);
+    if (rc == RS_RESULT_OK) {
+      rc = RS_RESULT_TIMEDOUT;
+    }
+    return UnlockSpec_and_ReturnRPResult(base, rc);
+  }
+
+  if (atStart && it->type == READ_ITERATOR && IR_ReadsWholeIndex(it->ctx) &&
+      DocTable_NumDead(&RP_SPEC(base)->docs) <
+          ((IndexReader *)it->ctx)->idx->numDocs / COUNT_SEEK_DEAD_RATIO) {
+    rc = rpidxCountIndex(self, it->ctx, count);
+  } else {
+    rc = rpidxCountBatches(self, count);
+  }
+  base->parent->totalResults += *count;
+  return UnlockSpec_and_ReturnRPResult(base, rc);
+}
+
+/* Next implementation for the partitions of a parallel query, read while their RPParallel holds
+ * the spec locked */
+static int rpidxNextPartition(ResultProcessor *base, SearchResult *res) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+
+  if (TimedOut_WithCounter(&self->timeout, &self->timeoutLimiter) == TIMED_OUT) {
+    return RS_RESULT_TIMEDOUT;
+  }
+  return rpidxRead(base, res);
+}
+
 static void rpidxFree(ResultProcessor *iter) {
   rm_free(iter);
 }
 
+void RPIndexIterator_Resume(ResultProcessor *base, IndexIterator *it) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  self->iiter = it;
+  self->first = NULL;
+  if (!it) {
+    return;
+  }
+  // the docids read before belong to another numbering of the documents, the next read fails
+  if (self->started && self->docIdsEpoch != RP_SPEC(base)->docIdsEpoch) {
+    return;
+  }
+  RSIndexResult *hit = NULL;
+  switch (it->SkipTo(it->ctx, self->lastRead + 1, &hit)) {
+    case INDEXREAD_OK:
+    case INDEXREAD_NOTFOUND:
+      // the iterator stopped on the next result it has
+      self->first = hit;
+      break;
+    default:
+      self->lastId = 0;
+      break;
+  }
+}
+
 ResultProcessor *RPIndexIterator_New(IndexIterator *root, struct timespec timeout) {
   RPIndexIterator *ret = rm_calloc(1, sizeof(*ret));
   ret->iiter = root;
   ret->timeout = timeout;
+  ret->lastId = DOCID_MAX;
   ret->base.Next = rpidxNext;
+  ret->base.NextBatch = rpidxNextBatch;
+  ret->base.Count = rpidxCount;
   ret->base.Free = rpidxFree;
   ret->base.type = RP_INDEX;
   return &ret->base;
@@ -197,6 +532,7 @@ void QITR_FreeChain(QueryIterator *qitr) {
     rp->Free(rp);
     rp = next;
   }
+  QITR_FreeArena(qitr);
 }
 
 /*******************************************************************************************************************
@@ -207,11 +543,45 @@ void QITR_FreeChain(QueryIterator *qitr) {
  * It may not be invoked if we are working in SORTBY mode (or later on in aggregations)
  *******************************************************************************************************************/
 
+// The number of results a scorer with a batch scoring function reads ahead and scores at once
+#define SCORER_BATCH_SIZE 64
+
+/* The arrays of an RSScoringBatch, filled as the results are read ahead */
+typedef struct {
+  double docScores[SCORER_BATCH_SIZE];
+  uint32_t docLens[SCORER_BATCH_SIZE];
+  uint32_t docMaxFreqs[SCORER_BATCH_SIZE];
+  int slops[SCORER_BATCH_SIZE];
+  double weights[SCORER_BATCH_SIZE];
+  uint32_t leafStart[SCORER_BATCH_SIZE + 1];
+  double scores[SCORER_BATCH_SIZE];
+  // Set if the result could not be batched, and was scored on its own
+  bool scored[SCORER_BATCH_SIZE];
+
+  arrayof(uint32_t) leafResults;
+  arrayof(RSResultType) leafTypes;
+  arrayof(double) leafWeights;
+  arrayof(double) freqs;
+  arrayof(double) idfs;
+  arrayof(double) bm25Idfs;
+  arrayof(double) leafScores;
+} ScorerBatch;
+
 typedef struct {
   ResultProcessor base;
   RSScoringFunction scorer;
   RSFreeFunction scorerFree;
   ScoringFunctionArgs scorerCtx;
+
+  // Set if the results are scored in batches
+  RSBatchScoringFunction batchScorer;
+  ScorerBatch *batch;
+  // The results read ahead, yielded from `pos` on once scored
+  SearchResult pending[SCORER_BATCH_SIZE];
+  size_t numPending;
+  size_t pos;
+  // The status upstream stopped with, returned once the pending results were yielded
+  int upstreamRC;
 } RPScorer;
 
 static int rpscoreNext(ResultProcessor *base, SearchResult *res) {
@@ -246,6 +616,125 @@ static int rpscoreNext(ResultProcessor *base, SearchResult *res) {
   return rc;
 }
 
+static void scorerBatch_AddLeaf(ScorerBatch *b, size_t i, const RSIndexResult *r) {
+  const RSQueryTerm *term = r->type == RSResultType_Term ? r->term.term : NULL;
+  array_append(b->leafResults, i);
+  array_append(b->leafTypes, r->type);
+  array_append(b->leafWeights, r->weight);
+  array_append(b->freqs, (double)r->freq);
+  array_append(b->idfs, term ? term->idf : 0);
+  array_append(b->bm25Idfs, term ? term->bm25_idf : 0);
+}
+
+/* Add the i-th pending result to the batch. Results which are not a leaf or an aggregate of
+ * leaves are scored right away instead */
+static void rpscoreBatchAdd(RPScorer *self, size_t i) {
+  ScorerBatch *b = self->batch;
+  SearchResult *res = &self->pending[i];
+  const RSIndexResult *r = res->indexResult;
+  const RSDocumentMetadata *dmd = res->dmd;
+
+  b->leafStart[i] = array_len(b->leafTypes);
+  b->scored[i] = false;
+  if (r->type & RS_RESULT_AGGREGATE) {
+    for (int c = 0; c < r->agg.numChildren; c++) {
+      if (r->agg.children[c]->type & RS_RESULT_AGGREGATE) {
+        res->score = self->scorer(&self->scorerCtx, r, dmd, self->base.parent->minScore);
+        b->scored[i] = true;
+        return;
+      }
+    }
+    for (int c = 0; c < r->agg.numChildren; c++) {
+      scorerBatch_AddLeaf(b, i, r->agg.children[c]);
+    }
+    b->weights[i] = r->weight;
+  } else {
+    scorerBatch_AddLeaf(b, i, r);
+    b->weights[i] = 1;
+  }
+  b->docScores[i] = dmd->score;
+  b->docLens[i] = dmd->len;
+  b->docMaxFreqs[i] = dmd->maxFreq;
+  b->slops[i] = self->scorerCtx.GetSlop(r);
+}
+
+/* Score the pending results at once */
+static void rpscoreBatchScore(RPScorer *self) {
+  ScorerBatch *b = self->batch;
+  b->leafStart[self->numPending] = array_len(b->leafTypes);
+  b->leafScores = array_ensure_len(b->leafScores, array_len(b->leafTypes));
+  RSScoringBatch batch = {
+      .numResults = self->numPending,
+      .docScores = b->docScores,
+      .docLens = b->docLens,
+      .docMaxFreqs = b->docMaxFreqs,
+      .slops = b->slops,
+      .weights = b->weights,
+      .leafStart = b->leafStart,
+      .numLeaves = array_len(b->leafTypes),
+      .leafResults = b->leafResults,
+      .leafTypes = b->leafTypes,
+      .leafWeights = b->leafWeights,
+      .freqs = b->freqs,
+      .idfs = b->idfs,
+      .bm25Idfs = b->bm25Idfs,
+      .leafScores = b->leafScores,
+  };
+  self->batchScorer(&self->scorerCtx, &batch, self->base.parent->minScore, b->scores);
+  for (size_t i = 0; i < self->numPending; i++) {
+    if (!b->scored[i]) {
+      self->pending[i].score = b->scores[i];
+    }
+  }
+
+  array_clear(b->leafResults);
+  array_clear(b->leafTypes);
+  array_clear(b->leafWeights);
+  array_clear(b->freqs);
+  array_clear(b->idfs);
+  array_clear(b->bm25Idfs);
+}
+
+/* Next for a scorer with a batch scoring function. Reads ahead a batch of results from upstream,
+ * scores them at once and yields them one by one */
+static int rpscoreNextBatch(ResultProcessor *base, SearchResult *res) {
+  RPScorer *self = (RPScorer *)base;
+
+  while (1) {
+    while (self->pos < self->numPending) {
+      SearchResult *r = &self->pending[self->pos++];
+      // The index result is overwritten by the reads ahead
+      r->indexResult = NULL;
+      if (r->score == RS_SCORE_FILTEROUT) {
+        base->parent->totalResults--;
+        SearchResult_Clear(r);
+        continue;
+      }
+      // Hand over the result, and keep the (cleared) one we were given to read into
+      SearchResult tmp = *res;
+      *res = *r;
+      *r = tmp;
+      return RS_RESULT_OK;
+    }
+    if (self->upstreamRC != RS_RESULT_OK) {
+      return self->upstreamRC;
+    }
+
+    self->numPending = self->pos = 0;
+    while (self->numPending < SCORER_BATCH_SIZE) {
+      int rc = base->upstream->Next(base->upstream, &self->pending[self->numPending]);
+      if (rc != RS_RESULT_OK) {
+        self->upstreamRC = rc;
+        break;
+      }
+      rpscoreBatchAdd(self, self->numPending++);
+    }
+    if (self->numPending) {
+      rpscoreBatchScore(self);
+    }
+  }
+}
+
 /* Free impl. for scorer - frees up the scorer privdata if needed */
 static void rpscoreFree(ResultProcessor *rp) {
   RPScorer *self = (RPScorer *)rp;
@@ -254,13 +743,27 @@ static void rpscoreFree(ResultProcessor *rp) {
   }
   rm_free(self->scorerCtx.scrExp);
   self->scorerCtx.scrExp = NULL;
+  if (self->batch) {
+    for (size_t i = 0; i < SCORER_BATCH_SIZE; i++) {
+      SearchResult_Destroy(&self->pending[i]);
+    }
+    ScorerBatch *b = self->batch;
+    array_free(b->leafResults);
+    array_free(b->leafTypes);
+    array_free(b->leafWeights);
+    array_free(b->freqs);
+    array_free(b->idfs);
+    array_free(b->bm25Idfs);
+    array_free(b->leafScores);
+    rm_free(b);
+  }
   rm_free(self);
 }
 
 /* Create a new scorer by name. If the name is not found in the scorer registry, we use the defalt
  * scorer */
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
-                              const ScoringFunctionArgs *fnargs) {
+                              const ScoringFunctionArgs *fnargs, int batch) {
   RPScorer *ret = rm_calloc(1, sizeof(*ret));
   ret->scorer = funcs->sf;
   ret->scorerFree = funcs->ff;
@@ -268,6 +771,22 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
   ret->base.Next = rpscoreNext;
   ret->base.Free = rpscoreFree;
   ret->base.type = RP_SCORER;
+
+  // Explanations are built by the scoring function itself, one result at a time
+  if (batch && funcs->bsf && !fnargs->scrExp) {
+    ret->batchScorer = funcs->bsf;
+    ret->batch = rm_calloc(1, sizeof(*ret->batch));
+    ScorerBatch *b = ret->batch;
+    b->leafResults = array_new(uint32_t, SCORER_BATCH_SIZE);
+    b->leafTypes = array_new(RSResultType, SCORER_BATCH_SIZE);
+    b->leafWeights = array_new(double, SCORER_BATCH_SIZE);
+    b->freqs = array_new(double, SCORER_BATCH_SIZE);
+    b->idfs = array_new(double, SCORER_BATCH_SIZE);
+    b->bm25Idfs = array_new(double, SCORER_BATCH_SIZE);
+    b->leafScores = array_new(double, SCORER_BATCH_SIZE);
+    ret->upstreamRC = RS_RESULT_OK;
+    ret->base.Next = rpscoreNextBatch;
+  }
   return &ret->base;
 }
 
@@ -321,7 +840,7 @@ ResultProcessor *RPMetricsLoader_New() {
  * maintains a heap of the top N results.
  *
  * Since we need it to be thread safe, every result that's put on the heap is copied, including its
- * index result tree.
+ * index result tree. The results of the heap are allocated from the arena of the query iterator.
  *
  * This means that from here down-stream, everything is thread safe, but we also need to properly
  * free discarded results.
@@ -331,6 +850,14 @@ ResultProcessor *RPMetricsLoader_New() {
  *
  * Note: We use a min-max heap to simplify maintaining a max heap where we can pop from the bottom
  * while finding the top N results
+ *
+ * When sorting by fields, as long as every sort key holds either numbers or strings (or is
+ * missing), the sorter keeps the results instead in a flat heap of normalized keys: a word by sort
+ * key, ordered as the results, and a word to break ties by document id. A number is its double in
+ * an order preserving encoding, a string the prefix of its first 8 bytes. Comparing results then
+ * mostly compares words, the strings of equal prefixes only being compared in full. The results
+ * are sorted once all of them were accumulated. The first result with another sort key moves all
+ * of them to the min-max heap.
  *******************************************************************************************************************/
 
 typedef int (*RPSorterCompareFunc)(const void *e1, const void *e2, const void *udata);
@@ -347,7 +874,8 @@ typedef struct {
   // private data for the compare function
   void *cmpCtx;
 
-  // pooled result - we recycle it to avoid allocations
+  // pooled result - we recycle it to avoid allocations. Allocated on the first accumulation, since
+  // the results are allocated from the arena of the parent
   SearchResult *pooledResult;
 
   struct {
@@ -355,8 +883,207 @@ typedef struct {
     size_t nkeys;
     uint64_t ascendMap;
   } fieldcmp;
+
+  // The heap of normalized keys, with the worst result at its root. Used when `stride` is set
+  struct {
+    SearchResult **results;
+    uint64_t *keys;       // `stride` words for every result
+    uint64_t *pooledKey;  // the key of the pooled result
+    uint8_t *kinds;       // the kind of the values of every sort key, a SortKeyKind
+    size_t stride;
+    size_t len;
+    size_t cap;
+    size_t yielded;
+  } keyed;
 } RPSorter;
 
+typedef enum {
+  SORTKEY_UNKNOWN,  // only missing so far
+  SORTKEY_NUMBER,
+  SORTKEY_STRING,
+} SortKeyKind;
+
+static int cmpByField(const RPSorter *self, size_t i, const SearchResult *h1,
+                      const SearchResult *h2, QueryError *qerr);
+
+/* Compare normalized keys. The strings of equal prefixes are compared in full */
+static inline int cmpSortKeys(const RPSorter *self, const uint64_t *k1, const SearchResult *r1,
+                              const uint64_t *k2, const SearchResult *r2) {
+  size_t stride = self->keyed.stride;
+  for (size_t ii = 0; ii < stride; ++ii) {
+    if (k1[ii] != k2[ii]) {
+      return k1[ii] > k2[ii] ? 1 : -1;
+    }
+    if (ii + 1 < stride && self->keyed.kinds[ii] == SORTKEY_STRING) {
+      int rc = cmpByField(self, ii, r1, r2, NULL);
+      if (rc != 0) {
+        return rc;
+      }
+    }
+  }
+  return 0;
+}
+
+#define SORT_KEY(self, pos) ((self)->keyed.keys + (pos) * (self)->keyed.stride)
+
+/* Whether the values of a sort key hold `kind`, which they do if they held none so far */
+static inline bool sorterKeyOfKind(const RPSorter *self, size_t ii, SortKeyKind kind) {
+  if (self->keyed.kinds[ii] == SORTKEY_UNKNOWN) {
+    self->keyed.kinds[ii] = kind;
+  }
+  return self->keyed.kinds[ii] == kind;
+}
+
+/* Normalize the sort keys of a result, ordered as they are by cmpByFields. Returns false if one of
+ * them is neither a number nor a string, or not of the kind of the others of its sort key */
+static bool sorterKey(const RPSorter *self, const SearchResult *r, uint64_t *key) {
+  size_t nkeys = self->keyed.stride - 1;
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    double d;
+    if (!RLookup_GetSortableNumber(self->fieldcmp.keys[ii], &r->rowdata, &d)) {
+      const RSValue *v = RLookup_GetItem(self->fieldcmp.keys[ii], &r->rowdata);
+      if (!v) {
+        // missing keys are the lowest, regardless of the order
+        key[ii] = 0;
+        continue;
+      }
+      if (v->t == RSValue_String || v->t == RSValue_RedisString || v->t == RSValue_OwnRstring) {
+        if (!sorterKeyOfKind(self, ii, SORTKEY_STRING)) {
+          return false;
+        }
+        size_t len;
+        const char *str = RSValue_StringPtrLen(v, &len);
+        uint64_t u = StrSortPrefix(str, len);
+        // may be 0 as a missing key, which are told apart by comparing them in full
+        key[ii] = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, ii) ? ~u : u;
+        continue;
+      }
+      if (v->t != RSValue_Number) {
+        return false;
+      }
+      d = v->numval;
+    }
+    if (isnan(d) || !sorterKeyOfKind(self, ii, SORTKEY_NUMBER)) {
+      return false;
+    }
+    // a double as an unsigned integer in the same order, -0 being 0
+    d = d == 0 ? 0 : d;
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    u = (u & (1ULL << 63)) ? ~u : u | (1ULL << 63);
+    // neither is 0, since NaN is excluded
+    key[ii] = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, ii) ? ~u : u;
+  }
+  // ties are broken by the order of the last key
+  key[nkeys] = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, nkeys - 1) ? ~r->docId : r->docId;
+  return true;
+}
+
+static void sorterKeyedSwap(RPSorter *self, size_t a, size_t b) {
+  SearchResult *tmp = self->keyed.results[a];
+  self->keyed.results[a] = self->keyed.results[b];
+  self->keyed.results[b] = tmp;
+  for (size_t ii = 0; ii < self->keyed.stride; ++ii) {
+    uint64_t k = SORT_KEY(self, a)[ii];
+    SORT_KEY(self, a)[ii] = SORT_KEY(self, b)[ii];
+    SORT_KEY(self, b)[ii] = k;
+  }
+}
+
+/* Compare the results at positions `a` and `b` of the heap */
+static inline int cmpSortKeysAt(const RPSorter *self, size_t a, size_t b) {
+  return cmpSortKeys(self, SORT_KEY(self, a), self->keyed.results[a], SORT_KEY(self, b),
+                     self->keyed.results[b]);
+}
+
+static void sorterKeyedSiftDown(RPSorter *self, size_t pos, size_t len) {
+  while (true) {
+    size_t worst = pos, left = 2 * pos + 1, right = left + 1;
+    if (left < len && cmpSortKeysAt(self, left, worst) < 0) {
+      worst = left;
+    }
+    if (right < len && cmpSortKeysAt(self, right, worst) < 0) {
+      worst = right;
+    }
+    if (worst == pos) {
+      return;
+    }
+    sorterKeyedSwap(self, pos, worst);
+    pos = worst;
+  }
+}
+
+/* Push the pooled result, whose key is the pooled key, into the keyed heap */
+static void sorterKeyedPush(ResultProcessor *rp) {
+  RPSorter *self = (RPSorter *)rp;
+  size_t stride = self->keyed.stride;
+
+  if (self->keyed.len < self->pq->size) {
+    if (self->keyed.len == self->keyed.cap) {
+      self->keyed.cap = MIN(self->keyed.cap ? self->keyed.cap * 2 : 64, self->pq->size);
+      self->keyed.results = rm_realloc(self->keyed.results, self->keyed.cap * sizeof(SearchResult *));
+      self->keyed.keys = rm_realloc(self->keyed.keys, self->keyed.cap * stride * sizeof(uint64_t));
+    }
+    size_t pos = self->keyed.len++;
+    self->pooledResult->indexResult = NULL;
+    self->keyed.results[pos] = self->pooledResult;
+    memcpy(SORT_KEY(self, pos), self->keyed.pooledKey, stride * sizeof(uint64_t));
+    while (pos) {
+      size_t parent = (pos - 1) / 2;
+      if (cmpSortKeysAt(self, pos, parent) >= 0) {
+        break;
+      }
+      sorterKeyedSwap(self, pos, parent);
+      pos = parent;
+    }
+    if (self->pooledResult->score < rp->parent->minScore) {
+      rp->parent->minScore = self->pooledResult->score;
+    }
+    self->pooledResult = QITR_Alloc(rp->parent, sizeof(*self->pooledResult));
+  } else {
+    SearchResult *minh = self->keyed.results[0];
+    if (minh->score > rp->parent->minScore) {
+      rp->parent->minScore = minh->score;
+    }
+    if (cmpSortKeys(self, self->keyed.pooledKey, self->pooledResult, SORT_KEY(self, 0), minh) > 0) {
+      self->pooledResult->indexResult = NULL;
+      self->keyed.results[0] = self->pooledResult;
+      self->pooledResult = minh;
+      memcpy(SORT_KEY(self, 0), self->keyed.pooledKey, stride * sizeof(uint64_t));
+      sorterKeyedSiftDown(self, 0, self->keyed.len);
+    }
+    SearchResult_Clear(self->pooledResult);
+  }
+}
+
+/* Move the results of the keyed heap to the min-max heap. They are in the same order there */
+static void sorterKeyedToHeap(RPSorter *self) {
+  for (size_t ii = 0; ii < self->keyed.len; ++ii) {
+    mmh_insert(self->pq, self->keyed.results[ii]);
+  }
+  rm_free(self->keyed.results);
+  rm_free(self->keyed.keys);
+  rm_free(self->keyed.pooledKey);
+  rm_free(self->keyed.kinds);
+  memset(&self->keyed, 0, sizeof(self->keyed));
+}
+
+/* Yield the results of the keyed heap, sorted from the best */
+static int rpsortNext_YieldKeyed(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (self->keyed.yielded == self->keyed.len) {
+    return RS_RESULT_EOF;
+  }
+
+  SearchResult *cur_best = self->keyed.results[self->keyed.yielded];
+  self->keyed.results[self->keyed.yielded++] = NULL;
+  RLookupRow oldrow = r->rowdata;
+  *r = *cur_best;
+
+  RLookupRow_Cleanup(&oldrow);
+  return RS_RESULT_OK;
+}
+
 /* Yield - pops the current top result from the heap */
 static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
@@ -366,18 +1093,28 @@ static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
     RLookupRow oldrow = r->rowdata;
     *r = *cur_best;
 
-    rm_free(cur_best);
     RLookupRow_Cleanup(&oldrow);
     return RS_RESULT_OK;
   }
   return RS_RESULT_EOF;
 }
 
+static void srDtor(void *p);
+
 static void rpsortFree(ResultProcessor *rp) {
   RPSorter *self = (RPSorter *)rp;
 
-  SearchResult_Destroy(self->pooledResult);
-  rm_free(self->pooledResult);
+  if (self->pooledResult) {
+    SearchResult_Destroy(self->pooledResult);
+  }
+
+  for (size_t ii = self->keyed.yielded; ii < self->keyed.len; ++ii) {
+    srDtor(self->keyed.results[ii]);
+  }
+  rm_free(self->keyed.results);
+  rm_free(self->keyed.keys);
+  rm_free(self->keyed.pooledKey);
+  rm_free(self->keyed.kinds);
 
   // calling mmh_free will free all the remaining results in the heap, if any
   mmh_free(self->pq);
@@ -386,20 +1123,17 @@ static void rpsortFree(ResultProcessor *rp) {
 
 #define RESULT_QUEUED RS_RESULT_MAX + 1
 
-static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
+/* Push the pooled result into the heap if it is one of the top results, and prepare the pooled
+ * result for the next one */
+static void rpsortPushPooled(ResultProcessor *rp) {
   RPSorter *self = (RPSorter *)rp;
 
-  // get the next result from upstream. `self->pooledResult` is expected to be empty and allocated.
-  int rc = rp->upstream->Next(rp->upstream, self->pooledResult);
-
-  // if our upstream has finished - just change the state to not accumulating, and yield
-  if (rc == RS_RESULT_EOF || (rc == RS_RESULT_TIMEDOUT && rp->parent->timeoutPolicy == TimeoutPolicy_Return)) {
-    // Transition state:
-    rp->Next = rpsortNext_Yield;
-    return rpsortNext_Yield(rp, r);
-  } else if (rc != RS_RESULT_OK) {
-    // whoops!
-    return rc;
+  if (self->keyed.stride) {
+    if (sorterKey(self, self->pooledResult, self->keyed.pooledKey)) {
+      sorterKeyedPush(rp);
+      return;
+    }
+    sorterKeyedToHeap(self);
   }
 
   // If the queue is not full - we just push the result into it
@@ -412,7 +1146,7 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
       rp->parent->minScore = self->pooledResult->score;
     }
     // we need to allocate a new result for the next iteration
-    self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
+    self->pooledResult = QITR_Alloc(rp->parent, sizeof(*self->pooledResult));
   } else {
     // find the min result
     SearchResult *minh = mmh_peek_min(self->pq);
@@ -430,10 +1164,55 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
     // clear the result in preparation for the next iteration
     SearchResult_Clear(self->pooledResult);
   }
+}
+
+/* Whether the upstream is done, and the sorter should yield its results */
+static inline bool rpsortUpstreamDone(ResultProcessor *rp, int rc) {
+  return rc == RS_RESULT_EOF ||
+         (rc == RS_RESULT_TIMEDOUT && rp->parent->timeoutPolicy == TimeoutPolicy_Return);
+}
+
+/* Start yielding the accumulated results */
+static int rpsortStartYield(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->keyed.stride) {
+    rp->Next = rpsortNext_Yield;
+    return rpsortNext_Yield(rp, r);
+  }
+
+  // sort the heap from the best result, by moving its root to its end
+  for (size_t len = self->keyed.len; len > 1; --len) {
+    sorterKeyedSwap(self, 0, len - 1);
+    sorterKeyedSiftDown(self, 0, len - 1);
+  }
+  rp->Next = rpsortNext_YieldKeyed;
+  return rpsortNext_YieldKeyed(rp, r);
+}
+
+static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+
+  // get the next result from upstream. `self->pooledResult` is expected to be empty and allocated.
+  int rc = rp->upstream->Next(rp->upstream, self->pooledResult);
+
+  // if our upstream has finished - just change the state to not accumulating, and yield
+  if (rpsortUpstreamDone(rp, rc)) {
+    // Transition state:
+    return rpsortStartYield(rp, r);
+  } else if (rc != RS_RESULT_OK) {
+    // whoops!
+    return rc;
+  }
+
+  rpsortPushPooled(rp);
   return RESULT_QUEUED;
 }
 
 static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->pooledResult) {
+    self->pooledResult = QITR_Alloc(rp->parent, sizeof(*self->pooledResult));
+  }
   uint32_t chunkLimit = rp->parent->resultLimit;
   rp->parent->resultLimit = UINT32_MAX; // we want to accumulate all results
   int rc;
@@ -444,6 +1223,40 @@ static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
   return rc;
 }
 
+/* Accumulate the results read in batches. Used when sorting by fields: the scores of the results
+ * sorted by their score are read one by one, so that the minimal score of the top results is up to
+ * date for the scorer */
+static int rpsortNext_AccumBatch(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->pooledResult) {
+    self->pooledResult = QITR_Alloc(rp->parent, sizeof(*self->pooledResult));
+  }
+  uint32_t chunkLimit = rp->parent->resultLimit;
+  rp->parent->resultLimit = UINT32_MAX; // we want to accumulate all results
+
+  SearchResultBatch batch;
+  SearchResultBatch_Init(&batch, RESULT_BATCH_SIZE);
+  int rc;
+  do {
+    rc = RP_NextBatch(rp->upstream, &batch);
+    for (size_t ii = 0; ii < batch.len; ++ii) {
+      // swap the result with the empty pooled result
+      SearchResult tmp = *self->pooledResult;
+      *self->pooledResult = batch.results[ii];
+      batch.results[ii] = tmp;
+      rpsortPushPooled(rp);
+    }
+    batch.len = 0;
+  } while (rc == RS_RESULT_OK);
+  SearchResultBatch_Destroy(&batch);
+  rp->parent->resultLimit = chunkLimit; // restore the limit
+
+  if (rpsortUpstreamDone(rp, rc)) {
+    return rpsortStartYield(rp, r);
+  }
+  return rc;
+}
+
 /* Compare results for the heap by score */
 static inline int cmpByScore(const void *e1, const void *e2, const void *udata) {
   const SearchResult *h1 = e1, *h2 = e2;
@@ -456,6 +1269,33 @@ static inline int cmpByScore(const void *e1, const void *e2, const void *udata)
   return h1->docId > h2->docId ? -1 : 1;
 }
 
+/* Compare results by their `i`th sort key */
+static int cmpByField(const RPSorter *self, size_t i, const SearchResult *h1,
+                      const SearchResult *h2, QueryError *qerr) {
+  const RLookupKey *kk = self->fieldcmp.keys[i];
+  // take the ascending bit for this property from the ascending bitmap
+  int ascending = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, i);
+
+  // the numbers of the sorting vectors are compared as they are stored
+  double n1, n2;
+  if (RLookup_GetSortableNumber(kk, &h1->rowdata, &n1) &&
+      RLookup_GetSortableNumber(kk, &h2->rowdata, &n2)) {
+    int rc = n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
+    return ascending ? -rc : rc;
+  }
+
+  const RSValue *v1 = RLookup_GetItem(kk, &h1->rowdata);
+  const RSValue *v2 = RLookup_GetItem(kk, &h2->rowdata);
+  if (!v1 || !v2) {
+    // If at least one of these has no sort key, it gets high value regardless of asc/desc.
+    // If both have none, they are equal
+    return v1 ? 1 : (v2 ? -1 : 0);
+  }
+
+  int rc = RSValue_Cmp(v1, v2, qerr);
+  return ascending ? -rc : rc;
+}
+
 /* Compare results for the heap by sorting key */
 static int cmpByFields(const void *e1, const void *e2, const void *udata) {
   const RPSorter *self = udata;
@@ -468,40 +1308,19 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
   }
 
   for (size_t i = 0; i < self->fieldcmp.nkeys && i < SORTASCMAP_MAXFIELDS; i++) {
-    const RSValue *v1 = RLookup_GetItem(self->fieldcmp.keys[i], &h1->rowdata);
-    const RSValue *v2 = RLookup_GetItem(self->fieldcmp.keys[i], &h2->rowdata);
-    // take the ascending bit for this property from the ascending bitmap
     ascending = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, i);
-    if (!v1 || !v2) {
-      // If at least one of these has no sort key, it gets high value regardless of asc/desc
-      if (v1) {
-        return 1;
-      } else if (v2) {
-        return -1;
-      } else {
-        // Both have no sort key, so they are equal. Continue to next sort key
-        continue;
-      }
-    }
-
-    int rc = RSValue_Cmp(v1, v2, qerr);
-    // printf("asc? %d Compare: \n", ascending);
-    // RSValue_Print(v1);
-    // printf(" <=> ");
-    // RSValue_Print(v2);
-    // printf("\n");
-
-    if (rc != 0) return ascending ? -rc : rc;
+    int rc = cmpByField(self, i, h1, h2, qerr);
+    if (rc != 0) return rc;
   }
 
   int rc = h1->docId < h2->docId ? -1 : 1;
   return ascending ? -rc : rc;
 }
 
+/* Destroy a result of the heap. Its memory belongs to the arena */
 static void srDtor(void *p) {
   if (p) {
     SearchResult_Destroy(p);
-    rm_free(p);
   }
 }
 
@@ -515,8 +1334,12 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
   ret->fieldcmp.nkeys = nkeys;
 
   ret->pq = mmh_init_with_size(maxresults, ret->cmp, ret->cmpCtx, srDtor);
-  ret->pooledResult = rm_calloc(1, sizeof(*ret->pooledResult));
-  ret->base.Next = rpsortNext_Accum;
+  if (nkeys) {
+    ret->keyed.stride = MIN(nkeys, SORTASCMAP_MAXFIELDS) + 1;
+    ret->keyed.pooledKey = rm_malloc(ret->keyed.stride * sizeof(uint64_t));
+    ret->keyed.kinds = rm_calloc(ret->keyed.stride - 1, sizeof(*ret->keyed.kinds));
+  }
+  ret->base.Next = nkeys ? rpsortNext_AccumBatch : rpsortNext_Accum;
   ret->base.Free = rpsortFree;
   ret->base.type = RP_SORTER;
   return &ret->base;
@@ -646,6 +1469,15 @@ static int rploaderNext(ResultProcessor *base, SearchResult *r) {
   return RS_RESULT_OK;
 }
 
+static int rploaderNextBatch(ResultProcessor *base, SearchResultBatch *batch) {
+  RPLoader *lc = (RPLoader *)base;
+  int rc = RP_NextBatch(base->upstream, batch);
+  for (size_t ii = 0; ii < batch->len; ++ii) {
+    rpLoader_loadDocument(lc, &batch->results[ii]);
+  }
+  return rc;
+}
+
 static void rploaderFreeInternal(ResultProcessor *base) {
   RPLoader *lc = (RPLoader *)base;
   QueryError_ClearError(&lc->status);
@@ -682,11 +1514,60 @@ static ResultProcessor *RPPlainLoader_New(RedisSearchCtx *sctx, RLookup *lk, con
   rploaderNew_setLoadOpts(self, sctx, lk, keys, nkeys);
 
   self->base.Next = rploaderNext;
+  self->base.NextBatch = rploaderNextBatch;
   self->base.Free = rploaderFree;
   self->base.type = RP_LOADER;
   return &self->base;
 }
 
+/*******************************************************************************************************************
+ *  Doc Values Results Processor
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  const RLookupKey **keys;
+  const TagIndex **indexes;
+  size_t nkeys;
+} RPDocValues;
+
+static int rpDocValuesNext(ResultProcessor *base, SearchResult *r) {
+  RPDocValues *self = (RPDocValues *)base;
+  int rc = base->upstream->Next(base->upstream, r);
+  if (rc != RS_RESULT_OK) {
+    return rc;
+  }
+
+  for (size_t ii = 0; ii < self->nkeys; ++ii) {
+    RSValue *v = TagIndex_GetDocValue(self->indexes[ii], r->docId);
+    if (v) {
+      RLookup_WriteKey(self->keys[ii], &r->rowdata, v);
+    }
+  }
+  return RS_RESULT_OK;
+}
+
+static void rpDocValuesFree(ResultProcessor *base) {
+  RPDocValues *self = (RPDocValues *)base;
+  rm_free(self->keys);
+  rm_free(self->indexes);
+  rm_free(self);
+}
+
+ResultProcessor *RPDocValues_New(const RLookupKey **keys, const TagIndex **indexes, size_t nkeys) {
+  RPDocValues *self = rm_calloc(1, sizeof(*self));
+  self->keys = rm_malloc(sizeof(*keys) * nkeys);
+  memcpy(self->keys, keys, sizeof(*keys) * nkeys);
+  self->indexes = rm_malloc(sizeof(*indexes) * nkeys);
+  memcpy(self->indexes, indexes, sizeof(*indexes) * nkeys);
+  self->nkeys = nkeys;
+
+  self->base.Next = rpDocValuesNext;
+  self->base.Free = rpDocValuesFree;
+  self->base.type = RP_DOC_VALUES;
+  return &self->base;
+}
+
 /*******************************************************************************************************************
  *  Safe Loader Results Processor
  *
@@ -794,13 +1675,31 @@ static int rpSafeLoader_ResetAndReturnLastCode(RPSafeLoader *self) {
 
 /*********************************************************************************/
 
-static void rpSafeLoader_Load(RPSafeLoader *self) {
+// The longest the safe loader holds the GIL at once, before letting Redis serve its clients
+#define SAFE_LOADER_LOCK_SLICE_MS 2
+// The time held is checked every this many documents
+#define SAFE_LOADER_LOCK_CHECK_INTERVAL 16
+
+static void rpSafeLoader_Load(RPSafeLoader *self, RedisModuleCtx *ctx) {
   SearchResult *curr_res;
+  struct timespec slice = {.tv_sec = 0, .tv_nsec = SAFE_LOADER_LOCK_SLICE_MS * 1000000};
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &deadline);
+  rs_timeradd(&deadline, &slice, &deadline);
+  size_t loaded = 0;
 
   // iterate the buffer.
   // TODO: implement `GetNextResult` that gets the current block to save calculation time.
   while ((curr_res = GetNextResult(self))) {
     rpLoader_loadDocument(&self->base_loader, curr_res);
+    if (++loaded % SAFE_LOADER_LOCK_CHECK_INTERVAL == 0 && TimedOut(&deadline)) {
+      // The documents loaded so far are safe to use without the GIL, and a document deleted in the
+      // meantime fails to open
+      RedisModule_ThreadSafeContextUnlock(ctx);
+      RedisModule_ThreadSafeContextLock(ctx);
+      clock_gettime(CLOCK_MONOTONIC_RAW, &deadline);
+      rs_timeradd(&deadline, &slice, &deadline);
+    }
   }
 
   // Reset the iterator
@@ -860,7 +1759,7 @@ static int rpSafeLoaderNext_Accumulate(ResultProcessor *rp, SearchResult *res) {
   // Then, lock Redis to guarantee safe access to Redis keyspace
   RedisModule_ThreadSafeContextLock(sctx->redisCtx);
 
-  rpSafeLoader_Load(self);
+  rpSafeLoader_Load(self, sctx->redisCtx);
 
   // Done loading. Unlock Redis
   RedisModule_ThreadSafeContextUnlock(sctx->redisCtx);
@@ -911,19 +1810,236 @@ static ResultProcessor *RPSafeLoader_New(RedisSearchCtx *sctx, RLookup *lk, cons
 #define DEFAULT_BUFFER_BLOCK_SIZE 1024
 
 ResultProcessor *RPLoader_New(AREQ *r, RLookup *lk, const RLookupKey **keys, size_t nkeys) {
+  ResultProcessor *rp;
   if (r->reqflags & QEXEC_F_RUN_IN_BACKGROUND) {
     // Assumes that Redis is *NOT* locked while executing the loader
-    return RPSafeLoader_New(r->sctx, lk, keys, nkeys, DEFAULT_BUFFER_BLOCK_SIZE);
+    rp = RPSafeLoader_New(r->sctx, lk, keys, nkeys, DEFAULT_BUFFER_BLOCK_SIZE);
   } else {
     // Assumes that Redis *IS* locked while executing the loader
-    return RPPlainLoader_New(r->sctx, lk, keys, nkeys);
+    rp = RPPlainLoader_New(r->sctx, lk, keys, nkeys);
+  }
+  // The values are replied as they are loaded: hash fields keep the strings Redis created for
+  // them, and JSON fields their serialization. A copy of the whole JSON value is only needed by
+  // FORMAT EXPAND, the format is known by now
+  ((RPLoader *)rp)->loadopts.noExpand = !IsFormatExpand(r);
+  return rp;
+}
+
+/*******************************************************************************************************************
+ *  Prefetch Results Processor
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  arrayof(SearchResult) results;
+  // The next buffered result to yield
+  uint32_t next;
+  // The code which ended the last fill, returned once the buffered results were yielded
+  int lastRc;
+  // The error of the last fill. The error of the read the fill belongs to is only known then
+  QueryError err;
+} RPPrefetch;
+
+static int rpprefetchNext(ResultProcessor *base, SearchResult *r) {
+  RPPrefetch *self = (RPPrefetch *)base;
+  if (self->next < array_len(self->results)) {
+    // Free the RLookup row before overriding it.
+    RLookupRow_Cleanup(&r->rowdata);
+    *r = self->results[self->next++];
+    if (self->next == array_len(self->results)) {
+      array_clear(self->results);
+      self->next = 0;
+    }
+    return RS_RESULT_OK;
+  }
+  if (self->lastRc != RS_RESULT_OK) {
+    int rc = self->lastRc;
+    self->lastRc = RS_RESULT_OK;
+    if (rc == RS_RESULT_ERROR) {
+      QueryError_SetError(base->parent->err, QueryError_GetCode(&self->err),
+                          QueryError_GetError(&self->err));
+      QueryError_ClearError(&self->err);
+    }
+    return rc;
+  }
+  return base->upstream->Next(base->upstream, r);
+}
+
+void RPPrefetch_Fill(ResultProcessor *rp, uint32_t limit) {
+  RPPrefetch *self = (RPPrefetch *)rp;
+  QueryIterator *qiter = rp->parent;
+  uint32_t buffered = array_len(self->results) - self->next;
+  if (self->lastRc != RS_RESULT_OK || buffered >= limit) {
+    return;
+  }
+
+  // Read the rows as a chunk of `limit` would have been. The error, if any, is set on the read
+  // which yields it
+  QueryError *err = qiter->err;
+  qiter->err = &self->err;
+  qiter->resultLimit = limit - buffered;
+  SearchResult r = {0};
+  int rc;
+  while ((rc = rp->upstream->Next(rp->upstream, &r)) == RS_RESULT_OK) {
+    self->results = array_append(self->results, r);
+    memset(&r, 0, sizeof(r));
+    if (!--qiter->resultLimit) {
+      break;
+    }
+  }
+  SearchResult_Destroy(&r);
+  self->lastRc = rc;
+  qiter->err = err;
+  RedisSearchCtx_UnlockSpec(qiter->sctx);
+}
+
+static void rpprefetchFree(ResultProcessor *base) {
+  RPPrefetch *self = (RPPrefetch *)base;
+  for (uint32_t ii = self->next; ii < array_len(self->results); ++ii) {
+    SearchResult_Destroy(&self->results[ii]);
+  }
+  array_free(self->results);
+  QueryError_ClearError(&self->err);
+  rm_free(self);
+}
+
+ResultProcessor *RPPrefetch_New(void) {
+  RPPrefetch *self = rm_calloc(1, sizeof(*self));
+  self->results = array_new(SearchResult, 0);
+  self->lastRc = RS_RESULT_OK;
+  self->base.type = RP_PREFETCH;
+  self->base.Next = rpprefetchNext;
+  self->base.Free = rpprefetchFree;
+  return &self->base;
+}
+
+/*******************************************************************************************************************
+ *  Frozen Processor
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  // The keys the rows have values of, in the order they are written
+  const RLookupKey **keys;
+  size_t nkeys;
+  Buffer rows;
+  BufferReader reader;
+  // The results counted and discounted by the chain while it was read, added to the next read
+  uint32_t totalResults;
+  // The code which ended the chain, returned once the rows were yielded, along with its error
+  int lastRc;
+  QueryError err;
+} RPFrozen;
+
+static int rpfrozenNext(ResultProcessor *base, SearchResult *r) {
+  RPFrozen *self = (RPFrozen *)base;
+  base->parent->totalResults += self->totalResults;
+  self->totalResults = 0;
+  BufferReader *br = &self->reader;
+  if (BufferReader_AtEnd(br)) {
+    if (self->lastRc == RS_RESULT_ERROR) {
+      QueryError_SetError(base->parent->err, QueryError_GetCode(&self->err),
+                          QueryError_GetError(&self->err));
+      QueryError_ClearError(&self->err);
+    }
+    return self->lastRc;
+  }
+
+  Buffer_Read(br, &r->docId, sizeof(r->docId));
+  Buffer_Read(br, &r->score, sizeof(r->score));
+  for (size_t ii = 0; ii < self->nkeys; ++ii) {
+    if (br->buf->data[br->pos] == RSValue_Undef) {
+      br->pos++;
+      continue;
+    }
+    RLookup_WriteOwnKey(self->keys[ii], &r->rowdata, RSValue_Deserialize(br));
+  }
+  return RS_RESULT_OK;
+}
+
+static void rpfrozenFree(ResultProcessor *base) {
+  RPFrozen *self = (RPFrozen *)base;
+  Buffer_Free(&self->rows);
+  rm_free(self->keys);
+  QueryError_ClearError(&self->err);
+  rm_free(self);
+}
+
+size_t RPFrozen_Freeze(QueryIterator *qiter, const RLookup *lk) {
+  RPFrozen *self = rm_calloc(1, sizeof(*self));
+  self->base.type = RP_FROZEN;
+  self->base.Next = rpfrozenNext;
+  self->base.Free = rpfrozenFree;
+  for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+    self->nkeys += !!kk->name;
+  }
+  self->keys = rm_malloc(self->nkeys * sizeof(*self->keys));
+  size_t nkeys = 0;
+  for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+    if (kk->name) {
+      self->keys[nkeys++] = kk;
+    }
+  }
+
+  // Read the rows as the next reads would have, with their error set aside for the read which
+  // yields it
+  QueryError *err = qiter->err;
+  uint32_t totalResults = qiter->totalResults;
+  uint32_t chunkLimit = qiter->resultLimit;
+  qiter->err = &self->err;
+  qiter->resultLimit = UINT32_MAX;
+  Buffer_Init(&self->rows, 1024);
+  BufferWriter bw = NewBufferWriter(&self->rows);
+  ResultProcessor *rp = qiter->endProc;
+  SearchResult r = {0};
+  size_t n = 0;
+  while ((self->lastRc = rp->Next(rp, &r)) == RS_RESULT_OK) {
+    Buffer_Write(&bw, &r.docId, sizeof(r.docId));
+    Buffer_Write(&bw, &r.score, sizeof(r.score));
+    for (size_t ii = 0; ii < self->nkeys; ++ii) {
+      const RSValue *v = RLookup_GetItem(self->keys[ii], &r.rowdata);
+      if (v) {
+        RSValue_Serialize(v, &bw);
+      } else {
+        Buffer_WriteU8(&bw, RSValue_Undef);
+      }
+    }
+    SearchResult_Clear(&r);
+    ++n;
   }
+  SearchResult_Destroy(&r);
+  RedisSearchCtx_UnlockSpec(qiter->sctx);
+  Buffer_ShrinkToSize(&self->rows);
+  self->reader = NewBufferReader(&self->rows);
+  self->totalResults = qiter->totalResults - totalResults;
+  qiter->totalResults = totalResults;
+  qiter->resultLimit = chunkLimit;
+  qiter->err = err;
+
+  QITR_FreeChain(qiter);
+  qiter->rootProc = qiter->endProc = NULL;
+  QITR_PushRP(qiter, &self->base);
+  return n;
+}
+
+void RPFrozen_Shrink(ResultProcessor *base) {
+  RPFrozen *self = (RPFrozen *)base;
+  Buffer *b = &self->rows;
+  size_t pos = self->reader.pos;
+  if (pos <= b->offset / 2) {
+    return;
+  }
+  memmove(b->data, b->data + pos, b->offset - pos);
+  b->offset -= pos;
+  Buffer_ShrinkToSize(b);
+  self->reader = NewBufferReader(b);
 }
 
 static char *RPTypeLookup[RP_MAX] = {"Index",   "Loader",    "Threadsafe-Loader", "Scorer",
                                      "Sorter",  "Counter",   "Pager/Limiter",     "Highlighter",
                                      "Grouper", "Projector", "Filter",            "Profile",
-                                     "Network", "Metrics Applier"};
+                                     "Network", "Metrics Applier", "Doc Values", "Prefetch",
+                                     "Frozen"};
 
 const char *RPTypeToString(ResultProcessorType type) {
   RS_LOG_ASSERT(type >= 0 && type < RP_MAX, "enum is out of range");
@@ -947,16 +2063,25 @@ typedef struct {
   ResultProcessor base;
   double profileTime;
   uint64_t profileCount;
+  bool withHw;      // whether the hardware counters are read, and were readable so far
+  PerfCounters hw;
 } RPProfile;
 
 static int rpprofileNext(ResultProcessor *base, SearchResult *r) {
   RPProfile *self = (RPProfile *)base;
 
+  PerfCounters hw0, hw1;
+  if (self->withHw && !PerfCounters_Read(&hw0)) {
+    self->withHw = false;
+  }
   hires_clock_t t0;
   hires_clock_get(&t0);
   int rc = base->upstream->Next(base->upstream, r);
   self->profileTime += hires_clock_since_msec(&t0);
   self->profileCount++;
+  if (self->withHw && PerfCounters_Read(&hw1)) {
+    PerfCounters_AddSince(&self->hw, &hw0, &hw1);
+  }
   return rc;
 }
 
@@ -965,10 +2090,11 @@ static void rpProfileFree(ResultProcessor *base) {
   rm_free(rp);
 }
 
-ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter) {
+ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter, bool withHw) {
   RPProfile *rpp = rm_calloc(1, sizeof(*rpp));
 
   rpp->profileCount = 0;
+  rpp->withHw = withHw;
   rpp->base.upstream = rp;
   rpp->base.parent = qiter;
   rpp->base.Next = rpprofileNext;
@@ -988,11 +2114,16 @@ uint64_t RPProfile_GetCount(ResultProcessor *rp) {
   return self->profileCount;
 }
 
-void Profile_AddRPs(QueryIterator *qiter) {
-  ResultProcessor *cur = qiter->endProc = RPProfile_New(qiter->endProc, qiter);
+const PerfCounters *RPProfile_GetHwCounters(ResultProcessor *rp) {
+  RPProfile *self = (RPProfile *)rp;
+  return self->withHw ? &self->hw : NULL;
+}
+
+void Profile_AddRPs(QueryIterator *qiter, bool withHw) {
+  ResultProcessor *cur = qiter->endProc = RPProfile_New(qiter->endProc, qiter, withHw);
   while (cur && cur->upstream && cur->upstream->upstream) {
     cur = cur->upstream;
-    cur->upstream = RPProfile_New(cur->upstream, qiter);
+    cur->upstream = RPProfile_New(cur->upstream, qiter, withHw);
     cur = cur->upstream;
   }
 }
@@ -1014,6 +2145,13 @@ static int rpcountNext(ResultProcessor *base, SearchResult *res) {
   int rc;
   RPCounter *self = (RPCounter *)base;
 
+  if (base->upstream->Count) {
+    size_t count = 0;
+    rc = base->upstream->Count(base->upstream, &count);
+    self->count += count;
+    return rc;
+  }
+
   while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
     self->count += 1;
     SearchResult_Clear(res);
@@ -1043,3 +2181,271 @@ ResultProcessor *RPCounter_New() {
   ret->base.type = RP_COUNTER;
   return &ret->base;
 }
+
+/*******************************************************************************************************************
+ *  Parallel Processor
+ *
+ * The root processor of a query executed in parallel over ranges of docids. Every partition reads
+ * its range from its own clone of the iterator tree, through its own chain of processors. On the
+ * first read all the partitions run to the end, concurrently on the worker threads and on the
+ * calling thread, and their results are then returned one partition after another, to be merged
+ * downstream by the sorter or the grouper.
+ *******************************************************************************************************************/
+
+typedef struct {
+  QueryIterator qiter;  // the chain of the partition
+  QueryError status;
+  arrayof(SearchResult) results;
+  int rc;               // the status the chain ended with
+} RPPartition;
+
+typedef struct {
+  // Reads the whole iterator tree, for processors reading it once the results are returned (see
+  // QITR_GetRootFilter)
+  RPIndexIterator base;
+  RPPartition *partitions;
+  size_t numPartitions;
+  t_docId maxDocId;
+  bool done;
+  size_t cur;  // the partition whose results are being returned
+  size_t pos;  // the position of the next result in the current partition
+} RPParallel;
+
+/* Position the partitions at the start of their ranges. The partitions after the first one seek
+ * to the start of their range and return the docids after the seek, and the docid the seek found
+ * if it matched. A seek may also stop on a docid which does not match, in which case the range of
+ * the previous partition extends up to it */
+static void rpparallelSeek(RPParallel *self) {
+  size_t n = self->numPartitions;
+  t_docId last = DOCID_MAX;
+  for (size_t ii = n - 1; ii > 0; --ii) {
+    RPIndexIterator *idx = (RPIndexIterator *)self->partitions[ii].qiter.rootProc;
+    IndexIterator *it = idx->iiter;
+    t_docId start = 1 + ii * (self->maxDocId / n);
+    RSIndexResult *hit = NULL;
+    t_docId after;  // the partition returns the docids after this one
+    switch (it->SkipTo(it->ctx, start, &hit)) {
+      case INDEXREAD_OK:
+        idx->first = hit;
+        after = start - 1;
+        break;
+      case INDEXREAD_NOTFOUND:
+        after = hit ? hit->docId : it->LastDocId(it->ctx);
+        break;
+      default:
+        // nothing to read, the previous partition reads up to the next one
+        idx->lastId = 0;
+        continue;
+    }
+    // if the partition stopped past the start of the next one, its range is empty
+    idx->lastId = last;
+    last = MIN(after, last);
+  }
+  ((RPIndexIterator *)self->partitions[0].qiter.rootProc)->lastId = last;
+}
+
+/* Run a partition to the end, collecting its results */
+static void rpparallelRunPartition(RPPartition *part) {
+  ResultProcessor *rp = part->qiter.endProc;
+  SearchResult r = {0};
+  while ((part->rc = rp->Next(rp, &r)) == RS_RESULT_OK) {
+    // the index result belongs to the iterator of the partition
+    r.indexResult = NULL;
+    part->results = array_append(part->results, r);
+    memset(&r, 0, sizeof(r));
+  }
+  SearchResult_Destroy(&r);
+}
+
+#ifdef MT_BUILD
+/* A parallel run of the partitions. The calling thread runs partitions as well, and only waits for
+ * the partitions the workers already started, so that queries never wait for workers busy running
+ * other queries. The run is released by the jobs added to the workers, which may start once the
+ * query is done */
+typedef struct {
+  RPParallel *self;
+  size_t next;  // the next partition to run
+  size_t done;  // the number of partitions done
+  uint32_t refcount;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} ParallelRun;
+
+static void parallelRun_Release(ParallelRun *run) {
+  if (__atomic_sub_fetch(&run->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  pthread_mutex_destroy(&run->lock);
+  pthread_cond_destroy(&run->cond);
+  rm_free(run);
+}
+
+static void parallelRun_Work(ParallelRun *run) {
+  size_t n = run->self->numPartitions;
+  size_t ii;
+  while ((ii = __atomic_fetch_add(&run->next, 1, __ATOMIC_ACQ_REL)) < n) {
+    rpparallelRunPartition(&run->self->partitions[ii]);
+    pthread_mutex_lock(&run->lock);
+    if (++run->done == n) {
+      pthread_cond_signal(&run->cond);
+    }
+    pthread_mutex_unlock(&run->lock);
+  }
+}
+
+static void parallelRun_Job(void *arg) {
+  ParallelRun *run = arg;
+  parallelRun_Work(run);
+  parallelRun_Release(run);
+}
+#endif
+
+static void rpparallelRun(RPParallel *self) {
+#ifdef MT_BUILD
+  size_t numJobs = self->numPartitions - 1;
+  ParallelRun *run = rm_calloc(1, sizeof(*run));
+  run->self = self;
+  run->refcount = 1 + numJobs;
+  pthread_mutex_init(&run->lock, NULL);
+  pthread_cond_init(&run->cond, NULL);
+  for (size_t ii = 0; ii < numJobs; ++ii) {
+    if (workersThreadPool_AddWork(parallelRun_Job, run) != 0) {
+      // the partitions left are run by this thread
+      __atomic_sub_fetch(&run->refcount, numJobs - ii, __ATOMIC_ACQ_REL);
+      break;
+    }
+  }
+  parallelRun_Work(run);
+  pthread_mutex_lock(&run->lock);
+  while (run->done < self->numPartitions) {
+    pthread_cond_wait(&run->cond, &run->lock);
+  }
+  pthread_mutex_unlock(&run->lock);
+  parallelRun_Release(run);
+#else
+  for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+    rpparallelRunPartition(&self->partitions[ii]);
+  }
+#endif
+}
+
+/* The status the query ends with once all the results were returned - the first error or timeout
+ * of a partition */
+static int rpparallelStatus(RPParallel *self) {
+  for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+    RPPartition *part = &self->partitions[ii];
+    if (part->rc == RS_RESULT_ERROR) {
+      if (!QueryError_HasError(self->base.base.parent->err)) {
+        QueryError_SetError(self->base.base.parent->err, QueryError_GetCode(&part->status),
+                            QueryError_GetError(&part->status));
+      }
+      return RS_RESULT_ERROR;
+    }
+  }
+  for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+    if (self->partitions[ii].rc == RS_RESULT_TIMEDOUT) {
+      return RS_RESULT_TIMEDOUT;
+    }
+  }
+  return RS_RESULT_EOF;
+}
+
+static int rpparallelNext(ResultProcessor *base, SearchResult *res) {
+  RPParallel *self = (RPParallel *)base;
+
+  if (!self->done) {
+    if (RP_SCTX(base)->flags == RS_CTX_UNSET) {
+      RedisSearchCtx_LockSpecRead(RP_SCTX(base));
+      ConcurrentSearchCtx_ReopenKeys(base->parent->conc);
+    }
+    for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+      self->partitions[ii].qiter.timeoutPolicy = base->parent->timeoutPolicy;
+    }
+    rpparallelSeek(self);
+    rpparallelRun(self);
+    for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+      base->parent->totalResults += self->partitions[ii].qiter.totalResults;
+    }
+    self->done = true;
+  }
+
+  while (self->cur < self->numPartitions) {
+    RPPartition *part = &self->partitions[self->cur];
+    if (self->pos < array_len(part->results)) {
+      RLookupRow oldrow = res->rowdata;
+      *res = part->results[self->pos];
+      // the result is moved
+      memset(&part->results[self->pos++], 0, sizeof(*res));
+      RLookupRow_Cleanup(&oldrow);
+      return RS_RESULT_OK;
+    }
+    self->cur++;
+    self->pos = 0;
+  }
+  return UnlockSpec_and_ReturnRPResult(base, rpparallelStatus(self));
+}
+
+static void rpparallelFree(ResultProcessor *base) {
+  RPParallel *self = (RPParallel *)base;
+  for (size_t ii = 0; ii < self->numPartitions; ++ii) {
+    RPPartition *part = &self->partitions[ii];
+    array_free_ex(part->results, SearchResult_Destroy((SearchResult *)ptr));
+    if (part->qiter.rootProc) {
+      IndexIterator *it = ((RPIndexIterator *)part->qiter.rootProc)->iiter;
+      QITR_FreeChain(&part->qiter);
+      it->Free(it);
+    }
+    QueryError_ClearError(&part->status);
+  }
+  rm_free(self->partitions);
+  rm_free(self);
+}
+
+ResultProcessor *RPParallel_New(const QueryIterator *parent, IndexIterator *root,
+                                size_t numPartitions, t_docId maxDocId) {
+  RPParallel *ret = rm_calloc(1, sizeof(*ret));
+  ret->base.iiter = root;
+  ret->base.lastId = DOCID_MAX;
+  ret->partitions = rm_calloc(numPartitions, sizeof(*ret->partitions));
+  ret->numPartitions = numPartitions;
+  ret->maxDocId = maxDocId;
+  for (size_t ii = 0; ii < numPartitions; ++ii) {
+    RPPartition *part = &ret->partitions[ii];
+    part->qiter.sctx = parent->sctx;
+    part->qiter.err = &part->status;
+    part->qiter.resultLimit = UINT32_MAX;
+    part->results = array_new(SearchResult, 0);
+  }
+  ret->base.base.Next = rpparallelNext;
+  ret->base.base.Free = rpparallelFree;
+  ret->base.base.type = RP_INDEX;
+  return &ret->base.base;
+}
+
+QueryIterator *RPParallel_GetPartition(ResultProcessor *rp, size_t ii) {
+  return &((RPParallel *)rp)->partitions[ii].qiter;
+}
+
+size_t RPParallel_NumPartitions(const ResultProcessor *rp) {
+  return rp->Next == rpparallelNext ? ((const RPParallel *)rp)->numPartitions : 0;
+}
+
+size_t RPIndexIterator_NumDocLookups(const ResultProcessor *rp) {
+  size_t n = ((const RPIndexIterator *)rp)->docLookups;
+  // the partitions of a parallel query look the documents up on their own
+  for (size_t ii = 0; ii < RPParallel_NumPartitions(rp); ++ii) {
+    const ResultProcessor *root = ((const RPParallel *)rp)->partitions[ii].qiter.rootProc;
+    if (root) {
+      n += ((const RPIndexIterator *)root)->docLookups;
+    }
+  }
+  return n;
+}
+
+ResultProcessor *RPIndexIterator_NewPartition(IndexIterator *itr, struct timespec timeout) {
+  ResultProcessor *rp = RPIndexIterator_New(itr, timeout);
+  rp->Next = rpidxNextPartition;
+  rp->NextBatch = NULL;
+  rp->Count = NULL;
+  return rp;
+}
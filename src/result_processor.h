@@ -17,6 +17,8 @@
 #include "rlookup.h"
 #include "extension.h"
 #include "score_explain.h"
+#include "util/perf_counters.h"
+#include "util/block_alloc.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,6 +58,9 @@ typedef enum {
   RP_PROFILE,
   RP_NETWORK,
   RP_METRICS,
+  RP_DOC_VALUES,
+  RP_PREFETCH,
+  RP_FROZEN,
   RP_MAX,
 } ResultProcessorType;
 
@@ -92,12 +97,25 @@ typedef struct {
   struct timespec startTime;
 
   RSTimeoutPolicy timeoutPolicy;
+
+  // Memory allocated by the processors, released all at once with them. See QITR_Alloc
+  BlkAlloc arena;
 } QueryIterator, QueryProcessingCtx;
 
 IndexIterator *QITR_GetRootFilter(QueryIterator *it);
 void QITR_PushRP(QueryIterator *it, struct ResultProcessor *rp);
 void QITR_FreeChain(QueryIterator *qitr);
 
+/**
+ * Allocate zeroed memory which lives as long as the processors of the iterator, and is freed all at
+ * once after them instead of one allocation at a time. It is not thread safe: every partition of a
+ * parallel query has its own iterator. Whatever outlives the processors, such as the results they
+ * yield, must be copied out of it.
+ */
+void *QITR_Alloc(QueryIterator *it, size_t size);
+/* Free the memory allocated with QITR_Alloc. Called once the processors are freed */
+void QITR_FreeArena(QueryIterator *it);
+
 /*
  * SearchResult - the object all the processing chain is working on.
  * It has the indexResult which is what the index scan brought - scores, vectors, flags, etc,
@@ -141,6 +159,18 @@ typedef enum {
   RS_RESULT_MAX
 } RPStatus;
 
+/* The number of results read at once by the processors accumulating all of their results */
+#define RESULT_BATCH_SIZE 1024
+
+/* A batch of search results, read by a single call to NextBatch. The results are allocated once
+ * and reused by every batch read into it */
+typedef struct {
+  SearchResult *results;
+  // the number of results read
+  size_t len;
+  size_t cap;
+} SearchResultBatch;
+
 /**
  * Result processor structure. This should be "Subclassed" by the actual
  * implementations
@@ -168,6 +198,24 @@ typedef struct ResultProcessor {
    */
   int (*Next)(struct ResultProcessor *self, SearchResult *res);
 
+  /**
+   * Optional. Populates up to `batch->cap` results of the batch, and sets `batch->len` to their
+   * number. Returns RS_RESULT_OK if more results may follow, otherwise the code which ended the
+   * batch, as Next would have. The results read before it are in the batch either way. Like Next,
+   * the existing data of the results is not read.
+   *
+   * Processors implementing it read their upstream in batches as well, saving a call per result
+   * and processor. Use RP_NextBatch, which falls back to Next.
+   */
+  int (*NextBatch)(struct ResultProcessor *self, SearchResultBatch *batch);
+
+  /**
+   * Optional. Counts the results the processor would return from now on into `count`, without
+   * building them, and adds them to the total results of the query. Returns the code which ended
+   * the results, as Next would have. Used by the queries which only return the number of results.
+   */
+  int (*Count)(struct ResultProcessor *self, size_t *count);
+
   /** Frees the processor and any internal data related to it. */
   void (*Free)(struct ResultProcessor *self);
 } ResultProcessor;
@@ -179,6 +227,19 @@ typedef struct ResultProcessor {
  */
 void SearchResult_Clear(SearchResult *r);
 
+/* Allocate the results of a batch holding up to `cap` of them */
+void SearchResultBatch_Init(SearchResultBatch *batch, size_t cap);
+
+/* Clear the results read into the batch, so that it may be read into again */
+void SearchResultBatch_Clear(SearchResultBatch *batch);
+
+/* Free the results of the batch */
+void SearchResultBatch_Destroy(SearchResultBatch *batch);
+
+/* Read a batch of results from a processor (see NextBatch), reading them one by one if it does
+ * not read batches */
+int RP_NextBatch(ResultProcessor *rp, SearchResultBatch *batch);
+
 /**
  * This function clears the search result, also freeing its internals. Internal
  * caches are freed. Use this function if `r` will not be used again.
@@ -187,8 +248,22 @@ void SearchResult_Destroy(SearchResult *r);
 
 ResultProcessor *RPIndexIterator_New(IndexIterator *itr, struct timespec timeoutTime);
 
+/* Create the index processor starting the chain of a partition of a parallel query (see
+ * RPParallel_New) */
+ResultProcessor *RPIndexIterator_NewPartition(IndexIterator *itr, struct timespec timeoutTime);
+
+/* Replace the iterator of an index processor by `itr`, built anew from the same query, which reads
+ * on from the docid after the last one read by the previous iterator. NULL detaches the iterator,
+ * freed by its owner, for the processor to be resumed later (see WITHCURSOR FREEZE). The spec is
+ * locked when an iterator is set, and the processor reads nothing if the doc ids were renumbered
+ * since it was detached */
+void RPIndexIterator_Resume(ResultProcessor *rp, IndexIterator *itr);
+
+/* Create a scorer. If `batch` is set and the scoring function has a batch version, the scorer
+ * reads ahead batches of results and scores them at once. The index results of batched results
+ * are not passed downstream, so it should only be set if nothing downstream needs them */
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
-                              const ScoringFunctionArgs *fnargs);
+                              const ScoringFunctionArgs *fnargs, int batch);
 
 ResultProcessor *RPMetricsLoader_New();
 
@@ -229,6 +304,16 @@ ResultProcessor *RPPager_New(size_t offset, size_t limit);
 struct AREQ;
 ResultProcessor *RPLoader_New(struct AREQ *r, RLookup *lk, const RLookupKey **keys, size_t nkeys);
 
+/*******************************************************************************************************************
+ *  Doc Values Processor
+ *
+ * Writes the values of tag fields to the results from the doc values of the fields, instead of loading them from
+ * redis. It only needs the spec to be locked, so unlike the loader it never buffers the results.
+ * `keys[i]` is written from the doc values of `indexes[i]`.
+ *******************************************************************************************************************/
+struct TagIndex;
+ResultProcessor *RPDocValues_New(const RLookupKey **keys, const struct TagIndex **indexes, size_t nkeys);
+
 /** Creates a new Highlight processor */
 ResultProcessor *RPHighlighter_New(const RSSearchOptions *searchopts, const FieldList *fields,
                                    const RLookup *lookup);
@@ -241,7 +326,7 @@ void RP_DumpChain(const ResultProcessor *rp);
  * This processor collects time and count info about the performance of its upstream RP.
  *
  *******************************************************************************************************************/
-ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter);
+ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter, bool withHw);
 
 
 /*******************************************************************************************************************
@@ -252,12 +337,74 @@ ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryIterator *qiter);
  *******************************************************************************************************************/
 ResultProcessor *RPCounter_New();
 
+/*******************************************************************************************************************
+ *  Parallel Processor
+ *
+ * This processor is the root of a query executed in parallel. The docids up to `maxDocId` are
+ * split into ranges, one per partition, and each partition reads its range through a chain of
+ * its own, pushed to the partition's iterator by the caller (see RPParallel_GetPartition). The
+ * chain starts with an index processor created by RPIndexIterator_NewPartition on a clone of
+ * `root`, and must not need the index results downstream. The chains and the clones are owned by
+ * the processor.
+ *
+ * On the first read all the partitions run to the end, on the worker threads if there are any,
+ * and their results are then returned one after another. `root` is not read by the processor,
+ * but is kept for the processors reading the root iterator (see QITR_GetRootFilter)
+ *******************************************************************************************************************/
+ResultProcessor *RPParallel_New(const QueryIterator *parent, IndexIterator *root,
+                                size_t numPartitions, t_docId maxDocId);
+
+/* The iterator holding the chain of a partition */
+QueryIterator *RPParallel_GetPartition(ResultProcessor *rp, size_t idx);
+
+/* The number of partitions of a parallel processor, or 0 if `rp` is not one */
+size_t RPParallel_NumPartitions(const ResultProcessor *rp);
+
+/*******************************************************************************************************************
+ *  Prefetch Processor
+ *
+ * The last processor of a cursor reading its chunks ahead (see WITHCURSOR PREFETCH). RPPrefetch_Fill reads the
+ * next chunk into the buffer of the processor while the client processes the previous one, and the buffered results
+ * are yielded before reading on from the upstream. The code which ended the chunk read ahead is returned once they
+ * were all yielded, along with its error if it is one.
+ *******************************************************************************************************************/
+ResultProcessor *RPPrefetch_New(void);
+
+/* Read up to `limit` results into the buffer of a prefetch processor, counting those still buffered. The spec is
+ * unlocked once they are read */
+void RPPrefetch_Fill(ResultProcessor *rp, uint32_t limit);
+
+/*******************************************************************************************************************
+ *  Frozen Processor
+ *
+ * The remaining results of an idle cursor (see WITHCURSOR FREEZE), packed into a single buffer: the docid and the
+ * score of every result, followed by the values of the keys of the last lookup, written by RSValue_Serialize. The
+ * processor replaces the chain the results were read from, and yields them back as rows holding the values of the
+ * keys, followed by the code which ended the chain.
+ *******************************************************************************************************************/
+
+/* Read the results of the chain of `qiter` to the end into a frozen processor, and make it the only processor of the
+ * chain instead, keeping the values of the keys of `lk`. Returns the number of results read */
+size_t RPFrozen_Freeze(QueryIterator *qiter, const struct RLookup *lk);
+
+/* Drop the results already yielded by a frozen processor from its buffer, once they take most of it */
+void RPFrozen_Shrink(ResultProcessor *rp);
+
 void updateRPIndexTimeout(ResultProcessor *base, struct timespec timeout);
 
 double RPProfile_GetDurationMSec(ResultProcessor *rp);
 uint64_t RPProfile_GetCount(ResultProcessor *rp);
+/* The hardware counters of the calls to the upstream of a profile processor, NULL if they are
+ * not read */
+const PerfCounters *RPProfile_GetHwCounters(ResultProcessor *rp);
+
+/* Add a profile processor after every processor. With `withHw`, they also read the hardware
+ * counters around the calls to their upstream */
+void Profile_AddRPs(QueryIterator *qiter, bool withHw);
 
-void Profile_AddRPs(QueryIterator *qiter);
+/* The documents an index processor, or the partitions of a parallel one, looked up in the doc
+ * table */
+size_t RPIndexIterator_NumDocLookups(const ResultProcessor *rp);
 
 // Return string for RPType
 const char *RPTypeToString(ResultProcessorType type);
@@ -13,6 +13,24 @@
 #include "value.h"
 #include "util/arr.h"
 
+static RLookupKey *RLookup_FindKey(RLookup *lookup, const char *name, size_t name_len);
+
+// Index all the named keys once the lookup is large enough to be worth it, or the new key
+static void indexKey(RLookup *lookup, RLookupKey *key) {
+  if (lookup->index.cap) {
+    // a name that is already indexed keeps resolving to its first key, as with a scan
+    if (!RLookup_FindKey(lookup, key->name, key->name_len)) {
+      NameIndex_Add(&lookup->index, NameIndex_Hash(key->name, key->name_len), key);
+    }
+  } else if (lookup->rowlen >= RLOOKUP_INDEX_MIN_KEYS) {
+    for (RLookupKey *kk = lookup->head; kk; kk = kk->next) {
+      if (kk->name && (!lookup->index.cap || !RLookup_FindKey(lookup, kk->name, kk->name_len))) {
+        NameIndex_Add(&lookup->index, NameIndex_Hash(kk->name, kk->name_len), kk);
+      }
+    }
+  }
+}
+
 // Allocate a new RLookupKey and add it to the RLookup table.
 static RLookupKey *createNewKey(RLookup *lookup, const char *name, size_t name_len, uint32_t flags) {
   RLookupKey *ret = rm_calloc(1, sizeof(*ret));
@@ -34,6 +52,9 @@ static RLookupKey *createNewKey(RLookup *lookup, const char *name, size_t name_l
   // Increase the RLookup table row length. (all rows have the same length).
   ++(lookup->rowlen);
 
+  if (ret->name) {
+    indexKey(lookup, ret);
+  }
   return ret;
 }
 
@@ -70,6 +91,7 @@ static RLookupKey *overrideKey(RLookup *lk, RLookupKey *old, uint32_t flags) {
   if (lk->tail == old) {
     lk->tail = new;
   }
+  NameIndex_Replace(&lk->index, NameIndex_Hash(new->name, new->name_len), old, new);
 
   return new;
 }
@@ -80,6 +102,17 @@ const FieldSpec *findFieldInSpecCache(const RLookup *lookup, const char *name) {
     return NULL;
   }
 
+  if (cc->index.cap) {
+    size_t len = strlen(name);
+    uint32_t h = NameIndex_Hash(name, len), pos = h;
+    for (const FieldSpec *fs; (fs = NameIndex_Next(&cc->index, h, &pos));) {
+      if (!strcmp(fs->name, name)) {
+        return fs;
+      }
+    }
+    return NULL;
+  }
+
   const FieldSpec *fs = NULL;
   for (size_t ii = 0; ii < cc->nfields; ++ii) {
     if (!strcmp(cc->fields[ii].name, name)) {
@@ -126,6 +159,15 @@ static RLookupKey *genKeyFromSpec(RLookup *lookup, const char *name, size_t name
 }
 
 static RLookupKey *RLookup_FindKey(RLookup *lookup, const char *name, size_t name_len) {
+  if (lookup->index.cap) {
+    uint32_t h = NameIndex_Hash(name, name_len), pos = h;
+    for (RLookupKey *kk; (kk = NameIndex_Next(&lookup->index, h, &pos));) {
+      if (kk->name_len == name_len && !strncmp(kk->name, name, name_len)) {
+        return kk;
+      }
+    }
+    return NULL;
+  }
   for (RLookupKey *kk = lookup->head; kk; kk = kk->next) {
     // match `name` to the name of the key
     if (kk->name_len == name_len && !strncmp(kk->name, name, name_len)) {
@@ -306,12 +348,17 @@ void RLookup_WriteKey(const RLookupKey *key, RLookupRow *row, RSValue *v) {
   RLookup_WriteOwnKey(key, row, RSValue_IncrRef(v));
 }
 
-void RLookup_WriteKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *dst, RSValue *v) {
-  // Get the key first
+RLookupKey *RLookup_GetWriteKeyByName(RLookup *lookup, const char *name, size_t len) {
   RLookupKey *k = RLookup_FindKey(lookup, name, len);
   if (!k) {
     k = RLookup_GetKeyEx(lookup, name, len, RLOOKUP_M_WRITE, RLOOKUP_F_NAMEALLOC);
   }
+  return k;
+}
+
+void RLookup_WriteKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *dst, RSValue *v) {
+  // Get the key first
+  RLookupKey *k = RLookup_GetWriteKeyByName(lookup, name, len);
   RLookup_WriteKey(k, dst, v);
 }
 
@@ -320,6 +367,18 @@ void RLookup_WriteOwnKeyByName(RLookup *lookup, const char *name, size_t len, RL
   RSValue_Decref(value);
 }
 
+RSValue *RLookupRow_GetSortable(const RLookupKey *key, const RLookupRow *row) {
+  const RSSortingVector *sv = row->sv;
+  if (RSSortingVector_Type(sv, key->svidx) != RS_SORTABLE_NUM) {
+    RSValue *ret = RSSortingVector_Get(sv, key->svidx);
+    return ret == RS_NullVal() ? NULL : ret;
+  }
+  // The value is cached in the row, which is only ever read by the query owning it
+  RSValue *ret = RSSortingVector_NewValue(sv, key->svidx);
+  RLookup_WriteOwnKey(key, (RLookupRow *)row, ret);
+  return ret;
+}
+
 void RLookupRow_Wipe(RLookupRow *r) {
   for (size_t ii = 0; ii < array_len(r->dyn) && r->ndyn; ++ii) {
     RSValue **vpp = r->dyn + ii;
@@ -389,6 +448,7 @@ void RLookup_Cleanup(RLookup *lk) {
     cur = next;
   }
   IndexSpecCache_Decref(lk->spcache);
+  NameIndex_Free(&lk->index);
 
   lk->head = lk->tail = NULL;
   memset(lk, 0xff, sizeof(*lk));
@@ -410,7 +470,6 @@ static RSValue *hvalToValue(RedisModuleString *src, RLookupCoerceType type) {
 
 static RSValue *jsonValToValue(RedisModuleCtx *ctx, RedisJSON json) {
   size_t len;
-  char *str;
   const char *constStr;
   RedisModuleString *rstr;
   long long ll;
@@ -421,8 +480,7 @@ static RSValue *jsonValToValue(RedisModuleCtx *ctx, RedisJSON json) {
   switch (japi->getType(json)) {
     case JSONType_String:
       japi->getString(json, &constStr, &len);
-      str = rm_strndup(constStr, len);
-      return RS_StringVal(str, len);
+      return RS_NewCopiedString(constStr, len);
     case JSONType_Int:
       japi->getInt(json, &ll);
       return RS_Int64Val(ll);
@@ -517,8 +575,10 @@ RSValue* jsonIterToValueExpanded(RedisModuleCtx *ctx, JSONResultsIterator iter)
 // Return REDISMODULE_OK, and set rsv to the value, if value exists
 // Return REDISMODULE_ERR otherwise
 //
-// Multi value is supported with apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST
-int jsonIterToValue(RedisModuleCtx *ctx, JSONResultsIterator iter, unsigned int apiVersion, RSValue **rsv) {
+// Multi value is supported with apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST. The expanded
+// value, a copy of the whole value for FORMAT EXPAND, is only built if `expand` is set
+int jsonIterToValue(RedisModuleCtx *ctx, JSONResultsIterator iter, unsigned int apiVersion,
+                    bool expand, RSValue **rsv) {
 
   int res = REDISMODULE_ERR;
   RedisModuleString *serialized = NULL;
@@ -553,8 +613,9 @@ int jsonIterToValue(RedisModuleCtx *ctx, JSONResultsIterator iter, unsigned int
     if (json) {
       RSValue *val = jsonValToValue(ctx, json);
       RSValue *otherval = RS_StealRedisStringVal(serialized);
-      RSValue *expand = japi_ver >= 4 ? jsonIterToValueExpanded(ctx, iter) : RS_NullVal();
-      *rsv = RS_DuoVal(val, otherval, expand);
+      RSValue *expanded =
+          expand && japi_ver >= 4 ? jsonIterToValueExpanded(ctx, iter) : RS_NullVal();
+      *rsv = RS_DuoVal(val, otherval, expanded);
       res = REDISMODULE_OK;
     } else if (serialized) {
       RedisModule_FreeString(ctx, serialized);
@@ -599,6 +660,24 @@ static RSValue *replyElemToValue(RedisModuleCallReply *rep, RLookupCoerceType ot
   }
 }
 
+static int openHashKey(RLookupLoadOptions *options, RedisModuleKey **keyobj) {
+  const char *keyPtr = options->dmd ? options->dmd->keyPtr : options->keyPtr;
+  RedisModuleCtx *ctx = options->sctx->redisCtx;
+  RedisModuleString *keyName =
+      RedisModule_CreateString(ctx, keyPtr, strlen(keyPtr));
+  *keyobj = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_OPEN_KEY_NOEFFECTS);
+  RedisModule_FreeString(ctx, keyName);
+  if (!*keyobj) {
+    QueryError_SetCode(options->status, QUERY_ENODOC);
+    return REDISMODULE_ERR;
+  }
+  if (RedisModule_KeyType(*keyobj) != REDISMODULE_KEYTYPE_HASH) {
+    QueryError_SetCode(options->status, QUERY_EREDISKEYTYPE);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
 static int getKeyCommonHash(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOptions *options,
                         RedisModuleKey **keyobj) {
   if (!options->forceLoad && (kk->flags & RLOOKUP_F_VAL_AVAILABLE)) {
@@ -608,20 +687,8 @@ static int getKeyCommonHash(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
 
   const char *keyPtr = options->dmd ? options->dmd->keyPtr : options->keyPtr;
   // In this case, the flag must be obtained via HGET
-  if (!*keyobj) {
-    RedisModuleCtx *ctx = options->sctx->redisCtx;
-    RedisModuleString *keyName =
-        RedisModule_CreateString(ctx, keyPtr, strlen(keyPtr));
-    *keyobj = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_OPEN_KEY_NOEFFECTS);
-    RedisModule_FreeString(ctx, keyName);
-    if (!*keyobj) {
-      QueryError_SetCode(options->status, QUERY_ENODOC);
-      return REDISMODULE_ERR;
-    }
-    if (RedisModule_KeyType(*keyobj) != REDISMODULE_KEYTYPE_HASH) {
-      QueryError_SetCode(options->status, QUERY_EREDISKEYTYPE);
-      return REDISMODULE_ERR;
-    }
+  if (!*keyobj && openHashKey(options, keyobj) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
   }
 
   // Get the actual hash value
@@ -686,12 +753,12 @@ static int getKeyCommonJSON(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
   if (!jsonIter) {
     // The field does not exist and and it isn't `__key`
     if (!strncmp(kk->path, UNDERSCORE_KEY, strlen(UNDERSCORE_KEY))) {
-      rsv = RS_StringVal(rm_strdup(keyPtr), strlen(keyPtr));
+      rsv = RS_NewCopiedString(keyPtr, strlen(keyPtr));
     } else {
       return REDISMODULE_OK;
     }
   } else {
-    int res = jsonIterToValue(ctx, jsonIter, options->sctx->apiVersion, &rsv);
+    int res = jsonIterToValue(ctx, jsonIter, options->sctx->apiVersion, !options->noExpand, &rsv);
     japi->freeIter(jsonIter);
     if (res == REDISMODULE_ERR) {
       return REDISMODULE_OK;
@@ -706,6 +773,86 @@ static int getKeyCommonJSON(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
 typedef int (*GetKeyFunc)(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOptions *options,
                           void **keyobj);
 
+// A hash is scanned once for the fields to load, instead of getting them one by one, if it has at
+// most this many fields for every field to load
+#define HASH_SCAN_MAX_FIELDS_PER_KEY 4
+// The most fields loaded by a scan
+#define HASH_SCAN_MAX_KEYS 64
+
+typedef struct {
+  const RLookupKey **keys;
+  size_t nkeys;
+  bool *found;
+  RLookupRow *dst;
+} RLookup_HashScan_privdata;
+
+static void RLookup_HashScan_callback(RedisModuleKey *key, RedisModuleString *field, RedisModuleString *value, void *privdata) {
+  REDISMODULE_NOT_USED(key);
+  RLookup_HashScan_privdata *pd = privdata;
+  size_t len;
+  const char *name = RedisModule_StringPtrLen(field, &len);
+  // several keys may load the same field
+  for (size_t ii = 0; ii < pd->nkeys; ++ii) {
+    const RLookupKey *kk = pd->keys[ii];
+    if (strlen(kk->path) != len || memcmp(kk->path, name, len)) {
+      continue;
+    }
+    // The value is retained as in RLookup_HGETALL_scan_callback
+    RSValue *rsv = hvalToValue(value, (kk->flags & RLOOKUP_T_NUMERIC) ? RLOOKUP_C_DBL : RLOOKUP_C_STR);
+    RLookup_WriteOwnKey(kk, pd->dst, rsv);
+    pd->found[ii] = true;
+  }
+}
+
+/* Load the fields of a hash with a single scan, as getKeyCommonHash does for every key. Returns
+ * whether they were loaded, or false if the hash is better read field by field. Sets `rc` if they
+ * were */
+static bool loadHashKeysScan(const RLookupKey **keys, size_t nkeys, RLookupRow *dst,
+                             RLookupLoadOptions *options, RedisModuleKey **keyobj, int *rc) {
+  if (nkeys < 2 || nkeys > HASH_SCAN_MAX_KEYS || !isFeatureSupported(RM_SCAN_KEY_API_FIX) || isCrdt) {
+    return false;
+  }
+  // Only the keys which need to be loaded
+  const RLookupKey *toLoad[HASH_SCAN_MAX_KEYS];
+  bool found[HASH_SCAN_MAX_KEYS];
+  size_t n = 0;
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    if (options->forceLoad || !(keys[ii]->flags & RLOOKUP_F_VAL_AVAILABLE)) {
+      found[n] = false;
+      toLoad[n++] = keys[ii];
+    }
+  }
+  if (n < 2) {
+    return false;
+  }
+
+  // The key is left open for the caller to close
+  if (openHashKey(options, keyobj) != REDISMODULE_OK) {
+    *rc = REDISMODULE_ERR;
+    return true;
+  }
+  if (RedisModule_ValueLength(*keyobj) > HASH_SCAN_MAX_FIELDS_PER_KEY * n) {
+    return false;
+  }
+
+  RLookup_HashScan_privdata pd = {.keys = toLoad, .nkeys = n, .found = found, .dst = dst};
+  RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
+  while (RedisModule_ScanKey(*keyobj, cursor, RLookup_HashScan_callback, &pd));
+  RedisModule_ScanCursorDestroy(cursor);
+
+  const char *keyPtr = options->dmd ? options->dmd->keyPtr : options->keyPtr;
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (!found[ii] && !strncmp(toLoad[ii]->path, UNDERSCORE_KEY, strlen(UNDERSCORE_KEY))) {
+      RedisModuleString *keyName = RedisModule_CreateString(options->sctx->redisCtx,
+                                    keyPtr, strlen(keyPtr));
+      RLookup_WriteOwnKey(toLoad[ii], dst, hvalToValue(keyName, RLOOKUP_C_STR));
+      RedisModule_FreeString(options->sctx->redisCtx, keyName);
+    }
+  }
+  *rc = REDISMODULE_OK;
+  return true;
+}
+
 
 static int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
   // Load the document from the schema. This should be simple enough...
@@ -719,6 +866,10 @@ static int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *
   // (success could also be when no value is found and nothing is loaded into `dst`,
   //  for example, with a JSONPath with no matches)
   if (options->nkeys) {
+    if (type == DocumentType_Hash &&
+        loadHashKeysScan(options->keys, options->nkeys, dst, options, (RedisModuleKey **)&key, &rc)) {
+      goto done;
+    }
     for (size_t ii = 0; ii < options->nkeys; ++ii) {
       const RLookupKey *kk = options->keys[ii];
       if (getKey(kk, dst, options, &key) != REDISMODULE_OK) {
@@ -889,7 +1040,7 @@ static int RLookup_JSON_GetAll(RLookup *it, RLookupRow *dst, RLookupLoadOptions
   }
 
   RSValue *vptr;
-  int res = jsonIterToValue(ctx, jsonIter, options->sctx->apiVersion, &vptr);
+  int res = jsonIterToValue(ctx, jsonIter, options->sctx->apiVersion, !options->noExpand, &vptr);
   japi->freeIter(jsonIter);
   if (res == REDISMODULE_ERR) {
     goto done;
@@ -929,18 +1080,23 @@ int RLookup_LoadDocument(RLookup *it, RLookupRow *dst, RLookupLoadOptions *optio
 int RLookup_LoadRuleFields(RedisModuleCtx *ctx, RLookup *it, RLookupRow *dst, IndexSpec *spec, const char *keyptr) {
   SchemaRule *rule = spec->rule;
 
-  // create rlookupkeys
-  int nkeys = array_len(rule->filter_fields);
-  RLookupKey **keys = rm_malloc(nkeys * sizeof(*keys));
-  for (int i = 0; i < nkeys; ++i) {
+  // create rlookupkeys. The lookup may be shared by the rules of several specs matching the same
+  // document: a field loaded already for another rule, from the same path, is not loaded again
+  int nfields = array_len(rule->filter_fields), nkeys = 0;
+  RLookupKey **keys = rm_malloc(nfields * sizeof(*keys));
+  for (int i = 0; i < nfields; ++i) {
     int idx = rule->filter_fields_index[i];
-    if (idx == -1) {
-      keys[i] = createNewKey(it, rule->filter_fields[i], strlen(rule->filter_fields[i]), RLOOKUP_F_NOFLAGS);
+    FieldSpec *fs = idx == -1 ? NULL : spec->fields + idx;
+    const char *name = fs ? fs->name : rule->filter_fields[i];
+    const char *path = fs ? fs->path : name;
+    size_t len = strlen(name);
+    RLookupKey *kk = RLookup_FindKey(it, name, len);
+    if (kk && !strcmp(kk->path, path)) {
       continue;
     }
-    FieldSpec *fs = spec->fields + idx;
-    keys[i] = createNewKey(it, fs->name, strlen(fs->name), RLOOKUP_F_NOFLAGS);
-    keys[i]->path = fs->path;
+    kk = createNewKey(it, name, len, RLOOKUP_F_NOFLAGS);
+    kk->path = path;
+    keys[nkeys++] = kk;
   }
 
   // load
@@ -954,7 +1110,7 @@ int RLookup_LoadRuleFields(RedisModuleCtx *ctx, RLookup *it, RLookupRow *dst, In
                             .status = &status,
                             .forceLoad = 1,
                             .mode = RLOOKUP_LOAD_KEYLIST };
-  int rv = loadIndividualKeys(it, dst, &opt);
+  int rv = nkeys ? loadIndividualKeys(it, dst, &opt) : REDISMODULE_OK;
   QueryError_ClearError(&status);
   rm_free(keys);
   return rv;
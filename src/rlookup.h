@@ -14,6 +14,7 @@
 #include "value.h"
 #include "sortable.h"
 #include "util/arr.h"
+#include "util/name_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -103,8 +104,14 @@ typedef struct RLookup {
   // If present, then GetKey will consult this list if the value is not found in
   // the existing list of keys.
   IndexSpecCache *spcache;
+
+  // The keys by their names, built once there are RLOOKUP_INDEX_MIN_KEYS of them. Smaller
+  // lookups are scanned
+  NameIndex index;
 } RLookup;
 
+#define RLOOKUP_INDEX_MIN_KEYS 16
+
 // If the key cannot be found, do not mark it as an error, but create it and
 // mark it as F_UNRESOLVED
 #define RLOOKUP_OPT_UNRESOLVED_OK 0x01
@@ -281,6 +288,18 @@ void RLookup_WriteKeyByName(RLookup *lookup, const char *name, size_t len, RLook
  */
 void RLookup_WriteOwnKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *row, RSValue *value);
 
+/**
+ * Get the key which WriteKeyByName writes `name` to, creating it if needed. This is useful for
+ * writing the same dynamic key in many rows
+ */
+RLookupKey *RLookup_GetWriteKeyByName(RLookup *lookup, const char *name, size_t len);
+
+/**
+ * Get the value of a sortable key from the sorting vector of the row. A number is created as an
+ * RSValue the first time it is read, and kept with the dynamic values of the row
+ */
+RSValue *RLookupRow_GetSortable(const RLookupKey *key, const RLookupRow *row);
+
 /** Get a value from the row, provided the key.
  *
  * This does not actually "search" for the key, but simply performs array
@@ -299,16 +318,26 @@ static inline RSValue *RLookup_GetItem(const RLookupKey *key, const RLookupRow *
   if (!ret) {
     if (key->flags & RLOOKUP_F_SVSRC) {
       if (row->sv && row->sv->len > key->svidx) {
-        ret = row->sv->values[key->svidx];
-        if (ret != NULL && ret == RS_NullVal()) {
-          ret = NULL;
-        }
+        ret = RLookupRow_GetSortable(key, row);
       }
     }
   }
   return ret;
 }
 
+/**
+ * Set `n` to the value of the key if it is a number of the sorting vector of the row, without
+ * creating an RSValue for it. Returns false otherwise, leaving the value to RLookup_GetItem
+ */
+static inline bool RLookup_GetSortableNumber(const RLookupKey *key, const RLookupRow *row,
+                                             double *n) {
+  if (!(key->flags & RLOOKUP_F_SVSRC) || !row->sv ||
+      (row->dyn && array_len(row->dyn) > key->dstidx && row->dyn[key->dstidx])) {
+    return false;
+  }
+  return RSSortingVector_GetNumber(row->sv, key->svidx, n);
+}
+
 /**
  * Wipes the row, retaining its memory but decrefing any included values.
  * This does not free all the memory consumed by the row, but simply resets
@@ -367,6 +396,12 @@ typedef struct {
    */
   int forceString;
 
+  /**
+   * Don't build the expanded values of the multi-value JSON fields (the third value of their duo),
+   * which are only replied with FORMAT EXPAND
+   */
+  int noExpand;
+
   struct QueryError *status;
 } RLookupLoadOptions;
 
@@ -408,7 +443,8 @@ static inline const RLookupKey *RLookup_FindKeyWith(const RLookup *l, uint32_t f
 int RLookup_LoadRuleFields(RedisModuleCtx *ctx, RLookup *it, RLookupRow *dst, IndexSpec *sp, const char *keyptr);
 
 
-int jsonIterToValue(RedisModuleCtx *ctx, JSONResultsIterator iter, unsigned int apiVersion, RSValue **rsv);
+int jsonIterToValue(RedisModuleCtx *ctx, JSONResultsIterator iter, unsigned int apiVersion,
+                    bool expand, RSValue **rsv);
 
 
 /**
@@ -14,24 +14,43 @@
 
 #ifdef REDIS_MODULE_TARGET /* Set this when compiling your code as a module */
 
+#ifdef RS_ALLOC_STATS
+#include "alloc_stats.h"
+#define RM_ALLOC_STATS_ALLOC(p) AllocStats_OnAlloc(p)
+#define RM_ALLOC_STATS_FREE(p) AllocStats_OnFree(p)
+#else
+#define RM_ALLOC_STATS_ALLOC(p)
+#define RM_ALLOC_STATS_FREE(p)
+#endif
+
 static inline void *rm_malloc(size_t n) {
-  return RedisModule_Alloc(n);
+  void *p = RedisModule_Alloc(n);
+  RM_ALLOC_STATS_ALLOC(p);
+  return p;
 }
 static inline void *rm_calloc(size_t nelem, size_t elemsz) {
-  return RedisModule_Calloc(nelem, elemsz);
+  void *p = RedisModule_Calloc(nelem, elemsz);
+  RM_ALLOC_STATS_ALLOC(p);
+  return p;
 }
 static inline void *rm_realloc(void *p, size_t n) {
+  RM_ALLOC_STATS_FREE(p);
   if (n == 0) {
     RedisModule_Free(p);
     return NULL;
   }
-  return RedisModule_Realloc(p, n);
+  p = RedisModule_Realloc(p, n);
+  RM_ALLOC_STATS_ALLOC(p);
+  return p;
 }
 static inline void rm_free(void *p) {
+  RM_ALLOC_STATS_FREE(p);
   RedisModule_Free(p);
 }
 static inline char *rm_strdup(const char *s) {
-  return RedisModule_Strdup(s);
+  char *p = RedisModule_Strdup(s);
+  RM_ALLOC_STATS_ALLOC(p);
+  return p;
 }
 
 static char *rm_strndup(const char *s, size_t n) {
@@ -6,6 +6,10 @@
 
 #include "rs_geo.h"
 
+#include "util/minmax.h"
+
+#include <math.h>
+
 int encodeGeo(double lon, double lat, double *bits) {
   GeoHashBits hash;
   int rv = geohashEncodeWGS84(lon, lat, GEO_STEP_MAX, &hash);
@@ -96,6 +100,118 @@ void calcRanges(double longitude, double latitude, double radius_meters, GeoHash
   calcAllNeighbors(&georadius, longitude, latitude, radius_meters, ranges);
 }
 
+/* Slack (in meters) added to the radius when testing cells against it, so rounding never drops a
+ * cell holding a point right on the circle */
+#define GEO_COVER_SLACK 1.0
+
+#define GEO_DEG_RAD(d) ((d) * M_PI / 180.0)
+#define GEO_RAD_DEG(r) ((r) * 180.0 / M_PI)
+
+/* The shortest distance between a point and any point of a cell. Points east or west of the cell
+ * are nearest to its closer meridian edge, at the latitude where that meridian comes closest to
+ * them. Returns 0 for points more than a quarter of the globe away in longitude, which only
+ * matters for huge radii */
+static double cellMinDistance(double lon, double lat, const GeoHashArea *a) {
+  if (lon >= a->longitude.min && lon <= a->longitude.max) {
+    double nlat = MIN(MAX(lat, a->latitude.min), a->latitude.max);
+    return geohashGetDistance(lon, lat, lon, nlat);
+  }
+  double west = fmod(a->longitude.min - lon + 720, 360);
+  double east = fmod(lon - a->longitude.max + 720, 360);
+  double dlon = MIN(west, east);
+  double elon = west < east ? a->longitude.min : a->longitude.max;
+  if (dlon >= 90) {
+    return 0;
+  }
+  double nlat = GEO_RAD_DEG(atan(tan(GEO_DEG_RAD(lat)) / cos(GEO_DEG_RAD(dlon))));
+  nlat = MIN(MAX(nlat, a->latitude.min), a->latitude.max);
+  return geohashGetDistance(lon, lat, elon, nlat);
+}
+
+/* Whether all the corners of a cell are inside the circle. Cells are small compared to the globe,
+ * so this is a good enough test for keeping a cell whole rather than subdividing it */
+static int cellWithinRadius(double lon, double lat, double radius, const GeoHashArea *a) {
+  return geohashGetDistance(lon, lat, a->longitude.min, a->latitude.min) <= radius &&
+         geohashGetDistance(lon, lat, a->longitude.min, a->latitude.max) <= radius &&
+         geohashGetDistance(lon, lat, a->longitude.max, a->latitude.min) <= radius &&
+         geohashGetDistance(lon, lat, a->longitude.max, a->latitude.max) <= radius;
+}
+
+static int cmpGeoHashRange(const void *p1, const void *p2) {
+  const GeoHashRange *r1 = p1, *r2 = p2;
+  return r1->min < r2->min ? -1 : r1->min > r2->min ? 1 : 0;
+}
+
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoHashRange *ranges) {
+  // Cells waiting to be either kept or subdivided, in a ring ordered by step, so the coarse
+  // cells are refined first. Together with the kept cells there are never more than
+  // GEO_COVER_MAX_CELLS of them.
+  GeoHashBits queue[GEO_COVER_MAX_CELLS];
+  GeoHashBits cells[GEO_COVER_MAX_CELLS];
+  size_t head = 0, queued = 0, ncells = 0;
+  double radius = radius_meters + GEO_COVER_SLACK;
+
+  // The four step 1 cells are the quarters of the globe
+  for (uint64_t i = 0; i < 4; ++i) {
+    queue[queued++] = (GeoHashBits){.bits = i, .step = 1};
+  }
+
+  while (queued) {
+    GeoHashBits hash = queue[head];
+    head = (head + 1) % GEO_COVER_MAX_CELLS;
+    --queued;
+
+    GeoHashArea area;
+    geohashDecodeWGS84(hash, &area);
+    if (cellMinDistance(longitude, latitude, &area) > radius) {
+      continue;
+    }
+    if (hash.step == GEO_STEP_MAX || cellWithinRadius(longitude, latitude, radius, &area)) {
+      cells[ncells++] = hash;
+      continue;
+    }
+
+    GeoHashBits children[4];
+    size_t nchildren = 0;
+    for (uint64_t i = 0; i < 4; ++i) {
+      GeoHashBits child = {.bits = (hash.bits << 2) | i, .step = hash.step + 1};
+      GeoHashArea childArea;
+      geohashDecodeWGS84(child, &childArea);
+      if (cellMinDistance(longitude, latitude, &childArea) <= radius) {
+        children[nchildren++] = child;
+      }
+    }
+    if (ncells + queued + nchildren > GEO_COVER_MAX_CELLS) {
+      // Out of budget, this cell stays as is
+      cells[ncells++] = hash;
+      continue;
+    }
+    for (size_t i = 0; i < nchildren; ++i) {
+      queue[(head + queued++) % GEO_COVER_MAX_CELLS] = children[i];
+    }
+  }
+
+  for (size_t i = 0; i < ncells; ++i) {
+    GeoHashFix52Bits min, max;
+    scoresOfGeoHashBox(cells[i], &min, &max);
+    ranges[i].min = min;
+    ranges[i].max = max;
+  }
+  qsort(ranges, ncells, sizeof(*ranges), cmpGeoHashRange);
+
+  // Cells are ordered along the geohash curve, so neighbors on it share a range
+  size_t nranges = 0;
+  for (size_t i = 0; i < ncells; ++i) {
+    if (nranges && ranges[nranges - 1].max >= ranges[i].min) {
+      ranges[nranges - 1].max = MAX(ranges[nranges - 1].max, ranges[i].max);
+    } else {
+      ranges[nranges++] = ranges[i];
+    }
+  }
+  return nranges;
+}
+
 bool isWithinRadiusLonLat(double lon1, double lat1, double lon2, double lat2, double radius,
                           double *distance) {
   double dist = geohashGetDistance(lon1, lat1, lon2, lat2);
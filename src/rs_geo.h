@@ -11,6 +11,9 @@
 
 #define GEO_RANGE_COUNT 9
 
+/* The maximal number of geohash cells a radius covering is made of */
+#define GEO_COVER_MAX_CELLS 8
+
 /*
  * Encode longetude and latitude doubles into a single double.
  * This value can be sorted and used for distance.
@@ -31,6 +34,18 @@ int  decodeGeo(double bits, double *xy);
 void calcRanges(double longitude, double latitude, double radius_meters,
                 GeoHashRange *ranges);
 
+/*
+ * Cover the circle of `radius_meters` around a point with at most GEO_COVER_MAX_CELLS geohash
+ * cells of varying steps. Cells fully inside the circle are kept whole and cells on its border
+ * are subdivided while the cell budget allows it, so the covering hugs the circle much tighter
+ * than the fixed step neighbor squares of `calcRanges`.
+ *
+ * The score ranges of the cells are written to `ranges` (which must hold GEO_COVER_MAX_CELLS
+ * entries) sorted, with adjacent cells merged into a single range. Returns the number of ranges.
+ */
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoHashRange *ranges);
+
 /*
  * Return true is distance is smaller than radius. radius must be in meters.
  * If `distance' is not NULL, the distance value is returned.
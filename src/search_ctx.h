@@ -40,6 +40,8 @@ typedef struct RedisSearchCtx {
   unsigned int apiVersion; // API Version to allow for backward compatibility / alternative functionality
   unsigned int expanded; // Reply format
   RSContextFlags flags;
+  // When set, the holds of the spec lock are accounted in it (for FT.PROFILE)
+  ConcurrentYieldCtl *lockStats;
 } RedisSearchCtx;
 
 #define SEARCH_CTX_SORTABLES(ctx) ((ctx && ctx->spec) ? ctx->spec->sortables : NULL)
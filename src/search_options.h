@@ -104,6 +104,10 @@ typedef struct {
   const StopWordList *stopwords;
   dict *params;
 
+  // The filter of the KNN clause, shared with the queries of the other vectors of a MULTIVECTOR
+  // query
+  struct SharedVectorFilter *vectorFilter;
+
   /** Legacy options */
   struct {
     NumericFilter **filters;
@@ -0,0 +1,228 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "slow_log.h"
+#include "config.h"
+#include "rmalloc.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/param.h>
+#include <time.h>
+
+static struct {
+  pthread_mutex_t lock;
+  SlowLogEntry *entries;  // a ring of `cap` entries, the latest one before `next`
+  size_t cap;
+  size_t len;
+  size_t next;
+  long long nextId;
+} slowLog_g = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static size_t sampleCounter_g = 0;
+
+bool SlowLog_IsSlow(double totalTime) {
+  long long threshold = RSGlobalConfig.slowLogThreshold;
+  return threshold >= 0 && totalTime >= threshold;
+}
+
+bool SlowLog_SamplePlan(void) {
+  size_t sample = RSGlobalConfig.slowLogPlanSample;
+  if (!sample || RSGlobalConfig.slowLogThreshold < 0) {
+    return false;
+  }
+  return __atomic_fetch_add(&sampleCounter_g, 1, __ATOMIC_RELAXED) % sample == 0;
+}
+
+static inline bool isWordChar(char c) {
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+char *SlowLog_NormalizeQuery(const char *query, size_t len) {
+  char buf[SLOWLOG_QUERY_MAX_LEN + 4];
+  size_t n = 0;
+  const char *p = query, *end = query + len;
+  bool space = false;
+#define PUT(c)                         \
+  if (n < SLOWLOG_QUERY_MAX_LEN) {     \
+    buf[n++] = (c);                    \
+  }
+
+  while (p < end && n < SLOWLOG_QUERY_MAX_LEN) {
+    char c = *p;
+    if (isspace((unsigned char)c)) {
+      space = true;
+      p++;
+      continue;
+    }
+    if (space && n) {
+      PUT(' ');
+    }
+    space = false;
+    bool afterWord = p > query && isWordChar(p[-1]);
+
+    if (c == '"' || c == '\'') {
+      // a quoted string, up to its closing quote
+      for (p++; p < end && *p != c; p++) {
+        if (*p == '\\') {
+          p++;
+        }
+      }
+      p = MIN(p + 1, end);
+      PUT(c);
+      PUT('?');
+      PUT(c);
+    } else if (c == '{') {
+      // the values of a tag
+      while (p < end && *p != '}') {
+        if (*p == '\\') {
+          p++;
+        }
+        p++;
+      }
+      p = MIN(p + 1, end);
+      PUT('{');
+      PUT('?');
+      PUT('}');
+    } else if (!afterWord && (isdigit((unsigned char)c) ||
+                              ((c == '-' || c == '+' || c == '.') && p + 1 < end &&
+                               isdigit((unsigned char)p[1])))) {
+      // a number, including its sign and exponent
+      for (p++; p < end && (isalnum((unsigned char)*p) || *p == '.' ||
+                            ((*p == '-' || *p == '+') && (p[-1] == 'e' || p[-1] == 'E')));
+           p++) {
+      }
+      PUT('?');
+    } else {
+      PUT(c);
+      p++;
+    }
+  }
+#undef PUT
+
+  if (p < end) {
+    memcpy(buf + n, "...", 3);
+    n += 3;
+  }
+  return rm_strndup(buf, n);
+}
+
+static void slowLogEntry_Free(SlowLogEntry *e) {
+  rm_free(e->index);
+  rm_free(e->query);
+  rm_free(e->plan);
+  rm_free(e->trace);
+}
+
+// The i'th latest entry, starting from 0
+static inline SlowLogEntry *slowLog_Get(size_t i) {
+  return &slowLog_g.entries[(slowLog_g.next + slowLog_g.cap - 1 - i) % slowLog_g.cap];
+}
+
+/* Resize the ring to the configured length, keeping the latest entries which fit. Called with the
+ * lock held */
+static void slowLog_Fit() {
+  size_t cap = RSGlobalConfig.slowLogMaxLen;
+  if (cap == slowLog_g.cap) {
+    return;
+  }
+  SlowLogEntry *entries = cap ? rm_calloc(cap, sizeof(*entries)) : NULL;
+  size_t len = MIN(slowLog_g.len, cap);
+  for (size_t i = 0; i < slowLog_g.len; i++) {
+    SlowLogEntry *e = slowLog_Get(i);
+    if (i < len) {
+      entries[len - 1 - i] = *e;
+    } else {
+      slowLogEntry_Free(e);
+    }
+  }
+  rm_free(slowLog_g.entries);
+  slowLog_g.entries = entries;
+  slowLog_g.cap = cap;
+  slowLog_g.len = len;
+  slowLog_g.next = cap ? len % cap : 0;
+}
+
+void SlowLog_Add(SlowLogEntry *entry) {
+  pthread_mutex_lock(&slowLog_g.lock);
+  slowLog_Fit();
+  if (!slowLog_g.cap) {
+    pthread_mutex_unlock(&slowLog_g.lock);
+    slowLogEntry_Free(entry);
+    return;
+  }
+  entry->id = slowLog_g.nextId++;
+  entry->timestamp = time(NULL);
+  SlowLogEntry *e = &slowLog_g.entries[slowLog_g.next];
+  if (slowLog_g.len == slowLog_g.cap) {
+    slowLogEntry_Free(e);
+  } else {
+    slowLog_g.len++;
+  }
+  *e = *entry;
+  slowLog_g.next = (slowLog_g.next + 1) % slowLog_g.cap;
+  pthread_mutex_unlock(&slowLog_g.lock);
+}
+
+static void slowLogEntry_Reply(RedisModule_Reply *reply, const SlowLogEntry *e) {
+  RedisModule_Reply_Map(reply);
+  RedisModule_ReplyKV_LongLong(reply, "id", e->id);
+  RedisModule_ReplyKV_LongLong(reply, "timestamp", e->timestamp);
+  RedisModule_ReplyKV_SimpleString(reply, "index", e->index);
+  RedisModule_ReplyKV_StringBuffer(reply, "query", e->query, strlen(e->query));
+  RedisModule_ReplyKV_LongLong(reply, "dialect", e->dialect);
+  RedisModule_ReplyKV_Double(reply, "parse_time", e->parseTime);
+  RedisModule_ReplyKV_Double(reply, "pipeline_time", e->pipelineTime);
+  RedisModule_ReplyKV_Double(reply, "execution_time", e->execTime);
+  RedisModule_ReplyKV_Double(reply, "total_time", e->totalTime);
+  RedisModule_ReplyKV_LongLong(reply, "results", e->numResults);
+  RedisModule_ReplyKV_LongLong(reply, "timed_out", e->timedOut);
+  if (e->plan) {
+    RedisModule_ReplyKV_StringBuffer(reply, "plan", e->plan, strlen(e->plan));
+  } else {
+    RedisModule_ReplyKV_Null(reply, "plan");
+  }
+  if (e->trace) {
+    RedisModule_ReplyKV_StringBuffer(reply, "trace", e->trace, strlen(e->trace));
+  } else {
+    RedisModule_ReplyKV_Null(reply, "trace");
+  }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+void SlowLog_Reply(RedisModule_Reply *reply, long long count) {
+  pthread_mutex_lock(&slowLog_g.lock);
+  slowLog_Fit();
+  size_t n = slowLog_g.len;
+  if (count >= 0 && count < n) {
+    n = count;
+  }
+  RedisModule_Reply_Array(reply);
+  for (size_t i = 0; i < n; i++) {
+    slowLogEntry_Reply(reply, slowLog_Get(i));
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+  pthread_mutex_unlock(&slowLog_g.lock);
+}
+
+size_t SlowLog_Len(void) {
+  pthread_mutex_lock(&slowLog_g.lock);
+  slowLog_Fit();
+  size_t len = slowLog_g.len;
+  pthread_mutex_unlock(&slowLog_g.lock);
+  return len;
+}
+
+void SlowLog_Reset(void) {
+  pthread_mutex_lock(&slowLog_g.lock);
+  for (size_t i = 0; i < slowLog_g.len; i++) {
+    slowLogEntry_Free(slowLog_Get(i));
+  }
+  slowLog_g.len = 0;
+  slowLog_g.next = 0;
+  pthread_mutex_unlock(&slowLog_g.lock);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "reply.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The longest normalized query kept in an entry, longer ones are truncated
+#define SLOWLOG_QUERY_MAX_LEN 1024
+// The longest plan kept in an entry, the iterators which do not fit are elided
+#define SLOWLOG_PLAN_MAX_LEN 2048
+
+/* A query which took longer than SLOWLOG_THRESHOLD, see FT.SLOWLOG. The times are in
+ * milliseconds */
+typedef struct {
+  long long id;         // set by SlowLog_Add
+  long long timestamp;  // unix time in seconds, set by SlowLog_Add
+  char *index;
+  char *query;          // normalized with SlowLog_NormalizeQuery
+  unsigned dialect;
+  double parseTime;     // from the command to the iterators, including the wait for a worker
+  double pipelineTime;  // building the result processors
+  double execTime;      // reading and replying with the results
+  double totalTime;
+  size_t numResults;
+  bool timedOut;
+  char *plan;           // the iterators with their estimated and actual results, or NULL
+  char *trace;          // the spans of a distributed query traced by the coordinator, or NULL
+} SlowLogEntry;
+
+/* The slow log is a ring buffer of the last SLOWLOG_MAX_LEN slow queries. It is shared by the
+ * main thread and the workers, so it has a lock of its own, which is only taken for the queries
+ * which are slow */
+
+/* Whether a query of `totalTime` milliseconds is slow enough to be logged */
+bool SlowLog_IsSlow(double totalTime);
+
+/* Whether the query about to be executed should keep the actual results of its iterators, for
+ * the plan of its entry if it turns out to be slow. One query of every SLOWLOG_PLAN_SAMPLE is */
+bool SlowLog_SamplePlan(void);
+
+/* Copy `query` with its whitespace collapsed and its numbers, quoted strings and tags replaced by
+ * '?', so that the queries which only differ by their values are logged alike. The copy is
+ * allocated with rm_malloc */
+char *SlowLog_NormalizeQuery(const char *query, size_t len);
+
+/* Add an entry to the log, taking ownership of its strings. The oldest entry is dropped once the
+ * log is full */
+void SlowLog_Add(SlowLogEntry *entry);
+
+/* Reply with the latest `count` entries, the latest first. A negative count replies with all */
+void SlowLog_Reply(RedisModule_Reply *reply, long long count);
+
+size_t SlowLog_Len(void);
+
+void SlowLog_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,249 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "sort_index.h"
+#include "sortable.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <stdlib.h>
+
+// The deleted ids the runs may hold beyond the live documents before the index is rebuilt
+#define SORT_INDEX_MAX_DEAD(docs) ((docs)->size + 1024)
+
+typedef struct {
+  t_docId id;
+  const RSValue *value;
+} SortIndexEntry;
+
+/* By value, missing values last, and then by id */
+static int cmpEntries(const void *p1, const void *p2) {
+  const SortIndexEntry *e1 = p1, *e2 = p2;
+  if (e1->value && e2->value) {
+    int rc = RSValue_Cmp(e1->value, e2->value, NULL);
+    if (rc) {
+      return rc;
+    }
+  } else if (e1->value || e2->value) {
+    return e1->value ? -1 : 1;
+  }
+  return e1->id < e2->id ? -1 : e1->id > e2->id ? 1 : 0;
+}
+
+SortIndex *NewSortIndex(uint16_t fieldIndex, int16_t sortIdx) {
+  SortIndex *si = rm_calloc(1, sizeof(*si));
+  si->runs = array_new(SortIndexRun, 4);
+  si->fieldIndex = fieldIndex;
+  si->sortIdx = sortIdx;
+  pthread_mutex_init(&si->lock, NULL);
+  return si;
+}
+
+static void SortIndex_FreeRuns(SortIndex *si) {
+  for (size_t i = 0; i < array_len(si->runs); ++i) {
+    array_free(si->runs[i].ids);
+  }
+  array_clear(si->runs);
+  si->numIds = 0;
+  si->maxDocId = 0;
+}
+
+void SortIndex_Free(SortIndex *si) {
+  if (!si) {
+    return;
+  }
+  SortIndex_FreeRuns(si);
+  array_free(si->runs);
+  pthread_mutex_destroy(&si->lock);
+  rm_free(si);
+}
+
+void SortIndex_Clear(SortIndex *si) {
+  pthread_mutex_lock(&si->lock);
+  SortIndex_FreeRuns(si);
+  pthread_mutex_unlock(&si->lock);
+}
+
+const RSValue *SortIndex_Value(const SortIndex *si, const DocTable *docs, t_docId docId) {
+  const RSDocumentMetadata *dmd = DocTable_Borrow(docs, docId);
+  if (!dmd) {
+    return NULL;
+  }
+  // the vector is kept by the table while the spec is locked
+  const RSValue *v = dmd->sortVector ? RSSortingVector_Get(dmd->sortVector, si->sortIdx) : NULL;
+  DMD_Return(dmd);
+  return v == RS_NullVal() ? NULL : v;
+}
+
+/* Make a run of sorted entries */
+static SortIndexRun newRun(const SortIndexEntry *entries, size_t n) {
+  SortIndexRun run = {.ids = array_newlen(t_docId, n), .numValued = 0};
+  for (size_t i = 0; i < n; ++i) {
+    run.ids[i] = entries[i].id;
+    run.numValued += !!entries[i].value;
+  }
+  return run;
+}
+
+/* Append the entries of the live documents of a run */
+static SortIndexEntry *readRun(const SortIndex *si, const DocTable *docs, const SortIndexRun *run,
+                               SortIndexEntry *entries) {
+  for (size_t i = 0; i < array_len(run->ids); ++i) {
+    t_docId id = run->ids[i];
+    if (DocTable_IsLive(docs, id)) {
+      SortIndexEntry e = {.id = id, .value = SortIndex_Value(si, docs, id)};
+      array_append(entries, e);
+    }
+  }
+  return entries;
+}
+
+/* Merge the two last runs, dropping the deleted documents */
+static void mergeLastRuns(SortIndex *si, const DocTable *docs) {
+  size_t n = array_len(si->runs);
+  SortIndexRun *r1 = si->runs + n - 2, *r2 = si->runs + n - 1;
+  SortIndexEntry *e1 = readRun(si, docs, r1, array_new(SortIndexEntry, array_len(r1->ids)));
+  SortIndexEntry *e2 = readRun(si, docs, r2, array_new(SortIndexEntry, array_len(r2->ids)));
+  size_t n1 = array_len(e1), n2 = array_len(e2);
+
+  SortIndexEntry *merged = rm_malloc((n1 + n2) * sizeof(*merged));
+  size_t i = 0, j = 0, k = 0;
+  while (i < n1 && j < n2) {
+    merged[k++] = cmpEntries(e1 + i, e2 + j) <= 0 ? e1[i++] : e2[j++];
+  }
+  while (i < n1) merged[k++] = e1[i++];
+  while (j < n2) merged[k++] = e2[j++];
+
+  si->numIds -= array_len(r1->ids) + array_len(r2->ids);
+  array_free(r1->ids);
+  array_free(r2->ids);
+  array_pop(si->runs);
+  *r1 = newRun(merged, k);
+  si->numIds += k;
+
+  rm_free(merged);
+  array_free(e1);
+  array_free(e2);
+}
+
+/* Sort the documents added since the index was extended into a new run */
+static void SortIndex_Extend(SortIndex *si, const DocTable *docs) {
+  SortIndexEntry *entries = array_new(SortIndexEntry, 16);
+  for (t_docId id = DocTable_NextLive(docs, si->maxDocId + 1); id && id <= docs->maxDocId;
+       id = DocTable_NextLive(docs, id + 1)) {
+    SortIndexEntry e = {.id = id, .value = SortIndex_Value(si, docs, id)};
+    array_append(entries, e);
+  }
+  si->maxDocId = docs->maxDocId;
+
+  size_t n = array_len(entries);
+  if (n) {
+    qsort(entries, n, sizeof(*entries), cmpEntries);
+    SortIndexRun run = newRun(entries, n);
+    array_append(si->runs, run);
+    si->numIds += n;
+    // keep every run at least twice the size of the following one
+    while (array_len(si->runs) > 1 &&
+           array_len(si->runs[array_len(si->runs) - 2].ids) <=
+               2 * array_len(array_tail(si->runs).ids)) {
+      mergeLastRuns(si, docs);
+    }
+  }
+  array_free(entries);
+}
+
+void SortIndex_Acquire(SortIndex *si, const DocTable *docs, uint64_t docIdsEpoch) {
+  pthread_mutex_lock(&si->lock);
+  if (si->docIdsEpoch != docIdsEpoch || si->numIds > docs->size + SORT_INDEX_MAX_DEAD(docs)) {
+    SortIndex_FreeRuns(si);
+    si->docIdsEpoch = docIdsEpoch;
+  }
+  if (docs->maxDocId > si->maxDocId) {
+    SortIndex_Extend(si, docs);
+  }
+}
+
+void SortIndex_Release(SortIndex *si) {
+  pthread_mutex_unlock(&si->lock);
+}
+
+size_t SortIndex_MemUsage(const SortIndex *si) {
+  return sizeof(*si) + array_len(si->runs) * sizeof(*si->runs) + si->numIds * sizeof(t_docId);
+}
+
+/* The id at a position of a run, counted in the order of the cursor */
+static inline t_docId runId(const SortIndexRun *run, size_t pos, bool asc) {
+  return asc || pos >= run->numValued ? run->ids[pos] : run->ids[run->numValued - 1 - pos];
+}
+
+/* Skip the deleted documents from the position of a run, and read the value of the next one */
+static void SortIndexCursor_Seek(SortIndexCursor *c, size_t i) {
+  const SortIndexRun *run = c->si->runs + i;
+  size_t len = array_len(run->ids);
+  c->heads[i] = NULL;
+  for (; c->pos[i] < len; c->pos[i]++) {
+    t_docId id = runId(run, c->pos[i], c->asc);
+    if (!DocTable_IsLive(c->docs, id)) {
+      continue;
+    }
+    if (c->pos[i] >= run->numValued || (c->heads[i] = SortIndex_Value(c->si, c->docs, id))) {
+      break;
+    }
+  }
+}
+
+void SortIndexCursor_Init(SortIndexCursor *c, const SortIndex *si, const DocTable *docs, bool asc) {
+  size_t n = array_len(si->runs);
+  c->si = si;
+  c->docs = docs;
+  c->asc = asc;
+  c->pos = rm_calloc(n ? n : 1, sizeof(*c->pos));
+  c->heads = rm_calloc(n ? n : 1, sizeof(*c->heads));
+  for (size_t i = 0; i < n; ++i) {
+    SortIndexCursor_Seek(c, i);
+  }
+}
+
+void SortIndexCursor_Free(SortIndexCursor *c) {
+  rm_free(c->pos);
+  rm_free(c->heads);
+}
+
+t_docId SortIndexCursor_Next(SortIndexCursor *c, const RSValue **value) {
+  const SortIndexRun *runs = c->si->runs;
+  size_t n = array_len(runs);
+  ssize_t best = -1;
+  // the runs still reading the documents having a value come first
+  for (size_t i = 0; i < n; ++i) {
+    if (!c->heads[i]) {
+      continue;
+    }
+    if (best < 0) {
+      best = i;
+      continue;
+    }
+    SortIndexEntry e1 = {.id = runId(runs + i, c->pos[i], c->asc), .value = c->heads[i]};
+    SortIndexEntry e2 = {.id = runId(runs + best, c->pos[best], c->asc), .value = c->heads[best]};
+    int rc = cmpEntries(&e1, &e2);
+    if (c->asc ? rc < 0 : rc > 0) {
+      best = i;
+    }
+  }
+  for (size_t i = 0; best < 0 && i < n; ++i) {
+    if (c->pos[i] < array_len(runs[i].ids)) {
+      best = i;
+    }
+  }
+  if (best < 0) {
+    return 0;
+  }
+
+  t_docId id = runId(runs + best, c->pos[best], c->asc);
+  *value = c->heads[best];
+  c->pos[best]++;
+  SortIndexCursor_Seek(c, best);
+  return id;
+}
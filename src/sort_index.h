@@ -0,0 +1,83 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "doc_table.h"
+#include "value.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A run of the documents of a sort index, by increasing value of the field and then by id. The
+ * documents missing the field follow the others, by id */
+typedef struct {
+  t_docId *ids;      // an array
+  size_t numValued;  // the ids having a value, ahead of the missing ones
+} SortIndexRun;
+
+/* The documents of a SORTINDEX field in the order of its sortable value, for the queries sorted by
+ * it to read the documents in order until they have enough results.
+ *
+ * A document never changes its value, as an updated document gets a new id, so the index is only
+ * extended. It is brought up to date lazily by the queries: the documents added since are sorted
+ * into a new run, and the runs are merged as they are appended, each run being at least twice the
+ * size of the following one. The ids of deleted documents are skipped when read, and dropped by
+ * the merges. The index is rebuilt once the doc ids were renumbered by the compaction */
+typedef struct SortIndex {
+  SortIndexRun *runs;    // an array
+  size_t numIds;         // the ids of the runs, including the deleted ones
+  t_docId maxDocId;      // the highest id the runs were extended to
+  uint64_t docIdsEpoch;  // the epoch of the doc ids of the runs
+  pthread_mutex_t lock;  // held while the index is extended and read
+  uint16_t fieldIndex;   // the index of the field in the spec
+  int16_t sortIdx;       // the index of the field in the sorting vectors
+} SortIndex;
+
+SortIndex *NewSortIndex(uint16_t fieldIndex, int16_t sortIdx);
+
+void SortIndex_Free(SortIndex *si);
+
+/* Lock the index and extend it to the documents of `docs`. The runs may be read until the index is
+ * released. Called by the queries, under the spec read lock */
+void SortIndex_Acquire(SortIndex *si, const DocTable *docs, uint64_t docIdsEpoch);
+
+void SortIndex_Release(SortIndex *si);
+
+/* Forget all the documents, when the contents of the index are dropped */
+void SortIndex_Clear(SortIndex *si);
+
+size_t SortIndex_MemUsage(const SortIndex *si);
+
+/* The sortable value of a document, or NULL if it is missing */
+const RSValue *SortIndex_Value(const SortIndex *si, const DocTable *docs, t_docId docId);
+
+/* Reads the live documents of an acquired index in sort order, merging its runs. The documents
+ * missing the field come last in both orders, as with the sorter */
+typedef struct {
+  const SortIndex *si;
+  const DocTable *docs;
+  bool asc;
+  size_t *pos;            // the position of each run, counted from its first id in sort order
+  const RSValue **heads;  // the value of the next id of each run, NULL if it is missing
+} SortIndexCursor;
+
+void SortIndexCursor_Init(SortIndexCursor *c, const SortIndex *si, const DocTable *docs, bool asc);
+
+void SortIndexCursor_Free(SortIndexCursor *c);
+
+/* The next document, along with its value (NULL if it is missing). Returns 0 at the end */
+t_docId SortIndexCursor_Next(SortIndexCursor *c, const RSValue **value);
+
+#ifdef __cplusplus
+}
+#endif
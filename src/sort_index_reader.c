@@ -0,0 +1,212 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "sort_index_reader.h"
+#include "query_optimizer.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/minmax.h"
+
+#include <stdlib.h>
+
+static int cmpDocId(const void *p1, const void *p2) {
+  t_docId id1 = *(const t_docId *)p1, id2 = *(const t_docId *)p2;
+  return id1 < id2 ? -1 : id1 > id2 ? 1 : 0;
+}
+
+static bool sameValue(const RSValue *v1, const RSValue *v2) {
+  if (!v1 || !v2) {
+    return v1 == v2;
+  }
+  return RSValue_Cmp(v1, v2, NULL) == 0;
+}
+
+/* Match a window of documents against the child. The window is sorted by id */
+static void SII_MatchWindow(SortIndexIterator *it, t_docId *window) {
+  size_t n = array_len(window);
+  qsort(window, n, sizeof(*window), cmpDocId);
+  IndexIterator *child = it->child;
+  child->Rewind(child->ctx);
+  RSIndexResult *hit;
+  for (size_t i = 0; i < n; ++i) {
+    int rc = child->SkipTo(child->ctx, window[i], &hit);
+    if (rc == INDEXREAD_OK) {
+      array_append(it->docIds, window[i]);
+    } else if (rc != INDEXREAD_NOTFOUND) {
+      break;
+    }
+  }
+}
+
+/* Collect the documents to yield. Once `limit` documents of the windows read so far matched, the
+ * first ones in sort order are among them, as the windows end with all the documents tied with
+ * their last one */
+static void SII_Collect(SortIndexIterator *it) {
+  IndexSpec *spec = it->sctx->spec;
+  SortIndex_Acquire(it->si, &spec->docs, spec->docIdsEpoch);
+  SortIndexCursor cursor;
+  SortIndexCursor_Init(&cursor, it->si, &spec->docs, it->asc);
+
+  // a window large enough for `limit` matches if the child matches evenly along the order
+  size_t childEstimate = it->child->NumEstimated(it->child->ctx);
+  size_t windowSize = MAX(QOptimizer_EstimateLimit(spec->docs.size, childEstimate, it->limit),
+                          it->limit);
+  t_docId *window = array_new(t_docId, windowSize);
+  const RSValue *value, *last = NULL;
+  t_docId id = SortIndexCursor_Next(&cursor, &value);
+  while (id && array_len(it->docIds) < it->limit) {
+    array_clear(window);
+    while (id && (array_len(window) < windowSize || sameValue(value, last))) {
+      array_append(window, id);
+      last = value;
+      id = SortIndexCursor_Next(&cursor, &value);
+    }
+    it->numScanned += array_len(window);
+    SII_MatchWindow(it, window);
+    windowSize *= 2;
+  }
+  array_free(window);
+
+  SortIndexCursor_Free(&cursor);
+  SortIndex_Release(it->si);
+
+  qsort(it->docIds, array_len(it->docIds), sizeof(*it->docIds), cmpDocId);
+  it->child->Rewind(it->child->ctx);
+  it->collected = true;
+  if (!array_len(it->docIds)) {
+    IITER_SET_EOF(&it->base);
+  }
+}
+
+/* Yield the document at `idx`, with the child result for it */
+static int SII_Yield(SortIndexIterator *it, size_t idx, RSIndexResult **hit) {
+  t_docId docId = it->lastDocId = it->docIds[idx];
+  it->curIndex = idx + 1;
+  if (it->curIndex == array_len(it->docIds)) {
+    IITER_SET_EOF(&it->base);
+  }
+
+  // the child matched the document while collecting, so it finds it again
+  int rc = it->child->SkipTo(it->child->ctx, docId, hit);
+  RS_LOG_ASSERT(rc == INDEXREAD_OK, "child must match the collected document");
+  it->base.current = *hit;
+  return INDEXREAD_OK;
+}
+
+static int SII_Read(void *ctx, RSIndexResult **hit) {
+  SortIndexIterator *it = ctx;
+  if (!it->collected) {
+    SII_Collect(it);
+  }
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  return SII_Yield(it, it->curIndex, hit);
+}
+
+static int SII_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  SortIndexIterator *it = ctx;
+  if (!it->collected) {
+    SII_Collect(it);
+  }
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+
+  // binary search for the first document not smaller than docId
+  size_t lo = it->curIndex, hi = array_len(it->docIds);
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (it->docIds[mid] < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == array_len(it->docIds)) {
+    it->curIndex = lo;
+    IITER_SET_EOF(&it->base);
+    return INDEXREAD_EOF;
+  }
+  SII_Yield(it, lo, hit);
+  return (*hit)->docId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+static size_t SII_NumEstimated(void *ctx) {
+  SortIndexIterator *it = ctx;
+  if (it->collected) {
+    return array_len(it->docIds);
+  }
+  return MIN(it->limit, it->child->NumEstimated(it->child->ctx));
+}
+
+static int SII_HasNext(void *ctx) {
+  SortIndexIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static t_docId SII_LastDocId(void *ctx) {
+  SortIndexIterator *it = ctx;
+  return it->lastDocId;
+}
+
+static void SII_Rewind(void *ctx) {
+  SortIndexIterator *it = ctx;
+  it->curIndex = 0;
+  it->lastDocId = 0;
+  it->child->Rewind(it->child->ctx);
+  if (!it->collected || array_len(it->docIds)) {
+    IITER_CLEAR_EOF(&it->base);
+  }
+}
+
+static void SII_Abort(void *ctx) {
+  SortIndexIterator *it = ctx;
+  IITER_SET_EOF(&it->base);
+  it->child->Abort(it->child->ctx);
+}
+
+static void SII_Free(IndexIterator *self) {
+  SortIndexIterator *it = self->ctx;
+  if (it == NULL) {
+    return;
+  }
+  it->child->Free(it->child);
+  array_free(it->docIds);
+  rm_free(it);
+}
+
+IndexIterator *NewSortIndexIterator(RedisSearchCtx *sctx, SortIndex *si, IndexIterator *child,
+                                    size_t limit, bool asc) {
+  SortIndexIterator *it = rm_calloc(1, sizeof(*it));
+  it->sctx = sctx;
+  it->si = si;
+  it->child = child;
+  it->limit = limit;
+  it->asc = asc;
+  it->docIds = array_new(t_docId, limit);
+  it->base.isValid = 1;
+
+  IndexIterator *ri = &it->base;
+  ri->ctx = it;
+  ri->type = SORT_INDEX_ITERATOR;
+  ri->mode = MODE_SORTED;
+  ri->ownKey = NULL;
+  // the results are the ones of the child
+  ri->current = child->current;
+
+  ri->Read = SII_Read;
+  ri->SkipTo = SII_SkipTo;
+  ri->Rewind = SII_Rewind;
+  ri->Free = SII_Free;
+  ri->HasNext = SII_HasNext;
+  ri->ReadBatch = NULL;
+  ri->NumEstimated = ri->Len = SII_NumEstimated;
+  ri->Abort = SII_Abort;
+  ri->LastDocId = SII_LastDocId;
+  ri->GetCriteriaTester = NULL;
+  return ri;
+}
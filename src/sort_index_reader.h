@@ -0,0 +1,42 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "index_iterator.h"
+#include "sort_index.h"
+#include "search_ctx.h"
+
+typedef struct {
+  IndexIterator base;
+  RedisSearchCtx *sctx;
+  SortIndex *si;
+  IndexIterator *child;         // the filters of the query
+  size_t limit;                 // number of first documents in sort order to yield
+  bool asc;
+
+  bool collected;               // the documents are collected on the first Read/SkipTo
+  t_docId *docIds;              // the first documents matching the child, sorted by id
+  size_t curIndex;              // index of the next document to yield
+  t_docId lastDocId;
+  size_t numScanned;            // documents read from the sort index until enough matched
+} SortIndexIterator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create an iterator over the first `limit` documents matching `child` in the order of a SORTINDEX
+ * field, along with the ones tied with the last of them. The documents are read from the sort
+ * index in windows of doubling size, and each window is matched against the child by id, until
+ * enough documents matched. The documents are yielded sorted by id, with the results of the child.
+ * Takes ownership of `child` */
+IndexIterator *NewSortIndexIterator(RedisSearchCtx *sctx, SortIndex *si, IndexIterator *child,
+                                    size_t limit, bool asc);
+
+#ifdef __cplusplus
+}
+#endif
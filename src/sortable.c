@@ -11,29 +11,167 @@
 #include "rmutil/util.h"
 #include "rmutil/strings.h"
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "sortable.h"
 #include "buffer.h"
+#include "util/dict.h"
+#include "util/minmax.h"
+
+#include <pthread.h>
+
+struct RSSortingStrings {
+  // the strings, as RSValues, each mapped to the number of slots holding it
+  dict *values;
+  // the strings are added by the indexer, and released by the last reader of a document
+  pthread_mutex_t lock;
+  // the sorting table and the vectors sharing the strings
+  size_t refcount;
+  size_t memsize;
+};
+
+static uint64_t sortingStrings_Hash(const void *key) {
+  const RSValue *v = key;
+  return dictGenHashFunction(v->strval.str, v->strval.len);
+}
+
+static int sortingStrings_Compare(void *privdata, const void *key1, const void *key2) {
+  const RSValue *v1 = key1, *v2 = key2;
+  return v1->strval.len == v2->strval.len && !memcmp(v1->strval.str, v2->strval.str, v1->strval.len);
+}
+
+static dictType sortingStringsType = {
+    .hashFunction = sortingStrings_Hash,
+    .keyCompare = sortingStrings_Compare,
+};
+
+static RSSortingStrings *newSortingStrings(void) {
+  RSSortingStrings *ss = rm_calloc(1, sizeof(*ss));
+  ss->values = dictCreate(&sortingStringsType, NULL);
+  pthread_mutex_init(&ss->lock, NULL);
+  ss->refcount = 1;
+  return ss;
+}
+
+static void sortingStrings_Decref(RSSortingStrings *ss) {
+  if (__atomic_sub_fetch(&ss->refcount, 1, __ATOMIC_RELAXED)) {
+    return;
+  }
+  // no vector is left, so are no strings
+  dictRelease(ss->values);
+  pthread_mutex_destroy(&ss->lock);
+  rm_free(ss);
+}
+
+static size_t sortingString_MemorySize(const RSValue *v) {
+  return sizeof(dictEntry) + sizeof(RSValue) + v->strval.len + 1;
+}
+
+/* Get the shared string equal to `str`, taking its ownership. Returns a value borrowed from the
+ * strings */
+static RSValue *sortingStrings_Add(RSSortingStrings *ss, char *str, size_t len) {
+  RSValue key = RS_StaticValue(RSValue_String);
+  key.strval.str = str;
+  key.strval.len = len;
+
+  pthread_mutex_lock(&ss->lock);
+  dictEntry *existing = NULL;
+  dictEntry *de = dictAddRaw(ss->values, &key, &existing);
+  RSValue *v;
+  if (de) {
+    v = RS_StringValT(str, len, RSString_RMAlloc);
+    de->key = v;
+    dictSetUnsignedIntegerVal(de, 1);
+    ss->memsize += sortingString_MemorySize(v);
+  } else {
+    rm_free(str);
+    v = dictGetKey(existing);
+    existing->v.u64++;
+  }
+  pthread_mutex_unlock(&ss->lock);
+  return v;
+}
+
+/* Release a slot holding a shared string. Assumes the strings are locked */
+static void sortingStrings_Release(RSSortingStrings *ss, RSValue *v) {
+  dictEntry *de = dictFind(ss->values, v);
+  RS_LOG_ASSERT(de, "sortable string is not shared");
+  if (--de->v.u64) {
+    return;
+  }
+  ss->memsize -= sortingString_MemorySize(v);
+  dictDelete(ss->values, v);
+  RSValue_Decref(v);
+}
+
+#define SV_TYPES(v) ((unsigned char *)((v)->slots + (v)->len))
 
 /* Create a sorting vector of a given length for a document */
 RSSortingVector *NewSortingVector(int len) {
   if (len > RS_SORTABLES_MAX) {
     return NULL;
   }
-  RSSortingVector *ret = rm_malloc(sizeof(RSSortingVector) + (len * sizeof(RSValue*)));
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_SORTABLES);
+  RSSortingVector *ret = rm_malloc(sizeof(RSSortingVector) + len * (sizeof(RSSortingSlot) + 1));
+  AllocStats_SetTag(prevTag);
   ret->len = len;
+  ret->strings = NULL;
   // set all values to NIL
-  for (int i = 0; i < len; i++) {
-    ret->values[i] = RS_NullVal();
+  memset(SV_TYPES(ret), RS_SORTABLE_NIL, len);
+  return ret;
+}
+
+RSSortingVector *RSSortingTable_NewVector(RSSortingTable *tbl) {
+  RSSortingVector *ret = NewSortingVector(tbl->len);
+  if (ret && tbl->strings) {
+    ret->strings = tbl->strings;
+    __atomic_fetch_add(&tbl->strings->refcount, 1, __ATOMIC_RELAXED);
   }
   return ret;
 }
 
+size_t RSSortingTable_StringsMemorySize(const RSSortingTable *tbl) {
+  if (!tbl || !tbl->strings) {
+    return 0;
+  }
+  pthread_mutex_lock(&tbl->strings->lock);
+  size_t ret = tbl->strings->memsize;
+  pthread_mutex_unlock(&tbl->strings->lock);
+  return ret;
+}
+
+RSValue *RSSortingVector_NewValue(const RSSortingVector *v, size_t index) {
+  if (v->len <= index) {
+    return NULL;
+  }
+  switch (RSSortingVector_Type(v, index)) {
+    case RS_SORTABLE_NIL:
+      return NULL;
+    case RS_SORTABLE_NUM:
+      return RS_NumVal(v->slots[index].num);
+    default:
+      return RSValue_IncrRef(v->slots[index].val);
+  }
+}
+
 /* Internal compare function between members of the sorting vectors, sorted by sk */
 int RSSortingVector_Cmp(RSSortingVector *self, RSSortingVector *other, RSSortingKey *sk,
                         QueryError *qerr) {
-  RSValue *v1 = self->values[sk->index];
-  RSValue *v2 = other->values[sk->index];
-  int rc = RSValue_Cmp(v1, v2, qerr);
+  int rc;
+  double n1, n2;
+  if (RSSortingVector_GetNumber(self, sk->index, &n1) &&
+      RSSortingVector_GetNumber(other, sk->index, &n2)) {
+    rc = n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
+  } else {
+    RSValue *v1 = RSSortingVector_NewValue(self, sk->index);
+    RSValue *v2 = RSSortingVector_NewValue(other, sk->index);
+    rc = RSValue_Cmp(v1 ? v1 : RS_NullVal(), v2 ? v2 : RS_NullVal(), qerr);
+    if (v1) {
+      RSValue_Decref(v1);
+    }
+    if (v2) {
+      RSValue_Decref(v2);
+    }
+  }
   return sk->ascending ? rc : -rc;
 }
 
@@ -68,41 +206,81 @@ char *normalizeStr(const char *str) {
   return lower_buffer;
 }
 
+/* Release the value of a slot, leaving it nil */
+static void releaseSlot(RSSortingVector *v, int idx) {
+  switch (SV_TYPES(v)[idx]) {
+    case RS_SORTABLE_STR:
+      pthread_mutex_lock(&v->strings->lock);
+      sortingStrings_Release(v->strings, v->slots[idx].val);
+      pthread_mutex_unlock(&v->strings->lock);
+      break;
+    case RS_SORTABLE_RSVAL:
+      RSValue_Decref(v->slots[idx].val);
+      break;
+    default:
+      break;
+  }
+  SV_TYPES(v)[idx] = RS_SORTABLE_NIL;
+}
+
 /* Put a value in the sorting vector */
 void RSSortingVector_Put(RSSortingVector *tbl, int idx, const void *p, int type, int unf) {
-  if (idx > RS_SORTABLES_MAX) {
+  if (idx >= tbl->len) {
     return;
   }
-  if (tbl->values[idx]) {
-    RSValue_Decref(tbl->values[idx]);
-    tbl->values[idx] = NULL;
-  }
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_SORTABLES);
+  releaseSlot(tbl, idx);
   switch (type) {
     case RS_SORTABLE_NUM:
-      tbl->values[idx] = RS_NumVal(*(double *)p);
-
+      tbl->slots[idx].num = *(double *)p;
       break;
     case RS_SORTABLE_STR: {
       char *str = unf ? rm_strdup(p) : normalizeStr((const char *)p);
-      tbl->values[idx] = RS_StringValT(str, strlen(str), RSString_RMAlloc);
+      if (tbl->strings) {
+        tbl->slots[idx].val = sortingStrings_Add(tbl->strings, str, strlen(str));
+      } else {
+        tbl->slots[idx].val = RS_StringValT(str, strlen(str), RSString_RMAlloc);
+        type = RS_SORTABLE_RSVAL;
+      }
       break;
     }
     case RS_SORTABLE_RSVAL:
-      tbl->values[idx] = (RSValue*)p;
+      tbl->slots[idx].val = (RSValue*)p;
       break;
     case RS_SORTABLE_NIL:
     default:
-      tbl->values[idx] = RS_NullVal();
+      type = RS_SORTABLE_NIL;
       break;
   }
+  SV_TYPES(tbl)[idx] = type;
+  AllocStats_SetTag(prevTag);
 }
 
 /* Free a sorting vector */
 void SortingVector_Free(RSSortingVector *v) {
+  RSSortingStrings *ss = v->strings;
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_SORTABLES);
+  if (ss) {
+    pthread_mutex_lock(&ss->lock);
+  }
   for (size_t i = 0; i < v->len; i++) {
-    RSValue_Decref(v->values[i]);
+    switch (SV_TYPES(v)[i]) {
+      case RS_SORTABLE_STR:
+        sortingStrings_Release(ss, v->slots[i].val);
+        break;
+      case RS_SORTABLE_RSVAL:
+        RSValue_Decref(v->slots[i].val);
+        break;
+      default:
+        break;
+    }
+  }
+  if (ss) {
+    pthread_mutex_unlock(&ss->lock);
+    sortingStrings_Decref(ss);
   }
   rm_free(v);
+  AllocStats_SetTag(prevTag);
 }
 
 /* Save a sorting vector to rdb. This is called from the doc table */
@@ -113,7 +291,13 @@ void SortingVector_RdbSave(RedisModuleIO *rdb, RSSortingVector *v) {
   }
   RedisModule_SaveUnsigned(rdb, v->len);
   for (int i = 0; i < v->len; i++) {
-    RSValue *val = v->values[i];
+    double num;
+    if (RSSortingVector_GetNumber(v, i, &num)) {
+      RedisModule_SaveUnsigned(rdb, RSValue_Number);
+      RedisModule_SaveDouble(rdb, num);
+      continue;
+    }
+    RSValue *val = RSSortingVector_Get(v, i);
     if (!val) {
       RedisModule_SaveUnsigned(rdb, RSValue_Null);
       continue;
@@ -153,33 +337,172 @@ RSSortingVector *SortingVector_RdbLoad(RedisModuleIO *rdb, int encver) {
         // strings include an extra character for null terminator. we set it to zero just in case
         char *s = RedisModule_LoadStringBuffer(rdb, &len);
         s[len - 1] = '\0';
-        vec->values[i] = RS_StringValT(rm_strdup(s), len - 1, RSString_RMAlloc);
+        vec->slots[i].val = RS_StringValT(rm_strdup(s), len - 1, RSString_RMAlloc);
+        SV_TYPES(vec)[i] = RS_SORTABLE_RSVAL;
         RedisModule_Free(s);
         break;
       }
       case RS_SORTABLE_NUM:
         // load numeric value
-        vec->values[i] = RS_NumVal(RedisModule_LoadDouble(rdb));
+        vec->slots[i].num = RedisModule_LoadDouble(rdb);
+        SV_TYPES(vec)[i] = RS_SORTABLE_NUM;
         break;
       // for nil we read nothing
       case RS_SORTABLE_NIL:
       default:
-        vec->values[i] = RS_NullVal();
         break;
     }
   }
   return vec;
 }
 
+/* Values are saved as their type followed by their contents. The types which are not kept in a
+ * sorting vector are saved as null */
+static void rsValue_RdbSave(RedisModuleIO *rdb, const RSValue *v) {
+  v = RSValue_Dereference(v);
+  if (!v) {
+    RedisModule_SaveUnsigned(rdb, RSValue_Undef);
+    return;
+  }
+  switch (v->t) {
+    case RSValue_Number:
+      RedisModule_SaveUnsigned(rdb, RSValue_Number);
+      RedisModule_SaveDouble(rdb, v->numval);
+      break;
+    case RSValue_String:
+    case RSValue_RedisString:
+    case RSValue_OwnRstring: {
+      size_t len;
+      const char *s = RSValue_StringPtrLen(v, &len);
+      RedisModule_SaveUnsigned(rdb, RSValue_String);
+      RedisModule_SaveStringBuffer(rdb, s, len);
+      break;
+    }
+    case RSValue_Array:
+      RedisModule_SaveUnsigned(rdb, RSValue_Array);
+      RedisModule_SaveUnsigned(rdb, v->arrval.len);
+      for (uint32_t i = 0; i < v->arrval.len; i++) {
+        rsValue_RdbSave(rdb, v->arrval.vals[i]);
+      }
+      break;
+    case RSValue_Duo:
+      RedisModule_SaveUnsigned(rdb, RSValue_Duo);
+      for (int i = 0; i < 3; i++) {
+        rsValue_RdbSave(rdb, v->duoval.vals[i]);
+      }
+      break;
+    default:
+      RedisModule_SaveUnsigned(rdb, RSValue_Null);
+      break;
+  }
+}
+
+static RSValue *rsValue_RdbLoad(RedisModuleIO *rdb) {
+  switch (RedisModule_LoadUnsigned(rdb)) {
+    case RSValue_Undef:
+      return NULL;
+    case RSValue_Number:
+      return RS_NumVal(RedisModule_LoadDouble(rdb));
+    case RSValue_String: {
+      size_t len;
+      char *s = RedisModule_LoadStringBuffer(rdb, &len);
+      RSValue *v = RS_NewCopiedString(s ? s : "", s ? len : 0);
+      if (s) RedisModule_Free(s);
+      return v;
+    }
+    case RSValue_Array: {
+      uint32_t len = RedisModule_LoadUnsigned(rdb);
+      RSValue **vals = rm_malloc(MAX(len, 1) * sizeof(*vals));
+      for (uint32_t i = 0; i < len; i++) {
+        RSValue *val = rsValue_RdbLoad(rdb);
+        vals[i] = val ? val : RS_NullVal();
+      }
+      return RSValue_NewArray(vals, len);
+    }
+    case RSValue_Duo: {
+      RSValue *val = rsValue_RdbLoad(rdb);
+      RSValue *otherval = rsValue_RdbLoad(rdb);
+      RSValue *other2val = rsValue_RdbLoad(rdb);
+      return RS_DuoVal(val, otherval, other2val);
+    }
+    default:
+      return RS_NullVal();
+  }
+}
+
+void RSSortingVector_RdbSave(RedisModuleIO *rdb, const RSSortingVector *v) {
+  RedisModule_SaveUnsigned(rdb, v->len);
+  for (size_t i = 0; i < v->len; i++) {
+    int type = RSSortingVector_Type(v, i);
+    RedisModule_SaveUnsigned(rdb, type);
+    switch (type) {
+      case RS_SORTABLE_NUM:
+        RedisModule_SaveDouble(rdb, v->slots[i].num);
+        break;
+      case RS_SORTABLE_STR: {
+        size_t len;
+        const char *s = RSValue_StringPtrLen(v->slots[i].val, &len);
+        // save the null terminator as well, the string is put back as a C string
+        RedisModule_SaveStringBuffer(rdb, s, len + 1);
+        break;
+      }
+      case RS_SORTABLE_RSVAL:
+        rsValue_RdbSave(rdb, v->slots[i].val);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+RSSortingVector *RSSortingTable_RdbLoadVector(RSSortingTable *tbl, RedisModuleIO *rdb) {
+  RSSortingVector *v = RSSortingTable_NewVector(tbl);
+  size_t len = RedisModule_LoadUnsigned(rdb);
+  for (size_t i = 0; i < len; i++) {
+    int type = RedisModule_LoadUnsigned(rdb);
+    switch (type) {
+      case RS_SORTABLE_NUM: {
+        double num = RedisModule_LoadDouble(rdb);
+        RSSortingVector_Put(v, i, &num, RS_SORTABLE_NUM, 0);
+        break;
+      }
+      case RS_SORTABLE_STR: {
+        size_t slen;
+        char *s = RedisModule_LoadStringBuffer(rdb, &slen);
+        if (s && slen) {
+          s[slen - 1] = '\0';
+          // the string was normalized when it was indexed
+          RSSortingVector_Put(v, i, s, RS_SORTABLE_STR, 1);
+        }
+        if (s) RedisModule_Free(s);
+        break;
+      }
+      case RS_SORTABLE_RSVAL: {
+        RSValue *val = rsValue_RdbLoad(rdb);
+        if (i < v->len && val) {
+          RSSortingVector_Put(v, i, val, RS_SORTABLE_RSVAL, 0);
+        } else if (val) {
+          RSValue_Decref(val);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return v;
+}
+
 size_t RSSortingVector_GetMemorySize(RSSortingVector *v) {
   if (!v) return 0;
 
-  size_t sum = v->len * sizeof(RSValue *);
+  // the shared strings are accounted for by the sorting table
+  size_t sum = sizeof(*v) + v->len * (sizeof(RSSortingSlot) + 1);
   for (int i = 0; i < v->len; i++) {
-    if (!v->values[i]) continue;
+    if (SV_TYPES(v)[i] != RS_SORTABLE_RSVAL) continue;
     sum += sizeof(RSValue);
 
-    RSValue *val = RSValue_Dereference(v->values[i]);
+    RSValue *val = RSValue_Dereference(v->slots[i].val);
     if (val && RSValue_IsString(val)) {
       size_t sz;
       RSValue_StringPtrLen(val, &sz);
@@ -193,10 +516,14 @@ size_t RSSortingVector_GetMemorySize(RSSortingVector *v) {
 RSSortingTable *NewSortingTable(void) {
   RSSortingTable *tbl = rm_calloc(1, sizeof(*tbl));
   tbl->cap = 1;
+  tbl->strings = newSortingStrings();
   return tbl;
 }
 
 void SortingTable_Free(RSSortingTable *t) {
+  if (t->strings) {
+    sortingStrings_Decref(t->strings);
+  }
   rm_free(t);
 }
 
@@ -28,14 +28,26 @@ extern "C" {
 #define RS_SORTABLE_NIL 4
 #define RS_SORTABLE_RSVAL 5
 
+/* The distinct sortable strings of an index, shared by the sorting vectors of its documents. Each
+ * string is kept once, along with the number of vectors holding it */
+typedef struct RSSortingStrings RSSortingStrings;
+
+/* A slot of a sorting vector. Numbers are kept unboxed, and the other values as RSValues */
+typedef union {
+  double num;
+  RSValue *val;
+} RSSortingSlot;
+
 /* RSSortingVector is a vector of sortable values. All documents in a schema where sortable fields
- * are defined will have such a vector. */
-#pragma pack(1)
+ * are defined will have such a vector. Its slots are followed by their types, one RS_SORTABLE_*
+ * byte per slot. The strings of a vector created for an index are the shared ones of the index, and
+ * a number only becomes an RSValue when it is read as one (see RSSortingVector_NewValue) */
 typedef struct RSSortingVector {
-  unsigned char len;
-  RSValue *values[];
+  uint16_t len;
+  RSSortingStrings *strings;
+  // aligned, for the numbers to be read in place
+  RSSortingSlot slots[];
 } RSSortingVector;
-#pragma pack()
 
 /* RSSortingTable defines the length and names of the fields in a sorting vector. It is saved as
  * part of the spec */
@@ -47,6 +59,8 @@ typedef struct {
 typedef struct {
   uint16_t len;
   uint16_t cap;
+  // the strings of the sorting vectors of the index
+  RSSortingStrings *strings;
   RSSortField fields[1];
 } RSSortingTable;
 
@@ -78,19 +92,51 @@ int RSSortingVector_Cmp(RSSortingVector *self, RSSortingVector *other, RSSorting
 /* Put a value in the sorting vector */
 void RSSortingVector_Put(RSSortingVector *tbl, int idx, const void *p, int type, int unf);
 
-/* Returns the value for a given index. Does not increment the refcount */
-static inline RSValue *RSSortingVector_Get(RSSortingVector *v, size_t index) {
+/* Returns the RS_SORTABLE_* type of the value at a given index */
+static inline int RSSortingVector_Type(const RSSortingVector *v, size_t index) {
+  return ((const unsigned char *)(v->slots + v->len))[index];
+}
+
+/* Returns the value for a given index, or NULL if it is a number or the index is out of range. Does
+ * not increment the refcount */
+static inline RSValue *RSSortingVector_Get(const RSSortingVector *v, size_t index) {
   if (v->len <= index) {
     return NULL;
   }
-  return v->values[index];
+  switch (RSSortingVector_Type(v, index)) {
+    case RS_SORTABLE_NUM:
+      return NULL;
+    case RS_SORTABLE_NIL:
+      return RS_NullVal();
+    default:
+      return v->slots[index].val;
+  }
+}
+
+/* Set `n` to the value at a given index, and return 1 if it is a number */
+static inline int RSSortingVector_GetNumber(const RSSortingVector *v, size_t index, double *n) {
+  if (v->len <= index || RSSortingVector_Type(v, index) != RS_SORTABLE_NUM) {
+    return 0;
+  }
+  *n = v->slots[index].num;
+  return 1;
 }
 
+/* Returns a new reference to the value at a given index, creating it for a number. Returns NULL if
+ * the value is nil or the index is out of range */
+RSValue *RSSortingVector_NewValue(const RSSortingVector *v, size_t index);
+
 size_t RSSortingVector_GetMemorySize(RSSortingVector *v);
 
-/* Create a sorting vector of a given length for a document */
+/* Create a sorting vector of a given length for a document, owning its strings */
 RSSortingVector *NewSortingVector(int len);
 
+/* Create a sorting vector for a document of the index of the table, sharing its strings */
+RSSortingVector *RSSortingTable_NewVector(RSSortingTable *tbl);
+
+/* The memory of the shared strings of the sorting vectors of the table */
+size_t RSSortingTable_StringsMemorySize(const RSSortingTable *tbl);
+
 /* Free a sorting vector */
 void SortingVector_Free(RSSortingVector *v);
 
@@ -100,6 +146,14 @@ void SortingVector_RdbSave(RedisModuleIO *rdb, RSSortingVector *v);
 /* Load a sorting vector from RDB */
 RSSortingVector *SortingVector_RdbLoad(RedisModuleIO *rdb, int encver);
 
+/* Save the sorting vector of a document along with the contents of its index. Unlike
+ * SortingVector_RdbSave, every kind of slot is saved */
+void RSSortingVector_RdbSave(RedisModuleIO *rdb, const RSSortingVector *v);
+
+/* Load a sorting vector saved by RSSortingVector_RdbSave, for a document of the index of the table
+ * sharing its strings */
+RSSortingVector *RSSortingTable_RdbLoadVector(RSSortingTable *tbl, RedisModuleIO *rdb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #include "redis_index.h"
 #include "indexer.h"
 #include "suffix.h"
+#include "phonetic_manager.h"
 #include "alias.h"
 #include "module.h"
 #include "aggregate/expr/expression.h"
@@ -31,7 +32,11 @@
 #include "rdb.h"
 #include "commands.h"
 #include "rmutil/cxx/chrono-clock.h"
+#include "geometry_index.h"
+#include "geometry/geometry_api.h"
 #include "util/workers.h"
+#include "util/threadpool_api.h"
+#include "index_persistence.h"
 
 #define INITIAL_DOC_TABLE_SIZE 1000
 
@@ -109,6 +114,57 @@ const FieldSpec *IndexSpec_GetField(const IndexSpec *spec, const char *name, siz
   return NULL;
 }
 
+ExistenceIndex *IndexSpec_GetExistence(const IndexSpec *sp, const FieldSpec *fs) {
+  if (!FieldSpec_IndexesMissing(fs)) {
+    return NULL;
+  }
+  for (size_t i = 0; i < array_len(sp->existence); ++i) {
+    if (sp->existence[i]->fieldIndex == fs->index) {
+      return sp->existence[i];
+    }
+  }
+  return NULL;
+}
+
+void IndexSpec_RemoveExistence(IndexSpec *sp, t_docId id) {
+  for (size_t i = 0; i < array_len(sp->existence); ++i) {
+    ExistenceIndex_Remove(sp->existence[i], id);
+  }
+}
+
+SortIndex *IndexSpec_GetSortIndex(const IndexSpec *sp, const FieldSpec *fs) {
+  if (!FieldSpec_HasSortIndex(fs)) {
+    return NULL;
+  }
+  for (size_t i = 0; i < array_len(sp->sortIndexes); ++i) {
+    if (sp->sortIndexes[i]->fieldIndex == fs->index) {
+      return sp->sortIndexes[i];
+    }
+  }
+  return NULL;
+}
+
+/* Create the existence indexes of the INDEXMISSING fields added from `from` on */
+static void IndexSpec_AddExistence(IndexSpec *sp, size_t from) {
+  for (size_t i = from; i < sp->numFields; ++i) {
+    if (FieldSpec_IndexesMissing(sp->fields + i)) {
+      ExistenceIndex *ex = NewExistenceIndex(i);
+      sp->existence = array_ensure_append_1(sp->existence, ex);
+    }
+  }
+}
+
+/* Create the sort indexes of the SORTINDEX fields added from `from` on */
+static void IndexSpec_AddSortIndexes(IndexSpec *sp, size_t from) {
+  for (size_t i = from; i < sp->numFields; ++i) {
+    const FieldSpec *fs = sp->fields + i;
+    if (FieldSpec_HasSortIndex(fs)) {
+      SortIndex *si = NewSortIndex(i, fs->sortIdx);
+      sp->sortIndexes = array_ensure_append_1(sp->sortIndexes, si);
+    }
+  }
+}
+
 // Assuming the spec is properly locked before calling this function.
 t_fieldMask IndexSpec_GetFieldBit(IndexSpec *spec, const char *name, size_t len) {
   const FieldSpec *fs = IndexSpec_GetField(spec, name, len);
@@ -264,6 +320,8 @@ static void IndexSpec_TimedOut_Free(IndexSpec *spec) {
   redisearch_thpool_add_work(cleanPool, (redisearch_thpool_proc)IndexSpec_FreeTask, rm_strdup(spec->name), THPOOL_PRIORITY_HIGH);
 }
 
+static void IndexSpec_SetTimeoutTimer(IndexSpec *sp, WeakRef spec_ref);
+
 static void IndexSpec_TimedOutProc(RedisModuleCtx *ctx, WeakRef w_ref) {
   // we need to delete the spec from the specDict_g, as far as the user see it,
   // this spec was deleted and its memory will be freed in a background thread.
@@ -277,11 +335,20 @@ static void IndexSpec_TimedOutProc(RedisModuleCtx *ctx, WeakRef w_ref) {
     // the spec was already deleted, nothing to do here
     return;
   }
+
+  sp->isTimerSet = false;
+  if (sp->flags & Index_Lazy) {
+    // An idle lazy index is only evicted. If it is in use, try again once the timeout passes
+    if (!LazyIndex_Evict(sp)) {
+      IndexSpec_SetTimeoutTimer(sp, StrongRef_Demote(spec_ref));
+    }
+    StrongRef_Release(spec_ref);
+    return;
+  }
 #ifdef _DEBUG
   RedisModule_Log(NULL, "notice", "Freeing index %s by timer", sp->name);
 #endif
 
-  sp->isTimerSet = false;
   // This function will perform an index drop, and we will still have to return our references
   IndexSpec_TimedOut_Free(sp);
 
@@ -338,12 +405,18 @@ void Indexes_SetTempSpecsTimers(TimerOp op) {
 //---------------------------------------------------------------------------------------------
 
 double IndexesScanner_IndexedPercent(IndexesScanner *scanner, IndexSpec *sp) {
+  // The vectors of the scanned documents are indexed once the workers insert them into their graphs
+  size_t pending = __atomic_load_n(&sp->scanVectorJobs, __ATOMIC_RELAXED);
   if (scanner || sp->scan_in_progress) {
     if (scanner) {
-      return scanner->totalKeys > 0 ? (double)scanner->scannedKeys / scanner->totalKeys : 0;
+      return scanner->totalKeys > 0
+                 ? (double)scanner->scannedKeys / (scanner->totalKeys + pending)
+                 : 0;
     } else {
       return 0;
     }
+  } else if (pending) {
+    return (double)sp->stats.numDocuments / (sp->stats.numDocuments + pending);
   } else {
     return 1.0;
   }
@@ -385,7 +458,8 @@ IndexSpec *IndexSpec_CreateNew(RedisModuleCtx *ctx, RedisModuleString **argv, in
     IndexSpec_SetTimeoutTimer(sp, StrongRef_Demote(spec_ref));
   }
 
-  if (!(sp->flags & Index_SkipInitialScan)) {
+  // a lazy index is scanned once it is first accessed
+  if (!(sp->flags & (Index_SkipInitialScan | Index_Lazy))) {
     IndexSpec_ScanAndReindex(ctx, spec_ref);
   }
   return sp;
@@ -456,6 +530,13 @@ static int parseTextField(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
       continue;
     } else if(AC_AdvanceIfMatch(ac, SPEC_WITHSUFFIXTRIE_STR)) {
       fs->options |= FieldSpec_WithSuffixTrie;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_WITHNGRAMS_STR)) {
+      fs->options |= FieldSpec_WithNgrams;
+      continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_NOOFFSETS_STR)) {
+      fs->options |= FieldSpec_NoOffsets;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_SEPARATEPOSTINGS_STR)) {
+      fs->options |= FieldSpec_WithSeparatePostings;
     } else {
       break;
     }
@@ -820,6 +901,14 @@ static int parseFieldSpec(ArgsCursor *ac, IndexSpec *sp, StrongRef sp_ref, Field
     }
   } else if (AC_AdvanceIfMatch(ac, SPEC_NUMERIC_STR)) {  // numeric field
     fs->types |= INDEXFLD_T_NUMERIC;
+    if (AC_AdvanceIfMatch(ac, SPEC_INDEXTYPE_STR)) {
+      if (!AC_AdvanceIfMatch(ac, SPEC_NUMERIC_BKD_STR)) {
+        QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                               "Invalid numeric index type for field `%s`", fs->name);
+        goto error;
+      }
+      fs->options |= FieldSpec_NumericBKD;
+    }
   } else if (AC_AdvanceIfMatch(ac, SPEC_GEO_STR)) {  // geo field
     fs->types |= INDEXFLD_T_GEO;
   } else if (AC_AdvanceIfMatch(ac, SPEC_VECTOR_STR)) {  // vector field
@@ -879,10 +968,23 @@ static int parseFieldSpec(ArgsCursor *ac, IndexSpec *sp, StrongRef sp_ref, Field
     } else if (AC_AdvanceIfMatch(ac, SPEC_NOINDEX_STR)) {
       fs->options |= FieldSpec_NotIndexable;
       continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_INDEXMISSING_STR)) {
+      fs->options |= FieldSpec_IndexMissing;
+      continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_SORTINDEX_STR)) {
+      fs->options |= FieldSpec_WithSortIndex;
+      continue;
     } else {
       break;
     }
   }
+  if (FieldSpec_HasSortIndex(fs) &&
+      (!FieldSpec_IsSortable(fs) || !FIELD_IS(fs, INDEXFLD_T_FULLTEXT | INDEXFLD_T_TAG))) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                           SPEC_SORTINDEX_STR " requires the field `%s` to be a SORTABLE TEXT or TAG",
+                           fs->name);
+    goto error;
+  }
   return 1;
 
 error:
@@ -907,6 +1009,11 @@ size_t IndexSpec_VectorIndexSize(IndexSpec *sp) {
   return total_memory;
 }
 
+// Assuming the spec is properly locked before calling this function.
+size_t IndexSpec_SortablesSize(const IndexSpec *sp) {
+  return sp->docs.sortablesSize + RSSortingTable_StringsMemorySize(sp->sortables);
+}
+
 // Assuming the spec is properly locked before calling this function.
 int IndexSpec_CreateTextId(const IndexSpec *sp) {
   int maxId = -1;
@@ -1054,10 +1161,21 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, StrongRef spec_ref, ArgsCu
       sp->suffixMask |= FIELD_BIT(fs);
       if (!sp->suffix) {
         sp->flags |= Index_HasSuffixTrie;
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
+        sp->suffix = NewSuffixArray();
+      }
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_HasNgrams(fs)) {
+      sp->ngramMask |= FIELD_BIT(fs);
+      if (!sp->ngrams) {
+        sp->ngrams = NewNgramIndex();
       }
     }
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_HasSeparatePostings(fs)) {
+      sp->separatePostingsMask |= FIELD_BIT(fs);
+    }
   }
+  IndexSpec_AddExistence(sp, prevNumFields);
+  IndexSpec_AddSortIndexes(sp, prevNumFields);
 
   // If we successfully modified the schema, we need to update the spec cache
   IndexSpecCache_Decref(sp->spcache);
@@ -1082,7 +1200,7 @@ int IndexSpec_AddFields(StrongRef spec_ref, IndexSpec *sp, RedisModuleCtx *ctx,
   setMemoryInfo(ctx);
 
   int rc = IndexSpec_AddFieldsInternal(sp, spec_ref, ac, status, 0);
-  if (rc && initialScan) {
+  if (rc && initialScan && LazyIndex_IsLoaded(sp)) {
     IndexSpec_ScanAndReindex(ctx, spec_ref);
   }
 
@@ -1104,6 +1222,7 @@ StrongRef IndexSpec_Parse(const char *name, const char **argv, int argc, QueryEr
 
   ArgsCursor_InitCString(&ac, argv, argc);
   long long timeout = -1;
+  long long lazyTimeout = -1;
   int dummy;
   size_t dummy2;
   SchemaRuleArgs rule_args = {0};
@@ -1118,12 +1237,16 @@ StrongRef IndexSpec_Parse(const char *name, const char **argv, int argc, QueryEr
       {AC_MKBITFLAG(SPEC_SCHEMA_EXPANDABLE_STR, &spec->flags, Index_WideSchema)},
       {AC_MKBITFLAG(SPEC_ASYNC_STR, &spec->flags, Index_Async)},
       {AC_MKBITFLAG(SPEC_SKIPINITIALSCAN_STR, &spec->flags, Index_SkipInitialScan)},
+      {AC_MKBITFLAG(SPEC_RESULTCACHE_STR, &spec->flags, Index_ResultCache)},
+      {AC_MKBITFLAG(SPEC_ASYNCUPDATES_STR, &spec->flags, Index_AsyncUpdates)},
+      {AC_MKBITFLAG(SPEC_SPELLINDEX_STR, &spec->flags, Index_SpellIndex)},
 
       // For compatibility
       {.name = "NOSCOREIDX", .target = &dummy, .type = AC_ARGTYPE_BOOLFLAG},
       {.name = "ON", .target = &rule_args.type, .len = &dummy2, .type = AC_ARGTYPE_STRING},
       SPEC_FOLLOW_HASH_ARGS_DEF(&rule_args){
           .name = SPEC_TEMPORARY_STR, .target = &timeout, .type = AC_ARGTYPE_LLONG},
+      {.name = SPEC_LAZY_STR, .target = &lazyTimeout, .type = AC_ARGTYPE_LLONG},
       {.name = SPEC_STOPWORDS_STR, .target = &acStopwords, .type = AC_ARGTYPE_SUBARGS},
       {.name = NULL}};
 
@@ -1139,6 +1262,21 @@ StrongRef IndexSpec_Parse(const char *name, const char **argv, int argc, QueryEr
   if (timeout != -1) {
     spec->flags |= Index_Temporary;
   }
+  if (lazyTimeout != -1) {
+    // the idle timeout of a lazy index is the timeout of the temporary indexes
+    if (timeout != -1) {
+      QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "`%s` and `%s` are mutually exclusive",
+                             SPEC_LAZY_STR, SPEC_TEMPORARY_STR);
+      goto failure;
+    }
+    if (lazyTimeout <= 0) {
+      QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Bad idle timeout for `%s`", SPEC_LAZY_STR);
+      goto failure;
+    }
+    spec->flags |= Index_Lazy;
+    LazyIndex_Init(spec);
+    timeout = lazyTimeout;
+  }
   spec->timeout = timeout * 1000;  // convert to ms
 
   if (rule_prefixes.argc > 0) {
@@ -1196,22 +1334,69 @@ failure:  // on failure free the spec fields array and return an error
 /* Initialize some index stats that might be useful for scoring functions */
 // Assuming the spec is properly locked before calling this function
 void IndexSpec_GetStats(IndexSpec *sp, RSIndexStats *stats) {
+  size_t totalDocsLen = sp->stats.totalDocsLen;
   stats->numDocs = sp->stats.numDocuments;
   stats->numTerms = sp->stats.numTerms;
-  stats->avgDocLen =
-      stats->numDocs ? (double)sp->stats.totalDocsLen / (double)sp->stats.numDocuments : 0;
+  if (sp->clusterStats) {
+    // Score with the statistics of the whole cluster when the coordinator pushed them
+    ClusterStats_Get(sp->clusterStats, &stats->numDocs, &totalDocsLen);
+  }
+  stats->avgDocLen = stats->numDocs ? (double)totalDocsLen / (double)stats->numDocs : 0;
+}
+
+JSONPlan *IndexSpec_GetJSONPlan(IndexSpec *sp) {
+  if (sp->jsonPlan && JSONPlan_NumFields(sp->jsonPlan) != sp->numFields) {
+    JSONPlan_Free(sp->jsonPlan);
+    sp->jsonPlan = NULL;
+  }
+  if (!sp->jsonPlan) {
+    sp->jsonPlan = JSONPlan_New(sp->fields, sp->numFields);
+  }
+  return sp->jsonPlan;
+}
+
+uint64_t IndexSpec_ResultsRevision(const IndexSpec *sp) {
+  return __atomic_load_n(&sp->revision, __ATOMIC_ACQUIRE) + RSGlobalConfig.revision;
 }
 
 // Assuming the spec is properly locked for writing before calling this function.
 int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len) {
-  int isNew = Trie_InsertStringBuffer(sp->terms, (char *)term, len, 1, 1, NULL);
+  Trie *terms = IndexSpec_GetTermsTrie(sp, term);
+  int isNew = Trie_InsertStringBuffer(terms, (char *)term, len, 1, 1, NULL);
   if (isNew) {
     sp->stats.numTerms++;
     sp->stats.termsSize += len;
+    if (terms == sp->terms) {
+      // phonetic codes are only looked up as they are
+      IndexSpec_TermsChanged(sp);
+    }
   }
   return isNew;
 }
 
+Trie *IndexSpec_GetTermsTrie(IndexSpec *sp, const char *term) {
+  if (term[0] == FIELD_TERM_PREFIX) {
+    if (!sp->fieldTerms) {
+      sp->fieldTerms = NewTrie(NULL, Trie_Sort_Lex);
+    }
+    return sp->fieldTerms;
+  }
+  if (term[0] != PHONETIC_PREFIX) {
+    return sp->terms;
+  }
+  if (!sp->phonetics) {
+    sp->phonetics = NewTrie(NULL, Trie_Sort_Lex);
+  }
+  return sp->phonetics;
+}
+
+size_t IndexSpec_FormatFieldTerm(char *buf, const FieldSpec *fs, const char *term, size_t len) {
+  int n = sprintf(buf, "%c%u:", FIELD_TERM_PREFIX, (unsigned)fs->ftId);
+  memcpy(buf + n, term, len);
+  buf[n + len] = '\0';
+  return n + len;
+}
+
 // For testing purposes only
 void Spec_AddToDict(RefManager *rm) {
   dictAdd(specDict_g, ((IndexSpec*)__RefManager_Get_Object(rm))->name, (void *)rm);
@@ -1224,6 +1409,7 @@ static void IndexSpecCache_Free(IndexSpecCache *c) {
     }
     rm_free(c->fields[ii].path);
   }
+  NameIndex_Free(&c->index);
   rm_free(c->fields);
   rm_free(c);
 }
@@ -1253,6 +1439,10 @@ static IndexSpecCache *IndexSpec_BuildSpecCache(const IndexSpec *spec) {
       // use the same pointer for both name and path
       ret->fields[ii].path = ret->fields[ii].name;
     }
+    if (spec->numFields >= SPEC_CACHE_INDEX_MIN_FIELDS) {
+      const char *name = ret->fields[ii].name;
+      NameIndex_Add(&ret->index, NameIndex_Hash(name, strlen(name)), ret->fields + ii);
+    }
   }
   return ret;
 }
@@ -1311,6 +1501,27 @@ static void IndexSpec_FreeUnlinkedData(IndexSpec *spec) {
   if (spec->terms) {
     TrieType_Free(spec->terms);
   }
+  if (spec->phonetics) {
+    TrieType_Free(spec->phonetics);
+  }
+  if (spec->fieldTerms) {
+    TrieType_Free(spec->fieldTerms);
+  }
+  if (spec->termExpansions) {
+    ExpansionCache_Free(spec->termExpansions);
+  }
+  if (spec->clusterStats) {
+    ClusterStats_Free(spec->clusterStats);
+  }
+  if (spec->resultCache) {
+    ResultCache_Free(spec->resultCache);
+  }
+  LazyIndex_Free(spec);
+  BuildProfile_Free(spec);
+  LatencyStats_Free(&spec->latency);
+  if (spec->jsonPlan) {
+    JSONPlan_Free(spec->jsonPlan);
+  }
   // Free TEXT TAG NUMERIC VECTOR and GEOSHAPE fields trie and inverted indexes
   if (spec->keysDict) {
     dictRelease(spec->keysDict);
@@ -1356,8 +1567,13 @@ static void IndexSpec_FreeUnlinkedData(IndexSpec *spec) {
   }
   // Free suffix trie
   if (spec->suffix) {
-    TrieType_Free(spec->suffix);
+    SuffixArray_Free(spec->suffix);
+  }
+  if (spec->ngrams) {
+    NgramIndex_Free(spec->ngrams);
   }
+  array_free_ex(spec->existence, ExistenceIndex_Free(*(ExistenceIndex **)ptr));
+  array_free_ex(spec->sortIndexes, SortIndex_Free(*(SortIndex **)ptr));
 
   // Destroy the spec's lock
   pthread_rwlock_destroy(&spec->rwlock);
@@ -1386,6 +1602,8 @@ void IndexSpec_Free(IndexSpec *spec) {
     }
     spec->isTimerSet = false;
   }
+  // Wait for the contents restored from the RDB
+  IndexPersistence_Free(spec);
   // Stop and destroy indexer
   if (spec->indexer) {
     Indexer_Free(spec->indexer);
@@ -1435,6 +1653,9 @@ void IndexSpec_RemoveFromGlobals(StrongRef spec_ref) {
 
   SchemaPrefixes_RemoveSpec(spec_ref);
 
+  // The keys queued to be indexed are dropped with the index, while the GIL is held
+  AsyncUpdates_Free(spec);
+
   // Mark there are pending index drops.
   // if ref count is > 1, the actual cleanup will be done only when StrongRefs are released.
   addPendingIndexDrop();
@@ -1510,10 +1731,24 @@ StrongRef IndexSpec_LoadUnsafeEx(RedisModuleCtx *ctx, IndexLoadOptions *options)
     }
   }
 
+  if (!(options->flags & INDEXSPEC_LOAD_NOLAZYLOAD)) {
+    LazyIndex_Load(ctx, spec_ref);
+  }
+
+  // the command sees the writes batched before it
+  AsyncUpdates_Flush(sp, ctx);
+
   // Increament the number of uses.
-  IndexSpec_IncreasCounter(sp);
+  if (!(options->flags & INDEXSPEC_LOAD_NOCOUNTER)) {
+    IndexSpec_IncreasCounter(sp);
+  }
 
-  if (!RS_IsMock && (sp->flags & Index_Temporary) && !(options->flags & INDEXSPEC_LOAD_NOTIMERUPDATE)) {
+  // an evicted lazy index is not evicted again, and the commands not reading its contents do not
+  // keep it loaded
+  bool idleTimer = (sp->flags & Index_Temporary) ||
+                   ((sp->flags & Index_Lazy) && LazyIndex_IsLoaded(sp) &&
+                    !(options->flags & INDEXSPEC_LOAD_NOLAZYLOAD));
+  if (!RS_IsMock && idleTimer && !(options->flags & INDEXSPEC_LOAD_NOTIMERUPDATE)) {
     if (sp->isTimerSet) {
       WeakRef old_timer_ref;
       if (RedisModule_StopTimer(RSDummyContext, sp->timerId, (void **)&old_timer_ref) == REDISMODULE_OK) {
@@ -1600,8 +1835,16 @@ IndexSpec *NewIndexSpec(const char *name) {
   sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
   sp->stopwords = DefaultStopWordList();
   sp->terms = NewTrie(NULL, Trie_Sort_Lex);
+  sp->termExpansions = NewExpansionCache();
+  sp->clusterStats = NewClusterStats();
+  sp->resultCache = NewResultCache();
   sp->suffix = NULL;
   sp->suffixMask = (t_fieldMask)0;
+  sp->ngrams = NULL;
+  sp->ngramMask = (t_fieldMask)0;
+  sp->separatePostingsMask = (t_fieldMask)0;
+  sp->existence = NULL;
+  sp->sortIndexes = NULL;
   sp->keysDict = NULL;
   sp->getValue = NULL;
   sp->getValueCtx = NULL;
@@ -1677,6 +1920,57 @@ void IndexSpec_MakeKeyless(IndexSpec *sp) {
   sp->keysDict = dictCreate(&invidxDictType, NULL);
 }
 
+void IndexSpec_ClearContents(IndexSpec *sp) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(RSDummyContext, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+
+  DocTable_Free(&sp->docs);
+  sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
+  TrieType_Free(sp->terms);
+  sp->terms = NewTrie(NULL, Trie_Sort_Lex);
+  if (sp->phonetics) {
+    TrieType_Free(sp->phonetics);
+    sp->phonetics = NULL;
+  }
+  if (sp->fieldTerms) {
+    TrieType_Free(sp->fieldTerms);
+    sp->fieldTerms = NULL;
+  }
+  if (sp->suffix) {
+    SuffixArray_Free(sp->suffix);
+    sp->suffix = NewSuffixArray();
+  }
+  if (sp->ngrams) {
+    NgramIndex_Free(sp->ngrams);
+    sp->ngrams = NewNgramIndex();
+  }
+  for (size_t i = 0; i < array_len(sp->existence); ++i) {
+    ExistenceIndex_Clear(sp->existence[i]);
+  }
+  for (size_t i = 0; i < array_len(sp->sortIndexes); ++i) {
+    SortIndex_Clear(sp->sortIndexes[i]);
+  }
+  dictRelease(sp->keysDict);
+  IndexSpec_MakeKeyless(sp);
+  if (sp->termExpansions) {
+    ExpansionCache_Free(sp->termExpansions);
+    sp->termExpansions = NewExpansionCache();
+  }
+  if (sp->resultCache) {
+    ResultCache_Free(sp->resultCache);
+    sp->resultCache = NewResultCache();
+  }
+  memset(&sp->stats, 0, sizeof(sp->stats));
+  IndexSpec_TermsChanged(sp);
+  // The doc ids start over, the queries and cursors paused on the spec do not resume
+  ++sp->docIdsEpoch;
+
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  // The keys are indexed again by the next scan
+  AsyncUpdates_Free(sp);
+}
+
 // Only used on new specs so it's thread safe
 void IndexSpec_StartGCFromSpec(StrongRef global, IndexSpec *sp, uint32_t gcPolicy) {
   sp->gc = GCContext_CreateGC(global, gcPolicy);
@@ -1957,6 +2251,14 @@ void IndexesScanner_Free(IndexesScanner *scanner) {
     }
     WeakRef_Release(scanner->spec_ref);
   }
+  for (size_t ii = 0; ii < array_len(scanner->pendingKeys); ++ii) {
+    RedisModule_FreeString(RSDummyContext, scanner->pendingKeys[ii]);
+  }
+  array_free(scanner->pendingKeys);
+  for (size_t ii = 0; ii < array_len(scanner->keys); ++ii) {
+    RedisModule_FreeString(RSDummyContext, scanner->keys[ii]);
+  }
+  array_free(scanner->keys);
   if (scanner->spec_name) rm_free(scanner->spec_name);
   rm_free(scanner);
 }
@@ -1988,13 +2290,12 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
 
   // check type of document is support and document is not empty
   DocumentType type = getDocType(key);
-  if (type == DocumentType_Unsupported) {
-    return;
-  }
-
   if (keyOpened) {
     RedisModule_CloseKey(key);
   }
+  if (type == DocumentType_Unsupported) {
+    return;
+  }
 
   if (scanner->global) {
     Indexes_UpdateMatchingWithSchemaRules(ctx, keyname, type, NULL);
@@ -2005,7 +2306,16 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
       // This check is performed without locking the spec, but it's ok since we locked the GIL
       // So the main thread is not running and the GC is not touching the relevant data
       if (SchemaRule_ShouldIndex(sp, keyname, type)) {
-        IndexSpec_UpdateDoc(sp, ctx, keyname, type);
+        if (RSGlobalConfig.bgIndexConcurrent) {
+          // indexed along with the other keys of this scan step, see Indexes_ScanFlush
+          if (!scanner->pendingKeys) {
+            scanner->pendingKeys = array_new(RedisModuleString *, 16);
+          }
+          scanner->pendingKeys = array_append(
+              scanner->pendingKeys, RedisModule_CreateStringFromString(RSDummyContext, keyname));
+        } else {
+          IndexSpec_UpdateDoc(sp, ctx, keyname, type);
+        }
       }
       StrongRef_Release(curr_run_ref);
     } else {
@@ -2016,13 +2326,149 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
   ++scanner->scannedKeys;
 }
 
+/* Index the keys buffered by the last scan step, before the GIL is released */
+static void Indexes_ScanFlush(RedisModuleCtx *ctx, IndexesScanner *scanner) {
+  size_t n = array_len(scanner->pendingKeys);
+  if (!n) {
+    return;
+  }
+  if (!scanner->cancelled) {
+    StrongRef curr_run_ref = WeakRef_Promote(scanner->spec_ref);
+    IndexSpec *sp = StrongRef_Get(curr_run_ref);
+    if (sp) {
+      IndexSpec_UpdateDocs(sp, ctx, scanner->pendingKeys, n);
+      StrongRef_Release(curr_run_ref);
+    } else {
+      scanner->cancelled = true;
+    }
+  }
+  for (size_t ii = 0; ii < n; ++ii) {
+    RedisModule_FreeString(RSDummyContext, scanner->pendingKeys[ii]);
+  }
+  array_clear(scanner->pendingKeys);
+}
+
+/* Scan the next keys, or index the next of the given keys of the scanner. Returns 0 once there are
+ * no more keys */
+static int Indexes_ScanNext(RedisModuleCtx *ctx, RedisModuleScanCursor *cursor,
+                            IndexesScanner *scanner) {
+  if (!scanner->keys) {
+    return RedisModule_Scan(ctx, cursor, (RedisModuleScanCB)Indexes_ScanProc, scanner);
+  }
+  if (scanner->nextKey < array_len(scanner->keys)) {
+    Indexes_ScanProc(ctx, scanner->keys[scanner->nextKey++], NULL, scanner);
+  }
+  return scanner->nextKey < array_len(scanner->keys);
+}
+
 //---------------------------------------------------------------------------------------------
 
+/* Geometries indexed by a scan are packed into their R-trees at once when it is done, which
+ * builds much better trees than inserting them one by one, and faster */
+static void IndexSpec_GeometryBulkLoad(RedisModuleCtx *ctx, IndexSpec *sp, bool start) {
+  if (!(sp->flags & Index_HasGeometry)) {
+    return;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  hires_clock_t t0;
+  hires_clock_get(&t0);
+  for (int i = 0; i < sp->numFields; ++i) {
+    const FieldSpec *fs = sp->fields + i;
+    if (!(fs->types & INDEXFLD_T_GEOMETRY)) {
+      continue;
+    }
+    GeometryIndex *idx = OpenGeometryIndex(ctx, sp, NULL, fs);
+    if (idx) {
+      const GeometryApi *api = GeometryApi_Get(idx);
+      start ? api->startBulkLoad(idx) : api->finishBulkLoad(idx);
+    }
+  }
+  if (!start) {
+    sp->stats.geometryBulkLoadTime += hires_clock_since_usec(&t0);
+  }
+  RedisSearchCtx_UnlockSpec(&sctx);
+}
+
+static void Indexes_GeometryBulkLoad(RedisModuleCtx *ctx, IndexesScanner *scanner, bool start) {
+  if (scanner->global) {
+    dictIterator *iter = dictGetIterator(specDict_g);
+    dictEntry *entry = NULL;
+    while ((entry = dictNext(iter))) {
+      StrongRef spec_ref = dictGetRef(entry);
+      IndexSpec_GeometryBulkLoad(ctx, StrongRef_Get(spec_ref), start);
+    }
+    dictReleaseIterator(iter);
+  } else {
+    StrongRef curr_run_ref = WeakRef_Promote(scanner->spec_ref);
+    IndexSpec *sp = StrongRef_Get(curr_run_ref);
+    if (sp) {
+      IndexSpec_GeometryBulkLoad(ctx, sp, start);
+      StrongRef_Release(curr_run_ref);
+    }
+  }
+}
+
+/* Record a step of the scan in the build profiles of the indexes it builds */
+static void Indexes_ProfileScan(IndexesScanner *scanner,
+                                void (*record)(IndexSpec *, const BuildProfileStep *),
+                                BuildProfileStep *step) {
+  step->global = scanner->global;
+  step->scannedKeys = scanner->scannedKeys;
+  if (scanner->global) {
+    dictIterator *iter = dictGetIterator(specDict_g);
+    dictEntry *entry = NULL;
+    while ((entry = dictNext(iter))) {
+      StrongRef spec_ref = dictGetRef(entry);
+      record(StrongRef_Get(spec_ref), step);
+    }
+    dictReleaseIterator(iter);
+  } else {
+    StrongRef curr_run_ref = WeakRef_Promote(scanner->spec_ref);
+    IndexSpec *sp = StrongRef_Get(curr_run_ref);
+    if (sp) {
+      record(sp, step);
+      StrongRef_Release(curr_run_ref);
+    }
+  }
+}
+
+// The shortest slice a background scan holding the GIL for several batches of keys shrinks to
+#define BG_INDEX_MIN_SLICE_USEC 50
+
+/* The vector index jobs of a scan step are queued to the workers in batches, rather than one by one
+ * as the vectors are inserted. Those of an index are counted until the workers run them, see
+ * IndexesScanner_IndexedPercent. The index is held for the step, which must end before the GIL is
+ * released */
+static StrongRef Indexes_ScanStepStart(IndexesScanner *scanner) {
+  StrongRef step_ref = INVALID_STRONG_REF;
+  size_t *pending = NULL;
+  if (!scanner->global) {
+    step_ref = WeakRef_Promote(scanner->spec_ref);
+    IndexSpec *sp = StrongRef_Get(step_ref);
+    if (sp) {
+      pending = &sp->scanVectorJobs;
+    } else {
+      step_ref = INVALID_STRONG_REF;
+    }
+  }
+  ThreadPoolAPI_HoldIndexJobs(pending);
+  return step_ref;
+}
+
+static void Indexes_ScanStepEnd(StrongRef step_ref) {
+  ThreadPoolAPI_FlushIndexJobs();
+  if (step_ref.rm) {
+    StrongRef_Release(step_ref);
+  }
+}
+
 static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
   RS_LOG_ASSERT(scanner, "invalid IndexesScanner");
 
   RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
   RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
+  BuildProfileStep step = {0};
   RedisModule_ThreadSafeContextLock(ctx);
 
   if (scanner->cancelled) {
@@ -2033,29 +2479,74 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
   } else {
     RedisModule_Log(ctx, "notice", "Scanning index %s in background", scanner->spec_name);
   }
+  Indexes_ProfileScan(scanner, BuildProfile_Start, &step);
+  Indexes_GeometryBulkLoad(ctx, scanner, true);
 
   size_t counter = 0;
-  while (RedisModule_Scan(ctx, cursor, (RedisModuleScanCB)Indexes_ScanProc, scanner)) {
+  // The slice is shortened while the main thread is busy, and lengthened back while it is idle
+  long long maxSlice = RSGlobalConfig.bgIndexSliceUsec;
+  long long slice = maxSlice;
+  // Reads the clock every few scan calls, as many as take a fraction of the slice
+  ConcurrentYieldCtl yield;
+  ConcurrentYieldCtl_Init(&yield, slice * 1000);
+  bool contended = false;
+  hires_clock_t sliceStart;
+  hires_clock_get(&sliceStart);
+  for (;;) {
+    yield.targetNS = slice * 1000;
+    ConcurrentYieldCtl_Start(&yield);
+    StrongRef step_ref = Indexes_ScanStepStart(scanner);
+    int more;
+    do {
+      more = Indexes_ScanNext(ctx, cursor, scanner);
+    } while (more && slice && !ConcurrentYieldCtl_Tick(&yield));
+    if (!more) {
+      Indexes_ScanStepEnd(step_ref);
+      break;
+    }
+    Indexes_ScanFlush(ctx, scanner);
+    Indexes_ScanStepEnd(step_ref);
+    step.workMs = hires_clock_since_usec(&sliceStart) / 1000;
+    Indexes_ProfileScan(scanner, BuildProfile_Slice, &step);
     RedisModule_ThreadSafeContextUnlock(ctx);
     counter++;
-    if (counter % RSGlobalConfig.numBGIndexingIterationsBeforeSleep == 0) {
+    if (contended || counter % RSGlobalConfig.numBGIndexingIterationsBeforeSleep == 0) {
       // Sleep for one microsecond to allow redis server to acquire the GIL while we release it.
-      // We do that periodically every X iterations (100 as default), otherwise we call
-      // 'sched_yield()'. That is since 'sched_yield()' doesn't give up the processor for enough
-      // time to ensure that other threads that are waiting for the GIL will actually have the
-      // chance to take it.
+      // We do that periodically every X iterations (100 as default), and whenever the main
+      // thread is found waiting on the scan, otherwise we call 'sched_yield()'. That is since
+      // 'sched_yield()' doesn't give up the processor for enough time to ensure that other
+      // threads that are waiting for the GIL will actually have the chance to take it.
       usleep(1);
     } else {
       sched_yield();
     }
+    hires_clock_t waitStart;
+    hires_clock_get(&waitStart);
     RedisModule_ThreadSafeContextLock(ctx);
+    step.waitMs = hires_clock_since_usec(&waitStart) / 1000;
+    hires_clock_get(&sliceStart);
+    if (maxSlice) {
+      // waiting for the GIL for longer than a slice means commands are waiting for the scan too
+      contended = step.waitMs * 1000 > slice;
+      if (contended) {
+        slice = MAX(slice / 2, BG_INDEX_MIN_SLICE_USEC);
+      } else {
+        slice = MIN(slice + slice / 4 + 1, maxSlice);
+      }
+    }
 
     if (scanner->cancelled) {
       RedisModule_Log(ctx, "notice", "Scanning indexes in background: cancelled (scanned=%ld)",
                   scanner->totalKeys);
+      step.workMs = 0;
       goto end;
     }
   }
+  StrongRef step_ref = Indexes_ScanStepStart(scanner);
+  Indexes_ScanFlush(ctx, scanner);
+  Indexes_ScanStepEnd(step_ref);
+  step.workMs = hires_clock_since_usec(&sliceStart) / 1000;
+  step.waitMs = 0;
 
   if (scanner->global) {
     RedisModule_Log(ctx, "notice", "Scanning indexes in background: done (scanned=%ld)",
@@ -2065,7 +2556,13 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
                     scanner->spec_name, scanner->totalKeys);
   }
 
-end:
+end:;
+  // also when cancelled, so the specs that are still alive do not keep buffering
+  hires_clock_t bulkStart;
+  hires_clock_get(&bulkStart);
+  Indexes_GeometryBulkLoad(ctx, scanner, false);
+  step.bulkLoadMs = hires_clock_since_usec(&bulkStart) / 1000;
+  Indexes_ProfileScan(scanner, BuildProfile_End, &step);
   if (!scanner->cancelled && scanner->global) {
     Indexes_SetTempSpecsTimers(TimerOp_Add);
   }
@@ -2079,11 +2576,15 @@ end:
 
 //---------------------------------------------------------------------------------------------
 
-static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
+static void ReindexPool_Start() {
   if (!reindexPool) {
     reindexPool = redisearch_thpool_create(1, DEFAULT_PRIVILEGED_THREADS_NUM);
     redisearch_thpool_init(reindexPool, LogCallback);
   }
+}
+
+static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
+  ReindexPool_Start();
 #ifdef _DEBUG
   RedisModule_Log(NULL, "notice", "Register index %s for async scan", ((IndexSpec*)StrongRef_Get(spec_ref))->name);
 #endif
@@ -2091,6 +2592,66 @@ static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
   redisearch_thpool_add_work(reindexPool, (redisearch_thpool_proc)Indexes_ScanAndReindexTask, scanner, THPOOL_PRIORITY_HIGH);
 }
 
+static int cmpDocIds(const void *p1, const void *p2) {
+  t_docId a = *(const t_docId *)p1, b = *(const t_docId *)p2;
+  return a < b ? -1 : a > b;
+}
+
+// Assumes that the spec is in a safe state to set a scanner on it (write lock or main thread)
+void IndexSpec_ReindexTermsDocs(RedisModuleCtx *ctx, StrongRef spec_ref, const char **terms,
+                                size_t n) {
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (sp->scan_in_progress) {
+    // the scan may have passed the documents already
+    IndexSpec_ScanAndReindex(ctx, spec_ref);
+    return;
+  }
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  arrayof(t_docId) ids = array_new(t_docId, 16);
+  for (size_t i = 0; i < n; ++i) {
+    RedisModuleKey *keyp = NULL;
+    InvertedIndex *idx = Redis_OpenInvertedIndexEx(&sctx, terms[i], strlen(terms[i]), 0, NULL, &keyp);
+    if (idx) {
+      IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+      RSIndexResult *res;
+      while (IR_Read(ir, &res) == INDEXREAD_OK) {
+        ids = array_append(ids, res->docId);
+      }
+      IR_Free(ir);
+    }
+    if (keyp) {
+      RedisModule_CloseKey(keyp);
+    }
+  }
+
+  // a document with several of the terms is reindexed once
+  qsort(ids, array_len(ids), sizeof(*ids), cmpDocIds);
+  arrayof(RedisModuleString *) keys = array_new(RedisModuleString *, array_len(ids));
+  for (size_t i = 0; i < array_len(ids); ++i) {
+    if (i && ids[i] == ids[i - 1]) {
+      continue;
+    }
+    size_t len;
+    sds key = DocTable_GetKey(&sp->docs, ids[i], &len);
+    if (key) {
+      keys = array_append(keys, RedisModule_CreateString(RSDummyContext, key, len));
+      sdsfree(key);
+    }
+  }
+  array_free(ids);
+  if (!array_len(keys)) {
+    array_free(keys);
+    return;
+  }
+
+  ReindexPool_Start();
+  IndexesScanner *scanner = IndexesScanner_New(spec_ref);
+  scanner->keys = keys;
+  scanner->totalKeys = array_len(keys);
+  redisearch_thpool_add_work(reindexPool, (redisearch_thpool_proc)Indexes_ScanAndReindexTask, scanner, THPOOL_PRIORITY_HIGH);
+}
+
 void ReindexPool_ThreadPoolDestroy() {
   if (reindexPool != NULL) {
     RedisModule_ThreadSafeContextUnlock(RSDummyContext);
@@ -2182,8 +2743,12 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
       RedisModule_InfoAddFieldCString(ctx, SPEC_SORTABLE_STR, "ON");
     if (FieldSpec_IsNoStem(fs))
       RedisModule_InfoAddFieldCString(ctx, SPEC_NOSTEM_STR, "ON");
+    if (FieldSpec_IsNoOffsets(fs))
+      RedisModule_InfoAddFieldCString(ctx, SPEC_NOOFFSETS_STR, "ON");
     if (!FieldSpec_IsIndexable(fs))
       RedisModule_InfoAddFieldCString(ctx, SPEC_NOINDEX_STR, "ON");
+    if (FieldSpec_IsNumericBKD(fs))
+      RedisModule_InfoAddFieldCString(ctx, SPEC_INDEXTYPE_STR, SPEC_NUMERIC_BKD_STR);
 
     RedisModule_InfoEndDictField(ctx);
   }
@@ -2202,8 +2767,8 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
   RedisModule_InfoAddFieldDouble(ctx, "vector_index_size", IndexSpec_VectorIndexSize(sp) / (float)0x100000);
   RedisModule_InfoAddFieldDouble(ctx, "offset_vectors_size", sp->stats.offsetVecsSize / (float)0x100000);
   RedisModule_InfoAddFieldDouble(ctx, "doc_table_size", sp->docs.memsize / (float)0x100000);
-  RedisModule_InfoAddFieldDouble(ctx, "sortable_values_size", sp->docs.sortablesSize / (float)0x100000);
-  RedisModule_InfoAddFieldDouble(ctx, "key_table_size", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  RedisModule_InfoAddFieldDouble(ctx, "sortable_values_size", IndexSpec_SortablesSize(sp) / (float)0x100000);
+  RedisModule_InfoAddFieldDouble(ctx, "key_table_size", DocIdMap_MemUsage(&sp->docs.dim) / (float)0x100000);
   RedisModule_InfoEndDictField(ctx);
 
   RedisModule_InfoAddFieldULongLong(ctx, "total_inverted_index_blocks", TotalIIBlocks);
@@ -2244,6 +2809,36 @@ void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, StrongRef spec_ref) {
   }
 }
 
+// Assuming the GIL is held. The scan replaces a background scan of the spec, if any
+void IndexSpec_ScanAndReindexSync(RedisModuleCtx *ctx, StrongRef spec_ref) {
+  if (RedisModule_DbSize(ctx) == 0) {
+    return;
+  }
+  IndexesScanner *scanner = IndexesScanner_New(spec_ref);
+  RedisModuleScanCursor *cursor = RedisModule_ScanCursorCreate();
+  BuildProfileStep step = {0};
+  Indexes_ProfileScan(scanner, BuildProfile_Start, &step);
+  hires_clock_t t0;
+  hires_clock_get(&t0);
+  Indexes_GeometryBulkLoad(ctx, scanner, true);
+  StrongRef step_ref = Indexes_ScanStepStart(scanner);
+  while (RedisModule_Scan(ctx, cursor, (RedisModuleScanCB)Indexes_ScanProc, scanner)) {
+    // bounds the keys buffered by a concurrent scan
+    Indexes_ScanFlush(ctx, scanner);
+  }
+  Indexes_ScanFlush(ctx, scanner);
+  Indexes_ScanStepEnd(step_ref);
+  // a single slice, holding the GIL throughout
+  step.workMs = hires_clock_since_usec(&t0) / 1000;
+  hires_clock_t bulkStart;
+  hires_clock_get(&bulkStart);
+  Indexes_GeometryBulkLoad(ctx, scanner, false);
+  step.bulkLoadMs = hires_clock_since_usec(&bulkStart) / 1000;
+  Indexes_ProfileScan(scanner, BuildProfile_End, &step);
+  IndexesScanner_Free(scanner);
+  RedisModule_ScanCursorDestroy(cursor);
+}
+
 // only used on "RDB load finished" event (before the server is ready to accept commands)
 // so it threadsafe
 void IndexSpec_DropLegacyIndexFromKeySpace(IndexSpec *sp) {
@@ -2323,6 +2918,8 @@ void Indexes_ScanAndReindex() {
 
 int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
                                        QueryError *status) {
+  hires_clock_t t0;
+  hires_clock_get(&t0);
   IndexSpec *sp = rm_calloc(1, sizeof(IndexSpec));
   StrongRef spec_ref = StrongRef_New(sp, (RefManager_Free)IndexSpec_Free);
   sp->own_ref = spec_ref;
@@ -2358,10 +2955,21 @@ int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
       sp->flags |= Index_HasSuffixTrie;
       sp->suffixMask |= FIELD_BIT(fs);
       if (!sp->suffix) {
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
+        sp->suffix = NewSuffixArray();
       }
     }
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_HasNgrams(fs)) {
+      sp->ngramMask |= FIELD_BIT(fs);
+      if (!sp->ngrams) {
+        sp->ngrams = NewNgramIndex();
+      }
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_HasSeparatePostings(fs)) {
+      sp->separatePostingsMask |= FIELD_BIT(fs);
+    }
   }
+  IndexSpec_AddExistence(sp, 0);
+  IndexSpec_AddSortIndexes(sp, 0);
   // After loading all the fields, we can build the spec cache
   sp->spcache = IndexSpec_BuildSpecCache(sp);
 
@@ -2375,6 +2983,9 @@ int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
 
   //    DocTable_RdbLoad(&sp->docs, rdb, encver);
   sp->terms = NewTrie(NULL, Trie_Sort_Lex);
+  sp->termExpansions = NewExpansionCache();
+  sp->clusterStats = NewClusterStats();
+  sp->resultCache = NewResultCache();
   /* For version 3 or up - load the generic trie */
   //  if (encver >= 3) {
   //    sp->terms = TrieType_GenericLoad(rdb, 0);
@@ -2415,9 +3026,17 @@ int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
     }
   }
 
+  if (encver >= INDEX_CONTENT_VERSION && IndexPersistence_RdbLoad(rdb, sp, encver) != REDISMODULE_OK) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Failed to load index contents");
+    goto cleanup;
+  }
+
   sp->indexer = NewIndexer(sp);
 
   sp->scan_in_progress = false;
+  if (sp->flags & Index_Lazy) {
+    LazyIndex_Init(sp);
+  }
 
   RefManager *oldSpec = dictFetchValue(specDict_g, sp->name);
   if (oldSpec) {
@@ -2434,6 +3053,10 @@ int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
     spec_ref = (StrongRef){oldSpec};
   } else {
     dictAdd(specDict_g, sp->name, spec_ref.rm);
+    if (sp->restore) {
+      IndexPersistence_Track(sp);
+    }
+    BuildProfile_RdbLoaded(sp, hires_clock_since_usec(&t0) / 1000);
   }
 
   for (int i = 0; i < sp->numFields; i++) {
@@ -2495,6 +3118,9 @@ void *IndexSpec_LegacyRdbLoad(RedisModuleIO *rdb, int encver) {
   } else {
     sp->terms = NewTrie(NULL, Trie_Sort_Lex);
   }
+  sp->termExpansions = NewExpansionCache();
+  sp->clusterStats = NewClusterStats();
+  sp->resultCache = NewResultCache();
 
   if (sp->flags & Index_HasCustomStopwords) {
     sp->stopwords = StopWordList_RdbLoad(rdb, encver);
@@ -2583,49 +3209,54 @@ cleanup:
   return REDISMODULE_ERR;
 }
 
-void Indexes_RdbSave(RedisModuleIO *rdb, int when) {
+void IndexSpec_RdbSave(RedisModuleIO *rdb, IndexSpec *sp) {
+  // we save the name plus the null terminator
+  RedisModule_SaveStringBuffer(rdb, sp->name, sp->nameLen + 1);
+  RedisModule_SaveUnsigned(rdb, (uint64_t)sp->flags);
+  RedisModule_SaveUnsigned(rdb, sp->numFields);
+  for (int i = 0; i < sp->numFields; i++) {
+    FieldSpec_RdbSave(rdb, &sp->fields[i]);
+  }
 
-  RedisModule_SaveUnsigned(rdb, dictSize(specDict_g));
+  SchemaRule_RdbSave(sp->rule, rdb);
 
-  dictIterator *iter = dictGetIterator(specDict_g);
-  dictEntry *entry = NULL;
-  while ((entry = dictNext(iter))) {
-    StrongRef spec_ref = dictGetRef(entry);
-    IndexSpec *sp = StrongRef_Get(spec_ref);
-    // we save the name plus the null terminator
-    RedisModule_SaveStringBuffer(rdb, sp->name, sp->nameLen + 1);
-    RedisModule_SaveUnsigned(rdb, (uint64_t)sp->flags);
-    RedisModule_SaveUnsigned(rdb, sp->numFields);
-    for (int i = 0; i < sp->numFields; i++) {
-      FieldSpec_RdbSave(rdb, &sp->fields[i]);
-    }
+  //    IndexStats_RdbSave(rdb, &sp->stats);
+  //    DocTable_RdbSave(&sp->docs, rdb);
+  //    // save trie of terms
+  //    TrieType_GenericSave(rdb, sp->terms, 0);
 
-    SchemaRule_RdbSave(sp->rule, rdb);
+  // If we have custom stopwords, save them
+  if (sp->flags & Index_HasCustomStopwords) {
+    StopWordList_RdbSave(rdb, sp->stopwords);
+  }
 
-    //    IndexStats_RdbSave(rdb, &sp->stats);
-    //    DocTable_RdbSave(&sp->docs, rdb);
-    //    // save trie of terms
-    //    TrieType_GenericSave(rdb, sp->terms, 0);
+  if (sp->flags & Index_HasSmap) {
+    SynonymMap_RdbSave(rdb, sp->smap);
+  }
 
-    // If we have custom stopwords, save them
-    if (sp->flags & Index_HasCustomStopwords) {
-      StopWordList_RdbSave(rdb, sp->stopwords);
-    }
+  RedisModule_SaveUnsigned(rdb, sp->timeout);
 
-    if (sp->flags & Index_HasSmap) {
-      SynonymMap_RdbSave(rdb, sp->smap);
+  if (sp->aliases) {
+    RedisModule_SaveUnsigned(rdb, array_len(sp->aliases));
+    for (size_t ii = 0; ii < array_len(sp->aliases); ++ii) {
+      RedisModule_SaveStringBuffer(rdb, sp->aliases[ii], strlen(sp->aliases[ii]) + 1);
     }
+  } else {
+    RedisModule_SaveUnsigned(rdb, 0);
+  }
+
+  IndexPersistence_RdbSave(rdb, sp);
+}
 
-    RedisModule_SaveUnsigned(rdb, sp->timeout);
+void Indexes_RdbSave(RedisModuleIO *rdb, int when) {
 
-    if (sp->aliases) {
-      RedisModule_SaveUnsigned(rdb, array_len(sp->aliases));
-      for (size_t ii = 0; ii < array_len(sp->aliases); ++ii) {
-        RedisModule_SaveStringBuffer(rdb, sp->aliases[ii], strlen(sp->aliases[ii]) + 1);
-      }
-    } else {
-      RedisModule_SaveUnsigned(rdb, 0);
-    }
+  RedisModule_SaveUnsigned(rdb, dictSize(specDict_g));
+
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry = NULL;
+  while ((entry = dictNext(iter))) {
+    StrongRef spec_ref = dictGetRef(entry);
+    IndexSpec_RdbSave(rdb, StrongRef_Get(spec_ref));
   }
 
   dictReleaseIterator(iter);
@@ -2670,6 +3301,7 @@ static void Indexes_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint
   if (subevent == REDISMODULE_SUBEVENT_LOADING_RDB_START ||
       subevent == REDISMODULE_SUBEVENT_LOADING_AOF_START ||
       subevent == REDISMODULE_SUBEVENT_LOADING_REPL_START) {
+    IndexPersistence_Reset();
     Indexes_Free(specDict_g);
     if (legacySpecDict) {
       dictEmpty(legacySpecDict, NULL);
@@ -2690,6 +3322,9 @@ static void Indexes_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint
 
     LegacySchemaRulesArgs_Free(ctx);
 
+    // Without the loaded event the restored indexes are rescanned along with the others
+    IndexPersistence_LoadingEnded(ctx, CompareVestions(redisVersion, noScanVersion) >= 0);
+
     if (hasLegacyIndexes || CompareVestions(redisVersion, noScanVersion) < 0) {
       Indexes_ScanAndReindex();
     } else {
@@ -2700,6 +3335,8 @@ static void Indexes_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint
     workersThreadPool_waitAndTerminate(ctx);
 #endif
     RedisModule_Log(RSDummyContext, "notice", "Loading event ends");
+  } else if (subevent == REDISMODULE_SUBEVENT_LOADING_FAILED) {
+    IndexPersistence_Reset();
   }
 }
 
@@ -2740,28 +3377,19 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx) {
 
 int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx);
 
-int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
-  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
-
-  if (!spec->rule) {
-    RedisModule_Log(ctx, "warning", "Index spec %s: no rule found", spec->name);
-    return REDISMODULE_ERR;
-  }
-
-  hires_clock_t t0;
-  hires_clock_get(&t0);
-
-  Document doc = {0};
-  Document_Init(&doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
+/* Load the document of the key, or delete it from the index if it can't be loaded */
+static int IndexSpec_LoadDoc(RedisSearchCtx *sctx, Document *doc, RedisModuleString *key,
+                             DocumentType type) {
+  Document_Init(doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
   // if a key does not exit, is not a hash or has no fields in index schema
 
   int rv = REDISMODULE_ERR;
   switch (type) {
   case DocumentType_Hash:
-    rv = Document_LoadSchemaFieldHash(&doc, &sctx);
+    rv = Document_LoadSchemaFieldHash(doc, sctx);
     break;
   case DocumentType_Json:
-    rv = Document_LoadSchemaFieldJson(&doc, &sctx);
+    rv = Document_LoadSchemaFieldJson(doc, sctx);
     break;
   case DocumentType_Unsupported:
     RS_LOG_ASSERT(0, "Should receieve valid type");
@@ -2769,29 +3397,114 @@ int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
 
   if (rv != REDISMODULE_OK) {
     // we already unlocked the spec but we can increase this value atomically
-    __atomic_add_fetch(&spec->stats.indexingFailures, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sctx->spec->stats.indexingFailures, 1, __ATOMIC_RELAXED);
 
     // if a document did not load properly, it is deleted
     // to prevent mismatch of index and hash
-    IndexSpec_DeleteDoc(spec, ctx, key);
-    Document_Free(&doc);
+    IndexSpec_DeleteDoc(sctx->spec, sctx->redisCtx, key);
+    Document_Free(doc);
+  }
+  return rv;
+}
+
+/* Account for the time since `t0` it took to index `n` documents. The documents of a batch are
+ * indexed together, so each of them is recorded with the average of the batch */
+static void indexSpec_AddIndexTime(IndexSpec *spec, hires_clock_t *t0, size_t n) {
+  long double usec = hires_clock_since_usec(t0);
+  spec->stats.totalIndexTime += usec;
+  for (size_t ii = 0; ii < n; ++ii) {
+    LatencyStats_Record(&spec->latency, LATENCY_CMD_INDEXING, LATENCY_PHASE_TOTAL,
+                        usec / n / 1000);
+  }
+}
+
+int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+
+  if (!spec->rule) {
+    RedisModule_Log(ctx, "warning", "Index spec %s: no rule found", spec->name);
     return REDISMODULE_ERR;
   }
 
+  hires_clock_t t0;
+  hires_clock_get(&t0);
+
+  Document doc = {0};
+  if (IndexSpec_LoadDoc(&sctx, &doc, key, type) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  uint64_t indexedHash = Document_IndexedHash(&doc, spec);
   RedisSearchCtx_LockSpecWrite(&sctx);
 
+  // a document whose indexed values did not change keeps its id, and leaves nothing to collect
+  if (Document_UpdateUnindexed(&doc, &sctx, indexedHash)) {
+    Document_Free(&doc);
+    indexSpec_AddIndexTime(spec, &t0, 1);
+    RedisSearchCtx_UnlockSpec(&sctx);
+    return REDISMODULE_OK;
+  }
+
   QueryError status = {0};
   RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, &doc, &status);
   aCtx->stateFlags |= ACTX_F_NOBLOCK | ACTX_F_NOFREEDOC;
+  aCtx->indexedHash = indexedHash;
   AddDocumentCtx_Submit(aCtx, &sctx, DOCUMENT_ADD_REPLACE);
 
   Document_Free(&doc);
 
-  spec->stats.totalIndexTime += hires_clock_since_usec(&t0);
+  indexSpec_AddIndexTime(spec, &t0, 1);
   RedisSearchCtx_UnlockSpec(&sctx);
   return REDISMODULE_OK;
 }
 
+/* Index the documents of the keys, which all match the rule of the spec, like
+ * IndexSpec_UpdateDoc() does for each of them, but preprocessing them concurrently */
+void IndexSpec_UpdateDocs(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString **keys,
+                          size_t n) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  hires_clock_t t0;
+  hires_clock_get(&t0);
+
+  Document *docs = rm_calloc(n, sizeof(*docs));
+  bool *loaded = rm_calloc(n, sizeof(*loaded));
+  for (size_t ii = 0; ii < n; ++ii) {
+    loaded[ii] = IndexSpec_LoadDoc(&sctx, docs + ii, keys[ii], spec->rule->type) == REDISMODULE_OK;
+  }
+
+  RedisSearchCtx_LockSpecWrite(&sctx);
+
+  RSAddDocumentCtx **aCtxs = array_new(RSAddDocumentCtx *, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (!loaded[ii]) {
+      continue;
+    }
+    // as in IndexSpec_UpdateDoc, a document whose indexed values did not change is not reindexed
+    uint64_t indexedHash = Document_IndexedHash(docs + ii, spec);
+    if (Document_UpdateUnindexed(docs + ii, &sctx, indexedHash)) {
+      continue;
+    }
+    QueryError status = {0};
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, docs + ii, &status);
+    aCtx->stateFlags |= ACTX_F_NOBLOCK | ACTX_F_NOFREEDOC;
+    aCtx->indexedHash = indexedHash;
+    aCtxs = array_append(aCtxs, aCtx);
+  }
+  AddDocumentCtx_SubmitBatch(aCtxs, array_len(aCtxs), &sctx, DOCUMENT_ADD_REPLACE);
+  array_free(aCtxs);
+
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (loaded[ii]) {
+      Document_Free(docs + ii);
+    }
+  }
+  rm_free(loaded);
+  rm_free(docs);
+
+  indexSpec_AddIndexTime(spec, &t0, n);
+  RedisSearchCtx_UnlockSpec(&sctx);
+}
+
 void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, t_docId id) {
 
   if (DocTable_DeleteR(&spec->docs, key)) {
@@ -2799,7 +3512,7 @@ void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModul
 
     // Increment the index's garbage collector's scanning frequency after document deletions
     if (spec->gc) {
-      GCContext_OnDelete(spec->gc);
+      GCContext_OnDelete(spec->gc, id);
     }
   }
 
@@ -2823,6 +3536,7 @@ void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModul
   if (spec->flags & Index_HasGeometry) {
     GeometryIndex_RemoveId(ctx, spec, id);
   }
+  IndexSpec_RemoveExistence(spec, id);
 }
 
 int IndexSpec_DeleteDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
@@ -2862,6 +3576,26 @@ void Indexes_Init(RedisModuleCtx *ctx) {
   SchemaPrefixes_Create();
 }
 
+/* Whether the key passes the FILTER of the spec, if it has one. The fields of the filter are loaded
+ * into `*r`, which is created on first use and shared by the specs the key is matched against, so
+ * that a field is loaded once for all of them */
+static bool keyPassesFilter(RedisModuleCtx *ctx, EvalCtx **r, IndexSpec *spec, const char *key_p) {
+  if (!spec->rule->filter_exp) {
+    return true;
+  }
+  if (!*r) {
+    *r = EvalCtx_Create();
+  }
+  RLookup_LoadRuleFields(ctx, &(*r)->lk, &(*r)->row, spec, key_p);
+
+  bool passes = true;
+  if (EvalCtx_EvalExpr(*r, spec->rule->filter_exp) == EXPR_EVAL_OK) {
+    passes = RSValue_BoolTest(&(*r)->res);
+  }
+  QueryError_ClearError((*r)->ee.err);
+  return passes;
+}
+
 SpecOpIndexingCtx *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
                                                    bool runFilters,
                                                    RedisModuleString *keyToReadData) {
@@ -2900,7 +3634,9 @@ SpecOpIndexingCtx *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisMod
     for (int j = 0; j < array_len(node->index_specs); ++j) {
       StrongRef global = node->index_specs[j];
       IndexSpec *spec = StrongRef_Get(global);
-      if (spec && !dictFind(specs, spec->name)) {
+      // an evicted lazy index indexes the keys again once it is loaded
+      if (spec && LazyIndex_IsLoaded(spec) && !IndexPersistence_Skip(spec) &&
+          !dictFind(specs, spec->name)) {
         SpecOpCtx specOp = {
             .spec = spec,
             .op = SpecOp_Add,
@@ -2916,25 +3652,12 @@ SpecOpIndexingCtx *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisMod
   array_free(prefixes);
 
   if (runFilters) {
-
     EvalCtx *r = NULL;
     for (size_t i = 0; i < array_len(res->specsOps); ++i) {
       SpecOpCtx *specOp = res->specsOps + i;
-      IndexSpec *spec = specOp->spec;
-      if (!spec->rule->filter_exp) {
-        continue;
-      }
-
-      // load hash only if required
-      if (!r) r = EvalCtx_Create();
-      RLookup_LoadRuleFields(ctx, &r->lk, &r->row, spec, key_p);
-
-      if (EvalCtx_EvalExpr(r, spec->rule->filter_exp) == EXPR_EVAL_OK) {
-        if (!RSValue_BoolTest(&r->res) && dictFind(specs, spec->name)) {
-          specOp->op = SpecOp_Del;
-        }
+      if (!keyPassesFilter(ctx, &r, specOp->spec, key_p)) {
+        specOp->op = SpecOp_Del;
       }
-      QueryError_ClearError(r->ee.err);
     }
 
     if (r) {
@@ -2981,7 +3704,11 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
     return;
   }
 
-  SpecOpIndexingCtx *specs = Indexes_FindMatchingSchemaRules(ctx, key, true, NULL);
+  // The filters are only evaluated for the specs the write is relevant to, rather than for all the
+  // specs matching the key by prefix
+  SpecOpIndexingCtx *specs = Indexes_FindMatchingSchemaRules(ctx, key, false, NULL);
+  const char *key_p = RedisModule_StringPtrLen(key, NULL);
+  EvalCtx *r = NULL;
 
   for (size_t i = 0; i < array_len(specs->specsOps); ++i) {
     SpecOpCtx *specOp = specs->specsOps + i;
@@ -2992,7 +3719,9 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
     }
 
     if (hashFieldChanged(specOp->spec, hashFields)) {
-      if (specOp->op == SpecOp_Add) {
+      if (AsyncUpdates_ShouldQueue(specOp->spec)) {
+        AsyncUpdates_Enqueue(specOp->spec, ctx, key);
+      } else if (keyPassesFilter(ctx, &r, specOp->spec, key_p)) {
         IndexSpec_UpdateDoc(specOp->spec, ctx, key, type);
       } else {
         IndexSpec_DeleteDoc(specOp->spec, ctx, key);
@@ -3000,6 +3729,9 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
     }
   }
 
+  if (r) {
+    EvalCtx_Destroy(r);
+  }
   Indexes_SpecOpsIndexingCtxFree(specs);
 }
 
@@ -3009,7 +3741,12 @@ void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
 
   for (size_t i = 0; i < array_len(specs->specsOps); ++i) {
     SpecOpCtx *specOp = specs->specsOps + i;
-    if (hashFieldChanged(specOp->spec, hashFields)) {
+    if (!hashFieldChanged(specOp->spec, hashFields)) {
+      continue;
+    }
+    if (AsyncUpdates_ShouldQueue(specOp->spec)) {
+      AsyncUpdates_Enqueue(specOp->spec, ctx, key);
+    } else {
       IndexSpec_DeleteDoc(specOp->spec, ctx, key);
     }
   }
@@ -3034,6 +3771,12 @@ void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStri
   for (size_t i = 0; i < array_len(from_specs->specsOps); ++i) {
     SpecOpCtx *specOp = from_specs->specsOps + i;
     IndexSpec *spec = specOp->spec;
+    if (AsyncUpdates_ShouldQueue(spec)) {
+      // the renamed document may still be queued, so both keys are indexed by their contents
+      // when the queue is drained (the new key is queued below, if it matches the rule)
+      AsyncUpdates_Enqueue(spec, ctx, from_key);
+      continue;
+    }
     if (specOp->op == SpecOp_Del) {
       // the document is not in the index from the first place
       continue;
@@ -3062,6 +3805,10 @@ void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStri
       // on the spec from section.
       continue;
     }
+    if (AsyncUpdates_ShouldQueue(specOp->spec)) {
+      AsyncUpdates_Enqueue(specOp->spec, ctx, to_key);
+      continue;
+    }
     IndexSpec_UpdateDoc(specOp->spec, ctx, to_key, type);
   }
   Indexes_SpecOpsIndexingCtxFree(from_specs);
@@ -24,6 +24,18 @@
 #include "util/references.h"
 #include "redisearch_api.h"
 #include "rules.h"
+#include "expansion_cache.h"
+#include "cluster_stats.h"
+#include "result_cache.h"
+#include "async_updates.h"
+#include "lazy_index.h"
+#include "build_profile.h"
+#include "latency_stats.h"
+#include "json_plan.h"
+#include "ngram_index.h"
+#include "existence_index.h"
+#include "sort_index.h"
+#include "util/name_index.h"
 #include <pthread.h>
 
 #ifdef __cplusplus
@@ -63,6 +75,16 @@ struct DocumentIndexer;
 #define SPEC_ASYNC_STR "ASYNC"
 #define SPEC_SKIPINITIALSCAN_STR "SKIPINITIALSCAN"
 #define SPEC_WITHSUFFIXTRIE_STR "WITHSUFFIXTRIE"
+#define SPEC_WITHNGRAMS_STR "WITHNGRAMS"
+#define SPEC_INDEXMISSING_STR "INDEXMISSING"
+#define SPEC_SORTINDEX_STR "SORTINDEX"
+#define SPEC_SEPARATEPOSTINGS_STR "SEPARATEPOSTINGS"
+#define SPEC_RESULTCACHE_STR "RESULTCACHE"
+#define SPEC_ASYNCUPDATES_STR "ASYNCUPDATES"
+#define SPEC_LAZY_STR "LAZY"
+#define SPEC_SPELLINDEX_STR "SPELLINDEX"
+#define SPEC_INDEXTYPE_STR "INDEXTYPE"
+#define SPEC_NUMERIC_BKD_STR "BKD"
 
 #define SPEC_GEOMETRY_FLAT_STR "FLAT"
 #define SPEC_GEOMETRY_SPHERE_STR "SPHERICAL"
@@ -126,6 +148,7 @@ typedef struct {
   size_t termsSize;
   size_t indexingFailures;
   long double totalIndexTime; // usec
+  long double geometryBulkLoadTime; // usec
   size_t totalDocsLen;
 } IndexStats;
 
@@ -157,6 +180,26 @@ typedef enum {
 
   Index_HasGeometry = 0x40000,
 
+  // Inverted index only: full blocks are converted to the stream-vbyte format. Only applies to
+  // indexes storing docids and, optionally, frequencies (see STREAM_VBYTE_ENCODING)
+  Index_StreamVByte = 0x80000,
+
+  // Inverted index only: term offset vectors are bit-packed in frames. Only applies to indexes
+  // storing term offsets (see PACKED_OFFSETS_ENCODING)
+  Index_PackedOffsets = 0x100000,
+
+  // Replies to repeated queries are cached until the index is written to (see ResultCache)
+  Index_ResultCache = 0x200000,
+
+  // Written keys are queued and indexed in batches in the background (see AsyncUpdates)
+  Index_AsyncUpdates = 0x400000,
+
+  // Loaded on its first access and evicted once idle (see LazyIndex)
+  Index_Lazy = 0x800000,
+
+  // FT.SPELLCHECK finds the terms by their deletion variants (see SpellIndex)
+  Index_SpellIndex = 0x1000000,
+
 } IndexFlags;
 
 // redis version (its here because most file include it with no problem,
@@ -189,7 +232,9 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 23
+#define INDEX_CURRENT_VERSION 25
+#define INDEX_COMPRESSED_CONTENT_VERSION 25
+#define INDEX_CONTENT_VERSION 24
 #define INDEX_GEOMETRY_VERSION 23
 #define INDEX_VECSIM_TIERED_VERSION 22
 #define INDEX_VECSIM_MULTI_VERSION 21
@@ -244,6 +289,11 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 
 #define FIELD_BIT(fs) (((t_fieldMask)1) << (fs)->ftId)
 
+// The terms of a SEPARATEPOSTINGS field are indexed a second time under `@<ftId>:<term>`, in an
+// inverted index of their own
+#define FIELD_TERM_PREFIX '@'
+#define FIELD_TERM_BUFLEN(len) ((len) + 8)
+
 typedef struct {
   RedisModuleString *types[INDEXFLD_NUM_TYPES];
 } IndexSpecFmtStrings;
@@ -262,10 +312,29 @@ typedef struct IndexSpec {
   IndexFlags flags;               // Flags
 
   Trie *terms;                    // Trie of all terms. Used for GC and fuzzy queries
-  Trie *suffix;                   // Trie of suffix tokens of terms. Used for contains queries
+  Trie *phonetics;                // Trie of the phonetic codes of the PHONETIC fields. Used for GC
+  Trie *fieldTerms;               // Trie of the terms of the SEPARATEPOSTINGS fields. Used for GC
+  struct SuffixArray *suffix;     // Suffixes of the terms. Used for contains queries
+  uint64_t termsRevision;         // Bumped whenever the terms a pattern may expand to change
+  ExpansionCache *termExpansions; // Recent expansions of prefix, suffix, wildcard and fuzzy terms
+  ClusterStats *clusterStats;     // Statistics over the cluster pushed by the coordinator, for scoring
   t_fieldMask suffixMask;         // Mask of all field that support contains query
+  NgramIndex *ngrams;             // Trigrams of the terms of the WITHNGRAMS fields
+  t_fieldMask ngramMask;          // Mask of the WITHNGRAMS fields
+  t_fieldMask separatePostingsMask; // Mask of the SEPARATEPOSTINGS fields
+  ExistenceIndex **existence;     // The documents having each INDEXMISSING field. An array
+  SortIndex **sortIndexes;        // The documents in the order of each SORTINDEX field. An array
   dict *keysDict;                 // Global dictionary. Contains inverted indexes of all TEXT TAG NUMERIC VECTOR and GEOSHAPE terms
 
+  uint64_t revision;              // Bumped whenever the spec is locked for write
+  uint64_t docIdsEpoch;           // Bumped whenever the doc ids are renumbered by the compaction
+  ResultCache *resultCache;       // Recent query replies, with Index_ResultCache
+  AsyncUpdates *asyncUpdates;     // Keys written but not indexed yet, with Index_AsyncUpdates
+  LazyIndex *lazy;                // Whether the contents are loaded, with Index_Lazy
+  JSONPlan *jsonPlan;             // The paths of the fields compiled into a trie, for JSON indexes
+  BuildProfile *buildProfile;     // Where the last build of the index spent its time
+  LatencyStats latency;           // Latencies of the commands run on the index
+
   RSSortingTable *sortables;      // Contains sortable data of documents
 
   DocTable docs;                  // Contains metadata of all documents
@@ -282,6 +351,10 @@ typedef struct IndexSpec {
   // can be true even if scanner == NULL, in case of a scan being cancelled
   // in favor on a newer, pending scan
   bool scan_in_progress;
+  // The vector index jobs queued by the scan that the workers did not run yet
+  size_t scanVectorJobs;
+  // Set while the contents restored from the RDB are decoded and checked against its keys
+  struct IndexRestore *restore;
   bool cascadeDelete;             // (deprecated) remove keys when removing spec. used by temporary index
 
   struct DocumentIndexer *indexer;// Indexer of fields into inverted indexes
@@ -289,7 +362,7 @@ typedef struct IndexSpec {
   // cached strings, corresponding to number of fields
   IndexSpecFmtStrings *indexStrs;
   struct IndexSpecCache *spcache;
-  // For index expiration
+  // For index expiration, or eviction with Index_Lazy
   long long timeout;
   RedisModuleTimerID timerId;
   bool isTimerSet;
@@ -306,6 +379,9 @@ typedef struct IndexSpec {
 
   // read write lock
   pthread_rwlock_t rwlock;
+  // the threads waiting to lock the spec for writing. Queries yield the read lock to them between
+  // two results, see RPIndexIterator
+  uint32_t writersWaiting;
 
   // Cursors counters
   size_t cursorsCap;
@@ -350,8 +426,12 @@ typedef struct IndexSpecCache {
   FieldSpec *fields;
   size_t nfields;
   size_t refcount;
+  // The fields by their names, for the schemas of at least SPEC_CACHE_INDEX_MIN_FIELDS fields
+  NameIndex index;
 } IndexSpecCache;
 
+#define SPEC_CACHE_INDEX_MIN_FIELDS 16
+
 /**
  * For testing only
  */
@@ -387,6 +467,12 @@ const char *IndexSpec_GetFieldNameByBit(const IndexSpec *sp, t_fieldMask id);
  * text field */
 t_fieldMask IndexSpec_GetFieldBit(IndexSpec *spec, const char *name, size_t len);
 
+/* The documents having an INDEXMISSING field, or NULL if the field is not INDEXMISSING */
+ExistenceIndex *IndexSpec_GetExistence(const IndexSpec *sp, const FieldSpec *fs);
+
+/* The documents in the order of a SORTINDEX field, or NULL if the field is not SORTINDEX */
+SortIndex *IndexSpec_GetSortIndex(const IndexSpec *sp, const FieldSpec *fs);
+
 /**
  * Check if phonetic matching is enabled on any field within the fieldmask.
  * Returns true if any field has phonetics, and false if none of the fields
@@ -440,9 +526,21 @@ FieldSpec *IndexSpec_CreateField(IndexSpec *sp, const char *name, const char *pa
 // This function locks the spec for writing. use it if you know the spec is not locked
 int IndexSpec_DeleteDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
 
+/* The plan extracting the values of the fields of a JSON document, compiled again whenever fields
+ * were added. Called with the GIL held, as documents are loaded */
+JSONPlan *IndexSpec_GetJSONPlan(IndexSpec *sp);
+
+/* Index the documents of the keys, which all match the rule of the spec, preprocessing them
+ * concurrently */
+void IndexSpec_UpdateDocs(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString **keys,
+                          size_t n);
+
 // This function does not lock the spec. use it if you know the spec is locked for writing
 void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, t_docId id);
 
+/* Clear a deleted document from the existence indexes of the INDEXMISSING fields */
+void IndexSpec_RemoveExistence(IndexSpec *sp, t_docId id);
+
 /**
  * Indicate that the index spec should use an internal dictionary,rather than
  * the Redis keyspace
@@ -453,6 +551,14 @@ void IndexSpec_MakeKeyless(IndexSpec *sp);
 
 void IndexesScanner_Cancel(struct IndexesScanner *scanner);
 void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, StrongRef ref);
+/* Index the keys of the spec at once, holding the GIL until they are all scanned */
+void IndexSpec_ScanAndReindexSync(RedisModuleCtx *ctx, StrongRef ref);
+/* Reindex in the background only the documents with any of the terms, such as the synonyms just
+ * added to a group. Scans the whole index instead while a scan of it is in progress */
+void IndexSpec_ReindexTermsDocs(RedisModuleCtx *ctx, StrongRef ref, const char **terms, size_t n);
+/* Free the documents and the indexes of the spec, keeping its definition. Called with the GIL held
+ * and the spec unlocked */
+void IndexSpec_ClearContents(IndexSpec *sp);
 #ifdef FTINFO_FOR_INFO_MODULES
 /**
  * Exposing all the fields of the index to INFO command.
@@ -465,6 +571,12 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp);
  */
 size_t IndexSpec_VectorIndexSize(IndexSpec *sp);
 
+/**
+ * Get the memory of the sortable values of the documents, along with the strings they share (in
+ * bytes).
+ */
+size_t IndexSpec_SortablesSize(const IndexSpec *sp);
+
 /**
  * Gets the next text id from the index. This does not currently
  * modify the index
@@ -503,6 +615,12 @@ int VecSimIndex_validate_params(RedisModuleCtx *ctx, VecSimParams *params, Query
 
 #define INDEXSPEC_LOAD_NOTIMERUPDATE 0x20
 
+/** Don't count the load as a use of the index */
+#define INDEXSPEC_LOAD_NOCOUNTER 0x40
+
+/** Don't load the contents of an evicted LAZY index, as the caller does not read them */
+#define INDEXSPEC_LOAD_NOLAZYLOAD 0x80
+
 typedef struct {
   uint32_t flags;
   union {
@@ -554,8 +672,28 @@ void IndexSpec_Free(IndexSpec *spec);
 
 //---------------------------------------------------------------------------------------------
 
+/* Add a term to the trie of terms of the spec. Returns 1 if the term is new */
 int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len);
 
+/* The trie a term is kept in: the phonetic codes and the terms of the SEPARATEPOSTINGS fields are
+ * kept apart from the terms, so that they are not expanded by prefix, fuzzy, contains and spell
+ * check queries, which have no use for them */
+Trie *IndexSpec_GetTermsTrie(IndexSpec *sp, const char *term);
+
+/* Format the term a SEPARATEPOSTINGS field indexes `term` under into `buf`, which holds at least
+ * FIELD_TERM_BUFLEN(len) bytes. Returns the length of the field term */
+size_t IndexSpec_FormatFieldTerm(char *buf, const FieldSpec *fs, const char *term, size_t len);
+
+/* Drop the cached term expansions, as the terms a pattern may expand to changed. Called with the
+ * spec write lock held */
+static inline void IndexSpec_TermsChanged(IndexSpec *sp) {
+  sp->termsRevision++;
+}
+
+/* The revision of the spec, as seen by the result cache. Bumped by any write to the spec and by
+ * any configuration change, the sum of two increasing counters being an increasing counter */
+uint64_t IndexSpec_ResultsRevision(const IndexSpec *sp);
+
 /** Returns a string suitable for indexes. This saves on string creation/destruction */
 RedisModuleString *IndexSpec_GetFormattedKey(IndexSpec *sp, const FieldSpec *fs, FieldType forType);
 RedisModuleString *IndexSpec_GetFormattedKeyByName(IndexSpec *sp, const char *s, FieldType forType);
@@ -563,12 +701,19 @@ RedisModuleString *IndexSpec_GetFormattedKeyByName(IndexSpec *sp, const char *s,
 IndexSpec *NewIndexSpec(const char *name);
 int IndexSpec_AddField(IndexSpec *sp, FieldSpec *fs);
 int IndexSpec_RdbLoad(RedisModuleIO *rdb, int encver, int when);
-void IndexSpec_RdbSave(RedisModuleIO *rdb, int when);
+/* Save the definition of an index, and its contents if they are persisted (see
+ * index_persistence.h), as a part of the aux data of the module */
+void IndexSpec_RdbSave(RedisModuleIO *rdb, IndexSpec *sp);
+/* Create and register an index saved by IndexSpec_RdbSave */
+int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
+                            QueryError *status);
 void IndexSpec_Digest(RedisModuleDigest *digest, void *value);
 int CompareVestions(Version v1, Version v2);
 int IndexSpec_RegisterType(RedisModuleCtx *ctx);
 // int IndexSpec_UpdateWithHash(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
 void IndexSpec_ClearAliases(StrongRef ref);
+/* Move all the aliases of an index to another one */
+void IndexSpec_MoveAliases(StrongRef from, StrongRef to);
 
 void IndexSpec_InitializeSynonym(IndexSpec *sp);
 void Indexes_SetTempSpecsTimers(TimerOp op);
@@ -581,6 +726,11 @@ typedef struct IndexesScanner {
   WeakRef spec_ref;
   char *spec_name;
   size_t scannedKeys, totalKeys;
+  // Keys scanned but not yet indexed, to preprocess their documents concurrently
+  arrayof(RedisModuleString *) pendingKeys;
+  // The keys to reindex instead of scanning the keyspace, see IndexSpec_ReindexTermsDocs
+  arrayof(RedisModuleString *) keys;
+  size_t nextKey;
 } IndexesScanner;
 
 double IndexesScanner_IndexedPercent(IndexesScanner *scanner, IndexSpec *sp);
@@ -135,8 +135,37 @@ static bool SpellCheck_IsTermExistsInTrie(Trie *t, const char *term, size_t len,
   return retVal;
 }
 
+typedef struct {
+  SpellCheckCtx *scCtx;
+  t_fieldMask fieldMask;
+  RS_Suggestions *s;
+  int incr;
+} spellIndexCtx;
+
+static void SpellCheck_AddIndexed(const rune *rstr, size_t slen, int dist, void *p) {
+  spellIndexCtx *ctx = p;
+  size_t suggestionLen;
+  char *res = runesToStr(rstr, slen, &suggestionLen);
+  double score;
+  if ((score = SpellCheck_GetScore(ctx->scCtx, res, suggestionLen, ctx->fieldMask)) != -1) {
+    RS_SuggestionsAdd(ctx->s, res, suggestionLen, score, ctx->incr);
+  }
+  rm_free(res);
+}
+
 static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char *term, size_t len,
                                        t_fieldMask fieldMask, RS_Suggestions *s, int incr) {
+  if (t->spell && scCtx->distance <= SPELL_INDEX_MAX_DISTANCE) {
+    size_t rlen;
+    rune *runes = strToFoldedRunes(term, &rlen);
+    if (runes && rlen <= TRIE_MAX_PREFIX) {
+      spellIndexCtx ctx = {.scCtx = scCtx, .fieldMask = fieldMask, .s = s, .incr = incr};
+      SpellIndex_Find(t->spell, runes, rlen, (int)scCtx->distance, SpellCheck_AddIndexed, &ctx);
+    }
+    rm_free(runes);
+    return;
+  }
+
   rune *rstr = NULL;
   t_len slen = 0;
   float score = 0;
@@ -367,6 +396,14 @@ void SpellCheck_Reply(SpellCheckCtx *scCtx, QueryAST *q) {
     return;
   }
 
+  IndexSpec *sp = scCtx->sctx->spec;
+  if ((sp->flags & Index_SpellIndex) && !sp->terms->spell) {
+    // built on first use, and kept up to date by the indexing from then on
+    RedisSearchCtx_LockSpecWrite(scCtx->sctx);
+    Trie_EnableSpellIndex(sp->terms);
+    RedisSearchCtx_UnlockSpec(scCtx->sctx);
+  }
+
   RedisModule_Reply _reply = RedisModule_NewReply(scCtx->sctx->redisCtx), *reply = &_reply;
   if (reply->resp3) {
     SpellCheck_Reply_resp3(scCtx, q, reply);
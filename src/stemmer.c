@@ -8,26 +8,163 @@
 #include <string.h>
 #include <stdio.h>
 #include <sys/param.h>
+#include <pthread.h>
 #include "snowball/include/libstemmer.h"
 #include "rmalloc.h"
+#include "config.h"
+#include "util/fnv.h"
+
+// Longer words are rare enough not to be cached
+#define STEM_CACHE_MAX_WORD_LEN 32
+// The lookups a thread counts before adding them to the global statistics
+#define STEM_CACHE_STATS_BATCH 256
+
+typedef struct {
+  uint32_t hash;
+  uint16_t len;
+  uint16_t stemLen;
+  char *data;  // The word followed by its stem, or NULL for an empty entry
+  size_t cap;
+} StemCacheEntry;
+
+/* A direct mapped cache of the stems of the words of a language, per thread */
+typedef struct {
+  StemCacheEntry *entries;
+  size_t size;  // A power of 2
+} StemCache;
+
+typedef struct {
+  StemCache langs[RS_LANG_UNSUPPORTED];
+  size_t hits;
+  size_t misses;
+} StemCacheThread;
+
+static pthread_key_t stemCacheKey_g;
+static size_t stemCacheHits_g = 0;
+static size_t stemCacheMisses_g = 0;
+
+static void StemCache_Clear(StemCache *cache) {
+  for (size_t ii = 0; ii < cache->size; ++ii) {
+    rm_free(cache->entries[ii].data);
+  }
+  rm_free(cache->entries);
+  cache->entries = NULL;
+  cache->size = 0;
+}
+
+static void stemCacheFlushStats(StemCacheThread *tc) {
+  __atomic_fetch_add(&stemCacheHits_g, tc->hits, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stemCacheMisses_g, tc->misses, __ATOMIC_RELAXED);
+  tc->hits = tc->misses = 0;
+}
+
+static void stemCacheThreadDtor(void *p) {
+  StemCacheThread *tc = p;
+  stemCacheFlushStats(tc);
+  for (size_t ii = 0; ii < RS_LANG_UNSUPPORTED; ++ii) {
+    StemCache_Clear(tc->langs + ii);
+  }
+  rm_free(tc);
+}
+
+static void __attribute__((constructor)) initStemCacheKey() {
+  pthread_key_create(&stemCacheKey_g, stemCacheThreadDtor);
+}
+
+/* The cache of the language for this thread, resized to the configured size, or NULL if disabled */
+static StemCache *getStemCache(RSLanguage language, StemCacheThread **tcp) {
+  size_t size = RSGlobalConfig.stemCacheSize;
+  if (!size || language < 0 || language >= RS_LANG_UNSUPPORTED) {
+    return NULL;
+  }
+  StemCacheThread *tc = pthread_getspecific(stemCacheKey_g);
+  if (!tc) {
+    tc = rm_calloc(1, sizeof(*tc));
+    pthread_setspecific(stemCacheKey_g, tc);
+  }
+  *tcp = tc;
+
+  size_t pow2 = 1;
+  while (pow2 < size) {
+    pow2 <<= 1;
+  }
+  StemCache *cache = tc->langs + language;
+  if (cache->size != pow2) {
+    StemCache_Clear(cache);
+    cache->entries = rm_calloc(pow2, sizeof(*cache->entries));
+    cache->size = pow2;
+  }
+  return cache;
+}
+
+const char *StemmerCache_Stem(struct sb_stemmer *sb, RSLanguage language, const char *word,
+                              size_t len, size_t *outlen) {
+  StemCacheThread *tc = NULL;
+  StemCache *cache = len <= STEM_CACHE_MAX_WORD_LEN ? getStemCache(language, &tc) : NULL;
+  if (!cache) {
+    const sb_symbol *stemmed = sb_stemmer_stem(sb, (const sb_symbol *)word, (int)len);
+    if (stemmed) {
+      *outlen = sb_stemmer_length(sb);
+    }
+    return (const char *)stemmed;
+  }
+
+  uint32_t hash = rs_fnv_32a_buf(word, len, 0);
+  StemCacheEntry *e = cache->entries + (hash & (cache->size - 1));
+  if (e->data && e->hash == hash && e->len == len && !memcmp(e->data, word, len)) {
+    if (++tc->hits + tc->misses >= STEM_CACHE_STATS_BATCH) {
+      stemCacheFlushStats(tc);
+    }
+    *outlen = e->stemLen;
+    return e->data + len;
+  }
+  if (tc->hits + ++tc->misses >= STEM_CACHE_STATS_BATCH) {
+    stemCacheFlushStats(tc);
+  }
+
+  const sb_symbol *stemmed = sb_stemmer_stem(sb, (const sb_symbol *)word, (int)len);
+  if (!stemmed) {
+    return NULL;
+  }
+  *outlen = sb_stemmer_length(sb);
+  if (*outlen > UINT16_MAX) {
+    return (const char *)stemmed;
+  }
+  if (len + *outlen + 1 > e->cap) {
+    e->cap = len + *outlen + 1;
+    e->data = rm_realloc(e->data, e->cap);
+  }
+  e->hash = hash;
+  e->len = len;
+  e->stemLen = *outlen;
+  memcpy(e->data, word, len);
+  memcpy(e->data + len, stemmed, *outlen);
+  e->data[len + *outlen] = '\0';
+  return e->data + len;
+}
+
+void StemmerCache_AddToInfo(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "stemmer_cache");
+  RedisModule_InfoAddFieldULongLong(ctx, "hits", __atomic_load_n(&stemCacheHits_g, __ATOMIC_RELAXED));
+  RedisModule_InfoAddFieldULongLong(ctx, "misses",
+                                    __atomic_load_n(&stemCacheMisses_g, __ATOMIC_RELAXED));
+}
 
 struct sbStemmerCtx {
   struct sb_stemmer *sb;
+  RSLanguage language;
   char *buf;
   size_t cap;
 };
 
 const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *outlen) {
-  const sb_symbol *b = (const sb_symbol *)word;
   struct sbStemmerCtx *stctx = ctx;
-  struct sb_stemmer *sb = stctx->sb;
 
-  const sb_symbol *stemmed = sb_stemmer_stem(sb, b, (int)len);
+  const char *stemmed = StemmerCache_Stem(stctx->sb, stctx->language, word, len, outlen);
   if (stemmed) {
-    *outlen = sb_stemmer_length(sb);
 
     // if the stem and its origin are the same - don't do anything
-    if (*outlen == len && strncasecmp(word, (const char *)stemmed, len) == 0) {
+    if (*outlen == len && strncasecmp(word, stemmed, len) == 0) {
       return NULL;
     }
     // reserver one character for the '+' prefix
@@ -39,7 +176,8 @@ const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *ou
       stctx->buf = rm_realloc(stctx->buf, stctx->cap);
     }
     // the first location is saved for the + prefix
-    memcpy(stctx->buf + 1, stemmed, *outlen + 1);
+    memcpy(stctx->buf + 1, stemmed, *outlen - 1);
+    stctx->buf[*outlen] = '\0';
     return (const char *)stctx->buf;
   }
   return NULL;
@@ -70,6 +208,7 @@ Stemmer *__newSnowballStemmer(RSLanguage language) {
 
   struct sbStemmerCtx *ctx = rm_malloc(sizeof(*ctx));
   ctx->sb = sb;
+  ctx->language = language;
   ctx->cap = 24;
   ctx->buf = rm_malloc(ctx->cap);
   ctx->buf[0] = STEM_PREFIX;
@@ -7,6 +7,7 @@
 #ifndef __RS_STEMMER_H__
 #define __RS_STEMMER_H__
 #include "language.h"
+#include "redismodule.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +40,17 @@ int ResetStemmer(Stemmer *stemmer, StemmerType type, RSLanguage language);
 /* Get a stemmer expander instance for registering it */
 void RegisterStemmerExpander();
 
+struct sb_stemmer;
+
+/* Stem a word with a snowball stemmer of the language, as sb_stemmer_stem() does. The stems of the
+ * words stemmed by each thread are cached per language (see STEM_CACHE_SIZE). The returned stem,
+ * of length `outlen`, is valid until the thread stems another word */
+const char *StemmerCache_Stem(struct sb_stemmer *sb, RSLanguage language, const char *word,
+                              size_t len, size_t *outlen);
+
+/* Add the hits and misses of the stemmer caches to INFO MODULES */
+void StemmerCache_AddToInfo(RedisModuleInfoCtx *ctx);
+
 /* Snoball Stemmer wrapper implementation */
 const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *outlen);
 void __sbstemmer_Free(Stemmer *s);
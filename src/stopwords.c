@@ -11,15 +11,125 @@
 #include "util/strconv.h"
 #include "rmutil/rm_assert.h"
 #include <ctype.h>
+#include <stdbool.h>
 #include "rdb.h"
+#include "util/arr.h"
 
 #define MAX_STOPWORDLIST_SIZE 1024
 
+// Seeds tried for each size of the hash table, before trying a larger one
+#define STOPWORDS_HASH_SEEDS 64
+// Maximal number of slots per stopword, after which collisions are probed
+#define STOPWORDS_HASH_MAX_LOAD 16
+
+typedef struct {
+  uint32_t hash;
+  uint32_t len;
+  const char *word;  // Within the words of the list, or NULL for an empty slot
+} StopWordSlot;
+
 typedef struct StopWordList {
   TrieMap *m;
   size_t refcount;
+
+  // The stopwords are looked up in a hash table whose seed is chosen for them not to collide if
+  // possible, so most lookups compare a single slot
+  StopWordSlot *slots;
+  uint32_t mask;  // The number of slots, a power of 2, minus 1
+  uint32_t seed;
+  bool perfect;      // No stopwords collide, otherwise they are probed linearly
+  uint64_t lengths;  // Bit i is set if a stopword is of length i, bit 63 for the longer ones
+  char *words;
 } StopWordList;
 
+static inline uint32_t stopwordHash(const char *s, size_t len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t ii = 0; ii < len; ++ii) {
+    h = (h ^ (uint8_t)s[ii]) * 16777619u;
+  }
+  return h;
+}
+
+#define STOPWORD_LENGTH_BIT(len) (1ULL << ((len) < 63 ? (len) : 63))
+
+static bool stopwordsCollide(const uint32_t *hashes, size_t n, uint32_t mask, uint8_t *used) {
+  memset(used, 0, mask + 1);
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (used[hashes[ii] & mask]++) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Build the hash table of the stopwords in the trie */
+static void StopWordList_BuildHash(StopWordList *sl) {
+  arrayof(char) words = array_new(char, 256);
+  arrayof(uint32_t) offsets = array_new(uint32_t, 64);
+  arrayof(uint32_t) lens = array_new(uint32_t, 64);
+  TrieMapIterator *it = TrieMap_Iterate(sl->m, "", 0);
+  char *str;
+  tm_len_t len;
+  void *ptr;
+  while (TrieMapIterator_Next(it, &str, &len, &ptr)) {
+    offsets = array_append(offsets, array_len(words));
+    lens = array_append(lens, len);
+    for (tm_len_t ii = 0; ii < len; ++ii) {
+      words = array_append(words, str[ii]);
+    }
+  }
+  TrieMapIterator_Free(it);
+
+  size_t n = array_len(lens);
+  sl->slots = NULL;
+  sl->words = NULL;
+  sl->lengths = 0;
+  if (n) {
+    sl->words = rm_malloc(array_len(words));
+    memcpy(sl->words, words, array_len(words));
+
+    uint32_t numSlots = 4;
+    while (numSlots < 2 * n) {
+      numSlots *= 2;
+    }
+    uint32_t *hashes = rm_malloc(n * sizeof(*hashes));
+    uint8_t *used = rm_malloc(numSlots * STOPWORDS_HASH_MAX_LOAD / 2);
+    sl->perfect = false;
+    sl->seed = 0;
+    sl->mask = numSlots - 1;
+    for (uint32_t size = numSlots; size <= n * STOPWORDS_HASH_MAX_LOAD && !sl->perfect; size *= 2) {
+      for (uint32_t seed = 0; seed < STOPWORDS_HASH_SEEDS; ++seed) {
+        for (size_t ii = 0; ii < n; ++ii) {
+          hashes[ii] = stopwordHash(sl->words + offsets[ii], lens[ii], seed);
+        }
+        if (!stopwordsCollide(hashes, n, size - 1, used)) {
+          sl->perfect = true;
+          sl->seed = seed;
+          sl->mask = size - 1;
+          break;
+        }
+      }
+    }
+
+    sl->slots = rm_calloc(sl->mask + 1, sizeof(*sl->slots));
+    for (size_t ii = 0; ii < n; ++ii) {
+      uint32_t h = stopwordHash(sl->words + offsets[ii], lens[ii], sl->seed);
+      uint32_t pos = h & sl->mask;
+      while (sl->slots[pos].word) {
+        pos = (pos + 1) & sl->mask;
+      }
+      sl->slots[pos] = (StopWordSlot){.hash = h, .len = lens[ii], .word = sl->words + offsets[ii]};
+      sl->lengths |= STOPWORD_LENGTH_BIT(lens[ii]);
+    }
+    rm_free(used);
+    rm_free(hashes);
+  }
+
+  array_free(words);
+  array_free(offsets);
+  array_free(lens);
+}
+
 static StopWordList *__default_stopwords = NULL;
 static StopWordList *__empty_stopwords = NULL;
 
@@ -49,7 +159,7 @@ int StopWordList_Contains(const StopWordList *sl, const char *term, size_t len)
   }
 
   strtolower(lowStr);
-  int ret = TrieMap_Find(sl->m, (char *)lowStr, len) != TRIEMAP_NOTFOUND;
+  int ret = StopWordList_ContainsLowered(sl, lowStr, len);
 
   // free memory if allocated
   if (len >= 32) rm_free(lowStr);
@@ -57,6 +167,25 @@ int StopWordList_Contains(const StopWordList *sl, const char *term, size_t len)
   return ret;
 }
 
+int StopWordList_ContainsLowered(const StopWordList *sl, const char *term, size_t len) {
+  if (!sl || !sl->slots || !term || !(sl->lengths & STOPWORD_LENGTH_BIT(len))) {
+    return 0;
+  }
+  uint32_t h = stopwordHash(term, len, sl->seed);
+  for (uint32_t pos = h & sl->mask;; pos = (pos + 1) & sl->mask) {
+    const StopWordSlot *slot = sl->slots + pos;
+    if (!slot->word) {
+      return 0;
+    }
+    if (slot->hash == h && slot->len == len && !memcmp(slot->word, term, len)) {
+      return 1;
+    }
+    if (sl->perfect) {
+      return 0;
+    }
+  }
+}
+
 StopWordList *NewStopWordListCStr(const char **strs, size_t len) {
   if (len == 0 && __empty_stopwords) {
     return __empty_stopwords;
@@ -86,6 +215,7 @@ StopWordList *NewStopWordListCStr(const char **strs, size_t len) {
     TrieMap_Add(sl->m, t, tlen, NULL, NULL);
     rm_free(t);
   }
+  StopWordList_BuildHash(sl);
   if (len == 0) {
     __empty_stopwords = sl;
   }
@@ -99,6 +229,8 @@ void StopWordList_Ref(StopWordList *sl) {
 static void StopWordList_FreeInternal(StopWordList *sl) {
   if (sl) {
     TrieMap_Free(sl->m, NULL);
+    rm_free(sl->slots);
+    rm_free(sl->words);
     rm_free(sl);
   }
 }
@@ -131,7 +263,7 @@ void StopWordList_FreeGlobals(void) {
 StopWordList *StopWordList_RdbLoad(RedisModuleIO *rdb, int encver) {
   StopWordList *sl = NULL;
   uint64_t elements = LoadUnsigned_IOError(rdb, goto cleanup);
-  sl = rm_malloc(sizeof(*sl));
+  sl = rm_calloc(1, sizeof(*sl));
   sl->m = NewTrieMap();
   sl->refcount = 1;
 
@@ -141,6 +273,7 @@ StopWordList *StopWordList_RdbLoad(RedisModuleIO *rdb, int encver) {
     TrieMap_Add(sl->m, str, len, NULL, NULL);
     RedisModule_Free(str);
   }
+  StopWordList_BuildHash(sl);
 
   return sl;
 
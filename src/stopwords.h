@@ -30,6 +30,9 @@ struct StopWordList;
 /* Check if a stopword list contains a term. The term must be already lowercased */
 int StopWordList_Contains(const struct StopWordList *sl, const char *term, size_t len);
 
+/* Like StopWordList_Contains, for a term lowercased as strtolower() does, which is not copied */
+int StopWordList_ContainsLowered(const struct StopWordList *sl, const char *term, size_t len);
+
 struct StopWordList *DefaultStopWordList();
 void StopWordList_FreeGlobals(void);
 
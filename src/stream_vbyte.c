@@ -0,0 +1,178 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "stream_vbyte.h"
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SVB_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SVB_NEON 1
+#endif
+
+typedef const uint8_t *(*svbDecodeGroups)(const uint8_t *ctrl, const uint8_t *data,
+                                          const uint8_t *end, uint32_t *out, size_t ngroups,
+                                          size_t *ndecoded);
+
+// Total data length of the 4 integers described by a control byte
+static uint8_t svbLengthTable[256];
+// Shuffle masks spreading the data bytes of a group into 4 little endian integers.
+// 0xFF entries zero the target byte in both pshufb and vqtbl1q.
+static uint8_t svbShuffleTable[256][16];
+
+static svbDecodeGroups svbDecoder;
+static const char *svbDecoderName;
+static pthread_once_t svbOnce = PTHREAD_ONCE_INIT;
+
+#define SVB_CODE(ctrl, i) (((ctrl)[(i) >> 2] >> (((i)&3) * 2)) & 0x03)
+
+static inline uint8_t svbCodeOf(uint32_t v) {
+  if (v < (1U << 8)) return 0;
+  if (v < (1U << 16)) return 1;
+  if (v < (1U << 24)) return 2;
+  return 3;
+}
+
+static const uint8_t *svbDecodeGroupsScalar(const uint8_t *ctrl, const uint8_t *data,
+                                            const uint8_t *end, uint32_t *out, size_t ngroups,
+                                            size_t *ndecoded) {
+  *ndecoded = 0;
+  return data;
+}
+
+#ifdef SVB_X86
+__attribute__((target("ssse3"))) static const uint8_t *svbDecodeGroupsSSSE3(
+    const uint8_t *ctrl, const uint8_t *data, const uint8_t *end, uint32_t *out, size_t ngroups,
+    size_t *ndecoded) {
+  size_t i = 0;
+  // A group never takes more than 16 bytes, so we can always load a full register if 16 bytes
+  // are left in the buffer.
+  for (; i < ngroups && data + 16 <= end; ++i) {
+    const uint8_t c = ctrl[i];
+    __m128i in = _mm_loadu_si128((const __m128i *)data);
+    __m128i shuf = _mm_loadu_si128((const __m128i *)svbShuffleTable[c]);
+    _mm_storeu_si128((__m128i *)(out + i * 4), _mm_shuffle_epi8(in, shuf));
+    data += svbLengthTable[c];
+  }
+  *ndecoded = i;
+  return data;
+}
+#endif
+
+#ifdef SVB_NEON
+static const uint8_t *svbDecodeGroupsNEON(const uint8_t *ctrl, const uint8_t *data,
+                                          const uint8_t *end, uint32_t *out, size_t ngroups,
+                                          size_t *ndecoded) {
+  size_t i = 0;
+  for (; i < ngroups && data + 16 <= end; ++i) {
+    const uint8_t c = ctrl[i];
+    uint8x16_t in = vld1q_u8(data);
+    uint8x16_t shuf = vld1q_u8(svbShuffleTable[c]);
+    vst1q_u8((uint8_t *)(out + i * 4), vqtbl1q_u8(in, shuf));
+    data += svbLengthTable[c];
+  }
+  *ndecoded = i;
+  return data;
+}
+#endif
+
+static void svbInit(void) {
+  for (int c = 0; c < 256; ++c) {
+    uint8_t pos = 0;
+    for (int i = 0; i < 4; ++i) {
+      uint8_t sz = ((c >> (i * 2)) & 0x03) + 1;
+      for (int b = 0; b < 4; ++b) {
+        svbShuffleTable[c][i * 4 + b] = b < sz ? pos + b : 0xFF;
+      }
+      pos += sz;
+    }
+    svbLengthTable[c] = pos;
+  }
+
+  svbDecoder = svbDecodeGroupsScalar;
+  svbDecoderName = "scalar";
+#if defined(SVB_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3")) {
+    svbDecoder = svbDecodeGroupsSSSE3;
+    svbDecoderName = "ssse3";
+  }
+#elif defined(SVB_NEON)
+  svbDecoder = svbDecodeGroupsNEON;
+  svbDecoderName = "neon";
+#endif
+}
+
+size_t StreamVByte_EncodedLen(const uint32_t *in, size_t n) {
+  size_t len = STREAMVBYTE_CTRL_LEN(n);
+  for (size_t i = 0; i < n; ++i) {
+    len += svbCodeOf(in[i]) + 1;
+  }
+  return len;
+}
+
+size_t StreamVByte_Encode(const uint32_t *in, size_t n, uint8_t *out) {
+  uint8_t *ctrl = out;
+  uint8_t *data = out + STREAMVBYTE_CTRL_LEN(n);
+  memset(ctrl, 0, STREAMVBYTE_CTRL_LEN(n));
+
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t v = in[i];
+    uint8_t code = svbCodeOf(v);
+    ctrl[i >> 2] |= code << ((i & 3) * 2);
+    // Integers are stored in little endian order, same as qint
+    for (int b = 0; b <= code; ++b) {
+      *data++ = v & 0xFF;
+      v >>= 8;
+    }
+  }
+  return data - out;
+}
+
+size_t StreamVByte_Decode(const uint8_t *in, const uint8_t *end, uint32_t *out, size_t n) {
+  pthread_once(&svbOnce, svbInit);
+
+  const uint8_t *ctrl = in;
+  const uint8_t *data = in + STREAMVBYTE_CTRL_LEN(n);
+
+  // Decode as many full groups as we can with the vectorized decoder
+  size_t ngroups = 0;
+  data = svbDecoder(ctrl, data, end, out, n / 4, &ngroups);
+
+  // Scalar decoding of the remaining integers
+  for (size_t i = ngroups * 4; i < n; ++i) {
+    uint8_t code = SVB_CODE(ctrl, i);
+    uint32_t v = 0;
+    for (int b = code; b >= 0; --b) {
+      v = (v << 8) | data[b];
+    }
+    out[i] = v;
+    data += code + 1;
+  }
+  return data - in;
+}
+
+size_t StreamVByte_SkipLen(const uint8_t *in, size_t n) {
+  pthread_once(&svbOnce, svbInit);
+
+  size_t len = STREAMVBYTE_CTRL_LEN(n);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    len += svbLengthTable[in[i >> 2]];
+  }
+  for (; i < n; ++i) {
+    len += SVB_CODE(in, i) + 1;
+  }
+  return len;
+}
+
+const char *StreamVByte_DecoderName(void) {
+  pthread_once(&svbOnce, svbInit);
+  return svbDecoderName;
+}
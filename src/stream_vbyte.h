@@ -0,0 +1,50 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef __STREAM_VBYTE_H__
+#define __STREAM_VBYTE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stream VByte - encoding of an array of unsigned 32 bit integers as two separate streams: a
+ * control stream holding the byte length (1-4) of each integer as 2 bits, followed by a data stream
+ * holding the integers' bytes back to back. Since the length of a group of 4 integers is known from
+ * a single control byte, groups can be decoded with one shuffle instruction (SSSE3 / NEON). We fall
+ * back to scalar decoding when the CPU does not support it. */
+
+/* The number of control bytes needed for n integers */
+#define STREAMVBYTE_CTRL_LEN(n) (((n) + 3) / 4)
+
+/* The maximal encoded length of n integers */
+#define STREAMVBYTE_MAX_LEN(n) (STREAMVBYTE_CTRL_LEN(n) + (n) * sizeof(uint32_t))
+
+/* Return the number of bytes needed to encode the n integers of `in` */
+size_t StreamVByte_EncodedLen(const uint32_t *in, size_t n);
+
+/* Encode n integers into `out`, which must hold at least StreamVByte_EncodedLen(in, n) bytes.
+ * Returns the number of bytes written */
+size_t StreamVByte_Encode(const uint32_t *in, size_t n, uint8_t *out);
+
+/* Decode n integers from `in` into `out`. `end` marks the end of the readable memory, which may be
+ * beyond the end of the encoded data (the SIMD decoder reads 16 bytes at a time, and uses it to
+ * avoid reading past the end of the buffer). Returns the number of bytes consumed */
+size_t StreamVByte_Decode(const uint8_t *in, const uint8_t *end, uint32_t *out, size_t n);
+
+/* Return the number of bytes taken by n encoded integers starting at `in`, without decoding them */
+size_t StreamVByte_SkipLen(const uint8_t *in, size_t n);
+
+/* Return the name of the decoder selected for this CPU ("ssse3", "neon" or "scalar") */
+const char *StreamVByte_DecoderName(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
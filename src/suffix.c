@@ -7,261 +7,447 @@
 #include "suffix.h"
 #include "rmutil/rm_assert.h"
 #include "config.h"
+#include "util/timeout.h"
 #include "wildcard/wildcard.h"
 
 #include <string.h>
 #include <strings.h>
+#include <sys/param.h>
+
+typedef struct {
+  char *str;              // NULL for a free id
+  uint32_t len;
+  uint32_t refs : 31;     // entries of the suffixes of the term
+  uint32_t deleted : 1;   // skipped until its entries are dropped
+} suffixTerm;
+
+typedef struct {
+  uint32_t term;
+  uint32_t offset;  // as long as the terms may be
+} suffixEntry;
+
+struct SuffixArray {
+  suffixTerm *terms;                  // by id
+  uint32_t *freeIds;                  // ids no entry refers to
+  arrayof(suffixEntry *) segments;    // sorted by suffix, from the oldest and largest
+  suffixEntry *pending;               // suffixes of the latest terms, unsorted
+  size_t numEntries;                  // in the segments and pending
+  size_t numDeleted;                  // entries of deleted terms
+};
+
+SuffixArray *NewSuffixArray() {
+  SuffixArray *sa = rm_calloc(1, sizeof(*sa));
+  sa->terms = array_new(suffixTerm, 16);
+  sa->freeIds = array_new(uint32_t, 0);
+  sa->segments = array_new(suffixEntry *, 4);
+  sa->pending = array_new(suffixEntry, SUFFIX_PENDING_MAX);
+  return sa;
+}
 
-typedef struct suffixData {
-  // int wordExists; // exact match to string exists already
-  // rune *rune;
-  char *term;             // string is used in the array of all suffix tokens
-  arrayof(char *) array;   // list of words containing the string. weak pointers
-} suffixData;
+void SuffixArray_Free(SuffixArray *sa) {
+  if (!sa) {
+    return;
+  }
+  array_free_ex(sa->terms, rm_free(((suffixTerm *)ptr)->str));
+  array_free(sa->freeIds);
+  array_free_ex(sa->segments, array_free(*(suffixEntry **)ptr));
+  array_free(sa->pending);
+  rm_free(sa);
+}
 
-#define Suffix_GetData(node) node ? node->payload ? \
-                             (suffixData *)node->payload->data : NULL : NULL
+size_t SuffixArray_NumSuffixes(const SuffixArray *sa) {
+  return sa->numEntries - sa->numDeleted;
+}
 
+size_t SuffixArray_MemUsage(const SuffixArray *sa) {
+  size_t sz = sizeof(*sa) + array_len(sa->terms) * sizeof(*sa->terms) +
+              array_len(sa->freeIds) * sizeof(*sa->freeIds) +
+              array_len(sa->segments) * sizeof(*sa->segments) +
+              sa->numEntries * sizeof(suffixEntry);
+  for (uint32_t i = 0; i < array_len(sa->terms); ++i) {
+    if (sa->terms[i].str) {
+      sz += sa->terms[i].len + 1;
+    }
+  }
+  return sz;
+}
 
-/***********************************************************/
-/*****************        Trie          ********************/
-/***********************************************************/
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline const char *entryStr(const SuffixArray *sa, suffixEntry e, size_t *len) {
+  const suffixTerm *t = sa->terms + e.term;
+  *len = t->len - e.offset;
+  return t->str + e.offset;
+}
+
+static inline bool entryDeleted(const SuffixArray *sa, suffixEntry e) {
+  return sa->terms[e.term].deleted;
+}
 
+static int cmpEntries(const SuffixArray *sa, suffixEntry a, suffixEntry b) {
+  size_t alen, blen;
+  const char *astr = entryStr(sa, a, &alen), *bstr = entryStr(sa, b, &blen);
+  int rc = memcmp(astr, bstr, MIN(alen, blen));
+  return rc ? rc : (alen > blen) - (alen < blen);
+}
 
-static suffixData createSuffixNode(char *term, int keepPtr) {
-  suffixData node = { 0 };
-  if (keepPtr) {
-    node.term = term;
+// Compare the suffix of an entry with a string, or only with its beginning if `prefix`
+static int cmpString(const SuffixArray *sa, suffixEntry e, const char *str, size_t len,
+                     bool prefix) {
+  size_t elen;
+  const char *estr = entryStr(sa, e, &elen);
+  if (prefix && elen > len) {
+    elen = len;
   }
-  node.array = array_ensure_append_1(node.array, term);
-  return node;
+  int rc = memcmp(estr, str, MIN(elen, len));
+  return rc ? rc : (elen > len) - (elen < len);
 }
 
-static void freeSuffixNode(suffixData *node) {
-  array_free(node->array);
-  rm_free(node->term);
-  rm_free(node);
+static void sortEntries(const SuffixArray *sa, suffixEntry *entries, suffixEntry *tmp, size_t n) {
+  if (n < 2) {
+    return;
+  }
+  size_t half = n / 2;
+  sortEntries(sa, entries, tmp, half);
+  sortEntries(sa, entries + half, tmp, n - half);
+  size_t i = 0, j = half, k = 0;
+  while (i < half && j < n) {
+    tmp[k++] = cmpEntries(sa, entries[j], entries[i]) < 0 ? entries[j++] : entries[i++];
+  }
+  while (i < half) {
+    tmp[k++] = entries[i++];
+  }
+  memcpy(entries, tmp, k * sizeof(*entries));
 }
 
-void addSuffixTrie(Trie *trie, const char *str, uint32_t len) {
-  //if () {}  check here gor other types
-  size_t rlen = 0;
-  runeBuf buf;
-  rune *runes = runeBufFill(str, len, &buf, &rlen);
-
-  TrieNode *trienode = TrieNode_Get(trie->root, runes, rlen, 1, NULL);
-  suffixData *data = NULL;
-  if (trienode && trienode->payload) {
-    // suffixData *node = TrieNode_GetValue(trie->root, runes, rlen, 1);
-    data = Suffix_GetData(trienode);
-    // if string was added in the past, skip
-    if (data && data->term) {
-      //rm_free(runes);
-      runeBufFree(&buf);
-      return;
+// The position of the first entry of a segment whose suffix is not below the string
+static uint32_t lowerBound(const SuffixArray *sa, suffixEntry *seg, const char *str,
+                           size_t len) {
+  uint32_t lo = 0, hi = array_len(seg);
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (cmpString(sa, seg[mid], str, len, false) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
   }
+  return lo;
+}
 
-  char *copyStr = rm_strndup(str, len);
-  if (!data) {
-    suffixData newdata = createSuffixNode(copyStr, 1);
-    RSPayload payload = { .data = (char*)&newdata, .len = sizeof(newdata) };
-    TrieNode_Add(&trie->root, runes, rlen, &payload, 1, ADD_REPLACE, trie->freecb);
-  } else {
-    RS_LOG_ASSERT(!data->term, "can't reach here");
-    data->term = copyStr;
-    data->array = array_ensure_append_1(data->array, copyStr);
-  }
-
-  // Save string copy to all suffixes of it
-  // If it exists, move to the next field
-  for (int j = 1; j < len - MIN_SUFFIX + 1; ++j) {
-    TrieNode *trienode = TrieNode_Get(trie->root, runes + j, rlen - j, 1, NULL);
-    
-    data = Suffix_GetData(trienode);
-    if (!trienode || !trienode->payload) {
-      suffixData newdata = createSuffixNode(copyStr, 0);
-      RSPayload payload = { .data = (char*)&newdata, .len = sizeof(newdata) };
-      Trie_InsertRune(trie, runes + j, rlen - j, 1, ADD_REPLACE, &payload);
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// Drop an entry of a deleted term, and free the term along with its last entry
+static void dropEntry(SuffixArray *sa, suffixEntry e) {
+  suffixTerm *t = sa->terms + e.term;
+  sa->numEntries--;
+  sa->numDeleted--;
+  if (--t->refs == 0) {
+    rm_free(t->str);
+    *t = (suffixTerm){0};
+    sa->freeIds = array_append(sa->freeIds, e.term);
+  }
+}
+
+/* Merge two segments into a new one, without the entries of the deleted terms */
+static suffixEntry *mergeSegments(SuffixArray *sa, suffixEntry *a, suffixEntry *b) {
+  uint32_t na = array_len(a), nb = array_len(b), i = 0, j = 0;
+  suffixEntry *merged = array_new(suffixEntry, na + nb);
+  while (i < na || j < nb) {
+    if (i < na && entryDeleted(sa, a[i])) {
+      dropEntry(sa, a[i++]);
+    } else if (j < nb && entryDeleted(sa, b[j])) {
+      dropEntry(sa, b[j++]);
+    } else if (j == nb || (i < na && cmpEntries(sa, a[i], b[j]) <= 0)) {
+      merged = array_append(merged, a[i++]);
     } else {
-      data->array = array_ensure_append_1(data->array, copyStr);
+      merged = array_append(merged, b[j++]);
     }
   }
-  runeBufFree(&buf);
+  return merged;
 }
 
-static void removeSuffix(const char *str, size_t rlen, arrayof(char*) array) {
-  for (int i = 0; i < array_len(array); ++i) {
-    if (!strncmp(array[i], str, rlen)) {
-      array = array_del_fast(array, i);
-      return;
-    }
+// Merge the last two segments
+static void mergeLast(SuffixArray *sa) {
+  uint32_t n = array_len(sa->segments);
+  suffixEntry *merged = mergeSegments(sa, sa->segments[n - 2], sa->segments[n - 1]);
+  array_free(sa->segments[n - 2]);
+  array_free(sa->segments[n - 1]);
+  sa->segments[n - 2] = merged;
+  array_pop(sa->segments);
+}
+
+/* Sort the pending entries into a new segment, and merge the last segments while the one before
+ * the last is not much larger than it */
+static void flushPending(SuffixArray *sa) {
+  uint32_t n = array_len(sa->pending);
+  if (!n) {
+    return;
+  }
+  suffixEntry *seg = array_new(suffixEntry, n);
+  seg = array_ensure_append_n(seg, sa->pending, n);
+  suffixEntry *tmp = rm_malloc(n * sizeof(*tmp));
+  sortEntries(sa, seg, tmp, n);
+  rm_free(tmp);
+  array_clear(sa->pending);
+  sa->segments = array_append(sa->segments, seg);
+
+  uint32_t k;
+  while ((k = array_len(sa->segments)) > 1 &&
+         array_len(sa->segments[k - 2]) <= 2 * array_len(sa->segments[k - 1])) {
+    mergeLast(sa);
   }
 }
 
-void deleteSuffixTrie(Trie *trie, const char *str, uint32_t len) {
-  size_t rlen = 0;
-  //rune *runes = strToRunesN(str, len, &rlen);
-
-  runeBuf buf;
-  rune *runes = runeBufFill(str, len, &buf, &rlen);
-
-  //rune runes[len];
-  //size_t rlen = strToRunesN(str, len, &runes);
-  char *oldTerm = NULL;
-
-  // iterate all matching terms and remove word
-  for (int j = 0; j < len - MIN_SUFFIX + 1; ++j) {
-    TrieNode *node = TrieNode_Get(trie->root, runes + j, rlen - j, 1, NULL);
-    suffixData *data = Suffix_GetData(node);
-    // suffix trie is shared between all text fields in index, even if they don't use it.
-    // if the trie is owned by other fields and not any one containing this suffix,
-    // then failure to find the suffix is not an error. just move along.
-    if (!data) continue;
-    // RS_LOG_ASSERT(data, "all suffixes must exist");
-    // suffixData *data = TrieMap_Find(trie, str + j, len - j);
-    if (j == 0) {
-      // keep pointer to word string to free after it was found in al sub tokens.
-      oldTerm = data->term;
-      data->term = NULL;
+// Merge all the segments into one, without the entries of the deleted terms
+static void compact(SuffixArray *sa) {
+  flushPending(sa);
+  while (array_len(sa->segments) > 1) {
+    mergeLast(sa);
+  }
+  if (array_len(sa->segments) == 1 && sa->numDeleted) {
+    suffixEntry *merged = mergeSegments(sa, sa->segments[0], NULL);
+    array_free(sa->segments[0]);
+    sa->segments[0] = merged;
+  }
+}
+
+/* The id of a term which is not deleted, or UINT32_MAX */
+static uint32_t findTerm(const SuffixArray *sa, const char *str, size_t len) {
+  for (uint32_t i = 0; i < array_len(sa->pending); ++i) {
+    suffixEntry e = sa->pending[i];
+    if (!e.offset && !entryDeleted(sa, e) && !cmpString(sa, e, str, len, false)) {
+      return e.term;
     }
-    // remove from array
-    removeSuffix(str, len, data->array);
-    // if array is empty, remove the node
-    if (array_len(data->array) == 0) {
-      RS_LOG_ASSERT(!data->term, "array should contain a pointer to the string");
-      Trie_DeleteRunes(trie, runes + j, rlen - j);
+  }
+  for (uint32_t i = 0; i < array_len(sa->segments); ++i) {
+    suffixEntry *seg = sa->segments[i];
+    for (uint32_t j = lowerBound(sa, seg, str, len);
+         j < array_len(seg) && !cmpString(sa, seg[j], str, len, false); ++j) {
+      if (!seg[j].offset && !entryDeleted(sa, seg[j])) {
+        return seg[j].term;
+      }
     }
   }
-  rm_free(oldTerm);
-  runeBufFree(&buf);
+  return UINT32_MAX;
 }
 
-static int processSuffixData(suffixData *data, SuffixCtx *sufCtx) {
-  //TrieSuffixCallback callback, void *ctx) {
-  if (!data) {
-    return REDISMODULE_OK;
+void addSuffixTrie(SuffixArray *sa, const char *str, uint32_t len) {
+  if (findTerm(sa, str, len) != UINT32_MAX) {
+    return;
   }
-  arrayof(char *) array = data->array;
-  for (int i = 0; i < array_len(array); ++i) {
-    if (sufCtx->callback(array[i], strlen(array[i]), sufCtx->cbCtx, NULL) != REDISMODULE_OK) {
-      return REDISEARCH_ERR;
+
+  uint32_t id;
+  if (array_len(sa->freeIds)) {
+    id = array_pop(sa->freeIds);
+  } else {
+    id = array_len(sa->terms);
+    sa->terms = array_append(sa->terms, (suffixTerm){0});
+  }
+  suffixTerm *t = sa->terms + id;
+  *t = (suffixTerm){.str = rm_strndup(str, len), .len = len};
+
+  // The suffixes begin at characters, and have at least MIN_SUFFIX bytes but for the term itself
+  for (uint32_t i = 0; i < len; ++i) {
+    if (i && ((str[i] & 0xC0) == 0x80 || len - i < MIN_SUFFIX)) {
+      continue;
     }
+    sa->pending = array_append(sa->pending, ((suffixEntry){.term = id, .offset = i}));
+    t->refs++;
+  }
+  sa->numEntries += t->refs;
+  if (array_len(sa->pending) >= SUFFIX_PENDING_MAX) {
+    flushPending(sa);
   }
-  return REDISMODULE_OK;
 }
 
-static int recursiveAdd(TrieNode *node, SuffixCtx *sufCtx) {
-  if (node->payload) {
-    size_t rlen;
-    suffixData *data = Suffix_GetData(node);
-    if (processSuffixData(data, sufCtx) != REDISMODULE_OK) {
-      return REDISMODULE_ERR;
-    }
+void deleteSuffixTrie(SuffixArray *sa, const char *str, uint32_t len) {
+  // the array is shared between all the fields of the index, even if they don't use it, so
+  // the term may not be there
+  uint32_t id = findTerm(sa, str, len);
+  if (id == UINT32_MAX) {
+    return;
   }
-  if (node->numChildren) {
-    TrieNode **children = __trieNode_children(node);
-    for (int i = 0; i < node->numChildren; ++i) {
-      if (recursiveAdd(children[i], sufCtx) != REDISMODULE_OK) {
-        return REDISMODULE_ERR;
-      }
+  sa->terms[id].deleted = 1;
+  sa->numDeleted += sa->terms[id].refs;
+
+  // The pending entries are dropped right away
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < array_len(sa->pending); ++i) {
+    if (sa->pending[i].term == id) {
+      dropEntry(sa, sa->pending[i]);
+    } else {
+      sa->pending[kept++] = sa->pending[i];
     }
   }
-  return REDISMODULE_OK;
+  array_hdr(sa->pending)->len = kept;
+
+  if (sa->numDeleted > SUFFIX_PENDING_MAX && 2 * sa->numDeleted > sa->numEntries) {
+    compact(sa);
+  }
 }
 
-void Suffix_IterateContains(SuffixCtx *sufCtx) {
-  if (sufCtx->type == SUFFIX_TYPE_CONTAINS) {
-    // get string from node and children
-    TrieNode *node = TrieNode_Get(sufCtx->root, sufCtx->rune, sufCtx->runelen, 0, NULL);
-    if (!node) {
-      return;
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static int cmpIds(const void *p1, const void *p2) {
+  uint32_t a = *(const uint32_t *)p1, b = *(const uint32_t *)p2;
+  return a < b ? -1 : a > b;
+}
+
+/* The ids of the terms with a suffix beginning with the string, or equal to it if not `prefix`,
+ * each once */
+static uint32_t *findTerms(const SuffixArray *sa, const char *str, size_t len, bool prefix,
+                           struct timespec *timeout) {
+  uint32_t *ids = array_new(uint32_t, 8);
+  size_t timeoutCounter = 0;
+  for (uint32_t i = 0; i < array_len(sa->pending); ++i) {
+    suffixEntry e = sa->pending[i];
+    if (!cmpString(sa, e, str, len, prefix)) {
+      ids = array_append(ids, e.term);
     }
-    recursiveAdd(node, sufCtx);
-  } else if (sufCtx->type == SUFFIX_TYPE_SUFFIX) {
-    // exact match. Get strings from a single node
-    TrieNode *node = TrieNode_Get(sufCtx->root, sufCtx->rune, sufCtx->runelen, 1, NULL);
-    suffixData *data = Suffix_GetData(node);
-    if (data) {
-      processSuffixData(data, sufCtx);
+  }
+  for (uint32_t i = 0; i < array_len(sa->segments); ++i) {
+    suffixEntry *seg = sa->segments[i];
+    for (uint32_t j = lowerBound(sa, seg, str, len);
+         j < array_len(seg) && !cmpString(sa, seg[j], str, len, prefix); ++j) {
+      if (!entryDeleted(sa, seg[j])) {
+        ids = array_append(ids, seg[j].term);
+      }
+      if (timeout && TimedOut_WithCounter(timeout, &timeoutCounter)) {
+        break;
+      }
+    }
+  }
+
+  // A term has as many of the suffixes as the string occurs in it
+  uint32_t n = array_len(ids), unique = 0;
+  qsort(ids, n, sizeof(*ids), cmpIds);
+  for (uint32_t i = 0; i < n; ++i) {
+    if (!i || ids[i] != ids[i - 1]) {
+      ids[unique++] = ids[i];
     }
   }
+  array_hdr(ids)->len = unique;
+  return ids;
 }
 
+/* The ids of the terms matching a wildcard pattern, found by the longest literal part of the token
+ * chosen by Suffix_ChooseToken. Returns NULL if the pattern has no literal part of MIN_SUFFIX
+ * characters */
+static uint32_t *findWildcardTerms(const SuffixArray *sa, const char *pattern, size_t len,
+                                   struct timespec *timeout, long long maxPrefixExpansions) {
+  size_t idx[len + 1];
+  size_t lens[len + 1];
+  int useIdx = Suffix_ChooseToken(pattern, len, idx, lens);
+  if (useIdx == REDISEARCH_UNINITIALIZED) {
+    return NULL;
+  }
 
-/***********************************************************************************
-*                                    Wildcard                                      *
-************************************************************************************/
-int Suffix_ChooseToken(const char *str, size_t len, size_t *tokenIdx, size_t *tokenLen) {
-  int runner = 0;
-  int i = 0;
-  int init = 0;
-  while (i < len) {
-    // save location of token
-    if (str[i] != '*') {
-      tokenIdx[runner] = i;
-      init = 1;
+  const char *token = pattern + idx[useIdx];
+  size_t toklen = lens[useIdx], litIdx = 0, litLen = 0;
+  for (size_t i = 0; i < toklen; ++i) {
+    size_t j = i;
+    while (j < toklen && token[j] != '?') {
+      ++j;
     }
-    // skip all characters other than `*`
-    while (i < len && str[i] != '*') {
-      ++i;
+    if (j - i > litLen) {
+      litIdx = i;
+      litLen = j - i;
     }
-    // save length of token
-    if (init) {
-      tokenLen[runner] = i - tokenIdx[runner];
-      ++runner;
-    }
-    // skip `*` characters
-    while (str[i] == '*') {
-      ++i;
+    i = j;
+  }
+  if (litLen < MIN_SUFFIX) {
+    return NULL;
+  }
+
+  uint32_t *ids = findTerms(sa, token + litIdx, litLen, true, timeout);
+  uint32_t matched = 0;
+  for (uint32_t i = 0; i < array_len(ids) && matched < maxPrefixExpansions; ++i) {
+    const suffixTerm *t = sa->terms + ids[i];
+    if (Wildcard_MatchChar(pattern, len, t->str, t->len) == FULL_MATCH) {
+      ids[matched++] = ids[i];
     }
   }
+  array_hdr(ids)->len = matched;
+  return ids;
+}
 
-  // choose best option
-  int score = INT32_MIN;
-  int retidx = REDISEARCH_UNINITIALIZED;
-  for (int i = 0; i < runner; ++i) {
-    if (tokenLen[i] < MIN_SUFFIX) {
-      continue;
+static void processTerms(const SuffixArray *sa, uint32_t *ids, SuffixCtx *sufCtx) {
+  for (uint32_t i = 0; i < array_len(ids); ++i) {
+    const suffixTerm *t = sa->terms + ids[i];
+    if (sufCtx->callback(t->str, t->len, sufCtx->cbCtx, NULL) != REDISMODULE_OK) {
+      return;
     }
+  }
+}
 
-    // 1. long string are likely to have less results
-    // 2. tokens at end of pattern are likely to be more relevant
-    int curScore = tokenLen[i] + i;
+void Suffix_IterateContains(SuffixCtx *sufCtx) {
+  size_t len;
+  char *str = runesToStr(sufCtx->rune, sufCtx->runelen, &len);
+  uint32_t *ids = findTerms(sufCtx->sa, str, len, sufCtx->type == SUFFIX_TYPE_CONTAINS,
+                            sufCtx->timeout);
+  rm_free(str);
+  processTerms(sufCtx->sa, ids, sufCtx);
+  array_free(ids);
+}
 
-    // iterating all children is demanding
-    if (str[tokenIdx[i] + tokenLen[i]] == '*') {
-      curScore -= 5;
-    }
+int Suffix_IterateWildcard(SuffixCtx *sufCtx) {
+  // matched in the folded form the terms are indexed in
+  size_t len;
+  char *pattern = runesToStr(sufCtx->rune, sufCtx->runelen, &len);
+  uint32_t *ids = findWildcardTerms(sufCtx->sa, pattern, len, sufCtx->timeout, LLONG_MAX);
+  rm_free(pattern);
+  if (!ids) {
+    return 0;
+  }
+  processTerms(sufCtx->sa, ids, sufCtx);
+  array_free(ids);
+  return 1;
+}
 
-    // this branching is heavy
-    for (int j = tokenIdx[i]; j < tokenIdx[i] + tokenLen[i]; ++j) {
-      if (str[j] == '?') {
-        --curScore;
+void SuffixArray_IterateSuffixes(SuffixArray *sa, void (*cb)(const char *, size_t, void *),
+                                 void *ctx) {
+  suffixEntry *all = array_new(suffixEntry, SuffixArray_NumSuffixes(sa));
+  for (uint32_t i = 0; i < array_len(sa->pending); ++i) {
+    all = array_append(all, sa->pending[i]);
+  }
+  for (uint32_t i = 0; i < array_len(sa->segments); ++i) {
+    for (uint32_t j = 0; j < array_len(sa->segments[i]); ++j) {
+      if (!entryDeleted(sa, sa->segments[i][j])) {
+        all = array_append(all, sa->segments[i][j]);
       }
     }
-
-    if (curScore >= score) {
-      score = curScore;
-      retidx = i;
+  }
+  uint32_t n = array_len(all);
+  suffixEntry *tmp = rm_malloc(n * sizeof(*tmp) + 1);
+  sortEntries(sa, all, tmp, n);
+  rm_free(tmp);
+  for (uint32_t i = 0; i < n; ++i) {
+    if (!i || cmpEntries(sa, all[i - 1], all[i])) {
+      size_t len;
+      const char *str = entryStr(sa, all[i], &len);
+      cb(str, len, ctx);
     }
   }
-
-  return retidx;
+  array_free(all);
 }
 
-int Suffix_ChooseToken_rune(const rune *str, size_t len, size_t *tokenIdx, size_t *tokenLen) {
+
+/***********************************************************************************
+*                                    Wildcard                                      *
+************************************************************************************/
+int Suffix_ChooseToken(const char *str, size_t len, size_t *tokenIdx, size_t *tokenLen) {
   int runner = 0;
   int i = 0;
   int init = 0;
   while (i < len) {
     // save location of token
-    if (str[i] != (rune)'*') {
+    if (str[i] != '*') {
       tokenIdx[runner] = i;
       init = 1;
     }
     // skip all characters other than `*`
-    while (i < len && str[i] != (rune)'*') {
+    while (i < len && str[i] != '*') {
       ++i;
     }
     // save length of token
@@ -270,7 +456,7 @@ int Suffix_ChooseToken_rune(const rune *str, size_t len, size_t *tokenIdx, size_
       ++runner;
     }
     // skip `*` characters
-    while (str[i] == (rune)'*') {
+    while (str[i] == '*') {
       ++i;
     }
   }
@@ -285,17 +471,17 @@ int Suffix_ChooseToken_rune(const rune *str, size_t len, size_t *tokenIdx, size_
 
     // 1. long string are likely to have less results
     // 2. tokens at end of pattern are likely to be more relevant
-    int curScore = tokenLen[i] + 1;
+    int curScore = tokenLen[i] + i;
 
     // iterating all children is demanding
-    if (str[tokenIdx[i] + tokenLen[i]] == (rune)'*') {
+    if (str[tokenIdx[i] + tokenLen[i]] == '*') {
       curScore -= 5;
     }
 
     // this branching is heavy
     for (int j = tokenIdx[i]; j < tokenIdx[i] + tokenLen[i]; ++j) {
-      if (str[j] == (rune)'?') {
-        --score;
+      if (str[j] == '?') {
+        --curScore;
       }
     }
 
@@ -308,213 +494,33 @@ int Suffix_ChooseToken_rune(const rune *str, size_t len, size_t *tokenIdx, size_
   return retidx;
 }
 
-int Suffix_CB_Wildcard(const rune *rune, size_t len, void *p, void *payload) {
-  SuffixCtx *sufCtx = p;
-  TriePayload *pl = payload;
-  if (!pl) {
-    return REDISMODULE_OK;
-  }
-
-  suffixData *data = (suffixData *)pl->data;
-  arrayof(char *) array = data->array;
-  for (int i = 0; i < array_len(array); ++i) {
-    if (Wildcard_MatchChar(sufCtx->cstr, sufCtx->cstrlen, array[i], strlen(array[i]))
-            == FULL_MATCH) {
-      if (sufCtx->callback(array[i], strlen(array[i]), sufCtx->cbCtx, NULL) != REDISMODULE_OK) {
-        return REDISEARCH_ERR;
-      }
-    }
-  }
-  return REDISMODULE_OK;
-}
-
-int Suffix_IterateWildcard(SuffixCtx *sufCtx) {
-  size_t idx[sufCtx->cstrlen];
-  size_t lens[sufCtx->cstrlen];
-  int useIdx = Suffix_ChooseToken_rune(sufCtx->rune, sufCtx->runelen, idx, lens);
-
-  if (useIdx == REDISEARCH_UNINITIALIZED) {
-    return 0;
-  }
-
-  rune *token = sufCtx->rune + idx[useIdx];
-  size_t toklen = lens[useIdx];
-  if (token[toklen] == (rune)'*') {
-    toklen++;
-  }
-  token[toklen] = (rune)'\0';
-
-  TrieNode_IterateWildcard(sufCtx->root, token, toklen, Suffix_CB_Wildcard, sufCtx, sufCtx->timeout);
-  return 1;
-}
-
-void suffixTrie_freeCallback(void *payload) {
-  suffixData *data = payload;
-  array_free(data->array);
-  data->array = NULL;
-  rm_free(data->term);
-  data->term = NULL;
-}
-
 
 /***********************************************************/
-/*****************        TrieMap       ********************/
+/*****************        Tags          ********************/
 /***********************************************************/
 
-
-void addSuffixTrieMap(TrieMap *trie, const char *str, uint32_t len) {
-  suffixData *data = TrieMap_Find(trie, (char *)str, len);
-
-  // if we found a node and term exists, we already have the term in the suffix
-  if (data != TRIEMAP_NOTFOUND && data->term) {
-    return;
-  }
-
-  char *copyStr = rm_strndup(str, len);
-  if (data == TRIEMAP_NOTFOUND) {    // node doesn't exist even as suffix of another term
-    data = rm_calloc(1, sizeof(*data));
-    data->term = copyStr;
-    data->array = array_ensure_append_1(data->array, copyStr);
-    TrieMap_Add(trie, copyStr, len, data, NULL);
-  } else {    // node exists as suffix for other term
-    RS_LOG_ASSERT(!data->term, "can't reach here");
-    data->term = copyStr;
-    data->array = array_ensure_append_1(data->array, copyStr);
-  }
-
-  // Save string copy to all suffixes of it
-  // If it exists, move to the next field
-  for (int j = 1; j < len - MIN_SUFFIX + 1; ++j) {
-    data = TrieMap_Find(trie, copyStr + j, len - j);
-
-    if (data == TRIEMAP_NOTFOUND) {
-      data = rm_calloc(1, sizeof(*data));
-      data->array = array_ensure_append_1(data->array, copyStr);
-      TrieMap_Add(trie, copyStr + j, len - j, data, NULL);
-    } else {
-      data->array = array_ensure_append_1(data->array, copyStr);
-    }
-  }
-}
-
-void deleteSuffixTrieMap(TrieMap *trie, const char *str, uint32_t len) {
-  char *oldTerm = NULL;
-
-  // iterate all matching terms and remove word
-  for (int j = 0; j < len - MIN_SUFFIX + 1; ++j) {
-    suffixData *data = TrieMap_Find(trie, str + j, len - j);
-    // suffix trie is shared between all tag fields in index, even if they don't use it.
-    // if the trie is owned by other fields and not any one containing this suffix,
-    // then failure to find the suffix is not an error. just move along.
-    if (data == TRIEMAP_NOTFOUND) continue;
-    // RS_LOG_ASSERT(data != TRIEMAP_NOTFOUND, "all suffixes must exist");
-    if (j == 0) {
-      // keep pointer to word string to free after it was found in al sub tokens.
-      oldTerm = data->term;
-      data->term = NULL;
-    }
-    // remove from array
-    removeSuffix(str, len, data->array);
-    // if array is empty, remove the node
-    if (array_len(data->array) == 0) {
-      RS_LOG_ASSERT(!data->term, "array should contain a pointer to the string");
-      TrieMap_Delete(trie, str + j, len - j, (freeCB)freeSuffixNode);
-    }
-  }
-  rm_free(oldTerm);
-}
-
-arrayof(char**) GetList_SuffixTrieMap(TrieMap *trie, const char *str, uint32_t len,
-                                          bool prefix, struct timespec timeout) {
-  arrayof(char**) arr = NULL;
-  suffixData *data = NULL;
-  if (!prefix) {
-    data = TrieMap_Find(trie, str, len);
-    if (data == TRIEMAP_NOTFOUND) {
-      return NULL;
-    } else {
-      arr = array_ensure_append_1(arr, data->array);
-      return arr;
+static arrayof(char *) termsOf(const SuffixArray *sa, uint32_t *ids) {
+  arrayof(char *) arr = NULL;
+  if (array_len(ids)) {
+    arr = array_new(char *, array_len(ids));
+    for (uint32_t i = 0; i < array_len(ids); ++i) {
+      arr = array_append(arr, sa->terms[ids[i]].str);
     }
-  } else {
-    TrieMapIterator *it = TrieMap_Iterate(trie, str, len);
-    TrieMapIterator_SetTimeout(it, timeout);
-    if (!it) {
-      return NULL;
-    }
-    // an upper limit on the number of expansions is enforced to avoid stuff like "*"
-    char *s;
-    tm_len_t sl;
-    //void *ptr;
-
-    // Find all completions of the prefix
-    while (TrieMapIterator_Next(it, &s, &sl, (void**)&data)) {
-      arr = array_ensure_append_1(arr, data->array);
-    }
-    TrieMapIterator_Free(it);
-    return arr;
   }
+  array_free(ids);
+  return arr;
 }
 
-// TODO:
-/* This function iterates the suffix trie, find matches to a `token` and returns an
- * array with terms matching the pattern.
- * The 'token' address is 'pattern + tokenidx' with length of tokenlen. */
-static arrayof(char*) _getWildcardArray(TrieMapIterator *it, const char *pattern, uint32_t plen, long long maxPrefixExpansions) {
-  char *s;
-  tm_len_t sl;
-  suffixData *nodeData;;
-  arrayof(char*) resArray = NULL;
-
-  while (TrieMapIterator_NextWildcard(it, &s, &sl, (void **)&nodeData)) {
-    for (int i = 0; i < array_len(nodeData->array); ++i) {
-      if (array_len(resArray) > maxPrefixExpansions) {
-        goto end;
-      }
-      if (Wildcard_MatchChar(pattern, plen, nodeData->array[i], strlen(nodeData->array[i])) == FULL_MATCH) {
-        resArray = array_ensure_append_1(resArray, nodeData->array[i]);
-      }
-    }
-  }
-
-end:
-  TrieMapIterator_Free(it);
-
-  return resArray;
+arrayof(char*) GetList_SuffixTrieMap(SuffixArray *sa, const char *str, uint32_t len,
+                                     bool prefix, struct timespec timeout) {
+  return termsOf(sa, findTerms(sa, str, len, prefix, &timeout));
 }
 
-arrayof(char*) GetList_SuffixTrieMap_Wildcard(TrieMap *trie, const char *pattern, uint32_t len,
+arrayof(char*) GetList_SuffixTrieMap_Wildcard(SuffixArray *sa, const char *pattern, uint32_t len,
                                               struct timespec timeout, long long maxPrefixExpansions) {
-  size_t idx[len];
-  size_t lens[len];
-  // find best token
-  int useIdx = Suffix_ChooseToken(pattern, len, idx, lens);
-  if (useIdx == REDISEARCH_UNINITIALIZED) {
+  uint32_t *ids = findWildcardTerms(sa, pattern, len, &timeout, maxPrefixExpansions);
+  if (!ids) {
     return BAD_POINTER;
   }
-
-  size_t tokenidx = idx[useIdx];
-  size_t tokenlen = lens[useIdx];
-  // if token end with '*', we iterate all its children
-  int prefix = pattern[tokenidx + tokenlen] == '*';
-
-  TrieMapIterator *it = TrieMap_Iterate(trie, pattern + tokenidx, tokenlen + prefix);
-  if (!it) return NULL;
-  TrieMapIterator_SetTimeout(it, timeout);
-  it->mode = prefix ? TM_WILDCARD_MODE : TM_WILDCARD_FIXED_LEN_MODE;
-
-  arrayof(char*) arr = _getWildcardArray(it, pattern, len, maxPrefixExpansions);
-
-  // token does not have hits
-  if (array_len(arr) == 0) {
-    array_free(arr);
-    return NULL;
-  }
-
-  return arr;
-}
-
-void suffixTrieMap_freeCallback(void *payload) {
-  suffixTrie_freeCallback(payload);
-  rm_free(payload);  
+  return termsOf(sa, ids);
 }
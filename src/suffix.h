@@ -15,17 +15,44 @@ extern "C" {
 
 #define MIN_SUFFIX 2
 
+// Number of suffixes of the latest terms kept unsorted, before they are sorted into a segment
+#define SUFFIX_PENDING_MAX 256
+
 typedef enum {
     SUFFIX_TYPE_SUFFIX = 0,
     SUFFIX_TYPE_CONTAINS = 1,
-    SUFFIX_TYPE_WILDCARD = 2,    
+    SUFFIX_TYPE_WILDCARD = 2,
 } SuffixType;
 
+/* The suffixes of the terms of the WITHSUFFIXTRIE fields of an index, or of the values of a
+ * WITHSUFFIXTRIE tag field, for contains, suffix and wildcard queries.
+ *
+ * Every term is stored once, and each of its suffixes, from every character with at least
+ * MIN_SUFFIX bytes after it, is an 8 bytes entry of the term id and the offset of the suffix in it.
+ * The entries are kept in segments sorted by their suffixes, which a pattern is looked up in with
+ * binary searches. The suffixes of new terms are sorted into a new segment once there are
+ * SUFFIX_PENDING_MAX of them, and the segments are merged as they grow, so that there are
+ * logarithmically many of them. A deleted term is skipped until its suffixes are dropped by a merge,
+ * and all the segments are merged once half of the suffixes are of deleted terms */
+typedef struct SuffixArray SuffixArray;
+
+SuffixArray *NewSuffixArray();
+
+void SuffixArray_Free(SuffixArray *sa);
+
+size_t SuffixArray_NumSuffixes(const SuffixArray *sa);
+
+size_t SuffixArray_MemUsage(const SuffixArray *sa);
+
+/* Call `cb` with every distinct suffix, in lexicographic order. Used for debug */
+void SuffixArray_IterateSuffixes(SuffixArray *sa, void (*cb)(const char *, size_t, void *),
+                                 void *ctx);
+
 /***********************************************************/
-/*****************        Trie          ********************/
+/*****************        Terms         ********************/
 /***********************************************************/
 typedef struct SuffixCtx {
-    TrieNode *root;
+    SuffixArray *sa;
     rune *rune;
     size_t runelen;
     const char *cstr;
@@ -37,41 +64,34 @@ typedef struct SuffixCtx {
 } SuffixCtx;
 
 
-void addSuffixTrie(Trie *trie, const char *str, uint32_t len);
-void deleteSuffixTrie(Trie *trie, const char *str, uint32_t len);
-
-void suffixTrie_freeCallback(void *data);
+void addSuffixTrie(SuffixArray *sa, const char *str, uint32_t len);
+void deleteSuffixTrie(SuffixArray *sa, const char *str, uint32_t len);
 
 /* Iterate on suffix trie and add use callback function on results */
 void Suffix_IterateContains(SuffixCtx *sufCtx);
 
-/* Iterate on suffix trie and add use callback function on results 
+/* Iterate on suffix trie and add use callback function on results
  * If wildcard pattern does not support suffix trie, return 0, else return 1. */
 int Suffix_IterateWildcard(SuffixCtx *sufCtx);
 
 
 /***********************************************************/
-/*****************        TrieMap       ********************/
+/*****************        Tags          ********************/
 /***********************************************************/
-void addSuffixTrieMap(TrieMap *trie, const char *str, uint32_t len);
-void deleteSuffixTrieMap(TrieMap *trie, const char *str, uint32_t len);
-
-void suffixTrieMap_freeCallback(void *payload);
 
-/* Return a list of list of terms which match the suffix or contains term */
-arrayof(char**) GetList_SuffixTrieMap(TrieMap *trie, const char *str, uint32_t len,
-                                        bool prefix, struct timespec timeout);
+/* Return a list of the terms which match the suffix or contains term */
+arrayof(char*) GetList_SuffixTrieMap(SuffixArray *sa, const char *str, uint32_t len,
+                                     bool prefix, struct timespec timeout);
 
 /* Return a list of terms which match the wildcard pattern
  * If pattern does not match using suffix trie, return 0xBAAAAAAD */
-arrayof(char*) GetList_SuffixTrieMap_Wildcard(TrieMap *trie, const char *pattern, uint32_t len,
+arrayof(char*) GetList_SuffixTrieMap_Wildcard(SuffixArray *sa, const char *pattern, uint32_t len,
                                                struct timespec timeout, long long maxPrefixExpansions);
 
 /* Breaks wildcard at '*'s and finds the best token to get iterate the suffix trie.
  * tokenIdx and tokenLen arrays should sufficient space for all tokens. Max (len / 2) + 1.
  * The function does not assume str is NULL terminated. */
 int Suffix_ChooseToken(const char *str, size_t len, size_t *tokenIdx, size_t *tokenLen);
-int Suffix_ChooseToken_rune(const rune *str, size_t len, size_t *tokenIdx, size_t *tokenLen);
 
 #ifdef __cplusplus
 }
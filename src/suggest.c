@@ -10,6 +10,8 @@
 #include "rmutil/args.h"
 #include "trie/trie_type.h"
 #include "query_error.h"
+#include "latency_stats.h"
+#include "rmutil/cxx/chrono-clock.h"
 
 extern bool isCrdt;
 
@@ -304,8 +306,11 @@ parse_error:
     goto end;
   }
 
+  hires_clock_t t0;
+  hires_clock_get(&t0);
   Vector *res = Trie_Search(tree, s, len, options.numResults, options.maxDistance, 1, options.trim,
                             options.optimize);
+  double execTime = hires_clock_since_msec(&t0);
   if (!res) {
     RedisModule_ReplyWithError(ctx, "Invalid query");
     goto end;
@@ -334,6 +339,9 @@ parse_error:
     TrieSearchResult_Free(e);
   }
   Vector_Free(res);
+  // suggestion dictionaries are not indexes, only the global stats have them
+  LatencyStats_RecordQuery(NULL, LATENCY_CMD_SUGGET, 0, execTime,
+                           hires_clock_since_msec(&t0) - execTime);
 
 end:
   if (key) {
@@ -32,7 +32,7 @@ static void TermData_Free(TermData* t_data) {
 
 static bool TermData_IdExists(TermData* t_data, const char* id) {
   for (uint32_t i = 0; i < array_len(t_data->groupIds); ++i) {
-    if (strcmp(t_data->groupIds[i], id) == 0) {
+    if (strcmp(t_data->groupIds[i] + 1 /* skip the ~ */, id) == 0) {
       return true;
     }
   }
@@ -40,9 +40,9 @@ static bool TermData_IdExists(TermData* t_data, const char* id) {
 }
 
 static void TermData_AddId(TermData* t_data, const char* id) {
-  char* newId;
-  rm_asprintf(&newId, SYNONYM_PREFIX, id);
   if (!TermData_IdExists(t_data, id)) {
+    char* newId;
+    rm_asprintf(&newId, SYNONYM_PREFIX, id);
     t_data->groupIds = array_append(t_data->groupIds, newId);
   }
 }
@@ -170,6 +170,14 @@ TermData* SynonymMap_GetIdsBySynonym(SynonymMap* smap, const char* synonym, size
   return dictFetchValue(smap->h_table, syn);
 }
 
+bool SynonymMap_InGroup(SynonymMap* smap, const char* synonym, const char* groupId) {
+  char *lowerSynonym = rm_strdup(synonym);
+  strtolower(lowerSynonym);
+  TermData* termData = dictFetchValue(smap->h_table, lowerSynonym);
+  rm_free(lowerSynonym);
+  return termData && TermData_IdExists(termData, groupId);
+}
+
 TermData** SynonymMap_DumpAllTerms(SynonymMap* smap, size_t* size) {
   *size = dictSize(smap->h_table);
   TermData** dump = rm_malloc(sizeof(TermData*) * (*size));
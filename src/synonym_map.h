@@ -82,6 +82,14 @@ void SynonymMap_Update(SynonymMap* smap, const char** synonyms, size_t size, con
  */
 TermData* SynonymMap_GetIdsBySynonym(SynonymMap* smap, const char* synonym, size_t len);
 
+/**
+ * Return true if the term is already in the group
+ * smap - the synonym map
+ * synonym - the term, in any case
+ * groupId - the group id, without the ~ prefix
+ */
+bool SynonymMap_InGroup(SynonymMap* smap, const char* synonym, const char* groupId);
+
 /**
  * Return array of all terms and the group ids they belong to
  * smap - the synonym map
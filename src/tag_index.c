@@ -7,12 +7,14 @@
 #include "tag_index.h"
 #include "suffix.h"
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "rmutil/vector.h"
 #include "inverted_index.h"
 #include "redis_index.h"
 #include "rmutil/util.h"
 #include "util/misc.h"
 #include "util/arr.h"
+#include "util/minmax.h"
 #include "rmutil/rm_assert.h"
 #include "resp3.h"
 
@@ -20,17 +22,102 @@ extern RedisModuleCtx *RSDummyContext;
 
 static uint32_t tagUniqueId = 0;
 
-// Tags are limited to 4096 each
-#define MAX_TAG_LEN 0x1000
 /* See tag_index.h for documentation  */
 TagIndex *NewTagIndex() {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TAG);
   TagIndex *idx = rm_new(TagIndex);
   idx->values = NewTrieMap();
-  idx->uniqueId = tagUniqueId++;
+  idx->uniqueId = __atomic_fetch_add(&tagUniqueId, 1, __ATOMIC_RELAXED);
   idx->suffix = NULL;
+  idx->docValues = (TagDocValues){
+      .codes = NewTrieMap(),
+      .values = array_new(RSValue *, 16),
+      .docCodes = array_new(uint16_t, 16),
+      .enabled = true,
+  };
+  idx->revision = 0;
+  idx->expansions = NewExpansionCache();
+  AllocStats_SetTag(prevTag);
   return idx;
 }
 
+// the codes are stored as the values of the trie map, there is nothing to free
+static void tagDocValues_freeCode(void *p) {
+}
+
+static void tagDocValues_Free(TagDocValues *dv) {
+  TrieMap_Free(dv->codes, tagDocValues_freeCode);
+  array_free_ex(dv->values, RSValue_Decref(*(RSValue **)ptr));
+  array_free(dv->docCodes);
+  *dv = (TagDocValues){.enabled = false};
+}
+
+/* See tag_index.h for documentation  */
+void TagIndex_SetDocValue(TagIndex *idx, const char *value, size_t len, t_docId docId) {
+  TagDocValues *dv = &idx->docValues;
+  if (!dv->enabled) {
+    return;
+  }
+
+  void *code = TrieMap_Find(dv->codes, (char *)value, len);
+  if (code == TRIEMAP_NOTFOUND) {
+    if (array_len(dv->values) == TAG_DOC_VALUES_MAX_CODES || len > UINT16_MAX) {
+      // too many values to be worth a dictionary, or too long for one
+      tagDocValues_Free(dv);
+      return;
+    }
+    dv->values = array_append(dv->values, RS_NewCopiedString(value, len));
+    code = (void *)(uintptr_t)array_len(dv->values);
+    TrieMap_Add(dv->codes, (char *)value, len, code, NULL);
+  }
+
+  size_t n = array_len(dv->docCodes);
+  if (docId >= n) {
+    dv->docCodes = array_ensure_len(dv->docCodes, docId + 1);
+    memset(dv->docCodes + n, 0, (docId + 1 - n) * sizeof(*dv->docCodes));
+  }
+  dv->docCodes[docId] = (uintptr_t)code;
+}
+
+/* See tag_index.h for documentation  */
+void TagIndex_RemapDocValues(TagIndex *idx, const DocIdRemap *remap) {
+  TagDocValues *dv = &idx->docValues;
+  t_docId end = MIN(remap->to, array_len(dv->docCodes));
+  // by increasing ids, as the new ids are never above the old ones
+  for (t_docId docId = remap->from; docId < end; ++docId) {
+    uint16_t code = dv->docCodes[docId];
+    t_docId newId = remap->newIds[docId - remap->from];
+    dv->docCodes[docId] = 0;
+    if (newId) {
+      dv->docCodes[newId] = code;
+    }
+  }
+}
+
+// The cache key of a pattern is its expansion type followed by the pattern
+#define EXPANSION_KEY(key, type, pattern, len) \
+  char key[(len) + 1];                         \
+  key[0] = (type);                             \
+  memcpy(key + 1, (pattern), (len));
+
+Expansion *TagIndex_GetExpansion(TagIndex *idx, ExpansionType type, const char *pattern,
+                                 size_t len, size_t limit) {
+  if (len >= UINT16_MAX) {
+    return NULL;
+  }
+  EXPANSION_KEY(key, type, pattern, len);
+  return ExpansionCache_Get(idx->expansions, idx->revision, key, len + 1, limit);
+}
+
+void TagIndex_CacheExpansion(TagIndex *idx, ExpansionType type, const char *pattern, size_t len,
+                             size_t limit, Expansion *exp) {
+  if (len >= UINT16_MAX) {
+    return;
+  }
+  EXPANSION_KEY(key, type, pattern, len);
+  ExpansionCache_Put(idx->expansions, idx->revision, key, len + 1, limit, exp);
+}
+
 /* read the next token from the string */
 char *TagIndex_SepString(char sep, char **s, size_t *toklen) {
 
@@ -134,6 +221,7 @@ struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_
     if (create) {
       iv = NewInvertedIndex(Index_DocIdsOnly, 1);
       TrieMap_Add(idx->values, (char *)value, len, iv, NULL);
+      idx->revision++;
     }
   }
   return iv;
@@ -152,15 +240,17 @@ static inline size_t tagIndex_Put(TagIndex *idx, const char *value, size_t len,
 size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId) {
   if (!values) return 0;
   size_t ret = 0;
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TAG);
   for (size_t ii = 0; ii < n; ++ii) {
     const char *tok = values[ii];
     if (tok && *tok != '\0') {
       ret += tagIndex_Put(idx, tok, strlen(tok), docId);
       if (idx->suffix) { // add to suffix triemap if exist
-        addSuffixTrieMap(idx->suffix, tok, strlen(tok));
+        addSuffixTrie(idx->suffix, tok, strlen(tok));
       }
     }
   }
+  AllocStats_SetTag(prevTag);
   return ret;
 }
 
@@ -196,18 +286,14 @@ static void TagReader_OnReopen(void *privdata) {
     // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
     if (ir->gcMarker == ir->idx->gcMarker) {
       // no GC - we just go to the same offset we were at
-      size_t offset = ir->br.pos;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->br.pos = offset;
+      IndexReader_ResumeBlock(ir);
     } else {
       // if there has been a GC cycle on this key while we were asleep, the offset might not be
       // valid anymore. This means that we need to seek to last docId we were at
 
       // reset the state of the reader
       t_docId lastId = ir->lastId;
-      ir->currentBlock = 0;
-      ir->br = NewBufferReader(&ir->idx->blocks[ir->currentBlock].buf);
-      ir->lastId = 0;
+      IndexReader_SetBlock(ir, 0);
 
       // seek to the previous last id
       RSIndexResult *dummy = NULL;
@@ -309,23 +395,71 @@ TagIndex *TagIndex_Open(RedisSearchCtx *sctx, RedisModuleString *formattedKey, i
   return ret;
 }
 
-/* Serialize all the tags in the index to the redis client */
-void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx) {
-  TrieMapIterator *it = TrieMap_Iterate(idx->values, "", 0);
-
-  char *str;
-  tm_len_t slen;
-  void *ptr;
-  RedisModule_ReplyWithSetOrArray(ctx, REDISMODULE_POSTPONED_LEN);
-  long long count = 0;
-  while (TrieMapIterator_Next(it, &str, &slen, &ptr)) {
-    ++count;
-    RedisModule_ReplyWithStringBuffer(ctx, str, slen);
+int TagValsOptions_Parse(ArgsCursor *ac, TagValsOptions *opts, QueryError *status) {
+  while (!AC_IsAtEnd(ac)) {
+    int rc = AC_OK;
+    if (AC_AdvanceIfMatch(ac, "PREFIX")) {
+      rc = AC_GetString(ac, &opts->prefix, &opts->prefixLen, 0);
+    } else if (AC_AdvanceIfMatch(ac, "AFTER")) {
+      rc = AC_GetString(ac, &opts->after, &opts->afterLen, 0);
+    } else if (AC_AdvanceIfMatch(ac, "LIMIT")) {
+      if ((rc = AC_GetSize(ac, &opts->offset, AC_F_GE0)) == AC_OK) {
+        rc = AC_GetSize(ac, &opts->limit, AC_F_GE1);
+      }
+    } else if (AC_AdvanceIfMatch(ac, "WITHCOUNTS")) {
+      opts->withCounts = true;
+    } else {
+      QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Unknown argument `%s`",
+                             AC_GetStringNC(ac, NULL));
+      return REDISMODULE_ERR;
+    }
+    if (rc != AC_OK) {
+      QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Bad arguments for FT.TAGVALS: %s",
+                             AC_Strerror(rc));
+      return REDISMODULE_ERR;
+    }
+    opts->ordered = true;
   }
+  return REDISMODULE_OK;
+}
 
-  RedisModule_ReplySetSetOrArrayLength(ctx, count);
+typedef struct {
+  RedisModuleCtx *ctx;
+  const TagValsOptions *opts;
+  size_t skipped;
+  size_t count;
+} serializeValuesCtx;
+
+static int serializeValue(const char *str, size_t len, void *p, void *value) {
+  serializeValuesCtx *sv = p;
+  if (sv->skipped < sv->opts->offset) {
+    sv->skipped++;
+    return 1;
+  }
+  RedisModule_ReplyWithStringBuffer(sv->ctx, str, len);
+  if (sv->opts->withCounts) {
+    RedisModule_ReplyWithLongLong(sv->ctx, ((InvertedIndex *)value)->numDocs);
+  }
+  sv->count++;
+  return !sv->opts->limit || sv->count < sv->opts->limit;
+}
 
-  TrieMapIterator_Free(it);
+void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx, const TagValsOptions *opts) {
+  serializeValuesCtx sv = {.ctx = ctx, .opts = opts};
+  if (opts->ordered) {
+    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_LEN);
+  } else {
+    RedisModule_ReplyWithSetOrArray(ctx, REDISMODULE_POSTPONED_LEN);
+  }
+  // the values are capped to the length of the keys of the trie
+  TrieMap_IterateFrom(idx->values, opts->prefix, MIN(opts->prefixLen, UINT16_MAX), opts->after,
+                      MIN(opts->afterLen, UINT16_MAX), serializeValue, &sv);
+  long long len = sv.count * (opts->withCounts ? 2 : 1);
+  if (opts->ordered) {
+    RedisModule_ReplySetArrayLength(ctx, len);
+  } else {
+    RedisModule_ReplySetSetOrArrayLength(ctx, len);
+  }
 }
 
 RedisModuleType *TagIndexType;
@@ -342,8 +476,13 @@ void *TagIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
     TrieMap_Add(idx->values, s, MIN(slen, MAX_TAG_LEN), inv, NULL);
     RedisModule_Free(s);
   }
+  TagIndex_ForgetDocValues(idx);
   return idx;
 }
+
+void TagIndex_ForgetDocValues(TagIndex *idx) {
+  tagDocValues_Free(&idx->docValues);
+}
 void TagIndex_RdbSave(RedisModuleIO *rdb, void *value) {
   TagIndex *idx = value;
   RedisModule_SaveUnsigned(rdb, idx->values->cardinality);
@@ -365,9 +504,13 @@ void TagIndex_RdbSave(RedisModuleIO *rdb, void *value) {
 
 void TagIndex_Free(void *p) {
   TagIndex *idx = p;
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TAG);
   TrieMap_Free(idx->values, InvertedIndex_Free);
-  TrieMap_Free(idx->suffix, suffixTrieMap_freeCallback);
+  SuffixArray_Free(idx->suffix);
+  tagDocValues_Free(&idx->docValues);
+  ExpansionCache_Free(idx->expansions);
   rm_free(idx);
+  AllocStats_SetTag(prevTag);
 }
 
 size_t TagIndex_MemUsage(const void *value) {
@@ -383,6 +526,14 @@ size_t TagIndex_MemUsage(const void *value) {
     sz += slen + InvertedIndex_MemUsage((InvertedIndex *)ptr);
   }
   TrieMapIterator_Free(it);
+
+  const TagDocValues *dv = &idx->docValues;
+  if (dv->enabled) {
+    sz += TrieMap_MemUsage((TrieMap *)dv->codes) + array_len(dv->docCodes) * sizeof(*dv->docCodes);
+    for (size_t i = 0; i < array_len(dv->values); ++i) {
+      sz += sizeof(RSValue) + dv->values[i]->strval.len;
+    }
+  }
   return sz;
 }
 
@@ -14,6 +14,7 @@
 #include "geo_index.h"
 #include "vector_index.h"
 #include "indexer.h"
+#include "expansion_cache.h"
 
 struct InvertedIndex;
 
@@ -100,12 +101,37 @@ extern "C" {
  *
  *
  */
+
+/* Fields with more distinct values than this do not keep doc values */
+#define TAG_DOC_VALUES_MAX_CODES UINT16_MAX
+
+/**
+ * The values of a tag field per document, dictionary-encoded: every distinct raw value of the field
+ * gets a code, and every document keeps the code of its value. Grouping or sorting by the field
+ * reads the value of a document from here instead of loading it from the keyspace.
+ *
+ * Only the raw value of HASH documents is kept, as loaded from the key. Doc values are dropped
+ * altogether (`enabled` is false) once the field holds more than TAG_DOC_VALUES_MAX_CODES values.
+ */
 typedef struct {
+  TrieMap *codes;      // raw value => code
+  RSValue **values;    // values[code - 1] is the raw value of a code
+  uint16_t *docCodes;  // docCodes[docId] is the code of the value of a document, 0 if it has none
+  bool enabled;
+} TagDocValues;
+
+typedef struct TagIndex {
   uint32_t uniqueId;
   TrieMap *values;
-  TrieMap *suffix;
+  struct SuffixArray *suffix;
+  TagDocValues docValues;
+  uint64_t revision;               // bumped whenever a value is added to or removed from the index
+  ExpansionCache *expansions;      // expanded at the revision of the index
 } TagIndex;
 
+// Tags are limited to 4096 each
+#define MAX_TAG_LEN 0x1000
+
 #define TAG_INDEX_KEY_FMT "tag:%s/%s"
 /* Format the key name for a tag index */
 RedisModuleString *TagIndex_FormatName(RedisSearchCtx *sctx, const char *field);
@@ -130,6 +156,39 @@ static inline void TagIndex_FreePreprocessedData(char **s) {
 /* Index a vector of pre-processed tags for a docId */
 size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId);
 
+static inline bool TagIndex_HasDocValues(const TagIndex *idx) {
+  return idx->docValues.enabled;
+}
+
+/* The doc values code of the field value for a docId, 0 if the document has no value */
+static inline uint16_t TagIndex_GetDocCode(const TagIndex *idx, t_docId docId) {
+  const TagDocValues *dv = &idx->docValues;
+  return docId < array_len(dv->docCodes) ? dv->docCodes[docId] : 0;
+}
+
+/* Keep the raw value of the field for a docId */
+void TagIndex_SetDocValue(TagIndex *idx, const char *value, size_t len, t_docId docId);
+
+/* Move the doc values of the documents renumbered by the docid compaction to their new ids */
+void TagIndex_RemapDocValues(TagIndex *idx, const DocIdRemap *remap);
+
+/* Get the raw value of the field for a docId from the doc values, or NULL if the document has no
+ * value. Check TagIndex_HasDocValues first */
+static inline RSValue *TagIndex_GetDocValue(const TagIndex *idx, t_docId docId) {
+  uint16_t code = TagIndex_GetDocCode(idx, docId);
+  return code ? idx->docValues.values[code - 1] : NULL;
+}
+
+/* Get the cached expansion of a pattern, expanded with at most `limit` values. Returns NULL if it
+ * is not cached, or if the index changed since it was. The caller releases the expansion */
+Expansion *TagIndex_GetExpansion(TagIndex *idx, ExpansionType type, const char *pattern,
+                                 size_t len, size_t limit);
+
+/* Cache the expansion of a pattern, expanded with at most `limit` values, evicting the least
+ * recently used expansion if the cache is full */
+void TagIndex_CacheExpansion(TagIndex *idx, ExpansionType type, const char *pattern, size_t len,
+                             size_t limit, Expansion *exp);
+
 /* Open an index reader to iterate a tag index for a specific tag. Used at query evaluation time.
  * Returns NULL if there is no such tag in the index */
 IndexIterator *TagIndex_OpenReader(TagIndex *idx, IndexSpec *sp, const char *value, size_t len,
@@ -142,11 +201,41 @@ TagIndex *TagIndex_Open(RedisSearchCtx *sctx, RedisModuleString *formattedKey, i
 
 struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_t len, int create);
 
-/* Serialize all the tags in the index to the redis client */
-void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx);
+/* The values of a tag index to reply to FT.TAGVALS with */
+typedef struct {
+  // the values start with the prefix
+  const char *prefix;
+  size_t prefixLen;
+  // the values follow this one, the last one of the previous page
+  const char *after;
+  size_t afterLen;
+  size_t offset;
+  // the number of values, 0 for all of them
+  size_t limit;
+  // each value is followed by its number of documents
+  bool withCounts;
+  // the values are replied in an array, in the order of the index, rather than in a set
+  bool ordered;
+} TagValsOptions;
+
+/* Parse the options of FT.TAGVALS following the field. Any of them has the values replied in an
+ * array, in the order of the index */
+int TagValsOptions_Parse(ArgsCursor *ac, TagValsOptions *opts, QueryError *status);
+
+/* Serialize the tags in the index to the redis client, in the order of the index (see
+ * TrieMap_KeyCmp) */
+void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx, const TagValsOptions *opts);
 
 #define TAGIDX_CURRENT_VERSION 1
 extern RedisModuleType *TagIndexType;
+
+/* Serialize the values of a tag index and their inverted indexes. The values of the documents are
+ * not saved, a loaded index has none */
+void TagIndex_RdbSave(RedisModuleIO *rdb, void *value);
+void *TagIndex_RdbLoad(RedisModuleIO *rdb, int encver);
+
+/* The documents of a loaded index are not indexed again, so their values are unknown */
+void TagIndex_ForgetDocValues(TagIndex *idx);
 /* Register the tag index type in redis */
 int TagIndex_RegisterType(RedisModuleCtx *ctx);
 
@@ -13,10 +13,21 @@
 #include <stdlib.h>
 #include <strings.h>
 #include "phonetic_manager.h"
+#include "util/mempool.h"
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TOK_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define TOK_NEON 1
+#endif
 
 typedef struct {
   RSTokenizer base;
   char **pos;
+  const char *end;  // End of the text, within which whole chunks may be read and written
   Stemmer *stemmer;
 } simpleTokenizer;
 
@@ -27,6 +38,158 @@ static void simpleTokenizer_Start(RSTokenizer *base, char *text, size_t len, uin
   ctx->options = options;
   ctx->len = len;
   self->pos = &ctx->text;
+  self->end = text + len;
+}
+
+/* Most text is split into tokens and lowercased a chunk of bytes at a time. The separator
+ * classes below are the ranges of ToksepMap_g, plus the escape and NUL which also end a run of
+ * plain token characters. Bytes with the high bit set are never separators, and are left as they
+ * are by DefaultNormalize in the C locale, so they are plain characters as well. */
+#define TOK_CHUNK 16
+
+#if defined(TOK_SSE2)
+#define TOK_SIMD 1
+
+static inline __m128i chunkInRange(__m128i v, uint8_t lo, uint8_t hi) {
+  __m128i x = _mm_sub_epi8(v, _mm_set1_epi8((char)lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8((char)(hi - lo))), x);
+}
+
+static inline __m128i chunkEq(__m128i v, uint8_t c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8((char)c));
+}
+
+/* The offset of the first separator, escape or NUL of the chunk, or TOK_CHUNK */
+static inline size_t chunkFindSpecial(const uint8_t *p) {
+  __m128i v = _mm_loadu_si128((const __m128i *)p);
+  __m128i m = _mm_or_si128(chunkEq(v, 0), chunkEq(v, '\t'));
+  m = _mm_or_si128(m, chunkInRange(v, ' ', '/'));
+  m = _mm_or_si128(m, chunkInRange(v, ':', '@'));
+  m = _mm_or_si128(m, chunkInRange(v, '[', '^'));
+  m = _mm_or_si128(m, chunkEq(v, '`'));
+  m = _mm_or_si128(m, chunkInRange(v, '{', '~'));
+  unsigned bits = _mm_movemask_epi8(m);
+  return bits ? __builtin_ctz(bits) : TOK_CHUNK;
+}
+
+/* Lowercase the first n bytes of the chunk, unless one of them is a control character or an
+ * escape. The whole chunk is written back */
+static inline int chunkLower(uint8_t *p, size_t n) {
+  __m128i v = _mm_loadu_si128((const __m128i *)p);
+  __m128i valid = _mm_cmpgt_epi8(_mm_set1_epi8((char)n),
+                                 _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+  __m128i special = _mm_or_si128(chunkInRange(v, 0, 0x1F), chunkEq(v, 0x7F));
+  special = _mm_and_si128(_mm_or_si128(special, chunkEq(v, '\\')), valid);
+  if (_mm_movemask_epi8(special)) {
+    return 0;
+  }
+  __m128i upper = _mm_and_si128(chunkInRange(v, 'A', 'Z'), valid);
+  if (_mm_movemask_epi8(upper)) {
+    v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128((__m128i *)p, v);
+  }
+  return 1;
+}
+
+#elif defined(TOK_NEON)
+#define TOK_SIMD 1
+
+static inline uint8x16_t chunkInRange(uint8x16_t v, uint8_t lo, uint8_t hi) {
+  return vcleq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8(hi - lo));
+}
+
+static inline uint8x16_t chunkEq(uint8x16_t v, uint8_t c) {
+  return vceqq_u8(v, vdupq_n_u8(c));
+}
+
+// 4 bits per byte of the comparison, as NEON has no movemask
+static inline uint64_t chunkMask(uint8x16_t m) {
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+static inline size_t chunkFindSpecial(const uint8_t *p) {
+  uint8x16_t v = vld1q_u8(p);
+  uint8x16_t m = vorrq_u8(chunkEq(v, 0), chunkEq(v, '\t'));
+  m = vorrq_u8(m, chunkInRange(v, ' ', '/'));
+  m = vorrq_u8(m, chunkInRange(v, ':', '@'));
+  m = vorrq_u8(m, chunkInRange(v, '[', '^'));
+  m = vorrq_u8(m, chunkEq(v, '`'));
+  m = vorrq_u8(m, chunkInRange(v, '{', '~'));
+  uint64_t bits = chunkMask(m);
+  return bits ? __builtin_ctzll(bits) / 4 : TOK_CHUNK;
+}
+
+static inline int chunkLower(uint8_t *p, size_t n) {
+  static const uint8_t lanes[TOK_CHUNK] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+  uint8x16_t v = vld1q_u8(p);
+  uint8x16_t valid = vcltq_u8(vld1q_u8(lanes), vdupq_n_u8(n));
+  uint8x16_t special = vorrq_u8(chunkInRange(v, 0, 0x1F), chunkEq(v, 0x7F));
+  special = vandq_u8(vorrq_u8(special, chunkEq(v, '\\')), valid);
+  if (chunkMask(special)) {
+    return 0;
+  }
+  uint8x16_t upper = vandq_u8(chunkInRange(v, 'A', 'Z'), valid);
+  if (chunkMask(upper)) {
+    vst1q_u8(p, vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20))));
+  }
+  return 1;
+}
+#endif
+
+/* Like toksep(), skipping the runs of plain token characters a chunk at a time within the text */
+static inline char *simpleTokenizer_Sep(simpleTokenizer *self, size_t *tokLen) {
+#ifdef TOK_SIMD
+  char **s = self->pos;
+  uint8_t *pos = (uint8_t *)*s;
+  char *orig = *s;
+  for (;;) {
+    while ((const char *)pos + TOK_CHUNK <= self->end) {
+      size_t off = chunkFindSpecial(pos);
+      pos += off;
+      if (off < TOK_CHUNK) {
+        break;
+      }
+    }
+    if (!*pos) {
+      break;
+    }
+    if (ToksepMap_g[*pos] && ((char *)pos == orig || *(pos - 1) != '\\')) {
+      *s = (char *)++pos;
+      *tokLen = ((char *)pos - orig) - 1;
+      if (!*pos) {
+        *s = NULL;
+      }
+      return orig;
+    }
+    ++pos;
+  }
+
+  *s = NULL;
+  *tokLen = (char *)pos - orig;
+  return orig;
+#else
+  return toksep(self->pos, tokLen);
+#endif
+}
+
+/* Lowercase the token in place a chunk at a time, as DefaultNormalize would. Returns 0 if it has
+ * control or escaped characters, or ends too close to the end of the text, for DefaultNormalize
+ * to handle it */
+static inline int simpleTokenizer_Lower(simpleTokenizer *self, char *s, size_t len) {
+#ifdef TOK_SIMD
+  for (size_t off = 0; off < len; off += TOK_CHUNK) {
+    if (s + off + TOK_CHUNK > self->end) {
+      return 0;
+    }
+    size_t n = len - off < TOK_CHUNK ? len - off : TOK_CHUNK;
+    if (!chunkLower((uint8_t *)s + off, n)) {
+      return 0;
+    }
+  }
+  return 1;
+#else
+  return 0;
+#endif
 }
 
 // Shortest word which can/should actually be stemmed
@@ -81,7 +244,7 @@ uint32_t simpleTokenizer_Next(RSTokenizer *base, Token *t) {
   while (*self->pos != NULL) {
     // get the next token
     size_t origLen;
-    char *tok = toksep(self->pos, &origLen);
+    char *tok = simpleTokenizer_Sep(self, &origLen);
 
     // normalize the token
     size_t normLen = origLen;
@@ -97,14 +260,20 @@ uint32_t simpleTokenizer_Next(RSTokenizer *base, Token *t) {
       normBuf = tok;
     }
 
-    char *normalized = DefaultNormalize(tok, normBuf, &normLen);
+    char *normalized;
+    if (normBuf == tok && simpleTokenizer_Lower(self, tok, normLen)) {
+      // lowercased in place, so the fast path leaves the length as it is
+      normalized = tok;
+    } else {
+      normalized = DefaultNormalize(tok, normBuf, &normLen);
+    }
     // ignore tokens that turn into nothing
     if (normalized == NULL || normLen == 0) {
       continue;
     }
 
     // skip stopwords
-    if (StopWordList_Contains(ctx->stopwords, normalized, normLen)) {
+    if (StopWordList_ContainsLowered(ctx->stopwords, normalized, normLen)) {
       continue;
     }
 
@@ -169,8 +338,41 @@ RSTokenizer *NewSimpleTokenizer(Stemmer *stemmer, StopWordList *stopwords, uint3
   return &t->base;
 }
 
-static mempool_t *tokpoolLatin_g = NULL;
-static mempool_t *tokpoolCn_g = NULL;
+/* The tokenizers are pooled per thread, so that the workers indexing documents concurrently do not
+ * share a pool. A tokenizer is returned to the pool of the thread releasing it */
+typedef struct {
+  mempool_t *latin;
+  mempool_t *cn;
+} tokenizerThreadPools;
+
+// Tokenizers kept by a thread for its next documents
+#define TOKENIZER_POOL_MAX 64
+
+static pthread_key_t tokpoolKey_g;
+
+static void tokenizerThreadPoolsDtor(void *p) {
+  tokenizerThreadPools *tp = p;
+  if (tp->latin) {
+    mempool_destroy(tp->latin);
+  }
+  if (tp->cn) {
+    mempool_destroy(tp->cn);
+  }
+  rm_free(tp);
+}
+
+static void __attribute__((constructor)) initTokpoolKey() {
+  pthread_key_create(&tokpoolKey_g, tokenizerThreadPoolsDtor);
+}
+
+static tokenizerThreadPools *getThreadPools() {
+  tokenizerThreadPools *tp = pthread_getspecific(tokpoolKey_g);
+  if (tp == NULL) {
+    tp = rm_calloc(1, sizeof(*tp));
+    pthread_setspecific(tokpoolKey_g, tp);
+  }
+  return tp;
+}
 
 static void *newLatinTokenizerAlloc() {
   return NewSimpleTokenizer(NULL, NULL, 0);
@@ -192,29 +394,36 @@ RSTokenizer *GetTokenizer(RSLanguage language, Stemmer *stemmer, StopWordList *s
 }
 
 RSTokenizer *GetChineseTokenizer(Stemmer *stemmer, StopWordList *stopwords) {
-  if (!tokpoolCn_g) {
-    mempool_options opts = {
-        .initialCap = 16, .alloc = newCnTokenizerAlloc, .free = tokenizerFree};
-    mempool_test_set_global(&tokpoolCn_g, &opts);
+  tokenizerThreadPools *tp = getThreadPools();
+  if (!tp->cn) {
+    mempool_options opts = {.initialCap = 4,
+                            .maxCap = TOKENIZER_POOL_MAX,
+                            .alloc = newCnTokenizerAlloc,
+                            .free = tokenizerFree};
+    tp->cn = mempool_new(&opts);
   }
 
-  RSTokenizer *t = mempool_get(tokpoolCn_g);
+  RSTokenizer *t = mempool_get(tp->cn);
   t->Reset(t, stemmer, stopwords, 0);
   return t;
 }
 
 RSTokenizer *GetSimpleTokenizer(Stemmer *stemmer, StopWordList *stopwords) {
-  if (!tokpoolLatin_g) {
-    mempool_options opts = {
-        .initialCap = 16, .alloc = newLatinTokenizerAlloc, .free = tokenizerFree};
-    mempool_test_set_global(&tokpoolLatin_g, &opts);
+  tokenizerThreadPools *tp = getThreadPools();
+  if (!tp->latin) {
+    mempool_options opts = {.initialCap = 4,
+                            .maxCap = TOKENIZER_POOL_MAX,
+                            .alloc = newLatinTokenizerAlloc,
+                            .free = tokenizerFree};
+    tp->latin = mempool_new(&opts);
   }
-  RSTokenizer *t = mempool_get(tokpoolLatin_g);
+  RSTokenizer *t = mempool_get(tp->latin);
   t->Reset(t, stemmer, stopwords, 0);
   return t;
 }
 
 void Tokenizer_Release(RSTokenizer *t) {
+  tokenizerThreadPools *tp = getThreadPools();
   // In the future it would be nice to have an actual ID field or w/e, but for
   // now we can just compare callback pointers
   if (t->Next == simpleTokenizer_Next) {
@@ -222,8 +431,15 @@ void Tokenizer_Release(RSTokenizer *t) {
       StopWordList_Unref(t->ctx.stopwords);
       t->ctx.stopwords = NULL;
     }
-    mempool_release(tokpoolLatin_g, t);
+    if (!tp->latin) {
+      // acquired by another thread
+      t->Free(t);
+    } else {
+      mempool_release(tp->latin, t);
+    }
+  } else if (!tp->cn) {
+    t->Free(t);
   } else {
-    mempool_release(tokpoolCn_g, t);
+    mempool_release(tp->cn, t);
   }
 }
@@ -91,7 +91,7 @@ RSTokenizer *NewChineseTokenizer(Stemmer *stemmer, StopWordList *stopwords, uint
  * Pooled tokenizer functions:
  * These functions retrieve tokenizers using pools.
  *
- * These should all be called when the GIL is held.
+ * Each thread has its own pools, so they may be called concurrently by the workers.
  */
 
 /**
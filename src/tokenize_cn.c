@@ -13,8 +13,12 @@
 #include "rmutil/rm_assert.h"
 #include "rmalloc.h"
 
+#include <pthread.h>
+
+// Shared by the tokenizers of all the threads, and only read once loaded
 static friso_config_t config_g;
 static friso_t friso_g;
+static pthread_once_t frisoOnce_g = PTHREAD_ONCE_INIT;
 
 #define CNTOKENIZE_BUF_MAX 256
 
@@ -25,12 +29,7 @@ typedef struct {
   size_t nescapebuf;
 } cnTokenizer;
 
-// TODO: This is just a global init
-static void maybeFrisoInit() {
-  if (friso_g) {
-    return;
-  }
-
+static void frisoInit() {
   const char *configfile = RSGlobalConfig.frisoIni;
   friso_g = friso_new();
   config_g = friso_new_config();
@@ -52,6 +51,11 @@ static void maybeFrisoInit() {
   config_g->en_sseg = 0;
 }
 
+// The first tokenizers may be created by several workers at once
+static void maybeFrisoInit() {
+  pthread_once(&frisoOnce_g, frisoInit);
+}
+
 static void cnTokenizer_Start(RSTokenizer *base, char *text, size_t len, uint32_t options) {
   cnTokenizer *self = (cnTokenizer *)base;
   base->ctx.text = text;
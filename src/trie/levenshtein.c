@@ -11,6 +11,10 @@
 #include "levenshtein.h"
 #include "rune_util.h"
 #include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/dllist.h"
+
+#include <pthread.h>
 
 // NewSparseAutomaton creates a new automaton for the string s, with a given max
 // edit distance check
@@ -191,37 +195,165 @@ void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
   //}
 }
 
-DFAFilter *NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
+static LevenshteinDFA *dfa_compile(SparseAutomaton *a) {
   Vector *cache = NewVector(dfaNode *, 8);
+  sparseVector *v = SparseAutomaton_Start(a);
+  dfaNode *dr = __newDfaNode(0, v);
+  __dfn_putCache(cache, dr);
+  dfa_build(dr, a, cache);
+
+  LevenshteinDFA *dfa = rm_malloc(sizeof(*dfa));
+  dfa->root = dr;
+  dfa->nodes = cache;
+  dfa->refcount = 1;
+  dfa->memory = sizeof(*dfa);
+  for (int i = 0; i < Vector_Size(cache); i++) {
+    dfaNode *dn;
+    Vector_Get(cache, i, &dn);
+    dfa->memory += sizeof(*dn) + dn->numEdges * sizeof(dfaEdge) + __sv_sizeof(dn->v->cap);
+  }
+  return dfa;
+}
+
+void LevenshteinDFA_Release(LevenshteinDFA *dfa) {
+  if (__atomic_sub_fetch(&dfa->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  for (int i = 0; i < Vector_Size(dfa->nodes); i++) {
+    dfaNode *dn;
+    Vector_Get(dfa->nodes, i, &dn);
+
+    if (dn) __dfaNode_free(dn);
+  }
+  Vector_Free(dfa->nodes);
+  rm_free(dfa);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// Queries compile their DFAs concurrently on the workers, so the cache has a lock of its own
+static struct {
+  pthread_mutex_t lock;
+  TrieMap *entries;  // distance and string => dfaCacheEntry, created on first use
+  DLLIST lru;        // the most recently used entry first
+  size_t size;
+  size_t memory;
+} dfaCache_g = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+typedef struct {
+  DLLIST_node llnode;
+  char *key;
+  tm_len_t keylen;
+  LevenshteinDFA *dfa;
+} dfaCacheEntry;
+
+static void dfaCacheEntry_Free(void *p) {
+  dfaCacheEntry *e = p;
+  LevenshteinDFA_Release(e->dfa);
+  rm_free(e->key);
+  rm_free(e);
+}
+
+static void dfaCache_Delete(dfaCacheEntry *e) {
+  dllist_delete(&e->llnode);
+  dfaCache_g.size--;
+  dfaCache_g.memory -= e->dfa->memory;
+  // deleting the key frees the entry
+  char *key = e->key;
+  e->key = NULL;
+  TrieMap_Delete(dfaCache_g.entries, key, e->keylen, dfaCacheEntry_Free);
+  rm_free(key);
+}
+
+/* Get the compiled DFA of the key from the cache, or compile and cache it */
+static LevenshteinDFA *dfaCache_Get(const char *key, size_t keylen, SparseAutomaton *a) {
+  pthread_mutex_lock(&dfaCache_g.lock);
+  if (!dfaCache_g.entries) {
+    dfaCache_g.entries = NewTrieMap();
+    dllist_init(&dfaCache_g.lru);
+  }
+  dfaCacheEntry *e = TrieMap_Find(dfaCache_g.entries, (char *)key, keylen);
+  if (e != TRIEMAP_NOTFOUND) {
+    dllist_delete(&e->llnode);
+    dllist_prepend(&dfaCache_g.lru, &e->llnode);
+    LevenshteinDFA *dfa = e->dfa;
+    __atomic_add_fetch(&dfa->refcount, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&dfaCache_g.lock);
+    return dfa;
+  }
+  pthread_mutex_unlock(&dfaCache_g.lock);
+
+  // compile without the lock, the same DFA may be compiled concurrently
+  LevenshteinDFA *dfa = dfa_compile(a);
+  if (dfa->memory > DFA_CACHE_MEMORY) {
+    return dfa;
+  }
+
+  pthread_mutex_lock(&dfaCache_g.lock);
+  e = TrieMap_Find(dfaCache_g.entries, (char *)key, keylen);
+  if (e != TRIEMAP_NOTFOUND) {
+    dfaCache_Delete(e);
+  }
+  e = rm_malloc(sizeof(*e));
+  e->key = rm_malloc(keylen);
+  memcpy(e->key, key, keylen);
+  e->keylen = keylen;
+  e->dfa = dfa;
+  __atomic_add_fetch(&dfa->refcount, 1, __ATOMIC_RELAXED);
+  TrieMap_Add(dfaCache_g.entries, e->key, e->keylen, e, NULL);
+  dllist_prepend(&dfaCache_g.lru, &e->llnode);
+  dfaCache_g.size++;
+  dfaCache_g.memory += dfa->memory;
+  while (dfaCache_g.size > DFA_CACHE_SIZE || dfaCache_g.memory > DFA_CACHE_MEMORY) {
+    dfaCache_Delete(DLLIST_ITEM(dfaCache_g.lru.prev, dfaCacheEntry, llnode));
+  }
+  pthread_mutex_unlock(&dfaCache_g.lock);
+  return dfa;
+}
+
+void DFACache_Clear() {
+  pthread_mutex_lock(&dfaCache_g.lock);
+  if (dfaCache_g.entries) {
+    TrieMap_Free(dfaCache_g.entries, dfaCacheEntry_Free);
+    dfaCache_g.entries = NULL;
+    dfaCache_g.size = 0;
+    dfaCache_g.memory = 0;
+  }
+  pthread_mutex_unlock(&dfaCache_g.lock);
+}
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+DFAFilter *NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
   SparseAutomaton a = NewSparseAutomaton(str, len, maxDist);
 
-  sparseVector *v = SparseAutomaton_Start(&a);
-  dfaNode *dr = __newDfaNode(0, v);
-  __dfn_putCache(cache, dr);
-  dfa_build(dr, &a, cache);
+  // the states do not depend on the prefix mode, the key is the distance and the string
+  LevenshteinDFA *dfa = NULL;
+  size_t keylen = 1 + len * sizeof(rune);
+  if (maxDist > 0 && keylen < UINT16_MAX) {
+    char *key = rm_malloc(keylen);
+    key[0] = maxDist;
+    memcpy(key + 1, str, len * sizeof(rune));
+    dfa = dfaCache_Get(key, keylen, &a);
+    rm_free(key);
+  } else {
+    dfa = dfa_compile(&a);
+  }
 
   DFAFilter *ret = rm_malloc(sizeof(*ret));
-  ret->cache = cache;
+  ret->dfa = dfa;
   ret->stack = NewVector(dfaNode *, 8);
   ret->distStack = NewVector(int, 8);
   ret->a = a;
   ret->prefixMode = prefixMode;
-  Vector_Push(ret->stack, dr);
+  Vector_Push(ret->stack, dfa->root);
   Vector_Push(ret->distStack, (maxDist + 1));
 
   return ret;
 }
 
 void DFAFilter_Free(DFAFilter *fc) {
-  for (int i = 0; i < Vector_Size(fc->cache); i++) {
-    dfaNode *dn;
-    Vector_Get(fc->cache, i, &dn);
-
-    if (dn) __dfaNode_free(dn);
-  }
-
-  Vector_Free(fc->cache);
+  LevenshteinDFA_Release(fc->dfa);
   Vector_Free(fc->stack);
   Vector_Free(fc->distStack);
 }
@@ -71,10 +71,29 @@ int SparseAutomaton_IsMatch(SparseAutomaton *a, sparseVector *v);
 /* Can the current state lead to a possible match, or is this a dead end? */
 int SparseAutomaton_CanMatch(SparseAutomaton *a, sparseVector *v);
 
+/* Number of compiled DFAs kept by the DFA cache */
+#define DFA_CACHE_SIZE 512
+
+/* Number of bytes of compiled DFAs kept by the DFA cache */
+#define DFA_CACHE_MEMORY (8 << 20)
+
+/* A DFA compiled for a string and a maximal distance. The DFAs of fuzzy searches (a distance above
+ * 0) are kept in a process wide LRU cache, as the same terms are searched repeatedly, and compiling
+ * one is most of the cost of a search on a small trie. A DFA is shared by the filters of its string
+ * and distance, so it is released rather than freed */
+typedef struct {
+    dfaNode *root;
+    // all the states of the DFA, the root first
+    Vector *nodes;
+    size_t memory;
+    uint32_t refcount;
+} LevenshteinDFA;
+
+void LevenshteinDFA_Release(LevenshteinDFA *dfa);
+
 /* DFAFilter is a constructed DFA used to filter the traversal on the trie */
 typedef struct {
-    // a cache of the DFA states, allowing us to re-use the same state whenever we need it
-    Vector *cache;
+    LevenshteinDFA *dfa;
     // A stack of the states leading up to the current state
     Vector *stack;
     // A stack of the minimal distance for each state, used for prefix matching
@@ -101,4 +120,7 @@ void StackPop(void *ctx, int numLevels);
  * is not freed by itself. */
 void DFAFilter_Free(DFAFilter *fc);
 
+/* Drop the compiled DFAs of the DFA cache */
+void DFACache_Clear();
+
 #endif
\ No newline at end of file
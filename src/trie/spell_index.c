@@ -0,0 +1,240 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "spell_index.h"
+#include "rmalloc.h"
+#include "triemap/triemap.h"
+#include "util/arr.h"
+
+#include <string.h>
+#include <sys/param.h>
+
+typedef struct {
+  rune *str;  // NULL for a free id
+  size_t len;
+} spellString;
+
+struct SpellIndex {
+  TrieMap *variants;   // variant => array of the ids of the strings listed under it
+  spellString *strs;   // by id
+  uint32_t *freeIds;
+};
+
+// Variants are keyed behind a marker byte, as the empty variant is valid
+#define VARIANT_KEY_MAX (1 + SPELL_INDEX_PREFIX_LEN * sizeof(rune))
+
+typedef void (*variantCallback)(const char *key, tm_len_t keylen, void *ctx);
+
+/* Call `cb` with the key of every variant of the prefix of a string with up to `maxDel` runes
+ * deleted. A variant may be passed more than once */
+static void forEachVariant(const rune *str, size_t len, int maxDel, variantCallback cb,
+                           void *ctx) {
+  size_t plen = MIN(len, SPELL_INDEX_PREFIX_LEN);
+  rune prefix[SPELL_INDEX_PREFIX_LEN];
+  for (size_t i = 0; i < plen; i++) {
+    prefix[i] = runeFold(str[i]);
+  }
+
+  char key[VARIANT_KEY_MAX];
+  key[0] = 'v';
+  rune *v = (rune *)(key + 1);
+  memcpy(v, prefix, plen * sizeof(rune));
+  cb(key, 1 + plen * sizeof(rune), ctx);
+
+  for (size_t i = 0; i < plen && maxDel >= 1; i++) {
+    // the prefix without the rune at i
+    memcpy(v, prefix, i * sizeof(rune));
+    memcpy(v + i, prefix + i + 1, (plen - i - 1) * sizeof(rune));
+    cb(key, 1 + (plen - 1) * sizeof(rune), ctx);
+
+    for (size_t j = i + 1; j < plen && maxDel >= 2; j++) {
+      // and without the rune at j
+      memcpy(v + i, prefix + i + 1, (j - i - 1) * sizeof(rune));
+      memcpy(v + j - 1, prefix + j + 1, (plen - j - 1) * sizeof(rune));
+      cb(key, 1 + (plen - 2) * sizeof(rune), ctx);
+    }
+  }
+}
+
+SpellIndex *NewSpellIndex() {
+  SpellIndex *si = rm_malloc(sizeof(*si));
+  si->variants = NewTrieMap();
+  si->strs = array_new(spellString, 16);
+  si->freeIds = array_new(uint32_t, 0);
+  return si;
+}
+
+static void idsFree(void *p) {
+  array_free(p);
+}
+
+void SpellIndex_Free(SpellIndex *si) {
+  TrieMap_Free(si->variants, idsFree);
+  array_free_ex(si->strs, rm_free(((spellString *)ptr)->str));
+  array_free(si->freeIds);
+  rm_free(si);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  SpellIndex *si;
+  uint32_t id;
+} variantCtx;
+
+static void *idsReplace(void *oldval, void *newval) {
+  // the old array was reallocated into the new one
+  return newval;
+}
+
+static void addVariant(const char *key, tm_len_t keylen, void *p) {
+  variantCtx *ctx = p;
+  uint32_t *ids = TrieMap_Find(ctx->si->variants, key, keylen);
+  if (ids == TRIEMAP_NOTFOUND) {
+    ids = array_new(uint32_t, 1);
+    ids = array_append(ids, ctx->id);
+    TrieMap_Add(ctx->si->variants, (char *)key, keylen, ids, NULL);
+  } else if (array_tail(ids) != ctx->id) {
+    // a variant repeated by the same string was appended to last
+    uint32_t *old = ids;
+    ids = array_append(ids, ctx->id);
+    if (ids != old) {
+      TrieMap_Add(ctx->si->variants, (char *)key, keylen, ids, idsReplace);
+    }
+  }
+}
+
+static void deleteVariant(const char *key, tm_len_t keylen, void *p) {
+  variantCtx *ctx = p;
+  uint32_t *ids = TrieMap_Find(ctx->si->variants, key, keylen);
+  if (ids == TRIEMAP_NOTFOUND) {
+    return;
+  }
+  for (uint32_t i = 0; i < array_len(ids); i++) {
+    if (ids[i] == ctx->id) {
+      array_del_fast(ids, i);
+      break;
+    }
+  }
+  if (!array_len(ids)) {
+    TrieMap_Delete(ctx->si->variants, key, keylen, idsFree);
+  }
+}
+
+void SpellIndex_Add(SpellIndex *si, const rune *str, size_t len) {
+  spellString s = {.str = rm_malloc(len * sizeof(rune)), .len = len};
+  memcpy(s.str, str, len * sizeof(rune));
+  variantCtx ctx = {.si = si};
+  if (array_len(si->freeIds)) {
+    ctx.id = array_pop(si->freeIds);
+    si->strs[ctx.id] = s;
+  } else {
+    ctx.id = array_len(si->strs);
+    si->strs = array_append(si->strs, s);
+  }
+  forEachVariant(str, len, SPELL_INDEX_MAX_DISTANCE, addVariant, &ctx);
+}
+
+void SpellIndex_Delete(SpellIndex *si, const rune *str, size_t len) {
+  // the string is listed under its whole prefix
+  char key[VARIANT_KEY_MAX];
+  size_t plen = MIN(len, SPELL_INDEX_PREFIX_LEN);
+  key[0] = 'v';
+  for (size_t i = 0; i < plen; i++) {
+    ((rune *)(key + 1))[i] = runeFold(str[i]);
+  }
+  uint32_t *ids = TrieMap_Find(si->variants, key, 1 + plen * sizeof(rune));
+  if (ids == TRIEMAP_NOTFOUND) {
+    return;
+  }
+  variantCtx ctx = {.si = si, .id = UINT32_MAX};
+  for (uint32_t i = 0; i < array_len(ids); i++) {
+    spellString *s = &si->strs[ids[i]];
+    if (s->len == len && !memcmp(s->str, str, len * sizeof(rune))) {
+      ctx.id = ids[i];
+      break;
+    }
+  }
+  if (ctx.id == UINT32_MAX) {
+    return;
+  }
+
+  forEachVariant(str, len, SPELL_INDEX_MAX_DISTANCE, deleteVariant, &ctx);
+  rm_free(si->strs[ctx.id].str);
+  si->strs[ctx.id].str = NULL;
+  si->freeIds = array_append(si->freeIds, ctx.id);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  SpellIndex *si;
+  uint32_t *ids;
+} findCtx;
+
+static void collectVariant(const char *key, tm_len_t keylen, void *p) {
+  findCtx *ctx = p;
+  uint32_t *ids = TrieMap_Find(ctx->si->variants, key, keylen);
+  if (ids != TRIEMAP_NOTFOUND) {
+    ctx->ids = array_ensure_append_n(ctx->ids, ids, array_len(ids));
+  }
+}
+
+static int cmpIds(const void *p1, const void *p2) {
+  uint32_t a = *(const uint32_t *)p1, b = *(const uint32_t *)p2;
+  return a < b ? -1 : a > b;
+}
+
+/* The Levenshtein distance of two folded strings, or maxDist + 1 if it is above maxDist */
+static int boundedDistance(const rune *a, size_t alen, const rune *b, size_t blen, int maxDist) {
+  if ((alen > blen ? alen - blen : blen - alen) > maxDist) {
+    return maxDist + 1;
+  }
+  int rows[2][blen + 1];
+  int *prev = rows[0], *cur = rows[1];
+  for (size_t j = 0; j <= blen; j++) {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= alen; i++) {
+    cur[0] = i;
+    int rowMin = cur[0];
+    rune ra = runeFold(a[i - 1]);
+    for (size_t j = 1; j <= blen; j++) {
+      int cost = prev[j - 1] + (ra != runeFold(b[j - 1]));
+      cost = MIN(cost, prev[j] + 1);
+      cur[j] = MIN(cost, cur[j - 1] + 1);
+      rowMin = MIN(rowMin, cur[j]);
+    }
+    if (rowMin > maxDist) {
+      return maxDist + 1;
+    }
+    int *tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+  return prev[blen];
+}
+
+void SpellIndex_Find(SpellIndex *si, const rune *str, size_t len, int maxDist,
+                     SpellIndexCallback cb, void *ctx) {
+  maxDist = MIN(maxDist, SPELL_INDEX_MAX_DISTANCE);
+  findCtx fc = {.si = si, .ids = array_new(uint32_t, 16)};
+  forEachVariant(str, len, maxDist, collectVariant, &fc);
+
+  size_t n = array_len(fc.ids);
+  qsort(fc.ids, n, sizeof(*fc.ids), cmpIds);
+  for (size_t i = 0; i < n; i++) {
+    if (i && fc.ids[i] == fc.ids[i - 1]) {
+      continue;
+    }
+    const spellString *s = &si->strs[fc.ids[i]];
+    int dist = boundedDistance(str, len, s->str, s->len, maxDist);
+    if (dist <= maxDist) {
+      cb(s->str, s->len, dist, ctx);
+    }
+  }
+  array_free(fc.ids);
+}
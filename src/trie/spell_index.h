@@ -0,0 +1,50 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "rune_util.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The maximal edit distance a spell index finds strings within */
+#define SPELL_INDEX_MAX_DISTANCE 2
+
+/* Number of leading runes of a string its deletion variants are made of */
+#define SPELL_INDEX_PREFIX_LEN 7
+
+/* A symmetric delete index of the strings of a trie, to find the strings within an edit distance
+ * of a string without traversing the trie (see Trie_EnableSpellIndex).
+ *
+ * Every string is listed under the deletion variants of its first SPELL_INDEX_PREFIX_LEN folded
+ * runes: the prefix with up to SPELL_INDEX_MAX_DISTANCE runes deleted. A string within distance d
+ * of a string shares a variant with up to d deletions with it, so the strings listed under the
+ * variants of the prefix of a string are the candidates, and the ones whose distance is within d
+ * are found. Only the prefixes are varied, bounding the variants of a string to 29 */
+typedef struct SpellIndex SpellIndex;
+
+SpellIndex *NewSpellIndex();
+
+void SpellIndex_Free(SpellIndex *si);
+
+void SpellIndex_Add(SpellIndex *si, const rune *str, size_t len);
+
+void SpellIndex_Delete(SpellIndex *si, const rune *str, size_t len);
+
+typedef void (*SpellIndexCallback)(const rune *str, size_t len, int dist, void *ctx);
+
+/* Call `cb` with every string of the index within `maxDist` (at most SPELL_INDEX_MAX_DISTANCE) of
+ * `str`, compared folded, in no particular order */
+void SpellIndex_Find(SpellIndex *si, const rune *str, size_t len, int maxDist,
+                     SpellIndexCallback cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
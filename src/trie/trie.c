@@ -93,8 +93,28 @@ TrieNode *__newTrieNode(const rune *str, t_len offset, t_len len, const char *pa
   return n;
 }
 
+/* Resize a node, which currently takes oldSize bytes. Frozen nodes are copied out of their arena
+ * instead */
+static TrieNode *__trieNode_realloc(TrieNode *n, size_t oldSize, size_t size) {
+  if (!__trieNode_isFrozen(n)) {
+    return rm_realloc(n, size);
+  }
+  TrieNode *copy = rm_malloc(size);
+  memcpy(copy, n, MIN(size, oldSize));
+  copy->flags &= ~TRIENODE_FROZEN;
+  return copy;
+}
+
+/* Free a node. Frozen nodes are freed with their arena */
+static void __trieNode_release(TrieNode *n) {
+  if (!__trieNode_isFrozen(n)) {
+    rm_free(n);
+  }
+}
+
 TrieNode *__trieNode_resizeChildren(TrieNode *n, int offset) {
-  n = rm_realloc(n, __trieNode_Sizeof(n->numChildren + offset, n->len));
+  n = __trieNode_realloc(n, __trieNode_Sizeof(n->numChildren, n->len),
+                         __trieNode_Sizeof(n->numChildren + offset, n->len));
   TrieNode **children = __trieNode_children(n);
 
   // stretch or shrink the child key cache array
@@ -125,13 +145,14 @@ TrieNode *__trie_SplitNode(TrieNode *n, t_len offset) {
   TrieNode *newChild = __newTrieNode(n->str, offset, n->len, NULL, 0, n->numChildren, n->score,
                                      __trieNode_isTerminal(n), n->sortMode);
   newChild->maxChildScore = n->maxChildScore;
-  newChild->flags = n->flags;
+  newChild->flags = n->flags & ~TRIENODE_FROZEN;
   newChild->payload = n->payload;
   n->payload = NULL;
   TrieNode **children = __trieNode_children(n);
   TrieNode **newChildren = __trieNode_children(newChild);
   memcpy(newChildren, children, sizeof(TrieNode *) * n->numChildren);
   memcpy(__trieNode_childKey(newChild, 0), __trieNode_childKey(n, 0), n->numChildren * sizeof(rune));
+  size_t oldSize = __trieNode_Sizeof(n->numChildren, n->len);
 
   // reduce the node to be just one child long with no score
   n->numChildren = 1;
@@ -141,7 +162,7 @@ TrieNode *__trie_SplitNode(TrieNode *n, t_len offset) {
   n->flags &= ~(TRIENODE_TERMINAL | TRIENODE_DELETED);
 
   updateScore(n, newChild->score);
-  n = rm_realloc(n, __trieNode_Sizeof(n->numChildren, n->len));
+  n = __trieNode_realloc(n, oldSize, __trieNode_Sizeof(n->numChildren, n->len));
   __trieNode_children(n)[0] = newChild;
   *__trieNode_childKey(n, 0) = newChild->str[0];
 
@@ -168,7 +189,7 @@ TrieNode *__trieNode_MergeWithSingleChild(TrieNode *n, TrieFreeCallback freecb)
   merged->numChildren = ch->numChildren;
   merged->payload = ch->payload;
   ch->payload = NULL;
-  merged->flags = ch->flags;
+  merged->flags = ch->flags & ~TRIENODE_FROZEN;
   TrieNode **children = __trieNode_children(ch);
   TrieNode **newChildren = __trieNode_children(merged);
   memcpy(newChildren, children, sizeof(TrieNode *) * merged->numChildren);
@@ -177,8 +198,8 @@ TrieNode *__trieNode_MergeWithSingleChild(TrieNode *n, TrieFreeCallback freecb)
     triePayload_Free(n->payload, freecb);
     n->payload = NULL;
   }
-  rm_free(n);
-  rm_free(ch);
+  __trieNode_release(n);
+  __trieNode_release(ch);
 
   return merged;
 }
@@ -223,7 +244,8 @@ int TrieNode_Add(TrieNode **np, const rune *str, t_len len, RSPayload *payload,
       n->score = score;
       n->flags |= TRIENODE_TERMINAL;
       TrieNode *newChild = __trieNode_children(n)[0];
-      n = rm_realloc(n, __trieNode_Sizeof(n->numChildren, n->len));
+      size_t size = __trieNode_Sizeof(n->numChildren, n->len);
+      n = __trieNode_realloc(n, size, size);
       if (n->payload != NULL) {
         triePayload_Free(n->payload, freecb);
         n->payload = NULL;
@@ -493,7 +515,52 @@ void TrieNode_Free(TrieNode *n, TrieFreeCallback freecb) {
     n->payload = NULL;
   }
 
-  rm_free(n);
+  __trieNode_release(n);
+}
+
+/* Nodes are packed, but we keep them aligned in the arena like the allocator does */
+#define TRIENODE_ARENA_SIZE(n) \
+  ((__trieNode_Sizeof((n)->numChildren, (n)->len) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static size_t __trieNode_treeSize(TrieNode *n) {
+  size_t size = TRIENODE_ARENA_SIZE(n);
+  for (t_len i = 0; i < n->numChildren; i++) {
+    size += __trieNode_treeSize(__trieNode_children(n)[i]);
+  }
+  return size;
+}
+
+static TrieNode *__trieNode_moveTo(TrieNode *n, char **pos) {
+  TrieNode *moved = (TrieNode *)*pos;
+  *pos += TRIENODE_ARENA_SIZE(n);
+  memcpy(moved, n, __trieNode_Sizeof(n->numChildren, n->len));
+  moved->flags |= TRIENODE_FROZEN;
+  __trieNode_release(n);
+
+  TrieNode **children = __trieNode_children(moved);
+  for (t_len i = 0; i < moved->numChildren; i++) {
+    children[i] = __trieNode_moveTo(children[i], pos);
+  }
+  return moved;
+}
+
+void *TrieNode_Compact(TrieNode **n) {
+  char *arena = rm_malloc(__trieNode_treeSize(*n));
+  char *pos = arena;
+  *n = __trieNode_moveTo(*n, &pos);
+  return arena;
+}
+
+size_t TrieNode_MemUsage(TrieNode *n) {
+  size_t size = __trieNode_isFrozen(n) ? TRIENODE_ARENA_SIZE(n)
+                                       : __trieNode_Sizeof(n->numChildren, n->len);
+  if (n->payload) {
+    size += sizeof(TriePayload) + n->payload->len + 1;
+  }
+  for (t_len i = 0; i < n->numChildren; i++) {
+    size += TrieNode_MemUsage(__trieNode_children(n)[i]);
+  }
+  return size;
 }
 
 static int runecmp(const rune *sa, size_t na, const rune *sb, size_t nb) {
@@ -23,6 +23,8 @@ typedef uint16_t t_len;
 #define TRIE_MAX_PREFIX 100
 #define TRIENODE_TERMINAL 0x1
 #define TRIENODE_DELETED 0x2
+// The node lives in its trie's arena (see TrieNode_Compact), and is not allocated on its own
+#define TRIENODE_FROZEN 0x4
 
 #define TRIENODE_SORTED_NONE 0
 #define TRIENODE_SORTED_SCORE 1
@@ -60,7 +62,7 @@ typedef struct {
   // the number of child nodes
   t_len numChildren;
 
-  uint8_t flags : 2;
+  uint8_t flags : 3;
   TrieSortMode sortMode : 1;
 
   // the node's score. Non termn
@@ -103,6 +105,8 @@ TrieNode *__newTrieNode(const rune *str, t_len offset, t_len len, const char *pa
 
 #define __trieNode_isDeleted(n) (n->flags & TRIENODE_DELETED)
 
+#define __trieNode_isFrozen(n) (n->flags & TRIENODE_FROZEN)
+
 /* Add a child node to the parent node n, with a string str starting at offset
 up until len, and a
 given score */
@@ -142,9 +146,18 @@ void *TrieNode_GetValue(TrieNode *n, const rune *str, t_len len, bool exact);
  * Returns 1 if the node was indeed deleted, 0 otherwise */
 int TrieNode_Delete(TrieNode *n, const rune *str, t_len len, TrieFreeCallback freecb);
 
-/* Free the trie's root and all its children recursively */
+/* Free the trie's root and all its children recursively. Frozen nodes are left to their arena */
 void TrieNode_Free(TrieNode *n, TrieFreeCallback freecb);
 
+/* Move all the nodes of the trie into a single allocation, laid out in depth first order, and
+ * return it. The moved nodes are frozen: changing them copies them out of the arena, which stays
+ * valid until the trie is freed or compacted again. Payloads are not moved */
+void *TrieNode_Compact(TrieNode **n);
+
+/* The number of bytes held by the nodes of the tree and their payloads, walking all of them.
+ * Frozen nodes are counted at their size in the arena of the trie */
+size_t TrieNode_MemUsage(TrieNode *n);
+
 /* trie iterator stack node. for internal use only */
 typedef struct {
   int state;
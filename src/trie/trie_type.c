@@ -13,7 +13,9 @@
 #include "rune_util.h"
 #include "trie_type.h"
 #include "rmalloc.h"
+#include "alloc_stats.h"
 #include "rdb.h"
+#include "util/dict.h"
 
 #include <math.h>
 #include <sys/param.h>
@@ -21,14 +23,23 @@
 #include <string.h>
 #include <limits.h>
 
+static void trieTopK_Update(Trie *t, const rune *runes, size_t len);
+
 Trie *NewTrie(TrieFreeCallback freecb, TrieSortMode sortMode) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TRIE);
   Trie *tree = rm_malloc(sizeof(Trie));
   rune *rs = strToRunes("", 0);
   tree->root = __newTrieNode(rs, 0, 0, NULL, 0, 0, 0, 0, sortMode);
   tree->size = 0;
   tree->freecb = freecb;
   tree->sortMode = sortMode;
+  tree->arena = NULL;
+  tree->uncompacted = 0;
+  tree->deleted = 0;
+  tree->topk = NULL;
+  tree->spell = NULL;
   rm_free(rs);
+  AllocStats_SetTag(prevTag);
   return tree;
 }
 
@@ -54,13 +65,33 @@ int Trie_InsertStringBuffer(Trie *t, const char *s, size_t len, double score, in
 int Trie_InsertRune(Trie *t, const rune *runes, size_t len, double score, int incr,
                     RSPayload *payload) {
   int rc = 0;                              
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TRIE);
   if (runes && len && len < TRIE_INITIAL_STRING_LEN) {
     rc = TrieNode_Add(&t->root, runes, len, payload, (float)score, incr ? ADD_INCR : ADD_REPLACE, t->freecb);
+    if (t->topk) {
+      trieTopK_Update(t, runes, len);
+    }
+    if (rc && t->spell) {
+      SpellIndex_Add(t->spell, runes, len);
+    }
     t->size += rc;
+    t->uncompacted += rc;
+    if (t->uncompacted >= TRIE_COMPACT_MIN_INSERTS && t->uncompacted * 2 >= t->size) {
+      Trie_Compact(t);
+    }
   }
+  AllocStats_SetTag(prevTag);
   return rc;
 }
 
+void Trie_Compact(Trie *t) {
+  void *arena = TrieNode_Compact(&t->root);
+  rm_free(t->arena);
+  t->arena = arena;
+  t->uncompacted = 0;
+  t->deleted = 0;
+}
+
 void *Trie_GetValueStringBuffer(Trie *t, const char *s, size_t len, bool exact) {
   if (len > TRIE_INITIAL_STRING_LEN * sizeof(rune)) {
     return 0;
@@ -88,8 +119,20 @@ int Trie_Delete(Trie *t, const char *s, size_t len) {
 }
 
 int Trie_DeleteRunes(Trie *t, const rune *runes, size_t len) {
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TRIE);
   int rc = TrieNode_Delete(t->root, runes, len, t->freecb);
+  if (rc && t->topk) {
+    trieTopK_Update(t, runes, len);
+  }
+  if (rc && t->spell) {
+    SpellIndex_Delete(t->spell, runes, len);
+  }
   t->size -= rc;
+  t->deleted += rc;
+  if (t->deleted >= TRIE_COMPACT_MIN_DELETES && t->deleted >= t->size) {
+    Trie_Compact(t);
+  }
+  AllocStats_SetTag(prevTag);
   return rc;
 }
 
@@ -131,24 +174,13 @@ TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist,
   return it;
 }
 
-Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
-                    int trim, int optimize) {
-
-  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
-    return NULL;
-  }
-  size_t rlen;
-  rune *runes = strToFoldedRunes(s, &rlen);
-  // make sure query length does not overflow
-  if (!runes || rlen >= TRIE_MAX_PREFIX) {
-    rm_free(runes);
-    return NULL;
-  }
-
+/* Search the trie for the top `num` entries, returning them by descending score */
+static Vector *trieSearchHeap(Trie *tree, const rune *runes, size_t rlen, size_t len, size_t num,
+                              int maxDist, int prefixMode) {
   heap_t *pq = rm_malloc(heap_sizeof(num));
   heap_init(pq, cmpEntries, NULL, num);
 
-  DFAFilter *fc = NewDFAFilter(runes, rlen, maxDist, prefixMode);
+  DFAFilter *fc = NewDFAFilter((rune *)runes, rlen, maxDist, prefixMode);
 
   TrieIterator *it = TrieNode_Iterate(tree->root, FilterFunc, StackPop, fc);
   // TrieIterator *it = TrieNode_Iterate(tree->root,NULL, NULL, NULL);
@@ -232,6 +264,204 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
     Vector_Put(ret, n - i - 1, h);
   }
 
+  TrieIterator_Free(it);
+  heap_free(pq);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+/* The cached completions of a prefix, by descending score. They own their strings and payloads */
+typedef struct {
+  size_t n;
+  TrieSearchResult res[TRIE_TOPK_SIZE];
+} trieTopK;
+
+static void trieTopK_FreeResult(TrieSearchResult *e) {
+  rm_free(e->str);
+  rm_free(e->payload);
+}
+
+static void trieTopK_Free(void *privdata, void *p) {
+  trieTopK *tk = p;
+  for (size_t i = 0; i < tk->n; i++) {
+    trieTopK_FreeResult(&tk->res[i]);
+  }
+  rm_free(tk);
+}
+
+static dictType topkDictType = {0};
+
+static void trieTopK_SetPayload(TrieSearchResult *e, const char *data, size_t len) {
+  rm_free(e->payload);
+  e->payload = NULL;
+  e->plen = 0;
+  if (data) {
+    e->payload = rm_malloc(len + 1);
+    memcpy(e->payload, data, len);
+    e->payload[len] = '\0';
+    e->plen = len;
+  }
+}
+
+/* The score of an entry in the results of a prefix search without a distance, as trieSearchHeap
+ * computes it. `prefix` holds the folded runes of the query, `len` is its length in bytes */
+static float trieTopK_Score(const rune *prefix, size_t plen, size_t len, const rune *str,
+                            size_t slen, float score) {
+  float ret = slen > 0 && slen == plen && memcmp(prefix, str, slen) == 0 ? (float)INT_MAX : score;
+  return ret / sqrt(1 + (slen >= len ? slen - len : len - slen));
+}
+
+/* Move a cached completion whose score changed to its place */
+static void trieTopK_Sort(trieTopK *tk, size_t pos) {
+  TrieSearchResult e = tk->res[pos];
+  for (; pos > 0 && tk->res[pos - 1].score < e.score; pos--) {
+    tk->res[pos] = tk->res[pos - 1];
+  }
+  for (; pos + 1 < tk->n && tk->res[pos + 1].score > e.score; pos++) {
+    tk->res[pos] = tk->res[pos + 1];
+  }
+  tk->res[pos] = e;
+}
+
+/* Return the top `num` completions of a prefix from the cache, caching them first if they are not.
+ * Returns NULL if the prefix is not cached as its folded form has another length */
+static Vector *trieTopK_Search(Trie *t, const rune *runes, size_t rlen, size_t len, size_t num) {
+  size_t klen;
+  char *key = runesToStr(runes, rlen, &klen);
+  if (klen != len) {
+    rm_free(key);
+    return NULL;
+  }
+  if (!t->topk) {
+    if (!topkDictType.valDestructor) {
+      topkDictType = dictTypeHeapStrings;
+      topkDictType.valDestructor = trieTopK_Free;
+    }
+    t->topk = dictCreate(&topkDictType, NULL);
+  }
+
+  trieTopK *tk = dictFetchValue(t->topk, key);
+  if (!tk) {
+    Vector *res = trieSearchHeap(t, runes, rlen, len, TRIE_TOPK_SIZE, 0, 1);
+    tk = rm_calloc(1, sizeof(*tk));
+    tk->n = Vector_Size(res);
+    for (size_t i = 0; i < tk->n; i++) {
+      TrieSearchResult *h;
+      Vector_Get(res, i, &h);
+      tk->res[i] = (TrieSearchResult){.str = h->str, .len = h->len, .score = h->score};
+      trieTopK_SetPayload(&tk->res[i], h->payload, h->plen);
+      rm_free(h);
+    }
+    Vector_Free(res);
+    if (dictSize(t->topk) >= TRIE_TOPK_MAX_ENTRIES) {
+      dictEmpty(t->topk, NULL);
+    }
+    dictAdd(t->topk, key, tk);
+  }
+  rm_free(key);
+
+  size_t n = MIN(num, tk->n);
+  Vector *ret = NewVector(TrieSearchResult *, n);
+  for (size_t i = 0; i < n; i++) {
+    TrieSearchResult *e = rm_malloc(sizeof(*e));
+    *e = tk->res[i];
+    e->str = rm_strndup(tk->res[i].str, tk->res[i].len);
+    Vector_Put(ret, i, e);
+  }
+  return ret;
+}
+
+/* Update the cached completions of the prefixes of a string which was inserted or deleted. A list
+ * which may miss a completion afterwards - a full list which a string leaves or drops in - is
+ * removed from the cache, and is searched again when it is next used */
+static void trieTopK_Update(Trie *t, const rune *runes, size_t len) {
+  TrieNode *node = TrieNode_Get(t->root, runes, len, true, NULL);
+  if (node && !__trieNode_isTerminal(node)) {
+    node = NULL;
+  }
+  size_t slen;
+  char *str = runesToStr(runes, len, &slen);
+  rune prefix[TRIE_TOPK_MAX_PREFIX];
+  for (size_t k = 0; k <= MIN(len, TRIE_TOPK_MAX_PREFIX); k++) {
+    if (k) {
+      prefix[k - 1] = runeFold(runes[k - 1]);
+    }
+    size_t qlen;
+    char *key = runesToStr(prefix, k, &qlen);
+    trieTopK *tk = dictFetchValue(t->topk, key);
+    if (!tk) {
+      rm_free(key);
+      continue;
+    }
+    size_t pos = 0;
+    while (pos < tk->n && (tk->res[pos].len != slen || memcmp(tk->res[pos].str, str, slen))) {
+      pos++;
+    }
+    bool full = tk->n == TRIE_TOPK_SIZE;
+
+    if (!node) {
+      if (pos < tk->n && full) {
+        dictDelete(t->topk, key);
+      } else if (pos < tk->n) {
+        trieTopK_FreeResult(&tk->res[pos]);
+        memmove(&tk->res[pos], &tk->res[pos + 1], (--tk->n - pos) * sizeof(*tk->res));
+      }
+      rm_free(key);
+      continue;
+    }
+
+    float score = trieTopK_Score(prefix, k, qlen, runes, len, node->score);
+    if (pos == tk->n) {
+      if (full && score <= tk->res[tk->n - 1].score) {
+        rm_free(key);
+        continue;
+      }
+      if (full) {
+        trieTopK_FreeResult(&tk->res[--tk->n]);
+      }
+      pos = tk->n++;
+      tk->res[pos] = (TrieSearchResult){.str = rm_strndup(str, slen), .len = slen};
+    } else if (full && score < tk->res[pos].score) {
+      // a completion which is not cached may rank above it now
+      dictDelete(t->topk, key);
+      rm_free(key);
+      continue;
+    }
+    tk->res[pos].score = score;
+    trieTopK_SetPayload(&tk->res[pos], node->payload ? node->payload->data : NULL,
+                        node->payload ? node->payload->len : 0);
+    trieTopK_Sort(tk, pos);
+    rm_free(key);
+  }
+  rm_free(str);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
+                    int trim, int optimize) {
+
+  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
+    return NULL;
+  }
+  size_t rlen;
+  rune *runes = strToFoldedRunes(s, &rlen);
+  // make sure query length does not overflow
+  if (!runes || rlen >= TRIE_MAX_PREFIX) {
+    rm_free(runes);
+    return NULL;
+  }
+
+  Vector *ret = NULL;
+  if (!maxDist && prefixMode && rlen <= TRIE_TOPK_MAX_PREFIX && num <= TRIE_TOPK_SIZE) {
+    ret = trieTopK_Search(tree, runes, rlen, len, num);
+  }
+  if (!ret) {
+    ret = trieSearchHeap(tree, runes, rlen, len, num, maxDist, prefixMode);
+  }
+  size_t n = Vector_Size(ret);
+
   // trim the results to remove irrelevant results
   if (trim) {
     float maxScore = 0;
@@ -256,12 +486,25 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
   }
 
   rm_free(runes);
-  TrieIterator_Free(it);
-  heap_free(pq);
 
   return ret;
 }
 
+void Trie_EnableSpellIndex(Trie *t) {
+  if (t->spell) {
+    return;
+  }
+  t->spell = NewSpellIndex();
+  TrieIterator *it = TrieNode_Iterate(t->root, NULL, NULL, NULL);
+  rune *rstr;
+  t_len len;
+  float score;
+  while (TrieIterator_Next(it, &rstr, &len, NULL, &score, NULL)) {
+    SpellIndex_Add(t->spell, rstr, len);
+  }
+  TrieIterator_Free(it);
+}
+
 int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score) {
   if (t->size == 0) {
     return 0;
@@ -322,6 +565,10 @@ void *TrieType_GenericLoad(RedisModuleIO *rdb, int loadPayloads) {
     RedisModule_Free(str);
     if (payload.data != NULL) RedisModule_Free(payload.data);
   }
+  // The whole trie was just built, freeze it at once
+  if (tree->uncompacted) {
+    Trie_Compact(tree);
+  }
   // TrieNode_Print(tree->root, 0, 0);
   return tree;
 
@@ -384,11 +631,20 @@ void TrieType_Digest(RedisModuleDigest *digest, void *value) {
 
 void TrieType_Free(void *value) {
   Trie *tree = value;
+  AllocTag prevTag = AllocStats_SetTag(ALLOC_TAG_TRIE);
   if (tree->root) {
     TrieNode_Free(tree->root, tree->freecb);
   }
+  rm_free(tree->arena);
+  if (tree->topk) {
+    dictRelease(tree->topk);
+  }
+  if (tree->spell) {
+    SpellIndex_Free(tree->spell);
+  }
 
   rm_free(tree);
+  AllocStats_SetTag(prevTag);
 }
 
 size_t TrieType_MemUsage(const void *value) {
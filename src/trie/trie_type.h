@@ -11,6 +11,7 @@
 
 #include "trie.h"
 #include "levenshtein.h"
+#include "spell_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,16 @@ typedef struct {
   size_t size;
   TrieFreeCallback freecb;
   TrieSortMode sortMode;
+  // the frozen nodes of the trie, see Trie_Compact
+  void *arena;
+  // entries inserted since the last compaction, which live outside the arena
+  size_t uncompacted;
+  // entries deleted since the last compaction, whose nodes are still held by the arena
+  size_t deleted;
+  // the top completions of the short prefixes searched, see Trie_Search. NULL until one is
+  struct dict *topk;
+  // the strings by their deletion variants, see Trie_EnableSpellIndex. NULL unless enabled
+  SpellIndex *spell;
 } Trie;
 
 typedef struct {
@@ -38,6 +49,23 @@ typedef struct {
 
 #define SCORE_TRIM_FACTOR 10.0
 
+/* Prefix searches of up to TRIE_TOPK_MAX_PREFIX runes, without a distance, cache the top
+ * TRIE_TOPK_SIZE completions of their prefix. Inserts and deletes update the cached lists of the
+ * prefixes of their string, so the lists hold what a search would return, and a search for a short
+ * prefix returns them without traversing the trie. A trie caches up to TRIE_TOPK_MAX_ENTRIES
+ * prefixes, and starts over once it is full */
+#define TRIE_TOPK_MAX_PREFIX 3
+#define TRIE_TOPK_SIZE 10
+#define TRIE_TOPK_MAX_ENTRIES 4096
+
+/* Insertions compact the trie once they added at least this many entries, and as many entries as
+ * were compacted before */
+#define TRIE_COMPACT_MIN_INSERTS 1024
+
+/* Deletions compact the trie once they removed at least this many entries, and as many entries as
+ * the trie still holds, so that the arena does not keep mostly dead nodes */
+#define TRIE_COMPACT_MIN_DELETES 1024
+
 /* Creates a new Trie.
  * Trie can be sorted by lexicographic order using `Trie_Sort_Lex` or by
  * score using `Trie_Sort_Score.                            */
@@ -54,11 +82,18 @@ int Trie_InsertRune(Trie *t, const rune *s, size_t len, double score, int incr,
 void *Trie_GetValueStringBuffer(Trie *t, const char *s, size_t len, bool exact);
 void *Trie_GetValueRune(Trie *t, const rune *runes, size_t len, bool exact);
 
+/* Move all the nodes of the trie into a single allocation. Entries added afterwards are allocated
+ * on their own, until they are merged into the arena by the next compaction. Invalidates iterators */
+void Trie_Compact(Trie *t);
+
 /* Delete the string from the trie. Return 1 if the node was found and deleted, 0 otherwise */
 int Trie_Delete(Trie *t, const char *s, size_t len);
 int Trie_DeleteRunes(Trie *t, const rune *runes, size_t len);
 
 void TrieSearchResult_Free(TrieSearchResult *e);
+/* Search for the top `num` entries matching `s`. Returns the results sorted by descending score,
+ * which the caller frees along with the vector. Their payloads point into the trie, or into its
+ * cached completions (see TRIE_TOPK_SIZE), and are valid until it is changed */
 Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
                     int trim, int optimize);
 
@@ -67,6 +102,11 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
  * Otherwise we return an iterator to all strings within maxDist Levenshtein distance */
 TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist, int prefixMode);
 
+/* Index the strings of the trie by their deletion variants, to find the strings within an edit
+ * distance of up to SPELL_INDEX_MAX_DISTANCE without traversing the trie (see SpellIndex). The
+ * index is kept up to date by inserts and deletes from then on. Does nothing if it is indexed */
+void Trie_EnableSpellIndex(Trie *t);
+
 /* Get a random key from the trie, and put the node's score in the score pointer. Returns 0 if the
  * trie is empty and we cannot do that */
 int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score);
@@ -0,0 +1,130 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_BITPACK_H
+#define RS_BITPACK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The number of bytes taken by n packed integers of `width` bits each */
+#define BITPACK_LEN(n, width) (((n) * (width) + 7) / 8)
+
+/* The number of bits needed to hold the largest of n integers */
+static inline uint8_t BitPack_Width(const uint32_t *in, size_t n) {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < n; ++i) {
+    mask |= in[i];
+  }
+  return mask ? 32 - __builtin_clz(mask) : 0;
+}
+
+/* Pack n integers of `width` bits each into `out`, least significant bits first. Bits above
+ * `width` must be clear. Returns the number of bytes written */
+static inline size_t BitPack_Pack(const uint32_t *in, size_t n, uint8_t width, uint8_t *out) {
+  uint8_t *p = out;
+  uint64_t acc = 0;
+  unsigned nbits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    acc |= (uint64_t)in[i] << nbits;
+    for (nbits += width; nbits >= 8; nbits -= 8) {
+      *p++ = acc & 0xFF;
+      acc >>= 8;
+    }
+  }
+  if (nbits) {
+    *p++ = acc & 0xFF;
+  }
+  return p - out;
+}
+
+/* Unpack n integers of `width` bits each from `in`. Returns the number of bytes consumed */
+static inline size_t BitPack_Unpack(const uint8_t *in, size_t n, uint8_t width, uint32_t *out) {
+  const uint8_t *p = in;
+  const uint64_t mask = (1ULL << width) - 1;
+  uint64_t acc = 0;
+  unsigned nbits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    for (; nbits < width; nbits += 8) {
+      acc |= (uint64_t)*p++ << nbits;
+    }
+    out[i] = acc & mask;
+    acc >>= width;
+    nbits -= width;
+  }
+  return p - in;
+}
+
+/* The number of bits needed to hold the largest of n 64 bit integers */
+static inline uint8_t BitPack64_Width(const uint64_t *in, size_t n) {
+  uint64_t mask = 0;
+  for (size_t i = 0; i < n; ++i) {
+    mask |= in[i];
+  }
+  return mask ? 64 - __builtin_clzll(mask) : 0;
+}
+
+/* Pack n 64 bit integers of `width` bits each, as BitPack_Pack. Integers wider than 32 bits are
+ * written in two parts, so that the accumulator never overflows */
+static inline size_t BitPack64_Pack(const uint64_t *in, size_t n, uint8_t width, uint8_t *out) {
+  const uint8_t lo = width < 32 ? width : 32, hi = width - lo;
+  uint8_t *p = out;
+  uint64_t acc = 0;
+  unsigned nbits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    acc |= (in[i] & 0xFFFFFFFF) << nbits;
+    for (nbits += lo; nbits >= 8; nbits -= 8) {
+      *p++ = acc & 0xFF;
+      acc >>= 8;
+    }
+    if (hi) {
+      acc |= (in[i] >> 32) << nbits;
+      for (nbits += hi; nbits >= 8; nbits -= 8) {
+        *p++ = acc & 0xFF;
+        acc >>= 8;
+      }
+    }
+  }
+  if (nbits) {
+    *p++ = acc & 0xFF;
+  }
+  return p - out;
+}
+
+/* Unpack n 64 bit integers of `width` bits each from `in`. Returns the number of bytes consumed */
+static inline size_t BitPack64_Unpack(const uint8_t *in, size_t n, uint8_t width, uint64_t *out) {
+  const uint8_t lo = width < 32 ? width : 32, hi = width - lo;
+  const uint64_t loMask = (1ULL << lo) - 1, hiMask = (1ULL << hi) - 1;
+  const uint8_t *p = in;
+  uint64_t acc = 0;
+  unsigned nbits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    for (; nbits < lo; nbits += 8) {
+      acc |= (uint64_t)*p++ << nbits;
+    }
+    out[i] = acc & loMask;
+    acc >>= lo;
+    nbits -= lo;
+    if (hi) {
+      for (; nbits < hi; nbits += 8) {
+        acc |= (uint64_t)*p++ << nbits;
+      }
+      out[i] |= (acc & hiMask) << 32;
+      acc >>= hi;
+      nbits -= hi;
+    }
+  }
+  return p - in;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
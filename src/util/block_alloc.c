@@ -52,6 +52,7 @@ void BlkAlloc_FreeAll(BlkAlloc *blocks, BlkAllocCleaner cleaner, void *arg, size
 void BlkAlloc_Clear(BlkAlloc *blocks, BlkAllocCleaner cleaner, void *arg, size_t elemSize) {
   freeCommon(blocks, cleaner, arg, elemSize, 1);
   blocks->root = blocks->last = NULL;
+  blocks->size = 0;
 }
 
 static BlkAllocBlock *getNewBlock(BlkAlloc *alloc, size_t blockSize) {
@@ -87,6 +88,7 @@ static BlkAllocBlock *getNewBlock(BlkAlloc *alloc, size_t blockSize) {
 
   block->numUsed = 0;
   block->next = NULL;
+  alloc->size += sizeof(*block) + block->capacity;
   // printf("%p: getNewBlock END\n", alloc);
   return block;
 }
@@ -96,7 +98,7 @@ void *BlkAlloc_Alloc(BlkAlloc *blocks, size_t elemSize, size_t blockSize) {
   if (!blocks->root) {
     blocks->root = blocks->last = getNewBlock(blocks, blockSize);
 
-  } else if (blocks->last->numUsed + elemSize > blockSize) {
+  } else if (blocks->last->numUsed + elemSize > blocks->last->capacity) {
     // Allocate a new element
     BlkAllocBlock *newBlock = getNewBlock(blocks, blockSize);
     blocks->last->next = newBlock;
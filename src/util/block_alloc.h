@@ -26,6 +26,9 @@ typedef struct BlkAlloc {
 
   // Available blocks - used when recycling the allocator
   BlkAllocBlock *avail;
+
+  // The bytes of the blocks in use, from root to last
+  size_t size;
 } BlkAlloc;
 
 // Initialize a block allocator
@@ -33,6 +36,7 @@ static inline void BlkAlloc_Init(BlkAlloc *alloc) {
   alloc->root = NULL;
   alloc->last = NULL;
   alloc->avail = NULL;
+  alloc->size = 0;
 }
 
 /**
@@ -0,0 +1,62 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "coarse_clock.h"
+#include "redismodule.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+uint64_t coarseClock_g = 0;
+
+static pthread_t coarseClockThread;
+static bool coarseClockStarted = false;
+static bool coarseClockStop = false;
+static bool atforkRegistered = false;
+
+static void *coarseClock_Run(void *arg) {
+  struct timespec interval = {.tv_sec = 0, .tv_nsec = COARSE_CLOCK_RESOLUTION_NS};
+  while (!__atomic_load_n(&coarseClockStop, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&coarseClock_g, CoarseClock_ReadNS(), __ATOMIC_RELAXED);
+    nanosleep(&interval, NULL);
+  }
+  return NULL;
+}
+
+// A forked child does not have the thread, so it would see the time stand still
+static void coarseClock_AtForkChild(void) {
+  __atomic_store_n(&coarseClock_g, 0, __ATOMIC_RELAXED);
+  coarseClockStarted = false;
+}
+
+int CoarseClock_Start(void) {
+  if (coarseClockStarted) {
+    return REDISMODULE_OK;
+  }
+  if (!atforkRegistered) {
+    pthread_atfork(NULL, NULL, coarseClock_AtForkChild);
+    atforkRegistered = true;
+  }
+  coarseClockStop = false;
+  // readers see a valid time as soon as the clock is set
+  __atomic_store_n(&coarseClock_g, CoarseClock_ReadNS(), __ATOMIC_RELAXED);
+  if (pthread_create(&coarseClockThread, NULL, coarseClock_Run, NULL)) {
+    __atomic_store_n(&coarseClock_g, 0, __ATOMIC_RELAXED);
+    return REDISMODULE_ERR;
+  }
+  coarseClockStarted = true;
+  return REDISMODULE_OK;
+}
+
+void CoarseClock_Stop(void) {
+  if (!coarseClockStarted) {
+    return;
+  }
+  __atomic_store_n(&coarseClockStop, true, __ATOMIC_RELAXED);
+  pthread_join(coarseClockThread, NULL);
+  __atomic_store_n(&coarseClock_g, 0, __ATOMIC_RELAXED);
+  coarseClockStarted = false;
+}
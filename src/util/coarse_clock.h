@@ -0,0 +1,59 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_COARSE_CLOCK_H
+#define RS_COARSE_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__FreeBSD__)
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
+/* A process wide monotonic clock, in nanoseconds, which a background thread refreshes every
+ * COARSE_CLOCK_RESOLUTION_NS. Reading it is a single load, for the checks of the hot loops which
+ * can do with its resolution, such as the query timeouts.
+ *
+ * It reads the same clock as clock_gettime(CLOCK_MONOTONIC_RAW), and lags it by up to a
+ * resolution when the thread runs. Until the thread is started, and in the forked children which
+ * do not have it, the clock is read on every call instead */
+#define COARSE_CLOCK_RESOLUTION_NS 1000000
+
+// The last time the thread read, 0 while there is no thread
+extern uint64_t coarseClock_g;
+
+static inline uint64_t CoarseClock_ReadNS(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static inline int CoarseClock_IsRunning(void) {
+  return __atomic_load_n(&coarseClock_g, __ATOMIC_RELAXED) != 0;
+}
+
+static inline uint64_t CoarseClock_NowNS(void) {
+  uint64_t now = __atomic_load_n(&coarseClock_g, __ATOMIC_RELAXED);
+  return now ? now : CoarseClock_ReadNS();
+}
+
+/* Start the thread refreshing the clock. Returns REDISMODULE_ERR if it could not be created, in
+ * which case the clock is read on every call */
+int CoarseClock_Start(void);
+
+/* Stop the thread, the clock is read on every call from now on */
+void CoarseClock_Stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_COARSE_CLOCK_H
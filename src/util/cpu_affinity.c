@@ -0,0 +1,153 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "cpu_affinity.h"
+#include "redismodule.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// No CPU number above it is accepted
+#define CPU_LIST_MAX_CPU 4095
+
+static bool parseCPU(const char **s, long *cpu) {
+  if (!isdigit(**s)) {
+    return false;
+  }
+  char *end;
+  *cpu = strtol(*s, &end, 10);
+  *s = end;
+  return *cpu <= CPU_LIST_MAX_CPU;
+}
+
+arrayof(int) CPUList_Parse(const char *s) {
+  arrayof(int) cpus = array_new(int, 8);
+  while (*s) {
+    long first, last;
+    if (!parseCPU(&s, &first)) {
+      goto error;
+    }
+    last = first;
+    if (*s == '-') {
+      ++s;
+      if (!parseCPU(&s, &last) || last < first) {
+        goto error;
+      }
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      array_append(cpus, (int)cpu);
+    }
+    if (*s == ',') {
+      ++s;
+      if (!*s) {
+        goto error;
+      }
+    } else if (*s && *s != '\n') {
+      goto error;
+    } else {
+      break;
+    }
+  }
+  if (array_len(cpus)) {
+    return cpus;
+  }
+
+error:
+  array_free(cpus);
+  return NULL;
+}
+
+bool CPUList_IsValidSetting(const char *setting) {
+  if (!*setting || !strcasecmp(setting, CPU_LIST_NUMA_LOCAL)) {
+    return true;
+  }
+  arrayof(int) cpus = CPUList_Parse(setting);
+  if (!cpus) {
+    return false;
+  }
+  array_free(cpus);
+  return true;
+}
+
+static arrayof(int) localNodeCPUs(void) {
+#if defined(__linux__)
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+    return NULL;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return NULL;
+  }
+  char buf[1024];
+  arrayof(int) cpus = fgets(buf, sizeof(buf), f) ? CPUList_Parse(buf) : NULL;
+  fclose(f);
+  return cpus;
+#else
+  return NULL;
+#endif
+}
+
+arrayof(int) CPUList_FromSetting(const char *setting) {
+  if (!setting || !*setting) {
+    return NULL;
+  }
+  if (!strcasecmp(setting, CPU_LIST_NUMA_LOCAL)) {
+    return localNodeCPUs();
+  }
+  return CPUList_Parse(setting);
+}
+
+int CPUList_PinCurrentThread(arrayof(int) cpus) {
+#if defined(__linux__)
+  int maxcpu = 0;
+  for (uint32_t i = 0; i < array_len(cpus); ++i) {
+    maxcpu = MAX(maxcpu, cpus[i]);
+  }
+  cpu_set_t *set = CPU_ALLOC(maxcpu + 1);
+  size_t size = CPU_ALLOC_SIZE(maxcpu + 1);
+  CPU_ZERO_S(size, set);
+  for (uint32_t i = 0; i < array_len(cpus); ++i) {
+    CPU_SET_S(cpus[i], size, set);
+  }
+  int rc = pthread_setaffinity_np(pthread_self(), size, set);
+  CPU_FREE(set);
+  return rc == 0 ? REDISMODULE_OK : REDISMODULE_ERR;
+#else
+  return REDISMODULE_ERR;
+#endif
+}
+
+void CPUList_Format(arrayof(int) cpus, char *buf, size_t len) {
+  size_t n = 0;
+  buf[0] = '\0';
+  for (uint32_t i = 0; i < array_len(cpus) && n < len; ++i) {
+    // Collapse the consecutive CPUs to a range
+    uint32_t j = i;
+    while (j + 1 < array_len(cpus) && cpus[j + 1] == cpus[j] + 1) {
+      ++j;
+    }
+    const char *sep = i ? "," : "";
+    if (j > i + 1) {
+      n += snprintf(buf + n, len - n, "%s%d-%d", sep, cpus[i], cpus[j]);
+      i = j;
+    } else {
+      n += snprintf(buf + n, len - n, "%s%d", sep, cpus[i]);
+    }
+  }
+}
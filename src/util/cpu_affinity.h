@@ -0,0 +1,43 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_CPU_AFFINITY_H
+#define RS_CPU_AFFINITY_H
+
+#include "util/arr.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The CPU list setting standing for the CPUs of the NUMA node the module is loaded on */
+#define CPU_LIST_NUMA_LOCAL "NUMA_LOCAL"
+
+/* Parse a list of CPUs in the cpuset format of Linux: CPU numbers and ranges separated by commas,
+ * e.g. "0-3,8,10-11". Returns NULL if it is malformed or empty */
+arrayof(int) CPUList_Parse(const char *s);
+
+/* Whether a CPU list setting is valid: a list of CPUs, NUMA_LOCAL, or empty for no list */
+bool CPUList_IsValidSetting(const char *setting);
+
+/* The CPUs of a CPU list setting. NUMA_LOCAL stands for the CPUs of the NUMA node the calling
+ * thread runs on, those where the memory it allocates is local. Returns NULL for no list, or if the
+ * node cannot be told */
+arrayof(int) CPUList_FromSetting(const char *setting);
+
+/* Restrict the calling thread to run on the given CPUs. Returns REDISMODULE_ERR if it cannot be */
+int CPUList_PinCurrentThread(arrayof(int) cpus);
+
+/* Format a list of CPUs back to the cpuset format, in a buffer of `len` bytes */
+void CPUList_Format(arrayof(int) cpus, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_CPU_AFFINITY_H
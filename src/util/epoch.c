@@ -0,0 +1,149 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "epoch.h"
+#include "arr.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t epoch;
+  size_t count;
+} epochPin;
+
+typedef struct {
+  uint64_t epoch;
+  void *ptr;
+  EpochFreeFunc freeFn;
+} epochRetired;
+
+struct EpochDomain {
+  pthread_mutex_t lock;
+  // bumped by every retirement, so the readers pinned after it get a later epoch
+  uint64_t epoch;
+  arrayof(epochPin) pins;          // by increasing epoch
+  arrayof(epochRetired) retired;   // by increasing epoch
+  size_t numPins;
+  // set once the owner released the domain
+  bool released;
+};
+
+EpochDomain *EpochDomain_New(void) {
+  EpochDomain *d = rm_calloc(1, sizeof(*d));
+  pthread_mutex_init(&d->lock, NULL);
+  d->pins = array_new(epochPin, 4);
+  d->retired = array_new(epochRetired, 4);
+  return d;
+}
+
+/* Take out the retired structures no pin protects. Called with the domain locked, they are freed
+ * after it is unlocked */
+static epochRetired *takeReclaimable(EpochDomain *d, uint32_t *n) {
+  uint32_t len = array_len(d->retired);
+  uint32_t k = len;
+  if (d->numPins) {
+    uint64_t oldest = d->pins[0].epoch;
+    for (k = 0; k < len && d->retired[k].epoch < oldest; ++k) {
+    }
+  }
+  *n = k;
+  if (!k) {
+    return NULL;
+  }
+  epochRetired *out = rm_malloc(k * sizeof(*out));
+  memcpy(out, d->retired, k * sizeof(*out));
+  memmove(d->retired, d->retired + k, (len - k) * sizeof(*d->retired));
+  d->retired = array_trimm_len(d->retired, k);
+  return out;
+}
+
+static void freeReclaimed(epochRetired *r, uint32_t n) {
+  for (uint32_t i = 0; i < n; ++i) {
+    r[i].freeFn(r[i].ptr);
+  }
+  rm_free(r);
+}
+
+static void domainFree(EpochDomain *d) {
+  pthread_mutex_destroy(&d->lock);
+  array_free(d->pins);
+  array_free(d->retired);
+  rm_free(d);
+}
+
+void EpochDomain_Release(EpochDomain *d) {
+  pthread_mutex_lock(&d->lock);
+  d->released = true;
+  bool last = d->numPins == 0;
+  uint32_t n = 0;
+  epochRetired *r = last ? takeReclaimable(d, &n) : NULL;
+  pthread_mutex_unlock(&d->lock);
+
+  freeReclaimed(r, n);
+  if (last) {
+    domainFree(d);
+  }
+}
+
+uint64_t EpochDomain_Pin(EpochDomain *d) {
+  pthread_mutex_lock(&d->lock);
+  uint64_t epoch = d->epoch;
+  uint32_t len = array_len(d->pins);
+  if (len && d->pins[len - 1].epoch == epoch) {
+    d->pins[len - 1].count++;
+  } else {
+    epochPin pin = {.epoch = epoch, .count = 1};
+    d->pins = array_append(d->pins, pin);
+  }
+  d->numPins++;
+  pthread_mutex_unlock(&d->lock);
+  return epoch;
+}
+
+void EpochDomain_Unpin(EpochDomain *d, uint64_t epoch) {
+  pthread_mutex_lock(&d->lock);
+  uint32_t i = 0, len = array_len(d->pins);
+  while (i < len && d->pins[i].epoch != epoch) {
+    ++i;
+  }
+  RS_LOG_ASSERT(i < len, "unpinned an epoch which is not pinned");
+  if (--d->pins[i].count == 0) {
+    d->pins = array_del(d->pins, i);
+  }
+  d->numPins--;
+  uint32_t n = 0;
+  epochRetired *r = takeReclaimable(d, &n);
+  bool last = d->released && d->numPins == 0;
+  pthread_mutex_unlock(&d->lock);
+
+  freeReclaimed(r, n);
+  if (last) {
+    domainFree(d);
+  }
+}
+
+void EpochDomain_Retire(EpochDomain *d, void *ptr, EpochFreeFunc freeFn) {
+  pthread_mutex_lock(&d->lock);
+  if (!d->numPins) {
+    pthread_mutex_unlock(&d->lock);
+    freeFn(ptr);
+    return;
+  }
+  epochRetired r = {.epoch = d->epoch++, .ptr = ptr, .freeFn = freeFn};
+  d->retired = array_append(d->retired, r);
+  pthread_mutex_unlock(&d->lock);
+}
+
+size_t EpochDomain_NumRetired(EpochDomain *d) {
+  pthread_mutex_lock(&d->lock);
+  size_t n = array_len(d->retired);
+  pthread_mutex_unlock(&d->lock);
+  return n;
+}
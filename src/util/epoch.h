@@ -0,0 +1,52 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_EPOCH_H
+#define RS_EPOCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*EpochFreeFunc)(void *ptr);
+
+/* Epoch based reclamation of the structures readers may still hold after they released the lock
+ * of what they read. A reader pins the current epoch, and a writer which unlinks a structure
+ * retires it instead of freeing it: it is freed once every reader pinned before it was retired has
+ * released its pin. Readers which pinned later cannot reach it.
+ *
+ * Pins and retirements may come from any thread. The domain is reference counted: every pin holds
+ * a reference, so it outlives the structure it belongs to while readers still hold pins */
+typedef struct EpochDomain EpochDomain;
+
+EpochDomain *EpochDomain_New(void);
+
+/* Release the reference of the owner of the domain. It is freed, along with everything still
+ * retired in it, once no pins remain */
+void EpochDomain_Release(EpochDomain *d);
+
+/* Pin the current epoch of the domain. Nothing retired from now on is freed before the returned
+ * epoch is unpinned */
+uint64_t EpochDomain_Pin(EpochDomain *d);
+
+/* Release a pin returned by EpochDomain_Pin, and free what no pin protects anymore */
+void EpochDomain_Unpin(EpochDomain *d, uint64_t epoch);
+
+/* Free `ptr` with `freeFn` once the readers pinned now release their pins. Freed at once if there
+ * are none */
+void EpochDomain_Retire(EpochDomain *d, void *ptr, EpochFreeFunc freeFn);
+
+/* The number of structures retired and not freed yet */
+size_t EpochDomain_NumRetired(EpochDomain *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_EPOCH_H
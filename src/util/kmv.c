@@ -0,0 +1,108 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "kmv.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+/* The finalizer of splitmix64, over the bits of the value. -0 and 0 are the same value */
+static uint64_t hashValue(double value) {
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t x;
+  memcpy(&x, &value, sizeof(x));
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+uint32_t KMV_Capacity(uint32_t len) {
+  if (!len) {
+    return 0;
+  }
+  uint32_t cap = 4;
+  while (cap < len) {
+    cap *= 2;
+  }
+  return cap < KMV_SIZE ? cap : KMV_SIZE;
+}
+
+static bool addHashed(KMVSketch *s, uint64_t hash, double value) {
+  if (s->len == KMV_SIZE && hash >= s->samples[KMV_SIZE - 1].hash) {
+    return false;
+  }
+
+  // the first sample whose hash is not below the value's
+  uint32_t lo = 0, hi = s->len;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (s->samples[mid].hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < s->len && s->samples[lo].hash == hash) {
+    return false;
+  }
+
+  if (s->len < KMV_SIZE && s->len == KMV_Capacity(s->len)) {
+    uint32_t cap = s->len ? 2 * s->len : 4;
+    s->samples = rm_realloc(s->samples, cap * sizeof(*s->samples));
+  }
+  // the sample of the largest hash is dropped from a full sketch
+  uint32_t n = s->len < KMV_SIZE ? s->len++ : KMV_SIZE - 1;
+  memmove(s->samples + lo + 1, s->samples + lo, (n - lo) * sizeof(*s->samples));
+  s->samples[lo] = (KMVSample){.hash = hash, .value = value};
+  return true;
+}
+
+bool KMV_Add(KMVSketch *s, double value) {
+  return addHashed(s, hashValue(value), value);
+}
+
+size_t KMV_Estimate(const KMVSketch *s) {
+  if (s->len < KMV_SIZE) {
+    return s->len;
+  }
+  // the hashes are spread evenly, so the k-th smallest one covers k-1 values out of the whole range
+  double kth = (double)s->samples[KMV_SIZE - 1].hash / 18446744073709551616.0;
+  return kth > 0 ? (size_t)((KMV_SIZE - 1) / kth) : SIZE_MAX;
+}
+
+static int cmpDouble(const void *p1, const void *p2) {
+  double d1 = *(const double *)p1, d2 = *(const double *)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+double KMV_Median(const KMVSketch *s) {
+  double values[KMV_SIZE];
+  for (uint32_t i = 0; i < s->len; ++i) {
+    values[i] = s->samples[i].value;
+  }
+  qsort(values, s->len, sizeof(*values), cmpDouble);
+  uint32_t mid = s->len / 2;
+  return s->len % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+void KMV_Merge(KMVSketch *dst, const KMVSketch *src) {
+  for (uint32_t i = 0; i < src->len; ++i) {
+    if (!addHashed(dst, src->samples[i].hash, src->samples[i].value) && dst->len == KMV_SIZE &&
+        src->samples[i].hash >= dst->samples[KMV_SIZE - 1].hash) {
+      // the rest of the samples of `src` have larger hashes still
+      break;
+    }
+  }
+}
+
+void KMV_Clear(KMVSketch *s) {
+  rm_free(s->samples);
+  s->samples = NULL;
+  s->len = 0;
+}
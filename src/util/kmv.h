@@ -0,0 +1,64 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_KMV_H
+#define RS_KMV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of values a sketch keeps, and counts exactly
+#define KMV_SIZE 32
+
+typedef struct {
+  uint64_t hash;
+  double value;
+} KMVSample;
+
+/* A K-minimum-values sketch of a set of doubles: of the distinct values added, the KMV_SIZE ones
+ * with the smallest hashes, sorted by hash. It counts the distinct values exactly until it is
+ * full, and estimates their number from its largest hash after. The values it keeps are a uniform
+ * sample of the distinct ones, and two sketches merge into the sketch of the union of their values.
+ * Values cannot be removed, the sketch is rebuilt from the values which remain instead */
+typedef struct {
+  KMVSample *samples;
+  uint32_t len;
+} KMVSketch;
+
+/* Add a value to the sketch. Returns true if the sketch changed */
+bool KMV_Add(KMVSketch *s, double value);
+
+/* The estimated number of distinct values added to the sketch */
+size_t KMV_Estimate(const KMVSketch *s);
+
+/* The median of the values sampled by the sketch, which must not be empty. For an even number of
+ * samples, the midpoint of the two middle ones */
+double KMV_Median(const KMVSketch *s);
+
+/* Add the values of `src` to `dst` */
+void KMV_Merge(KMVSketch *dst, const KMVSketch *src);
+
+/* Remove all the values of the sketch, and free its memory */
+void KMV_Clear(KMVSketch *s);
+
+/* The number of samples a sketch of `len` samples has room for. It grows with the sketch, up to
+ * KMV_SIZE */
+uint32_t KMV_Capacity(uint32_t len);
+
+static inline size_t KMV_MemUsage(const KMVSketch *s) {
+  return KMV_Capacity(s->len) * sizeof(*s->samples);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_KMV_H
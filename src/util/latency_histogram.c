@@ -0,0 +1,70 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "latency_histogram.h"
+
+#include <math.h>
+#include <string.h>
+
+#define SUB_BITS LATENCY_HISTOGRAM_SUB_BITS
+
+/* The values below 2 << SUB_BITS have a bucket each. Above, a value whose most significant bit is
+ * `msb` is counted in the bucket of its SUB_BITS + 1 high bits, which start from 1 << SUB_BITS
+ * within the buckets of its power of two */
+static inline size_t bucketOf(uint64_t v) {
+  int msb = 63 - __builtin_clzll(v | 1);
+  int shift = msb > SUB_BITS ? msb - SUB_BITS : 0;
+  return ((size_t)shift << SUB_BITS) + (v >> shift);
+}
+
+// The largest value counted in bucket `idx`
+static inline uint64_t bucketMaxValue(size_t idx) {
+  if (idx < (2 << SUB_BITS)) {
+    return idx;
+  }
+  int shift = (idx >> SUB_BITS) - 1;
+  uint64_t mantissa = idx - ((size_t)shift << SUB_BITS);
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram_Record(LatencyHistogram *h, uint64_t usec) {
+  if (usec > LATENCY_HISTOGRAM_MAX_VALUE) {
+    usec = LATENCY_HISTOGRAM_MAX_VALUE;
+  }
+  __atomic_fetch_add(&h->counts[bucketOf(usec)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+  uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  while (usec > max &&
+         !__atomic_compare_exchange_n(&h->max, &max, usec, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+
+uint64_t LatencyHistogram_Percentile(const LatencyHistogram *h, double p) {
+  uint64_t count = LatencyHistogram_Count(h);
+  if (!count) {
+    return 0;
+  }
+  uint64_t rank = ceil(p / 100 * count);
+  rank = rank ? rank : 1;
+  uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LATENCY_HISTOGRAM_NUM_BUCKETS; i++) {
+    seen += __atomic_load_n(&h->counts[i], __ATOMIC_RELAXED);
+    if (seen >= rank) {
+      uint64_t v = bucketMaxValue(i);
+      return v < max ? v : max;
+    }
+  }
+  return max;
+}
+
+void LatencyHistogram_Reset(LatencyHistogram *h) {
+  for (size_t i = 0; i < LATENCY_HISTOGRAM_NUM_BUCKETS; i++) {
+    __atomic_store_n(&h->counts[i], 0, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&h->count, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&h->max, 0, __ATOMIC_RELAXED);
+}
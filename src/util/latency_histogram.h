@@ -0,0 +1,48 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_LATENCY_HISTOGRAM_H
+#define RS_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A histogram of latencies in microseconds, in the manner of HdrHistogram: the values are counted
+ * in log-linear buckets, 16 for every power of two, so that a percentile is read with a relative
+ * error of at most 1/16 whatever the latency, in a fixed amount of memory.
+ *
+ * The buckets are updated with relaxed atomics, so that the histogram can be recorded to from
+ * any thread without a lock. A percentile read while values are recorded may miss some of them */
+#define LATENCY_HISTOGRAM_SUB_BITS 4
+// The largest value counted, about 25 days. Larger ones are counted as it
+#define LATENCY_HISTOGRAM_MAX_VALUE ((1ULL << 41) - 1)
+#define LATENCY_HISTOGRAM_NUM_BUCKETS \
+  ((41 - LATENCY_HISTOGRAM_SUB_BITS + 1) << LATENCY_HISTOGRAM_SUB_BITS)
+
+typedef struct {
+  uint64_t counts[LATENCY_HISTOGRAM_NUM_BUCKETS];
+  uint64_t count;
+  uint64_t max;
+} LatencyHistogram;
+
+void LatencyHistogram_Record(LatencyHistogram *h, uint64_t usec);
+
+/* The value under which `p` percents of the recorded values are, or 0 when there are none */
+uint64_t LatencyHistogram_Percentile(const LatencyHistogram *h, double p);
+
+static inline uint64_t LatencyHistogram_Count(const LatencyHistogram *h) {
+  return __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+}
+
+void LatencyHistogram_Reset(LatencyHistogram *h);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_NAME_INDEX_H
+#define RS_NAME_INDEX_H
+
+#include "rmalloc.h"
+#include "util/fnv.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An open addressing table of entries by their names, for the lookups of the fields of the wide
+ * schemas, which would otherwise scan them. The entries hold their own names: the table only keeps
+ * their hashes, and the caller compares the names of the entries with a matching hash:
+ *
+ *   uint32_t h = NameIndex_Hash(name, len), pos = h;
+ *   for (Entry *e; (e = NameIndex_Next(&ni, h, &pos));) {
+ *     if (e->len == len && !memcmp(e->name, name, len)) return e;
+ *   }
+ *
+ * Entries are added and replaced, never removed. The table is kept at most half full */
+
+typedef struct {
+  uint32_t hash;
+  void *entry;  // NULL for an empty slot
+} NameIndexSlot;
+
+typedef struct {
+  NameIndexSlot *slots;
+  uint32_t cap;  // a power of 2, 0 until the first entry
+  uint32_t n;
+} NameIndex;
+
+#define NAME_INDEX_INITIAL_CAP 32
+
+static inline uint32_t NameIndex_Hash(const char *name, size_t len) {
+  return rs_fnv_32a_buf(name, len, 0x811c9dc5);
+}
+
+/* The next entry from `*pos` whose name hashes to `hash`, or NULL once there are none. `*pos` is
+ * set to `hash` before the first call */
+static inline void *NameIndex_Next(const NameIndex *ni, uint32_t hash, uint32_t *pos) {
+  if (!ni->cap) {
+    return NULL;
+  }
+  for (uint32_t i = *pos & (ni->cap - 1); ni->slots[i].entry; i = (i + 1) & (ni->cap - 1)) {
+    if (ni->slots[i].hash == hash) {
+      *pos = i + 1;
+      return ni->slots[i].entry;
+    }
+  }
+  return NULL;
+}
+
+static inline void NameIndex_Insert_(NameIndexSlot *slots, uint32_t cap, uint32_t hash,
+                                     void *entry) {
+  uint32_t i = hash & (cap - 1);
+  while (slots[i].entry) {
+    i = (i + 1) & (cap - 1);
+  }
+  slots[i].hash = hash;
+  slots[i].entry = entry;
+}
+
+static inline void NameIndex_Add(NameIndex *ni, uint32_t hash, void *entry) {
+  if ((ni->n + 1) * 2 > ni->cap) {
+    uint32_t cap = ni->cap ? ni->cap * 2 : NAME_INDEX_INITIAL_CAP;
+    NameIndexSlot *slots = (NameIndexSlot *)rm_calloc(cap, sizeof(*slots));
+    for (uint32_t i = 0; i < ni->cap; i++) {
+      if (ni->slots[i].entry) {
+        NameIndex_Insert_(slots, cap, ni->slots[i].hash, ni->slots[i].entry);
+      }
+    }
+    rm_free(ni->slots);
+    ni->slots = slots;
+    ni->cap = cap;
+  }
+  NameIndex_Insert_(ni->slots, ni->cap, hash, entry);
+  ni->n++;
+}
+
+/* Replace `entry`, whose name hashes to `hash`, with `with`, which has the same name */
+static inline void NameIndex_Replace(NameIndex *ni, uint32_t hash, const void *entry, void *with) {
+  if (!ni->cap) {
+    return;
+  }
+  for (uint32_t i = hash & (ni->cap - 1); ni->slots[i].entry; i = (i + 1) & (ni->cap - 1)) {
+    if (ni->slots[i].entry == entry) {
+      ni->slots[i].entry = with;
+      return;
+    }
+  }
+}
+
+static inline void NameIndex_Free(NameIndex *ni) {
+  rm_free(ni->slots);
+  ni->slots = NULL;
+  ni->cap = ni->n = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_NAME_INDEX_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+
+#include "rmalloc.h"
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_NUM_COUNTERS 3
+
+typedef struct {
+  int fds[PERF_NUM_COUNTERS];  // the first one leads the group
+  bool failed;                 // the counters could not be opened on the thread
+} perfThreadCounters;
+
+static pthread_key_t perfKey_g;
+
+static void perfThreadCountersDtor(void *p) {
+  perfThreadCounters *tc = p;
+  for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+    if (tc->fds[i] >= 0) {
+      close(tc->fds[i]);
+    }
+  }
+  rm_free(tc);
+}
+
+static void __attribute__((constructor)) initKey() {
+  pthread_key_create(&perfKey_g, perfThreadCountersDtor);
+}
+
+static int perfOpen(uint64_t config, int groupFd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // this thread, on any cpu
+  return syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+static perfThreadCounters *perfGetThreadCounters() {
+  perfThreadCounters *tc = pthread_getspecific(perfKey_g);
+  if (tc) {
+    return tc;
+  }
+
+  static const uint64_t configs[PERF_NUM_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+  tc = rm_malloc(sizeof(*tc));
+  tc->failed = false;
+  for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+    tc->fds[i] = perfOpen(configs[i], i ? tc->fds[0] : -1);
+    if (tc->fds[i] < 0) {
+      tc->failed = true;
+    }
+  }
+  pthread_setspecific(perfKey_g, tc);
+  return tc;
+}
+
+bool PerfCounters_Read(PerfCounters *pc) {
+  perfThreadCounters *tc = perfGetThreadCounters();
+  if (tc->failed) {
+    return false;
+  }
+  // a group is read as the number of counters followed by their values
+  uint64_t buf[1 + PERF_NUM_COUNTERS];
+  if (read(tc->fds[0], buf, sizeof(buf)) != sizeof(buf) || buf[0] != PERF_NUM_COUNTERS) {
+    return false;
+  }
+  pc->cycles = buf[1];
+  pc->instructions = buf[2];
+  pc->cacheMisses = buf[3];
+  return true;
+}
+
+#else
+
+bool PerfCounters_Read(PerfCounters *pc) {
+  return false;
+}
+
+#endif
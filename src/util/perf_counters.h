@@ -0,0 +1,43 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef RS_PERF_COUNTERS_H
+#define RS_PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hardware counters of the user space execution of a thread, for FT.PROFILE.
+ *
+ * The counters are opened with perf_event_open(2) as a single group on the first read on a thread,
+ * and are kept open until the thread exits, so that a read is a single read(2). They are not
+ * available outside of Linux, or when perf_event_paranoid does not allow them to the process */
+typedef struct {
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t cacheMisses;
+} PerfCounters;
+
+/* Read the counters of the calling thread into `pc`. Returns false if they are not available */
+bool PerfCounters_Read(PerfCounters *pc);
+
+/* Add to `acc` what the counters counted from `start` to `end` */
+static inline void PerfCounters_AddSince(PerfCounters *acc, const PerfCounters *start,
+                                         const PerfCounters *end) {
+  acc->cycles += end->cycles - start->cycles;
+  acc->instructions += end->instructions - start->instructions;
+  acc->cacheMisses += end->cacheMisses - start->cacheMisses;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RS_PERF_COUNTERS_H
@@ -0,0 +1,16 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+/* Hint the CPU to bring the cache line of `addr` in for reading, ahead of its use. Never faults,
+ * any address may be given. Building with -DRS_NO_PREFETCH (make NO_PREFETCH=1) leaves it to the
+ * hardware prefetcher, to compare the iterator benchmarks of both builds */
+#ifdef RS_NO_PREFETCH
+#define RS_PREFETCH(addr) ((void)(addr))
+#else
+#define RS_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#endif
@@ -273,6 +273,83 @@ double QS_Query(QuantStream *stream, double q) {
   return prev->v;
 }
 
+// The rank uncertainty of the samples of one stream, placed before `next` in the other
+static double QS_MergeDelta(const Sample *next) {
+  return next ? fmax(next->g + next->d - 1, 0) : 0;
+}
+
+void QS_Merge(QuantStream *dst, QuantStream *src) {
+  if (dst->bufferLength) {
+    QS_Flush(dst);
+  }
+  if (src->bufferLength) {
+    QS_Flush(src);
+  }
+
+  // Both lists are ordered. The samples of src are copied over and interleaved with those of dst
+  Sample *cur = dst->firstSample;
+  const Sample *other = src->firstSample;
+  Sample *first = NULL, *last = NULL;
+  size_t length = 0;
+  while (cur || other) {
+    Sample *sample;
+    if (!other || (cur && cur->v <= other->v)) {
+      sample = cur;
+      cur = cur->next;
+      sample->d += QS_MergeDelta(other);
+    } else {
+      sample = QS_NewSample(dst);
+      sample->v = other->v;
+      sample->g = other->g;
+      sample->d = other->d + QS_MergeDelta(cur);
+      other = other->next;
+    }
+    sample->prev = last;
+    sample->next = NULL;
+    if (last) {
+      last->next = sample;
+    } else {
+      first = sample;
+    }
+    last = sample;
+    length++;
+  }
+
+  dst->firstSample = first;
+  dst->lastSample = last;
+  dst->samplesLength = length;
+  dst->n += src->n;
+  QS_Compress(dst);
+}
+
+void QS_Serialize(QuantStream *stream, BufferWriter *bw) {
+  if (stream->bufferLength) {
+    QS_Flush(stream);
+  }
+  uint64_t n = stream->n, samplesLength = stream->samplesLength;
+  Buffer_Write(bw, &n, sizeof(n));
+  Buffer_Write(bw, &samplesLength, sizeof(samplesLength));
+  for (const Sample *cur = stream->firstSample; cur; cur = cur->next) {
+    Buffer_Write(bw, &cur->v, sizeof(cur->v));
+    Buffer_Write(bw, &cur->g, sizeof(cur->g));
+    Buffer_Write(bw, &cur->d, sizeof(cur->d));
+  }
+}
+
+void QS_Deserialize(QuantStream *stream, BufferReader *br) {
+  uint64_t n, samplesLength;
+  Buffer_Read(br, &n, sizeof(n));
+  Buffer_Read(br, &samplesLength, sizeof(samplesLength));
+  for (uint64_t ii = 0; ii < samplesLength; ++ii) {
+    Sample *sample = QS_NewSample(stream);
+    Buffer_Read(br, &sample->v, sizeof(sample->v));
+    Buffer_Read(br, &sample->g, sizeof(sample->g));
+    Buffer_Read(br, &sample->d, sizeof(sample->d));
+    QS_AppendSample(stream, sample);
+  }
+  stream->n = n;
+}
+
 QuantStream *NewQuantileStream(const double *quantiles, size_t numQuantiles, size_t bufferLength) {
   QuantStream *ret = rm_calloc(1, sizeof(QuantStream));
   if ((ret->numQuantiles = numQuantiles)) {
@@ -9,12 +9,19 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include "buffer.h"
 
 typedef struct QuantStream QuantStream;
 
 QuantStream *NewQuantileStream(const double *quantiles, size_t numQuantiles, size_t bufferLength);
 void QS_Insert(QuantStream *qs, double val);
 double QS_Query(QuantStream *qs, double val);
+/* Add the values inserted to `src` to `dst`, which is created with the same quantiles */
+void QS_Merge(QuantStream *dst, QuantStream *src);
+/* Write the samples of the stream, to be read back by QS_Deserialize */
+void QS_Serialize(QuantStream *qs, BufferWriter *bw);
+/* Read the samples written by QS_Serialize into an empty stream, created with the same quantiles */
+void QS_Deserialize(QuantStream *qs, BufferReader *br);
 void QS_Free(QuantStream *qs);
 void QS_Dump(const QuantStream *stream, FILE *fp);
 size_t QS_GetCount(const QuantStream *stream);
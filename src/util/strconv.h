@@ -12,6 +12,7 @@
 #include <math.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 /* Strconv - common simple string conversion utils */
 
 // Case insensitive string equal
@@ -114,4 +115,15 @@ static char *rm_strdupcase(const char *s, size_t len) {
   return ret;
 }
 
+/* The first 8 bytes of a string as an integer in the order of the strings under memcmp: big
+ * endian, padded with zeros. Strings whose prefixes differ are ordered as their prefixes, the
+ * others are to be compared in full */
+static inline uint64_t StrSortPrefix(const char *str, size_t len) {
+  uint64_t u = 0;
+  for (size_t i = 0; i < 8; i++) {
+    u = u << 8 | (i < len ? (unsigned char)str[i] : 0);
+  }
+  return u;
+}
+
 #endif
\ No newline at end of file
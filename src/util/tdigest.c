@@ -0,0 +1,190 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tdigest.h"
+#include "rmalloc.h"
+
+#define TDIGEST_INITIAL_BUFFER 16
+
+typedef struct {
+  double mean;
+  double weight;
+} Centroid;
+
+struct TDigest {
+  double compression;
+
+  Centroid *centroids;  // Merged centroids, sorted by their mean
+  size_t numCentroids;
+
+  Centroid *buffer;  // Values and centroids added since the last merge
+  size_t bufferLength;
+  size_t bufferCap;
+
+  double count;  // Total weight of the values
+  double min;
+  double max;
+};
+
+TDigest *NewTDigest(double compression) {
+  TDigest *td = rm_calloc(1, sizeof(*td));
+  td->compression = compression;
+  td->min = INFINITY;
+  td->max = -INFINITY;
+  return td;
+}
+
+// The scale function: a centroid may span at most 1 of its unit. It is the steepest near the
+// quantiles 0 and 1, so that the centroids there are the smallest
+static double scale(const TDigest *td, double q) {
+  q = fmin(fmax(q, 0), 1);
+  return td->compression / (2 * M_PI) * asin(2 * q - 1);
+}
+
+static int cmpCentroids(const void *a, const void *b) {
+  double ma = ((const Centroid *)a)->mean, mb = ((const Centroid *)b)->mean;
+  return ma < mb ? -1 : ma > mb;
+}
+
+/* Merge the buffered centroids with the merged ones */
+static void TDigest_Compress(TDigest *td) {
+  if (!td->bufferLength) {
+    return;
+  }
+
+  size_t n = td->numCentroids + td->bufferLength;
+  Centroid *all = rm_realloc(td->centroids, n * sizeof(*all));
+  memcpy(all + td->numCentroids, td->buffer, td->bufferLength * sizeof(*all));
+  qsort(all, n, sizeof(*all), cmpCentroids);
+
+  // merge neighbours as long as they span at most 1 unit of the scale
+  size_t last = 0;
+  double before = 0;  // the weight before the last centroid
+  for (size_t ii = 1; ii < n; ++ii) {
+    double weight = all[last].weight + all[ii].weight;
+    if (scale(td, (before + weight) / td->count) - scale(td, before / td->count) <= 1) {
+      all[last].mean += (all[ii].mean - all[last].mean) * all[ii].weight / weight;
+      all[last].weight = weight;
+    } else {
+      before += all[last].weight;
+      all[++last] = all[ii];
+    }
+  }
+
+  td->centroids = all;
+  td->numCentroids = last + 1;
+  td->bufferLength = 0;
+}
+
+static void TDigest_AddCentroid(TDigest *td, double mean, double weight) {
+  if (td->bufferLength == td->bufferCap) {
+    // buffer up to a few times the centroids a digest keeps, before merging them
+    if (td->bufferCap < 4 * td->compression) {
+      td->bufferCap = td->bufferCap ? td->bufferCap * 2 : TDIGEST_INITIAL_BUFFER;
+      td->buffer = rm_realloc(td->buffer, td->bufferCap * sizeof(*td->buffer));
+    } else {
+      TDigest_Compress(td);
+    }
+  }
+  td->buffer[td->bufferLength++] = (Centroid){.mean = mean, .weight = weight};
+  td->count += weight;
+  td->min = fmin(td->min, mean);
+  td->max = fmax(td->max, mean);
+}
+
+void TDigest_Add(TDigest *td, double val) {
+  TDigest_AddCentroid(td, val, 1);
+}
+
+void TDigest_Merge(TDigest *dst, TDigest *src) {
+  TDigest_Compress(src);
+  for (size_t ii = 0; ii < src->numCentroids; ++ii) {
+    TDigest_AddCentroid(dst, src->centroids[ii].mean, src->centroids[ii].weight);
+  }
+  // the extremes of a centroid are not its mean
+  dst->min = fmin(dst->min, src->min);
+  dst->max = fmax(dst->max, src->max);
+}
+
+double TDigest_Quantile(TDigest *td, double q) {
+  TDigest_Compress(td);
+  if (!td->numCentroids) {
+    return 0;
+  }
+
+  double rank = fmax(ceil(q * td->count), 1);
+  double before = 0;
+  for (size_t ii = 0; ii < td->numCentroids; ++ii) {
+    const Centroid *c = td->centroids + ii;
+    if (before + c->weight < rank) {
+      before += c->weight;
+      continue;
+    }
+    if (c->weight <= 1) {
+      return c->mean;
+    }
+    // interpolate the values of the centroid from halfway to its neighbours, through its mean
+    double pos = (rank - before) / c->weight;
+    if (pos < 0.5) {
+      double left = ii ? (td->centroids[ii - 1].mean + c->mean) / 2 : td->min;
+      return left + (c->mean - left) * pos * 2;
+    } else {
+      double right = ii + 1 < td->numCentroids ? (c->mean + td->centroids[ii + 1].mean) / 2 : td->max;
+      return c->mean + (right - c->mean) * (pos - 0.5) * 2;
+    }
+  }
+  return td->max;
+}
+
+size_t TDigest_GetCount(const TDigest *td) {
+  return td->count;
+}
+
+void TDigest_Serialize(TDigest *td, BufferWriter *bw) {
+  TDigest_Compress(td);
+  Buffer_WriteU32(bw, td->numCentroids);
+  Buffer_Write(bw, &td->min, sizeof(td->min));
+  Buffer_Write(bw, &td->max, sizeof(td->max));
+  Buffer_Write(bw, td->centroids, td->numCentroids * sizeof(*td->centroids));
+}
+
+int TDigest_Deserialize(TDigest *td, BufferReader *br) {
+  size_t avail = br->buf->offset - br->pos;
+  if (avail < sizeof(uint32_t) + 2 * sizeof(double)) {
+    return 0;
+  }
+  uint32_t n = Buffer_ReadU32(br);
+  avail -= sizeof(uint32_t) + 2 * sizeof(double);
+  if (avail / sizeof(Centroid) < n) {
+    return 0;
+  }
+
+  double min, max;
+  Buffer_Read(br, &min, sizeof(min));
+  Buffer_Read(br, &max, sizeof(max));
+  for (uint32_t ii = 0; ii < n; ++ii) {
+    Centroid c;
+    Buffer_Read(br, &c, sizeof(c));
+    if (c.weight > 0) {
+      TDigest_AddCentroid(td, c.mean, c.weight);
+    }
+  }
+  if (n) {
+    td->min = fmin(td->min, min);
+    td->max = fmax(td->max, max);
+  }
+  return 1;
+}
+
+void TDigest_Free(TDigest *td) {
+  rm_free(td->centroids);
+  rm_free(td->buffer);
+  rm_free(td);
+}
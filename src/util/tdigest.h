@@ -0,0 +1,37 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <stdlib.h>
+#include "buffer.h"
+
+/* The compression of the digests built by the reducers */
+#define TDIGEST_DEFAULT_COMPRESSION 200
+
+/**
+ * A merging t-digest: an approximation of the distribution of a stream of values, as clusters of
+ * values (centroids) which are the smaller the closer their quantile is to 0 or 1. Unlike
+ * QuantStream it is not built for given quantiles, and digests of separate streams can be merged.
+ * A digest with less values than about its compression keeps all of them exactly.
+ */
+typedef struct TDigest TDigest;
+
+TDigest *NewTDigest(double compression);
+void TDigest_Add(TDigest *td, double val);
+/* Add the values added to `src` to `dst` */
+void TDigest_Merge(TDigest *dst, TDigest *src);
+/* The value at quantile `q`, as the value of rank ceil(q * count) for values kept exactly */
+double TDigest_Quantile(TDigest *td, double q);
+size_t TDigest_GetCount(const TDigest *td);
+/* Write the centroids of the digest, to be read back by TDigest_Deserialize */
+void TDigest_Serialize(TDigest *td, BufferWriter *bw);
+/* Add the centroids written by TDigest_Serialize to the digest. Returns 0 if they are malformed */
+int TDigest_Deserialize(TDigest *td, BufferReader *br);
+void TDigest_Free(TDigest *td);
+
+#endif
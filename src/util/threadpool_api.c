@@ -5,8 +5,21 @@
  */
 
 #include "threadpool_api.h"
+#include "workers.h"
+#include "workers_pool.h"
 #include "rmalloc.h"
 
+#include <stdbool.h>
+
+// The index jobs held back by the current thread, see ThreadPoolAPI_HoldIndexJobs
+static __thread struct {
+  bool holding;
+  size_t *pending;
+  void *pool;
+  size_t n;
+  redisearch_thpool_work_t jobs[THREADPOOL_API_MAX_HELD_JOBS];
+} held;
+
 static void ThreadPoolAPI_Execute(void *ctx) {
   ThreadPoolAPI_AsyncIndexJob *job = ctx;
   StrongRef spec_ref = WeakRef_Promote(job->spec_ref);
@@ -14,6 +27,9 @@ static void ThreadPoolAPI_Execute(void *ctx) {
   // If the spec is still alive, execute the callback
   if (StrongRef_Get(spec_ref)) {
     job->cb(job->arg);
+    if (job->pending) {
+      __atomic_sub_fetch(job->pending, 1, __ATOMIC_RELAXED);
+    }
     StrongRef_Release(spec_ref);
   }
 
@@ -22,6 +38,49 @@ static void ThreadPoolAPI_Execute(void *ctx) {
   rm_free(job);
 }
 
+static int submitJobs(void *pool, redisearch_thpool_work_t *jobs, size_t n_jobs) {
+#ifdef MT_BUILD
+  // The jobs of the workers are accounted as vector indexing jobs
+  int rc = pool == _workers_thpool ? workersThreadPool_AddIndexJobs(jobs, n_jobs)
+                                   : redisearch_thpool_add_n_work(pool, jobs, n_jobs, THPOOL_PRIORITY_LOW);
+#else
+  int rc = redisearch_thpool_add_n_work(pool, jobs, n_jobs, THPOOL_PRIORITY_LOW);
+#endif
+  if (rc == -1) {
+    // Failed to add jobs to the thread pool, free all the jobs
+    for (size_t i = 0; i < n_jobs; i++) {
+      ThreadPoolAPI_AsyncIndexJob *job = jobs[i].arg_p;
+      if (job->pending) {
+        __atomic_sub_fetch(job->pending, 1, __ATOMIC_RELAXED);
+      }
+      WeakRef_Release(job->spec_ref);
+      rm_free(job);
+    }
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+static int flushHeldJobs(void) {
+  int rc = REDISMODULE_OK;
+  if (held.n) {
+    rc = submitJobs(held.pool, held.jobs, held.n);
+    held.n = 0;
+  }
+  return rc;
+}
+
+void ThreadPoolAPI_HoldIndexJobs(size_t *pending) {
+  held.holding = true;
+  held.pending = pending;
+}
+
+void ThreadPoolAPI_FlushIndexJobs(void) {
+  flushHeldJobs();
+  held.holding = false;
+  held.pending = NULL;
+}
+
 // For now, we assume that all the jobs that are submitted are low priority jobs (not blocking any client).
 // We can add the priority to the `spec_ctx` (and rename it) if needed.
 int ThreadPoolAPI_SubmitIndexJobs(void *pool, void *spec_ctx, void **ext_jobs,
@@ -35,19 +94,27 @@ int ThreadPoolAPI_SubmitIndexJobs(void *pool, void *spec_ctx, void **ext_jobs,
     job->spec_ref = WeakRef_Clone(spec_ref);
     job->cb = cbs[i];
     job->arg = ext_jobs[i];
+    job->pending = NULL;
 
     jobs[i].arg_p = job;
     jobs[i].function_p = ThreadPoolAPI_Execute;
   }
 
-  if (redisearch_thpool_add_n_work(pool, jobs, n_jobs, THPOOL_PRIORITY_LOW) == -1) {
-    // Failed to add jobs to the thread pool, free all the jobs
-    for (size_t i = 0; i < n_jobs; i++) {
-      ThreadPoolAPI_AsyncIndexJob *job = jobs[i].arg_p;
-      WeakRef_Release(job->spec_ref);
-      rm_free(job);
+  if (!held.holding) {
+    return submitJobs(pool, jobs, n_jobs);
+  }
+  int rc = REDISMODULE_OK;
+  for (size_t i = 0; i < n_jobs; i++) {
+    if (held.n == THREADPOOL_API_MAX_HELD_JOBS || (held.n && held.pool != pool)) {
+      if (flushHeldJobs() != REDISMODULE_OK) rc = REDISMODULE_ERR;
     }
-    return REDISMODULE_ERR;
+    ThreadPoolAPI_AsyncIndexJob *job = jobs[i].arg_p;
+    if (held.pending) {
+      job->pending = held.pending;
+      __atomic_add_fetch(job->pending, 1, __ATOMIC_RELAXED);
+    }
+    held.pool = pool;
+    held.jobs[held.n++] = jobs[i];
   }
-  return REDISMODULE_OK;
+  return rc;
 }
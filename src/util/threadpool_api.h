@@ -12,8 +12,21 @@ typedef struct ThreadPoolAPI_AsyncIndexJob {
   WeakRef spec_ref;             // A reference to the associated spec of the job
   ThreadPoolAPI_CB cb;          // callback to execute (gets the external job context)
   void *arg;                    // The external job context
+  size_t *pending;              // Counts the job until it runs, if it was held (may be NULL)
 } ThreadPoolAPI_AsyncIndexJob;
 
 int ThreadPoolAPI_SubmitIndexJobs(void *pool, void *spec_ctx, void **ext_jobs,
                                                          ThreadPoolAPI_CB *cbs,
                                                          size_t n_jobs);
+
+// The most jobs held back before they are submitted anyway
+#define THREADPOOL_API_MAX_HELD_JOBS 128
+
+/* Hold back the index jobs submitted from the calling thread, to submit them in batches of up to
+ * THREADPOOL_API_MAX_HELD_JOBS, instead of one by one. Used by the background scan of an index,
+ * which inserts many vectors in a row. If `pending` is set, it counts the held jobs until they run,
+ * and must stay valid as long as the spec of the jobs is alive */
+void ThreadPoolAPI_HoldIndexJobs(size_t *pending);
+
+/* Submit the index jobs held back by the calling thread, and stop holding them */
+void ThreadPoolAPI_FlushIndexJobs(void);
@@ -10,6 +10,7 @@
 #include "redisearch.h"
 #include "version.h"
 #include "query_error.h"
+#include "util/coarse_clock.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -59,27 +60,34 @@ typedef struct TimeoutCtx {
 
 typedef int(*TimeoutCb)(TimeoutCtx *);
 
+// Check if time has been reached, on the coarse clock (see coarse_clock.h)
 static inline int TimedOut(struct timespec *timeout) {
-  static struct timespec now;
-  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-  if (__builtin_expect(rs_timer_ge(&now, timeout), 0)) {
+  uint64_t deadline = (uint64_t)timeout->tv_sec * 1000000000 + timeout->tv_nsec;
+  if (__builtin_expect(CoarseClock_NowNS() >= deadline, 0)) {
     return TIMED_OUT;
   }
   return NOT_TIMED_OUT;
 }
 
-// Check if time has been reached (run once every 100 calls) 
+// Check if time has been reached - on every call while the coarse clock runs, since it is a single
+// load, and otherwise once every 100 calls
 static inline int TimedOut_WithCounter(struct timespec *timeout, size_t *counter) {
   if (RS_IsMock) return 0;
 
-  if (*counter != REDISEARCH_UNINITIALIZED && ++(*counter) == 100) {
+  if (*counter == REDISEARCH_UNINITIALIZED) {
+    return NOT_TIMED_OUT;
+  }
+  if (CoarseClock_IsRunning()) {
+    return TimedOut(timeout);
+  }
+  if (++(*counter) == 100) {
     *counter = 0;
     return TimedOut(timeout);
   }
   return NOT_TIMED_OUT;
 }
 
-// Check if time has been reached (run once every 100 calls) 
+// Check if time has been reached (see TimedOut_WithCounter)
 static inline int TimedOut_WithCtx(TimeoutCtx *ctx) {
   return TimedOut_WithCounter(&ctx->timeout, &ctx->counter);
 }
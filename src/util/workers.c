@@ -9,8 +9,10 @@
 #include "redismodule.h"
 #include "config.h"
 #include "logging.h"
+#include "cpu_affinity.h"
 
 #include <pthread.h>
+#include <time.h>
 
 #ifdef MT_BUILD
 //------------------------------------------------------------------------------
@@ -20,6 +22,77 @@
 redisearch_threadpool _workers_thpool = NULL;
 size_t yield_counter = 0;
 
+// The CPUs the workers are pinned to, NULL if they are not
+static arrayof(int) workers_cpus = NULL;
+
+static void workersThread_Start(void *arg) {
+  if (CPUList_PinCurrentThread(workers_cpus) != REDISMODULE_OK) {
+    RedisModule_Log(RSDummyContext, "warning", "Could not set the CPU affinity of a worker thread");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Job classes
+//------------------------------------------------------------------------------
+
+static const char *workersJobClass_Names[WORKERS_JOB_NUM_CLASSES] = {
+  [WORKERS_JOB_QUERY] = "query",
+  [WORKERS_JOB_VECSIM_INDEX] = "vecsim_index",
+};
+
+// The statistics of a class of jobs, updated atomically by the threads queueing and running them
+typedef struct {
+  size_t pending;
+  size_t started;
+  size_t rejected;
+  uint64_t totalWaitUs;  // the time the jobs which started waited in the queue
+  uint64_t maxWaitUs;
+} workersJobStats;
+
+static workersJobStats workersJobs_Stats[WORKERS_JOB_NUM_CLASSES];
+
+// A job of the workers, wrapped to time its wait in the queue
+typedef struct {
+  redisearch_thpool_proc function_p;
+  void *arg_p;
+  WorkersJobClass cls;
+  struct timespec queued;
+} workersJob;
+
+static uint64_t elapsedUs(const struct timespec *since) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000000 + (now.tv_nsec - since->tv_nsec) / 1000;
+}
+
+static void workersJob_Run(void *arg) {
+  workersJob *job = arg;
+  workersJobStats *stats = &workersJobs_Stats[job->cls];
+  uint64_t waitUs = elapsedUs(&job->queued);
+  __atomic_sub_fetch(&stats->pending, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stats->started, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stats->totalWaitUs, waitUs, __ATOMIC_RELAXED);
+  uint64_t max = __atomic_load_n(&stats->maxWaitUs, __ATOMIC_RELAXED);
+  while (waitUs > max && !__atomic_compare_exchange_n(&stats->maxWaitUs, &max, waitUs, true,
+                                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+
+  redisearch_thpool_proc function_p = job->function_p;
+  void *arg_p = job->arg_p;
+  rm_free(job);
+  function_p(arg_p);
+}
+
+static workersJob *workersJob_New(WorkersJobClass cls, redisearch_thpool_proc function_p,
+                                  void *arg_p) {
+  workersJob *job = rm_new(workersJob);
+  job->function_p = function_p;
+  job->arg_p = arg_p;
+  job->cls = cls;
+  clock_gettime(CLOCK_MONOTONIC, &job->queued);
+  return job;
+}
+
 static void yieldCallback(void *yieldCtx) {
   yield_counter++;
   if (yield_counter % 10 == 0 || yield_counter == 1) {
@@ -37,6 +110,16 @@ int workersThreadPool_CreatePool(size_t worker_count) {
 
   _workers_thpool = redisearch_thpool_create(worker_count, RSGlobalConfig.privilegedThreadsNum);
   if (_workers_thpool == NULL) return REDISMODULE_ERR;
+  redisearch_thpool_set_high_priority_weight(_workers_thpool, RSGlobalConfig.workersQueryWeight);
+
+  // Resolved here, on the main thread, so that NUMA_LOCAL stands for the node of the main thread
+  workers_cpus = CPUList_FromSetting(RSGlobalConfig.workersCpuList);
+  if (workers_cpus) {
+    redisearch_thpool_set_thread_start(_workers_thpool, workersThread_Start, NULL);
+  } else if (RSGlobalConfig.workersCpuList) {
+    RedisModule_Log(RSDummyContext, "warning", "Could not tell the CPUs of %s, the workers are not pinned",
+                    RSGlobalConfig.workersCpuList);
+  }
 
   return REDISMODULE_OK;
 }
@@ -54,12 +137,83 @@ size_t workersThreadPool_WorkingThreadCount(void) {
   return redisearch_thpool_num_threads_working(_workers_thpool);
 }
 
-// add task for worker thread
-// DvirDu: I think we should add a priority parameter to this function
+// add query task for worker thread
 int workersThreadPool_AddWork(redisearch_thpool_proc function_p, void *arg_p) {
   assert(_workers_thpool != NULL);
 
-  return redisearch_thpool_add_work(_workers_thpool, function_p, arg_p, THPOOL_PRIORITY_HIGH);
+  workersJob *job = workersJob_New(WORKERS_JOB_QUERY, function_p, arg_p);
+  __atomic_add_fetch(&workersJobs_Stats[WORKERS_JOB_QUERY].pending, 1, __ATOMIC_RELAXED);
+  if (redisearch_thpool_add_work(_workers_thpool, workersJob_Run, job, THPOOL_PRIORITY_HIGH) != 0) {
+    __atomic_sub_fetch(&workersJobs_Stats[WORKERS_JOB_QUERY].pending, 1, __ATOMIC_RELAXED);
+    rm_free(job);
+    return -1;
+  }
+  return 0;
+}
+
+// add vector indexing tasks for worker threads
+int workersThreadPool_AddIndexJobs(redisearch_thpool_work_t *jobs, size_t n_jobs) {
+  assert(_workers_thpool != NULL);
+  if (n_jobs == 0) return 0;
+
+  redisearch_thpool_work_t wrapped[n_jobs];
+  for (size_t i = 0; i < n_jobs; i++) {
+    wrapped[i].function_p = workersJob_Run;
+    wrapped[i].arg_p = workersJob_New(WORKERS_JOB_VECSIM_INDEX, jobs[i].function_p, jobs[i].arg_p);
+  }
+  workersJobStats *stats = &workersJobs_Stats[WORKERS_JOB_VECSIM_INDEX];
+  __atomic_add_fetch(&stats->pending, n_jobs, __ATOMIC_RELAXED);
+  if (redisearch_thpool_add_n_work(_workers_thpool, wrapped, n_jobs, THPOOL_PRIORITY_LOW) != 0) {
+    __atomic_sub_fetch(&stats->pending, n_jobs, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < n_jobs; i++) {
+      rm_free(wrapped[i].arg_p);
+    }
+    return -1;
+  }
+  return 0;
+}
+
+bool workersThreadPool_AdmitQuery(void) {
+  workersJobStats *stats = &workersJobs_Stats[WORKERS_JOB_QUERY];
+  size_t max = RSGlobalConfig.maxPendingQueries;
+  if (!max || __atomic_load_n(&stats->pending, __ATOMIC_RELAXED) < max) {
+    return true;
+  }
+  __atomic_add_fetch(&stats->rejected, 1, __ATOMIC_RELAXED);
+  return false;
+}
+
+void workersThreadPool_AddToInfo(RedisModuleInfoCtx *ctx) {
+  if (!_workers_thpool) {
+    return;
+  }
+  RedisModule_InfoAddSection(ctx, "workers");
+  RedisModule_InfoAddFieldULongLong(ctx, "threads_working",
+                                    redisearch_thpool_num_threads_working(_workers_thpool));
+  char cpus[256] = "";
+  CPUList_Format(workers_cpus, cpus, sizeof(cpus));
+  RedisModule_InfoAddFieldCString(ctx, "workers_cpu_list", cpus);
+  for (size_t i = 0; i < RSGlobalConfig.numWorkerThreads; ++i) {
+    char field[64];
+    snprintf(field, sizeof(field), "worker_%zu_cpu_time_us", i);
+    RedisModule_InfoAddFieldULongLong(ctx, field, redisearch_thpool_thread_cpu_usec(_workers_thpool, i));
+  }
+  for (int cls = 0; cls < WORKERS_JOB_NUM_CLASSES; ++cls) {
+    workersJobStats *stats = &workersJobs_Stats[cls];
+    size_t started = __atomic_load_n(&stats->started, __ATOMIC_RELAXED);
+    size_t pending = __atomic_load_n(&stats->pending, __ATOMIC_RELAXED);
+    uint64_t totalWaitUs = __atomic_load_n(&stats->totalWaitUs, __ATOMIC_RELAXED);
+    char field[64];
+#define ADD_CLASS_FIELD(name, value)                                         \
+  snprintf(field, sizeof(field), "%s_%s", workersJobClass_Names[cls], name); \
+  RedisModule_InfoAddFieldULongLong(ctx, field, value)
+    ADD_CLASS_FIELD("jobs_pending", pending);
+    ADD_CLASS_FIELD("jobs_started", started);
+    ADD_CLASS_FIELD("jobs_rejected", __atomic_load_n(&stats->rejected, __ATOMIC_RELAXED));
+    ADD_CLASS_FIELD("queue_wait_avg_us", started ? totalWaitUs / started : 0);
+    ADD_CLASS_FIELD("queue_wait_max_us", __atomic_load_n(&stats->maxWaitUs, __ATOMIC_RELAXED));
+#undef ADD_CLASS_FIELD
+  }
 }
 
 // Wait until job queue contains no more than <threshold> pending jobs.
@@ -85,6 +239,8 @@ void workersThreadPool_Terminate(void) {
 
 void workersThreadPool_Destroy(void) {
   redisearch_thpool_destroy(_workers_thpool);
+  array_free(workers_cpus);
+  workers_cpus = NULL;
 }
 
 void workersThreadPool_InitIfRequired() {
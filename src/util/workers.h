@@ -12,9 +12,19 @@
 #include "thpool/thpool.h"
 #include "config.h"
 #include <assert.h>
+#include <stdbool.h>
 
 #define USE_BURST_THREADS() (RSGlobalConfig.numWorkerThreads && RSGlobalConfig.mt_mode == MT_MODE_ONLY_ON_OPERATIONS)
 
+// The classes of the jobs of the workers. Query jobs run with high priority, the privileged
+// threads run them first and the other threads run WORKERS_QUERY_WEIGHT of them for every vector
+// indexing job
+typedef enum {
+  WORKERS_JOB_QUERY,
+  WORKERS_JOB_VECSIM_INDEX,
+  WORKERS_JOB_NUM_CLASSES,
+} WorkersJobClass;
+
 // create workers thread pool
 // returns REDISMODULE_OK if thread pool created, REDISMODULE_ERR otherwise
 int workersThreadPool_CreatePool(size_t worker_count);
@@ -25,9 +35,19 @@ void workersThreadPool_InitPool();
 // return number of currently working threads
 size_t workersThreadPool_WorkingThreadCount(void);
 
-// adds a task
+// adds a query task
 int workersThreadPool_AddWork(redisearch_thpool_proc, void *arg_p);
 
+// adds vector indexing tasks
+int workersThreadPool_AddIndexJobs(redisearch_thpool_work_t *jobs, size_t n_jobs);
+
+// Whether a query may be queued to the workers, or should be rejected since MAX_PENDING_QUERIES
+// query jobs are already waiting for them. Counts the rejected queries
+bool workersThreadPool_AdmitQuery(void);
+
+// Add the queue statistics of every class of jobs to INFO
+void workersThreadPool_AddToInfo(RedisModuleInfoCtx *ctx);
+
 // Wait until the workers job queue contains no more than <threshold> jobs.
 void workersThreadPool_Drain(RedisModuleCtx *ctx, size_t threshold);
 
@@ -27,8 +27,15 @@ static size_t RSValue_NumToString(double dd, char *buf) {
 typedef struct {
   mempool_t *values;
   mempool_t *fieldmaps;
+  // Values followed by the buffer of their short string
+  mempool_t *inlineStrings;
 } mempoolThreadPool;
 
+typedef struct {
+  RSValue value;
+  char buf[RSVALUE_INLINE_STR_MAX + 1];
+} RSValueInlineStr;
+
 static void mempoolThreadPoolDtor(void *p) {
   mempoolThreadPool *tp = p;
   if (tp->values) {
@@ -37,6 +44,9 @@ static void mempoolThreadPoolDtor(void *p) {
   if (tp->fieldmaps) {
     mempool_destroy(tp->fieldmaps);
   }
+  if (tp->inlineStrings) {
+    mempool_destroy(tp->inlineStrings);
+  }
   rm_free(tp);
 }
 
@@ -46,6 +56,10 @@ static void *_valueAlloc() {
   return rm_malloc(sizeof(RSValue));
 }
 
+static void *_inlineStrAlloc() {
+  return rm_malloc(sizeof(RSValueInlineStr));
+}
+
 static void _valueFree(void *p) {
   rm_free(p);
 }
@@ -61,6 +75,8 @@ static inline mempoolThreadPool *getPoolInfo() {
     mempool_options opts = {
         .initialCap = 0, .maxCap = 1000, .alloc = _valueAlloc, .free = _valueFree};
     tp->values = mempool_new(&opts);
+    opts.alloc = _inlineStrAlloc;
+    tp->inlineStrings = mempool_new(&opts);
     pthread_setspecific(mempoolKey_g, tp);
   }
   return tp;
@@ -71,6 +87,7 @@ RSValue *RS_NewValue(RSValueType t) {
   v->t = t;
   v->refcount = 1;
   v->allocated = 1;
+  v->inlinestr = 0;
   return v;
 }
 
@@ -135,7 +152,9 @@ void RSValue_Clear(RSValue *v) {
 void RSValue_Free(RSValue *v) {
   RSValue_Clear(v);
   if (v->allocated) {
-    mempool_release(getPoolInfo()->values, v);
+    mempoolThreadPool *tp = getPoolInfo();
+    // the flag tells the allocation apart even if the value was since set to another type
+    mempool_release(v->inlinestr ? tp->inlineStrings : tp->values, v);
   }
 }
 
@@ -161,6 +180,18 @@ inline void RSValue_SetString(RSValue *v, char *str, size_t len) {
 }
 
 RSValue *RS_NewCopiedString(const char *s, size_t n) {
+  if (n <= RSVALUE_INLINE_STR_MAX) {
+    RSValueInlineStr *is = mempool_get(getPoolInfo()->inlineStrings);
+    RSValue *v = &is->value;
+    v->refcount = 1;
+    v->allocated = 1;
+    v->inlinestr = 1;
+    memcpy(is->buf, s, n);
+    is->buf[n] = 0;
+    // the buffer is released along with the value
+    RSValue_SetConstString(v, is->buf, n);
+    return v;
+  }
   RSValue *v = RS_NewValue(RSValue_String);
   char *cp = rm_malloc(n + 1);
   cp[n] = 0;
@@ -761,7 +792,7 @@ int RSValue_SendReply(RedisModule_Reply *reply, const RSValue *v, SendReplyFlags
 
 #if 1
     case RSValue_Array:
-      RedisModule_Reply_Array(reply);
+      RedisModule_Reply_ArrayOfSize(reply, v->arrval.len);
         for (uint32_t i = 0; i < v->arrval.len; i++) {
           RSValue_SendReply(reply, v->arrval.vals[i], flags);
         }
@@ -770,7 +801,7 @@ int RSValue_SendReply(RedisModule_Reply *reply, const RSValue *v, SendReplyFlags
 
     case RSValue_Map:
       // If Map value is used, assume Map api exists (RedisModule_HasMap)
-      RedisModule_Reply_Map(reply);
+      RedisModule_Reply_MapOfSize(reply, v->mapval.len);
       for (uint32_t i = 0; i < v->mapval.len; i++) {
           RSValue_SendReply(reply, v->mapval.pairs[RSVALUE_MAP_KEYPOS(i)], flags);
           RSValue_SendReply(reply, v->mapval.pairs[RSVALUE_MAP_VALUEPOS(i)], flags);
@@ -789,6 +820,91 @@ int RSValue_SendReply(RedisModule_Reply *reply, const RSValue *v, SendReplyFlags
   return REDISMODULE_OK;
 }
 
+void RSValue_Serialize(const RSValue *v, BufferWriter *bw) {
+  v = RSValue_Dereference(v);
+  RSValueType t = v ? v->t : RSValue_Null;
+  switch (t) {
+    case RSValue_Number:
+      Buffer_WriteU8(bw, RSValue_Number);
+      Buffer_Write(bw, &v->numval, sizeof(v->numval));
+      break;
+    case RSValue_String:
+    case RSValue_RedisString:
+    case RSValue_OwnRstring: {
+      size_t len;
+      const char *str = RSValue_StringPtrLen(v, &len);
+      Buffer_WriteU8(bw, RSValue_String);
+      Buffer_WriteU32(bw, len);
+      Buffer_Write(bw, str, len);
+      break;
+    }
+    case RSValue_Array:
+      Buffer_WriteU8(bw, RSValue_Array);
+      Buffer_WriteU32(bw, v->arrval.len);
+      for (uint32_t i = 0; i < v->arrval.len; i++) {
+        RSValue_Serialize(v->arrval.vals[i], bw);
+      }
+      break;
+    case RSValue_Map:
+      Buffer_WriteU8(bw, RSValue_Map);
+      Buffer_WriteU32(bw, v->mapval.len);
+      for (uint32_t i = 0; i < v->mapval.len; i++) {
+        RSValue_Serialize(v->mapval.pairs[RSVALUE_MAP_KEYPOS(i)], bw);
+        RSValue_Serialize(v->mapval.pairs[RSVALUE_MAP_VALUEPOS(i)], bw);
+      }
+      break;
+    case RSValue_Duo:
+      Buffer_WriteU8(bw, RSValue_Duo);
+      RSValue_Serialize(RS_DUOVAL_VAL(*v), bw);
+      RSValue_Serialize(RS_DUOVAL_OTHERVAL(*v), bw);
+      RSValue_Serialize(RS_DUOVAL_OTHER2VAL(*v), bw);
+      break;
+    default:
+      Buffer_WriteU8(bw, RSValue_Null);
+      break;
+  }
+}
+
+RSValue *RSValue_Deserialize(BufferReader *br) {
+  switch (Buffer_ReadU8(br)) {
+    case RSValue_Number: {
+      double d;
+      Buffer_Read(br, &d, sizeof(d));
+      return RS_NumVal(d);
+    }
+    case RSValue_String: {
+      uint32_t len = Buffer_ReadU32(br);
+      RSValue *v = RS_NewCopiedString(br->buf->data + br->pos, len);
+      Buffer_Seek(br, br->pos + len);
+      return v;
+    }
+    case RSValue_Array: {
+      uint32_t len = Buffer_ReadU32(br);
+      RSValue **vals = rm_calloc(len, sizeof(*vals));
+      for (uint32_t i = 0; i < len; i++) {
+        vals[i] = RSValue_Deserialize(br);
+      }
+      return RSValue_NewArrayEx(vals, len, RSVAL_ARRAY_ALLOC | RSVAL_ARRAY_NOINCREF);
+    }
+    case RSValue_Map: {
+      uint32_t len = Buffer_ReadU32(br);
+      RSValue **pairs = rm_calloc(len * 2, sizeof(*pairs));
+      for (uint32_t i = 0; i < len * 2; i++) {
+        pairs[i] = RSValue_Deserialize(br);
+      }
+      return RSValue_NewMap(pairs, len);
+    }
+    case RSValue_Duo: {
+      RSValue *val = RSValue_Deserialize(br);
+      RSValue *otherval = RSValue_Deserialize(br);
+      RSValue *other2val = RSValue_Deserialize(br);
+      return RS_DuoVal(val, otherval, other2val);
+    }
+    default:
+      return RS_NullVal();
+  }
+}
+
 void RSValue_Print(const RSValue *v) {
   FILE *fp = stderr;
   if (!v) {
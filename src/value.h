@@ -11,6 +11,7 @@
 #include "rmalloc.h"
 #include "query_error.h"
 #include "reply.h"
+#include "buffer.h"
 
 #include "util/fnv.h"
 
@@ -123,14 +124,16 @@ typedef struct RSValue {
     // reference to another value
     struct RSValue *ref;
   };
-  RSValueType t : 7;
+  RSValueType t : 6;
   uint8_t allocated : 1;
+  // Whether a short string is stored in the allocation of the value, right after it
+  uint8_t inlinestr : 1;
   uint16_t refcount;
 
 #ifdef __cplusplus
   RSValue() {
   }
-  RSValue(RSValueType t_) : ref(NULL), t(t_), refcount(0), allocated(0) {
+  RSValue(RSValueType t_) : ref(NULL), t(t_), refcount(0), allocated(0), inlinestr(0) {
   }
 
 #endif
@@ -289,8 +292,13 @@ static inline RSValue *RSValue_MakePersistent(RSValue *v) {
   return v;
 }
 
+// Strings up to this length are copied into the allocation of their value
+#define RSVALUE_INLINE_STR_MAX 22
+
 /**
  * Copies a string using the default mechanism. Returns the copied value.
+ * A string of up to RSVALUE_INLINE_STR_MAX bytes is stored along with the value, saving an
+ * allocation and a pointer chase for the short fields of the rows.
  */
 RSValue *RS_NewCopiedString(const char *s, size_t dst);
 
@@ -460,6 +468,13 @@ int RSValue_SendReply(RedisModule_Reply *reply, const RSValue *v, SendReplyFlags
 
 void RSValue_Print(const RSValue *v);
 
+/* Write a value to a buffer, to be read back by RSValue_Deserialize. References are written as the
+ * values they refer to, and strings of any kind as plain strings */
+void RSValue_Serialize(const RSValue *v, BufferWriter *bw);
+
+/* Read a value written by RSValue_Serialize. The value is owned by the caller */
+RSValue *RSValue_Deserialize(BufferReader *br);
+
 int RSValue_ArrayAssign(RSValue **args, int argc, const char *fmt, ...);
 
 #ifdef __cplusplus
@@ -12,6 +12,7 @@
 #include <string.h>
 #include <sys/param.h>
 #include "rmalloc.h"
+#include "util/bitpack.h"
 
 // static int msb = (int)(~0ULL << 25);
 
@@ -38,6 +39,16 @@ static size_t varintEncodeFieldMask(t_fieldMask value, uint8_t *vbuf) {
 #define VARINT_BUF(buf, pos) ((buf) + pos)
 #define VARINT_LEN(pos) (sizeof(varintBuf) - (pos))
 
+/* The encoded length of a varint, without encoding it */
+static inline size_t varintLen(uint32_t value) {
+  size_t n = 1;
+  while (value >>= 7) {
+    --value;
+    ++n;
+  }
+  return n;
+}
+
 size_t WriteVarintRaw(uint32_t value, char *buf) {
   varintBuf varint;
   size_t pos = varintEncode(value, varint);
@@ -119,3 +130,94 @@ size_t VVW_Write(VarintVectorWriter *w, uint32_t i) {
 size_t VVW_Truncate(VarintVectorWriter *w) {
   return Buffer_Truncate(&w->buf, 0);
 }
+
+/* Pick the bit width minimizing the size of a packed frame of n deltas. Returns the width, and sets
+ * the frame's byte length and number of exceptions */
+static uint8_t packedFrameWidth(const uint32_t *deltas, size_t n, size_t *len, uint8_t *nexc) {
+  const uint8_t maxWidth = BitPack_Width(deltas, n);
+  uint8_t width = maxWidth;
+  *len = 2 + BITPACK_LEN(n, width);
+  *nexc = 0;
+  for (uint8_t b = 0; b < maxWidth; ++b) {
+    size_t sz = 2 + BITPACK_LEN(n, b);
+    uint8_t exc = 0;
+    for (size_t i = 0; i < n && sz < *len; ++i) {
+      if (deltas[i] >> b) {
+        sz += 1 + varintLen(deltas[i] >> b);
+        ++exc;
+      }
+    }
+    if (sz < *len) {
+      width = b;
+      *len = sz;
+      *nexc = exc;
+    }
+  }
+  return width;
+}
+
+size_t VVW_Pack(VarintVectorWriter *w) {
+  uint32_t n = w->nmemb;
+  if (!n) {
+    return 0;
+  }
+
+  uint32_t *deltas = rm_malloc(n * sizeof(*deltas));
+  BufferReader br = NewBufferReader(&w->buf);
+  for (uint32_t i = 0; i < n; ++i) {
+    deltas[i] = ReadVarint(&br);
+  }
+
+  // The plain mode takes one more bit for the first delta, which must fit in 31 bits
+  size_t firstLen = varintLen(deltas[0]);
+  int plain = deltas[0] < (1U << 31);
+  size_t plainLen = w->buf.offset - firstLen + varintLen(deltas[0] << 1);
+  size_t packedLen = varintLen((n << 1) | 1);
+  for (uint32_t i = 0; i < n && (!plain || packedLen < plainLen); i += VVW_PACKED_FRAME_SIZE) {
+    size_t frameLen;
+    uint8_t nexc;
+    packedFrameWidth(deltas + i, MIN(n - i, VVW_PACKED_FRAME_SIZE), &frameLen, &nexc);
+    packedLen += frameLen;
+  }
+  plain = plain && plainLen <= packedLen;
+
+  // The deltas were read out of the buffer, so the vector is re-encoded in place
+  size_t outLen = plain ? plainLen : packedLen;
+  if (outLen > w->buf.cap) {
+    Buffer_Grow(&w->buf, outLen - w->buf.offset);
+  }
+  char *p = w->buf.data;
+  if (plain) {
+    size_t restLen = w->buf.offset - firstLen;
+    memmove(p + varintLen(deltas[0] << 1), w->buf.data + firstLen, restLen);
+    p += WriteVarintRaw(deltas[0] << 1, p);
+    p += restLen;
+  } else {
+    p += WriteVarintRaw((n << 1) | 1, p);
+    uint32_t low[VVW_PACKED_FRAME_SIZE];
+    for (uint32_t i = 0; i < n; i += VVW_PACKED_FRAME_SIZE) {
+      const uint32_t *frame = deltas + i;
+      size_t len = MIN(n - i, VVW_PACKED_FRAME_SIZE);
+      size_t frameLen;
+      uint8_t nexc;
+      uint8_t width = packedFrameWidth(frame, len, &frameLen, &nexc);
+      const uint32_t mask = width < 32 ? (1U << width) - 1 : UINT32_MAX;
+      for (size_t j = 0; j < len; ++j) {
+        low[j] = frame[j] & mask;
+      }
+      *p++ = width;
+      *p++ = nexc;
+      p += BitPack_Pack(low, len, width, (uint8_t *)p);
+      for (size_t j = 0; nexc && j < len; ++j) {
+        if (width < 32 && frame[j] >> width) {
+          *p++ = j;
+          p += WriteVarintRaw(frame[j] >> width, p);
+        }
+      }
+    }
+  }
+  rm_free(deltas);
+
+  w->buf.offset = p - w->buf.data;
+  return w->buf.offset;
+}
@@ -75,6 +75,21 @@ static inline void VVW_Reset(VarintVectorWriter *w) {
   w->buf.offset = 0;
 }
 
+/* Packed offset vectors (see Index_PackedOffsets). A vector starts with a varint holding a mode bit:
+ * - even: the vector is a plain delta varint vector, and the varint is its first delta shifted left
+ *   by one.
+ * - odd: the varint is the number of deltas shifted left by one, and the deltas follow in frames of
+ *   up to VVW_PACKED_FRAME_SIZE. A frame holds its bit width b and its number of exceptions (a byte
+ *   each), the low b bits of each delta, and for each exception - a delta which does not fit in b
+ *   bits - its position in the frame (a byte) and a varint of its remaining high bits.
+ * The writer picks the smaller of the two, and the bit width which minimizes each frame's size. */
+#define VVW_PACKED_FRAME_SIZE 128
+
+/* Re-encode the vector in the packed offsets format, in its buffer. The buffer is only reallocated
+ * if it has no spare byte for the mode bit, or the first delta does not fit in 31 bits. Nothing
+ * can be written to the vector afterwards, until it is reset. Returns the new byte length */
+size_t VVW_Pack(VarintVectorWriter *w);
+
 #define VVW_GetCount(vvw) ((vvw) ? (vvw)->nmemb : 0)
 #define VVW_GetByteLength(vvw) ((vvw) ? (vvw)->buf.offset : 0)
 #define VVW_GetByteData(vvw) ((vvw) ? (vvw)->buf.data : NULL)
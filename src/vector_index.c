@@ -11,6 +11,9 @@
 #include "rdb.h"
 #include "util/workers_pool.h"
 #include "util/threadpool_api.h"
+#include "util/timeout.h"
+
+#include <math.h>
 
 static VecSimIndex *openVectorKeysDict(IndexSpec *spec, RedisModuleString *keyName, int write) {
   KeysDictValue *kdv = dictFetchValue(spec->keysDict, keyName);
@@ -70,7 +73,62 @@ IndexIterator *createMetricIteratorFromVectorQueryResults(VecSimQueryReply *repl
   return NewMetricIterator(docIdsList, metricList, VECTOR_DISTANCE, yields_metric);
 }
 
-IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it) {
+// Measure the distance of every result of `filter` from the query vector, and keep the ones within
+// the radius. The results of the filter are read in the order of their ids, so the metric iterator
+// is sorted by id like the reply of the range query is.
+static IndexIterator *rangeAmongFilter(VecSimIndex *vecsim, VecSimIndexBasicInfo *info,
+                                       VectorQuery *vq, IndexIterator *filter,
+                                       struct timespec timeout, VectorQueryStats *stats,
+                                       QueryError *status) {
+  size_t vecLen = info->dim * VecSimType_sizeof(info->type);
+  void *qvector = vq->range.vector;
+  if (info->metric == VecSimMetric_Cosine) {
+    qvector = rm_malloc(vecLen);
+    memcpy(qvector, vq->range.vector, vecLen);
+    VecSim_Normalize(qvector, info->dim, info->type);
+  }
+
+  TimeoutCtx timeoutCtx = {.timeout = timeout, .counter = 0};
+  t_docId *docIdsList = array_new(t_docId, 16);
+  double *metricList = array_new(double, 16);
+  bool timedOut = false;
+  RSIndexResult *res;
+  int rc;
+  VecSimTieredIndex_AcquireSharedLocks(vecsim);
+  while ((rc = filter->Read(filter->ctx, &res)) == INDEXREAD_OK || rc == INDEXREAD_NOTFOUND) {
+    if (TimedOut_WithCtx(&timeoutCtx)) {
+      timedOut = true;
+      break;
+    }
+    if (rc == INDEXREAD_NOTFOUND) continue;
+    stats->distances++;
+    double metric = VecSimIndex_GetDistanceFrom_Unsafe(vecsim, res->docId, qvector);
+    // The distance of a document which has no vector (or whose vector was deleted) is NaN
+    if (!isnan(metric) && metric <= vq->range.radius) {
+      docIdsList = array_append(docIdsList, res->docId);
+      metricList = array_append(metricList, metric);
+    }
+  }
+  VecSimTieredIndex_ReleaseSharedLocks(vecsim);
+  // The filter is intersected with the range as well
+  filter->Rewind(filter->ctx);
+  if (qvector != vq->range.vector) {
+    rm_free(qvector);
+  }
+
+  if (timedOut || rc == INDEXREAD_TIMEOUT || !array_len(docIdsList)) {
+    array_free(docIdsList);
+    array_free(metricList);
+    if (timedOut || rc == INDEXREAD_TIMEOUT) {
+      QueryError_SetError(status, QUERY_TIMEDOUT, NULL);
+    }
+    return NULL;
+  }
+  return NewMetricIterator(docIdsList, metricList, VECTOR_DISTANCE, vq->scoreField != NULL);
+}
+
+IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it,
+                                 uint64_t filterKey, IndexIterator *rangeFilter) {
   RedisSearchCtx *ctx = q->sctx;
   RedisModuleString *key = RedisModule_CreateStringPrintf(ctx->redisCtx, "%s", vq->property);
   VecSimIndex *vecsim = openVectorKeysDict(ctx->spec, key, 0);
@@ -78,6 +136,9 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
   if (!vecsim) {
     return NULL;
   }
+  // The stats of a field are counters which the queries add to, under the read lock of the spec
+  FieldSpec *fs = (FieldSpec *)IndexSpec_GetField(ctx->spec, vq->property, strlen(vq->property));
+  VectorQueryStats *fieldStats = fs ? &fs->vectorOpts.queryStats : NULL;
 
   VecSimIndexBasicInfo info = VecSimIndex_BasicInfo(vecsim);
   size_t dim = info.dim;
@@ -109,6 +170,8 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
                                       .ignoreDocScore = q->opts->flags & Search_IgnoreScores,
                                       .childIt = child_it,
                                       .timeout = q->sctx->timeout,
+                                      .filterKey = filterKey,
+                                      .fieldStats = fieldStats,
       };
       return NewHybridVectorIterator(hParams, q->status);
     }
@@ -131,6 +194,18 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
                                     &qParams, QUERY_TYPE_RANGE, q->status) != VecSim_OK)  {
         return NULL;
       }
+      // A selective filter has fewer results than the range may have, measure their distances
+      // rather than getting the whole range from the vector index
+      if (rangeFilter && rangeFilter->NumEstimated(rangeFilter->ctx) <=
+                             VECTOR_RANGE_FILTER_MAX_RATIO * VecSimIndex_IndexSize(vecsim)) {
+        VectorQueryStats stats = {.queries = 1};
+        IndexIterator *it = rangeAmongFilter(vecsim, &info, vq, rangeFilter, q->sctx->timeout,
+                                             &stats, q->status);
+        if (fieldStats) {
+          VectorQueryStats_Add(fieldStats, &stats);
+        }
+        return it;
+      }
       qParams.timeoutCtx = &(TimeoutCtx){ .timeout = q->sctx->timeout, .counter = 0 };
       VecSimQueryReply *results =
           VecSimIndex_RangeQuery(vecsim, vq->range.vector, vq->range.radius,
@@ -140,6 +215,9 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
         QueryError_SetError(q->status, QUERY_TIMEDOUT, NULL);
         return NULL;
       }
+      if (fieldStats) {
+        VectorQueryStats_Add(fieldStats, &(VectorQueryStats){.queries = 1});
+      }
       bool yields_metric = vq->scoreField != NULL;
       return createMetricIteratorFromVectorQueryResults(results, yields_metric);
     }
@@ -147,6 +225,13 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
   return NULL;
 }
 
+void VectorQueryStats_Add(VectorQueryStats *to, const VectorQueryStats *from) {
+  __atomic_add_fetch(&to->queries, from->queries, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&to->distances, from->distances, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&to->batches, from->batches, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&to->batchResults, from->batchResults, __ATOMIC_RELAXED);
+}
+
 int VectorQuery_EvalParams(dict *params, QueryNode *node, QueryError *status) {
   for (size_t i = 0; i < QueryNode_NumParams(node); i++) {
     int res = QueryParam_Resolve(&node->params[i], params, status);
@@ -195,6 +280,27 @@ void VectorQuery_Free(VectorQuery *vq) {
   rm_free(vq);
 }
 
+SharedVectorFilter *NewSharedVectorFilter() {
+  SharedVectorFilter *f = rm_calloc(1, sizeof(*f));
+  pthread_mutex_init(&f->lock, NULL);
+  f->refcount = 1;
+  return f;
+}
+
+SharedVectorFilter *SharedVectorFilter_Incref(SharedVectorFilter *f) {
+  __atomic_add_fetch(&f->refcount, 1, __ATOMIC_RELAXED);
+  return f;
+}
+
+void SharedVectorFilter_Decref(SharedVectorFilter *f) {
+  if (__atomic_sub_fetch(&f->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  array_free(f->ids);
+  pthread_mutex_destroy(&f->lock);
+  rm_free(f);
+}
+
 const char *VecSimType_ToString(VecSimType type) {
   switch (type) {
     case VecSimType_FLOAT32: return VECSIM_TYPE_FLOAT32;
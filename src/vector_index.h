@@ -10,6 +10,9 @@
 #include "index_iterator.h"
 #include "query_node.h"
 #include "query_ctx.h"
+#include "util/arr.h"
+
+#include <pthread.h>
 
 #define VECSIM_TYPE_FLOAT32 "FLOAT32"
 #define VECSIM_TYPE_FLOAT64 "FLOAT64"
@@ -111,12 +114,39 @@ typedef struct VecSimLogCtx {
 VecSimIndex *OpenVectorIndex(IndexSpec *sp,
   RedisModuleString *keyName/*, RedisModuleKey **idxKey*/);
 
-IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it);
+/* A range query intersected with a filter whose estimated number of results is at most this
+ * ratio of the size of the vector index measures the distance of every result of the filter,
+ * rather than getting the whole range from the vector index */
+#define VECTOR_RANGE_FILTER_MAX_RATIO 0.05
+
+/* Create the iterator of a vector query. `child_it`, the filter of a KNN query, is owned by the
+ * iterator. `rangeFilter`, an optional iterator a range query is intersected with, is borrowed:
+ * it may be read and is then rewound */
+IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it,
+                                 uint64_t filterKey, IndexIterator *rangeFilter);
+
+/* Add the stats of a query to the stats of its field, which other queries add to concurrently */
+void VectorQueryStats_Add(VectorQueryStats *to, const VectorQueryStats *from);
 
 int VectorQuery_EvalParams(dict *params, QueryNode *node, QueryError *status);
 int VectorQuery_ParamResolve(VectorQueryParams params, size_t index, dict *paramsDict, QueryError *status);
 void VectorQuery_Free(VectorQuery *vq);
 
+/* The ids matching the filter of the KNN clause of a MULTIVECTOR query, shared by the queries of
+ * all its vectors (see QEXEC_F_MULTI_VECTOR). The first of them to be evaluated reads the filter,
+ * the others iterate over its ids. The queries run concurrently on the workers, and each holds a
+ * reference */
+typedef struct SharedVectorFilter {
+  pthread_mutex_t lock;
+  bool evaluated;
+  arrayof(t_docId) ids;  // sorted
+  size_t refcount;
+} SharedVectorFilter;
+
+SharedVectorFilter *NewSharedVectorFilter();
+SharedVectorFilter *SharedVectorFilter_Incref(SharedVectorFilter *f);
+void SharedVectorFilter_Decref(SharedVectorFilter *f);
+
 VecSimResolveCode VecSim_ResolveQueryParams(VecSimIndex *index, VecSimRawParam *params, size_t params_len,
                                             VecSimQueryParams *qParams, VecsimQueryType queryType, QueryError *status);
 size_t VecSimType_sizeof(VecSimType type);
@@ -0,0 +1,34 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// The number of times every measure is repeated, of which the median is reported
+#define BENCH_RUNS 5
+
+// Every run of the benchmarks draws the same numbers
+#define BENCH_SEED 47
+
+/* The median time in nanoseconds per operation of BENCH_RUNS runs of `run`, which returns the
+ * number of operations it did. `setup` is called before every run, out of the measure */
+static inline double measure(std::function<size_t()> run, std::function<void()> setup = [] {}) {
+  std::vector<double> times;
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    size_t ops = run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    times.push_back(ops ? ns / ops : 0);
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
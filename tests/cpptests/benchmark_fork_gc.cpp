@@ -0,0 +1,249 @@
+
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+
+#include "redismodule.h"
+#include "module.h"
+#include "version.h"
+
+#include "src/config.h"
+#include "src/fork_gc.h"
+#include "src/redisearch_api.h"
+#include "src/spec.h"
+
+#include "bench_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    return RediSearch_InitModuleInternal(ctx, argv, argc);
+}
+
+}
+
+// The words of the documents follow Zipf's law over a vocabulary of this size
+#define VOCABULARY_SIZE 10000
+// The lengths of the documents, in words, are drawn uniformly in this range
+#define MIN_DOC_LEN 5
+#define MAX_DOC_LEN 50
+// The cardinality of the tag field
+#define TAG_VALUES 100
+// The word the queries run during the cycles look for, matching about a tenth of the documents
+#define QUERY_WORD "w10"
+// The number of queries measuring the latency out of the cycles
+#define BASELINE_QUERIES 200
+
+// The fractions of the documents deleted before a cycle
+static const double deletionRates[] = {0.01, 0.1, 0.5};
+
+/* Which documents are deleted: drawn uniformly, the oldest ones as by an expiration, and runs of
+ * consecutive documents as by a bulk delete of related ones */
+enum DeletionPattern { DELETE_UNIFORM, DELETE_OLDEST, DELETE_CLUSTERED };
+static const char *patternNames[] = {"uniform", "oldest", "clustered"};
+#define CLUSTER_LEN 100
+
+static FILE *csv = NULL;
+
+static RSIndex *buildIndex(size_t numDocs, std::mt19937 &rng) {
+  RSIndexOptions *opts = RediSearch_CreateIndexOptions();
+  RediSearch_IndexOptionsSetGCPolicy(opts, GC_POLICY_FORK);
+  RSIndex *index = RediSearch_CreateIndex("idx", opts);
+  RediSearch_FreeIndexOptions(opts);
+  RediSearch_CreateTextField(index, "t");
+  RediSearch_CreateNumericField(index, "n");
+  RediSearch_CreateTagField(index, "g");
+
+  std::vector<double> weights(VOCABULARY_SIZE);
+  for (size_t i = 0; i < VOCABULARY_SIZE; i++) {
+    weights[i] = 1.0 / (i + 1);
+  }
+  std::discrete_distribution<size_t> word(weights.begin(), weights.end());
+  std::uniform_int_distribution<size_t> docLen(MIN_DOC_LEN, MAX_DOC_LEN);
+  std::uniform_real_distribution<> value(0, 1000000);
+
+  for (size_t i = 1; i <= numDocs; i++) {
+    std::string key = "doc" + std::to_string(i), text;
+    for (size_t n = docLen(rng); n; n--) {
+      text += "w" + std::to_string(word(rng)) + " ";
+    }
+    std::string tag = "tag" + std::to_string(rng() % TAG_VALUES);
+    RSDoc *d = RediSearch_CreateDocumentSimple(key.c_str());
+    RediSearch_DocumentAddFieldCString(d, "t", text.c_str(), RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldNumber(d, "n", std::floor(value(rng)), RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldCString(d, "g", tag.c_str(), RSFLDTYPE_DEFAULT);
+    RediSearch_SpecAddDocument(index, d);
+  }
+  return index;
+}
+
+static void deleteDocs(RSIndex *index, size_t numDocs, DeletionPattern pattern, double rate,
+                       std::mt19937 &rng) {
+  size_t toDelete = numDocs * rate;
+  std::vector<size_t> ids;
+  if (pattern == DELETE_OLDEST) {
+    for (size_t i = 1; i <= toDelete; i++) {
+      ids.push_back(i);
+    }
+  } else {
+    std::vector<char> deleted(numDocs + 1, 0);
+    size_t run = pattern == DELETE_CLUSTERED ? CLUSTER_LEN : 1;
+    std::uniform_int_distribution<size_t> start(1, numDocs);
+    while (ids.size() < toDelete) {
+      for (size_t i = start(rng), n = run; n && i <= numDocs && ids.size() < toDelete; i++, n--) {
+        if (!deleted[i]) {
+          deleted[i] = 1;
+          ids.push_back(i);
+        }
+      }
+    }
+  }
+  for (size_t id : ids) {
+    std::string key = "doc" + std::to_string(id);
+    RediSearch_DeleteDocument(index, key.c_str(), key.size());
+  }
+}
+
+// The time in microseconds of a query reading all the documents of QUERY_WORD
+static double runQuery(RSIndex *index) {
+  auto start = std::chrono::steady_clock::now();
+  RSQNode *qn = RediSearch_CreateTokenNode(index, "t", QUERY_WORD);
+  RSResultsIterator *it = RediSearch_GetResultsIterator(qn, index);
+  if (it) {
+    while (RediSearch_ResultsIteratorNext(it, index, NULL)) {
+    }
+    RediSearch_ResultsIteratorFree(it);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1000.0;
+}
+
+static double percentile(std::vector<double> &v, double p) {
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(v.size() * p))];
+}
+
+/* Build an index, delete some of its documents, and run a GC cycle while querying it. Reports the
+ * costs of the cycle to the parent, and the latency of the queries out of and during the cycle */
+static void benchCycle(RedisModuleCtx *ctx, size_t numDocs, DeletionPattern pattern, double rate,
+                       bool sharedMemory, std::mt19937 &rng) {
+  RSGlobalConfig.gcConfigParams.forkGc.forkGcSharedMemory = sharedMemory;
+  RSIndex *index = buildIndex(numDocs, rng);
+  ForkGC *fgc = (ForkGC *)((IndexSpec *)__RefManager_Get_Object(index))->gc->gcCtx;
+
+  std::vector<double> baseline;
+  for (size_t i = 0; i < BASELINE_QUERIES; i++) {
+    baseline.push_back(runQuery(index));
+  }
+
+  deleteDocs(index, numDocs, pattern, rate, rng);
+
+  std::atomic<bool> done(false);
+  double cycleMs = 0;
+  std::thread gcThread([&] {
+    auto start = std::chrono::steady_clock::now();
+    ((IndexSpec *)__RefManager_Get_Object(index))->gc->callbacks.periodicCallback(ctx, fgc);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cycleMs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0;
+    done = true;
+  });
+  std::vector<double> during;
+  while (!done) {
+    during.push_back(runQuery(index));
+  }
+  gcThread.join();
+
+  const ForkGCStats &st = fgc->stats;
+  printf("%-9zu %-10s %6g%% %-5s %10.2f %10.1f %12.1f %10.2f %10.2f %12.1f %9.1f %9.1f %9.1f %9.1f\n",
+         numDocs, patternNames[pattern], rate * 100, sharedMemory ? "shm" : "pipe", cycleMs,
+         st.lastForkNS / 1000.0, st.lastBytesReceived / 1024.0, st.lastApplyNS / 1000000.0,
+         st.lastLockedNS / 1000000.0, st.totalCollected / 1024.0, percentile(baseline, 0.5),
+         percentile(during, 0.5), percentile(during, 0.99), percentile(during, 1));
+  if (csv) {
+    fprintf(csv, "%zu,%s,%g,%s,%.3f,%.3f,%zu,%.3f,%.3f,%zu,%.3f,%.3f,%.3f,%.3f\n", numDocs,
+            patternNames[pattern], rate, sharedMemory ? "shm" : "pipe", cycleMs,
+            st.lastForkNS / 1000.0, st.lastBytesReceived, st.lastApplyNS / 1000000.0,
+            st.lastLockedNS / 1000000.0, st.totalCollected, percentile(baseline, 0.5),
+            percentile(during, 0.5), percentile(during, 0.99), percentile(during, 1));
+  }
+  RediSearch_DropIndex(index);
+}
+
+void SetUp() {
+    const char *arguments[] = {"SAFEMODE", "NOGC"};
+    RMCK_Bootstrap(my_OnLoad, arguments, 2);
+}
+
+void TearDown() {
+    RMCK_Shutdown();
+    RediSearch_CleanupModule();
+}
+
+/**
+ * Benchmark of the cycles of the fork GC, by the size of the index and the rate and pattern of the
+ * deletions: the time of a cycle, of the fork, the bytes the child sends, the time the parent
+ * applies the repairs and holds the write lock of the index while doing so, and the latency of the
+ * queries run during the cycle next to their latency out of it. The cycles run with the repairs
+ * sent through the pipe, and through the shared memory of FORK_GC_SHARED_MEMORY. The documents are
+ * drawn with a fixed seed, so that two builds are compared over the same data.
+ * Run with `make forkgc-bench`, or directly:
+ *   rsbench_forkgc [number of documents of the largest index (100000)] [CSV file to write the results to]
+ */
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    if (argc > 2 && !(csv = fopen(argv[2], "w"))) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    SetUp();
+    // the cycles are run by the benchmark only
+    RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec = 3600;
+    RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold = 0;
+    RSGlobalConfig.gcConfigParams.forkGc.forkGcSleepBeforeExit = 0;
+    RMCK::Context ctx;
+
+    printf("\nRunning fork GC benchmarks: up to %zu documents, query latencies in us\n\n", n);
+    printf("%-9s %-10s %7s %-5s %10s %10s %12s %10s %10s %12s %9s %9s %9s %9s\n", "docs",
+           "pattern", "deleted", "via", "cycle_ms", "fork_us", "received_kb", "apply_ms",
+           "locked_ms", "collected_kb", "q_p50", "q_gc_p50", "q_gc_p99", "q_gc_max");
+    if (csv) {
+        fprintf(csv, "docs,pattern,deleted,via,cycle_ms,fork_us,received_bytes,apply_ms,locked_ms,"
+                     "collected_bytes,query_p50_us,query_gc_p50_us,query_gc_p99_us,query_gc_max_us\n");
+    }
+
+    std::mt19937 rng;
+    rng.seed(BENCH_SEED);
+    for (size_t numDocs : {std::max<size_t>(n / 10, 1000), n}) {
+        for (int pattern = DELETE_UNIFORM; pattern <= DELETE_CLUSTERED; pattern++) {
+            for (double rate : deletionRates) {
+                benchCycle(ctx, numDocs, (DeletionPattern)pattern, rate, false, rng);
+            }
+        }
+        benchCycle(ctx, numDocs, DELETE_UNIFORM, 0.1, true, rng);
+    }
+
+    if (csv) {
+        fclose(csv);
+    }
+    TearDown();
+}
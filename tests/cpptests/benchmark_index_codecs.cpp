@@ -0,0 +1,331 @@
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+
+#include "redismodule.h"
+#include "module.h"
+#include "version.h"
+
+#include "src/buffer.h"
+#include "src/config.h"
+#include "src/forward_index.h"
+#include "src/index.h"
+#include "src/index_iterator.h"
+#include "src/inverted_index.h"
+#include "src/numeric_filter.h"
+#include "src/varint.h"
+
+#include "rmutil/alloc.h"
+
+#include "bench_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    return RediSearch_InitModuleInternal(ctx, argv, argc);
+}
+
+}
+
+// The encodings of the inverted indexes, one for every encoder and decoder pair
+static const struct {
+  const char *name;
+  uint32_t flags;
+} encodings[] = {
+    {"full", Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags},
+    {"full_wide", Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags |
+                      Index_WideSchema},
+    {"full_packed", Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags |
+                        Index_PackedOffsets},
+    {"freqs_fields", Index_StoreFreqs | Index_StoreFieldFlags},
+    {"freqs_fields_wide", Index_StoreFreqs | Index_StoreFieldFlags | Index_WideSchema},
+    {"freqs", Index_StoreFreqs},
+    {"fields", Index_StoreFieldFlags},
+    {"fields_wide", Index_StoreFieldFlags | Index_WideSchema},
+    {"fields_offsets", Index_StoreFieldFlags | Index_StoreTermOffsets},
+    {"fields_offsets_wide", Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema},
+    {"offsets", Index_StoreTermOffsets},
+    {"freqs_offsets", Index_StoreFreqs | Index_StoreTermOffsets},
+    {"docids", Index_DocIdsOnly},
+    {"docids_svb", Index_DocIdsOnly | Index_StreamVByte},
+};
+
+/* The gaps between the ids of the documents of a term: every document (a stop word), a geometric
+ * distribution of a common term, and of a rare one */
+static const struct {
+  const char *name;
+  double meanGap;
+} gapDistributions[] = {{"dense", 1}, {"common", 8}, {"rare", 1000}};
+
+static const size_t skipDistances[] = {1, 16, 256, 4096};
+
+// The fractions of the numeric values passing the filter, 0 for no filter
+static const double numericSelectivities[] = {0, 0.01, 0.1, 0.5, 1};
+
+static FILE *csv = NULL;
+
+// Report a measure as a row of the table, and of the CSV file if one was given
+static void report(const char *bench, const std::string &variant, const char *param,
+                   double nsPerOp, double bytesPerOp) {
+  printf("%-14s %-24s %-10s %12.2f %12.2f\n", bench, variant.c_str(), param, nsPerOp, bytesPerOp);
+  if (csv) {
+    fprintf(csv, "%s,%s,%s,%.3f,%.3f\n", bench, variant.c_str(), param, nsPerOp, bytesPerOp);
+  }
+}
+
+// The ids of `n` documents, with gaps drawn from a geometric distribution of mean `meanGap`
+static std::vector<t_docId> drawDocIds(size_t n, double meanGap, std::mt19937 &rng) {
+  std::vector<t_docId> ids(n);
+  std::geometric_distribution<uint32_t> gap(1 / meanGap);
+  t_docId id = 0;
+  for (size_t i = 0; i < n; i++) {
+    id += meanGap == 1 ? 1 : 1 + gap(rng);
+    ids[i] = id;
+  }
+  return ids;
+}
+
+// Term frequencies follow a Zipf-like distribution, most terms appear once in a document
+static std::vector<uint32_t> drawFreqs(size_t n, std::mt19937 &rng) {
+  std::vector<uint32_t> freqs(n);
+  std::uniform_real_distribution<> u(0, 1);
+  for (size_t i = 0; i < n; i++) {
+    freqs[i] = std::min<uint32_t>(1 / std::pow(u(rng) + 1e-9, 0.7), 1000);
+  }
+  return freqs;
+}
+
+// The bytes of the encoded entries of an index, out of the headers of its blocks
+static size_t indexBytes(const InvertedIndex *idx) {
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < idx->size; i++) {
+    bytes += IndexBlock_DataLen(&idx->blocks[i]);
+  }
+  return bytes;
+}
+
+static InvertedIndex *buildTermIndex(uint32_t flags, const std::vector<t_docId> &ids,
+                                     const std::vector<uint32_t> &freqs) {
+  InvertedIndex *idx = NewInvertedIndex((IndexFlags)flags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder((IndexFlags)flags);
+  VarintVectorWriter *vw = NewVarintVectorWriter(16);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ForwardIndexEntry ent = {0};
+    ent.docId = ids[i];
+    ent.freq = freqs[i];
+    ent.fieldMask = (t_fieldMask)1 << (i % 4);
+    VVW_Reset(vw);
+    for (uint32_t pos = 0, n = std::min<uint32_t>(freqs[i], 16); n--; pos += 1 + (i + n) % 50) {
+      VVW_Write(vw, pos);
+    }
+    ent.vw = vw;
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  }
+  VVW_Free(vw);
+  return idx;
+}
+
+static size_t readAll(IndexReader *ir) {
+  RSIndexResult *res;
+  size_t n = 0;
+  while (IR_Read(ir, &res) == INDEXREAD_OK) {
+    n++;
+  }
+  return n;
+}
+
+// Encode, decode and skip through every encoding, over every distribution of the ids
+static void benchCodecs(size_t n, std::mt19937 &rng) {
+  for (const auto &dist : gapDistributions) {
+    std::vector<t_docId> ids = drawDocIds(n, dist.meanGap, rng);
+    std::vector<uint32_t> freqs = drawFreqs(n, rng);
+    for (const auto &enc : encodings) {
+      std::string variant = std::string(enc.name) + "/" + dist.name;
+      size_t bytes = 0;
+      double encodeNs = measure([&] {
+        InvertedIndex *idx = buildTermIndex(enc.flags, ids, freqs);
+        bytes = indexBytes(idx);
+        InvertedIndex_Free(idx);
+        return ids.size();
+      });
+      report("encode", variant, "-", encodeNs, (double)bytes / n);
+
+      InvertedIndex *idx = buildTermIndex(enc.flags, ids, freqs);
+      double decodeNs = measure([&] {
+        IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+        size_t read = readAll(ir);
+        IR_Free(ir);
+        return read;
+      });
+      report("decode", variant, "-", decodeNs, 0);
+
+      for (size_t distance : skipDistances) {
+        char param[32];
+        snprintf(param, sizeof(param), "%zu", distance);
+        double skipNs = measure([&] {
+          IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+          RSIndexResult *res;
+          size_t skips = 0;
+          // skip `distance` documents of the term ahead every time
+          for (size_t i = distance; i < ids.size(); i += distance, skips++) {
+            if (IR_SkipTo(ir, ids[i], &res) == INDEXREAD_EOF) break;
+          }
+          IR_Free(ir);
+          return skips;
+        });
+        report("skip_to", variant, param, skipNs, 0);
+      }
+      InvertedIndex_Free(idx);
+    }
+  }
+}
+
+// Write and read varints of the magnitudes of the docid deltas, frequencies and offsets
+static void benchVarints(size_t n, std::mt19937 &rng) {
+  static const struct {
+    const char *name;
+    uint32_t max;
+  } ranges[] = {{"1byte", 1 << 7}, {"2bytes", 1 << 14}, {"mixed", 1 << 28}};
+
+  for (const auto &range : ranges) {
+    std::vector<uint32_t> values(n);
+    std::uniform_int_distribution<uint32_t> bits(0, 31 - __builtin_clz(range.max));
+    for (size_t i = 0; i < n; i++) {
+      values[i] = (rng() & ((1u << bits(rng)) - 1)) % range.max;
+    }
+    Buffer buf;
+    Buffer_Init(&buf, n * 5);
+    double writeNs = measure(
+        [&] {
+          BufferWriter bw = NewBufferWriter(&buf);
+          for (uint32_t v : values) {
+            WriteVarint(v, &bw);
+          }
+          return values.size();
+        },
+        [&] { buf.offset = 0; });
+    report("write_varint", range.name, "-", writeNs, (double)buf.offset / n);
+
+    volatile uint32_t sink = 0;
+    double readNs = measure([&] {
+      BufferReader br = NewBufferReader(&buf);
+      uint32_t sum = 0;
+      for (size_t i = 0; i < n; i++) {
+        sum += ReadVarint(&br);
+      }
+      sink = sum;
+      return n;
+    });
+    report("read_varint", range.name, "-", readNs, 0);
+    Buffer_Free(&buf);
+  }
+}
+
+// Grow a buffer from its initial capacity by writes of a fixed size, as the index blocks are
+static void benchBufferGrow(size_t n) {
+  static const size_t writeSizes[] = {1, 4, 16, 128};
+  std::vector<char> data(128, 'x');
+  for (size_t size : writeSizes) {
+    char param[32];
+    snprintf(param, sizeof(param), "%zu", size);
+    Buffer buf;
+    size_t cap = 0;
+    double ns = measure(
+        [&] {
+          BufferWriter bw = NewBufferWriter(&buf);
+          for (size_t i = 0; i < n; i++) {
+            Buffer_Write(&bw, data.data(), size);
+          }
+          cap = buf.cap;
+          Buffer_Free(&buf);
+          return n;
+        },
+        [&] { Buffer_Init(&buf, 16); });
+    report("buffer_grow", "from16", param, ns, (double)cap / n);
+  }
+}
+
+// Read a numeric index of uniform values with filters of varying selectivity
+static void benchNumeric(size_t n, std::mt19937 &rng) {
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  std::uniform_real_distribution<> value(0, 1000000);
+  for (size_t i = 1; i <= n; i++) {
+    InvertedIndex_WriteNumericEntry(idx, i, std::floor(value(rng)));
+  }
+  for (double selectivity : numericSelectivities) {
+    char param[32];
+    snprintf(param, sizeof(param), selectivity ? "%g%%" : "none", selectivity * 100);
+    NumericFilter *flt = selectivity ? NewNumericFilter(0, 1000000 * selectivity, 1, 0, true) : NULL;
+    double ns = measure([&] {
+      IndexReader *ir = NewNumericReader(NULL, idx, flt, 0, 1000000, 0);
+      readAll(ir);
+      IR_Free(ir);
+      return n;
+    });
+    report("read_numeric", "uniform", param, ns, (double)indexBytes(idx) / n);
+    if (flt) {
+      NumericFilter_Free(flt);
+    }
+  }
+  InvertedIndex_Free(idx);
+}
+
+void SetUp() {
+    const char *arguments[] = {"SAFEMODE", "NOGC"};
+    RMCK_Bootstrap(my_OnLoad, arguments, 2);
+}
+
+void TearDown() {
+    RMCK_Shutdown();
+    RediSearch_CleanupModule();
+}
+
+/**
+ * Micro-benchmarks of the encodings of the inverted indexes: every encoder with its decoder and
+ * skipper over realistic distributions of the docid gaps and the frequencies, the varints, the
+ * growth of the buffers and the numeric reader with filters. Reports the median time per operation
+ * of BENCH_RUNS runs, and the bytes per entry where it applies. The numbers are drawn with a fixed
+ * seed, so that two builds are compared over the same data.
+ * Run with `make codecs-bench`, or directly:
+ *   rsbench_codecs [number of entries (1000000)] [CSV file to write the results to]
+ */
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    if (argc > 2 && !(csv = fopen(argv[2], "w"))) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    SetUp();
+    printf("\nRunning index codecs benchmarks: %zu entries, median of %d runs\n\n", n, BENCH_RUNS);
+    printf("%-14s %-24s %-10s %12s %12s\n", "benchmark", "variant", "param", "ns/op", "bytes/op");
+    if (csv) {
+        fprintf(csv, "benchmark,variant,param,ns_per_op,bytes_per_op\n");
+    }
+
+    std::mt19937 rng;
+    rng.seed(BENCH_SEED);
+    benchCodecs(n, rng);
+    benchVarints(n, rng);
+    benchBufferGrow(n);
+    benchNumeric(n, rng);
+
+    if (csv) {
+        fclose(csv);
+    }
+    TearDown();
+}
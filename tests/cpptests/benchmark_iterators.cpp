@@ -0,0 +1,419 @@
+
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+
+#include "redismodule.h"
+#include "module.h"
+#include "version.h"
+
+#include "src/config.h"
+#include "src/index.h"
+#include "src/index_iterator.h"
+#include "src/inverted_index.h"
+#include "src/numeric_filter.h"
+#include "src/numeric_index.h"
+#include "src/optimizer_reader.h"
+#include "src/query_optimizer.h"
+#include "src/redisearch_api.h"
+#include "src/search_ctx.h"
+#include "src/spec.h"
+
+#include "bench_utils.h"
+#include "index_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    return RediSearch_InitModuleInternal(ctx, argv, argc);
+}
+
+// declaration for an internal function implemented in numeric_index.c
+IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
+                                     const NumericFilter *f, IteratorsConfig *config);
+}
+
+// The terms of the synthetic text follow Zipf's law with this exponent, the i'th term appearing
+// in 1/i of the documents
+#define ZIPF_TERMS 1000
+#define ZIPF_EXPONENT 1.0
+
+// The widths of the unions, around the default MIN_UNION_ITERATOR_HEAP of 20
+static const size_t unionWidths[] = {2, 4, 8, 16, 20, 21, 32, 64, 128};
+
+// The ranks of the rarer terms intersected with the second most common one
+static const size_t intersectRanks[] = {2, 9, 99, 999};
+
+// The ranks of the terms negated, or made optional
+static const size_t termRanks[] = {1, 9, 99, 999};
+
+// The fractions of the documents passing the numeric filters
+static const double numericSelectivities[] = {0.001, 0.01, 0.1, 0.5};
+
+// The numbers of results the optimizer is asked for
+static const size_t optimizerLimits[] = {10, 100};
+
+static FILE *csv = NULL;
+
+// Report a measure as a row of the table, and of the CSV file if one was given
+static void report(const char *bench, const std::string &variant, const std::string &param,
+                   double nsPerOp, size_t results) {
+  printf("%-16s %-24s %-12s %14.2f %10zu\n", bench, variant.c_str(), param.c_str(), nsPerOp,
+         results);
+  if (csv) {
+    fprintf(csv, "%s,%s,%s,%.3f,%zu\n", bench, variant.c_str(), param.c_str(), nsPerOp, results);
+  }
+}
+
+static size_t readAll(IndexIterator *it) {
+  RSIndexResult *res;
+  size_t n = 0;
+  while (it->Read(it->ctx, &res) == INDEXREAD_OK) {
+    n++;
+  }
+  return n;
+}
+
+/* The median time per result of reading all the results of the iterators `make` builds, out of
+ * building and freeing them. `perQuery` measures the time of the whole read instead */
+static double measureReads(std::function<IndexIterator *()> make, size_t *results,
+                           bool perQuery = false) {
+  IndexIterator *it = NULL;
+  double ns = measure(
+      [&] {
+        *results = readAll(it);
+        return perQuery ? 1 : *results;
+      },
+      [&] {
+        if (it) it->Free(it);
+        it = make();
+      });
+  it->Free(it);
+  return ns;
+}
+
+static std::string format(const char *fmt, double value) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), fmt, value);
+  return buf;
+}
+
+// The indexes of synthetic posting lists, with the iterators over them
+class Postings {
+ public:
+  Postings(const std::vector<std::vector<t_docId>> &lists, IndexFlags flags = INDEX_DEFAULT_FLAGS)
+      : lists_(lists) {
+    for (const auto &ids : lists) {
+      indexes_.push_back(createIndexFromIds(ids, flags));
+    }
+  }
+  ~Postings() {
+    for (InvertedIndex *idx : indexes_) {
+      InvertedIndex_Free(idx);
+    }
+  }
+
+  size_t len(size_t i) const { return lists_[i].size(); }
+
+  IndexIterator *iterator(size_t i) const {
+    return NewReadIterator(NewTermIndexReader(indexes_[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+  }
+
+  // An array of the iterators of the lists [from, from + num), as the unions and intersections
+  // take ownership of
+  IndexIterator **iterators(size_t from, size_t num) const {
+    IndexIterator **its = (IndexIterator **)rm_calloc(num, sizeof(*its));
+    for (size_t i = 0; i < num; i++) {
+      its[i] = iterator(from + i);
+    }
+    return its;
+  }
+
+ private:
+  const std::vector<std::vector<t_docId>> &lists_;
+  std::vector<InvertedIndex *> indexes_;
+};
+
+/* Reading a common term from documents of growing lengths, in which it occurs more often and has
+ * more offsets to decode */
+static void benchRead(const std::vector<t_docId> &ids) {
+  for (uint32_t freq : {1, 4, 16}) {
+    InvertedIndex *idx = createIndexFromIds(ids, INDEX_DEFAULT_FLAGS, freq);
+    size_t results;
+    double ns = measureReads(
+        [&] { return NewReadIterator(NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1)); },
+        &results);
+    report("read", "term", format("freq=%g", freq), ns, results);
+    InvertedIndex_Free(idx);
+  }
+}
+
+/* Unions of terms overlapping by Zipf's law, and of the disjoint values of a tag field, of every
+ * width in flat and heap mode, to find where the heap pays off */
+static void benchUnion(const Postings &terms, size_t numDocs, std::mt19937 &rng) {
+  IteratorsConfig config;
+  iteratorsConfig_init(&config);
+
+  for (size_t width : unionWidths) {
+    std::vector<std::vector<t_docId>> tagLists = createTagPostings(numDocs, width, rng);
+    Postings tags(tagLists, Index_DocIdsOnly);
+
+    for (int heap = 0; heap <= 1; heap++) {
+      config.minUnionIterHeap = heap ? 1 : LLONG_MAX;
+      const char *mode = heap ? "heap" : "flat";
+      size_t results;
+      double ns = measureReads(
+          [&] {
+            return NewUnionIterator(terms.iterators(0, width), width, NULL, 0, 1, QN_UNION, NULL,
+                                    &config);
+          },
+          &results);
+      report("union", std::string("zipf/") + mode, format("%g", width), ns, results);
+
+      ns = measureReads(
+          [&] {
+            return NewUnionIterator(tags.iterators(0, width), width, NULL, 0, 1, QN_UNION, NULL,
+                                    &config);
+          },
+          &results);
+      report("union", std::string("tags/") + mode, format("%g", width), ns, results);
+    }
+  }
+}
+
+/* Intersections of the second most common term with rarer ones, which should cost about the
+ * length of the rarer list, and of three terms */
+static void benchIntersect(const Postings &terms) {
+  for (size_t rank : intersectRanks) {
+    size_t results;
+    double ns = measureReads(
+        [&] {
+          IndexIterator **its = (IndexIterator **)rm_calloc(2, sizeof(*its));
+          its[0] = terms.iterator(1);
+          its[1] = terms.iterator(rank);
+          return NewIntersecIterator(its, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+        },
+        &results, true);
+    report("intersect", "2_terms", format("1:%.0f", (double)terms.len(1) / terms.len(rank)), ns,
+           results);
+  }
+
+  size_t results;
+  double ns = measureReads(
+      [&] {
+        IndexIterator **its = (IndexIterator **)rm_calloc(3, sizeof(*its));
+        its[0] = terms.iterator(1);
+        its[1] = terms.iterator(9);
+        its[2] = terms.iterator(99);
+        return NewIntersecIterator(its, 3, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+      },
+      &results, true);
+  report("intersect", "3_terms", "1,9,99", ns, results);
+}
+
+// Negate, or make optional, terms of every frequency over all the documents
+static void benchNotOptional(const Postings &terms, size_t numDocs) {
+  for (size_t rank : termRanks) {
+    std::string param = format("%g", rank);
+    size_t results;
+    double ns = measureReads([&] { return NewNotIterator(terms.iterator(rank), numDocs, 1, NULL); },
+                             &results);
+    report("not", "zipf", param, ns, results);
+
+    ns = measureReads([&] { return NewOptionalIterator(terms.iterator(rank), numDocs, 1); },
+                      &results);
+    report("optional", "zipf", param, ns, results);
+
+    // an optional term scoring the matches of a common one, as in `hello ~world`
+    ns = measureReads(
+        [&] {
+          IndexIterator **its = (IndexIterator **)rm_calloc(2, sizeof(*its));
+          its[0] = terms.iterator(1);
+          its[1] = NewOptionalIterator(terms.iterator(rank), numDocs, 1);
+          return NewIntersecIterator(its, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+        },
+        &results);
+    report("optional", "in_intersect", param, ns, results);
+  }
+}
+
+/* Numeric filters of every selectivity over trees of values of several distributions, which split
+ * the trees into ranges of different shapes */
+static void benchNumeric(size_t numDocs, std::mt19937 &rng) {
+  static const char *distributions[] = {"uniform", "sequential", "zipf", "100_values"};
+  IteratorsConfig config;
+  iteratorsConfig_init(&config);
+
+  for (const char *dist : distributions) {
+    std::vector<double> values(numDocs);
+    std::uniform_real_distribution<> u(0, 1);
+    for (size_t i = 0; i < numDocs; i++) {
+      if (!strcmp(dist, "uniform")) {
+        values[i] = std::floor(u(rng) * 1000000);
+      } else if (!strcmp(dist, "sequential")) {
+        values[i] = i;
+      } else if (!strcmp(dist, "zipf")) {
+        values[i] = std::floor(1 / (u(rng) + 1e-6));
+      } else {
+        values[i] = rng() % 100;
+      }
+    }
+    NumericRangeTree *t = NewNumericRangeTree();
+    for (size_t i = 0; i < numDocs; i++) {
+      NumericRangeTree_Add(t, i + 1, values[i], 0);
+    }
+    std::string variant = std::string(dist) + format("/%g_ranges", t->numRanges);
+
+    // the filters start at the 20th percentile of the values, and span their selectivity
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    for (double selectivity : numericSelectivities) {
+      size_t from = numDocs / 5, to = std::min(numDocs - 1, from + (size_t)(numDocs * selectivity));
+      NumericFilter *flt = NewNumericFilter(sorted[from], sorted[to], 1, 1, true);
+      size_t results;
+      double ns = measureReads(
+          [&] {
+            IndexIterator *it = createNumericIterator(NULL, t, flt, &config);
+            return it ? it : NewEmptyIterator();
+          },
+          &results);
+      report("numeric", variant, format("%g%%", selectivity * 100), ns, results);
+      NumericFilter_Free(flt);
+    }
+    NumericRangeTree_Free(t);
+  }
+}
+
+/* The top results of terms of every frequency sorted by a numeric field, by the optimizer which
+ * pages through the ranges of the field, and by reading all the matches as without it */
+static void benchOptimizer(size_t numDocs, std::mt19937 &rng) {
+  RSIndexOptions *opts = RediSearch_CreateIndexOptions();
+  RediSearch_IndexOptionsSetGCPolicy(opts, GC_POLICY_NONE);
+  RSIndex *index = RediSearch_CreateIndex("idx", opts);
+  RediSearch_FreeIndexOptions(opts);
+  RediSearch_CreateNumericField(index, "n");
+  std::uniform_real_distribution<> value(0, 1000000);
+  for (size_t i = 1; i <= numDocs; i++) {
+    std::string key = "doc" + std::to_string(i);
+    RSDoc *d = RediSearch_CreateDocumentSimple(key.c_str());
+    RediSearch_DocumentAddFieldNumber(d, "n", std::floor(value(rng)), RSFLDTYPE_DEFAULT);
+    RediSearch_SpecAddDocument(index, d);
+  }
+  IndexSpec *spec = (IndexSpec *)__RefManager_Get_Object(index);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, spec);
+  IteratorsConfig config;
+  iteratorsConfig_init(&config);
+
+  // the ids of the documents are 1..numDocs, in the order they were added
+  std::vector<std::vector<t_docId>> lists = createZipfPostings(numDocs, ZIPF_TERMS, ZIPF_EXPONENT, rng);
+  for (size_t rank : {(size_t)0, (size_t)9, (size_t)99, (size_t)999}) {
+    const std::vector<t_docId> &ids = lists[rank];
+    std::string variant = format("%g_docs", ids.size());
+    for (size_t limit : optimizerLimits) {
+      std::string param = format("limit=%g", limit);
+      QOptimizer *opt = QOptimizer_New();
+      opt->type = Q_OPT_HYBRID;
+      opt->limit = limit;
+      opt->asc = true;
+      opt->fieldName = "n";
+      opt->sctx = &sctx;
+      size_t results;
+      double ns = measureReads(
+          [&] {
+            // the iterator frees the filter it creates when there is none
+            opt->nf = NULL;
+            IndexIterator *child = NewBorrowedIdListIterator(ids.data(), ids.size(), 1);
+            return NewOptimizerIterator(opt, child, &config);
+          },
+          &results, true);
+      report("optimizer", variant, param, ns, results);
+      QOptimizer_Free(opt);
+    }
+
+    NumericFilter *all = NewNumericFilter(NF_NEGATIVE_INFINITY, NF_INFINITY, 1, 1, true);
+    all->fieldName = rm_strdup("n");
+    size_t results;
+    double ns = measureReads(
+        [&] {
+          IndexIterator **its = (IndexIterator **)rm_calloc(2, sizeof(*its));
+          its[0] = NewBorrowedIdListIterator(ids.data(), ids.size(), 1);
+          its[1] = NewNumericFilterIterator(&sctx, all, NULL, INDEXFLD_T_NUMERIC, &config);
+          return NewIntersecIterator(its, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+        },
+        &results, true);
+    report("no_optimizer", variant, "all", ns, results);
+    NumericFilter_Free(all);
+  }
+  RediSearch_DropIndex(index);
+}
+
+void SetUp() {
+    const char *arguments[] = {"SAFEMODE", "NOGC"};
+    RMCK_Bootstrap(my_OnLoad, arguments, 2);
+}
+
+void TearDown() {
+    RMCK_Shutdown();
+    RediSearch_CleanupModule();
+}
+
+/**
+ * Micro-benchmarks of the query iterators over synthetic indexes, out of the networking and the
+ * result processors which the benchmarks of tests/benchmarks measure as well: reading terms from
+ * documents of growing lengths, unions in flat and heap mode around MIN_UNION_ITERATOR_HEAP,
+ * intersections of terms of skewed frequencies, NOT and OPTIONAL, numeric filters over trees of
+ * several distributions, and the optimizer of the queries sorted by a numeric field. The terms
+ * follow Zipf's law and the numbers are drawn with a fixed seed, so that two builds are compared over the same data. Reports the median time per result of
+ * BENCH_RUNS runs, or per query for the intersections and the optimizer, with the number of
+ * results. Run with `make iterators-bench`, or directly:
+ *   rsbench_iterators [number of documents (1000000)] [CSV file to write the results to]
+ */
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    if (argc > 2 && !(csv = fopen(argv[2], "w"))) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    SetUp();
+    printf("\nRunning iterators benchmarks: %zu documents, median of %d runs\n\n", n, BENCH_RUNS);
+    printf("%-16s %-24s %-12s %14s %10s\n", "benchmark", "variant", "param", "ns/op", "results");
+    if (csv) {
+        fprintf(csv, "benchmark,variant,param,ns_per_op,results\n");
+    }
+
+    std::mt19937 rng;
+    rng.seed(BENCH_SEED);
+    std::vector<std::vector<t_docId>> lists = createZipfPostings(n, ZIPF_TERMS, ZIPF_EXPONENT, rng);
+    benchRead(lists[1]);
+    {
+        Postings terms(lists);
+        benchUnion(terms, n, rng);
+        benchIntersect(terms);
+        benchNotOptional(terms, n);
+    }
+    benchNumeric(n, rng);
+    // the documents of the optimizer are added to a spec, a tenth of them is enough
+    benchOptimizer(std::max<size_t>(n / 10, 1000), rng);
+
+    if (csv) {
+        fclose(csv);
+    }
+    TearDown();
+}
@@ -0,0 +1,296 @@
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+
+#include "redismodule.h"
+#include "module.h"
+#include "version.h"
+
+#include "src/index.h"
+#include "src/inverted_index.h"
+#include "src/numeric_filter.h"
+#include "src/hybrid_reader.h"
+
+#include "rmalloc.h"
+#include "rmutil/alloc.h"
+#include "index_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+extern "C" {
+
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    return RediSearch_InitModuleInternal(ctx, argv, argc);
+}
+
+}
+
+// The filters of the sweep, each passing every <step>-th document of the index
+enum FilterType { FILTER_TEXT, FILTER_TAG, FILTER_NUMERIC, FILTER_UNION, FILTER_INTERSECT };
+static const char *filterNames[] = {"text", "tag", "numeric", "union", "intersect"};
+
+// Fraction of the documents passing the filter is 1/step: 0.01%, 0.1%, 1%, 10%, 50% and 100%
+static const size_t steps[] = {10000, 1000, 100, 10, 2, 1};
+
+static const size_t ks[] = {10, 100};
+static const size_t efRuntimes[] = {10, 100, 500};
+
+struct SweepFilter {
+  FilterType type;
+  std::vector<InvertedIndex *> indexes;
+  NumericFilter *nf = NULL;
+};
+
+// A tag-like inverted index holding the ids [start, start+step, start+2*step, ...]
+static InvertedIndex *createTagIndex(size_t size, size_t step, size_t start) {
+  InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(Index_DocIdsOnly);
+  for (size_t i = 0; i < size; i++) {
+    t_docId id = start + i * step;
+    RSIndexResult rec = {.type = RSResultType_Virtual, .docId = id, .offsetsSz = 0, .freq = 0};
+    InvertedIndex_WriteEntryGeneric(idx, enc, id, &rec);
+  }
+  return idx;
+}
+
+static SweepFilter buildFilter(FilterType type, size_t max_id, size_t step,
+                               InvertedIndex *numericIndex) {
+  SweepFilter f;
+  f.type = type;
+  size_t n = max_id / step;
+  switch (type) {
+    case FILTER_TEXT:
+      f.indexes.push_back(createIndex(n, step, step));
+      break;
+    case FILTER_TAG:
+      f.indexes.push_back(createTagIndex(n, step, step));
+      break;
+    case FILTER_NUMERIC:
+      // Every document has its id as value, the range [1, n] passes n of them
+      f.indexes.push_back(numericIndex);
+      f.nf = NewNumericFilter(1, n, 1, 1, true);
+      break;
+    case FILTER_UNION:
+      // The odd and the even multiples of step
+      f.indexes.push_back(createIndex((n + 1) / 2, 2 * step, step));
+      if (n / 2) f.indexes.push_back(createIndex(n / 2, 2 * step, 2 * step));
+      break;
+    case FILTER_INTERSECT: {
+      // step = a * b with a a power of 2 and b odd, the multiples of a and of b intersect at the
+      // multiples of step
+      size_t a = step & -step, b = step / a;
+      f.indexes.push_back(createIndex(max_id / a, a, a));
+      f.indexes.push_back(createTagIndex(max_id / b, b, b));
+      break;
+    }
+  }
+  return f;
+}
+
+static void freeFilter(SweepFilter &f) {
+  if (f.nf) {
+    NumericFilter_Free(f.nf);
+    return;  // The numeric index is shared by the sweep
+  }
+  for (InvertedIndex *idx : f.indexes) {
+    InvertedIndex_Free(idx);
+  }
+}
+
+// A new iterator over the filter, the hybrid iterator takes ownership of it
+static IndexIterator *newFilterIterator(const SweepFilter &f, IteratorsConfig *config) {
+  if (f.type == FILTER_NUMERIC) {
+    return NewReadIterator(NewNumericReader(NULL, f.indexes[0], f.nf, f.nf->min, f.nf->max, true));
+  }
+  size_t num = f.indexes.size();
+  IndexIterator **its = (IndexIterator **)rm_calloc(num, sizeof(*its));
+  for (size_t i = 0; i < num; i++) {
+    its[i] = NewReadIterator(NewTermIndexReader(f.indexes[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+  }
+  switch (f.type) {
+    case FILTER_UNION:
+      return NewUnionIterator(its, num, NULL, 0, 1, QN_UNION, NULL, config);
+    case FILTER_INTERSECT:
+      return NewIntersecIterator(its, num, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+    default: {
+      IndexIterator *it = its[0];
+      rm_free(its);
+      return it;
+    }
+  }
+}
+
+struct SweepResult {
+  std::vector<double> latencies;  // in microseconds
+  std::vector<std::vector<t_docId>> ids;
+  size_t numBatches = 0;
+};
+
+static SweepResult runQueries(VecSimIndex *index, size_t d, const std::vector<float> &queries,
+                              size_t num_queries, const SweepFilter &f, size_t k,
+                              VecSimSearchMode mode, size_t efRuntime) {
+  SweepResult res;
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  for (size_t i = 0; i < num_queries; i++) {
+    KNNVectorQuery top_k_query = {.vector = (void *)(queries.data() + i * d), .vecLen = d, .k = k,
+                                  .order = BY_SCORE};
+    VecSimQueryParams queryParams = {.hnswRuntimeParams = HNSWRuntimeParams{.efRuntime = efRuntime}};
+    queryParams.searchMode = mode;
+    HybridIteratorParams hParams = {.index = index,
+                                    .dim = d,
+                                    .elementType = VecSimType_FLOAT32,
+                                    .spaceMetric = VecSimMetric_L2,
+                                    .query = top_k_query,
+                                    .qParams = queryParams,
+                                    .vectorScoreField = (char *)"__v_score",
+                                    .ignoreDocScore = true,
+                                    .childIt = NULL,
+                                    // No timeout
+                                    .timeout = {.tv_sec = 1L << 31, .tv_nsec = 0}};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    hParams.childIt = newFilterIterator(f, &config);
+    QueryError err = {QUERY_OK};
+    IndexIterator *hybridIt = NewHybridVectorIterator(hParams, &err);
+    assert(hybridIt && !QueryError_HasError(&err));
+    std::vector<t_docId> ids;
+    RSIndexResult *h = NULL;
+    while (hybridIt->Read(hybridIt->ctx, &h) != INDEXREAD_EOF) {
+      ids.push_back(h->docId);
+    }
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    res.latencies.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+    res.numBatches += ((HybridIterator *)hybridIt->ctx)->numIterations;
+    res.ids.push_back(ids);
+    hybridIt->Free(hybridIt);
+  }
+  return res;
+}
+
+static double recall(const SweepResult &res, const SweepResult &truth) {
+  size_t correct = 0, total = 0;
+  for (size_t i = 0; i < truth.ids.size(); i++) {
+    std::set<t_docId> expected(truth.ids[i].begin(), truth.ids[i].end());
+    for (t_docId id : res.ids[i]) {
+      correct += expected.count(id);
+    }
+    total += expected.size();
+  }
+  return total ? (double)correct / total : 1;
+}
+
+static void report(const char *filter, size_t step, size_t k, const char *policy, size_t ef,
+                   SweepResult &res, const SweepResult &truth) {
+  std::vector<double> &lat = res.latencies;
+  std::sort(lat.begin(), lat.end());
+  double sum = 0;
+  for (double l : lat) sum += l;
+  char efStr[32] = "-";
+  if (ef) snprintf(efStr, sizeof(efStr), "%zu", ef);
+  printf("%-10s %10.4f %5zu %-8s %6s %12.1f %12.1f %12.1f %9.2f %8.4f\n", filter, 100.0 / step, k,
+         policy, efStr, sum / lat.size(), lat[lat.size() / 2], lat[lat.size() * 99 / 100],
+         (double)res.numBatches / lat.size(), recall(res, truth));
+}
+
+void SetUp() {
+    const char *arguments[] = {"SAFEMODE", "NOGC"};
+    RMCK_Bootstrap(my_OnLoad, arguments, 2);
+}
+
+void TearDown() {
+    RMCK_Shutdown();
+    RediSearch_CleanupModule();
+}
+
+/**
+ * Sweeps the hybrid (filtered KNN) queries over the selectivity of their filter, for every kind of
+ * filter (a text term, a tag, a numeric range, a union and an intersection), k, EF_RUNTIME and
+ * hybrid policy (AD-HOC brute force, BATCHES, or the heuristic choosing between them). Reports the
+ * latency of the queries and their recall against the exact results of the AD-HOC brute force.
+ * Run with `make vecsim-hybrid-sweep`, or directly:
+ *   rsbench_hybrid_sweep [index size (100000)] [dim (128)] [number of queries (100)]
+ */
+int main(int argc, char **argv) {
+    size_t max_id = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t d = argc > 2 ? strtoul(argv[2], NULL, 10) : 128;
+    size_t num_queries = argc > 3 ? strtoul(argv[3], NULL, 10) : 100;
+
+    SetUp();
+    printf("\nRunning hybrid queries selectivity sweep: index size %zu, d %zu, %zu queries\n",
+           max_id, d, num_queries);
+
+    std::mt19937 rng;
+    rng.seed(47);
+    std::uniform_real_distribution<> distrib;
+    std::vector<float> data(max_id * d);
+    for (size_t i = 0; i < max_id * d; ++i) {
+        data[i] = (float)distrib(rng);
+    }
+    std::vector<float> queries(num_queries * d);
+    for (size_t i = 0; i < num_queries * d; ++i) {
+        queries[i] = (float)distrib(rng);
+    }
+
+    VecSimParams params{.algo = VecSimAlgo_HNSWLIB,
+                        .algoParams = {.hnswParams = HNSWParams{.type = VecSimType_FLOAT32,
+                                                                .dim = d,
+                                                                .metric = VecSimMetric_L2,
+                                                                .initialCapacity = max_id,
+                                                                .M = 16,
+                                                                .efConstruction = 200}}};
+    VecSimIndex *index = VecSimIndex_New(&params);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < max_id; i++) {
+        VecSimIndex_AddVector(index, data.data() + d * i, (int)i + 1);
+    }
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    printf("Build time: %lld ms\n\n",
+           (long long)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    assert(VecSimIndex_IndexSize(index) == max_id);
+
+    InvertedIndex *numericIndex = NewInvertedIndex(Index_StoreNumeric, 1);
+    for (size_t i = 1; i <= max_id; i++) {
+        InvertedIndex_WriteNumericEntry(numericIndex, i, i);
+    }
+
+    printf("%-10s %10s %5s %-8s %6s %12s %12s %12s %9s %8s\n", "filter", "selectivity%", "k",
+           "policy", "ef", "avg(us)", "p50(us)", "p99(us)", "batches", "recall");
+    for (int type = FILTER_TEXT; type <= FILTER_INTERSECT; type++) {
+      for (size_t step : steps) {
+        if (step > max_id) continue;
+        SweepFilter f = buildFilter((FilterType)type, max_id, step, numericIndex);
+        for (size_t k : ks) {
+          // The exact results, and the latency of the AD-HOC brute force, which EF_RUNTIME does
+          // not affect
+          SweepResult truth = runQueries(index, d, queries, num_queries, f, k,
+                                         VECSIM_HYBRID_ADHOC_BF, 0);
+          report(filterNames[type], step, k, "adhoc", 0, truth, truth);
+          for (size_t ef : efRuntimes) {
+            SweepResult batches = runQueries(index, d, queries, num_queries, f, k,
+                                             VECSIM_HYBRID_BATCHES, ef);
+            report(filterNames[type], step, k, "batches", ef, batches, truth);
+            SweepResult heuristic = runQueries(index, d, queries, num_queries, f, k,
+                                               (VecSimSearchMode)0, ef);
+            report(filterNames[type], step, k, "auto", ef, heuristic, truth);
+          }
+        }
+        freeFilter(f);
+      }
+    }
+
+    InvertedIndex_Free(numericIndex);
+    VecSimIndex_Free(index);
+    TearDown();
+}
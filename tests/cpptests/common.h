@@ -21,14 +21,6 @@
 
 #define get_spec(x) ((IndexSpec*)__RefManager_Get_Object(x))
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-#include "rwlock.h"
-#ifdef __cplusplus
-}
-#endif
-
 namespace RS {
 
 static void donecb(RSAddDocumentCtx *aCtx, RedisModuleCtx *, void *) {
@@ -37,7 +29,6 @@ static void donecb(RSAddDocumentCtx *aCtx, RedisModuleCtx *, void *) {
 
 template <typename... Ts>
 bool addDocument(RedisModuleCtx *ctx, RSIndex *index, const char *docid, Ts... args) {
-  RWLOCK_ACQUIRE_WRITE();
   RMCK::ArgvList argv(ctx, args...);
   AddDocumentOptions options = {0};
   options.numFieldElems = argv.size();
@@ -51,7 +42,6 @@ bool addDocument(RedisModuleCtx *ctx, RSIndex *index, const char *docid, Ts... a
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, get_spec(index));
   int rv = RS_AddDocument(&sctx, RMCK::RString(docid), &options, &status);
   RedisModule_FreeString(ctx, options.keyStr);
-  RWLOCK_RELEASE();
   return rv == REDISMODULE_OK;
 }
 
@@ -2,6 +2,8 @@
 #include "src/index.h"
 #include "src/inverted_index.h"
 
+#include <cmath>
+
 InvertedIndex *createIndex(int size, int idStep, int start_with) {
     InvertedIndex *idx = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
 
@@ -35,3 +37,46 @@ InvertedIndex *createIndex(int size, int idStep, int start_with) {
 
     return idx;
 }
+
+InvertedIndex *createIndexFromIds(const std::vector<t_docId> &ids, IndexFlags flags, uint32_t freq) {
+    InvertedIndex *idx = NewInvertedIndex(flags, 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+    VarintVectorWriter *vw = NewVarintVectorWriter(8);
+    for (uint32_t n = 0; n < freq; n++) {
+        VVW_Write(vw, 1);
+    }
+    for (t_docId id : ids) {
+        ForwardIndexEntry h = {0};
+        h.docId = id;
+        h.fieldMask = 1;
+        h.freq = freq;
+        h.vw = vw;
+        InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    }
+    VVW_Free(vw);
+    return idx;
+}
+
+std::vector<std::vector<t_docId>> createZipfPostings(size_t numDocs, size_t numTerms, double s,
+                                                     std::mt19937 &rng) {
+    std::vector<std::vector<t_docId>> postings(numTerms);
+    for (size_t i = 0; i < numTerms; i++) {
+        // the gaps between the documents of a term are geometric, so that drawing them takes the
+        // length of its list, rather than the number of documents
+        std::geometric_distribution<t_docId> gap(1 / std::pow(i + 1, s));
+        for (t_docId id = 1 + gap(rng); id <= numDocs; id += 1 + gap(rng)) {
+            postings[i].push_back(id);
+        }
+    }
+    return postings;
+}
+
+std::vector<std::vector<t_docId>> createTagPostings(size_t numDocs, size_t cardinality,
+                                                    std::mt19937 &rng) {
+    std::vector<std::vector<t_docId>> postings(cardinality);
+    std::uniform_int_distribution<size_t> tag(0, cardinality - 1);
+    for (t_docId id = 1; id <= numDocs; id++) {
+        postings[tag(rng)].push_back(id);
+    }
+    return postings;
+}
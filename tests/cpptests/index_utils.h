@@ -6,4 +6,21 @@
 
 #include "inverted_index.h"
 
+#include <random>
+#include <vector>
+
 InvertedIndex *createIndex(int size, int idStep, int start_with=0);
+
+/* An index of the given sorted ids, with `freq` occurrences of the term in every document */
+InvertedIndex *createIndexFromIds(const std::vector<t_docId> &ids, IndexFlags flags = INDEX_DEFAULT_FLAGS,
+                                  uint32_t freq = 1);
+
+/* The sorted ids of the documents of `numTerms` terms over the documents 1..numDocs, the i'th term
+ * appearing in 1/(i+1)^s of them, as the words of a text do by Zipf's law */
+std::vector<std::vector<t_docId>> createZipfPostings(size_t numDocs, size_t numTerms, double s,
+                                                     std::mt19937 &rng);
+
+/* The sorted ids of the documents 1..numDocs with each of `cardinality` tags, every document
+ * having one of them, drawn uniformly */
+std::vector<std::vector<t_docId>> createTagPostings(size_t numDocs, size_t cardinality,
+                                                    std::mt19937 &rng);
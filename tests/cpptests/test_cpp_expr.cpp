@@ -1,9 +1,13 @@
 #include "gtest/gtest.h"
 #include "aggregate/expr/expression.h"
 #include "aggregate/expr/exprast.h"
+#include "aggregate/expr/exprprog.h"
 #include "aggregate/functions/function.h"
 #include "util/arr.h"
 
+#include <cmath>
+#include <vector>
+
 class ExprTest : public ::testing::Test {
  public:
   static void SetUpTestCase() {
@@ -262,3 +266,109 @@ TEST_F(ExprTest, testPropertyFetch) {
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
 }
+
+TEST_F(ExprTest, testProgram) {
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  auto *kfoo = RLookup_GetKey(&lk, "foo", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  auto *kbar = RLookup_GetKey(&lk, "bar", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  auto *kprod = RLookup_GetKey(&lk, "prod", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  const size_t n = 4;
+  SearchResult results[n] = {};
+  const double foos[n] = {1, -3.5, 4, 7};
+  const double bars[n] = {2, 0, 5, 0};
+  for (size_t ii = 0; ii < n; ++ii) {
+    RLookup_WriteOwnKey(kfoo, &results[ii].rowdata, RS_NumVal(foos[ii]));
+    if (ii == 2) {
+      // converted by the arithmetic operators, but compared as a string
+      RLookup_WriteOwnKey(kbar, &results[ii].rowdata, RS_ConstStringValC("5"));
+    } else if (ii != 3) {
+      RLookup_WriteOwnKey(kbar, &results[ii].rowdata, RS_NumVal(bars[ii]));
+    }
+    if (ii != 3) {
+      RLookup_WriteOwnKey(kprod, &results[ii].rowdata, RS_NumVal(foos[ii] * bars[ii]));
+    }
+  }
+
+  TEvalCtx prod("@foo * @bar");
+  prod.lookup = &lk;
+  ASSERT_EQ(EXPR_EVAL_OK, prod.bindLookupKeys());
+  arrayof(ExprReuse) reuse = array_new(ExprReuse, 1);
+  ExprReuse r = {.expr = prod.root, .key = kprod};
+  reuse = array_append(reuse, r);
+
+  // the compiled program agrees with the recursive evaluator, wherever it doesn't fall back to it
+  auto check = [&](const char *s, const ExprReuse *reuse, std::vector<bool> expectedFallback) {
+    TEvalCtx ctx(s);
+    ASSERT_TRUE(ctx) << ctx.error();
+    ctx.lookup = &lk;
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys()) << s;
+    ExprProgram *p = ExprProgram_Compile(ctx.root, reuse);
+    ASSERT_TRUE(p) << s;
+
+    std::vector<double> regs(ExprProgram_NumRegisters(p) * n);
+    bool fallback[n];
+    const double *nums = ExprProgram_Eval(p, results, n, regs.data(), fallback);
+    for (size_t ii = 0; ii < n; ++ii) {
+      ASSERT_EQ(expectedFallback[ii], fallback[ii]) << s << " at " << ii;
+      if (fallback[ii]) {
+        continue;
+      }
+      ctx.srcrow = &results[ii].rowdata;
+      ASSERT_EQ(EXPR_EVAL_OK, ctx.eval()) << s;
+      ASSERT_EQ(RSValue_Number, ctx.result().t) << s;
+      if (std::isnan(ctx.result().numval)) {
+        ASSERT_TRUE(std::isnan(nums[ii])) << s << " at " << ii;
+      } else {
+        ASSERT_DOUBLE_EQ(ctx.result().numval, nums[ii]) << s << " at " << ii;
+      }
+    }
+    ExprProgram_Free(p);
+  };
+
+  std::vector<bool> none = {false, false, false, true};
+  check("@foo + @bar * 2", NULL, none);
+  check("(@foo * @bar) / 100 + 3 * (@foo * @bar)", NULL, none);
+  check("@foo % @bar - 1 / @bar", NULL, none);
+  check("@foo ^ 2 - (1 + 2) * 4", NULL, {false, false, false, false});
+  check("'2' * @foo", NULL, {false, false, false, false});
+  check("@foo < @bar", NULL, {false, false, true, true});
+  check("@foo == 4 || @bar >= 1", NULL, {false, false, true, true});
+  check("!(@foo >= 1) && 1 + 1 == 2", NULL, {false, false, false, false});
+  check("!@foo", NULL, {false, false, false, false});
+  // by the column kernels of the functions, which leave their NULL results to the evaluator
+  check("sqrt(@foo) + 1", NULL, {false, false, false, false});
+  check("floor(@foo) + abs(@bar - 1)", NULL, none);
+  check("hour(@foo * 5000) + day(@foo * 100000)", NULL, {false, true, false, false});
+  check("year(@foo) == 1970", NULL, {false, true, false, false});
+  // reads @prod instead of multiplying again
+  check("(@foo * @bar) / 100 + 3 * (@foo * @bar)", reuse, none);
+  check("@foo + @bar * 2", reuse, none);
+
+  TEvalCtx ctx("(@foo * @bar) / 100 + 3 * (@foo * @bar)");
+  ctx.lookup = &lk;
+  ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys());
+  ExprProgram *p = ExprProgram_Compile(ctx.root, NULL);
+  ExprProgram *reusing = ExprProgram_Compile(ctx.root, reuse);
+  // @foo, @bar, *, 100, /, 3, *, + with the product computed once, or read from @prod instead
+  ASSERT_EQ(8, ExprProgram_NumRegisters(p));
+  ASSERT_EQ(6, ExprProgram_NumRegisters(reusing));
+  ExprProgram_Free(p);
+  ExprProgram_Free(reusing);
+
+  // evaluated as they are, or by functions
+  const char *uncompiled[] = {"@foo",           "1",         "timefmt(@foo)", "@foo == 'bar'",
+                              "!(NULL)",        "lower(@foo)", "sqrt(@foo, 2)"};
+  for (auto s : uncompiled) {
+    TEvalCtx ctx(s);
+    ctx.lookup = &lk;
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys()) << s;
+    ASSERT_FALSE(ExprProgram_Compile(ctx.root, NULL)) << s;
+  }
+
+  array_free(reuse);
+  for (size_t ii = 0; ii < n; ++ii) {
+    RLookupRow_Cleanup(&results[ii].rowdata);
+  }
+  RLookup_Cleanup(&lk);
+}
@@ -200,3 +200,87 @@ TEST_F(ExtTest, testQueryExpander_v2) {
   QAST_Destroy(&qast);
   ASSERT_EQ(1, numFreed);
 }
+
+TEST_F(ExtTest, testBatchScoring) {
+  // already loaded by a previous test, if any
+  Extension_Load("default", DefaultExtensionInit);
+
+  RSToken tok1 = {.str = (char *)"hello", .len = 5};
+  RSToken tok2 = {.str = (char *)"world", .len = 5};
+  RSQueryTerm *t1 = NewQueryTerm(&tok1, 1), *t2 = NewQueryTerm(&tok2, 2);
+  t1->idf = 1.7;
+  t1->bm25_idf = 0.9;
+  t2->idf = 3.2;
+  t2->bm25_idf = 2.4;
+
+  // a single term, and a union of both terms
+  RSIndexResult *leaf = NewTokenRecord(t1, 0.5);
+  leaf->freq = 3;
+  RSIndexResult *child = NewTokenRecord(t2, 1);
+  child->freq = 2;
+  RSIndexResult *uni = NewUnionResult(2, 0.8);
+  AggregateResult_AddChild(uni, leaf);
+  AggregateResult_AddChild(uni, child);
+
+  RSDocumentMetadata dmds[2] = {};
+  dmds[0].score = 2;
+  dmds[0].len = 10;
+  dmds[0].maxFreq = 4;
+  dmds[1].score = 0.5;
+  dmds[1].len = 3;
+  dmds[1].maxFreq = 2;
+  const RSIndexResult *results[2] = {leaf, uni};
+
+  double docScores[2] = {dmds[0].score, dmds[1].score};
+  uint32_t docLens[2] = {10, 3}, docMaxFreqs[2] = {4, 2};
+  int slops[2] = {IndexResult_MinOffsetDelta(leaf), IndexResult_MinOffsetDelta(uni)};
+  double weights[2] = {1, uni->weight};
+  uint32_t leafStart[3] = {0, 1, 3};
+  uint32_t leafResults[3] = {0, 1, 1};
+  RSResultType leafTypes[3] = {RSResultType_Term, RSResultType_Term, RSResultType_Term};
+  double leafWeights[3] = {leaf->weight, leaf->weight, child->weight};
+  double freqs[3] = {3, 3, 2};
+  double idfs[3] = {t1->idf, t1->idf, t2->idf};
+  double bm25Idfs[3] = {t1->bm25_idf, t1->bm25_idf, t2->bm25_idf};
+  double leafScores[3];
+  RSScoringBatch batch = {
+      .numResults = 2,
+      .docScores = docScores,
+      .docLens = docLens,
+      .docMaxFreqs = docMaxFreqs,
+      .slops = slops,
+      .weights = weights,
+      .leafStart = leafStart,
+      .numLeaves = 3,
+      .leafResults = leafResults,
+      .leafTypes = leafTypes,
+      .leafWeights = leafWeights,
+      .freqs = freqs,
+      .idfs = idfs,
+      .bm25Idfs = bm25Idfs,
+      .leafScores = leafScores,
+  };
+
+  // the batch versions score exactly as the scalar scorers do
+  for (const char *name : {DEFAULT_SCORER_NAME, TFIDF_DOCNORM_SCORER_NAME, BM25_SCORER_NAME,
+                           BM25_STD_SCORER_NAME}) {
+    ScoringFunctionArgs scargs = {0};
+    ExtScoringFunctionCtx *sx = Extensions_GetScoringFunction(&scargs, name);
+    ASSERT_TRUE(sx != NULL);
+    ASSERT_TRUE(sx->bsf != NULL) << name;
+    scargs.indexStats.avgDocLen = 6.5;
+    double scores[2];
+    sx->bsf(&scargs, &batch, 0, scores);
+    for (int i = 0; i < 2; i++) {
+      ASSERT_EQ(sx->sf(&scargs, results[i], &dmds[i], 0), scores[i]) << name << " " << i;
+    }
+  }
+
+  // scorers without a batch version are scored one by one
+  ScoringFunctionArgs scargs = {0};
+  ASSERT_TRUE(Extensions_GetScoringFunction(&scargs, DISMAX_SCORER_NAME)->bsf == NULL);
+
+  IndexResult_Free(uni);
+  IndexResult_Free(leaf);
+  IndexResult_Free(child);
+}
@@ -7,7 +7,6 @@
 #include "rules.h"
 #include "query_error.h"
 #include "inverted_index.h"
-#include "rwlock.h"
 extern "C" {
 #include "util/dict.h"
 }
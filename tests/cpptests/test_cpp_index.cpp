@@ -1,6 +1,8 @@
 #include "src/buffer.h"
+#include "src/byte_offsets.h"
 #include "src/index.h"
 #include "src/inverted_index.h"
+#include "src/index_buffers.h"
 #include "src/index_result.h"
 #include "src/query_parser/tokenizer.h"
 #include "src/spec.h"
@@ -24,6 +26,8 @@
 #include <time.h>
 #include <float.h>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <cstdint>
 #include <random>
 #include <chrono>
@@ -138,6 +142,159 @@ TEST_F(IndexTest, testDistance) {
   VVW_Free(vw3);
 }
 
+static std::vector<uint32_t> readOffsets(RSOffsetIterator *it) {
+  std::vector<uint32_t> ret;
+  for (uint32_t n; RS_OFFSETVECTOR_EOF != (n = it->Next(it->ctx, NULL));) {
+    ret.push_back(n);
+  }
+  return ret;
+}
+
+TEST_F(IndexTest, testPackedOffsets) {
+  // Several frames of small deltas, with a few exceptions
+  std::vector<uint32_t> expected;
+  uint32_t pos = 0;
+  for (int i = 0; i < 1000; i++) {
+    pos += (i % 97 == 0) ? 100000 + i : 1 + i % 7;
+    expected.push_back(pos);
+  }
+  // A short vector keeps the varints, a huge first delta forces the frames
+  std::vector<std::vector<uint32_t>> vectors = {expected, {3, 200}, {3000000000u, 3000000001u}};
+
+  for (const auto &offsets : vectors) {
+    VarintVectorWriter *vw = NewVarintVectorWriter(8);
+    for (auto n : offsets) {
+      VVW_Write(vw, n);
+    }
+    size_t plainLen = VVW_GetByteLength(vw);
+    size_t packedLen = VVW_Pack(vw);
+    ASSERT_EQ(packedLen, VVW_GetByteLength(vw));
+    ASSERT_EQ(offsets.size(), VVW_GetCount(vw));
+    if (offsets.size() == expected.size()) {
+      ASSERT_LT(packedLen, plainLen / 2);
+    }
+
+    RSOffsetVector vec = offsetsFromVVW(vw);
+    vec.packed = 1;
+    RSOffsetIterator it = RSOffsetVector_Iterate(&vec, NULL);
+    ASSERT_EQ(offsets, readOffsets(&it));
+    it.Rewind(it.ctx);
+    ASSERT_EQ(offsets, readOffsets(&it));
+    it.Free(it.ctx);
+    VVW_Free(vw);
+  }
+
+  // Slop checks on packed vectors
+  VarintVectorWriter *vw = NewVarintVectorWriter(8);
+  VarintVectorWriter *vw2 = NewVarintVectorWriter(8);
+  for (auto n : {1, 9, 13, 16, 22}) {
+    VVW_Write(vw, n);
+  }
+  for (auto n : {4, 7, 32}) {
+    VVW_Write(vw2, n);
+  }
+  VVW_Pack(vw);
+  VVW_Pack(vw2);
+
+  RSIndexResult *tr1 = NewTokenRecord(NULL, 1);
+  tr1->docId = 1;
+  tr1->term.offsets = offsetsFromVVW(vw);
+  tr1->term.offsets.packed = 1;
+  RSIndexResult *tr2 = NewTokenRecord(NULL, 1);
+  tr2->docId = 1;
+  tr2->term.offsets = offsetsFromVVW(vw2);
+  tr2->term.offsets.packed = 1;
+
+  RSIndexResult *res = NewIntersectResult(2, 1);
+  AggregateResult_AddChild(res, tr1);
+  AggregateResult_AddChild(res, tr2);
+  ASSERT_EQ(2, IndexResult_MinOffsetDelta(res));
+  ASSERT_EQ(0, IndexResult_IsWithinRange(res, 0, 0));
+  ASSERT_EQ(0, IndexResult_IsWithinRange(res, 1, 1));
+  ASSERT_EQ(1, IndexResult_IsWithinRange(res, 1, 0));
+  ASSERT_EQ(1, IndexResult_IsWithinRange(res, 2, 1));
+
+  IndexResult_Free(tr1);
+  IndexResult_Free(tr2);
+  IndexResult_Free(res);
+  VVW_Free(vw);
+  VVW_Free(vw2);
+}
+
+extern "C" {
+int __indexResult_withinRangeInOrder(RSOffsetIterator *iters, uint32_t *positions, int num,
+                                     int maxSlop);
+int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positions, int num,
+                                       int maxSlop);
+}
+
+// The range checked through offset iterators, without decoding the offsets first
+static int iteratedWithinRange(RSIndexResult *res, int maxSlop, int inOrder) {
+  int num = res->agg.numChildren;
+  std::vector<RSOffsetIterator> iters(num);
+  std::vector<uint32_t> positions(num, 0);
+  for (int i = 0; i < num; i++) {
+    iters[i] = RSIndexResult_IterateOffsets(res->agg.children[i]);
+  }
+  int rc = inOrder ? __indexResult_withinRangeInOrder(iters.data(), positions.data(), num, maxSlop)
+                   : __indexResult_withinRangeUnordered(iters.data(), positions.data(), num, maxSlop);
+  for (auto &it : iters) {
+    it.Free(it.ctx);
+  }
+  return rc;
+}
+
+TEST_F(IndexTest, testDecodedRange) {
+  std::mt19937 gen(42);
+  const char *names[] = {"a", "b", "c", "d", "e"};
+  for (int round = 0; round < 2000; round++) {
+    int num = 2 + gen() % 4;
+    bool packed = gen() % 2;
+    // some of the results have too many offsets to be decoded
+    int maxOffsets = gen() % 10 ? 12 : 100;
+    // the same term in all the children, or distinct terms which never share an offset
+    bool sameTerm = gen() % 5 == 0;
+    RSIndexResult *res = NewIntersectResult(num, 1);
+    std::vector<VarintVectorWriter *> writers;
+    for (int i = 0; i < num; i++) {
+      VarintVectorWriter *vw = NewVarintVectorWriter(8);
+      int n = 1 + gen() % maxOffsets;
+      uint32_t pos = 0;
+      for (int j = 0; j < n; j++) {
+        pos += 1 + gen() % 8;
+        VVW_Write(vw, sameTerm ? pos : pos * num + i);
+      }
+      if (packed) {
+        VVW_Pack(vw);
+      } else {
+        VVW_Truncate(vw);
+      }
+      writers.push_back(vw);
+
+      RSToken tok = {.str = (char *)names[sameTerm ? 0 : i], .len = 1};
+      RSIndexResult *tr = NewTokenRecord(NewQueryTerm(&tok, i), 1);
+      tr->docId = 1;
+      tr->term.offsets = offsetsFromVVW(vw);
+      tr->term.offsets.packed = packed;
+      AggregateResult_AddChild(res, tr);
+    }
+
+    for (int maxSlop = 0; maxSlop < 4; maxSlop++) {
+      for (int inOrder = 0; inOrder < 2; inOrder++) {
+        ASSERT_EQ(iteratedWithinRange(res, maxSlop, inOrder),
+                  IndexResult_IsWithinRange(res, maxSlop, inOrder))
+            << "slop " << maxSlop << ", in order " << inOrder << ", round " << round;
+      }
+    }
+
+    for (int i = 0; i < num; i++) {
+      IndexResult_Free(res->agg.children[i]);
+      VVW_Free(writers[i]);
+    }
+    IndexResult_Free(res);
+  }
+}
+
 class IndexFlagsTest : public testing::TestWithParam<int> {};
 
 TEST_P(IndexFlagsTest, testRWFlags) {
@@ -364,7 +521,7 @@ TEST_F(IndexTest, testNot) {
   // printf("Reading!\n");
   IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
   irs[0] = NewReadIterator(r1);
-  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, 1);
+  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, 1, NULL);
 
   IndexIterator *ui = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
   RSIndexResult *h = NULL;
@@ -388,7 +545,7 @@ TEST_F(IndexTest, testPureNot) {
   IndexReader *r1 = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);  //
   printf("last id: %llu\n", (unsigned long long)w->lastId);
 
-  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, 1);
+  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, 1, NULL);
 
   RSIndexResult *h = NULL;
   int expected[] = {1,  2,  4,  5,  7,  8,  10, 11, 13, 14, 16, 17, 19,
@@ -575,6 +732,150 @@ TEST_F(IndexTest, testNumericEncodingMulti) {
   testNumericEncodingHelper(1);
 }
 
+TEST_F(IndexTest, testNumericBlockRanges) {
+  // Time-series like values: the blocks of the index hold disjoint ranges
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  const size_t N = 10000;
+  for (size_t i = 1; i <= N; i++) {
+    InvertedIndex_WriteNumericEntry(idx, i, i * 0.1 + 0.01);
+  }
+  ASSERT_GT(idx->size, 10);
+
+  // The range of each block bounds the values it holds
+  for (uint32_t i = 0; i < idx->size; i++) {
+    const IndexBlock *blk = idx->blocks + i;
+    ASSERT_LE(blk->valueRange.min, blk->firstId * 0.1 + 0.01);
+    ASSERT_GE(blk->valueRange.max, blk->lastId * 0.1 + 0.01);
+  }
+
+  NumericFilter *flt = NewNumericFilter(300.05, 450.5, 0, 1, true);
+  IndexReader *ir = NewNumericReader(NULL, idx, flt, 0, 0, false);
+  IndexIterator *it = NewReadIterator(ir);
+  RSIndexResult *res;
+  t_docId expected = 3001;
+  while (INDEXREAD_EOF != it->Read(it->ctx, &res)) {
+    ASSERT_EQ(expected++, res->docId);
+  }
+  ASSERT_EQ(4505, expected);
+  ASSERT_GT(ir->blocksSkipped, 0);
+
+  // Skipping into a block outside the filter lands on the first doc which passes it
+  it->Rewind(it->ctx);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, it->SkipTo(it->ctx, 100, &res));
+  ASSERT_EQ(3001, res->docId);
+  ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, 4000, &res));
+  ASSERT_EQ(INDEXREAD_EOF, it->SkipTo(it->ctx, 5000, &res));
+
+  it->Free(it);
+  NumericFilter_Free(flt);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testNumericSeriesBlocks) {
+  // Timestamps in milliseconds and measures at a fixed step, with two values for every fifth doc
+  for (bool integers : {true, false}) {
+    InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+    std::vector<std::pair<t_docId, double>> entries;
+    size_t recordBytes = 0;
+    for (t_docId id = 1; id <= 3000; id++) {
+      double value = integers ? 1700000000000.0 + id * 1000 + id % 3 : 20.5 + (id % 64) * 0.25;
+      entries.push_back({id, value});
+      recordBytes += InvertedIndex_WriteNumericEntry(idx, id, value);
+      if (id % 5 == 0) {
+        entries.push_back({id, value + 1});
+        recordBytes += InvertedIndex_WriteNumericEntry(idx, id, value + 1);
+      }
+    }
+
+    // Every full block is a series, much smaller than its records
+    ASSERT_GT(idx->size, 2);
+    size_t seriesBytes = 0;
+    for (uint32_t i = 0; i + 1 < idx->size; ++i) {
+      ASSERT_TRUE(IndexBlock_IsNumericSeries(&idx->blocks[i]));
+      seriesBytes += idx->blocks[i].buf.offset;
+    }
+    ASSERT_FALSE(IndexBlock_IsSealed(&idx->blocks[idx->size - 1]));
+    seriesBytes += idx->blocks[idx->size - 1].buf.offset;
+    ASSERT_LT(seriesBytes * 2, recordBytes);
+
+    // All the values are read back as written
+    IndexReader *ir = NewNumericReader(NULL, idx, NULL, 0, 0, false);
+    RSIndexResult *h = NULL;
+    for (auto &e : entries) {
+      ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+      ASSERT_EQ(e.first, h->docId);
+      ASSERT_EQ(e.second, h->num.value);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+    IR_Free(ir);
+
+    // The decoded values are filtered, and the values of a doc are returned once
+    double min = integers ? entries[1000].second : 25.0;
+    double max = integers ? entries[2000].second : 30.0;
+    NumericFilter *flt = NewNumericFilter(min, max, 1, 1, true);
+    ir = NewNumericReader(NULL, idx, flt, 0, 0, true);
+    std::vector<t_docId> expected, got;
+    for (auto &e : entries) {
+      if (e.second >= min && e.second <= max && (expected.empty() || expected.back() != e.first)) {
+        expected.push_back(e.first);
+      }
+    }
+    while (IR_Read(ir, &h) == INDEXREAD_OK) {
+      got.push_back(h->docId);
+    }
+    ASSERT_EQ(expected, got);
+
+    IR_Rewind(ir);
+    for (size_t i = 10; i < expected.size(); i += 97) {
+      ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, expected[i], &h));
+      ASSERT_EQ(expected[i], h->docId);
+    }
+    IR_Free(ir);
+    NumericFilter_Free(flt);
+
+    // The records of a series block are written back as they were
+    Buffer records;
+    IndexBlock_ToRecordBuffer(&idx->blocks[0], idx->flags, &records);
+    ASSERT_GT(records.offset, idx->blocks[0].buf.offset);
+    Buffer_Free(&records);
+    InvertedIndex_Free(idx);
+  }
+}
+
+TEST_F(IndexTest, testIndexBufferClasses) {
+  Buffer b;
+  IndexBuffer_Init(&b, 6);
+  ASSERT_EQ(INDEX_BUFFERS_MIN_CLASS, b.cap);
+  ASSERT_EQ(0, b.offset);
+
+  // the buffer grows to the next classes, keeping its data
+  memset(b.data, 'x', 10);
+  b.offset = 10;
+  IndexBuffer_Reserve(&b, 10);
+  ASSERT_EQ(24, b.cap);
+  IndexBuffer_Reserve(&b, 30);
+  ASSERT_EQ(48, b.cap);
+  ASSERT_EQ(10, b.offset);
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_EQ('x', b.data[i]);
+  }
+
+  // a freed buffer is reused by the next buffer of its class
+  char *data = b.data;
+  IndexBuffer_Free(&b);
+  ASSERT_EQ(NULL, b.data);
+  IndexBuffer_Init(&b, 40);
+  ASSERT_EQ(data, b.data);
+  ASSERT_EQ(48, b.cap);
+  IndexBuffer_Free(&b);
+
+  // larger buffers are allocated as they are
+  IndexBuffer_Init(&b, INDEX_BUFFERS_MAX_CLASS + 1);
+  ASSERT_EQ(INDEX_BUFFERS_MAX_CLASS + 1, b.cap);
+  IndexBuffer_Free(&b);
+  IndexBuffers_Free();
+}
+
 TEST_F(IndexTest, testAbort) {
 
   InvertedIndex *w = createIndex(1000, 1);
@@ -1361,7 +1662,7 @@ TEST_F(IndexTest, testDocTable) {
   ASSERT_EQ(N + 1, dt.size);
   ASSERT_EQ(N, dt.maxDocId);
 #ifdef __x86_64__
-  ASSERT_EQ(10180, (int)dt.memsize);
+  ASSERT_EQ(9380, (int)dt.memsize);
 #endif
   for (int i = 0; i < N; i++) {
     sprintf(buf, "doc_%d", i);
@@ -1397,7 +1698,7 @@ TEST_F(IndexTest, testDocTable) {
   RSDocumentMetadata *dmd = DocTable_Put(&dt, "Hello", 5, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
   t_docId strDocId = dmd->id;
   ASSERT_TRUE(0 != strDocId);
-  ASSERT_EQ(71, (int)dt.memsize);
+  ASSERT_EQ(63, (int)dt.memsize);
 
   // Test that binary keys also work here
   static const char binBuf[] = {"Hello\x00World"};
@@ -1406,7 +1707,7 @@ TEST_F(IndexTest, testDocTable) {
   DMD_Return(dmd);
   dmd = DocTable_Put(&dt, binBuf, binBufLen, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
   ASSERT_TRUE(dmd);
-  ASSERT_EQ(148, (int)dt.memsize);
+  ASSERT_EQ(132, (int)dt.memsize);
   ASSERT_NE(dmd->id, strDocId);
   ASSERT_EQ(dmd->id, DocIdMap_Get(&dt.dim, binBuf, binBufLen));
   ASSERT_EQ(strDocId, DocIdMap_Get(&dt.dim, "Hello", 5));
@@ -1414,6 +1715,78 @@ TEST_F(IndexTest, testDocTable) {
   DocTable_Free(&dt);
 }
 
+TEST_F(IndexTest, testDocIdMap) {
+  char buf[16];
+  const size_t N = 1000;
+  std::vector<RSDocumentMetadata> dmds(N + 1);
+  DocIdMap m = NewDocIdMap();
+  for (size_t i = 1; i <= N; i++) {
+    size_t nkey = sprintf(buf, "doc_%zu", i);
+    dmds[i].id = i;
+    dmds[i].keyPtr = sdsnewlen(buf, nkey);
+    DocIdMap_Put(&m, &dmds[i]);
+  }
+  ASSERT_EQ(N, m.size);
+
+  // deleting shifts back the following entries of the probes, which must remain reachable
+  for (size_t i = 1; i <= N; i += 2) {
+    ASSERT_EQ(1, DocIdMap_Delete(&m, dmds[i].keyPtr, sdslen(dmds[i].keyPtr)));
+  }
+  ASSERT_EQ(0, DocIdMap_Delete(&m, dmds[1].keyPtr, sdslen(dmds[1].keyPtr)));
+  ASSERT_EQ(N / 2, m.size);
+  for (size_t i = 1; i <= N; i++) {
+    t_docId expected = i % 2 ? 0 : i;
+    ASSERT_EQ(expected, DocIdMap_Get(&m, dmds[i].keyPtr, sdslen(dmds[i].keyPtr)));
+  }
+
+  // putting an existing key maps it to the new document
+  RSDocumentMetadata other = {0};
+  other.id = N + 1;
+  other.keyPtr = sdsdup(dmds[2].keyPtr);
+  DocIdMap_Put(&m, &other);
+  ASSERT_EQ(N / 2, m.size);
+  ASSERT_EQ(N + 1, DocIdMap_Get(&m, "doc_2", 5));
+
+  DocIdMap_Free(&m);
+  sdsfree(other.keyPtr);
+  for (size_t i = 1; i <= N; i++) {
+    sdsfree(dmds[i].keyPtr);
+  }
+}
+
+TEST_F(IndexTest, testDocTablePages) {
+  char buf[16];
+  DocTable dt = NewDocTable(10, 10);
+  size_t N = 3 * DOCTABLE_PAGE_SIZE;
+  for (size_t i = 1; i <= N; i++) {
+    size_t nkey = sprintf(buf, "doc_%zu", i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+  ASSERT_LE(3, dt.numPages);
+
+  // emptying the second page frees it
+  for (size_t i = DOCTABLE_PAGE_SIZE; i < 2 * DOCTABLE_PAGE_SIZE; i++) {
+    size_t nkey = sprintf(buf, "doc_%zu", i);
+    ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+  }
+  ASSERT_TRUE(dt.pages[0] != NULL);
+  ASSERT_TRUE(dt.pages[1] == NULL);
+  ASSERT_FALSE(DocTable_Exists(&dt, DOCTABLE_PAGE_SIZE));
+  ASSERT_TRUE(DocTable_Exists(&dt, 2 * DOCTABLE_PAGE_SIZE));
+
+  // the documents are iterated by increasing id
+  size_t count = 0;
+  t_docId last = 0;
+  DOCTABLE_FOREACH((&dt), {
+    ASSERT_LT(last, dmd->id);
+    last = dmd->id;
+    ++count;
+  });
+  ASSERT_EQ(N - DOCTABLE_PAGE_SIZE, count);
+  ASSERT_EQ(N, last);
+  DocTable_Free(&dt);
+}
+
 TEST_F(IndexTest, testSortable) {
   RSSortingTable *tbl = NewSortingTable();
   RSSortingTable_Add(&tbl, "foo", RSValue_String);
@@ -1438,21 +1811,30 @@ TEST_F(IndexTest, testSortable) {
   const char *str = "hello";
   const char *masse = "Maße";
   double num = 3.141;
-  ASSERT_TRUE(RSValue_IsNull(v->values[0]));
+  ASSERT_TRUE(RSValue_IsNull(RSSortingVector_Get(v, 0)));
   RSSortingVector_Put(v, 0, str, RS_SORTABLE_STR, 0);
-  ASSERT_EQ(v->values[0]->t, RSValue_String);
-  ASSERT_EQ(v->values[0]->strval.stype, RSString_RMAlloc);
+  ASSERT_EQ(RSSortingVector_Get(v, 0)->t, RSValue_String);
+  ASSERT_EQ(RSSortingVector_Get(v, 0)->strval.stype, RSString_RMAlloc);
 
-  ASSERT_TRUE(RSValue_IsNull(v->values[1]));
-  ASSERT_TRUE(RSValue_IsNull(v->values[2]));
+  ASSERT_TRUE(RSValue_IsNull(RSSortingVector_Get(v, 1)));
+  ASSERT_TRUE(RSValue_IsNull(RSSortingVector_Get(v, 2)));
   RSSortingVector_Put(v, 1, &num, RSValue_Number, 0);
-  ASSERT_EQ(v->values[1]->t, RS_SORTABLE_NUM);
+  // numbers are kept unboxed
+  ASSERT_EQ(RSSortingVector_Type(v, 1), RS_SORTABLE_NUM);
+  ASSERT_TRUE(RSSortingVector_Get(v, 1) == NULL);
+  double d = 0;
+  ASSERT_TRUE(RSSortingVector_GetNumber(v, 1, &d));
+  ASSERT_EQ(num, d);
+  RSValue *numval = RSSortingVector_NewValue(v, 1);
+  ASSERT_EQ(RSValue_Number, numval->t);
+  ASSERT_EQ(num, numval->numval);
+  RSValue_Decref(numval);
 
   RSSortingVector *v2 = NewSortingVector(tbl->len);
   RSSortingVector_Put(v2, 0, masse, RS_SORTABLE_STR, 0);
 
   /// test string unicode lowercase normalization
-  ASSERT_STREQ("masse", v2->values[0]->strval.str);
+  ASSERT_STREQ("masse", RSSortingVector_Get(v2, 0)->strval.str);
 
   double s2 = 4.444;
   RSSortingVector_Put(v2, 1, &s2, RS_SORTABLE_NUM, 0);
@@ -1486,6 +1868,38 @@ TEST_F(IndexTest, testSortable) {
   SortingVector_Free(v2);
 }
 
+TEST_F(IndexTest, testSortingVectorSharedStrings) {
+  RSSortingTable *tbl = NewSortingTable();
+  RSSortingTable_Add(&tbl, "foo", RSValue_String);
+  RSSortingTable_Add(&tbl, "bar", RSValue_Number);
+
+  RSSortingVector *v1 = RSSortingTable_NewVector(tbl);
+  RSSortingVector *v2 = RSSortingTable_NewVector(tbl);
+  RSSortingVector_Put(v1, 0, "Hello", RS_SORTABLE_STR, 0);
+  RSSortingVector_Put(v2, 0, "hello", RS_SORTABLE_STR, 0);
+  ASSERT_EQ(RS_SORTABLE_STR, RSSortingVector_Type(v1, 0));
+
+  // the normalized strings are the same value, kept once
+  RSValue *s = RSSortingVector_Get(v1, 0);
+  ASSERT_EQ(s, RSSortingVector_Get(v2, 0));
+  ASSERT_STREQ("hello", s->strval.str);
+  size_t size = RSSortingTable_StringsMemorySize(tbl);
+  ASSERT_LT(0, size);
+
+  // a string outlives the vectors released before the last one holding it
+  RSSortingVector_Put(v1, 0, "world", RS_SORTABLE_STR, 0);
+  ASSERT_STREQ("hello", RSSortingVector_Get(v2, 0)->strval.str);
+  ASSERT_STREQ("world", RSSortingVector_Get(v1, 0)->strval.str);
+  SortingVector_Free(v2);
+  // "hello" is gone, and "world" is as long
+  ASSERT_EQ(size, RSSortingTable_StringsMemorySize(tbl));
+
+  // the vectors keep the strings after the table is freed
+  SortingTable_Free(tbl);
+  ASSERT_STREQ("world", RSSortingVector_Get(v1, 0)->strval.str);
+  SortingVector_Free(v1);
+}
+
 TEST_F(IndexTest, testVarintFieldMask) {
   t_fieldMask x = 127;
   size_t expected[] = {1, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 19};
@@ -1545,3 +1959,756 @@ TEST_F(IndexTest, testDeltaSplits) {
   IR_Free(ir);
   InvertedIndex_Free(idx);
 }
+
+TEST_F(IndexTest, testStreamVByteBlocks) {
+  RSGlobalConfig.invertedIndexStreamVByteEncoding = true;
+  for (IndexFlags flags : {Index_DocIdsOnly, Index_StoreFreqs}) {
+    InvertedIndex *idx = NewInvertedIndex(flags, 1);
+    ASSERT_TRUE(idx->flags & Index_StreamVByte);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+
+    size_t numDocs = 5000;
+    for (t_docId i = 1; i <= numDocs; ++i) {
+      ForwardIndexEntry ent = {0};
+      ent.docId = i * 3;
+      ent.fieldMask = RS_FIELDMASK_ALL;
+      ent.freq = i % 7 + 1;
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+    }
+
+    // All blocks but the last one are sealed. Docids-only blocks this dense become bitmaps
+    ASSERT_GT(idx->size, 1);
+    for (uint32_t i = 0; i < idx->size - 1; ++i) {
+      if (flags == Index_DocIdsOnly) {
+        ASSERT_TRUE(IndexBlock_IsBitmap(&idx->blocks[i]));
+      } else {
+        ASSERT_TRUE(IndexBlock_IsStreamEncoded(&idx->blocks[i]));
+      }
+    }
+    ASSERT_FALSE(IndexBlock_IsSealed(&idx->blocks[idx->size - 1]));
+
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    for (t_docId i = 1; i <= numDocs; ++i) {
+      ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+      ASSERT_EQ(i * 3, h->docId);
+      ASSERT_EQ(flags == Index_StoreFreqs ? i % 7 + 1 : 1, h->freq);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+
+    IR_Rewind(ir);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 300, &h));
+    ASSERT_EQ(300, h->docId);
+    ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, 2 * 3000 + 1, &h));
+    ASSERT_EQ(2 * 3000 + 3, h->docId);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, numDocs * 3, &h));
+    ASSERT_EQ(numDocs * 3, h->docId);
+    ASSERT_EQ(INDEXREAD_EOF, IR_SkipTo(ir, numDocs * 3 + 1, &h));
+
+    IR_Free(ir);
+    InvertedIndex_Free(idx);
+  }
+  RSGlobalConfig.invertedIndexStreamVByteEncoding = false;
+}
+
+TEST_F(IndexTest, testPooledReaders) {
+  // a reader freed to the pool keeps the buffers of its blocks for its next index
+  RSGlobalConfig.invertedIndexStreamVByteEncoding = true;
+  InvertedIndex *big = NewInvertedIndex(Index_StoreFreqs, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(big->flags);
+  for (t_docId i = 1; i <= 1000; ++i) {
+    ForwardIndexEntry ent = {0};
+    ent.docId = i * 2;
+    ent.fieldMask = RS_FIELDMASK_ALL;
+    ent.freq = 2;
+    InvertedIndex_WriteForwardIndexEntry(big, enc, &ent);
+  }
+  RSGlobalConfig.invertedIndexStreamVByteEncoding = false;
+  InvertedIndex *small = createIndex(10, 1);
+
+  for (int round = 0; round < 3; ++round) {
+    IndexIterator *it = NewReadIterator(NewTermIndexReader(big, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    size_t n = 0;
+    RSIndexResult *h = NULL;
+    while (it->Read(it->ctx, &h) == INDEXREAD_OK) {
+      ASSERT_EQ(++n * 2, h->docId);
+      ASSERT_EQ(2, h->freq);
+    }
+    ASSERT_EQ(1000, n);
+    it->Free(it);
+
+    it = NewReadIterator(NewTermIndexReader(small, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    n = 0;
+    while (it->Read(it->ctx, &h) == INDEXREAD_OK) {
+      ++n;
+    }
+    ASSERT_EQ(10, n);
+    it->Free(it);
+  }
+  InvertedIndex_Free(big);
+  InvertedIndex_Free(small);
+}
+
+TEST_F(IndexTest, testBlockMaxFreq) {
+  // The number of entries in a block of a term index
+  const t_docId blockSize = 100;
+  InvertedIndex *idx = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  for (t_docId i = 1; i <= blockSize * 3; ++i) {
+    ForwardIndexEntry ent = {0};
+    ent.docId = i;
+    ent.fieldMask = RS_FIELDMASK_ALL;
+    // the middle block holds a single high frequency entry
+    ent.freq = i == blockSize + 7 ? 42 : i % 3 + 1;
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  }
+  ASSERT_EQ(3, idx->size);
+  ASSERT_EQ(3, idx->blocks[0].maxFreq);
+  ASSERT_EQ(42, idx->blocks[1].maxFreq);
+  ASSERT_EQ(3, idx->blocks[2].maxFreq);
+
+  // The reader exposes the block of its last record
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *h = NULL;
+  ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, blockSize + 1, &h));
+  ASSERT_EQ(&idx->blocks[1], IR_CurrentBlock(ir));
+  ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, blockSize * 2, &h));
+  ASSERT_EQ(&idx->blocks[1], IR_CurrentBlock(ir));
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testBitmapBlocks) {
+  InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  RSIndexResult rec = {.type = RSResultType_Virtual};
+
+  // Dense in the first half, sparse in the second
+  std::vector<t_docId> ids;
+  for (t_docId id = 1; id < 100000; id += (id < 50000 ? 1 + id % 3 : 200)) {
+    ids.push_back(id);
+    rec.docId = id;
+    InvertedIndex_WriteEntryGeneric(idx, enc, id, &rec);
+  }
+  size_t bitmaps = 0;
+  for (uint32_t i = 0; i < idx->size; ++i) {
+    const IndexBlock *blk = &idx->blocks[i];
+    if (blk->lastId < 50000 && i + 1 < idx->size) {
+      ASSERT_TRUE(IndexBlock_IsBitmap(blk));
+      ASSERT_EQ((blk->lastId - blk->firstId) / 64 + 1, blk->buf.offset / sizeof(uint64_t));
+      ++bitmaps;
+    } else if (blk->firstId > 50000) {
+      ASSERT_FALSE(IndexBlock_IsBitmap(blk));
+    }
+  }
+  ASSERT_GT(bitmaps, 10);
+
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *h = NULL;
+  for (t_docId id : ids) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+    ASSERT_EQ(id, h->docId);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+
+  // Every docid is found by a skip, every missing one lands on the next one
+  IR_Rewind(ir);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (i % 2) {
+      ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, ids[i], &h));
+      ASSERT_EQ(ids[i], h->docId);
+    } else if (ids[i] > 1 && (i == 0 || ids[i] - 1 != ids[i - 1])) {
+      ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, ids[i] - 1, &h));
+      ASSERT_EQ(ids[i], h->docId);
+    }
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_SkipTo(ir, ids.back() + 1, &h));
+
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testBlockSkips) {
+  IndexFlags flagsList[] = {(IndexFlags)INDEX_DEFAULT_FLAGS,
+                            (IndexFlags)(Index_StoreFreqs | Index_StoreFieldFlags)};
+  for (IndexFlags flags : flagsList) {
+    InvertedIndex *idx = NewInvertedIndex(flags, 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+    ForwardIndexEntry ent = {0};
+    ent.fieldMask = RS_FIELDMASK_ALL;
+    ent.freq = 1;
+
+    std::vector<t_docId> ids;
+    for (t_docId id = 1; id < 5000; id += 1 + id % 7) {
+      ids.push_back(id);
+      ent.docId = id;
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+    }
+
+    // Every full block holds a skip point every 16 records, the last block has none yet
+    size_t start = 0;
+    for (uint32_t i = 0; i < idx->size; ++i) {
+      const IndexBlock *blk = &idx->blocks[i];
+      if (i + 1 == idx->size) {
+        ASSERT_TRUE(blk->skips == NULL);
+        break;
+      }
+      ASSERT_EQ((blk->numEntries - 1) / 16, array_len(blk->skips));
+      for (uint32_t j = 0; j < array_len(blk->skips); ++j) {
+        ASSERT_EQ(ids[start + (j + 1) * 16 - 1], blk->firstId + blk->skips[j].prevId);
+      }
+      start += blk->numEntries;
+    }
+
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    for (size_t i = 0; i < ids.size(); i += 5) {
+      ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, ids[i], &h));
+      ASSERT_EQ(ids[i], h->docId);
+      if (i + 3 < ids.size() && ids[i + 3] - 1 != ids[i + 2]) {
+        ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, ids[i + 3] - 1, &h));
+        ASSERT_EQ(ids[i + 3], h->docId);
+      }
+    }
+    // Reading on after a skip continues from the record the skip stopped at
+    IR_Rewind(ir);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, ids[250], &h));
+    for (size_t i = 251; i < ids.size(); ++i) {
+      ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+      ASSERT_EQ(ids[i], h->docId);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+
+    IR_Free(ir);
+    InvertedIndex_Free(idx);
+  }
+}
+
+TEST_F(IndexTest, testBitPackedBlocks) {
+  for (IndexFlags flags : {Index_DocIdsOnly, Index_StoreFreqs}) {
+    InvertedIndex *idx = NewInvertedIndex(flags, 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+    ForwardIndexEntry ent = {0};
+    ent.fieldMask = RS_FIELDMASK_ALL;
+
+    // Too sparse for bitmaps, with deltas taking two bytes as varints
+    std::vector<t_docId> ids;
+    for (t_docId id = 1; id < 2000000; id += 150 + id % 50) {
+      ids.push_back(id);
+      ent.docId = id;
+      ent.freq = id % 5 + 1;
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+    }
+
+    // Every full block fits 8 bits per delta and 3 bits per frequency, in a buffer of its size
+    ASSERT_GT(idx->size, 2);
+    for (uint32_t i = 0; i + 1 < idx->size; ++i) {
+      const IndexBlock *blk = &idx->blocks[i];
+      ASSERT_TRUE(IndexBlock_IsBitPacked(blk));
+      size_t bits = flags == Index_StoreFreqs ? 8 + 3 : 8;
+      ASSERT_LE(blk->buf.offset, 2 + (blk->numEntries * bits + 7) / 8 + 1);
+      ASSERT_EQ(blk->buf.offset, blk->buf.cap);
+    }
+    ASSERT_FALSE(IndexBlock_IsSealed(&idx->blocks[idx->size - 1]));
+
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    for (t_docId id : ids) {
+      ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+      ASSERT_EQ(id, h->docId);
+      ASSERT_EQ(flags == Index_StoreFreqs ? id % 5 + 1 : 1, h->freq);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+
+    IR_Rewind(ir);
+    for (size_t i = 1; i + 3 < ids.size(); i += 7) {
+      ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, ids[i] - 1, &h));
+      ASSERT_EQ(ids[i], h->docId);
+      ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, ids[i + 3], &h));
+      ASSERT_EQ(ids[i + 3], h->docId);
+    }
+
+    IR_Free(ir);
+    InvertedIndex_Free(idx);
+  }
+}
+
+TEST_F(IndexTest, testBlockCapacity) {
+  InvertedIndex *idx = NewInvertedIndex((IndexFlags)INDEX_DEFAULT_FLAGS, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  ForwardIndexEntry ent = {0};
+  ent.fieldMask = RS_FIELDMASK_ALL;
+  ent.freq = 1;
+
+  // A single block is held inline
+  ent.docId = 1;
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  ASSERT_TRUE(InvertedIndex_HasInlineBlock(idx));
+
+  // The block size doubles every 8 blocks, up to 16 times the initial one
+  size_t numDocs = 0;
+  for (uint32_t i = 0; i < 48; ++i) {
+    numDocs += 100 << std::min(i / 8, 4U);
+  }
+  for (t_docId id = 2; id <= numDocs; ++id) {
+    ent.docId = id;
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  }
+  ASSERT_FALSE(InvertedIndex_HasInlineBlock(idx));
+  ASSERT_EQ(48, idx->size);
+  for (uint32_t i = 0; i < idx->size; ++i) {
+    ASSERT_EQ(100 << std::min(i / 8, 4U), idx->blocks[i].numEntries);
+    ASSERT_EQ(idx->blocks[i].numEntries, InvertedIndex_BlockCapacity(idx, i));
+  }
+
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *h = NULL;
+  for (t_docId id = 1; id <= numDocs; id += 97) {
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, id, &h));
+    ASSERT_EQ(id, h->docId);
+  }
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testInlineData) {
+  InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  RSIndexResult rec = {.type = RSResultType_Virtual};
+  const IndexBlock *blk = &idx->blocks[0];
+
+  // A few small deltas fit inline, until the data outgrows it
+  std::vector<t_docId> ids;
+  for (t_docId id = 1; blk->flags & IndexBlock_InlineData; id += 100) {
+    ASSERT_EQ(InvertedIndex_InlineData(idx), blk->buf.data);
+    ids.push_back(id);
+    rec.docId = id;
+    InvertedIndex_WriteEntryGeneric(idx, enc, id, &rec);
+    blk = &idx->blocks[0];
+  }
+  ASSERT_GT(ids.size(), 2);
+  ASSERT_NE(InvertedIndex_InlineData(idx), blk->buf.data);
+
+  IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *h = NULL;
+  for (t_docId id : ids) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h));
+    ASSERT_EQ(id, h->docId);
+  }
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h));
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+static std::vector<t_docId> readDocIds(IndexIterator *it) {
+  std::vector<t_docId> ids;
+  RSIndexResult *h = NULL;
+  while (it->Read(it->ctx, &h) != INDEXREAD_EOF) {
+    ids.push_back(h->docId);
+  }
+  return ids;
+}
+
+static std::vector<t_docId> readDocIdBatches(IndexIterator *it, size_t batchSize) {
+  std::vector<t_docId> ids, batch(batchSize);
+  size_t n = 0;
+  while (IndexIterator_ReadBatch(it, batch.data(), batchSize, &n) == INDEXREAD_OK) {
+    EXPECT_GT(n, 0);
+    EXPECT_LE(n, batchSize);
+    ids.insert(ids.end(), batch.begin(), batch.begin() + n);
+  }
+  return ids;
+}
+
+TEST_F(IndexTest, testReadBatch) {
+  InvertedIndex *w = createIndex(5000, 2);
+  InvertedIndex *w2 = createIndex(5000, 3);
+  // Sealed as bitmap blocks
+  InvertedIndex *w3 = NewInvertedIndex(Index_DocIdsOnly, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(w3->flags);
+  RSIndexResult rec = {.type = RSResultType_Virtual};
+  for (t_docId id = 1; id < 15000; ++id) {
+    if (id % 5) {
+      rec.docId = id;
+      InvertedIndex_WriteEntryGeneric(w3, enc, id, &rec);
+    }
+  }
+
+  auto newTree = [&](bool intersect) {
+    IndexIterator **irs = (IndexIterator **)calloc(3, sizeof(IndexIterator *));
+    irs[0] = NewReadIterator(NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    irs[1] = NewReadIterator(NewTermIndexReader(w2, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    irs[2] = NewReadIterator(NewTermIndexReader(w3, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    if (intersect) {
+      return NewIntersecIterator(irs, 3, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+    }
+    IteratorsConfig config{};
+    iteratorsConfig_init(&config);
+    return NewUnionIterator(irs, 3, NULL, 0, 1, QN_UNION, NULL, &config);
+  };
+
+  for (bool intersect : {false, true}) {
+    IndexIterator *it = newTree(intersect);
+    std::vector<t_docId> expected = readDocIds(it);
+    it->Free(it);
+    ASSERT_GT(expected.size(), 1000);
+
+    it = newTree(intersect);
+    ASSERT_TRUE(it->ReadBatch != NULL);
+    for (size_t batchSize : {1, 7, 1000}) {
+      ASSERT_EQ(expected, readDocIdBatches(it, batchSize));
+      it->Rewind(it->ctx);
+    }
+    it->Free(it);
+  }
+
+  // Leaves read on their own
+  IndexReader *ir = NewTermIndexReader(w3, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  IndexIterator *it = NewReadIterator(ir);
+  std::vector<t_docId> expected = readDocIds(it);
+  it->Rewind(it->ctx);
+  ASSERT_EQ(expected, readDocIdBatches(it, 300));
+  it->Free(it);
+
+  it = NewWildcardIterator(100, 100, NULL);
+  expected = readDocIds(it);
+  ASSERT_EQ(100, expected.size());
+  it->Rewind(it->ctx);
+  ASSERT_EQ(expected, readDocIdBatches(it, 30));
+  it->Free(it);
+
+  InvertedIndex_Free(w);
+  InvertedIndex_Free(w2);
+  InvertedIndex_Free(w3);
+}
+
+TEST_F(IndexTest, testUnionBitmapMerge) {
+  // children sharing most of their docids, over a few bitmap windows
+  std::vector<InvertedIndex *> idxs;
+  for (int i = 0; i < 10; ++i) {
+    idxs.push_back(createIndex(20000, 7 + i % 3));
+  }
+  auto newUnion = [&](bool docIdsOnly) {
+    IndexIterator **irs = (IndexIterator **)calloc(idxs.size(), sizeof(IndexIterator *));
+    for (size_t i = 0; i < idxs.size(); ++i) {
+      irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+    }
+    IteratorsConfig config{};
+    iteratorsConfig_init(&config);
+    IndexIterator *it = NewUnionIterator(irs, idxs.size(), NULL, 1, 1, QN_NUMERIC, NULL, &config);
+    UI_AllowBitmapMerge(it);
+    if (docIdsOnly) {
+      IndexIterator_EnableDocIdsOnly(it);
+    }
+    return it;
+  };
+
+  // a union whose records are needed keeps merging its children in a heap, so its records keep
+  // the children the scores are made of
+  IndexIterator *it = newUnion(false);
+  std::vector<t_docId> expected;
+  RSIndexResult *r = NULL;
+  while (it->Read(it->ctx, &r) != INDEXREAD_EOF) {
+    expected.push_back(r->docId);
+    ASSERT_GT(r->agg.numChildren, 0);
+    uint32_t freq = 0;
+    for (int i = 0; i < r->agg.numChildren; ++i) {
+      ASSERT_EQ(r->docId, r->agg.children[i]->docId);
+      freq += r->agg.children[i]->freq;
+    }
+    ASSERT_EQ(freq, r->freq);
+  }
+  it->Free(it);
+  ASSERT_GT(expected.back(), 2 * (1 << 16));
+
+  it = newUnion(true);
+  ASSERT_EQ(expected, readDocIds(it));
+  it->Rewind(it->ctx);
+  ASSERT_EQ(expected, readDocIdBatches(it, 100));
+
+  // skips within a window, to a docid between two, and past windows
+  for (size_t step : {3, 1000, 20000}) {
+    it->Rewind(it->ctx);
+    RSIndexResult *h = NULL;
+    for (size_t i = 0; i < expected.size(); i += step) {
+      ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, expected[i], &h));
+      ASSERT_EQ(expected[i], h->docId);
+      if (i + 1 < expected.size() && expected[i + 1] > expected[i] + 1) {
+        ASSERT_EQ(INDEXREAD_NOTFOUND, it->SkipTo(it->ctx, expected[i] + 1, &h));
+        ASSERT_EQ(expected[i + 1], h->docId);
+      }
+    }
+  }
+  RSIndexResult *h = NULL;
+  ASSERT_EQ(INDEXREAD_EOF, it->SkipTo(it->ctx, expected.back() + 1, &h));
+  it->Free(it);
+
+  for (InvertedIndex *idx : idxs) {
+    InvertedIndex_Free(idx);
+  }
+}
+
+TEST_F(IndexTest, testDocIdsOnly) {
+  InvertedIndex *w = createIndex(5000, 2);
+  InvertedIndex *w2 = createIndex(5000, 3);
+  InvertedIndex *w3 = createIndex(5000, 5);
+
+  // (w | w2) w3
+  auto newTree = [&]() {
+    IndexIterator **children = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
+    children[0] = NewReadIterator(NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    children[1] = NewReadIterator(NewTermIndexReader(w2, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    IteratorsConfig config{};
+    iteratorsConfig_init(&config);
+    IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
+    irs[0] = NewUnionIterator(children, 2, NULL, 0, 1, QN_UNION, NULL, &config);
+    irs[1] = NewReadIterator(NewTermIndexReader(w3, NULL, RS_FIELDMASK_ALL, NULL, 1));
+    return NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+  };
+
+  IndexIterator *it = newTree();
+  std::vector<t_docId> expected = readDocIds(it);
+  it->Free(it);
+  ASSERT_GT(expected.size(), 100);
+
+  it = newTree();
+  IndexIterator_EnableDocIdsOnly(it);
+  RSIndexResult *h = NULL;
+  std::vector<t_docId> docIds;
+  while (it->Read(it->ctx, &h) != INDEXREAD_EOF) {
+    ASSERT_EQ(0, h->agg.numChildren);
+    docIds.push_back(h->docId);
+  }
+  ASSERT_EQ(expected, docIds);
+
+  // Skipping lands on the same docids
+  it->Rewind(it->ctx);
+  for (size_t i = 0; i < expected.size(); i += 7) {
+    ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, expected[i], &h));
+    ASSERT_EQ(expected[i], h->docId);
+  }
+  it->Free(it);
+
+  InvertedIndex_Free(w);
+  InvertedIndex_Free(w2);
+  InvertedIndex_Free(w3);
+}
+
+TEST_F(IndexTest, testLiveDocs) {
+  char buf[16];
+  DocTable dt = NewDocTable(10, 1000);
+  const int N = 200;
+  for (int i = 1; i <= N; i++) {
+    size_t nkey = sprintf(buf, "doc_%d", i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+  // delete every third document
+  for (int i = 3; i <= N; i += 3) {
+    size_t nkey = sprintf(buf, "doc_%d", i);
+    ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+  }
+  ASSERT_TRUE(DocTable_IsLive(&dt, 2));
+  ASSERT_FALSE(DocTable_IsLive(&dt, 3));
+  ASSERT_FALSE(DocTable_IsLive(&dt, N + 1));
+  ASSERT_EQ(4, DocTable_NextLive(&dt, 3));
+  ASSERT_EQ(0, DocTable_NextLive(&dt, N + 1));
+
+  std::vector<t_docId> live, liveOdd;
+  for (t_docId id = 1; id <= N; id++) {
+    if (id % 3) {
+      live.push_back(id);
+      if (id % 2) liveOdd.push_back(id);
+    }
+  }
+
+  IndexIterator *it = NewWildcardIterator(dt.maxDocId, dt.size, &dt);
+  ASSERT_EQ(live, readDocIds(it));
+  it->Rewind(it->ctx);
+  ASSERT_EQ(live, readDocIdBatches(it, 7));
+  it->Rewind(it->ctx);
+  // skipping to a deleted document lands on the next live one
+  RSIndexResult *h = NULL;
+  ASSERT_EQ(INDEXREAD_NOTFOUND, it->SkipTo(it->ctx, 3, &h));
+  ASSERT_EQ(4, h->docId);
+  ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, 5, &h));
+  ASSERT_EQ(5, h->docId);
+  ASSERT_EQ(INDEXREAD_EOF, it->SkipTo(it->ctx, N + 1, &h));
+  it->Free(it);
+
+  // the complement of the even ids is the live odd ones
+  InvertedIndex *w = createIndex(N / 2, 2);
+  IndexReader *r = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  it = NewNotIterator(NewReadIterator(r), dt.maxDocId, 1, &dt);
+  ASSERT_EQ(liveOdd, readDocIds(it));
+  it->Rewind(it->ctx);
+  ASSERT_EQ(liveOdd, readDocIds(it));
+  it->Rewind(it->ctx);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, it->SkipTo(it->ctx, 9, &h));
+  ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, 11, &h));
+  it->Free(it);
+
+  InvertedIndex_Free(w);
+  DocTable_Free(&dt);
+}
+
+TEST_F(IndexTest, testMaxScoreUnion) {
+  // a rare term with a high bound, and a common one with a low bound
+  InvertedIndex *rare = createIndex(10, 50);
+  InvertedIndex *common = createIndex(500, 1);
+  RSToken rareTok = {.str = (char *)"rare", .len = 4};
+  RSToken commonTok = {.str = (char *)"common", .len = 6};
+  RSQueryTerm *rareTerm = NewQueryTerm(&rareTok, 1);
+  RSQueryTerm *commonTerm = NewQueryTerm(&commonTok, 2);
+  rareTerm->idf = 10;
+  commonTerm->idf = 1;
+
+  IndexIterator **irs = (IndexIterator **)rm_calloc(2, sizeof(IndexIterator *));
+  irs[0] = NewReadIterator(NewTermIndexReader(rare, NULL, RS_FIELDMASK_ALL, rareTerm, 1));
+  irs[1] = NewReadIterator(NewTermIndexReader(common, NULL, RS_FIELDMASK_ALL, commonTerm, 1));
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  IndexIterator *ui = NewUnionIterator(irs, 2, NULL, 0, 1, QN_UNION, NULL, &config);
+  double threshold = 0;
+  ASSERT_TRUE(IndexIterator_EnableMaxScore(ui, &threshold, 1));
+
+  // nothing is skipped until there is a threshold
+  ASSERT_EQ(500, readDocIds(ui).size());
+
+  // the common term alone cannot beat the threshold, so only the rare term's documents are read
+  ui->Rewind(ui->ctx);
+  threshold = 5;
+  std::vector<t_docId> expected;
+  for (t_docId id = 50; id <= 500; id += 50) {
+    expected.push_back(id);
+  }
+  ASSERT_EQ(expected, readDocIds(ui));
+
+  // both terms together cannot beat it
+  ui->Rewind(ui->ctx);
+  threshold = 12;
+  ASSERT_EQ(0, readDocIds(ui).size());
+  ui->Free(ui);
+
+  // the children of a union must be terms
+  irs = (IndexIterator **)rm_calloc(2, sizeof(IndexIterator *));
+  irs[0] = NewReadIterator(NewTermIndexReader(rare, NULL, RS_FIELDMASK_ALL, NULL, 1));
+  irs[1] = NewWildcardIterator(500, 500, NULL);
+  ui = NewUnionIterator(irs, 2, NULL, 0, 1, QN_UNION, NULL, &config);
+  ASSERT_FALSE(IndexIterator_EnableMaxScore(ui, &threshold, 1));
+  ui->Free(ui);
+
+  InvertedIndex_Free(rare);
+  InvertedIndex_Free(common);
+}
+
+TEST_F(IndexTest, testWideUnion) {
+  // enough children for a tournament tree and a bitmap, spanning a few bitmap windows
+  const int numChildren = 100;
+  std::vector<InvertedIndex *> idxs;
+  std::map<t_docId, size_t> counts;
+  for (int i = 0; i < numChildren; ++i) {
+    int step = 7 * i + 2;
+    idxs.push_back(createIndex(200, step));
+    for (int j = 1; j <= 200; ++j) {
+      counts[(t_docId)step * j]++;
+    }
+  }
+  std::vector<t_docId> expected;
+  for (auto &kv : counts) {
+    expected.push_back(kv.first);
+  }
+  ASSERT_GT(expected.back(), 2 * (1 << 16));
+
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  auto newUnion = [&](int quickExit) {
+    IndexIterator **irs = (IndexIterator **)calloc(numChildren, sizeof(IndexIterator *));
+    for (int i = 0; i < numChildren; ++i) {
+      irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+    }
+    return NewUnionIterator(irs, numChildren, NULL, quickExit, 1, QN_UNION, NULL, &config);
+  };
+
+  for (int quickExit : {0, 1}) {
+    IndexIterator *it = newUnion(quickExit);
+    RSIndexResult *h = NULL;
+    size_t i = 0;
+    while (it->Read(it->ctx, &h) != INDEXREAD_EOF) {
+      ASSERT_LT(i, expected.size());
+      ASSERT_EQ(expected[i], h->docId);
+      ASSERT_EQ(quickExit ? 1 : counts[h->docId], h->agg.numChildren);
+      i++;
+    }
+    ASSERT_EQ(expected.size(), i);
+
+    // skips land on the next docid of any child
+    it->Rewind(it->ctx);
+    for (size_t k = 3; k + 1 < expected.size(); k += 97) {
+      t_docId docId = expected[k] - k % 2;
+      auto next = std::lower_bound(expected.begin(), expected.end(), docId);
+      int rc = it->SkipTo(it->ctx, docId, &h);
+      ASSERT_EQ(*next == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND, rc);
+      ASSERT_EQ(*next, h->docId);
+      if (!quickExit) {
+        ASSERT_EQ(counts[*next], h->agg.numChildren);
+      }
+      ASSERT_EQ(INDEXREAD_OK, it->Read(it->ctx, &h));
+      ASSERT_EQ(*(next + 1), h->docId);
+    }
+    ASSERT_EQ(INDEXREAD_OK, it->SkipTo(it->ctx, expected.back(), &h));
+    ASSERT_EQ(INDEXREAD_EOF, it->Read(it->ctx, &h));
+
+    // batches go through the bitmap windows
+    it->Rewind(it->ctx);
+    for (size_t batchSize : {1, 7, 1000}) {
+      ASSERT_EQ(expected, readDocIdBatches(it, batchSize));
+      it->Rewind(it->ctx);
+    }
+    it->Free(it);
+  }
+
+  for (InvertedIndex *idx : idxs) {
+    InvertedIndex_Free(idx);
+  }
+}
+
+TEST_F(IndexTest, testByteOffsetsSkipTo) {
+  // Two fields of many tokens, so that both are read from checkpoints
+  const uint32_t numToks = 10 * BYTE_OFFSETS_CHECKPOINT_INTERVAL;
+  ByteOffsetWriter w;
+  ByteOffsetWriter_Init(&w);
+  std::vector<uint32_t> expected = {0};  // by position, from 1
+  uint32_t off = 0;
+  for (uint32_t i = 1; i <= numToks; i++) {
+    off += 1 + i % 13;
+    expected.push_back(off);
+    ByteOffsetWriter_Write(&w, off);
+  }
+  RSByteOffsets *offsets = NewByteOffsets();
+  RSByteOffsets_ReserveFields(offsets, 2);
+  RSByteOffsets_AddField(offsets, 0, 1)->lastTokPos = numToks / 3;
+  RSByteOffsets_AddField(offsets, 1, numToks / 3 + 1)->lastTokPos = numToks;
+  ByteOffsetWriter_Move(&w, offsets);
+  ByteOffsetWriter_Cleanup(&w);
+  ASSERT_LT(0, offsets->numCheckpoints);
+
+  RSByteOffsetIterator iter;
+  ASSERT_EQ(REDISMODULE_OK, RSByteOffset_Iterate(offsets, 1, &iter));
+  for (uint32_t pos = numToks / 3 + 1; pos <= numToks; pos++) {
+    ASSERT_EQ(expected[pos], RSByteOffsetIterator_Next(&iter));
+  }
+  ASSERT_EQ(RSBYTEOFFSET_EOF, RSByteOffsetIterator_Next(&iter));
+
+  // Skipping within a field, to the same position, and past its end
+  for (uint32_t stride : {1, 3, 63, 64, 65, 200}) {
+    ASSERT_EQ(REDISMODULE_OK, RSByteOffset_Iterate(offsets, 0, &iter));
+    uint32_t pos = 1;
+    for (; pos <= numToks / 3; pos += stride) {
+      ASSERT_EQ(expected[pos], RSByteOffsetIterator_SkipTo(&iter, pos));
+      ASSERT_EQ(expected[pos], RSByteOffsetIterator_SkipTo(&iter, pos));
+      ASSERT_EQ(pos, iter.curPos);
+    }
+    ASSERT_EQ(RSBYTEOFFSET_EOF, RSByteOffsetIterator_SkipTo(&iter, pos));
+  }
+  RSByteOffsets_Free(offsets);
+}
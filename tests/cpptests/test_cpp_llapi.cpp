@@ -1,10 +1,13 @@
 
 #include "src/redisearch_api.h"
+#include "src/spec.h"
 #include "gtest/gtest.h"
 #include "common.h"
 
 #include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #define DOCID1 "doc1"
 #define DOCID2 "doc2"
@@ -373,6 +376,195 @@ void loadDocsText(RSIndex *index) {
   }
 }
 
+TEST_F(LLApiTest, testAddDocumentsBatch) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateTextField(index, FIELD_NAME_1);
+  RediSearch_CreateField(index, FIELD_NAME_2, RSFLDTYPE_FULLTEXT, RSFLDOPT_WITHSUFFIXTRIE);
+
+  // the terms of the documents are merged, and written with the ids of the documents in order
+  char buff[16];
+  RSDoc* docs[10];
+  for (int i = 0; i < 10; ++i) {
+    sprintf(buff, "%d", i);
+    docs[i] = RediSearch_CreateDocument(buff, strlen(buff), 1.0, NULL);
+    RediSearch_DocumentAddFieldCString(docs[i], FIELD_NAME_1, words[i], RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldCString(docs[i], FIELD_NAME_2, words[i], RSFLDTYPE_DEFAULT);
+  }
+  ASSERT_EQ(REDISMODULE_OK, RediSearch_IndexAddDocuments(index, docs, 10, 0, NULL));
+
+  RSQNode* qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello");
+  RSResultsIterator* iter = RediSearch_GetResultsIterator(qn, index);
+  size_t len;
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(iter, index, &len), "5");
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(iter, index, &len), "6");
+  ASSERT_FALSE(RediSearch_ResultsIteratorNext(iter, index, &len));
+  RediSearch_ResultsIteratorFree(iter);
+
+  // the suffix trie has the merged terms too
+  qn = RediSearch_CreateContainsNode(index, FIELD_NAME_2, "el");
+  iter = RediSearch_GetResultsIterator(qn, index);
+  const char* id;
+  int ii = 0;
+  while ((id = (const char*)RediSearch_ResultsIteratorNext(iter, index, &len))) {
+    ASSERT_TRUE(strstr(words[*id - '0'], "el") != NULL);
+    ++ii;
+  }
+  ASSERT_EQ(ii, 7);
+  RediSearch_ResultsIteratorFree(iter);
+
+  // an existing document is not replaced without REPLACE, but the others are still added
+  RSDoc* more[2];
+  more[0] = RediSearch_CreateDocument("3", 1, 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(more[0], FIELD_NAME_1, "towel", RSFLDTYPE_DEFAULT);
+  more[1] = RediSearch_CreateDocument("10", 2, 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(more[1], FIELD_NAME_1, "towel", RSFLDTYPE_DEFAULT);
+  char* err = NULL;
+  ASSERT_EQ(REDISMODULE_ERR, RediSearch_IndexAddDocuments(index, more, 2, 0, &err));
+  ASSERT_STREQ(err, "Document already exists");
+  rm_free(err);
+
+  qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "towel");
+  iter = RediSearch_GetResultsIterator(qn, index);
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(iter, index, &len), "7");
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(iter, index, &len), "10");
+  ASSERT_FALSE(RediSearch_ResultsIteratorNext(iter, index, &len));
+  RediSearch_ResultsIteratorFree(iter);
+
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(LLApiTest, testResultsInBatches) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateTextField(index, FIELD_NAME_1);
+
+  char buff[16];
+  RSDoc* docs[100];
+  for (int i = 0; i < 100; ++i) {
+    sprintf(buff, "doc%d", i);
+    docs[i] = RediSearch_CreateDocument(buff, strlen(buff), 1.0, NULL);
+    RediSearch_DocumentAddFieldCString(docs[i], FIELD_NAME_1, "hello", RSFLDTYPE_DEFAULT);
+  }
+  ASSERT_EQ(REDISMODULE_OK, RediSearch_IndexAddDocuments(index, docs, 100, 0, NULL));
+  for (int i = 0; i < 100; i += 3) {
+    sprintf(buff, "doc%d", i);
+    ASSERT_EQ(REDISMODULE_OK, RediSearch_DeleteDocument(index, buff, strlen(buff)));
+  }
+
+  // the deleted documents are skipped, with their keys or without
+  for (bool withKeys : {true, false}) {
+    RSQNode* qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello");
+    RSResultsIterator* iter = RediSearch_GetResultsIterator(qn, index);
+    uint64_t ids[16];
+    const char* keys[16];
+    size_t lens[16];
+    std::vector<std::string> all;
+    size_t n;
+    while ((n = RediSearch_ResultsIteratorNextBatch(iter, index, ids, withKeys ? keys : NULL,
+                                                     lens, 16))) {
+      for (size_t ii = 0; ii < n; ++ii) {
+        ASSERT_NE(0, ids[ii]);
+        if (withKeys) {
+          all.push_back(std::string(keys[ii], lens[ii]));
+        } else {
+          all.push_back(std::to_string(ids[ii]));
+        }
+      }
+    }
+    ASSERT_EQ(66, all.size());
+    if (withKeys) {
+      ASSERT_EQ("doc1", all[0]);
+      ASSERT_EQ("doc2", all[1]);
+      ASSERT_EQ("doc98", all[65]);
+    }
+    RediSearch_ResultsIteratorFree(iter);
+  }
+
+  // the same documents are live in the bitmap
+  size_t nwords;
+  const uint64_t* live = RediSearch_IndexLiveDocs(index, &nwords);
+  size_t nlive = 0;
+  for (size_t ii = 0; ii < nwords; ++ii) {
+    nlive += __builtin_popcountll(live[ii]);
+  }
+  ASSERT_EQ(66, nlive);
+
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(LLApiTest, testLockPerIndex) {
+  RSIndex* products = RediSearch_CreateIndex("products", NULL);
+  RediSearch_CreateTextField(products, FIELD_NAME_1);
+  RSIndex* events = RediSearch_CreateIndex("events", NULL);
+  RediSearch_CreateTextField(events, FIELD_NAME_1);
+
+  RSDoc* d = RediSearch_CreateDocument(DOCID1, strlen(DOCID1), 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(products, d);
+
+  // an iterator holds the read lock of its own index only, so the other one can still be written
+  RSQNode* qn = RediSearch_CreateTokenNode(products, FIELD_NAME_1, "hello");
+  RSResultsIterator* iter = RediSearch_GetResultsIterator(qn, products);
+  d = RediSearch_CreateDocument(DOCID2, strlen(DOCID2), 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello", RSFLDTYPE_DEFAULT);
+  ASSERT_EQ(REDISMODULE_OK, RediSearch_SpecAddDocument(events, d));
+  ASSERT_EQ(REDISMODULE_OK, RediSearch_DeleteDocument(events, DOCID2, strlen(DOCID2)));
+
+  size_t len;
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(iter, products, &len), DOCID1);
+  ASSERT_FALSE(RediSearch_ResultsIteratorNext(iter, products, &len));
+  RediSearch_ResultsIteratorFree(iter);
+
+  RediSearch_DropIndex(events);
+  RediSearch_DropIndex(products);
+}
+
+TEST_F(LLApiTest, testIteratorsWithPendingWriter) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateTextField(index, FIELD_NAME_1);
+  RSDoc* d = RediSearch_CreateDocument(DOCID1, strlen(DOCID1), 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+
+  RSQNode* qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello");
+  RSResultsIterator* first = RediSearch_GetResultsIterator(qn, index);
+
+  // a writer waits for the iterator to be freed
+  std::thread writer([&] {
+    RSDoc* d = RediSearch_CreateDocument(DOCID2, strlen(DOCID2), 1.0, NULL);
+    RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello", RSFLDTYPE_DEFAULT);
+    RediSearch_SpecAddDocument(index, d);
+  });
+  IndexSpec* sp = (IndexSpec*)__RefManager_Get_Object(index);
+  while (!__atomic_load_n(&sp->writersWaiting, __ATOMIC_RELAXED)) {
+    std::this_thread::yield();
+  }
+
+  // the thread holding the first iterator keeps reading the index, rather than waiting behind the
+  // writer which waits for it
+  qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello");
+  RSResultsIterator* second = RediSearch_GetResultsIterator(qn, index);
+  size_t len;
+  ASSERT_STREQ((const char*)RediSearch_ResultsIteratorNext(second, index, &len), DOCID1);
+  ASSERT_FALSE(RediSearch_ResultsIteratorNext(second, index, &len));
+  RSIdxInfo info = {.version = RS_INFO_CURRENT_VERSION};
+  ASSERT_EQ(REDISEARCH_OK, RediSearch_IndexInfo(index, &info));
+  ASSERT_EQ(info.numDocuments, 1U);
+  RediSearch_IndexInfoFree(&info);
+
+  // the lock is released with the last iterator, whichever it is
+  RediSearch_ResultsIteratorFree(first);
+  RediSearch_ResultsIteratorFree(second);
+  writer.join();
+
+  qn = RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello");
+  RSResultsIterator* iter = RediSearch_GetResultsIterator(qn, index);
+  ASSERT_TRUE(RediSearch_ResultsIteratorNext(iter, index, &len));
+  ASSERT_TRUE(RediSearch_ResultsIteratorNext(iter, index, &len));
+  ASSERT_FALSE(RediSearch_ResultsIteratorNext(iter, index, &len));
+  RediSearch_ResultsIteratorFree(iter);
+  RediSearch_DropIndex(index);
+}
+
 TEST_F(LLApiTest, testContainsText) {
   // creating the index
   RSIndex* index = RediSearch_CreateIndex("index", NULL);
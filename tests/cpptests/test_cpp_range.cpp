@@ -3,9 +3,12 @@
 
 #include "numeric_index.h"
 #include "index.h"
+#include "rs_geo.h"
 #include "rmutil/alloc.h"
 
 #include <stdio.h>
+#include <algorithm>
+#include <vector>
 
 extern "C" {
 // declaration for an internal function implemented in numeric_index.c
@@ -57,6 +60,53 @@ TEST_F(RangeTest, testRangeTree) {
   NumericRangeTree_Free(t);
 }
 
+TEST_F(RangeTest, testRangeHistogram) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  std::vector<double> values;
+  for (size_t i = 0; i < 50000; i++) {
+    values.push_back((double)(1 + prng() % 5000));
+    NumericRangeTree_Add(t, i + 1, values.back(), false);
+  }
+  NumericRangeTree_RefreshHistogram(t);
+  ASSERT_EQ(array_len(t->histogram.buckets), t->numRanges);
+
+  struct {
+    double min;
+    double max;
+  } rngs[] = {{0, 100}, {10, 1000}, {2500, 3500}, {0, 5000}};
+
+  for (auto &rng : rngs) {
+    NumericFilter nf = { .min = rng.min, .max = rng.max, .inclusiveMin = 1, .inclusiveMax = 1 };
+    size_t actual = std::count_if(values.begin(), values.end(),
+                                  [&](double v) { return v >= rng.min && v <= rng.max; });
+    size_t leaves = 0;
+    Vector *v = NumericRangeTree_Find(t, &nf);
+    for (int i = 0; i < Vector_Size(v); i++) {
+      NumericRange *l;
+      Vector_Get(v, i, &l);
+      leaves += l->entries->numDocs;
+    }
+    Vector_Free(v);
+
+    // the estimate is much closer to the matches than the size of the leaves holding them
+    size_t estimate = NumericRangeTree_EstimateMatches(t, &nf);
+    ASSERT_LE(estimate, leaves);
+    ASSERT_NEAR(estimate, actual, actual / 5 + 10) << rng.min << ".." << rng.max;
+  }
+
+  // nothing is estimated outside of the tree
+  NumericFilter nf = { .min = 6000, .max = 7000, .inclusiveMin = 1, .inclusiveMax = 1 };
+  ASSERT_EQ(NumericRangeTree_EstimateMatches(t, &nf), 0);
+
+  // values added after the refresh still count
+  for (size_t i = 0; i < 1000; i++) {
+    NumericRangeTree_Add(t, 50001 + i, 4000.5, false);
+  }
+  nf = { .min = 0, .max = 5000, .inclusiveMin = 1, .inclusiveMax = 1 };
+  ASSERT_EQ(NumericRangeTree_EstimateMatches(t, &nf), 51000);
+  NumericRangeTree_Free(t);
+}
+
 const size_t MULT_COUNT = 3;
 struct d_arr {
   double v[MULT_COUNT];
@@ -245,3 +295,169 @@ TEST_F(RangeTest, testRangeIteratorMulti) {
 //   NumericFilter_Free(flt);
 //   return 0;
 // }
+
+TEST_F(RangeTest, testRangeIteratorColumn) {
+  RSGlobalConfig.numericSortedColumn = true;
+  NumericRangeTree *t = NewNumericRangeTree();
+
+  const size_t N = 50000;
+  std::vector<d_arr> lookup(N + 1);
+  for (size_t i = 1; i <= N; i++) {
+    for (size_t mult = 0; mult < 2; ++mult) {
+      lookup[i].v[mult] = (double)(1 + prng() % (N / 5));
+      NumericRangeTree_Add(t, i, lookup[i].v[mult], true);
+    }
+  }
+
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  for (size_t i = 0; i < 10; i++) {
+    double min = (double)(1 + prng() % (N / 5));
+    double max = (double)(1 + prng() % (N / 5));
+    NumericFilter *flt = NewNumericFilter(std::min(min, max), std::max(min, max), i % 2, i % 3, true);
+
+    std::vector<t_docId> expected;
+    for (size_t d = 1; d <= N; d++) {
+      if (NumericFilter_Match(flt, lookup[d].v[0]) || NumericFilter_Match(flt, lookup[d].v[1])) {
+        expected.push_back(d);
+      }
+    }
+
+    // the column yields each document once and in order, same as the postings would, along with
+    // a numeric record of one of its matching values
+    std::vector<t_docId> found;
+    IndexIterator *it = createNumericIterator(NULL, t, flt, &config);
+    RSIndexResult *res = NULL;
+    while (it && it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+      found.push_back(res->docId);
+      if (res->type == RSResultType_Union) {
+        res = res->agg.children[0];
+      }
+      ASSERT_EQ(res->type, RSResultType_Numeric);
+      ASSERT_EQ(res->freq, 1U);
+      ASSERT_EQ(res->weight, 1);
+      ASSERT_TRUE(NumericFilter_Match(flt, res->num.value));
+      ASSERT_TRUE(res->num.value == lookup[res->docId].v[0] ||
+                  res->num.value == lookup[res->docId].v[1]);
+    }
+    ASSERT_EQ(found, expected);
+    if (it) it->Free(it);
+    NumericFilter_Free(flt);
+  }
+
+  NumericRangeTree_Free(t);
+  RSGlobalConfig.numericSortedColumn = false;
+}
+
+TEST_F(RangeTest, testGeoCovering) {
+  const double lon = 2.3522, lat = 48.8566, radius = 1500;
+  GeoHashRange cover[GEO_COVER_MAX_CELLS];
+  size_t ncover = calcCovering(lon, lat, radius, cover);
+  ASSERT_GT(ncover, 0);
+  ASSERT_LE(ncover, GEO_COVER_MAX_CELLS);
+  GeoHashRange squares[GEO_RANGE_COUNT] = {{0}};
+  calcRanges(lon, lat, radius, squares);
+
+  auto inRanges = [](const GeoHashRange *ranges, size_t n, double h) {
+    for (size_t i = 0; i < n; ++i) {
+      if (ranges[i].min != ranges[i].max && h >= ranges[i].min && h <= ranges[i].max) return true;
+    }
+    return false;
+  };
+
+  // a grid of points around the circle: every point inside it must be covered, and the covering
+  // should fetch fewer points outside of it than the neighbor squares do
+  size_t coverHits = 0, squareHits = 0;
+  for (int x = -100; x <= 100; ++x) {
+    for (int y = -100; y <= 100; ++y) {
+      double h, xy[2];
+      encodeGeo(lon + x * 0.0005, lat + y * 0.0003, &h);
+      decodeGeo(h, xy);
+      bool covered = inRanges(cover, ncover, h);
+      if (isWithinRadiusLonLat(lon, lat, xy[0], xy[1], radius, NULL)) {
+        ASSERT_TRUE(covered) << x << "," << y;
+      }
+      coverHits += covered;
+      squareHits += inRanges(squares, GEO_RANGE_COUNT, h);
+    }
+  }
+  ASSERT_LT(coverHits, squareHits);
+
+  // ranges are sorted and disjoint
+  for (size_t i = 1; i < ncover; ++i) {
+    ASSERT_LT(cover[i - 1].max, cover[i].min);
+  }
+}
+
+TEST_F(RangeTest, testCardinalitySketch) {
+  KMVSketch s = {0};
+  // exact while the sketch is not full, duplicates are not counted
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(KMV_Add(&s, i));
+    ASSERT_FALSE(KMV_Add(&s, i));
+  }
+  ASSERT_FALSE(KMV_Add(&s, -0.0) && KMV_Add(&s, 0.0));
+  ASSERT_EQ(10, KMV_Estimate(&s));
+  ASSERT_EQ(4.5, KMV_Median(&s));
+
+  for (int i = 10; i < 100000; ++i) {
+    KMV_Add(&s, i);
+  }
+  ASSERT_EQ(KMV_SIZE, s.len);
+  ASSERT_EQ(KMV_SIZE * sizeof(KMVSample), KMV_MemUsage(&s));
+  size_t est = KMV_Estimate(&s);
+  ASSERT_GT(est, 50000);
+  ASSERT_LT(est, 200000);
+  double median = KMV_Median(&s);
+  ASSERT_GT(median, 20000);
+  ASSERT_LT(median, 80000);
+
+  // the union of two disjoint sets of values
+  KMVSketch other = {0};
+  for (int i = 100000; i < 200000; ++i) {
+    KMV_Add(&other, i);
+  }
+  KMV_Merge(&s, &other);
+  ASSERT_EQ(KMV_SIZE, s.len);
+  ASSERT_GT(KMV_Estimate(&s), est);
+  ASSERT_LT(KMV_Estimate(&s), 400000);
+
+  KMV_Clear(&s);
+  KMV_Clear(&other);
+  ASSERT_EQ(0, KMV_Estimate(&s));
+  ASSERT_EQ(0, KMV_MemUsage(&s));
+}
+
+TEST_F(RangeTest, testRetiredRanges) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  NumericRange *first = t->root->range;
+  NumericRangeTree_Add(t, 1, 1, 0);
+
+  // a query reading the tree pins its epoch, the ranges split meanwhile are retired
+  uint64_t epoch = EpochDomain_Pin(t->epochs);
+  for (size_t i = 2; i < 2000; i++) {
+    NumericRangeTree_Add(t, i, i, 0);
+  }
+  ASSERT_GT(t->numRanges, 1);
+  ASSERT_GT(EpochDomain_NumRetired(t->epochs), 0);
+  ASSERT_NE(first, t->root->range);
+  // and still readable
+  ASSERT_EQ(1, first->minVal);
+  ASSERT_LE(1, first->entries->numDocs);
+
+  // a query which started after the splits does not hold them
+  uint64_t later = EpochDomain_Pin(t->epochs);
+  EpochDomain_Unpin(t->epochs, epoch);
+  ASSERT_EQ(0, EpochDomain_NumRetired(t->epochs));
+
+  // the tree may be freed before the last query releases its pin
+  for (size_t i = 2000; i < 4000; i++) {
+    NumericRangeTree_Add(t, i, i, 0);
+  }
+  EpochDomain *epochs = t->epochs;
+  size_t retired = EpochDomain_NumRetired(epochs);
+  ASSERT_GT(retired, 0);
+  NumericRangeTree_Free(t);
+  ASSERT_EQ(retired, EpochDomain_NumRetired(epochs));
+  EpochDomain_Unpin(epochs, later);
+}
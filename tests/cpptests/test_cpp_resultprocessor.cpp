@@ -3,6 +3,8 @@
 #include "query.h"
 #include "gtest/gtest.h"
 
+#include <vector>
+
 struct processor1Ctx : public ResultProcessor {
   processor1Ctx() {
     memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
@@ -79,3 +81,111 @@ TEST_F(ResultProcessorTest, testProcessorChain) {
   ASSERT_EQ(2, numFreed);
   RLookup_Cleanup(&lk);
 }
+
+TEST_F(ResultProcessorTest, testNextBatch) {
+  QueryIterator qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey(&lk, "foo", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  QITR_PushRP(&qitr, p);
+
+  // Read one by one by the fallback, the last batch ends with the EOF
+  SearchResultBatch batch;
+  SearchResultBatch_Init(&batch, 2);
+  std::vector<t_docId> docIds;
+  int rc;
+  do {
+    rc = RP_NextBatch(p, &batch);
+    ASSERT_LE(batch.len, 2);
+    for (size_t ii = 0; ii < batch.len; ++ii) {
+      docIds.push_back(batch.results[ii].docId);
+    }
+    SearchResultBatch_Clear(&batch);
+  } while (rc == RS_RESULT_OK);
+  ASSERT_EQ(RS_RESULT_EOF, rc);
+  ASSERT_EQ(std::vector<t_docId>({1, 2, 3, 4, 5}), docIds);
+  SearchResultBatch_Destroy(&batch);
+
+  // A sorter by fields accumulates its upstream in batches
+  p->counter = 0;
+  const RLookupKey **keys = (const RLookupKey **)rm_calloc(1, sizeof(*keys));
+  keys[0] = p->kout;
+  QITR_PushRP(&qitr, RPSorter_NewByFields(3, keys, 1, SORTASCMAP_INIT));
+  SearchResult r = {0};
+  docIds.clear();
+  while (qitr.endProc->Next(qitr.endProc, &r) == RS_RESULT_OK) {
+    docIds.push_back(r.docId);
+    SearchResult_Clear(&r);
+  }
+  ASSERT_EQ(std::vector<t_docId>({1, 2, 3}), docIds);
+  SearchResult_Destroy(&r);
+
+  QITR_FreeChain(&qitr);
+  rm_free(keys);
+  RLookup_Cleanup(&lk);
+}
+
+struct stringsProcessorCtx : public ResultProcessor {
+  stringsProcessorCtx() {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+  }
+  std::vector<const char *> strs;  // NULL for a missing value
+  size_t counter = 0;
+  RLookupKey *kstr = NULL;
+  RLookupKey *knum = NULL;
+};
+
+// The strings in turn, with a number alternating between 0 and 1
+static int strings_Next(ResultProcessor *rp, SearchResult *res) {
+  stringsProcessorCtx *p = static_cast<stringsProcessorCtx *>(rp);
+  if (p->counter >= p->strs.size()) return RS_RESULT_EOF;
+
+  const char *s = p->strs[p->counter++];
+  res->docId = p->counter;
+  if (s) {
+    RLookup_WriteOwnKey(p->kstr, &res->rowdata, RS_ConstStringVal(s, strlen(s)));
+  }
+  RLookup_WriteOwnKey(p->knum, &res->rowdata, RS_NumVal(res->docId % 2));
+  return RS_RESULT_OK;
+}
+
+static void stringsProcessor_Free(ResultProcessor *rp) {
+  delete static_cast<stringsProcessorCtx *>(rp);
+}
+
+TEST_F(ResultProcessorTest, testSortByStrings) {
+  QueryIterator qitr = {0};
+  RLookup lk = {0};
+  stringsProcessorCtx *p = new stringsProcessorCtx();
+  p->Next = strings_Next;
+  p->Free = stringsProcessor_Free;
+  p->kstr = RLookup_GetKey(&lk, "str", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  p->knum = RLookup_GetKey(&lk, "num", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS);
+  // strings sharing their first 8 bytes are only told apart in full
+  p->strs = {"prefix_with_b", "prefix_with_a", NULL, "", "a", "prefix_with_a", "prefix_wit", "b"};
+  QITR_PushRP(&qitr, p);
+
+  // by the string ascending, then by the number descending
+  const RLookupKey **keys = (const RLookupKey **)rm_calloc(2, sizeof(*keys));
+  keys[0] = p->kstr;
+  keys[1] = p->knum;
+  uint64_t ascmap = SORTASCMAP_INIT;
+  SORTASCMAP_SETDESC(ascmap, 1);
+  QITR_PushRP(&qitr, RPSorter_NewByFields(10, keys, 2, ascmap));
+
+  SearchResult r = {0};
+  std::vector<t_docId> docIds;
+  while (qitr.endProc->Next(qitr.endProc, &r) == RS_RESULT_OK) {
+    docIds.push_back(r.docId);
+    SearchResult_Clear(&r);
+  }
+  // the missing string is last, the equal strings are ordered by their ids
+  ASSERT_EQ(std::vector<t_docId>({4, 5, 8, 7, 6, 2, 1, 3}), docIds);
+  SearchResult_Destroy(&r);
+
+  QITR_FreeChain(&qitr);
+  rm_free(keys);
+  RLookup_Cleanup(&lk);
+}
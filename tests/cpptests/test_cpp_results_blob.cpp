@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include "aggregate/results_blob.h"
+#include "rmalloc.h"
+#include "redismodule.h"
+
+#include <string.h>
+
+class ResultsBlobTest : public ::testing::Test {};
+
+static void roundtrip(size_t nrows, size_t strLen) {
+  const char *names[] = {"num", "str"};
+  size_t nameLens[] = {3, 3};
+  std::string s(strLen, 'x');
+
+  ResultsBlobWriter w;
+  ResultsBlobWriter_Init(&w, names, nameLens, 2);
+  for (size_t ii = 0; ii < nrows; ++ii) {
+    RSValue *n = RS_NumVal(ii);
+    RSValue *str = RS_NewCopiedString(s.c_str(), s.size());
+    ResultsBlobWriter_Write(&w, 0, n);
+    // every other row misses the string field
+    ResultsBlobWriter_Write(&w, 1, ii % 2 ? NULL : str);
+    ResultsBlobWriter_EndRow(&w);
+    RSValue_Decref(n);
+    RSValue_Decref(str);
+  }
+  size_t len;
+  char *data = ResultsBlobWriter_Finish(&w, 1000, RESULTS_BLOB_F_EXPAND, &len);
+  ASSERT_EQ(0, w.nrows);
+  ResultsBlobWriter_Free(&w);
+
+  ResultsBlob rb;
+  ASSERT_EQ(REDISMODULE_OK, ResultsBlob_Open(&rb, data, len));
+  ASSERT_EQ(nrows, rb.nrows);
+  ASSERT_EQ(1000, rb.totalResults);
+  ASSERT_TRUE(rb.flags & RESULTS_BLOB_F_EXPAND);
+  ASSERT_EQ(2, rb.ncols);
+  ASSERT_EQ(0, strncmp("str", rb.names[1], rb.nameLens[1]));
+  for (size_t ii = 0; ii < nrows; ++ii) {
+    RSValue *n = ResultsBlob_Read(&rb, 0);
+    ASSERT_TRUE(n);
+    ASSERT_EQ(ii, n->numval);
+    RSValue_Decref(n);
+    RSValue *str = ResultsBlob_Read(&rb, 1);
+    if (ii % 2) {
+      ASSERT_FALSE(str);
+    } else {
+      ASSERT_TRUE(str);
+      size_t n;
+      const char *p = RSValue_StringPtrLen(str, &n);
+      ASSERT_EQ(s, std::string(p, n));
+      RSValue_Decref(str);
+    }
+  }
+  ResultsBlob_Close(&rb);
+
+  // A truncated blob is rejected
+  ASSERT_EQ(REDISMODULE_ERR, ResultsBlob_Open(&rb, data, len - 1));
+  rm_free(data);
+}
+
+TEST_F(ResultsBlobTest, testRoundtrip) {
+  roundtrip(10, 16);
+}
+
+TEST_F(ResultsBlobTest, testCompressed) {
+  roundtrip(1000, 200);
+}
@@ -1,6 +1,9 @@
 #include "rlookup.h"
 #include "gtest/gtest.h"
 
+#include <string>
+#include <vector>
+
 class RLookupTest : public ::testing::Test {};
 
 TEST_F(RLookupTest, testInit) {
@@ -62,3 +65,31 @@ TEST_F(RLookupTest, testRow) {
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
 }
+
+TEST_F(RLookupTest, testIndexedKeys) {
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  // enough keys for the lookup to index them
+  std::vector<RLookupKey *> keys;
+  for (int i = 0; i < 100; i++) {
+    std::string name = "field" + std::to_string(i);
+    keys.push_back(RLookup_GetKey(&lk, name.c_str(), RLOOKUP_M_WRITE, RLOOKUP_F_NAMEALLOC));
+    ASSERT_TRUE(keys.back());
+  }
+  ASSERT_TRUE(lk.index.cap);
+  for (int i = 0; i < 100; i++) {
+    std::string name = "field" + std::to_string(i);
+    ASSERT_EQ(keys[i], RLookup_GetKey(&lk, name.c_str(), RLOOKUP_M_READ, RLOOKUP_F_NOFLAGS));
+  }
+  ASSERT_EQ(NULL, RLookup_GetKey(&lk, "field100", RLOOKUP_M_READ, RLOOKUP_F_NOFLAGS));
+  ASSERT_EQ(NULL, RLookup_GetKey(&lk, "field1", RLOOKUP_M_WRITE, RLOOKUP_F_NOFLAGS));
+
+  // an overridden key is replaced by its new key
+  RLookupKey *k = RLookup_GetKey(&lk, "field42", RLOOKUP_M_WRITE, RLOOKUP_F_OVERRIDE);
+  ASSERT_TRUE(k);
+  ASSERT_NE(keys[42], k);
+  ASSERT_EQ(keys[42]->dstidx, k->dstidx);
+  ASSERT_EQ(k, RLookup_GetKey(&lk, "field42", RLOOKUP_M_READ, RLOOKUP_F_NOFLAGS));
+
+  RLookup_Cleanup(&lk);
+}
@@ -0,0 +1,128 @@
+#include "suffix.h"
+#include "rmalloc.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <climits>
+#include <set>
+#include <string>
+#include <vector>
+
+class SuffixTest : public ::testing::Test {};
+
+static struct timespec noTimeout() {
+  struct timespec ts = {0};
+  ts.tv_sec = INT_MAX;
+  return ts;
+}
+
+// The terms found in the array, sorted
+static std::vector<std::string> lookup(SuffixArray *sa, const std::string &s, bool prefix) {
+  std::vector<std::string> res;
+  arrayof(char *) arr = GetList_SuffixTrieMap(sa, s.c_str(), s.size(), prefix, noTimeout());
+  if (arr) {
+    for (uint32_t i = 0; i < array_len(arr); ++i) {
+      res.push_back(arr[i]);
+    }
+    array_free(arr);
+  }
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+// The terms containing the string, or ending with it if not `prefix`, sorted
+static std::vector<std::string> bruteForce(const std::set<std::string> &terms,
+                                           const std::string &s, bool prefix) {
+  std::vector<std::string> res;
+  for (auto &t : terms) {
+    if (prefix ? t.find(s) != std::string::npos
+               : t.size() >= s.size() && !t.compare(t.size() - s.size(), s.size(), s)) {
+      res.push_back(t);
+    }
+  }
+  return res;
+}
+
+static void checkLookups(SuffixArray *sa, const std::set<std::string> &terms) {
+  std::vector<std::string> queries = {"ab", "ba", "abc", "cab", "aaa", "ca", "bcb", "cc", "abca"};
+  for (auto &q : queries) {
+    ASSERT_EQ(bruteForce(terms, q, true), lookup(sa, q, true)) << "contains " << q;
+    ASSERT_EQ(bruteForce(terms, q, false), lookup(sa, q, false)) << "suffix " << q;
+  }
+}
+
+// The i-th term, of 3 to 8 letters out of "abc"
+static std::string makeTerm(uint32_t i) {
+  std::string s;
+  uint32_t n = i * 2654435761U;
+  size_t len = 3 + i % 6;
+  while (s.size() < len) {
+    s += "abc"[n % 3];
+    n = n / 3 + i;
+  }
+  return s;
+}
+
+TEST_F(SuffixTest, testSegments) {
+  SuffixArray *sa = NewSuffixArray();
+  std::set<std::string> terms;
+  // Enough suffixes for many flushes of the pending ones and merges of the segments
+  for (uint32_t i = 0; terms.size() < 3000; ++i) {
+    std::string t = makeTerm(i);
+    if (terms.insert(t).second) {
+      addSuffixTrie(sa, t.c_str(), t.size());
+    }
+    if (terms.size() % 500 == 0) {
+      checkLookups(sa, terms);
+    }
+  }
+  checkLookups(sa, terms);
+
+  // Deleting half the terms compacts the segments
+  std::vector<std::string> deleted;
+  bool odd = false;
+  for (auto it = terms.begin(); it != terms.end();) {
+    if ((odd = !odd)) {
+      deleteSuffixTrie(sa, it->c_str(), it->size());
+      deleted.push_back(*it);
+      it = terms.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  checkLookups(sa, terms);
+  // Deleting a term which is not there does nothing
+  deleteSuffixTrie(sa, deleted[0].c_str(), deleted[0].size());
+  checkLookups(sa, terms);
+
+  // The ids of the deleted terms are reused
+  for (size_t i = 0; i < deleted.size(); i += 3) {
+    terms.insert(deleted[i]);
+    addSuffixTrie(sa, deleted[i].c_str(), deleted[i].size());
+  }
+  checkLookups(sa, terms);
+
+  SuffixArray_Free(sa);
+}
+
+TEST_F(SuffixTest, testLongTerm) {
+  SuffixArray *sa = NewSuffixArray();
+  // The offsets of the suffixes past UINT16_MAX are kept
+  std::string t(70000, 'a');
+  t.replace(UINT16_MAX + 100, 6, "marker");
+  addSuffixTrie(sa, t.c_str(), t.size());
+  addSuffixTrie(sa, "short", 5);
+  // Every suffix of the long term but its last character, and the 4 of the short one
+  ASSERT_EQ(t.size() - 1 + 4, SuffixArray_NumSuffixes(sa));
+
+  ASSERT_EQ(std::vector<std::string>{t}, lookup(sa, "marker", true));
+  ASSERT_EQ(std::vector<std::string>{t}, lookup(sa, "markeraa", true));
+  ASSERT_EQ(std::vector<std::string>{t}, lookup(sa, t.substr(t.size() - 10), false));
+  ASSERT_TRUE(lookup(sa, "markerb", true).empty());
+
+  deleteSuffixTrie(sa, t.c_str(), t.size());
+  ASSERT_TRUE(lookup(sa, "marker", true).empty());
+  ASSERT_EQ(std::vector<std::string>{"short"}, lookup(sa, "ort", true));
+
+  SuffixArray_Free(sa);
+}
@@ -1,4 +1,5 @@
 #include "tag_index.h"
+#include "rmalloc.h"
 #include "gtest/gtest.h"
 
 #include <vector>
@@ -49,6 +50,65 @@ TEST_F(TagIndexTest, testCreate) {
   TagIndex_Free(idx);
 }
 
+static Expansion *newExpansion(std::vector<const char *> values) {
+  char **arr = array_new(char *, values.size());
+  for (auto v : values) {
+    arr = array_append(arr, rm_strdup(v));
+  }
+  return NewExpansion(arr);
+}
+
+TEST_F(TagIndexTest, testExpansionCache) {
+  TagIndex *idx = NewTagIndex();
+  std::vector<const char *> v{"hello", "help"};
+  for (t_docId d = 1; d <= 10; d++) {
+    TagIndex_Index(idx, &v[0], v.size(), d);
+  }
+
+  Expansion *exp = newExpansion(v);
+  TagIndex_CacheExpansion(idx, Expansion_Prefix, "hel", 3, 200, exp);
+  Expansion_Release(exp);
+
+  Expansion *cached = TagIndex_GetExpansion(idx, Expansion_Prefix, "hel", 3, 200);
+  ASSERT_EQ(exp, cached);
+  ASSERT_EQ(2, array_len(cached->values));
+  ASSERT_STREQ("help", cached->values[1]);
+
+  // the type of the expansion and its limit are a part of the key
+  ASSERT_FALSE(TagIndex_GetExpansion(idx, Expansion_Suffix, "hel", 3, 200));
+  ASSERT_FALSE(TagIndex_GetExpansion(idx, Expansion_Prefix, "hel", 3, 1));
+
+  // indexing an existing value keeps the cache, a new value drops it
+  const char *existing = "hello", *added = "helm";
+  TagIndex_Index(idx, &existing, 1, 11);
+  Expansion *again = TagIndex_GetExpansion(idx, Expansion_Prefix, "hel", 3, 200);
+  ASSERT_EQ(exp, again);
+  Expansion_Release(again);
+  TagIndex_Index(idx, &added, 1, 12);
+  ASSERT_FALSE(TagIndex_GetExpansion(idx, Expansion_Prefix, "hel", 3, 200));
+
+  // the expansion held by a query outlives the cache
+  ASSERT_STREQ("hello", cached->values[0]);
+  Expansion_Release(cached);
+
+  // the least recently used expansion is evicted
+  for (int i = 0; i <= EXPANSION_CACHE_SIZE; i++) {
+    std::string pattern = std::to_string(i);
+    exp = newExpansion({});
+    TagIndex_CacheExpansion(idx, Expansion_Wildcard, pattern.c_str(), pattern.size(), 200, exp);
+    Expansion_Release(exp);
+    if (i == 1) {
+      // "0" is used again, so "1" is the least recently used one
+      Expansion_Release(TagIndex_GetExpansion(idx, Expansion_Wildcard, "0", 1, 200));
+    }
+  }
+  exp = TagIndex_GetExpansion(idx, Expansion_Wildcard, "0", 1, 200);
+  ASSERT_TRUE(exp);
+  Expansion_Release(exp);
+  ASSERT_FALSE(TagIndex_GetExpansion(idx, Expansion_Wildcard, "1", 1, 200));
+  TagIndex_Free(idx);
+}
+
 #define TEST_MY_SEP(sep, str)                     \
   orig = s = strdup(str);                         \
   token = TagIndex_SepString(sep, &s, &tokenLen); \
@@ -90,3 +150,37 @@ TEST_F(TagIndexTest, testSepString) {
 
   TEST_MY_SEP(' ', "   foo    bar   ")
 }
+
+TEST_F(TagIndexTest, testExpansionCacheMemory) {
+  ExpansionCache *cache = NewExpansionCache();
+  std::string big(EXPANSION_CACHE_MEMORY / 4, 'x');
+
+  // an expansion larger than the cache is not kept
+  Expansion *exp = newExpansion({big.c_str(), big.c_str(), big.c_str(), big.c_str()});
+  ExpansionCache_Put(cache, 0, "a", 1, 200, exp);
+  Expansion_Release(exp);
+  ASSERT_FALSE(ExpansionCache_Get(cache, 0, "a", 1, 200));
+
+  // the least recently used expansions are evicted to fit the memory of a new one
+  for (const char *key : {"a", "b", "c", "d"}) {
+    exp = newExpansion({big.c_str()});
+    ExpansionCache_Put(cache, 0, key, 1, 200, exp);
+    Expansion_Release(exp);
+  }
+  ExpansionCacheStats stats = ExpansionCache_GetStats(cache);
+  ASSERT_EQ(3, stats.entries);
+  ASSERT_LE(stats.memory, EXPANSION_CACHE_MEMORY);
+  ASSERT_FALSE(ExpansionCache_Get(cache, 0, "a", 1, 200));
+  exp = ExpansionCache_Get(cache, 0, "d", 1, 200);
+  ASSERT_TRUE(exp);
+  Expansion_Release(exp);
+
+  // another revision drops the entries
+  ASSERT_FALSE(ExpansionCache_Get(cache, 1, "d", 1, 200));
+  stats = ExpansionCache_GetStats(cache);
+  ASSERT_EQ(1, stats.hits);
+  ASSERT_EQ(3, stats.misses);
+  ASSERT_EQ(0, stats.entries);
+  ASSERT_EQ(0, stats.memory);
+  ExpansionCache_Free(cache);
+}
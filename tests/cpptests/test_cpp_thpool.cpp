@@ -2,6 +2,7 @@
 #include "thpool/thpool.h"
 #include <chrono>
 #include <thread>
+#include <atomic>
 
 class PriorityThpoolTestBasic : public ::testing::Test {
 
@@ -145,3 +146,154 @@ TEST_F(PriorityThpoolTestWithoutPrivilegedThreads, CombinationTest) {
     ASSERT_LT(arr[2], arr[4]);
     ASSERT_LT(arr[4], arr[3]);
 }
+
+/* The threads which are not privileged run <weight> high priority tasks for every low priority task.
+ */
+TEST_F(PriorityThpoolTestWithoutPrivilegedThreads, HighPriorityWeight) {
+    int total_tasks = 6;
+    std::chrono::time_point<std::chrono::high_resolution_clock> arr[total_tasks];
+    test_struct ts[total_tasks];
+    for (int i = 0; i < total_tasks; i++) {
+        ts[i].arr = arr;
+        ts[i].index = i;
+    }
+    redisearch_thpool_set_high_priority_weight(this->pool, 2);
+
+    // Tasks 0-3 are high priority, tasks 4-5 are low priority
+    for (int i = 0; i < total_tasks; i++) {
+        redisearch_thpool_add_work(this->pool, (void (*)(void *))sleep_and_set, (void *)&ts[i],
+                                   i < 4 ? THPOOL_PRIORITY_HIGH : THPOOL_PRIORITY_LOW);
+    }
+    redisearch_thpool_init(this->pool, nullptr);
+    redisearch_thpool_wait(this->pool);
+
+    // Expect two high priority tasks for every low priority one: 0->1->4->2->3->5
+    ASSERT_LT(arr[0], arr[1]);
+    ASSERT_LT(arr[1], arr[4]);
+    ASSERT_LT(arr[4], arr[2]);
+    ASSERT_LT(arr[2], arr[3]);
+    ASSERT_LT(arr[3], arr[5]);
+}
+
+class WorkStealingThpoolTest : public ::testing::Test {
+
+   public:
+    redisearch_threadpool pool;
+    virtual void SetUp() {
+        this->pool = redisearch_thpool_create(4, 1);
+        redisearch_thpool_init(this->pool, nullptr);
+    }
+
+    virtual void TearDown() {
+        redisearch_thpool_destroy(this->pool);
+    }
+};
+
+struct fork_ctx {
+    redisearch_threadpool pool;
+    std::atomic<int> *counter;
+};
+
+void count_job(fork_ctx *ctx) {
+    ctx->counter->fetch_add(1);
+}
+
+void fork_jobs(fork_ctx *ctx) {
+    for (int i = 0; i < 1000; i++) {
+        redisearch_thpool_add_work(ctx->pool, (void (*)(void *))count_job, (void *)ctx,
+                                   i % 2 ? THPOOL_PRIORITY_LOW : THPOOL_PRIORITY_HIGH);
+    }
+}
+
+/* Jobs adding jobs push them to the deque of their thread, from where the idle threads steal them.
+ * Waiting for the pool waits for the forked jobs as well.
+ */
+TEST_F(WorkStealingThpoolTest, ForkFromJobs) {
+    std::atomic<int> counter(0);
+    fork_ctx ctx = {this->pool, &counter};
+    for (int round = 1; round <= 10; round++) {
+        for (int i = 0; i < 10; i++) {
+            redisearch_thpool_add_work(this->pool, (void (*)(void *))fork_jobs, (void *)&ctx, THPOOL_PRIORITY_HIGH);
+        }
+        redisearch_thpool_wait(this->pool);
+        ASSERT_EQ(counter.load(), round * 10000);
+        ASSERT_EQ(redisearch_thpool_num_threads_working(this->pool), 0);
+    }
+}
+
+struct prioritized_ctx {
+    redisearch_threadpool pool;
+    test_struct ts[4];
+};
+
+void fork_prioritized(prioritized_ctx *ctx) {
+    redisearch_threadpool pool = ctx->pool;
+    test_struct *ts = ctx->ts;
+    redisearch_thpool_add_work(pool, (void (*)(void *))sleep_and_set, (void *)&ts[0], THPOOL_PRIORITY_LOW);
+    redisearch_thpool_add_work(pool, (void (*)(void *))sleep_and_set, (void *)&ts[1], THPOOL_PRIORITY_HIGH);
+    redisearch_thpool_add_work(pool, (void (*)(void *))sleep_and_set, (void *)&ts[2], THPOOL_PRIORITY_LOW);
+    redisearch_thpool_add_work(pool, (void (*)(void *))sleep_and_set, (void *)&ts[3], THPOOL_PRIORITY_HIGH);
+}
+
+/* The priorities hold for the jobs added from a job: the single privileged thread of the pool
+ * takes the high priority jobs it forked before the low priority ones.
+ */
+TEST_F(PriorityThpoolTestBasic, ForkedHighBeforeLow) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> arr[4];
+    prioritized_ctx ctx;
+    ctx.pool = this->pool;
+    for (int i = 0; i < 4; i++) {
+        ctx.ts[i].arr = arr;
+        ctx.ts[i].index = i;
+    }
+    redisearch_thpool_add_work(this->pool, (void (*)(void *))fork_prioritized, (void *)&ctx, THPOOL_PRIORITY_HIGH);
+    redisearch_thpool_wait(this->pool);
+    ASSERT_LT(arr[1], arr[0]);
+    ASSERT_LT(arr[1], arr[2]);
+    ASSERT_LT(arr[3], arr[0]);
+    ASSERT_LT(arr[3], arr[2]);
+}
+
+void count_start(std::atomic<int> *started) {
+    started->fetch_add(1);
+}
+
+static uint64_t thread_cpu_usec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Consume 20ms of CPU time
+void spin_job(void *) {
+    uint64_t end = thread_cpu_usec() + 20000;
+    while (thread_cpu_usec() < end) {
+    }
+}
+
+/* Every thread runs the start function before it runs any job, and the CPU time of the threads
+ * accounts for the jobs they ran.
+ */
+TEST(ThpoolThreadsTest, StartAndCpuTime) {
+    std::atomic<int> started(0);
+    redisearch_threadpool pool = redisearch_thpool_create(4, 1);
+    redisearch_thpool_set_thread_start(pool, (thread_start_func)count_start, &started);
+    redisearch_thpool_init(pool, nullptr);
+    ASSERT_EQ(started.load(), 4);
+
+    for (int i = 0; i < 4; i++) {
+        redisearch_thpool_add_work(pool, spin_job, nullptr, THPOOL_PRIORITY_HIGH);
+    }
+    redisearch_thpool_wait(pool);
+    uint64_t total_usec = 0;
+    for (size_t i = 0; i < 4; i++) {
+        total_usec += redisearch_thpool_thread_cpu_usec(pool, i);
+    }
+    ASSERT_GE(total_usec, 4 * 20000);
+    ASSERT_EQ(redisearch_thpool_thread_cpu_usec(pool, 4), 0);
+
+    // Once the threads are terminated they are not read
+    redisearch_thpool_terminate_threads(pool);
+    ASSERT_EQ(redisearch_thpool_thread_cpu_usec(pool, 0), 0);
+    redisearch_thpool_destroy(pool);
+}
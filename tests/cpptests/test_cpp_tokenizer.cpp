@@ -122,4 +122,30 @@ TEST_F(TokenizerTest, testTrailingEscapes) {
   ASSERT_NE(tokens.end(), tokens.find("world "));  // note the space
   tk->Free(tk);
   free(txt);
-}
\ No newline at end of file
+}
+TEST_F(TokenizerTest, testLongAsciiTokens) {
+  // tokens and separators spanning several chunks of the ASCII fast path, mixed with escapes,
+  // control bytes and non ASCII text which take the slow one
+  RSTokenizer *tk = GetSimpleTokenizer(NULL, DefaultStopWordList());
+  char *txt = strdup(
+      "TheQuickBrownFoxJumpsOverTheLazyDog                     ,,,,,,,,,,,,,,,,,,,,,, "
+      "And ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 with\\-an\\-escaped\\-DASH "
+      "BELL\aINSIDE שלוםWORLD UPPERCASEUPPERCASEUPPERCASE\\");
+  const char *expected[] = {"thequickbrownfoxjumpsoverthelazydog",
+                            "abcdefghijklmnopqrstuvwxyz0123456789",
+                            "with-an-escaped-dash",
+                            "bellinside",
+                            "שלוםworld",
+                            "uppercaseuppercaseuppercase"};
+  tk->Start(tk, txt, strlen(txt), TOKENIZE_NOSTEM);
+  Token tok;
+  size_t i = 0;
+  while (tk->Next(tk, &tok)) {
+    ASSERT_LT(i, sizeof(expected) / sizeof(*expected));
+    ASSERT_EQ(std::string(expected[i]), std::string(tok.tok, tok.tokLen));
+    i++;
+  }
+  ASSERT_EQ(sizeof(expected) / sizeof(*expected), i);
+  free(txt);
+  tk->Free(tk);
+}
@@ -326,6 +326,37 @@ TEST_F(TrieTest, testScoreOrder) {
   TrieType_Free(t);
 }
 
+TEST_F(TrieTest, testCompact) {
+  Trie *t = NewTrie(NULL, Trie_Sort_Lex);
+  char buf[64];
+  for (size_t ii = 0; ii < 3000; ++ii) {
+    sprintf(buf, "%lu", (unsigned long)ii);
+    ASSERT_TRUE(trieInsert(t, buf));
+  }
+  // Insertions compacted the trie, the latest ones are not in the arena yet
+  ASSERT_TRUE(t->arena != NULL);
+  ASSERT_GT(t->uncompacted, 0);
+  ASSERT_EQ(3000, trieIterRange(t, NULL, NULL).size());
+  ASSERT_EQ(1111, trieIterRange(t, "1", "1Z").size());
+
+  // Change frozen nodes
+  for (size_t ii = 0; ii < 3000; ii += 2) {
+    sprintf(buf, "%lu", (unsigned long)ii);
+    ASSERT_TRUE(Trie_Delete(t, buf, strlen(buf)));
+  }
+  ASSERT_TRUE(trieInsert(t, "1A"));
+  ASSERT_EQ(1501, trieIterRange(t, NULL, NULL).size());
+
+  Trie_Compact(t);
+  ASSERT_EQ(0, t->uncompacted);
+  ASSERT_EQ(1501, trieIterRange(t, NULL, NULL).size());
+  ASSERT_EQ(557, trieIterRange(t, "1", "1Z").size());
+  ASSERT_TRUE(trieInsert(t, "1AB"));
+  ASSERT_EQ(558, trieIterRange(t, "1", "1Z").size());
+
+  TrieType_Free(t);
+}
+
 /* leave for future benchmarks if needed
 TEST_F(TrieTest, testbenchmark) {
   Trie *t = NewTrie(trieFreeCb, Trie_Sort_Lex);
@@ -87,4 +87,24 @@ TEST_F(ValueTest, testNumericFormat) {
   RSValue_SetNumber(v, 1581011976800);
   ASSERT_STREQ("1581011976800", toString(v).c_str());
   RSValue_Decref(v);
-}
\ No newline at end of file
+}
+TEST_F(ValueTest, testCopiedString) {
+  // a short string is stored along with its value
+  std::string s(RSVALUE_INLINE_STR_MAX, 'a');
+  RSValue *v = RS_NewCopiedString(s.c_str(), s.size());
+  ASSERT_EQ(RSValue_String, v->t);
+  ASSERT_EQ(1, v->inlinestr);
+  ASSERT_EQ((char *)v + sizeof(RSValue), v->strval.str);
+  ASSERT_EQ(s, toString(v));
+  // the value can be reset to another type and still be released to its pool
+  RSValue_Clear(v);
+  RSValue_SetNumber(v, 3);
+  RSValue_Decref(v);
+
+  s += 'b';
+  v = RS_NewCopiedString(s.c_str(), s.size());
+  ASSERT_EQ(0, v->inlinestr);
+  ASSERT_EQ(s, toString(v));
+  ASSERT_EQ(0, v->strval.str[s.size()]);
+  RSValue_Decref(v);
+}
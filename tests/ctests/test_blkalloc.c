@@ -88,7 +88,32 @@ static int testFreeFunc() {
   return 0;
 }
 
+// Allocations of different sizes share a block as long as they fit in its capacity
+static int testMixedSizes() {
+  BlkAlloc alloc;
+  BlkAlloc_Init(&alloc);
+
+  char *buf = BlkAlloc_Alloc(&alloc, 8, 64);
+  char *buf2 = BlkAlloc_Alloc(&alloc, 32, 32);
+  ASSERT(buf2 == buf + 8);
+  ASSERT(alloc.root == alloc.last);
+
+  BlkAllocBlock *block = alloc.last;
+  char *buf3 = BlkAlloc_Alloc(&alloc, 16, 16);
+  ASSERT(alloc.last == block);
+  ASSERT(buf3 == buf2 + 32);
+
+  // the block is smaller than the requested block size, and cannot hold the element
+  BlkAlloc_Alloc(&alloc, 30, 128);
+  ASSERT(alloc.last != block);
+  ASSERT(alloc.last->capacity == 128);
+
+  BlkAlloc_FreeAll(&alloc, NULL, NULL, 0);
+  return 0;
+}
+
 TEST_MAIN({
   TESTFUNC(testBlockAlloc);
   TESTFUNC(testFreeFunc);
+  TESTFUNC(testMixedSizes);
 })
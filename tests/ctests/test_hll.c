@@ -0,0 +1,111 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+
+#include "src/hll/hll.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <math.h>
+#include <string.h>
+
+// FNV does not spread consecutive integers well enough for the registers, mix them instead
+static uint32_t mix(uint32_t h) {
+  h *= 0x9e3779b1;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static void addRange(struct HLL *hll, uint32_t from, uint32_t to) {
+  for (uint32_t ii = from; ii < to; ++ii) {
+    hll_add_hash(hll, mix(ii));
+  }
+}
+
+static int testSparse() {
+  // a few values are counted exactly, without registers
+  struct HLL hll;
+  ASSERT_EQUAL(0, hll_init(&hll, 8));
+  ASSERT_EQUAL(0, hll_count(&hll));
+  addRange(&hll, 0, 50);
+  addRange(&hll, 10, 20);
+  ASSERT(hll.registers == NULL);
+  ASSERT_EQUAL(50, hll_count(&hll));
+
+  // more hashes than fit in the memory of the registers make it dense
+  addRange(&hll, 50, HLL_SPARSE_MAX(&hll) + 1);
+  ASSERT(hll.registers != NULL);
+  ASSERT(hll.sparse == NULL);
+  hll_destroy(&hll);
+  return 0;
+}
+
+static int testMerge() {
+  // sparse and dense HLLs merge into the registers of all their values
+  struct HLL all, sparse, dense;
+  hll_init(&all, 8);
+  hll_init(&sparse, 8);
+  hll_init(&dense, 8);
+  addRange(&all, 0, 1000);
+  addRange(&sparse, 0, 30);
+  addRange(&dense, 30, 1000);
+  ASSERT(sparse.registers == NULL);
+  ASSERT(dense.registers != NULL);
+
+  struct HLL merged;
+  hll_init(&merged, 8);
+  ASSERT_EQUAL(0, hll_merge(&merged, &sparse));
+  ASSERT(merged.registers == NULL);
+  ASSERT_EQUAL(0, hll_merge(&merged, &dense));
+  ASSERT(merged.registers != NULL);
+  ASSERT(!memcmp(all.registers, merged.registers, all.size));
+  ASSERT_EQUAL(0, hll_merge(&dense, &sparse));
+  ASSERT(!memcmp(all.registers, dense.registers, all.size));
+
+  // the hashes of a sparse HLL can be loaded back
+  struct HLL loaded;
+  ASSERT_EQUAL(0, hll_load_sparse(&loaded, 8, sparse.sparse, sparse.sparseLen));
+  ASSERT_EQUAL(30, hll_count(&loaded));
+
+  struct HLL other;
+  hll_init(&other, 10);
+  ASSERT_EQUAL(-1, hll_merge(&merged, &other));
+
+  hll_destroy(&all);
+  hll_destroy(&sparse);
+  hll_destroy(&dense);
+  hll_destroy(&merged);
+  hll_destroy(&loaded);
+  hll_destroy(&other);
+  return 0;
+}
+
+static int testEstimate() {
+  // the estimates are close at all cardinalities, including those where the raw estimate is biased
+  struct HLL hll;
+  hll_init(&hll, 12);
+  uint32_t cardinalities[] = {2000, 5000, 10000, 20000, 50000, 200000};
+  uint32_t added = 0;
+  for (size_t ii = 0; ii < sizeof(cardinalities) / sizeof(*cardinalities); ++ii) {
+    addRange(&hll, added, cardinalities[ii]);
+    added = cardinalities[ii];
+    double estimate = hll_count(&hll);
+    ASSERT(fabs(estimate - added) <= 0.05 * added);
+  }
+  hll_destroy(&hll);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  TESTFUNC(testSparse);
+  TESTFUNC(testMerge);
+  TESTFUNC(testEstimate);
+})
@@ -0,0 +1,93 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+
+#include "src/util/tdigest.h"
+#include "src/buffer.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NUM_VALUES 100000
+
+static int cmpDoubles(const void *a, const void *b) {
+  double da = *(const double *)a, db = *(const double *)b;
+  return da < db ? -1 : da > db;
+}
+
+static int testExact() {
+  // a few values are all kept, so the quantiles are the values at their rank
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  for (size_t ii = 0; ii <= 100; ++ii) {
+    TDigest_Add(td, (ii * 37) % 101);
+  }
+  ASSERT_EQUAL(101, TDigest_GetCount(td));
+  ASSERT_EQUAL(0, TDigest_Quantile(td, 0));
+  ASSERT_EQUAL(50, TDigest_Quantile(td, 0.5));
+  ASSERT_EQUAL(95, TDigest_Quantile(td, 0.95));
+  ASSERT_EQUAL(100, TDigest_Quantile(td, 1));
+  TDigest_Free(td);
+  return 0;
+}
+
+static int testMerge() {
+  // digests of parts of the values, merged through their serialization, estimate the quantiles
+  // of all the values
+  double *values = malloc(NUM_VALUES * sizeof(*values));
+  TDigest *parts[3];
+  for (size_t ii = 0; ii < 3; ++ii) {
+    parts[ii] = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  }
+  srand(42);
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    values[ii] = -log((rand() + 1.0) / ((double)RAND_MAX + 1)) * 100;
+    TDigest_Add(parts[ii % 3], values[ii]);
+  }
+
+  Buffer buf;
+  Buffer_Init(&buf, 64);
+  BufferWriter bw = NewBufferWriter(&buf);
+  TDigest_Serialize(parts[1], &bw);
+  size_t firstSize = buf.offset;
+  TDigest_Serialize(parts[2], &bw);
+  BufferReader br = NewBufferReader(&buf);
+  TDigest *merged = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  TDigest_Merge(merged, parts[0]);
+  ASSERT(TDigest_Deserialize(merged, &br));
+  ASSERT(TDigest_Deserialize(merged, &br));
+  ASSERT(BufferReader_AtEnd(&br));
+  ASSERT_EQUAL(NUM_VALUES, TDigest_GetCount(merged));
+
+  qsort(values, NUM_VALUES, sizeof(*values), cmpDoubles);
+  double quantiles[] = {0.01, 0.5, 0.9, 0.99, 0.999};
+  for (size_t ii = 0; ii < sizeof(quantiles) / sizeof(*quantiles); ++ii) {
+    double exact = values[(size_t)ceil(quantiles[ii] * NUM_VALUES) - 1];
+    double estimate = TDigest_Quantile(merged, quantiles[ii]);
+    ASSERT(fabs(estimate - exact) <= 0.01 * exact);
+  }
+
+  // truncated digests are rejected
+  Buffer trunc = {.data = buf.data, .cap = buf.offset, .offset = firstSize - 1};
+  BufferReader tbr = NewBufferReader(&trunc);
+  ASSERT(!TDigest_Deserialize(merged, &tbr));
+
+  Buffer_Free(&buf);
+  TDigest_Free(merged);
+  for (size_t ii = 0; ii < 3; ++ii) {
+    TDigest_Free(parts[ii]);
+  }
+  free(values);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  TESTFUNC(testExact);
+  TESTFUNC(testMerge);
+})
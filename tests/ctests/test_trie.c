@@ -330,10 +330,47 @@ int testDFAFilter() {
   return 0;
 }
 
+int testDFACache() {
+  size_t rlen;
+  rune *runes = strToFoldedRunes("gangsta", &rlen);
+
+  // fuzzy filters of the same string and distance share their DFA, whatever the prefix mode
+  DFAFilter *fc1 = NewDFAFilter(runes, rlen, 2, 0);
+  DFAFilter *fc2 = NewDFAFilter(runes, rlen, 2, 1);
+  DFAFilter *fc3 = NewDFAFilter(runes, rlen, 1, 0);
+  DFAFilter *fc4 = NewDFAFilter(runes, rlen, 0, 0);
+  DFAFilter *fc5 = NewDFAFilter(runes, rlen, 0, 0);
+  ASSERT(fc1->dfa == fc2->dfa);
+  ASSERT(fc1->dfa != fc3->dfa);
+  ASSERT(fc4->dfa != fc5->dfa);
+
+  DFAFilter *filters[] = {fc1, fc2, fc3, fc4, fc5};
+  for (int i = 0; i < 5; i++) {
+    DFAFilter_Free(filters[i]);
+    free(filters[i]);
+  }
+
+  // a cached DFA outlives the filter, and is still used after the cache drops it
+  fc1 = NewDFAFilter(runes, rlen, 2, 0);
+  DFACache_Clear();
+  fc2 = NewDFAFilter(runes, rlen, 2, 0);
+  ASSERT(fc1->dfa != fc2->dfa);
+  ASSERT(fc1->dfa->root->numEdges == fc2->dfa->root->numEdges);
+  DFAFilter_Free(fc1);
+  DFAFilter_Free(fc2);
+  free(fc1);
+  free(fc2);
+
+  DFACache_Clear();
+  free(runes);
+  return 0;
+}
+
 TEST_MAIN({
   RMUTil_InitAlloc();
   TESTFUNC(testRuneUtil);
   TESTFUNC(testDFAFilter);
+  TESTFUNC(testDFACache);
   TESTFUNC(testTrie);
   TESTFUNC(testPayload);
   TESTFUNC(testUnicode);
@@ -262,6 +262,21 @@ def testGet(env):
     res = env.cmd('hgetall doc')
     env.assertEqual(set(res), set(['foo', 'foo', '__score', '0.1', '__language', 'arabic', '__payload', 'redislabs']))
 
+def testMGetOrder(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text').ok()
+    for i in range(200):
+        conn.execute_command('hset', 'doc%d' % i, 'foo', 'hello%d' % i)
+    # the keys of the shards interleaved, with keys which are not indexed among them
+    ids = []
+    for i in range(200):
+        ids += ['doc%d' % i, 'nodoc%d' % i]
+    res = env.cmd('ft.mget', 'idx', *ids)
+    env.assertEqual(len(res), 400)
+    for i in range(200):
+        env.assertEqual(res[2 * i], ['foo', 'hello%d' % i])
+        env.assertIsNone(res[2 * i + 1])
+
 
 def testDelete(env):
     r = env
@@ -1770,6 +1785,27 @@ def testInfoCommandImplied(env):
     env.assertNotEqual(-1, d['index_options'].index('NOOFFSETS'))
     env.assertNotEqual(-1, d['index_options'].index('NOHL'))
 
+def testFieldNoOffsets(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH',
+               'schema', 'title', 'text', 'body', 'text', 'nooffsets').ok()
+    if not env.isCluster():
+        res = env.cmd('ft.info', 'idx')
+        env.assertContains('NOOFFSETS', res[7][1])
+    conn.execute_command('hset', 'doc1', 'title', 'hello world', 'body', 'quick brown fox')
+    conn.execute_command('hset', 'doc2', 'title', 'world hello', 'body', 'fox jumps over the brown dog')
+
+    for _ in env.retry_with_reload():
+        waitForIndex(env, 'idx')
+        # the positions of the title are kept
+        env.expect('ft.search', 'idx', '@title:"hello world"', 'nocontent').equal([1, 'doc1'])
+        env.expect('ft.search', 'idx', '@title:(hello world)', 'slop', '0', 'inorder', 'nocontent').equal([1, 'doc1'])
+        # the terms of the body match regardless of their positions
+        res = env.cmd('ft.search', 'idx', '@body:"brown fox"', 'nocontent')
+        env.assertEqual(sorted(res[1:]), ['doc1', 'doc2'])
+        res = env.cmd('ft.search', 'idx', '@body:(fox brown)', 'slop', '0', 'inorder', 'nocontent')
+        env.assertEqual(sorted(res[1:]), ['doc1', 'doc2'])
+
 def testNoStem(env):
     env.cmd('ft.create', 'idx', 'ON', 'HASH',
             'schema', 'body', 'text', 'name', 'text', 'nostem')
@@ -2140,6 +2176,52 @@ def testReplaceReload(env):
     env.assertEqual('s200', doc['textfield'])
     env.assertEqual('1090', doc['numfield'])
 
+def testPersistIndexes(env):
+    env.skipOnCluster()
+    env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'true').ok()
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'PREFIX', 1, 'doc',
+            'SCHEMA', 't', 'TEXT', 'SORTABLE', 'n', 'NUMERIC', 'SORTABLE', 'tg', 'TAG')
+    conn = getConnectionByEnv(env)
+    for i in range(10):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello world %d' % i, 'n', i, 'tg', 'tag%d' % (i % 3))
+    conn.execute_command('DEL', 'doc2')
+    conn.execute_command('HSET', 'doc3', 't', 'hello again', 'n', 33)
+
+    def snapshot():
+        docs = ['doc%d' % i for i in range(10) if i != 2]
+        return ([env.cmd('FT.DEBUG', 'DOCINFO', 'idx', doc) for doc in docs],
+                env.cmd('FT.SEARCH', 'idx', 'hello', 'WITHSCORES', 'SORTBY', 'n'),
+                env.cmd('FT.SEARCH', 'idx', '@n:[3 40] @tg:{tag0}', 'NOCONTENT'),
+                index_info(env, 'idx')['num_docs'])
+
+    before = snapshot()
+    env.dump_and_reload()
+    # The restored documents keep their ids
+    env.assertEqual(snapshot(), before)
+
+    conn.execute_command('HSET', 'doc10', 't', 'hello there', 'n', 10)
+    env.expect('FT.SEARCH', 'idx', 'there', 'NOCONTENT').equal([1, 'doc10'])
+    env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'false').ok()
+
+def testPersistIndexesNumericValues(env):
+    env.skipOnCluster()
+    env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'true').ok()
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'n', 'NUMERIC', 'tg', 'TAG')
+    conn = getConnectionByEnv(env)
+    # Integral and fractional values, in sections large enough to be compressed
+    values = [-2**53, -1.5, -1, 0, 0.25, 7, 1e300, 2**53, 2**63]
+    for i in range(1000):
+        conn.execute_command('HSET', 'doc%d' % i, 'n', values[i % len(values)], 'tg', 'tag%d' % (i % 7))
+
+    queries = [['@n:[%s %s]' % (v, v)] for v in values] + [['@n:[-inf +inf] @tg:{tag3}']]
+    def snapshot():
+        return [env.cmd('FT.SEARCH', 'idx', *q, 'NOCONTENT', 'LIMIT', 0, 0) for q in queries]
+
+    before = snapshot()
+    env.dump_and_reload()
+    env.assertEqual(snapshot(), before)
+    env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'false').ok()
+
 
 # command = 'FT.CREATE idx SCHEMA '
 # for i in range(255):
@@ -2845,6 +2927,35 @@ def testExplainError(env):
     env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'test', 'TEXT').equal('OK')
     env.expect('FT.EXPLAIN', 'idx', '(').error()
 
+@skip(cluster=True)
+def testExplainWithPlan(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    for i, t in enumerate(['hello', 'hello world', 'hells', 'world']):
+        conn.execute_command('HSET', f'doc{i}', 't', t, 'n', i)
+
+    # the logical plan comes first, as without WITHPLAN
+    q = 'hell* @n:[0 2]'
+    res = env.cmd('FT.EXPLAIN', 'idx', q, 'WITHPLAN')
+    env.assertTrue(res.startswith(env.cmd('FT.EXPLAIN', 'idx', q)), message=res)
+    env.assertContains('\nITERATORS:\nINTERSECT est=', res)
+    env.assertContains(' strategy=', res)
+    env.assertContains('  UNION:hell est=3 expansions=2 strategy=flat {\n', res)
+    env.assertContains('    TEXT:hello est=2\n', res)
+    env.assertContains('    TEXT:hells est=1\n', res)
+    env.assertContains('NUMERIC:0-2 est=', res)
+    env.assertNotContains('OPTIMIZER:', res)
+    # the query is planned as FT.SEARCH executes it
+    env.assertContains('PIPELINE: Index -> Scorer -> Sorter', res)
+
+    # WITHPLAN may come after the arguments of the query
+    res = env.cmd('FT.EXPLAINCLI', 'idx', 'hello', 'DIALECT', 2, 'WITHPLAN')
+    env.assertEqual(res[:3], ['UNION {', '  hello', '  +hello(expanded)'])
+    env.assertContains('ITERATORS:', res)
+    env.assertContains('PIPELINE: Index -> Scorer -> Sorter -> Loader', res)
+
+    env.expect('FT.EXPLAIN', 'idx', '(', 'WITHPLAN').error()
+
 def testBadCursor(env):
     env.expect('FT.CURSOR', 'READ', 'idx').error()
     env.expect('FT.CURSOR', 'READ', 'idx', '1111').error()
@@ -3381,6 +3492,57 @@ def testAliasAddIfNX(env):
 def testAliasDelIfX(env):
     env.expect('FT._ALIASDELIFX a1').ok()
 
+def testReplaceIndex(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx_v1', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT').ok()
+    env.expect('FT.ALIASADD', 'idx', 'idx_v1').ok()
+    env.expect('FT.ALIASADD', 'idx_alt', 'idx_v1').ok()
+    for i in range(10):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello', 'n', i)
+    env.expect('FT.CREATE', 'idx_v2', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    waitForIndex(env, 'idx_v2')
+
+    env.expect('FT.REPLACEINDEX', 'idx_v1').raiseError()
+    env.expect('FT.REPLACEINDEX', 'idx_v1', 'imaginary').error().contains('Unknown index name')
+    env.expect('FT.REPLACEINDEX', 'idx', 'idx_v2').error().contains('Unknown index name')
+    env.expect('FT.REPLACEINDEX', 'idx_v1', 'idx_v1').error().contains('cannot replace itself')
+
+    env.expect('FT.REPLACEINDEX', 'idx_v1', 'idx_v2').ok()
+    # the aliases now point to the new index, and the documents are kept
+    env.expect('FT.SEARCH', 'idx', '@n:[0 4]', 'NOCONTENT', 'LIMIT', 0, 0).equal([5])
+    env.expect('FT.SEARCH', 'idx_alt', 'hello', 'NOCONTENT', 'LIMIT', 0, 0).equal([10])
+    env.expect('FT.SEARCH', 'idx_v1', 'hello').error().contains('no such index')
+    env.assertEqual(conn.execute_command('EXISTS', 'doc0'), 1)
+    env.expect('FT.ALIASDEL', 'idx').ok()
+
+def testExportImport(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    path = '/tmp/redisearch-test-%d.export' % os.getpid()
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'tg', 'TAG').ok()
+    env.expect('FT.ALIASADD', 'idx_alias', 'idx').ok()
+    for i in range(100):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello world', 'n', i, 'tg', 'tag%d' % (i % 3))
+    waitForIndex(env, 'idx')
+
+    env.expect('FT.EXPORT', 'imaginary', path).error().contains('Unknown index name')
+    env.expect('FT.EXPORT', 'idx', path).ok()
+    env.expect('FT.IMPORT', path).error().contains('Index already exists')
+    env.expect('FT.IMPORT', path + '.missing').error().contains('Could not read')
+
+    env.expect('FT.DROPINDEX', 'idx').ok()
+    conn.execute_command('DEL', 'doc0')
+    restored = env.cmd('INFO', 'search_index_persistence')['search_restored_indexes']
+    env.expect('FT.IMPORT', path).ok()
+    env.assertEqual(env.cmd('INFO', 'search_index_persistence')['search_restored_indexes'], restored + 1)
+    # the document of the deleted key is dropped
+    env.expect('FT.SEARCH', 'idx_alias', 'hello', 'NOCONTENT', 'LIMIT', 0, 0).equal([99])
+    env.expect('FT.SEARCH', 'idx', '@n:[10 19] @tg:{tag1}', 'NOCONTENT', 'LIMIT', 0, 0).equal([3])
+    # and the writes that follow are indexed
+    conn.execute_command('HSET', 'doc100', 't', 'hello', 'n', 100)
+    env.expect('FT.SEARCH', 'idx', '@n:[100 100]', 'NOCONTENT').equal([1, 'doc100'])
+    os.remove(path)
+
 def testEmptyDoc(env):
     conn = getConnectionByEnv(env)
     env.expect('FT.CREATE idx SCHEMA t TEXT').ok()
@@ -3653,6 +3815,26 @@ def testUsesCounter(env):
 
     assertInfoField(env, 'idx', 'number_of_uses', 3)
 
+def testCountOnly(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't1', 'TEXT', 't2', 'TEXT', 'tag', 'TAG').ok()
+    for i in range(1000):
+        conn.execute_command('HSET', 'doc%d' % i, 't1', 'hello', 't2', 'world' if i % 2 else 'hello', 'tag', 'a' if i % 3 else 'b')
+    # deleted and updated documents remain in the indexes until they are garbage collected
+    for i in range(0, 1000, 50):
+        conn.execute_command('DEL', 'doc%d' % i)
+    for i in range(1, 1000, 100):
+        conn.execute_command('HSET', 'doc%d' % i, 't1', 'bye')
+
+    def count(query):
+        return len(env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'LIMIT', 0, 1000)) - 1
+
+    for query in ['hello', 'world', '@t1:hello', '@t2:hello', '@tag:{a}', '@tag:{b}', 'hello world', '*']:
+        expected = count(query)
+        env.assertEqual(env.cmd('FT.SEARCH', 'idx', query, 'LIMIT', 0, 0), [expected], message=query)
+        res = env.cmd('FT.AGGREGATE', 'idx', query, 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count')
+        env.assertEqual(res[1:], [['count', str(expected)]], message=query)
+
 def test_aggregate_return_fail(env):
     env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'test', 'TEXT').equal('OK')
     env.expect('ft.add', 'idx', 'doc1', '1.0', 'FIELDS', 'test', 'foo').equal('OK')
@@ -3785,3 +3967,43 @@ def test_internal_commands(env):
         fail_eval_call(r, env, ['SEARCH.CLUSTERINFO'])
         
 
+
+def testSeparatePostings(env):
+    ''' Test that reading the tokens restricted to SEPARATEPOSTINGS fields from their own postings
+        does not change the results '''
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', 0).ok()
+    schema = ['title', 'TEXT', 'brand', 'TEXT', 'body', 'TEXT']
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'title', 'TEXT', 'SEPARATEPOSTINGS',
+               'brand', 'TEXT', 'SEPARATEPOSTINGS', 'body', 'TEXT').ok()
+    env.expect('FT.CREATE', 'ref', 'SCHEMA', *schema).ok()
+    res = to_dict(env.cmd('FT.INFO', 'idx'))
+    env.assertContains('SEPARATEPOSTINGS', str(res['attributes'][0]))
+    env.assertNotContains('SEPARATEPOSTINGS', str(res['attributes'][2]))
+
+    words = ['red', 'green', 'blue', 'shoe', 'shirt', 'acme', 'zeta']
+    for i in range(300):
+        conn.execute_command('HSET', 'doc%d' % i,
+                             'title', '%s %s' % (words[i % 7], words[i % 5]),
+                             'brand', words[i % 3 + 4],
+                             'body', '%s %s %s' % (words[i % 4], words[i % 6], words[i % 2]))
+
+    def compare():
+        for query in ['@title:red', '@brand:acme', '@title|brand:shoe', '@title:(red shoe)',
+                      '@title:"red shoe"', '@body:blue', 'green', '@title|body:zeta',
+                      '@title:red @brand:(shirt|zeta)', '@title:nosuchterm']:
+            params = ['NOCONTENT', 'SORTBY', 'title', 'LIMIT', 0, 1000]
+            res = env.cmd('FT.SEARCH', 'idx', query, *params)
+            env.assertEqual(res, env.cmd('FT.SEARCH', 'ref', query, *params), message=query)
+
+    compare()
+    res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', '@title|brand:shoe', 'NOCONTENT')
+    env.assertContains('UNION', str(res))
+
+    # the own postings of the fields are collected along with the others
+    for i in range(0, 300, 2):
+        conn.execute_command('DEL', 'doc%d' % i)
+    forceInvokeGC(env, 'idx')
+    forceInvokeGC(env, 'ref')
+    compare()
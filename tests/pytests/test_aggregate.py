@@ -1,6 +1,7 @@
 from common import *
 
 import bz2
+import random
 import json
 import unittest
 
@@ -1171,3 +1172,155 @@ def testWithKNN(env):
                                'REDUCE', 'COUNT', '0', 'AS', 'c', 'SORTBY', '1', '@n',
                                'PARAMS', '2', 'blob', create_np_array_typed([0] * dim).tobytes(), 'DIALECT', '2')
     env.assertEqual(res[1:], expected_res)
+
+def testTagDocValues(env):
+    # grouping and sorting by a tag field which is not sortable reads its values from the doc values
+    # of the field, so they should match the values loaded from the documents
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'u', 'TAG', 'n', 'NUMERIC')
+    values = ['Red', 'red', 'green, blue', 'green']
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', values[i % len(values)], 'u', str(i % 2), 'n', i)
+    conn.execute_command('HSET', 'doc100', 'n', 100)
+
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '*',
+                               'GROUPBY', '1', '@t', 'REDUCE', 'COUNT', '0', 'AS', 'c')
+    env.assertEqual({r[1]: r[3] for r in res[1:]},
+                    {None: '1', **{v: '25' for v in values}})
+
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '@n:[0 99]',
+                               'GROUPBY', '2', '@t', '@u', 'REDUCE', 'SUM', '1', '@n', 'AS', 's')
+    expected = {}
+    for i in range(100):
+        key = (values[i % len(values)], str(i % 2))
+        expected[key] = expected.get(key, 0) + i
+    env.assertEqual(sorted((r[1], r[3], r[5]) for r in res[1:]),
+                    sorted((t, u, str(s)) for (t, u), s in expected.items()))
+
+    # reducers on the same field still load it
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '@n:[0 99]',
+                               'GROUPBY', '1', '@u', 'REDUCE', 'COUNT_DISTINCT', '1', '@t', 'AS', 'd')
+    env.assertEqual(sorted(res[1:]), [['u', '0', 'd', '2'], ['u', '1', 'd', '2']])
+
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '@n:[0 7]', 'SORTBY', '4', '@t', 'DESC', '@n', 'ASC',
+                               'LOAD', '1', '@n')
+    env.assertEqual([(to_dict(r)['t'], to_dict(r)['n']) for r in res[1:]],
+                    [('red', '1'), ('red', '5'), ('green, blue', '2'), ('green, blue', '6'),
+                     ('green', '3'), ('green', '7'), ('Red', '0'), ('Red', '4')])
+
+    if not env.isCluster():
+        res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '*', 'GROUPBY', '1', '@t')
+        env.assertEqual([rp[1] for rp in res[1][4][1:]], ['Index', 'Grouper'])
+        res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '*', 'SORTBY', '1', '@t')
+        env.assertEqual([rp[1] for rp in res[1][4][1:]], ['Index', 'Doc Values', 'Sorter'])
+
+@skip(cluster=True)
+def testGroupBySpill(env):
+    # groups using more memory than GROUPBY_MAX_MEMORY are spilled to disk and merged back, which
+    # should not change the results
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'g', 'NUMERIC', 'n', 'NUMERIC', 't', 'TAG')
+    for i in range(10000):
+        conn.execute_command('HSET', f'doc{i}', 'g', i % 3000, 'n', i, 't', f'tag{i % 7}')
+
+    query = ['FT.AGGREGATE', 'idx', '*', 'LOAD', '3', '@g', '@n', '@t', 'GROUPBY', '1', '@g',
+             'REDUCE', 'COUNT', '0', 'AS', 'count',
+             'REDUCE', 'SUM', '1', '@n', 'AS', 'sum',
+             'REDUCE', 'MIN', '1', '@n', 'AS', 'min',
+             'REDUCE', 'AVG', '1', '@n', 'AS', 'avg',
+             'REDUCE', 'STDDEV', '1', '@n', 'AS', 'stddev',
+             'REDUCE', 'QUANTILE', '2', '@n', '0.5', 'AS', 'median',
+             'REDUCE', 'COUNT_DISTINCT', '1', '@t', 'AS', 'distinct',
+             'REDUCE', 'COUNT_DISTINCTISH', '1', '@t', 'AS', 'distinctish',
+             'REDUCE', 'TOLIST', '1', '@t', 'AS', 'tags',
+             'REDUCE', 'FIRST_VALUE', '3', '@n', 'BY', '@n', 'AS', 'first',
+             'SORTBY', '2', '@g', 'ASC', 'MAX', '3000']
+    def groups(res):
+        groups = [to_dict(r) for r in res[1:]]
+        for group in groups:
+            group['tags'] = sorted(group['tags'])
+            group['stddev'] = round(float(group['stddev']), 6)
+        return groups
+
+    expected = conn.execute_command(*query)
+    env.assertEqual(len(expected), 3001)
+
+    env.expect('FT.CONFIG', 'SET', 'GROUPBY_MAX_MEMORY', '65536').ok()
+    res = conn.execute_command(*query)
+    env.assertEqual(res[0], expected[0])
+    env.assertEqual(groups(res), groups(expected))
+
+    res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', *query[2:])
+    grouper = to_dict([rp for rp in res[1][4][1:] if rp[1] == 'Grouper'][0])
+    env.assertGreater(int(grouper['Spilled bytes']), 0)
+
+    # a few groups fit in memory and are never spilled
+    res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '*', 'GROUPBY', '1', '@t')
+    grouper = to_dict([rp for rp in res[1][4][1:] if rp[1] == 'Grouper'][0])
+    env.assertFalse('Spilled bytes' in grouper)
+    env.expect('FT.CONFIG', 'SET', 'GROUPBY_MAX_MEMORY', '0').ok()
+
+@skip(cluster=True)
+def testGroupByTopN(env):
+    # with GROUPBY_TOPN_FACTOR, a GROUPBY sorted by a COUNT in descending order only keeps a few
+    # times the groups returned, evicting those with the least results
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'brand', 'TAG', 'n', 'NUMERIC')
+    # 5 brands with many docs among 500 brands with a few docs each
+    brands = [f'top{i}' for i in range(5) for _ in range(50 + i)] + \
+             [f'brand{i}' for i in range(500) for _ in range(1 + i % 3)]
+    random.Random(7).shuffle(brands)
+    for i, brand in enumerate(brands):
+        conn.execute_command('HSET', f'doc{i}', 'brand', brand, 'n', i)
+
+    query = ['FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@brand',
+             'GROUPBY', '1', '@brand', 'REDUCE', 'COUNT', '0', 'AS', 'c',
+             'SORTBY', '2', '@c', 'DESC', 'MAX', '5']
+    expected = [['brand', f'top{i}', 'c', str(50 + i)] for i in reversed(range(5))]
+    env.assertEqual(conn.execute_command(*query)[1:], expected)
+
+    env.expect('FT.CONFIG', 'SET', 'GROUPBY_TOPN_FACTOR', '10').ok()
+    res = conn.execute_command(*query)
+    env.assertEqual(len(res), 6)
+    env.assertEqual(sorted(r[1] for r in res[1:]), [f'top{i}' for i in range(5)])
+    # a group evicted and created again only counts the results that follow
+    for r in res[1:]:
+        env.assertLessEqual(int(r[3]), 50 + int(r[1][3:]))
+
+    # other orders keep all the groups
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@brand',
+                               'GROUPBY', '1', '@brand', 'REDUCE', 'COUNT', '0', 'AS', 'c',
+                               'SORTBY', '2', '@c', 'ASC', 'MAX', '1000')
+    env.assertEqual(len(res), 506)
+    env.expect('FT.CONFIG', 'SET', 'GROUPBY_TOPN_FACTOR', '0').ok()
+
+def testTDigest(env):
+    # a digest of a group is a string, which TDIGEST_QUANTILE reads back
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE')
+    for i in range(101):
+        conn.execute_command('HSET', f'doc{i}', 'n', (i * 37) % 101)
+
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0',
+                               'REDUCE', 'TDIGEST', '1', '@n', 'AS', 'digest',
+                               'GROUPBY', '0',
+                               'REDUCE', 'TDIGEST_QUANTILE', '2', '@digest', '0.5', 'AS', 'q50',
+                               'REDUCE', 'TDIGEST_QUANTILE', '2', '@digest', '0.95', 'AS', 'q95')
+    env.assertEqual(res, [1, ['q50', '50', 'q95', '95']])
+
+    env.expect('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0',
+               'REDUCE', 'TDIGEST_QUANTILE', '2', '@n', '1.5', 'AS', 'q').error()
+
+def testLoadManyHashFields(env):
+    # several fields of small hashes are read in one scan, as if read one by one
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 't', 'TEXT')
+    conn.execute_command('HSET', 'small', 'n', '1', 't', 'foo', 'a', 'x', 'b', 'y')
+    big = {f'f{i}': i for i in range(100)}
+    conn.execute_command('HSET', 'big', 'n', '2', 't', 'bar', 'a', 'z', *[x for kv in big.items() for x in kv])
+
+    res = conn.execute_command('FT.AGGREGATE', 'idx', '*',
+                               'LOAD', '11', '@n', '@t', '@a', 'AS', 'a1', '@a', 'AS', 'a2', '@b', '@missing', '@__key',
+                               'SORTBY', '2', '@n', 'ASC')
+    env.assertEqual(res[1:], [['n', '1', 't', 'foo', 'a1', 'x', 'a2', 'x', 'b', 'y', '__key', 'small'],
+                              ['n', '2', 't', 'bar', 'a1', 'z', 'a2', 'z', '__key', 'big']])
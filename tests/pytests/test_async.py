@@ -5,7 +5,7 @@ import numpy as np
 from RLTest import Env
 
 from includes import *
-from common import getConnectionByEnv, waitForIndex, create_np_array_typed
+from common import getConnectionByEnv, waitForIndex, create_np_array_typed, index_info, to_dict
 
 def testCreateIndex(env):
     conn = getConnectionByEnv(env)
@@ -107,3 +107,119 @@ def test_eval_node_errors_async():
     env.expect('FT.SEARCH', 'idx', '*=>[KNN 2 @v $b]=>{$yield_distance_as:v}', 'timeout', 0, 'PARAMS', '2', 'b',
                create_np_array_typed([0]*dim).tobytes()).error()\
         .contains(f'{async_err_prefix}Property `v` already exists in schema')
+
+
+def testAsyncUpdates():
+    # the writes to an index created with ASYNCUPDATES are queued, and only indexed once the queue
+    # is drained
+    env = Env(moduleArgs='ASYNC_UPDATES_MAX_LAG 1000000')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ASYNCUPDATES', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    env.expect('FT.CREATE', 'sync', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT').ok()
+    waitForIndex(env, 'idx')
+    env.assertContains('ASYNCUPDATES', index_info(env, 'idx')['index_options'])
+    env.assertFalse('async_updates_stats' in index_info(env, 'sync'))
+
+    def stats():
+        return to_dict(index_info(env, 'idx')['async_updates_stats'])
+
+    for i in range(10):
+        conn.execute_command('HSET', 'doc1', 't', 'hello', 'n', i)
+    conn.execute_command('HSET', 'doc2', 't', 'hello world', 'n', 100)
+    env.assertEqual(env.cmd('FT.SEARCH', 'sync', 'hello', 'NOCONTENT')[0], 2)
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT'), [0])
+    # the repeated writes of a key are coalesced
+    env.assertEqual(stats()['queue_depth'], 2)
+    env.assertGreaterEqual(stats()['lag_ms'], 0)
+
+    env.expect('FT.SYNC', 'idx').ok()
+    env.expect('FT.SYNC', 'sync').ok()
+    env.assertEqual(stats(), {'queue_depth': 0, 'lag_ms': 0, 'drained': 2})
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'SORTBY', 'n').equal([2, 'doc1', 'doc2'])
+    # the keys were indexed with their latest contents
+    env.expect('FT.SEARCH', 'idx', '@n:[9 9]', 'NOCONTENT').equal([1, 'doc1'])
+
+    # deleted and renamed keys are queued as well
+    conn.delete('doc1')
+    conn.execute_command('RENAME', 'doc2', 'doc3')
+    env.assertEqual(stats()['queue_depth'], 3)
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')[0], 2)
+    env.expect('FT.SYNC', 'idx').ok()
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc3'])
+    conn.execute_command('RENAME', 'doc3', 'other')
+    env.expect('FT.SYNC', 'idx').ok()
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([0])
+    env.assertEqual(stats()['drained'], 6)
+
+    # with no lag allowed, the writes index the queue themselves
+    env.expect('FT.CONFIG', 'SET', 'ASYNC_UPDATES_MAX_LAG', 0).ok()
+    conn.execute_command('HSET', 'doc4', 't', 'hello')
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc4'])
+    env.assertEqual(stats()['queue_depth'], 0)
+
+    # otherwise the queue is drained in the background
+    env.expect('FT.CONFIG', 'SET', 'ASYNC_UPDATES_MAX_LAG', 50).ok()
+    conn.execute_command('HSET', 'doc5', 't', 'hello')
+    start = time.time()
+    while env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')[0] != 2:
+        env.assertLess(time.time() - start, 10)
+        time.sleep(0.01)
+    env.assertEqual(stats()['queue_depth'], 0)
+
+    env.expect('FT.SYNC', 'nonexistent').error().contains('Unknown index name')
+    env.expect('FT.SYNC', 'idx', 'extra').error().contains('wrong number of arguments')
+def testAsyncUpdatesUnindexed():
+    # the queued writes which only change unindexed fields keep the ids of their documents
+    env = Env(moduleArgs='ASYNC_UPDATES_MAX_LAG 1000000')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ASYNCUPDATES', 'SCHEMA', 't', 'TEXT',
+               'stock', 'NUMERIC', 'SORTABLE', 'NOINDEX').ok()
+    conn.execute_command('HSET', 'doc1', 't', 'hello', 'stock', 5)
+    conn.execute_command('HSET', 'doc2', 't', 'world', 'stock', 7)
+    env.expect('FT.SYNC', 'idx').ok()
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 2)
+
+    conn.execute_command('HSET', 'doc1', 'stock', 4)
+    conn.execute_command('HSET', 'doc2', 't', 'world', 'stock', 3)
+    env.expect('FT.SYNC', 'idx').ok()
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 2)
+    env.expect('FT.SEARCH', 'idx', '*', 'SORTBY', 'stock', 'RETURN', 1, 'stock').equal(
+        [2, 'doc2', ['stock', '3'], 'doc1', ['stock', '4']])
+
+    # an indexed value is still reindexed under a new id
+    conn.execute_command('HSET', 'doc1', 't', 'hi')
+    env.expect('FT.SYNC', 'idx').ok()
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 3)
+    env.expect('FT.SEARCH', 'idx', 'hi', 'RETURN', 1, 'stock').equal([1, 'doc1', ['stock', '4']])
+
+def testBatchWrites():
+    # with BATCH_WRITES, the writes of an event-loop iteration are coalesced and indexed in a batch
+    env = Env(moduleArgs='BATCH_WRITES true')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    waitForIndex(env, 'idx')
+
+    # the repeated writes of a key in a transaction are indexed once
+    pipe = conn.pipeline(transaction=True)
+    for i in range(10):
+        pipe.execute_command('HSET', 'doc1', 't', 'hello', 'n', i)
+    pipe.execute()
+    env.expect('FT.DEBUG', 'DOCIDTOID', 'idx', 'doc1').equal(1)
+    env.expect('FT.SEARCH', 'idx', '@n:[9 9]', 'NOCONTENT').equal([1, 'doc1'])
+
+    # a command using the index sees the writes which preceded it
+    pipe = conn.pipeline(transaction=True)
+    pipe.execute_command('HSET', 'doc2', 't', 'hello')
+    pipe.execute_command('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    pipe.execute_command('DEL', 'doc1')
+    pipe.execute_command('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    res = pipe.execute()
+    env.assertEqual(res[1][0], 2)
+    env.assertEqual(res[3], [1, 'doc2'])
+
+    # scripts writing many keys index them a batch at a time
+    env.cmd('EVAL', "for i=1,2500 do redis.call('HSET', 'doc:' .. i, 't', 'world') end", 0)
+    env.expect('FT.SEARCH', 'idx', 'world', 'LIMIT', 0, 0).equal([2500])
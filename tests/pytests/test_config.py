@@ -33,6 +33,9 @@ def testGetConfigOptions(env):
         assert env.expect('ft.config', 'get', 'MT_MODE').res[0][0] == 'MT_MODE'
         assert env.expect('ft.config', 'get', 'TIERED_HNSW_BUFFER_LIMIT').res[0][0] == 'TIERED_HNSW_BUFFER_LIMIT'
         assert env.expect('ft.config', 'get', 'PRIVILEGED_THREADS_NUM').res[0][0] == 'PRIVILEGED_THREADS_NUM'
+        assert env.expect('ft.config', 'get', 'WORKERS_QUERY_WEIGHT').res[0][0] == 'WORKERS_QUERY_WEIGHT'
+        assert env.expect('ft.config', 'get', 'MAX_PENDING_QUERIES').res[0][0] == 'MAX_PENDING_QUERIES'
+        assert env.expect('ft.config', 'get', 'WORKERS_CPU_LIST').res[0][0] == 'WORKERS_CPU_LIST'
     assert env.expect('ft.config', 'get', 'FRISOINI').res[0][0] == 'FRISOINI'
     assert env.expect('ft.config', 'get', 'MAXSEARCHRESULTS').res[0][0] == 'MAXSEARCHRESULTS'
     assert env.expect('ft.config', 'get', 'MAXAGGREGATERESULTS').res[0][0] == 'MAXAGGREGATERESULTS'
@@ -49,10 +52,32 @@ def testGetConfigOptions(env):
     assert env.expect('ft.config', 'get', '_NUMERIC_COMPRESS').res[0][0] == '_NUMERIC_COMPRESS'
     assert env.expect('ft.config', 'get', '_NUMERIC_RANGES_PARENTS').res[0][0] == '_NUMERIC_RANGES_PARENTS'
     assert env.expect('ft.config', 'get', 'RAW_DOCID_ENCODING').res[0][0] == 'RAW_DOCID_ENCODING'
+    assert env.expect('ft.config', 'get', 'STREAM_VBYTE_ENCODING').res[0][0] == 'STREAM_VBYTE_ENCODING'
+    assert env.expect('ft.config', 'get', 'PACKED_OFFSETS_ENCODING').res[0][0] == 'PACKED_OFFSETS_ENCODING'
+    assert env.expect('ft.config', 'get', 'NUMERIC_SORTED_COLUMN').res[0][0] == 'NUMERIC_SORTED_COLUMN'
+    assert env.expect('ft.config', 'get', 'PROFILE_HW_COUNTERS').res[0][0] == 'PROFILE_HW_COUNTERS'
     assert env.expect('ft.config', 'get', 'FORK_GC_CLEAN_NUMERIC_EMPTY_NODES').res[0][0] == 'FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'
     assert env.expect('ft.config', 'get', '_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES').res[0][0] == '_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'
+    assert env.expect('ft.config', 'get', 'FORK_GC_SHARED_MEMORY').res[0][0] == 'FORK_GC_SHARED_MEMORY'
+    assert env.expect('ft.config', 'get', 'GC_COMPACT_DOCIDS_RATIO').res[0][0] == 'GC_COMPACT_DOCIDS_RATIO'
+    assert env.expect('ft.config', 'get', 'GC_COLD_BLOCKS_PERIOD').res[0][0] == 'GC_COLD_BLOCKS_PERIOD'
+    assert env.expect('ft.config', 'get', 'COLD_BLOCKS_CACHE_SIZE').res[0][0] == 'COLD_BLOCKS_CACHE_SIZE'
     assert env.expect('ft.config', 'get', '_FREE_RESOURCE_ON_THREAD').res[0][0] == '_FREE_RESOURCE_ON_THREAD'
     assert env.expect('ft.config', 'get', 'BG_INDEX_SLEEP_GAP').res[0][0] == 'BG_INDEX_SLEEP_GAP'
+    assert env.expect('ft.config', 'get', 'RESULT_CACHE_MAX_MEMORY').res[0][0] == 'RESULT_CACHE_MAX_MEMORY'
+    assert env.expect('ft.config', 'get', 'RESULT_CACHE_TTL').res[0][0] == 'RESULT_CACHE_TTL'
+    assert env.expect('ft.config', 'get', 'GROUPBY_MAX_MEMORY').res[0][0] == 'GROUPBY_MAX_MEMORY'
+    assert env.expect('ft.config', 'get', 'GROUPBY_TOPN_FACTOR').res[0][0] == 'GROUPBY_TOPN_FACTOR'
+    assert env.expect('ft.config', 'get', 'BG_INDEX_CONCURRENT').res[0][0] == 'BG_INDEX_CONCURRENT'
+    assert env.expect('ft.config', 'get', 'STEM_CACHE_SIZE').res[0][0] == 'STEM_CACHE_SIZE'
+    assert env.expect('ft.config', 'get', 'BG_INDEX_SLICE_USEC').res[0][0] == 'BG_INDEX_SLICE_USEC'
+    assert env.expect('ft.config', 'get', 'ASYNC_UPDATES_MAX_LAG').res[0][0] == 'ASYNC_UPDATES_MAX_LAG'
+    assert env.expect('ft.config', 'get', 'BATCH_WRITES').res[0][0] == 'BATCH_WRITES'
+    assert env.expect('ft.config', 'get', 'PERSIST_INDEXES').res[0][0] == 'PERSIST_INDEXES'
+    assert env.expect('ft.config', 'get', 'INDEX_SEGMENTS_DIR').res[0][0] == 'INDEX_SEGMENTS_DIR'
+    assert env.expect('ft.config', 'get', 'SLOWLOG_THRESHOLD').res[0][0] == 'SLOWLOG_THRESHOLD'
+    assert env.expect('ft.config', 'get', 'SLOWLOG_MAX_LEN').res[0][0] == 'SLOWLOG_MAX_LEN'
+    assert env.expect('ft.config', 'get', 'SLOWLOG_PLAN_SAMPLE').res[0][0] == 'SLOWLOG_PLAN_SAMPLE'
 
 '''
 
@@ -116,6 +141,9 @@ def testAllConfig(env):
         env.assertEqual(res_dict['MT_MODE'][0], 'MT_MODE_OFF')
         env.assertEqual(res_dict['TIERED_HNSW_BUFFER_LIMIT'][0], '1024')
         env.assertEqual(res_dict['PRIVILEGED_THREADS_NUM'][0], '1')
+        env.assertEqual(res_dict['WORKERS_QUERY_WEIGHT'][0], '1')
+        env.assertEqual(res_dict['MAX_PENDING_QUERIES'][0], '0')
+        env.assertEqual(res_dict['WORKERS_CPU_LIST'][0], '')
     env.assertEqual(res_dict['FRISOINI'][0], None)
     env.assertEqual(res_dict['ON_TIMEOUT'][0], 'return')
     env.assertEqual(res_dict['GCSCANSIZE'][0], '100')
@@ -130,8 +158,26 @@ def testAllConfig(env):
     env.assertEqual(res_dict['_NUMERIC_RANGES_PARENTS'][0], '0')
     env.assertEqual(res_dict['FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'][0], 'true')
     env.assertEqual(res_dict['_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'][0], 'true')
+    env.assertEqual(res_dict['FORK_GC_SHARED_MEMORY'][0], 'false')
+    env.assertEqual(res_dict['GC_COMPACT_DOCIDS_RATIO'][0], '0')
+    env.assertEqual(res_dict['GC_COLD_BLOCKS_PERIOD'][0], '0')
+    env.assertEqual(res_dict['COLD_BLOCKS_CACHE_SIZE'][0], '67108864')
     env.assertEqual(res_dict['_FREE_RESOURCE_ON_THREAD'][0], 'true')
     env.assertEqual(res_dict['BG_INDEX_SLEEP_GAP'][0], '100')
+    env.assertEqual(res_dict['RESULT_CACHE_MAX_MEMORY'][0], '16777216')
+    env.assertEqual(res_dict['RESULT_CACHE_TTL'][0], '10000')
+    env.assertEqual(res_dict['GROUPBY_MAX_MEMORY'][0], '0')
+    env.assertEqual(res_dict['GROUPBY_TOPN_FACTOR'][0], '0')
+    env.assertEqual(res_dict['BG_INDEX_CONCURRENT'][0], 'false')
+    env.assertEqual(res_dict['STEM_CACHE_SIZE'][0], '4096')
+    env.assertEqual(res_dict['BG_INDEX_SLICE_USEC'][0], '0')
+    env.assertEqual(res_dict['ASYNC_UPDATES_MAX_LAG'][0], '100')
+    env.assertEqual(res_dict['BATCH_WRITES'][0], 'false')
+    env.assertEqual(res_dict['PERSIST_INDEXES'][0], 'false')
+    env.assertEqual(res_dict['INDEX_SEGMENTS_DIR'][0], None)
+    env.assertEqual(res_dict['SLOWLOG_THRESHOLD'][0], '100')
+    env.assertEqual(res_dict['SLOWLOG_MAX_LEN'][0], '128')
+    env.assertEqual(res_dict['SLOWLOG_PLAN_SAMPLE'][0], '100')
 
 # skip ctest configured tests
     #env.assertEqual(res_dict['GC_POLICY'][0], 'fork')
@@ -162,6 +208,8 @@ def testInitConfig(env):
         test_arg_num('WORKER_THREADS', 3)
         test_arg_num('TIERED_HNSW_BUFFER_LIMIT', 50000)
         test_arg_num('PRIVILEGED_THREADS_NUM', 4)
+        test_arg_num('WORKERS_QUERY_WEIGHT', 3)
+        test_arg_num('MAX_PENDING_QUERIES', 100)
     test_arg_num('GCSCANSIZE', 3)
     test_arg_num('MIN_PHONETIC_TERM_LEN', 3)
     test_arg_num('FORK_GC_RUN_INTERVAL', 3)
@@ -171,6 +219,16 @@ def testInitConfig(env):
     test_arg_num('UNION_ITERATOR_HEAP', 20)
     test_arg_num('_NUMERIC_RANGES_PARENTS', 1)
     test_arg_num('BG_INDEX_SLEEP_GAP', 15)
+    test_arg_num('RESULT_CACHE_MAX_MEMORY', 1024)
+    test_arg_num('RESULT_CACHE_TTL', 100)
+    test_arg_num('GROUPBY_MAX_MEMORY', 1024)
+    test_arg_num('GROUPBY_TOPN_FACTOR', 4)
+    test_arg_num('STEM_CACHE_SIZE', 100)
+    test_arg_num('BG_INDEX_SLICE_USEC', 2000)
+    test_arg_num('ASYNC_UPDATES_MAX_LAG', 500)
+    test_arg_num('GC_COMPACT_DOCIDS_RATIO', 4)
+    test_arg_num('GC_COLD_BLOCKS_PERIOD', 60)
+    test_arg_num('COLD_BLOCKS_CACHE_SIZE', 1048576)
 
 # True/False arguments
     def test_arg_true_false(arg_name, res):
@@ -198,6 +256,7 @@ def testInitConfig(env):
 
     test_arg_str('GC_POLICY', 'fork')
     test_arg_str('GC_POLICY', 'default', 'fork')
+    test_arg_str('GC_POLICY', 'incremental')
     test_arg_str('ON_TIMEOUT', 'fail')
     test_arg_str('TIMEOUT', '0', '0')
     test_arg_str('PARTIAL_INDEXED_DOCS', '0', 'false')
@@ -208,10 +267,24 @@ def testInitConfig(env):
     test_arg_str('MAXAGGREGATERESULTS', '-1', 'unlimited')
     test_arg_str('RAW_DOCID_ENCODING', 'false', 'false')
     test_arg_str('RAW_DOCID_ENCODING', 'true', 'true')
+    test_arg_str('STREAM_VBYTE_ENCODING', 'false', 'false')
+    test_arg_str('STREAM_VBYTE_ENCODING', 'true', 'true')
+    test_arg_str('PACKED_OFFSETS_ENCODING', 'false', 'false')
+    test_arg_str('PACKED_OFFSETS_ENCODING', 'true', 'true')
+    test_arg_str('NUMERIC_SORTED_COLUMN', 'false', 'false')
+    test_arg_str('NUMERIC_SORTED_COLUMN', 'true', 'true')
     test_arg_str('_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES', 'false', 'false')
     test_arg_str('_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES', 'true', 'true')
+    test_arg_str('FORK_GC_SHARED_MEMORY', 'false', 'false')
+    test_arg_str('FORK_GC_SHARED_MEMORY', 'true', 'true')
     test_arg_str('_FREE_RESOURCE_ON_THREAD', 'false', 'false')
     test_arg_str('_FREE_RESOURCE_ON_THREAD', 'true', 'true')
+    test_arg_str('BG_INDEX_CONCURRENT', 'true', 'true')
+    test_arg_str('BG_INDEX_CONCURRENT', 'false', 'false')
+    test_arg_str('BATCH_WRITES', 'true', 'true')
+    test_arg_str('BATCH_WRITES', 'false', 'false')
+    test_arg_str('PERSIST_INDEXES', 'true', 'true')
+    test_arg_str('PERSIST_INDEXES', 'false', 'false')
 
 def testImmutable(env):
     env.skipOnCluster()
@@ -228,10 +301,15 @@ def testImmutable(env):
         env.expect('ft.config', 'set', 'WORKER_THREADS').error().contains('Not modifiable at runtime')
         env.expect('ft.config', 'set', 'TIERED_HNSW_BUFFER_LIMIT').error().contains('Not modifiable at runtime')
         env.expect('ft.config', 'set', 'PRIVILEGED_THREADS_NUM').error().contains('Not modifiable at runtime')
+        env.expect('ft.config', 'set', 'WORKERS_CPU_LIST', '0').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'FRISOINI').error().contains('Not modifiable at runtime')
+    env.expect('ft.config', 'set', 'INDEX_SEGMENTS_DIR').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'GC_POLICY').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'NO_MEM_POOLS').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'PARTIAL_INDEXED_DOCS').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'UPGRADE_INDEX').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'RAW_DOCID_ENCODING').error().contains('Not modifiable at runtime')
+    env.expect('ft.config', 'set', 'STREAM_VBYTE_ENCODING').error().contains('Not modifiable at runtime')
+    env.expect('ft.config', 'set', 'PACKED_OFFSETS_ENCODING').error().contains('Not modifiable at runtime')
+    env.expect('ft.config', 'set', 'NUMERIC_SORTED_COLUMN').error().contains('Not modifiable at runtime')
     env.expect('ft.config', 'set', 'BG_INDEX_SLEEP_GAP').error().contains('Not modifiable at runtime')
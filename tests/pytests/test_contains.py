@@ -76,9 +76,10 @@ def testSanity(env):
     env.expect('ft.config', 'set', 'MAXEXPANSIONS', 10000000).equal('OK')
     item_qty = 10000
 
-    index_list = ['idx_bf', 'idx_suffix']
+    index_list = ['idx_bf', 'idx_suffix', 'idx_ngrams']
     env.cmd('ft.create', 'idx_bf', 'SCHEMA', 't', 'TEXT')
     env.cmd('ft.create', 'idx_suffix', 'SCHEMA', 't', 'TEXT', 'WITHSUFFIXTRIE')
+    env.cmd('ft.create', 'idx_ngrams', 'SCHEMA', 't', 'TEXT', 'WITHNGRAMS')
 
     conn = getConnectionByEnv(env)
 
@@ -91,7 +92,7 @@ def testSanity(env):
         pl.execute_command('HSET', 'doc%d' % (i + item_qty * 3), 't', 'foofo%d' % i)
         pl.execute()
 
-    for i in range(2):
+    for i in range(len(index_list)):
         #prefix
         env.expect('ft.search', index_list[i], 'f*', 'LIMIT', 0, 0).equal([40000])
         env.expect('ft.search', index_list[i], 'foo*', 'LIMIT', 0, 0).equal([40000])
@@ -388,3 +389,36 @@ def test_issue_3124(env):
   res_not_exist1 = env.cmd('ft.search', 'idx_txt', '@t:ell*')
   res_not_exist2 = env.cmd('ft.search', 'idx_txt_suffix', '@t:ell*')
   env.assertEqual(res_not_exist1, res_not_exist2)
+
+def testContainsNgrams(env):
+  env.skipOnCluster()
+  env.expect('ft.config set FORK_GC_CLEAN_THRESHOLD 0').ok()
+
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't1', 'TEXT', 'WITHNGRAMS', 't2', 'TEXT').ok()
+  res_info = [['identifier', 't1', 'attribute', 't1', 'type', 'TEXT', 'WEIGHT', '1', 'WITHNGRAMS'],
+              ['identifier', 't2', 'attribute', 't2', 'type', 'TEXT', 'WEIGHT', '1']]
+  assertInfoField(env, 'idx', 'attributes', res_info)
+
+  conn.execute_command('HSET', 'doc1', 't1', 'hello world', 't2', 'yellow')
+  conn.execute_command('HSET', 'doc2', 't1', 'jello sku4711', 't2', 'mellow')
+
+  # the trigrams of the patterns filter the terms, shorter patterns scan the trie
+  env.expect('ft.search', 'idx', '@t1:*ell*', 'LIMIT', 0, 0).equal([2])
+  env.expect('ft.search', 'idx', '@t1:*ello', 'LIMIT', 0, 0).equal([2])
+  env.expect('ft.search', 'idx', '@t1:*el*', 'LIMIT', 0, 0).equal([2])
+  env.expect('ft.search', 'idx', '@t1:*orl*', 'NOCONTENT').equal([1, 'doc1'])
+  env.expect('ft.search', 'idx', '@t1:*rl', 'NOCONTENT').equal([1, 'doc1'])
+  env.expect('ft.search', 'idx', '@t1:*ellx*', 'NOCONTENT').equal([0])
+  env.expect('ft.search', 'idx', "@t1:w'*u47?1'", 'NOCONTENT', 'DIALECT', 2).equal([1, 'doc2'])
+  env.expect('ft.search', 'idx', "@t1:w'h?l*'", 'NOCONTENT', 'DIALECT', 2).equal([1, 'doc1'])
+
+  # fields without n-grams are still found through the trie
+  env.expect('ft.search', 'idx', '@t2:*llow', 'LIMIT', 0, 0).equal([2])
+  env.expect('ft.search', 'idx', '*ellow*', 'LIMIT', 0, 0).equal([2])
+
+  # the terms cleaned by the GC leave the index
+  conn.execute_command('HSET', 'doc1', 't1', 'bold', 't2', 'yellow')
+  forceInvokeGC(env, 'idx')
+  env.expect('ft.search', 'idx', '@t1:*orl*', 'NOCONTENT').equal([0])
+  env.expect('ft.search', 'idx', '@t1:*old', 'NOCONTENT').equal([1, 'doc1'])
@@ -79,3 +79,392 @@ def test_MOD_3540(env):
         conn.execute_command('HSET', i, 't', i)
 
     env.expect('FT.SEARCH', 'idx', '*', 'SORTBY', 't', 'DESC', 'MAX', '20')
+
+def test_search_shard_limit(env):
+    # The shards are asked for part of the results first, and for the rest of them from the shards
+    # which may hold more - the results should be the same as when they are asked for all of them
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(1000):
+        # skew the top results towards some of the shards, with ties on the sort key
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i // 3 if i % 7 else 1000)
+
+    queries = [
+        ['FT.SEARCH', 'idx', 'hello', 'LIMIT', 100, 50, 'NOCONTENT'],
+        ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'DESC', 'LIMIT', 0, 200, 'NOCONTENT'],
+        ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'ASC', 'LIMIT', 37, 13],
+        ['FT.SEARCH', 'idx', '@n:[0 10]', 'SORTBY', 'n', 'NOCONTENT'],
+    ]
+    expected = [env.cmd(*q) for q in queries]
+
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'SEARCH_SHARD_LIMIT_FACTOR', 1)
+    for q, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*q), res, message=str(q))
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'SEARCH_SHARD_LIMIT_FACTOR', 0)
+
+def test_knn_shard_limit(env):
+    # The shards are asked for part of the top K results by their distance first, and for the rest
+    # of them from the shards which may hold more - the results should be the same as when they are
+    # asked for all of them
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32', 'DIM', 2,
+               'DISTANCE_METRIC', 'L2', 't', 'TEXT').ok()
+    for i in range(1000):
+        # skew the nearest vectors towards some of the shards
+        conn.execute_command('HSET', f'doc{i}', 'v', create_np_array_typed([i % 13, i // 13]).tobytes(),
+                             't', 'hello' if i % 3 else 'hello world')
+
+    blob = create_np_array_typed([0, 0]).tobytes()
+    queries = [
+        ['FT.SEARCH', 'idx', '*=>[KNN 100 @v $b AS dist]', 'SORTBY', 'dist', 'LIMIT', 0, 100,
+         'RETURN', 1, 'dist', 'PARAMS', 2, 'b', blob],
+        ['FT.SEARCH', 'idx', '*=>[KNN 50 @v $b AS dist]', 'SORTBY', 'dist', 'DESC', 'LIMIT', 10, 20,
+         'RETURN', 1, 'dist', 'PARAMS', 2, 'b', blob],
+        ['FT.SEARCH', 'idx', 'world=>[KNN 30 @v $b AS dist]', 'LIMIT', 0, 30, 'RETURN', 1, 'dist',
+         'PARAMS', 2, 'b', blob],
+    ]
+    expected = [env.cmd(*q) for q in queries]
+
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'KNN_SHARD_LIMIT_FACTOR', 1)
+    for q, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*q), res, message=str(q))
+
+    # The approximate mode merges the first replies of the shards only
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'KNN_SHARD_LIMIT_APPROXIMATE', 'true')
+    for q, res in zip(queries, expected):
+        approx = env.cmd(*q)
+        env.assertLessEqual(approx[0], res[0], message=str(q))
+    env.expect('FT.CONFIG', 'SET', 'KNN_SHARD_LIMIT_APPROXIMATE', 'maybe').error()
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'KNN_SHARD_LIMIT_APPROXIMATE', 'false')
+        con.execute_command('FT.CONFIG', 'SET', 'KNN_SHARD_LIMIT_FACTOR', 0)
+
+def test_hedge_budget(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'HEDGE_BUDGET', 101).error()
+    env.expect('FT.CONFIG', 'SET', 'HEDGE_BUDGET', -1).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello')
+
+    expected = env.cmd('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0)
+    env.expect('FT.CONFIG', 'SET', 'HEDGE_BUDGET', 5).ok()
+    env.expect('FT.CONFIG', 'GET', 'HEDGE_BUDGET').equal([['HEDGE_BUDGET', '5']])
+    for _ in range(10):
+        env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal(expected)
+    env.expect('FT.CONFIG', 'SET', 'HEDGE_BUDGET', 0).ok()
+
+def test_conn_max_inflight(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+
+    expected_search = env.cmd('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 50)
+    expected_agg = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC')
+    # The commands to a shard wait for the reply of the previous one
+    env.expect('FT.CONFIG', 'SET', 'CONN_MAX_INFLIGHT', 1).ok()
+    env.expect('FT.CONFIG', 'GET', 'CONN_MAX_INFLIGHT').equal([['CONN_MAX_INFLIGHT', '1']])
+    for _ in range(10):
+        env.expect('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 50).equal(expected_search)
+        env.expect('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC').equal(expected_agg)
+
+    # Every node reports the load of its connections
+    for sh in env.cmd('SEARCH.CLUSTERINFO')[9:]:
+        for node in sh[2:]:
+            env.assertEqual(node[4:9:2], ['inflight', 'queued', 'latency_ms'])
+
+    env.expect('FT.CONFIG', 'SET', 'MAX_PENDING_REQUESTS', 1000).ok()
+    env.expect('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 50).equal(expected_search)
+    env.expect('FT.CONFIG', 'SET', 'MAX_PENDING_REQUESTS', 0).ok()
+    env.expect('FT.CONFIG', 'SET', 'CONN_MAX_INFLIGHT', 128).ok()
+
+def test_io_threads():
+    env = Env(moduleArgs='IO_THREADS 3')
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'GET', 'IO_THREADS').equal([['IO_THREADS', '3']])
+    env.expect('FT.CONFIG', 'SET', 'IO_THREADS', 2).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+
+    # The requests take turns on the IO threads, each connected to every shard
+    for _ in range(10):
+        res = env.cmd('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 10, 'NOCONTENT')
+        env.assertEqual(res, [100] + [f'doc{i}' for i in range(10)])
+        res = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'c')
+        env.assertEqual(res, [1, ['c', '100']])
+    _, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    while cursor:
+        _, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+
+def test_aggregate_pushdown(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'NUMERIC', 'SORTABLE', 'n', 'NUMERIC', 'SORTABLE',
+               't', 'TAG', 'SORTABLE').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 'g', i % 10, 'n', i, 't', f'tag{i}')
+
+    # The shards send partial deviations and first values, merged exactly
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@g',
+                  'REDUCE', 'STDDEV', 1, '@n', 'AS', 'stddev',
+                  'REDUCE', 'FIRST_VALUE', 4, '@t', 'BY', '@n', 'DESC', 'AS', 'last',
+                  'REDUCE', 'FIRST_VALUE', 3, '@t', 'BY', '@n', 'AS', 'first',
+                  'SORTBY', 2, '@g', 'ASC')
+    rows = [to_dict(r) for r in res[1:]]
+    env.assertEqual([r['g'] for r in rows], [str(g) for g in range(10)])
+    for g, r in enumerate(rows):
+        env.assertAlmostEqual(float(r['stddev']), np.std(range(g, 100, 10), ddof=1), delta=1e-6)
+        env.assertEqual(r['last'], f'tag{90 + g}')
+        env.assertEqual(r['first'], f'tag{g}')
+
+    # Filters on the group keys and a sort by them with its limit run on the shards
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@g',
+                  'REDUCE', 'COUNT', 0, 'AS', 'count',
+                  'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+                  'FILTER', '@g >= 3', 'FILTER', '@count > 5',
+                  'SORTBY', 2, '@g', 'DESC', 'LIMIT', 1, 3)
+    env.assertEqual(res[1:], [['g', str(g), 'count', '10', 'sum', str(sum(range(g, 100, 10)))]
+                              for g in (8, 7, 6)])
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@g',
+                  'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+                  'FILTER', '@g < 5', 'SORTBY', 2, '@g', 'ASC', 'LIMIT', 0, 2)
+    env.assertEqual(res[1:], [['g', str(g), 'sum', str(sum(range(g, 100, 10)))] for g in (0, 1)])
+
+def test_slot(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'tenant', 'TAG', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for t in range(5):
+        for i in range(20):
+            conn.execute_command('HSET', f'{{tenant{t}}}:order:{i}', 'tenant', f'tenant{t}', 'n', i)
+
+    # The queries of a tenant give the same results on the shard of its hash tag alone
+    search = ['FT.SEARCH', 'idx', '@tenant:{tenant3}', 'SORTBY', 'n', 'LIMIT', 0, 5, 'NOCONTENT']
+    expected = env.cmd(*search)
+    env.assertEqual(expected, [20] + [f'{{tenant3}}:order:{i}' for i in range(5)])
+    env.expect(*search, 'SLOT', 'tenant3').equal(expected)
+    env.expect('FT.AGGREGATE', 'idx', '@tenant:{tenant3}', 'SLOT', 'tenant3', 'GROUPBY', 1, '@tenant',
+               'REDUCE', 'COUNT', 0, 'AS', 'count').equal([1, ['tenant', 'tenant3', 'count', '20']])
+
+    env.expect('FT.SEARCH', 'idx', '*', 'SLOT').error().contains('SLOT requires a hash tag')
+    if env.isCluster():
+        # The other shards are not queried
+        res = env.cmd('FT.SEARCH', 'idx', '*', 'LIMIT', 0, 0, 'SLOT', 'tenant3')
+        env.assertGreaterEqual(res[0], 20)
+        env.assertLessEqual(res[0], 100)
+        env.expect('FT.AGGREGATE', 'idx', '*', 'SLOT', 'tenant3', 'WITHCURSOR').error() \
+           .contains('SLOT is not supported with WITHCURSOR')
+
+def test_term_stats(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'TERM_STATS_INTERVAL', -1).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello rare' if i % 10 == 0 else 'hello world')
+
+    def rare_scores():
+        res = env.cmd('FT.SEARCH', 'idx', 'rare', 'WITHSCORES', 'NOCONTENT', 'SCORER', 'BM25STD')
+        env.assertEqual(res[0], 10)
+        return set(res[2::2])
+
+    # The shards score the same documents alike once they score with the statistics of the cluster
+    env.expect('FT.CONFIG', 'SET', 'TERM_STATS_INTERVAL', 100).ok()
+    env.expect('FT.CONFIG', 'GET', 'TERM_STATS_INTERVAL').equal([['TERM_STATS_INTERVAL', '100']])
+    start = time.time()
+    while len(rare_scores()) != 1:
+        env.assertLess(time.time() - start, 10, message='the scores of the shards still differ')
+        if time.time() - start >= 10:
+            break
+        time.sleep(0.1)
+    env.expect('FT.CONFIG', 'SET', 'TERM_STATS_INTERVAL', 0).ok()
+
+def test_result_cache(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'RESULTCACHE', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(20):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+
+    # Every shard tells the coordinator the id and the revision of the index
+    res = env.cmd('_FT._REVISION', 'idx')
+    env.assertEqual(len(res), 2)
+    env.expect('_FT._REVISION', 'missing').error().contains('Unknown index name')
+
+    search = ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'DESC', 'LIMIT', 0, 3, 'NOCONTENT']
+    aggregate = ['FT.AGGREGATE', 'idx', 'hello', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count']
+
+    # A repeated query replies the same, whether it is cached or not
+    env.expect(*search).equal([20, 'doc19', 'doc18', 'doc17'])
+    env.expect(*search).equal([20, 'doc19', 'doc18', 'doc17'])
+    env.expect(*aggregate).equal([1, ['count', '20']])
+    env.expect(*aggregate).equal([1, ['count', '20']])
+
+    # A write to any shard drops the cached replies
+    conn.execute_command('HSET', 'doc20', 't', 'hello', 'n', 20)
+    env.expect(*search).equal([21, 'doc20', 'doc19', 'doc18'])
+    env.expect(*aggregate).equal([1, ['count', '21']])
+    conn.execute_command('DEL', 'doc20')
+    env.expect(*search).equal([20, 'doc19', 'doc18', 'doc17'])
+    env.expect(*aggregate).equal([1, ['count', '20']])
+
+def test_trace(env):
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'TRACE_SAMPLE', -1).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+    search = ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 5]
+    expected = env.cmd(*search)
+
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', 0).ok()
+    env.expect('FT.CONFIG', 'SET', 'TRACE_SAMPLE', 1).ok()
+    env.expect('FT.CONFIG', 'GET', 'TRACE_SAMPLE').equal([['TRACE_SAMPLE', '1']])
+    env.expect('_FT.SLOWLOG', 'RESET').ok()
+
+    # A traced search replies the same
+    env.expect(*search).equal(expected)
+
+    # The coordinator logs a span per shard along with its own times, next to the entries of the
+    # local shard
+    traces = [e for e in map(to_dict, env.cmd('_FT.SLOWLOG', 'GET')) if e['trace']]
+    env.assertEqual(len(traces), 1)
+    env.assertEqual(traces[0]['results'], 100)
+    lines = traces[0]['trace'].split('\n')
+    env.assertTrue(lines[0].startswith('coordinator '), message=lines[0])
+    env.assertContains(f' replies={env.shardsCount} {{', lines[0])
+    env.assertEqual(lines[-1], '}')
+    env.assertEqual(len(lines), env.shardsCount + 2)
+    for span in lines[1:-1]:
+        env.assertTrue(span.startswith('  shard '), message=span)
+        for t in ['replied', 'network', 'parse', 'pipeline', 'execution', 'total']:
+            env.assertContains(f' {t}=', span)
+        env.assertNotContains('error', span)
+
+    # Nor are the searches which are not sampled traced
+    env.expect('FT.CONFIG', 'SET', 'TRACE_SAMPLE', 0).ok()
+    env.expect('_FT.SLOWLOG', 'RESET').ok()
+    env.expect(*search).equal(expected)
+    env.assertEqual([e for e in map(to_dict, env.cmd('_FT.SLOWLOG', 'GET')) if e['trace']], [])
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', 100).ok()
+
+def test_local_shard_in_process():
+    env = Env(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL')
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'LOCAL_SHARD_IN_PROCESS', 'maybe').error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello world' if i % 2 else 'hello', 'n', i / 3)
+
+    queries = [
+        ('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 20, 'WITHSCORES'),
+        ('FT.SEARCH', 'idx', '@n:[10 20]', 'SORTBY', 'n', 'DESC', 'RETURN', 1, 'n'),
+        ('FT.SEARCH', 'idx', 'nothing'),
+        ('FT.AGGREGATE', 'idx', 'hello', 'GROUPBY', 1, '@t', 'REDUCE', 'SUM', 1, '@n', 'AS', 's',
+         'SORTBY', 2, '@t', 'ASC'),
+        ('FT.AGGREGATE', 'idx', 'world', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC', 'LIMIT', 0, 10),
+    ]
+    expected = [env.cmd(*q) for q in queries]
+
+    # The searches to the shard of the coordinator run in its process, with the same replies
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'LOCAL_SHARD_IN_PROCESS', 'true')
+    env.expect('FT.CONFIG', 'GET', 'LOCAL_SHARD_IN_PROCESS').equal([['LOCAL_SHARD_IN_PROCESS', 'true']])
+    for q, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*q), res, message=str(q))
+    env.expect('FT.SEARCH', 'nosuchidx', 'hello').error()
+
+    # The cursors created in the process are read over the connection
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    n = len(res) - 1
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        n += len(res) - 1
+    env.assertEqual(n, 100)
+
+    for con in env.getOSSMasterNodesConnectionList():
+        con.execute_command('FT.CONFIG', 'SET', 'LOCAL_SHARD_IN_PROCESS', 'false')
+
+def test_cursor_read_ahead():
+    env = Env()
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'CURSOR_READ_AHEAD', -1).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    # enough documents for the shards to reply in several chunks
+    with conn.pipeline(transaction=False) as p:
+        for i in range(10000):
+            p.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+        p.execute()
+
+    queries = [
+        ('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC', 'MAX', 10000),
+        ('FT.AGGREGATE', 'idx', 'hello', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'c'),
+        ('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'LIMIT', 0, 5),
+    ]
+    expected = [env.cmd(*q) for q in queries]
+
+    # With a budget below the size of a single reply, each shard cursor is read again only once its
+    # last reply is read, with the same results
+    env.expect('FT.CONFIG', 'SET', 'CURSOR_READ_AHEAD', 1).ok()
+    env.expect('FT.CONFIG', 'GET', 'CURSOR_READ_AHEAD').equal([['CURSOR_READ_AHEAD', '1']])
+    for q, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*q), res, message=str(q))
+
+    # An aggregation which stops reading early is not held back by the shards waiting on it
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    n = len(res) - 1
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        n += len(res) - 1
+    env.assertEqual(n, 10000)
+    env.cmd('FT.AGGREGATE', 'idx', 'hello', 'WITHCURSOR', 'COUNT', 10)
+
+    env.expect('FT.CONFIG', 'SET', 'CURSOR_READ_AHEAD', 0).ok()
+    for q, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*q), res, message=str(q))
+    env.expect('FT.CONFIG', 'SET', 'CURSOR_READ_AHEAD', 4 << 20).ok()
+
+def test_info_cache():
+    env = Env()
+    SkipOnNonCluster(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'INFO_CACHE_TTL', -1).error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    conn.execute_command('HSET', 'doc1', 't', 'hello')
+    env.expect('FT.INFO', 'idx', 'EVERYTHING').error()
+
+    def num_docs(*args):
+        res = env.cmd('FT.INFO', 'idx', *args)
+        return int(float(res[res.index('num_docs') + 1]))
+
+    env.assertEqual(num_docs(), 1)
+    env.assertEqual(num_docs('SUMMARY'), 1)
+
+    # Within the TTL the merged reply is replied again, without asking the shards
+    env.expect('FT.CONFIG', 'SET', 'INFO_CACHE_TTL', 100000).ok()
+    env.expect('FT.CONFIG', 'GET', 'INFO_CACHE_TTL').equal([['INFO_CACHE_TTL', '100000']])
+    env.assertEqual(num_docs(), 1)
+    env.assertEqual(num_docs('SUMMARY'), 1)
+    conn.execute_command('HSET', 'doc2', 't', 'hello')
+    env.assertEqual(num_docs(), 1)
+    env.assertEqual(num_docs('SUMMARY'), 1)
+
+    # and once it expires, the shards are asked again
+    env.expect('FT.CONFIG', 'SET', 'INFO_CACHE_TTL', 1).ok()
+    time.sleep(0.01)
+    env.assertEqual(num_docs(), 2)
+    env.assertEqual(num_docs('SUMMARY'), 2)
+    env.expect('FT.CONFIG', 'SET', 'INFO_CACHE_TTL', 0).ok()
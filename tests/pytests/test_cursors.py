@@ -59,6 +59,88 @@ def testCursorsBG():
     env = Env(moduleArgs='WORKER_THREADS 1 MT_MODE MT_MODE_FULL _PRINT_PROFILE_CLOCK FALSE')
     testCursors(env)
 
+def runCursorsPrefetch(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(1000):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+
+    def read_all(prefetch, *args):
+        query = ['FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC',
+                 'WITHCURSOR', 'COUNT', 100] + prefetch
+        rows = []
+        for res, _ in exhaustCursor(env, 'idx', env.cmd(*query), *args):
+            rows += res[1:]
+        return rows
+
+    # The same rows are read ahead, whatever the size of the reads
+    expected = read_all([])
+    env.assertEqual(len(expected), 1000)
+    env.assertEqual(read_all(['PREFETCH']), expected)
+    env.assertEqual(read_all(['PREFETCH'], 'COUNT', 30), expected)
+    env.assertEqual(read_all(['PREFETCH'], 'COUNT', 250), expected)
+
+    # A cursor deleted while it reads ahead is freed once it is done
+    _, cid = env.cmd('FT.AGGREGATE', 'idx', '*', 'WITHCURSOR', 'COUNT', 10, 'PREFETCH')
+    env.expect('FT.CURSOR', 'DEL', 'idx', cid).ok()
+    env.expect('FT.CURSOR', 'READ', 'idx', cid).error().contains('Cursor not found')
+    with TimeLimit(10):
+        while getCursorStats(env)['index_total']:
+            sleep(0.01)
+
+def testCursorsPrefetch(env):
+    # Without the workers the cursor is read as usual
+    runCursorsPrefetch(env)
+
+@skip(noWorkers=True)
+def testCursorsPrefetchBG():
+    env = Env(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL')
+    runCursorsPrefetch(env)
+
+def testCursorsFreeze(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 'g', 'TAG').ok()
+    for i in range(1000):
+        conn.execute_command('HSET', f'doc{i}', 'n', i, 'g', f'g{i % 7}')
+
+    def read_all(query, freeze):
+        res = env.cmd('FT.AGGREGATE', 'idx', *query, 'WITHCURSOR', 'COUNT', 30, *freeze)
+        rows = []
+        for res, _ in exhaustCursor(env, 'idx', res):
+            rows += res[1:]
+        return rows
+
+    queries = [
+        # the iterators are resumed
+        ['*', 'LOAD', 1, '@n'],
+        ['@n:[100 800]', 'LOAD', 2, '@n', '@g', 'FILTER', '@n % 3 == 0', 'APPLY', '@n * 2', 'AS', 'd'],
+        # the remaining rows are packed
+        ['*', 'SORTBY', 2, '@n', 'DESC', 'APPLY', '@n + 1', 'AS', 'm'],
+        ['*', 'GROUPBY', 1, '@g', 'REDUCE', 'COUNT', 0, 'AS', 'c', 'SORTBY', 2, '@g', 'ASC'],
+        ['*', 'SORTBY', 2, '@n', 'ASC', 'MAX', 500, 'LOAD', 1, '@g'],
+    ]
+    for query in queries:
+        expected = read_all(query, [])
+        env.assertGreater(len(expected), 0, message=query)
+        env.assertEqual(read_all(query, ['FREEZE']), expected, message=query)
+
+    # A frozen cursor reads the documents it started with which were not deleted meanwhile
+    res, cid = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 100, 'FREEZE')
+    values = [row[1] for row in res[1:]]
+    deleted = 0
+    while cid:
+        conn.execute_command('DEL', f'doc{999 - deleted}')
+        conn.execute_command('HSET', f'new{deleted}', 'n', 5000 + deleted)
+        deleted += 1
+        res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', cid)
+        values += [row[1] for row in res[1:]]
+    env.assertEqual(values, [str(i) for i in range(1000 - deleted)])
+
+@skip(noWorkers=True)
+def testCursorsFreezeBG():
+    env = Env(moduleArgs='WORKER_THREADS 1 MT_MODE MT_MODE_FULL')
+    testCursorsFreeze(env)
 
 @skip(noWorkers=True)
 def testCursorsBGEdgeCasesSanity():
@@ -191,6 +273,70 @@ def testNumericCursor(env):
     env.assertEqual(res, [0])
     env.assertEqual(cursor, 0)
 
+def testNumericCursorWithWrites(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'n', 'NUMERIC').ok()
+    num_docs = 100
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', '@n:[0 1000]', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    values = [row[1] for row in res[1:]]
+    # the ranges of the numeric tree split under the cursor, which still reads the documents it
+    # started with, and only those
+    added = 0
+    while cursor:
+        for _ in range(200):
+            conn.execute_command('HSET', f'new{added}', 'n', 0.5 + added * 0.25)
+            added += 1
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        values += [row[1] for row in res[1:]]
+    env.assertEqual(sorted(values, key=float), [str(i) for i in range(num_docs)])
+
+@skip(noWorkers=True)
+def testNumericCursorWithWritesBG():
+    env = Env(moduleArgs='WORKER_THREADS 1 MT_MODE MT_MODE_FULL')
+    testNumericCursorWithWrites(env)
+
+def testCursorWithUpdates(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    num_docs = 100
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@__key', 'WITHCURSOR', 'COUNT', 10)
+    keys = [row[1] for row in res[1:]]
+    # the updated documents get new ids, past the documents the cursor started with, and are still
+    # read, while the new ones are not
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', num_docs + i)
+    conn.execute_command('HSET', 'new', 't', 'hello')
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        keys += [row[1] for row in res[1:]]
+    env.assertEqual(set(keys), {f'doc{i}' for i in range(num_docs)})
+
+def testCursorAfterDocIdCompaction():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0 GC_COMPACT_DOCIDS_RATIO 2')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT').ok()
+    num_docs = 3000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello')
+
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@__key', 'WITHCURSOR', 'COUNT', 10)
+    for i in range(num_docs):
+        if i % 3:
+            conn.execute_command('DEL', f'doc{i}')
+    forceInvokeGC(env, 'idx')
+
+    # the ids the cursor read up to were renumbered, it fails rather than end early
+    env.expect('FT.CURSOR', 'READ', 'idx', cursor).error().contains('renumbered')
 
 def testIndexDropWhileIdle(env):
     conn = getConnectionByEnv(env)
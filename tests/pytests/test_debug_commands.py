@@ -1,6 +1,6 @@
 from RLTest import Env
 from includes import *
-from common import waitForIndex
+from common import waitForIndex, to_dict
 
 
 class TestDebugCommands(object):
@@ -27,12 +27,13 @@ class TestDebugCommands(object):
         err_msg = 'wrong number of arguments'
         help_list = ['DUMP_INVIDX', 'DUMP_NUMIDX', 'DUMP_NUMIDXTREE', 'DUMP_TAGIDX', 'INFO_TAGIDX', 'DUMP_GEOMIDX', 'IDTODOCID', 'DOCIDTOID', 'DOCINFO',
                      'DUMP_PHONETIC_HASH', 'DUMP_SUFFIX_TRIE', 'DUMP_TERMS', 'INVIDX_SUMMARY', 'NUMIDX_SUMMARY',
-                     'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GC_CLEAN_NUMERIC', 'GIT_SHA', 'TTL', 'VECSIM_INFO']
+                     'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GC_CLEAN_NUMERIC', 'GIT_SHA', 'TTL', 'VECSIM_INFO', 'MEMORY',
+                     'BUILD_PROFILE', 'ALLOCSTATS']
         self.env.expect('FT.DEBUG', 'help').equal(help_list)
 
         for cmd in help_list:
-            if cmd == 'GIT_SHA':
-                # 'GIT_SHA' do not return err_msg
+            if cmd in ['GIT_SHA', 'ALLOCSTATS']:
+                # 'GIT_SHA' and 'ALLOCSTATS' do not return err_msg
                  continue
             self.env.expect('FT.DEBUG', cmd).raiseError().contains(err_msg)
 
@@ -149,11 +150,13 @@ class TestDebugCommands(object):
     def testInvertedIndexSummary(self):
         self.env.expect('FT.DEBUG', 'invidx_summary', 'idx', 'meir').equal(['numDocs', 1, 'lastId', 1, 'flags',
                                                                             83, 'numberOfBlocks', 1, 'blocks',
-                                                                            ['firstId', 1, 'lastId', 1, 'numEntries', 1]])
+                                                                            ['firstId', 1, 'lastId', 1, 'numEntries', 1,
+                                                                             'capacity', 100]])
 
         self.env.expect('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'meir').equal(['numDocs', 1, 'lastId', 1, 'flags',
                                                                             83, 'numberOfBlocks', 1, 'blocks',
-                                                                            ['firstId', 1, 'lastId', 1, 'numEntries', 1]])
+                                                                            ['firstId', 1, 'lastId', 1, 'numEntries', 1,
+                                                                             'capacity', 100]])
 
     def testUnexistsInvertedIndexSummary(self):
         self.env.expect('FT.DEBUG', 'invidx_summary', 'idx', 'meir1').raiseError()
@@ -180,5 +183,71 @@ class TestDebugCommands(object):
     def testNumericIndexSummaryWrongArity(self):
         self.env.expect('FT.DEBUG', 'numidx_summary', 'idx1').raiseError()
 
+    def testIndexMemory(self):
+        res = to_dict(self.env.cmd('FT.DEBUG', 'MEMORY', 'idx'))
+        doc_table = to_dict(res['doc_table'])
+        self.env.assertEqual(doc_table['num_docs'], 1)
+        for name in ['metadata', 'keys', 'sorting_vectors', 'pages', 'key_map', 'live_bitmap']:
+            mem = to_dict(doc_table[name])
+            self.env.assertGreater(mem['allocated'], 0, message=name)
+            self.env.assertGreaterEqual(mem['allocated'], mem['used'], message=name)
+        self.env.assertEqual(to_dict(res['terms_trie'])['entries'], 1)
+        self.env.assertEqual(to_dict(res['text_postings'])['num_indexes'], 1)
+
+        fields = [to_dict(f) for f in res['fields']]
+        self.env.assertEqual([f['attribute'] for f in fields], ['name', 'age', 't'])
+        self.env.assertEqual(fields[1]['num_ranges'], 1)
+        self.env.assertEqual(to_dict(fields[1]['postings'])['num_indexes'], 1)
+        self.env.assertEqual(fields[2]['num_values'], 1)
+
+        top = [to_dict(t) for t in res['top_terms']]
+        self.env.assertEqual([(t['term'], t['num_docs']) for t in top], [('meir', 1)])
+        res = to_dict(self.env.cmd('FT.DEBUG', 'MEMORY', 'idx', 'TOP', 0))
+        self.env.assertEqual(res['top_terms'], [])
+
+    def testIndexMemoryErrors(self):
+        self.env.expect('FT.DEBUG', 'MEMORY', 'idx1').raiseError()
+        self.env.expect('FT.DEBUG', 'MEMORY', 'idx', 'TOP').raiseError()
+        self.env.expect('FT.DEBUG', 'MEMORY', 'idx', 'TOP', -1).raiseError()
+        self.env.expect('FT.DEBUG', 'MEMORY', 'idx', 'BOTTOM', 1).raiseError()
+
+    def testBuildProfile(self):
+        # built by scanning the existing keys
+        self.env.expect('FT.CREATE', 'idx_bp', 'ON', 'HASH', 'SCHEMA', 'name', 'TEXT', 'age', 'NUMERIC').ok()
+        waitForIndex(self.env, 'idx_bp')
+        res = to_dict(self.env.cmd('FT.DEBUG', 'BUILD_PROFILE', 'idx_bp'))
+        self.env.assertEqual(res['in_progress'], 0)
+        self.env.assertEqual(res['global_scan'], 0)
+        self.env.assertGreaterEqual(res['keys_scanned'], 1)
+        self.env.assertEqual(res['docs_indexed'], 1)
+        self.env.assertGreaterEqual(float(res['total_ms']), float(res['gil_held_ms']))
+        types = {t['type']: t for t in map(to_dict, res['field_types'])}
+        self.env.assertEqual(sorted(types.keys()), ['NUMERIC', 'TEXT'])
+        self.env.assertEqual(types['TEXT']['fields'], 1)
+
+        # the writes that follow the build are not profiled
+        self.env.cmd('HSET', 'doc2', 'name', 'hello', 'age', 3)
+        self.env.assertEqual(to_dict(self.env.cmd('FT.DEBUG', 'BUILD_PROFILE', 'idx_bp'))['docs_indexed'], 1)
+
+        self.env.expect('FT.DEBUG', 'BUILD_PROFILE', 'idx_bp', 'extra').raiseError()
+        self.env.expect('FT.DEBUG', 'BUILD_PROFILE', 'imaginary').raiseError()
+        self.env.cmd('DEL', 'doc2')
+        self.env.expect('FT.DROPINDEX', 'idx_bp').ok()
+
+    def testAllocStats(self):
+        try:
+            res = to_dict(self.env.cmd('FT.DEBUG', 'ALLOCSTATS'))
+        except Exception as e:
+            # only built with ALLOC_STATS=1
+            self.env.assertContains('not built', str(e))
+            return
+        self.env.assertEqual(list(res.keys()), ['other', 'inverted_index', 'numeric', 'tag', 'trie',
+                                                'doc_table', 'sortables', 'query', 'coordinator'])
+        for tag in ['inverted_index', 'numeric', 'tag', 'trie', 'doc_table', 'sortables']:
+            stats = to_dict(res[tag])
+            self.env.assertGreater(stats['live_bytes'], 0, message=tag)
+            self.env.assertEqual(stats['live_bytes'], stats['allocated_bytes'] - stats['freed_bytes'], message=tag)
+        self.env.expect('FT.DEBUG', 'ALLOCSTATS', 'idx').raiseError().contains('wrong number of arguments')
+
     def testDumpSuffixWrongArity(self):
         self.env.expect('FT.DEBUG', 'DUMP_SUFFIX_TRIE', 'idx1', 'no_suffix').raiseError()
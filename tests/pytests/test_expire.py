@@ -37,6 +37,56 @@ def testExpireIndex(env):
     except Exception as e:
         env.assertEqual(str(e), 'Unknown index name')
 
+def testLazyIndex(env):
+    # lazy indexes are built on their first access, and evicted once idle
+    if env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'LAZY', 2, 'TEMPORARY', 2, 'SCHEMA', 't', 'TEXT').error()\
+       .contains('mutually exclusive')
+    env.expect('FT.CREATE', 'idx', 'LAZY', 0, 'SCHEMA', 't', 'TEXT').error().contains('Bad idle timeout')
+
+    conn.execute_command('HSET', 'doc1', 't', 'hello', 'n', 1)
+    env.expect('FT.CREATE', 'idx', 'LAZY', 2, 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+
+    def stats():
+        return to_dict(index_info(env, 'idx')['lazy_index_stats'])
+
+    # FT.INFO does not load the index
+    env.assertContains('LAZY', index_info(env, 'idx')['index_options'])
+    env.assertEqual(stats()['loaded'], 0)
+    env.assertEqual(stats()['idle_timeout_sec'], 2)
+    env.assertEqual(int(index_info(env, 'idx')['num_docs']), 0)
+
+    # the writes to an evicted index are indexed once it is loaded
+    conn.execute_command('HSET', 'doc2', 't', 'hello world', 'n', 2)
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'SORTBY', 'n').equal([2, 'doc1', 'doc2'])
+    env.assertEqual(stats()['loaded'], 1)
+    env.assertEqual(stats()['loads'], 1)
+    conn.execute_command('HSET', 'doc3', 't', 'hello', 'n', 3)
+    env.expect('FT.SEARCH', 'idx', '@n:[3 3]', 'NOCONTENT').equal([1, 'doc3'])
+
+    # evicted once idle, keeping its definition
+    with TimeLimit(10):
+        while stats()['loaded']:
+            time.sleep(0.1)
+    env.assertEqual(stats()['evictions'], 1)
+    env.assertEqual(int(index_info(env, 'idx')['num_docs']), 0)
+    conn.execute_command('DEL', 'doc1')
+
+    env.expect('FT.WARMUP', 'idx').ok()
+    env.assertEqual(stats()['loaded'], 1)
+    env.assertEqual(stats()['loads'], 2)
+    env.assertEqual(int(index_info(env, 'idx')['num_docs']), 2)
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'SORTBY', 'n').equal([2, 'doc2', 'doc3'])
+    env.expect('FT.WARMUP', 'missing').error().contains('Unknown index name')
+
+    # not evicted while a cursor is open on it
+    _, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@t', 'WITHCURSOR', 'COUNT', 1)
+    time.sleep(3)
+    env.assertEqual(stats()['loaded'], 1)
+    env.cmd('FT.CURSOR', 'DEL', 'idx', cursor)
+
 res_doc1_is_empty = [2, 'doc1', [], 'doc2', ['t', 'foo']]
 res_doc1_is_empty_last = [2, 'doc2', ['t', 'foo'], 'doc1', []]
 res_doc1_is_partial = [2, 'doc1', ['t', 'bar'], 'doc2', ['t', 'foo']]
@@ -751,3 +751,109 @@ def testFilterWithNot(env):
     conn.execute_command('JSON.SET', 'thing:bar', '$', r'{"name":"foo", "indexName":"idx1"}')
 
     env.expect('ft.search', 'things', 'foo').equal([0])
+
+@skip(cluster=True)
+def testConcurrentInitialScan(env):
+    conn = getConnectionByEnv(env)
+    words = ['hello', 'world', 'running', 'foo', 'bar']
+    for i in range(200):
+        # the long documents are preprocessed by the index threads, the short ones are not
+        text = ' '.join(words[(i + j) % len(words)] for j in range(400 if i % 2 else 4))
+        conn.execute_command('HSET', 'doc%d' % i, 't', text, 'tag', 'tag%d' % (i % 3),
+                             'n', i if i % 50 else 'nan%d' % i)
+
+    env.expect('FT.CONFIG', 'SET', 'BG_INDEX_CONCURRENT', 'true').ok()
+    env.expect('FT.CREATE idx_concurrent SCHEMA t TEXT tag TAG SORTABLE n NUMERIC').ok()
+    waitForIndex(env, 'idx_concurrent')
+    env.expect('FT.CONFIG', 'SET', 'BG_INDEX_CONCURRENT', 'false').ok()
+    env.expect('FT.CREATE idx SCHEMA t TEXT tag TAG SORTABLE n NUMERIC').ok()
+    waitForIndex(env, 'idx')
+
+    for query in ['hello', 'run', '@tag:{tag1}', '@n:[10 20]', 'foo -@tag:{tag2}']:
+        env.assertEqual(env.cmd('FT.SEARCH', 'idx_concurrent', query, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, 200),
+                        env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, 200),
+                        message=query)
+
+    info = index_info(env, 'idx_concurrent')
+    env.assertEqual(int(info['num_docs']), 196)
+    env.assertEqual(int(info['hash_indexing_failures']), 4)
+
+@skip(cluster=True)
+def testSlicedInitialScan(env):
+    # holding the GIL for several batches of keys at a time indexes all of them, once
+    conn = getConnectionByEnv(env)
+    for i in range(5000):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello world %d' % i, 'n', i)
+
+    for concurrent in ['false', 'true']:
+        env.expect('FT.CONFIG', 'SET', 'BG_INDEX_CONCURRENT', concurrent).ok()
+        env.expect('FT.CONFIG', 'SET', 'BG_INDEX_SLICE_USEC', 2000).ok()
+        env.expect('FT.CREATE', 'idx_' + concurrent, 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+        waitForIndex(env, 'idx_' + concurrent)
+        env.expect('FT.CONFIG', 'SET', 'BG_INDEX_SLICE_USEC', 0).ok()
+        env.expect('FT.CONFIG', 'SET', 'BG_INDEX_CONCURRENT', 'false').ok()
+
+        info = index_info(env, 'idx_' + concurrent)
+        env.assertEqual(int(info['num_docs']), 5000)
+        env.assertEqual(int(info['max_doc_id']), 5000)
+        env.expect('FT.SEARCH', 'idx_' + concurrent, '@n:[100 199]', 'LIMIT', 0, 0).equal([100])
+
+@skip(cluster=True)
+def testUpdateUnindexedInPlace(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'name', 'TEXT', 'price', 'NUMERIC',
+               'stock', 'NUMERIC', 'SORTABLE', 'NOINDEX', 'note', 'TEXT', 'SORTABLE', 'NOINDEX').ok()
+    conn.execute_command('HSET', 'p1', 'name', 'red shirt', 'price', 10, 'stock', 5, 'note', 'new')
+    conn.execute_command('HSET', 'p2', 'name', 'blue shirt', 'price', 20, 'stock', 7)
+
+    # only the unindexed fields change, or nothing does: the documents keep their ids
+    conn.execute_command('HSET', 'p1', 'stock', 4)
+    conn.execute_command('HSET', 'p2', 'name', 'blue shirt', 'price', 20, 'stock', 3)
+    conn.execute_command('HSET', 'p1', 'note', 'Sale')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 2)
+    env.expect('FT.SEARCH', 'idx', 'shirt', 'SORTBY', 'stock', 'RETURN', 1, 'stock').equal(
+        [2, 'p2', ['stock', '3'], 'p1', ['stock', '4']])
+    env.expect('FT.SEARCH', 'idx', 'red', 'NOCONTENT', 'SORTBY', 'note', 'WITHSORTKEYS').equal(
+        [1, 'p1', '$sale'])
+
+    # an invalid unindexed value fails the document, as when it is indexed
+    conn.execute_command('HSET', 'p2', 'stock', 'many')
+    env.expect('FT.SEARCH', 'idx', 'blue', 'NOCONTENT').equal([0])
+    env.assertEqual(int(index_info(env, 'idx')['hash_indexing_failures']), 1)
+
+    # indexed values are reindexed under a new id
+    conn.execute_command('HSET', 'p1', 'price', 12)
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 3)
+    env.expect('FT.SEARCH', 'idx', '@price:[11 13]', 'RETURN', 1, 'stock').equal([1, 'p1', ['stock', '4']])
+
+    # adding or removing an unindexed field reindexes the document as well
+    conn.execute_command('HDEL', 'p1', 'note')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 4)
+    env.expect('FT.SEARCH', 'idx', 'red', 'RETURN', 1, 'stock').equal([1, 'p1', ['stock', '4']])
+
+@skip(cluster=True)
+def testManyFilteredIndexes(env):
+    conn = getConnectionByEnv(env)
+    # the indexes share their prefix, and the fields of their filters
+    for i in range(20):
+        env.expect('FT.CREATE', 'idx%d' % i, 'PREFIX', 1, 'item:',
+                   'FILTER', '@n %% 20 == %d && @kind == "a"' % i,
+                   'SCHEMA', 'n', 'NUMERIC', 'kind', 'TAG').ok()
+    env.expect('FT.CREATE', 'all', 'PREFIX', 1, 'item:', 'SCHEMA', 'name', 'TEXT').ok()
+
+    for i in range(100):
+        conn.execute_command('HSET', 'item:%d' % i, 'n', i, 'kind', 'a' if i % 2 == 0 else 'b',
+                             'name', 'x')
+    for i in range(20):
+        expected = 5 if i % 2 == 0 else 0
+        env.assertEqual(int(index_info(env, 'idx%d' % i)['num_docs']), expected)
+    env.assertEqual(int(index_info(env, 'all')['num_docs']), 100)
+
+    # a field of the filter takes the document out of the index
+    conn.execute_command('HSET', 'item:4', 'kind', 'b')
+    env.expect('FT.SEARCH', 'idx4', '*', 'NOCONTENT').equal([4, 'item:24', 'item:44', 'item:64', 'item:84'])
+    # and puts it back in another one
+    conn.execute_command('HSET', 'item:4', 'n', 5, 'kind', 'a')
+    env.assertEqual(int(index_info(env, 'idx5')['num_docs']), 1)
+    env.expect('FT.SEARCH', 'idx5', '*', 'NOCONTENT').equal([1, 'item:4'])
+    env.expect('FT.SEARCH', 'all', '@name:x', 'LIMIT', 0, 0).equal([100])
@@ -282,3 +282,266 @@ def testAutoMemory_MOD_3951():
     env.expect('FT.ALTER', 'idx', 'SCHEMA', 'ADD', '2nd', 'TEXT').equal('OK')
 
     # This test should catch some leaks on the sanitizer
+
+def testIncrementalGC():
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL FORK_GC_CLEAN_THRESHOLD 0 GC_SCANSIZE 1')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC', 't', 'TAG').ok()
+
+    # enough documents for several blocks, so the pass takes more than one slice
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world', 'id', i, 't', 'tag%d' % (i % 2))
+    conn.execute_command('HSET', 'lonely', 'title', 'lonely', 't', 'lonely')
+
+    # the first pass checks every block, as the documents deleted before the index was loaded are
+    # not known
+    forceInvokeGC(env, 'idx')
+
+    # delete the documents of the first block only, and a term and a tag value entirely
+    for i in range(50):
+        env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    env.assertEqual(conn.execute_command('DEL', 'lonely'), 1)
+    forceInvokeGC(env, 'idx')
+
+    remaining = list(range(51, n + 1))
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), remaining)
+    env.assertEqual(sorted(set(sum(env.cmd('FT.DEBUG', 'DUMP_NUMIDX', 'idx', 'id'), []))), remaining)
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_TERMS', 'idx'), ['hello', 'world'])
+    env.assertEqual(sorted(r[0] for r in env.cmd('FT.DEBUG', 'DUMP_TAGIDX', 'idx', 't')), ['tag0', 'tag1'])
+    env.expect('FT.SEARCH', 'idx', '@id:[0 99]', 'LIMIT', 0, 0).equal([50])
+
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertGreater(float(gc_stats['total_slices']), float(gc_stats['total_cycles']))
+    # only the blocks holding the deleted documents were rewritten in the second pass
+    env.assertGreater(float(gc_stats['gc_blocks_skipped']), 0)
+
+def testForkGCDirtyBlocks():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC', 't', 'TAG').ok()
+
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world', 'id', i, 't', 'tag')
+    # the first cycle repairs every block
+    forceInvokeGC(env, 'idx')
+
+    # the next cycles only repair the blocks holding the documents deleted since the previous one
+    deleted = set()
+    for ids in [range(0, 10), range(1500, 1510), range(n - 10, n)]:
+        for i in ids:
+            env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+            deleted.add(i + 1)
+        forceInvokeGC(env, 'idx')
+
+    remaining = [i for i in range(1, n + 1) if i not in deleted]
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), remaining)
+    env.assertEqual(sorted(set(sum(env.cmd('FT.DEBUG', 'DUMP_NUMIDX', 'idx', 'id'), []))), remaining)
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_TAGIDX', 'idx', 't'), [['tag', remaining]])
+
+def testForkGCSharedMemory():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0 FORK_GC_SHARED_MEMORY true')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC', 't', 'TAG').ok()
+
+    # enough repaired blocks to grow the shared region past its initial size
+    n = 20000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world %d' % (i % 7), 'id', i, 't', 'tag%d' % (i % 3))
+    for i in range(0, n, 3):
+        env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+
+    remaining = [i + 1 for i in range(n) if i % 3]
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), remaining)
+    env.assertEqual(sorted(set(sum(env.cmd('FT.DEBUG', 'DUMP_NUMIDX', 'idx', 'id'), []))), remaining)
+    env.assertEqual(sorted(r[0] for r in env.cmd('FT.DEBUG', 'DUMP_TAGIDX', 'idx', 't')), ['tag1', 'tag2'])
+    env.expect('FT.SEARCH', 'idx', '@t:{tag0}', 'LIMIT', 0, 0).equal([0])
+    env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([len(remaining)])
+
+def testDocIdCompaction():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0 GC_COMPACT_DOCIDS_RATIO 2')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC', 'SORTABLE',
+               't', 'TAG').ok()
+
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world', 'id', i, 't', 'tag%d' % (i % 2))
+    for i in range(n):
+        if i % 3:
+            env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+
+    # the remaining documents are renumbered densely, in the same order
+    remaining = n // 3
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), remaining)
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), list(range(1, remaining + 1)))
+    env.assertEqual(sorted(set(sum(env.cmd('FT.DEBUG', 'DUMP_NUMIDX', 'idx', 'id'), []))),
+                    list(range(1, remaining + 1)))
+    tags = dict(env.cmd('FT.DEBUG', 'DUMP_TAGIDX', 'idx', 't'))
+    env.assertEqual(tags['tag0'], list(range(1, remaining + 1, 2)))
+    env.assertEqual(tags['tag1'], list(range(2, remaining + 1, 2)))
+
+    # the documents are found by their key and their values
+    env.expect('FT.SEARCH', 'idx', '@id:[300 300]', 'NOCONTENT').equal([1, 'doc300'])
+    env.expect('FT.SEARCH', 'idx', '@t:{tag1}', 'LIMIT', 0, 0).equal([remaining // 2])
+    res = env.cmd('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'id', 'DESC', 'LIMIT', 0, 2, 'NOCONTENT')
+    env.assertEqual(res, [remaining, 'doc2997', 'doc2994'])
+
+    # new documents are added after the compacted ones
+    conn.execute_command('HSET', 'new', 'title', 'hello world', 'id', n, 't', 'tag0')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), remaining + 1)
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world')[-1], remaining + 1)
+    env.assertEqual(conn.execute_command('DEL', 'doc0'), 1)
+    env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([remaining])
+
+def testMergeRepairedBlocks():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT').ok()
+
+    n = 2000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world')
+    blocksBefore = to_dict(env.cmd('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'world'))['numberOfBlocks']
+
+    # leave a tenth of the entries of every block
+    for i in range(n):
+        if i % 10:
+            env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+
+    # the repaired blocks were merged, and hold the remaining entries in order
+    blocksAfter = to_dict(env.cmd('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'world'))['numberOfBlocks']
+    env.assertLess(blocksAfter, blocksBefore // 2)
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), list(range(1, n + 1, 10)))
+    env.expect('FT.SEARCH', 'idx', 'hello world', 'LIMIT', 0, 0).equal([n // 10])
+
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertGreater(float(gc_stats['gc_blocks_merged']), 0)
+
+    # new documents are appended after the merged blocks
+    conn.execute_command('HSET', 'new', 'title', 'hello world')
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world')[-1], n + 1)
+
+def testRetentionDropsLeadingBlocks():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 't', 'TAG').ok()
+
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world', 't', 'tag%d' % (i % 2))
+    blocksBefore = to_dict(env.cmd('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'world'))['numberOfBlocks']
+
+    # the documents expire in the order they were added
+    expired = 2000
+    for i in range(expired):
+        env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertGreater(float(gc_stats['retention_blocks_dropped']), 0)
+    env.assertGreater(float(gc_stats['retention_records_dropped']), 0)
+    blocksAfter = to_dict(env.cmd('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'world'))['numberOfBlocks']
+    env.assertLess(blocksAfter, blocksBefore)
+
+    # the blocks of the live documents are left in place
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'), list(range(expired + 1, n + 1)))
+    env.expect('FT.SEARCH', 'idx', 'hello world', 'LIMIT', 0, 0).equal([n - expired])
+    env.expect('FT.SEARCH', 'idx', '@t:{tag1}', 'LIMIT', 0, 0).equal([(n - expired) // 2])
+    env.assertEqual(int(index_info(env, 'idx')['num_records']), (n - expired) * 3)
+
+    # new documents are appended after the remaining blocks
+    conn.execute_command('HSET', 'new', 'title', 'hello world')
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world')[-1], n + 1)
+
+def testColdBlocks():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0 GC_COLD_BLOCKS_PERIOD 1')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC',
+               't', 'TAG').ok()
+
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 'title', 'hello world', 'id', i, 't', 'tag%d' % (i % 2))
+
+    def queries():
+        return [env.cmd('FT.SEARCH', 'idx', 'hello world', 'LIMIT', 0, 0),
+                env.cmd('FT.SEARCH', 'idx', '@id:[100 2500]', 'LIMIT', 0, 0),
+                env.cmd('FT.SEARCH', 'idx', '@t:{tag1} world', 'LIMIT', 0, 0),
+                env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world')]
+    expected = queries()
+
+    # the blocks go cold once a sweep finds they were not accessed since the previous one
+    sleep(1.1)
+    forceInvokeGC(env, 'idx')
+    sleep(1.1)
+    forceInvokeGC(env, 'idx')
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertEqual(float(gc_stats['cold_block_sweeps']), 2)
+    env.assertGreater(float(gc_stats['cold_blocks']), 0)
+    env.assertLess(float(gc_stats['cold_blocks_bytes']), float(gc_stats['cold_blocks_inflated_bytes']))
+
+    # cold blocks are read from the cache once inflated
+    env.assertEqual(queries(), expected)
+    env.assertEqual(queries(), expected)
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertGreater(float(gc_stats['cold_block_cache_hit_ratio']), 0)
+
+    # cold blocks are repaired by the gc
+    for i in range(n):
+        if i % 3 == 0:
+            env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+    env.expect('FT.SEARCH', 'idx', 'hello world', 'LIMIT', 0, 0).equal([n - n // 3])
+    env.assertEqual(env.cmd('FT.DEBUG', 'DUMP_INVIDX', 'idx', 'world'),
+                    [i + 1 for i in range(n) if i % 3])
+
+def testTermsTrieCompaction():
+    env = Env(moduleArgs='GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0')
+    if env.env == 'existing-env' or env.isCluster():
+        env.skip()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'NOSTEM').ok()
+
+    n = 3000
+    for i in range(n):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'common word%d' % i)
+    before = to_dict(to_dict(env.cmd('FT.DEBUG', 'MEMORY', 'idx'))['terms_trie'])
+    env.assertEqual(before['entries'], n + 1)
+
+    # leave a tenth of the documents, and their terms
+    for i in range(n):
+        if i % 10:
+            env.assertEqual(conn.execute_command('DEL', 'doc%d' % i), 1)
+    forceInvokeGC(env, 'idx')
+
+    removed = n - n // 10
+    gc_stats = to_dict(index_info(env, 'idx')['gc_stats'])
+    env.assertEqual(float(gc_stats['gc_terms_removed']), removed)
+    env.assertEqual(int(index_info(env, 'idx')['num_terms']), n // 10 + 1)
+
+    # the deletions compacted the trie, which only holds a few of them
+    after = to_dict(to_dict(env.cmd('FT.DEBUG', 'MEMORY', 'idx'))['terms_trie'])
+    env.assertEqual(after['entries'], n // 10 + 1)
+    env.assertLess(after['deleted'], removed)
+    env.assertLess(after['bytes'], before['bytes'] // 2)
+    env.expect('FT.SEARCH', 'idx', 'word10', 'NOCONTENT').equal([1, 'doc10'])
+    env.expect('FT.SEARCH', 'idx', 'word11', 'NOCONTENT').equal([0])
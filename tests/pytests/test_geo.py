@@ -127,3 +127,36 @@ def testGeoDistanceFile(env):
               'APPLY', 'geodistance(@location,-0.15036,51.50566)', 'AS', 'distance',
               'GROUPBY', '1', '@distance',
               'SORTBY', 2, '@distance', 'ASC').equal(res)
+
+def testGeoNearest(env):
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'loc', 'GEO', 'tag', 'TAG').ok()
+  for i in range(50):
+    for j in range(50):
+      conn.execute_command('HSET', f'doc{i}_{j}', 'loc', f'{2 + i * 0.01},{48 + j * 0.01}',
+                           'tag', 'even' if (i + j) % 2 == 0 else 'odd')
+
+  for query in ['@loc:[2.2013 48.2037 50 km]=>{$yield_distance_as: dist}',
+                '@tag:{odd} @loc:[2.2013 48.2037 50 km]=>{$yield_distance_as: dist}']:
+    args = ['FT.SEARCH', 'idx', query, 'SORTBY', 'dist', 'LIMIT', 0, 10, 'RETURN', 1, 'dist']
+    # the optimizer collects the nearest documents only, the results must not change
+    nearest = env.cmd(*args, 'DIALECT', 4)
+    full = env.cmd(*args, 'WITHCOUNT', 'DIALECT', 4)
+    env.assertEqual(len(nearest), 21)
+    env.assertEqual(nearest[1:], full[1:])
+    dists = [float(res[1]) for res in nearest[2::2]]
+    env.assertEqual(dists, sorted(dists))
+    env.assertLess(dists[-1], 2)
+
+    profile = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query, 'SORTBY', 'dist',
+                      'LIMIT', 0, 10, 'DIALECT', 4)
+    env.assertContains('GEO-NEAREST', str(profile))
+
+  # more nearest documents are requested than there are in the radius
+  res = env.cmd('FT.SEARCH', 'idx', '@loc:[2.2013 48.2037 1 km]=>{$yield_distance_as: dist}',
+                'SORTBY', 'dist', 'LIMIT', 0, 100, 'RETURN', 1, 'dist', 'DIALECT', 4)
+  full = env.cmd('FT.SEARCH', 'idx', '@loc:[2.2013 48.2037 1 km]=>{$yield_distance_as: dist}',
+                 'SORTBY', 'dist', 'LIMIT', 0, 100, 'RETURN', 1, 'dist', 'WITHCOUNT', 'DIALECT', 4)
+  env.assertEqual(res[1:], full[1:])
+  env.assertEqual(full[0], (len(full) - 1) // 2)
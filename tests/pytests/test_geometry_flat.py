@@ -1,6 +1,7 @@
 from RLTest import Env
 from common import *
 import json
+import math
 
 def array_of_key_value_to_map(res):
   '''
@@ -294,3 +295,100 @@ def testFtInfo(env):
   else:
     # TODO: in cluster - be able to wait for cleaning of the index (would wait for freeing the geoshape index memory)
     env.assertLess(cur_usage, usage)
+
+def testBulkLoad(env):
+  ''' Test that geometries indexed by a scan are bulk loaded into the index '''
+
+  conn = getConnectionByEnv(env)
+  doc_num = 1000
+  for i in range(1, doc_num + 1):
+    conn.execute_command('HSET', f'doc{i}', 'geom', f'POLYGON(({2*i} {2*i}, {2*i} {10+2*i}, {10+2*i} {10+2*i}, {10+2*i} {2*i}, {2*i} {2*i}))')
+
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT').ok()
+  waitForIndex(env, 'idx')
+  assert_index_num_docs(env, 'idx', 'geom', doc_num)
+
+  def check_queries():
+    # documents 1 to 100 span from (2 2) to (210 210)
+    res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', 'POLYGON((0 0, 0 210, 210 210, 210 0, 0 0))', 'NOCONTENT', 'LIMIT', 0, 0, 'DIALECT', 3)
+    env.assertEqual(res[0], 100)
+    res = env.cmd('FT.SEARCH', 'idx', '@geom:[contains $poly]', 'PARAMS', 2, 'poly', 'POINT(1001 1001)', 'NOCONTENT', 'DIALECT', 3)
+    env.assertEqual(toSortedFlatList(res), [5, 'doc496', 'doc497', 'doc498', 'doc499', 'doc500'])
+
+  check_queries()
+  res = to_dict(env.cmd('FT.INFO idx'))
+  env.assertGreaterEqual(float(res['geoshapes_bulk_load_time']), 0)
+
+  # updates after the load go through regular inserts
+  conn.execute_command('HSET', 'doc1', 'geom', 'POLYGON((5000 5000, 5000 5010, 5010 5010, 5010 5000, 5000 5000))')
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', 'POLYGON((0 0, 0 210, 210 210, 210 0, 0 0))', 'NOCONTENT', 'LIMIT', 0, 0, 'DIALECT', 3)
+  env.assertEqual(res[0], 99)
+  conn.execute_command('HSET', 'doc1', 'geom', 'POLYGON((2 2, 2 12, 12 12, 12 2, 2 2))')
+
+  # loading from RDB reindexes the documents with a bulk load as well
+  if not env.isCluster():
+    for _ in env.retry_with_rdb_reload():
+      waitForIndex(env, 'idx')
+      check_queries()
+
+def testIntersectWithFilters(env):
+  ''' Test GEOSHAPE queries combined with other filters, where the candidates that only match the
+      query's bounding rect must be left out '''
+
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT', 'tag', 'TAG').ok()
+  # squares of 10x10 starting at (i, i), all of them within the bounding rect of the triangle below
+  doc_num = 180
+  for i in range(doc_num):
+    conn.execute_command('HSET', f'doc{i}', 'geom', f'POLYGON(({i} {i}, {i} {10+i}, {10+i} {10+i}, {10+i} {i}, {i} {i}))', 'tag', 'even' if i % 2 == 0 else 'odd')
+  triangle = 'POLYGON((0 0, 200 0, 0 200, 0 0))'
+
+  # only the squares which are under the hypotenuse x + y = 200 are within the triangle
+  within = [i for i in range(doc_num) if 2 * (10 + i) <= 200]
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', triangle, 'NOCONTENT', 'LIMIT', 0, doc_num, 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), toSortedFlatList([len(within)] + [f'doc{i}' for i in within]))
+
+  expected = [i for i in within if i % 2 == 1]
+  res = env.cmd('FT.SEARCH', 'idx', '@tag:{odd} @geom:[within $poly]', 'PARAMS', 2, 'poly', triangle, 'NOCONTENT', 'LIMIT', 0, doc_num, 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), toSortedFlatList([len(expected)] + [f'doc{i}' for i in expected]))
+
+  expected = [i for i in range(doc_num) if i % 2 == 0 and i not in within]
+  res = env.cmd('FT.SEARCH', 'idx', '@tag:{even} -@geom:[within $poly]', 'PARAMS', 2, 'poly', triangle, 'NOCONTENT', 'LIMIT', 0, doc_num, 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), toSortedFlatList([len(expected)] + [f'doc{i}' for i in expected]))
+
+def testLargePolygonCovering(env):
+  ''' Test queries against polygons large enough to be covered by a grid of cells, where most
+      candidates are told apart by their cells, and the rest by an exact check '''
+
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT').ok()
+
+  # a star of 100 points, alternating between radius 70 and 100
+  star = [(math.cos(2 * math.pi * i / 100) * (70 if i % 2 else 100),
+           math.sin(2 * math.pi * i / 100) * (70 if i % 2 else 100)) for i in range(100)]
+  star_wkt = 'POLYGON((' + ', '.join(f'{x} {y}' for x, y in star + star[:1]) + '))'
+
+  def inside(x, y):
+    res = False
+    for (x1, y1), (x2, y2) in zip(star, star[1:] + star[:1]):
+      if (y1 > y) != (y2 > y) and x < x1 + (y - y1) * (x2 - x1) / (y2 - y1):
+        res = not res
+    return res
+
+  expected = []
+  for i in range(30):
+    for j in range(30):
+      x, y = -104.5 + 7 * i, -104.5 + 7 * j
+      conn.execute_command('HSET', f'p{i}_{j}', 'geom', f'POINT({x} {y})')
+      if inside(x, y):
+        expected.append(f'p{i}_{j}')
+  conn.execute_command('HSET', 'star', 'geom', star_wkt)
+
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', star_wkt, 'NOCONTENT', 'LIMIT', 0, 1000, 'DIALECT', 3)
+  env.assertEqual(res[0], len(expected) + 1)
+  env.assertEqual(sorted(res[1:]), sorted(expected + ['star']))
+
+  # the star contains the points inside of it, and not the ones in its notches
+  for x, y in [(0.5, 0.5), (60.5, 0.5), (95.5, 0.5), (79.8, 5.0), (85, 85), (150, 0)]:
+    res = env.cmd('FT.SEARCH', 'idx', '@geom:[contains $poly]', 'PARAMS', 2, 'poly', f'POINT({x} {y})', 'NOCONTENT', 'DIALECT', 3)
+    env.assertEqual('star' in res[1:], inside(x, y), message=(x, y))
@@ -3,8 +3,8 @@ from RLTest import Env
 from time import sleep
 
 
-def ft_info_to_dict(env, idx):
-  res = env.execute_command('ft.info', idx)
+def ft_info_to_dict(env, idx, *args):
+  res = env.execute_command('ft.info', idx, *args)
   return {res[i]: res[i + 1] for i in range(0, len(res), 2)}
 
 # The output for this test can be used for recreating documentation for `FT.INFO`
@@ -76,3 +76,133 @@ def test_numeric_info(env):
   env.assertEqual(res3, exp2)  # Numeric field is sortable, and explicitly UNF
   env.assertEqual(res4, exp3)  # Numeric field is sortable, explicitly NOINDEX, and automatically UNF
   env.assertEqual(res5, exp3)  # Numeric field is sortable, explicitly NOINDEX, and explicitly UNF
+
+def testTermExpansionCache(env):
+  # repeated prefix, suffix, contains, wildcard and fuzzy queries are answered from cached
+  # expansions, which must be dropped once the terms of the index change
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  conn.execute_command('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'WITHSUFFIXTRIE', 'u', 'TEXT').ok()
+  conn.execute_command('HSET', 'doc1', 't', 'hello')
+  conn.execute_command('HSET', 'doc2', 't', 'help', 'u', 'help')
+
+  def cache_stats():
+    stats = ft_info_to_dict(env, 'idx')['expansion_cache_stats']
+    return {stats[i]: stats[i + 1] for i in range(0, len(stats), 2)}
+
+  queries = ['hel*', '*lp', '*el*', "w'he?p'", '%helo%', '@u:hel*']
+  def check(expected):
+    for q in queries:
+      for _ in range(2):
+        res = env.cmd('FT.SEARCH', 'idx', q, 'NOCONTENT', 'DIALECT', 2)
+        env.assertEqual(sorted(res[1:]), expected[q], message=q)
+
+  check({'hel*': ['doc1', 'doc2'], '*lp': ['doc2'], '*el*': ['doc1', 'doc2'],
+         "w'he?p'": ['doc2'], '%helo%': ['doc1', 'doc2'], '@u:hel*': ['doc2']})
+  stats = cache_stats()
+  env.assertEqual(stats['misses'], len(queries))
+  env.assertEqual(stats['hits'], len(queries))
+  env.assertEqual(stats['entries'], len(queries))
+
+  # a new term drops the cached expansions
+  conn.execute_command('HSET', 'doc3', 't', 'helm')
+  check({'hel*': ['doc1', 'doc2', 'doc3'], '*lp': ['doc2'], '*el*': ['doc1', 'doc2', 'doc3'],
+         "w'he?p'": ['doc2'], '%helo%': ['doc1', 'doc2', 'doc3'], '@u:hel*': ['doc2']})
+
+  # so does an existing term indexed in another field
+  conn.execute_command('HSET', 'doc4', 'u', 'hello')
+  check({'hel*': ['doc1', 'doc2', 'doc3', 'doc4'], '*lp': ['doc2'], '*el*': ['doc1', 'doc2', 'doc3', 'doc4'],
+         "w'he?p'": ['doc2'], '%helo%': ['doc1', 'doc2', 'doc3', 'doc4'], '@u:hel*': ['doc2', 'doc4']})
+
+  # and a term collected by the gc
+  conn.execute_command('DEL', 'doc3')
+  forceInvokeGC(env, 'idx')
+  check({'hel*': ['doc1', 'doc2', 'doc4'], '*lp': ['doc2'], '*el*': ['doc1', 'doc2', 'doc4'],
+         "w'he?p'": ['doc2'], '%helo%': ['doc1', 'doc2', 'doc4'], '@u:hel*': ['doc2', 'doc4']})
+  env.assertEqual(cache_stats()['misses'], 4 * len(queries))
+
+def testResultCache(env):
+  # repeated queries on an index created with RESULTCACHE are replied from the cache, until the
+  # index or the configuration change or the cached reply expires
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'RESULTCACHE', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+  env.expect('FT.CREATE', 'nocache', 'SCHEMA', 't', 'TEXT').ok()
+  conn.execute_command('HSET', 'doc1', 't', 'hello world', 'n', 1)
+  conn.execute_command('HSET', 'doc2', 't', 'hello there', 'n', 2)
+
+  info = ft_info_to_dict(env, 'idx')
+  env.assertContains('RESULTCACHE', info['index_options'])
+  env.assertFalse('result_cache_stats' in ft_info_to_dict(env, 'nocache'))
+
+  def cache_stats():
+    stats = ft_info_to_dict(env, 'idx')['result_cache_stats']
+    return {stats[i]: stats[i + 1] for i in range(0, len(stats), 2)}
+
+  search = ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'DESC', 'WITHSCORES']
+  aggregate = ['FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC']
+  expected_search = env.cmd(*search)
+  expected_aggregate = env.cmd(*aggregate)
+  env.assertEqual(env.cmd(*search), expected_search)
+  env.assertEqual(env.cmd(*aggregate), expected_aggregate)
+  stats = cache_stats()
+  env.assertEqual(stats['misses'], 2)
+  env.assertEqual(stats['hits'], 2)
+  env.assertEqual(stats['entries'], 2)
+
+  # the same arguments on another command are another query
+  env.assertEqual(env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello')[0][0], 2)
+  env.assertEqual(cache_stats()['hits'], 2)
+
+  # a write to the index drops the cached replies
+  conn.execute_command('HSET', 'doc3', 't', 'hello again', 'n', 3)
+  res = env.cmd(*search)
+  env.assertEqual(res[0], 3)
+  env.assertEqual(res[1], 'doc3')
+  env.assertEqual(env.cmd(*search), res)
+  stats = cache_stats()
+  env.assertEqual(stats['hits'], 3)
+  env.assertEqual(stats['entries'], 1)
+
+  conn.execute_command('DEL', 'doc3')
+  env.assertEqual(env.cmd(*search), expected_search)
+
+  # so does a configuration change
+  env.expect('FT.CONFIG', 'SET', 'MAXSEARCHRESULTS', 1).ok()
+  env.assertNotEqual(env.cmd(*search), expected_search)
+  env.expect('FT.CONFIG', 'SET', 'MAXSEARCHRESULTS', 1000000).ok()
+  env.assertEqual(env.cmd(*search), expected_search)
+
+  # an expired reply is evicted
+  env.expect('FT.CONFIG', 'SET', 'RESULT_CACHE_TTL', 1).ok()
+  env.cmd(*search)
+  sleep(0.01)
+  evictions = cache_stats()['evictions']
+  env.assertEqual(env.cmd(*search), expected_search)
+  env.assertEqual(cache_stats()['evictions'], evictions + 1)
+
+  # errors are never cached
+  env.expect('FT.CONFIG', 'SET', 'RESULT_CACHE_TTL', 10000).ok()
+  hits = cache_stats()['hits']
+  for _ in range(2):
+    env.expect('FT.SEARCH', 'idx', '@missing:hello').error()
+  env.assertEqual(cache_stats()['hits'], hits)
+
+def testInfoSummary(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'v', 'VECTOR', 'FLAT', 6, 'TYPE', 'FLOAT32',
+             'DIM', 2, 'DISTANCE_METRIC', 'L2').ok()
+  for i in range(10):
+    conn.execute_command('HSET', f'doc{i}', 't', f'hello{i}')
+  waitForIndex(env, 'idx')
+
+  full = ft_info_to_dict(env, 'idx')
+  summary = ft_info_to_dict(env, 'idx', 'summary')
+  # the counters only, without the attributes, the sizes which are walked for and the stats
+  env.assertEqual(summary['index_name'], 'idx')
+  for key in ['num_docs', 'max_doc_id', 'num_terms', 'num_records', 'hash_indexing_failures',
+              'indexing', 'percent_indexed']:
+    env.assertEqual(float(summary[key]), float(full[key]), message=key)
+  for key in ['attributes', 'index_definition', 'vector_index_sz_mb', 'gc_stats', 'cursor_stats']:
+    env.assertFalse(key in summary, message=key)
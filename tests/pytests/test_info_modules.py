@@ -125,3 +125,99 @@ def testInfoModulesAfterReload(env):
     env.assertEqual(fieldsInfo['search_fields_numeric'], 'Numeric=1,Sortable=1')
     env.assertEqual(fieldsInfo['search_fields_geo'], 'Geo=1,Sortable=1,NoIndex=1')
     env.assertEqual(fieldsInfo['search_fields_tag'], 'Tag=1,NoIndex=1')
+
+
+@skip(cluster=True)
+def testInfoModulesStemmerCache(env):
+  conn = env.getConnection()
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+  before = info_modules_to_dict(conn)['search_stemmer_cache']
+
+  # the same words are stemmed for every document, and only looked up once in snowball
+  for i in range(600):
+    conn.execute_command('HSET', f'doc{i}', 't', 'running jumping')
+  info = info_modules_to_dict(conn)['search_stemmer_cache']
+  env.assertGreaterEqual(int(info['search_hits']) - int(before['search_hits']), 1000)
+  env.assertLess(int(info['search_misses']) - int(before['search_misses']), 200)
+  env.expect('FT.SEARCH', 'idx', 'run', 'LIMIT', 0, 0).equal([600])
+
+  # the stems are the same without the cache
+  env.expect('FT.CONFIG', 'SET', 'STEM_CACHE_SIZE', 0).ok()
+  conn.execute_command('HSET', 'doc600', 't', 'runs')
+  env.expect('FT.SEARCH', 'idx', 'running', 'LIMIT', 0, 0).equal([601])
+  env.expect('FT.CONFIG', 'SET', 'STEM_CACHE_SIZE', 4096).ok()
+
+
+def testInfoModulesIndexSegments():
+  env = Env(moduleArgs='INDEX_SEGMENTS_DIR /tmp GC_POLICY FORK FORK_GC_CLEAN_THRESHOLD 0')
+  env.skipOnCluster()
+  conn = env.getConnection()
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+  for i in range(1000):
+    conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i)
+
+  # the full blocks are mapped from a segment, and read as before
+  info = info_modules_to_dict(conn)['search_index_segments']
+  env.assertGreater(int(info['search_mapped_bytes']), 0)
+  live = int(info['search_live_bytes'])
+  env.assertGreater(live, 0)
+  env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([1000])
+  env.expect('FT.SEARCH', 'idx', '@n:[100 199]', 'LIMIT', 0, 0).equal([100])
+
+  # the blocks the GC repairs move back to the heap
+  for i in range(0, 1000, 2):
+    conn.execute_command('DEL', f'doc{i}')
+  forceInvokeGC(env, 'idx')
+  info = info_modules_to_dict(conn)['search_index_segments']
+  env.assertLess(int(info['search_live_bytes']), live)
+  env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([500])
+  env.expect('FT.SEARCH', 'idx', '@n:[100 199]', 'LIMIT', 0, 0).equal([50])
+
+  # writing after the GC removed the last blocks
+  for i in range(500, 1000):
+    conn.execute_command('DEL', f'doc{i}')
+  forceInvokeGC(env, 'idx')
+  conn.execute_command('HSET', 'doc1000', 't', 'hello', 'n', 1000)
+  env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([251])
+
+
+@skip(cluster=True)
+def testInfoModulesLatency(env):
+  conn = env.getConnection()
+  env.expect('FT.CONFIG', 'RESETSTAT').ok()
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+  for i in range(100):
+    conn.execute_command('HSET', f'doc{i}', 't', 'hello world', 'n', i)
+  for i in range(10):
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+  env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n')
+  res, cid = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'WITHCURSOR', 'COUNT', 60)
+  env.cmd('FT.CURSOR', 'READ', 'idx', cid)
+
+  stats = to_dict(index_info(env, 'idx')['latency_stats'])
+  for cmd in ['aggregate', 'cursor_read', 'indexing', 'search']:
+    env.assertContains(cmd, stats)
+  search = to_dict(stats['search'])
+  env.assertEqual(sorted(search.keys()), ['execution', 'queue', 'reply', 'total'])
+  total = to_dict(search['total'])
+  env.assertEqual(total['count'], 10)
+  percentiles = [float(total[p]) for p in ['p50', 'p90', 'p99', 'p999']]
+  env.assertEqual(percentiles, sorted(percentiles))
+  env.assertGreater(percentiles[-1], 0)
+  # the first read of a cursor is counted with the aggregations
+  env.assertEqual(to_dict(to_dict(stats['aggregate'])['total'])['count'], 2)
+  env.assertEqual(to_dict(to_dict(stats['cursor_read'])['total'])['count'], 1)
+  env.assertEqual(to_dict(to_dict(stats['indexing'])['total'])['count'], 100)
+
+  info = info_modules_to_dict(conn)['search_latency']
+  env.assertContains('count=10,', info['search_search_total'])
+  env.assertContains('p999=', info['search_search_total'])
+
+  # the stats of the module and of the indexes are reset
+  env.expect('FT.CONFIG', 'RESETSTAT').ok()
+  env.assertFalse('search' in to_dict(index_info(env, 'idx').get('latency_stats', [])))
+  env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+  stats = to_dict(index_info(env, 'idx')['latency_stats'])
+  env.assertEqual(to_dict(to_dict(stats['search'])['total'])['count'], 1)
+  env.assertFalse('aggregate' in stats)
+  env.assertContains('count=1,', info_modules_to_dict(conn)['search_latency']['search_search_total'])
@@ -1155,3 +1155,41 @@ def test_mod5608(env):
         waitForIndex(env, 'idx')
         res = env.execute_command('FT.AGGREGATE', 'idx', "*", 'LOAD', 1, 'num', 'WITHCURSOR', 'MAXIDLE', 1, 'COUNT', 300)
         cursor_id = res[1]
+
+@no_msan
+def testSinglePassFieldExtraction(env):
+    # the values of the fields with simple paths are extracted in a single walk of the document,
+    # they must match the values RedisJSON returns for the same paths
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'JSON', 'SCHEMA',
+               '$.name', 'AS', 'name', 'TEXT',
+               '$.info.city', 'AS', 'city', 'TAG',
+               '$["info"]["zip code"]', 'AS', 'zip', 'TAG',
+               '$.tags[*]', 'AS', 'tags', 'TAG',
+               '$.scores[-1]', 'AS', 'last', 'NUMERIC',
+               '$.scores[0:2]', 'AS', 'first', 'NUMERIC',
+               '$..nick', 'AS', 'nick', 'TAG',
+               '$.*.city', 'AS', 'anycity', 'TAG').ok()
+
+    env.assertOk(conn.execute_command('JSON.SET', 'doc:1', '$', json.dumps({
+        'name': 'alice', 'info': {'city': 'paris', 'zip code': '75001', 'nick': 'al'},
+        'tags': ['a', 'b'], 'scores': [1, 2, 3]})))
+    env.assertOk(conn.execute_command('JSON.SET', 'doc:2', '$', json.dumps({
+        'name': 'bob', 'info': {'city': 'rome'}, 'tags': 'c', 'scores': [4]})))
+
+    env.expect('FT.SEARCH', 'idx', '@name:alice', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@city:{rome}', 'NOCONTENT').equal([1, 'doc:2'])
+    env.expect('FT.SEARCH', 'idx', '@zip:{75001}', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@tags:{b}', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@tags:{c}', 'NOCONTENT').equal([0])
+    env.expect('FT.SEARCH', 'idx', '@last:[3 3]', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@last:[4 4]', 'NOCONTENT').equal([1, 'doc:2'])
+    env.expect('FT.SEARCH', 'idx', '@first:[2 2]', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@nick:{al}', 'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@anycity:{paris}', 'NOCONTENT').equal([1, 'doc:1'])
+
+    # the paths of the fields added to the index are extracted as well
+    env.expect('FT.ALTER', 'idx', 'SCHEMA', 'ADD', '$.info.zip', 'AS', 'zip2', 'TAG').ok()
+    env.assertOk(conn.execute_command('JSON.SET', 'doc:3', '$', json.dumps({'name': 'carol', 'info': {'zip': '10001'}})))
+    env.expect('FT.SEARCH', 'idx', '@zip2:{10001}', 'NOCONTENT').equal([1, 'doc:3'])
+    env.expect('FT.SEARCH', 'idx', '@name:carol', 'NOCONTENT').equal([1, 'doc:3'])
@@ -0,0 +1,57 @@
+from includes import *
+from common import *
+from RLTest import Env
+
+
+def testIsMissing(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'schema', 'n', 'NUMERIC', 'INDEXMISSING',
+               't', 'TAG', 'INDEXMISSING', 'SORTABLE', 'body', 'TEXT').ok()
+    res_info = [['identifier', 'n', 'attribute', 'n', 'type', 'NUMERIC', 'INDEXMISSING'],
+                ['identifier', 't', 'attribute', 't', 'type', 'TAG', 'SEPARATOR', ',', 'SORTABLE',
+                 'INDEXMISSING'],
+                ['identifier', 'body', 'attribute', 'body', 'type', 'TEXT', 'WEIGHT', '1']]
+    assertInfoField(env, 'idx', 'attributes', res_info)
+
+    conn.execute_command('hset', 'doc1', 'n', 1, 't', 'a', 'body', 'hello')
+    conn.execute_command('hset', 'doc2', 'n', 2, 'body', 'hello')
+    conn.execute_command('hset', 'doc3', 't', 'b', 'body', 'world')
+    conn.execute_command('hset', 'doc4', 'body', 'hello')
+
+    def search(q):
+        res = env.cmd('ft.search', 'idx', q, 'NOCONTENT', 'DIALECT', 2)
+        return [res[0]] + sorted(res[1:])
+
+    env.assertEqual(search('ismissing(@n)'), [2, 'doc3', 'doc4'])
+    env.assertEqual(search('-ismissing(@n)'), [2, 'doc1', 'doc2'])
+    env.assertEqual(search('ismissing(@t)'), [2, 'doc2', 'doc4'])
+    env.assertEqual(search('ISMISSING(@t) hello'), [2, 'doc2', 'doc4'])
+    env.assertEqual(search('ismissing(@n) ismissing(@t)'), [1, 'doc4'])
+    env.assertEqual(search('-ismissing(@t) -@t:{b}'), [1, 'doc1'])
+    env.assertEqual(search('ismissing(@n) | @n:[1 1]'), [3, 'doc1', 'doc3', 'doc4'])
+    # not a function call
+    env.assertEqual(search('ismissing'), [0])
+
+    # updates and deletions
+    conn.execute_command('hset', 'doc4', 'n', 4)
+    conn.execute_command('hdel', 'doc1', 'n')
+    conn.execute_command('del', 'doc3')
+    env.assertEqual(search('ismissing(@n)'), [1, 'doc1'])
+    env.assertEqual(search('-ismissing(@n)'), [2, 'doc2', 'doc4'])
+    env.assertEqual(search('ismissing(@t)'), [2, 'doc2', 'doc4'])
+
+    env.expect('ft.search', 'idx', 'ismissing(@body)', 'DIALECT', 2).error() \
+       .contains('`ismissing` requires the field `body` to be INDEXMISSING')
+    env.expect('ft.search', 'idx', 'ismissing(@nosuch)', 'DIALECT', 2).error()
+
+
+def testIsMissingJson(env):
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'on', 'json', 'schema', '$.n', 'as', 'n', 'NUMERIC',
+               'INDEXMISSING').ok()
+    conn.execute_command('json.set', 'doc1', '$', r'{"n": 1}')
+    conn.execute_command('json.set', 'doc2', '$', r'{"n": null}')
+    conn.execute_command('json.set', 'doc3', '$', r'{"m": 1}')
+    waitForIndex(env, 'idx')
+    res = env.cmd('ft.search', 'idx', 'ismissing(@n)', 'NOCONTENT', 'DIALECT', 2)
+    env.assertEqual([res[0]] + sorted(res[1:]), [2, 'doc2', 'doc3'])
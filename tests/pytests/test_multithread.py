@@ -272,3 +272,177 @@ def test_async_updates_sanity():
         # After overwriting 1, there may be another one zombie.
         env.assertLessEqual(marked_deleted_vectors_new, marked_deleted_vectors + 1)
         marked_deleted_vectors = marked_deleted_vectors_new
+
+def testParallelQuery():
+    env = initEnv('WORKER_THREADS 4 MT_MODE MT_MODE_FULL')
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE', 'tag', 'TAG', 'SORTABLE')
+
+    # enough documents for a few partitions (see PARALLEL_PARTITION_MIN_RESULTS)
+    num_docs = 40000
+    with conn.pipeline(transaction=False) as pl:
+        for i in range(num_docs):
+            pl.execute_command('HSET', f'doc{i}', 't', 'hello world' if i % 3 else 'hello there hello',
+                               'n', i, 'tag', f'tag{i % 7}')
+        pl.execute()
+    # leave holes in the docids
+    with conn.pipeline(transaction=False) as pl:
+        for i in range(0, num_docs, 11):
+            pl.execute_command('DEL', f'doc{i}')
+        pl.execute()
+
+    # the results of a query executed in parallel are those of the serial execution
+    for query in ['hello', '*', 'hello -there', 'world|there', '@n:[100 30000]', '-@tag:{tag3}']:
+        args = ['FT.SEARCH', 'idx', query, 'WITHSCORES', 'NOCONTENT', 'LIMIT', 0, 20]
+        env.assertEqual(conn.execute_command(*args, 'PARALLEL', 4), conn.execute_command(*args), message=query)
+
+        args = ['FT.SEARCH', 'idx', query, 'SORTBY', 'n', 'DESC', 'LIMIT', 100, 20]
+        env.assertEqual(conn.execute_command(*args, 'PARALLEL', 4), conn.execute_command(*args), message=query)
+
+        args = ['FT.AGGREGATE', 'idx', query, 'GROUPBY', 1, '@tag',
+                'REDUCE', 'COUNT', 0, 'AS', 'count', 'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+                'SORTBY', 2, '@tag', 'ASC']
+        env.assertEqual(conn.execute_command(*args, 'PARALLEL', 4), conn.execute_command(*args), message=query)
+
+    env.expect('FT.SEARCH', 'idx', 'hello', 'PARALLEL', 0).error().contains('PARALLEL requires an integer')
+    env.expect('FT.SEARCH', 'idx', 'hello', 'PARALLEL', 65).error().contains('PARALLEL requires an integer')
+    env.expect('FT.AGGREGATE', 'idx', 'hello', 'PARALLEL').error().contains('PARALLEL requires an integer')
+
+def testParallelGroupBy():
+    env = initEnv('WORKER_THREADS 4 MT_MODE MT_MODE_FULL')
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 'm', 'NUMERIC', 'SORTABLE',
+            'tag', 'TAG', 'SORTABLE')
+
+    num_docs = 40000
+    with conn.pipeline(transaction=False) as pl:
+        for i in range(num_docs):
+            pl.execute_command('HSET', f'doc{i}', 'n', i, 'm', i % 13, 'tag', f'tag{i % 7}')
+        pl.execute()
+
+    # the groups of every partition are merged into the same groups as those of the serial execution
+    args = ['FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@tag',
+            'REDUCE', 'COUNT', 0, 'AS', 'count',
+            'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+            'REDUCE', 'AVG', 1, '@n', 'AS', 'avg',
+            'REDUCE', 'MIN', 1, '@n', 'AS', 'min',
+            'REDUCE', 'MAX', 1, '@n', 'AS', 'max',
+            'REDUCE', 'COUNT_DISTINCT', 1, '@m', 'AS', 'distinct',
+            'REDUCE', 'COUNT_DISTINCTISH', 1, '@n', 'AS', 'distinctish',
+            'REDUCE', 'TOLIST', 1, '@m', 'AS', 'list',
+            'REDUCE', 'FIRST_VALUE', 1, '@n', 'AS', 'first',
+            'REDUCE', 'FIRST_VALUE', 3, '@n', 'BY', '@m', 'AS', 'first_by',
+            'SORTBY', 2, '@tag', 'ASC']
+    env.assertEqual(conn.execute_command(*args, 'PARALLEL', 4), conn.execute_command(*args))
+
+    # the merged sketches are only as accurate as the serial ones
+    args = ['FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@tag',
+            'REDUCE', 'STDDEV', 1, '@n', 'AS', 'stddev',
+            'REDUCE', 'QUANTILE', 2, '@n', 0.5, 'AS', 'median',
+            'REDUCE', 'RANDOM_SAMPLE', 2, '@n', 10, 'AS', 'sample',
+            'SORTBY', 2, '@tag', 'ASC']
+    serial = conn.execute_command(*args)
+    parallel = conn.execute_command(*args, 'PARALLEL', 4)
+    env.assertEqual(len(parallel), len(serial))
+    for expected, res in zip(serial[1:], parallel[1:]):
+        expected, res = to_dict(expected), to_dict(res)
+        env.assertAlmostEqual(float(res['stddev']), float(expected['stddev']), delta=0.001)
+        env.assertAlmostEqual(float(res['median']), num_docs / 2, delta=num_docs / 50)
+        env.assertEqual(len(res['sample']), 10)
+        tag = int(res['tag'][len('tag'):])
+        for n in res['sample']:
+            env.assertEqual(int(n) % 7, tag)
+
+def testWorkersAdmissionControl():
+    env = initEnv(moduleArgs='WORKER_THREADS 1 MT_MODE MT_MODE_FULL MAX_PENDING_QUERIES 1 WORKERS_QUERY_WEIGHT 3')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'GET', 'WORKERS_QUERY_WEIGHT').equal([['WORKERS_QUERY_WEIGHT', '3']])
+    env.expect('FT.CONFIG', 'GET', 'MAX_PENDING_QUERIES').equal([['MAX_PENDING_QUERIES', '1']])
+    env.expect('FT.CONFIG', 'SET', 'WORKERS_QUERY_WEIGHT', '2').error().contains('Not modifiable at runtime')
+
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE')
+    with conn.pipeline(transaction=False) as pl:
+        for i in range(10000):
+            pl.execute_command('HSET', f'doc{i}', 'n', i)
+        pl.execute()
+
+    # Send the queries from concurrent clients, so that they queue up behind the single worker
+    from threading import Thread
+    num_clients = 20
+    errors = []
+
+    def runner(query):
+        cli = env.getConnection()
+        try:
+            cli.execute_command(*query)
+        except Exception as e:
+            errors.append(str(e))
+
+    def run_clients(query):
+        errors.clear()
+        ths = [Thread(target=runner, args=(query,)) for _ in range(num_clients)]
+        [th.start() for th in ths]
+        [th.join() for th in ths]
+
+    run_clients(['FT.SEARCH', 'idx', '*', 'SORTBY', 'n', 'DESC', 'LIMIT', 0, 1])
+    for e in errors:
+        env.assertContains('Too many queries are waiting for the workers', e)
+    rejected = len(errors)
+
+    # Every query either ran or was rejected, and the queue statistics account for them
+    info = env.cmd('INFO', 'MODULES')
+    env.assertEqual(info['search_query_jobs_rejected'], rejected)
+    env.assertEqual(info['search_query_jobs_started'], num_clients - rejected)
+    env.assertEqual(info['search_query_jobs_pending'], 0)
+    env.assertGreaterEqual(info['search_query_queue_wait_max_us'], info['search_query_queue_wait_avg_us'])
+    env.assertEqual(info['search_vecsim_index_jobs_started'], 0)
+
+    # Without a limit no query is rejected
+    env.expect('FT.CONFIG', 'SET', 'MAX_PENDING_QUERIES', '0').ok()
+    run_clients(['FT.SEARCH', 'idx', '*', 'LIMIT', 0, 0])
+    env.assertEqual(errors, [])
+    env.assertEqual(env.cmd('INFO', 'MODULES')['search_query_jobs_rejected'], rejected)
+
+def testCachedReplyReplayedByWorkers():
+    env = initEnv(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'RESULTCACHE', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    with conn.pipeline(transaction=False) as pl:
+        for i in range(5000):
+            pl.execute_command('HSET', f'doc{i}', 't', f'hello {i}', 'n', i)
+        pl.execute()
+
+    def query_jobs():
+        return env.cmd('INFO', 'MODULES')['search_query_jobs_started']
+
+    # A large cached reply is replayed by a worker
+    query = ['FT.AGGREGATE', 'idx', 'hello', 'LOAD', 2, '@t', '@n', 'SORTBY', 2, '@n', 'ASC',
+             'LIMIT', 0, 5000]
+    expected = env.cmd(*query)
+    jobs = query_jobs()
+    env.assertEqual(env.cmd(*query), expected)
+    env.assertEqual(query_jobs(), jobs + 1)
+
+    # a small one is replayed by the main thread
+    query = ['FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'LIMIT', 0, 1]
+    expected = env.cmd(*query)
+    jobs = query_jobs()
+    env.assertEqual(env.cmd(*query), expected)
+    env.assertEqual(query_jobs(), jobs)
+
+def testWorkersCpuList():
+    env = initEnv(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL WORKERS_CPU_LIST 0')
+    env.skipOnCluster()
+    env.expect('FT.CONFIG', 'GET', 'WORKERS_CPU_LIST').equal([['WORKERS_CPU_LIST', '0']])
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    env.cmd('HSET', 'doc1', 't', 'hello')
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc1'])
+
+    # The workers report the CPUs they are pinned to and the CPU time each of them used
+    info = env.cmd('INFO', 'MODULES')
+    env.assertEqual(str(info['search_workers_cpu_list']), '0')
+    for i in range(2):
+        env.assertGreaterEqual(info[f'search_worker_{i}_cpu_time_us'], 0)
@@ -180,6 +180,36 @@ def testEmptyNumericLeakCenter(env):
     res = env.cmd('FT.SEARCH', 'idx', '@n:[-inf + inf]', 'NOCONTENT')
     env.assertEqual(res[0], docs / 100 + 100)
 
+def testNumericTreeRebalance(env):
+    # the GC merges the leaves it leaves sparse, and keeps the tree balanced
+    env.skipOnCluster()
+    env.expect('FT.CONFIG', 'SET', 'FORK_GC_RUN_INTERVAL', 3600).equal('OK')
+    env.expect('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC')
+
+    docs = 20000
+    for i in range(docs):
+        conn.execute_command('HSET', 'doc{}'.format(i), 'n', i)
+    # keep one document out of 100
+    for i in range(docs):
+        if i % 100:
+            conn.execute_command('DEL', 'doc{}'.format(i))
+
+    before = dump_numeric_index_tree(env, 'idx', 'n')
+    forceInvokeGC(env, 'idx')
+    after = dump_numeric_index_tree(env, 'idx', 'n')
+    env.assertGreater(before['numRanges'], after['numRanges'])
+    env.assertGreater(after['revisionId'], before['revisionId'])
+    depth = dump_numeric_index_tree_root(env, 'idx', 'n')['maxDepth']
+    env.assertLessEqual(depth, 2 * math.ceil(math.log2(after['numRanges'])) + 2)
+
+    res = env.cmd('FT.SEARCH', 'idx', '@n:[-inf +inf]', 'NOCONTENT', 'LIMIT', 0, 0)
+    env.assertEqual(res[0], docs / 100)
+    res = env.cmd('FT.SEARCH', 'idx', '@n:[1000 1999]', 'NOCONTENT', 'SORTBY', 'n')
+    env.assertEqual(res, [10] + ['doc{}'.format(i) for i in range(1000, 2000, 100)])
+
 def testCardinalityCrash(env):
     # this test reproduces crash where cardinality array was cleared on the GC
     env.skipOnCluster()
@@ -197,3 +227,56 @@ def testCardinalityCrash(env):
 
     for i in range(count):
         conn.execute_command('HSET', 'doc{}'.format(i), 'n', format(i))
+
+def testBKDIndexType(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'n', 'NUMERIC', 'INDEXTYPE', 'FOO').error() \
+       .contains('Invalid numeric index type for field `n`')
+
+    env.expect('FT.CREATE', 'bkd', 'PREFIX', 1, 'doc', 'SCHEMA', 'ts', 'NUMERIC', 'INDEXTYPE', 'BKD',
+               'lat', 'NUMERIC', 'INDEXTYPE', 'BKD', 'SORTABLE', 'lon', 'NUMERIC', 'INDEXTYPE', 'BKD').ok()
+    env.expect('FT.CREATE', 'tree', 'PREFIX', 1, 'doc', 'SCHEMA', 'ts', 'NUMERIC',
+               'lat', 'NUMERIC', 'lon', 'NUMERIC').ok()
+    info = index_info(env, 'bkd')
+    env.assertContains('BKD', info['attributes'][0])
+    env.assertContains('SORTABLE', info['attributes'][1])
+
+    # high cardinality timestamps, and coordinates
+    docs = 10000
+    for i in range(docs):
+        conn.execute_command('HSET', f'doc{i}', 'ts', 1600000000000 + i * 7, 'lat', (i * 37) % 180 - 90,
+                             'lon', (i * 53) % 360 - 180)
+    waitForIndex(env, 'bkd')
+    waitForIndex(env, 'tree')
+
+    # boxes over the fields are answered the same by both indexes
+    queries = ['@ts:[1600000000000 1600000035000]', '@ts:[(1600000001000 (1600000069000]',
+               '@lat:[-10 10] @lon:[0 90]', '@ts:[1600000010000 1600000050000] @lat:[0 45] @lon:[-90 0]',
+               '@lat:[100 200]']
+    for q in queries:
+        expected = env.cmd('FT.SEARCH', 'tree', q, 'NOCONTENT', 'LIMIT', 0, docs, 'SORTBY', 'ts')
+        env.assertEqual(env.cmd('FT.SEARCH', 'bkd', q, 'NOCONTENT', 'LIMIT', 0, docs, 'SORTBY', 'ts'), expected,
+                        message=q)
+
+    # and scored the same, though the leaves of the BKD fields are read from their column
+    params = ['NOCONTENT', 'WITHSCORES', 'SCORER', 'TFIDF', 'LIMIT', 0, docs]
+    for q in queries:
+        expected = to_dict(env.cmd('FT.SEARCH', 'tree', q, *params)[1:])
+        env.assertEqual(to_dict(env.cmd('FT.SEARCH', 'bkd', q, *params)[1:]), expected, message=q)
+
+def testSortedColumnScores():
+    # the ranges answered from their sorted column yield the numeric records the postings do
+    env = Env(moduleArgs='NUMERIC_SORTED_COLUMN true')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC')
+    docs = 5000
+    for i in range(docs):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello', 'n', i % 1000)
+
+    params = ['NOCONTENT', 'WITHSCORES', 'SCORER', 'TFIDF', 'LIMIT', 0, docs]
+    everything = to_dict(env.cmd('FT.SEARCH', 'idx', 'hello @n:[-inf +inf]', *params)[1:])
+    res = env.cmd('FT.SEARCH', 'idx', 'hello @n:[(333 666]', *params)
+    env.assertEqual(res[0], 5 * 333)
+    scores = to_dict(res[1:])
+    env.assertEqual(scores, {doc: everything[doc] for doc in scores})
@@ -681,3 +681,79 @@ def testOptimizeArgsDefault():
     # DEFAULT DIALECT 4 and WITHCOUNT explicitly specified ==> WITHCOUNT
     env.assertEqual(conn.execute_command(*query, 'WITHCOUNT'), conn.execute_command(*query, 'WITHCOUNT'))
     env.assertNotEqual(conn.execute_command(*query, 'WITHCOUNT'), conn.execute_command(*query, 'WITHOUTCOUNT'))
+
+def testBlockMaxPruning(env):
+    ''' Test that skipping blocks which cannot beat the top results by BM25STD does not change them '''
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+    words = ['foo', 'bar', 'baz']
+    for i in range(3000):
+        # rare high frequency terms, so most blocks have a low bound
+        doc = ' '.join([w for n, w in enumerate(words) if i % (n + 2) == 0])
+        doc += ' foo' * (5 if i % 397 == 0 else 0) + ' bar' * (8 if i % 991 == 0 else 0)
+        conn.execute_command('HSET', i, 't', doc + ' filler')
+
+    for query in ['foo|bar', 'foo|bar|baz', 'foo bar', '(foo bar)|baz']:
+        for limit in [1, 10, 50]:
+            params = ['SCORER', 'BM25STD', 'WITHSCORES', 'NOCONTENT', 'LIMIT', 0, limit]
+            not_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHCOUNT', *params)
+            opt_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHOUTCOUNT', *params)
+            env.assertEqual(not_res[1:], opt_res[1:], message='%s limit %d' % (query, limit))
+
+def testMaxScorePruning(env):
+    ''' Test that skipping documents which cannot beat the top results by TFIDF does not change them '''
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+    for i in range(3000):
+        # a common term, and rarer ones with higher bounds
+        doc = 'foo' + (' bar' if i % 7 == 0 else '') + (' baz' * 3 if i % 101 == 0 else '')
+        conn.execute_command('HSET', i, 't', doc + ' filler' * (i % 5))
+
+    for query in ['foo|bar', 'foo|bar|baz', 'bar|baz', 'foo|baz']:
+        for limit in [1, 10, 50]:
+            params = ['WITHSCORES', 'NOCONTENT', 'LIMIT', 0, limit]
+            not_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHCOUNT', *params)
+            opt_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHOUTCOUNT', *params)
+            env.assertEqual(not_res[1:], opt_res[1:], message='%s limit %d' % (query, limit))
+
+def testSortIndex(env):
+    ''' Test that reading the documents in the order of a SORTINDEX field does not change the results '''
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'n', 'TEXT', 'SORTINDEX').error() \
+       .contains('SORTINDEX requires the field `n` to be a SORTABLE TEXT or TAG')
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 'SORTINDEX').error()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'name', 'TEXT', 'SORTABLE', 'SORTINDEX',
+               'tag', 'TAG', 'SORTABLE', 'SORTINDEX', 't', 'TEXT').ok()
+
+    def fill(start, end):
+        for i in range(start, end):
+            # repeated values, and some documents without a tag
+            fields = ['name', 'Name%d' % (i * 7 % 500), 't', 'foo' if i % 3 else 'bar']
+            if i % 10:
+                fields += ['tag', 'tag%d' % (i % 37)]
+            conn.execute_command('HSET', 'doc%d' % i, *fields)
+
+    def compare():
+        for query in ['*', 'foo', 'bar', '@tag:{tag1|tag2}', '-@tag:{tag3}']:
+            for sortby in [['name', 'ASC'], ['name', 'DESC'], ['tag', 'ASC'], ['tag', 'DESC']]:
+                for limit in [[0, 1], [0, 10], [5, 20]]:
+                    params = ['NOCONTENT', 'SORTBY', *sortby, 'LIMIT', *limit]
+                    not_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHCOUNT', *params)
+                    opt_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHOUTCOUNT', *params)
+                    env.assertEqual(not_res[1:], opt_res[1:],
+                                    message='%s %s limit %s' % (query, sortby, limit))
+
+    fill(0, 2000)
+    compare()
+    res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'foo', 'SORTBY', 'name', 'LIMIT', 0, 10,
+                  'WITHOUTCOUNT')
+    env.assertContains('SORT-INDEX', str(res))
+
+    # the order is extended with the documents added since, and skips the deleted ones
+    fill(1500, 2500)
+    for i in range(0, 2500, 3):
+        conn.execute_command('DEL', 'doc%d' % i)
+    compare()
@@ -106,3 +106,14 @@ def testIssue1313(env):
 
     env.expect('FT.CREATE test1 ON HASH SCHEMA topic TEXT PHONETIC dm:en topic2 TEXT NOINDEX').ok()
     env.expect('FT.SEARCH', 'test1', '@topic:(tmp)=>{$phonetic: true}').equal([0])
+
+def testPhoneticCodesAreNotTerms(env):
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH',
+                         'schema', 'text', 'TEXT', 'PHONETIC', 'dm:en'))
+    env.assertOk(env.cmd('ft.add', 'idx', 'doc1', 1.0, 'fields', 'text', 'morfix'))
+
+    # the codes are kept apart from the terms
+    terms = env.cmd('ft.debug', 'dump_terms', 'idx')
+    env.assertTrue('morfix' in terms)
+    env.assertFalse(any(t.startswith('<') for t in terms))
+    env.assertEquals(env.cmd('ft.search', 'idx', 'morphix', 'NOCONTENT'), [1, 'doc1'])
@@ -0,0 +1,64 @@
+# -*- coding: utf-8 -*-
+
+from includes import *
+from common import *
+from RLTest import Env
+
+
+def setupIndex(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'g', 'TAG').ok()
+    for i in range(10):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello world' if i % 2 else 'hello',
+                             'n', i, 'g', 'even' if i % 2 == 0 else 'odd')
+    return conn
+
+
+def testPrepareExecute(env):
+    setupIndex(env)
+
+    env.expect('FT.PREPARE', 'q1', 'idx', '@n:[$min $max] @g:{$tag}', 'NOCONTENT',
+               'SORTBY', 'n', 'DIALECT', 2).ok()
+    env.expect('FT.EXECUTE', 'q1', 'PARAMS', 6, 'min', 2, 'max', 7, 'tag', 'even') \
+       .equal([2, 'doc2', 'doc4', 'doc6'])
+    # the same prepared query with other values
+    env.expect('FT.EXECUTE', 'q1', 'PARAMS', 6, 'min', 0, 'max', 3, 'tag', 'odd') \
+       .equal([2, 'doc1', 'doc3'])
+    # executed as the FT.SEARCH it stands for
+    env.expect('FT.EXECUTE', 'q1', 'PARAMS', 6, 'min', 2, 'max', 7, 'tag', 'even').equal(
+        env.cmd('FT.SEARCH', 'idx', '@n:[$min $max] @g:{$tag}', 'NOCONTENT', 'SORTBY', 'n',
+                'PARAMS', 6, 'min', 2, 'max', 7, 'tag', 'even', 'DIALECT', 2))
+
+    # a query without params
+    env.expect('FT.PREPARE', 'q2', 'idx', 'world', 'NOCONTENT', 'SORTBY', 'n').ok()
+    env.expect('FT.EXECUTE', 'q2').equal([5, 'doc1', 'doc3', 'doc5', 'doc7', 'doc9'])
+
+    # preparing under the same name replaces the query
+    env.expect('FT.PREPARE', 'q2', 'idx', '@n:[$n $n]', 'NOCONTENT', 'DIALECT', 2).ok()
+    env.expect('FT.EXECUTE', 'q2', 'PARAMS', 2, 'n', 4).equal([1, 'doc4'])
+
+    env.expect('FT.DEALLOCATE', 'q2').equal(1)
+    env.expect('FT.DEALLOCATE', 'q2').equal(0)
+    env.expect('FT.EXECUTE', 'q2').error().contains('q2: no such prepared query')
+    env.expect('FT.EXECUTE', 'q1', 'PARAMS', 6, 'min', 2, 'max', 7, 'tag', 'even') \
+       .equal([2, 'doc2', 'doc4', 'doc6'])
+
+
+def testPrepareErrors(env):
+    setupIndex(env)
+
+    env.expect('FT.PREPARE', 'q', 'idx').error().contains('wrong number of arguments')
+    env.expect('FT.PREPARE', 'q', 'nosuchidx', 'hello').error().contains('nosuchidx: no such index')
+    # the query is parsed when it is prepared
+    env.expect('FT.PREPARE', 'q', 'idx', '@n:[1', 'DIALECT', 2).error().contains('Syntax error')
+    env.expect('FT.PREPARE', 'q', 'idx', 'hello', 'NOSUCHOPTION').error()
+    env.expect('FT.PREPARE', 'q', 'idx', '@n:[$n $n]', 'PARAMS', 2, 'n', 1, 'DIALECT', 2) \
+       .error().contains('PARAMS are given to FT.EXECUTE')
+    env.expect('FT.DEALLOCATE', 'q').equal(0)
+
+    env.expect('FT.PREPARE', 'q', 'idx', '@n:[$n $n]', 'DIALECT', 2).ok()
+    env.expect('FT.EXECUTE').error().contains('wrong number of arguments')
+    env.expect('FT.EXECUTE', 'q', 'LIMIT', 0, 1).error().contains('expected PARAMS')
+    # the params are bound when the query is executed
+    env.expect('FT.EXECUTE', 'q').error().contains('No such parameter')
+    env.expect('FT.DEALLOCATE').error().contains('wrong number of arguments')
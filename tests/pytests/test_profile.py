@@ -211,6 +211,20 @@ def testProfileTag(env):
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '@t:{foo}', 'nocontent')
   env.assertEqual(actual_res[1][3], ['Iterators profile', ['Type', 'TAG', 'Term', 'foo', 'Counter', 2, 'Size', 2]])
 
+VECTOR_STATS = ['Batch results', 'Distances computed', 'Filter pass rate']
+
+def vector_stats(profile):
+  return {key: profile[profile.index(key) + 1] for key in VECTOR_STATS if key in profile}
+
+def without_vector_stats(iterators_profile):
+  # The stats of the vector iterator which depend on the vector index are checked on their own
+  profile = list(iterators_profile[1])
+  for key in VECTOR_STATS:
+    if key in profile:
+      i = profile.index(key)
+      del profile[i:i + 2]
+  return [iterators_profile[0], profile]
+
 def testProfileVector(env):
   env.skipOnCluster()
   conn = getConnectionByEnv(env)
@@ -229,7 +243,7 @@ def testProfileVector(env):
   expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 3]]
   expected_vecsim_rp_res = ['Type', 'Metrics Applier', 'Counter', 3]
   env.assertEqual(actual_res[0], [3, '4', '2', '1'])
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(actual_res[1][4][2], expected_vecsim_rp_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'STANDARD_KNN')
 
@@ -239,7 +253,7 @@ def testProfileVector(env):
   expected_iterators_res = ['Iterators profile', ['Type', 'METRIC - VECTOR DISTANCE', 'Counter', 2]]
   expected_vecsim_rp_res = ['Type', 'Metrics Applier', 'Counter', 2]
   env.assertEqual(actual_res[0], [2, '4', '2'])
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(actual_res[1][4][2], expected_vecsim_rp_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'RANGE_QUERY')
 
@@ -247,13 +261,17 @@ def testProfileVector(env):
   # Expect ad-hoc BF to take place - going over child iterator exactly once (reading 2 results)
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello world)=>[KNN 3 @v $vec]',
                                     'SORTBY', '__v_score', 'PARAMS', '2', 'vec', 'aaaaaaaa', 'nocontent')
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 2, 'Child iterator',
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 2, 'Hybrid policy', 'HYBRID_ADHOC_BF', 'Child iterator',
                                                  ['Type', 'INTERSECT', 'Counter', 2, 'Child iterators',
                                                  ['Type', 'TEXT', 'Term', 'world', 'Counter', 2, 'Size', 2],
                                                  ['Type', 'TEXT', 'Term', 'hello', 'Counter', 2, 'Size', 5]]]]
   expected_vecsim_rp_res = ['Type', 'Metrics Applier', 'Counter', 2]
   env.assertEqual(actual_res[0], [2, '4', '5'])
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  # The distances of the 2 results of the filter were measured, out of the 5 vectors
+  stats = vector_stats(actual_res[1][3][1])
+  env.assertEqual(stats['Distances computed'], 2)
+  env.assertAlmostEqual(float(stats['Filter pass rate']), 0.4, 1e-6)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(actual_res[1][4][2], expected_vecsim_rp_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_ADHOC_BF')
 
@@ -265,12 +283,16 @@ def testProfileVector(env):
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello world)=>[KNN 3 @v $vec]',
                                     'SORTBY', '__v_score', 'PARAMS', '2', 'vec', 'aaaaaaaa', 'nocontent')
   env.assertEqual(actual_res[0], [3, '4', '6', '7'])
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 3, 'Batches number', 2, 'Child iterator',
+  # 6 batch results, out of which 4, 6 and 7 passed the filter until there were 3 of them
+  stats = vector_stats(actual_res[1][3][1])
+  env.assertEqual(stats['Batch results'], 6)
+  env.assertAlmostEqual(float(stats['Filter pass rate']), 0.5, 1e-6)
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 3, 'Hybrid policy', 'HYBRID_BATCHES', 'Batches number', 2, 'Child iterator',
                                                  ['Type', 'INTERSECT', 'Counter', 8, 'Child iterators',
                                                  ['Type', 'TEXT', 'Term', 'world', 'Counter', 8, 'Size', 9997],
                                                  ['Type', 'TEXT', 'Term', 'hello', 'Counter', 8, 'Size', 10000]]]]
   expected_vecsim_rp_res = ['Type', 'Metrics Applier', 'Counter', 3]
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(actual_res[1][4][2], expected_vecsim_rp_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES')
 
@@ -280,13 +302,13 @@ def testProfileVector(env):
 
   # expected results that pass the filter is index_size/2. after two iterations with no results,
   # we should move ad-hoc BF.
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Batches number', 2, 'Child iterator',
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_BATCHES_TO_ADHOC_BF', 'Batches number', 2, 'Child iterator',
                                                   ['Type', 'INTERSECT', 'Counter', 2, 'Child iterators',
                                                    ['Type', 'TEXT', 'Term', 'hello', 'Counter', 5, 'Size', 10000],
                                                    ['Type', 'TEXT', 'Term', 'other', 'Counter', 3, 'Size', 10000]]]]
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 3 @v $vec]',
                                       'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent')
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES_TO_ADHOC_BF')
 
   # Ask explicitly to run in batches mode, without asking for a certain batch size.
@@ -294,22 +316,22 @@ def testProfileVector(env):
   # index after the 13th batch.
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 2 @v $vec HYBRID_POLICY BATCHES]',
                                     'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent')
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Batches number', 13, 'Child iterator',
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_BATCHES', 'Batches number', 13, 'Child iterator',
                                                    ['Type', 'INTERSECT', 'Counter', 12, 'Child iterators',
                                                     ['Type', 'TEXT', 'Term', 'hello', 'Counter', 25, 'Size', 10000],
                                                     ['Type', 'TEXT', 'Term', 'other', 'Counter', 13, 'Size', 10000]]]]
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES')
 
   # Ask explicitly to run in batches mode, with batch size of 100.
   # After 200 iterations, we should go over the entire index.
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 2 @v $vec HYBRID_POLICY BATCHES BATCH_SIZE 100]',
                                     'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent', 'timeout', '100000')
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Batches number', 200, 'Child iterator',
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_BATCHES', 'Batches number', 200, 'Child iterator',
                                                   ['Type', 'INTERSECT', 'Counter', 199, 'Child iterators',
                                                    ['Type', 'TEXT', 'Term', 'hello', 'Counter', 399, 'Size', 10000],
                                                    ['Type', 'TEXT', 'Term', 'other', 'Counter', 200, 'Size', 10000]]]]
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES')
 
   # Asking only for a batch size without asking for batches policy. While batchs mode is on, the bacth size will be as
@@ -318,13 +340,27 @@ def testProfileVector(env):
   # every iteration that returned 0 results.
   actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 2 @v $vec BATCH_SIZE 100]',
                                     'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent')
-  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Batches number', 2, 'Child iterator',
+  expected_iterators_res = ['Iterators profile', ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_BATCHES_TO_ADHOC_BF', 'Batches number', 2, 'Child iterator',
                                                   ['Type', 'INTERSECT', 'Counter', 2, 'Child iterators',
                                                    ['Type', 'TEXT', 'Term', 'hello', 'Counter', 5, 'Size', 10000],
                                                    ['Type', 'TEXT', 'Term', 'other', 'Counter', 3, 'Size', 10000]]]]
-  env.assertEqual(actual_res[1][3], expected_iterators_res)
+  env.assertEqual(without_vector_stats(actual_res[1][3]), expected_iterators_res)
   env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES_TO_ADHOC_BF')
 
+  # No result passed the filter in the batches of the first query without an explicit policy, so the
+  # same query goes to ad-hoc BF right away as long as the index is not written to.
+  actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 3 @v $vec]',
+                                    'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent')
+  env.assertEqual(actual_res[1][3][1][:8], ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_ADHOC_BF',
+                                           'Filter history', 'applied'])
+  env.assertEqual(to_dict(env.cmd("FT.DEBUG", "VECSIM_INFO", "idx", "v"))['LAST_SEARCH_MODE'], 'HYBRID_ADHOC_BF')
+
+  # A write to the index drops the history of its filters
+  conn.execute_command('hset', '20001', 'v', '????????', 't', "other")
+  actual_res = conn.execute_command('ft.profile', 'idx', 'search', 'query', '(@t:hello other)=>[KNN 3 @v $vec]',
+                                    'SORTBY', '__v_score', 'PARAMS', '2', 'vec', '????????', 'nocontent')
+  env.assertEqual(actual_res[1][3][1][:6], ['Type', 'VECTOR', 'Counter', 0, 'Hybrid policy', 'HYBRID_BATCHES_TO_ADHOC_BF'])
+
 
 def testResultProcessorCounter(env):
   env.skipOnCluster()
@@ -384,3 +420,87 @@ def testNotIterator(env):
             'Loader', 'Counter', 1]]]]
 
   env.expect('ft.profile', 'idx', 'search', 'query', 'foo -@t:baz').equal(res)
+
+def testProfileCriteriaTesters(env):
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC')
+  env.cmd('FT.CREATE', 'idx_sortable', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE')
+  for i in range(2000):
+    conn.execute_command('HSET', i, 't', 'rare' if i % 200 == 0 else 'common', 'n', i % 100)
+
+  params = ['NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, 100]
+  expected = env.cmd('FT.SEARCH', 'idx', 'rare @n:[0 90]', *params)
+  env.assertEqual(expected[0], 10)
+
+  # the broad numeric union of an unscored query is tested against the documents of the selective term
+  env.expect('FT.SEARCH', 'idx_sortable', 'rare @n:[0 90]', *params).equal(expected)
+  res = env.cmd('FT.PROFILE', 'idx_sortable', 'SEARCH', 'QUERY', 'rare @n:[0 90]', *params)
+  env.assertEqual(res[1][3], ['Iterators profile',
+                              ['Type', 'INTERSECT', 'Counter', 10,
+                               'Strategy', 'Criteria testers', 'Tested children', 1,
+                               'Child iterators',
+                                 ['Type', 'TEXT', 'Term', 'rare', 'Counter', 10, 'Size', 10]]])
+
+  # documents failing the tested filter are left out
+  env.expect('FT.SEARCH', 'idx_sortable', 'rare @n:[1 90]', 'NOCONTENT').equal([0])
+
+  # without a sortable field the children are intersected
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'rare @n:[0 90]', *params)
+  env.assertNotContains('Strategy', res[1][3][1])
+
+  # the numeric records of a scored query count in its scores, so its children are intersected
+  res = env.cmd('FT.PROFILE', 'idx_sortable', 'SEARCH', 'QUERY', 'rare @n:[0 90]', 'NOCONTENT')
+  env.assertNotContains('Strategy', res[1][3][1])
+  params = ['NOCONTENT', 'WITHSCORES', 'SCORER', 'TFIDF', 'LIMIT', 0, 100]
+  scored = env.cmd('FT.SEARCH', 'idx_sortable', 'rare @n:[0 90]', *params)
+  env.assertEqual(to_dict(scored[1:]), to_dict(env.cmd('FT.SEARCH', 'idx', 'rare @n:[0 90]', *params)[1:]))
+
+def testProfileIndexLock(env):
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+  for i in range(100):
+    conn.execute_command('HSET', i, 't', 'hello')
+
+  # the holds of the spec lock are reported along with the profile clock
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello', 'NOCONTENT')
+  env.assertEqual(res[1][5][0:2], ['Index lock yields', 0])
+  env.assertEqual(res[1][6][0], 'Index lock hold time')
+  env.assertGreaterEqual(float(res[1][6][1]), 0)
+
+  env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello', 'NOCONTENT')
+  env.assertEqual(len(res[1]), 5)
+  env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'true')
+
+def testProfileWorkCounters(env):
+  env.skipOnCluster()
+  conn = getConnectionByEnv(env)
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+  for i in range(100):
+    conn.execute_command('HSET', i, 't', 'hello world' if i % 10 == 0 else 'hello')
+
+  # the work of the iterators is reported along with the profile clock
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello world', 'NOCONTENT')
+  env.assertEqual(res[0][0], 10)
+  intersect = res[1][3][1]
+  skipTos = 0
+  for child in intersect[intersect.index('Child iterators') + 1:]:
+    child = to_dict(child)
+    env.assertLessEqual(child['SkipTo hits'], child['SkipTo calls'])
+    env.assertGreaterEqual(child['Blocks read'], 1)
+    env.assertGreater(child['Bytes read'], 0)
+    env.assertEqual(child['Filtered records'], 0)
+    skipTos += child['SkipTo calls']
+  env.assertGreater(skipTos, 0)
+
+  # and the documents looked up by the index processor
+  index = to_dict(res[1][4][1])
+  env.assertEqual(index['Document lookups'], 10)
+
+  env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello', 'NOCONTENT')
+  env.assertEqual(res[1][3], ['Iterators profile', ['Type', 'TEXT', 'Term', 'hello', 'Counter', 100, 'Size', 100]])
+  env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'true')
@@ -309,3 +309,29 @@ def expireDocs(isSortable, iter1_expected_without_sortby, iter1_expected_with_so
 
         master.execute_command('FLUSHALL')
         env.expect('WAIT', '1', '10000').equal(1)
+
+def testFullSyncRestoresIndexes():
+  env = initEnv(skip=False)
+  master = env.getConnection()
+  slave = env.getSlaveConnection()
+  env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'true').ok()
+  env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'tg', 'TAG').ok()
+  for i in range(100):
+    master.execute_command('HSET', 'doc%d' % i, 't', 'hello', 'n', i, 'tg', 'tag%d' % (i % 2))
+
+  # diverge the replica from its primary, so that it syncs again in full
+  slave.execute_command('REPLICAOF', 'NO', 'ONE')
+  slave.execute_command('FLUSHALL')
+  slave.execute_command('SET', 'diverged', '1')
+  slave.execute_command('REPLICAOF', '127.0.0.1', master.execute_command('CONFIG', 'GET', 'port')[1])
+  checkSlaveSynced(env, slave, ('EXISTS', 'diverged'), 0, time_out=20)
+  env.expect('WAIT', '1', '10000').equal(1)
+
+  # the replica restored the index rather than reindexing it, and indexes the writes that follow
+  info = slave.execute_command('INFO', 'search_index_persistence')
+  env.assertGreaterEqual(info['search_restored_indexes'], 1)
+  env.assertGreaterEqual(info['search_restored_documents'], 100)
+  env.assertEqual(slave.execute_command('FT.SEARCH', 'idx', '@n:[10 19] @tg:{tag0}', 'NOCONTENT', 'LIMIT', 0, 0), [5])
+  master.execute_command('HSET', 'doc100', 't', 'hello there')
+  checkSlaveSynced(env, slave, ('FT.SEARCH', 'idx', 'there', 'NOCONTENT'), [1, 'doc100'], time_out=20)
+  env.expect('FT.CONFIG', 'SET', 'PERSIST_INDEXES', 'false').ok()
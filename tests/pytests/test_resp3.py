@@ -196,7 +196,9 @@ def test_profile(env):
           {'Type': 'Scorer', 'Time': ANY, 'Counter': 2},
           {'Type': 'Sorter', 'Time': ANY, 'Counter': 2},
           {'Type': 'Loader', 'Time': ANY, 'Counter': 2}
-        ]
+        ],
+        'Index lock yields': 0,
+        'Index lock hold time': ANY
       }
     }
     env.expect('FT.PROFILE', 'idx1', 'SEARCH', 'QUERY', '*', "FORMAT", "STRING").equal(exp)
@@ -232,19 +234,22 @@ def test_coord_profile():
                       'Result processors profile': [{'Type': 'Index', 'Time': ANY, 'Counter': ANY},
                                                     {'Type': 'Scorer', 'Time': ANY, 'Counter': ANY},
                                                     {'Type': 'Sorter', 'Time': ANY, 'Counter': ANY},
-                                                    {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}]},
+                                                    {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}],
+                     'Index lock yields': ANY, 'Index lock hold time': ANY},
         'Shard #2': {'Total profile time': ANY, 'Parsing time': ANY, 'Pipeline creation time': ANY,
                      'Iterators profile': [{'Type': 'WILDCARD', 'Time': ANY, 'Counter': ANY}],
                      'Result processors profile': [{'Type': 'Index', 'Time': ANY, 'Counter': ANY},
                                                    {'Type': 'Scorer', 'Time': ANY, 'Counter': ANY},
                                                    {'Type': 'Sorter', 'Time': ANY, 'Counter': ANY},
-                                                   {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}]},
+                                                   {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}],
+                     'Index lock yields': ANY, 'Index lock hold time': ANY},
         'Shard #3': {'Total profile time': ANY, 'Parsing time': ANY, 'Pipeline creation time': ANY,
                      'Iterators profile': [{'Type': 'WILDCARD', 'Time': ANY, 'Counter': ANY}],
                      'Result processors profile': [{'Type': 'Index', 'Time': ANY, 'Counter': ANY},
                                                    {'Type': 'Scorer', 'Time': ANY, 'Counter': ANY},
                                                    {'Type': 'Sorter', 'Time': ANY, 'Counter': ANY},
-                                                   {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}]},
+                                                   {'Type': 'Loader', 'Time': ANY, 'Counter': ANY}],
+                     'Index lock yields': ANY, 'Index lock hold time': ANY},
         'Coordinator': {'Total Coordinator time': ANY, 'Post Proccessing time': ANY}}}
     res = env.cmd('FT.PROFILE', 'idx1', 'SEARCH', 'QUERY', '*', 'FORMAT', 'STRING')
     res['results'].sort(key=lambda x: "" if x['extra_attributes'].get('f1') == None else x['extra_attributes']['f1'])
@@ -397,6 +402,7 @@ def test_info():
       'cursor_stats': {'global_idle': 0, 'global_total': 0, 'index_capacity': ANY, 'index_total': 0},
       'dialect_stats': {'dialect_1': 0, 'dialect_2': 0, 'dialect_3': 0, 'dialect_4': 0},
       'doc_table_size_mb': ANY,
+      'expansion_cache_stats': {'entries': 0, 'hits': 0, 'misses': 0, 'size_mb': 0.0},
       'gc_stats': ANY,
       'hash_indexing_failures': 0,
       'index_definition': {'default_score': 1.0, 'key_type': 'HASH', 'prefixes': ['doc'] },
@@ -554,7 +560,10 @@ def test_clusterinfo(env):
             { 'host': '127.0.0.1',
               'id': ANY,
               'port': ANY,
-              'role': 'master self'
+              'role': 'master self',
+              'inflight': ANY,
+              'queued': ANY,
+              'latency_ms': ANY
             }
           ],
           'start': 0
@@ -564,7 +573,10 @@ def test_clusterinfo(env):
             {'host': '127.0.0.1',
              'id': ANY,
              'port': ANY,
-             'role': 'master '}
+             'role': 'master ',
+             'inflight': ANY,
+             'queued': ANY,
+             'latency_ms': ANY}
           ],
           'start': 5462
         },
@@ -573,7 +585,10 @@ def test_clusterinfo(env):
             { 'host': '127.0.0.1',
               'id': ANY,
               'port': ANY,
-              'role': 'master '
+              'role': 'master ',
+              'inflight': ANY,
+              'queued': ANY,
+              'latency_ms': ANY
             }
           ],
           'start': 10924
@@ -626,6 +641,8 @@ def test_profile_crash_mod5323():
           { 'Counter': 3, 'Time': ANY, 'Type': 'Scorer' },
           { 'Counter': 3, 'Time': ANY, 'Type': 'Sorter' }
         ],
+        'Index lock yields': 0,
+        'Index lock hold time': ANY,
         'Total profile time': ANY
        },
        'results': [
@@ -669,6 +686,8 @@ def test_profile_child_itrerators_array():
           {'Counter': 2, 'Time': ANY, 'Type': 'Scorer'},
           {'Counter': 2, 'Time': ANY, 'Type': 'Sorter'}
         ],
+        'Index lock yields': 0,
+        'Index lock hold time': ANY,
         'Total profile time': ANY
       },
       'results': [
@@ -704,6 +723,8 @@ def test_profile_child_itrerators_array():
           { 'Counter': 0, 'Time': 0.0, 'Type': 'Scorer'},
           {'Counter': 0, 'Time': 0.0, 'Type': 'Sorter'}
         ],
+        'Index lock yields': 0,
+        'Index lock hold time': ANY,
         'Total profile time': 0.0
       },
       'results': [],
@@ -1169,9 +1190,24 @@ def test_ft_info():
         'gc_stats': {
           'average_cycle_time_ms': nan,
           'bytes_collected': 0.0,
+          'cold_block_cache_hit_ratio': ANY,
+          'cold_block_sweeps': 0.0,
+          'cold_blocks': 0.0,
+          'cold_blocks_bytes': 0.0,
+          'cold_blocks_frozen': 0.0,
+          'cold_blocks_inflated_bytes': 0.0,
+          'docids_compaction_segments': 0.0,
+          'docids_compactions': 0.0,
+          'docids_reclaimed': 0.0,
           'gc_blocks_denied': 0.0,
+          'gc_blocks_merged': 0.0,
           'gc_numeric_trees_missed': 0.0,
+          'gc_terms_removed': 0.0,
           'last_run_time_ms': 0.0,
+          'retention_blocks_dropped': 0.0,
+          'retention_bytes_dropped': 0.0,
+          'retention_drops': 0.0,
+          'retention_records_dropped': 0.0,
           'total_cycles': 0.0,
           'total_ms_run': 0.0
         },
@@ -0,0 +1,118 @@
+# -*- coding: utf-8 -*-
+
+from includes import *
+from common import *
+from RLTest import Env
+
+
+def setupSlowLog(env, threshold=0, sample=1):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', threshold).ok()
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_PLAN_SAMPLE', sample).ok()
+    env.expect('FT.SLOWLOG', 'RESET').ok()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    for i in range(10):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello world' if i % 2 else 'hello', 'n', i)
+    return conn
+
+
+@skip(cluster=True)
+def testSlowLogEntry(env):
+    setupSlowLog(env)
+
+    env.expect('FT.SEARCH', 'idx', 'hello  world @n:[1   8]', 'NOCONTENT').noError()
+    env.expect('FT.SLOWLOG', 'LEN').equal(1)
+
+    entry = to_dict(env.cmd('FT.SLOWLOG', 'GET')[0])
+    env.assertEqual(entry['index'], 'idx')
+    env.assertEqual(entry['query'], 'hello world @n:[? ?]')
+    env.assertEqual(entry['dialect'], 1)
+    env.assertEqual(entry['results'], 4)
+    env.assertEqual(entry['timed_out'], 0)
+    for t in ['parse_time', 'pipeline_time', 'execution_time', 'total_time']:
+        env.assertGreaterEqual(float(entry[t]), 0)
+    env.assertGreaterEqual(float(entry['total_time']), float(entry['parse_time']))
+
+    # the plan of a sampled query has the actual results of its iterators
+    plan = entry['plan']
+    env.assertTrue(plan.startswith('INTERSECT est='), message=plan)
+    env.assertContains('TEXT:hello est=10 act=', plan)
+    env.assertContains('TEXT:world est=5 act=', plan)
+    env.assertContains('NUMERIC:', plan)
+
+
+@skip(cluster=True)
+def testSlowLogNormalizeQuery(env):
+    setupSlowLog(env)
+
+    env.cmd('FT.SEARCH', 'idx', '"hello world"', 'NOCONTENT')
+    env.cmd('FT.SEARCH', 'idx', '@n:[-1.5 30] -world', 'NOCONTENT')
+    env.cmd('FT.AGGREGATE', 'idx', 'hello2 @n:[(1 inf]')
+    res = [to_dict(e)['query'] for e in env.cmd('FT.SLOWLOG', 'GET')]
+    env.assertEqual(res, ['hello2 @n:[(? inf]', '@n:[? ?] -world', '"?"'])
+
+
+@skip(cluster=True)
+def testSlowLogCommand(env):
+    setupSlowLog(env)
+
+    for i in range(5):
+        env.cmd('FT.SEARCH', 'idx', f'hello @n:[{i} 10]', 'NOCONTENT')
+    env.expect('FT.SLOWLOG', 'LEN').equal(5)
+
+    # the latest entries first
+    res = env.cmd('FT.SLOWLOG', 'GET', 2)
+    env.assertEqual(len(res), 2)
+    ids = [to_dict(e)['id'] for e in res]
+    env.assertEqual(ids[0], ids[1] + 1)
+    env.assertEqual(len(env.cmd('FT.SLOWLOG', 'GET', 100)), 5)
+    env.assertEqual(env.cmd('FT.SLOWLOG', 'GET', 0), [])
+
+    # the log keeps the latest SLOWLOG_MAX_LEN entries
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_MAX_LEN', 3).ok()
+    env.expect('FT.SLOWLOG', 'LEN').equal(3)
+    env.assertEqual([to_dict(e)['id'] for e in env.cmd('FT.SLOWLOG', 'GET')][0], ids[0])
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    env.expect('FT.SLOWLOG', 'LEN').equal(3)
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_MAX_LEN', 128).ok()
+
+    env.expect('FT.SLOWLOG', 'RESET').ok()
+    env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+    env.expect('FT.SLOWLOG').error()
+    env.expect('FT.SLOWLOG', 'GET', -1).error().contains('Bad count')
+    env.expect('FT.SLOWLOG', 'LEN', 1).error()
+    env.expect('FT.SLOWLOG', 'FOO').error().contains('Unknown subcommand')
+
+
+@skip(cluster=True)
+def testSlowLogThreshold(env):
+    setupSlowLog(env, threshold=-1, sample=0)
+
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+    # fast queries are not logged
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', 100000).ok()
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+    # nor are profiled ones
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', 0).ok()
+    env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello', 'NOCONTENT')
+    env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+    # without sampling, the plan only has the estimates
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT')
+    env.assertEqual(to_dict(env.cmd('FT.SLOWLOG', 'GET')[0])['plan'], 'TEXT:hello est=10')
+
+    # a cursor is logged once it is depleted, with the time of all of its reads
+    env.expect('FT.SLOWLOG', 'RESET').ok()
+    res, cid = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 4)
+    while cid:
+        env.expect('FT.SLOWLOG', 'LEN').equal(0)
+        res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', cid)
+    env.expect('FT.SLOWLOG', 'LEN').equal(1)
+
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_THRESHOLD', 100).ok()
+    env.expect('FT.CONFIG', 'SET', 'SLOWLOG_PLAN_SAMPLE', 100).ok()
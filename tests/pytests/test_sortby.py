@@ -171,3 +171,74 @@ def testSortby(env):
     compare_asc_desc(env, ['ft.search', 'idx', 'foo @n:[-inf inf]', 'SORTBY', 'n'], params)
     compare_asc_desc(env, ['ft.search', 'idx', '@n:[-inf inf]', 'SORTBY', 'n'], params)
 
+
+
+@skip(cluster=True)
+def testSortbyNumericKeys(env):
+    # numeric sort keys are ordered as the other keys: missing values last, and ties by document id
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 'a', 'NUMERIC', 'SORTABLE', 'b', 'NUMERIC', 'SORTABLE')
+    docs = []
+    for i in range(300):
+        a = [(i * 7) % 11 - 5, -0.0, 0, 'inf', '-inf', None][i % 6]
+        b = (i * 13) % 5
+        if a is None:
+            conn.execute_command('HSET', f'doc{i}', 'b', b)
+        else:
+            conn.execute_command('HSET', f'doc{i}', 'a', a, 'b', b)
+        docs.append((i, None if a is None else float(a), b))
+
+    def expected(asc_a, asc_b, limit):
+        present = [d for d in docs if d[1] is not None]
+        present.sort(key=lambda d: (d[1] if asc_a else -d[1], d[2] if asc_b else -d[2],
+                                    d[0] if asc_b else -d[0]))
+        missing = sorted([d for d in docs if d[1] is None],
+                         key=lambda d: (d[2] if asc_b else -d[2], d[0] if asc_b else -d[0]))
+        return [f'doc{d[0]}' for d in (present + missing)[:limit]]
+
+    for asc_a in [True, False]:
+        for asc_b in [True, False]:
+            for limit in [1, 10, 100, 300]:
+                res = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@__key',
+                              'SORTBY', '4', '@a', 'ASC' if asc_a else 'DESC', '@b', 'ASC' if asc_b else 'DESC',
+                              'MAX', limit)
+                env.assertEqual([r[1] for r in res[1:]], expected(asc_a, asc_b, limit),
+                                message=(asc_a, asc_b, limit))
+
+    # keys which are not numbers are sorted as well
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@__key',
+                  'APPLY', '@__key', 'AS', 'c', 'SORTBY', '2', '@c', 'ASC', 'MAX', 5)
+    env.assertEqual([r[1] for r in res[1:]], sorted(f'doc{i}' for i in range(300))[:5])
+
+def testSortableValuesStorage(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TAG', 'SORTABLE', 'n', 'NUMERIC', 'SORTABLE',
+               'title', 'TEXT', 'SORTABLE').ok()
+    n = 1000
+    for i in range(n):
+        conn.execute_command('HSET', f'doc{i}', 't', ['Red', 'BLUE'][i % 2], 'n', i, 'title', f'title {i % 10}')
+
+    # numbers are sorted, filtered and returned from the sorting vectors
+    env.expect('FT.SEARCH', 'idx', '@n:[10 12]', 'SORTBY', 'n', 'DESC', 'RETURN', 1, 'n').equal(
+        [3, 'doc12', ['n', '12'], 'doc11', ['n', '11'], 'doc10', ['n', '10']])
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'APPLY', '@n * 2', 'AS', 'm', 'SORTBY', 2, '@m', 'DESC', 'MAX', 2)
+    env.assertEqual([to_dict(r)['m'] for r in res[1:]], [str(2 * (n - 1)), str(2 * (n - 2))])
+
+    # the strings are normalized, and shared by the documents holding the same value
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'c', 'SORTBY', 2, '@t', 'ASC')
+    env.assertEqual(res[1:], [['t', 'blue', 'c', str(n // 2)], ['t', 'red', 'c', str(n // 2)]])
+    env.expect('FT.SEARCH', 'idx', '@n:[0 1]', 'SORTBY', 'title', 'ASC', 'RETURN', 1, 'title').equal(
+        [2, 'doc0', ['title', 'title 0'], 'doc1', ['title', 'title 1']])
+
+    if not env.isCluster():
+        doc_table = to_dict(to_dict(env.cmd('FT.DEBUG', 'MEMORY', 'idx'))['doc_table'])
+        strings = to_dict(doc_table['sortable_strings'])
+        env.assertGreater(strings['used'], 0)
+        # 2 tag values and 10 titles
+        env.assertLess(strings['used'], 12 * 100)
+
+    for i in range(n):
+        conn.execute_command('DEL', f'doc{i}')
+    if not env.isCluster():
+        doc_table = to_dict(to_dict(env.cmd('FT.DEBUG', 'MEMORY', 'idx'))['doc_table'])
+        env.assertEqual(to_dict(doc_table['sortable_strings'])['used'], 0)
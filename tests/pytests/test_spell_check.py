@@ -178,3 +178,33 @@ def testSpellCheckIssue437(env):
                'Tooni toque kerfuffle', 'TERMS',
                'EXCLUDE', 'slang', 'TERMS',
                'INCLUDE', 'slang').equal([['TERM', 'tooni', [['0', 'toonie']]]])
+
+def testSpellCheckSpellIndex(env):
+    # An index with SPELLINDEX suggests the same terms as one without it
+    env.cmd('ft.create', 'plain', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'SCHEMA', 'body', 'TEXT')
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'SPELLINDEX', 'SCHEMA', 'body', 'TEXT')
+    res = env.cmd('ft.info', 'idx')
+    env.assertContains('SPELLINDEX', res[res.index('index_options') + 1])
+
+    conn = getConnectionByEnv(env)
+    words = ['hello', 'help', 'held', 'hells', 'shell', 'yellow', 'internationalization',
+             'internationalisation', 'interpretation']
+    for i, w in enumerate(words):
+        conn.execute_command('HSET', 'doc%d' % i, 'body', w)
+
+    def check(query, distance):
+        # suggestions of equal scores may come in any order
+        def suggestions(idx):
+            res = env.cmd('ft.spellcheck', idx, query, 'DISTANCE', distance)
+            return [(term, sorted(map(tuple, sugs))) for _, term, sugs in res]
+        env.assertEqual(suggestions('idx'), suggestions('plain'))
+
+    for distance in [1, 2, 3]:
+        for query in ['helo', 'hel', 'yelow', 'internationalizasion', 'nternationalization', 'shel']:
+            check(query, distance)
+
+    # terms indexed after the spell index was built
+    conn.execute_command('HSET', 'doc100', 'body', 'helot')
+    conn.execute_command('HSET', 'doc101', 'body', 'internationalizations')
+    for query in ['helo', 'internationalizasion']:
+        check(query, 2)
@@ -127,3 +127,28 @@ def testIssue_490(env):
     env.expect('ft.sugget', 'sug', 'Redis', 'WITHPAYLOADS').equal(['RediSearch', 'RediSearch, an awesome search engine'])
     env.expect('ft.sugadd', 'sug', 'RediSearch', '1', 'INCR', 'PAYLOAD', 'RediSearch 2.0, next gen search engine').equal(1)
     env.expect('ft.sugget', 'sug', 'Redis', 'WITHPAYLOADS').equal(['RediSearch', 'RediSearch 2.0, next gen search engine'])
+
+def testSuggestCachedPrefix(env):
+    skipOnCrdtEnv(env)
+    # Short prefixes are served from cached completions, which must follow the changes to the
+    # dictionary. A MAX above 10 bypasses the cache
+    def check():
+        for prefix in ['', 'a', 'ab', 'abc']:
+            cached = env.cmd('FT.SUGGET', 'sug', prefix, 'MAX', 10, 'WITHSCORES', 'WITHPAYLOADS')
+            searched = env.cmd('FT.SUGGET', 'sug', prefix, 'MAX', 100, 'WITHSCORES', 'WITHPAYLOADS')
+            env.assertEqual(cached, searched[0:len(cached)])
+
+    for i in range(30):
+        env.cmd('FT.SUGADD', 'sug', 'abc%d' % i, i + 1, 'PAYLOAD', 'p%d' % i)
+    check()
+    env.cmd('FT.SUGADD', 'sug', 'abc3', 100, 'INCR')
+    env.cmd('FT.SUGADD', 'sug', 'abc29', 1, 'PAYLOAD', 'lower')
+    check()
+    env.cmd('FT.SUGADD', 'sug', 'ab', 5)
+    env.cmd('FT.SUGDEL', 'sug', 'abc3')
+    env.cmd('FT.SUGDEL', 'sug', 'abc28')
+    check()
+    for i in range(30):
+        env.cmd('FT.SUGDEL', 'sug', 'abc%d' % i)
+    check()
+    env.expect('FT.SUGGET', 'sug', 'a').equal(['ab'])
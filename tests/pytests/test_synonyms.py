@@ -1,5 +1,5 @@
 from includes import *
-from common import getConnectionByEnv, waitForIndex, sortedResults, toSortedFlatList
+from common import getConnectionByEnv, waitForIndex, sortedResults, toSortedFlatList, index_info
 
 
 def testBasicSynonymsUseCase(env):
@@ -194,3 +194,27 @@ def testSkipInitialIndex(env):
 
     env.expect('FT.SEARCH idx1 @foo:xyz').equal([1, 'doc1', ['foo', 'bar']])
     env.expect('FT.SEARCH idx2 @foo:xyz').equal([0])
+
+def testSynonymUpdateReindexesNewSynonymsDocs(env):
+    conn = getConnectionByEnv(env)
+
+    env.expect('FT.CREATE idx SCHEMA foo text').ok()
+    conn.execute_command('HSET', 'doc1', 'foo', 'bar')
+    conn.execute_command('HSET', 'doc2', 'foo', 'baz')
+    conn.execute_command('HSET', 'doc3', 'foo', 'qux')
+    waitForIndex(env, 'idx')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 3)
+
+    # only the document with the new synonym is reindexed
+    env.expect('FT.SYNUPDATE idx g1 bar xyz').ok()
+    waitForIndex(env, 'idx')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 4)
+    env.expect('FT.SEARCH idx @foo:xyz NOCONTENT').equal([1, 'doc1'])
+
+    # synonyms already in the group are not reindexed again
+    env.expect('FT.SYNUPDATE idx g1 bar xyz baz').ok()
+    waitForIndex(env, 'idx')
+    env.assertEqual(int(index_info(env, 'idx')['max_doc_id']), 5)
+    res = env.cmd('FT.SEARCH', 'idx', '@foo:xyz', 'NOCONTENT')
+    env.assertEqual(sorted(res[1:]), ['doc1', 'doc2'])
+    env.expect('FT.SEARCH idx @foo:qux NOCONTENT').equal([1, 'doc3'])
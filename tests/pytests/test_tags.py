@@ -365,3 +365,64 @@ def testEmptyTagLeak(env):
         pl.execute()
     forceInvokeGC(env, 'idx')
     env.expect('FT.DEBUG', 'DUMP_TAGIDX', 'idx', 't').equal([])
+
+def testTagExpansionCacheInvalidation(env):
+    # repeated prefix, suffix and wildcard queries are answered from cached expansions, which must
+    # be dropped once tag values are added or collected
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'WITHSUFFIXTRIE', 'u', 'TAG')
+    conn.execute_command('HSET', 'doc1', 't', 'abc1', 'u', 'abc1')
+    conn.execute_command('HSET', 'doc2', 't', 'abc2', 'u', 'abc2')
+
+    queries = ['@t:{abc*}', '@t:{*c2}', '@t:{*bc*}', "@t:{w'a*2'}", '@u:{abc*}', '@u:{*c2}', "@u:{w'a*2'}"]
+    def check(expected):
+        for q in queries:
+            for _ in range(2):
+                res = env.cmd('FT.SEARCH', 'idx', q, 'NOCONTENT', 'DIALECT', 2)
+                env.assertEqual(sorted(res[1:]), [d for d in expected if d in matches[q]], message=q)
+
+    matches = {'@t:{abc*}': ['doc1', 'doc2', 'doc3'], '@t:{*c2}': ['doc2', 'doc3'],
+               '@t:{*bc*}': ['doc1', 'doc2', 'doc3'], "@t:{w'a*2'}": ['doc2', 'doc3'],
+               '@u:{abc*}': ['doc1', 'doc2', 'doc3'], '@u:{*c2}': ['doc2', 'doc3'],
+               "@u:{w'a*2'}": ['doc2', 'doc3']}
+    check(['doc1', 'doc2'])
+
+    conn.execute_command('HSET', 'doc3', 't', 'abcc2', 'u', 'abcc2')
+    check(['doc1', 'doc2', 'doc3'])
+
+    conn.execute_command('DEL', 'doc1', 'doc3')
+    forceInvokeGC(env, 'idx')
+    check(['doc2'])
+
+def testTagValsPaging(env):
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG')
+    values = ['v%02d' % i for i in range(30)] + ['w%02d' % i for i in range(5)]
+    for i, v in enumerate(values):
+        conn.execute_command('HSET', 'doc%d' % i, 't', v)
+    conn.execute_command('HSET', 'extra', 't', 'v03')
+
+    env.expect('FT.TAGVALS', 'idx', 't', 'PREFIX', 'w').equal(['w%02d' % i for i in range(5)])
+    env.expect('FT.TAGVALS', 'idx', 't', 'LIMIT', 0, 3).equal(['v00', 'v01', 'v02'])
+    env.expect('FT.TAGVALS', 'idx', 't', 'LIMIT', 2, 2).equal(['v02', 'v03'])
+    env.expect('FT.TAGVALS', 'idx', 't', 'AFTER', 'v28', 'LIMIT', 0, 3).equal(['v29', 'w00', 'w01'])
+    env.expect('FT.TAGVALS', 'idx', 't', 'PREFIX', 'v', 'AFTER', 'v28').equal(['v29'])
+    env.expect('FT.TAGVALS', 'idx', 't', 'PREFIX', 'v0', 'LIMIT', 2, 2, 'WITHCOUNTS').equal(
+        ['v02', 1, 'v03', 2])
+
+    # paging with AFTER the last value of each page visits every value once, in order
+    pages, after = [], None
+    while True:
+        args = ['AFTER', after] if after is not None else []
+        page = env.cmd('FT.TAGVALS', 'idx', 't', *args, 'LIMIT', 0, 4)
+        if not page:
+            break
+        pages += page
+        after = page[-1]
+    env.assertEqual(pages, values)
+
+    env.expect('FT.TAGVALS', 'idx', 't', 'LIMIT', 0, 0).error()
+    env.expect('FT.TAGVALS', 'idx', 't', 'AFTER').error()
+    env.expect('FT.TAGVALS', 'idx', 't', 'BOGUS').error()
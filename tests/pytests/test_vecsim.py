@@ -335,7 +335,8 @@ def test_create():
         expected_FLAT = ['ALGORITHM', 'FLAT', 'TYPE', data_type, 'DIMENSION', 1024, 'METRIC', 'L2', 'IS_MULTI_VALUE', 0, 'INDEX_SIZE', 0, 'INDEX_LABEL_COUNT', 0, 'MEMORY', dummy_val, 'LAST_SEARCH_MODE', 'EMPTY_MODE', 'BLOCK_SIZE', 1024]
 
         for _ in env.retry_with_rdb_reload():
-            info = [['identifier', 'v_HNSW', 'attribute', 'v_HNSW', 'type', 'VECTOR']]
+            info = [['identifier', 'v_HNSW', 'attribute', 'v_HNSW', 'type', 'VECTOR', 'vector_queries', 0,
+                     'vector_distances', 0, 'vector_batches', 0, 'vector_batch_results', 0]]
             assertInfoField(env, 'idx1', 'attributes', info)
             info_data_HNSW = conn.execute_command("FT.DEBUG", "VECSIM_INFO", "idx1", "v_HNSW")
             # replace memory values with a dummy value - irrelevant for the test
@@ -805,6 +806,37 @@ def test_hybrid_query_batches_mode_with_tags():
         conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
 
 
+def test_hybrid_query_batches_mode_with_selective_filter():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    # A filter of 2% of the index is read up front, and the batches are filtered by its ids.
+    dim = 2
+    index_size = 6000 * env.shardsCount
+
+    for data_type in VECSIM_DATA_TYPES:
+        conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '8', 'TYPE', data_type,
+                             'DIM', dim, 'DISTANCE_METRIC', 'L2', 'EF_RUNTIME', 100, 'tags', 'TAG')
+
+        p = conn.pipeline(transaction=False)
+        for i in range(1, index_size+1):
+            vector = create_np_array_typed([i]*dim, data_type)
+            p.execute_command('HSET', i, 'v', vector.tobytes(), 'tags', 'rare' if i % 50 == 0 else 'common')
+        p.execute()
+
+        query_data = create_np_array_typed([index_size/2]*dim, data_type)
+
+        # Expect the ids which divide by 50 around index_size/2, closer results come before (secondary sorting by id).
+        expected_res = [10, str(int(index_size/2)), ['__v_score', str(0), 'tags', 'rare']]
+        for i in range(1, 10):
+            expected_res.append(str(int(index_size/2) + (-50*int((i+1)/2) if i % 2 else 50*int(i/2))))
+            expected_res.append(['__v_score', str(dim*(50*int((i+1)/2))**2), 'tags', 'rare'])
+        execute_hybrid_query(env, '(@tags:{rare})=>[KNN 10 @v $vec_param HYBRID_POLICY BATCHES]', query_data,
+                             'tags').equal(expected_res)
+        execute_hybrid_query(env, '(@tags:{rare})=>[KNN 10 @v $vec_param HYBRID_POLICY ADHOC_BF]', query_data,
+                             'tags', hybrid_mode='HYBRID_ADHOC_BF').equal(expected_res)
+        conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
+
+
 def test_hybrid_query_with_numeric():
     env = Env(moduleArgs='DEFAULT_DIALECT 2')
     conn = getConnectionByEnv(env)
@@ -2044,6 +2076,48 @@ def test_range_query_complex_queries():
         conn.flushall()
 
 
+def test_range_query_selective_filter():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 4
+    index_size = 2000
+
+    for metric in ['L2', 'COSINE']:
+        env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+                   'DIM', dim, 'DISTANCE_METRIC', metric, 't', 'TAG').ok()
+        p = conn.pipeline(transaction=False)
+        for i in range(1, index_size+1):
+            vector = create_np_array_typed([i, i % 7, i % 11, 1])
+            # 1% of the documents are rare, a selective filter for a range that has them all
+            p.execute_command('HSET', i, 'v', vector.tobytes(), 't', 'rare' if i % 100 == 0 else 'common')
+        p.execute()
+        # A rare document without a vector
+        conn.execute_command('HSET', index_size+100, 't', 'rare')
+
+        query_data = create_np_array_typed([index_size, 3, 5, 1])
+        radius = 0.5 if metric == 'COSINE' else dim * index_size**2
+        params = ['PARAMS', 4, 'vec_param', query_data.tobytes(), 'r', radius]
+        range_query = '@v:[VECTOR_RANGE $r $vec_param]=>{$YIELD_DISTANCE_AS:dist}'
+        res = conn.execute_command('FT.SEARCH', 'idx', range_query, 'SORTBY', 'dist', 'RETURN', 1, 'dist',
+                                   'LIMIT', 0, index_size, *params)
+        all_dists = {res[i]: float(res[i+1][1]) for i in range(1, len(res), 2)}
+        expected = {doc_id: dist for doc_id, dist in all_dists.items() if int(doc_id) % 100 == 0}
+
+        # The distances of the results of the filter are measured rather than taken from the range,
+        # with the filter on either side of the intersection
+        for query in [f'@t:{{rare}} {range_query}', f'{range_query} @t:{{rare}}']:
+            res = conn.execute_command('FT.SEARCH', 'idx', query, 'SORTBY', 'dist', 'RETURN', 1, 'dist',
+                                       'LIMIT', 0, index_size, *params)
+            env.assertEqual(res[0], len(expected))
+            for i in range(1, len(res), 2):
+                env.assertAlmostEqual(float(res[i+1][1]), expected[res[i]], 1e-5)
+
+        # A radius nothing is within
+        env.expect('FT.SEARCH', 'idx', f'@t:{{rare}} {range_query}', 'PARAMS', 4, 'vec_param',
+                   create_np_array_typed([-index_size, -3, -5, -1]).tobytes(), 'r', 0).equal([0])
+        conn.flushall()
+
+
 def test_multiple_range_queries():
     env = Env(moduleArgs='DEFAULT_DIALECT 2')
     conn = getConnectionByEnv(env)
@@ -2329,3 +2403,34 @@ def test_tiered_index_gc(env):
     debug_info_v2 = get_vecsim_debug_dict(env, 'idx', 'v2')
     env.assertEqual(to_dict(debug_info_v1['BACKEND_INDEX'])['NUMBER_OF_MARKED_DELETED'], 0)
     env.assertEqual(to_dict(debug_info_v2['BACKEND_INDEX'])['NUMBER_OF_MARKED_DELETED'], 0)
+
+
+@skip(cluster=True)
+def test_multi_vector_query():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 2
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dim, 'DISTANCE_METRIC', 'L2', 't', 'TAG')
+
+    for i in range(20):
+        conn.execute_command("HSET", f'doc{i}', "v", create_np_array_typed([i] * dim).tobytes(),
+                             't', 'odd' if i % 2 else 'even')
+
+    vectors = [create_np_array_typed([i] * dim).tobytes() for i in (0, 7.4, 19)]
+    for query in ["*=>[KNN 3 @v $BLOB]", "@t:{odd}=>[KNN 3 @v $BLOB]"]:
+        # Every vector is replied with the results of its own query, in order
+        res = conn.execute_command("FT.SEARCH", "idx", query, "MULTIVECTOR", "NOCONTENT",
+                                   "PARAMS", 2, "BLOB", b''.join(vectors))
+        env.assertEqual(len(res), len(vectors))
+        for vector, vector_res in zip(vectors, res):
+            expected = conn.execute_command("FT.SEARCH", "idx", query, "NOCONTENT",
+                                            "PARAMS", 2, "BLOB", vector)
+            env.assertEqual(vector_res, expected)
+
+    # The parameter holds whole vectors
+    env.expect("FT.SEARCH", "idx", "*=>[KNN 3 @v $BLOB]", "MULTIVECTOR",
+               "PARAMS", 2, "BLOB", b''.join(vectors) + b'\x00').error().contains('MULTIVECTOR expects')
+    env.expect("FT.SEARCH", "idx", "@t:{odd}", "MULTIVECTOR").error().contains('KNN query')
+    env.expect("FT.AGGREGATE", "idx", "*=>[KNN 3 @v $BLOB]", "MULTIVECTOR",
+               "PARAMS", 2, "BLOB", vectors[0]).error().contains('only supported by FT.SEARCH')